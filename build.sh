@@ -54,6 +54,42 @@ board_has_icons() {
     return 1
 }
 
+board_has_prescaled_masks() {
+    local board_name="$1"
+    local overrides_file="$SCRIPT_DIR/src/boards/$board_name/board_overrides.h"
+
+    if [[ ! -f "$overrides_file" ]]; then
+        return 1
+    fi
+
+    # Match: #define ICON_MASK_PRESCALED true (allow whitespace)
+    if grep -qE '^[[:space:]]*#define[[:space:]]+ICON_MASK_PRESCALED[[:space:]]+true[[:space:]]*$' "$overrides_file"; then
+        return 0
+    fi
+
+    return 1
+}
+
+# Extra mask icon sizes (only generated when a target board sets ICON_MASK_PRESCALED).
+ICON_MASK_SIZES="${ICON_MASK_SIZES:-128}"
+
+should_generate_mask_sizes() {
+    local target_board="$1"
+
+    if [[ -n "$target_board" ]]; then
+        board_has_prescaled_masks "$target_board"
+        return $?
+    fi
+
+    for board_name in "${!FQBN_TARGETS[@]}"; do
+        if board_has_prescaled_masks "$board_name"; then
+            return 0
+        fi
+    done
+
+    return 1
+}
+
 should_generate_icon_assets() {
     local target_board="$1"
 
@@ -123,27 +159,30 @@ build_board() {
     # Check for board-specific configuration overrides
     EXTRA_FLAGS=()
 
-    # Some third-party Arduino libraries (e.g., Async_TCP) are compiled as separate
-    # translation units and do not see macros defined only in board_overrides.h.
-    # If a board override defines CONFIG_ASYNC_TCP_STACK_SIZE, also pass it as a
-    # global -D so the library is compiled with the same value.
+    # Some third-party Arduino libraries (e.g., Async_TCP, NimBLE-Arduino) are compiled
+    # as separate translation units and do not see macros defined only in
+    # board_overrides.h. Forward their task placement / memory knobs as global -D
+    # so the libraries are compiled with the same values.
     EXTRA_GLOBAL_DEFINES=""
     if [[ -f "$board_overrides_file" ]]; then
-        async_tcp_stack_size=$(grep -E '^[[:space:]]*#define[[:space:]]+CONFIG_ASYNC_TCP_STACK_SIZE[[:space:]]+' "$board_overrides_file" \
-            | head -n 1 \
-            | awk '{print $3}')
-        if [[ -n "${async_tcp_stack_size:-}" ]]; then
-            EXTRA_GLOBAL_DEFINES+=" -DCONFIG_ASYNC_TCP_STACK_SIZE=${async_tcp_stack_size}"
-        fi
-
-        # NimBLE-Arduino can optionally allocate its host memory from PSRAM.
-        # The library only sees this if we pass it as a global compile define.
-        nimble_mem_mode_external=$(grep -E '^[[:space:]]*#define[[:space:]]+CONFIG_BT_NIMBLE_MEM_ALLOC_MODE_EXTERNAL[[:space:]]+' "$board_overrides_file" \
-            | head -n 1 \
-            | awk '{print $3}')
-        if [[ -n "${nimble_mem_mode_external:-}" ]]; then
-            EXTRA_GLOBAL_DEFINES+=" -DCONFIG_BT_NIMBLE_MEM_ALLOC_MODE_EXTERNAL=${nimble_mem_mode_external}"
-        fi
+        local forwarded_macros=(
+            CONFIG_ASYNC_TCP_STACK_SIZE
+            CONFIG_ASYNC_TCP_PRIORITY
+            CONFIG_ASYNC_TCP_RUNNING_CORE
+            # NimBLE-Arduino can optionally allocate its host memory from PSRAM.
+            CONFIG_BT_NIMBLE_MEM_ALLOC_MODE_EXTERNAL
+            CONFIG_BT_NIMBLE_PINNED_TO_CORE
+            CONFIG_BT_NIMBLE_HOST_TASK_STACK_SIZE
+        )
+        local macro value
+        for macro in "${forwarded_macros[@]}"; do
+            value=$(grep -E "^[[:space:]]*#define[[:space:]]+${macro}[[:space:]]+" "$board_overrides_file" \
+                | head -n 1 \
+                | awk '{print $3}')
+            if [[ -n "${value:-}" ]]; then
+                EXTRA_GLOBAL_DEFINES+=" -D${macro}=${value}"
+            fi
+        done
     fi
 
     # Always embed board name for runtime identification (used by firmware update UX).
@@ -228,9 +267,14 @@ build_board() {
         echo ""
     fi
     
+    # Compressed app image for OTA uploads (/api/update accepts .bin.gz)
+    if [[ -f "$board_build_path/app.ino.bin" ]]; then
+        gzip -9 -n -c "$board_build_path/app.ino.bin" > "$board_build_path/app.ino.bin.gz"
+    fi
+
     echo ""
     echo -e "${GREEN}✓ Build complete for $board_name${NC}"
-    ls -lh "$board_build_path"/*.bin 2>/dev/null || echo "Binary files generated"
+    ls -lh "$board_build_path"/*.bin "$board_build_path"/*.bin.gz 2>/dev/null || echo "Binary files generated"
     echo ""
 }
 
@@ -252,6 +296,14 @@ fi
 if should_generate_icon_assets "$TARGET_BOARD"; then
     echo "Generating LVGL icon assets from assets/icons_*..."
 
+    # Pre-scaled mask sizes are compiled under ICON_MASK_PRESCALED; skip generating
+    # them (several MB of source) when no target uses them.
+    mask_sizes=""
+    if should_generate_mask_sizes "$TARGET_BOARD"; then
+        mask_sizes="$ICON_MASK_SIZES"
+        echo "Mask icon sizes: 64 + $mask_sizes"
+    fi
+
     # Always generate stable output files so includes remain predictable.
     python3 "$SCRIPT_DIR/tools/png2lvgl_assets.py" \
         "$SCRIPT_DIR/assets/icons_mono" \
@@ -260,12 +312,16 @@ if should_generate_icon_assets "$TARGET_BOARD"; then
         --prefix "ic_" \
         --format "alpha_8bit" \
         --size 64 \
-        --resize
+        --resize \
+        --extra-sizes "$mask_sizes" \
+        --variant-guard "ICON_MASK_PRESCALED"
 
     python3 "$SCRIPT_DIR/tools/generate_icon_registry.py" \
         --mono-h "$SCRIPT_DIR/src/app/icon_assets_mono.h" \
         --out-h "$SCRIPT_DIR/src/app/icon_registry.h" \
-        --out-cpp "$SCRIPT_DIR/src/app/icon_registry.cpp"
+        --out-cpp "$SCRIPT_DIR/src/app/icon_registry.cpp" \
+        --variant-sizes "$mask_sizes" \
+        --variant-guard "ICON_MASK_PRESCALED"
 
     echo ""
 else
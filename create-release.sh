@@ -173,4 +173,6 @@ echo "   git tag -a v$VERSION -m \"$RELEASE_TITLE\""
 echo "   git push origin v$VERSION"
 echo ""
 echo "3. GitHub Actions will automatically create the release with binaries"
+echo "   (the app image also as .bin.gz, which devices prefer for OTA, and a"
+echo "   .delta.gz patch from the previous stable release, see tools/make_delta_ota.py)"
 echo ""
@@ -2,13 +2,16 @@
 
 #if defined(CONFIG_BT_ENABLED)
 
+#include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <esp_timer.h>
 
 #include <NimBLEDevice.h>
 #include "HIDTypes.h"
 
 #include "sdkconfig.h"
+#include "tap_latency.h"
 
 #if defined(CONFIG_ARDUHAL_ESP_LOG)
   #include "esp32-hal-log.h"
@@ -99,9 +102,11 @@ void BleKeyboard::begin(void)
 {
   NimBLEDevice::init(deviceName);
 	NimBLEDevice::setSecurityAuth(true, true, false);
+  applyOwnAddress();
 
   NimBLEServer *pServer = NimBLEDevice::createServer();
   pServer->setCallbacks(this);
+  server = pServer;
 
   hid        = new NimBLEHIDDevice(pServer);
   inputKeyboard = hid->getInputReport(KEYBOARD_ID); // <-- input REPORTID from report map
@@ -118,12 +123,69 @@ void BleKeyboard::begin(void)
   NimBLEAdvertising *pAdvertising = pServer->getAdvertising();
   pAdvertising->setAppearance(HID_KEYBOARD);
   pAdvertising->addServiceUUID(hid->getHidService()->getUUID());
-  pAdvertising->start();
+  // Directed advertising times out after 1.28 s; keep the device discoverable.
+  pAdvertising->setAdvertisingCompleteCallback([this](NimBLEAdvertising* adv) {
+    if (!connected) adv->start();
+  });
+  startAdvertising();
   hid->setBatteryLevel(batteryLevel);
 }
 
+void BleKeyboard::setIdentity(const uint8_t* randomStatic, const NimBLEAddress* peer)
+{
+  hasOwnAddr = randomStatic != nullptr;
+  if (randomStatic) memcpy(ownAddr, randomStatic, sizeof(ownAddr));
+  hasPeer = peer != nullptr;
+  if (peer) peerAddr = *peer;
+}
+
+void BleKeyboard::applyOwnAddress()
+{
+  if (hasOwnAddr) {
+    NimBLEDevice::setOwnAddr(ownAddr);
+    NimBLEDevice::setOwnAddrType(BLE_OWN_ADDR_RANDOM);
+  } else {
+    NimBLEDevice::setOwnAddrType(BLE_OWN_ADDR_PUBLIC);
+  }
+}
+
+void BleKeyboard::startAdvertising()
+{
+  if (!server) return;
+  NimBLEAdvertising* adv = server->getAdvertising();
+  if (hasPeer && adv->start(1280, &peerAddr)) return;
+  adv->start();
+}
+
+void BleKeyboard::switchIdentity(const uint8_t* randomStatic, const NimBLEAddress* peer)
+{
+  setIdentity(randomStatic, peer);
+  if (!server) return;
+
+  if (connected) {
+    server->disconnect(connHandle);
+    for (int i = 0; i < 50 && connected; i++) vTaskDelay(pdMS_TO_TICKS(10));
+    vTaskDelay(pdMS_TO_TICKS(20));   // NimBLE restarts advertising after a disconnect
+  }
+  server->getAdvertising()->stop();
+  applyOwnAddress();
+  startAdvertising();
+}
+
 void BleKeyboard::end(void)
 {
+  // Tears the whole NimBLE stack down (bonds stay in NVS); construct a new
+  // BleKeyboard to start again.
+  if (connected && server) {
+    server->disconnect(connHandle);
+    vTaskDelay(pdMS_TO_TICKS(100));   // let the terminate go out
+  }
+  NimBLEDevice::deinit(true);
+  delete hid;
+  hid = 0;
+  server = nullptr;
+  inputKeyboard = outputKeyboard = inputMediaKeys = nullptr;
+  connected = false;
 }
 
 bool BleKeyboard::isConnected(void) const {
@@ -141,7 +203,8 @@ void BleKeyboard::sendReport(KeyReport* keys)
   if (this->isConnected())
   {
     this->inputKeyboard->setValue((uint8_t*)keys, sizeof(KeyReport));
-    this->inputKeyboard->notify();
+    notifyTimed(this->inputKeyboard);
+    tap_latency_note_report();
   }
 }
 
@@ -150,13 +213,46 @@ void BleKeyboard::sendReport(MediaKeyReport* keys)
   if (this->isConnected())
   {
     this->inputMediaKeys->setValue((uint8_t*)keys, sizeof(MediaKeyReport));
-    this->inputMediaKeys->notify();
+    notifyTimed(this->inputMediaKeys);
+    tap_latency_note_report();
   }
 }
 
+void BleKeyboard::notifyTimed(NimBLECharacteristic* characteristic)
+{
+  // Notifications are not acknowledged, so this is the host-side cost of
+  // queuing the report (it grows when the controller's buffers back up).
+  const int64_t t0 = esp_timer_get_time();
+  characteristic->notify();
+  const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+  reportTxLastUs = us;
+  if (us > reportTxMaxUs) reportTxMaxUs = us;
+  reportLastMs = millis();
+}
+
+bool BleKeyboard::requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout)
+{
+  if (!connected || !server) return false;
+  return server->updateConnParams(connHandle, minInterval, maxInterval, latency, timeout);
+}
+
 void BleKeyboard::onConnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo) {
+    connHandle = connInfo.getConnHandle();
     connected = true;
     if (connectCallback) connectCallback();
+    if (connParamsCallback) connParamsCallback(connInfo.getConnInterval(), connInfo.getConnLatency(), connInfo.getConnTimeout());
+}
+
+void BleKeyboard::onAuthenticationComplete(NimBLEConnInfo& connInfo) {
+    if (authCallback && connInfo.isEncrypted()) authCallback(connInfo.getIdAddress(), connInfo.isBonded());
+}
+
+void BleKeyboard::onAuthenticated(AuthCallback cb) {
+    authCallback = cb;
+}
+
+void BleKeyboard::onConnParamsUpdate(NimBLEConnInfo& connInfo) {
+    if (connParamsCallback) connParamsCallback(connInfo.getConnInterval(), connInfo.getConnLatency(), connInfo.getConnTimeout());
 }
 
 void BleKeyboard::onDisconnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo, int reason) {
@@ -172,6 +268,10 @@ void BleKeyboard::onDisconnect(Callback cb) {
     disconnectCallback = cb;
 }
 
+void BleKeyboard::onConnParams(ConnParamsCallback cb) {
+    connParamsCallback = cb;
+}
+
 void BleKeyboard::onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) {
   uint8_t* value = (uint8_t*)(pCharacteristic->getValue().c_str());
   ESP_LOGI(LOG_TAG, "special keys: %d", *value);
@@ -435,6 +535,22 @@ void BleKeyboard::releaseAll(void)
 	sendReport(&_keyReport);
 }
 
+void BleKeyboard::sendKeys(uint8_t modifiers, const uint8_t* usages, uint8_t count)
+{
+	if (count > 6) count = 6;
+	_keyReport.modifiers = modifiers;
+	for (uint8_t i = 0; i < 6; i++) {
+		_keyReport.keys[i] = (i < count) ? usages[i] : 0;
+	}
+	sendReport(&_keyReport);
+}
+
+uint8_t BleKeyboard::asciiUsage(uint8_t c)
+{
+	if (c >= 128) return 0;
+	return pgm_read_byte(_asciimap + c);
+}
+
 size_t BleKeyboard::write(uint8_t c)
 {
 	uint8_t p = press(c);  // Keydown
@@ -95,6 +95,10 @@ class BleKeyboard : public Print, NimBLEServerCallbacks, NimBLECharacteristicCal
 {
 public:
   using Callback = std::function<void(void)>;
+  // interval in 1.25 ms units, latency in connection events, timeout in 10 ms units.
+  using ConnParamsCallback = std::function<void(uint16_t interval, uint16_t latency, uint16_t timeout)>;
+  // Identity address of a host that finished pairing / encrypting the link.
+  using AuthCallback = std::function<void(const NimBLEAddress& peer, bool bonded)>;
 
 public:
   BleKeyboard(std::string deviceName = "ESP32-Keyboard", std::string deviceManufacturer = "Espressif", uint8_t batteryLevel = 100);
@@ -110,14 +114,36 @@ public:
   size_t write(const MediaKeyReport c);
   size_t write(const uint8_t *buffer, size_t size);
   void releaseAll(void);
+  // Replace the held keys with modifiers plus up to 6 HID usages, and send.
+  void sendKeys(uint8_t modifiers, const uint8_t* usages, uint8_t count);
+  // HID usage for a printable ASCII character (0x80 set: needs shift), 0 if none.
+  static uint8_t asciiUsage(uint8_t c);
   bool isConnected(void) const;
   void setBatteryLevel(uint8_t level);
   void onConnect(Callback cb);
   void onDisconnect(Callback cb);
+  // Called on connect and whenever the central applies new connection parameters.
+  void onConnParams(ConnParamsCallback cb);
+  // Ask the central for new connection parameters (same units as above).
+  bool requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
+  // Time spent in the last / slowest notify() of an input report, in microseconds.
+  uint32_t lastReportTxUs() const { return reportTxLastUs; }
+  uint32_t maxReportTxUs() const { return reportTxMaxUs; }
+  uint32_t lastReportMillis() const { return reportLastMs; }
+  void onAuthenticated(AuthCallback cb);
+
+  // Own address (little-endian random static address; null = public) and the
+  // host to advertise to first. Call before begin(), or use switchIdentity().
+  void setIdentity(const uint8_t* randomStatic, const NimBLEAddress* peer);
+  // Drop the link and advertise as another identity: directed at peer for up
+  // to 1.28 s when given, then undirected.
+  void switchIdentity(const uint8_t* randomStatic, const NimBLEAddress* peer);
 
 protected:
   void onConnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo) override;
   void onDisconnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo, int reason) override;
+  void onConnParamsUpdate(NimBLEConnInfo& connInfo) override;
+  void onAuthenticationComplete(NimBLEConnInfo& connInfo) override;
   virtual void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& connInfo) override;
 
 protected:
@@ -132,9 +158,25 @@ protected:
   std::string deviceManufacturer;
   std::string deviceName;
   bool connected = false;
+  NimBLEServer* server = nullptr;
+  uint16_t connHandle = 0xFFFF;
+  volatile uint32_t reportTxLastUs = 0;
+  volatile uint32_t reportTxMaxUs = 0;
+  volatile uint32_t reportLastMs = 0;
+
+  bool hasOwnAddr = false;
+  uint8_t ownAddr[6] = {};
+  bool hasPeer = false;
+  NimBLEAddress peerAddr;
+
+  void notifyTimed(NimBLECharacteristic* characteristic);
+  void applyOwnAddress();
+  void startAdvertising();
 
   Callback connectCallback    = nullptr;
   Callback disconnectCallback = nullptr;
+  ConnParamsCallback connParamsCallback = nullptr;
+  AuthCallback authCallback = nullptr;
 };
 
 #endif // CONFIG_BT_NIMBLE_ROLE_PERIPHERAL
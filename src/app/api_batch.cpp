@@ -0,0 +1,277 @@
+#include "web_portal_routes.h"
+
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+
+#include "board_config.h"
+#include "json_stream_writer.h"
+#include "log_manager.h"
+#include "macros_config.h"
+#include "web_portal_auth.h"
+#include "web_portal_body.h"
+#include "web_portal_json_alloc.h"
+#include "web_portal_profile.h"
+#include "web_portal_state.h"
+
+#if HAS_DISPLAY
+#include "display_manager.h"
+#include "screen_saver_manager.h"
+#endif
+
+#if HAS_IMAGE_API
+#include "image_api.h"
+#endif
+
+#if PORTAL_BATCH_ENABLED
+
+// POST /api/batch: {"ops":[{"op":"wake"},{"op":"screen","screen":"macro2"}, ...]}
+// Every op is checked before any runs, so a malformed batch changes nothing.
+// Ops then run in order through the same calls as their single routes (display
+// work goes to the LVGL task via the display command queue); the first one
+// that fails stops the batch and the rest are reported as skipped.
+
+namespace {
+
+enum class OpKind : uint8_t {
+    Sleep,
+    Wake,
+    Activity,
+    Screen,
+    Brightness,
+    Macro,
+    ImageUrl,
+};
+
+struct Op {
+    OpKind kind;
+    const char* name;   // points into the request document
+    const char* str;    // screen id / URL
+    long a;             // brightness / macro screen / timeout ms
+    long b;             // macro button
+    bool flag;          // activity wake / image center
+};
+
+struct OpResult {
+    const char* status;   // "ok", "failed", "invalid", "skipped"
+    const char* message;  // nullptr when there is nothing to add
+};
+
+// The whole request document: ops array, their members and short strings.
+constexpr size_t kBatchJsonDocCapacity = 4096;
+
+bool read_uint(JsonVariantConst v, long max, long* out) {
+    if (!v.is<long>()) return false;
+    const long n = v.as<long>();
+    if (n < 0 || n > max) return false;
+    *out = n;
+    return true;
+}
+
+#if HAS_DISPLAY
+bool screen_exists(const char* id) {
+    size_t count = 0;
+    const ScreenInfo* screens = display_manager_get_available_screens(&count);
+    for (size_t i = 0; screens && i < count; i++) {
+        if (screens[i].id && strcmp(screens[i].id, id) == 0) return true;
+    }
+    return false;
+}
+#endif
+
+// Fill op from its JSON object; nullptr when valid, otherwise why not.
+const char* parse_op(JsonObjectConst o, Op* op) {
+    *op = Op{};
+    op->name = o["op"] | "";
+    const char* name = op->name;
+
+#if HAS_DISPLAY
+    if (strcmp(name, "sleep") == 0) {
+        op->kind = OpKind::Sleep;
+        return nullptr;
+    }
+    if (strcmp(name, "wake") == 0) {
+        op->kind = OpKind::Wake;
+        return nullptr;
+    }
+    if (strcmp(name, "activity") == 0) {
+        op->kind = OpKind::Activity;
+        op->flag = o["wake"] | false;
+        return nullptr;
+    }
+    if (strcmp(name, "screen") == 0) {
+        op->kind = OpKind::Screen;
+        op->str = o["screen"] | "";
+        if (!op->str[0]) return "Missing screen ID";
+        if (!screen_exists(op->str)) return "Screen not found";
+        return nullptr;
+    }
+    if (strcmp(name, "brightness") == 0) {
+        op->kind = OpKind::Brightness;
+        if (!read_uint(o["brightness"], 100, &op->a)) return "brightness must be 0-100";
+        return nullptr;
+    }
+    if (strcmp(name, "macro") == 0) {
+        op->kind = OpKind::Macro;
+        if (!read_uint(o["screen"], MACROS_SCREEN_COUNT, &op->a) || op->a < 1) return "Invalid macro screen";
+        if (!read_uint(o["button"], MACROS_BUTTONS_PER_SCREEN, &op->b) || op->b < 1) return "Invalid macro button";
+        return nullptr;
+    }
+#endif
+#if HAS_IMAGE_API
+    if (strcmp(name, "image_url") == 0) {
+        op->kind = OpKind::ImageUrl;
+        op->str = o["url"] | "";
+        if (!op->str[0]) return "Missing url";
+        long timeout_s = 0;
+        if (!o["timeout"].isNull() && !read_uint(o["timeout"], 3600, &timeout_s)) return "Invalid timeout";
+        op->a = timeout_s * 1000L;
+        op->flag = o["center"] | true;
+        return nullptr;
+    }
+#endif
+    return name[0] ? "Unknown op" : "Missing op";
+}
+
+// Run one validated op; nullptr on success, otherwise why it failed.
+const char* run_op(const Op& op) {
+    switch (op.kind) {
+#if HAS_DISPLAY
+        case OpKind::Sleep:
+            screen_saver_manager_sleep_now();
+            return nullptr;
+        case OpKind::Wake:
+            screen_saver_manager_wake();
+            return nullptr;
+        case OpKind::Activity:
+            screen_saver_manager_notify_activity(op.flag);
+            return nullptr;
+        case OpKind::Screen: {
+            bool success = false;
+            display_manager_show_screen(op.str, &success);
+            if (!success) return "Screen not found";
+            // Screen-affecting action counts as explicit activity and should wake.
+            screen_saver_manager_notify_activity(true);
+            return nullptr;
+        }
+        case OpKind::Brightness:
+            screen_saver_manager_set_brightness((uint8_t)op.a);
+            web_portal_note_config_changed();
+            return nullptr;
+        case OpKind::Macro:
+            if (!display_manager_trigger_macro((uint8_t)(op.a - 1), (uint8_t)(op.b - 1))) return "Macro failed";
+            return nullptr;
+#endif
+#if HAS_IMAGE_API
+        case OpKind::ImageUrl: {
+            const char* err = nullptr;
+            if (!image_api_queue_url(op.str, (unsigned long)op.a, op.flag, &err)) return err ? err : "Rejected";
+            return nullptr;
+        }
+#endif
+        default:
+            return "Unsupported op";
+    }
+}
+
+void send_results(AsyncWebServerRequest* request, int code, const Op* ops, const OpResult* results, size_t n, size_t ran) {
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->setCode(code);
+    JsonStreamWriter writer(*response);
+    JsonStreamObject root = writer.root();
+    root["success"] = code == 200;
+    root["ran"] = (uint32_t)ran;
+    JsonStreamArray list = root.createNestedArray("results");
+    for (size_t i = 0; i < n; i++) {
+        JsonStreamObject o = list.createNestedObject();
+        o["op"] = ops[i].name ? ops[i].name : "";
+        o["status"] = results[i].status;
+        if (results[i].message) o["message"] = results[i].message;
+    }
+    portal_profile_bytes_out(request, writer.finish());
+    request->send(response);
+}
+
+void handlePostBatch(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
+    const uint8_t* body = portal_body_collect(request, "batch", data, len, index, total, PORTAL_BATCH_MAX_BODY);
+    if (!body) return;
+
+    // NOTE: AsyncWebServer handlers execute on the AsyncTCP task; avoid large stack allocations.
+    BasicJsonDocument<MacrosJsonAllocator> doc(kBatchJsonDocCapacity);
+    if (doc.capacity() == 0) {
+        portal_body_release(request);
+        Logger.logMessage("Portal", "ERROR: /api/batch OOM (JsonDocument allocation failed)");
+        request->send(503, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
+        return;
+    }
+    DeserializationError error = deserializeJson(doc, body, total);
+    portal_body_release(request);
+
+    if (error) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+        return;
+    }
+
+    JsonArrayConst list = doc["ops"];
+    if (list.isNull() || list.size() == 0) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing ops\"}");
+        return;
+    }
+    if (list.size() > PORTAL_BATCH_MAX_OPS) {
+        request->send(413, "application/json", "{\"success\":false,\"message\":\"Too many ops\"}");
+        return;
+    }
+
+    Op ops[PORTAL_BATCH_MAX_OPS];
+    OpResult results[PORTAL_BATCH_MAX_OPS];
+    const size_t n = list.size();
+
+    bool valid = true;
+    size_t i = 0;
+    for (JsonVariantConst v : list) {
+        JsonObjectConst o = v.as<JsonObjectConst>();
+        ops[i] = Op{};
+        const char* why = o.isNull() ? "Op must be an object" : parse_op(o, &ops[i]);
+        results[i] = why ? OpResult{"invalid", why} : OpResult{"skipped", nullptr};
+        if (why) valid = false;
+        i++;
+    }
+    if (!valid) {
+        Logger.logMessagef("API", "POST /api/batch: rejected (%u ops)", (unsigned)n);
+        send_results(request, 400, ops, results, n, 0);
+        return;
+    }
+
+    size_t ran = 0;
+    const char* failed = nullptr;
+    for (i = 0; i < n && !failed; i++) {
+        failed = run_op(ops[i]);
+        results[i] = failed ? OpResult{"failed", failed} : OpResult{"ok", nullptr};
+        ran++;
+    }
+
+    Logger.logMessagef("API", "POST /api/batch: %u/%u ops%s", (unsigned)ran, (unsigned)n, failed ? ", stopped" : "");
+    send_results(request, failed ? 409 : 200, ops, results, n, ran);
+}
+
+} // namespace
+
+void web_portal_register_api_batch_routes(AsyncWebServer& server) {
+    server.on(
+        "/api/batch",
+        HTTP_POST,
+        [](AsyncWebServerRequest* request) {
+            if (!portal_auth_gate(request)) return;
+        },
+        NULL,
+        handlePostBatch
+    );
+}
+
+#else
+
+void web_portal_register_api_batch_routes(AsyncWebServer& server) {
+    (void)server;
+}
+
+#endif // PORTAL_BATCH_ENABLED
@@ -0,0 +1,124 @@
+#include "web_portal_routes.h"
+
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+
+#include "board_config.h"
+#include "log_manager.h"
+#include "web_portal_auth.h"
+#include "web_portal_body.h"
+
+#if HAS_BLE_KEYBOARD
+#include "ble_keyboard_manager.h"
+#endif
+
+#if HAS_BLE_KEYBOARD
+static void handleGetBleHosts(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+    BleHostStats stats;
+    ble_keyboard_get_host_stats(&stats);
+
+    StaticJsonDocument<1024> doc;
+    doc["active"] = stats.active + 1;
+    doc["switching"] = stats.switching;
+    doc["switches"] = stats.switches;
+    doc["last_switch_ms"] = stats.last_switch_ms;
+    doc["last_switch_directed"] = stats.last_switch_directed;
+
+    JsonArray profiles = doc.createNestedArray("profiles");
+    for (uint8_t i = 0; i < stats.count; i++) {
+        BleHostProfileInfo info;
+        if (!ble_keyboard_get_host_profile(i, &info)) break;
+        JsonObject p = profiles.createNestedObject();
+        p["profile"] = i + 1;
+        p["address"] = info.own_address;
+        p["bonded"] = info.bonded;
+        if (info.bonded) {
+            p["host"] = info.peer_address;
+        } else {
+            p["host"] = nullptr;
+        }
+    }
+
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// Body: {"profile": n} (1-based).
+static bool parseProfile(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total, uint8_t* out) {
+    const uint8_t* body = portal_body_collect(request, "ble", data, len, index, total, 128);
+    if (!body) return false;
+
+    StaticJsonDocument<128> doc;
+    const DeserializationError error = deserializeJson(doc, body, total);
+    portal_body_release(request);
+    if (error) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+        return false;
+    }
+
+    BleHostStats stats;
+    ble_keyboard_get_host_stats(&stats);
+    const int profile = doc["profile"] | 0;
+    if (profile < 1 || profile > stats.count) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid profile\"}");
+        return false;
+    }
+    *out = (uint8_t)(profile - 1);
+    return true;
+}
+
+static void handleSelectBleHost(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
+    uint8_t profile = 0;
+    if (!parseProfile(request, data, len, index, total, &profile)) return;
+
+    Logger.logMessagef("API", "POST /api/ble/host: profile %u", (unsigned)profile + 1);
+    (void)ble_keyboard_select_host(profile);
+
+    // Applied by the main loop; GET /api/ble/hosts shows when the host is back.
+    char response[64];
+    snprintf(response, sizeof(response), "{\"success\":true,\"profile\":%u}", (unsigned)profile + 1);
+    request->send(202, "application/json", response);
+}
+
+static void handleForgetBleHost(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
+    uint8_t profile = 0;
+    if (!parseProfile(request, data, len, index, total, &profile)) return;
+
+    Logger.logMessagef("API", "POST /api/ble/host/forget: profile %u", (unsigned)profile + 1);
+    (void)ble_keyboard_forget_host(profile);
+    request->send(202, "application/json", "{\"success\":true}");
+}
+#endif
+
+void web_portal_register_api_ble_routes(AsyncWebServer& server) {
+#if HAS_BLE_KEYBOARD
+    server.on("/api/ble/hosts", HTTP_GET, handleGetBleHosts);
+
+    server.on(
+        "/api/ble/host",
+        HTTP_POST,
+        [](AsyncWebServerRequest* request) {
+            if (!portal_auth_gate(request)) return;
+        },
+        NULL,
+        handleSelectBleHost
+    );
+
+    server.on(
+        "/api/ble/host/forget",
+        HTTP_POST,
+        [](AsyncWebServerRequest* request) {
+            if (!portal_auth_gate(request)) return;
+        },
+        NULL,
+        handleForgetBleHost
+    );
+#else
+    (void)server;
+#endif
+}
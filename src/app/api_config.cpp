@@ -6,7 +6,10 @@
 #include "board_config.h"
 #include "config_manager.h"
 #include "log_manager.h"
+#include "log_stream.h"
 #include "web_portal_auth.h"
+#include "web_portal_body.h"
+#include "web_portal_http.h"
 #include "web_portal_json_alloc.h"
 #include "web_portal_state.h"
 
@@ -15,6 +18,10 @@
 #include "screen_saver_manager.h"
 #endif
 
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+#include "image_api.h"
+#endif
+
 static void handleGetConfig(AsyncWebServerRequest* request) {
     if (!portal_auth_gate(request)) return;
 
@@ -24,6 +31,10 @@ static void handleGetConfig(AsyncWebServerRequest* request) {
         return;
     }
 
+    char etag[48];
+    portal_format_etag(etag, sizeof(etag), "config", web_portal_state().config_generation);
+    if (portal_send_not_modified(request, etag)) return;
+
     // Create JSON response (don't include passwords)
     // NOTE: AsyncWebServer handlers execute on the AsyncTCP task; avoid large stack allocations.
     static constexpr size_t kConfigJsonDocCapacity = 2304;
@@ -69,6 +80,20 @@ static void handleGetConfig(AsyncWebServerRequest* request) {
     // Display settings
     doc["backlight_brightness"] = current_config->backlight_brightness;
 
+#if LOG_STREAM_ENABLED
+    doc["log_stream_host"] = current_config->log_stream_host;
+    doc["log_stream_port"] = current_config->log_stream_port;
+#endif
+
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+    doc["image_mcast_group"] = current_config->image_mcast_group;
+    doc["image_mcast_port"] = current_config->image_mcast_port;
+#endif
+
+#if HAS_BLE_KEYBOARD
+    doc["ble_typing_interval_ms"] = current_config->ble_typing_interval_ms;
+#endif
+
 #if HAS_DISPLAY
     // Screen saver settings
     doc["screen_saver_enabled"] = current_config->screen_saver_enabled;
@@ -86,17 +111,23 @@ static void handleGetConfig(AsyncWebServerRequest* request) {
 
     AsyncResponseStream* response = request->beginResponseStream("application/json");
     serializeJson(doc, *response);
+    portal_add_etag_headers(response, etag);
     request->send(response);
 }
 
+// Largest POST /api/config body accepted.
+static constexpr size_t kConfigMaxBody = 4096;
+
 static void handlePostConfig(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
     if (!portal_auth_gate(request)) return;
 
-    (void)index;
-    (void)total;
+    // Bodies larger than one TCP segment arrive in several chunks.
+    const uint8_t* body = portal_body_collect(request, "config", data, len, index, total, kConfigMaxBody);
+    if (!body) return;
 
     DeviceConfig* current_config = web_portal_state().config;
     if (!current_config) {
+        portal_body_release(request);
         request->send(500, "application/json", "{\"success\":false,\"message\":\"Config not initialized\"}");
         return;
     }
@@ -106,11 +137,13 @@ static void handlePostConfig(AsyncWebServerRequest* request, uint8_t* data, size
     static constexpr size_t kConfigJsonDocCapacity = 2304;
     BasicJsonDocument<MacrosJsonAllocator> doc(kConfigJsonDocCapacity);
     if (doc.capacity() == 0) {
+        portal_body_release(request);
         Logger.logMessage("Portal", "ERROR: /api/config OOM (JsonDocument allocation failed)");
         request->send(503, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
         return;
     }
-    DeserializationError error = deserializeJson(doc, data, len);
+    DeserializationError error = deserializeJson(doc, body, total);
+    portal_body_release(request);
 
     if (error) {
         Logger.logMessagef("Portal", "JSON parse error: %s", error.c_str());
@@ -213,6 +246,36 @@ static void handlePostConfig(AsyncWebServerRequest* request, uint8_t* data, size
         }
     }
 
+#if LOG_STREAM_ENABLED
+    // Syslog receiver (optional; port 0 means default 514)
+    if (doc.containsKey("log_stream_host")) {
+        strlcpy(current_config->log_stream_host, doc["log_stream_host"] | "", CONFIG_LOG_STREAM_HOST_MAX_LEN);
+    }
+    if (doc.containsKey("log_stream_port")) {
+        if (doc["log_stream_port"].is<const char*>()) {
+            const char* port_str = doc["log_stream_port"];
+            current_config->log_stream_port = (uint16_t)atoi(port_str ? port_str : "0");
+        } else {
+            current_config->log_stream_port = (uint16_t)(doc["log_stream_port"] | 0);
+        }
+    }
+#endif
+
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+    // Multicast image group (optional; port 0 means IMAGE_API_MULTICAST_DEFAULT_PORT)
+    if (doc.containsKey("image_mcast_group")) {
+        strlcpy(current_config->image_mcast_group, doc["image_mcast_group"] | "", CONFIG_IMAGE_MCAST_GROUP_MAX_LEN);
+    }
+    if (doc.containsKey("image_mcast_port")) {
+        if (doc["image_mcast_port"].is<const char*>()) {
+            const char* port_str = doc["image_mcast_port"];
+            current_config->image_mcast_port = (uint16_t)atoi(port_str ? port_str : "0");
+        } else {
+            current_config->image_mcast_port = (uint16_t)(doc["image_mcast_port"] | 0);
+        }
+    }
+#endif
+
     // Basic Auth enabled
     if (doc.containsKey("basic_auth_enabled")) {
         if (doc["basic_auth_enabled"].is<const char*>()) {
@@ -263,6 +326,22 @@ static void handlePostConfig(AsyncWebServerRequest* request, uint8_t* data, size
 #endif
     }
 
+#if HAS_BLE_KEYBOARD
+    // BLE typing pace (0-255 ms per report)
+    if (doc.containsKey("ble_typing_interval_ms")) {
+        int v;
+        if (doc["ble_typing_interval_ms"].is<const char*>()) {
+            const char* s = doc["ble_typing_interval_ms"];
+            v = atoi(s ? s : "0");
+        } else {
+            v = (int)(doc["ble_typing_interval_ms"] | BLE_KEYBOARD_TYPING_INTERVAL_MS);
+        }
+        if (v < 0) v = 0;
+        if (v > 255) v = 255;
+        current_config->ble_typing_interval_ms = (uint8_t)v;
+    }
+#endif
+
 #if HAS_DISPLAY
     // Screen saver settings
     if (doc.containsKey("screen_saver_enabled")) {
@@ -312,6 +391,8 @@ static void handlePostConfig(AsyncWebServerRequest* request, uint8_t* data, size
 #endif
 
     current_config->magic = CONFIG_MAGIC;
+    // Fields above changed in RAM even if validation or the save below fails.
+    web_portal_state().config_generation = web_portal_state().config_generation + 1;
 
     // Validate config
     if (!config_manager_is_valid(current_config)) {
@@ -319,13 +400,19 @@ static void handlePostConfig(AsyncWebServerRequest* request, uint8_t* data, size
         return;
     }
 
-    // Save to NVS
-    if (config_manager_save(current_config)) {
-        Logger.logMessage("Portal", "Config saved");
+    // Save to NVS: now when rebooting, else once the settings stop changing
+    // (sliders post several saves a second; they coalesce into one write).
+    const bool reboot = !request->hasParam("no_reboot");
+    const bool saved = reboot ? config_manager_save(current_config) : config_manager_save_deferred(current_config);
+    if (saved) {
+        Logger.logMessage("Portal", reboot ? "Config saved" : "Config applied; write pending");
+        log_stream_configure(current_config);
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+        image_api_multicast_configure(current_config->image_mcast_group, current_config->image_mcast_port);
+#endif
         request->send(200, "application/json", "{\"success\":true,\"message\":\"Configuration saved\"}");
 
-        // Check for no_reboot parameter
-        if (!request->hasParam("no_reboot")) {
+        if (reboot) {
             Logger.logMessage("Portal", "Rebooting device");
             // Schedule reboot after response is sent
             delay(100);
@@ -1,7 +1,6 @@
 #include "web_portal_routes.h"
 
 #include <ESPAsyncWebServer.h>
-#include <ArduinoJson.h>
 #include <WiFi.h>
 
 #include "board_config.h"
@@ -10,8 +9,8 @@
 #include "log_manager.h"
 #include "project_branding.h"
 #include "web_portal_auth.h"
-#include "web_portal_http.h"
-#include "web_portal_json_alloc.h"
+#include "web_portal_body.h"
+#include "web_portal_json_stream.h"
 #include "web_portal_state.h"
 #include "../version.h"
 
@@ -20,6 +19,10 @@
 #include "screen_saver_manager.h"
 #endif
 
+#if BENCH_ENABLED
+#include "bench.h"
+#endif
+
 static void handleGetMode(AsyncWebServerRequest* request) {
     if (!portal_auth_gate(request)) return;
 
@@ -47,25 +50,64 @@ static void handleReboot(AsyncWebServerRequest* request) {
     ESP.restart();
 }
 
+#if BENCH_ENABLED
+static void send_bench_started(AsyncWebServerRequest* request, bool ok, const char* err) {
+    if (ok) {
+        request->send(202, "application/json", "{\"success\":true,\"state\":\"running\"}");
+        return;
+    }
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->setCode(bench_get_state() == BenchState::Running ? 409 : 400);
+    response->print("{\"success\":false,\"message\":\"");
+    response->print(err);
+    response->print("\"}");
+    request->send(response);
+}
+
+// POST /api/bench
+// Starts a benchmark run (bench.h); poll GET /api/bench for the results.
+// A JPEG body (at most BENCH_JPEG_MAX_BYTES) enables the decode tests.
+static void handlePostBench(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+    // Requests with a body are answered by handlePostBenchBody.
+    if (request->contentLength() > 0) return;
+    char err[96];
+    const bool ok = bench_start(nullptr, 0, err, sizeof(err));
+    Logger.logMessagef("API", "POST /api/bench: %s", ok ? "started" : err);
+    send_bench_started(request, ok, err);
+}
+
+static void handlePostBenchBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
+    const uint8_t* body = portal_body_collect(request, "bench", data, len, index, total, BENCH_JPEG_MAX_BYTES);
+    if (!body) return;
+    char err[96];
+    const bool ok = bench_start(body, total, err, sizeof(err));
+    portal_body_release(request);
+    Logger.logMessagef("API", "POST /api/bench (%u byte JPEG): %s", (unsigned)total, ok ? "started" : err);
+    send_bench_started(request, ok, err);
+}
+
+// GET /api/bench
+// State of the current or last run, with its results once done.
+static void handleGetBench(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+    portal_send_json_stream(request, bench_write_json);
+}
+#endif
+
 void web_portal_register_api_core_routes(AsyncWebServer& server) {
     server.on("/api/mode", HTTP_GET, handleGetMode);
     server.on("/api/info", HTTP_GET, handleGetVersion);
     server.on("/api/health", HTTP_GET, handleGetHealth);
     server.on("/api/reboot", HTTP_POST, handleReboot);
+#if BENCH_ENABLED
+    server.on("/api/bench", HTTP_GET, handleGetBench);
+    server.on("/api/bench", HTTP_POST, handlePostBench, NULL, handlePostBenchBody);
+#endif
 }
 
-static void handleGetVersion(AsyncWebServerRequest* request) {
-    if (!portal_auth_gate(request)) return;
-
-    // Build JSON via ArduinoJson (safe escaping), then stream it using chunked response.
-    // NOTE: AsyncWebServer handlers execute on the AsyncTCP task; avoid large stack allocations.
-    static constexpr size_t kInfoJsonDocCapacity = 4096;
-    BasicJsonDocument<MacrosJsonAllocator> doc(kInfoJsonDocCapacity);
-    if (doc.capacity() == 0) {
-        request->send(503, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
-        return;
-    }
-
+static void write_info(JsonStreamObject& doc) {
     doc["version"] = FIRMWARE_VERSION;
     doc["build_date"] = BUILD_DATE;
     doc["build_time"] = BUILD_TIME;
@@ -78,13 +120,15 @@ static void handleGetVersion(AsyncWebServerRequest* request) {
     doc["free_heap"] = ESP.getFreeHeap();
     doc["sketch_size"] = device_telemetry_sketch_size();
     doc["free_sketch_space"] = device_telemetry_free_sketch_space();
-    doc["mac_address"] = WiFi.macAddress();
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    char mac_str[18];
+    snprintf(mac_str, sizeof(mac_str), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    doc["mac_address"] = mac_str;
     doc["wifi_hostname"] = WiFi.getHostname();
 
-    String mdns;
-    mdns.reserve(64);
-    mdns += WiFi.getHostname();
-    mdns += ".local";
+    char mdns[72];
+    snprintf(mdns, sizeof(mdns), "%s.local", WiFi.getHostname());
     doc["mdns_name"] = mdns;
     doc["hostname"] = WiFi.getHostname();
     doc["project_name"] = PROJECT_NAME;
@@ -93,6 +137,9 @@ static void handleGetVersion(AsyncWebServerRequest* request) {
     // Web portal health widget configuration (client-side only).
     doc["health_poll_interval_ms"] = HEALTH_POLL_INTERVAL_MS;
     doc["health_history_seconds"] = HEALTH_HISTORY_SECONDS;
+    // Push updates on /api/events instead of polling (falls back to polling).
+    doc["events"] = (PORTAL_EVENTS_ENABLED ? true : false);
+    doc["route_profile"] = (PORTAL_ROUTE_PROFILE_ENABLED ? true : false);
 
     // Build metadata for GitHub-based updates
 #ifdef BUILD_BOARD_NAME
@@ -101,6 +148,8 @@ static void handleGetVersion(AsyncWebServerRequest* request) {
     doc["board_name"] = "unknown";
 #endif
     doc["github_updates_enabled"] = (GITHUB_UPDATES_ENABLED ? true : false);
+    // /api/update takes .bin.gz (the portal compresses uploads when the browser can).
+    doc["ota_gzip"] = (OTA_GZIP_ENABLED ? true : false);
 #if GITHUB_UPDATES_ENABLED
     doc["github_owner"] = GITHUB_OWNER;
     doc["github_repo"] = GITHUB_REPO;
@@ -108,6 +157,9 @@ static void handleGetVersion(AsyncWebServerRequest* request) {
 
     doc["has_mqtt"] = (HAS_MQTT ? true : false);
     doc["has_backlight"] = (HAS_BACKLIGHT ? true : false);
+    doc["has_ble_keyboard"] = (HAS_BLE_KEYBOARD ? true : false);
+    doc["has_log_stream"] = ((LOG_STREAM_ENABLED && LOG_ASYNC_ENABLED) ? true : false);
+    doc["has_image_multicast"] = ((HAS_IMAGE_API && IMAGE_API_MULTICAST) ? true : false);
 
 #if HAS_DISPLAY
     doc["has_display"] = true;
@@ -125,9 +177,9 @@ static void handleGetVersion(AsyncWebServerRequest* request) {
     // Get available screens
     size_t screen_count = 0;
     const ScreenInfo* screens = display_manager_get_available_screens(&screen_count);
-    JsonArray arr = doc.createNestedArray("available_screens");
+    JsonStreamArray arr = doc.createNestedArray("available_screens");
     for (size_t i = 0; i < screen_count; i++) {
-        JsonObject o = arr.createNestedObject();
+        JsonStreamObject o = arr.createNestedObject();
         o["id"] = screens[i].id;
         o["name"] = screens[i].display_name;
     }
@@ -142,32 +194,16 @@ static void handleGetVersion(AsyncWebServerRequest* request) {
 #else
     doc["has_display"] = false;
 #endif
+}
 
-    if (doc.overflowed()) {
-        Logger.logMessage("Portal", "ERROR: /api/info JSON overflow (document too small)");
-        request->send(500, "application/json", "{\"success\":false,\"message\":\"Response too large\"}");
-        return;
-    }
-
-    send_json_doc_chunked(request, doc, 503);
+// Both are polled by every open portal tab: stream them into a reusable
+// buffer instead of building a JsonDocument per request.
+static void handleGetVersion(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+    portal_send_json_stream(request, write_info);
 }
 
 static void handleGetHealth(AsyncWebServerRequest* request) {
     if (!portal_auth_gate(request)) return;
-
-    BasicJsonDocument<MacrosJsonAllocator> doc(1024);
-    if (doc.capacity() == 0) {
-        request->send(503, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
-        return;
-    }
-
-    device_telemetry_fill_api(doc);
-
-    if (doc.overflowed()) {
-        Logger.logMessage("Portal", "ERROR: /api/health JSON overflow (StaticJsonDocument too small)");
-        request->send(500, "application/json", "{\"success\":false,\"message\":\"Response too large\"}");
-        return;
-    }
-
-    send_json_doc_chunked(request, doc, 503);
+    portal_send_json_stream(request, device_telemetry_write_api);
 }
@@ -6,24 +6,37 @@
 #include "config_manager.h"
 #include "log_manager.h"
 #include "web_portal_auth.h"
+#include "web_portal_body.h"
 #include "web_portal_state.h"
 
 #if HAS_DISPLAY
 #include "display_manager.h"
+#include "screen_capture.h"
 #include "screen_saver_manager.h"
 #endif
 
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+#include "heap_placement.h"
+#include "label_font.h"
+#include "macros_config.h"
+
+// The runtime macro screen UI reads from this instance (defined in app.ino).
+extern MacroConfig macro_config;
+#endif
+
 #if HAS_DISPLAY
+// Largest JSON body accepted by the display PUT routes.
+static constexpr size_t kDisplayMaxBody = 256;
+
 static void handleSetDisplayBrightness(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
     if (!portal_auth_gate(request)) return;
-    // Only handle the complete request (index == 0 && index + len == total)
-    if (index != 0 || index + len != total) {
-        return;
-    }
+    const uint8_t* body = portal_body_collect(request, "display", data, len, index, total, kDisplayMaxBody);
+    if (!body) return;
 
     // Parse JSON body
     StaticJsonDocument<256> doc;
-    DeserializationError error = deserializeJson(doc, data, len);
+    DeserializationError error = deserializeJson(doc, body, total);
+    portal_body_release(request);
 
     if (error) {
         request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
@@ -39,22 +52,9 @@ static void handleSetDisplayBrightness(AsyncWebServerRequest* request, uint8_t*
     uint8_t brightness = (uint8_t)(doc["brightness"] | 100);
     if (brightness > 100) brightness = 100;
 
-    // Update the in-RAM target brightness (does not persist to NVS).
-    // This keeps the screen saver target consistent with what the user sees.
-    if (web_portal_state().config) {
-        web_portal_state().config->backlight_brightness = brightness;
-    }
+    screen_saver_manager_set_brightness(brightness);
 
-    // Edge case: if the screen saver is dimming/asleep/fading, directly setting the
-    // backlight would show the UI again without updating the screen saver state.
-    // Easiest fix: when not Awake, route through the screen saver wake path.
-    const ScreenSaverState state = screen_saver_manager_get_status().state;
-    if (state != ScreenSaverState::Awake) {
-        screen_saver_manager_wake();
-    } else {
-        display_manager_set_backlight_brightness(brightness);
-        screen_saver_manager_notify_activity(false);
-    }
+    web_portal_note_config_changed();
 
     // Return success
     char response[64];
@@ -107,14 +107,13 @@ static void handlePostDisplayActivity(AsyncWebServerRequest* request) {
 
 static void handleSetDisplayScreen(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
     if (!portal_auth_gate(request)) return;
-    // Only handle the complete request (index == 0 && index + len == total)
-    if (index != 0 || index + len != total) {
-        return;
-    }
+    const uint8_t* body = portal_body_collect(request, "display", data, len, index, total, kDisplayMaxBody);
+    if (!body) return;
 
     // Parse JSON body
     StaticJsonDocument<256> doc;
-    DeserializationError error = deserializeJson(doc, data, len);
+    DeserializationError error = deserializeJson(doc, body, total);
+    portal_body_release(request);
 
     if (error) {
         request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
@@ -155,6 +154,101 @@ static void handleSetDisplayScreen(AsyncWebServerRequest* request, uint8_t* data
 }
 #endif
 
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+// Distinct code points reported by GET /api/fonts/glyphs.
+static constexpr size_t kMaxLabelCodepoints = 512;
+
+static void send_font_result(AsyncWebServerRequest* request, bool ok, const char* err) {
+    if (ok) {
+        request->send(200, "application/json", "{\"success\":true}");
+        return;
+    }
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->setCode(400);
+    response->print("{\"success\":false,\"message\":\"");
+    response->print(err);
+    response->print("\"}");
+    request->send(response);
+}
+
+// GET /api/fonts/label
+// {"loaded":bool,"file_bytes":N,"glyphs":N,"line_height":N,"loads":N,"load_failures":N,"load_ms":N}
+static void handleGetLabelFont(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+    LabelFontStats st;
+    label_font_get_stats(&st);
+
+    StaticJsonDocument<256> doc;
+    doc["loaded"] = st.loaded;
+    doc["file_bytes"] = st.file_bytes;
+    doc["glyphs"] = st.glyphs;
+    doc["line_height"] = st.line_height;
+    doc["loads"] = st.loads;
+    doc["load_failures"] = st.load_failures;
+    doc["load_ms"] = st.load_ms;
+    doc["max_bytes"] = (uint32_t)LABEL_FONT_MAX_BYTES;
+
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    serializeJson(doc, *response);
+    request->send(response);
+}
+
+// POST /api/fonts/label
+// Body: an LVGL binary font (lv_font_conv --format bin). Stored as
+// /fonts/label.bin; the LVGL task loads it and the labels re-layout.
+static void handlePostLabelFont(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
+    if (index == 0 && portal_body_owner_active("font")) {
+        request->send(409, "application/json", "{\"success\":false,\"message\":\"Another font upload is in progress\"}");
+        return;
+    }
+    const uint8_t* body = portal_body_collect(request, "font", data, len, index, total, LABEL_FONT_MAX_BYTES);
+    if (!body) return;
+
+    char err[96];
+    const bool ok = label_font_save(body, total, err, sizeof(err));
+    portal_body_release(request);
+    Logger.logMessagef("API", "POST /api/fonts/label (%u bytes): %s", (unsigned)total, ok ? "saved" : err);
+    send_font_result(request, ok, err);
+}
+
+// DELETE /api/fonts/label
+static void handleDeleteLabelFont(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+    char err[96];
+    const bool ok = label_font_remove(err, sizeof(err));
+    send_font_result(request, ok, err);
+}
+
+// GET /api/fonts/glyphs
+// {"codepoints":[N,...],"truncated":bool}: what the macro labels use, for
+// subsetting the label font (tools/label_font.py).
+static void handleGetLabelFontGlyphs(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+    uint32_t* cps = (uint32_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Http, kMaxLabelCodepoints * sizeof(uint32_t));
+    if (!cps) {
+        request->send(503, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
+        return;
+    }
+    bool truncated = false;
+    macros_config_ensure_loaded();
+    const size_t count = label_font_collect_codepoints(&macro_config, cps, kMaxLabelCodepoints, &truncated);
+
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->setCode(200);
+    response->print("{\"codepoints\":[");
+    for (size_t i = 0; i < count; i++) {
+        if (i) response->print(",");
+        response->print((unsigned)cps[i]);
+    }
+    response->print(truncated ? "],\"truncated\":true}" : "],\"truncated\":false}");
+    heap_tag_free(HeapTag::Http, cps);
+    request->send(response);
+}
+#endif
+
 void web_portal_register_api_display_routes(AsyncWebServer& server) {
 #if HAS_DISPLAY
     server.on(
@@ -183,6 +277,24 @@ void web_portal_register_api_display_routes(AsyncWebServer& server) {
         NULL,
         handleSetDisplayScreen
     );
+
+    // Screenshot and mirror (no-op unless SCREEN_CAPTURE_ENABLED)
+    screen_capture_register_routes(server);
+
+    #if LABEL_FONT_ENABLED
+    server.on("/api/fonts/glyphs", HTTP_GET, handleGetLabelFontGlyphs);
+    server.on("/api/fonts/label", HTTP_GET, handleGetLabelFont);
+    server.on("/api/fonts/label", HTTP_DELETE, handleDeleteLabelFont);
+    server.on(
+        "/api/fonts/label",
+        HTTP_POST,
+        [](AsyncWebServerRequest* request) {
+            if (!portal_auth_gate(request)) return;
+        },
+        NULL,
+        handlePostLabelFont
+    );
+    #endif
 #else
     (void)server;
 #endif
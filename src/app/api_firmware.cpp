@@ -4,12 +4,17 @@
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <Update.h>
-#include <WiFiClientSecure.h>
 #include <WiFi.h>
 
 #include "device_telemetry.h"
 #include "github_release_config.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
 #include "log_manager.h"
+#include "ota_delta.h"
+#include "ota_gzip.h"
+#include "ota_quiet.h"
+#include "tls_client.h"
 #include "project_branding.h"
 #include "web_portal_auth.h"
 #include "web_portal_json_alloc.h"
@@ -17,16 +22,29 @@
 #include "../version.h"
 
 #include <esp_heap_caps.h>
+#include <lwip/sockets.h>
+#include <mbedtls/sha256.h>
+#include <new>
 
 static TaskHandle_t firmware_update_task_handle = nullptr;
 static volatile bool firmware_update_in_progress = false;
 static volatile size_t firmware_update_progress = 0;
 static volatile size_t firmware_update_total = 0;
+static volatile uint32_t firmware_update_bytes_per_sec = 0;
+
+// What github_fetch_latest_release() found; empty strings when absent.
+struct FirmwareRelease {
+    char version[24];
+    char asset_url[512];
+    size_t asset_size;
+    char asset_sha256[65];  // hex, from the asset's "digest" when GitHub lists one
+    char delta_url[512];    // patch from the running version
+    char delta_sha256[65];
+};
 
 static char firmware_update_state[16] = "idle"; // idle|downloading|writing|rebooting|error
 static char firmware_update_error[192] = "";
-static char firmware_update_latest_version[24] = "";
-static char firmware_update_download_url[512] = "";
+static FirmwareRelease firmware_update_release = {};
 
 static bool parse_semver_triplet(const char* s, int* major, int* minor, int* patch) {
     if (!s || !major || !minor || !patch) return false;
@@ -58,30 +76,24 @@ static int compare_semver(const char* a, const char* b) {
     return 0;
 }
 
-static bool github_fetch_latest_release(
-    char* out_version,
-    size_t out_version_len,
-    char* out_asset_url,
-    size_t out_asset_url_len,
-    size_t* out_asset_size,
-    char* out_error,
-    size_t out_error_len
-) {
+// GitHub lists an asset's digest as "sha256:<64 hex>"; anything else is
+// treated as absent.
+static void github_digest_to_sha256(const char* digest, char* out, size_t out_len) {
+    out[0] = '\0';
+    if (!digest || strncmp(digest, "sha256:", 7) != 0 || strlen(digest + 7) != 64) return;
+    strlcpy(out, digest + 7, out_len);
+}
+
+static bool github_fetch_latest_release(FirmwareRelease* out, char* out_error, size_t out_error_len) {
 #if !GITHUB_UPDATES_ENABLED
-    (void)out_version;
-    (void)out_version_len;
-    (void)out_asset_url;
-    (void)out_asset_url_len;
-    (void)out_asset_size;
+    (void)out;
     if (out_error && out_error_len > 0) {
         strlcpy(out_error, "GitHub updates disabled", out_error_len);
     }
     return false;
 #else
     if (out_error && out_error_len > 0) out_error[0] = '\0';
-    if (out_version && out_version_len > 0) out_version[0] = '\0';
-    if (out_asset_url && out_asset_url_len > 0) out_asset_url[0] = '\0';
-    if (out_asset_size) *out_asset_size = 0;
+    memset(out, 0, sizeof(*out));
 
     if (WiFi.status() != WL_CONNECTED) {
         if (out_error && out_error_len > 0) {
@@ -93,9 +105,8 @@ static bool github_fetch_latest_release(
     char api_url[256];
     snprintf(api_url, sizeof(api_url), "https://api.github.com/repos/%s/%s/releases/latest", GITHUB_OWNER, GITHUB_REPO);
 
-    WiFiClientSecure client;
-    client.setInsecure();
-    client.setTimeout(15000);
+    TlsClient client;
+    client.setHandshakeTimeout(15000);
 
     HTTPClient http;
     http.setTimeout(15000);
@@ -135,6 +146,7 @@ static bool github_fetch_latest_release(
     filter["assets"][0]["name"] = true;
     filter["assets"][0]["browser_download_url"] = true;
     filter["assets"][0]["size"] = true;
+    filter["assets"][0]["digest"] = true;
 
     // Read the full response before parsing. Parsing directly from the stream can
     // occasionally fail with IncompleteInput if the connection stalls.
@@ -182,18 +194,39 @@ static bool github_fetch_latest_release(
 
     snprintf(expected_asset_name, sizeof(expected_asset_name), "%s-%s-v%s.bin", PROJECT_NAME, board, version);
 
+    // Releases also carry <asset>.bin.gz; it is about half the download.
+    char gzip_asset_name[sizeof(expected_asset_name) + 3];
+    snprintf(gzip_asset_name, sizeof(gzip_asset_name), "%s.gz", expected_asset_name);
+
+    // ... and, for devices on the previous release, a patch against it:
+    // <project>-<board>-vX.Y.Z-from-vA.B.C.delta.gz (tools/make_delta_ota.py).
+    char delta_asset_name[sizeof(expected_asset_name) + 48];
+    snprintf(delta_asset_name, sizeof(delta_asset_name), "%s-%s-v%s-from-v%s.delta.gz", PROJECT_NAME, board, version, FIRMWARE_VERSION);
+
     JsonArray assets = doc["assets"].as<JsonArray>();
     const char* found_url = nullptr;
+    const char* found_digest = "";
     size_t found_size = 0;
+    bool found_gzip = false;
 
     for (JsonVariant v : assets) {
         const char* name = v["name"] | "";
         const char* url = v["browser_download_url"] | "";
+        const char* digest = v["digest"] | "";
         const size_t size = (size_t)(v["size"] | 0);
-        if (name && url && strlen(name) > 0 && strcmp(name, expected_asset_name) == 0) {
+        if (!name || !url || strlen(name) == 0) continue;
+        if (OTA_GZIP_ENABLED && strcmp(name, gzip_asset_name) == 0) {
             found_url = url;
+            found_digest = digest;
             found_size = size;
-            break;
+            found_gzip = true;
+        } else if (!found_gzip && strcmp(name, expected_asset_name) == 0) {
+            found_url = url;
+            found_digest = digest;
+            found_size = size;
+        } else if (OTA_DELTA_ENABLED && strcmp(name, delta_asset_name) == 0) {
+            strlcpy(out->delta_url, url, sizeof(out->delta_url));
+            github_digest_to_sha256(digest, out->delta_sha256, sizeof(out->delta_sha256));
         }
     }
 
@@ -205,155 +238,378 @@ static bool github_fetch_latest_release(
         return false;
     }
 
-    if (out_version && out_version_len > 0) {
-        strlcpy(out_version, version, out_version_len);
-    }
-    if (out_asset_url && out_asset_url_len > 0) {
-        strlcpy(out_asset_url, found_url, out_asset_url_len);
-    }
-    if (out_asset_size) {
-        *out_asset_size = found_size;
-    }
+    strlcpy(out->version, version, sizeof(out->version));
+    strlcpy(out->asset_url, found_url, sizeof(out->asset_url));
+    out->asset_size = found_size;
+    github_digest_to_sha256(found_digest, out->asset_sha256, sizeof(out->asset_sha256));
 
     http.end();
     return true;
 #endif
 }
 
-static void firmware_update_task(void* pv) {
-    (void)pv;
+static bool firmware_flash_sink(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    const uint32_t t0 = micros();
+    const bool ok = Update.write(const_cast<uint8_t*>(data), len) == len;
+    ota_quiet_note_flash_write(len, micros() - t0);
+    return ok;
+}
 
-    // Snapshot URL and size/version at task start.
-    char url[sizeof(firmware_update_download_url)];
-    char latest_version[sizeof(firmware_update_latest_version)];
-    size_t expected_total = firmware_update_total;
-    strlcpy(url, firmware_update_download_url, sizeof(url));
-    strlcpy(latest_version, firmware_update_latest_version, sizeof(latest_version));
+static void firmware_update_fail(const char* msg) {
+    strlcpy(firmware_update_error, msg, sizeof(firmware_update_error));
+}
 
-    firmware_update_progress = 0;
-    strlcpy(firmware_update_state, "downloading", sizeof(firmware_update_state));
-    firmware_update_error[0] = '\0';
+// Download ring: the update task fills flash-sector-sized slots from the
+// network while a writer task drains them through the inflate/delta stages
+// into Update, so TLS reads and flash erases overlap instead of alternating.
+static constexpr size_t kRingSlotBytes = 4096;
+static constexpr uint8_t kRingEnd = 0xFF;
+
+// No byte for this long counts as a dropped connection.
+static constexpr uint32_t kDownloadStallMs = 10000;
+
+struct FirmwareRing {
+    QueueHandle_t free_slots;  // slot indices the reader may fill
+    QueueHandle_t full_slots;  // slot indices to write; kRingEnd stops the writer
+    uint8_t* slot[FIRMWARE_DL_RING_SLOTS];
+    size_t len[FIRMWARE_DL_RING_SLOTS];
+    size_t count;
+    OtaGzip* inflater;         // first stage, or nullptr to write straight to Update
+    TaskHandle_t reader;       // notified when the writer has exited
+    volatile bool ok;          // false once a write failed
+};
+
+static void firmware_ring_free(FirmwareRing* ring) {
+    for (size_t i = 0; i < ring->count; i++) heap_tag_free(HeapTag::Ota, ring->slot[i]);
+    ring->count = 0;
+    if (ring->free_slots) vQueueDelete(ring->free_slots);
+    if (ring->full_slots) vQueueDelete(ring->full_slots);
+    ring->free_slots = nullptr;
+    ring->full_slots = nullptr;
+}
 
-    // Mark OTA in progress to block other OTA/image operations.
-    web_portal_state().ota_in_progress = true;
+// Allocate up to FIRMWARE_DL_RING_SLOTS slots (PSRAM first); two are enough
+// to overlap network and flash.
+static bool firmware_ring_alloc(FirmwareRing* ring) {
+    ring->free_slots = xQueueCreate(FIRMWARE_DL_RING_SLOTS, sizeof(uint8_t));
+    ring->full_slots = xQueueCreate(FIRMWARE_DL_RING_SLOTS + 1, sizeof(uint8_t));
+    if (!ring->free_slots || !ring->full_slots) return false;
+
+    for (size_t i = 0; i < FIRMWARE_DL_RING_SLOTS; i++) {
+        uint8_t* p = (uint8_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Ota, kRingSlotBytes);
+        if (!p) break;
+        ring->slot[i] = p;
+        const uint8_t idx = (uint8_t)i;
+        xQueueSend(ring->free_slots, &idx, 0);
+        ring->count++;
+    }
+    return ring->count >= 2;
+}
 
-    WiFiClientSecure client;
-    client.setInsecure();
+static void firmware_writer_task(void* pv) {
+    FirmwareRing* ring = (FirmwareRing*)pv;
+    uint8_t idx = 0;
+    while (xQueueReceive(ring->full_slots, &idx, portMAX_DELAY) == pdTRUE && idx != kRingEnd) {
+        // After a failure keep recycling slots so the reader never blocks.
+        if (ring->ok) {
+            const size_t n = ring->len[idx];
+            ring->ok = ring->inflater ? ring->inflater->write(ring->slot[idx], n) : firmware_flash_sink(nullptr, ring->slot[idx], n);
+        }
+        xQueueSend(ring->free_slots, &idx, portMAX_DELAY);
+    }
+    xTaskNotifyGive(ring->reader);
+    vTaskDelete(nullptr);
+}
 
-    HTTPClient http;
-    http.setTimeout(10000);
+// (Re)issue the GET for url, from byte offset when it is non-zero.
+static int firmware_http_get(HTTPClient& http, TlsClient& client, const char* url, size_t offset) {
+    http.end();
+    http.setTimeout(kDownloadStallMs);
     http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    if (!http.begin(client, url)) return HTTPC_ERROR_CONNECTION_REFUSED;
 
-    if (!http.begin(client, url)) {
-        strlcpy(firmware_update_state, "error", sizeof(firmware_update_state));
-        strlcpy(firmware_update_error, "Failed to init download", sizeof(firmware_update_error));
-        firmware_update_in_progress = false;
-        web_portal_state().ota_in_progress = false;
-        vTaskDelete(nullptr);
-        return;
+    http.addHeader("User-Agent", "esp32-template-firmware");
+    if (offset > 0) {
+        char range[32];
+        snprintf(range, sizeof(range), "bytes=%u-", (unsigned)offset);
+        http.addHeader("Range", range);
     }
+    return http.GET();
+}
 
-    http.addHeader("User-Agent", "esp32-template-firmware");
-    const int http_code = http.GET();
+// Read what has arrived, up to len bytes. Waits on the socket rather than
+// polling; 0 once the connection closed or stalled for timeout_ms.
+static size_t firmware_read_some(TlsClient& client, uint8_t* buf, size_t len, uint32_t timeout_ms) {
+    const uint32_t start = millis();
+    for (;;) {
+        const int avail = client.available();
+        if (avail > 0) {
+            const int n = client.read(buf, ((size_t)avail < len) ? (size_t)avail : len);
+            return (n > 0) ? (size_t)n : 0;
+        }
+        if (!client.connected()) return 0;
+
+        const uint32_t waited = millis() - start;
+        if (waited >= timeout_ms) return 0;
+
+        const int fd = client.fd();
+        if (fd < 0) {
+            delay(1);
+            continue;
+        }
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(fd, &readable);
+        const uint32_t slice_ms = (timeout_ms - waited < 100) ? (timeout_ms - waited) : 100;
+        struct timeval tv = {0, (long)(slice_ms * 1000)};
+        select(fd + 1, &readable, nullptr, nullptr, &tv);
+    }
+}
+
+// Download url into the inactive OTA slot and finalize it. A .bin.gz is
+// inflated on the fly; a .delta.gz is inflated and applied on top of the
+// running partition. The download is hashed as it arrives and checked
+// against expected_sha256 (hex, may be empty), and an interrupted transfer
+// continues with a Range request. On failure firmware_update_error says why
+// and *base_mismatch (optional) is set when a delta did not fit this
+// firmware; nothing has been committed in either case.
+static bool firmware_download_and_flash(const char* url, size_t expected_total, const char* expected_sha256, bool* base_mismatch) {
+    if (base_mismatch) *base_mismatch = false;
+    firmware_update_progress = 0;
+    firmware_update_bytes_per_sec = 0;
+    strlcpy(firmware_update_state, "downloading", sizeof(firmware_update_state));
+
+    TlsClient client;
+
+    HTTPClient http;
+    const int http_code = firmware_http_get(http, client, url, 0);
     if (http_code != 200) {
-        strlcpy(firmware_update_state, "error", sizeof(firmware_update_state));
         snprintf(firmware_update_error, sizeof(firmware_update_error), "Download HTTP %d", http_code);
         http.end();
-        firmware_update_in_progress = false;
-        web_portal_state().ota_in_progress = false;
-        vTaskDelete(nullptr);
-        return;
+        return false;
     }
 
     int http_len = http.getSize();
     if (http_len <= 0) {
         http_len = -1; // unknown length
     }
+    const size_t content_len = (http_len > 0) ? (size_t)http_len : 0;
     size_t total = (http_len > 0) ? (size_t)http_len : expected_total;
     firmware_update_total = total;
 
+    // The .bin.gz and .delta.gz assets are expanded on the fly; their image
+    // size is only known at the end.
+    const size_t url_len = strlen(url);
+    const bool delta = url_len > 9 && strcmp(url + url_len - 9, ".delta.gz") == 0;
+    const bool gzip = url_len > 3 && strcmp(url + url_len - 3, ".gz") == 0;
+
     const size_t freeSpace = device_telemetry_free_sketch_space();
     if (total > 0 && total > freeSpace) {
-        strlcpy(firmware_update_state, "error", sizeof(firmware_update_state));
         snprintf(firmware_update_error, sizeof(firmware_update_error), "Firmware too large (%u > %u)", (unsigned)total, (unsigned)freeSpace);
         http.end();
-        firmware_update_in_progress = false;
-        web_portal_state().ota_in_progress = false;
-        vTaskDelete(nullptr);
-        return;
+        return false;
     }
 
-    if (!Update.begin((total > 0) ? total : UPDATE_SIZE_UNKNOWN, U_FLASH)) {
-        strlcpy(firmware_update_state, "error", sizeof(firmware_update_state));
-        strlcpy(firmware_update_error, "OTA begin failed", sizeof(firmware_update_error));
+    if (!Update.begin((total > 0 && !gzip) ? total : UPDATE_SIZE_UNKNOWN, U_FLASH)) {
+        firmware_update_fail("OTA begin failed");
         http.end();
-        firmware_update_in_progress = false;
-        web_portal_state().ota_in_progress = false;
-        vTaskDelete(nullptr);
-        return;
+        return false;
     }
 
-    strlcpy(firmware_update_state, "writing", sizeof(firmware_update_state));
-
-    WiFiClient* stream = http.getStreamPtr();
-    uint8_t* buf = nullptr;
-#if SOC_SPIRAM_SUPPORTED
-    if (psramFound()) {
-        buf = (uint8_t*)heap_caps_malloc(2048, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    // Pipeline: download -> ring -> [inflate] -> [apply delta] -> Update.write
+    OtaDelta* patcher = nullptr;
+    OtaGzip* inflater = nullptr;
+    bool ready = true;
+    if (delta) {
+        patcher = new (std::nothrow) OtaDelta();
+        ready = patcher && patcher->begin(firmware_flash_sink, nullptr);
     }
-#endif
-    if (!buf) {
-        buf = (uint8_t*)heap_caps_malloc(2048, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (ready && gzip) {
+        inflater = new (std::nothrow) OtaGzip();
+        ready = inflater && (patcher ? inflater->begin(OtaDelta::sink, patcher) : inflater->begin(firmware_flash_sink, nullptr));
     }
-    if (!buf) {
-        strlcpy(firmware_update_state, "error", sizeof(firmware_update_state));
-        strlcpy(firmware_update_error, "OOM (OTA buffer alloc failed)", sizeof(firmware_update_error));
+
+    FirmwareRing ring = {};
+    ring.inflater = inflater;
+    ring.reader = xTaskGetCurrentTaskHandle();
+    ring.ok = true;
+    bool started = false;
+    if (ready && firmware_ring_alloc(&ring)) {
+        // Update.write reaches esp_partition_write; the stages keep their state on the heap.
+        started = xTaskCreate(firmware_writer_task, "fw_write", 6144, &ring, 1, nullptr) == pdPASS;
+    }
+    if (!started) {
+        firmware_update_fail(ready ? "OOM (OTA buffer alloc failed)" : "OOM (OTA decoder alloc failed)");
+        firmware_ring_free(&ring);
+        delete inflater;
+        delete patcher;
         Update.abort();
         http.end();
-        firmware_update_in_progress = false;
-        web_portal_state().ota_in_progress = false;
-        vTaskDelete(nullptr);
-        return;
+        return false;
     }
 
-    while (http.connected() && (http_len > 0 || http_len == -1)) {
-        const size_t available = stream->available();
-        if (!available) {
-            delay(1);
-            continue;
-        }
+    strlcpy(firmware_update_state, "writing", sizeof(firmware_update_state));
 
-        const size_t to_read = (available > 2048) ? 2048 : available;
-        const int read_bytes = stream->readBytes(buf, to_read);
-        if (read_bytes <= 0) {
-            break;
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+
+    const uint32_t started_ms = millis();
+    uint32_t rate_ms = started_ms;
+    size_t rate_bytes = 0;
+    size_t received = 0;
+    uint32_t resumes = 0;
+    bool ok = true;
+    bool eof = false;
+    while (ok && !eof && ring.ok) {
+        uint8_t idx = 0;
+        xQueueReceive(ring.free_slots, &idx, portMAX_DELAY);
+        uint8_t* slot = ring.slot[idx];
+        size_t fill = 0;
+
+        while (fill < kRingSlotBytes && ring.ok) {
+            if (http_len == 0) {
+                eof = true;
+                break;
+            }
+            size_t want = kRingSlotBytes - fill;
+            if (http_len > 0 && want > (size_t)http_len) want = (size_t)http_len;
+
+            const size_t n = firmware_read_some(client, slot + fill, want, kDownloadStallMs);
+            if (n > 0) {
+                mbedtls_sha256_update(&sha, slot + fill, n);
+                fill += n;
+                received += n;
+                if (http_len > 0) http_len -= (int)n;
+                continue;
+            }
+
+            // Without a length the close is the only end marker.
+            if (http_len == -1) {
+                eof = true;
+                break;
+            }
+
+            // Dropped or stalled: pick up where the stream stopped.
+            bool resumed = false;
+            while (!resumed && resumes < FIRMWARE_DL_RESUME_RETRIES) {
+                resumes++;
+                Logger.logMessagef("OTA", "Download interrupted at %u/%u bytes, resuming (%u/%u)", (unsigned)received, (unsigned)content_len, (unsigned)resumes, (unsigned)FIRMWARE_DL_RESUME_RETRIES);
+                delay(1000 * resumes);
+                const int code = firmware_http_get(http, client, url, received);
+                const int rest = http.getSize();
+                if (code == 206 && rest > 0 && received + (size_t)rest == content_len) {
+                    http_len = rest;
+                    resumed = true;
+                } else {
+                    Logger.logMessagef("OTA", "Resume refused (HTTP %d, %d bytes)", code, rest);
+                }
+            }
+            if (!resumed) {
+                snprintf(firmware_update_error, sizeof(firmware_update_error), "Download interrupted at %u of %u bytes", (unsigned)received, (unsigned)content_len);
+                ok = false;
+                break;
+            }
         }
 
-        const size_t written = Update.write(buf, (size_t)read_bytes);
-        if (written != (size_t)read_bytes) {
-            strlcpy(firmware_update_state, "error", sizeof(firmware_update_state));
-            strlcpy(firmware_update_error, "Flash write failed", sizeof(firmware_update_error));
-            Update.abort();
-            http.end();
-            free(buf);
-            firmware_update_in_progress = false;
-            web_portal_state().ota_in_progress = false;
-            vTaskDelete(nullptr);
-            return;
+        if (fill > 0) {
+            ring.len[idx] = fill;
+            xQueueSend(ring.full_slots, &idx, portMAX_DELAY);
+        } else {
+            xQueueSend(ring.free_slots, &idx, portMAX_DELAY);
         }
 
-        firmware_update_progress += written;
-        if (http_len > 0) {
-            http_len -= (int)read_bytes;
+        firmware_update_progress = received;
+        const uint32_t now = millis();
+        if (now - rate_ms >= 500) {
+            firmware_update_bytes_per_sec = (uint32_t)((uint64_t)(received - rate_bytes) * 1000 / (now - rate_ms));
+            rate_ms = now;
+            rate_bytes = received;
         }
     }
 
+    // Let the writer drain what is queued, then join it.
+    const uint8_t end_marker = kRingEnd;
+    xQueueSend(ring.full_slots, &end_marker, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    const bool written = ring.ok;
+    firmware_ring_free(&ring);
     http.end();
-    free(buf);
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    char digest_hex[65];
+    for (size_t i = 0; i < sizeof(digest); i++) {
+        snprintf(digest_hex + i * 2, 3, "%02x", digest[i]);
+    }
+
+    const uint32_t elapsed_ms = millis() - started_ms;
+    Logger.logMessagef(
+        "OTA", "Downloaded %u bytes in %u ms (%u KB/s, %u resumes), sha256 %s",
+        (unsigned)received, (unsigned)elapsed_ms, (unsigned)(elapsed_ms ? (uint64_t)received * 1000 / elapsed_ms / 1024 : 0), (unsigned)resumes, digest_hex
+    );
+    firmware_update_bytes_per_sec = elapsed_ms ? (uint32_t)((uint64_t)received * 1000 / elapsed_ms) : 0;
+
+    bool stages_ok = written;
+    if (ok && stages_ok && expected_sha256 && expected_sha256[0] && strcasecmp(digest_hex, expected_sha256) != 0) {
+        firmware_update_fail("Download SHA-256 mismatch");
+        ok = false;
+    }
+    if (ok && stages_ok && inflater) stages_ok = inflater->finish();
+    if (ok && stages_ok && patcher) stages_ok = patcher->finish();
+    if (!stages_ok) {
+        // The innermost stage knows best what went wrong.
+        const char* why = (patcher && patcher->error()) ? patcher->error() : (inflater && inflater->error()) ? inflater->error() : "Flash write failed";
+        firmware_update_fail(why);
+        if (base_mismatch && patcher) *base_mismatch = patcher->base_mismatch();
+        ok = false;
+    }
+    delete inflater;
+    delete patcher;
+
+    if (!ok) {
+        Update.abort();
+        return false;
+    }
 
     if (!Update.end(true)) {
+        firmware_update_fail("OTA finalize failed");
+        return false;
+    }
+    return true;
+}
+
+static void firmware_update_task(void* pv) {
+    (void)pv;
+
+    // Snapshot the release at task start.
+    FirmwareRelease release;
+    memcpy(&release, &firmware_update_release, sizeof(release));
+    const size_t expected_total = firmware_update_total;
+
+    firmware_update_error[0] = '\0';
+
+    // Mark OTA in progress to block other OTA/image operations.
+    web_portal_state().ota_in_progress = true;
+
+    bool ok = false;
+    if (release.delta_url[0]) {
+        bool base_mismatch = false;
+        ok = firmware_download_and_flash(release.delta_url, 0, release.delta_sha256, &base_mismatch);
+        if (!ok) {
+            // Whatever went wrong with the patch, the full image still works.
+            Logger.logMessagef("OTA", "Delta update failed (%s%s), downloading full image", firmware_update_error, base_mismatch ? ", base mismatch" : "");
+            firmware_update_error[0] = '\0';
+        }
+    }
+    if (!ok) {
+        ok = firmware_download_and_flash(release.asset_url, expected_total, release.asset_sha256, nullptr);
+    }
+
+    if (!ok) {
         strlcpy(firmware_update_state, "error", sizeof(firmware_update_state));
-        strlcpy(firmware_update_error, "OTA finalize failed", sizeof(firmware_update_error));
         firmware_update_in_progress = false;
         web_portal_state().ota_in_progress = false;
         vTaskDelete(nullptr);
@@ -361,7 +617,6 @@ static void firmware_update_task(void* pv) {
     }
 
     strlcpy(firmware_update_state, "rebooting", sizeof(firmware_update_state));
-    (void)latest_version;
 
     // Give the HTTP response/polling a moment to observe completion.
     delay(300);
@@ -375,25 +630,28 @@ static void handleGetFirmwareLatest(AsyncWebServerRequest* request) {
     request->send(404, "application/json", "{\"success\":false,\"message\":\"GitHub updates disabled\"}");
     return;
 #else
-    char latest[24];
-    char url[512];
-    size_t size = 0;
+    // AsyncTCP task only; kept off its stack.
+    static FirmwareRelease release;
     char err[192];
 
-    if (!github_fetch_latest_release(latest, sizeof(latest), url, sizeof(url), &size, err, sizeof(err))) {
+    if (!github_fetch_latest_release(&release, err, sizeof(err))) {
         char resp[256];
         snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", err[0] ? err : "Failed");
         request->send(500, "application/json", resp);
         return;
     }
 
-    const bool update_available = (compare_semver(FIRMWARE_VERSION, latest) < 0);
+    const bool update_available = (compare_semver(FIRMWARE_VERSION, release.version) < 0);
 
     StaticJsonDocument<384> doc;
     doc["success"] = true;
     doc["current_version"] = FIRMWARE_VERSION;
-    doc["latest_version"] = latest;
+    doc["latest_version"] = release.version;
     doc["update_available"] = update_available;
+    // The release has a delta patch from this exact version.
+    doc["delta_available"] = update_available && release.delta_url[0] != '\0';
+    // GitHub publishes a SHA-256 for the asset; the download is checked against it.
+    doc["sha256_available"] = release.asset_sha256[0] != '\0';
 
     AsyncResponseStream* response = request->beginResponseStream("application/json");
     serializeJson(doc, *response);
@@ -412,12 +670,11 @@ static void handlePostFirmwareUpdate(AsyncWebServerRequest* request) {
         return;
     }
 
-    char latest[24];
-    char url[512];
-    size_t size = 0;
+    // AsyncTCP task only; kept off its stack.
+    static FirmwareRelease release;
     char err[192];
 
-    if (!github_fetch_latest_release(latest, sizeof(latest), url, sizeof(url), &size, err, sizeof(err))) {
+    if (!github_fetch_latest_release(&release, err, sizeof(err))) {
         char resp[256];
         snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", err[0] ? err : "Failed");
         request->send(500, "application/json", resp);
@@ -425,7 +682,7 @@ static void handlePostFirmwareUpdate(AsyncWebServerRequest* request) {
     }
 
     // If no update is available, still allow re-install? For now, require newer.
-    if (compare_semver(FIRMWARE_VERSION, latest) >= 0) {
+    if (compare_semver(FIRMWARE_VERSION, release.version) >= 0) {
         request->send(200, "application/json", "{\"success\":true,\"message\":\"Already up to date\",\"update_started\":false}");
         return;
     }
@@ -433,9 +690,9 @@ static void handlePostFirmwareUpdate(AsyncWebServerRequest* request) {
     // Seed global state for status polling.
     firmware_update_in_progress = true;
     firmware_update_progress = 0;
-    firmware_update_total = size;
-    strlcpy(firmware_update_latest_version, latest, sizeof(firmware_update_latest_version));
-    strlcpy(firmware_update_download_url, url, sizeof(firmware_update_download_url));
+    firmware_update_total = release.asset_size;
+    firmware_update_bytes_per_sec = 0;
+    memcpy(&firmware_update_release, &release, sizeof(firmware_update_release));
     firmware_update_error[0] = '\0';
     strlcpy(firmware_update_state, "downloading", sizeof(firmware_update_state));
 
@@ -443,7 +700,7 @@ static void handlePostFirmwareUpdate(AsyncWebServerRequest* request) {
     const BaseType_t ok = xTaskCreate(
         firmware_update_task,
         "fw_update",
-        12288,
+        13312,  // TLS download plus the release snapshot
         nullptr,
         1,
         &firmware_update_task_handle
@@ -461,7 +718,7 @@ static void handlePostFirmwareUpdate(AsyncWebServerRequest* request) {
     doc["success"] = true;
     doc["update_started"] = true;
     doc["current_version"] = FIRMWARE_VERSION;
-    doc["latest_version"] = latest;
+    doc["latest_version"] = release.version;
 
     AsyncResponseStream* response = request->beginResponseStream("application/json");
     serializeJson(doc, *response);
@@ -469,6 +726,15 @@ static void handlePostFirmwareUpdate(AsyncWebServerRequest* request) {
 #endif
 }
 
+void web_portal_get_firmware_update_status(FirmwareUpdateStatus* out) {
+    out->in_progress = firmware_update_in_progress;
+    out->progress = (uint32_t)firmware_update_progress;
+    out->total = (uint32_t)firmware_update_total;
+    out->bytes_per_sec = firmware_update_bytes_per_sec;
+    strlcpy(out->state, firmware_update_state, sizeof(out->state));
+    strlcpy(out->error, firmware_update_error, sizeof(out->error));
+}
+
 static void handleGetFirmwareUpdateStatus(AsyncWebServerRequest* request) {
     if (!portal_auth_gate(request)) return;
     StaticJsonDocument<384> doc;
@@ -477,7 +743,8 @@ static void handleGetFirmwareUpdateStatus(AsyncWebServerRequest* request) {
     doc["state"] = firmware_update_state;
     doc["progress"] = (uint32_t)firmware_update_progress;
     doc["total"] = (uint32_t)firmware_update_total;
-    doc["latest_version"] = firmware_update_latest_version;
+    doc["bytes_per_sec"] = firmware_update_bytes_per_sec;
+    doc["latest_version"] = firmware_update_release.version;
     doc["error"] = firmware_update_error;
 
     AsyncResponseStream* response = request->beginResponseStream("application/json");
@@ -4,12 +4,26 @@
 
 #include "macros_config.h"
 #include "web_portal_auth.h"
+#include "web_portal_body.h"
 #include "web_portal_http.h"
+#include "web_portal_workers.h"
 
 #if HAS_DISPLAY && HAS_ICONS
 #include "icon_registry.h"
 #include "icon_store.h"
 #include <FFat.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#if ICON_STORE_ATLAS
+#include "icon_atlas.h"
+#endif
+#if ICON_PACK_ENABLED
+#include "icon_pack.h"
+#include "log_manager.h"
+#include "loop_scheduler.h"
+#include "web_portal_admission.h"
+#include "web_portal_state.h"
+#endif
 #endif
 
 #include <freertos/FreeRTOS.h>
@@ -18,22 +32,37 @@
 // The runtime macro screen UI reads from this instance (defined in app.ino).
 extern MacroConfig macro_config;
 
-// ===== Icon install body (binary) =====
-static uint8_t* g_icon_body = nullptr;
-static size_t g_icon_body_total = 0;
-static bool g_icon_body_in_progress = false;
-static portMUX_TYPE g_icon_body_mux = portMUX_INITIALIZER_UNLOCKED;
-
-static void icon_body_reset() {
-    uint8_t* toFree = nullptr;
-    portENTER_CRITICAL(&g_icon_body_mux);
-    toFree = g_icon_body;
-    g_icon_body = nullptr;
-    g_icon_body_total = 0;
-    g_icon_body_in_progress = false;
-    portEXIT_CRITICAL(&g_icon_body_mux);
-    if (toFree) free(toFree);
+// Max body accepted by POST /api/icons/install_batch.
+#ifndef ICON_STORE_BATCH_MAX_BYTES
+    #if SOC_SPIRAM_SUPPORTED
+        #define ICON_STORE_BATCH_MAX_BYTES (512 * 1024)
+    #else
+        #define ICON_STORE_BATCH_MAX_BYTES (96 * 1024)
+    #endif
+#endif
+
+#if HAS_DISPLAY && HAS_ICONS
+// Chunk-safe body accumulation shared by the install routes (web_portal_body).
+// Returns the whole body once its last chunk is in; on error the response is sent.
+// One install runs at a time: the icon store is not written concurrently.
+static const uint8_t* icon_body_collect(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total, size_t max_total) {
+    if (index == 0 && portal_body_owner_active("icons")) {
+        request->send(409, "application/json", "{\"success\":false,\"message\":\"Another icon install is in progress\"}");
+        return nullptr;
+    }
+    return portal_body_collect(request, "icons", data, len, index, total, max_total);
+}
+
+// Validate and write one icon blob (worker job); arg is the NUL-terminated id.
+static void icon_install_apply(const uint8_t* body, size_t len, const void* arg, PortalWorkReply* reply) {
+    char err[128];
+    if (!icon_store_install_blob((const char*)arg, body, len, err, sizeof(err))) {
+        portal_work_reply_error(reply, 400, err);
+        return;
+    }
+    portal_work_reply(reply, 200, "{\"success\":true}");
 }
+#endif
 
 // GET /api/icons
 // Returns the compiled icon IDs so the portal can offer an autocomplete list.
@@ -146,10 +175,11 @@ static void handleGetInstalledIcons(AsyncWebServerRequest* request) {
         size_t cur_len = 0;
         size_t cur_off = 0;
 
-        enum class Phase : uint8_t { Header, Items, Footer, Done } phase = Phase::Header;
+        enum class Phase : uint8_t { Header, Atlas, Items, Footer, Done } phase = Phase::Header;
 
         bool first = true;
         bool ffat_ok = false;
+        size_t atlas_pos = 0;
         File dir;
         File f;
 
@@ -158,6 +188,7 @@ static void handleGetInstalledIcons(AsyncWebServerRequest* request) {
         InstalledIconsChunker() {
             scratch.reserve(256);
 
+            // With the atlas, /icons only holds icons installed before it.
             ffat_ok = icon_store_ffat_ready() && FFat.exists("/icons");
             if (ffat_ok) {
                 dir = FFat.open("/icons");
@@ -181,9 +212,30 @@ static void handleGetInstalledIcons(AsyncWebServerRequest* request) {
             switch (phase) {
                 case Phase::Header:
                     set_piece("{\"success\":true,\"source\":\"ffat\",\"icons\":[", strlen("{\"success\":true,\"source\":\"ffat\",\"icons\":["));
-                    phase = Phase::Items;
+                    phase = Phase::Atlas;
                     return true;
 
+                case Phase::Atlas: {
+#if ICON_STORE_ATLAS
+                    char id[MACROS_ICON_ID_MAX_LEN];
+                    if (icon_store_ffat_ready() && icon_atlas_id_at(atlas_pos, id, sizeof(id))) {
+                        atlas_pos++;
+                        if (!first) scratch += ",";
+                        first = false;
+
+                        // Atlas ids are validated as [a-z0-9_]+ on install, so no escaping needed.
+                        scratch += "{\"id\":\"";
+                        scratch += id;
+                        scratch += "\",\"kind\":\"color\"}";
+
+                        set_piece(scratch.c_str(), scratch.length());
+                        return true;
+                    }
+#endif
+                    phase = Phase::Items;
+                    return next_piece();
+                }
+
                 case Phase::Items: {
                     if (!ffat_ok) {
                         phase = Phase::Footer;
@@ -288,78 +340,101 @@ static void handlePostIconInstall(AsyncWebServerRequest* request, uint8_t* data,
         return;
     }
 
-    // Chunk-safe body accumulation.
-    if (index == 0) {
-        bool alreadyInProgress = false;
-        uint8_t* staleBody = nullptr;
-        portENTER_CRITICAL(&g_icon_body_mux);
-        alreadyInProgress = g_icon_body_in_progress;
-        if (!alreadyInProgress) {
-            staleBody = g_icon_body;
-            g_icon_body = nullptr;
-            g_icon_body_total = total;
-            g_icon_body_in_progress = true;
-        }
-        portEXIT_CRITICAL(&g_icon_body_mux);
+    // Ids that do not fit a job cannot be referenced by a button either.
+    if (idParam.length() >= kPortalWorkArgBytes) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid icon id (expected [a-z0-9_]+)\"}");
+        return;
+    }
 
-        if (staleBody) free(staleBody);
+    const uint8_t* body = icon_body_collect(request, data, len, index, total, 256 * 1024);
+    if (!body) return;
 
-        if (alreadyInProgress) {
-            request->send(409, "application/json", "{\"success\":false,\"message\":\"Another icon install is in progress\"}");
-            return;
-        }
-
-        if (total == 0 || total > (256 * 1024)) {
-            icon_body_reset();
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid body size\"}");
-            return;
-        }
+    portal_worker_run(request, PortalWorkRoute::Icons, icon_install_apply, body, total, idParam.c_str(), idParam.length() + 1);
+#endif
+}
 
-        g_icon_body = (uint8_t*)malloc(total);
-        if (!g_icon_body) {
-            icon_body_reset();
-            request->send(500, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
-            return;
-        }
+// POST /api/icons/install_batch
+// Body: records of u8 id_len, id, u32 blob_len (LE), blob (see icon_store_install_batch).
+// Response: {"success":bool,"installed":N,"failed":M,"results":[{"index":i,"id":"...","ok":bool,"message":"..."}]}
+#if HAS_DISPLAY && HAS_ICONS
+struct IconBatchResponse {
+    AsyncResponseStream* response;
+    size_t failed;
+    bool first;
+};
+
+static void icon_batch_result(size_t index, const char* id, bool ok, const char* message, void* ctx) {
+    IconBatchResponse* out = (IconBatchResponse*)ctx;
+    if (!ok) out->failed++;
+
+    AsyncResponseStream* response = out->response;
+    response->print(out->first ? "{\"index\":" : ",{\"index\":");
+    out->first = false;
+    response->print((unsigned)index);
+    response->print(",\"id\":");
+    if (id) {
+        // Only [a-z0-9_]+ ids are passed through; no escaping needed.
+        response->print("\"");
+        response->print(id);
+        response->print("\"");
+    } else {
+        response->print("null");
     }
-
-    if (!g_icon_body_in_progress || !g_icon_body || g_icon_body_total != total) {
-        icon_body_reset();
-        request->send(500, "application/json", "{\"success\":false,\"message\":\"Internal state error\"}");
-        return;
+    response->print(ok ? ",\"ok\":true" : ",\"ok\":false,\"message\":\"");
+    if (!ok) {
+        response->print(message);
+        response->print("\"");
     }
+    response->print("}");
+}
+#endif
 
-    if (index + len > total) {
-        icon_body_reset();
-        request->send(400, "application/json", "{\"success\":false,\"message\":\"Body overflow\"}");
-        return;
-    }
+static void handlePostIconInstallBatch(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
 
-    memcpy(g_icon_body + index, data, len);
+#if !(HAS_DISPLAY && HAS_ICONS)
+    (void)data;
+    (void)len;
+    (void)index;
+    (void)total;
+    request->send(400, "application/json", "{\"success\":false,\"message\":\"Icons not supported on this target\"}");
+    return;
+#else
+
+    const uint8_t* body = icon_body_collect(request, data, len, index, total, ICON_STORE_BATCH_MAX_BYTES);
+    if (!body) return;
 
-    // Not done yet.
-    if (index + len != total) return;
+    IconBatchResponse out;
+    out.response = request->beginResponseStream("application/json");
+    out.failed = 0;
+    out.first = true;
+    out.response->print("{\"results\":[");
 
+    size_t installed = 0;
     char err[128];
-    const bool ok = icon_store_install_blob(idParam.c_str(), g_icon_body, g_icon_body_total, err, sizeof(err));
-    icon_body_reset();
+    const bool ok = icon_store_install_batch(body, total, icon_batch_result, &out, &installed, err, sizeof(err));
+    portal_body_release(request);
 
+    out.response->print("],\"installed\":");
+    out.response->print((unsigned)installed);
+    out.response->print(",\"failed\":");
+    out.response->print((unsigned)out.failed);
     if (!ok) {
-        AsyncResponseStream* response = request->beginResponseStream("application/json");
-        response->setCode(400);
-        response->print("{\"success\":false,\"message\":\"");
-        response->print(err);
-        response->print("\"}");
-        request->send(response);
-        return;
+        out.response->setCode(400);
+        out.response->print(",\"success\":false,\"message\":\"");
+        out.response->print(err);
+        out.response->print("\"}");
+    } else {
+        out.response->setCode(200);
+        out.response->print(out.failed ? ",\"success\":false}" : ",\"success\":true}");
     }
-
-    request->send(200, "application/json", "{\"success\":true}");
+    request->send(out.response);
 #endif
 }
 
 // POST /api/icons/gc
-// Deletes unused installed icons (emoji_*, user_*) based on the current (already-saved) macro config.
+// Starts deleting unused installed icons (emoji_*, user_*) based on the current (already-saved)
+// macro config, in the background. Poll GET /api/icons/gc for the result.
 static void handlePostIconGC(AsyncWebServerRequest* request) {
     if (!portal_auth_gate(request)) return;
 
@@ -368,13 +443,12 @@ static void handlePostIconGC(AsyncWebServerRequest* request) {
     return;
 #else
 
-    size_t deleted = 0;
-    size_t bytes = 0;
     char err[128];
-    const bool ok = icon_store_gc_unused_from_macros(&macro_config, &deleted, &bytes, err, sizeof(err));
-    if (!ok) {
+    // Icons used only by screens still loading must not look unused.
+    macros_config_ensure_loaded();
+    if (!icon_store_gc_start(&macro_config, err, sizeof(err))) {
         AsyncResponseStream* response = request->beginResponseStream("application/json");
-        response->setCode(400);
+        response->setCode(409);
         response->print("{\"success\":false,\"message\":\"");
         response->print(err);
         response->print("\"}");
@@ -382,21 +456,274 @@ static void handlePostIconGC(AsyncWebServerRequest* request) {
         return;
     }
 
+    request->send(202, "application/json", "{\"success\":true,\"state\":\"running\"}");
+#endif
+}
+
+#if HAS_DISPLAY && HAS_ICONS
+static const char* icon_gc_state_name(IconStoreGcState state) {
+    switch (state) {
+        case IconStoreGcState::Running: return "running";
+        case IconStoreGcState::Done: return "done";
+        case IconStoreGcState::Cancelled: return "cancelled";
+        case IconStoreGcState::Failed: return "failed";
+        default: return "idle";
+    }
+}
+#endif
+
+static void send_icon_gc_status(AsyncWebServerRequest* request) {
+#if !(HAS_DISPLAY && HAS_ICONS)
+    request->send(400, "application/json", "{\"success\":false,\"message\":\"Icons not supported on this target\"}");
+    return;
+#else
+    IconStoreGcStatus st;
+    icon_store_gc_get_status(&st);
+
     AsyncResponseStream* response = request->beginResponseStream("application/json");
     response->setCode(200);
-    response->print("{\"success\":true,\"deleted\":");
-    response->print((unsigned)deleted);
+    response->print(st.state == IconStoreGcState::Failed ? "{\"success\":false,\"state\":\"" : "{\"success\":true,\"state\":\"");
+    response->print(icon_gc_state_name(st.state));
+    response->print("\",\"cancel_requested\":");
+    response->print(st.cancel_requested ? "true" : "false");
+    response->print(",\"scanned\":");
+    response->print((unsigned)st.scanned);
+    response->print(",\"deleted\":");
+    response->print((unsigned)st.deleted);
     response->print(",\"bytes_freed\":");
-    response->print((unsigned)bytes);
+    response->print((unsigned)st.bytes_freed);
+    response->print(",\"elapsed_ms\":");
+    response->print((unsigned)st.elapsed_ms);
+    if (st.message[0]) {
+        response->print(",\"message\":\"");
+        response->print(st.message);
+        response->print("\"");
+    }
+    response->print("}");
+    request->send(response);
+#endif
+}
+
+// GET /api/icons/gc
+// Status of the current or last GC run.
+static void handleGetIconGC(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+    send_icon_gc_status(request);
+}
+
+// DELETE /api/icons/gc
+// Cancels a running GC; it stops at its next batch boundary.
+static void handleDeleteIconGC(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+#if HAS_DISPLAY && HAS_ICONS
+    icon_store_gc_cancel();
+#endif
+    send_icon_gc_status(request);
+}
+
+// GET /api/icons/bench?rounds=N
+// Times compiled-registry lookups (hash table) against the old linear strcmp scan.
+static void handleGetIconBench(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+#if !(HAS_DISPLAY && HAS_ICONS)
+    request->send(400, "application/json", "{\"success\":false,\"message\":\"Icons not supported on this target\"}");
+    return;
+#else
+    // Runs on the AsyncTCP task; keep the linear baseline well under its watchdog.
+    int rounds = 10;
+    if (request->hasParam("rounds")) {
+        rounds = request->getParam("rounds")->value().toInt();
+    }
+    if (rounds < 1) rounds = 1;
+    if (rounds > 50) rounds = 50;
+
+    const size_t n = icon_registry_count();
+    static const char* const kMiss = "no_such_icon";
+    volatile uint32_t sink = 0;
+    IconRef ref;
+
+    int64_t t0 = esp_timer_get_time();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < n; i++) {
+            sink += icon_registry_lookup(icon_registry_id_at(i), &ref) ? 1 : 0;
+        }
+        sink += icon_registry_lookup(kMiss, &ref) ? 1 : 0;
+    }
+    const int64_t hashed_us = esp_timer_get_time() - t0;
+
+    t0 = esp_timer_get_time();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i <= n; i++) {
+            const char* id = (i < n) ? icon_registry_id_at(i) : kMiss;
+            for (size_t j = 0; j < n; j++) {
+                if (strcmp(id, icon_registry_id_at(j)) == 0) {
+                    sink += 1;
+                    break;
+                }
+            }
+        }
+    }
+    const int64_t linear_us = esp_timer_get_time() - t0;
+    (void)sink;
+
+    const uint32_t lookups = (uint32_t)rounds * (uint32_t)(n + 1);
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->setCode(200);
+    response->print("{\"success\":true,\"icons\":");
+    response->print((unsigned)n);
+    response->print(",\"lookups\":");
+    response->print((unsigned)lookups);
+    response->print(",\"hash_ns_avg\":");
+    response->print((unsigned)((hashed_us * 1000) / lookups));
+    response->print(",\"linear_ns_avg\":");
+    response->print((unsigned)((linear_us * 1000) / lookups));
     response->print("}");
     request->send(response);
 #endif
 }
 
+// GET /api/icons/pack
+// {"present":bool,"mapped":bool,"entries":N,"pack_bytes":N,"capacity_bytes":N,"hits":N}
+static void handleGetIconPack(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+#if !(HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED)
+    request->send(200, "application/json", "{\"present\":false,\"mapped\":false}");
+#else
+    IconPackStats st;
+    icon_pack_get_stats(&st);
+
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->setCode(200);
+    response->print(st.partition_present ? "{\"present\":true" : "{\"present\":false");
+    response->print(st.mapped ? ",\"mapped\":true" : ",\"mapped\":false");
+    response->print(",\"entries\":");
+    response->print((unsigned)st.entries);
+    response->print(",\"pack_bytes\":");
+    response->print((unsigned)st.pack_bytes);
+    response->print(",\"capacity_bytes\":");
+    response->print((unsigned)st.capacity_bytes);
+    response->print(",\"hits\":");
+    response->print((unsigned)st.hits);
+    response->print("}");
+    request->send(response);
+#endif
+}
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED
+static void send_icon_pack_error(AsyncWebServerRequest* request, int code, const char* err) {
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->setCode(code);
+    response->print("{\"success\":false,\"message\":\"");
+    response->print(err);
+    response->print("\"}");
+    request->send(response);
+}
+
+// The old pack's flash is gone once writing starts; only a reboot brings
+// the icons back (the new pack, or none).
+static void icon_pack_failed(AsyncWebServerRequest* request, const char* err) {
+    Logger.logEnd(err);
+    send_icon_pack_error(request, 500, err);
+    delay(500);
+    ESP.restart();
+}
+#endif
+
+// POST /api/icons/pack
+// Body: a whole icon pack (icon_pack.h), written straight to the icons partition.
+// The device reboots afterwards, also when the upload fails.
+static void handlePostIconPack(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
+
+#if !(HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED)
+    (void)data;
+    (void)len;
+    (void)index;
+    (void)total;
+    request->send(400, "application/json", "{\"success\":false,\"message\":\"Icon pack not supported on this target\"}");
+    return;
+#else
+    char err[96];
+    if (index == 0) {
+        if (web_portal_state().ota_in_progress) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"An update is in progress\"}");
+            return;
+        }
+        if (!icon_pack_write_begin(total, err, sizeof(err))) {
+            send_icon_pack_error(request, 400, err);
+            return;
+        }
+        Logger.logBegin("Icon Pack");
+        Logger.logLinef("Size: %u bytes", (unsigned)total);
+
+        // OTA quiet mode shows its progress screen, so no screen keeps drawing
+        // icons from sectors being erased.
+        web_portal_state().ota_in_progress = true;
+        web_portal_state().ota_progress = 0;
+        web_portal_state().ota_total = total;
+        loop_scheduler_notify();
+
+        // A client that drops mid-upload never reaches the last chunk.
+        if (!portal_on_request_end(request, []() {
+                if (!icon_pack_write_active()) return;
+                Logger.logEnd("Upload abandoned - rebooting");
+                ESP.restart();
+            })) {
+            icon_pack_failed(request, "Device busy");
+            return;
+        }
+    }
+
+    // Refused at the first chunk: the reply has been sent.
+    if (!icon_pack_write_active()) return;
+
+    if (len && !icon_pack_write(data, len, err, sizeof(err))) {
+        icon_pack_failed(request, err);
+        return;
+    }
+    web_portal_state().ota_progress += len;
+
+    if (index + len == total) {
+        if (!icon_pack_write_end(err, sizeof(err))) {
+            icon_pack_failed(request, err);
+            return;
+        }
+        Logger.logEnd("Success - rebooting");
+        request->send(200, "application/json", "{\"success\":true,\"message\":\"Icon pack written. Rebooting...\"}");
+        delay(500);
+        ESP.restart();
+    }
+#endif
+}
+
 void web_portal_register_api_icons_routes(AsyncWebServer& server) {
     // NOTE: register more specific routes first; some AsyncWebServer URI matchers behave like prefix matches.
     server.on("/api/icons/installed", HTTP_GET, handleGetInstalledIcons);
     server.on("/api/icons/gc", HTTP_POST, handlePostIconGC);
+    server.on("/api/icons/gc", HTTP_GET, handleGetIconGC);
+    server.on("/api/icons/gc", HTTP_DELETE, handleDeleteIconGC);
+    server.on("/api/icons/bench", HTTP_GET, handleGetIconBench);
+    server.on("/api/icons/pack", HTTP_GET, handleGetIconPack);
+    server.on(
+        "/api/icons/pack",
+        HTTP_POST,
+        [](AsyncWebServerRequest* request) {
+            if (!portal_auth_gate(request)) return;
+        },
+        NULL,
+        handlePostIconPack
+    );
+    server.on(
+        "/api/icons/install_batch",
+        HTTP_POST,
+        [](AsyncWebServerRequest* request) {
+            if (!portal_auth_gate(request)) return;
+        },
+        NULL,
+        handlePostIconInstallBatch
+    );
     server.on(
         "/api/icons/install",
         HTTP_POST,
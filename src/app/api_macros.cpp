@@ -4,92 +4,110 @@
 #include <ESPAsyncWebServer.h>
 
 #include "device_telemetry.h"
+#include "ducky_script.h"
 #include "log_manager.h"
 #include "macros_config.h"
+#include "macros_json_stream.h"
 #include "macro_templates.h"
+#include "mqtt_macros_sync.h"
 #include "web_portal_auth.h"
+#include "web_portal_body.h"
 #include "web_portal_http.h"
 #include "web_portal_json_alloc.h"
+#include "web_portal_workers.h"
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
-#include <esp_heap_caps.h>
-#include <soc/soc_caps.h>
+#include <new>
 
 // The runtime macro screen UI reads from this instance (defined in app.ino).
 extern MacroConfig macro_config;
 
 // ===== Macros Config (screens × buttons) =====
-static bool g_macros_loaded = false;
-
-static uint8_t* g_macros_body = nullptr;
-static size_t g_macros_body_total = 0;
-static bool g_macros_body_in_progress = false;
-
-// MVP: macros editor posts the full screens × buttons config. Keep the parsing document bounded.
-// If MACROS_* dimensions or max string sizes are increased, adjust this accordingly.
-static constexpr size_t kMacrosJsonDocCapacity = 65536;
+// app.ino loads macro_config during setup; handlers that read or replace all
+// of it first wait for screens still arriving from the boot load
+// (macros_config_ensure_loaded).
+
+// One macros update (POST or PATCH) is received at a time. Its buffers belong to
+// g_macros_update_owner and are freed when it completes, fails or disconnects.
+// The PATCH body and the POST staging config are body leases (web_portal_body).
+// Once received, the update is applied and saved by a PortalWorkRoute::Macros
+// job (web_portal_workers.h), in order with the ones before it.
+static AsyncWebServerRequest* g_macros_update_owner = nullptr;
+static bool g_macros_update_failed = false;      // error sent; ignore the rest of the body
+static MacroConfig* g_macros_stage = nullptr;    // POST: parsed into as chunks arrive
+static MacrosJsonStream* g_macros_stream = nullptr;
+
+// PATCH bodies carry one button or one screen's settings.
+static constexpr size_t kMacrosPatchMaxBody = 2048;
+static constexpr size_t kMacrosPatchJsonDocCapacity = 3072;
 
 // Protect macros upload globals from theoretical cross-task interleaving.
 static portMUX_TYPE g_macros_body_mux = portMUX_INITIALIZER_UNLOCKED;
 
-static void macros_body_reset() {
-    uint8_t* toFree = nullptr;
+// Free the update's buffers; with release, also let the next update start.
+static void macros_update_end(AsyncWebServerRequest* request, bool release = true) {
+    bool owned = false;
+    MacrosJsonStream* stream = nullptr;
     portENTER_CRITICAL(&g_macros_body_mux);
-    toFree = g_macros_body;
-    g_macros_body = nullptr;
-    g_macros_body_total = 0;
-    g_macros_body_in_progress = false;
+    if (g_macros_update_owner == request) {
+        owned = true;
+        stream = g_macros_stream;
+        g_macros_stage = nullptr;
+        g_macros_stream = nullptr;
+        if (release) {
+            g_macros_update_owner = nullptr;
+            g_macros_update_failed = false;
+        } else {
+            g_macros_update_failed = true;
+        }
+    }
     portEXIT_CRITICAL(&g_macros_body_mux);
 
-    if (toFree) {
-        free(toFree);
-    }
+    if (owned) portal_body_release(request);
+    delete stream;
 }
 
-static const char* macro_action_to_string(MacroButtonAction a) {
-    switch (a) {
-        case MacroButtonAction::None: return "none";
-        case MacroButtonAction::SendKeys: return "send_keys";
-        case MacroButtonAction::NavPrevScreen: return "nav_prev";
-        case MacroButtonAction::NavNextScreen: return "nav_next";
-        case MacroButtonAction::NavToScreen: return "nav_to";
-        case MacroButtonAction::GoBack: return "go_back";
-        case MacroButtonAction::MqttSend: return "mqtt_send";
-        default: return "none";
+// Claim the update slot for request (409 if another one is running).
+static bool macros_update_begin(AsyncWebServerRequest* request) {
+    bool busy = false;
+    portENTER_CRITICAL(&g_macros_body_mux);
+    busy = g_macros_update_owner != nullptr && g_macros_update_owner != request;
+    if (!busy) {
+        g_macros_update_owner = request;
+        g_macros_update_failed = false;
     }
-}
+    portEXIT_CRITICAL(&g_macros_body_mux);
 
-static const char* macro_icon_type_to_string(MacroIconType t) {
-    switch (t) {
-        case MacroIconType::None: return "none";
-        case MacroIconType::Builtin: return "builtin";
-        case MacroIconType::Emoji: return "emoji";
-        case MacroIconType::Asset: return "asset";
-        default: return "none";
+    if (busy) {
+        request->send(409, "application/json", "{\"success\":false,\"message\":\"Another macros update is in progress\"}");
+        return false;
     }
-}
 
-static MacroIconType macro_icon_type_from_string(const char* s) {
-    if (!s || !*s) return MacroIconType::None;
-    if (strcasecmp(s, "none") == 0) return MacroIconType::None;
-    if (strcasecmp(s, "builtin") == 0) return MacroIconType::Builtin;
-    if (strcasecmp(s, "emoji") == 0) return MacroIconType::Emoji;
-    if (strcasecmp(s, "asset") == 0) return MacroIconType::Asset;
-    return MacroIconType::None;
+    // An aborted upload never reaches its last chunk.
+    if (!portal_on_request_end(request, [request]() { macros_update_end(request); })) {
+        macros_update_end(request);
+        request->send(503, "application/json", "{\"success\":false,\"message\":\"Device busy, retry later\"}");
+        return false;
+    }
+    return true;
 }
 
-static MacroButtonAction macro_action_from_string(const char* s) {
-    if (!s || !*s) return MacroButtonAction::None;
-    if (strcasecmp(s, "none") == 0) return MacroButtonAction::None;
-    if (strcasecmp(s, "send_keys") == 0) return MacroButtonAction::SendKeys;
-    if (strcasecmp(s, "nav_prev") == 0) return MacroButtonAction::NavPrevScreen;
-    if (strcasecmp(s, "nav_next") == 0) return MacroButtonAction::NavNextScreen;
-    if (strcasecmp(s, "nav_to") == 0) return MacroButtonAction::NavToScreen;
-    if (strcasecmp(s, "go_back") == 0) return MacroButtonAction::GoBack;
-    if (strcasecmp(s, "mqtt_send") == 0) return MacroButtonAction::MqttSend;
-    return MacroButtonAction::None;
+// True when request owns the update slot and should keep processing its
+// body. A request that was refused at its first chunk (409/413) never owns
+// it, and has been answered already. After an error only the last chunk
+// matters: it releases the slot.
+static bool macros_update_continue(AsyncWebServerRequest* request, bool is_final) {
+    bool owned = false;
+    bool failed = false;
+    portENTER_CRITICAL(&g_macros_body_mux);
+    owned = g_macros_update_owner == request;
+    failed = g_macros_update_failed;
+    portEXIT_CRITICAL(&g_macros_body_mux);
+
+    if (owned && failed && is_final) macros_update_end(request);
+    return owned && !failed;
 }
 
 static uint32_t clamp_rgb24(uint32_t v) {
@@ -97,23 +115,15 @@ static uint32_t clamp_rgb24(uint32_t v) {
     return v & 0x00FFFFFFu;
 }
 
-static void macros_cache_load_if_needed() {
-    if (g_macros_loaded) return;
-    g_macros_loaded = true;
-    if (!macros_config_load(&macro_config)) {
-        macros_config_set_defaults(&macro_config);
-    }
-}
-
-void web_portal_macros_preload() {
-    macros_cache_load_if_needed();
-}
-
 // GET /api/macros
 static void handleGetMacros(AsyncWebServerRequest* request) {
     if (!portal_auth_gate(request)) return;
 
-    macros_cache_load_if_needed();
+    macros_config_ensure_loaded();
+
+    char etag[48];
+    portal_format_etag(etag, sizeof(etag), "macros", macros_config_generation());
+    if (portal_send_not_modified(request, etag)) return;
 
     // Stream the response in chunks to avoid building the full JSON in RAM.
     // This reduces transient allocations and keeps TTFB low.
@@ -168,7 +178,7 @@ static void handleGetMacros(AsyncWebServerRequest* request) {
 
             switch (phase) {
                 case Phase::Header: {
-                    // Keep this in sync with src/app/macros_config.cpp (MACROS_VERSION).
+                    // JSON schema version; independent of the stored format (MACROS_VERSION in macros_config.cpp).
                     char hdr[256];
                     snprintf(
                         hdr,
@@ -256,12 +266,12 @@ static void handleGetMacros(AsyncWebServerRequest* request) {
                     // Use ArduinoJson to correctly escape strings.
                     StaticJsonDocument<768> item;
                     item["label"] = btn->label;
-                    item["action"] = macro_action_to_string(btn->action);
+                    item["action"] = macros_action_to_string(btn->action);
                     item["payload"] = btn->payload;
                     item["mqtt_topic"] = btn->mqtt_topic;
 
                     JsonObject icon = item.createNestedObject("icon");
-                    icon["type"] = macro_icon_type_to_string(btn->icon.type);
+                    icon["type"] = macros_icon_type_to_string(btn->icon.type);
                     icon["id"] = btn->icon.id;
                     icon["display"] = btn->icon.display;
 
@@ -327,275 +337,351 @@ static void handleGetMacros(AsyncWebServerRequest* request) {
         return;
     }
 
-    send_chunked_state(request, "application/json", st);
+    send_chunked_state(request, "application/json", st, etag);
 }
 
-// POST /api/macros
-// Accepts a single JSON payload containing all screens × buttons.
-static void handlePostMacros(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
-    if (!portal_auth_gate(request)) return;
+static void send_macros_error(AsyncWebServerRequest* request, int code, const char* message) {
+    PortalWorkReply reply;
+    portal_work_reply_error(&reply, code, message);
+    request->send(reply.code, "application/json", reply.body);
+}
+
+// Send an error for the running update and drop its buffers. The rest of the
+// body is ignored; the last chunk (or the disconnect) releases the slot.
+static void macros_update_fail(AsyncWebServerRequest* request, bool is_final, int code, const char* message) {
+    send_macros_error(request, code, message);
+    macros_update_end(request, is_final);
+}
+
+static uint32_t macro_color_from_json(JsonVariant v) {
+    return v.isNull() ? MACROS_COLOR_UNSET : clamp_rgb24(v | 0);
+}
+
+// Apply the keys present in bo to btn; missing keys keep their current value
+// (so a fresh button from macros_config_set_defaults() gets the full-POST semantics).
+// "icon" replaces the whole icon; null colors clear the override.
+// Returns nullptr, or an error message (btn may be partially updated).
+static const char* macro_button_apply_json(JsonObject bo, MacroButtonConfig* btn) {
+    if (bo.isNull()) return "buttons[] entries must be objects";
+
+    if (bo.containsKey("label")) strlcpy(btn->label, bo["label"] | "", sizeof(btn->label));
+    if (bo.containsKey("action")) btn->action = macros_action_from_string(bo["action"] | "none");
+    if (bo.containsKey("payload")) strlcpy(btn->payload, bo["payload"] | "", sizeof(btn->payload));
+    if (bo.containsKey("mqtt_topic")) strlcpy(btn->mqtt_topic, bo["mqtt_topic"] | "", sizeof(btn->mqtt_topic));
+
+    if (bo.containsKey("icon")) {
+        JsonObject io = bo["icon"].as<JsonObject>();
+        btn->icon.type = macros_icon_type_from_string(io["type"] | "none");
+        strlcpy(btn->icon.id, io["id"] | "", sizeof(btn->icon.id));
+        strlcpy(btn->icon.display, io["display"] | "", sizeof(btn->icon.display));
+    }
 
-    // Chunk-safe body accumulation (AsyncWebServer may call us multiple times).
+    // Optional per-button appearance overrides.
+    if (bo.containsKey("button_bg")) btn->button_bg = macro_color_from_json(bo["button_bg"]);
+    if (bo.containsKey("icon_color")) btn->icon_color = macro_color_from_json(bo["icon_color"]);
+    if (bo.containsKey("label_color")) btn->label_color = macro_color_from_json(bo["label_color"]);
+
+    return macros_button_normalize(btn);
+}
+
+// Compile-check a SendKeys payload so script errors come back with the save
+// rather than on the first press.
+static bool macros_check_script(const MacroButtonConfig* btn, int s, int b, char* err, size_t err_len) {
+    if (btn->action != MacroButtonAction::SendKeys) return true;
+    char script_err[80];
+    if (ducky_compile(btn->payload, nullptr, 0, nullptr, script_err, sizeof(script_err))) return true;
+    snprintf(err, err_len, "screens[%d].buttons[%d].payload %s", s, b, script_err);
+    return false;
+}
+
+// Chunk-safe body accumulation into a body lease (AsyncWebServer may call us multiple times).
+// Returns the whole body once it is buffered; on errors a response has been sent.
+static const uint8_t* macros_body_collect(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total, size_t max_total) {
+    const bool is_final = index + len >= total;
     if (index == 0) {
-        bool alreadyInProgress = false;
-        uint8_t* staleBody = nullptr;
-        portENTER_CRITICAL(&g_macros_body_mux);
-        alreadyInProgress = g_macros_body_in_progress;
-        if (!alreadyInProgress) {
-            // Clear any stale buffer from a previous attempt.
-            staleBody = g_macros_body;
-            g_macros_body = nullptr;
-            g_macros_body_total = total;
-            g_macros_body_in_progress = true;
+        if (total > max_total) {
+            request->send(413, "application/json", "{\"success\":false,\"message\":\"JSON body too large\"}");
+            return nullptr;
         }
-        portEXIT_CRITICAL(&g_macros_body_mux);
+        if (!macros_update_begin(request)) return nullptr;
 
-        if (staleBody) {
-            free(staleBody);
-        }
+        // One chunk: parse it in place.
+        if (is_final) return data;
 
-        if (alreadyInProgress) {
-            request->send(409, "application/json", "{\"success\":false,\"message\":\"Another macros update is in progress\"}");
-            return;
+        if (!portal_body_lease(request, "macros", total)) {
+            macros_update_fail(request, is_final, 503, "Device busy, retry later");
+            return nullptr;
         }
+    }
 
-#if SOC_SPIRAM_SUPPORTED
-        if (psramFound()) {
-            g_macros_body = (uint8_t*)heap_caps_malloc(total, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        }
-#endif
-        if (!g_macros_body) {
-            g_macros_body = (uint8_t*)malloc(total);
-        }
-        if (!g_macros_body) {
-            macros_body_reset();
-            request->send(500, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
-            return;
+    if (!macros_update_continue(request, is_final)) return nullptr;
+
+    size_t size = 0;
+    uint8_t* body = portal_body_leased(request, &size);
+    if (!body || size != total || index + len > total) {
+        macros_update_fail(request, is_final, 400, "Invalid upload");
+        return nullptr;
+    }
+
+    memcpy(body + index, data, len);
+    return is_final ? body : nullptr;
+}
+
+// Validate, save and apply a parsed POST /api/macros (worker job). body is
+// the staging MacroConfig.
+static void macros_post_apply(const uint8_t* body, size_t len, const void* arg, PortalWorkReply* reply) {
+    (void)len;
+    (void)arg;
+    MacroConfig* next = (MacroConfig*)body;
+
+    // Unknown templates fall back to the firmware default.
+    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        if (!macro_templates::is_valid(next->template_id[s])) {
+            strlcpy(next->template_id[s], macro_templates::default_id(), sizeof(next->template_id[s]));
         }
     }
 
-    if (!g_macros_body_in_progress || !g_macros_body || g_macros_body_total != total) {
-        macros_body_reset();
-        request->send(500, "application/json", "{\"success\":false,\"message\":\"Internal state error\"}");
-        return;
+    char script_err[128];
+    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+            if (macros_check_script(&next->buttons[s][b], s, b, script_err, sizeof(script_err))) continue;
+            portal_work_reply_error(reply, 400, script_err);
+            return;
+        }
     }
 
-    if (index + len > total) {
-        macros_body_reset();
-        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid upload\"}");
+    if (!macros_config_save(next)) {
+#if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
+        device_telemetry_log_memory_snapshot("http_macros_post_save_fail");
+#endif
+        portal_work_reply_error(reply, 500, "Failed to save");
         return;
     }
 
-    memcpy(g_macros_body + index, data, len);
+#if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
+    device_telemetry_log_memory_snapshot("http_macros_post_saved");
+#endif
 
-    const bool is_final = (index + len == total);
-    if (!is_final) {
-        return;
-    }
+    // Apply immediately to the runtime macro UI; only the screens/buttons that
+    // differ get redrawn.
+    macros_config_mark_diff(&macro_config, next);
+    memcpy(&macro_config, next, sizeof(MacroConfig));
+    ducky_programs_rebuild(&macro_config);
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
-    // Capture heap state right before we allocate/parse the JSON document.
-    device_telemetry_log_memory_snapshot("http_macros_post_begin");
+    device_telemetry_log_memory_snapshot("http_macros_post_applied");
 #endif
 
-    // Parse JSON body
-    BasicJsonDocument<MacrosJsonAllocator> doc(kMacrosJsonDocCapacity);
-    DeserializationError error = deserializeJson(doc, g_macros_body, total);
+    portal_work_reply(reply, 200, "{\"success\":true}\n");
+}
 
-    macros_body_reset();
+// POST /api/macros
+// Accepts a single JSON payload containing all screens × buttons. The body is
+// parsed as it arrives (MacrosJsonStream) into a staging MacroConfig, which
+// replaces the runtime config once it is complete, valid and saved.
+static void handlePostMacros(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
+
+    const bool is_final = index + len >= total;
+    if (index == 0) {
+        if (!macros_update_begin(request)) return;
 
-    if (error) {
-        Logger.logMessagef("Macros", "JSON parse error: %s", error.c_str());
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
-        device_telemetry_log_memory_snapshot("http_macros_post_parse_fail");
+        // Capture heap state right before we allocate the staging config.
+        device_telemetry_log_memory_snapshot("http_macros_post_begin");
 #endif
-        if (error == DeserializationError::NoMemory) {
-            request->send(413, "application/json", "{\"success\":false,\"message\":\"JSON body too large\"}");
+
+        g_macros_stage = (MacroConfig*)portal_body_lease(request, "macros", sizeof(MacroConfig));
+        g_macros_stream = new (std::nothrow) MacrosJsonStream();
+        if (!g_macros_stage || !g_macros_stream) {
+            macros_update_fail(request, is_final, 500, "Out of memory");
             return;
         }
-        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+        g_macros_stream->begin(g_macros_stage);
+    }
+
+    if (!macros_update_continue(request, is_final)) return;
+
+    bool ok = g_macros_stream && g_macros_stream->feed(data, len);
+    if (ok && is_final) ok = g_macros_stream->finish();
+    if (!ok) {
+        const char* err = g_macros_stream ? g_macros_stream->error() : "Internal state error";
+        Logger.logMessagef("Macros", "JSON parse error: %s", err);
+#if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
+        device_telemetry_log_memory_snapshot("http_macros_post_parse_fail");
+#endif
+        macros_update_fail(request, is_final, 400, err);
         return;
     }
+    if (!is_final) return;
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
     device_telemetry_log_memory_snapshot("http_macros_post_parsed");
 #endif
 
-    // Basic shape validation
-    if (!doc.containsKey("screens") || !doc["screens"].is<JsonArray>()) {
-        request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing screens[]\"}");
-        return;
-    }
+    // The staging config is the request's lease; the job owns it from here.
+    portal_worker_run(request, PortalWorkRoute::Macros, macros_post_apply,
+        (const uint8_t*)g_macros_stage, sizeof(MacroConfig), nullptr, 0);
+    macros_update_end(request);
+}
 
-    JsonArray screens = doc["screens"].as<JsonArray>();
-    if ((int)screens.size() != MACROS_SCREEN_COUNT) {
-        request->send(400, "application/json", "{\"success\":false,\"message\":\"screens[] has wrong length\"}");
+// Target of a PATCH, parsed from its URL on AsyncTCP.
+struct MacrosPatchTarget {
+    int8_t screen;
+    int8_t button;   // -1: screen settings
+};
+
+// Apply and save a PATCH /api/macros/screens/... body (worker job).
+static void macros_patch_apply(const uint8_t* body, size_t len, const void* arg, PortalWorkReply* reply) {
+    const MacrosPatchTarget* target = (const MacrosPatchTarget*)arg;
+    const int s = target->screen;
+    const int b = target->button;
+
+    BasicJsonDocument<MacrosJsonAllocator> doc(kMacrosPatchJsonDocCapacity);
+    DeserializationError error = deserializeJson(doc, body, len);
+    if (error || !doc.is<JsonObject>()) {
+        portal_work_reply_error(reply, 400, "Invalid JSON");
         return;
     }
+    JsonObject o = doc.as<JsonObject>();
 
-    MacroConfig* next = nullptr;
-#if SOC_SPIRAM_SUPPORTED
-    if (psramFound()) {
-        next = (MacroConfig*)heap_caps_malloc(sizeof(MacroConfig), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    }
-#endif
-    if (!next) {
-        next = (MacroConfig*)malloc(sizeof(MacroConfig));
-    }
-    if (!next) {
-        request->send(500, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
-        return;
-    }
-    macros_config_set_defaults(next);
-
-    // Global defaults
-    if (doc.containsKey("defaults") && doc["defaults"].is<JsonObject>()) {
-        JsonObject d = doc["defaults"].as<JsonObject>();
-        if (d.containsKey("screen_bg")) next->default_screen_bg = clamp_rgb24(d["screen_bg"] | next->default_screen_bg);
-        if (d.containsKey("button_bg")) next->default_button_bg = clamp_rgb24(d["button_bg"] | next->default_button_bg);
-        if (d.containsKey("icon_color")) next->default_icon_color = clamp_rgb24(d["icon_color"] | next->default_icon_color);
-        if (d.containsKey("label_color")) next->default_label_color = clamp_rgb24(d["label_color"] | next->default_label_color);
-    }
+    macros_config_ensure_loaded();
 
-    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
-        JsonVariant sv = screens[s];
-        if (!sv.is<JsonObject>()) {
-            free(next);
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"screens[] entries must be objects\"}");
+    if (b >= 0) {
+        MacroButtonConfig next = macro_config.buttons[s][b];
+        const char* err = macro_button_apply_json(o, &next);
+        if (err) {
+            portal_work_reply_error(reply, 400, err);
             return;
         }
-        JsonObject so = sv.as<JsonObject>();
-
-        // Optional per-screen background override.
-        if (so.containsKey("screen_bg")) {
-            next->screen_bg[s] = clamp_rgb24(so["screen_bg"] | 0);
-        } else {
-            next->screen_bg[s] = MACROS_COLOR_UNSET;
-        }
-
-        // Optional template selection (defaults to the firmware default if missing/invalid).
-        const char* tpl = so["template"] | macro_templates::default_id();
-        if (!macro_templates::is_valid(tpl)) {
-            tpl = macro_templates::default_id();
-        }
-        strlcpy(next->template_id[s], tpl, sizeof(next->template_id[s]));
-
-        if (!so.containsKey("buttons") || !so["buttons"].is<JsonArray>()) {
-            free(next);
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Each screen must have buttons[]\"}");
+        char script_err[128];
+        if (!macros_check_script(&next, s, b, script_err, sizeof(script_err))) {
+            portal_work_reply_error(reply, 400, script_err);
             return;
         }
-        JsonArray buttons = so["buttons"].as<JsonArray>();
-        if ((int)buttons.size() != MACROS_BUTTONS_PER_SCREEN) {
-            free(next);
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"buttons[] has wrong length\"}");
+
+        const MacroButtonConfig prev = macro_config.buttons[s][b];
+        macro_config.buttons[s][b] = next;
+        if (!macros_config_save(&macro_config)) {
+            macro_config.buttons[s][b] = prev;
+            portal_work_reply_error(reply, 500, "Failed to save");
             return;
         }
-
-        for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
-            JsonVariant bv = buttons[b];
-            if (!bv.is<JsonObject>()) {
-                free(next);
-                request->send(400, "application/json", "{\"success\":false,\"message\":\"buttons[] entries must be objects\"}");
+        macros_config_mark_button_changed((uint8_t)s, (uint8_t)b);
+    } else {
+        char tpl[MACROS_TEMPLATE_ID_MAX_LEN];
+        strlcpy(tpl, macro_config.template_id[s], sizeof(tpl));
+        if (o.containsKey("template")) {
+            const char* t = o["template"] | "";
+            if (!macro_templates::is_valid(t)) {
+                portal_work_reply_error(reply, 400, "Unknown template");
                 return;
             }
-            JsonObject bo = bv.as<JsonObject>();
-
-            const char* label = bo["label"] | "";
-            const char* action_s = bo["action"] | "none";
-            const char* payload = bo["payload"] | "";
-            const char* mqtt_topic = bo["mqtt_topic"] | "";
-
-            MacroIconType iconType = MacroIconType::None;
-            const char* iconId = "";
-            const char* iconDisplay = "";
-            if (bo.containsKey("icon") && bo["icon"].is<JsonObject>()) {
-                JsonObject io = bo["icon"].as<JsonObject>();
-                iconType = macro_icon_type_from_string(io["type"] | "none");
-                iconId = io["id"] | "";
-                iconDisplay = io["display"] | "";
-            }
-
-            strlcpy(next->buttons[s][b].label, label, sizeof(next->buttons[s][b].label));
-            next->buttons[s][b].action = macro_action_from_string(action_s);
-            strlcpy(next->buttons[s][b].payload, payload, sizeof(next->buttons[s][b].payload));
-            strlcpy(next->buttons[s][b].mqtt_topic, mqtt_topic, sizeof(next->buttons[s][b].mqtt_topic));
-
-            next->buttons[s][b].icon.type = iconType;
-            strlcpy(next->buttons[s][b].icon.id, iconId, sizeof(next->buttons[s][b].icon.id));
-            strlcpy(next->buttons[s][b].icon.display, iconDisplay, sizeof(next->buttons[s][b].icon.display));
-
-            // Optional per-button appearance overrides.
-            next->buttons[s][b].button_bg = bo.containsKey("button_bg") ? clamp_rgb24(bo["button_bg"] | 0) : MACROS_COLOR_UNSET;
-            next->buttons[s][b].icon_color = bo.containsKey("icon_color") ? clamp_rgb24(bo["icon_color"] | 0) : MACROS_COLOR_UNSET;
-            next->buttons[s][b].label_color = bo.containsKey("label_color") ? clamp_rgb24(bo["label_color"] | 0) : MACROS_COLOR_UNSET;
-
-            // Normalize: if action is none, clear payload/icon to keep state tidy.
-            if (next->buttons[s][b].action == MacroButtonAction::None) {
-                next->buttons[s][b].payload[0] = '\0';
-                next->buttons[s][b].mqtt_topic[0] = '\0';
-                next->buttons[s][b].icon.type = MacroIconType::None;
-                next->buttons[s][b].icon.id[0] = '\0';
-                next->buttons[s][b].icon.display[0] = '\0';
-            }
+            strlcpy(tpl, t, sizeof(tpl));
+        }
+        const uint32_t bg = o.containsKey("screen_bg") ? macro_color_from_json(o["screen_bg"]) : macro_config.screen_bg[s];
+
+        char prev_tpl[MACROS_TEMPLATE_ID_MAX_LEN];
+        strlcpy(prev_tpl, macro_config.template_id[s], sizeof(prev_tpl));
+        const uint32_t prev_bg = macro_config.screen_bg[s];
+        strlcpy(macro_config.template_id[s], tpl, sizeof(macro_config.template_id[s]));
+        macro_config.screen_bg[s] = bg;
+        if (!macros_config_save(&macro_config)) {
+            strlcpy(macro_config.template_id[s], prev_tpl, sizeof(macro_config.template_id[s]));
+            macro_config.screen_bg[s] = prev_bg;
+            portal_work_reply_error(reply, 500, "Failed to save");
+            return;
+        }
+        macros_config_mark_screen_changed((uint8_t)s);
+    }
 
-            // Validate: mqtt_send requires a topic.
-            if (next->buttons[s][b].action == MacroButtonAction::MqttSend) {
-                if (!next->buttons[s][b].mqtt_topic[0]) {
-                    free(next);
-                    request->send(400, "application/json", "{\"success\":false,\"message\":\"mqtt_send requires mqtt_topic\"}");
-                    return;
-                }
-            }
+    ducky_programs_rebuild(&macro_config);
+    portal_work_reply(reply, 200, "{\"success\":true}\n");
+}
 
-            // For non-MQTT actions, ignore stored mqtt_topic.
-            if (next->buttons[s][b].action != MacroButtonAction::MqttSend) {
-                next->buttons[s][b].mqtt_topic[0] = '\0';
-            }
+// PATCH /api/macros/screens/{n}             - {"template":"...","screen_bg":0xRRGGBB|null}
+// PATCH /api/macros/screens/{n}/buttons/{m}  - button object; only the keys present change
+// n and m are 0-based indexes into GET /api/macros screens[] / buttons[].
+// Edits macro_config in place and saves it, so changing one label does not
+// need the full-config document or a second MacroConfig.
+static void handlePatchMacros(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (!portal_auth_gate(request)) return;
 
-            // For non-payload actions, ignore stored payload.
-            if (next->buttons[s][b].action != MacroButtonAction::SendKeys && next->buttons[s][b].action != MacroButtonAction::NavToScreen && next->buttons[s][b].action != MacroButtonAction::MqttSend) {
-                next->buttons[s][b].payload[0] = '\0';
-            }
-        }
+    const uint8_t* body = macros_body_collect(request, data, len, index, total, kMacrosPatchMaxBody);
+    if (!body) return;
+
+    int s = -1;
+    int b = -1;
+    char tail = 0;
+    const char* url = request->url().c_str();
+    bool is_button = sscanf(url, "/api/macros/screens/%d/buttons/%d%c", &s, &b, &tail) == 2;
+    if (!is_button && sscanf(url, "/api/macros/screens/%d%c", &s, &tail) != 1) {
+        macros_update_end(request);
+        send_macros_error(request, 404, "Unknown macros path");
+        return;
     }
-
-    if (!macros_config_save(next)) {
-        free(next);
-#if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
-        device_telemetry_log_memory_snapshot("http_macros_post_save_fail");
-#endif
-        request->send(500, "application/json", "{\"success\":false,\"message\":\"Failed to save\"}");
+    if (s < 0 || s >= MACROS_SCREEN_COUNT || (is_button && (b < 0 || b >= MACROS_BUTTONS_PER_SCREEN))) {
+        macros_update_end(request);
+        send_macros_error(request, 404, "Screen or button out of range");
         return;
     }
 
-#if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
-    device_telemetry_log_memory_snapshot("http_macros_post_saved");
-#endif
-
-    g_macros_loaded = true;
-
-    // Apply immediately to the runtime macro UI.
-    memcpy(&macro_config, next, sizeof(MacroConfig));
+    const MacrosPatchTarget target = {(int8_t)s, (int8_t)(is_button ? b : -1)};
+    portal_worker_run(request, PortalWorkRoute::Macros, macros_patch_apply, body, total, &target, sizeof(target));
+    macros_update_end(request);
+}
 
-    free(next);
+#if HAS_MQTT && MQTT_MACROS_SYNC
+// POST /api/macros/sync - publish this device's macros as the next fleet
+// version (the screens that differ from the retained ones, then the manifest).
+static void handlePostMacrosSync(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
 
-#if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
-    device_telemetry_log_memory_snapshot("http_macros_post_applied");
-#endif
+    macros_config_ensure_loaded();
+    uint32_t version = 0;
+    uint8_t screens = 0;
+    char err[96] = "";
+    if (!mqtt_macros_sync_publish(&macro_config, &version, &screens, err, sizeof(err))) {
+        send_macros_error(request, 503, err);
+        return;
+    }
 
-    request->send(200, "application/json", "{\"success\":true}\n");
+    char body[96];
+    snprintf(body, sizeof(body), "{\"success\":true,\"version\":%lu,\"screens\":%u}\n", (unsigned long)version, (unsigned)screens);
+    request->send(200, "application/json", body);
 }
+#endif
 
 void web_portal_register_api_macros_routes(AsyncWebServer& server) {
     server.on("/api/macros", HTTP_GET, handleGetMacros);
+#if HAS_MQTT && MQTT_MACROS_SYNC
+    // Before POST /api/macros, which would also match this path.
+    server.on("/api/macros/sync", HTTP_POST, handlePostMacrosSync);
+#endif
     server.on(
         "/api/macros",
         HTTP_POST,
         [](AsyncWebServerRequest* request) {
             if (!portal_auth_gate(request)) return;
+            // No body: the body handler never runs, so answer here.
+            if (request->contentLength() == 0) {
+                send_macros_error(request, 400, "Missing JSON body");
+            }
         },
         NULL,
         handlePostMacros
     );
+    server.on(
+        "/api/macros/screens",
+        HTTP_PATCH,
+        [](AsyncWebServerRequest* request) {
+            if (!portal_auth_gate(request)) return;
+            // No body: the body handler never runs, so answer here.
+            if (request->contentLength() == 0) {
+                send_macros_error(request, 400, "Missing JSON body");
+            }
+        },
+        NULL,
+        handlePatchMacros
+    );
 }
@@ -5,9 +5,29 @@
 
 #include "device_telemetry.h"
 #include "log_manager.h"
+#include "ota_gzip.h"
+#include "ota_quiet.h"
+#include "web_portal_admission.h"
 #include "web_portal_auth.h"
 #include "web_portal_state.h"
 
+// Decoder for a gzip upload; one OTA runs at a time.
+static OtaGzip ota_gzip;
+static bool ota_gzip_active = false;
+
+static bool ota_flash_sink(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    const uint32_t t0 = micros();
+    const bool ok = Update.write(const_cast<uint8_t*>(data), len) == len;
+    ota_quiet_note_flash_write(len, micros() - t0);
+    return ok;
+}
+
+static void ota_gzip_release() {
+    ota_gzip.end();
+    ota_gzip_active = false;
+}
+
 static void handleOTAUpload(AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final) {
     if (!portal_auth_gate(request)) return;
 
@@ -21,19 +41,22 @@ static void handleOTAUpload(AsyncWebServerRequest* request, String filename, siz
         web_portal_state().ota_progress = 0;
         web_portal_state().ota_total = request->contentLength();
 
-        // Check if filename ends with .bin
-        if (!filename.endsWith(".bin")) {
+        // Plain app image (.bin) or its gzip (.bin.gz, detected by magic too)
+        const bool gzip = filename.endsWith(".gz") || OtaGzip::looks_gzip(data, len);
+        if (!filename.endsWith(".bin") && !gzip) {
             Logger.logEnd("Not a .bin file");
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Only .bin files are supported\"}");
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Only .bin or .bin.gz files are supported\"}");
             web_portal_state().ota_in_progress = false;
             return;
         }
 
-        // Get OTA partition size
-        size_t updateSize = (web_portal_state().ota_total > 0) ? web_portal_state().ota_total : UPDATE_SIZE_UNKNOWN;
+        // Get OTA partition size. A gzip upload's image size is only known at
+        // the end; Update stops at the partition size.
+        size_t updateSize = (web_portal_state().ota_total > 0 && !gzip) ? web_portal_state().ota_total : UPDATE_SIZE_UNKNOWN;
         size_t freeSpace = device_telemetry_free_sketch_space();
 
         Logger.logLinef("Free space: %d bytes", freeSpace);
+        if (gzip) Logger.logLine("Format: gzip");
 
         // Validate size before starting
         if (web_portal_state().ota_total > 0 && web_portal_state().ota_total > freeSpace) {
@@ -51,11 +74,34 @@ static void handleOTAUpload(AsyncWebServerRequest* request, String filename, siz
             web_portal_state().ota_in_progress = false;
             return;
         }
+
+        ota_gzip_active = false;
+        if (gzip) {
+            if (!ota_gzip.begin(ota_flash_sink, nullptr)) {
+                Logger.logEnd(ota_gzip.error());
+                Update.abort();
+                request->send(500, "application/json", "{\"success\":false,\"message\":\"Out of memory for gzip decoder\"}");
+                web_portal_state().ota_in_progress = false;
+                return;
+            }
+            ota_gzip_active = true;
+            // The decoder's buffers go back even if the client drops mid-upload.
+            if (!portal_on_request_end(request, []() { ota_gzip_release(); })) {
+                ota_gzip_release();
+                Logger.logEnd("No end hook");
+                Update.abort();
+                request->send(503, "application/json", "{\"success\":false,\"message\":\"Device busy, retry later\"}");
+                web_portal_state().ota_in_progress = false;
+                return;
+            }
+        }
     }
 
-    // Write chunk to flash
+    // Write chunk to flash (through the decoder for gzip; it writes whole sectors)
     if (len) {
-        if (Update.write(data, len) != len) {
+        const bool ok = ota_gzip_active ? ota_gzip.write(data, len) : ota_flash_sink(nullptr, data, len);
+        if (!ok) {
+            if (ota_gzip_active && ota_gzip.error()) Logger.logLine(ota_gzip.error());
             Logger.logEnd("Write failed");
             Update.printError(Serial);
             request->send(500, "application/json", "{\"success\":false,\"message\":\"Write failed\"}");
@@ -76,6 +122,19 @@ static void handleOTAUpload(AsyncWebServerRequest* request, String filename, siz
 
     // Final chunk - complete OTA
     if (final) {
+        if (ota_gzip_active && !ota_gzip.finish()) {
+            Logger.logEnd(ota_gzip.error());
+            Update.abort();
+            ota_gzip_release();
+            request->send(500, "application/json", "{\"success\":false,\"message\":\"Corrupt gzip firmware\"}");
+            web_portal_state().ota_in_progress = false;
+            return;
+        }
+        if (ota_gzip_active) {
+            Logger.logLinef("Inflated: %u bytes", (unsigned)ota_gzip.out_bytes());
+            ota_gzip_release();
+        }
+
         if (Update.end(true)) {
             Logger.logLinef("Written: %d bytes", web_portal_state().ota_progress);
             Logger.logEnd("Success - rebooting");
@@ -1,12 +1,27 @@
 #include "../version.h"
 #include "board_config.h"
+#include "boot_profile.h"
 #include "config_manager.h"
 #include "web_portal.h"
+#include "web_portal_events.h"
 #include "log_manager.h"
+#include "log_stream.h"
 #include "mqtt_manager.h"
 #include "device_telemetry.h"
 #include "ble_keyboard_manager.h"
 #include "macros_config.h"
+#include "ducky_script.h"
+#include "power_manager.h"
+#include "loop_scheduler.h"
+#include "static_alloc.h"
+#include "memory_pressure.h"
+#include "ota_quiet.h"
+#include "task_placement.h"
+#include "trace.h"
+#include "wifi_cache.h"
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+#include "image_api.h"
+#endif
 #include <WiFi.h>
 #include <ESPmDNS.h>
 #include <lwip/netif.h>
@@ -14,13 +29,27 @@
 #if defined(ARDUINO_ARCH_ESP32)
 #include <soc/soc_caps.h>
 #include <esp_attr.h>
+#include <freertos/semphr.h>
 #endif
 
 #if HAS_DISPLAY
 #include "display_manager.h"
+#include "screen_capture.h"
 #include "screen_saver_manager.h"
 #endif
 
+#if HAS_DISPLAY && HAS_ICONS && ICON_STORE_WARMUP
+#include "icon_warmup.h"
+#endif
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED
+#include "icon_pack.h"
+#endif
+
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+#include "label_font.h"
+#endif
+
 #if HAS_TOUCH
 #include "touch_manager.h"
 #endif
@@ -48,11 +77,21 @@ const unsigned long WIFI_BACKOFF_BASE = 3000; // 3 seconds base (DHCP typically
 
 // Heartbeat interval (board-configurable)
 const unsigned long HEARTBEAT_INTERVAL = HEARTBEAT_INTERVAL_MS;
-unsigned long lastHeartbeat = 0;
 
-// WiFi watchdog for connection monitoring
+// WiFi watchdog for connection monitoring (safety net: disconnects wake it at once)
 const unsigned long WIFI_CHECK_INTERVAL = 10000; // 10 seconds
-unsigned long lastWiFiCheck = 0;
+
+// millis() of the last station disconnect, 0 once reconnected. Set by the
+// WiFi event task, read by the watchdog.
+static volatile uint32_t g_wifi_dropped_ms = 0;
+// millis() of the last failed watchdog reconnect (0 = none); spaces retries.
+static uint32_t g_wifi_failed_ms = 0;
+
+// Dotted quad without an Arduino String (no heap allocation).
+static const char* ip_to_str(const IPAddress& ip, char* out, size_t out_len) {
+  snprintf(out, out_len, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  return out;
+}
 
 // WiFi event handlers for connection lifecycle monitoring
 void onWiFiConnected(WiFiEvent_t event, WiFiEventInfo_t info) {
@@ -60,13 +99,20 @@ void onWiFiConnected(WiFiEvent_t event, WiFiEventInfo_t info) {
 }
 
 void onWiFiGotIP(WiFiEvent_t event, WiFiEventInfo_t info) {
-  Logger.logMessagef("WiFi", "Got IP: %s", WiFi.localIP().toString().c_str());
+  boot_profile_mark(BootMilestone::WifiUp);
+  char ip[16];
+  Logger.logMessagef("WiFi", "Got IP: %s", ip_to_str(WiFi.localIP(), ip, sizeof(ip)));
 }
 
 void onWiFiDisconnected(WiFiEvent_t event, WiFiEventInfo_t info) {
   uint8_t reason = info.wifi_sta_disconnected.reason;
   Logger.logMessagef("WiFi", "Disconnected - reason: %d", reason);
 
+  // Wake the watchdog instead of waiting for its next poll.
+  const uint32_t now = millis();
+  g_wifi_dropped_ms = now ? now : 1;
+  loop_scheduler_notify();
+
   // Common disconnect reasons:
   // 2 = AUTH_EXPIRE, 3 = AUTH_LEAVE, 4 = ASSOC_EXPIRE
   // 8 = ASSOC_LEAVE, 15 = 4WAY_HANDSHAKE_TIMEOUT
@@ -74,11 +120,280 @@ void onWiFiDisconnected(WiFiEvent_t event, WiFiEventInfo_t info) {
 }
 
 
+// ============================================================================
+// Main loop callbacks (see loop_scheduler.h)
+// ============================================================================
+// Each returns how long (ms) until it should run again.
+
+#if HAS_DISPLAY
+static uint32_t loop_screen_saver(uint32_t) {
+  screen_saver_manager_loop();
+  return screen_saver_manager_poll_interval_ms();
+}
+#endif
+
+static uint32_t loop_power(uint32_t) {
+  power_manager_loop();
+  return 10;
+}
+
+#if HAS_TOUCH
+static uint32_t loop_touch(uint32_t) {
+  touch_manager_loop();
+  return 50;
+}
+#endif
+
+static uint32_t loop_portal(uint32_t) {
+  // Handle web portal (DNS for captive portal)
+  web_portal_handle();
+  return web_portal_is_ap_mode() ? 10 : 100;
+}
+
+#if HAS_IMAGE_API
+static uint32_t loop_images(uint32_t) {
+  // Process pending image uploads (deferred decoding)
+  web_portal_process_pending_images();
+  return 10;
+}
+#endif
+
+#if HAS_DISPLAY && SCREEN_CAPTURE_ENABLED
+static uint32_t loop_screen_mirror(uint32_t now) {
+  // Push /api/display/mirror updates (idle without clients).
+  return screen_capture_poll(now);
+}
+#endif
+
+static uint32_t loop_portal_events(uint32_t now) {
+  // Push /api/events updates (idle until someone subscribes).
+  return web_portal_events_poll(now);
+}
+
+#if HAS_MQTT
+static uint32_t loop_mqtt(uint32_t) {
+  mqtt_manager.loop();
+  return 10;
+}
+#endif
+
+static uint32_t loop_config_store(uint32_t now) {
+  // Debounced write of config saved from the portal (idle until one is).
+  return config_manager_loop(now);
+}
+
+static uint32_t loop_ota_quiet(uint32_t now) {
+  // Pause/restore subsystems around firmware updates.
+  return ota_quiet_loop(now);
+}
+
+#if MEMORY_PRESSURE_ENABLED
+static uint32_t loop_memory_pressure(uint32_t now) {
+  // Shed or restore load as the heap runs low / recovers.
+  return memory_pressure_loop(now);
+}
+#endif
+
+static uint32_t loop_ble(uint32_t) {
+  // On-demand BLE stack start / idle shutdown (no-op otherwise).
+  ble_keyboard.loop();
+  return 50;
+}
+
+// WiFi watchdog - reconnect after a disconnect event (or a missed one, on the poll)
+static uint32_t loop_wifi_watchdog(uint32_t now) {
+  // Only run if we're not in AP mode (AP mode is the fallback, should stay active)
+  if (!config_loaded || web_portal_is_ap_mode() || strlen(device_config.wifi_ssid) == 0) {
+    return WIFI_CHECK_INTERVAL;
+  }
+  if (WiFi.status() == WL_CONNECTED) {
+    g_wifi_dropped_ms = 0;
+    return WIFI_CHECK_INTERVAL;
+  }
+
+  // The driver's auto-reconnect goes straight back to the same AP; give it
+  // WIFI_RECONNECT_GRACE_MS before tearing the station down.
+  const uint32_t dropped = g_wifi_dropped_ms;
+  if (dropped && now - dropped < WIFI_RECONNECT_GRACE_MS) {
+    return WIFI_RECONNECT_GRACE_MS - (now - dropped);
+  }
+  if (g_wifi_failed_ms && now - g_wifi_failed_ms < WIFI_CHECK_INTERVAL) {
+    return WIFI_CHECK_INTERVAL - (now - g_wifi_failed_ms);
+  }
+
+  Logger.logMessage("WiFi Watchdog", "Connection lost - attempting reconnect");
+  if (connect_wifi()) {
+    g_wifi_failed_ms = 0;
+    g_wifi_dropped_ms = 0;
+    start_mdns();
+  } else {
+    const uint32_t failed = millis();
+    g_wifi_failed_ms = failed ? failed : 1;
+  }
+  return WIFI_CHECK_INTERVAL;
+}
+
+static uint32_t loop_heartbeat(uint32_t now) {
+  if (WiFi.status() == WL_CONNECTED) {
+    char ip[16];
+    Logger.logQuickf("Heartbeat", "Up: %ds | Heap: %d | WiFi: %s (%s)",
+      now / 1000, ESP.getFreeHeap(),
+      ip_to_str(WiFi.localIP(), ip, sizeof(ip)), WiFi.getHostname());
+  } else {
+    Logger.logQuickf("Heartbeat", "Up: %ds | Heap: %d | WiFi: Disconnected",
+      now / 1000, ESP.getFreeHeap());
+  }
+
+  // Keep a consistent memory line in the logs to quantify before/after changes.
+  device_telemetry_log_memory_snapshot("hb");
+  return HEARTBEAT_INTERVAL;
+}
+
+// Same order the old polling loop() used; event-driven entries run as soon as
+// another task calls loop_scheduler_notify().
+static void register_loop_tasks() {
+  loop_scheduler_init();
+  #if HAS_DISPLAY
+  loop_scheduler_add("screen_saver", loop_screen_saver, 0, true);
+  #endif
+  loop_scheduler_add("power", loop_power, 0);
+  #if HAS_TOUCH
+  loop_scheduler_add("touch", loop_touch, 0);
+  #endif
+  loop_scheduler_add("portal", loop_portal, 0);
+  #if HAS_IMAGE_API
+  loop_scheduler_add("images", loop_images, 0, true);
+  #endif
+  loop_scheduler_add("events", loop_portal_events, 0, true);
+  #if HAS_DISPLAY && SCREEN_CAPTURE_ENABLED
+  loop_scheduler_add("mirror", loop_screen_mirror, 0, true);
+  #endif
+  #if HAS_MQTT
+  loop_scheduler_add("mqtt", loop_mqtt, 0);
+  #endif
+  loop_scheduler_add("config_store", loop_config_store, 0, true);
+  loop_scheduler_add("ota_quiet", loop_ota_quiet, 0);
+  #if MEMORY_PRESSURE_ENABLED
+  loop_scheduler_add("mem_pressure", loop_memory_pressure, 0, true);
+  #endif
+  loop_scheduler_add("ble", loop_ble, 0, true);
+  loop_scheduler_add("wifi_watchdog", loop_wifi_watchdog, WIFI_CHECK_INTERVAL, true);
+  loop_scheduler_add("heartbeat", loop_heartbeat, HEARTBEAT_INTERVAL);
+}
+
+// ============================================================================
+// Boot helpers
+// ============================================================================
+
+// connect_wifi(), and once more after a hard reset of the radio when that fails.
+static bool connect_wifi_with_reset() {
+  if (connect_wifi()) return true;
+
+  // Hard reset retry - WiFi hardware may be in bad state
+  Logger.logMessage("Main", "WiFi failed - attempting hard reset");
+  Logger.logBegin("WiFi Hard Reset");
+  WiFi.mode(WIFI_OFF);
+  delay(1000);  // Longer delay to fully reset hardware
+  WiFi.mode(WIFI_STA);
+  delay(500);
+  Logger.logEnd("Reset complete");
+
+  // One more attempt after hard reset
+  return connect_wifi();
+}
+
+#if BOOT_WIFI_PARALLEL
+static SemaphoreHandle_t g_wifi_boot_done = nullptr;
+static volatile bool g_wifi_boot_ok = false;
+
+static void wifi_boot_task(void*) {
+  g_wifi_boot_ok = connect_wifi_with_reset();
+  xSemaphoreGive(g_wifi_boot_done);
+  vTaskDelete(nullptr);
+}
+#endif
+
+// Start associating with the configured network. With BOOT_WIFI_PARALLEL
+// this returns at once and wifi_boot_finish() collects the result.
+static void wifi_boot_start() {
+  #if BOOT_WIFI_PARALLEL
+  g_wifi_boot_done = xSemaphoreCreateBinary();
+  if (g_wifi_boot_done &&
+      task_placement_create(wifi_boot_task, "WiFiBoot", BOOT_WIFI_TASK_STACK_BYTES, nullptr, 1, nullptr, -1) == pdPASS) {
+    return;
+  }
+  if (g_wifi_boot_done) {
+    vSemaphoreDelete(g_wifi_boot_done);
+    g_wifi_boot_done = nullptr;
+  }
+  Logger.logMessage("Main", "WiFi boot task not started; connecting in setup");
+  #endif
+}
+
+// Whether the station connected (blocks until wifi_boot_start()'s attempt ends).
+static bool wifi_boot_finish() {
+  #if BOOT_WIFI_PARALLEL
+  if (g_wifi_boot_done) {
+    xSemaphoreTake(g_wifi_boot_done, portMAX_DELAY);
+    vSemaphoreDelete(g_wifi_boot_done);
+    g_wifi_boot_done = nullptr;
+    return g_wifi_boot_ok;
+  }
+  #endif
+  return connect_wifi_with_reset();
+}
+
+// Set once setup() has finished (see boot_complete_if_done).
+static bool g_setup_done = false;
+
+// Boot is over once setup() has returned and every macro screen is loaded,
+// whichever comes last; heap allocations after that count as steady state.
+static void boot_complete_if_done() {
+  if (__atomic_load_n(&g_setup_done, __ATOMIC_SEQ_CST) && boot_profile_get_ms(BootMilestone::MacrosAll)) {
+    static_alloc_boot_complete();
+  }
+}
+
+// Every macro screen is loaded: compile their scripts. Setup or the macro load task.
+static void on_macros_loaded(MacroConfig* cfg) {
+  boot_profile_mark(BootMilestone::MacrosAll);
+  ducky_programs_rebuild(cfg);
+  boot_complete_if_done();
+}
+
+#if HAS_DISPLAY
+// Hold the splash until it has been on the panel for BOOT_SPLASH_MIN_MS. The
+// work since display init normally covers that already; the cap keeps a panel
+// that never presents from stalling boot.
+static void wait_splash_shown() {
+  const uint32_t start = millis();
+  while (millis() - start < BOOT_SPLASH_MIN_MS + 2000) {
+    const uint32_t shown = boot_profile_get_ms(BootMilestone::FirstPixel);
+    if (shown && millis() - shown >= BOOT_SPLASH_MIN_MS) return;
+    delay(10);
+  }
+}
+#endif
+
 void setup()
 {
+  boot_profile_mark(BootMilestone::Setup);
+
   // Initialize log manager (wraps Serial for web streaming)
   Logger.begin(115200);
-  delay(1000);
+  #if defined(ARDUINO_USB_CDC_ON_BOOT) && ARDUINO_USB_CDC_ON_BOOT
+  // Give a serial monitor a moment to attach so the boot banner is not lost;
+  // returns at once when one already is.
+  while (!Serial && millis() < BOOT_SERIAL_WAIT_MS) {
+    delay(10);
+  }
+  #endif
+
+  // Before any task that records trace events starts.
+  trace_init();
+
+  // STATIC_ALLOC_MODE arenas, while the heap is still whole.
+  static_alloc_init();
 
   // Register WiFi event handlers for connection lifecycle
   WiFi.onEvent(onWiFiConnected, ARDUINO_EVENT_WIFI_STA_CONNECTED);
@@ -104,12 +419,24 @@ void setup()
   device_telemetry_log_memory_snapshot("boot");
 
   // Initialize device_config with sensible defaults
-  // (Important: must happen before display_manager_init uses the config)
+  // (Important: must happen before config_manager_load and display_manager_init)
   memset(&device_config, 0, sizeof(DeviceConfig));
   device_config.backlight_brightness = 100;  // Default to full brightness
   device_config.mqtt_port = 0;
   device_config.mqtt_interval_seconds = 0;
 
+  #if LOG_STREAM_ENABLED
+  device_config.log_stream_port = 0;
+  #endif
+
+  #if HAS_IMAGE_API && IMAGE_API_MULTICAST
+  device_config.image_mcast_port = 0;
+  #endif
+
+  #if HAS_BLE_KEYBOARD
+  device_config.ble_typing_interval_ms = BLE_KEYBOARD_TYPING_INTERVAL_MS;
+  #endif
+
   #if HAS_DISPLAY
   // Screen saver defaults (v1)
   device_config.screen_saver_enabled = false;
@@ -129,36 +456,24 @@ void setup()
   digitalWrite(LED_PIN, LED_ACTIVE_HIGH ? LOW : HIGH); // LED off initially
   #endif
 
-  #if HAS_DISPLAY
-  display_manager_init(&device_config);
-  display_manager_set_splash_status("Loading config...");
-  #endif
-
-  #if HAS_TOUCH
-  // Initialize touch after display is ready
-  touch_manager_init();
-  #endif
-
   // Initialize configuration manager
-  #if HAS_DISPLAY
-  display_manager_set_splash_status("Init NVS...");
-  #endif
   config_manager_init();
 
   // Cache flash/sketch metadata early to avoid concurrent access from different tasks later
   // (e.g., MQTT publish + web API calls).
   device_telemetry_init();
 
+  // Timer service task priority from the Task Placement table (TIMER_TASK_PRIORITY).
+  task_placement_init();
+
   // Start CPU monitoring background task
   device_telemetry_start_cpu_monitoring();
 
   // Start /api/health window min/max sampler (captures short dips between polls)
   device_telemetry_start_health_window_sampling();
 
-  // Try to load saved configuration
-  #if HAS_DISPLAY
-  display_manager_set_splash_status("Reading config...");
-  #endif
+  // Load the saved configuration first (a few ms of NVS): WiFi can then start
+  // associating right away, and the display comes up at the saved brightness.
   config_loaded = config_manager_load(&device_config);
 
   if (!config_loaded) {
@@ -166,10 +481,27 @@ void setup()
     String default_name = config_manager_get_default_device_name();
     strlcpy(device_config.device_name, default_name.c_str(), CONFIG_DEVICE_NAME_MAX_LEN);
     device_config.magic = CONFIG_MAGIC;
+  } else {
+    // Association (scan, connect, DHCP) runs while the display, BLE and icons start.
+    Logger.logMessage("Main", "Config loaded - connecting to WiFi");
+    wifi_boot_start();
   }
 
-  // Load macro config (independent of WiFi config validity)
-  (void)macros_config_load(&macro_config);
+  #if HAS_DISPLAY
+  display_manager_init(&device_config);
+  display_manager_set_splash_status(config_loaded ? "Connecting WiFi..." : "Starting...");
+  #endif
+
+  #if HAS_TOUCH
+  // Initialize touch after display is ready
+  touch_manager_init();
+  #endif
+
+  // Load macro config (independent of WiFi config validity). With
+  // BOOT_MACROS_LAZY only the default screen is read here; the rest follow
+  // from a background task and on_macros_loaded runs once they are in.
+  (void)macros_config_load_lazy(&macro_config, 0, on_macros_loaded);
+  boot_profile_mark(BootMilestone::Macros);
 
   // Start BLE HID keyboard after device name is known.
   // Safe no-op when HAS_BLE_KEYBOARD is false or Bluetooth is not enabled in the core.
@@ -180,10 +512,19 @@ void setup()
   display_manager_set_macro_runtime(&macro_config, &ble_keyboard);
   #endif
 
-  // Re-apply brightness from loaded config (display was initialized before config load)
-  #if HAS_DISPLAY && HAS_BACKLIGHT
-  Logger.logLinef("Main: Applying loaded brightness: %d%%", device_config.backlight_brightness);
-  display_manager_set_backlight_brightness(device_config.backlight_brightness);
+  #if HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED
+  // Map the read-only icon pack before anything looks icons up.
+  icon_pack_init();
+  #endif
+
+  #if HAS_DISPLAY && LABEL_FONT_ENABLED
+  // Queue the uploaded label font (if any) for the LVGL task; FFat is mounted by now.
+  label_font_init();
+  #endif
+
+  #if HAS_DISPLAY && HAS_ICONS && ICON_STORE_WARMUP
+  // Preload installed icons while WiFi connects and the splash is up.
+  icon_warmup_start(&macro_config);
   #endif
 
   #if HAS_DISPLAY
@@ -191,41 +532,48 @@ void setup()
   screen_saver_manager_init(&device_config);
   #endif
 
-  // Start WiFi BEFORE initializing web server (critical for ESP32-C3)
+  // Idle power mode (entered by the screen saver; no-op unless POWER_IDLE_ENABLED).
+  power_manager_init();
+
   #if HAS_DISPLAY
-  display_manager_set_splash_status("Connecting WiFi...");
+  // The macro pad does not need the network: show it as soon as the splash
+  // has been readable, and finish bringing up WiFi and the portal behind it.
+  wait_splash_shown();
+
+  // Navigate to Macro Screen 1 by default
+  bool ok = false;
+  display_manager_show_screen("macro1", &ok);
+  if (!ok) {
+    display_manager_show_info();
+  }
+
+  // Start the screen saver inactivity timer after the first runtime screen is visible.
+  // This avoids counting boot + splash time as "inactivity".
+  screen_saver_manager_notify_activity(false);
   #endif
 
+  // Start WiFi BEFORE initializing web server (critical for ESP32-C3)
   if (!config_loaded) {
     Logger.logMessage("Main", "No config - starting AP mode");
     web_portal_start_ap();
+  } else if (wifi_boot_finish()) {
+    start_mdns();
   } else {
-    Logger.logMessage("Main", "Config loaded - connecting to WiFi");
-    if (connect_wifi()) {
-      start_mdns();
-    } else {
-      // Hard reset retry - WiFi hardware may be in bad state
-      Logger.logMessage("Main", "WiFi failed - attempting hard reset");
-      Logger.logBegin("WiFi Hard Reset");
-      WiFi.mode(WIFI_OFF);
-      delay(1000);  // Longer delay to fully reset hardware
-      WiFi.mode(WIFI_STA);
-      delay(500);
-      Logger.logEnd("Reset complete");
-
-      // One more attempt after hard reset
-      if (connect_wifi()) {
-        start_mdns();
-      } else {
-        Logger.logMessage("Main", "WiFi failed after reset - fallback to AP");
-        web_portal_start_ap();
-      }
-    }
+    Logger.logMessage("Main", "WiFi failed after reset - fallback to AP");
+    web_portal_start_ap();
   }
 
   // Initialize web portal AFTER WiFi is started
   web_portal_init(&device_config);
 
+  // Syslog streaming resolves its host once WiFi is up.
+  log_stream_configure(&device_config);
+
+  #if HAS_IMAGE_API && IMAGE_API_MULTICAST
+  // Multicast image receive joins its group once WiFi is up (and again after drops).
+  image_api_multicast_configure(device_config.image_mcast_group, device_config.image_mcast_port);
+  #endif
+
   #if HAS_MQTT
   // Initialize MQTT manager (will only connect/publish when configured)
   char sanitized[CONFIG_DEVICE_NAME_MAX_LEN];
@@ -237,90 +585,28 @@ void setup()
   #endif
   #endif
 
-  lastHeartbeat = millis();
+  register_loop_tasks();
   Logger.logMessage("Main", "Setup complete");
+  boot_profile_log();
 
   // Snapshot after all subsystems are initialized.
   device_telemetry_log_memory_snapshot("setup");
 
-  #if HAS_DISPLAY
-  // Show splash for minimum duration to ensure visibility
-  display_manager_set_splash_status("Ready!");
-  delay(2000);  // 2 seconds to see splash + status updates
-
-  // Navigate to Macro Screen 1 by default
-  bool ok = false;
-  display_manager_show_screen("macro1", &ok);
-  if (!ok) {
-    display_manager_show_info();
-  }
-
-  // Start the screen saver inactivity timer after the first runtime screen is visible.
-  // This avoids counting boot + splash time as "inactivity".
-  screen_saver_manager_notify_activity(false);
-  #endif
+  __atomic_store_n(&g_setup_done, true, __ATOMIC_SEQ_CST);
+  boot_complete_if_done();
 }
 
 void loop()
 {
-  #if HAS_DISPLAY
-  screen_saver_manager_loop();
-  #endif
-
-  #if HAS_TOUCH
-  touch_manager_loop();
-  #endif
-
-  // Handle web portal (DNS for captive portal)
-  web_portal_handle();
-
-  #if HAS_IMAGE_API
-  // Process pending image uploads (deferred decoding)
-  web_portal_process_pending_images();
-  #endif
-
-  #if HAS_MQTT
-  mqtt_manager.loop();
-  #endif
-
-  unsigned long currentMillis = millis();
-
-  // WiFi watchdog - monitor connection and reconnect if needed
-  // Only run if we're not in AP mode (AP mode is the fallback, should stay active)
-  if (config_loaded && !web_portal_is_ap_mode() && currentMillis - lastWiFiCheck >= WIFI_CHECK_INTERVAL) {
-    if (WiFi.status() != WL_CONNECTED && strlen(device_config.wifi_ssid) > 0) {
-      Logger.logMessage("WiFi Watchdog", "Connection lost - attempting reconnect");
-      if (connect_wifi()) {
-        start_mdns();
-      }
-    }
-    lastWiFiCheck = currentMillis;
-  }
-
-  // Check if it's time for heartbeat
-  if (currentMillis - lastHeartbeat >= HEARTBEAT_INTERVAL) {
-    if (WiFi.status() == WL_CONNECTED) {
-      Logger.logQuickf("Heartbeat", "Up: %ds | Heap: %d | WiFi: %s (%s)",
-        currentMillis / 1000, ESP.getFreeHeap(),
-        WiFi.localIP().toString().c_str(), WiFi.getHostname());
-    } else {
-      Logger.logQuickf("Heartbeat", "Up: %ds | Heap: %d | WiFi: Disconnected",
-        currentMillis / 1000, ESP.getFreeHeap());
-    }
-
-    lastHeartbeat = currentMillis;
-
-    // Keep a consistent memory line in the logs to quantify before/after changes.
-    device_telemetry_log_memory_snapshot("hb");
-  }
-
-  delay(10);
+  // Runs due callbacks, then blocks until the next deadline or an event.
+  loop_scheduler_run();
 }
 
 // Connect to WiFi with exponential backoff
 bool connect_wifi() {
   Logger.logBegin("WiFi Connection");
   Logger.logLinef("SSID: %s", device_config.wifi_ssid);
+  const uint32_t connect_start = millis();
 
   // Helper: format BSSID as string
   auto format_bssid = [](const uint8_t *bssid, char *out, size_t out_len) {
@@ -352,7 +638,9 @@ bool connect_wifi() {
     int matches = 0;
 
     for (int i = 0; i < n; i++) {
-      if (WiFi.SSID(i) == target_ssid) {
+      // The raw record, not WiFi.SSID(i): no String per scanned network.
+      const wifi_ap_record_t *rec = (const wifi_ap_record_t *)WiFi.getScanInfoByIndex(i);
+      if (rec && strcmp((const char *)rec->ssid, target_ssid) == 0) {
         matches++;
         const int rssi = WiFi.RSSI(i);
         if (best_index < 0 || rssi > best_rssi) {
@@ -393,10 +681,159 @@ bool connect_wifi() {
     return true;
   };
 
-  // === WiFi Hardware Reset Sequence ===
+  // Hostname and address; applied again whenever the radio has been reset.
+  // lease: cached DHCP address to apply as a static config (nullptr = DHCP).
+  auto configure_sta = [&](const WifiCacheEntry *lease) -> bool {
+    // Prepare sanitized hostname
+    char sanitized[CONFIG_DEVICE_NAME_MAX_LEN];
+    config_manager_sanitize_device_name(device_config.device_name, sanitized, CONFIG_DEVICE_NAME_MAX_LEN);
+
+    // Set WiFi hostname for mDNS and internal use
+    // NOTE: ESP32's lwIP stack has limited DHCP Option 12 (hostname) support
+    // The hostname may not always appear in router DHCP tables due to ESP-IDF/lwIP limitations
+    // Use mDNS (.local) or NetBIOS for reliable device discovery instead
+    if (strlen(sanitized) > 0) {
+      // Set via WiFi library
+      WiFi.setHostname(sanitized);
+      Logger.logLinef("Hostname: %s", sanitized);
+
+      // Also set via esp_netif API (for compatibility)
+      esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+      if (netif != NULL) {
+        esp_netif_set_hostname(netif, sanitized);
+      }
+    }
+
+    // Configure fixed IP if provided
+    if (strlen(device_config.fixed_ip) > 0) {
+      Logger.logBegin("Fixed IP Config");
+
+      IPAddress local_ip, gateway, subnet, dns1, dns2;
+
+      if (!local_ip.fromString(device_config.fixed_ip)) {
+        Logger.logEnd("Invalid IP address");
+        return false;
+      }
+
+      if (!subnet.fromString(device_config.subnet_mask)) {
+        Logger.logEnd("Invalid subnet mask");
+        return false;
+      }
+
+      if (!gateway.fromString(device_config.gateway)) {
+        Logger.logEnd("Invalid gateway");
+        return false;
+      }
+
+      // DNS1: use provided, or default to gateway
+      if (strlen(device_config.dns1) > 0) {
+        dns1.fromString(device_config.dns1);
+      } else {
+        dns1 = gateway;
+      }
+
+      // DNS2: optional
+      if (strlen(device_config.dns2) > 0) {
+        dns2.fromString(device_config.dns2);
+      } else {
+        dns2 = IPAddress(0, 0, 0, 0);
+      }
+
+      if (!WiFi.config(local_ip, gateway, subnet, dns1, dns2)) {
+        Logger.logEnd("Configuration failed");
+        return false;
+      }
+
+      Logger.logLinef("IP: %s", device_config.fixed_ip);
+      Logger.logEnd();
+    }
+    #if WIFI_FAST_REUSE_LEASE
+    else if (lease) {
+      // Take the last DHCP address without asking again.
+      if (!WiFi.config(IPAddress(lease->ip), IPAddress(lease->gateway), IPAddress(lease->subnet), IPAddress(lease->dns))) {
+        Logger.logLine("Cached lease rejected - using DHCP");
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+      }
+    } else {
+      // Back to DHCP after a fast connect applied a cached lease.
+      WiFi.config(IPAddress(), IPAddress(), IPAddress());
+    }
+    #else
+    (void)lease;
+    #endif
+    return true;
+  };
+
+  // Connected: report, remember the AP for the next fast connect.
+  auto finish_connected = [&](bool fast) {
+    // Reconnects run in the steady state: format without Arduino Strings.
+    char ip[16];
+    ip_to_str(WiFi.localIP(), ip, sizeof(ip));
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    Logger.logLinef("IP: %s", ip);
+    Logger.logLinef("Hostname: %s", WiFi.getHostname());
+    Logger.logLinef("MAC: %02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    Logger.logLinef("Signal: %d dBm", WiFi.RSSI());
+    Logger.logLine("");
+    Logger.logLine("Access via:");
+    Logger.logLinef("  http://%s", ip);
+    Logger.logLinef("  http://%s.local", WiFi.getHostname());
+
+    #if WIFI_FAST_CONNECT
+    WifiCacheEntry entry = {};
+    const uint8_t *bssid = WiFi.BSSID();
+    if (bssid && WiFi.channel() > 0) {
+      memcpy(entry.bssid, bssid, 6);
+      entry.channel = (uint8_t)WiFi.channel();
+      entry.ip = (uint32_t)WiFi.localIP();
+      entry.gateway = (uint32_t)WiFi.gatewayIP();
+      entry.subnet = (uint32_t)WiFi.subnetMask();
+      entry.dns = (uint32_t)WiFi.dnsIP();
+      wifi_cache_store(device_config.wifi_ssid, device_config.wifi_password, entry);
+    }
+    #endif
+
+    const uint32_t took = millis() - connect_start;
+    wifi_cache_note_connect(fast, true, took);
+    Logger.logLinef("Took %lu ms (%s)", (unsigned long)took, fast ? "fast connect" : "scan");
+    Logger.logEnd("Connected");
+  };
+
   // Disable persistent WiFi config (we manage our own via NVS)
   WiFi.persistent(false);
 
+  #if WIFI_FAST_CONNECT
+  // Directed connect to the AP of the last success: no radio reset, no scan.
+  WifiCacheEntry cached;
+  if (wifi_cache_load(device_config.wifi_ssid, device_config.wifi_password, &cached)) {
+    char bssid_str[18];
+    format_bssid(cached.bssid, bssid_str, sizeof(bssid_str));
+    Logger.logLinef("Fast connect: %s | Ch %u", bssid_str, (unsigned)cached.channel);
+
+    WiFi.mode(WIFI_STA);
+    WiFi.setSleep(false);
+    WiFi.setAutoReconnect(true);
+    if (configure_sta(WIFI_FAST_REUSE_LEASE ? &cached : nullptr)) {
+      WiFi.begin(device_config.wifi_ssid, device_config.wifi_password, cached.channel, cached.bssid);
+      const unsigned long start = millis();
+      while (millis() - start < WIFI_FAST_CONNECT_TIMEOUT_MS) {
+        if (WiFi.status() == WL_CONNECTED) {
+          finish_connected(true);
+          return true;
+        }
+        delay(20);
+      }
+    }
+
+    // The AP moved channel, went away or stopped answering: forget it and scan.
+    Logger.logLine("Fast connect failed - full scan");
+    wifi_cache_note_fast_miss();
+    wifi_cache_clear();
+  }
+  #endif
+
+  // === WiFi Hardware Reset Sequence ===
   // Full WiFi reset to clear stale state and prevent hardware corruption
   WiFi.disconnect(true);  // Disconnect + erase stored credentials
   delay(100);
@@ -412,72 +849,10 @@ bool connect_wifi() {
   // Enable auto-reconnect at WiFi stack level
   WiFi.setAutoReconnect(true);
 
-  // Prepare sanitized hostname
-  char sanitized[CONFIG_DEVICE_NAME_MAX_LEN];
-  config_manager_sanitize_device_name(device_config.device_name, sanitized, CONFIG_DEVICE_NAME_MAX_LEN);
-
-  // Set WiFi hostname for mDNS and internal use
-  // NOTE: ESP32's lwIP stack has limited DHCP Option 12 (hostname) support
-  // The hostname may not always appear in router DHCP tables due to ESP-IDF/lwIP limitations
-  // Use mDNS (.local) or NetBIOS for reliable device discovery instead
-  if (strlen(sanitized) > 0) {
-    // Set via WiFi library
-    WiFi.setHostname(sanitized);
-    Logger.logLinef("Hostname: %s", sanitized);
-
-    // Also set via esp_netif API (for compatibility)
-    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    if (netif != NULL) {
-      esp_netif_set_hostname(netif, sanitized);
-    }
-  }
-
-  // Configure fixed IP if provided
-  if (strlen(device_config.fixed_ip) > 0) {
-    Logger.logBegin("Fixed IP Config");
-
-    IPAddress local_ip, gateway, subnet, dns1, dns2;
-
-    if (!local_ip.fromString(device_config.fixed_ip)) {
-      Logger.logEnd("Invalid IP address");
-      Logger.logEnd("Connection failed");
-      return false;
-    }
-
-    if (!subnet.fromString(device_config.subnet_mask)) {
-      Logger.logEnd("Invalid subnet mask");
-      Logger.logEnd("Connection failed");
-      return false;
-    }
-
-    if (!gateway.fromString(device_config.gateway)) {
-      Logger.logEnd("Invalid gateway");
-      Logger.logEnd("Connection failed");
-      return false;
-    }
-
-    // DNS1: use provided, or default to gateway
-    if (strlen(device_config.dns1) > 0) {
-      dns1.fromString(device_config.dns1);
-    } else {
-      dns1 = gateway;
-    }
-
-    // DNS2: optional
-    if (strlen(device_config.dns2) > 0) {
-      dns2.fromString(device_config.dns2);
-    } else {
-      dns2 = IPAddress(0, 0, 0, 0);
-    }
-
-    if (!WiFi.config(local_ip, gateway, subnet, dns1, dns2)) {
-      Logger.logEnd("Configuration failed");
-      Logger.logEnd("Connection failed");
-      return false;
-    }
-
-    Logger.logLinef("IP: %s", device_config.fixed_ip);
-    Logger.logEnd();
+  if (!configure_sta(nullptr)) {
+    wifi_cache_note_connect(false, false, 0);
+    Logger.logEnd("Connection failed");
+    return false;
   }
 
   // Prefer the strongest AP when multiple BSSIDs exist for the same SSID.
@@ -501,16 +876,7 @@ bool connect_wifi() {
     while (millis() - start < backoff) {
       wl_status_t status = WiFi.status();
       if (status == WL_CONNECTED) {
-        Logger.logLinef("IP: %s", WiFi.localIP().toString().c_str());
-        Logger.logLinef("Hostname: %s", WiFi.getHostname());
-        Logger.logLinef("MAC: %s", WiFi.macAddress().c_str());
-        Logger.logLinef("Signal: %d dBm", WiFi.RSSI());
-        Logger.logLine("");
-        Logger.logLine("Access via:");
-        Logger.logLinef("  http://%s", WiFi.localIP().toString().c_str());
-        Logger.logLinef("  http://%s.local", WiFi.getHostname());
-        Logger.logEnd("Connected");
-
+        finish_connected(false);
         return true;
       }
       delay(100);
@@ -529,6 +895,7 @@ bool connect_wifi() {
     }
   }
 
+  wifi_cache_note_connect(false, false, 0);
   Logger.logEnd("All attempts failed");
   return false;
 }
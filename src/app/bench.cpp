@@ -0,0 +1,675 @@
+/*
+ * Bench Implementation
+ */
+
+#include "bench.h"
+
+#if BENCH_ENABLED
+
+#include "ducky_script.h"
+#include "fs_health.h"
+#include "heap_placement.h"
+#include "json_stream_writer.h"
+#include "log_manager.h"
+#include "../version.h"
+
+#if HAS_DISPLAY
+#include "display_manager.h"
+#endif
+
+#if HAS_DISPLAY && HAS_IMAGE_API
+#include "jpeg_engine.h"
+#include "jpeg_preflight.h"
+#include "lvgl_jpeg_decoder.h"
+#include "rgb888_pack.h"
+#endif
+
+#include <Arduino.h>
+#include <FFat.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <string.h>
+
+// The live macro config (defined in app.ino).
+extern MacroConfig macro_config;
+
+#define BENCH_STACK_BYTES 6144
+
+namespace {
+
+// Scratch file for the FFat read test; icon-sized random reads (a 32x32
+// RGB565+A8 icon is 3 KB).
+static const char* kFfatPath = "/bench.bin";
+static constexpr uint32_t kFfatFileBytes = 128 * 1024;
+static constexpr uint32_t kFfatChunkBytes = 4096;
+static constexpr uint32_t kFfatIconBytes = 3072;
+static constexpr uint32_t kFfatRandomReads = 64;
+
+// Representative macro: text, chords, media keys and a rate change, no DELAY.
+static const char kDuckyScript[] =
+    "GUI r\n"
+    "STRING notepad\n"
+    "ENTER\n"
+    "STRINGDELAY 5\n"
+    "STRING Hello from the macro pad. The quick brown fox jumps over the lazy dog.\n"
+    "CTRL SHIFT LEFTARROW\n"
+    "CTRL c\n"
+    "END\n"
+    "CTRL v\n"
+    "ALT TAB\n"
+    "VOLUMEUP\n"
+    "F5\n";
+static constexpr uint32_t kDuckyRounds = 200;
+
+// The full-frame decoder allocates its output; a few runs are enough.
+static constexpr uint32_t kJpegRuns = 4;
+
+struct FfatResult {
+    bool ran;
+    uint32_t file_bytes;
+    uint32_t write_us;
+    uint32_t seq_read_us;
+    uint32_t random_reads;
+    uint32_t random_read_bytes;
+    uint32_t random_read_us;
+};
+
+struct JpegFullResult {
+    bool ran;
+    int width;                 // decoded size
+    int height;
+    int scale;
+    uint32_t runs;
+    uint32_t us;
+    char error[48];
+};
+
+// One JPEG decoder engine decoding into RAM at the panel-fit scale.
+struct JpegEngineResult {
+    uint8_t id;                // JPEG_DECODER_*
+    int width;                 // decoded size
+    int height;
+    uint32_t runs;
+    uint32_t us;
+    char error[48];
+};
+
+// TJpgDec and the board's engine (the same one unless JPEG_DECODER says otherwise).
+static constexpr size_t kJpegEngineSlots = 2;
+
+struct DuckyResult {
+    uint32_t script_bytes;
+    uint32_t program_bytes;
+    uint32_t steps;
+    uint32_t rounds;
+    uint32_t compile_us;
+    uint32_t walk_us;
+};
+
+struct Results {
+    BenchDisplayResult display;
+    JpegFullResult jpeg_full;
+    JpegEngineResult jpeg_engines[kJpegEngineSlots];
+    uint8_t jpeg_engine_count;
+    FfatResult ffat;
+    bool macros_ok;
+    MacrosBenchResult macros;
+    DuckyResult ducky;
+};
+
+static volatile BenchState g_state = BenchState::Idle;
+static const char* volatile g_phase = nullptr;
+static TaskHandle_t g_task = nullptr;
+// The LVGL task holds bench_jpeg() until bench_display_done().
+static volatile bool g_display_pending = false;
+static uint32_t g_started_ms = 0;
+static uint32_t g_elapsed_ms = 0;
+static char g_message[64];
+
+static uint8_t* g_jpeg = nullptr;
+static size_t g_jpeg_len = 0;
+static int g_jpeg_width = 0;
+static int g_jpeg_height = 0;
+static int g_jpeg_scale = 0;  // panel-fit scale
+
+static Results g_results;
+
+static void set_err(char* err, size_t err_len, const char* msg) {
+    if (err && err_len) strlcpy(err, msg, err_len);
+}
+
+// Bytes -> MB/s, pixels -> MP/s.
+static float mega_per_s(uint64_t count, uint32_t us) {
+    return us ? (float)((double)count / (double)us) : 0.0f;
+}
+
+static float per_s(uint64_t count, uint32_t us) {
+    return us ? (float)((double)count * 1000000.0 / (double)us) : 0.0f;
+}
+
+static const char* driver_name() {
+    #if !HAS_DISPLAY
+    return "none";
+    #elif DISPLAY_DRIVER == DISPLAY_DRIVER_TFT_ESPI
+    return "tft_espi";
+    #elif DISPLAY_DRIVER == DISPLAY_DRIVER_ST7789V2
+    return "st7789v2";
+    #elif DISPLAY_DRIVER == DISPLAY_DRIVER_LOVYANGFX
+    return "lovyangfx";
+    #elif DISPLAY_DRIVER == DISPLAY_DRIVER_ARDUINO_GFX
+    return "arduino_gfx";
+    #elif DISPLAY_DRIVER == DISPLAY_DRIVER_ESP_PANEL
+    return "esp_panel";
+    #else
+    return "unknown";
+    #endif
+}
+
+static void run_display() {
+    BenchDisplayResult& r = g_results.display;
+    #if HAS_DISPLAY
+    if (!displayManager) {
+        r.skipped = "no display";
+        return;
+    }
+    g_display_pending = true;
+    (void)ulTaskNotifyTake(pdTRUE, 0);
+    if (!displayManager->queueBench()) {
+        g_display_pending = false;
+        r.skipped = "display queue full";
+        return;
+    }
+    // Frames are a few ms to a few tens of ms each; this only catches a stuck task.
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(30000)) == 0) {
+        r.skipped = "display timed out";
+    }
+    #else
+    r.skipped = "no display";
+    #endif
+}
+
+static void run_jpeg_full() {
+    JpegFullResult& r = g_results.jpeg_full;
+    #if HAS_DISPLAY && HAS_IMAGE_API && LV_USE_IMG
+    if (!g_jpeg) return;
+    r.ran = true;
+    for (uint32_t i = 0; i < kJpegRuns; i++) {
+        uint16_t* pixels = nullptr;
+        int scale = 0;
+        const uint32_t t0 = (uint32_t)esp_timer_get_time();
+        const bool ok = lvgl_jpeg_decode_to_rgb565(g_jpeg, g_jpeg_len, &pixels, &r.width, &r.height, &scale, r.error, sizeof(r.error));
+        const uint32_t dt = (uint32_t)esp_timer_get_time() - t0;
+        if (pixels) heap_caps_free(pixels);
+        if (!ok) return;
+        r.error[0] = '\0';
+        r.scale = scale;
+        r.us += dt;
+        r.runs++;
+    }
+    #endif
+}
+
+#if HAS_DISPLAY && HAS_IMAGE_API
+struct EngineFrame {
+    uint16_t* pixels;
+    int w;
+    int h;
+    Rgb888PackFn pack;
+};
+
+// Same conversion the image paths do: RGB888 blocks packed, RGB565 copied.
+static bool engine_frame_block(void* ctx, const JpegBlock& b) {
+    EngineFrame* f = (EngineFrame*)ctx;
+    if (b.x < 0 || b.y < 0 || b.x + b.w > f->w || b.y + b.h > f->h) return false;
+    for (int row = 0; row < b.h; row++) {
+        uint16_t* dst = f->pixels + (size_t)(b.y + row) * (size_t)f->w + (size_t)b.x;
+        if (b.format == JpegPixels::Rgb565) {
+            memcpy(dst, (const uint16_t*)b.pixels + (size_t)row * (size_t)b.stride, (size_t)b.w * 2);
+        } else {
+            f->pack((const uint8_t*)b.pixels + (size_t)row * (size_t)b.stride * 3, dst, (size_t)b.w);
+        }
+    }
+    return true;
+}
+
+static void run_jpeg_engine(JpegEngineResult& r) {
+    const int div = 1 << g_jpeg_scale;
+    r.width = (g_jpeg_width + div - 1) / div;
+    r.height = (g_jpeg_height + div - 1) / div;
+
+    JpegEngine* engine = jpeg_engine_create(r.id);
+    if (!engine) {
+        set_err(r.error, sizeof(r.error), "out of memory");
+        return;
+    }
+    if (!jpeg_engine_can(engine, false, (uint8_t)g_jpeg_scale)) {
+        set_err(r.error, sizeof(r.error), "cannot scale");
+        jpeg_engine_destroy(engine);
+        return;
+    }
+    const size_t bytes = (size_t)r.width * (size_t)r.height * 2;
+    uint16_t* pixels = (uint16_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Image, bytes);
+    if (!pixels) {
+        set_err(r.error, sizeof(r.error), "out of memory");
+        jpeg_engine_destroy(engine);
+        return;
+    }
+
+    EngineFrame frame = {pixels, r.width, r.height, rgb888_pack_kernel(false, false)};
+    for (uint32_t i = 0; i < kJpegRuns; i++) {
+        JpegEngineInput input;
+        input.data = g_jpeg;
+        input.size = g_jpeg_len;
+        uint16_t w = 0;
+        uint16_t h = 0;
+        const uint32_t t0 = (uint32_t)esp_timer_get_time();
+        const bool ok = engine->prepare(&input, &w, &h, r.error, sizeof(r.error)) &&
+                        engine->decode((uint8_t)g_jpeg_scale, false, engine_frame_block, &frame, r.error, sizeof(r.error));
+        const uint32_t dt = (uint32_t)esp_timer_get_time() - t0;
+        if (!ok) break;
+        r.error[0] = '\0';
+        r.us += dt;
+        r.runs++;
+    }
+    heap_tag_free(HeapTag::Image, pixels);
+    jpeg_engine_destroy(engine);
+}
+#endif
+
+static void run_jpeg_engines() {
+    #if HAS_DISPLAY && HAS_IMAGE_API
+    if (!g_jpeg) return;
+    g_results.jpeg_engines[g_results.jpeg_engine_count++].id = JPEG_DECODER_TJPGD_ROM;
+    if (JPEG_DECODER != JPEG_DECODER_TJPGD_ROM) {
+        g_results.jpeg_engines[g_results.jpeg_engine_count++].id = JPEG_DECODER;
+    }
+    for (uint8_t i = 0; i < g_results.jpeg_engine_count; i++) {
+        run_jpeg_engine(g_results.jpeg_engines[i]);
+    }
+    #endif
+}
+
+static void run_ffat() {
+    FfatResult& r = g_results.ffat;
+    FSHealthStats fs;
+    fs_health_get(&fs);
+    if (!fs.ffat_mounted) return;
+
+    uint8_t* buf = (uint8_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Other, kFfatChunkBytes);
+    if (!buf) return;
+    uint32_t seed = 0x2545F491u;
+    for (uint32_t i = 0; i < kFfatChunkBytes; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        buf[i] = (uint8_t)(seed >> 24);
+    }
+
+    File f = FFat.open(kFfatPath, FILE_WRITE);
+    if (!f) {
+        heap_tag_free(HeapTag::Other, buf);
+        return;
+    }
+    uint32_t t0 = (uint32_t)esp_timer_get_time();
+    uint32_t written = 0;
+    while (written < kFfatFileBytes && f.write(buf, kFfatChunkBytes) == kFfatChunkBytes) {
+        written += kFfatChunkBytes;
+    }
+    f.flush();
+    f.close();
+    r.write_us = (uint32_t)esp_timer_get_time() - t0;
+    fs_health_note_ffat_file(0, written);
+
+    if (written == kFfatFileBytes) {
+        f = FFat.open(kFfatPath, FILE_READ);
+        if (f) {
+            t0 = (uint32_t)esp_timer_get_time();
+            uint32_t read = 0;
+            while (read < kFfatFileBytes && f.read(buf, kFfatChunkBytes) == kFfatChunkBytes) {
+                read += kFfatChunkBytes;
+            }
+            r.seq_read_us = (uint32_t)esp_timer_get_time() - t0;
+
+            // Fixed sequence, so runs on different boards read the same offsets.
+            seed = 12345u;
+            t0 = (uint32_t)esp_timer_get_time();
+            for (uint32_t i = 0; i < kFfatRandomReads; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                const uint32_t off = (seed >> 8) % (kFfatFileBytes - kFfatIconBytes);
+                if (!f.seek(off) || f.read(buf, kFfatIconBytes) != kFfatIconBytes) break;
+                r.random_reads++;
+            }
+            r.random_read_us = (uint32_t)esp_timer_get_time() - t0;
+            r.random_read_bytes = r.random_reads * kFfatIconBytes;
+            f.close();
+            r.ran = read == kFfatFileBytes;
+            r.file_bytes = read;
+        }
+    }
+
+    if (FFat.remove(kFfatPath)) fs_health_note_ffat_file(written, 0);
+    heap_tag_free(HeapTag::Other, buf);
+}
+
+static void run_ducky() {
+    DuckyResult& r = g_results.ducky;
+    uint8_t program[DUCKY_PROGRAM_MAX_LEN];
+    size_t len = 0;
+    r.script_bytes = sizeof(kDuckyScript) - 1;
+
+    uint32_t t0 = (uint32_t)esp_timer_get_time();
+    for (uint32_t i = 0; i < kDuckyRounds; i++) {
+        if (!ducky_compile(kDuckyScript, program, sizeof(program), &len, nullptr, 0)) return;
+    }
+    r.compile_us = (uint32_t)esp_timer_get_time() - t0;
+    r.program_bytes = (uint32_t)len;
+
+    volatile size_t steps = 0;
+    t0 = (uint32_t)esp_timer_get_time();
+    for (uint32_t i = 0; i < kDuckyRounds; i++) {
+        steps = ducky_program_steps(program, len);
+    }
+    r.walk_us = (uint32_t)esp_timer_get_time() - t0;
+    r.steps = (uint32_t)steps;
+    r.rounds = kDuckyRounds;
+}
+
+static void bench_task_fn(void*) {
+    const uint32_t t0 = millis();
+    Logger.logMessage("Bench", "Run started");
+
+    g_phase = "display";
+    run_display();
+    g_phase = "jpeg";
+    run_jpeg_full();
+    run_jpeg_engines();
+    g_phase = "ffat";
+    run_ffat();
+    g_phase = "macros";
+    g_results.macros_ok = macros_config_bench(&macro_config, &g_results.macros);
+    g_phase = "ducky";
+    run_ducky();
+
+    g_elapsed_ms = millis() - t0;
+    g_phase = nullptr;
+
+    BenchState state = BenchState::Done;
+    if (g_display_pending) {
+        // The LVGL task may still read the JPEG; the next start frees it.
+        state = BenchState::Failed;
+        strlcpy(g_message, "Display benchmark did not finish", sizeof(g_message));
+    } else if (g_jpeg) {
+        heap_tag_free(HeapTag::Image, g_jpeg);
+        g_jpeg = nullptr;
+        g_jpeg_len = 0;
+    }
+
+    Logger.logMessagef("Bench", "Run finished in %lu ms", (unsigned long)g_elapsed_ms);
+    g_task = nullptr;
+    __atomic_store_n(&g_state, state, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
+}
+
+static void write_display(JsonStreamObject& root) {
+    const BenchDisplayResult& r = g_results.display;
+    JsonStreamObject d = root.createNestedObject("display");
+    d["driver"] = driver_name();
+    d["ran"] = r.ran;
+    if (!r.ran) {
+        d["skipped"] = r.skipped ? r.skipped : "not run";
+        return;
+    }
+    d["width"] = r.width;
+    d["height"] = r.height;
+    d["frames"] = r.frames;
+
+    const uint64_t frameBytes = (uint64_t)r.width * r.height * 2u;
+    JsonStreamObject fill = d.createNestedObject("fill");
+    fill["frame_us"] = r.fill_us / r.frames;
+    fill["mb_per_s"] = mega_per_s(frameBytes * r.frames, r.fill_us);
+
+    JsonStreamObject flush = d.createNestedObject("flush");
+    flush["frame_us"] = r.flush_us / r.frames;
+    flush["mb_per_s"] = mega_per_s(frameBytes * r.frames, r.flush_us);
+    flush["fps"] = per_s(r.frames, r.flush_us);
+
+    JsonStreamObject redraw = d.createNestedObject("redraw");
+    redraw["frame_us"] = r.redraw_us / r.frames;
+    redraw["mb_per_s"] = mega_per_s(frameBytes * r.frames, r.redraw_us);
+    redraw["fps"] = per_s(r.frames, r.redraw_us);
+
+    JsonStreamArray templates = d.createNestedArray("templates");
+    for (size_t i = 0; i < BENCH_TEMPLATE_COUNT; i++) {
+        if (!r.template_us[i]) continue;
+        JsonStreamObject t = templates.createNestedObject();
+        t["id"] = macro_templates::id_for((macro_templates::TemplateKind)i);
+        t["frame_us"] = r.template_us[i] / r.frames;
+        t["fps"] = per_s(r.frames, r.template_us[i]);
+    }
+}
+
+static void write_jpeg(JsonStreamObject& root) {
+    JsonStreamObject j = root.createNestedObject("jpeg");
+    if (!g_jpeg_width) {
+        #if HAS_DISPLAY && HAS_IMAGE_API
+        j["skipped"] = "no JPEG posted";
+        #else
+        j["skipped"] = "image API disabled";
+        #endif
+        return;
+    }
+    j["width"] = g_jpeg_width;
+    j["height"] = g_jpeg_height;
+
+    const BenchDisplayResult& d = g_results.display;
+    JsonStreamObject strip = j.createNestedObject("strip");
+    if (d.strip_runs) {
+        strip["runs"] = d.strip_runs;
+        strip["pixels"] = d.strip_pixels;
+        strip["us"] = d.strip_us / d.strip_runs;
+        strip["mp_per_s"] = mega_per_s((uint64_t)d.strip_pixels * d.strip_runs, d.strip_us);
+    } else {
+        strip["skipped"] = d.ran ? "decode failed" : "display not run";
+    }
+
+    const JpegFullResult& f = g_results.jpeg_full;
+    JsonStreamObject full = j.createNestedObject("full_frame");
+    if (f.runs) {
+        full["runs"] = f.runs;
+        full["width"] = f.width;
+        full["height"] = f.height;
+        full["scale"] = f.scale;
+        full["us"] = f.us / f.runs;
+        full["mp_per_s"] = mega_per_s((uint64_t)f.width * f.height * f.runs, f.us);
+    } else if (f.ran) {
+        full["skipped"] = f.error[0] ? f.error : "decode failed";
+    } else {
+        full["skipped"] = "LVGL image support disabled";
+    }
+
+    JsonStreamArray engines = j.createNestedArray("engines");
+    for (uint8_t i = 0; i < g_results.jpeg_engine_count; i++) {
+        const JpegEngineResult& e = g_results.jpeg_engines[i];
+        JsonStreamObject o = engines.createNestedObject();
+        o["name"] = jpeg_engine_name(e.id);
+        if (!e.runs) {
+            o["skipped"] = e.error[0] ? e.error : "decode failed";
+            continue;
+        }
+        o["runs"] = e.runs;
+        o["width"] = e.width;
+        o["height"] = e.height;
+        o["us"] = e.us / e.runs;
+        o["mp_per_s"] = mega_per_s((uint64_t)e.width * e.height * e.runs, e.us);
+    }
+}
+
+static void write_ffat(JsonStreamObject& root) {
+    const FfatResult& r = g_results.ffat;
+    JsonStreamObject f = root.createNestedObject("ffat");
+    if (!r.ran) {
+        f["skipped"] = "FFat not mounted or write failed";
+        return;
+    }
+    f["file_bytes"] = r.file_bytes;
+    f["write_mb_per_s"] = mega_per_s(r.file_bytes, r.write_us);
+    f["seq_read_mb_per_s"] = mega_per_s(r.file_bytes, r.seq_read_us);
+    f["random_reads"] = r.random_reads;
+    f["random_read_bytes"] = kFfatIconBytes;
+    f["random_read_us"] = r.random_reads ? r.random_read_us / r.random_reads : 0;
+    f["random_read_mb_per_s"] = mega_per_s(r.random_read_bytes, r.random_read_us);
+}
+
+static void write_macros(JsonStreamObject& root) {
+    const MacrosBenchResult& r = g_results.macros;
+    JsonStreamObject m = root.createNestedObject("macros");
+    if (!g_results.macros_ok) {
+        m["skipped"] = "encode failed (out of memory)";
+        return;
+    }
+    m["encoded_bytes"] = r.encoded_bytes;
+    m["encode_us"] = r.encode_us;
+    m["decode_us"] = r.decode_us;
+    JsonStreamObject ffat = m.createNestedObject("ffat");
+    ffat["ok"] = r.ffat_ok;
+    ffat["save_us"] = r.ffat_save_us;
+    ffat["load_us"] = r.ffat_load_us;
+    JsonStreamObject nvs = m.createNestedObject("nvs");
+    nvs["ok"] = r.nvs_ok;
+    nvs["save_us"] = r.nvs_save_us;
+    nvs["load_us"] = r.nvs_load_us;
+}
+
+static void write_ducky(JsonStreamObject& root) {
+    const DuckyResult& r = g_results.ducky;
+    JsonStreamObject d = root.createNestedObject("ducky");
+    if (!r.rounds) {
+        d["skipped"] = "compile failed";
+        return;
+    }
+    d["script_bytes"] = r.script_bytes;
+    d["program_bytes"] = r.program_bytes;
+    d["steps"] = r.steps;
+    d["compile_us"] = r.compile_us / r.rounds;
+    d["compile_kb_per_s"] = per_s((uint64_t)r.script_bytes * r.rounds, r.compile_us) / 1024.0f;
+    d["walk_steps_per_s"] = per_s((uint64_t)r.steps * r.rounds, r.walk_us);
+}
+
+} // namespace
+
+BenchState bench_get_state(const char** phase) {
+    if (phase) *phase = g_phase;
+    return __atomic_load_n(&g_state, __ATOMIC_ACQUIRE);
+}
+
+bool bench_start(const uint8_t* jpeg, size_t jpeg_len, char* err, size_t err_len) {
+    set_err(err, err_len, "");
+    if (__atomic_load_n(&g_state, __ATOMIC_ACQUIRE) == BenchState::Running || g_display_pending) {
+        set_err(err, err_len, "Benchmark in progress");
+        return false;
+    }
+
+    if (g_jpeg) {
+        heap_tag_free(HeapTag::Image, g_jpeg);
+        g_jpeg = nullptr;
+        g_jpeg_len = 0;
+    }
+    memset(&g_results, 0, sizeof(g_results));
+    g_jpeg_width = 0;
+    g_jpeg_height = 0;
+    g_jpeg_scale = 0;
+    g_message[0] = '\0';
+
+    if (jpeg && jpeg_len) {
+        #if HAS_DISPLAY && HAS_IMAGE_API
+        // Both paths decode at the largest scale that fits the panel.
+        int panelW = DISPLAY_WIDTH;
+        int panelH = DISPLAY_HEIGHT;
+        if (displayManager && displayManager->getDriver()) {
+            panelW = displayManager->getDriver()->width();
+            panelH = displayManager->getDriver()->height();
+        }
+        if (!jpeg_preflight_tjpgd_fit_supported(jpeg, jpeg_len, panelW, panelH, &g_jpeg_scale, err, err_len) ||
+            !jpeg_read_dimensions(jpeg, jpeg_len, &g_jpeg_width, &g_jpeg_height)) {
+            g_jpeg_width = 0;
+            g_jpeg_height = 0;
+            return false;
+        }
+        #else
+        set_err(err, err_len, "Image API disabled in this build");
+        return false;
+        #endif
+        g_jpeg = (uint8_t*)heap_place_malloc(HeapClass::Bulk, HeapTag::Image, jpeg_len);
+        if (!g_jpeg) {
+            set_err(err, err_len, "Out of memory");
+            return false;
+        }
+        memcpy(g_jpeg, jpeg, jpeg_len);
+        g_jpeg_len = jpeg_len;
+    }
+
+    g_started_ms = millis();
+    g_elapsed_ms = 0;
+    __atomic_store_n(&g_state, BenchState::Running, __ATOMIC_RELEASE);
+    if (xTaskCreate(bench_task_fn, "Bench", BENCH_STACK_BYTES, nullptr, tskIDLE_PRIORITY + 1, &g_task) != pdPASS) {
+        g_task = nullptr;
+        __atomic_store_n(&g_state, BenchState::Failed, __ATOMIC_RELEASE);
+        strlcpy(g_message, "Failed to start benchmark task", sizeof(g_message));
+        set_err(err, err_len, g_message);
+        return false;
+    }
+    return true;
+}
+
+void bench_write_json(JsonStreamObject& root) {
+    const BenchState state = __atomic_load_n(&g_state, __ATOMIC_ACQUIRE);
+    switch (state) {
+        case BenchState::Running: root["state"] = "running"; break;
+        case BenchState::Done: root["state"] = "done"; break;
+        case BenchState::Failed: root["state"] = "failed"; break;
+        default: root["state"] = "idle"; break;
+    }
+    if (state == BenchState::Running) {
+        const char* phase = g_phase;
+        root["phase"] = phase ? phase : "starting";
+        root["elapsed_ms"] = (uint32_t)(millis() - g_started_ms);
+        return;
+    }
+    if (g_message[0]) root["message"] = g_message;
+    if (state == BenchState::Idle) return;
+
+    root["version"] = FIRMWARE_VERSION;
+    #ifdef BUILD_BOARD_NAME
+    root["board_name"] = BUILD_BOARD_NAME;
+    #else
+    root["board_name"] = "unknown";
+    #endif
+    root["chip_model"] = ESP.getChipModel();
+    root["cpu_freq"] = ESP.getCpuFreqMHz();
+    root["psram_size"] = ESP.getPsramSize();
+    root["elapsed_ms"] = g_elapsed_ms;
+
+    write_display(root);
+    write_jpeg(root);
+    write_ffat(root);
+    write_macros(root);
+    write_ducky(root);
+}
+
+BenchDisplayResult* bench_display_result() {
+    return &g_results.display;
+}
+
+const uint8_t* bench_jpeg(size_t* out_len) {
+    if (out_len) *out_len = g_jpeg_len;
+    return g_jpeg;
+}
+
+void bench_display_done() {
+    g_display_pending = false;
+    TaskHandle_t task = g_task;
+    if (task) xTaskNotifyGive(task);
+}
+
+#endif // BENCH_ENABLED
@@ -0,0 +1,88 @@
+/*
+ * Bench
+ *
+ * On-device benchmark suite (BENCH_ENABLED), for per-board, per-release
+ * performance fingerprints. One run measures:
+ *   display  fullscreen solid fill and flush through the driver, full-screen
+ *            LVGL redraws (render + flush), and the redraw time of a macro
+ *            screen under each template
+ *   jpeg     TJpgDec decode of a posted JPEG through the strip path
+ *            (StripDecoder onto the panel) and the full-frame path
+ *            (lvgl_jpeg_decode_to_rgb565 into RAM)
+ *   ffat     sequential and icon-sized random reads of a scratch file
+ *   macros   encode/decode of the live macro config and a save + load
+ *            through FFat and NVS (macros_config_bench)
+ *   ducky    DuckyScript compile, and a walk of the compiled program
+ *
+ * POST /api/bench starts a run (optional image/jpeg body for the decode
+ * tests), GET /api/bench returns the state and, once done, the results. A
+ * long press on the test screen starts a run too.
+ *
+ * The run has its own task. The display part runs on the LVGL task
+ * (DisplayCommandType::RunBench) and freezes the UI for a second or two;
+ * it is skipped while the panel sleeps or shows a direct image.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if BENCH_ENABLED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macro_templates.h"
+#include "macros_config.h"
+
+class JsonStreamObject;
+
+enum class BenchState : uint8_t {
+    Idle = 0,
+    Running = 1,
+    Done = 2,
+    Failed = 3,
+};
+
+static constexpr size_t BENCH_TEMPLATE_COUNT = (size_t)macro_templates::TemplateKind::Count;
+
+// Filled on the LVGL task by DisplayManager.
+struct BenchDisplayResult {
+    bool ran;
+    const char* skipped;         // reason when !ran
+    uint16_t width;              // driver coordinate space
+    uint16_t height;
+    uint16_t frames;             // per measurement
+
+    // Solid fullscreen frames: filling the draw buffer (CPU, scaled to the
+    // panel) and pushing it band by band (setAddrWindow + pushColors).
+    uint32_t fill_us;
+    uint32_t flush_us;
+    // lv_obj_invalidate(screen) + lv_refr_now() of the screen shown at the start.
+    uint32_t redraw_us;
+
+    // The same for macro screen 1 under each template (0 = not measured).
+    uint32_t template_us[BENCH_TEMPLATE_COUNT];
+
+    // StripDecoder::decode_fit of the posted JPEG, centered on the panel.
+    uint16_t strip_runs;
+    uint32_t strip_us;
+    uint32_t strip_pixels;       // decoded pixels per run
+};
+
+// State and current phase name (nullptr when not running).
+BenchState bench_get_state(const char** phase = nullptr);
+
+// Starts a run. jpeg (may be nullptr) is copied. False with a message when a
+// run is in progress or memory is short. Any task.
+bool bench_start(const uint8_t* jpeg, size_t jpeg_len, char* err, size_t err_len);
+
+// GET /api/bench body.
+void bench_write_json(JsonStreamObject& root);
+
+// LVGL task side (DisplayManager::runBench).
+BenchDisplayResult* bench_display_result();
+const uint8_t* bench_jpeg(size_t* out_len);
+void bench_display_done();
+
+#endif // BENCH_ENABLED
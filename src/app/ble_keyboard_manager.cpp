@@ -1,42 +1,350 @@
 #include "ble_keyboard_manager.h"
+#include "boot_profile.h"
+#include "power_manager.h"
+#include "loop_scheduler.h"
+#include "ota_quiet.h"
+#include "memory_pressure.h"
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/timers.h>
+#include <freertos/semphr.h>
 
 #if BLE_KEYBOARD_MANAGER_ENABLED
 #include <esp_bt.h>
+#include <esp_heap_caps.h>
+#include <esp_mac.h>
+#include <NimBLEDevice.h>
+#include <Preferences.h>
 #endif
 
 #include <string>
 
-void BleKeyboardManager::begin(const DeviceConfig* config) {
+static BleTypingStats g_typing_stats = {};
+static portMUX_TYPE g_typing_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void ble_keyboard_get_typing_stats(BleTypingStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_typing_stats_mux);
+    *out = g_typing_stats;
+    portEXIT_CRITICAL(&g_typing_stats_mux);
+}
+
+// Connection parameter and stack state, shared by the NimBLE host task
+// (callbacks), the relax timer, the main loop and the callers of
+// requestLowLatency(); guarded by g_link_mux.
+static BleLinkStats g_link = {};
+static BleStackStats g_stack = {};
+static portMUX_TYPE g_link_mux = portMUX_INITIALIZER_UNLOCKED;
+
 #if BLE_KEYBOARD_MANAGER_ENABLED
-    if (keyboard) {
+static uint32_t g_link_activity_ms = 0;
+static BleKeyboard* g_link_keyboard = nullptr;
+static TimerHandle_t g_relax_timer = nullptr;
+
+// Held while the stack is started or stopped, and by anything outside the
+// macro executor that touches the keyboard object (the relax timer, telemetry,
+// requestLowLatency). The executor pins the stack with acquire() instead.
+static SemaphoreHandle_t g_stack_mutex = nullptr;
+// Guarded by g_stack_mutex.
+static uint8_t g_stack_users = 0;
+static uint32_t g_stack_activity_ms = 0;
+static volatile bool g_stack_start_requested = false;
+
+// Leave the host's parameters alone while it discovers services and bonds.
+static constexpr uint32_t kConnectSettleMs = 10000;
+// Supervision timeouts (10 ms units); comfortably above interval * (latency + 1) * 3.
+static constexpr uint16_t kFastTimeout = 200;
+static constexpr uint16_t kIdleTimeout = 400;
+
+static void link_request(BleLinkMode mode) {
+    bool ok;
+    if (mode == BleLinkMode::Fast) {
+        ok = g_link_keyboard->requestConnParams(BLE_KEYBOARD_FAST_INTERVAL_MIN, BLE_KEYBOARD_FAST_INTERVAL_MAX, 0, kFastTimeout);
+    } else {
+        ok = g_link_keyboard->requestConnParams(BLE_KEYBOARD_IDLE_INTERVAL_MIN, BLE_KEYBOARD_IDLE_INTERVAL_MAX,
+                                                BLE_KEYBOARD_IDLE_LATENCY, kIdleTimeout);
+    }
+    if (!ok) return;
+    portENTER_CRITICAL(&g_link_mux);
+    g_link.mode = mode;
+    g_link.requests++;
+    portEXIT_CRITICAL(&g_link_mux);
+}
+
+static void relax_timer_cb(TimerHandle_t timer) {
+    // Busy (a start/stop also stops this timer, so retrying is harmless).
+    if (xSemaphoreTake(g_stack_mutex, 0) != pdTRUE) {
+        xTimerChangePeriod(timer, pdMS_TO_TICKS(100), 0);
         return;
     }
+    struct Unlock { ~Unlock() { xSemaphoreGive(g_stack_mutex); } } unlock;
 
-    // We only use BLE HID. Release Classic BT controller memory to reclaim internal RAM.
-    // Must be called before the controller is initialized by the BLE stack.
-    static bool classicBtReleased = false;
-    if (!classicBtReleased) {
-        const esp_err_t err = esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT);
-        Logger.logMessagef("BLE", "Classic BT mem release: %s (%d)", (err == ESP_OK) ? "OK" : "ERR", (int)err);
-        classicBtReleased = true;
+    if (!g_link_keyboard || !g_link_keyboard->isConnected()) return;
+
+    // A long macro keeps sending reports; hold the fast interval until it goes quiet.
+    portENTER_CRITICAL(&g_link_mux);
+    uint32_t last = g_link_activity_ms;
+    portEXIT_CRITICAL(&g_link_mux);
+    const uint32_t lastReport = g_link_keyboard->lastReportMillis();
+    if ((int32_t)(lastReport - last) > 0) last = lastReport;
+
+    const uint32_t quiet = millis() - last;
+    if (quiet < BLE_KEYBOARD_FAST_HOLD_MS) {
+        const TickType_t ticks = pdMS_TO_TICKS(BLE_KEYBOARD_FAST_HOLD_MS - quiet);
+        xTimerChangePeriod(timer, ticks ? ticks : 1, 0);
+        return;
     }
+    link_request(BleLinkMode::Idle);
+}
 
-    const char* name = (config && strlen(config->device_name) > 0) ? config->device_name : "ESP32-Keyboard";
+static void relax_timer_arm(uint32_t ms) {
+    if (!g_relax_timer) return;
+    const TickType_t ticks = pdMS_TO_TICKS(ms);
+    xTimerChangePeriod(g_relax_timer, ticks ? ticks : 1, 0);   // also starts it
+}
+#endif
 
-    keyboard = new BleKeyboard(std::string(name), "Espressif", 100);
+// ===== Host profiles =====
+// Profile 0 advertises with the public address, profile n with a random
+// static address derived from it, so every host bonds with its own identity
+// and only finds the keyboard while its profile is active. The bonded peer
+// of each profile is kept in NVS; the keys themselves are in NimBLE's store.
 
-    keyboard->onConnect([]() {
-        Logger.logMessage("BLE", "Keyboard connected");
-    });
-    keyboard->onDisconnect([]() {
-        Logger.logMessage("BLE", "Keyboard disconnected");
-    });
+static_assert(BLE_KEYBOARD_HOST_PROFILES >= 1 && BLE_KEYBOARD_HOST_PROFILES <= 8, "BLE_KEYBOARD_HOST_PROFILES must be 1-8");
 
-    Logger.logMessagef("BLE", "Starting BLE keyboard: %s", name);
-    keyboard->begin();
+struct HostSlot {
+    uint8_t peer[6];      // NimBLE byte order
+    uint8_t peer_type;
+    uint8_t bonded;
+};
+
+static HostSlot g_host_slots[BLE_KEYBOARD_HOST_PROFILES] = {};
+static BleHostStats g_hosts = {0, BLE_KEYBOARD_HOST_PROFILES, false, false, 0, 0};   // guarded by g_link_mux
+static uint32_t g_host_switch_started_ms = 0;     // guarded by g_link_mux
+static volatile int8_t g_host_select_pending = -1;
+static volatile uint8_t g_host_forget_pending = 0; // bit per profile
+
+#if BLE_KEYBOARD_MANAGER_ENABLED
+static Preferences g_host_prefs;
+static constexpr const char* kHostNamespace = "ble_hosts";
+
+static bool g_host_auth_pending = false;          // guarded by g_link_mux
+static uint8_t g_host_auth_peer[6] = {};
+static uint8_t g_host_auth_type = 0;
+static bool g_host_auth_bonded = false;
+
+// Own address of a profile in NimBLE byte order (little-endian); false for the public one.
+static bool host_own_address(uint8_t index, uint8_t out[6]) {
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_BT);
+    for (int i = 0; i < 6; i++) out[i] = mac[5 - i];
+    if (index == 0) return false;
+    out[0] ^= index;
+    out[5] |= 0xC0;   // random static
+    return true;
+}
+
+static void format_address(const uint8_t le[6], char* out, size_t out_len) {
+    snprintf(out, out_len, "%02x:%02x:%02x:%02x:%02x:%02x", le[5], le[4], le[3], le[2], le[1], le[0]);
+}
+
+static void hosts_load() {
+    if (!g_host_prefs.begin(kHostNamespace, true)) return;
+    uint8_t active = g_host_prefs.getUChar("active", 0);
+    if (g_host_prefs.getBytesLength("slots") == sizeof(g_host_slots)) {
+        g_host_prefs.getBytes("slots", g_host_slots, sizeof(g_host_slots));
+    }
+    g_host_prefs.end();
+    if (active >= BLE_KEYBOARD_HOST_PROFILES) active = 0;
+    portENTER_CRITICAL(&g_link_mux);
+    g_hosts.active = active;
+    portEXIT_CRITICAL(&g_link_mux);
+}
+
+static void hosts_save() {
+    if (!g_host_prefs.begin(kHostNamespace, false)) return;
+    g_host_prefs.putUChar("active", g_hosts.active);
+    g_host_prefs.putBytes("slots", g_host_slots, sizeof(g_host_slots));
+    g_host_prefs.end();
+}
+
+// A bond can be shared by profiles (the same host paired twice); only delete
+// it from NimBLE's store when no other profile uses it.
+static void hosts_delete_bond(uint8_t index) {
+    HostSlot& slot = g_host_slots[index];
+    if (!slot.bonded) return;
+    bool shared = false;
+    for (uint8_t i = 0; i < BLE_KEYBOARD_HOST_PROFILES; i++) {
+        if (i != index && g_host_slots[i].bonded && memcmp(g_host_slots[i].peer, slot.peer, 6) == 0) shared = true;
+    }
+    if (!shared) NimBLEDevice::deleteBond(NimBLEAddress(slot.peer, slot.peer_type));
+    memset(&slot, 0, sizeof(slot));
+}
+
+static void hosts_apply_identity(BleKeyboard* kb, bool switching) {
+    const uint8_t index = g_hosts.active;
+    uint8_t own[6];
+    const bool random = host_own_address(index, own);
+    const HostSlot& slot = g_host_slots[index];
+    const NimBLEAddress peer(slot.peer, slot.peer_type);
+    const NimBLEAddress* target = slot.bonded ? &peer : nullptr;
+    if (switching) {
+        kb->switchIdentity(random ? own : nullptr, target);
+    } else {
+        kb->setIdentity(random ? own : nullptr, target);
+    }
+}
+
+// Main loop, holding g_stack_mutex: apply pairing results, forgets and switches.
+static void hosts_service(BleKeyboard* kb) {
+    bool dirty = false;
+
+    portENTER_CRITICAL(&g_link_mux);
+    const bool auth = g_host_auth_pending;
+    g_host_auth_pending = false;
+    uint8_t peer[6];
+    memcpy(peer, g_host_auth_peer, 6);
+    const uint8_t peerType = g_host_auth_type;
+    const bool bonded = g_host_auth_bonded;
+    portEXIT_CRITICAL(&g_link_mux);
+
+    if (auth && bonded) {
+        HostSlot& slot = g_host_slots[g_hosts.active];
+        if (!slot.bonded || memcmp(slot.peer, peer, 6) != 0) {
+            // A new host took this profile; the previous one has to pair again.
+            hosts_delete_bond(g_hosts.active);
+            memcpy(slot.peer, peer, 6);
+            slot.peer_type = peerType;
+            slot.bonded = 1;
+            dirty = true;
+            char text[18];
+            format_address(peer, text, sizeof(text));
+            Logger.logMessagef("BLE", "Host profile %u bonded to %s", (unsigned)g_hosts.active + 1, text);
+        }
+    }
+
+    portENTER_CRITICAL(&g_link_mux);
+    const uint8_t forget = g_host_forget_pending;
+    g_host_forget_pending = 0;
+    portEXIT_CRITICAL(&g_link_mux);
+    for (uint8_t i = 0; i < BLE_KEYBOARD_HOST_PROFILES; i++) {
+        if (!(forget & (1u << i)) || !g_host_slots[i].bonded) continue;
+        hosts_delete_bond(i);
+        dirty = true;
+        Logger.logMessagef("BLE", "Host profile %u forgotten", (unsigned)i + 1);
+    }
+
+    const int8_t select = g_host_select_pending;
+    if (select >= 0) {
+        g_host_select_pending = -1;
+        if ((uint8_t)select != g_hosts.active) {
+            const bool directed = g_host_slots[select].bonded != 0;
+            portENTER_CRITICAL(&g_link_mux);
+            g_hosts.active = (uint8_t)select;
+            g_hosts.switching = kb != nullptr;
+            g_hosts.last_switch_directed = directed;
+            portEXIT_CRITICAL(&g_link_mux);
+            dirty = true;
+            Logger.logMessagef("BLE", "Switching to host profile %u%s", (unsigned)select + 1, directed ? " (directed)" : "");
+            if (kb) hosts_apply_identity(kb, true);
+        }
+    }
+
+    if (dirty) hosts_save();
+}
+#endif
+
+void ble_keyboard_get_host_stats(BleHostStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_link_mux);
+    *out = g_hosts;
+    portEXIT_CRITICAL(&g_link_mux);
+}
+
+bool ble_keyboard_get_host_profile(uint8_t index, BleHostProfileInfo* out) {
+    if (!out || index >= BLE_KEYBOARD_HOST_PROFILES) return false;
+    memset(out, 0, sizeof(*out));
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    uint8_t own[6];
+    (void)host_own_address(index, own);
+    format_address(own, out->own_address, sizeof(out->own_address));
+    portENTER_CRITICAL(&g_link_mux);
+    const HostSlot slot = g_host_slots[index];   // written by the main loop
+    portEXIT_CRITICAL(&g_link_mux);
+    out->bonded = slot.bonded != 0;
+    if (out->bonded) format_address(slot.peer, out->peer_address, sizeof(out->peer_address));
+#endif
+    return true;
+}
+
+bool ble_keyboard_select_host(uint8_t index) {
+    if (index >= BLE_KEYBOARD_HOST_PROFILES) return false;
+    portENTER_CRITICAL(&g_link_mux);
+    g_host_switch_started_ms = millis();
+    portEXIT_CRITICAL(&g_link_mux);
+    g_host_select_pending = (int8_t)index;
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    if (BLE_KEYBOARD_ON_DEMAND) {
+        g_stack_start_requested = true;
+        loop_scheduler_notify();
+    }
+#endif
+    return true;
+}
+
+bool ble_keyboard_forget_host(uint8_t index) {
+    if (index >= BLE_KEYBOARD_HOST_PROFILES) return false;
+    portENTER_CRITICAL(&g_link_mux);
+    g_host_forget_pending |= (uint8_t)(1u << index);
+    portEXIT_CRITICAL(&g_link_mux);
+    return true;
+}
+
+void ble_keyboard_get_link_stats(BleLinkStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_link_mux);
+    *out = g_link;
+    portEXIT_CRITICAL(&g_link_mux);
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    if (g_stack_mutex && xSemaphoreTake(g_stack_mutex, 0) == pdTRUE) {
+        if (g_link_keyboard) {
+            out->report_tx_last_us = g_link_keyboard->lastReportTxUs();
+            out->report_tx_max_us = g_link_keyboard->maxReportTxUs();
+        }
+        xSemaphoreGive(g_stack_mutex);
+    }
+#endif
+}
+
+void ble_keyboard_get_stack_stats(BleStackStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_link_mux);
+    *out = g_stack;
+    portEXIT_CRITICAL(&g_link_mux);
+    out->on_demand = BLE_KEYBOARD_ON_DEMAND;
+}
+
+void BleKeyboardManager::begin(const DeviceConfig* config) {
+    this->config = config;
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    if (!g_stack_mutex) {
+        g_stack_mutex = xSemaphoreCreateMutex();
+        hosts_load();
+    }
+    if (BLE_KEYBOARD_CONN_TUNING && !g_relax_timer) {
+        g_relax_timer = xTimerCreate("BleRelax", pdMS_TO_TICKS(BLE_KEYBOARD_FAST_HOLD_MS), pdFALSE, nullptr, relax_timer_cb);
+    }
+
+    if (BLE_KEYBOARD_ON_DEMAND) {
+        Logger.logMessagef("BLE", "Keyboard on demand: starts on first use, stops after %lu s idle",
+            (unsigned long)(BLE_KEYBOARD_IDLE_SHUTDOWN_MS / 1000));
+        return;
+    }
+
+    xSemaphoreTake(g_stack_mutex, portMAX_DELAY);
+    startStack();
+    xSemaphoreGive(g_stack_mutex);
 #else
     (void)config;
 
@@ -73,10 +381,196 @@ void BleKeyboardManager::begin(const DeviceConfig* config) {
 #endif
 }
 
-void BleKeyboardManager::end() {
 #if BLE_KEYBOARD_MANAGER_ENABLED
+// Caller holds g_stack_mutex.
+void BleKeyboardManager::startStack() {
+    if (keyboard) return;
+
+    // We only use BLE HID. Release Classic BT controller memory to reclaim internal RAM.
+    // Must be called before the controller is initialized by the BLE stack.
+    static bool classicBtReleased = false;
+    if (!classicBtReleased) {
+        const esp_err_t err = esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT);
+        Logger.logMessagef("BLE", "Classic BT mem release: %s (%d)", (err == ESP_OK) ? "OK" : "ERR", (int)err);
+        classicBtReleased = true;
+    }
+
+    const char* name = (config && strlen(config->device_name) > 0) ? config->device_name : "ESP32-Keyboard";
+    const size_t heapBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+    keyboard = new BleKeyboard(std::string(name), "Espressif", 100);
+
+    keyboard->onConnect([]() {
+        Logger.logMessage("BLE", "Keyboard connected");
+        portENTER_CRITICAL(&g_link_mux);
+        g_link.connected = true;
+        g_link.mode = BleLinkMode::Host;
+        if (g_hosts.switching) {
+            g_hosts.switching = false;
+            g_hosts.switches++;
+            g_hosts.last_switch_ms = millis() - g_host_switch_started_ms;
+        }
+        portEXIT_CRITICAL(&g_link_mux);
+        if (BLE_KEYBOARD_CONN_TUNING) relax_timer_arm(kConnectSettleMs);
+    });
+    keyboard->onDisconnect([]() {
+        Logger.logMessage("BLE", "Keyboard disconnected");
+        if (g_relax_timer) xTimerStop(g_relax_timer, 0);
+        portENTER_CRITICAL(&g_link_mux);
+        g_link.connected = false;
+        g_link.mode = BleLinkMode::Host;
+        portEXIT_CRITICAL(&g_link_mux);
+    });
+    keyboard->onConnParams([](uint16_t interval, uint16_t latency, uint16_t timeout) {
+        portENTER_CRITICAL(&g_link_mux);
+        g_link.interval = interval;
+        g_link.latency = latency;
+        g_link.timeout = timeout;
+        g_link.updates++;
+        portEXIT_CRITICAL(&g_link_mux);
+        Logger.logMessagef("BLE", "Connection interval %u.%02u ms, latency %u, timeout %u ms",
+            (unsigned)(interval * 125 / 100), (unsigned)(interval * 125 % 100), (unsigned)latency, (unsigned)timeout * 10);
+    });
+
+    keyboard->onAuthenticated([](const NimBLEAddress& peer, bool bonded) {
+        portENTER_CRITICAL(&g_link_mux);
+        memcpy(g_host_auth_peer, peer.getVal(), 6);
+        g_host_auth_type = peer.getType();
+        g_host_auth_bonded = bonded;
+        g_host_auth_pending = true;
+        portEXIT_CRITICAL(&g_link_mux);
+    });
+
+    hosts_apply_identity(keyboard, false);
+    Logger.logMessagef("BLE", "Starting BLE keyboard: %s (host profile %u)", name, (unsigned)g_hosts.active + 1);
+    keyboard->begin();
+    g_link_keyboard = keyboard;
+    boot_profile_mark(BootMilestone::BleAdvertising);
+
+    // Bonds live in NVS, so a bonded host reconnects to a restarted stack
+    // with its stored keys instead of pairing again.
+    const size_t heapAfter = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    const int bonds = NimBLEDevice::getNumBonds();
+    portENTER_CRITICAL(&g_link_mux);
+    g_stack.running = true;
+    g_stack.starts++;
+    g_stack.heap_cost_bytes = heapBefore > heapAfter ? (uint32_t)(heapBefore - heapAfter) : 0;
+    g_stack.bonds = (uint8_t)(bonds > 0 ? bonds : 0);
+    portEXIT_CRITICAL(&g_link_mux);
+    g_stack_activity_ms = millis();
+
+    Logger.logMessagef("BLE", "Stack up: %u bytes internal heap, %d bonded host(s)",
+        (unsigned)g_stack.heap_cost_bytes, bonds);
+}
+
+// Caller holds g_stack_mutex.
+void BleKeyboardManager::stopStack() {
     if (!keyboard) return;
+
+    if (g_relax_timer) xTimerStop(g_relax_timer, 0);
+    g_link_keyboard = nullptr;
+
+    const size_t heapBefore = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
     keyboard->end();
+    delete keyboard;
+    keyboard = nullptr;
+    const size_t heapAfter = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+    portENTER_CRITICAL(&g_link_mux);
+    g_link.connected = false;
+    g_link.mode = BleLinkMode::Host;
+    g_stack.running = false;
+    g_stack.stops++;
+    g_stack.heap_reclaimed_bytes = heapAfter > heapBefore ? (uint32_t)(heapAfter - heapBefore) : 0;
+    portEXIT_CRITICAL(&g_link_mux);
+
+    Logger.logMessagef("BLE", "Stack stopped: %u bytes internal heap reclaimed",
+        (unsigned)g_stack.heap_reclaimed_bytes);
+}
+#endif
+
+void BleKeyboardManager::end() {
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    if (!g_stack_mutex) return;
+    xSemaphoreTake(g_stack_mutex, portMAX_DELAY);
+    stopStack();
+    xSemaphoreGive(g_stack_mutex);
+#endif
+}
+
+void BleKeyboardManager::loop() {
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    if (!g_stack_mutex) return;
+    if (xSemaphoreTake(g_stack_mutex, 0) != pdTRUE) return;
+
+    hosts_service(keyboard);
+
+    if (ota_quiet_active()) {
+        // Firmware update: free the radio and its RAM unless a macro holds it;
+        // requests wait until the update is over.
+        if (keyboard && g_stack_users == 0) stopStack();
+    } else if (memory_pressure_tier() >= MemPressureTier::Ble) {
+        // Memory pressure: give the radio's RAM back while no host is
+        // connected; a macro can still start it on demand.
+        if (keyboard) {
+            if (g_stack_users == 0 && !keyboard->isConnected()) stopStack();
+        } else if (g_stack_start_requested) {
+            g_stack_start_requested = false;
+            startStack();
+        }
+    } else if (!BLE_KEYBOARD_ON_DEMAND) {
+        // Started at boot and kept up (restarted after a failed update).
+        if (!keyboard) startStack();
+    } else if (!keyboard) {
+        if (g_stack_start_requested) {
+            g_stack_start_requested = false;
+            startStack();
+        }
+    } else if (g_stack_users == 0 && (millis() - g_stack_activity_ms) >= BLE_KEYBOARD_IDLE_SHUTDOWN_MS) {
+        stopStack();
+    }
+    xSemaphoreGive(g_stack_mutex);
+#endif
+}
+
+bool BleKeyboardManager::acquire(const volatile bool* cancel) {
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    if (!g_stack_mutex) return false;
+    // Full clock and no light sleep while a macro uses the link.
+    power_manager_acquire(PowerActivity::Ble);
+    xSemaphoreTake(g_stack_mutex, portMAX_DELAY);
+    g_stack_users++;
+    g_stack_activity_ms = millis();
+    const bool running = keyboard != nullptr;
+    if (!running) {
+        g_stack_start_requested = true;
+        loop_scheduler_notify();
+    }
+    xSemaphoreGive(g_stack_mutex);
+
+    if (!BLE_KEYBOARD_ON_DEMAND || (running && keyboard->isConnected())) return true;
+
+    // Started by loop(); give a bonded host time to reconnect.
+    const uint32_t t0 = millis();
+    while (!(keyboard && keyboard->isConnected())) {
+        if ((cancel && *cancel) || (millis() - t0) >= BLE_KEYBOARD_ON_DEMAND_CONNECT_MS) break;
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    return true;
+#else
+    (void)cancel;
+    return false;
+#endif
+}
+
+void BleKeyboardManager::release() {
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    if (!g_stack_mutex) return;
+    power_manager_release(PowerActivity::Ble);
+    xSemaphoreTake(g_stack_mutex, portMAX_DELAY);
+    if (g_stack_users > 0) g_stack_users--;
+    g_stack_activity_ms = millis();
+    xSemaphoreGive(g_stack_mutex);
 #endif
 }
 
@@ -96,17 +590,119 @@ bool BleKeyboardManager::isConnected() const {
 #endif
 }
 
-void BleKeyboardManager::sendText(const char* text) {
+void BleKeyboardManager::requestLowLatency() {
+#if BLE_KEYBOARD_MANAGER_ENABLED
+    if (!g_stack_mutex || xSemaphoreTake(g_stack_mutex, 0) != pdTRUE) return;
+    struct Unlock { ~Unlock() { xSemaphoreGive(g_stack_mutex); } } unlock;
+
+    // On demand: a touch-down brings the stack up (loop() starts it), so a
+    // bonded host is usually back by the time the macro runs.
+    g_stack_activity_ms = millis();
+    if (!keyboard) {
+        if (BLE_KEYBOARD_ON_DEMAND) {
+            g_stack_start_requested = true;
+            loop_scheduler_notify();
+        }
+        return;
+    }
+
+    if (!BLE_KEYBOARD_CONN_TUNING || !keyboard->isConnected()) return;
+
+    portENTER_CRITICAL(&g_link_mux);
+    g_link_activity_ms = millis();
+    const bool fast = g_link.mode == BleLinkMode::Fast;
+    portEXIT_CRITICAL(&g_link_mux);
+
+    if (!fast) link_request(BleLinkMode::Fast);
+    relax_timer_arm(BLE_KEYBOARD_FAST_HOLD_MS);
+#endif
+}
+
+#if BLE_KEYBOARD_MANAGER_ENABLED
+static void typingPause(uint32_t ms) {
+    if (ms == 0) {
+        taskYIELD();
+        return;
+    }
+    const TickType_t ticks = pdMS_TO_TICKS(ms);
+    vTaskDelay(ticks ? ticks : 1);
+}
+#endif
+
+void BleKeyboardManager::typeText(const char* text, int interval_ms, const volatile bool* cancel) {
 #if BLE_KEYBOARD_MANAGER_ENABLED
     if (!keyboard || !text) return;
     if (!keyboard->isConnected()) return;
 
-    keyboard->print(text);
+    uint32_t interval = (interval_ms >= 0) ? (uint32_t)interval_ms
+        : (config ? config->ble_typing_interval_ms : BLE_KEYBOARD_TYPING_INTERVAL_MS);
+    if (interval > 255) interval = 255;
+
+    const uint32_t t0 = millis();
+    uint32_t chars = 0;
+    uint32_t reports = 0;
+
+    uint8_t keys[6];
+    uint8_t count = 0;
+    uint8_t mods = 0;
+    const uint8_t batch = (BLE_KEYBOARD_TYPING_BATCH_KEYS < 1) ? 1
+        : (BLE_KEYBOARD_TYPING_BATCH_KEYS > 6 ? 6 : BLE_KEYBOARD_TYPING_BATCH_KEYS);
+
+    auto flush = [&]() {
+        if (count == 0) return;
+        keyboard->sendKeys(mods, keys, count);
+        typingPause(interval);
+        keyboard->sendKeys(0, nullptr, 0);
+        typingPause(interval);
+        reports += 2;
+        count = 0;
+    };
+
+    for (const char* p = text; *p; p++) {
+        if (cancel && *cancel) break;
+        if (*p == '\r') continue;
+
+        const uint8_t usage = BleKeyboard::asciiUsage((uint8_t)*p);
+        if (!usage) continue;   // no key for this character
+        const uint8_t key = usage & 0x7F;
+        const uint8_t keyMods = (usage & 0x80) ? 0x02 : 0;   // left shift
+
+        // A key can only be in a report once, and every key in a report shares
+        // its modifiers; otherwise start a new report.
+        bool conflict = count >= batch || (count > 0 && keyMods != mods);
+        for (uint8_t i = 0; i < count && !conflict; i++) {
+            if (keys[i] == key) conflict = true;
+        }
+        if (conflict) flush();
+
+        if (count == 0) mods = keyMods;
+        keys[count++] = key;
+        chars++;
+    }
+    flush();
+
+    const uint32_t elapsed = millis() - t0;
+    portENTER_CRITICAL(&g_typing_stats_mux);
+    g_typing_stats.runs++;
+    g_typing_stats.chars += chars;
+    g_typing_stats.reports += reports;
+    g_typing_stats.last_chars = chars;
+    g_typing_stats.last_reports = reports;
+    g_typing_stats.last_ms = elapsed;
+    g_typing_stats.last_cps = (uint16_t)(elapsed ? (chars * 1000u / elapsed) : 0);
+    g_typing_stats.last_interval_ms = (uint8_t)interval;
+    portEXIT_CRITICAL(&g_typing_stats_mux);
 #else
     (void)text;
+    (void)interval_ms;
+    (void)cancel;
 #endif
 }
 
+void BleKeyboardManager::sendText(const char* text) {
+    typeText(text);
+}
+
 void BleKeyboardManager::press(uint8_t key) {
 #if BLE_KEYBOARD_MANAGER_ENABLED
     if (!keyboard) return;
@@ -16,16 +16,107 @@
 #define BLE_KEYBOARD_MANAGER_ENABLED 0
 #endif
 
+// STRING typing throughput, for tuning the report interval per host.
+struct BleTypingStats {
+    uint32_t runs;
+    uint32_t chars;
+    uint32_t reports;
+    uint32_t last_chars;
+    uint32_t last_reports;
+    uint32_t last_ms;
+    uint16_t last_cps;           // characters per second of the last run
+    uint8_t last_interval_ms;
+};
+
+void ble_keyboard_get_typing_stats(BleTypingStats* out);
+
+enum class BleLinkMode : uint8_t {
+    Host,   // whatever the central negotiated; nothing requested yet
+    Fast,   // short interval for a macro burst
+    Idle,   // relaxed interval with peripheral latency
+};
+
+// Connection parameters as applied by the central (it may not grant what was requested).
+struct BleLinkStats {
+    bool connected;
+    BleLinkMode mode;            // last requested
+    uint16_t interval;           // 1.25 ms units
+    uint16_t latency;            // connection events the keyboard may skip
+    uint16_t timeout;            // 10 ms units
+    uint32_t requests;
+    uint32_t updates;
+    uint32_t report_tx_last_us;  // notify() time of an input report
+    uint32_t report_tx_max_us;
+};
+
+void ble_keyboard_get_link_stats(BleLinkStats* out);
+
+// NimBLE stack lifecycle (BLE_KEYBOARD_ON_DEMAND), internal heap measured
+// around the last start and stop.
+struct BleStackStats {
+    bool on_demand;
+    bool running;
+    uint32_t starts;
+    uint32_t stops;
+    uint32_t heap_cost_bytes;
+    uint32_t heap_reclaimed_bytes;
+    uint8_t bonds;               // bonded hosts when last started
+};
+
+void ble_keyboard_get_stack_stats(BleStackStats* out);
+
+// Host profiles (BLE_KEYBOARD_HOST_PROFILES): each has its own address and
+// bond, so a host only reconnects while its profile is active. Indexes are
+// 0-based; switches and forgets are applied by BleKeyboardManager::loop().
+struct BleHostProfileInfo {
+    char own_address[18];
+    char peer_address[18];       // "" until a host bonds
+    bool bonded;
+};
+
+struct BleHostStats {
+    uint8_t active;
+    uint8_t count;
+    bool switching;              // waiting for the new host to connect
+    bool last_switch_directed;   // advertised to the bonded host first
+    uint32_t switches;
+    uint32_t last_switch_ms;     // request to connection
+};
+
+void ble_keyboard_get_host_stats(BleHostStats* out);
+bool ble_keyboard_get_host_profile(uint8_t index, BleHostProfileInfo* out);
+bool ble_keyboard_select_host(uint8_t index);
+// Delete the profile's bond; the next host to pair while it is active takes it.
+bool ble_keyboard_forget_host(uint8_t index);
+
 class BleKeyboardManager {
 public:
+    // Starts the NimBLE stack, or with BLE_KEYBOARD_ON_DEMAND only prepares it.
     void begin(const DeviceConfig* config);
+    // Stops and deinitialises the stack.
     void end();
+    // Main loop: on demand, starts a requested stack and stops it after
+    // BLE_KEYBOARD_IDLE_SHUTDOWN_MS without use.
+    void loop();
+
+    // Pin the stack for a macro (pair with release()). On demand this starts
+    // it and waits up to BLE_KEYBOARD_ON_DEMAND_CONNECT_MS for the host.
+    bool acquire(const volatile bool* cancel = nullptr);
+    void release();
 
     bool enabled() const;
     bool isConnected() const;
 
-    // For MVP: just enough for DuckyScript STRING + basic key taps.
-    // More complex chords/media keys can be added in the DuckyScript executor step.
+    // Ask for the fast connection interval ahead of a burst (touch-down, macro
+    // start). The link relaxes to the idle parameters once no report has been
+    // sent for BLE_KEYBOARD_FAST_HOLD_MS. No-op without BLE_KEYBOARD_CONN_TUNING.
+    void requestLowLatency();
+
+    // Type text: consecutive characters with the same modifiers and distinct
+    // keys share one press report (up to BLE_KEYBOARD_TYPING_BATCH_KEYS), each
+    // followed by a release report. interval_ms is the pause after every report;
+    // < 0 uses the configured ble_typing_interval_ms. Stops early when *cancel is set.
+    void typeText(const char* text, int interval_ms = -1, const volatile bool* cancel = nullptr);
     void sendText(const char* text);
 
     void press(uint8_t key);
@@ -37,8 +128,12 @@ public:
     void tapMedia(const MediaKeyReport key);
 
 private:
+    const DeviceConfig* config = nullptr;
 #if BLE_KEYBOARD_MANAGER_ENABLED
     BleKeyboard* keyboard = nullptr;
+
+    void startStack();
+    void stopStack();
 #endif
 };
 
@@ -56,6 +56,92 @@
 #define HAS_BLE_KEYBOARD false
 #endif
 
+// Default pause (ms) after each key report when typing STRING text (runtime setting ble_typing_interval_ms).
+#ifndef BLE_KEYBOARD_TYPING_INTERVAL_MS
+#define BLE_KEYBOARD_TYPING_INTERVAL_MS 5
+#endif
+
+// Distinct same-modifier keys packed into one report while typing (1-6; 1 = one key per report).
+#ifndef BLE_KEYBOARD_TYPING_BATCH_KEYS
+#define BLE_KEYBOARD_TYPING_BATCH_KEYS 6
+#endif
+
+// Start the NimBLE stack on first use (touch-down / SendKeys) instead of at boot,
+// and deinitialise it after BLE_KEYBOARD_IDLE_SHUTDOWN_MS to give its RAM back.
+#ifndef BLE_KEYBOARD_ON_DEMAND
+#define BLE_KEYBOARD_ON_DEMAND false
+#endif
+
+// Idle time (ms) without macros or macropad touches before an on-demand stack stops.
+#ifndef BLE_KEYBOARD_IDLE_SHUTDOWN_MS
+#define BLE_KEYBOARD_IDLE_SHUTDOWN_MS 600000
+#endif
+
+// How long (ms) a macro waits for a bonded host to reconnect to a freshly started stack.
+#ifndef BLE_KEYBOARD_ON_DEMAND_CONNECT_MS
+#define BLE_KEYBOARD_ON_DEMAND_CONNECT_MS 4000
+#endif
+
+// Stored BLE host profiles, each with its own address and bond (1-8; keep <= CONFIG_BT_NIMBLE_MAX_BONDS).
+#ifndef BLE_KEYBOARD_HOST_PROFILES
+#define BLE_KEYBOARD_HOST_PROFILES 3
+#endif
+
+// Request a short BLE connection interval for macro bursts and relax it when idle.
+#ifndef BLE_KEYBOARD_CONN_TUNING
+#define BLE_KEYBOARD_CONN_TUNING true
+#endif
+
+// Shortest connection interval asked for during bursts, in 1.25 ms units (6 = 7.5 ms; hosts may clamp it).
+#ifndef BLE_KEYBOARD_FAST_INTERVAL_MIN
+#define BLE_KEYBOARD_FAST_INTERVAL_MIN 6
+#endif
+
+// Longest connection interval accepted during bursts, in 1.25 ms units (12 = 15 ms).
+#ifndef BLE_KEYBOARD_FAST_INTERVAL_MAX
+#define BLE_KEYBOARD_FAST_INTERVAL_MAX 12
+#endif
+
+// Shortest connection interval asked for while idle, in 1.25 ms units (24 = 30 ms).
+#ifndef BLE_KEYBOARD_IDLE_INTERVAL_MIN
+#define BLE_KEYBOARD_IDLE_INTERVAL_MIN 24
+#endif
+
+// Longest connection interval asked for while idle, in 1.25 ms units (48 = 60 ms).
+#ifndef BLE_KEYBOARD_IDLE_INTERVAL_MAX
+#define BLE_KEYBOARD_IDLE_INTERVAL_MAX 48
+#endif
+
+// Connection events the keyboard may skip while idle (peripheral latency).
+#ifndef BLE_KEYBOARD_IDLE_LATENCY
+#define BLE_KEYBOARD_IDLE_LATENCY 4
+#endif
+
+// Quiet time (ms) without touches or reports before the fast interval is relaxed.
+#ifndef BLE_KEYBOARD_FAST_HOLD_MS
+#define BLE_KEYBOARD_FAST_HOLD_MS 3000
+#endif
+
+// Macro taps waiting behind the running macro on the executor task (extra taps are dropped).
+#ifndef MACRO_EXECUTOR_QUEUE_DEPTH
+#define MACRO_EXECUTOR_QUEUE_DEPTH 4
+#endif
+
+// Tapping the button whose macro is running cancels it.
+#ifndef MACRO_EXECUTOR_TAP_TO_CANCEL
+#define MACRO_EXECUTOR_TAP_TO_CANCEL true
+#endif
+
+// Drop a tap on a button that is already queued (false = queue it again).
+#ifndef MACRO_EXECUTOR_COALESCE_REPEATS
+#define MACRO_EXECUTOR_COALESCE_REPEATS true
+#endif
+
+// Stack of the macro executor task.
+#ifndef MACRO_EXECUTOR_STACK_BYTES
+#define MACRO_EXECUTOR_STACK_BYTES 4096
+#endif
+
 // GPIO for the built-in LED (only used when HAS_BUILTIN_LED is true).
 #ifndef LED_PIN
 #define LED_PIN 2  // Common GPIO for ESP32 boards
@@ -75,6 +161,84 @@
 #define WIFI_MAX_ATTEMPTS 3
 #endif
 
+// Connect straight to the AP (BSSID + channel) of the last success before scanning.
+#ifndef WIFI_FAST_CONNECT
+#define WIFI_FAST_CONNECT true
+#endif
+
+// Time the directed connect gets to reach an IP before the full scan runs (ms).
+#ifndef WIFI_FAST_CONNECT_TIMEOUT_MS
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000
+#endif
+
+// Fast connect reuses the last DHCP address as a static config (skips DHCP; needs a reservation).
+#ifndef WIFI_FAST_REUSE_LEASE
+#define WIFI_FAST_REUSE_LEASE false
+#endif
+
+// After a disconnect, time the driver's auto-reconnect gets before the watchdog reconnects (ms).
+#ifndef WIFI_RECONNECT_GRACE_MS
+#define WIFI_RECONNECT_GRACE_MS 1500
+#endif
+
+// TLS sessions kept for resumption by outbound HTTPS (image_url, firmware check/download), one per host; 0 disables.
+#ifndef TLS_SESSION_CACHE_ENTRIES
+#define TLS_SESSION_CACHE_ENTRIES 4
+#endif
+
+// Connect + handshake timeout for outbound HTTPS when the caller gives none (ms).
+#ifndef TLS_HANDSHAKE_TIMEOUT_MS
+#define TLS_HANDSHAKE_TIMEOUT_MS 15000
+#endif
+
+// ============================================================================
+// Config Store
+// ============================================================================
+
+// Portal config saves are written once no change arrived for this long (ms).
+#ifndef CONFIG_SAVE_DEBOUNCE_MS
+#define CONFIG_SAVE_DEBOUNCE_MS 1500
+#endif
+
+// Longest a pending config change waits while changes keep arriving (ms).
+#ifndef CONFIG_SAVE_MAX_DELAY_MS
+#define CONFIG_SAVE_MAX_DELAY_MS 10000
+#endif
+
+// ============================================================================
+// Boot
+// ============================================================================
+
+// Associate with WiFi on a background task while the display, BLE and icons start.
+#ifndef BOOT_WIFI_PARALLEL
+#define BOOT_WIFI_PARALLEL true
+#endif
+
+// Stack of the boot-time WiFi task (bytes).
+#ifndef BOOT_WIFI_TASK_STACK_BYTES
+#define BOOT_WIFI_TASK_STACK_BYTES 6144
+#endif
+
+// Minimum time the splash stays on the panel before the first macro screen (ms).
+#ifndef BOOT_SPLASH_MIN_MS
+#define BOOT_SPLASH_MIN_MS 500
+#endif
+
+// Load only the default macro screen during setup; the others follow from a background task.
+#ifndef BOOT_MACROS_LAZY
+#define BOOT_MACROS_LAZY true
+#endif
+
+// Stack of the background macro load task (bytes).
+#ifndef BOOT_MACROS_TASK_STACK_BYTES
+#define BOOT_MACROS_TASK_STACK_BYTES 6144
+#endif
+
+// USB CDC boards: longest wait for a serial monitor before the boot banner (ms).
+#ifndef BOOT_SERIAL_WAIT_MS
+#define BOOT_SERIAL_WAIT_MS 1000
+#endif
+
 // ============================================================================
 // Instrumentation / Telemetry Defaults
 // ============================================================================
@@ -105,6 +269,546 @@
 #define MEMORY_SNAPSHOT_ON_HTTP_ENABLED 0
 #endif
 
+// Queue log lines in a ring written to serial by a background task (callers never wait on the port).
+#ifndef LOG_ASYNC_ENABLED
+#define LOG_ASYNC_ENABLED true
+#endif
+
+// Log lines the ring holds (~200 bytes each, PSRAM when present; power of two). Lines beyond are dropped and counted.
+#ifndef LOG_RING_LINES
+#define LOG_RING_LINES 32
+#endif
+
+// Compile-time level for LOGE/LOGW/LOGI/LOGD/LOGV (0 none, 1 error, 2 warn, 3 info, 4 debug, 5 verbose).
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 3
+#endif
+
+// Level for the display manager's LOG* messages (screen switches).
+#ifndef LOG_LEVEL_DISPLAY
+#define LOG_LEVEL_DISPLAY LOG_LEVEL
+#endif
+
+// Level for the image API and strip decoder LOG* messages (per-strip progress is debug).
+#ifndef LOG_LEVEL_IMAGE
+#define LOG_LEVEL_IMAGE LOG_LEVEL
+#endif
+
+// LOG* macros record the format pointer and raw arguments; the log drain task formats them.
+#ifndef LOG_BINARY_ENABLED
+#define LOG_BINARY_ENABLED false
+#endif
+
+// Copy log lines to a UDP syslog receiver set in /api/config (log_stream_host). Needs LOG_ASYNC_ENABLED.
+#ifndef LOG_STREAM_ENABLED
+#define LOG_STREAM_ENABLED true
+#endif
+
+// Longest a streamed log line waits before its datagram is sent (ms).
+#ifndef LOG_STREAM_BATCH_MS
+#define LOG_STREAM_BATCH_MS 250
+#endif
+
+// Largest syslog datagram; lines queued within LOG_STREAM_BATCH_MS share one up to this size.
+#ifndef LOG_STREAM_DATAGRAM_BYTES
+#define LOG_STREAM_DATAGRAM_BYTES 1024
+#endif
+
+// Syslog send budget (bytes per second). Datagrams over it are dropped and counted.
+#ifndef LOG_STREAM_MAX_BYTES_PER_S
+#define LOG_STREAM_MAX_BYTES_PER_S 4096
+#endif
+
+// FAT cluster size the cached FFat usage rounds file size changes to (bytes).
+#ifndef FS_HEALTH_FFAT_CLUSTER_BYTES
+#define FS_HEALTH_FFAT_CLUSTER_BYTES 4096
+#endif
+
+// Delay after FFat is first mounted before its usage is measured once in the background (ms).
+#ifndef FS_HEALTH_RECONCILE_DELAY_MS
+#define FS_HEALTH_RECONCILE_DELAY_MS 3000
+#endif
+
+// ============================================================================
+// Web Portal Admission Control
+// ============================================================================
+
+// Cap concurrent JSON / upload requests and answer 503 + Retry-After when busy or low on heap.
+#ifndef PORTAL_ADMISSION_ENABLED
+#define PORTAL_ADMISSION_ENABLED true
+#endif
+
+// Concurrent JSON API reads (GET /api/..., each builds a JsonDocument).
+#ifndef PORTAL_ADMISSION_JSON_MAX
+#define PORTAL_ADMISSION_JSON_MAX 3
+#endif
+
+// Concurrent body uploads (macros, icons, images, config, OTA).
+#ifndef PORTAL_ADMISSION_UPLOAD_MAX
+#define PORTAL_ADMISSION_UPLOAD_MAX 2
+#endif
+
+// Internal heap (bytes) that must stay free to admit a JSON read; uploads need twice this.
+#ifndef PORTAL_ADMISSION_MIN_FREE_BYTES
+#define PORTAL_ADMISSION_MIN_FREE_BYTES 24576
+#endif
+
+// Largest free internal block (bytes) needed to admit a JSON read; uploads need twice this.
+#ifndef PORTAL_ADMISSION_MIN_BLOCK_BYTES
+#define PORTAL_ADMISSION_MIN_BLOCK_BYTES 8192
+#endif
+
+// Retry-After (seconds) sent with a 503.
+#ifndef PORTAL_ADMISSION_RETRY_AFTER_S
+#define PORTAL_ADMISSION_RETRY_AFTER_S 2
+#endif
+
+// Reusable response buffers for streamed JSON endpoints (/api/health, /api/info).
+#ifndef PORTAL_JSON_STREAM_SLOTS
+#define PORTAL_JSON_STREAM_SLOTS 2
+#endif
+
+// Size (bytes) of each streamed JSON response buffer (PSRAM when present).
+#ifndef PORTAL_JSON_STREAM_SLOT_BYTES
+#define PORTAL_JSON_STREAM_SLOT_BYTES 8192
+#endif
+
+// Server-Sent Events at /api/events: health, screen, image and OTA updates pushed to the portal.
+#ifndef PORTAL_EVENTS_ENABLED
+#define PORTAL_EVENTS_ENABLED true
+#endif
+
+// Concurrent /api/events subscribers; further connections are refused (clients fall back to polling).
+#ifndef PORTAL_EVENTS_MAX_CLIENTS
+#define PORTAL_EVENTS_MAX_CLIENTS 2
+#endif
+
+// Interval (ms) between health events on /api/events.
+#ifndef PORTAL_EVENTS_HEALTH_INTERVAL_MS
+#define PORTAL_EVENTS_HEALTH_INTERVAL_MS HEALTH_POLL_INTERVAL_MS
+#endif
+
+// How often (ms) screen, image and OTA state are checked for changes while someone is subscribed.
+#ifndef PORTAL_EVENTS_CHECK_MS
+#define PORTAL_EVENTS_CHECK_MS 250
+#endif
+
+// Per-route request count, latency histogram, bytes and heap drop at /api/routes.
+#ifndef PORTAL_ROUTE_PROFILE_ENABLED
+#define PORTAL_ROUTE_PROFILE_ENABLED true
+#endif
+
+// Distinct method + path pairs profiled; later ones share a "*" entry.
+#ifndef PORTAL_ROUTE_PROFILE_MAX_ROUTES
+#define PORTAL_ROUTE_PROFILE_MAX_ROUTES 32
+#endif
+
+// Request bodies staged at once (shared body leases for every POST/PUT/PATCH handler).
+#ifndef PORTAL_BODY_ARENA_LEASES
+#define PORTAL_BODY_ARENA_LEASES 6
+#endif
+
+// Close an upload whose body lease has received nothing for this long (ms).
+#ifndef PORTAL_BODY_ARENA_TIMEOUT_MS
+#define PORTAL_BODY_ARENA_TIMEOUT_MS 10000
+#endif
+
+// Largest released body block (bytes) kept in PSRAM for reuse instead of freed.
+#ifndef PORTAL_BODY_ARENA_CACHE_MAX_BYTES
+#define PORTAL_BODY_ARENA_CACHE_MAX_BYTES 16384
+#endif
+
+// Run flash-heavy handlers (macros save, icon install) on portal worker tasks instead of AsyncTCP.
+#ifndef PORTAL_WORKERS_ENABLED
+#define PORTAL_WORKERS_ENABLED false
+#endif
+
+// Portal worker tasks (1 or 2).
+#ifndef PORTAL_WORKER_COUNT
+#define PORTAL_WORKER_COUNT 2
+#endif
+
+// Core of portal worker 0 (-1 = either core).
+#ifndef PORTAL_WORKER_0_CORE
+#define PORTAL_WORKER_0_CORE 1
+#endif
+
+// Core of portal worker 1 (-1 = either core).
+#ifndef PORTAL_WORKER_1_CORE
+#define PORTAL_WORKER_1_CORE 0
+#endif
+
+// Portal worker priority (keep below CONFIG_ASYNC_TCP_PRIORITY so light routes answer first).
+#ifndef PORTAL_WORKER_PRIORITY
+#define PORTAL_WORKER_PRIORITY 1
+#endif
+
+// Portal worker stack (bytes).
+#ifndef PORTAL_WORKER_STACK_BYTES
+#define PORTAL_WORKER_STACK_BYTES 6144
+#endif
+
+// Jobs queued per portal worker; a full queue answers 503 + Retry-After.
+#ifndef PORTAL_WORKER_QUEUE_DEPTH
+#define PORTAL_WORKER_QUEUE_DEPTH 4
+#endif
+
+// Worker for macros POST/PATCH (-1 = run inline on AsyncTCP).
+#ifndef PORTAL_WORKER_ROUTE_MACROS
+#define PORTAL_WORKER_ROUTE_MACROS 0
+#endif
+
+// Worker for icon installs (-1 = run inline on AsyncTCP).
+#ifndef PORTAL_WORKER_ROUTE_ICONS
+#define PORTAL_WORKER_ROUTE_ICONS 1
+#endif
+
+// POST /api/batch: run several display/image commands from one request.
+#ifndef PORTAL_BATCH_ENABLED
+#define PORTAL_BATCH_ENABLED true
+#endif
+
+// Most ops accepted in one /api/batch request.
+#ifndef PORTAL_BATCH_MAX_OPS
+#define PORTAL_BATCH_MAX_OPS 16
+#endif
+
+// Largest /api/batch request body (bytes).
+#ifndef PORTAL_BATCH_MAX_BODY
+#define PORTAL_BATCH_MAX_BODY 4096
+#endif
+
+// Accept gzip firmware (.bin.gz) for /api/update and GitHub updates, inflated with the ROM decoder.
+#ifndef OTA_GZIP_ENABLED
+#define OTA_GZIP_ENABLED true
+#endif
+
+// Prefer a release's delta patch from the running version for GitHub updates (needs OTA_GZIP_ENABLED).
+#ifndef OTA_DELTA_ENABLED
+#define OTA_DELTA_ENABLED OTA_GZIP_ENABLED
+#endif
+
+// 4 KB buffers between the GitHub download and the flash writer task (PSRAM first, at least 2).
+#ifndef FIRMWARE_DL_RING_SLOTS
+#define FIRMWARE_DL_RING_SLOTS 4
+#endif
+
+// Range requests allowed to resume an interrupted GitHub firmware download.
+#ifndef FIRMWARE_DL_RESUME_RETRIES
+#define FIRMWARE_DL_RESUME_RETRIES 3
+#endif
+
+// Pause rendering, MQTT health, BLE, icon warm-up and CPU sampling while an OTA writes flash.
+#ifndef OTA_QUIET_ENABLED
+#define OTA_QUIET_ENABLED true
+#endif
+
+// Begin/end/instant/counter events in a per-core ring, exported at /api/trace.
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED false
+#endif
+
+// Trace events kept per core (16 bytes each; power of two).
+#ifndef TRACE_RING_EVENTS
+#define TRACE_RING_EVENTS 4096
+#endif
+
+// Per-subsystem live/peak heap bytes per heap, in /api/health heap_tags and memory logs.
+#ifndef HEAP_TAGS_ENABLED
+#define HEAP_TAGS_ENABLED true
+#endif
+
+// Reserve per-subsystem arenas at boot (STATIC_ALLOC_*_BYTES) so the steady state makes no heap allocations.
+#ifndef STATIC_ALLOC_MODE
+#define STATIC_ALLOC_MODE false
+#endif
+
+// Static-allocation arena for image API decoders, strip and oversize upload buffers (bytes).
+#ifndef STATIC_ALLOC_IMAGE_BYTES
+#define STATIC_ALLOC_IMAGE_BYTES (96 * 1024)
+#endif
+
+// Static-allocation arena for JSON documents and streamed JSON slots (bytes).
+#ifndef STATIC_ALLOC_JSON_BYTES
+#define STATIC_ALLOC_JSON_BYTES (48 * 1024)
+#endif
+
+// Static-allocation arena for icon payloads and warm-up lists (bytes; cover ICON_STORE_CACHE_BYTES).
+#ifndef STATIC_ALLOC_ICONS_BYTES
+#define STATIC_ALLOC_ICONS_BYTES (288 * 1024)
+#endif
+
+// Static-allocation arena for HTTP request bodies (bytes).
+#ifndef STATIC_ALLOC_HTTP_BYTES
+#define STATIC_ALLOC_HTTP_BYTES (64 * 1024)
+#endif
+
+// Static-allocation arena for untyped tagged blocks (bytes).
+#ifndef STATIC_ALLOC_OTHER_BYTES
+#define STATIC_ALLOC_OTHER_BYTES (16 * 1024)
+#endif
+
+// GET /metrics: telemetry, route, loop, heap tag and display stats in Prometheus text format.
+#ifndef PROMETHEUS_METRICS_ENABLED
+#define PROMETHEUS_METRICS_ENABLED true
+#endif
+
+// On-device benchmarks (display, JPEG, FFat, macros storage, DuckyScript) via /api/bench and the test screen.
+#ifndef BENCH_ENABLED
+#define BENCH_ENABLED true
+#endif
+
+// Largest JPEG POST /api/bench accepts for its decode tests.
+#ifndef BENCH_JPEG_MAX_BYTES
+#define BENCH_JPEG_MAX_BYTES (128 * 1024)
+#endif
+
+// Frames timed per display benchmark (driver fill, LVGL redraw, each macro template).
+#ifndef BENCH_DISPLAY_FRAMES
+#define BENCH_DISPLAY_FRAMES 20
+#endif
+
+// ============================================================================
+// MQTT Configuration
+// ============================================================================
+
+// Run the MQTT client (connect, keepalive, publishing) on a dedicated task instead of the Arduino loop.
+#ifndef MQTT_TASK_ENABLED
+#define MQTT_TASK_ENABLED true
+#endif
+
+// MQTT task priority (loop() runs at 1).
+#ifndef MQTT_TASK_PRIORITY
+#define MQTT_TASK_PRIORITY 1
+#endif
+
+// Core the MQTT task is pinned to on dual-core targets (LVGL renders on core 0).
+#ifndef MQTT_TASK_CORE
+#define MQTT_TASK_CORE 1
+#endif
+
+// MQTT task stack (health and discovery JSON are serialized on it).
+#ifndef MQTT_TASK_STACK_BYTES
+#define MQTT_TASK_STACK_BYTES 8192
+#endif
+
+// Publishes queued for the MQTT task, also while offline (retained topics coalesce; extra events are dropped).
+#ifndef MQTT_PUBLISH_QUEUE_DEPTH
+#define MQTT_PUBLISH_QUEUE_DEPTH 16
+#endif
+
+// Queued non-retained publishes (button events) older than this (ms) are dropped instead of sent late (0 = never).
+#ifndef MQTT_PUBLISH_EVENT_MAX_AGE_MS
+#define MQTT_PUBLISH_EVENT_MAX_AGE_MS 60000
+#endif
+
+// Upper bound (ms) for the broker TCP connect and the CONNACK wait.
+#ifndef MQTT_CONNECT_TIMEOUT_MS
+#define MQTT_CONNECT_TIMEOUT_MS 3000
+#endif
+
+// First reconnect delay (ms); doubles per failed attempt.
+#ifndef MQTT_RECONNECT_MIN_MS
+#define MQTT_RECONNECT_MIN_MS 1000
+#endif
+
+// Longest reconnect delay (ms) the backoff grows to.
+#ifndef MQTT_RECONNECT_MAX_MS
+#define MQTT_RECONNECT_MAX_MS 60000
+#endif
+
+// Subscribe to <base>/cmd/+ for screen/sleep/wake/brightness/image_url/macro commands (no portal auth; use broker ACLs).
+#ifndef MQTT_COMMANDS_ENABLED
+#define MQTT_COMMANDS_ENABLED true
+#endif
+
+// Fleet macro sync: apply per-screen macro chunks from retained topics under MQTT_MACROS_SYNC_TOPIC (opt-in).
+#ifndef MQTT_MACROS_SYNC
+#define MQTT_MACROS_SYNC false
+#endif
+
+// Topic prefix shared by the fleet (<prefix>/manifest, <prefix>/screen/<n>).
+#ifndef MQTT_MACROS_SYNC_TOPIC
+#define MQTT_MACROS_SYNC_TOPIC "fleet/macros"
+#endif
+
+// Largest encoded macro screen sent or accepted (the MQTT client buffer grows to hold one).
+#ifndef MQTT_MACROS_SYNC_MAX_CHUNK_BYTES
+#define MQTT_MACROS_SYNC_MAX_CHUNK_BYTES 4096
+#endif
+
+// Quiet time after the last applied screen before the macros are saved and the version acked.
+#ifndef MQTT_MACROS_SYNC_SAVE_DELAY_MS
+#define MQTT_MACROS_SYNC_SAVE_DELAY_MS 2000
+#endif
+
+// Publish each health field to its own retained <base>/health/<field> topic and point HA discovery at it.
+#ifndef MQTT_HEALTH_SPLIT_TOPICS
+#define MQTT_HEALTH_SPLIT_TOPICS false
+#endif
+
+// With split topics, publish only fields that changed beyond the thresholds between full snapshots.
+#ifndef MQTT_HEALTH_DELTA_ENABLED
+#define MQTT_HEALTH_DELTA_ENABLED false
+#endif
+
+// With split topics, every Nth health interval is a full snapshot (all fields + the batched health/state).
+#ifndef MQTT_HEALTH_FULL_EVERY_N
+#define MQTT_HEALTH_FULL_EVERY_N 10
+#endif
+
+// Relative change (percent) a numeric health field needs before delta publishing resends it.
+#ifndef MQTT_HEALTH_DELTA_PCT
+#define MQTT_HEALTH_DELTA_PCT 5
+#endif
+
+// Stream HA discovery configs (beginPublish/write) so their size is not bounded by MQTT_MAX_PACKET_SIZE.
+#ifndef MQTT_DISCOVERY_STREAMED
+#define MQTT_DISCOVERY_STREAMED true
+#endif
+
+// Skip HA discovery when its content hash matches the one in NVS (HA's homeassistant/status birth forces a resend).
+#ifndef MQTT_DISCOVERY_SKIP_UNCHANGED
+#define MQTT_DISCOVERY_SKIP_UNCHANGED true
+#endif
+
+// ============================================================================
+// Power Management
+// ============================================================================
+
+// While the screen saver is asleep, scale the CPU clock down (esp_pm DFS) and allow light sleep.
+#ifndef POWER_IDLE_ENABLED
+#define POWER_IDLE_ENABLED false
+#endif
+
+// Lowest CPU clock (MHz) while idle (the XTAL frequency, or 80/160).
+#ifndef POWER_IDLE_MIN_FREQ_MHZ
+#define POWER_IDLE_MIN_FREQ_MHZ 40
+#endif
+
+// Enter automatic light sleep while idle (needs a core built with CONFIG_FREERTOS_USE_TICKLESS_IDLE).
+#ifndef POWER_IDLE_LIGHT_SLEEP
+#define POWER_IDLE_LIGHT_SLEEP true
+#endif
+
+// Switch WiFi to WIFI_PS_MAX_MODEM while idle (less current, slower HTTP/MQTT replies).
+#ifndef POWER_IDLE_WIFI_MAX_MODEM
+#define POWER_IDLE_WIFI_MAX_MODEM false
+#endif
+
+// How long (ms) an HTTP request or MQTT message keeps full clock and blocks light sleep.
+#ifndef POWER_ACTIVITY_HOLD_MS
+#define POWER_ACTIVITY_HOLD_MS 2000
+#endif
+
+// ============================================================================
+// Main Loop Scheduler
+// ============================================================================
+
+// Longest (ms) the loop task blocks between scheduler passes (bounds a missed wakeup).
+#ifndef LOOP_SCHEDULER_MAX_SLEEP_MS
+#define LOOP_SCHEDULER_MAX_SLEEP_MS 100
+#endif
+
+// A scheduled callback starting this many ms after its deadline is counted as late.
+#ifndef LOOP_SCHEDULER_LATE_MS
+#define LOOP_SCHEDULER_LATE_MS 20
+#endif
+
+// A loop() scheduler pass doing more work than this (us) counts in loop_over_budget_window.
+#ifndef LOOP_PASS_BUDGET_US
+#define LOOP_PASS_BUDGET_US 20000
+#endif
+
+// An LVGL task cycle holding the display lock longer than this (us) counts in lvgl_over_budget_window.
+#ifndef LVGL_CYCLE_BUDGET_US
+#define LVGL_CYCLE_BUDGET_US 33000
+#endif
+
+// Capacity of the scheduler's callback table.
+#ifndef LOOP_SCHEDULER_MAX_ENTRIES
+#define LOOP_SCHEDULER_MAX_ENTRIES 16
+#endif
+
+// ============================================================================
+// Task Placement
+// ============================================================================
+// Core (0/1, -1 = either; ignored on single-core chips), priority and stack of
+// the long-running tasks. MQTT_TASK_* and IMAGE_API_WORKER_* live with their
+// features. Library tasks read their own defines, which build.sh forwards from
+// board_overrides.h: CONFIG_ASYNC_TCP_RUNNING_CORE / _PRIORITY / _STACK_SIZE
+// and CONFIG_BT_NIMBLE_PINNED_TO_CORE / CONFIG_BT_NIMBLE_HOST_TASK_STACK_SIZE.
+
+// Core the LVGL render task is pinned to (the Arduino loop runs on core 1).
+#ifndef LVGL_TASK_CORE
+#define LVGL_TASK_CORE 0
+#endif
+
+// LVGL render task priority (loop() runs at 1).
+#ifndef LVGL_TASK_PRIORITY
+#define LVGL_TASK_PRIORITY 1
+#endif
+
+// LVGL render task stack (bytes).
+#ifndef LVGL_TASK_STACK_BYTES
+#define LVGL_TASK_STACK_BYTES 8192
+#endif
+
+// LVGL flush task priority (keep above LVGL_TASK_PRIORITY so queued bands start at once).
+#ifndef LVGL_FLUSH_TASK_PRIORITY
+#define LVGL_FLUSH_TASK_PRIORITY 2
+#endif
+
+// LVGL flush task stack (bytes).
+#ifndef LVGL_FLUSH_TASK_STACK_BYTES
+#define LVGL_FLUSH_TASK_STACK_BYTES 4096
+#endif
+
+// Core of the CPU usage sampler task (-1 = either core).
+#ifndef CPU_MONITOR_TASK_CORE
+#define CPU_MONITOR_TASK_CORE -1
+#endif
+
+// CPU usage sampler task priority.
+#ifndef CPU_MONITOR_TASK_PRIORITY
+#define CPU_MONITOR_TASK_PRIORITY 1
+#endif
+
+// CPU usage sampler task stack (bytes).
+#ifndef CPU_MONITOR_TASK_STACK_BYTES
+#define CPU_MONITOR_TASK_STACK_BYTES 3072
+#endif
+
+// Busiest tasks of each CPU sample reported in /api/health cpu_tasks.
+#ifndef CPU_TASK_TOP_N
+#define CPU_TASK_TOP_N 6
+#endif
+
+// CPU usage (percent) at which the busiest tasks are logged (at most every 10 s).
+#ifndef CPU_TASK_ALERT_PERCENT
+#define CPU_TASK_ALERT_PERCENT 90
+#endif
+
+// Core of the log drain task (-1 = either core).
+#ifndef LOG_TASK_CORE
+#define LOG_TASK_CORE -1
+#endif
+
+// Log drain task priority (keep low: it only moves queued lines to serial).
+#ifndef LOG_TASK_PRIORITY
+#define LOG_TASK_PRIORITY 1
+#endif
+
+// Log drain task stack (bytes).
+#ifndef LOG_TASK_STACK_BYTES
+#define LOG_TASK_STACK_BYTES 3072
+#endif
+
+// Timer service task priority (health window sampler, BLE timers; -1 = keep CONFIG_FREERTOS_TIMER_TASK_PRIORITY).
+#ifndef TIMER_TASK_PRIORITY
+#define TIMER_TASK_PRIORITY -1
+#endif
+
 // ============================================================================
 // Additional Default Configuration Settings
 // ============================================================================
@@ -178,11 +882,152 @@
 #define LVGL_BUFFER_SIZE (DISPLAY_WIDTH * 10)  // 10 lines buffer
 #endif
 
+// Allocate a second LVGL draw buffer so rendering overlaps an async driver flush.
+#ifndef LVGL_DOUBLE_BUFFER
+#define LVGL_DOUBLE_BUFFER false
+#endif
+
+// Pause LVGL timers, screen updates and flushes while the screen saver is asleep.
+#ifndef DISPLAY_SUSPEND_RENDER_ON_SLEEP
+#define DISPLAY_SUSPEND_RENDER_ON_SLEEP true
+#endif
+
+// Let the LEDC peripheral run screen-saver backlight fades when the driver supports it (else software steps).
+#ifndef BACKLIGHT_HW_FADE_ENABLED
+#define BACKLIGHT_HW_FADE_ENABLED true
+#endif
+
+// While render is suspended, also put the panel into its sleep/display-off state (driver-dependent).
+#ifndef DISPLAY_SLEEP_PANEL_ON_SCREEN_SAVER
+#define DISPLAY_SLEEP_PANEL_ON_SCREEN_SAVER false
+#endif
+
+// Keep this many macro screens on each side of the active one pre-built (0 = build on first show).
+#ifndef MACROPAD_PREWARM_NEIGHBORS
+#define MACROPAD_PREWARM_NEIGHBORS 0
+#endif
+
+// Keep at most this many macro screens built; the least recently used hidden one is destroyed (0 = no cap).
+#ifndef MACROPAD_MAX_BUILT_SCREENS
+#define MACROPAD_MAX_BUILT_SCREENS 0
+#endif
+
+// Swipe left/right on a macro screen to show the next/previous one (needs HAS_TOUCH).
+#ifndef MACROPAD_GESTURES
+#define MACROPAD_GESTURES true
+#endif
+
+// Screen id for a swipe up on a macro screen ("back" = previous screen, "" = none).
+#ifndef MACROPAD_GESTURE_UP_SCREEN
+#define MACROPAD_GESTURE_UP_SCREEN ""
+#endif
+
+// Screen id for a swipe down on a macro screen ("back" = previous screen, "" = none).
+#ifndef MACROPAD_GESTURE_DOWN_SCREEN
+#define MACROPAD_GESTURE_DOWN_SCREEN "back"
+#endif
+
+// Screen id for a long-press on a macro screen ("" = none: the button is clicked on release).
+#ifndef MACROPAD_GESTURE_LONG_PRESS_SCREEN
+#define MACROPAD_GESTURE_LONG_PRESS_SCREEN ""
+#endif
+
+// Slots in the cross-task display command queue (power of two).
+#ifndef DISPLAY_CMD_QUEUE_DEPTH
+#define DISPLAY_CMD_QUEUE_DEPTH 16
+#endif
+
+// Macro taps kept for the touch-to-HID latency percentiles in /api/health and MQTT.
+#ifndef TAP_LATENCY_HIST_SAMPLES
+#define TAP_LATENCY_HIST_SAMPLES 32
+#endif
+
+// Rendered frames kept for the render/flush/present percentiles in /api/health.
+#ifndef DISPLAY_PERF_HIST_SAMPLES
+#define DISPLAY_PERF_HIST_SAMPLES 64
+#endif
+
+// Sync panel writes to the tearing-effect (TE) output when the driver has a TE pin
+// (Arduino_GFX: LCD_QSPI_TE, ESP_Panel: TFT_TE). Trades up to one refresh of latency for no tearing.
+#ifndef DISPLAY_TE_SYNC_ENABLED
+#define DISPLAY_TE_SYNC_ENABLED false
+#endif
+
+// Longest TE wait before writing anyway (ms); one refresh at ~50-60Hz plus margin.
+#ifndef DISPLAY_TE_WAIT_TIMEOUT_MS
+#define DISPLAY_TE_WAIT_TIMEOUT_MS 25
+#endif
+
+// Also TE-sync each direct-image (StripDecoder) strip; adds up to one refresh per strip.
+#ifndef DISPLAY_TE_SYNC_STRIPS
+#define DISPLAY_TE_SYNC_STRIPS true
+#endif
+
+// Buffered drivers present only the rows LVGL touched since the last present() (instead of the full canvas).
+#ifndef DISPLAY_BUFFERED_DIRTY_PRESENT
+#define DISPLAY_BUFFERED_DIRTY_PRESENT true
+#endif
+
+// Render LVGL RGB565 in big-endian byte order (LV_COLOR_16_SWAP) so flushes need no per-pixel swap.
+#ifndef LVGL_COLOR_16_SWAP
+#define LVGL_COLOR_16_SWAP false
+#endif
+
+// Run panel transfers on a dedicated flush task (dual-core only) so LVGL renders while the bus is busy.
+#ifndef LVGL_FLUSH_TASK_ENABLED
+#define LVGL_FLUSH_TASK_ENABLED false
+#endif
+
+// Core the flush task is pinned to (LVGL rendering stays on core 0).
+#ifndef LVGL_FLUSH_TASK_CORE
+#define LVGL_FLUSH_TASK_CORE 1
+#endif
+
+// Max completed draw areas queued for the flush task.
+#ifndef LVGL_FLUSH_QUEUE_DEPTH
+#define LVGL_FLUSH_QUEUE_DEPTH 2
+#endif
+
+// Longest LVGL task sleep when idle (task is woken early by display_manager_request_render()).
+#ifndef LVGL_TASK_MAX_SLEEP_MS
+#define LVGL_TASK_MAX_SLEEP_MS 500
+#endif
+
 // LVGL tick period in milliseconds.
 #ifndef LVGL_TICK_PERIOD_MS
 #define LVGL_TICK_PERIOD_MS 5
 #endif
 
+// GET /api/display/screenshot and the /api/display/mirror WebSocket (see screen_capture.h).
+#ifndef SCREEN_CAPTURE_ENABLED
+#define SCREEN_CAPTURE_ENABLED false
+#endif
+
+// Keep capturing this long (ms) after the last screenshot or mirror client; then the shadow framebuffer is freed.
+#ifndef SCREEN_CAPTURE_LINGER_MS
+#define SCREEN_CAPTURE_LINGER_MS 30000
+#endif
+
+// Longest a screenshot waits for a complete frame (ms) before ending the body short.
+#ifndef SCREEN_CAPTURE_WAIT_MS
+#define SCREEN_CAPTURE_WAIT_MS 2000
+#endif
+
+// Mirror messages per second over /api/display/mirror (0 = no mirror WebSocket).
+#ifndef SCREEN_MIRROR_FPS
+#define SCREEN_MIRROR_FPS 2
+#endif
+
+// Most encoded bytes per mirror message; a larger change goes out over several.
+#ifndef SCREEN_MIRROR_MAX_BYTES
+#define SCREEN_MIRROR_MAX_BYTES (16 * 1024)
+#endif
+
+// Mirror clients at once; further connections are refused.
+#ifndef SCREEN_MIRROR_MAX_CLIENTS
+#define SCREEN_MIRROR_MAX_CLIENTS 2
+#endif
+
 // ============================================================================
 // Backlight Configuration
 // ============================================================================
@@ -206,7 +1051,7 @@
 
 // Touch driver selection
 // Available drivers:
-//   TOUCH_DRIVER_XPT2046 (1) - XPT2046 resistive touch (via TFT_eSPI)
+//   TOUCH_DRIVER_XPT2046 (1) - XPT2046 resistive touch (own SPI bus)
 //   TOUCH_DRIVER_FT6236 (2) - FT6236 capacitive touch (future support)
 //   TOUCH_DRIVER_AXS15231B (3) - AXS15231B capacitive touch (I2C, JC3248W535)
 #define TOUCH_DRIVER_XPT2046 1
@@ -221,6 +1066,21 @@
 #define LVGL_BUFFER_PREFER_INTERNAL false
 #endif
 
+// TFT_eSPI: send LVGL bands with pushPixelsDMA (needs LVGL_DOUBLE_BUFFER + LVGL_BUFFER_PREFER_INTERNAL).
+#ifndef TFT_ESPI_DMA_ENABLED
+#define TFT_ESPI_DMA_ENABLED false
+#endif
+
+// Serve LVGL allocations from one PSRAM arena reserved at lv_init (TLSF); overflow goes to the heap.
+#ifndef LVGL_ARENA_ENABLED
+#define LVGL_ARENA_ENABLED true
+#endif
+
+// LVGL arena size (bytes).
+#ifndef LVGL_ARENA_BYTES
+#define LVGL_ARENA_BYTES (256 * 1024)
+#endif
+
 // ESP_Panel (ST77916 QSPI): prefer allocating the optional byte-swap buffer in
 // internal RAM first for maximum flush reliability.
 // Prefer internal RAM over PSRAM for ESP_Panel swap buffer allocation.
@@ -228,6 +1088,44 @@
 #define ESP_PANEL_SWAPBUF_PREFER_INTERNAL true
 #endif
 
+// ============================================================================
+// Heap Placement (see heap_placement.h)
+// ============================================================================
+// Heap orders for the HEAP_PLACE_* class mappings below:
+//   HEAP_ORDER_INTERNAL (1)           - internal RAM only
+//   HEAP_ORDER_INTERNAL_PSRAM (2)     - internal RAM, then PSRAM
+//   HEAP_ORDER_PSRAM_INTERNAL (3)     - PSRAM, then internal RAM
+//   HEAP_ORDER_DMA_INTERNAL_PSRAM (4) - DMA-capable internal RAM, any internal RAM, then PSRAM
+#define HEAP_ORDER_INTERNAL 1
+#define HEAP_ORDER_INTERNAL_PSRAM 2
+#define HEAP_ORDER_PSRAM_INTERNAL 3
+#define HEAP_ORDER_DMA_INTERNAL_PSRAM 4
+
+// Heap order for buffers a peripheral reads by DMA (panel flush / swap buffers).
+#ifndef HEAP_PLACE_DMA
+#define HEAP_PLACE_DMA HEAP_ORDER_DMA_INTERNAL_PSRAM
+#endif
+
+// Heap order for latency-critical buffers (inflate state, decoder work areas on hot paths).
+#ifndef HEAP_PLACE_LATENCY
+#define HEAP_PLACE_LATENCY HEAP_ORDER_INTERNAL_PSRAM
+#endif
+
+// Heap order for large or long-lived blocks (LVGL objects, draw buffers, icons, image pool).
+#ifndef HEAP_PLACE_BULK
+#define HEAP_PLACE_BULK HEAP_ORDER_PSRAM_INTERNAL
+#endif
+
+// Heap order for per-request blocks (bodies, JSON documents, uploads, decode and OTA buffers).
+#ifndef HEAP_PLACE_TRANSIENT
+#define HEAP_PLACE_TRANSIENT HEAP_ORDER_PSRAM_INTERNAL
+#endif
+
+// With PSRAM, a transient block over 1 KB falls back to internal RAM only while this much stays free (0 = always).
+#ifndef HEAP_PLACE_TRANSIENT_INTERNAL_RESERVE_BYTES
+#define HEAP_PLACE_TRANSIENT_INTERNAL_RESERVE_BYTES (48 * 1024)
+#endif
+
 // ============================================================================
 // Memory Diagnostics (instrumentation)
 // ============================================================================
@@ -244,11 +1142,79 @@
 #define MEMORY_TRIPWIRE_INTERNAL_MIN_BYTES (10 * 1024)
 #endif
 
+// Enable tiered load shedding when the heap runs low (see memory_pressure.h).
+#ifndef MEMORY_PRESSURE_ENABLED
+#define MEMORY_PRESSURE_ENABLED true
+#endif
+
+// Internal free heap below which memory pressure escalates (bytes).
+#ifndef MEMORY_PRESSURE_FREE_BYTES
+#define MEMORY_PRESSURE_FREE_BYTES (32 * 1024)
+#endif
+
+// Largest internal free block below which memory pressure escalates (bytes).
+#ifndef MEMORY_PRESSURE_BLOCK_BYTES
+#define MEMORY_PRESSURE_BLOCK_BYTES (12 * 1024)
+#endif
+
+// Largest PSRAM free block below which memory pressure escalates (bytes; boards with PSRAM).
+#ifndef MEMORY_PRESSURE_PSRAM_BLOCK_BYTES
+#define MEMORY_PRESSURE_PSRAM_BLOCK_BYTES (64 * 1024)
+#endif
+
+// Minimum time between two escalation steps while pressure lasts (ms).
+#ifndef MEMORY_PRESSURE_STEP_MS
+#define MEMORY_PRESSURE_STEP_MS 2000
+#endif
+
+// Time the heap must stay healthy before each tier is undone (ms).
+#ifndef MEMORY_PRESSURE_RECOVER_MS
+#define MEMORY_PRESSURE_RECOVER_MS 15000
+#endif
+
 // Select the touch HAL backend (one of the TOUCH_DRIVER_* constants).
 #ifndef TOUCH_DRIVER
 #define TOUCH_DRIVER TOUCH_DRIVER_XPT2046  // Default to XPT2046
 #endif
 
+// CST816S / XPT2046: read touch from a task woken by the TOUCH_INT / TOUCH_IRQ
+// line instead of over the bus on every LVGL indev poll (no bus traffic while
+// nobody touches the panel).
+// Needs TOUCH_INT (CST816S) or TOUCH_IRQ (XPT2046) >= 0; AXS15231B already gates its reads on its own INT ISR.
+#ifndef TOUCH_INT_SAMPLING
+#define TOUCH_INT_SAMPLING true
+#endif
+
+// XPT2046: X/Y conversions per touch read; the median of each axis is used (odd, 1..15).
+#ifndef XPT2046_SAMPLES
+#define XPT2046_SAMPLES 5
+#endif
+
+// XPT2046: minimum pressure (Z) for a valid touch; lighter contact reads as released.
+#ifndef XPT2046_Z_THRESHOLD
+#define XPT2046_Z_THRESHOLD 400
+#endif
+
+// Timestamped touch samples buffered between the sampling task and LVGL reads.
+#ifndef TOUCH_SAMPLE_RING
+#define TOUCH_SAMPLE_RING 16
+#endif
+
+// Shortest swipe, in percent of the shorter display side (touch_gesture.h).
+#ifndef TOUCH_SWIPE_MIN_DISTANCE_PCT
+#define TOUCH_SWIPE_MIN_DISTANCE_PCT 25
+#endif
+
+// Longest press-to-lift time that still counts as a swipe (slower drags are ignored).
+#ifndef TOUCH_SWIPE_MAX_MS
+#define TOUCH_SWIPE_MAX_MS 600
+#endif
+
+// Hold time (without moving) that makes a long-press.
+#ifndef TOUCH_LONG_PRESS_MS
+#define TOUCH_LONG_PRESS_MS 800
+#endif
+
 // ============================================================================
 // Image API Configuration
 // ============================================================================
@@ -280,6 +1246,59 @@
 #define HAS_ICONS false
 #endif
 
+// Store installed icons in one packed FFat file with a sorted index (icon_atlas.h)
+// instead of one /icons/<id>.bin per icon.
+#ifndef ICON_STORE_ATLAS
+#define ICON_STORE_ATLAS true
+#endif
+
+// Use build-time mask icon sizes (ic_<id>_<N>, see build.sh ICON_MASK_SIZES) instead of
+// upscaling 64px masks to 2x at runtime. Costs flash (~16 KB per icon at 128px).
+#ifndef ICON_MASK_PRESCALED
+#define ICON_MASK_PRESCALED false
+#endif
+
+// Preload installed icons used by the macro screens into the icon cache from a
+// low-priority task at boot (default screen first), so first visits do not stall on FFat.
+#ifndef ICON_STORE_WARMUP
+#define ICON_STORE_WARMUP true
+#endif
+
+// Serve icons straight from a mapped, read-only "icons" partition when the partition table has one (icon_pack.h).
+#ifndef ICON_PACK_ENABLED
+#define ICON_PACK_ENABLED true
+#endif
+
+// Data subtype of the "icons" partition (custom subtypes are 0x40-0xFE).
+#ifndef ICON_PACK_PARTITION_SUBTYPE
+#define ICON_PACK_PARTITION_SUBTYPE 0x40
+#endif
+
+// Render macro button labels with an LVGL binary font loaded from FFat (/fonts/label.bin) when one is uploaded (label_font.h).
+#ifndef LABEL_FONT_ENABLED
+#define LABEL_FONT_ENABLED true
+#endif
+
+// Largest label font file accepted by POST /api/fonts/label (it is loaded whole into the LVGL heap).
+#ifndef LABEL_FONT_MAX_BYTES
+#define LABEL_FONT_MAX_BYTES (128 * 1024)
+#endif
+
+// Render each macro label once into a PSRAM A8 bitmap and draw it as an image (no-op without PSRAM).
+#ifndef LABEL_CACHE_ENABLED
+#define LABEL_CACHE_ENABLED true
+#endif
+
+// Label bitmaps kept (shown and recently used).
+#ifndef LABEL_CACHE_ENTRIES
+#define LABEL_CACHE_ENTRIES 48
+#endif
+
+// PSRAM budget for label bitmaps (bytes); unreferenced ones are evicted LRU beyond it.
+#ifndef LABEL_CACHE_MAX_BYTES
+#define LABEL_CACHE_MAX_BYTES (96 * 1024)
+#endif
+
 // Image API configuration (only relevant when HAS_IMAGE_API is true)
 // Max bytes accepted for full image uploads (JPEG).
 #ifndef IMAGE_API_MAX_SIZE_BYTES
@@ -301,6 +1320,227 @@
 #define IMAGE_API_MAX_TIMEOUT_MS (86400UL * 1000UL)  // 24 hours max timeout
 #endif
 
+// Keep a PSRAM snapshot of the screen an image covers and put it back on the panel instantly on return.
+#ifndef IMAGE_API_RETURN_SNAPSHOT
+#define IMAGE_API_RETURN_SNAPSHOT true
+#endif
+
+// Decode full-image uploads while the HTTP body arrives (needs only a small ring, not the whole JPEG).
+#ifndef IMAGE_API_STREAM_UPLOAD
+#define IMAGE_API_STREAM_UPLOAD true
+#endif
+
+// Decode /api/display/image_url downloads as bytes arrive instead of buffering the whole body.
+#ifndef IMAGE_API_STREAM_URL
+#define IMAGE_API_STREAM_URL true
+#endif
+
+// Bytes buffered between the upload handler and the streaming decoder.
+#ifndef IMAGE_API_STREAM_RING_BYTES
+#define IMAGE_API_STREAM_RING_BYTES (16 * 1024)
+#endif
+
+// Ring space kept free for data already in flight when the upload stops opening
+// its TCP window. Must cover the lwIP receive window plus one segment.
+#ifndef IMAGE_API_STREAM_ACK_RESERVE_BYTES
+#define IMAGE_API_STREAM_ACK_RESERVE_BYTES (8 * 1024)
+#endif
+
+// Streaming decode gives up when no bytes arrive for this long (ms).
+#ifndef IMAGE_API_STREAM_IDLE_TIMEOUT_MS
+#define IMAGE_API_STREAM_IDLE_TIMEOUT_MS 3000
+#endif
+
+// Run image downloads/decodes on a dedicated task instead of the Arduino loop.
+#ifndef IMAGE_API_WORKER_ENABLED
+#define IMAGE_API_WORKER_ENABLED true
+#endif
+
+// Image worker task priority (loop() runs at 1).
+#ifndef IMAGE_API_WORKER_PRIORITY
+#define IMAGE_API_WORKER_PRIORITY 1
+#endif
+
+// Core the image worker is pinned to on dual-core targets (LVGL renders on core 0).
+#ifndef IMAGE_API_WORKER_CORE
+#define IMAGE_API_WORKER_CORE 1
+#endif
+
+// Image worker stack (TLS handshakes for image_url need the headroom).
+#ifndef IMAGE_API_WORKER_STACK_BYTES
+#define IMAGE_API_WORKER_STACK_BYTES 10240
+#endif
+
+// Jobs the HTTP handlers can queue for the image worker.
+#ifndef IMAGE_API_WORKER_QUEUE_DEPTH
+#define IMAGE_API_WORKER_QUEUE_DEPTH 4
+#endif
+
+// Uploaded strips that may wait for decode, so strip N+1 uploads while strip N decodes.
+#ifndef IMAGE_STRIP_PIPELINE_DEPTH
+#define IMAGE_STRIP_PIPELINE_DEPTH 3
+#endif
+
+// Reserve fixed image body buffers at boot instead of malloc/free per upload (limits heap fragmentation).
+#ifndef IMAGE_API_POOL_ENABLED
+#define IMAGE_API_POOL_ENABLED true
+#endif
+
+// Pool slots for whole JPEGs (IMAGE_API_MAX_SIZE_BYTES each): one decoding + one uploading.
+#ifndef IMAGE_API_POOL_LARGE_SLOTS
+#define IMAGE_API_POOL_LARGE_SLOTS 2
+#endif
+
+// Pool slots for strips / raw batches: the strip queue plus the one being received.
+#ifndef IMAGE_API_POOL_SMALL_SLOTS
+#define IMAGE_API_POOL_SMALL_SLOTS (IMAGE_STRIP_PIPELINE_DEPTH + 1)
+#endif
+
+// Size of one small pool slot.
+#ifndef IMAGE_API_POOL_SMALL_BYTES
+#define IMAGE_API_POOL_SMALL_BYTES (16 * 1024)
+#endif
+
+// Allow the pool in internal RAM when no PSRAM is fitted (otherwise those boards keep per-upload malloc).
+#ifndef IMAGE_API_POOL_INTERNAL
+#define IMAGE_API_POOL_INTERNAL false
+#endif
+
+// Accept pre-rendered RGB565 rectangles (raw/RLE/LZ4) at /api/display/image/raw.
+#ifndef IMAGE_API_RAW_UPLOAD
+#define IMAGE_API_RAW_UPLOAD true
+#endif
+
+// Accept partial updates (lists of JPEG / RGB565 tiles) at /api/display/image/tiles.
+#ifndef IMAGE_API_TILE_UPLOAD
+#define IMAGE_API_TILE_UPLOAD true
+#endif
+
+// Persistent binary WebSocket channel for strips, rectangles and tile batches at /api/display/ws.
+#ifndef IMAGE_API_WEBSOCKET
+#define IMAGE_API_WEBSOCKET true
+#endif
+
+// Opt-in UDP multicast receive of strip-sequenced JPEGs for fleets (group/port set in /api/config).
+#ifndef IMAGE_API_MULTICAST
+#define IMAGE_API_MULTICAST false
+#endif
+
+// UDP port joined when the configured multicast port is 0.
+#ifndef IMAGE_API_MULTICAST_DEFAULT_PORT
+#define IMAGE_API_MULTICAST_DEFAULT_PORT 5010
+#endif
+
+// Most datagrams one multicast strip may be cut into.
+#ifndef IMAGE_API_MULTICAST_MAX_FRAGMENTS
+#define IMAGE_API_MULTICAST_MAX_FRAGMENTS 256
+#endif
+
+// How long a completed multicast strip waits for a strip queue slot before it counts as lost.
+#ifndef IMAGE_API_MULTICAST_QUEUE_WAIT_MS
+#define IMAGE_API_MULTICAST_QUEUE_WAIT_MS 200
+#endif
+
+// Per-URL ETag/Last-Modified cache for image_url (conditional GET; 0 disables).
+#ifndef IMAGE_API_URL_CACHE_ENTRIES
+#define IMAGE_API_URL_CACHE_ENTRIES 4
+#endif
+
+// Largest image_url JPEG body kept in PSRAM so a 304 can be re-decoded without a download.
+#ifndef IMAGE_API_URL_CACHE_BODY_MAX_BYTES
+#define IMAGE_API_URL_CACHE_BODY_MAX_BYTES (256 * 1024)
+#endif
+
+// Keep-alive connections kept open for image_url / playlist fetches, per scheme+host+port; 0 disables.
+#ifndef IMAGE_API_URL_KEEPALIVE_CONNS
+#define IMAGE_API_URL_KEEPALIVE_CONNS 2
+#endif
+
+// An idle keep-alive connection is closed after this long (ms).
+#ifndef IMAGE_API_URL_KEEPALIVE_IDLE_MS
+#define IMAGE_API_URL_KEEPALIVE_IDLE_MS 45000
+#endif
+
+// LVGL image screen keeps two panel-sized PSRAM buffers and flips between them (no per-image malloc).
+#ifndef LVGL_IMAGE_DOUBLE_BUFFER
+#define LVGL_IMAGE_DOUBLE_BUFFER true
+#endif
+
+// LVGL image uploads paint top-down while decoding instead of appearing when complete (needs LVGL_IMAGE_DOUBLE_BUFFER).
+#ifndef LVGL_IMAGE_PROGRESSIVE
+#define LVGL_IMAGE_PROGRESSIVE true
+#endif
+
+// Output rows decoded between progressive redraws.
+#ifndef LVGL_IMAGE_PROGRESSIVE_ROWS
+#define LVGL_IMAGE_PROGRESSIVE_ROWS 16
+#endif
+
+// On-device URL playlist with decode-ahead (/api/display/playlist; needs LV_USE_IMG).
+#ifndef IMAGE_PLAYLIST_ENABLED
+#define IMAGE_PLAYLIST_ENABLED true
+#endif
+
+// Max URLs in the image playlist.
+#ifndef IMAGE_PLAYLIST_MAX_ENTRIES
+#define IMAGE_PLAYLIST_MAX_ENTRIES 8
+#endif
+
+// Accept full images larger (or smaller) than the panel: decode at the largest TJpgDec scale that fits.
+#ifndef IMAGE_API_SCALED_DECODE
+#define IMAGE_API_SCALED_DECODE true
+#endif
+
+// Pack TJpgDec output four pixels per step with word loads/stores (false = one pixel per step).
+#ifndef IMAGE_PACK_UNROLLED
+#define IMAGE_PACK_UNROLLED true
+#endif
+
+// JPEG decoder engine (see jpeg_engine.h)
+// Available engines:
+//   JPEG_DECODER_TJPGD_ROM (1) - TJpgDec in ROM (every target, 4 KB work area, RGB888 out)
+//   JPEG_DECODER_JPEGDEC (2) - JPEGDEC library (RGB565 out, ESP32-S3 SIMD, ~20 KB per decoder)
+//   JPEG_DECODER_ESP_HW (3) - hardware JPEG codec (ESP32-P4; buffered, unscaled images only)
+// Streams, scaled decodes and BGR565 output fall back to TJpgDec where the engine can't.
+#define JPEG_DECODER_TJPGD_ROM 1
+#define JPEG_DECODER_JPEGDEC 2
+#define JPEG_DECODER_ESP_HW 3
+
+// Select the JPEG decoder engine (one of the JPEG_DECODER_* constants).
+#ifndef JPEG_DECODER
+#define JPEG_DECODER JPEG_DECODER_TJPGD_ROM
+#endif
+
+// Split full-frame uploads with MCU-row restart intervals across both cores (dual-core + PSRAM only).
+#ifndef IMAGE_API_PARALLEL_DECODE
+#define IMAGE_API_PARALLEL_DECODE true
+#endif
+
+// Core the parallel-decode helper task runs on (the other half decodes on IMAGE_API_WORKER_CORE).
+#ifndef IMAGE_API_PARALLEL_CORE
+#define IMAGE_API_PARALLEL_CORE 0
+#endif
+
+// Record per-stage timings of recent image operations (GET /api/display/image/stats).
+#ifndef IMAGE_API_PROFILE
+#define IMAGE_API_PROFILE true
+#endif
+
+// Number of image operations kept by the profiler.
+#ifndef IMAGE_API_PROFILE_HISTORY
+#define IMAGE_API_PROFILE_HISTORY 8
+#endif
+
+// Pull MJPEG (multipart/x-mixed-replace) camera feeds at /api/display/stream (needs IMAGE_API_STREAM_URL).
+#ifndef IMAGE_API_MJPEG_STREAM
+#define IMAGE_API_MJPEG_STREAM true
+#endif
+
+// Default frame-rate cap for /api/display/stream (faster frames are dropped; 0 = uncapped).
+#ifndef IMAGE_API_MJPEG_DEFAULT_MAX_FPS
+#define IMAGE_API_MJPEG_DEFAULT_MAX_FPS 10
+#endif
+
 // Image API performance tuning
 // Controls how many rows the strip decoder batches into one LCD transaction.
 // Higher = fewer LCD transactions (faster) but more temporary RAM.
@@ -0,0 +1,60 @@
+#include "boot_profile.h"
+
+#include "log_manager.h"
+
+#include <freertos/FreeRTOS.h>
+
+namespace {
+
+constexpr size_t kCount = (size_t)BootMilestone::Count;
+
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+volatile uint32_t g_ms[kCount] = {};
+
+} // namespace
+
+const char* boot_milestone_name(BootMilestone m) {
+    switch (m) {
+        case BootMilestone::Setup: return "setup";
+        case BootMilestone::FirstPixel: return "first_pixel";
+        case BootMilestone::Macros: return "macros";
+        case BootMilestone::WifiUp: return "wifi";
+        case BootMilestone::BleAdvertising: return "ble";
+        case BootMilestone::PortalReady: return "portal";
+        case BootMilestone::Ready: return "ready";
+        case BootMilestone::MacrosAll: return "macros_all";
+        default: return "?";
+    }
+}
+
+void boot_profile_mark(BootMilestone m) {
+    const size_t i = (size_t)m;
+    if (i >= kCount || g_ms[i]) return;
+
+    const uint32_t now = millis();
+    portENTER_CRITICAL(&g_mux);
+    if (!g_ms[i]) g_ms[i] = now ? now : 1;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+uint32_t boot_profile_get_ms(BootMilestone m) {
+    const size_t i = (size_t)m;
+    return i < kCount ? g_ms[i] : 0;
+}
+
+void boot_profile_log() {
+    char line[160];
+    size_t len = 0;
+    line[0] = '\0';
+    for (size_t i = 0; i < kCount && len < sizeof(line); i++) {
+        const uint32_t ms = g_ms[i];
+        const char* name = boot_milestone_name((BootMilestone)i);
+        const char* sep = i ? " " : "";
+        if (ms) {
+            len += snprintf(line + len, sizeof(line) - len, "%s%s=%lu", sep, name, (unsigned long)ms);
+        } else {
+            len += snprintf(line + len, sizeof(line) - len, "%s%s=-", sep, name);
+        }
+    }
+    Logger.logMessage("Boot", line);
+}
@@ -0,0 +1,45 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include "board_config.h"
+
+// Boot Profile
+// millis() at each startup milestone, recorded once by whichever task gets
+// there first:
+//   setup        setup() entered (after ROM, bootloader and core init)
+//   first_pixel  first frame on the panel (the splash)
+//   macros       default macro screen loaded
+//   wifi         station got an IP
+//   ble          BLE keyboard advertising (later on demand builds)
+//   portal       web server listening
+//   ready        first runtime screen (normally macro1) on the panel
+//   macros_all   every macro screen loaded (BOOT_MACROS_LAZY: in the background)
+// /api/health reports them as boot_ms; setup() logs them on one line when it
+// finishes.
+
+#include <Arduino.h>
+
+enum class BootMilestone : uint8_t {
+    Setup,
+    FirstPixel,
+    Macros,
+    WifiUp,
+    BleAdvertising,
+    PortalReady,
+    Ready,
+    MacrosAll,
+    Count
+};
+
+const char* boot_milestone_name(BootMilestone m);
+
+// Record the milestone if it has not been reached yet (any task, cheap once set).
+void boot_profile_mark(BootMilestone m);
+
+// millis() when the milestone was reached; 0 = not yet.
+uint32_t boot_profile_get_ms(BootMilestone m);
+
+// One "setup=.. first_pixel=.." log line; unreached milestones show as '-'.
+void boot_profile_log();
+
+#endif // BOOT_PROFILE_H
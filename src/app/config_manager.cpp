@@ -9,7 +9,11 @@
 #include "board_config.h"
 #include "web_assets.h"
 #include "log_manager.h"
+#include "loop_scheduler.h"
 #include <Preferences.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <nvs_flash.h>
 
 // NVS namespace
@@ -36,19 +40,52 @@
 #define KEY_BASIC_AUTH_ENABLED "ba_en"
 #define KEY_BASIC_AUTH_USER    "ba_user"
 #define KEY_BASIC_AUTH_PASS    "ba_pass"
+
+#if LOG_STREAM_ENABLED
+#define KEY_LOG_STREAM_HOST "log_host"
+#define KEY_LOG_STREAM_PORT "log_port"
+#endif
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+#define KEY_IMAGE_MCAST_GROUP "img_mc_grp"
+#define KEY_IMAGE_MCAST_PORT  "img_mc_port"
+#endif
 #if HAS_DISPLAY
 #define KEY_SCREEN_SAVER_ENABLED "ss_en"
 #define KEY_SCREEN_SAVER_TIMEOUT "ss_to"
 #define KEY_SCREEN_SAVER_FADE_OUT "ss_fo"
 #define KEY_SCREEN_SAVER_FADE_IN "ss_fi"
 #define KEY_SCREEN_SAVER_WAKE_TOUCH "ss_wt"
+
+#define KEY_BLE_TYPING_INTERVAL "ble_type_iv"
 #endif
 #define KEY_MAGIC          "magic"
 
 static Preferences preferences;
 
+// Write coalescing: saves land in g_pending and are written by
+// config_manager_loop() (or a flush); g_persisted mirrors NVS so only changed
+// keys are rewritten. g_store_mutex guards these and every NVS write.
+static SemaphoreHandle_t g_store_mutex = nullptr;
+static DeviceConfig g_persisted;
+static bool g_persisted_valid = false;
+static DeviceConfig g_pending;
+static bool g_dirty = false;
+static uint32_t g_dirty_since_ms = 0;   // first change not yet written
+static uint32_t g_last_change_ms = 0;
+static ConfigStoreStats g_store_stats = {};
+
+// Every restart path (portal reboot, config save, OTA) goes through esp_restart().
+static void flush_on_restart() {
+    config_manager_flush();
+}
+
 // Initialize NVS
 void config_manager_init() {
+    if (!g_store_mutex) {
+        g_store_mutex = xSemaphoreCreateMutex();
+        esp_register_shutdown_handler(flush_on_restart);
+    }
+
     Logger.logBegin("Config NVS Init");
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -139,6 +176,20 @@ bool config_manager_load(DeviceConfig *config) {
         config->basic_auth_username[0] = '\0';
         config->basic_auth_password[0] = '\0';
 
+        #if LOG_STREAM_ENABLED
+        config->log_stream_host[0] = '\0';
+        config->log_stream_port = 0;
+        #endif
+
+        #if HAS_IMAGE_API && IMAGE_API_MULTICAST
+        config->image_mcast_group[0] = '\0';
+        config->image_mcast_port = 0;
+        #endif
+
+        #if HAS_BLE_KEYBOARD
+        config->ble_typing_interval_ms = BLE_KEYBOARD_TYPING_INTERVAL_MS;
+        #endif
+
         #if HAS_DISPLAY
         // Screen saver defaults
         config->screen_saver_enabled = false;
@@ -192,6 +243,20 @@ bool config_manager_load(DeviceConfig *config) {
     preferences.getString(KEY_BASIC_AUTH_USER, config->basic_auth_username, CONFIG_BASIC_AUTH_USERNAME_MAX_LEN);
     preferences.getString(KEY_BASIC_AUTH_PASS, config->basic_auth_password, CONFIG_BASIC_AUTH_PASSWORD_MAX_LEN);
 
+    #if LOG_STREAM_ENABLED
+    preferences.getString(KEY_LOG_STREAM_HOST, config->log_stream_host, CONFIG_LOG_STREAM_HOST_MAX_LEN);
+    config->log_stream_port = preferences.getUShort(KEY_LOG_STREAM_PORT, 0);
+    #endif
+
+    #if HAS_IMAGE_API && IMAGE_API_MULTICAST
+    preferences.getString(KEY_IMAGE_MCAST_GROUP, config->image_mcast_group, CONFIG_IMAGE_MCAST_GROUP_MAX_LEN);
+    config->image_mcast_port = preferences.getUShort(KEY_IMAGE_MCAST_PORT, 0);
+    #endif
+
+    #if HAS_BLE_KEYBOARD
+    config->ble_typing_interval_ms = preferences.getUChar(KEY_BLE_TYPING_INTERVAL, BLE_KEYBOARD_TYPING_INTERVAL_MS);
+    #endif
+
     #if HAS_DISPLAY
     // Load screen saver settings
     config->screen_saver_enabled = preferences.getBool(KEY_SCREEN_SAVER_ENABLED, false);
@@ -215,86 +280,247 @@ bool config_manager_load(DeviceConfig *config) {
         return false;
     }
     
+    // What NVS holds, so later saves only write the keys that change.
+    xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+    g_persisted = *config;
+    g_persisted_valid = true;
+    xSemaphoreGive(g_store_mutex);
+
     config_manager_print(config);
     Logger.logEnd();
     return true;
 }
 
-// Save configuration to NVS
-bool config_manager_save(const DeviceConfig *config) {
+// Writes the keys whose value differs from persisted (what NVS holds); every
+// key when all is set. Each key that lands is copied into persisted, so a key
+// whose write failed still differs and is retried by the next write.
+// Caller holds g_store_mutex with preferences open.
+static void write_changed_keys(const DeviceConfig *next, DeviceConfig *persisted, bool all,
+                               uint32_t *written, uint32_t *skipped, uint32_t *failed) {
+    // putString() returns the string length, so 0 is only a failure for a non-empty value.
+    #define PUT_STR(key, field) \
+        if (all || strcmp(persisted->field, next->field) != 0) { \
+            if (preferences.putString(key, next->field) || !next->field[0]) { \
+                memcpy(persisted->field, next->field, sizeof(persisted->field)); (*written)++; \
+            } else { \
+                Logger.logLinef("ERROR: write failed: %s", key); (*failed)++; \
+            } \
+        } else { (*skipped)++; }
+    #define PUT_NUM(type, key, field) \
+        if (all || persisted->field != next->field) { \
+            if (preferences.put##type(key, next->field)) { \
+                persisted->field = next->field; (*written)++; \
+            } else { \
+                Logger.logLinef("ERROR: write failed: %s", key); (*failed)++; \
+            } \
+        } else { (*skipped)++; }
+
+    // WiFi settings
+    PUT_STR(KEY_WIFI_SSID, wifi_ssid);
+    PUT_STR(KEY_WIFI_PASS, wifi_password);
+
+    // Device settings
+    PUT_STR(KEY_DEVICE_NAME, device_name);
+
+    // Fixed IP settings
+    PUT_STR(KEY_FIXED_IP, fixed_ip);
+    PUT_STR(KEY_SUBNET_MASK, subnet_mask);
+    PUT_STR(KEY_GATEWAY, gateway);
+    PUT_STR(KEY_DNS1, dns1);
+    PUT_STR(KEY_DNS2, dns2);
+
+    // Dummy setting
+    PUT_STR(KEY_DUMMY, dummy_setting);
+
+    // MQTT settings
+    PUT_STR(KEY_MQTT_HOST, mqtt_host);
+    PUT_NUM(UShort, KEY_MQTT_PORT, mqtt_port);
+    PUT_STR(KEY_MQTT_USER, mqtt_username);
+    PUT_STR(KEY_MQTT_PASS, mqtt_password);
+    PUT_NUM(UShort, KEY_MQTT_INTERVAL, mqtt_interval_seconds);
+
+    // Display settings
+    PUT_NUM(UChar, KEY_BACKLIGHT_BRIGHTNESS, backlight_brightness);
+
+    // Basic Auth settings
+    PUT_NUM(Bool, KEY_BASIC_AUTH_ENABLED, basic_auth_enabled);
+    PUT_STR(KEY_BASIC_AUTH_USER, basic_auth_username);
+    PUT_STR(KEY_BASIC_AUTH_PASS, basic_auth_password);
+
+    #if LOG_STREAM_ENABLED
+    PUT_STR(KEY_LOG_STREAM_HOST, log_stream_host);
+    PUT_NUM(UShort, KEY_LOG_STREAM_PORT, log_stream_port);
+    #endif
+
+    #if HAS_IMAGE_API && IMAGE_API_MULTICAST
+    PUT_STR(KEY_IMAGE_MCAST_GROUP, image_mcast_group);
+    PUT_NUM(UShort, KEY_IMAGE_MCAST_PORT, image_mcast_port);
+    #endif
+
+    #if HAS_BLE_KEYBOARD
+    PUT_NUM(UChar, KEY_BLE_TYPING_INTERVAL, ble_typing_interval_ms);
+    #endif
+
+    #if HAS_DISPLAY
+    // Screen saver settings
+    PUT_NUM(Bool, KEY_SCREEN_SAVER_ENABLED, screen_saver_enabled);
+    PUT_NUM(UShort, KEY_SCREEN_SAVER_TIMEOUT, screen_saver_timeout_seconds);
+    PUT_NUM(UShort, KEY_SCREEN_SAVER_FADE_OUT, screen_saver_fade_out_ms);
+    PUT_NUM(UShort, KEY_SCREEN_SAVER_FADE_IN, screen_saver_fade_in_ms);
+    PUT_NUM(Bool, KEY_SCREEN_SAVER_WAKE_TOUCH, screen_saver_wake_on_touch);
+    #endif
+
+    // Magic number last (indicates valid config)
+    if (all || persisted->magic != CONFIG_MAGIC) {
+        if (preferences.putUInt(KEY_MAGIC, CONFIG_MAGIC)) {
+            persisted->magic = CONFIG_MAGIC;
+            (*written)++;
+        } else {
+            Logger.logLinef("ERROR: write failed: %s", KEY_MAGIC);
+            (*failed)++;
+        }
+    }
+
+    #undef PUT_STR
+    #undef PUT_NUM
+}
+
+// Writes g_pending. Caller holds g_store_mutex.
+static bool store_write_locked() {
+    Logger.logBegin("Config Save");
+
+    if (!preferences.begin(CONFIG_NAMESPACE, false)) { // Read-write mode
+        Logger.logEnd("Preferences begin failed");
+        return false;
+    }
+
+    uint32_t written = 0;
+    uint32_t skipped = 0;
+    uint32_t failed = 0;
+    write_changed_keys(&g_pending, &g_persisted, !g_persisted_valid, &written, &skipped, &failed);
+    preferences.end();
+
+    // Without a full mirror yet, only a clean pass makes g_persisted trustworthy.
+    if (failed == 0) g_persisted_valid = true;
+    g_dirty = (failed != 0);
+    g_store_stats.writes++;
+    g_store_stats.keys_written += written;
+    g_store_stats.keys_skipped += skipped;
+    g_store_stats.keys_failed += failed;
+
+    Logger.logLinef("Keys written: %lu (%lu unchanged, %lu failed)",
+                    (unsigned long)written, (unsigned long)skipped, (unsigned long)failed);
+    if (failed) {
+        // The failed keys stay pending; retry after the debounce, not on the next loop pass.
+        g_dirty_since_ms = g_last_change_ms = millis();
+        Logger.logEnd("Some keys not written, will retry");
+        return false;
+    }
+    config_manager_print(&g_pending);
+    Logger.logEnd();
+    return true;
+}
+
+static bool store_validate(const DeviceConfig *config) {
     if (!config) {
         Logger.logMessage("Config", "Save failed: NULL pointer");
         return false;
     }
-    
+
     if (!config_manager_is_valid(config)) {
         Logger.logMessage("Config", "Save failed: Invalid config");
         return false;
     }
-    
-    Logger.logBegin("Config Save");
-    
-    preferences.begin(CONFIG_NAMESPACE, false); // Read-write mode
-    
-    // Save WiFi settings
-    preferences.putString(KEY_WIFI_SSID, config->wifi_ssid);
-    preferences.putString(KEY_WIFI_PASS, config->wifi_password);
-    
-    // Save device settings
-    preferences.putString(KEY_DEVICE_NAME, config->device_name);
-    
-    // Save fixed IP settings
-    preferences.putString(KEY_FIXED_IP, config->fixed_ip);
-    preferences.putString(KEY_SUBNET_MASK, config->subnet_mask);
-    preferences.putString(KEY_GATEWAY, config->gateway);
-    preferences.putString(KEY_DNS1, config->dns1);
-    preferences.putString(KEY_DNS2, config->dns2);
-    
-    // Save dummy setting
-    preferences.putString(KEY_DUMMY, config->dummy_setting);
-
-    // Save MQTT settings
-    preferences.putString(KEY_MQTT_HOST, config->mqtt_host);
-    preferences.putUShort(KEY_MQTT_PORT, config->mqtt_port);
-    preferences.putString(KEY_MQTT_USER, config->mqtt_username);
-    preferences.putString(KEY_MQTT_PASS, config->mqtt_password);
-    preferences.putUShort(KEY_MQTT_INTERVAL, config->mqtt_interval_seconds);
-    
-    // Save display settings
-    Logger.logLinef("Saving brightness: %d%%", config->backlight_brightness);
-    preferences.putUChar(KEY_BACKLIGHT_BRIGHTNESS, config->backlight_brightness);
+    return true;
+}
 
-    // Save Basic Auth settings
-    preferences.putBool(KEY_BASIC_AUTH_ENABLED, config->basic_auth_enabled);
-    preferences.putString(KEY_BASIC_AUTH_USER, config->basic_auth_username);
-    preferences.putString(KEY_BASIC_AUTH_PASS, config->basic_auth_password);
+// Save configuration to NVS now (changed keys only)
+bool config_manager_save(const DeviceConfig *config) {
+    if (!store_validate(config)) return false;
 
-    #if HAS_DISPLAY
-    // Save screen saver settings
-    preferences.putBool(KEY_SCREEN_SAVER_ENABLED, config->screen_saver_enabled);
-    preferences.putUShort(KEY_SCREEN_SAVER_TIMEOUT, config->screen_saver_timeout_seconds);
-    preferences.putUShort(KEY_SCREEN_SAVER_FADE_OUT, config->screen_saver_fade_out_ms);
-    preferences.putUShort(KEY_SCREEN_SAVER_FADE_IN, config->screen_saver_fade_in_ms);
-    preferences.putBool(KEY_SCREEN_SAVER_WAKE_TOUCH, config->screen_saver_wake_on_touch);
-    #endif
-    
-    // Save magic number last (indicates valid config)
-    preferences.putUInt(KEY_MAGIC, CONFIG_MAGIC);
-    
-    preferences.end();
-    
-    config_manager_print(config);
-    Logger.logEnd();
+    xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+    g_pending = *config;
+    g_dirty = true;
+    g_store_stats.saves++;
+    const bool ok = store_write_locked();
+    xSemaphoreGive(g_store_mutex);
+    return ok;
+}
+
+bool config_manager_save_deferred(const DeviceConfig *config) {
+    if (!store_validate(config)) return false;
+
+    const uint32_t now = millis();
+    xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+    if (g_dirty) {
+        g_store_stats.coalesced++;
+    } else {
+        g_dirty_since_ms = now;
+    }
+    g_pending = *config;
+    g_dirty = true;
+    g_last_change_ms = now;
+    g_store_stats.saves++;
+    xSemaphoreGive(g_store_mutex);
+
+    // The loop entry computes the write time.
+    loop_scheduler_notify();
     return true;
 }
 
+bool config_manager_flush() {
+    if (!g_store_mutex) return true;
+    xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+    const bool ok = !g_dirty || store_write_locked();
+    xSemaphoreGive(g_store_mutex);
+    return ok;
+}
+
+uint32_t config_manager_loop(uint32_t now_ms) {
+    xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+    const bool dirty = g_dirty;
+    const uint32_t quiet = now_ms - g_last_change_ms;
+    const uint32_t age = now_ms - g_dirty_since_ms;
+    xSemaphoreGive(g_store_mutex);
+
+    if (!dirty) return LOOP_SCHEDULER_IDLE;
+
+    // Write once changes stop for CONFIG_SAVE_DEBOUNCE_MS, or after
+    // CONFIG_SAVE_MAX_DELAY_MS of continuous changes (a slider held down).
+    if (quiet < CONFIG_SAVE_DEBOUNCE_MS && age < CONFIG_SAVE_MAX_DELAY_MS) {
+        const uint32_t a = CONFIG_SAVE_DEBOUNCE_MS - quiet;
+        const uint32_t b = CONFIG_SAVE_MAX_DELAY_MS - age;
+        return a < b ? a : b;
+    }
+
+    config_manager_flush();
+    return LOOP_SCHEDULER_IDLE;
+}
+
+void config_manager_get_store_stats(ConfigStoreStats *out) {
+    if (!out) return;
+    if (!g_store_mutex) {
+        *out = ConfigStoreStats{};
+        return;
+    }
+    xSemaphoreTake(g_store_mutex, portMAX_DELAY);
+    *out = g_store_stats;
+    out->pending = g_dirty;
+    xSemaphoreGive(g_store_mutex);
+}
+
 // Reset configuration (erase from NVS)
 bool config_manager_reset() {
     Logger.logBegin("Config Reset");
     
+    xSemaphoreTake(g_store_mutex, portMAX_DELAY);
     preferences.begin(CONFIG_NAMESPACE, false);
     bool success = preferences.clear();
     preferences.end();
+    // A pending write would bring the erased config back.
+    g_dirty = false;
+    g_persisted_valid = false;
+    xSemaphoreGive(g_store_mutex);
     
     if (success) {
         Logger.logEnd();
@@ -359,4 +585,17 @@ void config_manager_print(const DeviceConfig *config) {
     // MQTT config can still exist in NVS, but the firmware has MQTT support compiled out.
     Logger.logLine("MQTT: disabled (feature not compiled into firmware)");
 #endif
+
+#if LOG_STREAM_ENABLED
+    if (strlen(config->log_stream_host) > 0) {
+        Logger.logLinef("Syslog: %s:%d", config->log_stream_host, config->log_stream_port > 0 ? config->log_stream_port : 514);
+    }
+#endif
+
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+    if (strlen(config->image_mcast_group) > 0) {
+        Logger.logLinef("Image multicast: %s:%d", config->image_mcast_group,
+                        config->image_mcast_port > 0 ? config->image_mcast_port : IMAGE_API_MULTICAST_DEFAULT_PORT);
+    }
+#endif
 }
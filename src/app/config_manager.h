@@ -13,6 +13,13 @@
  *   }
  *   config_manager_save();           // Save after user configures
  *   config_manager_reset();          // Erase all config
+ *
+ * WRITE COALESCING:
+ *   config_manager_save_deferred() only records the new config; the loop
+ *   entry (config_manager_loop) writes it once changes have stopped for
+ *   CONFIG_SAVE_DEBOUNCE_MS, so a burst of portal saves costs one NVS write.
+ *   Writes only touch keys whose value changed. Pending changes are flushed
+ *   before any restart (shutdown handler) and when an OTA update starts.
  */
 
 #ifndef CONFIG_MANAGER_H
@@ -37,6 +44,12 @@
 #define CONFIG_BASIC_AUTH_USERNAME_MAX_LEN 32
 #define CONFIG_BASIC_AUTH_PASSWORD_MAX_LEN 64
 
+// Network log streaming (syslog receiver)
+#define CONFIG_LOG_STREAM_HOST_MAX_LEN 64
+
+// Multicast image receive (dotted IPv4 group)
+#define CONFIG_IMAGE_MCAST_GROUP_MAX_LEN 16
+
 // Configuration structure
 struct DeviceConfig {
     // WiFi credentials
@@ -71,6 +84,23 @@ struct DeviceConfig {
     char basic_auth_username[CONFIG_BASIC_AUTH_USERNAME_MAX_LEN];
     char basic_auth_password[CONFIG_BASIC_AUTH_PASSWORD_MAX_LEN];
 
+#if LOG_STREAM_ENABLED
+    // UDP syslog receiver for log lines (empty host = off)
+    char log_stream_host[CONFIG_LOG_STREAM_HOST_MAX_LEN];
+    uint16_t log_stream_port;                // default to 514 when 0
+#endif
+
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+    // Multicast group image strips are received on (empty = off)
+    char image_mcast_group[CONFIG_IMAGE_MCAST_GROUP_MAX_LEN];
+    uint16_t image_mcast_port;               // IMAGE_API_MULTICAST_DEFAULT_PORT when 0
+#endif
+
+#if HAS_BLE_KEYBOARD
+    // BLE keyboard: pause after every key report while typing STRING text
+    uint8_t ble_typing_interval_ms;          // default BLE_KEYBOARD_TYPING_INTERVAL_MS
+#endif
+
 #if HAS_DISPLAY
     // Screen saver (burn-in prevention v1): backlight sleep on inactivity
     bool screen_saver_enabled;               // default false
@@ -97,4 +127,20 @@ void config_manager_print(const DeviceConfig *config); // Debug print config
 void config_manager_sanitize_device_name(const char *input, char *output, size_t max_len); // Sanitize name for mDNS
 String config_manager_get_default_device_name();      // Get default device name with chip ID
 
+// Write coalescing
+struct ConfigStoreStats {
+    bool pending;             // a change is waiting for its write
+    uint32_t saves;           // save requests (immediate and deferred)
+    uint32_t coalesced;       // deferred saves folded into a write already pending
+    uint32_t writes;          // NVS writes
+    uint32_t keys_written;    // keys that changed, over all writes
+    uint32_t keys_skipped;    // unchanged keys left alone
+    uint32_t keys_failed;     // key writes NVS refused (retried by the next write)
+};
+
+bool config_manager_save_deferred(const DeviceConfig *config); // Validate, write after the debounce
+bool config_manager_flush();                          // Write a pending change now
+uint32_t config_manager_loop(uint32_t now_ms);        // Loop entry: returns ms until it wants to run
+void config_manager_get_store_stats(ConfigStoreStats *out);
+
 #endif // CONFIG_MANAGER_H
@@ -2,17 +2,79 @@
 
 #include "board_config.h"
 #include "log_manager.h"
+#include "log_stream.h"
 
 #include "fs_health.h"
 
 #if HAS_MQTT
 #include "mqtt_manager.h"
+#include "mqtt_commands.h"
+#include "mqtt_macros_sync.h"
 #endif
 
 #if HAS_DISPLAY
 #include "display_manager.h"
+#include "lvgl_heap.h"
+#include "tap_latency.h"
 #endif
 
+#if HAS_IMAGE_API
+#include "image_api.h"
+#include "image_pool.h"
+#endif
+
+#if HAS_TOUCH
+#include "touch_gesture.h"
+#include "touch_manager.h"
+#endif
+
+#if HAS_DISPLAY && HAS_ICONS
+#include "icon_store.h"
+#endif
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_STORE_WARMUP
+#include "icon_warmup.h"
+#endif
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED
+#include "icon_pack.h"
+#endif
+
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+#include "label_font.h"
+#endif
+
+#if HAS_DISPLAY && LABEL_CACHE_ENABLED
+#include "label_cache.h"
+#endif
+
+#if HAS_DISPLAY && SCREEN_CAPTURE_ENABLED
+#include "screen_capture.h"
+#endif
+
+#if HAS_BLE_KEYBOARD
+#include "ble_keyboard_manager.h"
+#endif
+
+#if POWER_IDLE_ENABLED
+#include "power_manager.h"
+#endif
+
+#include "boot_profile.h"
+#include "config_manager.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
+#include "static_alloc.h"
+#include "loop_scheduler.h"
+#include "memory_pressure.h"
+#include "ota_quiet.h"
+#include "task_placement.h"
+#include "tls_client.h"
+#include "web_portal_admission.h"
+#include "web_portal_body.h"
+#include "web_portal_workers.h"
+#include "wifi_cache.h"
+
 #include <Arduino.h>
 #include <WiFi.h>
 #include "soc/soc_caps.h"
@@ -37,6 +99,16 @@ static uint32_t last_idle_runtime = 0;
 static uint32_t last_total_runtime = 0;
 static bool first_calculation = true;
 
+// Per-task share of the last sample (under cpu_mutex). Percent of one core,
+// so a task that keeps its core busy reads 100 on either chip.
+struct CpuTaskShare {
+    char name[configMAX_TASK_NAME_LEN];
+    uint8_t percent;
+};
+static CpuTaskShare cpu_top_tasks[CPU_TASK_TOP_N];
+static uint8_t cpu_top_count = 0;
+static int8_t cpu_core_usage[portNUM_PROCESSORS];
+
 static bool log_every_ms(unsigned long now_ms, unsigned long *last_ms, unsigned long interval_ms) {
     if (!last_ms) return false;
     if (*last_ms == 0 || (now_ms - *last_ms) >= interval_ms) {
@@ -51,7 +123,9 @@ static bool flash_cache_initialized = false;
 static size_t cached_sketch_size = 0;
 static size_t cached_free_sketch_space = 0;
 
-static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool include_debug_fields);
+// Doc is a JsonDocument or a JsonStreamObject (same call surface).
+template <typename Doc>
+static void fill_common(Doc &doc, bool include_ip_and_channel, bool include_debug_fields);
 
 static void get_memory_snapshot(
     size_t *out_heap_free,
@@ -88,6 +162,64 @@ struct HealthWindowStats {
 
 static HealthWindowStats g_health_window = {};
 
+// Latency histograms for the same window (loop pass, LVGL cycle, HTTP
+// service time). Log-linear buckets: exact below 8 us, then four per power of
+// two (at most 25% wide), up to 2^24 us; larger values land in the last one.
+// Recording is an index computation and an increment under
+// g_health_window_mux; nothing is allocated.
+static constexpr size_t kLatencyBuckets = 8 + 21 * 4 + 1;
+
+struct LatencyHistogram {
+    uint32_t buckets[kLatencyBuckets];
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t over_budget;
+};
+
+static LatencyHistogram g_latency[(size_t)HealthLatency::Count] = {};
+
+static size_t latency_bucket(uint32_t us) {
+    if (us < 8) return us;
+    const uint32_t msb = 31 - (uint32_t)__builtin_clz(us);
+    if (msb >= 24) return kLatencyBuckets - 1;
+    return 8 + (msb - 3) * 4 + ((us >> (msb - 2)) & 3);
+}
+
+// Largest value that lands in bucket i.
+static uint32_t latency_bucket_upper(size_t i) {
+    if (i < 8) return (uint32_t)i;
+    const uint32_t msb = 3 + (uint32_t)(i - 8) / 4;
+    const uint32_t sub = (uint32_t)(i - 8) % 4;
+    return ((4 + sub) << (msb - 2)) + (1u << (msb - 2)) - 1;
+}
+
+// Caller holds g_health_window_mux.
+static void latency_summarize_locked(const LatencyHistogram& h, HealthLatencySummary* out) {
+    out->count = h.count;
+    out->max_us = h.max_us;
+    out->over_budget = h.over_budget;
+    out->p50_us = out->p95_us = out->p99_us = 0;
+    if (h.count == 0) return;
+
+    const uint32_t r50 = (uint32_t)(((uint64_t)h.count * 50 + 99) / 100);
+    const uint32_t r95 = (uint32_t)(((uint64_t)h.count * 95 + 99) / 100);
+    const uint32_t r99 = (uint32_t)(((uint64_t)h.count * 99 + 99) / 100);
+    uint32_t seen = 0;
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        if (!h.buckets[i]) continue;
+        seen += h.buckets[i];
+        // Bucket bounds overstate by up to 25%; never past the real maximum.
+        uint32_t v = latency_bucket_upper(i);
+        if (v > h.max_us) v = h.max_us;
+        if (!out->p50_us && seen >= r50) out->p50_us = v;
+        if (!out->p95_us && seen >= r95) out->p95_us = v;
+        if (seen >= r99) {
+            out->p99_us = v;
+            break;
+        }
+    }
+}
+
 static int compute_fragmentation_percent(size_t free_bytes, size_t largest_bytes) {
     if (free_bytes == 0) return 0;
     if (largest_bytes > free_bytes) return 0;
@@ -133,29 +265,101 @@ static void health_window_update_sample(size_t internal_free, size_t internal_la
     portEXIT_CRITICAL(&g_health_window_mux);
 }
 
-static void health_window_timer_cb(TimerHandle_t) {
-    size_t heap_free = 0;
-    size_t heap_min = 0;
-    size_t heap_largest = 0;
-    size_t internal_free = 0;
-    size_t internal_min = 0;
-    size_t psram_free = 0;
-    size_t psram_min = 0;
-    size_t psram_largest = 0;
+// Shared snapshot (see DeviceTelemetrySnapshot). Built outside the lock and
+// copied in/out under it, so readers never see a half-written struct.
+static portMUX_TYPE g_snapshot_mux = portMUX_INITIALIZER_UNLOCKED;
+static DeviceTelemetrySnapshot g_snapshot = {};
+static uint32_t g_snapshot_ticks = 0;
+// Temperature and WiFi change slowly: refresh them every 5th tick (1 s).
+static constexpr uint32_t kSnapshotSlowEvery = 5;
+
+#if SOC_TEMP_SENSOR_SUPPORTED
+// Installed once and left enabled (installing per read costs more than the read).
+static temperature_sensor_handle_t g_temp_sensor = nullptr;
+static bool g_temp_sensor_failed = false;
+
+static bool read_cpu_temperature(int *out) {
+    if (!g_temp_sensor && !g_temp_sensor_failed) {
+        temperature_sensor_config_t cfg = TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
+        if (temperature_sensor_install(&cfg, &g_temp_sensor) != ESP_OK) {
+            g_temp_sensor = nullptr;
+            g_temp_sensor_failed = true;
+        } else if (temperature_sensor_enable(g_temp_sensor) != ESP_OK) {
+            temperature_sensor_uninstall(g_temp_sensor);
+            g_temp_sensor = nullptr;
+            g_temp_sensor_failed = true;
+        }
+    }
+    if (!g_temp_sensor) return false;
+
+    float celsius = 0;
+    if (temperature_sensor_get_celsius(g_temp_sensor, &celsius) != ESP_OK) return false;
+    *out = (int)celsius;
+    return true;
+}
+#endif
+
+static DeviceTelemetrySnapshot snapshot_refresh(bool slow) {
+    DeviceTelemetrySnapshot next;
+    portENTER_CRITICAL(&g_snapshot_mux);
+    next = g_snapshot;  // keeps the slow fields when !slow
+    portEXIT_CRITICAL(&g_snapshot_mux);
 
     get_memory_snapshot(
-        &heap_free,
-        &heap_min,
-        &heap_largest,
-        &internal_free,
-        &internal_min,
-        &psram_free,
-        &psram_min,
-        &psram_largest
+        &next.mem.heap_free_bytes,
+        &next.mem.heap_min_free_bytes,
+        &next.mem.heap_largest_free_block_bytes,
+        &next.mem.heap_internal_free_bytes,
+        &next.mem.heap_internal_min_free_bytes,
+        &next.mem.psram_free_bytes,
+        &next.mem.psram_min_free_bytes,
+        &next.mem.psram_largest_free_block_bytes
     );
+    // IMPORTANT: On PSRAM boards, `heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)` can return a PSRAM block,
+    // while `ESP.getFreeHeap()` reports internal heap only. Mixing those yields negative fragmentation.
+    // We define heap fragmentation as INTERNAL heap fragmentation.
+    next.heap_fragmentation = compute_fragmentation_percent(next.mem.heap_internal_free_bytes, next.mem.heap_largest_free_block_bytes);
+    next.psram_fragmentation = compute_fragmentation_percent(next.mem.psram_free_bytes, next.mem.psram_largest_free_block_bytes);
+
+    if (slow) {
+#if SOC_TEMP_SENSOR_SUPPORTED
+        next.cpu_temperature_valid = read_cpu_temperature(&next.cpu_temperature);
+#else
+        next.cpu_temperature_valid = false;
+#endif
+        next.wifi_connected = (WiFi.status() == WL_CONNECTED);
+        next.wifi_rssi = next.wifi_connected ? WiFi.RSSI() : 0;
+        next.wifi_channel = next.wifi_connected ? WiFi.channel() : 0;
+        const wifi_mode_t mode = WiFi.getMode();
+        if (next.wifi_connected) {
+            next.ip_v4 = (uint32_t)WiFi.localIP();
+        } else if (mode == WIFI_AP || mode == WIFI_AP_STA) {
+            next.ip_v4 = (uint32_t)WiFi.softAPIP();
+        } else {
+            next.ip_v4 = 0;
+        }
+    }
+
+    next.taken_ms = millis();
+    if (next.taken_ms == 0) next.taken_ms = 1;
+
+    portENTER_CRITICAL(&g_snapshot_mux);
+    g_snapshot = next;
+    portEXIT_CRITICAL(&g_snapshot_mux);
+    return next;
+}
+
+static void health_window_timer_cb(TimerHandle_t) {
+    const bool slow = (++g_snapshot_ticks % kSnapshotSlowEvery) == 0;
+    const DeviceTelemetrySnapshot snap = snapshot_refresh(slow);
 
     // heap_largest is computed as INTERNAL largest free block (see get_memory_snapshot).
-    health_window_update_sample(internal_free, heap_largest, psram_free, psram_largest);
+    health_window_update_sample(
+        snap.mem.heap_internal_free_bytes,
+        snap.mem.heap_largest_free_block_bytes,
+        snap.mem.psram_free_bytes,
+        snap.mem.psram_largest_free_block_bytes
+    );
 }
 
 static HealthWindowStats health_window_get_and_reset(size_t internal_free_now, size_t internal_largest_now, size_t psram_free_now, size_t psram_largest_now) {
@@ -206,8 +410,30 @@ static HealthWindowStats health_window_get_and_reset(size_t internal_free_now, s
     portEXIT_CRITICAL(&g_health_window_mux);
     return snap;
 }
+
+// Summaries of the latency window; resets it.
+static void latency_window_get_and_reset(HealthLatencySummary out[(size_t)HealthLatency::Count]) {
+    portENTER_CRITICAL(&g_health_window_mux);
+    for (size_t i = 0; i < (size_t)HealthLatency::Count; i++) {
+        latency_summarize_locked(g_latency[i], &out[i]);
+    }
+    memset(g_latency, 0, sizeof(g_latency));
+    portEXIT_CRITICAL(&g_health_window_mux);
+}
 } // namespace
 
+void device_telemetry_note_latency(HealthLatency which, uint32_t us, bool over_budget) {
+    if ((size_t)which >= (size_t)HealthLatency::Count) return;
+    const size_t b = latency_bucket(us);
+    portENTER_CRITICAL(&g_health_window_mux);
+    LatencyHistogram& h = g_latency[(size_t)which];
+    h.buckets[b]++;
+    h.count++;
+    if (us > h.max_us) h.max_us = us;
+    if (over_budget) h.over_budget++;
+    portEXIT_CRITICAL(&g_health_window_mux);
+}
+
 // One-shot tripwire state (per boot).
 static bool g_low_mem_tripwire_fired = false;
 
@@ -228,6 +454,18 @@ DeviceMemorySnapshot device_telemetry_get_memory_snapshot() {
     return snapshot;
 }
 
+void device_telemetry_get_snapshot(DeviceTelemetrySnapshot *out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_snapshot_mux);
+    *out = g_snapshot;
+    portEXIT_CRITICAL(&g_snapshot_mux);
+
+    // Before the sampler runs (early boot), or if it was never started.
+    if (out->taken_ms == 0) {
+        *out = snapshot_refresh(true);
+    }
+}
+
 void device_telemetry_log_memory_snapshot(const char *tag) {
     size_t heap_free = 0;
     size_t heap_min = 0;
@@ -272,6 +510,15 @@ void device_telemetry_log_memory_snapshot(const char *tag) {
         (unsigned)psram_largest
     );
 
+#if HEAP_TAGS_ENABLED
+    // Who holds it: live bytes per tag, one line per heap (same 128-byte limit).
+    for (uint8_t k = 0; k < (uint8_t)HeapKind::Count; k++) {
+        char tags[96];
+        if (heap_tag_format_live((HeapKind)k, tags, sizeof(tags)) == 0) continue;
+        Logger.logMessagef("Mem", "%s %s: %s", tag ? tag : "(null)", heap_kind_name((HeapKind)k), tags);
+    }
+#endif
+
     // Tripwire: dump task stack watermarks once per boot when internal min heap is critically low.
     // Runtime gating (not preprocessor gating) so we can't accidentally compile this out.
     if (MEMORY_TRIPWIRE_ENABLED) {
@@ -291,6 +538,7 @@ void device_telemetry_log_memory_snapshot(const char *tag) {
                 (unsigned)psram_largest
             );
             device_telemetry_dump_task_stack_watermarks(tag);
+            memory_pressure_poke();
         }
     }
 }
@@ -365,7 +613,8 @@ void device_telemetry_dump_task_stack_watermarks(const char *tag) {
     }
 }
 
-void device_telemetry_fill_api(JsonDocument &doc) {
+template <typename Doc>
+static void fill_api(Doc &doc) {
     // Web portal /api/health payload
     // - include IP/channel and debug fields
     fill_common(doc, true, true);
@@ -380,14 +629,15 @@ void device_telemetry_fill_api(JsonDocument &doc) {
     // - The key "cpu_temperature" is used for the SoC/internal temperature.
     //   You can safely use "temperature" for an external/ambient sensor.
     // - If you also publish these over MQTT, keep the JSON keys identical in
-    //   device_telemetry_fill_mqtt() so you can reuse the same HA templates.
+    //   fill_mqtt() so you can reuse the same HA templates.
     //
     // Example (commented out):
     // doc["temperature"] = 23.4;
     // doc["humidity"] = 55.2;
 }
 
-void device_telemetry_fill_mqtt(JsonDocument &doc) {
+template <typename Doc>
+static void fill_mqtt(Doc &doc) {
     // MQTT payload
     fill_common(doc, false, false);
 
@@ -398,6 +648,8 @@ void device_telemetry_fill_mqtt(JsonDocument &doc) {
     //   devices/<sanitized>/health/state
     // Home Assistant entities then extract values via value_template, e.g.:
     //   {{ value_json.temperature }}
+    // (With MQTT_HEALTH_SPLIT_TOPICS each field also gets its own
+    // devices/<sanitized>/health/<field> topic.)
     //
     // Add your custom sensor fields below.
     //
@@ -410,6 +662,22 @@ void device_telemetry_fill_mqtt(JsonDocument &doc) {
     // doc["humidity"] = 55.2;
 }
 
+void device_telemetry_fill_api(JsonDocument &doc) {
+    fill_api(doc);
+}
+
+void device_telemetry_write_api(JsonStreamObject &doc) {
+    fill_api(doc);
+}
+
+void device_telemetry_fill_mqtt(JsonDocument &doc) {
+    fill_mqtt(doc);
+}
+
+void device_telemetry_write_mqtt(JsonStreamObject &doc) {
+    fill_mqtt(doc);
+}
+
 void device_telemetry_init() {
     if (flash_cache_initialized) return;
 
@@ -421,6 +689,9 @@ void device_telemetry_init() {
 void device_telemetry_start_health_window_sampling() {
     if (g_health_window_timer != nullptr) return;
 
+    // Seed the shared snapshot so the first consumers do not wait for a tick.
+    snapshot_refresh(true);
+
     // FreeRTOS timer runs on the timer service task. This avoids adding a new task.
     g_health_window_timer = xTimerCreate(
         "health_win",
@@ -478,6 +749,11 @@ static int calculate_cpu_usage() {
         return -1;
     }
 
+    // Runtime counters from the previous sample, matched by task handle.
+    static TaskHandle_t prev_handles[kMaxTasks];
+    static uint32_t prev_runtime[kMaxTasks];
+    static UBaseType_t prev_count = 0;
+
     uint32_t total_runtime = 0;
     const int task_count = uxTaskGetSystemState(task_stats, kMaxTasks, &total_runtime);
 
@@ -523,6 +799,56 @@ static int calculate_cpu_usage() {
 
     if (total_delta == 0) return -1;
 
+    // Per-task deltas: keep the heaviest CPU_TASK_TOP_N (idle tasks excluded).
+    CpuTaskShare top[CPU_TASK_TOP_N];
+    uint8_t top_count = 0;
+    int8_t core_usage[portNUM_PROCESSORS];
+    for (int c = 0; c < portNUM_PROCESSORS; c++) core_usage[c] = -1;
+
+    for (int i = 0; i < task_count; i++) {
+        const TaskStatus_t& t = task_stats[i];
+        uint32_t delta = t.ulRunTimeCounter;  // tasks created since the last sample
+        for (UBaseType_t k = 0; k < prev_count; k++) {
+            if (prev_handles[k] == t.xHandle) {
+                delta = t.ulRunTimeCounter - prev_runtime[k];
+                break;
+            }
+        }
+        uint32_t percent = (uint32_t)((uint64_t)delta * 100 / total_delta);
+        if (percent > 100) percent = 100;
+
+        bool is_idle = false;
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            if (t.xHandle == xTaskGetIdleTaskHandleForCore(c)) {
+                core_usage[c] = (int8_t)(100 - percent);
+                is_idle = true;
+            }
+        }
+        if (is_idle || percent == 0) continue;
+
+        // Insertion into the small sorted list.
+        int pos = top_count;
+        while (pos > 0 && top[pos - 1].percent < percent) pos--;
+        if (pos >= CPU_TASK_TOP_N) continue;
+        const int last = (top_count < CPU_TASK_TOP_N) ? top_count : CPU_TASK_TOP_N - 1;
+        for (int k = last; k > pos; k--) top[k] = top[k - 1];
+        strlcpy(top[pos].name, t.pcTaskName, sizeof(top[pos].name));
+        top[pos].percent = (uint8_t)percent;
+        if (top_count < CPU_TASK_TOP_N) top_count++;
+    }
+
+    for (int i = 0; i < task_count; i++) {
+        prev_handles[i] = task_stats[i].xHandle;
+        prev_runtime[i] = task_stats[i].ulRunTimeCounter;
+    }
+    prev_count = (UBaseType_t)task_count;
+
+    xSemaphoreTake(cpu_mutex, portMAX_DELAY);
+    memcpy(cpu_top_tasks, top, sizeof(CpuTaskShare) * top_count);
+    cpu_top_count = top_count;
+    memcpy(cpu_core_usage, core_usage, sizeof(cpu_core_usage));
+    xSemaphoreGive(cpu_mutex);
+
     // FreeRTOS uxTaskGetSystemState:
     // - total_runtime = elapsed wall-clock time (in timer ticks) since boot
     // - Each task's ulRunTimeCounter = time that task has been running
@@ -541,13 +867,32 @@ static int calculate_cpu_usage() {
     
     if (cpu_usage < 0) cpu_usage = 0;
     if (cpu_usage > 100) cpu_usage = 100;
-    
+
+    // Name the tasks behind a busy CPU.
+    static unsigned long last_busy_log_ms = 0;
+    if (cpu_usage >= CPU_TASK_ALERT_PERCENT && top_count > 0 && log_every_ms(now_ms, &last_busy_log_ms, 10000)) {
+        char line[128];
+        size_t len = 0;
+        for (uint8_t i = 0; i < top_count && len < sizeof(line); i++) {
+            const int n = snprintf(line + len, sizeof(line) - len, "%s%s %u%%", i ? ", " : "", top[i].name, (unsigned)top[i].percent);
+            if (n < 0) break;
+            len += (size_t)n;
+        }
+        Logger.logQuickf("CPU", "%d%% busy: %s", cpu_usage, line);
+    }
+
     return cpu_usage;
 }
 
 // Background task: Calculate CPU usage every 1s
 static void cpu_monitoring_task(void* param) {
     while (true) {
+        // The sample walks every task; skip it while a firmware update runs.
+        if (ota_quiet_active()) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+
         int new_value = calculate_cpu_usage();
         
         xSemaphoreTake(cpu_mutex, portMAX_DELAY);
@@ -568,19 +913,21 @@ static void cpu_monitoring_task(void* param) {
 void device_telemetry_start_cpu_monitoring() {
     if (cpu_task_handle != nullptr) return;  // Already started
     
+    for (int c = 0; c < portNUM_PROCESSORS; c++) cpu_core_usage[c] = -1;
     cpu_mutex = xSemaphoreCreateMutex();
     if (cpu_mutex == nullptr) {
         Logger.logMessage("CPU Monitor", "Failed to create mutex");
         return;
     }
     
-    BaseType_t result = xTaskCreate(
+    BaseType_t result = task_placement_create(
         cpu_monitoring_task,
         "cpu_monitor",
-        2048,  // Stack size
+        CPU_MONITOR_TASK_STACK_BYTES,
         nullptr,
-        1,  // Low priority
-        &cpu_task_handle
+        CPU_MONITOR_TASK_PRIORITY,  // Low priority
+        &cpu_task_handle,
+        CPU_MONITOR_TASK_CORE
     );
     
     if (result != pdPASS) {
@@ -590,6 +937,22 @@ void device_telemetry_start_cpu_monitoring() {
     }
 }
 
+size_t device_telemetry_get_cpu_tasks(DeviceCpuTaskUsage* out, size_t max, int* core_usage, size_t core_max) {
+    if (cpu_mutex == nullptr) return 0;
+
+    xSemaphoreTake(cpu_mutex, portMAX_DELAY);
+    const size_t n = (cpu_top_count < max) ? cpu_top_count : max;
+    for (size_t i = 0; i < n; i++) {
+        strlcpy(out[i].name, cpu_top_tasks[i].name, sizeof(out[i].name));
+        out[i].percent = cpu_top_tasks[i].percent;
+    }
+    for (size_t c = 0; c < core_max; c++) {
+        core_usage[c] = (c < (size_t)portNUM_PROCESSORS) ? cpu_core_usage[c] : -1;
+    }
+    xSemaphoreGive(cpu_mutex);
+    return n;
+}
+
 int device_telemetry_get_cpu_usage() {
     if (cpu_mutex == nullptr) return 0;  // Not initialized
     
@@ -600,9 +963,35 @@ int device_telemetry_get_cpu_usage() {
     return value;
 }
 
-static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool include_debug_fields) {
+#if HAS_DISPLAY
+// Compact [p50, p95, p99, max] array keeps the MQTT payload within MQTT_MAX_PACKET_SIZE.
+template <typename Obj>
+static void fill_perf_histogram(Obj obj, const char *key, const DisplayPerfHistogram &h) {
+    auto arr = obj.createNestedArray(key);
+    arr.add(h.p50_us);
+    arr.add(h.p95_us);
+    arr.add(h.p99_us);
+    arr.add(h.max_us);
+}
+
+template <typename Obj>
+static void fill_tap_histogram(Obj obj, const char *key, const TapLatencyHistogram &h) {
+    auto arr = obj.createNestedArray(key);
+    arr.add(h.p50_us);
+    arr.add(h.p95_us);
+    arr.add(h.p99_us);
+    arr.add(h.max_us);
+}
+#endif
+
+template <typename Doc>
+static void fill_common(Doc &doc, bool include_ip_and_channel, bool include_debug_fields) {
     fs_health_init();
 
+    // Heap, temperature and WiFi figures come from the shared snapshot.
+    DeviceTelemetrySnapshot snap;
+    device_telemetry_get_snapshot(&snap);
+
     // System
     uint64_t uptime_us = esp_timer_get_time();
     doc["uptime_seconds"] = uptime_us / 1000000;
@@ -624,6 +1013,17 @@ static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool inc
     }
     doc["reset_reason"] = reset_str;
 
+    // Boot milestones (debug only): millis() at each, null until reached.
+    if (include_debug_fields) {
+        auto boot = doc.createNestedObject("boot_ms");
+        for (uint8_t m = 0; m < (uint8_t)BootMilestone::Count; m++) {
+            const uint32_t ms = boot_profile_get_ms((BootMilestone)m);
+            const char* name = boot_milestone_name((BootMilestone)m);
+            if (ms) boot[name] = ms;
+            else boot[name] = nullptr;
+        }
+    }
+
     // CPU (API includes cpu_freq; MQTT keeps payload smaller)
     if (include_debug_fields) {
         doc["cpu_freq"] = ESP.getCpuFreqMHz();
@@ -637,51 +1037,49 @@ static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool inc
         doc["cpu_usage"] = nullptr;
     }
 
-    // CPU / SoC temperature
-#if SOC_TEMP_SENSOR_SUPPORTED
-    float temp_celsius = 0;
-    temperature_sensor_handle_t temp_sensor = NULL;
-    temperature_sensor_config_t temp_sensor_config = TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
-
-    if (temperature_sensor_install(&temp_sensor_config, &temp_sensor) == ESP_OK) {
-        if (temperature_sensor_enable(temp_sensor) == ESP_OK) {
-            if (temperature_sensor_get_celsius(temp_sensor, &temp_celsius) == ESP_OK) {
-                doc["cpu_temperature"] = (int)temp_celsius;
-            } else {
-                doc["cpu_temperature"] = nullptr;
+    // Per-core usage and the heaviest tasks of the last CPU sample. MQTT gets
+    // the top task only, to stay within MQTT_MAX_PACKET_SIZE.
+    {
+        DeviceCpuTaskUsage cpu_tasks[CPU_TASK_TOP_N];
+        int core_usage[portNUM_PROCESSORS];
+        const size_t n = device_telemetry_get_cpu_tasks(cpu_tasks, CPU_TASK_TOP_N, core_usage, portNUM_PROCESSORS);
+        if (cpu_usage >= 0) {
+            auto cores = doc.createNestedArray("cpu_cores");
+            for (int c = 0; c < portNUM_PROCESSORS; c++) {
+                if (core_usage[c] >= 0) {
+                    cores.add(core_usage[c]);
+                } else {
+                    cores.add(nullptr);
+                }
             }
-            temperature_sensor_disable(temp_sensor);
-        } else {
-            doc["cpu_temperature"] = nullptr;
         }
-        temperature_sensor_uninstall(temp_sensor);
+        if (include_debug_fields) {
+            auto tasks = doc.createNestedObject("cpu_tasks");
+            for (size_t i = 0; i < n; i++) {
+                tasks[cpu_tasks[i].name] = cpu_tasks[i].percent;
+            }
+        } else if (n > 0) {
+            doc["cpu_top_task"] = cpu_tasks[0].name;
+            doc["cpu_top_task_pct"] = cpu_tasks[0].percent;
+        }
+    }
+
+    // CPU / SoC temperature
+    if (snap.cpu_temperature_valid) {
+        doc["cpu_temperature"] = snap.cpu_temperature;
     } else {
         doc["cpu_temperature"] = nullptr;
     }
-#else
-    doc["cpu_temperature"] = nullptr;
-#endif
 
     // Memory
-    size_t heap_free = 0;
-    size_t heap_min = 0;
-    size_t heap_largest = 0;
-    size_t internal_free = 0;
-    size_t internal_min = 0;
-    size_t psram_free = 0;
-    size_t psram_min = 0;
-    size_t psram_largest = 0;
-
-    get_memory_snapshot(
-        &heap_free,
-        &heap_min,
-        &heap_largest,
-        &internal_free,
-        &internal_min,
-        &psram_free,
-        &psram_min,
-        &psram_largest
-    );
+    const size_t heap_free = snap.mem.heap_free_bytes;
+    const size_t heap_min = snap.mem.heap_min_free_bytes;
+    const size_t heap_largest = snap.mem.heap_largest_free_block_bytes;
+    const size_t internal_free = snap.mem.heap_internal_free_bytes;
+    const size_t internal_min = snap.mem.heap_internal_min_free_bytes;
+    const size_t psram_free = snap.mem.psram_free_bytes;
+    const size_t psram_min = snap.mem.psram_min_free_bytes;
+    const size_t psram_largest = snap.mem.psram_largest_free_block_bytes;
 
     doc["heap_free"] = heap_free;
     doc["heap_min"] = heap_min;
@@ -693,21 +1091,18 @@ static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool inc
     doc["heap_largest"] = heap_largest;
     doc["heap_internal_free"] = internal_free;
     doc["heap_internal_min"] = internal_min;
-    const size_t internal_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    const size_t internal_largest = heap_largest;  // INTERNAL largest block
     doc["heap_internal_largest"] = internal_largest;
     doc["psram_free"] = psram_free;
     doc["psram_min"] = psram_min;
     doc["psram_largest"] = psram_largest;
 
-    // Heap fragmentation
-    // IMPORTANT: On PSRAM boards, `heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)` can return a PSRAM block,
-    // while `ESP.getFreeHeap()` reports internal heap only. Mixing those yields negative fragmentation.
-    // We define heap fragmentation as INTERNAL heap fragmentation.
-    const int heap_frag = compute_fragmentation_percent(internal_free, internal_largest);
-    doc["heap_fragmentation"] = heap_frag;
-
-    const int psram_frag = compute_fragmentation_percent(psram_free, psram_largest);
-    doc["psram_fragmentation"] = psram_frag;
+    // Heap fragmentation (INTERNAL heap; see snapshot_refresh)
+    doc["heap_fragmentation"] = snap.heap_fragmentation;
+    doc["psram_fragmentation"] = snap.psram_fragmentation;
+    if (include_debug_fields) {
+        doc["telemetry_age_ms"] = (uint32_t)(millis() - snap.taken_ms);
+    }
 
     // Windowed min/max sampling between /api/health calls.
     // Only include (and reset) these fields for the web API path.
@@ -734,6 +1129,29 @@ static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool inc
             doc["psram_largest_min_window"] = nullptr;
             doc["psram_fragmentation_max_window"] = nullptr;
         }
+
+        // Latency over the same window: [p50, p95, p99, max] in us (null when
+        // nothing was recorded).
+        HealthLatencySummary lat[(size_t)HealthLatency::Count];
+        latency_window_get_and_reset(lat);
+        static const char* const kLatencyKeys[(size_t)HealthLatency::Count] = {
+            "loop_pass_us_window",
+            "lvgl_cycle_us_window",
+            "http_service_us_window",
+        };
+        for (size_t i = 0; i < (size_t)HealthLatency::Count; i++) {
+            if (lat[i].count == 0) {
+                doc[kLatencyKeys[i]] = nullptr;
+                continue;
+            }
+            auto arr = doc.createNestedArray(kLatencyKeys[i]);
+            arr.add(lat[i].p50_us);
+            arr.add(lat[i].p95_us);
+            arr.add(lat[i].p99_us);
+            arr.add(lat[i].max_us);
+        }
+        doc["loop_over_budget_window"] = lat[(size_t)HealthLatency::LoopPass].over_budget;
+        doc["lvgl_over_budget_window"] = lat[(size_t)HealthLatency::LvglCycle].over_budget;
     }
 
     // Flash usage
@@ -757,6 +1175,7 @@ static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool inc
                 doc["fs_used_bytes"] = nullptr;
                 doc["fs_total_bytes"] = nullptr;
             }
+            if (include_debug_fields) doc["fs_usage_updates"] = fs.ffat_usage_updates;
         } else {
             doc["fs_type"] = nullptr;
             doc["fs_mounted"] = nullptr;
@@ -780,6 +1199,36 @@ static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool inc
             doc["mqtt_last_health_publish_ms"] = nullptr;
             doc["mqtt_health_publish_age_ms"] = nullptr;
         }
+        doc["mqtt_task"] = mqtt_manager.taskRunning();
+        doc["mqtt_reconnect_backoff_ms"] = mqtt_manager.reconnectBackoffMs();
+        MqttQueueStats qs;
+        mqtt_manager.getQueueStats(&qs);
+        doc["mqtt_queue_depth"] = qs.depth;
+        doc["mqtt_publish_sent"] = qs.sent;
+        doc["mqtt_publish_coalesced"] = qs.coalesced;
+        doc["mqtt_publish_dropped_full"] = qs.dropped_full;
+        doc["mqtt_publish_dropped_expired"] = qs.dropped_expired;
+        doc["mqtt_publish_dropped_failed"] = qs.dropped_failed;
+        #if MQTT_HEALTH_SPLIT_TOPICS
+        doc["mqtt_health_fields_sent"] = mqtt_manager.healthFieldsSent();
+        doc["mqtt_health_fields_skipped"] = mqtt_manager.healthFieldsSkipped();
+        #endif
+        #if MQTT_COMMANDS_ENABLED
+        MqttCommandStats cs;
+        mqtt_commands_get_stats(&cs);
+        doc["mqtt_commands_received"] = cs.received;
+        doc["mqtt_commands_rejected"] = cs.rejected;
+        #endif
+        #if MQTT_MACROS_SYNC
+        MqttMacrosSyncStats ms;
+        mqtt_macros_sync_get_stats(&ms);
+        doc["macros_sync_version"] = ms.acked_version;
+        doc["macros_sync_target"] = ms.manifest_version;
+        doc["macros_sync_pending"] = ms.pending;
+        doc["macros_sync_applied"] = ms.applied;
+        doc["macros_sync_skipped"] = ms.skipped;
+        doc["macros_sync_rejected"] = ms.rejected;
+        #endif
     }
 #else
     doc["mqtt_enabled"] = false;
@@ -797,24 +1246,610 @@ static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool inc
             doc["display_fps"] = stats.fps;
             doc["display_lv_timer_us"] = stats.lv_timer_us;
             doc["display_present_us"] = stats.present_us;
+            doc["display_flush_us"] = stats.flush_us;
+            doc["display_flush_kickoff_us"] = stats.flush_kickoff_us;
+
+            // Per-frame distributions: {"render":[p50,p95,p99,max], "flush":[...], "present":[...]}
+            auto frame = doc.createNestedObject("display_frame_us");
+            fill_perf_histogram(frame, "render", stats.render);
+            fill_perf_histogram(frame, "flush", stats.flush);
+            fill_perf_histogram(frame, "present", stats.present);
+#if DISPLAY_TE_SYNC_ENABLED
+            fill_perf_histogram(frame, "te_wait", stats.te_wait);
+            doc["display_te_timeouts"] = stats.te_timeouts;
+#endif
+
+            doc["display_px_per_s"] = stats.flush_px_per_s;
+            doc["display_flushes_per_frame"] = roundf(stats.flushes_per_frame * 10.0f) / 10.0f;
+            doc["display_bus_mbps"] = roundf(stats.bus_mb_per_s * 10.0f) / 10.0f;
         } else {
             doc["display_fps"] = nullptr;
             doc["display_lv_timer_us"] = nullptr;
             doc["display_present_us"] = nullptr;
+            doc["display_flush_us"] = nullptr;
+            doc["display_flush_kickoff_us"] = nullptr;
+            doc["display_frame_us"] = nullptr;
+            doc["display_px_per_s"] = nullptr;
+            doc["display_flushes_per_frame"] = nullptr;
+            doc["display_bus_mbps"] = nullptr;
+        }
+    }
+
+    // Cross-task command queue + LVGL mutex contention (web API only; windowed).
+    if (include_debug_fields) {
+        DisplayCommandStats cmd;
+        if (display_manager_get_command_stats(&cmd, true)) {
+            doc["display_cmd_enqueued"] = cmd.enqueued;
+            doc["display_cmd_dropped"] = cmd.dropped;
+            doc["display_cmd_depth"] = cmd.depth;
+            doc["display_cmd_depth_max_window"] = cmd.depth_max_window;
+            doc["display_lock_wait_max_us_window"] = cmd.lock_wait_max_us_window;
+            doc["display_lock_wait_avg_us_window"] = cmd.lock_count_window
+                ? (uint32_t)(cmd.lock_wait_total_us_window / cmd.lock_count_window)
+                : 0;
+        } else {
+            doc["display_cmd_enqueued"] = nullptr;
+            doc["display_cmd_dropped"] = nullptr;
+            doc["display_cmd_depth"] = nullptr;
+            doc["display_cmd_depth_max_window"] = nullptr;
+            doc["display_lock_wait_max_us_window"] = nullptr;
+            doc["display_lock_wait_avg_us_window"] = nullptr;
+        }
+
+        MacroScreenCacheStats ms;
+        if (display_manager_get_macro_screen_stats(&ms)) {
+            doc["macro_screens_built"] = ms.built;
+            doc["macro_screen_evictions"] = ms.evictions;
+            doc["macro_screen_rebuilds"] = ms.rebuilds;
+        } else {
+            doc["macro_screens_built"] = nullptr;
+            doc["macro_screen_evictions"] = nullptr;
+            doc["macro_screen_rebuilds"] = nullptr;
         }
+
+#if SCREEN_CAPTURE_ENABLED
+        // Screenshot/mirror: what the flush tap costs per frame and what went out.
+        ScreenCaptureStats cap;
+        if (screen_capture_get_stats(&cap)) {
+            auto c = doc.createNestedObject("screen_capture");
+            c["armed"] = cap.armed;
+            c["shadow_bytes"] = cap.shadow_bytes;
+            c["fills"] = cap.fills;
+            c["frames"] = cap.frames;
+            c["tap_us"] = cap.tap_us_last;
+            c["tap_us_max"] = cap.tap_us_max;
+            c["screenshots"] = cap.screenshots;
+            c["screenshots_failed"] = cap.screenshots_failed;
+            c["screenshots_busy"] = cap.screenshots_busy;
+            c["screenshot_bytes"] = cap.screenshot_bytes_last;
+            c["screenshot_us"] = cap.screenshot_us_last;
+            c["mirror_clients"] = cap.mirror_clients;
+            c["mirror_messages"] = cap.mirror_messages;
+            c["mirror_bytes"] = cap.mirror_bytes;
+            c["mirror_dropped"] = cap.mirror_dropped;
+            c["mirror_tick_us_max"] = cap.mirror_tick_us_max;
+        } else {
+            doc["screen_capture"] = nullptr;
+        }
+#endif
     }
 #else
     doc["display_fps"] = nullptr;
     doc["display_lv_timer_us"] = nullptr;
     doc["display_present_us"] = nullptr;
+    doc["display_flush_us"] = nullptr;
+    doc["display_flush_kickoff_us"] = nullptr;
+    doc["display_frame_us"] = nullptr;
+    doc["display_px_per_s"] = nullptr;
+    doc["display_flushes_per_frame"] = nullptr;
+    doc["display_bus_mbps"] = nullptr;
+    if (include_debug_fields) {
+        doc["display_cmd_enqueued"] = nullptr;
+        doc["display_cmd_dropped"] = nullptr;
+        doc["display_cmd_depth"] = nullptr;
+        doc["display_cmd_depth_max_window"] = nullptr;
+        doc["display_lock_wait_max_us_window"] = nullptr;
+        doc["display_lock_wait_avg_us_window"] = nullptr;
+        doc["macro_screens_built"] = nullptr;
+        doc["macro_screen_evictions"] = nullptr;
+        doc["macro_screen_rebuilds"] = nullptr;
+    }
+#endif
+
+    // Deferred image jobs (web API only)
+    if (include_debug_fields) {
+#if HAS_IMAGE_API
+        ImageApiWorkerStats img;
+        if (image_api_get_worker_stats(&img)) {
+            doc["image_worker"] = img.worker;
+            doc["image_state"] = img.state;
+            doc["image_job_queue_depth"] = img.queue_depth;
+            doc["image_strip_queue_depth"] = img.strip_queue_depth;
+            doc["image_job_active"] = img.active_job_name;
+            doc["image_job_last"] = img.last_job_name;
+            doc["image_job_last_wait_ms"] = img.last_wait_ms;
+            doc["image_job_last_run_ms"] = img.last_run_ms;
+            doc["image_job_max_run_ms"] = img.max_run_ms;
+            doc["image_jobs_done"] = img.jobs_done;
+            doc["image_jobs_coalesced"] = img.jobs_coalesced;
+            doc["image_url_not_modified"] = img.url_not_modified;
+            doc["image_url_conns_opened"] = img.url_conns_opened;
+            doc["image_url_conns_reused"] = img.url_conns_reused;
+            doc["image_url_conns_idle"] = img.url_conns_idle;
+            doc["image_last_decode_ms"] = img.last_decode_ms;
+            doc["image_last_decode_parallel"] = img.last_decode_parallel;
+            doc["image_parallel_decodes"] = img.parallel_decodes;
+            doc["image_ws_connected"] = img.ws_connected;
+            doc["image_ws_messages"] = img.ws_messages;
+            doc["image_ws_rejected"] = img.ws_rejected;
+#if IMAGE_API_MULTICAST
+            doc["image_mcast_joined"] = img.mcast_joined;
+            doc["image_mcast_datagrams"] = img.mcast_datagrams;
+            doc["image_mcast_frames"] = img.mcast_frames;
+            doc["image_mcast_rebuilt"] = img.mcast_rebuilt;
+            doc["image_mcast_strips_lost"] = img.mcast_strips_lost;
+            doc["image_mcast_rejected"] = img.mcast_rejected;
+#endif
+        } else {
+            doc["image_worker"] = nullptr;
+            doc["image_state"] = nullptr;
+        }
+
+        ImagePoolStats pool;
+        image_pool_get_stats(&pool);
+        doc["image_pool_enabled"] = pool.enabled;
+        if (pool.enabled) {
+            doc["image_pool_psram"] = pool.psram;
+            doc["image_pool_slots"] = pool.large_slots + pool.small_slots;
+            doc["image_pool_used"] = pool.large_used + pool.small_used;
+            doc["image_pool_large_used"] = pool.large_used;
+            doc["image_pool_small_used"] = pool.small_used;
+            doc["image_pool_peak_used"] = pool.peak_used;
+            doc["image_pool_refusals"] = pool.refusals;
+        }
+#else
+        doc["image_worker"] = nullptr;
+        doc["image_state"] = nullptr;
+#endif
+    }
+
+    // FFat icon cache (debug only)
+#if HAS_DISPLAY && HAS_ICONS
+    if (include_debug_fields) {
+        IconStoreCacheStats icons;
+        icon_store_get_cache_stats(&icons);
+        doc["icon_cache_entries"] = icons.entries;
+        doc["icon_cache_referenced"] = icons.referenced;
+        doc["icon_cache_bytes"] = icons.bytes;
+        doc["icon_cache_hits"] = icons.hits;
+        doc["icon_cache_misses"] = icons.misses;
+        doc["icon_cache_evictions"] = icons.evictions;
+        doc["icon_cache_refusals"] = icons.refusals;
+        doc["icon_cache_loads"] = icons.loads;
+        doc["icon_cache_load_us_avg"] = icons.loads ? (icons.load_us_total / icons.loads) : 0;
+        doc["icon_cache_loaded_stored_bytes"] = icons.loaded_stored_bytes;
+        doc["icon_cache_loaded_pixel_bytes"] = icons.loaded_pixel_bytes;
+#if ICON_PACK_ENABLED
+        IconPackStats pack;
+        icon_pack_get_stats(&pack);
+        if (pack.mapped) {
+            doc["icon_pack_entries"] = pack.entries;
+            doc["icon_pack_hits"] = pack.hits;
+        } else {
+            doc["icon_pack_entries"] = nullptr;
+            doc["icon_pack_hits"] = nullptr;
+        }
+#endif
+#if ICON_STORE_WARMUP
+        IconWarmupStats warmup;
+        icon_warmup_get_stats(&warmup);
+        doc["icon_warmup_running"] = warmup.running;
+        doc["icon_warmup_queued"] = warmup.queued;
+        doc["icon_warmup_loaded"] = warmup.loaded;
+        doc["icon_warmup_skipped"] = warmup.skipped;
+        doc["icon_warmup_failed"] = warmup.failed;
+        doc["icon_warmup_cache_full"] = warmup.budget_full;
+        doc["icon_warmup_ms"] = warmup.elapsed_ms;
+#endif
+    }
+#endif
+
+    // Runtime label font (debug only); null until one is loaded.
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+    if (include_debug_fields) {
+        LabelFontStats font;
+        label_font_get_stats(&font);
+        if (font.loaded) {
+            doc["label_font_bytes"] = font.file_bytes;
+            doc["label_font_glyphs"] = font.glyphs;
+        } else {
+            doc["label_font_bytes"] = nullptr;
+            doc["label_font_glyphs"] = nullptr;
+        }
+    }
+#endif
+
+    // Pre-rendered label bitmaps (debug only); null without PSRAM.
+#if HAS_DISPLAY && LABEL_CACHE_ENABLED
+    if (include_debug_fields) {
+        LabelCacheStats labels;
+        label_cache_get_stats(&labels);
+        if (labels.active) {
+            doc["label_cache_entries"] = labels.entries;
+            doc["label_cache_bytes"] = labels.bytes;
+            doc["label_cache_hits"] = labels.hits;
+            doc["label_cache_misses"] = labels.misses;
+        } else {
+            doc["label_cache_entries"] = nullptr;
+            doc["label_cache_bytes"] = nullptr;
+            doc["label_cache_hits"] = nullptr;
+            doc["label_cache_misses"] = nullptr;
+        }
+    }
 #endif
 
+#if HAS_DISPLAY
+    // Tap-to-HID latency: {"total":[p50,p95,p99,max]} (MQTT), plus the stages (web).
+    {
+        TapLatencyStats tap;
+        tap_latency_get_stats(&tap);
+        doc["tap_latency_taps"] = tap.taps;
+        auto lat = doc.createNestedObject("tap_latency_us");
+        fill_tap_histogram(lat, "total", tap.total);
+        if (include_debug_fields) {
+            fill_tap_histogram(lat, "touch_click", tap.touch_to_click);
+            fill_tap_histogram(lat, "click_dispatch", tap.click_to_dispatch);
+            fill_tap_histogram(lat, "dispatch_report", tap.dispatch_to_report);
+            fill_tap_histogram(lat, "report_span", tap.report_span);
+        }
+    }
+#endif
+
+#if HAS_TOUCH
+    // Touch sampling and gestures (debug only): reads should stay flat at idle.
+    if (include_debug_fields) {
+        TouchSamplerStats ts;
+        touch_manager_get_sampler_stats(&ts);
+        doc["touch_sampler"] = ts.active;
+        if (ts.active) {
+            doc["touch_irqs"] = ts.irqs;
+            doc["touch_reads"] = ts.reads;
+            doc["touch_samples"] = ts.samples;
+            doc["touch_samples_coalesced"] = ts.coalesced;
+            doc["touch_samples_dropped"] = ts.dropped;
+        }
+#if MACROPAD_GESTURES
+        TouchGestureStats gs;
+        touch_gesture_get_stats(&gs);
+        doc["touch_swipes"] = gs.swipes;
+        doc["touch_long_presses"] = gs.long_presses;
+        doc["touch_gestures_handled"] = gs.handled;
+#endif
+    }
+#endif
+
+#if HAS_BLE_KEYBOARD
+    // STRING typing throughput (debug only)
+    if (include_debug_fields) {
+        BleTypingStats typing;
+        ble_keyboard_get_typing_stats(&typing);
+        doc["ble_typing_runs"] = typing.runs;
+        doc["ble_typing_chars"] = typing.chars;
+        doc["ble_typing_reports"] = typing.reports;
+        doc["ble_typing_last_chars"] = typing.last_chars;
+        doc["ble_typing_last_ms"] = typing.last_ms;
+        doc["ble_typing_last_cps"] = typing.last_cps;
+        doc["ble_typing_last_interval_ms"] = typing.last_interval_ms;
+    }
+
+    // NimBLE stack lifecycle: running state on MQTT, heap accounting on web.
+    {
+        BleStackStats stack;
+        ble_keyboard_get_stack_stats(&stack);
+        doc["ble_stack_running"] = stack.running;
+        if (include_debug_fields) {
+            doc["ble_stack_on_demand"] = stack.on_demand;
+            doc["ble_stack_starts"] = stack.starts;
+            doc["ble_stack_stops"] = stack.stops;
+            doc["ble_stack_heap_cost"] = stack.heap_cost_bytes;
+            doc["ble_stack_heap_reclaimed"] = stack.heap_reclaimed_bytes;
+            doc["ble_bonds"] = stack.bonds;
+        }
+    }
+
+    // Host profiles: active profile on MQTT, switch timing on web.
+    {
+        BleHostStats hosts;
+        ble_keyboard_get_host_stats(&hosts);
+        doc["ble_host_profile"] = hosts.active + 1;
+        if (include_debug_fields) {
+            doc["ble_host_switches"] = hosts.switches;
+            doc["ble_host_switching"] = hosts.switching;
+            doc["ble_host_last_switch_ms"] = hosts.last_switch_ms;
+            doc["ble_host_last_switch_directed"] = hosts.last_switch_directed;
+        }
+    }
+
+    // Connection parameters the central applied (interval also on MQTT).
+    {
+        BleLinkStats link;
+        ble_keyboard_get_link_stats(&link);
+        if (link.connected) {
+            doc["ble_conn_interval_us"] = (uint32_t)link.interval * 1250u;
+        } else {
+            doc["ble_conn_interval_us"] = nullptr;
+        }
+        if (include_debug_fields) {
+            static const char *const kModes[] = {"host", "fast", "idle"};
+            doc["ble_conn_mode"] = kModes[(uint8_t)link.mode];
+            doc["ble_conn_latency"] = link.latency;
+            doc["ble_conn_timeout_ms"] = (uint32_t)link.timeout * 10u;
+            doc["ble_conn_requests"] = link.requests;
+            doc["ble_conn_updates"] = link.updates;
+            doc["ble_report_tx_last_us"] = link.report_tx_last_us;
+            doc["ble_report_tx_max_us"] = link.report_tx_max_us;
+        }
+    }
+#endif
+
+#if POWER_IDLE_ENABLED
+    // Idle power mode (debug only). Current draw needs an external meter; these
+    // show what the firmware did while it was measured.
+    if (include_debug_fields) {
+        PowerStats ps;
+        power_manager_get_stats(&ps);
+        doc["power_supported"] = ps.supported;
+        doc["power_idle"] = ps.idle;
+        doc["power_light_sleep"] = ps.light_sleep;
+        doc["power_cpu_freq_mhz"] = ps.cpu_freq_mhz;
+        doc["power_idle_entries"] = ps.idle_entries;
+        doc["power_idle_seconds"] = ps.idle_ms / 1000;
+        doc["power_holds"] = ps.holds;
+        doc["power_idle_loop_gap_max_ms"] = ps.idle_loop_gap_max_ms;
+        doc["power_last_wake_gap_ms"] = ps.last_wake_gap_ms;
+    }
+#endif
+
+    // Firmware update flash writes (debug only): the last update, read back
+    // after its reboot, to compare runs with and without quiet mode.
+    if (include_debug_fields) {
+        OtaQuietStats oq;
+        ota_quiet_get_stats(&oq);
+        doc["ota_quiet_active"] = oq.active;
+        if (oq.last_valid) {
+            doc["ota_last_quiet"] = oq.last_quiet;
+            doc["ota_last_flash_bytes"] = oq.last_flash_bytes;
+            doc["ota_last_flash_ms"] = oq.last_flash_ms;
+            doc["ota_last_flash_kbps"] = oq.last_flash_kbps;
+            doc["ota_last_flash_write_max_us"] = oq.last_flash_write_max_us;
+        }
+    }
+
+    // Log lines lost to a full ring (debug only).
+    if (include_debug_fields) {
+        doc["log_dropped"] = Logger.dropped();
+
+        // Syslog streaming: null when no receiver is configured and resolved.
+        LogStreamStats lss;
+        log_stream_get_stats(&lss);
+        if (lss.active) {
+            doc["log_stream_datagrams"] = lss.datagrams;
+            doc["log_stream_dropped"] = lss.dropped_lines;
+        } else {
+            doc["log_stream_datagrams"] = nullptr;
+            doc["log_stream_dropped"] = nullptr;
+        }
+    }
+
+    // Main loop scheduler (debug only): per-callback cost and punctuality.
+    if (include_debug_fields) {
+        LoopSchedulerStats ls;
+        loop_scheduler_get_stats(&ls);
+        doc["loop_passes"] = ls.passes;
+        doc["loop_events"] = ls.events;
+        doc["loop_sleep_seconds"] = ls.sleep_ms / 1000;
+
+        LoopSchedulerEntryStats entries[LOOP_SCHEDULER_MAX_ENTRIES];
+        const size_t n = loop_scheduler_get_entry_stats(entries, LOOP_SCHEDULER_MAX_ENTRIES);
+        auto sched = doc.createNestedObject("loop_tasks");
+        for (size_t i = 0; i < n; i++) {
+            auto e = sched.createNestedArray(entries[i].name);
+            e.add(entries[i].runs);
+            e.add(entries[i].runs ? entries[i].total_us / entries[i].runs : 0);
+            e.add(entries[i].max_us);
+            e.add(entries[i].late);
+            e.add(entries[i].overruns);
+        }
+    }
+
+#if MEMORY_PRESSURE_ENABLED
+    // Memory pressure shedding: current tier always, history in debug.
+    {
+        MemPressureStats mp;
+        memory_pressure_get_stats(&mp);
+        doc["mem_pressure_tier"] = memory_pressure_tier_name(mp.tier);
+        if (include_debug_fields) {
+            doc["mem_pressure_peak"] = memory_pressure_tier_name(mp.peak);
+            doc["mem_pressure_escalations"] = mp.escalations;
+            doc["mem_pressure_recoveries"] = mp.recoveries;
+        }
+    }
+#endif
+
+#if PORTAL_ADMISSION_ENABLED
+    // Portal admission control (debug only).
+    if (include_debug_fields) {
+        PortalAdmissionStats as;
+        portal_admission_get_stats(&as);
+        doc["http_admitted"] = as.admitted;
+        doc["http_rejected_busy"] = as.rejected_busy;
+        doc["http_rejected_memory"] = as.rejected_memory;
+        doc["http_in_flight"] = as.in_flight_json + as.in_flight_upload;
+        doc["http_in_flight_peak"] = as.in_flight_peak;
+    }
+#endif
+
+    // Shared request body leases (debug only).
+    if (include_debug_fields) {
+        PortalBodyStats bs;
+        portal_body_get_stats(&bs);
+        doc["http_body_leases"] = bs.leases;
+        doc["http_body_leases_peak"] = bs.leases_peak;
+        doc["http_body_bytes"] = bs.bytes;
+        doc["http_body_bytes_peak"] = bs.bytes_peak;
+        doc["http_body_cached_bytes"] = bs.cached_bytes;
+        doc["http_body_granted"] = bs.granted;
+        doc["http_body_reused"] = bs.reused;
+        doc["http_body_refused"] = bs.refused;
+        doc["http_body_expired"] = bs.expired;
+        doc["http_body_abandoned"] = bs.abandoned;
+    }
+
+#if PORTAL_WORKERS_ENABLED
+    // Portal workers (debug only): per worker [core, queued, queued_peak, jobs,
+    // rejected, orphaned, busy_ms, max_run_ms, max_wait_ms]; per route
+    // [worker (-1 = inline), dispatched, inline_runs].
+    if (include_debug_fields) {
+        PortalWorkerStats ws[2];
+        const size_t n = portal_workers_get_stats(ws, sizeof(ws) / sizeof(ws[0]));
+        auto workers = doc.createNestedArray("http_workers");
+        for (size_t i = 0; i < n; i++) {
+            auto w = workers.createNestedArray();
+            w.add(ws[i].core);
+            w.add(ws[i].queued);
+            w.add(ws[i].queued_peak);
+            w.add(ws[i].jobs);
+            w.add(ws[i].rejected);
+            w.add(ws[i].orphaned);
+            w.add(ws[i].busy_ms);
+            w.add(ws[i].max_run_ms);
+            w.add(ws[i].max_wait_ms);
+        }
+        auto routes = doc.createNestedObject("http_worker_routes");
+        for (uint8_t r = 0; r < (uint8_t)PortalWorkRoute::Count; r++) {
+            PortalWorkRouteStats rs;
+            portal_work_route_get_stats((PortalWorkRoute)r, &rs);
+            auto a = routes.createNestedArray(portal_work_route_name((PortalWorkRoute)r));
+            a.add(rs.worker);
+            a.add(rs.dispatched);
+            a.add(rs.inline_runs);
+        }
+    }
+#endif
+
+#if HEAP_TAGS_ENABLED
+    // Tagged heap accounting (debug only): per tag and heap,
+    // [live_bytes, peak_bytes, live_blocks, allocs, failed]. Unused heaps are left out.
+    if (include_debug_fields) {
+        auto tags = doc.createNestedObject("heap_tags");
+        for (uint8_t t = 0; t < (uint8_t)HeapTag::Count; t++) {
+            HeapTagStats st[(size_t)HeapKind::Count];
+            heap_tag_get_stats((HeapTag)t, st);
+            bool used = false;
+            for (const HeapTagStats& k : st) used = used || k.allocs || k.failed;
+            if (!used) continue;
+            auto o = tags.createNestedObject(heap_tag_name((HeapTag)t));
+            for (uint8_t k = 0; k < (uint8_t)HeapKind::Count; k++) {
+                if (!st[k].allocs && !st[k].failed) continue;
+                auto a = o.createNestedArray(heap_kind_name((HeapKind)k));
+                a.add(st[k].live_bytes);
+                a.add(st[k].peak_bytes);
+                a.add(st[k].live_blocks);
+                a.add(st[k].allocs);
+                a.add(st[k].failed);
+            }
+        }
+    }
+#endif
+
+#if HEAP_TAGS_ENABLED
+    // Steady state (debug only): tagged heap allocations since boot completed
+    // (null until then), the tags that made them, and with STATIC_ALLOC_MODE
+    // each arena as [size, used, peak, overflows].
+    if (include_debug_fields) {
+        StaticAllocStats sa;
+        static_alloc_get_stats(&sa);
+        doc["static_alloc"] = (bool)STATIC_ALLOC_MODE;
+        if (sa.booted) {
+            doc["heap_allocs_after_boot"] = sa.allocs_after_boot;
+            auto by_tag = doc.createNestedObject("heap_allocs_after_boot_tags");
+            for (uint8_t t = 0; t < (uint8_t)HeapTag::Count; t++) {
+                if (sa.tag_allocs[t]) by_tag[heap_tag_name((HeapTag)t)] = sa.tag_allocs[t];
+            }
+        } else {
+            doc["heap_allocs_after_boot"] = nullptr;
+        }
+        // Every heap_caps allocation, when the core has heap hooks.
+        if (sa.all_counted && sa.booted) doc["heap_allocs_after_boot_all"] = sa.all_allocs_after_boot;
+
+#if STATIC_ALLOC_MODE
+        auto arenas = doc.createNestedObject("static_arenas");
+        for (uint8_t t = 0; t < (uint8_t)HeapTag::Count; t++) {
+            StaticArenaStats as;
+            if (!static_alloc_get_arena_stats((HeapTag)t, &as)) continue;
+            auto a = arenas.createNestedArray(heap_tag_name((HeapTag)t));
+            a.add(as.total_bytes);
+            a.add(as.used_bytes);
+            a.add(as.peak_bytes);
+            a.add(as.overflows);
+        }
+#endif
+    }
+#endif
+
+    // Heap placement per class (debug only): [allocs, fallbacks, reserve_refusals, failed].
+    if (include_debug_fields) {
+        auto place = doc.createNestedObject("heap_place");
+        for (uint8_t c = 0; c < (uint8_t)HeapClass::Count; c++) {
+            HeapPlaceStats ps;
+            heap_place_get_stats((HeapClass)c, &ps);
+            auto a = place.createNestedArray(heap_class_name((HeapClass)c));
+            a.add(ps.allocs);
+            a.add(ps.fallbacks);
+            a.add(ps.reserve_refusals);
+            a.add(ps.failed);
+        }
+    }
+
+#if HAS_DISPLAY
+    // LVGL arena (debug only): [size, used, peak, largest_free, frag_pct, overflow_allocs],
+    // null when LVGL allocates from the system heap.
+    if (include_debug_fields) {
+        LvglHeapStats lh;
+        lvgl_heap_get_stats(&lh);
+        if (lh.arena) {
+            auto a = doc.createNestedArray("lvgl_arena");
+            a.add(lh.total_bytes);
+            a.add(lh.used_bytes);
+            a.add(lh.peak_bytes);
+            a.add(lh.largest_free);
+            a.add(lh.frag_pct);
+            a.add(lh.overflow_allocs);
+        } else {
+            doc["lvgl_arena"] = nullptr;
+        }
+    }
+#endif
+
+    // Actual task placement (debug only): [core (-1 = unpinned), priority, stack_free].
+    if (include_debug_fields) {
+        TaskPlacementInfo tasks[14];
+        const size_t n = task_placement_get(tasks, sizeof(tasks) / sizeof(tasks[0]));
+        auto placement = doc.createNestedObject("tasks");
+        for (size_t i = 0; i < n; i++) {
+            auto t = placement.createNestedArray(tasks[i].name);
+            t.add(tasks[i].core);
+            t.add(tasks[i].priority);
+            t.add(tasks[i].stack_free);
+        }
+    }
+
     // WiFi stats (only if connected)
-    if (WiFi.status() == WL_CONNECTED) {
-        doc["wifi_rssi"] = WiFi.RSSI();
+    if (snap.wifi_connected) {
+        doc["wifi_rssi"] = snap.wifi_rssi;
 
         if (include_ip_and_channel) {
-            doc["wifi_channel"] = WiFi.channel();
+            doc["wifi_channel"] = snap.wifi_channel;
             {
                 IPAddress ip = WiFi.localIP();
                 char ip_buf[16];
@@ -832,6 +1867,48 @@ static void fill_common(JsonDocument &doc, bool include_ip_and_channel, bool inc
             doc["hostname"] = nullptr;
         }
     }
+
+    // Station connects (debug only): how the last one got there and how long it took.
+    if (include_debug_fields) {
+        WifiConnectStats ws;
+        wifi_cache_get_stats(&ws);
+        doc["wifi_connect_ms"] = ws.last_connect_ms;
+        doc["wifi_fast_connects"] = ws.fast_connects;
+        doc["wifi_fast_misses"] = ws.fast_misses;
+        doc["wifi_full_connects"] = ws.full_connects;
+        doc["wifi_connect_failures"] = ws.failures;
+    }
+
+    // Outbound HTTPS handshakes (debug only): [full, resumed, failed] and
+    // [full_avg, resumed_avg, last] in microseconds.
+    if (include_debug_fields) {
+        TlsClientStats ts;
+        tls_client_get_stats(&ts);
+        auto hs = doc.createNestedArray("tls_handshakes");
+        hs.add(ts.full);
+        hs.add(ts.resumed);
+        hs.add(ts.failed);
+        auto us = doc.createNestedArray("tls_handshake_us");
+        us.add(ts.full_us);
+        us.add(ts.resumed_us);
+        us.add(ts.last_us);
+        doc["tls_handshake_heap"] = ts.handshake_heap;
+        doc["tls_conn_heap"] = ts.conn_heap;
+        doc["tls_sessions"] = ts.sessions;
+    }
+
+    // Config write coalescing (debug only).
+    if (include_debug_fields) {
+        ConfigStoreStats cs;
+        config_manager_get_store_stats(&cs);
+        doc["config_save_pending"] = cs.pending;
+        doc["config_saves"] = cs.saves;
+        doc["config_saves_coalesced"] = cs.coalesced;
+        doc["config_writes"] = cs.writes;
+        doc["config_keys_written"] = cs.keys_written;
+        doc["config_keys_skipped"] = cs.keys_skipped;
+        doc["config_keys_failed"] = cs.keys_failed;
+    }
 }
 
 static void get_memory_snapshot(
@@ -3,6 +3,8 @@
 
 #include <ArduinoJson.h>
 
+#include "json_stream_writer.h"
+
 struct DeviceMemorySnapshot {
 	size_t heap_free_bytes;
 	size_t heap_min_free_bytes;
@@ -29,10 +31,26 @@ void device_telemetry_fill_api(JsonDocument &doc);
 // Intentionally excludes volatile/low-value fields like IP address.
 void device_telemetry_fill_mqtt(JsonDocument &doc);
 
+// Same fields as the fill_* functions, written straight to a JSON stream
+// (no document allocation). Used by /api/health and the batched MQTT payload.
+void device_telemetry_write_api(JsonStreamObject &doc);
+void device_telemetry_write_mqtt(JsonStreamObject &doc);
+
 // Get current CPU usage percentage (0-100).
 // Thread-safe - reads cached value updated by background task.
 int device_telemetry_get_cpu_usage();
 
+// One of the busiest tasks of the last CPU sample.
+struct DeviceCpuTaskUsage {
+	char name[16];
+	uint8_t percent;               // of one core
+};
+
+// Busiest tasks of the last CPU sample, heaviest first (idle tasks excluded),
+// and per-core usage (-1 = unknown) for up to core_max cores. Returns the
+// number of tasks written.
+size_t device_telemetry_get_cpu_tasks(DeviceCpuTaskUsage *out, size_t max, int *core_usage, size_t core_max);
+
 // Initialize CPU monitoring background task.
 // Must be called once during setup.
 void device_telemetry_start_cpu_monitoring();
@@ -42,9 +60,50 @@ void device_telemetry_start_cpu_monitoring();
 // Safe to call multiple times.
 void device_telemetry_start_health_window_sampling();
 
+// Latency sources summarized per /api/health window (*_us_window fields).
+enum class HealthLatency : uint8_t {
+	LoopPass,      // loop() scheduler pass, work only (not the sleep)
+	LvglCycle,     // one LVGL task cycle with the display lock held
+	HttpRequest,   // AsyncTCP request: first handler call to teardown
+	Count
+};
+
+struct HealthLatencySummary {
+	uint32_t count;
+	uint32_t p50_us;
+	uint32_t p95_us;
+	uint32_t p99_us;
+	uint32_t max_us;
+	uint32_t over_budget;
+};
+
+// Record one sample (any task; no allocation). over_budget marks a sample past
+// the source's budget (LOOP_PASS_BUDGET_US, LVGL_CYCLE_BUDGET_US).
+void device_telemetry_note_latency(HealthLatency which, uint32_t us, bool over_budget = false);
+
 // Capture a point-in-time memory snapshot (heap/internal heap/PSRAM).
 DeviceMemorySnapshot device_telemetry_get_memory_snapshot();
 
+// Shared telemetry snapshot. The health window timer refreshes it (memory every
+// 200 ms, CPU temperature and WiFi every second), so /api/health, MQTT health,
+// the info screen and portal admission read one copy instead of walking the
+// heap and probing the sensor on every call.
+struct DeviceTelemetrySnapshot {
+	uint32_t taken_ms;             // millis() of the last memory refresh (0 = never)
+	DeviceMemorySnapshot mem;      // heap_largest_free_block_bytes is the INTERNAL largest block
+	int heap_fragmentation;        // internal heap, percent
+	int psram_fragmentation;
+	bool cpu_temperature_valid;
+	int cpu_temperature;           // Celsius
+	bool wifi_connected;
+	int wifi_rssi;
+	int wifi_channel;
+	uint32_t ip_v4;                // STA address when connected, else SoftAP address when the AP is up; 0 = none (IPAddress byte order)
+};
+
+// Copy the latest snapshot (refreshed on the spot if the timer has not run yet).
+void device_telemetry_get_snapshot(DeviceTelemetrySnapshot *out);
+
 // Convenience logging helper (single line) using LogManager.
 void device_telemetry_log_memory_snapshot(const char *tag);
 
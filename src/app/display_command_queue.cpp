@@ -0,0 +1,66 @@
+/*
+ * Display Command Queue Implementation
+ */
+
+#include "display_command_queue.h"
+
+#if HAS_DISPLAY
+
+DisplayCommandQueue::DisplayCommandQueue() : enqueuePos(0), dequeuePos(0) {
+    for (uint32_t i = 0; i < DISPLAY_CMD_QUEUE_DEPTH; i++) {
+        slots[i].seq = i;
+    }
+}
+
+bool DisplayCommandQueue::push(const DisplayCommand& cmd) {
+    uint32_t pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+    Slot* slot = nullptr;
+
+    while (true) {
+        slot = &slots[pos & kMask];
+        const uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        const int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            // Slot is free for this position; claim it.
+            if (__atomic_compare_exchange_n(&enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+            // CAS failure reloaded pos; retry.
+        } else if (diff < 0) {
+            // The consumer has not released this slot yet: full.
+            return false;
+        } else {
+            // Another producer claimed pos; catch up.
+            pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->cmd = cmd;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool DisplayCommandQueue::pop(DisplayCommand* out) {
+    const uint32_t pos = dequeuePos;
+    Slot* slot = &slots[pos & kMask];
+    const uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+    // Not yet published (empty, or a producer is still copying).
+    if ((int32_t)(seq - (pos + 1)) < 0) {
+        return false;
+    }
+
+    *out = slot->cmd;
+    __atomic_store_n(&slot->seq, pos + DISPLAY_CMD_QUEUE_DEPTH, __ATOMIC_RELEASE);
+    __atomic_store_n(&dequeuePos, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t DisplayCommandQueue::depth() const {
+    const uint32_t head = __atomic_load_n(&enqueuePos, __ATOMIC_ACQUIRE);
+    const uint32_t tail = __atomic_load_n(&dequeuePos, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
+
+#endif // HAS_DISPLAY
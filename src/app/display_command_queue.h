@@ -0,0 +1,80 @@
+/*
+ * Display Command Queue
+ *
+ * Bounded lock-free multi-producer / single-consumer queue used by other tasks
+ * (AsyncTCP handlers, MQTT, main loop) to hand display requests to the LVGL
+ * task without taking the LVGL mutex.
+ *
+ * Each slot carries a sequence number (Vyukov bounded queue): producers claim
+ * a position with a CAS on the enqueue index, copy their command in and then
+ * publish it by advancing the slot sequence. The LVGL task is the only
+ * consumer. A full queue rejects the push (callers count it as a drop).
+ */
+
+#ifndef DISPLAY_COMMAND_QUEUE_H
+#define DISPLAY_COMMAND_QUEUE_H
+
+#include "board_config.h"
+
+#if HAS_DISPLAY
+
+#include <Arduino.h>
+
+class Screen;
+
+enum class DisplayCommandType : uint8_t {
+    ShowScreen = 0,       // screen
+    ShowError = 1,        // title + text
+    SplashStatus = 2,     // text
+    SetBrightness = 3,    // value (0-100)
+    ShowDirectImage = 4,  // image session start (flush gate already set by producer)
+    ReturnFromImage = 5,  // image session end / hide
+    TriggerMacro = 6,     // screen (MacroPadScreen) + value (button index)
+    OtaProgress = 7,      // text; shows the static firmware update screen
+    OtaProgressEnd = 8,   // back to the screen the update interrupted
+    MemoryPressure = 9,   // value: MemPressureTier; shed caches / hidden screens
+    ReloadLabelFont = 10, // reload the macro label font from FFat (label_font.h)
+    RunBench = 11,        // display part of the benchmark suite (bench.h)
+};
+
+struct DisplayCommand {
+    DisplayCommandType type;
+    uint8_t value;
+    // Navigation requests stamp this for switch latency logging (0 = internal).
+    uint32_t requested_ms;
+    Screen* screen;
+    char title[48];
+    char text[192];
+};
+
+class DisplayCommandQueue {
+public:
+    DisplayCommandQueue();
+
+    // Safe from any task (not ISR). Returns false when the queue is full.
+    bool push(const DisplayCommand& cmd);
+
+    // Consumer side (LVGL task only).
+    bool pop(DisplayCommand* out);
+
+    // Approximate number of queued commands.
+    uint32_t depth() const;
+
+private:
+    static_assert((DISPLAY_CMD_QUEUE_DEPTH & (DISPLAY_CMD_QUEUE_DEPTH - 1)) == 0,
+                  "DISPLAY_CMD_QUEUE_DEPTH must be a power of two");
+    static constexpr uint32_t kMask = DISPLAY_CMD_QUEUE_DEPTH - 1;
+
+    struct Slot {
+        volatile uint32_t seq;
+        DisplayCommand cmd;
+    };
+
+    Slot slots[DISPLAY_CMD_QUEUE_DEPTH];
+    volatile uint32_t enqueuePos;
+    volatile uint32_t dequeuePos;
+};
+
+#endif // HAS_DISPLAY
+
+#endif // DISPLAY_COMMAND_QUEUE_H
@@ -51,6 +51,15 @@ public:
         // DisplayManager must call present() to push that buffer to the panel.
         Buffered = 1,
     };
+
+    // RGB565 byte order the driver wants in pushColors(..., swap_bytes=false).
+    enum class PixelOrder : uint8_t {
+        // CPU (little-endian) RGB565, as LVGL renders with LV_COLOR_16_SWAP=0.
+        HostEndian = 0,
+        // MSB-first RGB565 as sent on the wire by SPI/QSPI panels.
+        // Matches LVGL's LV_COLOR_16_SWAP=1 output.
+        BigEndian = 1,
+    };
     
     // Hardware initialization
     virtual void init() = 0;
@@ -69,6 +78,18 @@ public:
     virtual void setBacklightBrightness(uint8_t brightness) = 0;  // 0-100
     virtual uint8_t getBacklightBrightness() = 0;
     virtual bool hasBacklightControl() = 0;  // Capability query
+
+    // Optional hardware backlight fade (BACKLIGHT_HW_FADE_ENABLED).
+    // Starts a fade from `from` to `to` (0-100%) over duration_ms and returns
+    // immediately; the PWM peripheral steps the duty, so the fade stays smooth
+    // while the calling task is busy. getBacklightBrightness() reports `to`.
+    // Default: unsupported (returns false) and the screen saver fades in software.
+    virtual bool fadeBacklight(uint8_t from, uint8_t to, uint32_t duration_ms) {
+        (void)from;
+        (void)to;
+        (void)duration_ms;
+        return false;
+    }
     
     // Display-specific fixes/configuration (optional, board-dependent)
     virtual void applyDisplayFixes() = 0;
@@ -79,17 +100,79 @@ public:
     virtual void setAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) = 0;
     virtual void pushColors(uint16_t* data, uint32_t len, bool swap_bytes = true) = 0;
 
+    // Optional asynchronous flush (used when LVGL_DOUBLE_BUFFER is enabled).
+    // Starts transferring the current address window and returns immediately.
+    // The driver must call onDone(ctx) once the panel no longer reads from `data`;
+    // this may happen from ISR context.
+    // Default: unsupported (returns false) and callers fall back to pushColors().
+    virtual bool pushColorsAsync(uint16_t* data, uint32_t len, bool swap_bytes, void (*onDone)(void* ctx), void* ctx) {
+        (void)data;
+        (void)len;
+        (void)swap_bytes;
+        (void)onDone;
+        (void)ctx;
+        return false;
+    }
+
+    // Drivers whose library offers no transfer-complete interrupt finish an async
+    // flush here: if the transfer is done, release the bus and call onDone.
+    // DisplayManager calls it on the LVGL task (or with the LVGL mutex held)
+    // while LVGL waits for a flush and once per render cycle.
+    // Default: no-op (completion comes from the driver's own callback).
+    virtual void pollAsyncFlush() {
+    }
+
     // Declare whether the driver is Direct or Buffered.
     // Default: Direct (most SPI/QSPI drivers push pixels immediately in flush callback).
     virtual RenderMode renderMode() const {
         return RenderMode::Direct;
     }
 
+    // Declare the native pixel byte order. When it matches LVGL's color format the
+    // flush passes swap_bytes=false and no per-pixel swap pass is needed.
+    // Default: BigEndian (SPI/QSPI panels).
+    virtual PixelOrder pixelOrder() const {
+        return PixelOrder::BigEndian;
+    }
+
     // For buffered drivers, push the accumulated framebuffer/canvas to the panel.
     // Default: no-op (Direct drivers do not need an explicit present).
     virtual void present() {
         // Override in buffered drivers (e.g., Arduino_GFX canvas)
     }
+
+    // Optional read-back for buffered drivers (SCREEN_CAPTURE_ENABLED): copy the
+    // w x h rect at (x, y), in setAddrWindow() coordinates, from the buffer into
+    // out as host-endian RGB565. Called with the LVGL mutex held.
+    // Default: unsupported (returns false); Direct drivers are captured from the flushes.
+    virtual bool readRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* out) {
+        (void)x;
+        (void)y;
+        (void)w;
+        (void)h;
+        (void)out;
+        return false;
+    }
+
+    // Optional panel sleep while the screen saver has the backlight off
+    // (DISPLAY_SLEEP_PANEL_ON_SCREEN_SAVER). Called from the LVGL task with no flush
+    // in flight. Default: no-op (panel keeps scanning).
+    virtual void setPanelSleep(bool sleep) {
+        (void)sleep;
+    }
+
+    // Optional tearing-effect (TE) sync (DISPLAY_TE_SYNC_ENABLED).
+    // hasTearingEffect() reports whether a TE line is wired and active.
+    // waitForTearingEffect() blocks until the panel enters vertical blanking so the
+    // next write starts ahead of the scan; returns false on timeout/unsupported.
+    // DisplayManager decides when to wait and records the time spent.
+    virtual bool hasTearingEffect() const {
+        return false;
+    }
+    virtual bool waitForTearingEffect(uint32_t timeout_ms) {
+        (void)timeout_ms;
+        return false;
+    }
     
     // LVGL configuration hook (override to customize LVGL driver settings)
     // Called during LVGL initialization to allow driver-specific configuration
@@ -18,4 +18,8 @@
 #error "No display driver selected or unknown driver type"
 #endif
 
+#if DISPLAY_TE_SYNC_ENABLED
+#include "drivers/panel_te_sync.cpp"
+#endif
+
 #endif // HAS_DISPLAY
@@ -1,10 +1,42 @@
 #include "board_config.h"
 
+#define LOGGER_MODULE_LEVEL LOG_LEVEL_DISPLAY
+
 #if HAS_DISPLAY
 
 #include "display_manager.h"
+#include "boot_profile.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
 #include "log_manager.h"
 #include "device_telemetry.h"
+#include "memory_pressure.h"
+#include "task_placement.h"
+#include "trace.h"
+
+#if HAS_ICONS
+#include "icon_store.h"
+#endif
+
+#if LABEL_FONT_ENABLED
+#include "label_font.h"
+#endif
+
+#if LABEL_CACHE_ENABLED
+#include "label_cache.h"
+#endif
+
+#if SCREEN_CAPTURE_ENABLED
+#include "screen_capture.h"
+#endif
+
+#if BENCH_ENABLED
+#include "bench.h"
+#include "ducky_script.h"
+#if HAS_IMAGE_API
+#include "jpeg_preflight.h"
+#endif
+#endif
 
 // Include selected display driver header.
 // Driver implementations are compiled via src/app/display_drivers.cpp.
@@ -19,12 +51,78 @@
 #endif
 
 #include <SPI.h>
+#include <esp_heap_caps.h>
+#include <string.h>
 
 namespace {
 static portMUX_TYPE g_perf_mux = portMUX_INITIALIZER_UNLOCKED;
-static DisplayPerfStats g_perf = {0, 0, 0};
+static DisplayPerfStats g_perf = {};
+static uint32_t g_perf_flush_accum_us = 0;
+static uint32_t g_perf_kickoff_accum_us = 0;
 static uint32_t g_perf_window_start_ms = 0;
 static uint16_t g_perf_window_frames = 0;
+static uint32_t g_perf_window_px = 0;
+static uint32_t g_perf_window_flushes = 0;
+static uint32_t g_perf_window_bus_us = 0;
+
+// Fixed-size ring of recent per-frame samples; percentiles are computed on read
+// so the LVGL task only pays for a store.
+struct PerfRing {
+    uint32_t samples[DISPLAY_PERF_HIST_SAMPLES];
+    uint16_t count;
+    uint16_t next;
+};
+
+static PerfRing g_hist_render = {};
+static PerfRing g_hist_flush = {};
+static PerfRing g_hist_present = {};
+static PerfRing g_hist_te = {};
+
+// The async flush in flight, timed to its completion in asyncFlushDone().
+// One at a time: LVGL waits for flush ready before it flushes the next band.
+static volatile uint32_t g_perf_async_t0 = 0;
+static volatile uint32_t g_perf_async_px = 0;
+static volatile bool g_perf_async_last = false;
+
+// Caller holds g_perf_mux.
+static void perf_ring_push(PerfRing& ring, uint32_t us) {
+    ring.samples[ring.next] = us;
+    ring.next = (uint16_t)((ring.next + 1) % DISPLAY_PERF_HIST_SAMPLES);
+    if (ring.count < DISPLAY_PERF_HIST_SAMPLES) ring.count++;
+}
+
+static void perf_ring_summarize(const PerfRing& live, DisplayPerfHistogram* out) {
+    PerfRing ring;
+    portENTER_CRITICAL(&g_perf_mux);
+    ring = live;
+    portEXIT_CRITICAL(&g_perf_mux);
+
+    *out = {0, 0, 0, 0};
+    const uint16_t n = ring.count;
+    if (n == 0) return;
+
+    // Insertion sort: n is small and this runs on the reader's task.
+    uint32_t* v = ring.samples;
+    for (uint16_t i = 1; i < n; i++) {
+        const uint32_t key = v[i];
+        int j = (int)i - 1;
+        while (j >= 0 && v[j] > key) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = key;
+    }
+
+    // Nearest-rank percentiles.
+    auto rank = [n](uint32_t pct) -> uint16_t {
+        uint32_t idx = (pct * n + 99) / 100;
+        return (uint16_t)(idx > 0 ? idx - 1 : 0);
+    };
+    out->p50_us = v[rank(50)];
+    out->p95_us = v[rank(95)];
+    out->p99_us = v[rank(99)];
+    out->max_us = v[n - 1];
+}
 
 static void perf_update_lv_timer_us(uint32_t us) {
     portENTER_CRITICAL(&g_perf_mux);
@@ -35,13 +133,51 @@ static void perf_update_lv_timer_us(uint32_t us) {
 static void perf_update_present_us(uint32_t us) {
     portENTER_CRITICAL(&g_perf_mux);
     g_perf.present_us = us;
+    perf_ring_push(g_hist_present, us);
     portEXIT_CRITICAL(&g_perf_mux);
 }
 
-static void perf_mark_frame() {
+static void perf_add_te_wait_us(uint32_t us, bool timed_out) {
+    portENTER_CRITICAL(&g_perf_mux);
+    perf_ring_push(g_hist_te, us);
+    if (timed_out) g_perf.te_timeouts++;
+    portEXIT_CRITICAL(&g_perf_mux);
+}
+
+// Accumulate bus time per band; publish once LVGL flushed the frame's last band.
+// Also called from the DMA completion ISR (asyncFlushDone).
+static void perf_add_flush_us(uint32_t us, uint32_t px, bool last) {
+    portENTER_CRITICAL_SAFE(&g_perf_mux);
+    g_perf_flush_accum_us += us;
+    g_perf_window_px += px;
+    g_perf_window_flushes++;
+    g_perf_window_bus_us += us;
+    if (last) {
+        g_perf.flush_us = g_perf_flush_accum_us;
+        perf_ring_push(g_hist_flush, g_perf_flush_accum_us);
+        g_perf_flush_accum_us = 0;
+    }
+    portEXIT_CRITICAL_SAFE(&g_perf_mux);
+}
+
+// CPU time of async flush calls (kick-off until pushColorsAsync() returned).
+static void perf_add_flush_kickoff_us(uint32_t us, bool last) {
+    portENTER_CRITICAL(&g_perf_mux);
+    g_perf_kickoff_accum_us += us;
+    if (last) {
+        g_perf.flush_kickoff_us = g_perf_kickoff_accum_us;
+        g_perf_kickoff_accum_us = 0;
+    }
+    portEXIT_CRITICAL(&g_perf_mux);
+}
+
+// render_us: lv_timer_handler() time of the cycle that produced this frame.
+static void perf_mark_frame(uint32_t render_us) {
     const uint32_t now = millis();
 
     portENTER_CRITICAL(&g_perf_mux);
+    perf_ring_push(g_hist_render, render_us);
+
     if (g_perf_window_start_ms == 0) {
         g_perf_window_start_ms = now;
         g_perf_window_frames = 0;
@@ -52,11 +188,57 @@ static void perf_mark_frame() {
     if (elapsed >= 1000) {
         // Simple, low-cost FPS estimate.
         g_perf.fps = g_perf_window_frames;
+
+        g_perf.flush_px_per_s = (uint32_t)(((uint64_t)g_perf_window_px * 1000) / elapsed);
+        g_perf.flushes_per_frame = (float)g_perf_window_flushes / (float)g_perf_window_frames;
+        // bytes per microsecond == MB/s
+        g_perf.bus_mb_per_s = g_perf_window_bus_us
+            ? ((float)g_perf_window_px * (float)sizeof(lv_color_t)) / (float)g_perf_window_bus_us
+            : 0.0f;
+
         g_perf_window_start_ms = now;
         g_perf_window_frames = 0;
+        g_perf_window_px = 0;
+        g_perf_window_flushes = 0;
+        g_perf_window_bus_us = 0;
     }
     portEXIT_CRITICAL(&g_perf_mux);
 }
+
+// Macro screen cap counters (see MacroScreenCacheStats); LVGL task writes.
+static uint32_t g_macro_evictions = 0;
+static uint32_t g_macro_rebuilds = 0;
+
+// Command queue / mutex contention counters (see DisplayCommandStats).
+static portMUX_TYPE g_cmd_mux = portMUX_INITIALIZER_UNLOCKED;
+static DisplayCommandStats g_cmd_stats = {};
+
+static void cmd_stats_note_enqueue(bool ok, uint32_t depth) {
+    portENTER_CRITICAL(&g_cmd_mux);
+    if (ok) {
+        g_cmd_stats.enqueued++;
+        if (depth > g_cmd_stats.depth_max_window) g_cmd_stats.depth_max_window = depth;
+    } else {
+        g_cmd_stats.dropped++;
+    }
+    portEXIT_CRITICAL(&g_cmd_mux);
+}
+
+static void cmd_stats_note_lock_wait(uint32_t us) {
+    portENTER_CRITICAL(&g_cmd_mux);
+    g_cmd_stats.lock_count_window++;
+    g_cmd_stats.lock_wait_total_us_window += us;
+    if (us > g_cmd_stats.lock_wait_max_us_window) g_cmd_stats.lock_wait_max_us_window = us;
+    portEXIT_CRITICAL(&g_cmd_mux);
+}
+
+static lv_color_t* alloc_lvgl_draw_buffer() {
+    const size_t bytes = LVGL_BUFFER_SIZE * sizeof(lv_color_t);
+    // Some QSPI panels/drivers flush straight from the draw buffer by DMA and
+    // need it in internal RAM; otherwise it is an ordinary bulk buffer.
+    const HeapClass cls = LVGL_BUFFER_PREFER_INTERNAL ? HeapClass::Dma : HeapClass::Bulk;
+    return (lv_color_t*)heap_place_malloc(cls, HeapTag::Display, bytes);
+}
 } // namespace
 
 // Global instance
@@ -68,6 +250,8 @@ DisplayManager::DisplayManager(DeviceConfig* cfg)
     currentScreen(nullptr),
     previousScreen(nullptr),
     pendingScreen(nullptr),
+    otaScreenActive(false),
+    otaReturnScreen(nullptr),
     infoScreen(cfg, this),
     testScreen(this),
     errorScreen(this),
@@ -78,15 +262,45 @@ DisplayManager::DisplayManager(DeviceConfig* cfg)
     lvglMutex(nullptr),
     screenCount(0),
     buf(nullptr),
+    buf2(nullptr),
+    flushSwapBytes(true),
+    asyncFlush(false),
+#if LVGL_FLUSH_TASK_ENABLED && !CONFIG_FREERTOS_UNICORE
+    flushHead(0),
+    flushTail(0),
+    flushTaskHandle(nullptr),
+#endif
     flushPending(false),
+#if DISPLAY_TE_SYNC_ENABLED
+    teFrameSynced(false),
+#endif
+    renderSuspendRequested(false),
+    renderSuspended(false),
     directImageActive(false),
+#if HAS_IMAGE_API && IMAGE_API_RETURN_SNAPSHOT
+    returnSnapshot(nullptr),
+    returnSnapshotScreen(nullptr),
+    returnSnapshotBytes(0),
+    returnSnapshotW(0),
+    returnSnapshotH(0),
+#endif
     macroConfig(nullptr),
-    bleKeyboard(nullptr),
-    pendingSplashStatus{0},
-    pendingSplashStatusPending(false) {
+    bleKeyboard(nullptr) {
     mqttManager = nullptr;
     errorTitle[0] = '\0';
     errorMessage[0] = '\0';
+    switchRequestMs = 0;
+    switchShowMs = 0;
+    switchLatencyPending = false;
+    #if MACROPAD_PREWARM_NEIGHBORS > 0
+    prewarmPending = false;
+    #endif
+    shedLevel = 0;
+    #if MACROPAD_MAX_BUILT_SCREENS > 0
+    macroUseTick = 0;
+    memset(macroLastUse, 0, sizeof(macroLastUse));
+    macroEvictedMask = 0;
+    #endif
 
     // Instantiate selected display driver
     #if DISPLAY_DRIVER == DISPLAY_DRIVER_TFT_ESPI
@@ -146,6 +360,13 @@ DisplayManager::~DisplayManager() {
         vTaskDelete(lvglTaskHandle);
         lvglTaskHandle = nullptr;
     }
+
+    #if LVGL_FLUSH_TASK_ENABLED && !CONFIG_FREERTOS_UNICORE
+    if (flushTaskHandle) {
+        vTaskDelete(flushTaskHandle);
+        flushTaskHandle = nullptr;
+    }
+    #endif
     
     if (currentScreen) {
         currentScreen->hide();
@@ -178,11 +399,15 @@ DisplayManager::~DisplayManager() {
         lvglMutex = nullptr;
     }
     
-    // Free LVGL buffer
+    // Free LVGL buffers
     if (buf) {
-        heap_caps_free(buf);
+        heap_tag_free(HeapTag::Display, buf);
         buf = nullptr;
     }
+    if (buf2) {
+        heap_tag_free(HeapTag::Display, buf2);
+        buf2 = nullptr;
+    }
 }
 
 void DisplayManager::setMacroRuntime(MacroConfig* cfg, BleKeyboardManager* keyboard) {
@@ -191,13 +416,165 @@ void DisplayManager::setMacroRuntime(MacroConfig* cfg, BleKeyboardManager* keybo
 }
 
 void DisplayManager::showError(const char* title, const char* message) {
-    // Persist content so callers can pass temporary buffers.
-    strlcpy(errorTitle, title ? title : "", sizeof(errorTitle));
-    strlcpy(errorMessage, message ? message : "", sizeof(errorMessage));
+    // The command carries its own copy so callers can pass temporary buffers
+    // and concurrent errors cannot mix titles and messages.
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::ShowError;
+    strlcpy(cmd.title, title ? title : "", sizeof(cmd.title));
+    strlcpy(cmd.text, message ? message : "", sizeof(cmd.text));
+    if (enqueueCommand(cmd)) {
+        Logger.logMessage("Display", "Queued switch to ErrorScreen");
+    }
+}
+
+bool DisplayManager::enqueueCommand(const DisplayCommand& cmd) {
+    const bool ok = commands.push(cmd);
+    cmd_stats_note_enqueue(ok, commands.depth());
+    if (!ok) {
+        Logger.logMessagef("Display", "WARNING: command queue full; dropped command %u", (unsigned)cmd.type);
+        return false;
+    }
+    requestRender();
+    return true;
+}
 
-    // Ensure the error screen shows the current text when it becomes active.
-    pendingScreen = &errorScreen;
-    Logger.logMessage("Display", "Queued switch to ErrorScreen");
+void DisplayManager::enqueueScreen(Screen* screen, uint32_t requestedMs) {
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::ShowScreen;
+    cmd.screen = screen;
+    cmd.requested_ms = requestedMs;
+    (void)enqueueCommand(cmd);
+}
+
+void DisplayManager::applyCommand(const DisplayCommand& cmd) {
+    // LVGL task, mutex held. Screen requests only pick the target; the switch
+    // itself runs once per cycle, so a burst of requests costs one show().
+    switch (cmd.type) {
+        case DisplayCommandType::ShowScreen:
+            if (cmd.screen && otaScreenActive) {
+                otaReturnScreen = cmd.screen;
+            } else if (cmd.screen) {
+                pendingScreen = cmd.screen;
+                switchRequestMs = cmd.requested_ms;
+            }
+            break;
+
+        case DisplayCommandType::ShowError:
+            strlcpy(errorTitle, cmd.title, sizeof(errorTitle));
+            strlcpy(errorMessage, cmd.text, sizeof(errorMessage));
+            if (currentScreen == &errorScreen && pendingScreen == nullptr) {
+                // Already visible: update the text in place.
+                errorScreen.setError(errorTitle, errorMessage);
+            } else {
+                pendingScreen = &errorScreen;
+            }
+            break;
+
+        case DisplayCommandType::SplashStatus:
+            splashScreen.setStatus(cmd.text);
+            break;
+
+        case DisplayCommandType::SetBrightness:
+            driver->setBacklightBrightness(cmd.value);
+            break;
+
+        case DisplayCommandType::OtaProgress:
+            if (!otaScreenActive) {
+                otaScreenActive = true;
+                Screen* from = pendingScreen ? pendingScreen : currentScreen;
+                #if HAS_IMAGE_API
+                // An image session does not survive the update screen.
+                if (from == &directImageScreen) {
+                    from = previousScreen ? previousScreen : &infoScreen;
+                }
+                #endif
+                otaReturnScreen = (from == &splashScreen) ? nullptr : from;
+                splashScreen.setSpinnerVisible(false);
+                pendingScreen = &splashScreen;
+            }
+            splashScreen.setStatus(cmd.text);
+            break;
+
+        case DisplayCommandType::OtaProgressEnd:
+            if (otaScreenActive) {
+                otaScreenActive = false;
+                splashScreen.setSpinnerVisible(true);
+                pendingScreen = otaReturnScreen ? otaReturnScreen : &infoScreen;
+                otaReturnScreen = nullptr;
+            }
+            break;
+
+        case DisplayCommandType::MemoryPressure:
+            applyShedLevel(cmd.value);
+            break;
+
+        case DisplayCommandType::ReloadLabelFont:
+            #if LABEL_FONT_ENABLED
+            label_font_apply();
+            #endif
+            break;
+
+        case DisplayCommandType::RunBench:
+            #if BENCH_ENABLED
+            runBench();
+            #endif
+            break;
+
+        case DisplayCommandType::TriggerMacro:
+            if (cmd.screen) {
+                static_cast<MacroPadScreen*>(cmd.screen)->triggerButton(cmd.value);
+            }
+            break;
+
+        #if HAS_IMAGE_API
+        case DisplayCommandType::ShowDirectImage:
+            if (otaScreenActive) {
+                // The image API is held during updates; do not let a late
+                // session cover the update screen.
+                directImageActive = false;
+                break;
+            }
+            // If we're already showing the DirectImageScreen, don't switch again
+            // (it would also clobber previousScreen).
+            if (currentScreen == &directImageScreen && pendingScreen == nullptr) {
+                Logger.logMessage("Display", "Already on DirectImageScreen");
+                break;
+            }
+            // Save the screen to return to after the image times out.
+            if (currentScreen && currentScreen != &directImageScreen) {
+                previousScreen = currentScreen;
+                #if IMAGE_API_RETURN_SNAPSHOT
+                takeReturnSnapshot();
+                #endif
+            }
+            pendingScreen = &directImageScreen;
+            break;
+
+        case DisplayCommandType::ReturnFromImage:
+            if (otaScreenActive) {
+                if (otaReturnScreen == &directImageScreen || otaReturnScreen == nullptr) {
+                    otaReturnScreen = previousScreen ? previousScreen : &infoScreen;
+                }
+                previousScreen = nullptr;
+                #if IMAGE_API_RETURN_SNAPSHOT
+                freeReturnSnapshot();
+                #endif
+                break;
+            }
+            // If no previous screen, default to info screen.
+            pendingScreen = previousScreen ? previousScreen : &infoScreen;
+            previousScreen = nullptr;
+            #if IMAGE_API_RETURN_SNAPSHOT
+            // The old frame goes up now; the screen switch below redraws the
+            // same pixels (and anything that changed meanwhile) afterwards.
+            blitReturnSnapshot(pendingScreen);
+            #endif
+            break;
+        #endif
+
+        default:
+            break;
+    }
 }
 
 const char* DisplayManager::getScreenIdForInstance(const Screen* screen) const {
@@ -237,14 +614,54 @@ void DisplayManager::flushCallback(lv_disp_drv_t *disp, const lv_area_t *area, l
         return;
     }
     #endif
+
+    #if SCREEN_CAPTURE_ENABLED
+    // Before the panel (or flush task) gets the buffer: the tap copies it while it is still LVGL's.
+    screen_capture_flush_tap(disp, area, color_p);
+    #endif
     
+    #if LVGL_FLUSH_TASK_ENABLED && !CONFIG_FREERTOS_UNICORE
+    // Hand the area to the flush task on the other core; it signals flush ready.
+    if (mgr->flushTaskHandle && mgr->enqueueFlush(disp, area, color_p)) {
+        mgr->flushPending = true;
+        TRACE_INSTANT("lvgl.flush_enqueue");
+        return;
+    }
+    #endif
+
+    TRACE_SCOPE("lvgl.flush");
     uint32_t w = (area->x2 - area->x1 + 1);
     uint32_t h = (area->y2 - area->y1 + 1);
+
+    #if DISPLAY_TE_SYNC_ENABLED
+    mgr->teSyncBand(disp);
+    #endif
     
+    const uint32_t t0 = micros();
     mgr->driver->startWrite();
     mgr->driver->setAddrWindow(area->x1, area->y1, w, h);
-    mgr->driver->pushColors((uint16_t *)&color_p->full, w * h, true);
+
+    // Double-buffered: start the transfer and return so LVGL can render the next
+    // band into the other buffer. The driver reports completion via asyncFlushDone.
+    bool started = false;
+    const bool last = lv_disp_flush_is_last(disp);
+    if (mgr->asyncFlush) {
+        // Armed first: the transfer may complete before pushColorsAsync() returns.
+        g_perf_async_t0 = t0;
+        g_perf_async_px = w * h;
+        g_perf_async_last = last;
+        started = mgr->driver->pushColorsAsync((uint16_t *)&color_p->full, w * h, mgr->flushSwapBytes, DisplayManager::asyncFlushDone, disp);
+    }
+    if (!started) {
+        mgr->driver->pushColors((uint16_t *)&color_p->full, w * h, mgr->flushSwapBytes);
+    }
     mgr->driver->endWrite();
+    if (started) {
+        // The bus time is recorded by asyncFlushDone().
+        perf_add_flush_kickoff_us(micros() - t0, last);
+    } else {
+        perf_add_flush_us(micros() - t0, w * h, last);
+    }
 
     // Signal that the driver may need a post-render present() step.
     // For Direct render-mode drivers this is harmless (present() is a no-op).
@@ -252,9 +669,399 @@ void DisplayManager::flushCallback(lv_disp_drv_t *disp, const lv_area_t *area, l
         mgr->flushPending = true;
     }
     
-    lv_disp_flush_ready(disp);
+    if (!started) {
+        lv_disp_flush_ready(disp);
+    }
+}
+
+void DisplayManager::asyncFlushDone(void* ctx) {
+    // May run in the DMA ISR: the perf update only takes a spinlock and
+    // lv_disp_flush_ready() only sets flags.
+    perf_add_flush_us(micros() - g_perf_async_t0, g_perf_async_px, g_perf_async_last);
+    lv_disp_flush_ready((lv_disp_drv_t*)ctx);
+}
+
+void DisplayManager::flushWaitCallback(lv_disp_drv_t* disp) {
+    DisplayManager* mgr = (DisplayManager*)disp->user_data;
+    if (mgr && mgr->asyncFlush) {
+        mgr->driver->pollAsyncFlush();
+    }
+    taskYIELD();
+}
+
+void DisplayManager::waitFlushIdle() {
+    // Bounded: a transfer that never completes must not wedge callers forever.
+    const uint32_t start = millis();
+    while (draw_buf.flushing && (millis() - start) < 500) {
+        if (asyncFlush) {
+            driver->pollAsyncFlush();
+            if (!draw_buf.flushing) break;
+        }
+        vTaskDelay(1);
+    }
+}
+
+#if LVGL_FLUSH_TASK_ENABLED && !CONFIG_FREERTOS_UNICORE
+bool DisplayManager::enqueueFlush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p) {
+    // LVGL keeps at most one flush per draw buffer in flight, so the ring only
+    // fills if the flush task stalls; wait briefly rather than reorder bands.
+    const uint32_t start = millis();
+    while ((uint32_t)(flushHead - __atomic_load_n(&flushTail, __ATOMIC_ACQUIRE)) >= LVGL_FLUSH_QUEUE_DEPTH) {
+        if ((millis() - start) >= 500) {
+            return false;
+        }
+        taskYIELD();
+    }
+
+    const uint32_t head = flushHead;
+    FlushJob& job = flushQueue[head % LVGL_FLUSH_QUEUE_DEPTH];
+    job.disp = disp;
+    job.area = *area;
+    job.color_p = color_p;
+    __atomic_store_n(&flushHead, head + 1, __ATOMIC_RELEASE);
+
+    xTaskNotifyGive(flushTaskHandle);
+    return true;
+}
+
+void DisplayManager::flushTask(void* pvParameter) {
+    DisplayManager* mgr = (DisplayManager*)pvParameter;
+
+    Logger.logBegin("LVGL Flush Task");
+    Logger.logLinef("Started on core %d (queue depth %d)", xPortGetCoreID(), (int)LVGL_FLUSH_QUEUE_DEPTH);
+    Logger.logEnd();
+
+    while (true) {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (mgr->flushTail != __atomic_load_n(&mgr->flushHead, __ATOMIC_ACQUIRE)) {
+            const uint32_t tail = mgr->flushTail;
+            const FlushJob job = mgr->flushQueue[tail % LVGL_FLUSH_QUEUE_DEPTH];
+
+            const uint32_t w = (uint32_t)(job.area.x2 - job.area.x1 + 1);
+            const uint32_t h = (uint32_t)(job.area.y2 - job.area.y1 + 1);
+
+            #if DISPLAY_TE_SYNC_ENABLED
+            mgr->teSyncBand(job.disp);
+            #endif
+
+            const uint32_t t0 = micros();
+            mgr->driver->startWrite();
+            mgr->driver->setAddrWindow(job.area.x1, job.area.y1, w, h);
+            mgr->driver->pushColors((uint16_t *)&job.color_p->full, w * h, mgr->flushSwapBytes);
+            mgr->driver->endWrite();
+            perf_add_flush_us(micros() - t0, w * h, lv_disp_flush_is_last(job.disp));
+
+            __atomic_store_n(&mgr->flushTail, tail + 1, __ATOMIC_RELEASE);
+            lv_disp_flush_ready(job.disp);
+        }
+    }
+}
+#endif
+
+void DisplayManager::syncTearingEffect() {
+    #if DISPLAY_TE_SYNC_ENABLED
+    if (!driver || !driver->hasTearingEffect()) return;
+    const uint32_t t0 = micros();
+    const bool seen = driver->waitForTearingEffect(DISPLAY_TE_WAIT_TIMEOUT_MS);
+    perf_add_te_wait_us(micros() - t0, !seen);
+    #endif
+}
+
+#if DISPLAY_TE_SYNC_ENABLED
+void DisplayManager::teSyncBand(lv_disp_drv_t* disp) {
+    // Buffered drivers only touch their canvas here; they sync in present().
+    if (driver->renderMode() != DisplayDriver::RenderMode::Direct) return;
+
+    // Later bands of the same refresh follow the scan down the panel.
+    if (!teFrameSynced) {
+        syncTearingEffect();
+        teFrameSynced = true;
+    }
+    if (lv_disp_flush_is_last(disp)) {
+        teFrameSynced = false;
+    }
+}
+#endif
+
+#if MACROPAD_PREWARM_NEIGHBORS > 0
+bool DisplayManager::prewarmNextNeighbor() {
+    int current = -1;
+    for (int i = 0; i < MACROS_SCREEN_COUNT; i++) {
+        if (currentScreen == &macroScreens[i]) {
+            current = i;
+            break;
+        }
+    }
+    if (current < 0) return false;
+
+    // Nearest first, next before previous (matches nav-next being the common tap).
+    for (int d = 1; d <= MACROPAD_PREWARM_NEIGHBORS && d < MACROS_SCREEN_COUNT; d++) {
+        const int candidates[2] = {
+            (current + d) % MACROS_SCREEN_COUNT,
+            (current + MACROS_SCREEN_COUNT - d) % MACROS_SCREEN_COUNT,
+        };
+        for (int c = 0; c < 2; c++) {
+            MacroPadScreen& s = macroScreens[candidates[c]];
+            if (!s.isWarm()) {
+                const uint32_t t0 = millis();
+                s.prewarm();
+                Logger.logMessagef("Display", "Pre-warmed macro%d (%lu ms)", candidates[c] + 1, (unsigned long)(millis() - t0));
+                #if MACROPAD_MAX_BUILT_SCREENS > 0
+                noteMacroScreenUse(&s);
+                #endif
+                return true;
+            }
+        }
+    }
+    return false;
+}
+#endif
+
+#if MACROPAD_MAX_BUILT_SCREENS > 0
+static_assert(MACROPAD_MAX_BUILT_SCREENS >= 1 + 2 * MACROPAD_PREWARM_NEIGHBORS || MACROPAD_MAX_BUILT_SCREENS >= MACROS_SCREEN_COUNT,
+              "MACROPAD_MAX_BUILT_SCREENS must hold the active screen and its pre-warmed neighbours");
+
+void DisplayManager::noteMacroScreenUse(Screen* screen) {
+    int used = -1;
+    for (int i = 0; i < MACROS_SCREEN_COUNT; i++) {
+        if (screen == &macroScreens[i]) {
+            used = i;
+            break;
+        }
+    }
+    if (used < 0) return;
+
+    if (macroEvictedMask & (1u << used)) {
+        macroEvictedMask &= ~(1u << used);
+        g_macro_rebuilds++;
+    }
+    macroLastUse[used] = ++macroUseTick;
+
+    int current = -1;
+    for (int i = 0; i < MACROS_SCREEN_COUNT; i++) {
+        if (currentScreen == &macroScreens[i]) {
+            current = i;
+            break;
+        }
+    }
+
+    while (getBuiltMacroScreenCount() > MACROPAD_MAX_BUILT_SCREENS) {
+        // Least recently used hidden screen; pre-warmed neighbours of the
+        // active one go last so pre-warming does not evict its own work.
+        int victim = -1;
+        bool victimNear = true;
+        for (int i = 0; i < MACROS_SCREEN_COUNT; i++) {
+            MacroPadScreen* s = &macroScreens[i];
+            if (!s->isCreated() || s == currentScreen || s == pendingScreen || i == used) continue;
+            bool near = false;
+            if (current >= 0) {
+                const int d = (i - current + MACROS_SCREEN_COUNT) % MACROS_SCREEN_COUNT;
+                near = d <= MACROPAD_PREWARM_NEIGHBORS || MACROS_SCREEN_COUNT - d <= MACROPAD_PREWARM_NEIGHBORS;
+            }
+            if (victim < 0 || (victimNear && !near) ||
+                (near == victimNear && macroLastUse[i] < macroLastUse[victim])) {
+                victim = i;
+                victimNear = near;
+            }
+        }
+        if (victim < 0) break;
+        macroScreens[victim].destroy();
+        macroEvictedMask |= 1u << victim;
+        g_macro_evictions++;
+        LOGI("Display", "Destroyed macro%d (least recently used)", victim + 1);
+    }
+}
+#endif
+
+uint8_t DisplayManager::getBuiltMacroScreenCount() const {
+    uint8_t built = 0;
+    for (int i = 0; i < MACROS_SCREEN_COUNT; i++) {
+        if (macroScreens[i].isCreated()) built++;
+    }
+    return built;
 }
 
+void DisplayManager::applyShedLevel(uint8_t level) {
+    const uint8_t was = shedLevel;
+    shedLevel = level;
+    // Coming down needs nothing: screens and caches rebuild on their next use.
+    if (level <= was) return;
+
+    // Screens first: destroying one drops its icon references, so the cache
+    // trim below can evict those too.
+    if (level >= (uint8_t)MemPressureTier::Screens && was < (uint8_t)MemPressureTier::Screens) {
+        unsigned screens = 0;
+        for (int i = 0; i < MACROS_SCREEN_COUNT; i++) {
+            MacroPadScreen* s = &macroScreens[i];
+            if (s == currentScreen || s == pendingScreen || !s->isCreated()) continue;
+            s->destroy();
+            screens++;
+        }
+        #if HAS_IMAGE_API && LV_USE_IMG
+        if (&lvglImageScreen != currentScreen && &lvglImageScreen != pendingScreen) {
+            lvglImageScreen.destroy();
+        }
+        #endif
+        #if MACROPAD_PREWARM_NEIGHBORS > 0
+        prewarmPending = false;
+        #endif
+        Logger.logMessagef("Display", "Memory pressure: destroyed %u hidden macro screen(s)", screens);
+    }
+
+    #if HAS_IMAGE_API && IMAGE_API_RETURN_SNAPSHOT
+    // The return from an image falls back to a normal redraw.
+    freeReturnSnapshot();
+    #endif
+
+    unsigned icons = 0;
+    #if HAS_ICONS
+    icons = icon_store_trim_unreferenced();
+    #endif
+    const unsigned masks = MacroPadScreen::trimMask2xCache(macroScreens, MACROS_SCREEN_COUNT);
+    unsigned labels = 0;
+    #if LABEL_CACHE_ENABLED
+    labels = label_cache_trim_unreferenced();
+    #endif
+    Logger.logMessagef("Display", "Memory pressure: dropped %u icon(s), %u 2x mask(s), %u label bitmap(s)", icons, masks, labels);
+}
+
+#if BENCH_ENABLED
+uint32_t DisplayManager::benchRedraw(uint16_t frames) {
+    const bool buffered = driver->renderMode() == DisplayDriver::RenderMode::Buffered;
+    const uint32_t t0 = micros();
+    for (uint16_t i = 0; i < frames; i++) {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(nullptr);
+        waitFlushIdle();
+        if (buffered) driver->present();
+    }
+    return micros() - t0;
+}
+
+void DisplayManager::runBench() {
+    // LVGL task, mutex held: nothing else renders or touches the panel until
+    // this returns. Each part runs whole frames so the numbers compare
+    // across drivers (direct, buffered, DMA).
+    BenchDisplayResult* r = bench_display_result();
+    if (renderSuspended) {
+        r->skipped = "display asleep";
+    } else if (otaScreenActive) {
+        r->skipped = "firmware update";
+    } else if (!currentScreen) {
+        r->skipped = "no screen";
+    }
+    #if HAS_IMAGE_API
+    if (directImageActive || currentScreen == &directImageScreen) {
+        r->skipped = "direct image shown";
+    }
+    #endif
+    if (r->skipped) {
+        bench_display_done();
+        return;
+    }
+
+    const bool buffered = driver->renderMode() == DisplayDriver::RenderMode::Buffered;
+    const uint16_t frames = BENCH_DISPLAY_FRAMES;
+    r->width = (uint16_t)driver->width();
+    r->height = (uint16_t)driver->height();
+    r->frames = frames;
+    waitFlushIdle();
+
+    // Fill: solid color into the draw buffer (CPU). Flush: the buffer pushed
+    // band by band over the whole panel, as flushCallback() does.
+    {
+        uint16_t* px = (uint16_t*)buf;
+        const uint32_t bufPx = draw_buf.size;
+        const uint16_t rows = (uint16_t)(bufPx / r->width);
+        for (uint16_t i = 0; i < frames && rows > 0; i++) {
+            const uint16_t color = (i & 1) ? 0x4208 : 0x2104;  // dark grays
+            uint32_t t0 = micros();
+            for (uint32_t p = 0; p < bufPx; p++) px[p] = color;
+            // Scaled from one buffer to the whole panel.
+            r->fill_us += (uint32_t)((uint64_t)(micros() - t0) * r->width * r->height / bufPx);
+
+            t0 = micros();
+            driver->startWrite();
+            for (uint16_t y = 0; y < r->height; y += rows) {
+                const uint16_t h = (uint16_t)((r->height - y) < rows ? (r->height - y) : rows);
+                driver->setAddrWindow(0, (int16_t)y, r->width, h);
+                driver->pushColors(px, (uint32_t)r->width * h, false);
+            }
+            driver->endWrite();
+            if (buffered) driver->present();
+            r->flush_us += micros() - t0;
+        }
+    }
+
+    r->redraw_us = benchRedraw(frames);
+
+    #if HAS_IMAGE_API
+    // The image upload path: StripDecoder straight onto the panel.
+    size_t jpegLen = 0;
+    const uint8_t* jpeg = bench_jpeg(&jpegLen);
+    int jw = 0;
+    int jh = 0;
+    if (jpeg && jpeg_read_dimensions(jpeg, jpegLen, &jw, &jh)) {
+        const int scale = jpeg_tjpgd_fit_scale(jw, jh, r->width, r->height);
+        const int div = 1 << (scale > 0 ? scale : 0);
+        StripDecoder decoder;
+        decoder.setDisplayDriver(driver);
+        decoder.begin(r->width, r->height, r->width, r->height);
+        for (uint16_t i = 0; i < 4; i++) {
+            const uint32_t t0 = micros();
+            if (!decoder.decode_fit(jpeg, jpegLen, nullptr, nullptr, false, STRIP_FIT_CENTER)) break;
+            if (buffered) driver->present();
+            r->strip_us += micros() - t0;
+            r->strip_runs++;
+        }
+        decoder.end();
+        r->strip_pixels = (uint32_t)((jw + div - 1) / div) * (uint32_t)((jh + div - 1) / div);
+    }
+    #endif
+
+    // Each template on macro screen 1 (its buttons). The screens render from
+    // a scratch copy of the config, so the live one (saved by PATCH workers,
+    // returned by GET /api/macros) never holds a bench template.
+    MacroConfig* live = macroConfig;
+    MacroConfig* scratch = live && shedLevel < (uint8_t)MemPressureTier::Screens
+        ? (MacroConfig*)heap_place_malloc(HeapClass::Transient, HeapTag::Display, sizeof(MacroConfig))
+        : nullptr;
+    if (scratch) {
+        memcpy(scratch, live, sizeof(MacroConfig));
+        macroConfig = scratch;
+        MacroPadScreen& s = macroScreens[0];
+        const bool wasCreated = s.isCreated();
+        for (size_t k = 0; k < BENCH_TEMPLATE_COUNT; k++) {
+            strlcpy(scratch->template_id[0], macro_templates::id_for((macro_templates::TemplateKind)k), MACROS_TEMPLATE_ID_MAX_LEN);
+            macros_config_mark_screen_changed(0);
+            s.show();
+            // Untimed first frame: layout, icon and label bitmap loads.
+            (void)benchRedraw(1);
+            r->template_us[k] = benchRedraw(frames);
+        }
+        macroConfig = live;
+        heap_tag_free(HeapTag::Display, scratch);
+        // Rebuild from the live config, including any edit made meanwhile.
+        macros_config_mark_screen_changed(0);
+        if (!wasCreated && &s != currentScreen && &s != pendingScreen) {
+            s.destroy();
+        }
+    }
+
+    // Back to what was shown; the next cycle repaints it.
+    currentScreen->show();
+    lv_obj_invalidate(lv_scr_act());
+    flushPending = false;
+    requestRender();
+
+    r->ran = true;
+    Logger.logMessagef("Display", "Bench: flush %lu us/frame, redraw %lu us/frame",
+        (unsigned long)(r->flush_us / frames), (unsigned long)(r->redraw_us / frames));
+    bench_display_done();
+}
+#endif
+
 bool DisplayManager::isInLvglTask() const {
     if (!lvglTaskHandle) return false;
     return xTaskGetCurrentTaskHandle() == lvglTaskHandle;
@@ -277,7 +1084,19 @@ void DisplayManager::unlockIfNeeded(bool didLock) {
 
 void DisplayManager::lock() {
     if (lvglMutex) {
-        xSemaphoreTake(lvglMutex, portMAX_DELAY);
+        if (isInLvglTask()) {
+            xSemaphoreTake(lvglMutex, portMAX_DELAY);
+        } else {
+            const uint32_t t0 = micros();
+            xSemaphoreTake(lvglMutex, portMAX_DELAY);
+            cmd_stats_note_lock_wait(micros() - t0);
+        }
+    }
+
+    // External lockers (e.g. the strip decoder) may drive the panel directly;
+    // make sure no LVGL band is still being transferred behind their back.
+    if (!isInLvglTask()) {
+        waitFlushIdle();
     }
 }
 
@@ -285,11 +1104,63 @@ void DisplayManager::unlock() {
     if (lvglMutex) {
         xSemaphoreGive(lvglMutex);
     }
+
+    // External callers lock to mutate LVGL state; make sure it gets rendered
+    // without waiting for the task's idle timeout.
+    if (!isInLvglTask()) {
+        requestRender();
+    }
+}
+
+void DisplayManager::setRenderSuspended(bool suspended) {
+    if (renderSuspendRequested == suspended) return;
+    renderSuspendRequested = suspended;
+    requestRender();
+}
+
+void DisplayManager::applyRenderSuspend(bool suspend) {
+    // Runs on the LVGL task with the LVGL mutex held.
+    waitFlushIdle();
+
+    if (suspend) {
+        // Nothing drawn now is visible; resume redraws the whole screen anyway.
+        flushPending = false;
+        #if DISPLAY_SLEEP_PANEL_ON_SCREEN_SAVER
+        driver->setPanelSleep(true);
+        #endif
+        renderSuspended = true;
+        Logger.logMessage("Display", "Render suspended");
+        return;
+    }
+
+    #if DISPLAY_SLEEP_PANEL_ON_SCREEN_SAVER
+    driver->setPanelSleep(false);
+    #endif
+    renderSuspended = false;
+
+    // One full refresh: panel RAM may be stale (or lost in panel sleep).
+    lv_obj_invalidate(lv_scr_act());
+    Logger.logMessage("Display", "Render resumed");
+}
+
+void DisplayManager::requestRender() {
+    if (lvglTaskHandle) {
+        xTaskNotifyGive(lvglTaskHandle);
+    }
 }
 
 bool DisplayManager::tryLock(uint32_t timeoutMs) {
     if (!lvglMutex) return false;
-    return xSemaphoreTake(lvglMutex, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+    const uint32_t t0 = micros();
+    const bool taken = xSemaphoreTake(lvglMutex, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+    if (!isInLvglTask()) {
+        cmd_stats_note_lock_wait(micros() - t0);
+    }
+    if (!taken) return false;
+    if (!isInLvglTask()) {
+        waitFlushIdle();
+    }
+    return true;
 }
 
 // FreeRTOS task for continuous LVGL rendering
@@ -302,11 +1173,29 @@ void DisplayManager::lvglTask(void* pvParameter) {
     
     while (true) {
         mgr->lock();
+        const uint32_t cycle_t0 = micros();
 
-        // Apply deferred splash status update if one was queued.
-        if (mgr->pendingSplashStatusPending && mgr->currentScreen == &mgr->splashScreen) {
-            mgr->splashScreen.setStatus(mgr->pendingSplashStatus);
-            mgr->pendingSplashStatusPending = false;
+        // Screen saver suspend/resume (requested from the main loop task).
+        {
+            const bool wantSuspend = mgr->renderSuspendRequested;
+            if (wantSuspend != mgr->renderSuspended) {
+                mgr->applyRenderSuspend(wantSuspend);
+            }
+        }
+
+        // Drain cross-task requests. Bounded per cycle so a flood of producers
+        // cannot starve rendering; leftovers are picked up next cycle.
+        {
+            DisplayCommand cmd;
+            uint32_t drained = 0;
+            while (drained < DISPLAY_CMD_QUEUE_DEPTH && mgr->commands.pop(&cmd)) {
+                mgr->applyCommand(cmd);
+                drained++;
+            }
+            if (drained) TRACE_COUNTER("lvgl.commands", drained);
+            if (drained == DISPLAY_CMD_QUEUE_DEPTH) {
+                mgr->requestRender();
+            }
         }
         
         // Process pending screen switch (deferred from external calls)
@@ -342,7 +1231,15 @@ void DisplayManager::lvglTask(void* pvParameter) {
             if (mgr->currentScreen == &mgr->errorScreen) {
                 mgr->errorScreen.setError(mgr->errorTitle, mgr->errorMessage);
             }
+            const uint32_t showStartMs = millis();
+            TRACE_BEGIN("lvgl.screen_show");
             mgr->currentScreen->show();
+            TRACE_END("lvgl.screen_show");
+            mgr->switchShowMs = millis() - showStartMs;
+            mgr->switchLatencyPending = true;
+            #if MACROPAD_MAX_BUILT_SCREENS > 0
+            mgr->noteMacroScreenUse(mgr->currentScreen);
+            #endif
             mgr->pendingScreen = nullptr;
             const char* appliedId = mgr->getScreenIdForInstance(mgr->currentScreen);
 
@@ -352,7 +1249,7 @@ void DisplayManager::lvglTask(void* pvParameter) {
             #endif
 
             const char* screenId = appliedId;
-            Logger.logMessagef("Display", "Switched to %s", screenId ? screenId : "(unregistered)");
+            LOGI("Display", "Switched to %s", screenId ? screenId : "(unregistered)");
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
             {
@@ -362,39 +1259,130 @@ void DisplayManager::lvglTask(void* pvParameter) {
             }
 #endif
         }
+
+        // Suspended: screen switches are still applied above, but nothing is
+        // rendered or flushed until setRenderSuspended(false) wakes us.
+        if (mgr->renderSuspended) {
+            mgr->unlock();
+            (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
         
+        #if SCREEN_CAPTURE_ENABLED
+        #if HAS_IMAGE_API
+        screen_capture_lvgl_poll(mgr->directImageActive);
+        #else
+        screen_capture_lvgl_poll(false);
+        #endif
+        #endif
+
         // Handle LVGL rendering (animations, timers, etc.)
+        TRACE_BEGIN("lvgl.timer_handler");
         const uint32_t t0 = micros();
         uint32_t delayMs = lv_timer_handler();
         const uint32_t t1 = micros();
+        TRACE_END("lvgl.timer_handler");
         perf_update_lv_timer_us(t1 - t0);
         
         // Update current screen (data refresh)
         if (mgr->currentScreen) {
+            TRACE_BEGIN("lvgl.screen_update");
             mgr->currentScreen->update();
+            TRACE_END("lvgl.screen_update");
+        }
+
+        // Polled drivers: finish the last band before sleeping so the bus is
+        // released now rather than on the next cycle.
+        if (mgr->asyncFlush) {
+            mgr->driver->pollAsyncFlush();
         }
         
         // Flush canvas buffer only when LVGL produced draw data.
         if (mgr->flushPending) {
             // One 'frame' per rendered cycle (even if multiple flush callbacks happened).
-            perf_mark_frame();
+            perf_mark_frame(t1 - t0);
             if (mgr->driver->renderMode() == DisplayDriver::RenderMode::Buffered) {
+                // The last band may still be in flight on the flush task / DMA.
+                mgr->waitFlushIdle();
+                mgr->syncTearingEffect();
+                TRACE_BEGIN("lvgl.present");
                 const uint32_t p0 = micros();
                 mgr->driver->present();
                 const uint32_t p1 = micros();
+                TRACE_END("lvgl.present");
                 perf_update_present_us(p1 - p0);
             }
             mgr->flushPending = false;
+            boot_profile_mark(BootMilestone::FirstPixel);
+
+            if (mgr->switchLatencyPending) {
+                mgr->switchLatencyPending = false;
+                if (mgr->currentScreen != &mgr->splashScreen) boot_profile_mark(BootMilestone::Ready);
+                // Only navigation requests (showScreen/goBack) carry a request stamp.
+                const uint32_t requested = mgr->switchRequestMs;
+                if (requested) {
+                    const char* id = mgr->getScreenIdForInstance(mgr->currentScreen);
+                    Logger.logMessagef("Display", "Switch to %s: %lu ms to first frame (show %lu ms)",
+                        id ? id : "(unregistered)",
+                        (unsigned long)(millis() - requested),
+                        (unsigned long)mgr->switchShowMs);
+                    mgr->switchRequestMs = 0;
+                }
+                #if MACROPAD_PREWARM_NEIGHBORS > 0
+                mgr->prewarmPending = true;
+                #endif
+            }
         }
-        
+
+        #if MACROPAD_PREWARM_NEIGHBORS > 0
+        // Off the switch's critical path: the new screen is already on the panel.
+        // One screen per cycle keeps touch/animation latency bounded.
+        if (mgr->prewarmPending && mgr->commands.depth() == 0 &&
+            mgr->shedLevel < (uint8_t)MemPressureTier::Screens) {
+            if (mgr->prewarmNextNeighbor()) {
+                mgr->requestRender();
+            } else {
+                mgr->prewarmPending = false;
+            }
+        }
+        #endif
+
+        const uint32_t cycle_us = micros() - cycle_t0;
         mgr->unlock();
+        device_telemetry_note_latency(HealthLatency::LvglCycle, cycle_us, cycle_us > (uint32_t)LVGL_CYCLE_BUDGET_US);
         
-        // Sleep based on LVGL's suggested next timer deadline.
-        // Clamp to keep UI responsive while avoiding busy looping on static screens.
+        // Sleep until LVGL's next timer deadline or until another task asks for a
+        // render (screen switch, splash status, external LVGL changes).
+        // The cap keeps screen update() cadences (e.g. 500ms info/macro refresh)
+        // and DirectImageScreen timeouts working on otherwise static screens.
         if (delayMs < 1) delayMs = 1;
-        if (delayMs > 20) delayMs = 20;
-        vTaskDelay(pdMS_TO_TICKS(delayMs));
+        if (delayMs > LVGL_TASK_MAX_SLEEP_MS) delayMs = LVGL_TASK_MAX_SLEEP_MS;
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(delayMs));
+    }
+}
+
+bool display_manager_get_command_stats(DisplayCommandStats* out, bool reset_window) {
+    if (!out) return false;
+    portENTER_CRITICAL(&g_cmd_mux);
+    *out = g_cmd_stats;
+    if (reset_window) {
+        g_cmd_stats.depth_max_window = 0;
+        g_cmd_stats.lock_wait_max_us_window = 0;
+        g_cmd_stats.lock_wait_total_us_window = 0;
+        g_cmd_stats.lock_count_window = 0;
     }
+    portEXIT_CRITICAL(&g_cmd_mux);
+
+    out->depth = (displayManager) ? displayManager->getCommandQueueDepth() : 0;
+    return true;
+}
+
+bool display_manager_get_macro_screen_stats(MacroScreenCacheStats* out) {
+    if (!out || !displayManager) return false;
+    out->built = displayManager->getBuiltMacroScreenCount();
+    out->evictions = g_macro_evictions;
+    out->rebuilds = g_macro_rebuilds;
+    return true;
 }
 
 bool display_manager_get_perf_stats(DisplayPerfStats* out) {
@@ -402,6 +1390,11 @@ bool display_manager_get_perf_stats(DisplayPerfStats* out) {
     portENTER_CRITICAL(&g_perf_mux);
     *out = g_perf;
     portEXIT_CRITICAL(&g_perf_mux);
+
+    perf_ring_summarize(g_hist_render, &out->render);
+    perf_ring_summarize(g_hist_flush, &out->flush);
+    perf_ring_summarize(g_hist_present, &out->present);
+    perf_ring_summarize(g_hist_te, &out->te_wait);
     return true;
 }
 
@@ -439,21 +1432,7 @@ void DisplayManager::initLVGL() {
     lv_init();
     
     // Allocate LVGL draw buffer.
-    // Some QSPI panels/drivers require internal RAM for flush reliability.
-    if (LVGL_BUFFER_PREFER_INTERNAL) {
-        buf = (lv_color_t*)heap_caps_malloc(LVGL_BUFFER_SIZE * sizeof(lv_color_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-        if (!buf) {
-            Logger.logLine("Internal RAM allocation failed, trying PSRAM...");
-            buf = (lv_color_t*)heap_caps_malloc(LVGL_BUFFER_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
-        }
-    } else {
-        // Default: PSRAM first, fallback to internal.
-        buf = (lv_color_t*)heap_caps_malloc(LVGL_BUFFER_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
-        if (!buf) {
-            Logger.logLine("PSRAM allocation failed, trying internal RAM...");
-            buf = (lv_color_t*)heap_caps_malloc(LVGL_BUFFER_SIZE * sizeof(lv_color_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-        }
-    }
+    buf = alloc_lvgl_draw_buffer();
     if (!buf) {
         Logger.logLine("ERROR: Failed to allocate LVGL buffer!");
         Logger.logEnd();
@@ -466,6 +1445,18 @@ void DisplayManager::initLVGL() {
         LVGL_BUFFER_SIZE * sizeof(lv_color_t),
         LVGL_BUFFER_SIZE,
         bufInPsram ? "PSRAM" : "internal");
+
+    #if LVGL_DOUBLE_BUFFER
+    // Optional second buffer: LVGL renders into one while the driver sends the other.
+    // Falls back to single buffering if the allocation fails.
+    buf2 = alloc_lvgl_draw_buffer();
+    if (buf2) {
+        asyncFlush = true;
+        Logger.logLinef("Second buffer allocated [%s] (async flush)", esp_ptr_external_ram(buf2) ? "PSRAM" : "internal");
+    } else {
+        Logger.logLine("Second buffer allocation failed; single-buffered");
+    }
+    #endif
     
     // Initialize default theme (dark mode with custom primary color)
     lv_theme_t* theme = lv_theme_default_init(
@@ -478,8 +1469,18 @@ void DisplayManager::initLVGL() {
     lv_disp_set_theme(NULL, theme);
     Logger.logLine("Theme: Default dark mode initialized");
     
+    // Let LVGL render in the panel's byte order when the build matches it.
+    const bool panelBigEndian = (driver->pixelOrder() == DisplayDriver::PixelOrder::BigEndian);
+    flushSwapBytes = panelBigEndian && !LV_COLOR_16_SWAP;
+    if (!panelBigEndian && LV_COLOR_16_SWAP) {
+        Logger.logLine("WARNING: LV_COLOR_16_SWAP set but driver expects host-endian RGB565");
+    }
+    Logger.logLinef("Pixel order: %s (flush swap: %s)",
+        LV_COLOR_16_SWAP ? "big-endian" : "host-endian",
+        flushSwapBytes ? "yes" : "no");
+
     // Set up display buffer
-    lv_disp_draw_buf_init(&draw_buf, buf, NULL, LVGL_BUFFER_SIZE);
+    lv_disp_draw_buf_init(&draw_buf, buf, buf2, LVGL_BUFFER_SIZE);
     
     // Initialize display driver
     lv_disp_drv_init(&disp_drv);
@@ -488,11 +1489,24 @@ void DisplayManager::initLVGL() {
     disp_drv.flush_cb = DisplayManager::flushCallback;
     disp_drv.draw_buf = &draw_buf;
     disp_drv.user_data = this;  // Pass instance for callback
+
+    #if LVGL_FLUSH_TASK_ENABLED && !CONFIG_FREERTOS_UNICORE
+    const bool deferredFlush = true;
+    #else
+    const bool deferredFlush = asyncFlush;
+    #endif
+    if (deferredFlush) {
+        disp_drv.wait_cb = DisplayManager::flushWaitCallback;
+    }
     
     // Apply driver-specific LVGL configuration (rotation, full refresh, etc.)
     driver->configureLVGL(&disp_drv, DISPLAY_ROTATION);
     
     lv_disp_drv_register(&disp_drv);
+
+    #if SCREEN_CAPTURE_ENABLED
+    screen_capture_init(driver, &disp_drv);
+    #endif
     
     Logger.logLinef("Buffer: %d pixels (%d lines)", LVGL_BUFFER_SIZE, LVGL_BUFFER_SIZE / DISPLAY_WIDTH);
     Logger.logEnd();
@@ -524,15 +1538,24 @@ void DisplayManager::init() {
     showSplash();
     
     // Create LVGL rendering task
-    // Stack size increased to 8KB for ESP32-S3 and larger displays
-    // On dual-core: pin to Core 0 (Arduino loop runs on Core 1)
+    // Placement comes from LVGL_TASK_* (default: Core 0, the Arduino loop runs on Core 1).
     // On single-core: runs on Core 0 (time-sliced with Arduino loop)
+    task_placement_create(lvglTask, "LVGL", LVGL_TASK_STACK_BYTES, this, LVGL_TASK_PRIORITY, &lvglTaskHandle, LVGL_TASK_CORE);
     #if CONFIG_FREERTOS_UNICORE
-    xTaskCreate(lvglTask, "LVGL", 8192, this, 1, &lvglTaskHandle);
     Logger.logLine("Rendering task created (single-core)");
     #else
-    xTaskCreatePinnedToCore(lvglTask, "LVGL", 8192, this, 1, &lvglTaskHandle, 0);
-    Logger.logLine("Rendering task created (pinned to Core 0)");
+    Logger.logLinef("Rendering task created (Core %d, prio %d)", (int)LVGL_TASK_CORE, (int)LVGL_TASK_PRIORITY);
+
+    #if LVGL_FLUSH_TASK_ENABLED
+    // Flush task runs above the render task's priority so queued bands start
+    // transferring as soon as LVGL hands them over.
+    task_placement_create(flushTask, "LVGLFlush", LVGL_FLUSH_TASK_STACK_BYTES, this, LVGL_FLUSH_TASK_PRIORITY, &flushTaskHandle, LVGL_FLUSH_TASK_CORE);
+    if (flushTaskHandle) {
+        Logger.logLinef("Flush task created (pinned to Core %d)", (int)LVGL_FLUSH_TASK_CORE);
+    } else {
+        Logger.logLine("Flush task creation failed; flushing inline");
+    }
+    #endif
     #endif
     
     Logger.logEnd();
@@ -552,69 +1575,183 @@ void DisplayManager::showSplash() {
 
 void DisplayManager::showInfo() {
     // Defer screen switch to lvglTask (non-blocking)
-    pendingScreen = &infoScreen;
+    enqueueScreen(&infoScreen, 0);
     Logger.logMessage("Display", "Queued switch to InfoScreen");
 }
 
 void DisplayManager::showTest() {
     // Defer screen switch to lvglTask (non-blocking)
-    pendingScreen = &testScreen;
+    enqueueScreen(&testScreen, 0);
     Logger.logMessage("Display", "Queued switch to TestScreen");
 }
 
 #if HAS_IMAGE_API
 void DisplayManager::showDirectImage() {
-    // If we're already showing the DirectImageScreen, don't queue a redundant
-    // LVGL screen switch (it would also risk clobbering previousScreen).
-    if (currentScreen == &directImageScreen) {
-        directImageActive = true;
-        Logger.logMessage("Display", "Already on DirectImageScreen");
-        return;
-    }
-
-    // Save current screen so we can return to it after timeout
-    // If we're already on DirectImageScreen, don't overwrite previousScreen
-    if (currentScreen && currentScreen != &directImageScreen) {
-        previousScreen = currentScreen;
-    }
-    
-    // Defer screen switch to lvglTask (non-blocking)
     // Immediately gate LVGL flushes so the decoder can safely write even before
     // the screen switch is processed by the LVGL task.
     // Also drop any pending buffered present() to avoid flushing stale LVGL content
     // over the direct-image content.
     flushPending = false;
     directImageActive = true;
-    pendingScreen = &directImageScreen;
-    Logger.logMessage("Display", "Queued switch to DirectImageScreen");
+
+    // Screen bookkeeping (previousScreen, already-showing check) happens on the
+    // LVGL task when the command is applied.
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::ShowDirectImage;
+    if (enqueueCommand(cmd)) {
+        Logger.logMessage("Display", "Queued switch to DirectImageScreen");
+    }
+}
+
+#if IMAGE_API_RETURN_SNAPSHOT
+void DisplayManager::takeReturnSnapshot() {
+    // LVGL task, while currentScreen is still the active LVGL screen. This only
+    // renders into memory, so a decoder already writing the panel is fine.
+    returnSnapshotScreen = nullptr;
+    if (renderSuspended || shedLevel >= (uint8_t)MemPressureTier::Caches) return;
+
+    lv_obj_t* scr = lv_scr_act();
+    const lv_coord_t w = lv_obj_get_width(scr);
+    const lv_coord_t h = lv_obj_get_height(scr);
+    if (w != lv_disp_get_hor_res(nullptr) || h != lv_disp_get_ver_res(nullptr)) return;
+
+    const size_t bytes = lv_snapshot_buf_size_needed(scr, LV_IMG_CF_TRUE_COLOR);
+    if (returnSnapshot && returnSnapshotBytes != bytes) freeReturnSnapshot();
+    if (!returnSnapshot) {
+        // PSRAM only: a full frame in internal RAM would cost more than the redraw saves.
+        returnSnapshot = (lv_color_t*)heap_tag_malloc(HeapTag::Display, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!returnSnapshot) return;
+        returnSnapshotBytes = bytes;
+    }
+
+    const uint32_t t0 = micros();
+    lv_img_dsc_t dsc;
+    if (lv_snapshot_take_to_buf(scr, LV_IMG_CF_TRUE_COLOR, &dsc, returnSnapshot, (uint32_t)bytes) != LV_RES_OK) {
+        freeReturnSnapshot();
+        return;
+    }
+    returnSnapshotW = w;
+    returnSnapshotH = h;
+    returnSnapshotScreen = currentScreen;
+    LOGI("Display", "Return snapshot %dx%d in %lu us", (int)w, (int)h, (unsigned long)(micros() - t0));
 }
 
+bool DisplayManager::blitReturnSnapshot(Screen* target) {
+    const bool valid = returnSnapshot && returnSnapshotScreen == target && !renderSuspended &&
+                       returnSnapshotW == lv_disp_get_hor_res(nullptr) && returnSnapshotH == lv_disp_get_ver_res(nullptr);
+    if (!valid) {
+        freeReturnSnapshot();
+        return false;
+    }
+
+    // Bands go through the LVGL draw buffer, which the driver can always push
+    // from (DMA-capable where the driver needs it); the snapshot is in PSRAM.
+    waitFlushIdle();
+    const uint32_t t0 = micros();
+    const uint32_t w = (uint32_t)returnSnapshotW;
+    const uint32_t rows = draw_buf.size / w;
+    driver->startWrite();
+    for (uint32_t y = 0; rows > 0 && y < (uint32_t)returnSnapshotH; y += rows) {
+        const uint32_t h = ((uint32_t)returnSnapshotH - y) < rows ? ((uint32_t)returnSnapshotH - y) : rows;
+        memcpy(buf, returnSnapshot + y * w, (size_t)w * h * sizeof(lv_color_t));
+        driver->setAddrWindow(0, (int16_t)y, (uint16_t)w, (uint16_t)h);
+        driver->pushColors((uint16_t*)buf, w * h, flushSwapBytes);
+    }
+    driver->endWrite();
+    if (driver->renderMode() == DisplayDriver::RenderMode::Buffered) {
+        driver->present();
+    }
+    LOGI("Display", "Restored snapshot in %lu us", (unsigned long)(micros() - t0));
+    freeReturnSnapshot();
+    return true;
+}
+
+void DisplayManager::freeReturnSnapshot() {
+    returnSnapshotScreen = nullptr;
+    if (returnSnapshot) {
+        heap_tag_free(HeapTag::Display, returnSnapshot);
+        returnSnapshot = nullptr;
+    }
+    returnSnapshotBytes = 0;
+}
+#endif
+
 void DisplayManager::returnToPreviousScreen() {
     // Defer screen switch to lvglTask (non-blocking)
-    // If no previous screen, default to info screen
-    Screen* targetScreen = previousScreen ? previousScreen : &infoScreen;
     directImageActive = false;
-    pendingScreen = targetScreen;
-    previousScreen = nullptr;  // Clear previous screen reference
-    Logger.logMessage("Display", "Queued return to previous screen");
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::ReturnFromImage;
+    if (enqueueCommand(cmd)) {
+        Logger.logMessage("Display", "Queued return to previous screen");
+    }
 }
 #endif
 
 void DisplayManager::setSplashStatus(const char* text) {
-    // Avoid blocking boot indefinitely if the LVGL task died while holding the mutex.
-    if (isInLvglTask()) {
+    // Before the LVGL task runs (boot) or from within it, apply directly.
+    if (!lvglTaskHandle || isInLvglTask()) {
         splashScreen.setStatus(text);
         return;
     }
 
-    if (!tryLock(100)) {
-        // LVGL is busy; defer rather than dropping the update.
-        strlcpy(pendingSplashStatus, text ? text : "", sizeof(pendingSplashStatus));
-        pendingSplashStatusPending = true;
+    // Never block the caller on the LVGL mutex; the LVGL task applies it.
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::SplashStatus;
+    strlcpy(cmd.text, text ? text : "", sizeof(cmd.text));
+    (void)enqueueCommand(cmd);
+}
+
+void DisplayManager::showOtaProgress(const char* text) {
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::OtaProgress;
+    strlcpy(cmd.text, text ? text : "", sizeof(cmd.text));
+    (void)enqueueCommand(cmd);
+}
+
+void DisplayManager::endOtaProgress() {
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::OtaProgressEnd;
+    (void)enqueueCommand(cmd);
+}
+
+void DisplayManager::shedMemory(uint8_t level) {
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::MemoryPressure;
+    cmd.value = level;
+    (void)enqueueCommand(cmd);
+}
+
+void DisplayManager::reloadLabelFont() {
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::ReloadLabelFont;
+    (void)enqueueCommand(cmd);
+}
+
+#if BENCH_ENABLED
+bool DisplayManager::queueBench() {
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::RunBench;
+    return enqueueCommand(cmd);
+}
+#endif
+
+void DisplayManager::setBacklightBrightness(uint8_t brightness) {
+    if (!driver) return;
+
+    // Before the LVGL task runs (boot) or from within it, apply directly.
+    if (!lvglTaskHandle || isInLvglTask()) {
+        driver->setBacklightBrightness(brightness);
         return;
     }
-    splashScreen.setStatus(text);
-    unlock();
+
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::SetBrightness;
+    cmd.value = brightness;
+    if (!enqueueCommand(cmd)) {
+        // Brightness must not be lost under load; the backlight PWM does not
+        // share the panel bus, so a direct write is safe as a fallback.
+        driver->setBacklightBrightness(brightness);
+    }
 }
 
 bool DisplayManager::showScreen(const char* screen_id) {
@@ -624,7 +1761,13 @@ bool DisplayManager::showScreen(const char* screen_id) {
     for (size_t i = 0; i < screenCount; i++) {
         if (strcmp(availableScreens[i].id, screen_id) == 0) {
             // Defer screen switch to lvglTask (non-blocking)
-            pendingScreen = availableScreens[i].instance;
+            DisplayCommand cmd = {};
+            cmd.type = DisplayCommandType::ShowScreen;
+            cmd.screen = availableScreens[i].instance;
+            cmd.requested_ms = millis();
+            if (!enqueueCommand(cmd)) {
+                return false;
+            }
             Logger.logMessagef("Display", "Queued switch to screen: %s", screen_id);
             return true;
         }
@@ -634,6 +1777,18 @@ bool DisplayManager::showScreen(const char* screen_id) {
     return false;
 }
 
+bool DisplayManager::triggerMacro(uint8_t screen, uint8_t button) {
+    if (screen >= MACROS_SCREEN_COUNT || button >= MACROS_BUTTONS_PER_SCREEN) return false;
+
+    // The action runs on the LVGL task like a tap, so navigation and busy
+    // visuals behave the same; the macro screen need not be visible.
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::TriggerMacro;
+    cmd.screen = &macroScreens[screen];
+    cmd.value = button;
+    return enqueueCommand(cmd);
+}
+
 bool DisplayManager::goBackOrDefault() {
     // Do not treat splash or unregistered screens as valid targets.
     Screen* target = previousScreen;
@@ -654,11 +1809,52 @@ bool DisplayManager::goBackOrDefault() {
         return showScreen("macro1");
     }
 
-    pendingScreen = target;
+    DisplayCommand cmd = {};
+    cmd.type = DisplayCommandType::ShowScreen;
+    cmd.screen = target;
+    cmd.requested_ms = millis();
+    if (!enqueueCommand(cmd)) {
+        return false;
+    }
     Logger.logMessage("Display", "Queued go-back to previous screen");
     return true;
 }
 
+bool DisplayManager::handleGesture(TouchGesture gesture) {
+    #if MACROPAD_GESTURES
+    int current = -1;
+    for (int i = 0; i < MACROS_SCREEN_COUNT; i++) {
+        if (currentScreen == &macroScreens[i]) {
+            current = i;
+            break;
+        }
+    }
+    if (current < 0) return false;
+
+    const char* target = nullptr;
+    switch (gesture) {
+        case TouchGesture::SwipeLeft:
+        case TouchGesture::SwipeRight: {
+            // Content follows the finger: swiping left brings in the next screen.
+            const int next = (gesture == TouchGesture::SwipeLeft)
+                ? (current + 1) % MACROS_SCREEN_COUNT
+                : (current + MACROS_SCREEN_COUNT - 1) % MACROS_SCREEN_COUNT;
+            return showScreen(macroScreenIds[next]);
+        }
+        case TouchGesture::SwipeUp: target = MACROPAD_GESTURE_UP_SCREEN; break;
+        case TouchGesture::SwipeDown: target = MACROPAD_GESTURE_DOWN_SCREEN; break;
+        case TouchGesture::LongPress: target = MACROPAD_GESTURE_LONG_PRESS_SCREEN; break;
+        default: return false;
+    }
+    if (!target || target[0] == '\0') return false;
+    if (strcmp(target, "back") == 0) return goBackOrDefault();
+    return showScreen(target);
+    #else
+    (void)gesture;
+    return false;
+    #endif
+}
+
 const char* DisplayManager::getCurrentScreenId() {
     // Return ID of current screen (nullptr if splash or unknown)
     for (size_t i = 0; i < screenCount; i++) {
@@ -706,6 +1902,30 @@ void display_manager_set_splash_status(const char* text) {
     }
 }
 
+void display_manager_show_ota_progress(const char* text) {
+    if (displayManager) {
+        displayManager->showOtaProgress(text);
+    }
+}
+
+void display_manager_end_ota_progress() {
+    if (displayManager) {
+        displayManager->endOtaProgress();
+    }
+}
+
+void display_manager_shed_memory(uint8_t level) {
+    if (displayManager) {
+        displayManager->shedMemory(level);
+    }
+}
+
+void display_manager_reload_label_font() {
+    if (displayManager) {
+        displayManager->reloadLabelFont();
+    }
+}
+
 void display_manager_show_screen(const char* screen_id, bool* success) {
     bool result = false;
     if (displayManager) {
@@ -730,8 +1950,8 @@ const ScreenInfo* display_manager_get_available_screens(size_t* count) {
 }
 
 void display_manager_set_backlight_brightness(uint8_t brightness) {
-    if (displayManager && displayManager->getDriver()) {
-        displayManager->getDriver()->setBacklightBrightness(brightness);
+    if (displayManager) {
+        displayManager->setBacklightBrightness(brightness);
     }
 }
 
@@ -765,6 +1985,22 @@ void display_manager_unlock() {
     }
 }
 
+void display_manager_request_render() {
+    if (displayManager) {
+        displayManager->requestRender();
+    }
+}
+
+bool display_manager_handle_gesture(TouchGesture gesture) {
+    if (!displayManager) return false;
+    return displayManager->handleGesture(gesture);
+}
+
+bool display_manager_trigger_macro(uint8_t screen, uint8_t button) {
+    if (!displayManager) return false;
+    return displayManager->triggerMacro(screen, button);
+}
+
 bool display_manager_try_lock(uint32_t timeout_ms) {
     if (!displayManager) return false;
     return displayManager->tryLock(timeout_ms);
@@ -11,6 +11,8 @@
 #include "screens/macropad_screen.h"
 #include "screens/error_screen.h"
 #include "macros_config.h"
+#include "display_command_queue.h"
+#include "touch_gesture.h"
 
 #if HAS_IMAGE_API
 #include "screens/direct_image_screen.h"
@@ -60,6 +62,7 @@ private:
     DisplayDriver* driver;
     lv_disp_draw_buf_t draw_buf;
     lv_color_t* buf;  // Dynamically allocated LVGL buffer
+    lv_color_t* buf2; // Optional second buffer (LVGL_DOUBLE_BUFFER)
     lv_disp_drv_t disp_drv;
     
     // Configuration reference
@@ -72,7 +75,18 @@ private:
     // Screen management
     Screen* currentScreen;
     Screen* previousScreen;  // Track previous screen for return navigation
-    Screen* pendingScreen;   // Deferred screen switch (processed in lvglTask)
+    Screen* pendingScreen;   // Screen switch to apply this cycle (LVGL task only)
+    // Firmware update screen (LVGL task only): while shown, screen requests
+    // only change where otaReturnScreen goes back to.
+    bool otaScreenActive;
+    Screen* otaReturnScreen;
+
+    // Cross-task requests (screen switches, splash/error text, brightness, image
+    // session start/end). Producers never take lvglMutex; lvglTask drains it.
+    DisplayCommandQueue commands;
+    bool enqueueCommand(const DisplayCommand& cmd);
+    void applyCommand(const DisplayCommand& cmd);
+    void enqueueScreen(Screen* screen, uint32_t requestedMs);
 
     // Helpers: avoid taking the LVGL mutex when already inside the LVGL task
     bool isInLvglTask() const;
@@ -89,14 +103,42 @@ private:
     char errorTitle[48];
     char errorMessage[192];
 
-    // When called off the LVGL task we try a bounded mutex wait. If that fails,
-    // defer the splash status update and apply it from the LVGL task loop.
-    char pendingSplashStatus[96];
-    bool pendingSplashStatusPending;
 
-    // Fixed macro pad screens (created lazily on first show)
+    // Fixed macro pad screens (created lazily on first show, or pre-warmed
+    // around the active one with MACROPAD_PREWARM_NEIGHBORS)
     MacroPadScreen macroScreens[MACROS_SCREEN_COUNT];
 
+    // Switch latency (request -> first frame flushed), logged once per switch.
+    uint32_t switchRequestMs;
+    uint32_t switchShowMs;
+    bool switchLatencyPending;
+
+    #if MACROPAD_PREWARM_NEIGHBORS > 0
+    // Build one missing/stale neighbour per LVGL cycle after a switch settles.
+    bool prewarmPending;
+    bool prewarmNextNeighbor();
+    #endif
+
+    #if MACROPAD_MAX_BUILT_SCREENS > 0
+    // Use order of the macro screens (higher = more recent) for
+    // MACROPAD_MAX_BUILT_SCREENS. LVGL task only.
+    uint32_t macroUseTick;
+    uint32_t macroLastUse[MACROS_SCREEN_COUNT];
+    uint32_t macroEvictedMask;
+    void noteMacroScreenUse(Screen* screen);
+    #endif
+
+    // Memory pressure tier last applied (MemPressureTier; LVGL task only).
+    uint8_t shedLevel;
+    void applyShedLevel(uint8_t level);
+
+    #if BENCH_ENABLED
+    // Display part of the benchmark suite (RunBench command).
+    void runBench();
+    // Time full-screen redraws of the loaded screen (render + flush + present).
+    uint32_t benchRedraw(uint16_t frames);
+    #endif
+
     // Persistent storage for screen registry strings.
     // "macro" + up to 2 digits + NUL
     char macroScreenIds[MACROS_SCREEN_COUNT][8];
@@ -133,14 +175,75 @@ private:
     // LVGL flush callback (static, accesses instance via user_data)
     static void flushCallback(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p);
 
+    // Completion hook for DisplayDriver::pushColorsAsync() (may run in ISR context).
+    static void asyncFlushDone(void* ctx);
+
+    // Whether LVGL's buffer must be byte-swapped on flush (LVGL color format does
+    // not match DisplayDriver::pixelOrder()). Resolved once in initLVGL().
+    bool flushSwapBytes;
+
+    // True when two draw buffers are registered and the flush may return before
+    // the transfer completes (driver calls asyncFlushDone later).
+    bool asyncFlush;
+
+    // LVGL busy-waits for the previous flush before reusing a draw buffer; let other
+    // tasks run meanwhile when flushes complete asynchronously.
+    static void flushWaitCallback(lv_disp_drv_t* disp);
+
+    // Block (yielding) until LVGL has no flush in flight.
+    void waitFlushIdle();
+
+    #if LVGL_FLUSH_TASK_ENABLED && !CONFIG_FREERTOS_UNICORE
+    // Single-producer (LVGL task) / single-consumer (flush task) ring of completed
+    // draw areas. Indices only ever increase; slot = index % depth.
+    struct FlushJob {
+        lv_disp_drv_t* disp;
+        lv_area_t area;
+        lv_color_t* color_p;
+    };
+    FlushJob flushQueue[LVGL_FLUSH_QUEUE_DEPTH];
+    volatile uint32_t flushHead;
+    volatile uint32_t flushTail;
+    TaskHandle_t flushTaskHandle;
+
+    bool enqueueFlush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p);
+    static void flushTask(void* pvParameter);
+    #endif
+
     // Buffered render-mode drivers (e.g., Arduino_GFX canvas) need an explicit
     // present() step, but only after LVGL has actually rendered something.
     bool flushPending;
 
+    #if DISPLAY_TE_SYNC_ENABLED
+    // Direct drivers: TE-sync once per refresh, before its first band.
+    bool teFrameSynced;
+    void teSyncBand(lv_disp_drv_t* disp);
+    #endif
+
+    // Render suspend (screen saver asleep). requested is written by any task;
+    // the LVGL task applies it and tracks the applied state in renderSuspended.
+    volatile bool renderSuspendRequested;
+    bool renderSuspended;
+    void applyRenderSuspend(bool suspend);
+
     // When true, LVGL flushes must not touch the panel.
     // This is enabled as soon as DirectImageScreen is requested so that
     // the JPEG decoder can safely write to the display without SPI contention.
     volatile bool directImageActive;
+
+    #if HAS_IMAGE_API && IMAGE_API_RETURN_SNAPSHOT
+    // The screen a direct image covers, rendered into PSRAM when the image
+    // comes up and pushed back to the panel when it goes away, so the return
+    // does not wait for LVGL to rebuild and flush the whole screen.
+    lv_color_t* returnSnapshot;
+    Screen* returnSnapshotScreen;   // nullptr when the snapshot is not valid
+    size_t returnSnapshotBytes;
+    lv_coord_t returnSnapshotW;
+    lv_coord_t returnSnapshotH;
+    void takeReturnSnapshot();
+    bool blitReturnSnapshot(Screen* target);
+    void freeReturnSnapshot();
+    #endif
     
     // FreeRTOS task for LVGL rendering
     static void lvglTask(void* pvParameter);
@@ -182,6 +285,14 @@ public:
     // Return to previous runtime screen when available; otherwise go to default ("macro1").
     // Returns true when a navigation was queued.
     bool goBackOrDefault();
+
+    // Run a macro button's action as if it were tapped (thread-safe; 0-based
+    // indexes). Returns false when out of range or the queue is full.
+    bool triggerMacro(uint8_t screen, uint8_t button);
+
+    // Navigate for a touch gesture on a macro screen (MACROPAD_GESTURES).
+    // LVGL task only (touch read callback). Returns true when a switch was queued.
+    bool handleGesture(TouchGesture gesture);
     
     // Get current screen ID (returns nullptr if splash or no screen)
     const char* getCurrentScreenId();
@@ -191,11 +302,55 @@ public:
     
     // Splash status update (thread-safe)
     void setSplashStatus(const char* text);
+
+    // Static firmware update screen (splash without spinner) with text, and
+    // back to the interrupted screen afterwards (thread-safe).
+    void showOtaProgress(const char* text);
+    void endOtaProgress();
+
+    // Memory pressure tier changed (thread-safe): from "caches" up, drop
+    // unreferenced icon cache and 2x mask entries; from "screens" up, also
+    // destroy hidden macro pad / LVGL image screens and stop pre-warming.
+    void shedMemory(uint8_t level);
+
+    // Reload the macro label font on the LVGL task (thread-safe).
+    void reloadLabelFont();
+
+    #if BENCH_ENABLED
+    // Run the display benchmarks on the LVGL task (bench.h; thread-safe).
+    // Returns false when the queue is full.
+    bool queueBench();
+    #endif
     
     // Mutex helpers for external thread-safe access
+    // unlock() from a non-LVGL task also wakes the rendering task, since the
+    // caller most likely changed LVGL state that needs to be drawn.
     void lock();
     void unlock();
 
+    // Wake the LVGL task early (it otherwise sleeps until LVGL's next timer
+    // deadline, capped at LVGL_TASK_MAX_SLEEP_MS). Safe from any task.
+    void requestRender();
+
+    // Commands waiting for the LVGL task (approximate).
+    uint32_t getCommandQueueDepth() const { return commands.depth(); }
+
+    // Macro screens with an LVGL object tree (approximate from other tasks).
+    uint8_t getBuiltMacroScreenCount() const;
+
+    // Backlight brightness (0-100). Applied on the LVGL task when called from
+    // another task once rendering is running.
+    void setBacklightBrightness(uint8_t brightness);
+
+    // Pause/resume LVGL rendering (timers, screen update(), flushes). Resume forces
+    // one full-screen refresh. Safe from any task; applied by the LVGL task.
+    void setRenderSuspended(bool suspended);
+    bool isRenderSuspended() const { return renderSuspended; }
+
+    // Wait for the panel's tearing-effect edge (DISPLAY_TE_SYNC_ENABLED) and record
+    // the wait in perf stats. No-op when the driver has no active TE line.
+    void syncTearingEffect();
+
     // Attempt to lock the LVGL mutex with a timeout (in milliseconds).
     // Returns true if the lock was acquired.
     bool tryLock(uint32_t timeoutMs);
@@ -225,17 +380,70 @@ public:
 // Global instance (managed by app.ino)
 extern DisplayManager* displayManager;
 
+// Percentiles over the most recent rendered frames (microseconds).
+typedef struct DisplayPerfHistogram {
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} DisplayPerfHistogram;
+
 // Lightweight perf stats updated by the LVGL rendering task.
 // Safe to read from non-LVGL tasks (e.g., AsyncTCP /api/health handler).
 typedef struct DisplayPerfStats {
     uint16_t fps;
     uint32_t lv_timer_us;
     uint32_t present_us;
+    // Panel transfer time summed over the last frame, from setAddrWindow until
+    // the band is on the panel (DMA completion for async flushes).
+    uint32_t flush_us;
+    // CPU time the async flushes of the last frame took to start their
+    // transfers (LVGL_DOUBLE_BUFFER); 0 when flushes are synchronous.
+    uint32_t flush_kickoff_us;
+
+    // Distributions over the last DISPLAY_PERF_HIST_SAMPLES rendered frames.
+    DisplayPerfHistogram render;
+    DisplayPerfHistogram flush;
+    DisplayPerfHistogram present;
+
+    // Bus throughput over the last ~1s window.
+    uint32_t flush_px_per_s;
+    float flushes_per_frame;
+    // Bytes pushed / flush time (to completion, as flush_us).
+    float bus_mb_per_s;
+
+    // Time spent waiting for the panel TE edge (DISPLAY_TE_SYNC_ENABLED), per wait.
+    DisplayPerfHistogram te_wait;
+    uint32_t te_timeouts;
 } DisplayPerfStats;
 
 // Returns true if stats are available (HAS_DISPLAY).
 bool display_manager_get_perf_stats(DisplayPerfStats* out);
 
+// Cross-task command queue and LVGL mutex contention counters.
+typedef struct DisplayCommandStats {
+    uint32_t enqueued;
+    uint32_t dropped;
+    uint32_t depth;
+    // Window values cover the time since the previous reset_window read.
+    uint32_t depth_max_window;
+    uint32_t lock_wait_max_us_window;
+    uint32_t lock_wait_total_us_window;
+    uint32_t lock_count_window;
+} DisplayCommandStats;
+
+// reset_window: start a new window after reading (used by /api/health).
+bool display_manager_get_command_stats(DisplayCommandStats* out, bool reset_window);
+
+// Built macro screens and the MACROPAD_MAX_BUILT_SCREENS cap at work.
+typedef struct MacroScreenCacheStats {
+    uint8_t built;          // macro screens with an LVGL object tree now
+    uint32_t evictions;     // hidden screens destroyed to stay under the cap
+    uint32_t rebuilds;      // evicted screens built again on show or pre-warm
+} MacroScreenCacheStats;
+
+bool display_manager_get_macro_screen_stats(MacroScreenCacheStats* out);
+
 // C-style interface for app.ino
 void display_manager_init(DeviceConfig* config);
 void display_manager_show_splash();
@@ -245,6 +453,10 @@ void display_manager_show_screen(const char* screen_id, bool* success);  // succ
 const char* display_manager_get_current_screen_id();
 const ScreenInfo* display_manager_get_available_screens(size_t* count);
 void display_manager_set_splash_status(const char* text);
+void display_manager_show_ota_progress(const char* text);
+void display_manager_end_ota_progress();
+void display_manager_shed_memory(uint8_t level);  // MemPressureTier
+void display_manager_reload_label_font();  // label_font.h
 void display_manager_set_backlight_brightness(uint8_t brightness);  // 0-100%
 
 // Provide macro runtime pointers used by MacroPadScreen.
@@ -264,6 +476,14 @@ void display_manager_lock();
 void display_manager_unlock();
 bool display_manager_try_lock(uint32_t timeout_ms);
 
+// Wake the LVGL rendering task (e.g. after queuing work it should pick up).
+void display_manager_request_render();
+
+bool display_manager_handle_gesture(TouchGesture gesture);
+
+// Run a macro button's action remotely (0-based indexes; see triggerMacro()).
+bool display_manager_trigger_macro(uint8_t screen, uint8_t button);
+
 #if HAS_IMAGE_API
 // C-style interface for image API
 void display_manager_show_direct_image();
@@ -6,12 +6,14 @@
  */
 
 #include "arduino_gfx_driver.h"
+#include "ledc_backlight_fade.h"
 #include "../log_manager.h"
 
 Arduino_GFX_Driver::Arduino_GFX_Driver() 
     : bus(nullptr), gfx(nullptr), canvas(nullptr), currentBrightness(100), backlightPwmAttached(false),
       displayWidth(DISPLAY_WIDTH), displayHeight(DISPLAY_HEIGHT), displayRotation(DISPLAY_ROTATION),
-      currentX(0), currentY(0), currentW(0), currentH(0) {
+      currentX(0), currentY(0), currentW(0), currentH(0),
+      dirtyValid(false), dirtyX1(0), dirtyY1(0), dirtyX2(0), dirtyY2(0) {
 }
 
 Arduino_GFX_Driver::~Arduino_GFX_Driver() {
@@ -85,6 +87,18 @@ void Arduino_GFX_Driver::init() {
         return;
     }
     Logger.logLine("Arduino_GFX: Display initialized via canvas");
+
+    #if DISPLAY_TE_SYNC_ENABLED
+    #ifdef LCD_QSPI_TE
+    // TEON, mode 0: pulse TE during vertical blanking only.
+    bus->beginWrite();
+    bus->writeC8D8(0x35, 0x00);
+    bus->endWrite();
+    te.begin(LCD_QSPI_TE);
+    #else
+    Logger.logLine("Arduino_GFX: TE sync requested but LCD_QSPI_TE is not defined");
+    #endif
+    #endif
     
     // Clear screen
     canvas->fillScreen(BLACK);
@@ -145,6 +159,7 @@ void Arduino_GFX_Driver::setBacklightBrightness(uint8_t brightness) {
     #endif
 
     #if ESP_ARDUINO_VERSION_MAJOR >= 3
+    ledc_backlight_fade_stop(LCD_BL_PIN);
     ledcWrite(LCD_BL_PIN, duty);  // New API: write to pin directly
     #else
     ledcWrite(TFT_BACKLIGHT_PWM_CHANNEL, duty);  // Old API: write to channel
@@ -159,6 +174,33 @@ void Arduino_GFX_Driver::setBacklightBrightness(uint8_t brightness) {
     #endif
 }
 
+bool Arduino_GFX_Driver::fadeBacklight(uint8_t from, uint8_t to, uint32_t duration_ms) {
+    // ledcFade() (ledc_set_fade_with_time) needs the Core 3.x LEDC API.
+    #if defined(LCD_BL_PIN) && HAS_BACKLIGHT && LEDC_BACKLIGHT_FADE_SUPPORTED
+    if (!backlightPwmAttached) return false;
+    if (from > 100) from = 100;
+    if (to > 100) to = 100;
+
+    uint32_t fromDuty = (from * 255) / 100;
+    uint32_t toDuty = (to * 255) / 100;
+    #ifdef TFT_BACKLIGHT_ON
+    if (!TFT_BACKLIGHT_ON) {
+        fromDuty = 255 - fromDuty;
+        toDuty = 255 - toDuty;
+    }
+    #endif
+
+    if (!ledc_backlight_fade(LCD_BL_PIN, fromDuty, toDuty, duration_ms)) return false;
+    currentBrightness = to;
+    return true;
+    #else
+    (void)from;
+    (void)to;
+    (void)duration_ms;
+    return false;
+    #endif
+}
+
 uint8_t Arduino_GFX_Driver::getBacklightBrightness() {
     return currentBrightness;
 }
@@ -201,18 +243,105 @@ void Arduino_GFX_Driver::pushColors(uint16_t* data, uint32_t len, bool swap_byte
     if (canvas) {
         canvas->draw16bitRGBBitmap(currentX, currentY, data, currentW, currentH);
     }
+
+    if (currentW == 0 || currentH == 0) return;
+    const int16_t x2 = (int16_t)(currentX + currentW - 1);
+    const int16_t y2 = (int16_t)(currentY + currentH - 1);
+    if (!dirtyValid) {
+        dirtyX1 = currentX;
+        dirtyY1 = currentY;
+        dirtyX2 = x2;
+        dirtyY2 = y2;
+        dirtyValid = true;
+    } else {
+        if (currentX < dirtyX1) dirtyX1 = currentX;
+        if (currentY < dirtyY1) dirtyY1 = currentY;
+        if (x2 > dirtyX2) dirtyX2 = x2;
+        if (y2 > dirtyY2) dirtyY2 = y2;
+    }
 }
 
 DisplayDriver::RenderMode Arduino_GFX_Driver::renderMode() const {
     return RenderMode::Buffered;
 }
 
+void Arduino_GFX_Driver::setPanelSleep(bool sleep) {
+    if (!gfx) return;
+    if (sleep) {
+        gfx->displayOff();
+    } else {
+        gfx->displayOn();
+    }
+}
+
 void Arduino_GFX_Driver::present() {
     // Push canvas buffer to physical display.
     // Called by DisplayManager only when LVGL produced draw data.
-    if (canvas) {
-        canvas->flush();
+    if (!canvas) return;
+
+    #if DISPLAY_BUFFERED_DIRTY_PRESENT
+    uint16_t* fb = canvas->getFramebuffer();
+    if (!dirtyValid) {
+        return;
     }
+    dirtyValid = false;
+
+    if (fb && gfx) {
+        // The canvas framebuffer is in panel (rotation 0) orientation. Map the dirty
+        // logical rect to a physical row span and send those full-width rows; rows are
+        // contiguous in the framebuffer, so no staging copy is needed.
+        // Mapping mirrors Arduino_Canvas::writePixelPreclipped().
+        const int16_t maxY = (int16_t)(displayHeight - 1);
+        int16_t row0;
+        int16_t row1;
+        switch (displayRotation) {
+            case 1: row0 = dirtyX1; row1 = dirtyX2; break;
+            case 2: row0 = (int16_t)(maxY - dirtyY2); row1 = (int16_t)(maxY - dirtyY1); break;
+            case 3: row0 = (int16_t)(maxY - dirtyX2); row1 = (int16_t)(maxY - dirtyX1); break;
+            default: row0 = dirtyY1; row1 = dirtyY2; break;
+        }
+        if (row0 < 0) row0 = 0;
+        if (row1 > maxY) row1 = maxY;
+        if (row1 < row0) return;
+
+        const uint16_t rows = (uint16_t)(row1 - row0 + 1);
+        gfx->draw16bitRGBBitmap(0, row0, fb + (size_t)row0 * displayWidth, displayWidth, rows);
+        return;
+    }
+    #endif
+
+    dirtyValid = false;
+    canvas->flush();
+}
+
+bool Arduino_GFX_Driver::readRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* out) {
+    const uint16_t* fb = canvas ? canvas->getFramebuffer() : nullptr;
+    if (!fb || !out) return false;
+    if (x < 0 || y < 0 || x + w > width() || y + h > height()) return false;
+
+    // Logical -> panel mapping as in present() (Arduino_Canvas::writePixelPreclipped()).
+    const int16_t maxX = (int16_t)(displayWidth - 1);
+    const int16_t maxY = (int16_t)(displayHeight - 1);
+    for (uint16_t row = 0; row < h; row++) {
+        const int16_t ly = (int16_t)(y + row);
+        uint16_t* dst = out + (size_t)row * w;
+        if (displayRotation == 0) {
+            memcpy(dst, fb + (size_t)ly * displayWidth + x, (size_t)w * sizeof(uint16_t));
+            continue;
+        }
+        for (uint16_t col = 0; col < w; col++) {
+            const int16_t lx = (int16_t)(x + col);
+            int16_t px;
+            int16_t py;
+            switch (displayRotation) {
+                case 1: px = (int16_t)(maxX - ly); py = lx; break;
+                case 2: px = (int16_t)(maxX - lx); py = (int16_t)(maxY - ly); break;
+                default: px = ly; py = (int16_t)(maxY - lx); break;
+            }
+            dst[col] = fb[(size_t)py * displayWidth + px];
+        }
+    }
+    return true;
 }
 
 void Arduino_GFX_Driver::configureLVGL(lv_disp_drv_t* drv, uint8_t rotation) {
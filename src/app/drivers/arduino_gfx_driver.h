@@ -15,6 +15,10 @@
 #include "../board_config.h"
 #include <Arduino_GFX_Library.h>
 
+#if DISPLAY_TE_SYNC_ENABLED
+#include "panel_te_sync.h"
+#endif
+
 class Arduino_GFX_Driver : public DisplayDriver {
 private:
     Arduino_DataBus* bus;
@@ -29,6 +33,14 @@ private:
     // Current drawing area (set by setAddrWindow, used by pushColors)
     int16_t currentX, currentY;
     uint16_t currentW, currentH;
+
+    // Union of areas drawn since the last present() (logical/rotated coordinates).
+    bool dirtyValid;
+    int16_t dirtyX1, dirtyY1, dirtyX2, dirtyY2;
+
+    #if DISPLAY_TE_SYNC_ENABLED
+    PanelTeSync te;
+    #endif
     
 public:
     Arduino_GFX_Driver();
@@ -42,6 +54,7 @@ public:
     void setBacklightBrightness(uint8_t brightness) override;  // 0-100%
     uint8_t getBacklightBrightness() override;
     bool hasBacklightControl() override;
+    bool fadeBacklight(uint8_t from, uint8_t to, uint32_t duration_ms) override;
     void applyDisplayFixes() override;
     
     void startWrite() override;
@@ -50,7 +63,17 @@ public:
     void pushColors(uint16_t* data, uint32_t len, bool swap_bytes = true) override;
 
     RenderMode renderMode() const override;
+    // Canvas stores host-endian RGB565 and converts on flush().
+    PixelOrder pixelOrder() const override { return PixelOrder::HostEndian; }
     void present() override;  // Flush canvas buffer to physical display
+    bool readRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* out) override;
+
+    void setPanelSleep(bool sleep) override;
+
+    #if DISPLAY_TE_SYNC_ENABLED
+    bool hasTearingEffect() const override { return te.enabled(); }
+    bool waitForTearingEffect(uint32_t timeout_ms) override { return te.wait(timeout_ms); }
+    #endif
     
     // Override LVGL configuration to use software rotation
     void configureLVGL(lv_disp_drv_t* drv, uint8_t rotation) override;
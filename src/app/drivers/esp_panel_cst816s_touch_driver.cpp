@@ -3,8 +3,8 @@
 #include "../board_config.h"
 #include "../log_manager.h"
 
-ESPPanel_CST816S_TouchDriver::ESPPanel_CST816S_TouchDriver()
-    : touch(nullptr), rotation(0), calibrationEnabled(false),
+ESPPanel_CST816S_TouchDriver::ESPPanel_CST816S_TouchDriver(int int_pin)
+    : touch(nullptr), intPin(int_pin), rotation(0), calibrationEnabled(false),
       calXMin(0), calXMax(0), calYMin(0), calYMax(0) {}
 
 ESPPanel_CST816S_TouchDriver::~ESPPanel_CST816S_TouchDriver() {
@@ -21,7 +21,7 @@ void ESPPanel_CST816S_TouchDriver::init() {
     touch_bus->configI2cFreqHz(400000);
     touch_bus->begin();
 
-    touch = new ESP_PanelTouch_CST816S(touch_bus, DISPLAY_WIDTH, DISPLAY_HEIGHT, TOUCH_RST, TOUCH_INT);
+    touch = new ESP_PanelTouch_CST816S(touch_bus, DISPLAY_WIDTH, DISPLAY_HEIGHT, TOUCH_RST, intPin);
     touch->init();
     touch->begin();
 }
@@ -7,7 +7,9 @@
 
 class ESPPanel_CST816S_TouchDriver : public TouchDriver {
 public:
-    ESPPanel_CST816S_TouchDriver();
+    // int_pin: the controller's INT line for ESP_Panel, or -1 when the caller
+    // services it (TouchManager's interrupt sampling).
+    explicit ESPPanel_CST816S_TouchDriver(int int_pin);
     ~ESPPanel_CST816S_TouchDriver() override;
 
     void init() override;
@@ -20,6 +22,7 @@ public:
 
 private:
     ESP_PanelTouch* touch;
+    int intPin;
     uint8_t rotation;
 
     bool calibrationEnabled;
@@ -1,11 +1,14 @@
 #include "esp_panel_st77916_driver.h"
 
 #include "../board_config.h"
+#include "../heap_placement.h"
+#include "../heap_tags.h"
 #include "../log_manager.h"
 
 #include <esp_heap_caps.h>
 #include <esp32-hal-psram.h>
 #include <driver/ledc.h>
+#include <soc/soc_caps.h>
 
 #ifndef TFT_SPI_FREQ_HZ
 #define TFT_SPI_FREQ_HZ (50 * 1000 * 1000)
@@ -198,6 +201,9 @@ static const esp_lcd_panel_vendor_init_cmd_t lcd_init_cmd[] = {
     {0xF3, (uint8_t[]){0x01}, 1, 0},
     {0xF0, (uint8_t[]){0x00}, 1, 0},
     {0x21, (uint8_t[]){0x00}, 1, 0},
+#if DISPLAY_TE_SYNC_ENABLED && defined(TFT_TE)
+    {0x35, (uint8_t[]){0x00}, 1, 0},  // TEON, mode 0 (V-blank only)
+#endif
     {0x11, (uint8_t[]){0x00}, 1, 120},
     {0x29, (uint8_t[]){0x00}, 1, 0},
 };
@@ -205,8 +211,13 @@ static const esp_lcd_panel_vendor_init_cmd_t lcd_init_cmd[] = {
 ESPPanel_ST77916_Driver::ESPPanel_ST77916_Driver()
     : backlight(nullptr), lcd(nullptr), currentBrightness(100), backlightIsOn(false),
       currentX(0), currentY(0), currentW(0), currentH(0),
-        swapBuf(nullptr), swapBufCapacityPixels(0) {
+        swapBuf(nullptr), swapBufCapacityPixels(0), swapBufAllocFailed(false),
+        asyncIdle(nullptr), asyncPending(false), asyncDone(nullptr), asyncDoneCtx(nullptr) {
         busMutex = xSemaphoreCreateMutex();
+        asyncIdle = xSemaphoreCreateBinary();
+        if (asyncIdle) {
+            xSemaphoreGive(asyncIdle);
+        }
 }
 
 ESPPanel_ST77916_Driver::~ESPPanel_ST77916_Driver() {
@@ -214,8 +225,12 @@ ESPPanel_ST77916_Driver::~ESPPanel_ST77916_Driver() {
         vSemaphoreDelete(busMutex);
         busMutex = nullptr;
     }
+    if (asyncIdle) {
+        vSemaphoreDelete(asyncIdle);
+        asyncIdle = nullptr;
+    }
     if (swapBuf) {
-        heap_caps_free(swapBuf);
+        heap_tag_free(HeapTag::Display, swapBuf);
         swapBuf = nullptr;
     }
     if (lcd) {
@@ -269,56 +284,48 @@ void ESPPanel_ST77916_Driver::init() {
     lcd->reset();
     lcd->begin();
 
-    // Allocate a reusable swap buffer for optional byte swapping.
-    // Size it to the LVGL draw buffer so we can swap+flush in one drawBitmap call.
-    swapBufCapacityPixels = (uint32_t)LVGL_BUFFER_SIZE;
+    // Used by pushColorsAsync() to signal LVGL once the QSPI DMA transfer is done.
+    lcd->attachDrawBitmapFinishCallback(onDrawBitmapFinish, this);
+
+    #if DISPLAY_TE_SYNC_ENABLED
+    #ifdef TFT_TE
+    te.begin(TFT_TE);
+    #else
+    Logger.logLine("ESP_Panel: TE sync requested but TFT_TE is not defined");
+    #endif
+    #endif
+
+    // The byte-swap buffer is allocated lazily on the first pushColors(swap_bytes=true).
+    // With LV_COLOR_16_SWAP builds LVGL and the strip decoder already produce
+    // big-endian pixels, so it is never needed.
+    swapBufCapacityPixels = 0;
     swapBuf = nullptr;
 
-    if (!ESP_PANEL_SWAPBUF_PREFER_INTERNAL) {
-#if SOC_SPIRAM_SUPPORTED
-        if (psramFound()) {
-            // Prefer PSRAM first when configured. Note: some panel/bus implementations may
-            // be more reliable with internal/DMA-capable buffers, so we keep fallbacks.
-            swapBuf = (uint16_t*)heap_caps_malloc(sizeof(uint16_t) * swapBufCapacityPixels, MALLOC_CAP_SPIRAM);
-        }
-#endif
-    }
+    Logger.logLine("ESP_Panel: Display initialized");
+}
 
-    if (!swapBuf) {
-        // Prefer internal DMA-capable memory for reliability on QSPI flush.
-        // Some panel/bus implementations can stall when given PSRAM-backed buffers.
-#if defined(MALLOC_CAP_DMA)
-        swapBuf = (uint16_t*)heap_caps_malloc(sizeof(uint16_t) * swapBufCapacityPixels,
-                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
-#else
-        swapBuf = (uint16_t*)heap_caps_malloc(sizeof(uint16_t) * swapBufCapacityPixels,
-                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-#endif
-    }
+bool ESPPanel_ST77916_Driver::ensureSwapBuf() {
+    // Reusable swap buffer for optional byte swapping.
+    if (swapBuf) return true;
+    if (swapBufAllocFailed) return false;
 
-    if (!swapBuf) {
-        // Fallback: internal RAM without DMA capability (still often works, depends on underlying driver).
-        swapBuf = (uint16_t*)heap_caps_malloc(sizeof(uint16_t) * swapBufCapacityPixels,
-                                             MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-    }
+    // Size it to the LVGL draw buffer so we can swap+flush in one drawBitmap call.
+    swapBufCapacityPixels = (uint32_t)LVGL_BUFFER_SIZE;
 
-    if (!swapBuf && ESP_PANEL_SWAPBUF_PREFER_INTERNAL) {
-#if SOC_SPIRAM_SUPPORTED
-        if (psramFound()) {
-            // Last resort when we preferred internal.
-            swapBuf = (uint16_t*)heap_caps_malloc(sizeof(uint16_t) * swapBufCapacityPixels, MALLOC_CAP_SPIRAM);
-        }
-#endif
-    }
+    // The swap buffer is the source of the QSPI flush DMA; PSRAM-backed
+    // buffers can stall some panel/bus implementations.
+    const HeapClass cls = ESP_PANEL_SWAPBUF_PREFER_INTERNAL ? HeapClass::Dma : HeapClass::Bulk;
+    swapBuf = (uint16_t*)heap_place_malloc(cls, HeapTag::Display, sizeof(uint16_t) * swapBufCapacityPixels);
 
     if (swapBuf) {
         const size_t bytes = sizeof(uint16_t) * (size_t)swapBufCapacityPixels;
         Logger.logLinef("ESP_Panel: swapBuf %u bytes [%s]", (unsigned)bytes, esp_ptr_external_ram(swapBuf) ? "PSRAM" : "internal");
     } else {
         Logger.logLine("ESP_Panel: swapBuf allocation FAILED");
+        swapBufCapacityPixels = 0;
+        swapBufAllocFailed = true;
     }
-
-    Logger.logLine("ESP_Panel: Display initialized");
+    return swapBuf != nullptr;
 }
 
 void ESPPanel_ST77916_Driver::setRotation(uint8_t rotation) {
@@ -327,8 +334,21 @@ void ESPPanel_ST77916_Driver::setRotation(uint8_t rotation) {
     (void)rotation;
 }
 
+// The backlight runs on LEDC_LOW_SPEED_MODE / LEDC_CHANNEL_0 with a 13-bit timer (see init()).
+// A running hardware fade holds the channel, so stop it before any other write.
+static bool g_backlight_fade_installed = false;
+
+static void stop_backlight_fade() {
+    #if SOC_LEDC_SUPPORT_FADE_STOP
+    if (g_backlight_fade_installed) {
+        ledc_fade_stop(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+    }
+    #endif
+}
+
 void ESPPanel_ST77916_Driver::setBacklight(bool on) {
     if (!backlight) return;
+    stop_backlight_fade();
 
     if (!on) {
         backlight->off();
@@ -342,6 +362,7 @@ void ESPPanel_ST77916_Driver::setBacklight(bool on) {
 
 void ESPPanel_ST77916_Driver::setBacklightBrightness(uint8_t brightness) {
     if (!backlight) return;
+    stop_backlight_fade();
 
     currentBrightness = clamp_percent(brightness);
     if (currentBrightness == 0) {
@@ -354,6 +375,35 @@ void ESPPanel_ST77916_Driver::setBacklightBrightness(uint8_t brightness) {
     backlightIsOn = true;
 }
 
+bool ESPPanel_ST77916_Driver::fadeBacklight(uint8_t from, uint8_t to, uint32_t duration_ms) {
+    #if SOC_LEDC_SUPPORT_FADE_STOP
+    if (!backlight) return false;
+    if (!g_backlight_fade_installed) {
+        if (ledc_fade_func_install(0) != ESP_OK) return false;
+        g_backlight_fade_installed = true;
+    }
+    stop_backlight_fade();
+
+    constexpr uint32_t kMaxDuty = (1u << LEDC_TIMER_13_BIT) - 1;
+    const uint32_t fromDuty = clamp_percent(from) * kMaxDuty / 100;
+    const uint32_t toDuty = clamp_percent(to) * kMaxDuty / 100;
+
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, fromDuty);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+    if (ledc_set_fade_with_time(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, toDuty, (int)duration_ms) != ESP_OK) return false;
+    if (ledc_fade_start(LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, LEDC_FADE_NO_WAIT) != ESP_OK) return false;
+
+    currentBrightness = clamp_percent(to);
+    backlightIsOn = currentBrightness > 0;
+    return true;
+    #else
+    (void)from;
+    (void)to;
+    (void)duration_ms;
+    return false;
+    #endif
+}
+
 uint8_t ESPPanel_ST77916_Driver::getBacklightBrightness() {
     return currentBrightness;
 }
@@ -370,6 +420,21 @@ void ESPPanel_ST77916_Driver::applyDisplayFixes() {
     }
 }
 
+void ESPPanel_ST77916_Driver::setPanelSleep(bool sleep) {
+    if (!lcd) return;
+
+    // Same bus ownership as a blocking write: no DMA may be in flight.
+    startWrite();
+    const bool idleTaken = asyncIdle && xSemaphoreTake(asyncIdle, pdMS_TO_TICKS(500)) == pdTRUE;
+    if (sleep) {
+        lcd->displayOff();
+    } else {
+        lcd->displayOn();
+    }
+    if (idleTaken) xSemaphoreGive(asyncIdle);
+    endWrite();
+}
+
 void ESPPanel_ST77916_Driver::startWrite() {
     if (busMutex) {
         xSemaphoreTake(busMutex, portMAX_DELAY);
@@ -398,19 +463,83 @@ void ESPPanel_ST77916_Driver::pushColors(uint16_t* data, uint32_t len, bool swap
         return;
     }
 
+    // Wait for any in-flight async flush before reusing swapBuf / the panel IO.
+    const bool idleTaken = asyncIdle && xSemaphoreTake(asyncIdle, pdMS_TO_TICKS(500)) == pdTRUE;
+
     // The ESP_Panel API expects a byte pointer.
     // If swap_bytes is requested, swap into a contiguous buffer and flush once.
-    if (!swap_bytes || !swapBuf || swapBufCapacityPixels < pixelCount) {
+    if (!swap_bytes || !ensureSwapBuf() || swapBufCapacityPixels < pixelCount) {
         // For non-RGB panels, drawBitmap() is DMA-based and may return before the transfer completes.
         // LVGL's flush callback must not signal "flush ready" until the panel IO is done.
         (void)lcd->drawBitmapWaitUntilFinish(currentX, currentY, currentW, currentH, (const uint8_t*)data, 500);
-        return;
+    } else {
+        for (uint32_t i = 0; i < pixelCount; i++) {
+            uint16_t v = data[i];
+            swapBuf[i] = (uint16_t)((v << 8) | (v >> 8));
+        }
+        // See note above: wait until DMA transfer completes before returning to LVGL.
+        (void)lcd->drawBitmapWaitUntilFinish(currentX, currentY, currentW, currentH, (const uint8_t*)swapBuf, 500);
+    }
+
+    if (idleTaken) {
+        xSemaphoreGive(asyncIdle);
     }
+}
+
+bool ESPPanel_ST77916_Driver::pushColorsAsync(uint16_t* data, uint32_t len, bool swap_bytes, void (*onDone)(void* ctx), void* ctx) {
+    if (!lcd || !data || !asyncIdle || currentW == 0 || currentH == 0) return false;
+
+    const uint32_t pixelCount = (uint32_t)currentW * (uint32_t)currentH;
+    if (len < pixelCount) return false;
+
+    // LVGL never issues a new flush before the previous one reported ready, so this
+    // normally succeeds immediately. A timeout means the last transfer never finished;
+    // let the caller fall back to the blocking path.
+    if (xSemaphoreTake(asyncIdle, pdMS_TO_TICKS(500)) != pdTRUE) {
+        return false;
+    }
+
+    const uint8_t* src = (const uint8_t*)data;
+    if (swap_bytes && ensureSwapBuf() && swapBufCapacityPixels >= pixelCount) {
+        for (uint32_t i = 0; i < pixelCount; i++) {
+            uint16_t v = data[i];
+            swapBuf[i] = (uint16_t)((v << 8) | (v >> 8));
+        }
+        src = (const uint8_t*)swapBuf;
+    }
+
+    asyncDone = onDone;
+    asyncDoneCtx = ctx;
+    asyncPending = true;
+
+    if (!lcd->drawBitmap(currentX, currentY, currentW, currentH, src)) {
+        asyncPending = false;
+        asyncDone = nullptr;
+        asyncDoneCtx = nullptr;
+        xSemaphoreGive(asyncIdle);
+        return false;
+    }
+
+    return true;
+}
+
+bool ESPPanel_ST77916_Driver::onDrawBitmapFinish(void* user_data) {
+    ESPPanel_ST77916_Driver* self = (ESPPanel_ST77916_Driver*)user_data;
+
+    // Blocking draws also trigger this callback; only act on async transfers.
+    if (!self || !self->asyncPending) return false;
+
+    void (*done)(void*) = self->asyncDone;
+    void* ctx = self->asyncDoneCtx;
+    self->asyncPending = false;
+    self->asyncDone = nullptr;
+    self->asyncDoneCtx = nullptr;
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(self->asyncIdle, &woken);
 
-    for (uint32_t i = 0; i < pixelCount; i++) {
-        uint16_t v = data[i];
-        swapBuf[i] = (uint16_t)((v << 8) | (v >> 8));
+    if (done) {
+        done(ctx);
     }
-    // See note above: wait until DMA transfer completes before returning to LVGL.
-    (void)lcd->drawBitmapWaitUntilFinish(currentX, currentY, currentW, currentH, (const uint8_t*)swapBuf, 500);
+    return woken == pdTRUE;
 }
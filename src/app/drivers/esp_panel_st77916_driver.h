@@ -9,6 +9,10 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
+#if DISPLAY_TE_SYNC_ENABLED
+#include "panel_te_sync.h"
+#endif
+
 class ESPPanel_ST77916_Driver : public DisplayDriver {
 public:
     ESPPanel_ST77916_Driver();
@@ -24,6 +28,7 @@ public:
     void setBacklightBrightness(uint8_t brightness) override;
     uint8_t getBacklightBrightness() override;
     bool hasBacklightControl() override;
+    bool fadeBacklight(uint8_t from, uint8_t to, uint32_t duration_ms) override;
 
     void applyDisplayFixes() override;
 
@@ -31,8 +36,19 @@ public:
     void endWrite() override;
     void setAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) override;
     void pushColors(uint16_t* data, uint32_t len, bool swap_bytes = true) override;
+    bool pushColorsAsync(uint16_t* data, uint32_t len, bool swap_bytes, void (*onDone)(void* ctx), void* ctx) override;
+
+    void setPanelSleep(bool sleep) override;
+
+    #if DISPLAY_TE_SYNC_ENABLED
+    bool hasTearingEffect() const override { return te.enabled(); }
+    bool waitForTearingEffect(uint32_t timeout_ms) override { return te.wait(timeout_ms); }
+    #endif
 
 private:
+    // Panel IO "transfer done" callback (ISR context).
+    static bool onDrawBitmapFinish(void* user_data);
+
     ESP_PanelBacklight* backlight;
     ESP_PanelLcd* lcd;
 
@@ -48,6 +64,20 @@ private:
 
     uint16_t* swapBuf;
     uint32_t swapBufCapacityPixels;
+    bool swapBufAllocFailed;
+    bool ensureSwapBuf();
+
+    // Async flush state. asyncIdle is a binary semaphore that is "given" while no
+    // async transfer is in flight; blocking writes take it too so they never reuse
+    // swapBuf (or interleave on the bus) while DMA is still reading it.
+    SemaphoreHandle_t asyncIdle;
+    volatile bool asyncPending;
+    void (*asyncDone)(void* ctx);
+    void* asyncDoneCtx;
+
+    #if DISPLAY_TE_SYNC_ENABLED
+    PanelTeSync te;
+    #endif
 };
 
 #endif // ESP_PANEL_ST77916_DRIVER_H
@@ -0,0 +1,59 @@
+/*
+ * LEDC Backlight Fade
+ *
+ * Small helper shared by drivers that drive the backlight through an
+ * Arduino-attached LEDC pin (Core 3.x API).
+ *
+ * A hardware fade holds its LEDC channel until the fade ends: starting another
+ * fade, or a plain ledcWrite(), blocks the caller for the rest of it. Drivers
+ * therefore only offer hardware fades on chips that can stop a fade early
+ * (SOC_LEDC_SUPPORT_FADE_STOP) and stop any running fade before writing.
+ */
+
+#ifndef LEDC_BACKLIGHT_FADE_H
+#define LEDC_BACKLIGHT_FADE_H
+
+#include <Arduino.h>
+#include <soc/soc_caps.h>
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3 && SOC_LEDC_SUPPORT_FADE_STOP
+#define LEDC_BACKLIGHT_FADE_SUPPORTED 1
+#include <driver/ledc.h>
+#include <esp32-hal-periman.h>
+#else
+#define LEDC_BACKLIGHT_FADE_SUPPORTED 0
+#endif
+
+#if LEDC_BACKLIGHT_FADE_SUPPORTED
+// ledc_fade_stop() logs an error until the fade service is installed by the first fade.
+static bool g_ledc_backlight_fade_used = false;
+#endif
+
+// Stop a fade still running on the pin's channel (no-op otherwise).
+static inline void ledc_backlight_fade_stop(uint8_t pin) {
+#if LEDC_BACKLIGHT_FADE_SUPPORTED
+    if (!g_ledc_backlight_fade_used) return;
+    ledc_channel_handle_t* bus = (ledc_channel_handle_t*)perimanGetPinBus(pin, ESP32_BUS_TYPE_LEDC);
+    if (!bus) return;
+    ledc_fade_stop((ledc_mode_t)(bus->channel / SOC_LEDC_CHANNEL_NUM), (ledc_channel_t)(bus->channel % SOC_LEDC_CHANNEL_NUM));
+#else
+    (void)pin;
+#endif
+}
+
+// Fade the pin's duty from from_duty to to_duty over duration_ms without blocking.
+static inline bool ledc_backlight_fade(uint8_t pin, uint32_t from_duty, uint32_t to_duty, uint32_t duration_ms) {
+#if LEDC_BACKLIGHT_FADE_SUPPORTED
+    ledc_backlight_fade_stop(pin);
+    g_ledc_backlight_fade_used = true;
+    return ledcFade(pin, from_duty, to_duty, (int)duration_ms);
+#else
+    (void)pin;
+    (void)from_duty;
+    (void)to_duty;
+    (void)duration_ms;
+    return false;
+#endif
+}
+
+#endif // LEDC_BACKLIGHT_FADE_H
@@ -0,0 +1,71 @@
+/*
+ * Panel Tearing-Effect (TE) Sync Implementation
+ */
+
+#include "panel_te_sync.h"
+#include "../log_manager.h"
+
+// Give up on a TE line that never toggles rather than stalling every frame.
+static constexpr uint8_t kMaxConsecutiveTimeouts = 8;
+
+PanelTeSync::PanelTeSync()
+    : edge(nullptr), pin(-1), active(false), consecutiveTimeouts(0) {
+}
+
+PanelTeSync::~PanelTeSync() {
+    if (pin >= 0) {
+        detachInterrupt(pin);
+    }
+    if (edge) {
+        vSemaphoreDelete(edge);
+        edge = nullptr;
+    }
+}
+
+bool PanelTeSync::begin(int te_pin) {
+    if (te_pin < 0) return false;
+
+    edge = xSemaphoreCreateBinary();
+    if (!edge) {
+        Logger.logLine("TE: ERROR - semaphore alloc failed");
+        return false;
+    }
+
+    pin = te_pin;
+    pinMode(pin, INPUT);
+    attachInterruptArg(pin, onEdge, this, RISING);
+    active = true;
+    consecutiveTimeouts = 0;
+
+    Logger.logLinef("TE: Sync enabled on GPIO%d", pin);
+    return true;
+}
+
+void IRAM_ATTR PanelTeSync::onEdge(void* arg) {
+    PanelTeSync* self = (PanelTeSync*)arg;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(self->edge, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+bool PanelTeSync::wait(uint32_t timeout_ms) {
+    if (!active) return false;
+
+    // Drop an edge latched earlier: blanking may already be over, so only a
+    // fresh edge guarantees the write starts ahead of the scan.
+    (void)xSemaphoreTake(edge, 0);
+
+    if (xSemaphoreTake(edge, pdMS_TO_TICKS(timeout_ms)) == pdTRUE) {
+        consecutiveTimeouts = 0;
+        return true;
+    }
+
+    if (++consecutiveTimeouts >= kMaxConsecutiveTimeouts) {
+        active = false;
+        detachInterrupt(pin);
+        Logger.logMessagef("TE", "No TE edges on GPIO%d after %u waits; sync disabled", pin, (unsigned)kMaxConsecutiveTimeouts);
+    }
+    return false;
+}
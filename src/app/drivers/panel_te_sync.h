@@ -0,0 +1,43 @@
+/*
+ * Panel Tearing-Effect (TE) Sync
+ *
+ * Small helper shared by display drivers whose panel exposes a TE output.
+ * The panel raises TE at the start of vertical blanking; starting a write on
+ * that edge keeps it ahead of the scanout and avoids visible tearing.
+ *
+ * The edge is latched by a GPIO interrupt into a binary semaphore, so waiting
+ * costs no CPU. If the line never toggles (unwired pin, TE not enabled in the
+ * panel), the helper disables itself after a few consecutive timeouts.
+ */
+
+#ifndef PANEL_TE_SYNC_H
+#define PANEL_TE_SYNC_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+class PanelTeSync {
+public:
+    PanelTeSync();
+    ~PanelTeSync();
+
+    // Attach the TE interrupt. Returns false (and stays disabled) for pin < 0.
+    bool begin(int pin);
+
+    bool enabled() const { return active; }
+
+    // Block until the next TE rising edge, or timeout_ms.
+    // Returns true if the edge was seen.
+    bool wait(uint32_t timeout_ms);
+
+private:
+    static void IRAM_ATTR onEdge(void* arg);
+
+    SemaphoreHandle_t edge;
+    int pin;
+    bool active;
+    uint8_t consecutiveTimeouts;
+};
+
+#endif // PANEL_TE_SYNC_H
@@ -1,19 +1,77 @@
 #include "st7789v2_driver.h"
 #include "../log_manager.h"
 
-ST7789V2_Driver::ST7789V2_Driver() : spi(&SPI), currentBrightness(100) {
-    // Initialize SPI pointer to default hardware SPI
+#include <driver/gpio.h>
+#include <string.h>
+
+// 60 MHz requested (within ST7789 spec); spi_master picks the nearest APB divider.
+static constexpr int kSpiClockHz = 60000000;
+
+// spi_transaction_t::user flags read by the pre/post transfer callbacks.
+static constexpr uintptr_t kUserDc = 1u << 0;    // D/C high (data)
+static constexpr uintptr_t kUserLast = 1u << 1;  // last transaction of an async band
+
+// The post-transfer callback only gets the transaction; there is one panel.
+static ST7789V2_Driver* s_st7789v2 = nullptr;
+
+ST7789V2_Driver::ST7789V2_Driver()
+    : spi(nullptr), currentBrightness(100), maxTransferBytes(0), inFlight(0),
+      asyncDone(nullptr), asyncDoneCtx(nullptr) {
+    memset(trans, 0, sizeof(trans));
+}
+
+void IRAM_ATTR ST7789V2_Driver::onPreTransfer(spi_transaction_t* t) {
+    gpio_set_level((gpio_num_t)LCD_DC_PIN, ((uintptr_t)t->user & kUserDc) ? 1 : 0);
+}
+
+void IRAM_ATTR ST7789V2_Driver::onPostTransfer(spi_transaction_t* t) {
+    if (!((uintptr_t)t->user & kUserLast)) return;
+    ST7789V2_Driver* self = s_st7789v2;
+    if (!self) return;
+
+    void (*done)(void*) = self->asyncDone;
+    void* ctx = self->asyncDoneCtx;
+    self->asyncDone = nullptr;
+    self->asyncDoneCtx = nullptr;
+    if (done) {
+        done(ctx);
+    }
+}
+
+void ST7789V2_Driver::writeBytes(bool dc, const uint8_t* data, uint32_t len) {
+    if (!spi || len == 0) return;
+    spi_transaction_t t;
+    memset(&t, 0, sizeof(t));
+    t.length = len * 8;
+    t.user = (void*)(dc ? kUserDc : 0);
+    if (len <= sizeof(t.tx_data)) {
+        t.flags = SPI_TRANS_USE_TXDATA;
+        memcpy(t.tx_data, data, len);
+    } else {
+        t.tx_buffer = data;
+    }
+    (void)spi_device_polling_transmit(spi, &t);
 }
 
 void ST7789V2_Driver::writeCommand(uint8_t cmd) {
-    digitalWrite(LCD_DC_PIN, LOW);
-    spi->transfer(cmd);
-    digitalWrite(LCD_DC_PIN, HIGH);  // Return to data mode
+    writeBytes(false, &cmd, 1);
 }
 
 void ST7789V2_Driver::writeData(uint8_t data) {
-    digitalWrite(LCD_DC_PIN, HIGH);
-    spi->transfer(data);
+    writeBytes(true, &data, 1);
+}
+
+void ST7789V2_Driver::waitIdle() {
+    while (inFlight > 0) {
+        spi_transaction_t* done = nullptr;
+        if (spi_device_get_trans_result(spi, &done, pdMS_TO_TICKS(500)) != ESP_OK) {
+            // Bounded like DisplayManager::waitFlushIdle(): do not wedge the caller.
+            Logger.logLine("ST7789V2: WARNING: queued transfer did not complete");
+            inFlight = 0;
+            break;
+        }
+        inFlight--;
+    }
 }
 
 void ST7789V2_Driver::setWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
@@ -21,60 +79,74 @@ void ST7789V2_Driver::setWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t
     const uint16_t y_offset = 20;
     const uint16_t x_offset = 0;
 
-    writeCommand(ST7789_CASET);
-    writeData((x0 + x_offset) >> 8);
-    writeData((x0 + x_offset) & 0xFF);
-    writeData((x1 + x_offset) >> 8);
-    writeData((x1 + x_offset) & 0xFF);
+    waitIdle();
 
-    writeCommand(ST7789_RASET);
-    writeData((y0 + y_offset) >> 8);
-    writeData((y0 + y_offset) & 0xFF);
-    writeData((y1 + y_offset) >> 8);
-    writeData((y1 + y_offset) & 0xFF);
+    const uint8_t cols[4] = {
+        (uint8_t)((x0 + x_offset) >> 8), (uint8_t)((x0 + x_offset) & 0xFF),
+        (uint8_t)((x1 + x_offset) >> 8), (uint8_t)((x1 + x_offset) & 0xFF),
+    };
+    const uint8_t rows[4] = {
+        (uint8_t)((y0 + y_offset) >> 8), (uint8_t)((y0 + y_offset) & 0xFF),
+        (uint8_t)((y1 + y_offset) >> 8), (uint8_t)((y1 + y_offset) & 0xFF),
+    };
 
+    writeCommand(ST7789_CASET);
+    writeBytes(true, cols, sizeof(cols));
+    writeCommand(ST7789_RASET);
+    writeBytes(true, rows, sizeof(rows));
     writeCommand(ST7789_RAMWR);
 }
 
-void ST7789V2_Driver::rgb565ToBgr565(uint16_t* pixels, uint32_t count) {
-    // LVGL blends colors in RGB space, but ST7789V2 display expects BGR
-    // Swapping here fixes color artifacts on anti-aliased text edges
-    for (uint32_t i = 0; i < count; i++) {
-        uint16_t color = pixels[i];
-        // Extract RGB components from RGB565
-        uint16_t r = (color >> 11) & 0x1F;  // 5 bits red
-        uint16_t g = (color >> 5) & 0x3F;   // 6 bits green
-        uint16_t b = color & 0x1F;          // 5 bits blue
-        // Recombine as BGR565
-        pixels[i] = (b << 11) | (g << 5) | r;
-    }
-}
-
 void ST7789V2_Driver::init() {
     Logger.logLine("ST7789V2: Initializing native driver");
-    
-    // Configure GPIO pins
-    pinMode(LCD_CS_PIN, OUTPUT);
+
+    // Configure GPIO pins (CS belongs to the SPI peripheral)
     pinMode(LCD_DC_PIN, OUTPUT);
     pinMode(LCD_RST_PIN, OUTPUT);
     pinMode(LCD_BL_PIN, OUTPUT);
 
-    digitalWrite(LCD_CS_PIN, HIGH);
     digitalWrite(LCD_DC_PIN, HIGH);
 
     // Start backlight off until init completes
     analogWrite(LCD_BL_PIN, 0);
 
+    // One LVGL draw buffer per transaction; bigger writes (image strips) are split.
+    maxTransferBytes = (uint32_t)LVGL_BUFFER_SIZE * 2u;
+
+    spi_bus_config_t bus;
+    memset(&bus, 0, sizeof(bus));
+    bus.mosi_io_num = LCD_MOSI_PIN;
+    bus.miso_io_num = -1;
+    bus.sclk_io_num = LCD_SCK_PIN;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = (int)maxTransferBytes;
+    if (spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO) != ESP_OK) {
+        Logger.logLine("ST7789V2: ERROR: SPI bus init failed");
+        return;
+    }
+
     // SPI (Mode 3, MSB first) per Waveshare sample
-    spi->begin(LCD_SCK_PIN, -1, LCD_MOSI_PIN, LCD_CS_PIN);
-    spi->setDataMode(SPI_MODE3);
-    spi->setBitOrder(MSBFIRST);
-    spi->setFrequency(60000000); // 60MHz - within ST7789 spec
-    
-    Logger.logLine("ST7789V2: SPI initialized at 60MHz");
+    spi_device_interface_config_t dev;
+    memset(&dev, 0, sizeof(dev));
+    dev.mode = 3;
+    dev.clock_speed_hz = kSpiClockHz;
+    dev.spics_io_num = LCD_CS_PIN;
+    dev.queue_size = (int)kQueueDepth;
+    dev.pre_cb = onPreTransfer;
+    dev.post_cb = onPostTransfer;
+    if (spi_bus_add_device(SPI2_HOST, &dev, &spi) != ESP_OK) {
+        Logger.logLine("ST7789V2: ERROR: SPI device add failed");
+        spi = nullptr;
+        return;
+    }
+    s_st7789v2 = this;
+
+    int actual_khz = 0;
+    (void)spi_device_get_actual_freq(spi, &actual_khz);
+    Logger.logLinef("ST7789V2: SPI DMA initialized at %d kHz", actual_khz);
 
     // Hardware reset (matches sample timing)
-    digitalWrite(LCD_CS_PIN, LOW);
     delay(20);
     digitalWrite(LCD_RST_PIN, LOW);
     delay(20);
@@ -170,9 +242,6 @@ void ST7789V2_Driver::init() {
     writeCommand(0x29);  // Display on
     delay(20);
     
-    // End init sequence transaction
-    digitalWrite(LCD_CS_PIN, HIGH);
-
     Logger.logLine("ST7789V2: Display initialized");
     
     // Backlight on at saved brightness
@@ -218,13 +287,11 @@ void ST7789V2_Driver::applyDisplayFixes() {
 }
 
 void ST7789V2_Driver::startWrite() {
-    // Begin SPI transaction
-    digitalWrite(LCD_CS_PIN, LOW);
+    // CS is asserted per transaction by the SPI peripheral.
 }
 
 void ST7789V2_Driver::endWrite() {
-    // End SPI transaction
-    digitalWrite(LCD_CS_PIN, HIGH);
+    // Queued pixel transfers keep running; the next window waits for them.
 }
 
 void ST7789V2_Driver::setAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) {
@@ -232,23 +299,14 @@ void ST7789V2_Driver::setAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h
 }
 
 void ST7789V2_Driver::pushColors(uint16_t* data, uint32_t len, bool swap_bytes) {
-    // NOTE: Removed RGB→BGR swap - this panel appears to be in RGB mode
-    // (despite 0x36=0x00 configuration which should be BGR mode)
-    // If colors appear correct without swap, the panel ignores the BGR bit
-    // or has different register mapping than standard ST7789V2
-    
-    // Push pixel data
-    digitalWrite(LCD_DC_PIN, HIGH);
-    // CS already managed by startWrite/endWrite
-
-    if (!data || len == 0) {
+    if (!spi || !data || len == 0) {
         return;
     }
+    waitIdle();
 
-    // LVGL typically provides RGB565 in CPU-endian order.
-    // The panel expects MSB-first bytes on the wire.
-    // To enable fast bulk SPI transfers, optionally swap bytes in-place,
-    // perform a single write, then swap back.
+    // The panel expects MSB-first bytes on the wire. LVGL_COLOR_16_SWAP builds
+    // already render that way (swap_bytes=false); otherwise swap in place for
+    // the transfer and restore the caller's buffer afterwards.
     if (swap_bytes) {
         uint8_t* b = (uint8_t*)data;
         for (uint32_t i = 0; i < len; i++) {
@@ -258,9 +316,14 @@ void ST7789V2_Driver::pushColors(uint16_t* data, uint32_t len, bool swap_bytes)
         }
     }
 
-    // Bulk transfer is dramatically faster than per-byte spi->transfer() loops.
-    // SPIClass::writeBytes is provided by the ESP32 Arduino core.
-    spi->writeBytes((const uint8_t*)data, len * 2);
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t left = len * 2;
+    while (left > 0) {
+        const uint32_t n = left < maxTransferBytes ? left : maxTransferBytes;
+        writeBytes(true, p, n);
+        p += n;
+        left -= n;
+    }
 
     if (swap_bytes) {
         uint8_t* b = (uint8_t*)data;
@@ -272,6 +335,52 @@ void ST7789V2_Driver::pushColors(uint16_t* data, uint32_t len, bool swap_bytes)
     }
 }
 
+bool ST7789V2_Driver::pushColorsAsync(uint16_t* data, uint32_t len, bool swap_bytes, void (*onDone)(void* ctx), void* ctx) {
+    // Zero-copy only: a band that needs swapping takes the blocking path.
+    if (!spi || !data || len == 0 || swap_bytes) return false;
+
+    const uint32_t bytes = len * 2;
+    const uint32_t chunks = (bytes + maxTransferBytes - 1) / maxTransferBytes;
+    if (chunks > kQueueDepth) return false;
+
+    // LVGL waits for the previous band's completion before flushing the next,
+    // so this only collects finished transactions.
+    waitIdle();
+
+    asyncDoneCtx = ctx;
+    asyncDone = onDone;
+
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t left = bytes;
+    for (uint32_t i = 0; i < chunks; i++) {
+        const uint32_t n = left < maxTransferBytes ? left : maxTransferBytes;
+        spi_transaction_t& t = trans[i];
+        memset(&t, 0, sizeof(t));
+        t.length = n * 8;
+        t.tx_buffer = p;
+        t.user = (void*)(kUserDc | (i + 1 == chunks ? kUserLast : 0));
+        if (spi_device_queue_trans(spi, &t, pdMS_TO_TICKS(500)) != ESP_OK) {
+            // The last transaction never got queued, so no callback will come:
+            // send the rest synchronously and report completion here.
+            asyncDone = nullptr;
+            asyncDoneCtx = nullptr;
+            waitIdle();
+            while (left > 0) {
+                const uint32_t m = left < maxTransferBytes ? left : maxTransferBytes;
+                writeBytes(true, p, m);
+                p += m;
+                left -= m;
+            }
+            onDone(ctx);
+            return true;
+        }
+        inFlight++;
+        p += n;
+        left -= n;
+    }
+    return true;
+}
+
 // Configure LVGL display driver for ST7789V2-specific behavior
 void ST7789V2_Driver::configureLVGL(lv_disp_drv_t* drv, uint8_t rotation) {
     // ST7789V2 panel stays in portrait mode (240x280)
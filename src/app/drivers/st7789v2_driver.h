@@ -1,11 +1,15 @@
 /*
  * ST7789V2 Display Driver (Native SPI)
- * 
+ *
  * Optimized driver for 1.69" IPS LCD (240x280 ST7789V2).
- * Direct SPI control for maximum performance (60MHz).
- * 
+ * Talks to the panel through ESP-IDF's spi_master with DMA.
+ *
  * Features:
- * - BGR565 color swap for proper anti-aliasing
+ * - Queued DMA pixel transfers: pushColorsAsync() returns once the band is
+ *   queued and reports completion from the SPI post-transfer callback, so the
+ *   (single) core renders the next band while the previous one is sent
+ * - Zero-copy flush when LVGL renders big-endian RGB565 (LVGL_COLOR_16_SWAP)
+ * - D/C driven by the SPI pre-transfer callback, CS by the SPI peripheral
  * - 20px Y-offset handling for 1.69" panel
  * - PWM backlight control (0-100%)
  * - Landscape mode via LVGL software rotation
@@ -16,7 +20,8 @@
 
 #include "../display_driver.h"
 #include "../board_config.h"
-#include <SPI.h>
+
+#include <driver/spi_master.h>
 
 // ST7789V2 commands
 #define ST7789_CASET   0x2A
@@ -25,21 +30,38 @@
 
 class ST7789V2_Driver : public DisplayDriver {
 private:
-    SPIClass* spi;
+    // Queued pixel transactions; a band larger than the bus's max transfer
+    // is split over several.
+    static constexpr uint32_t kQueueDepth = 4;
+
+    spi_device_handle_t spi;
     uint8_t currentBrightness;
-    
-    // Low-level SPI communication
+    uint32_t maxTransferBytes;
+
+    // Transactions queued and not yet collected with spi_device_get_trans_result().
+    uint32_t inFlight;
+    spi_transaction_t trans[kQueueDepth];
+
+    // Completion of the pending async band (called from the SPI ISR).
+    void (*volatile asyncDone)(void* ctx);
+    void* volatile asyncDoneCtx;
+
+    static void onPreTransfer(spi_transaction_t* t);
+    static void onPostTransfer(spi_transaction_t* t);
+
+    // Low-level SPI communication (blocking, polling transactions)
     void writeCommand(uint8_t cmd);
     void writeData(uint8_t data);
+    void writeBytes(bool dc, const uint8_t* data, uint32_t len);
     void setWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
-    
-    // RGB565 to BGR565 color swap for anti-aliasing fix
-    void rgb565ToBgr565(uint16_t* pixels, uint32_t count);
-    
+
+    // Collects every queued transaction; polling transfers need an idle device.
+    void waitIdle();
+
 public:
     ST7789V2_Driver();
     ~ST7789V2_Driver() override = default;
-    
+
     void init() override;
     void setRotation(uint8_t rotation) override;
     int width() override { return (int)DISPLAY_WIDTH; }
@@ -49,14 +71,15 @@ public:
     uint8_t getBacklightBrightness() override;
     bool hasBacklightControl() override;
     void applyDisplayFixes() override;
-    
+
     // LVGL configuration - ST7789V2 requires software rotation
     void configureLVGL(lv_disp_drv_t* drv, uint8_t rotation) override;
-    
+
     void startWrite() override;
     void endWrite() override;
     void setAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) override;
     void pushColors(uint16_t* data, uint32_t len, bool swap_bytes = true) override;
+    bool pushColorsAsync(uint16_t* data, uint32_t len, bool swap_bytes, void (*onDone)(void* ctx), void* ctx) override;
 };
 
 #endif // ST7789V2_DRIVER_H
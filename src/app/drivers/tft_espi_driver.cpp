@@ -1,7 +1,14 @@
 #include "tft_espi_driver.h"
 #include "../log_manager.h"
+#include "ledc_backlight_fade.h"
 
-TFT_eSPI_Driver::TFT_eSPI_Driver() : currentBrightness(100) {
+TFT_eSPI_Driver::TFT_eSPI_Driver()
+    : currentBrightness(100),
+      dmaReady(false),
+      dmaInFlight(false),
+      endPending(false),
+      asyncDone(nullptr),
+      asyncDoneCtx(nullptr) {
     // TFT_eSPI constructor already called
     // Initialize brightness to 100% (full brightness)
 }
@@ -9,6 +16,13 @@ TFT_eSPI_Driver::TFT_eSPI_Driver() : currentBrightness(100) {
 void TFT_eSPI_Driver::init() {
     Logger.logLine("TFT_eSPI: Initializing");
     tft.init();
+
+    #if TFT_ESPI_DMA_ENABLED
+    // Needs DMA-capable draw buffers (LVGL_BUFFER_PREFER_INTERNAL) and
+    // LVGL_DOUBLE_BUFFER to overlap rendering with the transfer.
+    dmaReady = tft.initDMA();
+    Logger.logLinef("TFT_eSPI: DMA flush %s", dmaReady ? "enabled" : "unavailable (blocking pushColors)");
+    #endif
     
     #if HAS_BACKLIGHT
     // Initialize PWM for backlight control
@@ -71,6 +85,7 @@ void TFT_eSPI_Driver::setBacklightBrightness(uint8_t brightness) {
     
     // ESP32 Arduino Core 3.x uses new LEDC API
     #if ESP_ARDUINO_VERSION_MAJOR >= 3
+    ledc_backlight_fade_stop(TFT_BL);
     ledcWrite(TFT_BL, dutyCycle);  // New API: write to pin directly
     #else
     ledcWrite(TFT_BACKLIGHT_PWM_CHANNEL, dutyCycle);  // Old API: write to channel
@@ -78,6 +93,32 @@ void TFT_eSPI_Driver::setBacklightBrightness(uint8_t brightness) {
     #endif
 }
 
+bool TFT_eSPI_Driver::fadeBacklight(uint8_t from, uint8_t to, uint32_t duration_ms) {
+    // ledcFade() (ledc_set_fade_with_time) needs the Core 3.x LEDC API.
+    #if HAS_BACKLIGHT && LEDC_BACKLIGHT_FADE_SUPPORTED
+    if (from > 100) from = 100;
+    if (to > 100) to = 100;
+
+    uint32_t fromDuty = (from * 255) / 100;
+    uint32_t toDuty = (to * 255) / 100;
+    #ifdef TFT_BACKLIGHT_ON
+    if (!TFT_BACKLIGHT_ON) {
+        fromDuty = 255 - fromDuty;
+        toDuty = 255 - toDuty;
+    }
+    #endif
+
+    if (!ledc_backlight_fade(TFT_BL, fromDuty, toDuty, duration_ms)) return false;
+    currentBrightness = to;
+    return true;
+    #else
+    (void)from;
+    (void)to;
+    (void)duration_ms;
+    return false;
+    #endif
+}
+
 uint8_t TFT_eSPI_Driver::getBacklightBrightness() {
     #if HAS_BACKLIGHT
     return currentBrightness;
@@ -118,18 +159,62 @@ void TFT_eSPI_Driver::applyDisplayFixes() {
     #endif
 }
 
+void TFT_eSPI_Driver::completeDma() {
+    dmaInFlight = false;
+    if (endPending) {
+        endPending = false;
+        tft.endWrite();
+    }
+    void (*done)(void* ctx) = asyncDone;
+    asyncDone = nullptr;
+    if (done) done(asyncDoneCtx);
+}
+
+void TFT_eSPI_Driver::finishDma() {
+    if (!dmaInFlight) return;
+    tft.dmaWait();
+    completeDma();
+}
+
 void TFT_eSPI_Driver::startWrite() {
+    finishDma();
     tft.startWrite();
 }
 
 void TFT_eSPI_Driver::endWrite() {
+    // tft.endWrite() waits for the DMA; defer it so the flush can return.
+    if (dmaInFlight) {
+        endPending = true;
+        return;
+    }
     tft.endWrite();
 }
 
 void TFT_eSPI_Driver::setAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) {
+    finishDma();
     tft.setAddrWindow(x, y, w, h);
 }
 
 void TFT_eSPI_Driver::pushColors(uint16_t* data, uint32_t len, bool swap_bytes) {
+    finishDma();
     tft.pushColors(data, len, swap_bytes);
 }
+
+bool TFT_eSPI_Driver::pushColorsAsync(uint16_t* data, uint32_t len, bool swap_bytes, void (*onDone)(void* ctx), void* ctx) {
+    // pushPixelsDMA() would swap in place (in LVGL's buffer); only zero-copy
+    // bands go through DMA (LVGL_COLOR_16_SWAP on the CYD).
+    if (!dmaReady || swap_bytes || len == 0) return false;
+    finishDma();
+
+    asyncDone = onDone;
+    asyncDoneCtx = ctx;
+    dmaInFlight = true;
+    tft.pushPixelsDMA(data, len);
+    return true;
+}
+
+void TFT_eSPI_Driver::pollAsyncFlush() {
+    if (dmaInFlight && !tft.dmaBusy()) {
+        completeDma();
+    }
+}
@@ -3,6 +3,11 @@
  * 
  * Wrapper for Bodmer's TFT_eSPI library.
  * Supports: ILI9341, ST7789, ST7735, ILI9488, and many others.
+ *
+ * With TFT_ESPI_DMA_ENABLED, pushColorsAsync() starts the band with
+ * pushPixelsDMA() and returns. TFT_eSPI has no completion callback, so the
+ * transfer is finished (bus released, onDone called) from pollAsyncFlush()
+ * or by the next driver call that needs the bus.
  */
 
 #ifndef TFT_ESPI_DRIVER_H
@@ -16,6 +21,18 @@ class TFT_eSPI_Driver : public DisplayDriver {
 private:
     TFT_eSPI tft;
     uint8_t currentBrightness;  // Current brightness level (0-100%)
+
+    // DMA flush state (LVGL task only).
+    bool dmaReady;     // initDMA() succeeded
+    bool dmaInFlight;  // a pushPixelsDMA() band has not been completed yet
+    bool endPending;   // endWrite() arrived while the band was in flight
+    void (*asyncDone)(void* ctx);
+    void* asyncDoneCtx;
+
+    // Releases the bus if endWrite() was deferred, then reports the band done.
+    void completeDma();
+    // Blocks until the in-flight band (if any) is sent, then completes it.
+    void finishDma();
     
 public:
     TFT_eSPI_Driver();
@@ -29,12 +46,15 @@ public:
     void setBacklightBrightness(uint8_t brightness) override;  // 0-100%
     uint8_t getBacklightBrightness() override;
     bool hasBacklightControl() override;
+    bool fadeBacklight(uint8_t from, uint8_t to, uint32_t duration_ms) override;
     void applyDisplayFixes() override;
     
     void startWrite() override;
     void endWrite() override;
     void setAddrWindow(int16_t x, int16_t y, uint16_t w, uint16_t h) override;
     void pushColors(uint16_t* data, uint32_t len, bool swap_bytes = true) override;
+    bool pushColorsAsync(uint16_t* data, uint32_t len, bool swap_bytes, void (*onDone)(void* ctx), void* ctx) override;
+    void pollAsyncFlush() override;
 };
 
 #endif // TFT_ESPI_DRIVER_H
@@ -1,8 +1,35 @@
 #include "xpt2046_driver.h"
 #include "../log_manager.h"
 
+static_assert(XPT2046_SAMPLES >= 1 && XPT2046_SAMPLES <= 15, "XPT2046_SAMPLES must be 1..15");
+
+// Controller commands (start bit, channel, 12-bit differential, PD1:PD0).
+// PD = 01 keeps the reference/ADC on between conversions of a burst; the
+// last command of a burst uses PD = 00 so T_IRQ is enabled again.
+static constexpr uint8_t kCmdZ1 = 0xB1;
+static constexpr uint8_t kCmdZ2 = 0xC1;
+static constexpr uint8_t kCmdX = 0x91;
+static constexpr uint8_t kCmdY = 0xD1;
+static constexpr uint8_t kCmdYPowerDown = 0xD0;
+
+static const SPISettings kTouchSPISettings(2000000, MSBFIRST, SPI_MODE0);
+
+static uint16_t median(uint16_t* v, uint8_t n) {
+    // Insertion sort; n is a handful of samples.
+    for (uint8_t i = 1; i < n; i++) {
+        const uint16_t key = v[i];
+        int8_t j = (int8_t)i - 1;
+        while (j >= 0 && v[j] > key) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = key;
+    }
+    return v[n / 2];
+}
+
 XPT2046_Driver::XPT2046_Driver(uint8_t cs, uint8_t irq) 
-    : ts(cs, irq), cs_pin(cs), irq_pin(irq), rotation(1), touchSPI(nullptr) {
+    : touchSPI(nullptr), ownsSPI(false), cs_pin(cs), irq_pin(irq), rotation(1) {
     // Default calibration values (will be overridden by board config)
     cal_x_min = 300;
     cal_x_max = 3900;
@@ -11,10 +38,10 @@ XPT2046_Driver::XPT2046_Driver(uint8_t cs, uint8_t irq)
 }
 
 XPT2046_Driver::~XPT2046_Driver() {
-    if (touchSPI) {
+    if (touchSPI && ownsSPI) {
         delete touchSPI;
-        touchSPI = nullptr;
     }
+    touchSPI = nullptr;
 }
 
 void XPT2046_Driver::init() {
@@ -23,52 +50,94 @@ void XPT2046_Driver::init() {
     // Configure SPI bus for touch controller (CYD uses separate VSPI bus)
     #if defined(TOUCH_MOSI) && defined(TOUCH_MISO) && defined(TOUCH_SCLK)
     touchSPI = new SPIClass(VSPI);
+    ownsSPI = true;
     touchSPI->begin(TOUCH_SCLK, TOUCH_MISO, TOUCH_MOSI, TOUCH_CS);
     Logger.logLinef("XPT2046: SPI bus configured (MOSI=%d, MISO=%d, CLK=%d, CS=%d)", 
                    TOUCH_MOSI, TOUCH_MISO, TOUCH_SCLK, TOUCH_CS);
-    
-    // Initialize XPT2046 touchscreen library with custom SPI
-    ts.begin(*touchSPI);
     #else
     // Use default SPI bus
-    ts.begin();
+    touchSPI = &SPI;
+    touchSPI->begin();
     #endif
+
+    pinMode(cs_pin, OUTPUT);
+    digitalWrite(cs_pin, HIGH);
+    if (irq_pin != 255) {
+        pinMode(irq_pin, INPUT);
+    }
     
-    ts.setRotation(rotation);
-    
-    Logger.logLinef("XPT2046: Calibration (%d,%d) to (%d,%d), rotation=%d", 
-                   cal_x_min, cal_y_min, cal_x_max, cal_y_max, rotation);
+    Logger.logLinef("XPT2046: Calibration (%d,%d) to (%d,%d), rotation=%d, %d-sample median", 
+                   cal_x_min, cal_y_min, cal_x_max, cal_y_max, rotation, XPT2046_SAMPLES);
     Logger.logLine("XPT2046: Initialization complete");
 }
 
+bool XPT2046_Driver::readRaw(uint16_t* x, uint16_t* y, uint16_t* z) {
+    // Each transfer16() returns the previous conversion while sending the next command.
+    uint16_t xs[XPT2046_SAMPLES];
+    uint16_t ys[XPT2046_SAMPLES];
+
+    touchSPI->beginTransaction(kTouchSPISettings);
+    digitalWrite(cs_pin, LOW);
+    touchSPI->transfer(kCmdZ1);
+    const int32_t z1 = touchSPI->transfer16(kCmdZ2) >> 3;
+    const int32_t z2 = touchSPI->transfer16(kCmdX) >> 3;
+    int32_t pressure = z1 + 4095 - z2;
+    if (pressure < 0) pressure = 0;
+
+    const bool touched = pressure >= XPT2046_Z_THRESHOLD;
+    if (touched) {
+        (void)touchSPI->transfer16(kCmdX);  // the first X after Z settles poorly
+        for (uint8_t i = 0; i < XPT2046_SAMPLES; i++) {
+            const bool last = (i == XPT2046_SAMPLES - 1);
+            xs[i] = touchSPI->transfer16(last ? kCmdYPowerDown : kCmdY) >> 3;
+            ys[i] = touchSPI->transfer16(last ? 0 : kCmdX) >> 3;
+        }
+    } else {
+        (void)touchSPI->transfer16(kCmdYPowerDown);
+        (void)touchSPI->transfer16(0);
+    }
+    digitalWrite(cs_pin, HIGH);
+    touchSPI->endTransaction();
+
+    if (!touched) return false;
+
+    *x = median(xs, XPT2046_SAMPLES);
+    *y = median(ys, XPT2046_SAMPLES);
+    *z = (uint16_t)pressure;
+
+    // A floating MISO (controller not responding) reads as all ones.
+    return *x < 4096 && *y < 4096;
+}
+
 bool XPT2046_Driver::isTouched() {
-    return ts.touched();
+    uint16_t x, y;
+    return getTouch(&x, &y);
 }
 
 bool XPT2046_Driver::getTouch(uint16_t* x, uint16_t* y, uint16_t* pressure) {
-    // Check if screen is being touched
-    if (!ts.tirqTouched() && ts.bufferEmpty()) {
+    // T_IRQ is low only while pressed: skip the SPI burst when it is high.
+    if (irq_pin != 255 && digitalRead(irq_pin) != LOW) {
         return false;
     }
-    
-    // Get raw coordinates from XPT2046
-    TS_Point p = ts.getPoint();
-    
-    // Validate raw values (should be in 0-4095 range, not max noise values)
-    if (p.x >= 8000 || p.y >= 8000 || p.z >= 4000) {
-        // Invalid/noise - touch controller not responding properly
+
+    uint16_t rx, ry, rz;
+    if (!readRaw(&rx, &ry, &rz)) {
         return false;
     }
-    
-    // Filter by pressure - XPT2046 needs minimum pressure to be valid touch
-    // z=0 is electrical noise, not actual touch
-    if (p.z < 200) {  // Minimum pressure threshold
-        return false;
+
+    // Raw axes to the display orientation (same mapping as XPT2046_Touchscreen,
+    // so existing TOUCH_CAL_* values keep working).
+    int32_t px, py;
+    switch (rotation) {
+        case 0: px = 4095 - ry; py = rx; break;
+        case 1: px = rx; py = ry; break;
+        case 2: px = ry; py = 4095 - rx; break;
+        default: px = 4095 - rx; py = 4095 - ry; break;
     }
     
     // Map raw coordinates (0-4095) to calibrated screen coordinates
-    int32_t mapped_x = map(p.x, cal_x_min, cal_x_max, 0, DISPLAY_WIDTH - 1);
-    int32_t mapped_y = map(p.y, cal_y_min, cal_y_max, 0, DISPLAY_HEIGHT - 1);
+    int32_t mapped_x = map(px, cal_x_min, cal_x_max, 0, DISPLAY_WIDTH - 1);
+    int32_t mapped_y = map(py, cal_y_min, cal_y_max, 0, DISPLAY_HEIGHT - 1);
     
     // Clamp to display bounds
     *x = constrain(mapped_x, 0, DISPLAY_WIDTH - 1);
@@ -76,7 +145,7 @@ bool XPT2046_Driver::getTouch(uint16_t* x, uint16_t* y, uint16_t* pressure) {
     
     // Optionally return pressure (Z coordinate)
     if (pressure) {
-        *pressure = p.z;
+        *pressure = rz;
     }
     
     return true;
@@ -94,8 +163,7 @@ void XPT2046_Driver::setCalibration(uint16_t x_min, uint16_t x_max,
 }
 
 void XPT2046_Driver::setRotation(uint8_t rot) {
-    rotation = rot;
-    ts.setRotation(rotation);
+    rotation = rot % 4;
     
     Logger.logLinef("XPT2046: Rotation set to %d", rotation);
 }
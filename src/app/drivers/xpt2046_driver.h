@@ -1,10 +1,16 @@
 /*
  * XPT2046 Touch Driver
  * 
- * Standalone driver using XPT2046_Touchscreen library by Paul Stoffregen.
+ * Standalone resistive touch driver talking to the controller directly over SPI.
  * Used on ESP32-2432S028R (CYD) and compatible displays.
  * 
  * Hardware: Resistive touch controller on separate VSPI bus
+ *
+ * Each read checks the pressure first, then takes XPT2046_SAMPLES X/Y
+ * conversions in one chip-select burst and keeps the median of each axis,
+ * which drops the outliers a resistive panel produces at the edges of a
+ * press. With TOUCH_INT_SAMPLING the reads run on TouchManager's sampling
+ * task (woken by T_IRQ), never inside the LVGL indev read.
  */
 
 #ifndef XPT2046_DRIVER_H
@@ -12,13 +18,12 @@
 
 #include "../touch_driver.h"
 #include "../board_config.h"
-#include <XPT2046_Touchscreen.h>
 #include <SPI.h>
 
 class XPT2046_Driver : public TouchDriver {
 private:
-    XPT2046_Touchscreen ts;  // Standalone touch controller
     SPIClass* touchSPI;      // Persistent SPI instance for touch controller
+    bool ownsSPI;            // touchSPI was created here (not the global SPI)
     uint8_t cs_pin;
     uint8_t irq_pin;
     
@@ -26,6 +31,10 @@ private:
     uint16_t cal_x_min, cal_x_max;
     uint16_t cal_y_min, cal_y_max;
     uint8_t rotation;
+
+    // One pressure check plus a median-filtered X/Y burst, in raw controller
+    // axes. Returns false (controller powered down) below XPT2046_Z_THRESHOLD.
+    bool readRaw(uint16_t* x, uint16_t* y, uint16_t* z);
     
 public:
     // Constructor initializes standalone XPT2046 controller
@@ -2,171 +2,393 @@
 
 #include "ble_keyboard_manager.h"
 #include "log_manager.h"
+#include "macros_config.h"
 
 #include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
-#if BLE_KEYBOARD_MANAGER_ENABLED
-
 namespace {
 
-constexpr uint32_t kInterStepDelayMs = 8;
+enum DuckyOp : uint8_t {
+    kOpEnd = 0x00,
+    kOpText = 0x01,
+    kOpDelay = 0x02,
+    kOpKey = 0x03,
+    kOpMedia = 0x04,
+    kOpRate = 0x05,
+};
 
-static void delayMs(uint32_t ms) {
-    if (ms == 0) return;
-    vTaskDelay(pdMS_TO_TICKS(ms));
-}
+constexpr uint8_t kModCtrl = 0x01;
+constexpr uint8_t kModShift = 0x02;
+constexpr uint8_t kModAlt = 0x04;
+constexpr uint8_t kModGui = 0x08;
+constexpr uint8_t kModifierKeyBase = 0x80;   // KEY_LEFT_CTRL; +1 shift, +2 alt, +3 gui
 
-static void strToUpperInPlace(char* s) {
-    if (!s) return;
-    for (; *s; s++) {
-        *s = (char)toupper((unsigned char)*s);
-    }
-}
+struct NamedKey {
+    const char* name;
+    uint8_t code;
+};
 
-static char* trimInPlace(char* s) {
-    if (!s) return s;
+struct NamedMedia {
+    const char* name;
+    uint8_t report[2];
+};
+
+// Key codes as in BleKeyboard.h; spelled out so scripts can be validated in
+// builds without the BLE keyboard.
+static const NamedKey kNamedKeys[] = {
+    {"ENTER", 0xB0}, {"RETURN", 0xB0},
+    {"TAB", 0xB3},
+    {"ESC", 0xB1}, {"ESCAPE", 0xB1},
+    {"BACKSPACE", 0xB2}, {"BKSP", 0xB2},
+    {"SPACE", (uint8_t)' '},
+    {"UPARROW", 0xDA}, {"UP", 0xDA},
+    {"DOWNARROW", 0xD9}, {"DOWN", 0xD9},
+    {"LEFTARROW", 0xD8}, {"LEFT", 0xD8},
+    {"RIGHTARROW", 0xD7}, {"RIGHT", 0xD7},
+    {"HOME", 0xD2},
+    {"END", 0xD5},
+    {"PAGEUP", 0xD3},
+    {"PAGEDOWN", 0xD6},
+    {"F1", 0xC2}, {"F2", 0xC3}, {"F3", 0xC4}, {"F4", 0xC5},
+    {"F5", 0xC6}, {"F6", 0xC7}, {"F7", 0xC8}, {"F8", 0xC9},
+    {"F9", 0xCA}, {"F10", 0xCB}, {"F11", 0xCC}, {"F12", 0xCD},
+};
+
+static const NamedMedia kNamedMedia[] = {
+    {"VOLUMEUP", {32, 0}},
+    {"VOLUMEDOWN", {64, 0}},
+    {"MUTE", {16, 0}},
+    {"PLAYPAUSE", {8, 0}},
+    {"NEXTTRACK", {1, 0}},
+    {"PREVTRACK", {2, 0}}, {"PREV", {2, 0}},
+};
+
+static const NamedKey kNamedModifiers[] = {
+    {"CTRL", kModCtrl}, {"CONTROL", kModCtrl},
+    {"SHIFT", kModShift},
+    {"ALT", kModAlt},
+    {"GUI", kModGui}, {"WIN", kModGui}, {"CMD", kModGui},
+};
 
-    // Left trim
-    while (*s && isspace((unsigned char)*s)) s++;
+#if BLE_KEYBOARD_MANAGER_ENABLED
+static_assert(KEY_LEFT_CTRL == kModifierKeyBase && KEY_LEFT_GUI == kModifierKeyBase + 3, "modifier codes");
+static_assert(KEY_RETURN == 0xB0 && KEY_F1 == 0xC2 && KEY_F12 == 0xCD && KEY_UP_ARROW == 0xDA, "key codes");
+#endif
 
-    // Right trim
-    char* end = s + strlen(s);
-    while (end > s && isspace((unsigned char)end[-1])) end--;
-    *end = '\0';
-    return s;
+// Case-insensitive compare of a length-delimited token with a name.
+static bool tokenIs(const char* tok, size_t len, const char* name) {
+    return strncasecmp(tok, name, len) == 0 && name[len] == '\0';
 }
 
-static bool tokenEquals(const char* a, const char* b) {
-    if (!a || !b) return false;
-    return strcasecmp(a, b) == 0;
+static bool hasWord(const char* s, size_t len, const char* word) {
+    const size_t n = strlen(word);
+    return len >= n && strncasecmp(s, word, n) == 0 && (len == n || isspace((unsigned char)s[n]));
 }
 
-struct KeyToken {
-    bool isMedia;
-    uint8_t key;
-    MediaKeyReport media;
-};
+struct Emitter {
+    uint8_t* out;
+    size_t cap;
+    size_t len;
+    bool overflow;
 
-static bool parseMediaToken(const char* tok, KeyToken* out) {
-    if (!tok || !out) return false;
+    bool fits(size_t n) const {
+        // One byte is always kept for the END opcode.
+        return !overflow && (cap == 0 || len + n + 1 <= cap);
+    }
 
-    if (tokenEquals(tok, "VOLUMEUP")) {
-        out->isMedia = true;
-        memcpy(out->media, KEY_MEDIA_VOLUME_UP, sizeof(MediaKeyReport));
-        return true;
+    void put(uint8_t b) {
+        if (out) out[len] = b;
+        len++;
     }
-    if (tokenEquals(tok, "VOLUMEDOWN")) {
-        out->isMedia = true;
-        memcpy(out->media, KEY_MEDIA_VOLUME_DOWN, sizeof(MediaKeyReport));
-        return true;
+};
+
+struct Compiler {
+    Emitter em;
+    unsigned line_no;
+    char* err;
+    size_t err_len;
+    bool had_error;
+
+    // Keep the first error: "line N: what" or "line N: what 'token'".
+    void fail(const char* what, const char* tok = nullptr, size_t tok_len = 0) {
+        if (had_error) return;
+        had_error = true;
+        if (!err || err_len == 0) return;
+        if (tok) {
+            snprintf(err, err_len, "line %u: %s '%.*s'", line_no, what, (int)(tok_len > 24 ? 24 : tok_len), tok);
+        } else {
+            snprintf(err, err_len, "line %u: %s", line_no, what);
+        }
     }
-    if (tokenEquals(tok, "MUTE")) {
-        out->isMedia = true;
-        memcpy(out->media, KEY_MEDIA_MUTE, sizeof(MediaKeyReport));
-        return true;
+
+    void text(const char* s, size_t len) {
+        while (len > 0) {
+            const size_t n = len > 255 ? 255 : len;
+            if (!em.fits(n + 3)) {
+                em.overflow = true;
+                return;
+            }
+            em.put(kOpText);
+            em.put((uint8_t)n);
+            for (size_t i = 0; i < n; i++) em.put((uint8_t)s[i]);
+            em.put(0);
+            s += n;
+            len -= n;
+        }
     }
-    if (tokenEquals(tok, "PLAYPAUSE")) {
-        out->isMedia = true;
-        memcpy(out->media, KEY_MEDIA_PLAY_PAUSE, sizeof(MediaKeyReport));
-        return true;
+
+    void delay(uint32_t ms) {
+        if (!em.fits(5)) {
+            em.overflow = true;
+            return;
+        }
+        em.put(kOpDelay);
+        for (int i = 0; i < 4; i++) em.put((uint8_t)(ms >> (8 * i)));
     }
-    if (tokenEquals(tok, "NEXTTRACK")) {
-        out->isMedia = true;
-        memcpy(out->media, KEY_MEDIA_NEXT_TRACK, sizeof(MediaKeyReport));
-        return true;
+
+    void chord(const char* s, size_t len) {
+        uint8_t mods = 0;
+        size_t i = 0;
+        for (;;) {
+            while (i < len && (s[i] == ' ' || s[i] == '\t')) i++;
+            if (i >= len) return;   // modifiers only: nothing to send
+
+            const char* tok = s + i;
+            size_t tok_len = 0;
+            while (i < len && s[i] != ' ' && s[i] != '\t') {
+                i++;
+                tok_len++;
+            }
+
+            bool is_mod = false;
+            for (const NamedKey& m : kNamedModifiers) {
+                if (tokenIs(tok, tok_len, m.name)) {
+                    mods |= m.code;
+                    is_mod = true;
+                    break;
+                }
+            }
+            if (is_mod) continue;
+
+            // Key token; anything after it on the line is ignored.
+            for (const NamedMedia& m : kNamedMedia) {
+                if (!tokenIs(tok, tok_len, m.name)) continue;
+                if (!em.fits(4)) {
+                    em.overflow = true;
+                    return;
+                }
+                em.put(kOpMedia);
+                em.put(mods);
+                em.put(m.report[0]);
+                em.put(m.report[1]);
+                return;
+            }
+
+            int code = -1;
+            if (tok_len == 1) {
+                // Single character (letters/digits) — use ASCII path.
+                code = (uint8_t)tok[0];
+            } else {
+                for (const NamedKey& k : kNamedKeys) {
+                    if (tokenIs(tok, tok_len, k.name)) {
+                        code = k.code;
+                        break;
+                    }
+                }
+            }
+            if (code < 0) {
+                fail("unknown key", tok, tok_len);
+                return;
+            }
+            if (!em.fits(3)) {
+                em.overflow = true;
+                return;
+            }
+            em.put(kOpKey);
+            em.put(mods);
+            em.put((uint8_t)code);
+            return;
+        }
     }
-    if (tokenEquals(tok, "PREVTRACK") || tokenEquals(tok, "PREV")) {
-        out->isMedia = true;
-        memcpy(out->media, KEY_MEDIA_PREVIOUS_TRACK, sizeof(MediaKeyReport));
+
+    // Parse the number after a word_len-character command.
+    bool millisArg(const char* s, size_t len, size_t word_len, const char* what, uint32_t* out) {
+        size_t i = word_len;
+        while (i < len && isspace((unsigned char)s[i])) i++;
+        if (i >= len) {
+            fail(what);
+            return false;
+        }
+        const size_t start = i;
+        uint32_t ms = 0;
+        for (; i < len; i++) {
+            if (!isdigit((unsigned char)s[i])) {
+                char msg[48];
+                snprintf(msg, sizeof(msg), "%s, got", what);
+                fail(msg, s + start, len - start);
+                return false;
+            }
+            const uint32_t digit = (uint32_t)(s[i] - '0');
+            ms = (ms > (UINT32_MAX - digit) / 10) ? UINT32_MAX : ms * 10 + digit;
+        }
+        *out = ms;
         return true;
     }
 
-    return false;
-}
+    void line(const char* s, size_t len) {
+        // Trim
+        while (len > 0 && isspace((unsigned char)*s)) {
+            s++;
+            len--;
+        }
+        while (len > 0 && isspace((unsigned char)s[len - 1])) len--;
+        if (len == 0) return;
 
-static bool parseKeyToken(const char* tok, KeyToken* out) {
-    if (!tok || !*tok || !out) return false;
+        // Comments
+        if (hasWord(s, len, "REM")) return;
+        if (s[0] == '#' || (len >= 2 && s[0] == '/' && s[1] == '/')) return;
+
+        // STRING <text>
+        if (hasWord(s, len, "STRING")) {
+            size_t i = 6;
+            while (i < len && isspace((unsigned char)s[i])) i++;
+            text(s + i, len - i);
+            return;
+        }
 
-    // Media keys first
-    if (parseMediaToken(tok, out)) return true;
+        // STRINGDELAY <ms>: report interval for the STRING lines after it
+        if (hasWord(s, len, "STRINGDELAY") || hasWord(s, len, "STRING_DELAY")) {
+            const size_t word = (s[6] == '_') ? 12 : 11;
+            uint32_t ms = 0;
+            if (!millisArg(s, len, word, "STRINGDELAY needs milliseconds", &ms)) return;
+            if (ms > 255) {
+                fail("STRINGDELAY above 255 ms");
+                return;
+            }
+            if (!em.fits(2)) {
+                em.overflow = true;
+                return;
+            }
+            em.put(kOpRate);
+            em.put((uint8_t)ms);
+            return;
+        }
 
-    out->isMedia = false;
+        // DELAY <ms>
+        if (hasWord(s, len, "DELAY")) {
+            uint32_t ms = 0;
+            if (!millisArg(s, len, 5, "DELAY needs milliseconds", &ms)) return;
+            if (ms > 0) delay(ms);
+            return;
+        }
 
-    // Single character (letters/digits) — use ASCII path.
-    if (strlen(tok) == 1) {
-        out->key = (uint8_t)tok[0];
-        return true;
+        chord(s, len);
     }
+};
 
-    // Normalize common names
-    if (tokenEquals(tok, "ENTER") || tokenEquals(tok, "RETURN")) { out->key = KEY_RETURN; return true; }
-    if (tokenEquals(tok, "TAB")) { out->key = KEY_TAB; return true; }
-    if (tokenEquals(tok, "ESC") || tokenEquals(tok, "ESCAPE")) { out->key = KEY_ESC; return true; }
-    if (tokenEquals(tok, "BACKSPACE") || tokenEquals(tok, "BKSP")) { out->key = KEY_BACKSPACE; return true; }
-    if (tokenEquals(tok, "SPACE")) { out->key = (uint8_t)' '; return true; }
-
-    if (tokenEquals(tok, "UPARROW") || tokenEquals(tok, "UP")) { out->key = KEY_UP_ARROW; return true; }
-    if (tokenEquals(tok, "DOWNARROW") || tokenEquals(tok, "DOWN")) { out->key = KEY_DOWN_ARROW; return true; }
-    if (tokenEquals(tok, "LEFTARROW") || tokenEquals(tok, "LEFT")) { out->key = KEY_LEFT_ARROW; return true; }
-    if (tokenEquals(tok, "RIGHTARROW") || tokenEquals(tok, "RIGHT")) { out->key = KEY_RIGHT_ARROW; return true; }
-
-    if (tokenEquals(tok, "HOME")) { out->key = KEY_HOME; return true; }
-    if (tokenEquals(tok, "END")) { out->key = KEY_END; return true; }
-    if (tokenEquals(tok, "PAGEUP")) { out->key = KEY_PAGE_UP; return true; }
-    if (tokenEquals(tok, "PAGEDOWN")) { out->key = KEY_PAGE_DOWN; return true; }
-
-    // Function keys
-    if (tok[0] == 'F' || tok[0] == 'f') {
-        const int n = atoi(tok + 1);
-        switch (n) {
-            case 1: out->key = KEY_F1; return true;
-            case 2: out->key = KEY_F2; return true;
-            case 3: out->key = KEY_F3; return true;
-            case 4: out->key = KEY_F4; return true;
-            case 5: out->key = KEY_F5; return true;
-            case 6: out->key = KEY_F6; return true;
-            case 7: out->key = KEY_F7; return true;
-            case 8: out->key = KEY_F8; return true;
-            case 9: out->key = KEY_F9; return true;
-            case 10: out->key = KEY_F10; return true;
-            case 11: out->key = KEY_F11; return true;
-            case 12: out->key = KEY_F12; return true;
-            default: break;
-        }
+} // namespace
+
+bool ducky_compile(const char* script, uint8_t* out, size_t out_cap, size_t* out_len, char* err, size_t err_len) {
+    if (err && err_len) err[0] = '\0';
+    if (out_len) *out_len = 0;
+    if (out && out_cap == 0) return false;
+
+    Compiler c = {};
+    c.em.out = out;
+    c.em.cap = out ? out_cap : 0;
+    c.err = err;
+    c.err_len = err_len;
+    c.line_no = 1;
+
+    const char* p = script ? script : "";
+    while (*p && !c.em.overflow) {
+        const char* nl = strpbrk(p, "\r\n");
+        const size_t len = nl ? (size_t)(nl - p) : strlen(p);
+        c.line(p, len);
+        if (!nl) break;
+
+        // Count LF, CRLF and lone CR as one line break each.
+        p = nl;
+        if (p[0] == '\r' && p[1] == '\n') p++;
+        p++;
+        c.line_no++;
     }
 
-    return false;
+    c.em.put(kOpEnd);
+    if (out_len) *out_len = c.em.len;
+
+    if (c.em.overflow) {
+        if (err && err_len) snprintf(err, err_len, "line %u: script too long", c.line_no);
+        return false;
+    }
+    return !c.had_error;
 }
 
-static bool parseModifierToken(const char* tok, uint8_t* keyOut) {
-    if (!tok || !keyOut) return false;
+size_t ducky_program_steps(const uint8_t* program, size_t len) {
+    if (!program) return 0;
+    size_t steps = 0;
+    size_t pc = 0;
+    while (pc < len) {
+        switch (program[pc++]) {
+            case kOpEnd:
+                return steps;
+            case kOpText: {
+                if (pc >= len) return 0;
+                const size_t n = program[pc++];
+                if (pc + n + 1 > len || program[pc + n] != 0) return 0;
+                pc += n + 1;
+                steps++;
+                break;
+            }
+            case kOpRate:
+                pc += 1;
+                break;
+            case kOpDelay:
+                pc += 4;
+                steps++;
+                break;
+            case kOpKey:
+                pc += 2;
+                steps++;
+                break;
+            case kOpMedia:
+                pc += 3;
+                steps++;
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 0;  // no END
+}
 
-    if (tokenEquals(tok, "CTRL") || tokenEquals(tok, "CONTROL")) { *keyOut = KEY_LEFT_CTRL; return true; }
-    if (tokenEquals(tok, "SHIFT")) { *keyOut = KEY_LEFT_SHIFT; return true; }
-    if (tokenEquals(tok, "ALT")) { *keyOut = KEY_LEFT_ALT; return true; }
-    if (tokenEquals(tok, "GUI") || tokenEquals(tok, "WIN") || tokenEquals(tok, "CMD")) { *keyOut = KEY_LEFT_GUI; return true; }
+#if BLE_KEYBOARD_MANAGER_ENABLED
 
-    return false;
-}
+namespace {
 
-static void sendKeyToken(const KeyToken& tok, BleKeyboardManager* keyboard) {
-    if (!keyboard) return;
+constexpr uint32_t kInterStepDelayMs = 8;
 
-    if (tok.isMedia) {
-        keyboard->tapMedia(tok.media);
-    } else {
-        keyboard->tap(tok.key);
-    }
+constexpr uint32_t kCancelPollMs = 20;
+
+static inline bool cancelled(const volatile bool* cancel) {
+    return cancel && *cancel;
 }
 
-} // namespace
+// Sleep in short slices so a cancel ends a long DELAY promptly.
+static void delayMs(uint32_t ms, const volatile bool* cancel) {
+    while (ms > 0 && !cancelled(cancel)) {
+        const uint32_t step = ms > kCancelPollMs ? kCancelPollMs : ms;
+        vTaskDelay(pdMS_TO_TICKS(step));
+        ms -= step;
+    }
+}
 
-bool ducky_execute(const char* script, BleKeyboardManager* keyboard) {
-    if (!script || !*script) return false;
+static bool keyboardReady(BleKeyboardManager* keyboard) {
     if (!keyboard) return false;
 
     if (!keyboard->enabled()) {
@@ -178,114 +400,208 @@ bool ducky_execute(const char* script, BleKeyboardManager* keyboard) {
         Logger.logMessage("Ducky", "BLE keyboard not connected; macro skipped");
         return false;
     }
+    return true;
+}
 
-    // Copy into a scratch buffer so we can split lines in-place.
-    // Macro payload strings are bounded by MACROS_PAYLOAD_MAX_LEN (256), but keep a little headroom.
-    char buf[384];
-    strlcpy(buf, script, sizeof(buf));
-
-    char* cursor = buf;
-    while (cursor && *cursor) {
-        // Find end-of-line
-        char* line = cursor;
-        char* nl = strpbrk(cursor, "\r\n");
-        if (nl) {
-            // Null-terminate this line
-            *nl = '\0';
-
-            // Advance cursor past any CR/LF combo
-            cursor = nl + 1;
-            while (*cursor == '\r' || *cursor == '\n') cursor++;
-        } else {
-            cursor = nullptr;
-        }
-
-        char* trimmed = trimInPlace(line);
-        if (!trimmed || !*trimmed) continue;
+// Compiled programs for the SendKeys buttons of the live config, in one
+// allocation. Readers copy a program out under the mux, so a rebuild can swap
+// and free the set while a macro is still typing.
+struct DuckyProgramSet {
+    uint32_t generation;
+    uint16_t offset[MACROS_SCREEN_COUNT][MACROS_BUTTONS_PER_SCREEN];
+    uint16_t length[MACROS_SCREEN_COUNT][MACROS_BUTTONS_PER_SCREEN];   // 0 = no program
+    uint8_t data[];
+};
 
-        // Comments
-        if (strncasecmp(trimmed, "REM", 3) == 0 && (trimmed[3] == '\0' || isspace((unsigned char)trimmed[3]))) {
-            continue;
-        }
-        if (trimmed[0] == '#' || (trimmed[0] == '/' && trimmed[1] == '/')) {
-            continue;
-        }
+static DuckyProgramSet* g_programs = nullptr;
+static portMUX_TYPE g_programs_mux = portMUX_INITIALIZER_UNLOCKED;
 
-        // STRING <text>
-        if (strncasecmp(trimmed, "STRING", 6) == 0 && isspace((unsigned char)trimmed[6])) {
-            const char* text = trimmed + 6;
-            while (*text && isspace((unsigned char)*text)) text++;
-            keyboard->sendText(text);
-            delayMs(kInterStepDelayMs);
-            continue;
-        }
+} // namespace
 
-        // DELAY <ms>
-        if (strncasecmp(trimmed, "DELAY", 5) == 0 && isspace((unsigned char)trimmed[5])) {
-            const char* msStr = trimmed + 5;
-            while (*msStr && isspace((unsigned char)*msStr)) msStr++;
-            const long ms = strtol(msStr, nullptr, 10);
-            if (ms > 0) delayMs((uint32_t)ms);
-            continue;
+bool ducky_run(const uint8_t* program, size_t len, BleKeyboardManager* keyboard, const volatile bool* cancel) {
+    if (!program || len == 0) return false;
+    if (!keyboardReady(keyboard)) return false;
+
+    int typingInterval = -1;   // STRINGDELAY; -1 = configured default
+    size_t pc = 0;
+    while (pc < len) {
+        if (cancelled(cancel)) {
+            keyboard->releaseAll();
+            Logger.logMessage("Ducky", "Macro cancelled");
+            return false;
         }
 
-        // Tokenize by whitespace
-        // Make a working copy to uppercase tokens as needed.
-        char work[256];
-        strlcpy(work, trimmed, sizeof(work));
+        const uint8_t op = program[pc++];
+        switch (op) {
+            case kOpEnd:
+                return true;
+
+            case kOpText: {
+                if (pc >= len) return false;
+                const size_t n = program[pc++];
+                if (pc + n + 1 > len || program[pc + n] != 0) return false;
+                keyboard->typeText((const char*)(program + pc), typingInterval, cancel);
+                pc += n + 1;
+                delayMs(kInterStepDelayMs, cancel);
+                break;
+            }
 
-        uint8_t modifiers[4];
-        int modifierCount = 0;
+            case kOpRate:
+                if (pc >= len) return false;
+                typingInterval = program[pc++];
+                break;
+
+            case kOpDelay: {
+                if (pc + 4 > len) return false;
+                const uint32_t ms = (uint32_t)program[pc] | ((uint32_t)program[pc + 1] << 8) |
+                                    ((uint32_t)program[pc + 2] << 16) | ((uint32_t)program[pc + 3] << 24);
+                pc += 4;
+                delayMs(ms, cancel);
+                break;
+            }
 
-        char* saveptr = nullptr;
-        char* tok = strtok_r(work, " \t", &saveptr);
+            case kOpKey:
+            case kOpMedia: {
+                const size_t n = (op == kOpKey) ? 2 : 3;
+                if (pc + n > len) return false;
+                const uint8_t mods = program[pc];
 
-        // Collect modifier tokens
-        while (tok) {
-            uint8_t modKey = 0;
-            if (parseModifierToken(tok, &modKey)) {
-                if (modifierCount < (int)(sizeof(modifiers) / sizeof(modifiers[0]))) {
-                    modifiers[modifierCount++] = modKey;
+                // Send chord or single token
+                for (uint8_t bit = 0; bit < 4; bit++) {
+                    if (mods & (1u << bit)) keyboard->press((uint8_t)(kModifierKeyBase + bit));
+                }
+                if (op == kOpKey) {
+                    keyboard->tap(program[pc + 1]);
+                } else {
+                    const MediaKeyReport media = {program[pc + 1], program[pc + 2]};
+                    keyboard->tapMedia(media);
                 }
-                tok = strtok_r(nullptr, " \t", &saveptr);
-                continue;
+                pc += n;
+                delayMs(kInterStepDelayMs, cancel);
+
+                // Release modifiers and any sticky keys
+                keyboard->releaseAll();
+                delayMs(kInterStepDelayMs, cancel);
+                break;
             }
-            break;
-        }
 
-        if (!tok) {
-            continue;
+            default:
+                Logger.logMessagef("Ducky", "Bad opcode 0x%02X", (unsigned)op);
+                return false;
         }
+    }
+    return true;
+}
+
+bool ducky_execute(const char* script, BleKeyboardManager* keyboard, const volatile bool* cancel) {
+    if (!script || !*script) return false;
+    if (!keyboardReady(keyboard)) return false;
+
+    uint8_t program[DUCKY_PROGRAM_MAX_LEN];
+    size_t len = 0;
+    char err[80];
+    if (!ducky_compile(script, program, sizeof(program), &len, err, sizeof(err))) {
+        Logger.logMessagef("Ducky", "Script error (%s)", err);
+    }
+    return ducky_run(program, len, keyboard, cancel);
+}
 
-        KeyToken keyTok;
-        if (!parseKeyToken(tok, &keyTok)) {
-            Logger.logMessagef("Ducky", "Unknown token: %s", tok);
-            continue;
+void ducky_programs_rebuild(const MacroConfig* cfg) {
+    if (!cfg) return;
+
+    // Pass 1: size every program; pass 2 compiles into the set.
+    size_t total = 0;
+    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+            const MacroButtonConfig& btn = cfg->buttons[s][b];
+            if (btn.action != MacroButtonAction::SendKeys || btn.payload[0] == '\0') continue;
+            size_t len = 0;
+            (void)ducky_compile(btn.payload, nullptr, 0, &len, nullptr, 0);
+            total += len;
         }
+    }
 
-        // Send chord or single token
-        for (int i = 0; i < modifierCount; i++) {
-            keyboard->press(modifiers[i]);
+    DuckyProgramSet* set = (DuckyProgramSet*)malloc(sizeof(DuckyProgramSet) + total);
+    if (!set) {
+        Logger.logMessagef("Ducky", "Program cache: out of memory (%u bytes)", (unsigned)total);
+    } else {
+        memset(set, 0, sizeof(DuckyProgramSet));
+        set->generation = macros_config_generation();
+
+        size_t used = 0;
+        unsigned errors = 0;
+        for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
+            for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+                const MacroButtonConfig& btn = cfg->buttons[s][b];
+                if (btn.action != MacroButtonAction::SendKeys || btn.payload[0] == '\0') continue;
+                size_t len = 0;
+                char err[80];
+                if (!ducky_compile(btn.payload, set->data + used, total - used, &len, err, sizeof(err))) {
+                    if (errors++ == 0) Logger.logMessagef("Ducky", "Screen %d button %d: %s", s + 1, b + 1, err);
+                }
+                set->offset[s][b] = (uint16_t)used;
+                set->length[s][b] = (uint16_t)len;
+                used += len;
+            }
         }
+        Logger.logMessagef("Ducky", "Compiled macros: %u bytes, %u with errors", (unsigned)used, errors);
+    }
 
-        sendKeyToken(keyTok, keyboard);
-        delayMs(kInterStepDelayMs);
+    DuckyProgramSet* old;
+    portENTER_CRITICAL(&g_programs_mux);
+    old = g_programs;
+    g_programs = set;
+    portEXIT_CRITICAL(&g_programs_mux);
+    free(old);
+}
 
-        // Release modifiers and any sticky keys
-        keyboard->releaseAll();
-        delayMs(kInterStepDelayMs);
+bool ducky_execute_button(uint8_t screen, uint8_t button, const char* script, BleKeyboardManager* keyboard,
+                          const volatile bool* cancel) {
+    if (screen >= MACROS_SCREEN_COUNT || button >= MACROS_BUTTONS_PER_SCREEN) return false;
+
+    uint8_t program[DUCKY_PROGRAM_MAX_LEN];
+    size_t len = 0;
+    const uint32_t generation = macros_config_generation();
+    portENTER_CRITICAL(&g_programs_mux);
+    if (g_programs && g_programs->generation == generation) {
+        len = g_programs->length[screen][button];
+        if (len > sizeof(program)) len = 0;
+        memcpy(program, g_programs->data + g_programs->offset[screen][button], len);
     }
+    portEXIT_CRITICAL(&g_programs_mux);
 
-    return true;
+    if (len == 0) return ducky_execute(script, keyboard, cancel);
+    return ducky_run(program, len, keyboard, cancel);
 }
 
 #else
 
-bool ducky_execute(const char* script, BleKeyboardManager* keyboard) {
+bool ducky_run(const uint8_t* program, size_t len, BleKeyboardManager* keyboard, const volatile bool* cancel) {
+    (void)program;
+    (void)len;
+    (void)keyboard;
+    (void)cancel;
+    Logger.logMessage("Ducky", "BLE keyboard is not enabled in this build");
+    return false;
+}
+
+bool ducky_execute(const char* script, BleKeyboardManager* keyboard, const volatile bool* cancel) {
     (void)script;
     (void)keyboard;
+    (void)cancel;
     Logger.logMessage("Ducky", "BLE keyboard is not enabled in this build");
     return false;
 }
 
+void ducky_programs_rebuild(const MacroConfig* cfg) {
+    (void)cfg;
+}
+
+bool ducky_execute_button(uint8_t screen, uint8_t button, const char* script, BleKeyboardManager* keyboard,
+                          const volatile bool* cancel) {
+    (void)screen;
+    (void)button;
+    return ducky_execute(script, keyboard, cancel);
+}
+
 #endif // BLE_KEYBOARD_MANAGER_ENABLED
@@ -4,14 +4,21 @@
 #include <Arduino.h>
 
 class BleKeyboardManager;
+struct MacroConfig;
 
 // Executes a small DuckyScript-inspired subset.
 // - Commands are case-insensitive.
-// - Unknown tokens are ignored with a log warning.
+// - Unknown tokens are reported by ducky_compile(); at run time the line is
+//   skipped with a log warning.
 // - Safe no-op if keyboard is null or not connected.
+// - Blocks for the whole script; run it from the macro executor task
+//   (macro_executor.h), not the LVGL task. Setting *cancel stops it between
+//   steps and within DELAYs, releasing all keys.
 //
 // Supported:
 //   STRING <text>
+//   STRINGDELAY <ms>   pause after each key report for the STRINGs that follow
+//                      (0-255; default: the ble_typing_interval_ms setting)
 //   DELAY <ms>
 //   A..Z, 0..9
 //   ENTER, TAB, ESCAPE, BACKSPACE, SPACE
@@ -20,6 +27,39 @@ class BleKeyboardManager;
 //   F1..F12
 //   CTRL/SHIFT/ALT/GUI modifiers before a key token (multiple allowed)
 //   VOLUMEUP, VOLUMEDOWN, MUTE, PLAYPAUSE, NEXTTRACK, PREVTRACK
-bool ducky_execute(const char* script, BleKeyboardManager* keyboard);
+bool ducky_execute(const char* script, BleKeyboardManager* keyboard, const volatile bool* cancel = nullptr);
+
+// Scripts are compiled once into a compact opcode stream:
+//   0x01 TEXT  u8 len, len bytes, NUL
+//   0x02 DELAY u32 ms (little-endian)
+//   0x03 KEY   u8 modifier mask (1 ctrl, 2 shift, 4 alt, 8 gui), u8 key code
+//   0x04 MEDIA u8 modifier mask, 2-byte media report
+//   0x05 RATE  u8 ms (STRINGDELAY)
+//   0x00 END
+// A macro payload (MACROS_PAYLOAD_MAX_LEN) always fits DUCKY_PROGRAM_MAX_LEN.
+#define DUCKY_PROGRAM_MAX_LEN 400
+
+// Compile script into out (out may be null to only measure / validate).
+// Lines with errors are left out of the program. Returns false when a line
+// had an error (the first one is described in err, e.g.
+// "line 3: unknown key 'FOO'") or the program did not fit out_cap.
+bool ducky_compile(const char* script, uint8_t* out, size_t out_cap, size_t* out_len, char* err, size_t err_len);
+
+// Walks a compiled program without sending anything: the number of steps
+// (TEXT, DELAY, KEY, MEDIA) ducky_run() would take, or 0 when it is malformed.
+size_t ducky_program_steps(const uint8_t* program, size_t len);
+
+// Run a compiled program.
+bool ducky_run(const uint8_t* program, size_t len, BleKeyboardManager* keyboard, const volatile bool* cancel = nullptr);
+
+// Compile every SendKeys payload of the live config into the per-button
+// program cache. Call after loading the config and after each
+// macros_config_mark_*() call.
+void ducky_programs_rebuild(const MacroConfig* cfg);
+
+// Run a button's cached program; falls back to compiling script when the
+// cache was built for another config generation.
+bool ducky_execute_button(uint8_t screen, uint8_t button, const char* script, BleKeyboardManager* keyboard,
+                          const volatile bool* cancel = nullptr);
 
 #endif // DUCKY_SCRIPT_H
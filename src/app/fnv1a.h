@@ -0,0 +1,30 @@
+#pragma once
+
+// 32-bit FNV-1a, for cheap change detection and hash-table keys (not for
+// anything an attacker picks collisions in). Pass an earlier result as
+// `hash` to continue hashing across several pieces.
+
+#include <stddef.h>
+#include <stdint.h>
+
+static constexpr uint32_t kFnv1a32Init = 2166136261u;
+
+static inline uint32_t fnv1a32_byte(uint32_t hash, uint8_t c) {
+    return (hash ^ c) * 16777619u;
+}
+
+static inline uint32_t fnv1a32(const void* data, size_t len, uint32_t hash = kFnv1a32Init) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        hash = fnv1a32_byte(hash, p[i]);
+    }
+    return hash;
+}
+
+// NUL-terminated string, without the terminator.
+static inline uint32_t fnv1a32_str(const char* s, uint32_t hash = kFnv1a32Init) {
+    while (*s) {
+        hash = fnv1a32_byte(hash, (uint8_t)*s++);
+    }
+    return hash;
+}
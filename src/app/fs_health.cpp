@@ -1,9 +1,14 @@
 #include "fs_health.h"
 
+#include "board_config.h"
+
 #include <string.h>
 
 #if defined(ARDUINO_ARCH_ESP32)
+#include <FFat.h>
 #include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #endif
 
 namespace {
@@ -13,19 +18,61 @@ static FSHealthStats g_stats = {
     .ffat_mounted = false,
     .ffat_used_bytes = 0,
     .ffat_total_bytes = 0,
+    .ffat_usage_updates = 0,
 };
 
-static void detect_partitions() {
 #if defined(ARDUINO_ARCH_ESP32)
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool g_reconcile_started = false;
+
+// Deltas applied before the measurement have nothing to apply to; the
+// measurement includes them.
+static bool g_measured = false;
+
+static void detect_partitions() {
     const esp_partition_t* ffat_part = esp_partition_find_first(
         ESP_PARTITION_TYPE_DATA,
         ESP_PARTITION_SUBTYPE_DATA_FAT,
         "ffat");
     g_stats.ffat_partition_present = (ffat_part != nullptr);
+}
+
+static uint32_t clusters(uint32_t bytes) {
+    const uint32_t c = (uint32_t)FS_HEALTH_FFAT_CLUSTER_BYTES;
+    return (bytes + c - 1) / c;
+}
+
+// usedBytes() reads the whole FAT, which is why /api/health never calls it.
+static void reconcile_task_fn(void*) {
+    vTaskDelay(pdMS_TO_TICKS(FS_HEALTH_RECONCILE_DELAY_MS));
+
+    // A write that lands while the FAT is read may or may not be counted in
+    // it; measure again if one did.
+    for (int attempt = 0; attempt < 3; attempt++) {
+        portENTER_CRITICAL(&g_mux);
+        const uint32_t before = g_stats.ffat_usage_updates;
+        portEXIT_CRITICAL(&g_mux);
+
+        const uint32_t used = (uint32_t)FFat.usedBytes();
+        const uint32_t total = (uint32_t)FFat.totalBytes();
+
+        portENTER_CRITICAL(&g_mux);
+        const bool settled = g_stats.ffat_usage_updates == before;
+        if (settled || attempt == 2) {
+            g_stats.ffat_used_bytes = used;
+            g_stats.ffat_total_bytes = total;
+            g_measured = total > 0;
+        }
+        portEXIT_CRITICAL(&g_mux);
+        if (settled) break;
+    }
+    vTaskDelete(nullptr);
+}
 #else
+static void detect_partitions() {
     g_stats.ffat_partition_present = false;
-#endif
 }
+#endif
 } // namespace
 
 void fs_health_init() {
@@ -34,15 +81,76 @@ void fs_health_init() {
     detect_partitions();
 }
 
-void fs_health_set_ffat_usage(uint32_t used_bytes, uint32_t total_bytes) {
+void fs_health_note_ffat_mounted() {
+#if defined(ARDUINO_ARCH_ESP32)
+    portENTER_CRITICAL(&g_mux);
     // Treat this as a one-way latch: once mounted, keep reporting mounted.
     g_stats.ffat_mounted = true;
-    g_stats.ffat_used_bytes = used_bytes;
-    g_stats.ffat_total_bytes = total_bytes;
+    const bool start = !g_reconcile_started;
+    g_reconcile_started = true;
+    portEXIT_CRITICAL(&g_mux);
+
+    if (start && xTaskCreate(reconcile_task_fn, "FsUsage", 3072, nullptr, tskIDLE_PRIORITY, nullptr) != pdPASS) {
+        // Stay without usage numbers rather than read the FAT on the caller's task.
+        g_reconcile_started = false;
+    }
+#endif
+}
+
+void fs_health_note_ffat_file(uint32_t old_bytes, uint32_t new_bytes) {
+#if defined(ARDUINO_ARCH_ESP32)
+    const int64_t delta = ((int64_t)clusters(new_bytes) - (int64_t)clusters(old_bytes))
+        * (int64_t)FS_HEALTH_FFAT_CLUSTER_BYTES;
+
+    portENTER_CRITICAL(&g_mux);
+    g_stats.ffat_usage_updates++;
+    if (g_measured && delta != 0) {
+        int64_t used = (int64_t)g_stats.ffat_used_bytes + delta;
+        if (used < 0) used = 0;
+        if (used > (int64_t)g_stats.ffat_total_bytes) used = g_stats.ffat_total_bytes;
+        g_stats.ffat_used_bytes = (uint32_t)used;
+    }
+    portEXIT_CRITICAL(&g_mux);
+#else
+    (void)old_bytes;
+    (void)new_bytes;
+#endif
+}
+
+uint32_t fs_health_ffat_file_size(const char* path) {
+#if defined(ARDUINO_ARCH_ESP32)
+    if (!FFat.exists(path)) return 0;
+    File f = FFat.open(path, FILE_READ);
+    if (!f) return 0;
+    const uint32_t sz = (uint32_t)f.size();
+    f.close();
+    return sz;
+#else
+    (void)path;
+    return 0;
+#endif
+}
+
+bool fs_health_ffat_remove(const char* path) {
+#if defined(ARDUINO_ARCH_ESP32)
+    const uint32_t sz = fs_health_ffat_file_size(path);
+    if (!FFat.remove(path)) return false;
+    fs_health_note_ffat_file(sz, 0);
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
 }
 
 void fs_health_get(FSHealthStats* out) {
     if (!g_inited) fs_health_init();
     if (!out) return;
+#if defined(ARDUINO_ARCH_ESP32)
+    portENTER_CRITICAL(&g_mux);
+    memcpy(out, &g_stats, sizeof(g_stats));
+    portEXIT_CRITICAL(&g_mux);
+#else
     memcpy(out, &g_stats, sizeof(g_stats));
+#endif
 }
@@ -12,20 +12,36 @@ extern "C" {
 // Design goals:
 // - /api/health must never mount/probe filesystems (avoid heap churn and latency)
 // - Filesystem availability/type is cached at boot (partition table)
-// - Usage numbers are only reported after some other subsystem has mounted the FS
-//   and provided totals via fs_health_set_ffat_usage().
+// - Usage is measured once, by a background task started when some subsystem
+//   first mounts FFat (the macros store does so at boot). From then on the
+//   stores that write FFat report each file's size change, so the cached
+//   numbers stay current without walking directories.
 
 typedef struct FSHealthStats {
     bool ffat_partition_present;
     bool ffat_mounted;
     uint32_t ffat_used_bytes;
-    uint32_t ffat_total_bytes;
+    uint32_t ffat_total_bytes;   // 0 until the background measurement has run
+    uint32_t ffat_usage_updates; // size changes applied since boot
 } FSHealthStats;
 
 void fs_health_init();
 
-// Called by subsystems that successfully mounted FFat.
-void fs_health_set_ffat_usage(uint32_t used_bytes, uint32_t total_bytes);
+// Called by subsystems that successfully mounted FFat. The first call starts
+// the one-time usage measurement (FS_HEALTH_RECONCILE_DELAY_MS later).
+void fs_health_note_ffat_mounted();
+
+// A file on FFat changed size: 0 -> n for a new file, n -> 0 for a removed
+// one. Both sizes are rounded up to FS_HEALTH_FFAT_CLUSTER_BYTES, as FAT
+// allocates whole clusters. A directory counts as a 1-byte file.
+void fs_health_note_ffat_file(uint32_t old_bytes, uint32_t new_bytes);
+
+// Size of a file on FFat (mounted by the caller), 0 when it does not exist.
+uint32_t fs_health_ffat_file_size(const char* path);
+
+// Removes a file from FFat and reports the space freed. False (nothing
+// reported) when the remove failed.
+bool fs_health_ffat_remove(const char* path);
 
 // Returns cached stats (always succeeds after fs_health_init()).
 void fs_health_get(FSHealthStats* out);
@@ -4,60 +4,139 @@
 
 #if HAS_MQTT
 
+#include "fnv1a.h"
 #include "mqtt_manager.h"
 #include "web_assets.h" // PROJECT_DISPLAY_NAME
 #include "../version.h" // FIRMWARE_VERSION
+#include "log_manager.h"
 #include <ArduinoJson.h>
+#include <Preferences.h>
 
 static bool publish_sensor_config(
     MqttManager &mqtt,
     const char *object_id,
     const char *name_suffix,
-    const char *value_template,
+    const char *field,
     const char *unit_of_measurement,
     const char *device_class,
     const char *state_class,
     const char *entity_category
 );
 
-void ha_discovery_publish_health(MqttManager &mqtt) {
+// Every discovery run walks this list once to hash the configs and, when they
+// changed (or HA asked), once more to publish them.
+static void publish_health_configs(MqttManager &mqtt) {
     // Notes:
-    // - Single JSON publish model: all entities share the same stat_t.
-    // - value_template extracts fields from the JSON payload.
+    // - Single JSON publish model: all entities share the same stat_t and a
+    //   value_template extracts their field from the JSON payload.
+    // - With MQTT_HEALTH_SPLIT_TOPICS each entity reads ~/health/<field> instead.
 
-    publish_sensor_config(mqtt, "uptime", "Uptime", "{{ value_json.uptime_seconds }}", "s", "duration", "measurement", "diagnostic");
-    publish_sensor_config(mqtt, "reset_reason", "Reset Reason", "{{ value_json.reset_reason }}", "", "", "", "diagnostic");
+    publish_sensor_config(mqtt, "uptime", "Uptime", "uptime_seconds", "s", "duration", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "reset_reason", "Reset Reason", "reset_reason", "", "", "", "diagnostic");
 
-    publish_sensor_config(mqtt, "cpu_usage", "CPU Usage", "{{ value_json.cpu_usage }}", "%", "", "measurement", "diagnostic");
-    publish_sensor_config(mqtt, "cpu_temperature", "Core Temp", "{{ value_json.cpu_temperature }}", "°C", "temperature", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "cpu_usage", "CPU Usage", "cpu_usage", "%", "", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "cpu_temperature", "Core Temp", "cpu_temperature", "°C", "temperature", "measurement", "diagnostic");
 
-    publish_sensor_config(mqtt, "heap_free", "Free Heap", "{{ value_json.heap_free }}", "B", "", "measurement", "diagnostic");
-    publish_sensor_config(mqtt, "heap_min", "Min Free Heap", "{{ value_json.heap_min }}", "B", "", "measurement", "diagnostic");
-    publish_sensor_config(mqtt, "heap_fragmentation", "Heap Fragmentation", "{{ value_json.heap_fragmentation }}", "%", "", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "heap_free", "Free Heap", "heap_free", "B", "", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "heap_min", "Min Free Heap", "heap_min", "B", "", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "heap_fragmentation", "Heap Fragmentation", "heap_fragmentation", "%", "", "measurement", "diagnostic");
 
-    publish_sensor_config(mqtt, "flash_used", "Flash Used", "{{ value_json.flash_used }}", "B", "", "measurement", "diagnostic");
-    publish_sensor_config(mqtt, "flash_total", "Flash Total", "{{ value_json.flash_total }}", "B", "", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "flash_used", "Flash Used", "flash_used", "B", "", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "flash_total", "Flash Total", "flash_total", "B", "", "measurement", "diagnostic");
 
-    publish_sensor_config(mqtt, "wifi_rssi", "WiFi RSSI", "{{ value_json.wifi_rssi }}", "dBm", "signal_strength", "measurement", "diagnostic");
+    publish_sensor_config(mqtt, "wifi_rssi", "WiFi RSSI", "wifi_rssi", "dBm", "signal_strength", "measurement", "diagnostic");
 
     // =====================================================================
     // USER-EXTEND: Add your own Home Assistant entities here
     // =====================================================================
     // To add new sensors (e.g. ambient temperature + humidity), you typically:
-    //   1) Add JSON fields to device_telemetry_fill_mqtt() in device_telemetry.cpp
-    //   2) Add matching discovery entries below (value_template must match keys)
+    //   1) Add JSON fields to fill_mqtt() in device_telemetry.cpp
+    //   2) Add matching discovery entries below (the field must match the JSON key)
     //
     // Example (commented out): External temperature/humidity
     // (These will show up under the normal Sensors category in Home Assistant.)
-    // publish_sensor_config(mqtt, "temperature", "Temperature", "{{ value_json.temperature }}", "°C", "temperature", "measurement", nullptr);
-    // publish_sensor_config(mqtt, "humidity", "Humidity", "{{ value_json.humidity }}", "%", "humidity", "measurement", nullptr);
+    // publish_sensor_config(mqtt, "temperature", "Temperature", "temperature", "°C", "temperature", "measurement", nullptr);
+    // publish_sensor_config(mqtt, "humidity", "Humidity", "humidity", "%", "humidity", "measurement", nullptr);
+}
+
+namespace {
+struct DiscoveryPass {
+    bool publish;     // false = only hash the configs
+    uint32_t hash;    // FNV-1a over topics and payloads
+    uint16_t failed;
+};
+
+// FNV-1a over whatever ArduinoJson serializes into it.
+class HashPrint : public Print {
+public:
+    explicit HashPrint(uint32_t &hash) : _hash(hash) {}
+    size_t write(uint8_t c) override {
+        _hash = fnv1a32_byte(_hash, c);
+        return 1;
+    }
+    using Print::write;
+
+private:
+    uint32_t &_hash;
+};
+} // namespace
+
+static DiscoveryPass g_pass = {true, 0, 0};
+
+static constexpr const char *kDiscoveryNamespace = "ha_disc";
+
+static uint32_t load_published_hash() {
+    Preferences prefs;
+    if (!prefs.begin(kDiscoveryNamespace, true)) return 0;
+    const uint32_t hash = prefs.getUInt("hash", 0);
+    prefs.end();
+    return hash;
+}
+
+static void store_published_hash(uint32_t hash) {
+    Preferences prefs;
+    if (!prefs.begin(kDiscoveryNamespace, false)) return;
+    prefs.putUInt("hash", hash);
+    prefs.end();
+}
+
+bool ha_discovery_publish_health(MqttManager &mqtt, bool force) {
+#if MQTT_DISCOVERY_SKIP_UNCHANGED
+    // The broker is part of the hash: a new broker has none of our retained configs.
+    g_pass = {false, kFnv1a32Init, 0};
+    {
+        HashPrint h(g_pass.hash);
+        h.print(mqtt.brokerHost());
+        h.print(':');
+        h.print(mqtt.brokerPort());
+    }
+    publish_health_configs(mqtt);
+    const uint32_t hash = g_pass.hash | 1u;  // 0 = nothing stored
+
+    if (!force && hash == load_published_hash()) {
+        Logger.logMessage("MQTT", "HA discovery unchanged; skipped");
+        return true;
+    }
+#endif
+
+    g_pass = {true, 0, 0};
+    publish_health_configs(mqtt);
+    if (g_pass.failed) {
+        Logger.logMessagef("MQTT", "HA discovery: %u config(s) failed", (unsigned)g_pass.failed);
+        return false;
+    }
+
+#if MQTT_DISCOVERY_SKIP_UNCHANGED
+    store_published_hash(hash);
+#endif
+    return true;
 }
 
 static bool publish_sensor_config(
     MqttManager &mqtt,
     const char *object_id,
     const char *name_suffix,
-    const char *value_template,
+    const char *field,
     const char *unit_of_measurement,
     const char *device_class,
     const char *state_class,
@@ -91,8 +170,16 @@ static bool publish_sensor_config(
     snprintf(uniq_id, sizeof(uniq_id), "%s_%s", mqtt.sanitizedName(), object_id);
     doc["uniq_id"] = uniq_id;
 
+#if MQTT_HEALTH_SPLIT_TOPICS
+    char state_topic[64];
+    snprintf(state_topic, sizeof(state_topic), "~/health/%s", field);
+    doc["stat_t"] = state_topic;
+#else
+    char value_template[64];
+    snprintf(value_template, sizeof(value_template), "{{ value_json.%s }}", field);
     doc["stat_t"] = "~/health/state";
     doc["val_tpl"] = value_template;
+#endif
 
     // Availability
     doc["avty_t"] = "~/availability";
@@ -119,11 +206,21 @@ static bool publish_sensor_config(
 
     if (doc.overflowed()) {
         // Payload too large for this StaticJsonDocument size.
-        // mqtt.publishJson() will also fail if serialization exceeds MQTT_MAX_PACKET_SIZE.
+        g_pass.failed++;
         return false;
     }
 
-    return mqtt.publishJson(topic, doc, true);
+    if (!g_pass.publish) {
+        HashPrint h(g_pass.hash);
+        h.print(topic);
+        serializeJson(doc, h);
+        return true;
+    }
+
+    // Streamed: only the document, not MQTT_MAX_PACKET_SIZE, bounds the config.
+    const bool ok = mqtt.publishJsonStreamed(topic, doc, true);
+    if (!ok) g_pass.failed++;
+    return ok;
 }
 
 #endif // HAS_MQTT
@@ -8,9 +8,15 @@
 
 class MqttManager;
 
+// Topic Home Assistant announces itself on ("online" after it or the broker restarts).
+#define HA_DISCOVERY_STATUS_TOPIC "homeassistant/status"
+
 // Publish Home Assistant MQTT discovery configuration for the health sensors.
-// Intended to be called once per boot after MQTT connects.
-void ha_discovery_publish_health(MqttManager &mqtt);
+// Intended to be called on the MQTT client task once per boot after MQTT connects.
+// With MQTT_DISCOVERY_SKIP_UNCHANGED nothing is sent when the configs hash to
+// the value stored in NVS after the last complete publish (force = send anyway).
+// Returns false when a config could not be published.
+bool ha_discovery_publish_health(MqttManager &mqtt, bool force);
 
 #endif // HAS_MQTT
 
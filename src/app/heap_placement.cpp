@@ -0,0 +1,179 @@
+#include "heap_placement.h"
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <soc/soc_caps.h>
+#include <string.h>
+
+namespace {
+
+enum class Heap : uint8_t {
+    None,
+    Dma,
+    Internal,
+    Psram,
+};
+
+// Transient blocks up to this size ignore the internal reserve: they are
+// gone again before they could matter.
+constexpr size_t kSmallBlockBytes = 1024;
+
+constexpr size_t kClasses = (size_t)HeapClass::Count;
+
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+HeapPlaceStats g_stats[kClasses] = {};
+
+int order_for(HeapClass cls) {
+    switch (cls) {
+        case HeapClass::Dma: return HEAP_PLACE_DMA;
+        case HeapClass::Latency: return HEAP_PLACE_LATENCY;
+        case HeapClass::Bulk: return HEAP_PLACE_BULK;
+        case HeapClass::Transient:
+        default: return HEAP_PLACE_TRANSIENT;
+    }
+}
+
+// The heaps to try, in order (unused entries are None).
+void heaps_for(HeapClass cls, Heap out[3]) {
+    out[0] = out[1] = out[2] = Heap::None;
+    switch (order_for(cls)) {
+        case HEAP_ORDER_INTERNAL:
+            out[0] = Heap::Internal;
+            break;
+        case HEAP_ORDER_INTERNAL_PSRAM:
+            out[0] = Heap::Internal;
+            out[1] = Heap::Psram;
+            break;
+        case HEAP_ORDER_DMA_INTERNAL_PSRAM:
+            out[0] = Heap::Dma;
+            out[1] = Heap::Internal;
+            out[2] = Heap::Psram;
+            break;
+        case HEAP_ORDER_PSRAM_INTERNAL:
+        default:
+            out[0] = Heap::Psram;
+            out[1] = Heap::Internal;
+            break;
+    }
+}
+
+bool has_psram() {
+#if SOC_SPIRAM_SUPPORTED
+    static int8_t found = -1;
+    if (found < 0) found = psramFound() ? 1 : 0;
+    return found == 1;
+#else
+    return false;
+#endif
+}
+
+uint32_t caps_for(Heap heap) {
+    switch (heap) {
+        case Heap::Dma: return MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT;
+        case Heap::Psram: return MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+        case Heap::Internal:
+        default:
+            // Without PSRAM every 8-bit region is internal; INTERNAL would
+            // leave some of them out.
+            return has_psram() ? (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) : MALLOC_CAP_8BIT;
+    }
+}
+
+// False when this heap must be skipped for the request.
+bool usable(HeapClass cls, Heap heap, size_t size, bool* reserve_refused) {
+    if (heap == Heap::None) return false;
+    if (heap == Heap::Psram) return has_psram();
+    if (cls != HeapClass::Transient || !has_psram() || size <= kSmallBlockBytes) return true;
+    if (HEAP_PLACE_TRANSIENT_INTERNAL_RESERVE_BYTES == 0) return true;
+
+    const size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (free_internal >= size + (size_t)HEAP_PLACE_TRANSIENT_INTERNAL_RESERVE_BYTES) return true;
+    *reserve_refused = true;
+    return false;
+}
+
+void note(HeapClass cls, bool ok, bool fallback, bool reserve_refused) {
+    HeapPlaceStats& s = g_stats[(size_t)cls < kClasses ? (size_t)cls : (size_t)HeapClass::Transient];
+    portENTER_CRITICAL(&g_mux);
+    if (ok) {
+        s.allocs++;
+        if (fallback) s.fallbacks++;
+    } else {
+        s.failed++;
+    }
+    if (reserve_refused) s.reserve_refusals++;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+} // namespace
+
+const char* heap_class_name(HeapClass cls) {
+    switch (cls) {
+        case HeapClass::Dma: return "dma";
+        case HeapClass::Latency: return "latency";
+        case HeapClass::Bulk: return "bulk";
+        case HeapClass::Transient:
+        default: return "transient";
+    }
+}
+
+void* heap_place_malloc(HeapClass cls, HeapTag tag, size_t size) {
+    if (size == 0) return nullptr;
+
+    Heap heaps[3];
+    heaps_for(cls, heaps);
+    bool reserve_refused = false;
+    bool tried = false;
+    for (size_t i = 0; i < 3; i++) {
+        if (!usable(cls, heaps[i], size, &reserve_refused)) continue;
+        void* p = heap_tag_malloc(tag, size, caps_for(heaps[i]));
+        if (p) {
+            note(cls, true, tried, reserve_refused);
+            return p;
+        }
+        tried = true;
+    }
+    note(cls, false, false, reserve_refused);
+    return nullptr;
+}
+
+void* heap_place_calloc(HeapClass cls, HeapTag tag, size_t n, size_t size) {
+    if (n && size > SIZE_MAX / n) return nullptr;
+    const size_t bytes = n * size;
+    void* p = heap_place_malloc(cls, tag, bytes);
+    if (p) memset(p, 0, bytes);
+    return p;
+}
+
+void* heap_place_realloc(HeapClass cls, HeapTag tag, void* ptr, size_t size) {
+    if (!ptr) return heap_place_malloc(cls, tag, size);
+    if (size == 0) {
+        heap_tag_free(tag, ptr);
+        return nullptr;
+    }
+
+    Heap heaps[3];
+    heaps_for(cls, heaps);
+    bool reserve_refused = false;
+    bool tried = false;
+    for (size_t i = 0; i < 3; i++) {
+        if (!usable(cls, heaps[i], size, &reserve_refused)) continue;
+        // Resizes in place when the block already sits in a matching heap,
+        // else moves it; the old block survives a failure.
+        void* p = heap_tag_realloc(tag, ptr, size, caps_for(heaps[i]));
+        if (p) {
+            note(cls, true, tried, reserve_refused);
+            return p;
+        }
+        tried = true;
+    }
+    note(cls, false, false, reserve_refused);
+    return nullptr;
+}
+
+void heap_place_get_stats(HeapClass cls, HeapPlaceStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_mux);
+    *out = g_stats[(size_t)cls < kClasses ? (size_t)cls : (size_t)HeapClass::Transient];
+    portEXIT_CRITICAL(&g_mux);
+}
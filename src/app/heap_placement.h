@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+ * Heap placement policy.
+ *
+ * Callers say what kind of block they need; the board decides which heaps
+ * serve that kind and in what order (HEAP_PLACE_* in board_config.h). One
+ * table replaces the PSRAM-first / internal-first fallbacks each subsystem
+ * used to carry, so a board tunes placement in one place.
+ *
+ *   Dma        read by a peripheral (panel flush and swap buffers)
+ *   Latency    touched on hot paths where PSRAM would slow things down
+ *   Bulk       large or long-lived (LVGL objects, draw buffers, icons, pools)
+ *   Transient  lives for one request or job (bodies, JSON, uploads, decoder
+ *              and OTA buffers); refusing it is an error the caller reports
+ *
+ * On boards with PSRAM, a Transient block over 1 KB only falls back to
+ * internal RAM while that leaves HEAP_PLACE_TRANSIENT_INTERNAL_RESERVE_BYTES
+ * free, so a burst of uploads cannot starve WiFi and TLS.
+ *
+ * Blocks are charged to tag like heap_tag_malloc() and are freed with
+ * heap_tag_free() and the same tag.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_config.h"
+#include "heap_tags.h"
+
+enum class HeapClass : uint8_t {
+    Dma,
+    Latency,
+    Bulk,
+    Transient,
+    Count
+};
+
+const char* heap_class_name(HeapClass cls);
+
+void* heap_place_malloc(HeapClass cls, HeapTag tag, size_t size);
+void* heap_place_calloc(HeapClass cls, HeapTag tag, size_t n, size_t size);
+void* heap_place_realloc(HeapClass cls, HeapTag tag, void* ptr, size_t size);
+
+struct HeapPlaceStats {
+    uint32_t allocs;           // served
+    uint32_t fallbacks;        // served by a heap after the first in the order
+    uint32_t reserve_refusals; // internal fallback skipped to keep the reserve
+    uint32_t failed;           // no heap in the order could serve it
+};
+
+void heap_place_get_stats(HeapClass cls, HeapPlaceStats* out);
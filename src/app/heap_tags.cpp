@@ -0,0 +1,232 @@
+#include "heap_tags.h"
+
+#include "static_alloc.h"
+
+#include <esp_memory_utils.h>
+#include <freertos/FreeRTOS.h>
+#include <stdio.h>
+#include <string.h>
+
+const char* heap_tag_name(HeapTag tag) {
+    switch (tag) {
+        case HeapTag::Lvgl: return "lvgl";
+        case HeapTag::Image: return "image";
+        case HeapTag::Json: return "json";
+        case HeapTag::Icons: return "icons";
+        case HeapTag::Ota: return "ota";
+        case HeapTag::Display: return "display";
+        case HeapTag::Http: return "http";
+        case HeapTag::Other:
+        default: return "other";
+    }
+}
+
+const char* heap_kind_name(HeapKind kind) {
+    switch (kind) {
+        case HeapKind::Internal: return "internal";
+        case HeapKind::Psram: return "psram";
+        case HeapKind::Dma:
+        default: return "dma";
+    }
+}
+
+#if HEAP_TAGS_ENABLED
+
+namespace {
+
+constexpr size_t kTags = (size_t)HeapTag::Count;
+constexpr size_t kKinds = (size_t)HeapKind::Count;
+
+// Internal RAM is DMA-capable either way on these chips, so a DMA block can
+// only be told apart by remembering it. They are few (panel buffers).
+constexpr size_t kDmaSlots = 16;
+
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+HeapTagStats g_stats[kTags][kKinds] = {};
+void* g_dma_blocks[kDmaSlots] = {};
+
+size_t tag_index(HeapTag tag) {
+    const size_t i = (size_t)tag;
+    return i < kTags ? i : (size_t)HeapTag::Other;
+}
+
+HeapKind requested_kind(uint32_t caps) {
+    if (caps & MALLOC_CAP_SPIRAM) return HeapKind::Psram;
+    if (caps & MALLOC_CAP_DMA) return HeapKind::Dma;
+    return HeapKind::Internal;
+}
+
+// Caller holds g_mux.
+HeapKind kind_of_locked(void* ptr, bool forget) {
+    if (esp_ptr_external_ram(ptr)) return HeapKind::Psram;
+    for (void*& slot : g_dma_blocks) {
+        if (slot == ptr) {
+            if (forget) slot = nullptr;
+            return HeapKind::Dma;
+        }
+    }
+    return HeapKind::Internal;
+}
+
+void charge(HeapTag tag, void* ptr, uint32_t caps) {
+    const size_t bytes = heap_caps_get_allocated_size(ptr);
+    portENTER_CRITICAL(&g_mux);
+    HeapKind kind = esp_ptr_external_ram(ptr) ? HeapKind::Psram : HeapKind::Internal;
+    if (kind == HeapKind::Internal && (caps & MALLOC_CAP_DMA)) {
+        for (void*& slot : g_dma_blocks) {
+            if (!slot) {
+                slot = ptr;
+                kind = HeapKind::Dma;
+                break;
+            }
+        }
+    }
+    HeapTagStats& s = g_stats[tag_index(tag)][(size_t)kind];
+    s.live_bytes += (uint32_t)bytes;
+    if (s.live_bytes > s.peak_bytes) s.peak_bytes = s.live_bytes;
+    s.live_blocks++;
+    s.allocs++;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void discharge(HeapTag tag, void* ptr) {
+    const size_t bytes = heap_caps_get_allocated_size(ptr);
+    portENTER_CRITICAL(&g_mux);
+    HeapTagStats& s = g_stats[tag_index(tag)][(size_t)kind_of_locked(ptr, true)];
+    s.live_bytes = (s.live_bytes > bytes) ? s.live_bytes - (uint32_t)bytes : 0;
+    if (s.live_blocks) s.live_blocks--;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void note_failed(HeapTag tag, uint32_t caps) {
+    portENTER_CRITICAL(&g_mux);
+    g_stats[tag_index(tag)][(size_t)requested_kind(caps)].failed++;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+} // namespace
+
+void* heap_tag_malloc(HeapTag tag, size_t size, uint32_t caps) {
+#if STATIC_ALLOC_MODE
+    // Arena blocks are not heap allocations: not charged.
+    if (void* a = static_alloc_arena_malloc(tag, size, caps)) return a;
+#endif
+    void* p = heap_caps_malloc(size, caps);
+    if (p) {
+        charge(tag, p, caps);
+    } else if (size) {
+        note_failed(tag, caps);
+    }
+    return p;
+}
+
+void* heap_tag_calloc(HeapTag tag, size_t n, size_t size, uint32_t caps) {
+#if STATIC_ALLOC_MODE
+    if (n && size <= SIZE_MAX / n) {
+        if (void* a = static_alloc_arena_malloc(tag, n * size, caps)) {
+            memset(a, 0, n * size);
+            return a;
+        }
+    }
+#endif
+    void* p = heap_caps_calloc(n, size, caps);
+    if (p) {
+        charge(tag, p, caps);
+    } else if (n && size) {
+        note_failed(tag, caps);
+    }
+    return p;
+}
+
+void* heap_tag_aligned_alloc(HeapTag tag, size_t alignment, size_t size, uint32_t caps) {
+#if STATIC_ALLOC_MODE
+    if (void* a = static_alloc_arena_aligned_alloc(tag, alignment, size, caps)) return a;
+#endif
+    void* p = heap_caps_aligned_alloc(alignment, size, caps);
+    if (p) {
+        charge(tag, p, caps);
+    } else if (size) {
+        note_failed(tag, caps);
+    }
+    return p;
+}
+
+void* heap_tag_realloc(HeapTag tag, void* ptr, size_t size, uint32_t caps) {
+    if (!ptr) return heap_tag_malloc(tag, size, caps);
+    if (size == 0) {
+        heap_tag_free(tag, ptr);
+        return nullptr;
+    }
+
+#if STATIC_ALLOC_MODE
+    if (static_alloc_owns(ptr)) {
+        if (void* a = static_alloc_arena_realloc(ptr, size)) return a;
+        // Does not fit the arena any more: move it wherever heap_tag_malloc can.
+        void* p = heap_tag_malloc(tag, size, caps);
+        if (!p) return nullptr;
+        const size_t old_size = static_alloc_block_size(ptr);
+        memcpy(p, ptr, old_size < size ? old_size : size);
+        static_alloc_arena_free(ptr);
+        return p;
+    }
+#endif
+
+    // The old block is gone once realloc succeeds, so take its size first.
+    const size_t old_bytes = heap_caps_get_allocated_size(ptr);
+    portENTER_CRITICAL(&g_mux);
+    const HeapKind old_kind = kind_of_locked(ptr, false);
+    portEXIT_CRITICAL(&g_mux);
+
+    void* p = heap_caps_realloc(ptr, size, caps);
+    if (!p) {
+        note_failed(tag, caps);
+        return nullptr;
+    }
+
+    portENTER_CRITICAL(&g_mux);
+    if (old_kind == HeapKind::Dma) kind_of_locked(ptr, true);
+    HeapTagStats& s = g_stats[tag_index(tag)][(size_t)old_kind];
+    s.live_bytes = (s.live_bytes > old_bytes) ? s.live_bytes - (uint32_t)old_bytes : 0;
+    if (s.live_blocks) s.live_blocks--;
+    // A resize is not a new allocation for the counters.
+    if (s.allocs) s.allocs--;
+    portEXIT_CRITICAL(&g_mux);
+    charge(tag, p, caps);
+    return p;
+}
+
+void heap_tag_free(HeapTag tag, void* ptr) {
+    if (!ptr) return;
+#if STATIC_ALLOC_MODE
+    if (static_alloc_owns(ptr)) {
+        static_alloc_arena_free(ptr);
+        return;
+    }
+#endif
+    discharge(tag, ptr);
+    heap_caps_free(ptr);
+}
+
+void heap_tag_get_stats(HeapTag tag, HeapTagStats out[(size_t)HeapKind::Count]) {
+    portENTER_CRITICAL(&g_mux);
+    memcpy(out, g_stats[tag_index(tag)], sizeof(HeapTagStats) * kKinds);
+    portEXIT_CRITICAL(&g_mux);
+}
+
+size_t heap_tag_format_live(HeapKind kind, char* out, size_t out_len) {
+    if (!out || out_len == 0) return 0;
+    out[0] = '\0';
+    size_t len = 0;
+    for (size_t t = 0; t < kTags; t++) {
+        HeapTagStats s[kKinds];
+        heap_tag_get_stats((HeapTag)t, s);
+        const uint32_t live = s[(size_t)kind].live_bytes;
+        if (!live) continue;
+        const int n = snprintf(out + len, out_len - len, "%s%s=%lu", len ? " " : "", heap_tag_name((HeapTag)t), (unsigned long)live);
+        if (n < 0 || (size_t)n >= out_len - len) break;
+        len += (size_t)n;
+    }
+    return len;
+}
+
+#endif // HEAP_TAGS_ENABLED
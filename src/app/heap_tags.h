@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+ * Tagged heap accounting (HEAP_TAGS_ENABLED).
+ *
+ * Thin wrappers over heap_caps_malloc/realloc/free that charge each block to
+ * the subsystem that owns it. Per tag and per heap (internal, PSRAM, and
+ * internal blocks requested with MALLOC_CAP_DMA) they keep live bytes, peak
+ * live bytes, live blocks and allocations. Sizes are what the allocator
+ * actually reserved (heap_caps_get_allocated_size).
+ *
+ * A block must be freed with the tag it was allocated with. Reported in
+ * /api/health (heap_tags) and in the memory snapshot log lines.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_heap_caps.h>
+
+#include "board_config.h"
+
+enum class HeapTag : uint8_t {
+    Lvgl,       // LVGL's allocator (objects, styles, image cache)
+    Image,      // image API: upload buffers, decoders, frame buffers, pool
+    Json,       // ArduinoJson documents (MacrosJsonAllocator), streamed JSON
+    Icons,      // icon store, atlas, warm-up cache
+    Ota,        // firmware download ring, gzip and delta state
+    Display,    // driver and flush buffers
+    Http,       // request bodies
+    Other,
+    Count
+};
+
+enum class HeapKind : uint8_t {
+    Internal,
+    Psram,
+    Dma,
+    Count
+};
+
+struct HeapTagStats {
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    uint32_t live_blocks;
+    uint32_t allocs;
+    uint32_t failed;        // requests this heap could not satisfy
+};
+
+const char* heap_tag_name(HeapTag tag);
+const char* heap_kind_name(HeapKind kind);
+
+#if HEAP_TAGS_ENABLED
+
+void* heap_tag_malloc(HeapTag tag, size_t size, uint32_t caps);
+void* heap_tag_calloc(HeapTag tag, size_t n, size_t size, uint32_t caps);
+void* heap_tag_realloc(HeapTag tag, void* ptr, size_t size, uint32_t caps);
+void* heap_tag_aligned_alloc(HeapTag tag, size_t alignment, size_t size, uint32_t caps);
+void heap_tag_free(HeapTag tag, void* ptr);
+
+// Copy one tag's counters (all heaps).
+void heap_tag_get_stats(HeapTag tag, HeapTagStats out[(size_t)HeapKind::Count]);
+
+// "lvgl=41200 image=153600 ..." for the tags holding live bytes in kind.
+// Returns the length written.
+size_t heap_tag_format_live(HeapKind kind, char* out, size_t out_len);
+
+#else
+
+inline void* heap_tag_malloc(HeapTag, size_t size, uint32_t caps) { return heap_caps_malloc(size, caps); }
+inline void* heap_tag_calloc(HeapTag, size_t n, size_t size, uint32_t caps) { return heap_caps_calloc(n, size, caps); }
+inline void* heap_tag_realloc(HeapTag, void* ptr, size_t size, uint32_t caps) { return heap_caps_realloc(ptr, size, caps); }
+inline void* heap_tag_aligned_alloc(HeapTag, size_t alignment, size_t size, uint32_t caps) { return heap_caps_aligned_alloc(alignment, size, caps); }
+inline void heap_tag_free(HeapTag, void* ptr) { heap_caps_free(ptr); }
+
+#endif // HEAP_TAGS_ENABLED
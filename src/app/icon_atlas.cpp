@@ -0,0 +1,535 @@
+/*
+ * Icon Atlas Implementation
+ */
+
+#include "icon_atlas.h"
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_STORE_ATLAS
+
+#include "fs_health.h"
+
+#include <Arduino.h>
+#include <FFat.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// Compact once dead (replaced/removed) payload bytes exceed this and the live data.
+#ifndef ICON_STORE_ATLAS_COMPACT_BYTES
+#define ICON_STORE_ATLAS_COMPACT_BYTES (64 * 1024)
+#endif
+
+namespace {
+
+static const char* kAtlasPath = "/icons.atlas";
+static const char* kAtlasTmpPath = "/icons.atlas.tmp";
+
+static constexpr uint32_t kHeaderBytes = 16;
+static constexpr size_t kCopyChunkBytes = 4096;
+
+// On-disk index entry; the ESP32 is little-endian, so it is read and written as is.
+struct AtlasEntry {
+    char id[32];
+    uint32_t offset;
+    uint32_t data_len;
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;
+    uint8_t encoding;
+    uint16_t palette_count;
+};
+static_assert(sizeof(AtlasEntry) == 48, "atlas index entry layout");
+
+// RAM copy of the index. Readers take the lock; writers are serialised by the
+// icon operation lock and only take this one to swap the index.
+static AtlasEntry* g_index = nullptr;
+static uint32_t g_count = 0;
+static uint32_t g_file_bytes = 0;
+static uint32_t g_live_bytes = 0;
+static uint32_t g_compactions = 0;
+static bool g_present = false;
+static bool g_loaded = false;
+
+static SemaphoreHandle_t atlas_mutex() {
+    static SemaphoreHandle_t m = xSemaphoreCreateMutex();
+    return m;
+}
+
+struct AtlasLock {
+    AtlasLock() { xSemaphoreTake(atlas_mutex(), portMAX_DELAY); }
+    ~AtlasLock() { xSemaphoreGive(atlas_mutex()); }
+};
+
+static void set_err(char* err, size_t err_len, const char* msg) {
+    if (!err || err_len == 0) return;
+    strlcpy(err, msg ? msg : "", err_len);
+}
+
+static uint32_t align4(uint32_t v) {
+    return (v + 3u) & ~3u;
+}
+
+static AtlasEntry* alloc_index(size_t count) {
+    const size_t bytes = (count ? count : 1) * sizeof(AtlasEntry);
+    AtlasEntry* p = nullptr;
+#if SOC_SPIRAM_SUPPORTED
+    if (psramFound()) {
+        p = (AtlasEntry*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+#endif
+    if (!p) p = (AtlasEntry*)malloc(bytes);
+    return p;
+}
+
+// Lower bound of id in a sorted index.
+static uint32_t index_find(const AtlasEntry* index, uint32_t count, const char* id, bool* found) {
+    uint32_t lo = 0;
+    uint32_t hi = count;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (strncmp(index[mid].id, id, sizeof(index[mid].id)) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    *found = lo < count && strncmp(index[lo].id, id, sizeof(index[lo].id)) == 0;
+    return lo;
+}
+
+// Insert or replace; the index must have room for one more entry.
+static void index_upsert(AtlasEntry* index, uint32_t* count, const AtlasEntry& e) {
+    bool found = false;
+    const uint32_t pos = index_find(index, *count, e.id, &found);
+    if (!found) {
+        memmove(&index[pos + 1], &index[pos], (size_t)(*count - pos) * sizeof(AtlasEntry));
+        (*count)++;
+    }
+    index[pos] = e;
+}
+
+static void set_index_locked(AtlasEntry* index, uint32_t count, uint32_t file_bytes) {
+    free(g_index);
+    g_index = index;
+    g_count = count;
+    g_file_bytes = file_bytes;
+    g_present = true;
+
+    g_live_bytes = 0;
+    for (uint32_t i = 0; i < count; i++) g_live_bytes += index[i].data_len;
+}
+
+static void clear_index_locked() {
+    free(g_index);
+    g_index = nullptr;
+    g_count = 0;
+    g_file_bytes = 0;
+    g_live_bytes = 0;
+    g_present = false;
+}
+
+static void pack_header(uint8_t* hdr, uint32_t count, uint32_t index_off) {
+    memset(hdr, 0, kHeaderBytes);
+    memcpy(hdr, "ICA1", 4);
+    memcpy(hdr + 4, &count, 4);
+    memcpy(hdr + 8, &index_off, 4);
+}
+
+static bool read_atlas(AtlasEntry** out_index, uint32_t* out_count, uint32_t* out_file_bytes) {
+    File f = FFat.open(kAtlasPath, "r");
+    if (!f) return false;
+
+    const uint32_t file_bytes = (uint32_t)f.size();
+    uint8_t hdr[kHeaderBytes];
+    if (file_bytes < kHeaderBytes || f.read(hdr, sizeof(hdr)) != sizeof(hdr) || memcmp(hdr, "ICA1", 4) != 0) {
+        f.close();
+        return false;
+    }
+
+    uint32_t count = 0;
+    uint32_t index_off = 0;
+    memcpy(&count, hdr + 4, 4);
+    memcpy(&index_off, hdr + 8, 4);
+    if (index_off < kHeaderBytes || (uint64_t)index_off + (uint64_t)count * sizeof(AtlasEntry) > file_bytes) {
+        f.close();
+        return false;
+    }
+
+    AtlasEntry* index = alloc_index(count);
+    if (!index) {
+        f.close();
+        return false;
+    }
+
+    const size_t index_bytes = (size_t)count * sizeof(AtlasEntry);
+    bool ok = count == 0 || (f.seek(index_off) && f.read((uint8_t*)index, index_bytes) == index_bytes);
+    f.close();
+
+    // Reject an index that points outside the payload area.
+    for (uint32_t i = 0; ok && i < count; i++) {
+        AtlasEntry& e = index[i];
+        e.id[sizeof(e.id) - 1] = '\0';
+        if (e.format == 0) e.format = 1;
+        const bool raw_rgb565a8 = e.format == 1 && e.encoding == 0;
+        ok = e.offset >= kHeaderBytes
+            && (uint64_t)e.offset + e.data_len <= index_off
+            && (!raw_rgb565a8 || e.data_len == (uint32_t)e.width * (uint32_t)e.height * 3u);
+    }
+    if (!ok) {
+        free(index);
+        return false;
+    }
+
+    *out_index = index;
+    *out_count = count;
+    *out_file_bytes = file_bytes;
+    return true;
+}
+
+static void ensure_loaded_locked() {
+    if (g_loaded) return;
+    g_loaded = true;
+
+    // A compaction interrupted between remove and rename leaves only the new file;
+    // one interrupted earlier leaves a partial one next to the intact atlas.
+    if (FFat.exists(kAtlasTmpPath)) {
+        if (FFat.exists(kAtlasPath)) {
+            File tmp = FFat.open(kAtlasTmpPath, "r");
+            const uint32_t tmp_bytes = tmp ? (uint32_t)tmp.size() : 0;
+            if (tmp) tmp.close();
+            if (FFat.remove(kAtlasTmpPath)) fs_health_note_ffat_file(tmp_bytes, 0);
+        } else {
+            FFat.rename(kAtlasTmpPath, kAtlasPath);
+        }
+    }
+
+    AtlasEntry* index = nullptr;
+    uint32_t count = 0;
+    uint32_t file_bytes = 0;
+    if (read_atlas(&index, &count, &file_bytes)) {
+        set_index_locked(index, count, file_bytes);
+    }
+}
+
+static bool write_all(File& f, const void* data, size_t len) {
+    return f.write((const uint8_t*)data, len) == len;
+}
+
+static bool pad_to(File& f, uint32_t* pos, uint32_t target) {
+    static const uint8_t zeros[4] = {0, 0, 0, 0};
+    if (target <= *pos) return true;
+    const size_t n = (size_t)(target - *pos);
+    if (!write_all(f, zeros, n)) return false;
+    *pos = target;
+    return true;
+}
+
+// Write the index at the next aligned position after pos, then point the header at it.
+static bool commit_index(File& f, uint32_t pos, const AtlasEntry* index, uint32_t count, uint32_t* out_file_bytes) {
+    const uint32_t index_off = align4(pos);
+    if (!f.seek(pos) || !pad_to(f, &pos, index_off)) return false;
+    if (count && !write_all(f, index, (size_t)count * sizeof(AtlasEntry))) return false;
+    f.flush();
+
+    uint8_t hdr[kHeaderBytes];
+    pack_header(hdr, count, index_off);
+    if (!f.seek(0) || !write_all(f, hdr, sizeof(hdr))) return false;
+
+    *out_file_bytes = index_off + count * (uint32_t)sizeof(AtlasEntry);
+    return true;
+}
+
+static bool compact(char* err, size_t err_len) {
+    AtlasEntry* index = alloc_index(g_count);
+    uint8_t* chunk = (uint8_t*)malloc(kCopyChunkBytes);
+    if (!index || !chunk) {
+        free(index);
+        free(chunk);
+        set_err(err, err_len, "Out of memory");
+        return false;
+    }
+
+    File src = FFat.open(kAtlasPath, "r");
+    File dst = FFat.open(kAtlasTmpPath, "w");
+    bool ok = src && dst;
+
+    uint8_t hdr[kHeaderBytes];
+    pack_header(hdr, 0, kHeaderBytes);
+    ok = ok && write_all(dst, hdr, sizeof(hdr));
+
+    uint32_t pos = kHeaderBytes;
+    for (uint32_t i = 0; ok && i < g_count; i++) {
+        AtlasEntry e = g_index[i];
+        ok = pad_to(dst, &pos, align4(pos)) && src.seek(e.offset);
+
+        uint32_t left = e.data_len;
+        e.offset = pos;
+        while (ok && left > 0) {
+            const size_t n = left < kCopyChunkBytes ? left : kCopyChunkBytes;
+            ok = src.read(chunk, n) == n && write_all(dst, chunk, n);
+            left -= (uint32_t)n;
+        }
+        pos += e.data_len;
+        index[i] = e;
+    }
+
+    uint32_t file_bytes = 0;
+    ok = ok && commit_index(dst, pos, index, g_count, &file_bytes);
+
+    const uint32_t src_bytes = src ? (uint32_t)src.size() : 0;
+    const uint32_t dst_bytes = dst ? (uint32_t)dst.size() : 0;
+    if (src) src.close();
+    if (dst) dst.close();
+    free(chunk);
+
+    if (!ok) {
+        free(index);
+        FFat.remove(kAtlasTmpPath);
+        set_err(err, err_len, "Icon atlas compaction failed");
+        return false;
+    }
+
+    // Readers hold the lock while they have the atlas open.
+    AtlasLock lock;
+    if (!FFat.remove(kAtlasPath) || !FFat.rename(kAtlasTmpPath, kAtlasPath)) {
+        free(index);
+        // Drop the index; the next lookup recovers from whichever file survived.
+        clear_index_locked();
+        g_loaded = false;
+        set_err(err, err_len, "Icon atlas rename failed");
+        return false;
+    }
+    set_index_locked(index, g_count, file_bytes);
+    g_compactions++;
+    fs_health_note_ffat_file(src_bytes, dst_bytes);
+    return true;
+}
+
+static void compact_if_needed() {
+    const uint32_t used = kHeaderBytes + g_live_bytes + g_count * (uint32_t)sizeof(AtlasEntry);
+    const uint32_t dead = g_file_bytes > used ? g_file_bytes - used : 0;
+    if (dead <= (uint32_t)ICON_STORE_ATLAS_COMPACT_BYTES || dead <= g_live_bytes) return;
+
+    // Best-effort: on failure the atlas keeps its dead space.
+    compact(nullptr, 0);
+}
+
+} // namespace
+
+bool icon_atlas_find(const char* id, IconAtlasItem* out) {
+    if (!id || !*id || !out) return false;
+
+    AtlasLock lock;
+    ensure_loaded_locked();
+
+    bool found = false;
+    const uint32_t pos = index_find(g_index, g_count, id, &found);
+    if (!found) return false;
+
+    const AtlasEntry& e = g_index[pos];
+    memset(out, 0, sizeof(*out));
+    out->width = e.width;
+    out->height = e.height;
+    out->format = e.format;
+    out->encoding = e.encoding;
+    out->palette_count = e.palette_count;
+    out->data_len = e.data_len;
+    return true;
+}
+
+bool icon_atlas_read(const char* id, uint8_t* dst, uint32_t data_len) {
+    if (!id || !*id || !dst) return false;
+
+    AtlasLock lock;
+    ensure_loaded_locked();
+
+    bool found = false;
+    const uint32_t pos = index_find(g_index, g_count, id, &found);
+    if (!found || g_index[pos].data_len != data_len) return false;
+
+    File f = FFat.open(kAtlasPath, "r");
+    if (!f) return false;
+    const bool ok = f.seek(g_index[pos].offset) && f.read(dst, data_len) == data_len;
+    f.close();
+    return ok;
+}
+
+size_t icon_atlas_count() {
+    AtlasLock lock;
+    ensure_loaded_locked();
+    return g_count;
+}
+
+bool icon_atlas_id_at(size_t index, char* out, size_t out_len) {
+    if (!out || out_len == 0) return false;
+
+    AtlasLock lock;
+    ensure_loaded_locked();
+    if (index >= g_count) return false;
+    strlcpy(out, g_index[index].id, out_len);
+    return true;
+}
+
+bool icon_atlas_install(const IconAtlasItem* items, size_t count, char* err, size_t err_len) {
+    set_err(err, err_len, "");
+    if (!items || count == 0) {
+        set_err(err, err_len, "No icons");
+        return false;
+    }
+
+    {
+        AtlasLock lock;
+        ensure_loaded_locked();
+    }
+
+    // Merge into a new index first so a failed allocation writes nothing.
+    AtlasEntry* merged = alloc_index(g_count + count);
+    if (!merged) {
+        set_err(err, err_len, "Out of memory");
+        return false;
+    }
+    if (g_count) memcpy(merged, g_index, (size_t)g_count * sizeof(AtlasEntry));
+    uint32_t merged_count = g_count;
+
+    const bool fresh = !g_present;
+    File f = FFat.open(kAtlasPath, fresh ? "w" : "r+");
+    if (!f) {
+        free(merged);
+        set_err(err, err_len, "Failed to open icon atlas");
+        return false;
+    }
+
+    // Append after whatever is there (including leftovers of an interrupted install).
+    uint32_t pos = fresh ? 0 : (uint32_t)f.size();
+    const uint32_t old_bytes = pos;
+    bool ok = true;
+    if (fresh) {
+        uint8_t hdr[kHeaderBytes];
+        pack_header(hdr, 0, kHeaderBytes);
+        ok = write_all(f, hdr, sizeof(hdr));
+        pos = kHeaderBytes;
+    } else {
+        ok = f.seek(pos);
+    }
+
+    for (size_t i = 0; ok && i < count; i++) {
+        const IconAtlasItem& it = items[i];
+        ok = pad_to(f, &pos, align4(pos)) && write_all(f, it.data, it.data_len);
+        if (!ok) break;
+
+        AtlasEntry e;
+        memset(&e, 0, sizeof(e));
+        strlcpy(e.id, it.id, sizeof(e.id));
+        e.offset = pos;
+        e.data_len = it.data_len;
+        e.width = it.width;
+        e.height = it.height;
+        e.format = it.format;
+        e.encoding = it.encoding;
+        e.palette_count = it.palette_count;
+        index_upsert(merged, &merged_count, e);
+        pos += it.data_len;
+    }
+
+    uint32_t file_bytes = 0;
+    ok = ok && commit_index(f, pos, merged, merged_count, &file_bytes);
+    // A failed install may still have appended part of its payloads.
+    fs_health_note_ffat_file(old_bytes, (uint32_t)f.size());
+    f.close();
+
+    if (!ok) {
+        free(merged);
+        set_err(err, err_len, "Short write");
+        return false;
+    }
+
+    {
+        AtlasLock lock;
+        set_index_locked(merged, merged_count, file_bytes);
+    }
+    compact_if_needed();
+    return true;
+}
+
+bool icon_atlas_remove_if(
+    bool (*drop)(const char* id, void* ctx),
+    void* ctx,
+    size_t* out_removed,
+    size_t* out_bytes_freed,
+    char* err,
+    size_t err_len
+) {
+    set_err(err, err_len, "");
+    if (out_removed) *out_removed = 0;
+    if (out_bytes_freed) *out_bytes_freed = 0;
+    if (!drop) return false;
+
+    {
+        AtlasLock lock;
+        ensure_loaded_locked();
+    }
+    if (!g_present || g_count == 0) return true;
+
+    AtlasEntry* kept = alloc_index(g_count);
+    if (!kept) {
+        set_err(err, err_len, "Out of memory");
+        return false;
+    }
+
+    uint32_t kept_count = 0;
+    size_t removed = 0;
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < g_count; i++) {
+        if (drop(g_index[i].id, ctx)) {
+            removed++;
+            bytes += g_index[i].data_len;
+        } else {
+            kept[kept_count++] = g_index[i];
+        }
+    }
+
+    if (removed == 0) {
+        free(kept);
+        return true;
+    }
+
+    // Only a shorter index is appended; the payloads become dead space.
+    File f = FFat.open(kAtlasPath, "r+");
+    uint32_t file_bytes = 0;
+    const uint32_t old_bytes = f ? (uint32_t)f.size() : 0;
+    const bool ok = f && commit_index(f, old_bytes, kept, kept_count, &file_bytes);
+    if (f) {
+        fs_health_note_ffat_file(old_bytes, (uint32_t)f.size());
+        f.close();
+    }
+
+    if (!ok) {
+        free(kept);
+        set_err(err, err_len, "Failed to update icon atlas");
+        return false;
+    }
+
+    {
+        AtlasLock lock;
+        set_index_locked(kept, kept_count, file_bytes);
+    }
+    compact_if_needed();
+
+    if (out_removed) *out_removed = removed;
+    if (out_bytes_freed) *out_bytes_freed = bytes;
+    return true;
+}
+
+void icon_atlas_get_stats(IconAtlasStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+
+    AtlasLock lock;
+    out->present = g_present;
+    out->entries = g_count;
+    out->file_bytes = g_file_bytes;
+    out->live_bytes = g_live_bytes;
+    out->compactions = g_compactions;
+}
+
+#endif // HAS_DISPLAY && HAS_ICONS && ICON_STORE_ATLAS
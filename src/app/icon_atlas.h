@@ -0,0 +1,85 @@
+/*
+ * Icon Atlas
+ *
+ * Packed storage for installed (FFat) icons: one file instead of one
+ * /icons/<id>.bin per icon, so a lookup is a binary search in a RAM index plus
+ * one read, and listing never walks a directory.
+ *
+ * File layout (/icons.atlas, little-endian):
+ *
+ *   header   "ICA1", u32 count, u32 index_offset, u32 reserved
+ *   payloads icon data as stored after the blob header (RGB565+A8 pixels,
+ *            or palette + indices, possibly compressed), each starting on
+ *            a 4-byte boundary
+ *   index    count x 48-byte entries sorted by id:
+ *            char id[32] (NUL padded), u32 offset, u32 data_len,
+ *            u16 width, u16 height, u8 format, u8 encoding,
+ *            u16 palette_count (icon blob fields, see icon_store.h;
+ *            format 0 = 1)
+ *
+ * Installs append the new payloads and a new index after the end of the file,
+ * then rewrite the header; the header is the commit point, so an interrupted
+ * install leaves the previous atlas intact. Replaced or removed payloads stay
+ * as dead space until the atlas is compacted (rewritten to /icons.atlas.tmp
+ * and renamed over).
+ *
+ * Writers (install/remove) must hold icon_store's icon operation lock and
+ * have FFat mounted. Readers may run on any task.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_STORE_ATLAS
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct IconAtlasItem {
+    const char* id;          // [a-z0-9_]+, shorter than 32 bytes
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;          // icon blob format / encoding / palette size
+    uint8_t encoding;
+    uint16_t palette_count;
+    const uint8_t* data;     // blob data after its 16-byte header
+    uint32_t data_len;
+};
+
+struct IconAtlasStats {
+    bool present;
+    uint32_t entries;
+    uint32_t file_bytes;
+    uint32_t live_bytes;     // payloads still referenced by the index
+    uint32_t compactions;
+};
+
+// Describe an icon (all fields but id and data). Returns false when the atlas does not have it.
+bool icon_atlas_find(const char* id, IconAtlasItem* out);
+
+// Read an icon's stored data into dst (data_len from icon_atlas_find).
+// Fails if the icon changed size since (treat as a miss).
+bool icon_atlas_read(const char* id, uint8_t* dst, uint32_t data_len);
+
+// Number of icons, and the id at a position in sorted order (for listing).
+size_t icon_atlas_count();
+bool icon_atlas_id_at(size_t index, char* out, size_t out_len);
+
+// Add or replace icons in one append. Items with the same id: the last wins.
+bool icon_atlas_install(const IconAtlasItem* items, size_t count, char* err, size_t err_len);
+
+// Drop every icon for which drop(id, ctx) returns true. Compacts the atlas
+// when dead space has grown past ICON_STORE_ATLAS_COMPACT_BYTES and the live data.
+bool icon_atlas_remove_if(
+    bool (*drop)(const char* id, void* ctx),
+    void* ctx,
+    size_t* out_removed,
+    size_t* out_bytes_freed,
+    char* err,
+    size_t err_len
+);
+
+void icon_atlas_get_stats(IconAtlasStats* out);
+
+#endif // HAS_DISPLAY && HAS_ICONS && ICON_STORE_ATLAS
@@ -0,0 +1,301 @@
+/*
+ * Icon Pack Implementation
+ */
+
+#include "icon_pack.h"
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED
+
+#include "heap_placement.h"
+#include "log_manager.h"
+
+#include <Arduino.h>
+#include <esp_partition.h>
+
+#include <string.h>
+
+namespace {
+
+static constexpr uint32_t kHeaderBytes = 16;
+static constexpr uint32_t kFlagSwap16 = 1u << 0;
+static const uint8_t kMagic[4] = {'I', 'C', 'P', '1'};
+
+// Same layout as the atlas index entry (icon_atlas.cpp).
+struct PackEntry {
+    char id[32];
+    uint32_t offset;
+    uint32_t data_len;
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;
+    uint8_t encoding;
+    uint16_t palette_count;
+};
+static_assert(sizeof(PackEntry) == 48, "pack index entry layout");
+
+static const esp_partition_t* g_part = nullptr;
+static esp_partition_mmap_handle_t g_map_handle = 0;
+static const uint8_t* g_base = nullptr;
+static const PackEntry* g_index = nullptr;   // in the mapping
+static lv_img_dsc_t* g_dsc = nullptr;        // one per entry
+static uint32_t g_count = 0;
+static uint32_t g_pack_bytes = 0;
+static volatile bool g_serving = false;
+static volatile uint32_t g_hits = 0;
+
+// Upload state (one writer, the AsyncTCP task).
+static bool g_writing = false;
+static uint32_t g_write_total = 0;
+static uint32_t g_written = 0;
+static uint32_t g_erased_to = 0;
+static uint8_t g_hdr[kHeaderBytes];
+
+static void set_err(char* err, size_t err_len, const char* msg) {
+    if (!err || err_len == 0) return;
+    strlcpy(err, msg ? msg : "", err_len);
+}
+
+static uint32_t read_u32_le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Checks the header; returns the end of the index (0 = invalid).
+static uint32_t check_header(const uint8_t* hdr, uint32_t capacity, uint32_t* out_count, uint32_t* out_index_off) {
+    if (memcmp(hdr, kMagic, sizeof(kMagic)) != 0) return 0;
+    const uint32_t count = read_u32_le(hdr + 4);
+    const uint32_t index_off = read_u32_le(hdr + 8);
+    const uint32_t flags = read_u32_le(hdr + 12);
+
+    const bool swapped = (flags & kFlagSwap16) != 0;
+    if (swapped != (LV_COLOR_16_SWAP != 0)) return 0;
+    if (count == 0 || index_off < kHeaderBytes) return 0;
+    const uint64_t end = (uint64_t)index_off + (uint64_t)count * sizeof(PackEntry);
+    if (end > capacity) return 0;
+
+    *out_count = count;
+    *out_index_off = index_off;
+    return (uint32_t)end;
+}
+
+// Raw RGB565+A8 inside the payload area, ids NUL terminated and ascending.
+static bool check_entry(const PackEntry& e, const PackEntry* prev, uint32_t index_off) {
+    if (memchr(e.id, '\0', sizeof(e.id)) == nullptr || e.id[0] == '\0') return false;
+    if (prev && strncmp(prev->id, e.id, sizeof(e.id)) >= 0) return false;
+    if (e.format != 1 || e.encoding != 0) return false;
+    if (e.width == 0 || e.height == 0 || e.width > 256 || e.height > 256) return false;
+    if (e.data_len != (uint32_t)e.width * (uint32_t)e.height * 3u) return false;
+    return e.offset >= kHeaderBytes && (uint64_t)e.offset + e.data_len <= index_off;
+}
+
+static void unmap() {
+    if (g_base) esp_partition_munmap(g_map_handle);
+    g_base = nullptr;
+    g_index = nullptr;
+    g_count = 0;
+    g_pack_bytes = 0;
+}
+
+static bool map_pack() {
+    uint8_t hdr[kHeaderBytes];
+    if (esp_partition_read(g_part, 0, hdr, sizeof(hdr)) != ESP_OK) return false;
+
+    uint32_t count = 0;
+    uint32_t index_off = 0;
+    const uint32_t end = check_header(hdr, g_part->size, &count, &index_off);
+    if (!end) {
+        // An erased partition is the normal "no pack" case.
+        if (hdr[0] != 0xFF) Logger.logMessage("IconPack", "No valid pack in the icons partition");
+        return false;
+    }
+
+    const void* ptr = nullptr;
+    if (esp_partition_mmap(g_part, 0, end, ESP_PARTITION_MMAP_DATA, &ptr, &g_map_handle) != ESP_OK) {
+        Logger.logMessage("IconPack", "Mapping the icons partition failed");
+        return false;
+    }
+    g_base = (const uint8_t*)ptr;
+    g_index = (const PackEntry*)(g_base + index_off);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!check_entry(g_index[i], i ? &g_index[i - 1] : nullptr, index_off)) {
+            Logger.logMessagef("IconPack", "Pack entry %u is invalid; pack ignored", (unsigned)i);
+            unmap();
+            return false;
+        }
+    }
+
+    g_dsc = (lv_img_dsc_t*)heap_place_calloc(HeapClass::Bulk, HeapTag::Icons, count, sizeof(lv_img_dsc_t));
+    if (!g_dsc) {
+        Logger.logMessage("IconPack", "Out of memory for pack descriptors");
+        unmap();
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const PackEntry& e = g_index[i];
+        lv_img_dsc_t& d = g_dsc[i];
+        d.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+        d.header.always_zero = 0;
+        d.header.reserved = 0;
+        d.header.w = e.width;
+        d.header.h = e.height;
+        d.data_size = e.data_len;
+        d.data = g_base + e.offset;
+    }
+
+    g_count = count;
+    g_pack_bytes = end;
+    return true;
+}
+
+static bool erase_through(uint32_t end) {
+    const uint32_t sector = g_part->erase_size ? g_part->erase_size : 4096;
+    while (g_erased_to < end) {
+        if (esp_partition_erase_range(g_part, g_erased_to, sector) != ESP_OK) return false;
+        g_erased_to += sector;
+    }
+    return true;
+}
+
+} // namespace
+
+void icon_pack_init() {
+    g_part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA,
+        (esp_partition_subtype_t)ICON_PACK_PARTITION_SUBTYPE,
+        "icons");
+    if (!g_part) return;
+
+    if (map_pack()) {
+        g_serving = true;
+        Logger.logMessagef("IconPack", "Mapped %u icons (%u of %u bytes)",
+            (unsigned)g_count, (unsigned)g_pack_bytes, (unsigned)g_part->size);
+    }
+}
+
+const lv_img_dsc_t* icon_pack_find(const char* id) {
+    if (!g_serving || !id || !*id) return nullptr;
+
+    uint32_t lo = 0;
+    uint32_t hi = g_count;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        const int c = strncmp(g_index[mid].id, id, sizeof(g_index[mid].id));
+        if (c == 0) {
+            g_hits = g_hits + 1;
+            return &g_dsc[mid];
+        }
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return nullptr;
+}
+
+void icon_pack_get_stats(IconPackStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    out->partition_present = g_part != nullptr;
+    out->mapped = g_serving;
+    out->capacity_bytes = g_part ? g_part->size : 0;
+    out->pack_bytes = g_pack_bytes;
+    out->entries = g_count;
+    out->hits = g_hits;
+}
+
+bool icon_pack_write_begin(size_t total, char* err, size_t err_len) {
+    set_err(err, err_len, "");
+    if (!g_part) {
+        set_err(err, err_len, "No icons partition on this device");
+        return false;
+    }
+    if (g_writing) {
+        set_err(err, err_len, "Another pack upload is in progress");
+        return false;
+    }
+    if (total < kHeaderBytes + sizeof(PackEntry) || total > g_part->size) {
+        set_err(err, err_len, "Pack size does not fit the icons partition");
+        return false;
+    }
+
+    // Nothing new may point into flash that is about to be erased.
+    g_serving = false;
+    g_writing = true;
+    g_write_total = (uint32_t)total;
+    g_written = 0;
+    g_erased_to = 0;
+    memset(g_hdr, 0xFF, sizeof(g_hdr));
+    return true;
+}
+
+bool icon_pack_write(const uint8_t* data, size_t len, char* err, size_t err_len) {
+    if (!g_writing) {
+        set_err(err, err_len, "No pack upload in progress");
+        return false;
+    }
+    if (len > g_write_total - g_written) {
+        set_err(err, err_len, "Pack is longer than announced");
+        return false;
+    }
+    if (!erase_through(g_written + (uint32_t)len)) {
+        set_err(err, err_len, "Flash erase failed");
+        return false;
+    }
+
+    // Keep the header; its magic is only written once the pack checks out.
+    uint32_t skip = 0;
+    while (g_written + skip < kHeaderBytes && skip < len) {
+        g_hdr[g_written + skip] = data[skip];
+        skip++;
+    }
+    const uint32_t magic_left = g_written < sizeof(kMagic) ? (uint32_t)sizeof(kMagic) - g_written : 0;
+    const uint32_t hold = magic_left < len ? magic_left : (uint32_t)len;
+    if (len > hold && esp_partition_write(g_part, g_written + hold, data + hold, len - hold) != ESP_OK) {
+        set_err(err, err_len, "Flash write failed");
+        return false;
+    }
+    g_written += (uint32_t)len;
+    return true;
+}
+
+bool icon_pack_write_end(char* err, size_t err_len) {
+    if (!g_writing) {
+        set_err(err, err_len, "No pack upload in progress");
+        return false;
+    }
+    g_writing = false;
+    if (g_written != g_write_total) {
+        set_err(err, err_len, "Pack upload incomplete");
+        return false;
+    }
+
+    uint32_t count = 0;
+    uint32_t index_off = 0;
+    const uint32_t end = check_header(g_hdr, g_written, &count, &index_off);
+    if (!end) {
+        set_err(err, err_len, "Invalid pack header (or wrong RGB565 byte order)");
+        return false;
+    }
+
+    PackEntry prev;
+    PackEntry e;
+    for (uint32_t i = 0; i < count; i++) {
+        if (esp_partition_read(g_part, index_off + i * (uint32_t)sizeof(PackEntry), &e, sizeof(e)) != ESP_OK
+            || !check_entry(e, i ? &prev : nullptr, index_off)) {
+            set_err(err, err_len, "Invalid pack index");
+            return false;
+        }
+        prev = e;
+    }
+
+    if (esp_partition_write(g_part, 0, kMagic, sizeof(kMagic)) != ESP_OK) {
+        set_err(err, err_len, "Flash write failed");
+        return false;
+    }
+    Logger.logMessagef("IconPack", "Wrote %u icons (%u bytes)", (unsigned)count, (unsigned)g_written);
+    return true;
+}
+
+bool icon_pack_write_active() {
+    return g_writing;
+}
+
+#endif // HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED
@@ -0,0 +1,67 @@
+/*
+ * Icon Pack
+ *
+ * Read-only icons served straight from flash. A raw data partition named
+ * "icons" (subtype ICON_PACK_PARTITION_SUBTYPE, see partitions/README.md)
+ * holds a packed image that is mapped into the address space at boot, and
+ * each icon's lv_img_dsc_t points into the mapping: no copy to RAM, no FFat
+ * read, no decode. Only the descriptors live in RAM (12 bytes per icon).
+ *
+ * Layout (little-endian), the same shape as the icon atlas (icon_atlas.h):
+ *
+ *   header   "ICP1", u32 count, u32 index_offset, u32 flags
+ *            (bit 0: RGB565 bytes swapped, must match LV_COLOR_16_SWAP)
+ *   payloads raw RGB565+A8 pixels (width * height * 3 bytes each)
+ *   index    count x 48-byte entries sorted by id:
+ *            char id[32] (NUL padded), u32 offset, u32 data_len,
+ *            u16 width, u16 height, u8 format (1), u8 encoding (0),
+ *            u16 palette_count (0)
+ *
+ * tools/png2lvgl_assets.py --icon-pack builds one. POST /api/icons/pack
+ * replaces the whole partition and reboots: the magic is written last, so a
+ * pack cut short is never mapped.
+ *
+ * Pack icons are looked up after compiled icons and before installed (FFat)
+ * ones, so they shadow installed icons with the same id.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED
+
+#include <lvgl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct IconPackStats {
+    bool partition_present;
+    bool mapped;              // a valid pack is mapped
+    uint32_t capacity_bytes;  // partition size
+    uint32_t pack_bytes;      // end of the mapped pack's index
+    uint32_t entries;
+    uint32_t hits;            // lookups served from the pack
+};
+
+// Maps the pack partition when it holds a valid pack. Call once at boot.
+void icon_pack_init();
+
+// Descriptor of a pack icon (stable until reboot), or nullptr. Any task.
+const lv_img_dsc_t* icon_pack_find(const char* id);
+
+void icon_pack_get_stats(IconPackStats* out);
+
+// Wholesale replacement (one writer at a time). begin() checks the size and
+// stops serving pack icons; the old pack's flash is erased as the new one
+// is written, so the caller reboots once a write has started, whether or
+// not end() succeeds.
+bool icon_pack_write_begin(size_t total, char* err, size_t err_len);
+bool icon_pack_write(const uint8_t* data, size_t len, char* err, size_t err_len);
+
+// Validates the written pack and commits its magic.
+bool icon_pack_write_end(char* err, size_t err_len);
+
+bool icon_pack_write_active();
+
+#endif // HAS_DISPLAY && HAS_ICONS && ICON_PACK_ENABLED
@@ -5,8 +5,18 @@
 #include <Arduino.h>
 #include <FFat.h>
 #include <esp_partition.h>
+#include <esp_timer.h>
 
+#include "fnv1a.h"
 #include "fs_health.h"
+#include "heap_placement.h"
+#include "pixel_codec.h"
+#if ICON_STORE_ATLAS
+#include "icon_atlas.h"
+#endif
+#if ICON_PACK_ENABLED
+#include "icon_pack.h"
+#endif
 
 #include <string.h>
 
@@ -53,16 +63,13 @@ static bool ensure_ffat() {
     }
 
     ffat_ready = FFat.begin(false);
-    if (ffat_ready) {
-        // Report usage to the health module (best-effort). This is called only
-        // when some icon operation needed FFat, not from /api/health.
-        fs_health_set_ffat_usage((uint32_t)FFat.usedBytes(), (uint32_t)FFat.totalBytes());
-    }
+    if (ffat_ready) fs_health_note_ffat_mounted();
     return ffat_ready;
 }
 
 static bool is_safe_icon_id(const char* s) {
     if (!s || !*s) return false;
+    if (strnlen(s, MACROS_ICON_ID_MAX_LEN) >= MACROS_ICON_ID_MAX_LEN) return false;
     for (const char* p = s; *p; p++) {
         const char c = *p;
         const bool ok = (c >= 'a' && c <= 'z')
@@ -74,12 +81,33 @@ static bool is_safe_icon_id(const char* s) {
 }
 
 struct IconFileHeader {
-    char magic[4];      // "ICN1"
-    uint16_t width;     // LE
-    uint16_t height;    // LE
-    uint8_t format;     // 1 = RGB565+Alpha
-    uint8_t reserved[3];
-    uint32_t data_len;  // LE
+    char magic[4];          // "ICN1" or "ICN2"
+    uint16_t width;         // LE
+    uint16_t height;        // LE
+    uint8_t format;         // IconBlobFormat
+    uint8_t encoding;       // IconBlobEncoding (ICN2; 0 in ICN1)
+    uint16_t palette_count; // LE, ICON_FORMAT_PALETTE8 only (ICN2)
+    uint32_t data_len;      // LE
+};
+
+enum IconBlobFormat : uint8_t {
+    ICON_FORMAT_RGB565A8 = 1,
+    ICON_FORMAT_PALETTE8 = 2,
+};
+
+enum IconBlobEncoding : uint8_t {
+    ICON_ENCODING_RAW = 0,
+    ICON_ENCODING_RLE = 1,
+    ICON_ENCODING_LZ4 = 2,
+};
+
+struct IconBlobInfo {
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;
+    uint8_t encoding;
+    uint16_t palette_count;
+    uint32_t data_len;      // stored bytes after the header
 };
 
 static uint16_t read_u16_le(const uint8_t* p) {
@@ -93,43 +121,193 @@ static uint32_t read_u32_le(const uint8_t* p) {
         | ((uint32_t)p[3] << 24);
 }
 
+static void set_err(char* err, size_t err_len, const char* msg) {
+    if (!err || err_len == 0) return;
+    strlcpy(err, msg ? msg : "", err_len);
+}
+
+// RGB565+A8 bytes the icon occupies once loaded (every format is expanded to it).
+static size_t icon_pixel_bytes(const IconBlobInfo& info) {
+    return (size_t)info.width * (size_t)info.height * 3;
+}
+
+static bool icon_is_raw_rgb565a8(const IconBlobInfo& info) {
+    return info.format == ICON_FORMAT_RGB565A8 && info.encoding == ICON_ENCODING_RAW;
+}
+
+// Parses and sanity-checks an ICN1/ICN2 header; blob_len is header + data.
+static bool parse_icon_header(const uint8_t* hdr, size_t blob_len, IconBlobInfo* out, char* err, size_t err_len) {
+    const bool icn1 = hdr[0] == 'I' && hdr[1] == 'C' && hdr[2] == 'N' && hdr[3] == '1';
+    const bool icn2 = hdr[0] == 'I' && hdr[1] == 'C' && hdr[2] == 'N' && hdr[3] == '2';
+    if (!icn1 && !icn2) {
+        set_err(err, err_len, "Bad magic");
+        return false;
+    }
+
+    IconBlobInfo info;
+    info.width = read_u16_le(hdr + 4);
+    info.height = read_u16_le(hdr + 6);
+    info.format = hdr[8];
+    info.encoding = icn2 ? hdr[9] : ICON_ENCODING_RAW;
+    info.palette_count = icn2 ? read_u16_le(hdr + 10) : 0;
+    info.data_len = read_u32_le(hdr + 12);
+
+    const bool format_ok = info.format == ICON_FORMAT_RGB565A8 || (icn2 && info.format == ICON_FORMAT_PALETTE8);
+    if (!format_ok || info.encoding > ICON_ENCODING_LZ4) {
+        set_err(err, err_len, "Unsupported format");
+        return false;
+    }
+    if (info.width == 0 || info.height == 0 || info.width > 256 || info.height > 256) {
+        set_err(err, err_len, "Invalid dimensions");
+        return false;
+    }
+
+    const size_t pixels = (size_t)info.width * (size_t)info.height;
+    size_t palette_bytes = 0;
+    if (info.format == ICON_FORMAT_PALETTE8) {
+        if (info.palette_count == 0 || info.palette_count > 256) {
+            set_err(err, err_len, "Invalid palette size");
+            return false;
+        }
+        palette_bytes = (size_t)info.palette_count * 3;
+    } else {
+        info.palette_count = 0;
+    }
+
+    // Raw data has an exact size; compressed data only needs its palette.
+    const size_t unit = (info.format == ICON_FORMAT_PALETTE8) ? 1 : 3;
+    const size_t raw_len = palette_bytes + pixels * unit;
+    if (info.encoding == ICON_ENCODING_RAW ? info.data_len != raw_len : info.data_len <= palette_bytes) {
+        set_err(err, err_len, "Unexpected payload size");
+        return false;
+    }
+
+    if ((size_t)sizeof(IconFileHeader) + (size_t)info.data_len != blob_len) {
+        set_err(err, err_len, "Blob length mismatch");
+        return false;
+    }
+
+    *out = info;
+    return true;
+}
+
+static bool decode_icon_stream(uint8_t encoding, const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len, size_t unit, char* err, size_t err_len) {
+    switch (encoding) {
+        case ICON_ENCODING_RAW:
+            if (src_len != dst_len) {
+                set_err(err, err_len, "Raw size mismatch");
+                return false;
+            }
+            memcpy(dst, src, dst_len);
+            return true;
+        case ICON_ENCODING_RLE:
+            return pixel_rle_decode(src, src_len, dst, dst_len, unit, err, err_len);
+        case ICON_ENCODING_LZ4:
+            return pixel_lz4_decode(src, src_len, dst, dst_len, err, err_len);
+        default:
+            set_err(err, err_len, "Unknown encoding");
+            return false;
+    }
+}
+
+// Expands stored icon data into icon_pixel_bytes(info) of RGB565+A8 at out.
+static bool decode_icon_data(const IconBlobInfo& info, const uint8_t* data, uint8_t* out, char* err, size_t err_len) {
+    const size_t pixels = (size_t)info.width * (size_t)info.height;
+    if (info.format == ICON_FORMAT_RGB565A8) {
+        return decode_icon_stream(info.encoding, data, info.data_len, out, pixels * 3, 3, err, err_len);
+    }
+
+    // Palette: decode the indices into the last third of the output, then
+    // expand forward in place (pixel i is written at or before index i+1 is read).
+    const uint8_t* palette = data;
+    const size_t palette_bytes = (size_t)info.palette_count * 3;
+    uint8_t* indices = out + pixels * 2;
+    if (!decode_icon_stream(info.encoding, data + palette_bytes, info.data_len - palette_bytes, indices, pixels, 1, err, err_len)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < pixels; i++) {
+        const uint8_t k = indices[i];
+        uint8_t* px = out + i * 3;
+        if (k < info.palette_count) {
+            px[0] = palette[k * 3 + 0];
+            px[1] = palette[k * 3 + 1];
+            px[2] = palette[k * 3 + 2];
+        } else {
+            // Out-of-range index: transparent.
+            px[0] = 0;
+            px[1] = 0;
+            px[2] = 0;
+        }
+    }
+    return true;
+}
+
 struct CacheEntry {
     bool in_use;
     char id[32];
     lv_img_dsc_t dsc;
     uint8_t* data;
     size_t data_len;
-    uint32_t last_used_ms;
+    uint16_t refs;       // lv_img objects currently pointing at dsc
+    uint32_t last_used;  // g_cache_tick at the last acquire/release (LRU order)
 };
 
-// IMPORTANT:
-// LVGL image objects keep a pointer to the provided lv_img_dsc_t (and its data).
-// Evicting/reusing cache slots can invalidate those pointers while the UI is
-// still rendering, causing memory corruption and panics.
-//
-// Therefore: this cache is intentionally non-evicting. If it fills up, we
-// refuse to load more file-backed icons (they simply won't render) rather than
-// risking a crash.
+// LVGL image objects keep a pointer to the provided lv_img_dsc_t (and its
+// data), so an entry may only be freed while nothing references it. Screens
+// hold a reference for as long as an lv_img shows the icon
+// (icon_store_acquire / icon_store_release). Unreferenced entries stay cached
+// until the pixel data exceeds ICON_STORE_CACHE_BYTES or a slot is needed;
+// then the least recently used of them is evicted.
 #ifndef ICON_STORE_CACHE_SLOTS
     #if SOC_SPIRAM_SUPPORTED
-        // PSRAM-capable targets can afford a bigger icon cache.
+        #define ICON_STORE_CACHE_SLOTS 48
+    #else
         #define ICON_STORE_CACHE_SLOTS 16
+    #endif
+#endif
+
+#ifndef ICON_STORE_CACHE_BYTES
+    #if SOC_SPIRAM_SUPPORTED
+        // PSRAM-capable targets can afford a bigger icon cache.
+        #define ICON_STORE_CACHE_BYTES (256 * 1024)
     #else
-        #define ICON_STORE_CACHE_SLOTS 4
+        #define ICON_STORE_CACHE_BYTES (48 * 1024)
     #endif
 #endif
 
+// Touched only from the LVGL task (screens acquire/release while refreshing).
 static CacheEntry g_cache[ICON_STORE_CACHE_SLOTS];
+static uint32_t g_cache_tick = 0;
+static size_t g_cache_bytes = 0;
+static uint32_t g_cache_hits = 0;
+static uint32_t g_cache_misses = 0;
+static uint32_t g_cache_evictions = 0;
+static uint32_t g_cache_refusals = 0;
+static uint32_t g_cache_loads = 0;
+static uint32_t g_cache_load_us = 0;
+static uint32_t g_cache_loaded_stored_bytes = 0;
+static uint32_t g_cache_loaded_pixel_bytes = 0;
+
+static uint8_t* alloc_icon_payload(size_t len) {
+    return (uint8_t*)heap_place_malloc(HeapClass::Bulk, HeapTag::Icons, len);
+}
+
+static void free_icon_payload(void* p) {
+    heap_tag_free(HeapTag::Icons, p);
+}
 
 static void cache_free(CacheEntry& e) {
     if (e.data) {
-        free(e.data);
+        free_icon_payload(e.data);
         e.data = nullptr;
+        g_cache_bytes -= e.data_len;
     }
     e.in_use = false;
     e.id[0] = '\0';
     e.data_len = 0;
-    e.last_used_ms = 0;
+    e.refs = 0;
+    e.last_used = 0;
     memset(&e.dsc, 0, sizeof(e.dsc));
 }
 
@@ -141,18 +319,59 @@ static CacheEntry* cache_find(const char* id) {
     return nullptr;
 }
 
+static CacheEntry* cache_find_dsc(const lv_img_dsc_t* dsc) {
+    for (auto& e : g_cache) {
+        if (e.in_use && &e.dsc == dsc) return &e;
+    }
+    return nullptr;
+}
+
+static CacheEntry* cache_lru_unreferenced() {
+    CacheEntry* victim = nullptr;
+    for (auto& e : g_cache) {
+        if (!e.in_use || e.refs != 0) continue;
+        if (!victim || (int32_t)(e.last_used - victim->last_used) < 0) victim = &e;
+    }
+    return victim;
+}
+
+static void cache_evict(CacheEntry& e) {
+    // LVGL's image cache is keyed by the descriptor address; the slot is reused.
+    lv_img_cache_invalidate_src(&e.dsc);
+    cache_free(e);
+    g_cache_evictions++;
+}
+
+// Drop least recently used unreferenced icons until the data fits the budget.
+static void cache_trim() {
+    while (g_cache_bytes > (size_t)ICON_STORE_CACHE_BYTES) {
+        CacheEntry* victim = cache_lru_unreferenced();
+        if (!victim) return;  // Everything left is on screen.
+        cache_evict(*victim);
+    }
+}
+
 static CacheEntry* cache_alloc_slot() {
     for (auto& e : g_cache) {
         if (!e.in_use) return &e;
     }
 
-    // Non-evicting (see note above).
-    return nullptr;
+    // Full: reuse the least recently used icon nothing is showing.
+    CacheEntry* victim = cache_lru_unreferenced();
+    if (victim) cache_evict(*victim);
+    return victim;
 }
 
-static bool load_icon_file_to_cache(const char* icon_id, IconRef* out) {
-    if (!ensure_ffat()) return false;
+// Whether per-icon files may exist under /icons (installs before the atlas).
+// Checked once; cleared when GC has moved them into the atlas.
+static int8_t g_legacy_dir = -1;
+
+static bool legacy_icons_present() {
+    if (g_legacy_dir < 0) g_legacy_dir = FFat.exists("/icons") ? 1 : 0;
+    return g_legacy_dir == 1;
+}
 
+static bool read_icon_file(const char* icon_id, uint8_t** out_data, IconBlobInfo* out_info) {
     char path[80];
     snprintf(path, sizeof(path), "/icons/%s.bin", icon_id);
 
@@ -171,84 +390,155 @@ static bool load_icon_file_to_cache(const char* icon_id, IconRef* out) {
         return false;
     }
 
-    if (!(hdr_buf[0] == 'I' && hdr_buf[1] == 'C' && hdr_buf[2] == 'N' && hdr_buf[3] == '1')) {
+    IconBlobInfo info;
+    if (!parse_icon_header(hdr_buf, file_size, &info, nullptr, 0)) {
         f.close();
         return false;
     }
 
-    const uint16_t w = read_u16_le(hdr_buf + 4);
-    const uint16_t h = read_u16_le(hdr_buf + 6);
-    const uint8_t fmt = hdr_buf[8];
-    const uint32_t data_len = read_u32_le(hdr_buf + 12);
-
-    if (fmt != 1) {
-        f.close();
-        return false;
-    }
-    if (w == 0 || h == 0 || w > 256 || h > 256) {
+    uint8_t* data = alloc_icon_payload(info.data_len);
+    if (!data) {
         f.close();
         return false;
     }
 
-    const size_t expected_payload = (size_t)w * (size_t)h * 3;
-    if (data_len != expected_payload) {
-        f.close();
+    const int rd = f.read(data, info.data_len);
+    f.close();
+    if (rd != (int)info.data_len) {
+        free_icon_payload(data);
         return false;
     }
 
-    if (sizeof(IconFileHeader) + (size_t)data_len != file_size) {
-        f.close();
+    *out_data = data;
+    *out_info = info;
+    return true;
+}
+
+#if ICON_STORE_ATLAS
+static bool read_icon_atlas(const char* icon_id, uint8_t** out_data, IconBlobInfo* out_info) {
+    IconAtlasItem item;
+    if (!icon_atlas_find(icon_id, &item)) return false;
+
+    uint8_t* data = alloc_icon_payload(item.data_len);
+    if (!data) return false;
+    if (!icon_atlas_read(icon_id, data, item.data_len)) {
+        free_icon_payload(data);
         return false;
     }
 
-    uint8_t* payload = nullptr;
-#if SOC_SPIRAM_SUPPORTED
-    if (psramFound()) {
-        payload = (uint8_t*)heap_caps_malloc(data_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    out_info->width = item.width;
+    out_info->height = item.height;
+    out_info->format = item.format;
+    out_info->encoding = item.encoding;
+    out_info->palette_count = item.palette_count;
+    out_info->data_len = item.data_len;
+    *out_data = data;
+    return true;
+}
+#endif
+
+// Read and expand an installed icon to RGB565+A8 in LVGL byte order. Touches
+// no cache state, so it may run on any task.
+static bool read_decoded_icon(const char* icon_id, IconStorePreload* out) {
+    if (!ensure_ffat()) return false;
+
+    const int64_t t0 = esp_timer_get_time();
+
+    uint8_t* stored = nullptr;
+    IconBlobInfo info;
+#if ICON_STORE_ATLAS
+    bool found = read_icon_atlas(icon_id, &stored, &info);
+    if (!found && legacy_icons_present()) {
+        found = read_icon_file(icon_id, &stored, &info);
     }
+#else
+    const bool found = read_icon_file(icon_id, &stored, &info);
 #endif
-    if (!payload) payload = (uint8_t*)malloc(data_len);
-    if (!payload) {
-        f.close();
-        return false;
+    if (!found) return false;
+
+    // Raw RGB565+A8 is used as read; everything else is expanded to it.
+    uint8_t* payload = stored;
+    const size_t data_len = icon_pixel_bytes(info);
+    if (!icon_is_raw_rgb565a8(info)) {
+        payload = alloc_icon_payload(data_len);
+        char derr[64];
+        const bool ok = payload && decode_icon_data(info, stored, payload, derr, sizeof(derr));
+        free_icon_payload(stored);
+        if (!ok) {
+            free_icon_payload(payload);
+            return false;
+        }
     }
 
-    const int rd = f.read(payload, data_len);
-    f.close();
-    if (rd != (int)data_len) {
-        free(payload);
-        return false;
+#if LV_COLOR_16_SWAP
+    // Stored as little-endian RGB565 + A8; LVGL renders big-endian RGB565 in this build.
+    for (size_t i = 0; i + 2 < (size_t)data_len; i += 3) {
+        const uint8_t lo = payload[i];
+        payload[i] = payload[i + 1];
+        payload[i + 1] = lo;
     }
+#endif
+
+    strlcpy(out->id, icon_id, sizeof(out->id));
+    out->data = payload;
+    out->data_len = data_len;
+    out->width = info.width;
+    out->height = info.height;
+    out->stored_len = info.data_len;
+    out->load_us = (uint32_t)(esp_timer_get_time() - t0);
+    return true;
+}
+
+// Take ownership of a decoded icon. refs is 1 for an acquire, 0 for warm-up.
+static CacheEntry* cache_insert(IconStorePreload* icon, uint16_t refs) {
+    if (!icon->data) return nullptr;
+
+    g_cache_loads++;
+    g_cache_load_us += icon->load_us;
+    g_cache_loaded_stored_bytes += icon->stored_len;
+    g_cache_loaded_pixel_bytes += icon->data_len;
 
     CacheEntry* slot = cache_alloc_slot();
     if (!slot) {
-        free(payload);
-        return false;
+        // Every slot is on screen somewhere.
+        g_cache_refusals++;
+        free_icon_payload(icon->data);
+        icon->data = nullptr;
+        return nullptr;
     }
     cache_free(*slot);
 
     slot->in_use = true;
-    strlcpy(slot->id, icon_id, sizeof(slot->id));
-    slot->data = payload;
-    slot->data_len = data_len;
-    slot->last_used_ms = millis();
+    strlcpy(slot->id, icon->id, sizeof(slot->id));
+    slot->data = icon->data;
+    slot->data_len = icon->data_len;
+    slot->refs = refs;
+    slot->last_used = ++g_cache_tick;
+    g_cache_bytes += icon->data_len;
+    icon->data = nullptr;
 
     slot->dsc.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
     slot->dsc.header.always_zero = 0;
     slot->dsc.header.reserved = 0;
-    slot->dsc.header.w = w;
-    slot->dsc.header.h = h;
-    slot->dsc.data_size = data_len;
-    slot->dsc.data = payload;
+    slot->dsc.header.w = icon->width;
+    slot->dsc.header.h = icon->height;
+    slot->dsc.data_size = slot->data_len;
+    slot->dsc.data = slot->data;
+    return slot;
+}
+
+static bool load_icon_to_cache(const char* icon_id, IconRef* out) {
+    IconStorePreload icon;
+    if (!read_decoded_icon(icon_id, &icon)) return false;
+
+    CacheEntry* slot = cache_insert(&icon, 1);
+    if (!slot) return false;
 
     out->dsc = &slot->dsc;
     out->kind = IconKind::Color;
-    return true;
-}
 
-static void set_err(char* err, size_t err_len, const char* msg) {
-    if (!err || err_len == 0) return;
-    strlcpy(err, msg ? msg : "", err_len);
+    cache_trim();
+    return true;
 }
 
 static bool has_prefix(const char* s, const char* prefix) {
@@ -261,19 +551,255 @@ static bool has_prefix(const char* s, const char* prefix) {
     return true;
 }
 
-static bool macros_use_icon_id(const MacroConfig* cfg, const char* id) {
-    if (!cfg || !id || !*id) return false;
+// Ids referenced by Emoji/Asset macro buttons, built once per GC run
+// (open addressing; heap, not the HTTP task's stack).
+struct IconIdSet {
+    size_t cap;  // power of two
+    char (*ids)[MACROS_ICON_ID_MAX_LEN];
+};
+
+static bool id_set_contains(const IconIdSet* set, const char* id) {
+    for (size_t i = fnv1a32_str(id) & (set->cap - 1);; i = (i + 1) & (set->cap - 1)) {
+        if (!set->ids[i][0]) return false;
+        if (strncmp(set->ids[i], id, MACROS_ICON_ID_MAX_LEN) == 0) return true;
+    }
+}
+
+static bool id_set_build(IconIdSet* set, const MacroConfig* cfg) {
+    // At most one id per button; keep the table at most half full.
+    set->cap = 1;
+    while (set->cap < 2 * (size_t)MACROS_SCREEN_COUNT * (size_t)MACROS_BUTTONS_PER_SCREEN) set->cap <<= 1;
+    set->ids = (char (*)[MACROS_ICON_ID_MAX_LEN])alloc_icon_payload(set->cap * MACROS_ICON_ID_MAX_LEN);
+    if (!set->ids) return false;
+    memset(set->ids, 0, set->cap * MACROS_ICON_ID_MAX_LEN);
 
     for (size_t s = 0; s < (size_t)MACROS_SCREEN_COUNT; s++) {
         for (size_t b = 0; b < (size_t)MACROS_BUTTONS_PER_SCREEN; b++) {
             const auto& icon = cfg->buttons[s][b].icon;
-            if (icon.type == MacroIconType::Emoji || icon.type == MacroIconType::Asset) {
-                if (strncmp(icon.id, id, (size_t)MACROS_ICON_ID_MAX_LEN) == 0) return true;
-            }
+            if (icon.type != MacroIconType::Emoji && icon.type != MacroIconType::Asset) continue;
+            if (!icon.id[0] || id_set_contains(set, icon.id)) continue;
+
+            size_t i = fnv1a32_str(icon.id) & (set->cap - 1);
+            while (set->ids[i][0]) i = (i + 1) & (set->cap - 1);
+            strlcpy(set->ids[i], icon.id, MACROS_ICON_ID_MAX_LEN);
+        }
+    }
+    return true;
+}
+
+// Checks the header and, for compressed/palette data, that it decodes.
+static bool validate_icon_blob(const uint8_t* blob, size_t blob_len, IconBlobInfo* out_info, char* err, size_t err_len) {
+    if (!blob || blob_len < sizeof(IconFileHeader) || blob_len > (256 * 1024)) {
+        set_err(err, err_len, "Invalid blob");
+        return false;
+    }
+
+    IconBlobInfo info;
+    if (!parse_icon_header(blob, blob_len, &info, err, err_len)) return false;
+
+    if (!icon_is_raw_rgb565a8(info)) {
+        uint8_t* scratch = alloc_icon_payload(icon_pixel_bytes(info));
+        if (!scratch) {
+            set_err(err, err_len, "Out of memory");
+            return false;
+        }
+        char derr[64];
+        const bool ok = decode_icon_data(info, blob + sizeof(IconFileHeader), scratch, derr, sizeof(derr));
+        free_icon_payload(scratch);
+        if (!ok) {
+            if (err && err_len) snprintf(err, err_len, "Corrupt icon data: %s", derr);
+            return false;
         }
     }
 
-    return false;
+    *out_info = info;
+    return true;
+}
+
+#if ICON_STORE_ATLAS
+static IconAtlasItem atlas_item_for(const char* id, const IconBlobInfo& info, const uint8_t* blob) {
+    IconAtlasItem item;
+    item.id = id;
+    item.width = info.width;
+    item.height = info.height;
+    item.format = info.format;
+    item.encoding = info.encoding;
+    item.palette_count = info.palette_count;
+    item.data = blob + sizeof(IconFileHeader);
+    item.data_len = info.data_len;
+    return item;
+}
+#endif
+
+#if !ICON_STORE_ATLAS
+static bool write_icon_file(const char* icon_id, const uint8_t* blob, size_t blob_len, char* err, size_t err_len) {
+    // Ensure /icons exists.
+    if (!FFat.exists("/icons") && FFat.mkdir("/icons")) {
+        fs_health_note_ffat_file(0, 1);
+    }
+    g_legacy_dir = 1;
+
+    char path[80];
+    snprintf(path, sizeof(path), "/icons/%s.bin", icon_id);
+
+    const uint32_t old_size = fs_health_ffat_file_size(path);
+    File f = FFat.open(path, "w");
+    if (!f) {
+        set_err(err, err_len, "Failed to open file for writing");
+        return false;
+    }
+
+    const size_t written = f.write(blob, blob_len);
+    f.close();
+    fs_health_note_ffat_file(old_size, (uint32_t)written);
+
+    if (written != blob_len) {
+        set_err(err, err_len, "Short write");
+        return false;
+    }
+    return true;
+}
+#else
+static void remove_legacy_icon_file(const char* icon_id) {
+    if (!legacy_icons_present()) return;
+
+    char path[80];
+    snprintf(path, sizeof(path), "/icons/%s.bin", icon_id);
+    if (FFat.exists(path)) fs_health_ffat_remove(path);
+}
+
+// Moves one kept /icons/<id>.bin into the atlas. The file stays if that fails.
+static void migrate_legacy_icon_file(const char* id, File& f) {
+    const size_t sz = (size_t)f.size();
+    uint8_t* blob = (sz >= sizeof(IconFileHeader) && sz <= (256 * 1024)) ? alloc_icon_payload(sz) : nullptr;
+    const bool read_ok = blob && f.read(blob, sz) == sz;
+    f.close();
+
+    IconBlobInfo info;
+    bool ok = read_ok && validate_icon_blob(blob, sz, &info, nullptr, 0);
+    if (ok) {
+        const IconAtlasItem item = atlas_item_for(id, info, blob);
+        ok = icon_atlas_install(&item, 1, nullptr, 0);
+    }
+    free_icon_payload(blob);
+
+    if (ok) {
+        char path[96];
+        snprintf(path, sizeof(path), "/icons/%s.bin", id);
+        if (FFat.remove(path)) fs_health_note_ffat_file((uint32_t)sz, 0);
+    }
+}
+#endif
+
+#ifndef ICON_STORE_GC_BATCH
+#define ICON_STORE_GC_BATCH 8  // /icons files per GC step before yielding
+#endif
+
+#ifndef ICON_STORE_GC_STACK_BYTES
+#define ICON_STORE_GC_STACK_BYTES 6144
+#endif
+
+static bool gc_should_drop(const char* id, void* ctx) {
+    const IconIdSet* keep = (const IconIdSet*)ctx;
+    const bool managed = has_prefix(id, "emoji_") || has_prefix(id, "user_");
+    return managed && !id_set_contains(keep, id);
+}
+
+// Background GC job (icon_store_gc_start). Written by the GC task, read by the status endpoint.
+struct GcJob {
+    IconStoreGcState state;
+    bool cancel;
+    uint32_t scanned;
+    uint32_t deleted;
+    uint32_t bytes_freed;
+    uint32_t elapsed_ms;
+    char message[96];
+    IconIdSet keep;
+};
+
+static GcJob g_gc = {};
+
+// Deletes unused /icons/*.bin files. With the atlas, the kept ones are moved
+// into it and /icons is removed once empty.
+// Files are handled ICON_STORE_GC_BATCH at a time, yielding in between; a
+// cancelled run stops at the next batch boundary.
+static void gc_legacy_icons(const IconIdSet* keep, size_t* deleted, size_t* bytes) {
+    File dir = FFat.open("/icons");
+    if (!dir || !dir.isDirectory()) return;
+
+    bool keeps_files = false;
+    bool cancelled = false;
+    size_t in_batch = 0;
+    File f = dir.openNextFile();
+    while (f) {
+        __atomic_add_fetch(&g_gc.scanned, 1, __ATOMIC_RELAXED);
+        bool handled = false;
+        if (!f.isDirectory()) {
+            const char* name = f.name();
+            const size_t sz = (size_t)f.size();
+
+            const char* base = name ? strrchr(name, '/') : nullptr;
+            base = base ? (base + 1) : name;
+            const char* ext = base ? strrchr(base, '.') : nullptr;
+
+            if (base && ext && strcmp(ext, ".bin") == 0) {
+                const size_t base_len = (size_t)(ext - base);
+                if (base_len > 0 && base_len < (size_t)MACROS_ICON_ID_MAX_LEN) {
+                    char id[64];
+                    memset(id, 0, sizeof(id));
+                    memcpy(id, base, base_len);
+                    id[base_len] = '\0';
+
+                    if (gc_should_drop(id, (void*)keep)) {
+                        char path[96];
+                        snprintf(path, sizeof(path), "/icons/%s.bin", id);
+                        if (FFat.remove(path)) {
+                            fs_health_note_ffat_file((uint32_t)sz, 0);
+                            (*deleted)++;
+                            *bytes += sz;
+                        }
+                    } else {
+#if ICON_STORE_ATLAS
+                        migrate_legacy_icon_file(id, f);
+                        handled = true;
+#endif
+                    }
+                }
+            }
+        }
+        if (!handled) f.close();
+
+        __atomic_store_n(&g_gc.deleted, (uint32_t)*deleted, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_gc.bytes_freed, (uint32_t)*bytes, __ATOMIC_RELAXED);
+        if (++in_batch >= ICON_STORE_GC_BATCH) {
+            in_batch = 0;
+            vTaskDelay(1);
+            if (__atomic_load_n(&g_gc.cancel, __ATOMIC_ACQUIRE)) {
+                cancelled = true;
+                break;
+            }
+        }
+        f = dir.openNextFile();
+    }
+    dir.close();
+    if (cancelled) return;
+
+#if ICON_STORE_ATLAS
+    // Anything left (failed migrations, foreign files) keeps the fallback path alive.
+    dir = FFat.open("/icons");
+    if (dir && dir.isDirectory()) {
+        File rest = dir.openNextFile();
+        keeps_files = (bool)rest;
+        if (rest) rest.close();
+        dir.close();
+    }
+    if (!keeps_files && FFat.rmdir("/icons")) {
+        fs_health_note_ffat_file(1, 0);
+        g_legacy_dir = 0;
+    }
+#else
+    (void)keeps_files;
+#endif
 }
 
 } // namespace
@@ -282,7 +808,7 @@ bool icon_store_ffat_ready() {
     return ensure_ffat();
 }
 
-bool icon_store_lookup(const char* icon_id, IconRef* out) {
+bool icon_store_acquire(const char* icon_id, IconRef* out) {
     if (!out) return false;
 
     // Prefer compiled icons.
@@ -290,15 +816,123 @@ bool icon_store_lookup(const char* icon_id, IconRef* out) {
 
     if (!icon_id || !*icon_id) return false;
 
+#if ICON_PACK_ENABLED
+    // Mapped flash: nothing to load, cache or release.
+    if (const lv_img_dsc_t* dsc = icon_pack_find(icon_id)) {
+        out->dsc = dsc;
+        out->kind = IconKind::Color;
+        return true;
+    }
+#endif
+
     // Cache.
     if (CacheEntry* e = cache_find(icon_id)) {
-        e->last_used_ms = millis();
+        e->refs++;
+        e->last_used = ++g_cache_tick;
+        g_cache_hits++;
         out->dsc = &e->dsc;
         out->kind = IconKind::Color;
         return true;
     }
 
-    return load_icon_file_to_cache(icon_id, out);
+    g_cache_misses++;
+    return load_icon_to_cache(icon_id, out);
+}
+
+void icon_store_release(const lv_img_dsc_t* dsc) {
+    if (!dsc) return;
+
+    // Compiled icons are not in the cache; nothing to do.
+    CacheEntry* e = cache_find_dsc(dsc);
+    if (!e || e->refs == 0) return;
+
+    e->refs--;
+    e->last_used = ++g_cache_tick;
+    if (e->refs == 0) cache_trim();
+}
+
+uint16_t icon_store_trim_unreferenced() {
+    uint16_t evicted = 0;
+    for (auto& e : g_cache) {
+        if (!e.in_use || e.refs != 0) continue;
+        cache_evict(e);
+        evicted++;
+    }
+    return evicted;
+}
+
+bool icon_store_is_loaded(const char* icon_id) {
+    if (!icon_id || !*icon_id) return false;
+    IconRef ref;
+    if (icon_registry_lookup(icon_id, &ref)) return true;
+#if ICON_PACK_ENABLED
+    if (icon_pack_find(icon_id)) return true;
+#endif
+    return cache_find(icon_id) != nullptr;
+}
+
+bool icon_store_preload_read(const char* icon_id, IconStorePreload* out) {
+    if (!out) return false;
+    memset(out, 0, sizeof(*out));
+    if (!is_safe_icon_id(icon_id)) return false;
+    return read_decoded_icon(icon_id, out);
+}
+
+IconStorePreloadResult icon_store_preload_commit(IconStorePreload* icon) {
+    if (!icon || !icon->data) return IconStorePreloadResult::Failed;
+
+    IconStorePreloadResult result = IconStorePreloadResult::Added;
+    if (cache_find(icon->id)) {
+        // Loaded by a screen while we were reading it.
+        result = IconStorePreloadResult::AlreadyLoaded;
+    } else if (g_cache_bytes + icon->data_len > (size_t)ICON_STORE_CACHE_BYTES) {
+        result = IconStorePreloadResult::Full;
+    } else {
+        bool free_slot = false;
+        for (const auto& e : g_cache) {
+            if (!e.in_use) {
+                free_slot = true;
+                break;
+            }
+        }
+        if (!free_slot) result = IconStorePreloadResult::Full;
+    }
+
+    if (result != IconStorePreloadResult::Added) {
+        free_icon_payload(icon->data);
+        icon->data = nullptr;
+        return result;
+    }
+
+    return cache_insert(icon, 0) ? result : IconStorePreloadResult::Failed;
+}
+
+void icon_store_preload_discard(IconStorePreload* icon) {
+    if (!icon) return;
+    free_icon_payload(icon->data);
+    icon->data = nullptr;
+}
+
+void icon_store_get_cache_stats(IconStoreCacheStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+
+    out->slots = ICON_STORE_CACHE_SLOTS;
+    out->budget_bytes = ICON_STORE_CACHE_BYTES;
+    for (const auto& e : g_cache) {
+        if (!e.in_use) continue;
+        out->entries++;
+        if (e.refs) out->referenced++;
+    }
+    out->bytes = g_cache_bytes;
+    out->hits = g_cache_hits;
+    out->misses = g_cache_misses;
+    out->evictions = g_cache_evictions;
+    out->refusals = g_cache_refusals;
+    out->loads = g_cache_loads;
+    out->load_us_total = g_cache_load_us;
+    out->loaded_stored_bytes = g_cache_loaded_stored_bytes;
+    out->loaded_pixel_bytes = g_cache_loaded_pixel_bytes;
 }
 
 bool icon_store_install_blob(const char* icon_id, const uint8_t* blob, size_t blob_len, char* err, size_t err_len) {
@@ -315,42 +949,126 @@ bool icon_store_install_blob(const char* icon_id, const uint8_t* blob, size_t bl
     }
 
     // Validate blob before taking the global icon op lock.
-    if (!blob || blob_len < sizeof(IconFileHeader) || blob_len > (256 * 1024)) {
-        set_err(err, err_len, "Invalid blob");
+    IconBlobInfo info;
+    if (!validate_icon_blob(blob, blob_len, &info, err, err_len)) {
         return false;
     }
 
-    if (!(blob[0] == 'I' && blob[1] == 'C' && blob[2] == 'N' && blob[3] == '1')) {
-        set_err(err, err_len, "Bad magic");
+    if (!icons_begin_op(err, err_len, "Icon operation in progress")) {
         return false;
     }
 
-    const uint16_t w = read_u16_le(blob + 4);
-    const uint16_t h = read_u16_le(blob + 6);
-    const uint8_t fmt = blob[8];
-    const uint32_t data_len = read_u32_le(blob + 12);
+    struct IconsOpGuard {
+        ~IconsOpGuard() { icons_end_op(); }
+    } guard;
 
-    if (fmt != 1) {
-        set_err(err, err_len, "Unsupported format");
+    // NOTE: Do not invalidate cached icon descriptors here.
+    // If an icon is currently being rendered, LVGL may still hold a pointer to
+    // the cached lv_img_dsc_t / data. Freeing it can crash the device.
+    // The updated icon will be picked up on next boot (or after an explicit
+    // cache reset, if implemented in the future).
+
+#if ICON_STORE_ATLAS
+    const IconAtlasItem item = atlas_item_for(icon_id, info, blob);
+    if (!icon_atlas_install(&item, 1, err, err_len)) return false;
+    remove_legacy_icon_file(icon_id);
+    return true;
+#else
+    (void)info;
+    return write_icon_file(icon_id, blob, blob_len, err, err_len);
+#endif
+}
+
+bool icon_store_install_batch(
+    const uint8_t* body,
+    size_t body_len,
+    IconBatchResultFn on_result,
+    void* ctx,
+    size_t* out_installed,
+    char* err,
+    size_t err_len
+) {
+    set_err(err, err_len, "");
+    if (out_installed) *out_installed = 0;
+
+    if (!ensure_ffat()) {
+        set_err(err, err_len, "FFat not available on this partition scheme");
         return false;
     }
-    if (w == 0 || h == 0 || w > 256 || h > 256) {
-        set_err(err, err_len, "Invalid dimensions");
-        return false;
+
+    // Pass 1: framing only. A malformed container rejects the whole request.
+    size_t count = 0;
+    for (size_t off = 0; off < body_len;) {
+        const size_t id_len = body[off];
+        if (id_len == 0 || body_len - off < 1 + id_len + 4) {
+            set_err(err, err_len, "Truncated batch record");
+            return false;
+        }
+        const uint32_t blob_len = read_u32_le(body + off + 1 + id_len);
+        const size_t blob_off = off + 1 + id_len + 4;
+        if (blob_len > body_len - blob_off) {
+            set_err(err, err_len, "Truncated batch record");
+            return false;
+        }
+        count++;
+        off = blob_off + blob_len;
     }
 
-    const size_t expected_payload = (size_t)w * (size_t)h * 3;
-    if (data_len != expected_payload) {
-        set_err(err, err_len, "Unexpected payload size");
+    if (count == 0) {
+        set_err(err, err_len, "Empty batch");
         return false;
     }
 
-    if ((size_t)sizeof(IconFileHeader) + (size_t)data_len != blob_len) {
-        set_err(err, err_len, "Blob length mismatch");
+    struct BatchRecord {
+        char id[MACROS_ICON_ID_MAX_LEN];
+        size_t index;
+        const uint8_t* blob;
+        uint32_t blob_len;
+        IconBlobInfo info;
+    };
+    BatchRecord* recs = (BatchRecord*)malloc(count * sizeof(BatchRecord));
+    if (!recs) {
+        set_err(err, err_len, "Out of memory");
         return false;
     }
 
+    // Pass 2: validate each record; bad ones are reported and skipped.
+    size_t valid = 0;
+    char rerr[96];
+    for (size_t off = 0, i = 0; i < count; i++) {
+        const size_t id_len = body[off];
+        const uint32_t blob_len = read_u32_le(body + off + 1 + id_len);
+        const uint8_t* blob = body + off + 1 + id_len + 4;
+
+        BatchRecord& r = recs[valid];
+        r.id[0] = '\0';
+        if (id_len < sizeof(r.id)) {
+            memcpy(r.id, body + off + 1, id_len);
+            r.id[id_len] = '\0';
+        }
+        off += 1 + id_len + 4 + blob_len;
+
+        if (!is_safe_icon_id(r.id)) {
+            if (on_result) on_result(i, nullptr, false, "Invalid icon id (expected [a-z0-9_]+)", ctx);
+            continue;
+        }
+        if (!validate_icon_blob(blob, blob_len, &r.info, rerr, sizeof(rerr))) {
+            if (on_result) on_result(i, r.id, false, rerr, ctx);
+            continue;
+        }
+        r.index = i;
+        r.blob = blob;
+        r.blob_len = blob_len;
+        valid++;
+    }
+
+    if (valid == 0) {
+        free(recs);
+        return true;
+    }
+
     if (!icons_begin_op(err, err_len, "Icon operation in progress")) {
+        free(recs);
         return false;
     }
 
@@ -358,41 +1076,84 @@ bool icon_store_install_blob(const char* icon_id, const uint8_t* blob, size_t bl
         ~IconsOpGuard() { icons_end_op(); }
     } guard;
 
-    // Ensure /icons exists.
-    if (!FFat.exists("/icons")) {
-        FFat.mkdir("/icons");
+    size_t installed = 0;
+#if ICON_STORE_ATLAS
+    // Pass 3: one atlas append for every valid icon.
+    IconAtlasItem* items = (IconAtlasItem*)malloc(valid * sizeof(IconAtlasItem));
+    if (!items) {
+        free(recs);
+        set_err(err, err_len, "Out of memory");
+        return false;
+    }
+    for (size_t i = 0; i < valid; i++) {
+        items[i] = atlas_item_for(recs[i].id, recs[i].info, recs[i].blob);
     }
 
-    char path[80];
-    snprintf(path, sizeof(path), "/icons/%s.bin", icon_id);
-
-    File f = FFat.open(path, "w");
-    if (!f) {
-        set_err(err, err_len, "Failed to open file for writing");
-        return false;
+    const bool ok = icon_atlas_install(items, valid, rerr, sizeof(rerr));
+    free(items);
+    for (size_t i = 0; i < valid; i++) {
+        if (ok) remove_legacy_icon_file(recs[i].id);
+        if (on_result) on_result(recs[i].index, recs[i].id, ok, ok ? "" : rerr, ctx);
+    }
+    if (ok) installed = valid;
+#else
+    // Pass 3: one file per icon.
+    for (size_t i = 0; i < valid; i++) {
+        const bool ok = write_icon_file(recs[i].id, recs[i].blob, recs[i].blob_len, rerr, sizeof(rerr));
+        if (ok) installed++;
+        if (on_result) on_result(recs[i].index, recs[i].id, ok, ok ? "" : rerr, ctx);
     }
+#endif
 
-    const size_t written = f.write(blob, blob_len);
-    f.close();
+    free(recs);
+    if (out_installed) *out_installed = installed;
+    return true;
+}
 
-    if (written != blob_len) {
-        set_err(err, err_len, "Short write");
-        return false;
+namespace {
+
+static void gc_task_fn(void*) {
+    const uint32_t t0 = millis();
+    size_t deleted = 0;
+    size_t bytes = 0;
+    bool ok = true;
+    char err[96] = "";
+
+#if ICON_STORE_ATLAS
+    // One index rewrite (plus compaction when due); not split into batches.
+    if (!__atomic_load_n(&g_gc.cancel, __ATOMIC_ACQUIRE)) {
+        ok = icon_atlas_remove_if(gc_should_drop, &g_gc.keep, &deleted, &bytes, err, sizeof(err));
+        __atomic_add_fetch(&g_gc.scanned, (uint32_t)icon_atlas_count() + (uint32_t)deleted, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_gc.deleted, (uint32_t)deleted, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_gc.bytes_freed, (uint32_t)bytes, __ATOMIC_RELAXED);
     }
+#endif
 
-    // NOTE: Do not invalidate cached icon descriptors here.
-    // If an icon is currently being rendered, LVGL may still hold a pointer to
-    // the cached lv_img_dsc_t / data. Freeing it can crash the device.
-    // The updated icon will be picked up on next boot (or after an explicit
-    // cache reset, if implemented in the future).
+    if (ok && legacy_icons_present() && !__atomic_load_n(&g_gc.cancel, __ATOMIC_ACQUIRE)) {
+        gc_legacy_icons(&g_gc.keep, &deleted, &bytes);
+    }
 
-    return true;
+    free_icon_payload(g_gc.keep.ids);
+    g_gc.keep.ids = nullptr;
+    strlcpy(g_gc.message, err, sizeof(g_gc.message));
+    __atomic_store_n(&g_gc.elapsed_ms, millis() - t0, __ATOMIC_RELAXED);
+
+    IconStoreGcState state = IconStoreGcState::Done;
+    if (!ok) {
+        state = IconStoreGcState::Failed;
+    } else if (__atomic_load_n(&g_gc.cancel, __ATOMIC_ACQUIRE)) {
+        state = IconStoreGcState::Cancelled;
+    }
+
+    icons_end_op();
+    __atomic_store_n(&g_gc.state, state, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
 }
 
-bool icon_store_gc_unused_from_macros(const MacroConfig* cfg, size_t* out_deleted_count, size_t* out_bytes_freed, char* err, size_t err_len) {
+} // namespace
+
+bool icon_store_gc_start(const MacroConfig* cfg, char* err, size_t err_len) {
     set_err(err, err_len, "");
-    if (out_deleted_count) *out_deleted_count = 0;
-    if (out_bytes_freed) *out_bytes_freed = 0;
 
     if (!cfg) {
         set_err(err, err_len, "Missing macro config");
@@ -404,63 +1165,52 @@ bool icon_store_gc_unused_from_macros(const MacroConfig* cfg, size_t* out_delete
         return false;
     }
 
+    // Held until the GC task finishes; installs meanwhile get "in progress".
     if (!icons_begin_op(err, err_len, "Icon operation in progress")) {
         return false;
     }
 
-    if (!FFat.exists("/icons")) {
-        // Nothing to delete.
+    if (!id_set_build(&g_gc.keep, cfg)) {
         icons_end_op();
-        return true;
+        set_err(err, err_len, "Out of memory");
+        return false;
     }
 
-    File dir = FFat.open("/icons");
-    if (!dir || !dir.isDirectory()) {
+    g_gc.cancel = false;
+    g_gc.scanned = 0;
+    g_gc.deleted = 0;
+    g_gc.bytes_freed = 0;
+    g_gc.elapsed_ms = 0;
+    g_gc.message[0] = '\0';
+    __atomic_store_n(&g_gc.state, IconStoreGcState::Running, __ATOMIC_RELEASE);
+
+    if (xTaskCreate(gc_task_fn, "IconGC", ICON_STORE_GC_STACK_BYTES, nullptr, tskIDLE_PRIORITY + 1, nullptr) != pdPASS) {
+        free_icon_payload(g_gc.keep.ids);
+        g_gc.keep.ids = nullptr;
+        __atomic_store_n(&g_gc.state, IconStoreGcState::Failed, __ATOMIC_RELEASE);
         icons_end_op();
-        return true;
+        set_err(err, err_len, "Failed to start icon GC");
+        return false;
     }
+    return true;
+}
 
-    size_t deleted = 0;
-    size_t bytes = 0;
-
-    File f = dir.openNextFile();
-    while (f) {
-        if (!f.isDirectory()) {
-            const char* name = f.name();
-            const size_t sz = (size_t)f.size();
-
-            const char* base = name ? strrchr(name, '/') : nullptr;
-            base = base ? (base + 1) : name;
-            const char* ext = base ? strrchr(base, '.') : nullptr;
-
-            if (base && ext && strcmp(ext, ".bin") == 0) {
-                const size_t base_len = (size_t)(ext - base);
-                if (base_len > 0 && base_len < (size_t)MACROS_ICON_ID_MAX_LEN) {
-                    char id[64];
-                    memset(id, 0, sizeof(id));
-                    memcpy(id, base, base_len);
-                    id[base_len] = '\0';
-
-                    const bool managed = has_prefix(id, "emoji_") || has_prefix(id, "user_");
-                    if (managed && !macros_use_icon_id(cfg, id)) {
-                        char path[96];
-                        snprintf(path, sizeof(path), "/icons/%s.bin", id);
-                        if (FFat.remove(path)) {
-                            deleted++;
-                            bytes += sz;
-                        }
-                    }
-                }
-            }
-        }
-        f = dir.openNextFile();
+void icon_store_gc_cancel() {
+    if (__atomic_load_n(&g_gc.state, __ATOMIC_ACQUIRE) == IconStoreGcState::Running) {
+        __atomic_store_n(&g_gc.cancel, true, __ATOMIC_RELEASE);
     }
+}
 
-    if (out_deleted_count) *out_deleted_count = deleted;
-    if (out_bytes_freed) *out_bytes_freed = bytes;
-
-    icons_end_op();
-    return true;
+void icon_store_gc_get_status(IconStoreGcStatus* out) {
+    if (!out) return;
+    out->state = __atomic_load_n(&g_gc.state, __ATOMIC_ACQUIRE);
+    out->cancel_requested = __atomic_load_n(&g_gc.cancel, __ATOMIC_RELAXED);
+    out->scanned = __atomic_load_n(&g_gc.scanned, __ATOMIC_RELAXED);
+    out->deleted = __atomic_load_n(&g_gc.deleted, __ATOMIC_RELAXED);
+    out->bytes_freed = __atomic_load_n(&g_gc.bytes_freed, __ATOMIC_RELAXED);
+    out->elapsed_ms = __atomic_load_n(&g_gc.elapsed_ms, __ATOMIC_RELAXED);
+    // Only written before the state leaves Running.
+    strlcpy(out->message, out->state == IconStoreGcState::Running ? "" : g_gc.message, sizeof(out->message));
 }
 
 size_t icon_store_list_installed(char* out_json, size_t out_json_len) {
@@ -472,17 +1222,6 @@ size_t icon_store_list_installed(char* out_json, size_t out_json_len) {
         return 0;
     }
 
-    if (!FFat.exists("/icons")) {
-        strlcpy(out_json, "{\"success\":true,\"source\":\"ffat\",\"icons\":[]}", out_json_len);
-        return 0;
-    }
-
-    File dir = FFat.open("/icons");
-    if (!dir || !dir.isDirectory()) {
-        strlcpy(out_json, "{\"success\":true,\"source\":\"ffat\",\"icons\":[]}", out_json_len);
-        return 0;
-    }
-
     // Very small JSON builder (bounded output).
     size_t count = 0;
     size_t used = 0;
@@ -502,8 +1241,37 @@ size_t icon_store_list_installed(char* out_json, size_t out_json_len) {
 
     append("{\"success\":true,\"source\":\"ffat\",\"icons\":[");
 
-    File f = dir.openNextFile();
     bool first = true;
+    auto append_item = [&](const char* id) -> bool {
+        char item[120];
+        // Icon ids are restricted to [a-z0-9_]+, so no escaping needed.
+        snprintf(item, sizeof(item), "{\"id\":\"%s\",\"kind\":\"color\"}", id);
+
+        if (!first) {
+            if (!append(",")) return false;
+        }
+        if (!append(item)) return false;
+        first = false;
+        count++;
+        return true;
+    };
+
+#if ICON_STORE_ATLAS
+    // Atlas listing comes from the RAM index.
+    const size_t atlas_count = icon_atlas_count();
+    for (size_t i = 0; i < atlas_count && !overflow; i++) {
+        char id[MACROS_ICON_ID_MAX_LEN];
+        if (!icon_atlas_id_at(i, id, sizeof(id))) break;
+        if (!append_item(id)) break;
+    }
+#endif
+
+    File dir;
+    if (legacy_icons_present()) {
+        dir = FFat.open("/icons");
+    }
+
+    File f = (dir && dir.isDirectory()) ? dir.openNextFile() : File();
     while (f && !overflow) {
         if (!f.isDirectory()) {
             const char* name = f.name();
@@ -519,16 +1287,7 @@ size_t icon_store_list_installed(char* out_json, size_t out_json_len) {
                     memcpy(tmp, base, base_len);
                     tmp[base_len] = '\0';
 
-                    char item[120];
-                    // `tmp` is derived from filename and restricted to [a-z0-9_]+, so no escaping needed.
-                    snprintf(item, sizeof(item), "{\"id\":\"%s\",\"kind\":\"color\"}", tmp);
-
-                    if (!first) {
-                        if (!append(",")) break;
-                    }
-                    if (!append(item)) break;
-                    first = false;
-                    count++;
+                    if (!append_item(tmp)) break;
                 }
             }
         }
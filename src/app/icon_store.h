@@ -14,36 +14,152 @@
 extern "C" {
 #endif
 
-// Looks up a compiled icon first; if not found, tries to load a cached icon from FFat.
-// Returns true on success.
-bool icon_store_lookup(const char* icon_id, IconRef* out);
+// Looks up a compiled icon first; if not found, finds or loads the icon from
+// FFat into the icon cache and takes a reference on it. Returns true on success.
+// Call icon_store_release(out->dsc) once no lv_img shows it any more; until
+// then the cache will not evict it. LVGL task only.
+bool icon_store_acquire(const char* icon_id, IconRef* out);
+
+// Drops a reference taken by icon_store_acquire (no-op for compiled icons and nullptr).
+void icon_store_release(const lv_img_dsc_t* dsc);
+
+struct IconStoreCacheStats {
+    uint16_t slots;
+    uint16_t entries;      // icons loaded from FFat
+    uint16_t referenced;   // ... currently shown by at least one lv_img
+    size_t bytes;          // pixel data held
+    size_t budget_bytes;   // ICON_STORE_CACHE_BYTES (unreferenced icons above it are evicted)
+    uint32_t hits;
+    uint32_t misses;       // FFat loads
+    uint32_t evictions;
+    uint32_t refusals;     // loads dropped because every slot was referenced
+    uint32_t loads;        // icons read (and decoded) from FFat
+    uint32_t load_us_total;
+    uint32_t loaded_stored_bytes;  // bytes read from FFat for those loads
+    uint32_t loaded_pixel_bytes;   // RGB565+A8 bytes they expanded to
+};
+
+void icon_store_get_cache_stats(IconStoreCacheStats* out);
+
+// Memory pressure: evict every icon no lv_img shows. Returns the number
+// evicted. LVGL task only.
+uint16_t icon_store_trim_unreferenced();
+
+// Background warm-up (icon_warmup.h): the FFat read and decode run on the
+// calling task, only the commit touches the cache.
+struct IconStorePreload {
+    char id[32];
+    uint8_t* data;         // RGB565+A8, owned until committed or discarded
+    size_t data_len;
+    uint16_t width;
+    uint16_t height;
+    uint32_t stored_len;
+    uint32_t load_us;
+};
+
+enum class IconStorePreloadResult : uint8_t {
+    Added = 0,
+    AlreadyLoaded = 1,
+    Full = 2,      // no free slot or byte budget left (nothing was evicted)
+    Failed = 3,
+};
+
+// True for compiled icons and icons already in the cache. LVGL task only.
+bool icon_store_is_loaded(const char* icon_id);
+
+// Reads and decodes an installed icon. Any task; touches no cache state.
+bool icon_store_preload_read(const char* icon_id, IconStorePreload* out);
+
+// Adds a preloaded icon to the cache without a reference, so it is the first
+// to go when space is needed. Never evicts. Frees icon->data unless Added.
+// LVGL task only.
+IconStorePreloadResult icon_store_preload_commit(IconStorePreload* icon);
+
+void icon_store_preload_discard(IconStorePreload* icon);
 
 // Returns true if FFat is available for icon persistence.
 bool icon_store_ffat_ready();
 
 // Installs (stores) a pre-converted icon blob.
-// Expected format:
-// - header: magic "ICN1" (4 bytes)
-// - width (u16 LE)
-// - height (u16 LE)
-// - format (u8): 1 = RGB565+Alpha (LV_IMG_CF_TRUE_COLOR_ALPHA-compatible, 3 bytes/pixel)
-// - reserved (3 bytes)
+// Expected format (16-byte header, then data_len bytes):
+// - magic "ICN1" or "ICN2" (4 bytes)
+// - width (u16 LE), height (u16 LE), at most 256
+// - format (u8):
+//     1 = RGB565 LE + A8, 3 bytes/pixel (LV_IMG_CF_TRUE_COLOR_ALPHA-compatible)
+//     2 = palette (ICN2 only): palette_count RGB565 LE + A8 entries (3 bytes each),
+//         then one index byte per pixel
+// - encoding (u8, ICN2; reserved in ICN1) of the pixel/index stream
+//   (the palette is never compressed):
+//     0 = raw, 1 = RLE (PackBits over 3-byte pixels / index bytes, see
+//     pixel_codec.h), 2 = LZ4 block
+// - palette_count (u16 LE, ICN2 format 2: 1..256; reserved otherwise)
 // - data_len (u32 LE)
-// - data payload
 //
-// Writes to /icons/<icon_id>.bin on FFat.
+// Every format is expanded to RGB565+A8 when the icon is loaded, so LVGL can
+// still zoom it; compression saves FFat space and read time, not RAM.
+//
+// Writes into the packed icon atlas on FFat (ICON_STORE_ATLAS, see icon_atlas.h),
+// otherwise to /icons/<icon_id>.bin.
 bool icon_store_install_blob(const char* icon_id, const uint8_t* blob, size_t blob_len, char* err, size_t err_len);
 
-// Lists installed icon IDs (filenames under /icons/*.bin). Returns count written.
+// Per-record outcome of icon_store_install_batch. id is nullptr when the
+// record's id is not a valid icon id; message is "" on success.
+typedef void (*IconBatchResultFn)(size_t index, const char* id, bool ok, const char* message, void* ctx);
+
+// Installs several blobs with one atlas append. The body is a sequence of
+// records: u8 id_len, id bytes, u32 blob_len (LE), blob (as above).
+// Every record is validated before anything is written; invalid records are
+// reported through on_result and skipped, the rest are installed together.
+// Returns false (nothing written) only for a malformed body or a busy/unavailable store.
+bool icon_store_install_batch(
+    const uint8_t* body,
+    size_t body_len,
+    IconBatchResultFn on_result,
+    void* ctx,
+    size_t* out_installed,
+    char* err,
+    size_t err_len
+);
+
+// Lists installed icon IDs (atlas index, then any /icons/*.bin files). Returns count written.
 size_t icon_store_list_installed(char* out_json, size_t out_json_len);
 
-// Deletes unused installed icons under /icons/*.bin based on the current macro configuration.
+// Deletes unused installed icons (atlas entries and /icons/*.bin) based on the current macro configuration.
 // Policy:
 // - Only considers deleting managed prefixes (currently "emoji_" and "user_")
 // - Keeps any icon IDs referenced by macro buttons where icon.type is Emoji or Asset
 //
-// Returns true on success. On failure, returns false and writes a short error message to `err`.
-bool icon_store_gc_unused_from_macros(const MacroConfig* cfg, size_t* out_deleted_count, size_t* out_bytes_freed, char* err, size_t err_len);
+// With the atlas, kept /icons/*.bin files are moved into it, and the atlas is
+// compacted once enough dead space has built up.
+//
+// Runs as a background task: icon_store_gc_start snapshots the referenced ids
+// and returns; progress and the result come from icon_store_gc_get_status.
+// Other icon operations are refused until it finishes.
+enum class IconStoreGcState : uint8_t {
+    Idle = 0,
+    Running = 1,
+    Done = 2,
+    Cancelled = 3,
+    Failed = 4,
+};
+
+struct IconStoreGcStatus {
+    IconStoreGcState state;
+    bool cancel_requested;
+    uint32_t scanned;      // icons looked at so far
+    uint32_t deleted;
+    uint32_t bytes_freed;
+    uint32_t elapsed_ms;   // of the last finished run
+    char message[96];      // error text when Failed
+};
+
+// Returns false (with err) when a GC or another icon operation is already running.
+bool icon_store_gc_start(const MacroConfig* cfg, char* err, size_t err_len);
+
+// Stops a running GC at its next batch boundary (already deleted icons stay deleted).
+void icon_store_gc_cancel();
+
+void icon_store_gc_get_status(IconStoreGcStatus* out);
 
 #ifdef __cplusplus
 }
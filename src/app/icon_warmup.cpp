@@ -0,0 +1,183 @@
+/*
+ * Icon Warm-up Implementation
+ */
+
+#include "icon_warmup.h"
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_STORE_WARMUP
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#include "display_manager.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
+#include "icon_store.h"
+#include "log_manager.h"
+#include "memory_pressure.h"
+#include "ota_quiet.h"
+
+#ifndef ICON_WARMUP_STACK_BYTES
+#define ICON_WARMUP_STACK_BYTES 4096
+#endif
+
+// Pause between icons so touch and rendering get the CPU and the FFat lock.
+#ifndef ICON_WARMUP_GAP_MS
+#define ICON_WARMUP_GAP_MS 2
+#endif
+
+namespace {
+
+static const size_t kMaxIds = (size_t)MACROS_SCREEN_COUNT * (size_t)MACROS_BUTTONS_PER_SCREEN;
+
+struct WarmupList {
+    const MacroConfig* cfg;
+    size_t count;
+    char ids[kMaxIds][MACROS_ICON_ID_MAX_LEN];
+};
+
+static TaskHandle_t g_task = nullptr;
+static bool g_started = false;
+static IconWarmupStats g_stats = {};
+
+// Same normalization MacroPadScreen applies before icon_store_acquire.
+static bool normalize_id(const char* in, char* out, size_t out_len) {
+    size_t w = 0;
+    while (*in == ' ' || *in == '\t') in++;
+    for (; *in && w + 1 < out_len; in++) {
+        char c = *in;
+        if (c == '-') c = '_';
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        out[w++] = c;
+    }
+    while (w > 0 && (out[w - 1] == ' ' || out[w - 1] == '\t' || out[w - 1] == '\r' || out[w - 1] == '\n')) w--;
+    out[w] = '\0';
+    return w > 0;
+}
+
+static void add_screen(WarmupList* list, const MacroConfig* cfg, size_t screen) {
+    for (size_t b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+        const MacroButtonIcon& icon = cfg->buttons[screen][b].icon;
+        // Builtin icons are compiled; only installed ones live on FFat.
+        if (icon.type != MacroIconType::Emoji && icon.type != MacroIconType::Asset) continue;
+
+        char id[MACROS_ICON_ID_MAX_LEN];
+        if (!normalize_id(icon.id, id, sizeof(id))) continue;
+
+        bool seen = false;
+        for (size_t i = 0; i < list->count; i++) {
+            if (strcmp(list->ids[i], id) == 0) {
+                seen = true;
+                break;
+            }
+        }
+        if (!seen) strlcpy(list->ids[list->count++], id, MACROS_ICON_ID_MAX_LEN);
+    }
+}
+
+static void warmup_task_fn(void* arg) {
+    WarmupList* list = (WarmupList*)arg;
+    const uint32_t t0 = millis();
+
+    // The other screens may still be loading (BOOT_MACROS_LAZY).
+    macros_config_ensure_loaded();
+    for (size_t s = 1; s < MACROS_SCREEN_COUNT; s++) {
+        add_screen(list, list->cfg, s);
+    }
+    __atomic_store_n(&g_stats.queued, (uint16_t)list->count, __ATOMIC_RELAXED);
+
+    for (size_t i = 0; i < list->count; i++) {
+        const char* id = list->ids[i];
+
+        // FFat reads and decodes wait out a firmware update.
+        while (ota_quiet_active()) vTaskDelay(pdMS_TO_TICKS(250));
+
+        // Icons load on demand anyway; do not fill the cache under pressure.
+        if (memory_pressure_tier() >= MemPressureTier::Caches) {
+            Logger.logLine("IconWarmup: stopped (memory pressure)");
+            break;
+        }
+
+        display_manager_lock();
+        const bool loaded = icon_store_is_loaded(id);
+        display_manager_unlock();
+        if (loaded) {
+            __atomic_add_fetch(&g_stats.skipped, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        IconStorePreload icon;
+        if (!icon_store_preload_read(id, &icon)) {
+            __atomic_add_fetch(&g_stats.failed, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        display_manager_lock();
+        const IconStorePreloadResult result = icon_store_preload_commit(&icon);
+        display_manager_unlock();
+
+        if (result == IconStorePreloadResult::Added) {
+            __atomic_add_fetch(&g_stats.loaded, 1, __ATOMIC_RELAXED);
+        } else if (result == IconStorePreloadResult::AlreadyLoaded) {
+            __atomic_add_fetch(&g_stats.skipped, 1, __ATOMIC_RELAXED);
+        } else if (result == IconStorePreloadResult::Full) {
+            __atomic_store_n(&g_stats.budget_full, true, __ATOMIC_RELAXED);
+            break;
+        } else {
+            __atomic_add_fetch(&g_stats.failed, 1, __ATOMIC_RELAXED);
+        }
+
+        __atomic_store_n(&g_stats.elapsed_ms, millis() - t0, __ATOMIC_RELAXED);
+        vTaskDelay(pdMS_TO_TICKS(ICON_WARMUP_GAP_MS));
+    }
+
+    __atomic_store_n(&g_stats.elapsed_ms, millis() - t0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_stats.running, false, __ATOMIC_RELEASE);
+    Logger.logLinef("IconWarmup: %u loaded, %u skipped, %u failed in %lu ms%s",
+        (unsigned)g_stats.loaded, (unsigned)g_stats.skipped, (unsigned)g_stats.failed,
+        (unsigned long)g_stats.elapsed_ms, g_stats.budget_full ? " (cache full)" : "");
+
+    heap_tag_free(HeapTag::Icons, list);
+    g_task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+} // namespace
+
+void icon_warmup_start(const MacroConfig* cfg) {
+    if (!cfg || g_started) return;
+    g_started = true;
+
+    // Snapshot the ids before warming: the config may be replaced (portal save)
+    // while the task runs. The default screen's now (app.ino shows macro1 once
+    // setup completes), the others on the task once they are loaded.
+    WarmupList* list = (WarmupList*)heap_place_malloc(HeapClass::Transient, HeapTag::Icons, sizeof(WarmupList));
+    if (!list) return;
+    list->cfg = cfg;
+    list->count = 0;
+    add_screen(list, cfg, 0);
+    g_stats.queued = (uint16_t)list->count;
+
+    g_stats.running = true;
+    // Below the LVGL task (priority 1), so it only runs when rendering and input are idle.
+    if (xTaskCreate(warmup_task_fn, "IconWarmup", ICON_WARMUP_STACK_BYTES, list, tskIDLE_PRIORITY, &g_task) != pdPASS) {
+        g_stats.running = false;
+        g_task = nullptr;
+        heap_tag_free(HeapTag::Icons, list);
+        Logger.logMessage("IconWarmup", "Failed to create task");
+    }
+}
+
+void icon_warmup_get_stats(IconWarmupStats* out) {
+    if (!out) return;
+    out->running = __atomic_load_n(&g_stats.running, __ATOMIC_ACQUIRE);
+    out->queued = g_stats.queued;
+    out->loaded = __atomic_load_n(&g_stats.loaded, __ATOMIC_RELAXED);
+    out->skipped = __atomic_load_n(&g_stats.skipped, __ATOMIC_RELAXED);
+    out->failed = __atomic_load_n(&g_stats.failed, __ATOMIC_RELAXED);
+    out->budget_full = __atomic_load_n(&g_stats.budget_full, __ATOMIC_RELAXED);
+    out->elapsed_ms = __atomic_load_n(&g_stats.elapsed_ms, __ATOMIC_RELAXED);
+}
+
+#endif // HAS_DISPLAY && HAS_ICONS && ICON_STORE_WARMUP
@@ -0,0 +1,47 @@
+/*
+ * Icon Warm-up
+ *
+ * Loads the installed (FFat) icons referenced by the macro screens into the
+ * icon cache from a low-priority task at boot, so the first visit to each
+ * screen does not read and decode them inside MacroPadScreen::refreshButtons.
+ *
+ * Order: the default screen (macro1) first, then the other screens, buttons
+ * in order; each id once. Compiled icons need no warm-up. The FFat read and
+ * decode run on the warm-up task; only the cache insert takes the LVGL lock.
+ * Warm-up stops once the cache has no free slot or byte budget left
+ * (it never evicts), and loaded icons stay unreferenced, so screens can
+ * still evict them.
+ *
+ * Builtin mask icons are compiled, and their 2x masks depend on the laid-out
+ * icon box and use the screen's few non-evicting slots, so they are left to
+ * the screens.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_DISPLAY && HAS_ICONS && ICON_STORE_WARMUP
+
+#include <stdint.h>
+
+#include "macros_config.h"
+
+struct IconWarmupStats {
+    bool running;
+    uint16_t queued;     // distinct installed icon ids found in the config
+    uint16_t loaded;     // added to the cache
+    uint16_t skipped;    // already loaded (compiled, or a screen got there first)
+    uint16_t failed;     // not installed or unreadable
+    bool budget_full;    // stopped early: the cache had no room left
+    uint32_t elapsed_ms;
+};
+
+// Snapshot the icon ids from cfg and start the warm-up task (once per boot).
+// Call after macros_config_load_lazy and display_manager_init; the task waits
+// for the other screens before reading their ids.
+void icon_warmup_start(const MacroConfig* cfg);
+
+void icon_warmup_get_stats(IconWarmupStats* out);
+
+#endif // HAS_DISPLAY && HAS_ICONS && ICON_STORE_WARMUP
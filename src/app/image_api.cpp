@@ -7,12 +7,30 @@
 
 #include "board_config.h"
 
+#define LOGGER_MODULE_LEVEL LOG_LEVEL_IMAGE
+
 #if HAS_IMAGE_API
 
 #include "image_api.h"
+#include "image_playlist.h"
+#include "image_pool.h"
+#include "image_profile.h"
+#include "jpeg_engine.h"
+#include "jpeg_parallel.h"
 #include "jpeg_preflight.h"
+#include "rgb565_codec.h"
+#include "rgb888_pack.h"
+#include "tls_client.h"
+#include "image_tiles.h"
+#include "image_ws.h"
+#include "image_mcast.h"
 #include "log_manager.h"
+#include "trace.h"
+#include "web_portal_admission.h"
+#include "web_portal_body.h"
 #include "device_telemetry.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
 
 #if HAS_DISPLAY
 #include "display_manager.h"
@@ -22,37 +40,49 @@
 #include <ESPAsyncWebServer.h>
 #include <WiFi.h>
 #include <WiFiClient.h>
-#include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
 #include <string.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/portmacro.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
 
 #include "lvgl_jpeg_decoder.h"
 
 #include <esp_heap_caps.h>
 #include <soc/soc_caps.h>
 
-static void* image_api_alloc(size_t size) {
-    if (size == 0) return nullptr;
-
-#if SOC_SPIRAM_SUPPORTED
-    // Prefer PSRAM to reduce internal heap pressure when available.
-    void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
-    if (p) return p;
+#if IMAGE_API_MULTICAST
+#include <errno.h>
+#include <lwip/sockets.h>
 #endif
 
-    // Fallback: any 8-bit heap.
-    // On some no-PSRAM boards, using INTERNAL|8BIT can exclude viable 8-bit regions.
-    // Using 8BIT matches ESP.getFreeHeap() behavior and can reduce pressure on the
-    // internal heap reserved for decode-time allocations.
-    return heap_caps_malloc(size, MALLOC_CAP_8BIT);
+static void* image_api_alloc(size_t size) {
+    // Lives until the image is decoded.
+    return heap_place_malloc(HeapClass::Transient, HeapTag::Image, size);
 }
 
 static void image_api_free(void* p) {
     if (!p) return;
-    heap_caps_free(p);
+    if (image_pool_release(p)) return;
+    heap_tag_free(HeapTag::Image, p);
+}
+
+// Buffer for a compressed image body: a pool slot when the pool serves this
+// size, else the heap. When the pool is full, returns nullptr and sets *refusal.
+static void* image_api_lease(size_t size, const char** refusal) {
+    if (refusal) *refusal = nullptr;
+    if (image_pool_enabled()) {
+        void* p = image_pool_lease(size);
+        if (p) return p;
+        if (image_pool_fits(size)) {
+            if (refusal) *refusal = "Image buffer pool full";
+            return nullptr;
+        }
+        // Larger than a slot: not pooled.
+    }
+    return image_api_alloc(size);
 }
 
 static size_t image_api_no_psram_effective_headroom_bytes(size_t base_headroom, size_t free_heap, size_t largest_block) {
@@ -88,19 +118,24 @@ static size_t image_api_no_psram_effective_headroom_bytes(size_t base_headroom,
 // ===== Internal state =====
 
 static ImageApiConfig g_cfg;
-static ImageApiBackend g_backend = {nullptr, nullptr, nullptr};
+static ImageApiBackend g_backend = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
 static bool (*g_auth_gate)(AsyncWebServerRequest* request) = nullptr;
 
 // Image upload buffer (allocated temporarily during upload)
 static uint8_t* image_upload_buffer = nullptr;
 static size_t image_upload_size = 0;
 static unsigned long image_upload_timeout_ms = 10000;
+static bool image_upload_center = true;
+static bool image_upload_parallel = true;
+static ImageProfileSpan image_upload_profile = {};  // receive/alloc/preflight of the buffered upload
+static uint32_t image_upload_start_us = 0;
 
 // Upload state tracking
 enum UploadState {
     UPLOAD_IDLE = 0,
     UPLOAD_IN_PROGRESS,
-    UPLOAD_READY_TO_DISPLAY
+    UPLOAD_READY_TO_DISPLAY,
+    UPLOAD_STREAMING  // Body is decoded by the main loop while it arrives
 };
 static volatile UploadState upload_state = UPLOAD_IDLE;
 static volatile unsigned long pending_op_id = 0;  // Incremented when new op is queued
@@ -112,8 +147,13 @@ struct PendingImageOp {
     bool dismiss;  // true = dismiss current image, false = show new image
     unsigned long timeout_ms;  // Display timeout in milliseconds
     unsigned long start_time;  // Time when upload completed (for accurate timeout)
+    bool center;  // scaled-down images: centre (true) or top-left
+    bool parallel;  // allow the dual-core decode (?parallel=0 opts out)
+    const char* profile_kind;  // profiler label ("upload", "url")
+    ImageProfileSpan profile;  // stages measured before the worker took the job
+    JpegHeader header;  // parsed by the upload preflight; found = false when not parsed yet
 };
-static PendingImageOp pending_image_op = {nullptr, 0, false, 10000, 0};
+static PendingImageOp pending_image_op = {nullptr, 0, false, 10000, 0, true, true};
 
 // Strip upload state (buffering during HTTP upload)
 static uint8_t* current_strip_buffer = nullptr;
@@ -129,8 +169,49 @@ struct PendingStripOp {
     int total_strips;
     unsigned long timeout_ms;
     unsigned long start_time;
+
+    // Raw RGB565 rectangles (/api/display/image/raw) and tile batches
+    // (/api/display/image/tiles) share the queue. For a rectangle,
+    // image_width x image_height is its size.
+    uint8_t kind;  // StripOpKind
+    uint8_t encoding;  // Rgb565Encoding
+    bool big_endian;
+    int x;
+    int y;
+    bool has_timeout;  // Partial updates only restart the timeout if one was given
 };
-static PendingStripOp pending_strip_op = {nullptr, 0, 0, 0, 0, 0, 10000, 0};
+enum StripOpKind : uint8_t {
+    STRIP_OP_JPEG = 0,
+    STRIP_OP_RECT,
+    STRIP_OP_TILES,
+};
+// Strips waiting for decode. Producers (AsyncTCP handlers, and the multicast
+// receiver task with IMAGE_API_MULTICAST) fill the slot at the tail and then
+// publish it under strip_queue_push_mux; the single consumer (image worker or
+// main loop) frees the slot at the head and then releases it. Receiving strip
+// N+1 therefore overlaps decoding strip N.
+static PendingStripOp strip_queue[IMAGE_STRIP_PIPELINE_DEPTH];
+static uint32_t strip_queue_head = 0;
+static uint32_t strip_queue_tail = 0;
+static portMUX_TYPE strip_queue_push_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t strip_queue_count() {
+    return __atomic_load_n(&strip_queue_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&strip_queue_head, __ATOMIC_ACQUIRE);
+}
+
+// Queue op at the tail; the queue then owns op.buffer. False while another
+// upload runs or the queue is full (the caller still owns the buffer).
+static bool strip_queue_push(const PendingStripOp& op) {
+    portENTER_CRITICAL(&strip_queue_push_mux);
+    const bool ok = upload_state == UPLOAD_IDLE && strip_queue_count() < IMAGE_STRIP_PIPELINE_DEPTH;
+    if (ok) {
+        const uint32_t tail = __atomic_load_n(&strip_queue_tail, __ATOMIC_RELAXED);
+        strip_queue[tail % IMAGE_STRIP_PIPELINE_DEPTH] = op;
+        __atomic_store_n(&strip_queue_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+    portEXIT_CRITICAL(&strip_queue_push_mux);
+    return ok;
+}
 
 // URL download state (queued by HTTP handler, executed in main loop)
 static constexpr size_t IMAGE_API_URL_MAX_LEN = 256;
@@ -138,30 +219,121 @@ struct PendingUrlOp {
     bool active;
     char url[IMAGE_API_URL_MAX_LEN];
     unsigned long timeout_ms;
+    bool center;
 };
-static PendingUrlOp pending_url_op = {false, {0}, 0};
+static PendingUrlOp pending_url_op = {false, {0}, 0, true};
 
 // AsyncWebServer handlers run on the AsyncTCP task; the main loop consumes this op.
 // Protect cross-task publication/consumption so we don't read stale url/timeout_ms.
 static portMUX_TYPE pending_url_op_mux = portMUX_INITIALIZER_UNLOCKED;
 
-// Small body buffer for /api/display/image_url to avoid heap allocation.
-// AsyncWebServer body callbacks can be interrupted by client disconnects; keeping this static
-// prevents leaks. We also add a timeout so a stalled upload doesn't block future requests.
-static bool image_url_body_in_use = false;
-static size_t image_url_body_expected_len = 0;
-static unsigned long image_url_body_start_ms = 0;
+// Largest JSON body accepted by /api/display/image_url and /api/display/stream.
 static constexpr size_t IMAGE_URL_BODY_MAX_SIZE = 1024;
-static char image_url_body_buf[IMAGE_URL_BODY_MAX_SIZE + 1];
+
+// Bumped whenever the direct image screen starts showing new content.
+static uint32_t image_session_seq = 0;
 
 // Track partial uploads so we can reclaim memory if the client disconnects mid-transfer.
 static unsigned long image_upload_start_ms = 0;
 static unsigned long strip_upload_last_activity_ms = 0;
 
+// Deferred image work. The payload of each job stays in its pending_* slot above
+// (every slot is single-entry and guarded by upload_state); a job records what was
+// queued and when, and wakes whoever consumes it (worker task or main loop).
+enum ImageJobType : uint8_t {
+    IMAGE_JOB_NONE = 0,
+    IMAGE_JOB_UPLOAD,
+    IMAGE_JOB_STREAM,
+    IMAGE_JOB_URL,
+    IMAGE_JOB_STRIP,
+    IMAGE_JOB_DISMISS,
+    IMAGE_JOB_MJPEG,
+};
+
+static const char* image_job_name(uint8_t type) {
+    switch (type) {
+        case IMAGE_JOB_UPLOAD: return "upload";
+        case IMAGE_JOB_STREAM: return "stream";
+        case IMAGE_JOB_URL: return "url";
+        case IMAGE_JOB_STRIP: return "strip";
+        case IMAGE_JOB_DISMISS: return "dismiss";
+        case IMAGE_JOB_MJPEG: return "mjpeg";
+        default: return nullptr;
+    }
+}
+
+struct ImageJob {
+    uint8_t type;
+    unsigned long enqueued_ms;
+};
+
+static ImageApiWorkerStats image_job_stats = {};
+static portMUX_TYPE image_job_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+#if IMAGE_API_WORKER_ENABLED
+static QueueHandle_t image_job_queue = nullptr;
+static TaskHandle_t image_worker_task = nullptr;
+static volatile bool image_worker_ota_in_progress = false;
+static void image_api_start_worker();
+#endif
+
+// Hand a queued job to the consumer. Never blocks (called from AsyncTCP handlers).
+static void image_api_notify_job(ImageJobType type) {
+#if IMAGE_API_WORKER_ENABLED
+    if (image_job_queue) {
+        const ImageJob job = {(uint8_t)type, millis()};
+        // If the queue is full the worker is already awake; the slot still holds the payload.
+        const bool queued = (xQueueSend(image_job_queue, &job, 0) == pdTRUE);
+        portENTER_CRITICAL(&image_job_stats_mux);
+        if (queued) {
+            image_job_stats.jobs_queued++;
+        } else {
+            image_job_stats.jobs_coalesced++;
+        }
+        portEXIT_CRITICAL(&image_job_stats_mux);
+        return;
+    }
+#endif
+    (void)type;
+    portENTER_CRITICAL(&image_job_stats_mux);
+    image_job_stats.jobs_queued++;
+    portEXIT_CRITICAL(&image_job_stats_mux);
+}
+
+#if IMAGE_API_STREAM_UPLOAD
+// Streaming upload session: the AsyncTCP task writes body chunks into a small ring,
+// the main loop decodes from it. The session ends (UPLOAD_IDLE) once both sides are done.
+static ImageStreamRing upload_stream;
+static AsyncWebServerRequest* upload_stream_request = nullptr;  // Owner of the session
+static volatile bool upload_stream_decode_pending = false;
+static volatile bool upload_stream_stalled = false;
+static bool upload_stream_producer_done = false;
+static bool upload_stream_consumer_done = false;
+static bool upload_stream_ok = false;
+static char upload_stream_error[96];
+static volatile unsigned long upload_stream_last_activity_ms = 0;
+static portMUX_TYPE upload_stream_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Flow control: while the ring is nearly full the upload connection stops
+// opening its TCP window (ackLater). AsyncClient is not thread-safe, so only
+// the AsyncTCP task touches the client and these (held_ms is read for the log).
+static AsyncClient* upload_stream_client = nullptr;
+static bool upload_stream_held = false;
+static unsigned long upload_stream_held_since_ms = 0;
+static volatile uint32_t upload_stream_held_ms = 0;
+#endif
+
 static bool is_jpeg_magic(const uint8_t* buf, size_t sz) {
     return (buf && sz >= 3 && buf[0] == 0xFF && buf[1] == 0xD8 && buf[2] == 0xFF);
 }
 
+// 507 for a body buffer that could not be leased (pool full or out of memory).
+static void send_lease_failure(AsyncWebServerRequest* request, const char* refusal) {
+    char resp[96];
+    snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", refusal ? refusal : "Out of memory");
+    request->send(507, "application/json", resp);
+}
+
 static unsigned long parse_timeout_ms(AsyncWebServerRequest* request) {
     // Parse optional timeout parameter from query string (e.g., ?timeout=30)
     unsigned long timeout_seconds = g_cfg.default_timeout_ms / 1000;
@@ -175,6 +347,20 @@ static unsigned long parse_timeout_ms(AsyncWebServerRequest* request) {
     return timeout_seconds * 1000UL;
 }
 
+// Optional ?center=0 places an image smaller than the panel (or scaled down to
+// fit it) at the top-left corner instead of centering it.
+static bool parse_center(AsyncWebServerRequest* request) {
+    if (!request->hasParam("center")) return true;
+    return request->getParam("center")->value() != "0";
+}
+
+// Optional ?parallel=0 keeps a full upload on the single-core strip decoder
+// (A/B benchmarking of the dual-core path).
+static bool parse_parallel(AsyncWebServerRequest* request) {
+    if (!request->hasParam("parallel")) return true;
+    return request->getParam("parallel")->value() != "0";
+}
+
 static bool starts_with_ignore_case(const char* s, const char* prefix) {
     if (!s || !prefix) return false;
     while (*prefix) {
@@ -275,17 +461,136 @@ static bool parse_http_or_https_url(
     return true;
 }
 
-static bool download_jpeg_to_buffer(
+// One HTTP(S) connection to scheme://host:port; both transports live here so
+// either can be used.
+struct UrlConn {
+    TlsClient tls;
+    WiFiClient plain;
+    Client* client = nullptr;  // the open transport, nullptr when closed
+    UrlScheme scheme = URL_SCHEME_HTTPS;
+    uint16_t port = 0;
+    char host[128] = {0};
+    bool leased = false;
+    unsigned long idle_since_ms = 0;
+
+    void close() {
+        if (client) client->stop();
+        client = nullptr;
+    }
+};
+
+#if IMAGE_API_URL_KEEPALIVE_CONNS > 0
+// Keep-alive connections for image_url and playlist fetches. Only the task
+// that runs image_api_run_pending() touches them. An idle one holds its
+// socket (and TLS buffers) for IMAGE_API_URL_KEEPALIVE_IDLE_MS.
+static UrlConn url_pool[IMAGE_API_URL_KEEPALIVE_CONNS];
+static uint32_t url_pool_opened = 0;
+static uint32_t url_pool_reused = 0;
+
+static void url_pool_expire(bool all) {
+    for (UrlConn& c : url_pool) {
+        if (c.leased || !c.client) continue;
+        if (all || (unsigned long)(millis() - c.idle_since_ms) >= IMAGE_API_URL_KEEPALIVE_IDLE_MS) c.close();
+    }
+}
+
+// A connection for scheme://host:port: an idle open one when there is one,
+// else a closed slot (the oldest idle connection is closed to make room).
+// nullptr when every slot is leased.
+static UrlConn* url_pool_lease(UrlScheme scheme, const char* host, uint16_t port) {
+    UrlConn* spare = nullptr;
+    for (UrlConn& c : url_pool) {
+        if (c.leased) continue;
+        if (c.client && c.scheme == scheme && c.port == port && strcmp(c.host, host) == 0) {
+            c.leased = true;
+            return &c;
+        }
+        if (!spare || (!c.client && spare->client) ||
+            (c.client && spare->client && (long)(c.idle_since_ms - spare->idle_since_ms) < 0)) {
+            spare = &c;
+        }
+    }
+    if (!spare) return nullptr;
+    spare->close();
+    spare->leased = true;
+    return spare;
+}
+
+static uint8_t url_pool_idle_count() {
+    uint8_t n = 0;
+    for (const UrlConn& c : url_pool) n += (!c.leased && c.client) ? 1 : 0;
+    return n;
+}
+#endif
+
+// Open HTTP(S) connection state for an image download. The body follows the
+// parsed headers on `client`, which belongs to conn: a pooled keep-alive
+// connection, or `own` (MJPEG streams, or when the pool is full).
+struct UrlDownload {
+    UrlConn own;
+    UrlConn* conn = nullptr;
+    Client* client = nullptr;
+    bool keep_alive = false;    // the server agreed to keep the connection open
+    bool reused = false;        // the request went out on a pooled connection
+    size_t content_length = 0;
+    size_t pos = 0;
+    unsigned long start_ms = 0;
+    unsigned long timeout_ms = 0;
+
+    // Conditional GET: validators to send (nullptr = none) and the ones received.
+    const char* if_none_match = nullptr;
+    const char* if_modified_since = nullptr;
+    bool not_modified = false;  // 304 to a conditional request (no body follows)
+    char etag[96] = {0};
+    char last_modified[40] = {0};
+
+    // Optional copy of the body as it is streamed (see url_stream_read).
+    uint8_t* tee = nullptr;
+
+    // MJPEG: accept a multipart/x-mixed-replace response (no overall Content-Length).
+    bool accept_multipart = false;
+    bool multipart = false;
+
+    // Note: `millis()` wraps; use wrap-safe elapsed checks.
+    bool timed_out() const { return (unsigned long)(millis() - start_ms) >= timeout_ms; }
+
+    ~UrlDownload() { release(); }
+
+    // Done with the response: a pooled connection whose body was read to the
+    // end goes back to the pool, anything else is closed. Idempotent.
+    void release() {
+        if (!conn) return;
+        if (conn != &own && keep_alive && client && pos < content_length && content_length - pos <= 1024) {
+            // A decoder that stopped at EOI may leave a few trailing bytes.
+            uint8_t scratch[64];
+            while (pos < content_length && client->available() > 0) {
+                const int r = client->read(scratch, min(sizeof(scratch), content_length - pos));
+                if (r <= 0) break;
+                pos += (size_t)r;
+            }
+        }
+        const bool reusable = conn != &own && keep_alive && client && pos == content_length &&
+                              client->connected() && client->available() <= 0;
+        if (reusable) {
+            conn->idle_since_ms = millis();
+        } else {
+            conn->close();
+        }
+        conn->leased = false;
+        conn = nullptr;
+        client = nullptr;
+    }
+};
+
+// Connect, send the GET and consume the response headers.
+static bool url_download_open(
     const char* url,
     unsigned long timeout_ms,
-    uint8_t** out_buf,
-    size_t* out_sz,
+    UrlDownload* dl,
     char* err,
     size_t err_len
 ) {
-    if (!out_buf || !out_sz) return false;
-    *out_buf = nullptr;
-    *out_sz = 0;
+    if (!dl) return false;
 
     if (!url || strlen(url) == 0) {
         snprintf(err, err_len, "Missing URL");
@@ -312,28 +617,27 @@ static bool download_jpeg_to_buffer(
         if (scheme == URL_SCHEME_HTTPS) {
             const size_t internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
             if (internal_free < g_cfg.decode_headroom_bytes) {
-                snprintf(err, err_len, "Insufficient internal heap for TLS/decode headroom");
-                return false;
+#if IMAGE_API_URL_KEEPALIVE_CONNS > 0
+                // Idle keep-alive connections hold TLS buffers; give those back first.
+                url_pool_expire(true);
+                if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) < g_cfg.decode_headroom_bytes)
+#endif
+                {
+                    snprintf(err, err_len, "Insufficient internal heap for TLS/decode headroom");
+                    return false;
+                }
             }
         }
     }
 #endif
 
     // Conservative per-operation timeout.
-    // Note: `millis()` wraps; use wrap-safe elapsed checks.
-    const unsigned long start_ms = millis();
-    unsigned long effective_timeout_ms = timeout_ms;
-    if (effective_timeout_ms == 0) effective_timeout_ms = 15000UL;
+    dl->start_ms = millis();
+    dl->timeout_ms = timeout_ms;
+    if (dl->timeout_ms == 0) dl->timeout_ms = 15000UL;
     // Clamp to avoid stalling the main loop for too long.
-    if (effective_timeout_ms > 30000UL) effective_timeout_ms = 30000UL;
-
-    const auto timed_out = [&]() -> bool {
-        return (unsigned long)(millis() - start_ms) >= effective_timeout_ms;
-    };
+    if (dl->timeout_ms > 30000UL) dl->timeout_ms = 30000UL;
 
-    WiFiClientSecure client_tls;
-    WiFiClient client_plain;
-    Client* client = nullptr;
     if (scheme == URL_SCHEME_HTTPS) {
         // SECURITY NOTE:
         // We intentionally use insecure TLS mode for now (no certificate validation)
@@ -347,31 +651,27 @@ static bool download_jpeg_to_buffer(
                 "WARNING: HTTPS image_url uses insecure TLS (no certificate validation). A MITM can spoof content. Use only on trusted networks, or implement CA verification/pinning."
             );
         }
-        client_tls.setInsecure();
-        client = &client_tls;
-    } else {
-        client = &client_plain;
-    }
-
-    if (!client->connect(host, port)) {
-        snprintf(err, err_len, "%s connect failed", scheme == URL_SCHEME_HTTPS ? "TLS" : "TCP");
-        return false;
     }
 
-    client->printf("GET %s HTTP/1.1\r\n", path);
-    client->printf("Host: %s\r\n", host);
-    client->print("User-Agent: esp32-template-image-api/1.0\r\n");
-    client->print("Accept: image/jpeg, */*\r\n");
-    client->print("Connection: close\r\n\r\n");
+    // MJPEG streams hold their connection for as long as they run; they never
+    // take a pool slot.
+#if IMAGE_API_URL_KEEPALIVE_CONNS > 0
+    if (!dl->accept_multipart) dl->conn = url_pool_lease(scheme, host, port);
+#endif
+    const bool pooled = dl->conn != nullptr;
+    if (!pooled) dl->conn = &dl->own;
+    UrlConn* conn = dl->conn;
 
     // Read status + headers line-by-line to reduce stack usage.
     // (Avoids buffering the entire header block.)
     auto read_http_line = [&](char* out, size_t out_len) -> bool {
         if (!out || out_len == 0) return false;
         size_t n = 0;
-        while (!timed_out()) {
-            int b = client->read();
+        while (!dl->timed_out()) {
+            int b = dl->client->read();
             if (b < 0) {
+                // A pooled connection the server has since closed.
+                if (!dl->client->connected()) break;
                 yield();
                 continue;
             }
@@ -393,15 +693,56 @@ static bool download_jpeg_to_buffer(
             out[n++] = (char)b;
         }
 
-        snprintf(err, err_len, "Timeout waiting for headers");
+        snprintf(err, err_len, dl->timed_out() ? "Timeout waiting for headers" : "Connection closed");
         return false;
     };
 
+    // A reused connection may have been closed by the server while idle (its
+    // keep-alive timeout can be shorter than ours); one retry on a new one.
     char line[256];
     int status = 0;
-    if (!read_http_line(line, sizeof(line))) {
-        return false;
+    for (int attempt = 0; ; attempt++) {
+        dl->reused = conn->client != nullptr;
+        if (!conn->client) {
+            Client* client = &conn->plain;
+            if (scheme == URL_SCHEME_HTTPS) {
+                conn->tls.setHandshakeTimeout(dl->timeout_ms);
+                client = &conn->tls;
+            }
+            if (!client->connect(host, port)) {
+                snprintf(err, err_len, "%s connect failed", scheme == URL_SCHEME_HTTPS ? "TLS" : "TCP");
+                return false;
+            }
+            conn->client = client;
+            conn->scheme = scheme;
+            conn->port = port;
+            strlcpy(conn->host, host, sizeof(conn->host));
+#if IMAGE_API_URL_KEEPALIVE_CONNS > 0
+            if (pooled) url_pool_opened++;
+#endif
+        }
+        dl->client = conn->client;
+        Client* client = dl->client;
+
+        client->printf("GET %s HTTP/1.1\r\n", path);
+        client->printf("Host: %s\r\n", host);
+        client->print("User-Agent: esp32-template-image-api/1.0\r\n");
+        client->print("Accept: image/jpeg, */*\r\n");
+        if (dl->if_none_match && dl->if_none_match[0]) {
+            client->printf("If-None-Match: %s\r\n", dl->if_none_match);
+        }
+        if (dl->if_modified_since && dl->if_modified_since[0]) {
+            client->printf("If-Modified-Since: %s\r\n", dl->if_modified_since);
+        }
+        client->print(pooled ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
+
+        if (read_http_line(line, sizeof(line))) break;
+        if (!dl->reused || attempt > 0 || dl->timed_out()) return false;
+        conn->close();
     }
+#if IMAGE_API_URL_KEEPALIVE_CONNS > 0
+    if (dl->reused) url_pool_reused++;
+#endif
     if (line[0] == '\0') {
         snprintf(err, err_len, "Invalid HTTP response");
         return false;
@@ -411,6 +752,10 @@ static bool download_jpeg_to_buffer(
         snprintf(err, err_len, "Failed to parse HTTP status");
         return false;
     }
+    // HTTP/1.1 keeps the connection unless the server says otherwise. Only
+    // a response that ends where its headers say (304, or a Content-Length
+    // body) can leave it reusable.
+    bool keep_alive = pooled && starts_with_ignore_case(line, "HTTP/1.1");
 
     bool chunked = false;
     size_t content_length = 0;
@@ -428,6 +773,23 @@ static bool download_jpeg_to_buffer(
             const char* v = line + strlen("Content-Length:");
             while (*v == ' ' || *v == '\t') v++;
             content_length = (size_t)strtoul(v, nullptr, 10);
+        } else if (starts_with_ignore_case(line, "Content-Type:")) {
+            const char* v = line + strlen("Content-Type:");
+            while (*v == ' ' || *v == '\t') v++;
+            dl->multipart = starts_with_ignore_case(v, "multipart/x-mixed-replace");
+        } else if (starts_with_ignore_case(line, "ETag:")) {
+            const char* v = line + strlen("ETag:");
+            while (*v == ' ' || *v == '\t') v++;
+            // Oversized validators are dropped rather than truncated.
+            if (strlen(v) < sizeof(dl->etag)) strlcpy(dl->etag, v, sizeof(dl->etag));
+        } else if (starts_with_ignore_case(line, "Last-Modified:")) {
+            const char* v = line + strlen("Last-Modified:");
+            while (*v == ' ' || *v == '\t') v++;
+            if (strlen(v) < sizeof(dl->last_modified)) strlcpy(dl->last_modified, v, sizeof(dl->last_modified));
+        } else if (starts_with_ignore_case(line, "Connection:")) {
+            const char* v = line + strlen("Connection:");
+            while (*v == ' ' || *v == '\t') v++;
+            if (starts_with_ignore_case(v, "close")) keep_alive = false;
         } else if (starts_with_ignore_case(line, "Transfer-Encoding:")) {
             // If chunked, we bail for now (keeps implementation small + memory-predictable).
             const char* v = line + strlen("Transfer-Encoding:");
@@ -455,6 +817,13 @@ static bool download_jpeg_to_buffer(
         }
     }
 
+    if (status == 304 && (dl->if_none_match || dl->if_modified_since)) {
+        dl->not_modified = true;
+        dl->keep_alive = keep_alive;
+        dl->content_length = 0;
+        dl->pos = 0;
+        return true;
+    }
     if (status != 200) {
         snprintf(err, err_len, "HTTP status %d", status);
         return false;
@@ -463,6 +832,16 @@ static bool download_jpeg_to_buffer(
         snprintf(err, err_len, "Chunked transfer unsupported");
         return false;
     }
+    if (dl->accept_multipart) {
+        if (!dl->multipart) {
+            snprintf(err, err_len, "Not an MJPEG stream (multipart/x-mixed-replace)");
+            return false;
+        }
+        // Each part carries its own Content-Length (see mjpeg_read_part_header).
+        dl->content_length = 0;
+        dl->pos = 0;
+        return true;
+    }
     if (content_length == 0) {
         snprintf(err, err_len, "Missing Content-Length");
         return false;
@@ -472,15 +851,33 @@ static bool download_jpeg_to_buffer(
         return false;
     }
 
-    uint8_t* buf = (uint8_t*)image_api_alloc(content_length);
+    dl->keep_alive = keep_alive;
+    dl->content_length = content_length;
+    dl->pos = 0;
+    return true;
+}
+
+// Read the body of an open download into a new buffer.
+static bool download_jpeg_body(
+    UrlDownload* dl,
+    uint8_t** out_buf,
+    size_t* out_sz,
+    char* err,
+    size_t err_len
+) {
+    const size_t content_length = dl->content_length;
+
+    const char* refusal = nullptr;
+    uint8_t* buf = (uint8_t*)image_api_lease(content_length, &refusal);
     if (!buf) {
-        snprintf(err, err_len, "Out of memory allocating %u bytes", (unsigned)content_length);
+        if (refusal) snprintf(err, err_len, "%s", refusal);
+        else snprintf(err, err_len, "Out of memory allocating %u bytes", (unsigned)content_length);
         return false;
     }
 
     size_t pos = 0;
-    while (pos < content_length && !timed_out()) {
-        const int r = client->read(buf + pos, (int)min((size_t)1024, content_length - pos));
+    while (pos < content_length && !dl->timed_out()) {
+        const int r = dl->client->read(buf + pos, (int)min((size_t)1024, content_length - pos));
         if (r > 0) {
             pos += (size_t)r;
             continue;
@@ -488,6 +885,7 @@ static bool download_jpeg_to_buffer(
         delay(1);
     }
 
+    dl->pos = pos;
     if (pos != content_length) {
         image_api_free(buf);
         snprintf(err, err_len, "Incomplete body (%u/%u)", (unsigned)pos, (unsigned)content_length);
@@ -505,554 +903,2519 @@ static bool download_jpeg_to_buffer(
     return true;
 }
 
-// ===== Handlers =====
+static bool download_jpeg_to_buffer(
+    const char* url,
+    unsigned long timeout_ms,
+    uint8_t** out_buf,
+    size_t* out_sz,
+    char* err,
+    size_t err_len
+) {
+    if (!out_buf || !out_sz) return false;
+    *out_buf = nullptr;
+    *out_sz = 0;
 
-// POST /api/display/image - Upload and display JPEG image (deferred decode)
-static void handleImageUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
-    if (g_auth_gate && !g_auth_gate(request)) return;
-    (void)filename;
+    UrlDownload dl;
+    if (!url_download_open(url, timeout_ms, &dl, err, err_len)) {
+        return false;
+    }
+    return download_jpeg_body(&dl, out_buf, out_sz, err, err_len);
+}
 
-    // First chunk - initialize upload
-    if (index == 0) {
-        // If upload already in progress OR pending display, reject (client can retry)
-        if (upload_state == UPLOAD_IN_PROGRESS || upload_state == UPLOAD_READY_TO_DISPLAY) {
-            request->send(409, "application/json", "{\"success\":false,\"message\":\"Upload busy\"}");
-            return;
-        }
+// Don't hold the LVGL mutex while a streaming decode waits on the network.
+static void image_stream_wait_hook(bool waiting, void* ctx) {
+    (void)ctx;
+    #if HAS_DISPLAY
+    if (waiting) {
+        display_manager_unlock();
+    } else {
+        display_manager_lock();
+    }
+    #else
+    (void)waiting;
+    #endif
+}
 
-        Logger.logBegin("Image Upload");
-        Logger.logLinef("Total size: %u bytes", request->contentLength());
+// All direct-screen display paths start here.
+static bool image_api_begin_session(int width, int height, unsigned long timeout_ms, unsigned long start_time) {
+    image_session_seq++;
+    return g_backend.start_strip_session(width, height, timeout_ms, start_time);
+}
 
-        image_upload_timeout_ms = parse_timeout_ms(request);
-        image_upload_start_ms = millis();
-        Logger.logLinef("Timeout: %lu ms", image_upload_timeout_ms);
+// Decode a whole image (buffer, or read != nullptr) into the current session:
+// scaled down to fit when the backend supports it, else panel-sized only.
+static bool image_api_decode_whole(const uint8_t* buf, size_t sz, ImageStreamReadFn read, void* read_ctx, bool center) {
+    TRACE_SCOPE("image.decode");
+#if IMAGE_API_SCALED_DECODE
+    if (g_backend.decode_fit) {
+        return g_backend.decode_fit(buf, sz, read, read_ctx, false, center);
+    }
+#else
+    (void)center;
+#endif
+    if (read) return g_backend.decode_stream(read, read_ctx, false);
+    return g_backend.decode_strip(buf, sz, 0, false);
+}
 
-        device_telemetry_log_memory_snapshot("img pre-clear");
+// Header check for a whole-image upload, matching image_api_decode_whole.
+// header receives what the check parsed, for the decode.
+static bool image_api_preflight_whole(const uint8_t* buf, size_t sz, JpegHeader* header, char* err, size_t err_sz) {
+#if IMAGE_API_SCALED_DECODE
+    if (g_backend.decode_fit) {
+        return jpeg_preflight_tjpgd_fit_supported(buf, sz, g_cfg.lcd_width, g_cfg.lcd_height, nullptr, err, err_sz, header);
+    }
+#endif
+    return jpeg_preflight_tjpgd_supported(buf, sz, g_cfg.lcd_width, g_cfg.lcd_height, err, err_sz, header);
+}
 
-        // Free any pending image buffer to make room for new upload
-        if (pending_image_op.buffer) {
-            Logger.logMessage("Upload", "Freeing pending image buffer");
-            image_api_free((void*)pending_image_op.buffer);
-            pending_image_op.buffer = nullptr;
-            pending_image_op.size = 0;
-        }
+#if IMAGE_API_PARALLEL_DECODE
+#if STATIC_ALLOC_MODE
+// Reserved by image_api_init() and kept: a parallel decode allocates no frame.
+static uint16_t* g_parallel_fb = nullptr;
+#endif
 
-        device_telemetry_log_memory_snapshot("img post-clear");
+static uint16_t* parallel_fb_alloc(size_t bytes) {
+#if STATIC_ALLOC_MODE
+    if (!g_parallel_fb) g_parallel_fb = (uint16_t*)heap_tag_malloc(HeapTag::Image, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return g_parallel_fb;
+#else
+    return (uint16_t*)heap_tag_malloc(HeapTag::Image, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+}
 
-        // Check file size
-        size_t total_size = request->contentLength();
-        if (total_size > g_cfg.max_image_size_bytes) {
-            Logger.logEnd("ERROR: Image too large");
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Image too large\"}");
-            return;
+static void parallel_fb_free(uint16_t* fb) {
+#if STATIC_ALLOC_MODE
+    (void)fb;
+#else
+    heap_tag_free(HeapTag::Image, fb);
+#endif
+}
+
+// Decode a buffered panel-sized JPEG on both cores and push it in one rect.
+// False = not splittable or failed before drawing; caller uses the strip path.
+// header is buf's parsed header (the preflight's), parsed here when not found.
+static bool image_api_decode_parallel(const uint8_t* buf, size_t sz, const JpegHeader& header, unsigned long timeout_ms, unsigned long start_time) {
+    if (!g_backend.push_rect || !jpeg_parallel_available()) return false;
+    JpegHeader parsed;
+    const JpegHeader* hdr = &header;
+    if (!header.found) {
+        const uint32_t header_t0 = image_profile_now_us();
+        jpeg_parse_header(buf, sz, &parsed);
+        image_profile_add(IMAGE_STAGE_PREFLIGHT, image_profile_now_us() - header_t0, (uint32_t)sz);
+        hdr = &parsed;
+    }
+    if (!jpeg_parallel_header_splittable(*hdr, g_cfg.lcd_width, g_cfg.lcd_height)) return false;
+
+    const size_t bytes = (size_t)g_cfg.lcd_width * (size_t)g_cfg.lcd_height * sizeof(uint16_t);
+    const uint32_t alloc_t0 = image_profile_now_us();
+    uint16_t* fb = parallel_fb_alloc(bytes);
+    image_profile_add(IMAGE_STAGE_ALLOC, image_profile_now_us() - alloc_t0, fb ? (uint32_t)bytes : 0);
+    if (!fb) {
+        Logger.logMessagef("Portal", "Parallel decode skipped: no %u byte frame buffer", (unsigned)bytes);
+        return false;
+    }
+
+    // Decode without holding the display lock; only the push needs it.
+    JpegParallelTiming timing = {};
+    char err[96];
+    TRACE_BEGIN("image.decode_parallel");
+    const bool decoded = jpeg_parallel_decode_rgb565(buf, sz, hdr, fb, g_cfg.lcd_width, g_cfg.lcd_height, true, &timing, err, sizeof(err));
+    TRACE_END("image.decode_parallel");
+    if (!decoded) {
+        Logger.logMessagef("Portal", "Parallel decode failed (%s); using strip decoder", err);
+        parallel_fb_free(fb);
+        return false;
+    }
+    // Both cores pack while they decode; the stage records the wall time.
+    image_profile_add(IMAGE_STAGE_DECODE, timing.total_us, (uint32_t)sz);
+
+    Logger.logMessagef(
+        "Portal",
+        "Parallel decode: %u intervals in %lu ms (cores %lu / %lu ms)",
+        (unsigned)timing.intervals,
+        (unsigned long)(timing.total_us / 1000),
+        (unsigned long)(timing.slice_us[0] / 1000),
+        (unsigned long)(timing.slice_us[1] / 1000)
+    );
+
+    #if HAS_DISPLAY
+    display_manager_lock();
+    #endif
+    bool ok = image_api_begin_session(g_cfg.lcd_width, g_cfg.lcd_height, timeout_ms, start_time);
+    if (ok) ok = g_backend.push_rect(0, 0, g_cfg.lcd_width, g_cfg.lcd_height, fb, true);
+    #if HAS_DISPLAY
+    display_manager_unlock();
+    #endif
+
+    parallel_fb_free(fb);
+    return ok;
+}
+#endif // IMAGE_API_PARALLEL_DECODE
+
+#if IMAGE_API_STREAM_UPLOAD
+// A panel-sized JPEG with MCU-row restart intervals decodes faster buffered
+// (both cores) than streamed (one core). Header-only check on the first chunk.
+static bool image_api_prefers_parallel(AsyncWebServerRequest* request, const uint8_t* data, size_t len) {
+#if IMAGE_API_PARALLEL_DECODE
+    if (!parse_parallel(request) || !g_backend.push_rect || !jpeg_parallel_available()) return false;
+    return jpeg_parallel_header_splittable(data, len, g_cfg.lcd_width, g_cfg.lcd_height);
+#else
+    (void)request;
+    (void)data;
+    (void)len;
+    return false;
+#endif
+}
+#endif // IMAGE_API_STREAM_UPLOAD
+
+// Streaming decode needs the whole JPEG in memory when the LVGL image screen is active.
+static bool image_stream_decode_available() {
+    if (!g_backend.decode_stream || !g_backend.start_strip_session) return false;
+
+    #if HAS_DISPLAY && LV_USE_IMG
+    const char* current_screen = display_manager_get_current_screen_id();
+    if (current_screen && strcmp(current_screen, "lvgl_image") == 0) return false;
+    #endif
+
+    return true;
+}
+
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+// Conditional GET cache for /api/display/image_url. Clients that re-post the
+// same URL on a timer get a 304 round trip instead of a download + decode when
+// the image is unchanged. Only touched by the consumer (worker / main loop).
+struct UrlCacheEntry {
+    char url[IMAGE_API_URL_MAX_LEN];
+    char etag[96];
+    char last_modified[40];
+    uint8_t* body;             // Last JPEG body (PSRAM only); nullptr when not kept
+    size_t body_size;
+    unsigned long used_ms;
+};
+static UrlCacheEntry url_cache[IMAGE_API_URL_CACHE_ENTRIES] = {};
+
+// The URL whose image the direct screen shows (valid while image_session_seq matches).
+static int url_cache_on_screen = -1;
+static uint32_t url_cache_on_screen_seq = 0;
+
+// Slot of the URL image queued in pending_image_op (-1 = not from the cache).
+static int url_cache_pending_slot = -1;
+
+static uint32_t url_cache_not_modified = 0;
+
+static int url_cache_slot_for(const char* url) {
+    for (int i = 0; i < IMAGE_API_URL_CACHE_ENTRIES; i++) {
+        if (strcmp(url_cache[i].url, url) == 0) return i;
+    }
+
+    // Free slot first, else the least recently used one.
+    int victim = 0;
+    for (int i = 0; i < IMAGE_API_URL_CACHE_ENTRIES; i++) {
+        if (url_cache[i].url[0] == '\0') {
+            victim = i;
+            break;
         }
+        if ((long)(url_cache[i].used_ms - url_cache[victim].used_ms) < 0) victim = i;
+    }
 
-        // Check memory availability.
-        // - Upload uses a single contiguous buffer.
-        // - The decode pipeline needs headroom (historically expressed via g_cfg.decode_headroom_bytes).
+    UrlCacheEntry* e = &url_cache[victim];
+    if (e->body) heap_tag_free(HeapTag::Image, e->body);
+    memset(e, 0, sizeof(*e));
+    strlcpy(e->url, url, sizeof(e->url));
+    if (url_cache_on_screen == victim) url_cache_on_screen = -1;
+    return victim;
+}
+
+static bool url_cache_is_on_screen(int slot) {
+    return slot >= 0 && slot == url_cache_on_screen && url_cache_on_screen_seq == image_session_seq;
+}
+
+// Arm validators on `dl` when a 304 could be served for this slot.
+static void url_cache_prepare(int slot, UrlDownload* dl) {
+    UrlCacheEntry* e = &url_cache[slot];
+    e->used_ms = millis();
+    if (!e->etag[0] && !e->last_modified[0]) return;
 
+    const bool can_refresh = url_cache_is_on_screen(slot) && g_backend.refresh_current_image;
+    if (!can_refresh && !e->body) return;
+
+    if (e->etag[0]) dl->if_none_match = e->etag;
+    if (e->last_modified[0]) dl->if_modified_since = e->last_modified;
+}
+
+// Remember validators from a 200 response. Drops a stale body.
+static void url_cache_store_validators(int slot, const UrlDownload& dl) {
+    UrlCacheEntry* e = &url_cache[slot];
+    strlcpy(e->etag, dl.etag, sizeof(e->etag));
+    strlcpy(e->last_modified, dl.last_modified, sizeof(e->last_modified));
+    if (e->body) {
+        heap_tag_free(HeapTag::Image, e->body);
+        e->body = nullptr;
+        e->body_size = 0;
+    }
+}
+
+// PSRAM copy target for the body of a 200 (nullptr when it should not be kept).
+static uint8_t* url_cache_alloc_body(const UrlDownload& dl) {
 #if SOC_SPIRAM_SUPPORTED
-        // `SOC_SPIRAM_SUPPORTED` means the SoC can use PSRAM, but some boards have no PSRAM fitted.
-        // Use a runtime check so no-PSRAM boards don't take PSRAM-specific headroom gating.
-        const bool has_psram = psramFound();
-        const size_t psram_free = has_psram ? heap_caps_get_free_size(MALLOC_CAP_SPIRAM) : 0;
-        const size_t psram_largest = has_psram ? heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) : 0;
-        const bool psram_can_hold_upload = has_psram && (psram_free >= total_size) && (psram_largest >= total_size);
+    if (!dl.etag[0] && !dl.last_modified[0]) return nullptr;
+    if (dl.content_length == 0 || dl.content_length > (size_t)IMAGE_API_URL_CACHE_BODY_MAX_BYTES) return nullptr;
+    if (!psramFound()) return nullptr;
+    return (uint8_t*)heap_tag_malloc(HeapTag::Image, dl.content_length, MALLOC_CAP_SPIRAM);
 #else
-        const size_t psram_free = 0;
-        const size_t psram_largest = 0;
-        const bool psram_can_hold_upload = false;
+    (void)dl;
+    return nullptr;
 #endif
+}
 
-        // PSRAM boards vs no-PSRAM boards behave very differently.
-        // - On PSRAM boards: upload buffer is expected to land in PSRAM; keep an internal headroom guard.
-        // - On no-PSRAM boards: keep the historical "total heap" guard (ESP.getFreeHeap) so we don't
-        //   falsely reject when internal-only metrics look tight but the system can still operate.
-#if SOC_SPIRAM_SUPPORTED
-        if (has_psram) {
-            const size_t internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-            if (internal_free < g_cfg.decode_headroom_bytes) {
-            Logger.logLinef(
-                "ERROR: Insufficient internal memory for decode headroom (need %u, have %u)",
-                (unsigned)g_cfg.decode_headroom_bytes,
-                (unsigned)internal_free
-            );
-            device_telemetry_log_memory_snapshot("img insufficient");
-            char error_msg[240];
-            snprintf(
-                error_msg,
-                sizeof(error_msg),
-                "{\"success\":false,\"message\":\"Insufficient internal memory: need %uKB decode headroom, have %uKB.\"}",
-                (unsigned)(g_cfg.decode_headroom_bytes / 1024),
-                (unsigned)(internal_free / 1024)
-            );
-            Logger.logEnd();
-            request->send(507, "application/json", error_msg);
+static void url_cache_keep_body(int slot, uint8_t* body, size_t size) {
+    UrlCacheEntry* e = &url_cache[slot];
+    if (e->body) heap_tag_free(HeapTag::Image, e->body);
+    e->body = body;
+    e->body_size = body ? size : 0;
+}
+
+static void url_cache_mark_shown(int slot) {
+    url_cache_on_screen = slot;
+    url_cache_on_screen_seq = image_session_seq;
+}
+#endif // IMAGE_API_URL_CACHE_ENTRIES > 0
+
+// Queue a downloaded JPEG for decode on the next consumer tick (takes ownership of buf).
+static void queue_downloaded_image(uint8_t* buf, size_t sz, unsigned long timeout_ms, bool center, int cache_slot) {
+    if (pending_image_op.buffer) {
+        image_api_free((void*)pending_image_op.buffer);
+    }
+    pending_image_op.buffer = buf;
+    pending_image_op.size = sz;
+    pending_image_op.dismiss = false;
+    pending_image_op.timeout_ms = timeout_ms > 0 ? timeout_ms : g_cfg.default_timeout_ms;
+    pending_image_op.start_time = millis();
+    pending_image_op.center = center;
+    pending_image_op.parallel = true;
+    pending_image_op.profile_kind = "url";
+    pending_image_op.profile = {};
+    pending_image_op.header = JpegHeader();
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+    url_cache_pending_slot = cache_slot;
+#else
+    (void)cache_slot;
+#endif
+    pending_op_id++;
+    image_api_notify_job(IMAGE_JOB_UPLOAD);
+    upload_state = UPLOAD_READY_TO_DISPLAY;
+}
+
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+// Serve a 304: re-arm the image if it is still on screen, else re-decode the
+// kept body. Returns false when neither is possible (caller refetches).
+static bool url_cache_serve_not_modified(int slot, unsigned long timeout_ms, bool center) {
+    UrlCacheEntry* e = &url_cache[slot];
+    const unsigned long display_timeout_ms = timeout_ms > 0 ? timeout_ms : g_cfg.default_timeout_ms;
+
+    if (url_cache_is_on_screen(slot) && g_backend.refresh_current_image &&
+        g_backend.refresh_current_image(display_timeout_ms, millis())) {
+        url_cache_not_modified++;
+        Logger.logMessage("Portal", "Image URL not modified (304); kept on screen");
+        upload_state = UPLOAD_IDLE;
+        return true;
+    }
+
+    if (e->body) {
+        uint8_t* copy = (uint8_t*)image_api_lease(e->body_size, nullptr);
+        if (!copy) return false;
+        memcpy(copy, e->body, e->body_size);
+        url_cache_not_modified++;
+        Logger.logMessagef("Portal", "Image URL not modified (304); decoding cached %u bytes", (unsigned)e->body_size);
+        queue_downloaded_image(copy, e->body_size, timeout_ms, center, slot);
+        return true;
+    }
+
+    return false;
+}
+#endif // IMAGE_API_URL_CACHE_ENTRIES > 0
+
+#if IMAGE_API_STREAM_URL
+// ImageStreamReadFn over an open download: pulls body bytes straight from the
+// socket (TLS records are decrypted as the decoder asks for them).
+static size_t url_stream_read(void* ctx, uint8_t* dst, size_t n) {
+    UrlDownload* dl = (UrlDownload*)ctx;
+    if (!dl || !dl->client) return 0;
+
+    const size_t remaining = dl->content_length - dl->pos;
+    if (n > remaining) n = remaining;
+
+    size_t got = 0;
+    bool waiting = false;
+    while (got < n && !dl->timed_out()) {
+        uint8_t scratch[64];
+        uint8_t* out = dst ? dst + got : scratch;
+        const size_t want = dst ? (n - got) : min(n - got, sizeof(scratch));
+
+        const int r = dl->client->read(out, want);
+        if (r > 0) {
+            if (dl->tee) memcpy(dl->tee + dl->pos + got, out, (size_t)r);
+            got += (size_t)r;
+            continue;
+        }
+        if (!dl->client->connected() && dl->client->available() <= 0) {
+            break;
+        }
+
+        if (!waiting) {
+            waiting = true;
+            image_stream_wait_hook(true, nullptr);
+        }
+        delay(1);
+    }
+
+    if (waiting) {
+        image_stream_wait_hook(false, nullptr);
+    }
+
+    dl->pos += got;
+    return got;
+}
+
+// Decode an open download in one pass (main loop). No full-size body buffer.
+static void image_api_stream_url(UrlDownload& dl, unsigned long timeout_ms, bool center, int cache_slot) {
+    device_telemetry_log_memory_snapshot("urlimg pre-stream");
+
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+    // Keep a PSRAM copy of the body so a later 304 can be re-decoded.
+    dl.tee = (cache_slot >= 0) ? url_cache_alloc_body(dl) : nullptr;
+#else
+    (void)cache_slot;
+#endif
+
+    const unsigned long t0 = millis();
+    const unsigned long display_timeout_ms = timeout_ms > 0 ? timeout_ms : g_cfg.default_timeout_ms;
+    bool success = false;
+    image_profile_begin("url");
+
+    #if HAS_DISPLAY
+    // Serialize with LVGL task; url_stream_read releases it while the socket is empty.
+    display_manager_lock();
+    #endif
+
+    if (!image_api_begin_session(g_cfg.lcd_width, g_cfg.lcd_height, display_timeout_ms, millis())) {
+        Logger.logMessage("Portal", "ERROR: Failed to init image display");
+    } else {
+        success = image_api_decode_whole(nullptr, 0, url_stream_read, &dl, center);
+    }
+
+    #if HAS_DISPLAY
+    display_manager_unlock();
+    #endif
+
+    dl.release();
+    image_profile_end(success);
+
+    device_telemetry_log_memory_snapshot("urlimg post-stream");
+    Logger.logMessagef(
+        "Portal",
+        "Streamed URL image %s: %u/%u bytes in %lu ms",
+        success ? "done" : "FAILED",
+        (unsigned)dl.pos,
+        (unsigned)dl.content_length,
+        (unsigned long)(millis() - t0)
+    );
+
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+    if (cache_slot >= 0) {
+        if (success && dl.pos == dl.content_length) {
+            url_cache_keep_body(cache_slot, dl.tee, dl.content_length);
+            url_cache_mark_shown(cache_slot);
+        } else if (dl.tee) {
+            heap_tag_free(HeapTag::Image, dl.tee);
+        }
+        dl.tee = nullptr;
+    }
+#endif
+
+    upload_state = UPLOAD_IDLE;
+    if (!success) {
+        if (dl.timed_out()) {
+            Logger.logMessage("Portal", "ERROR: URL download timed out during decode");
+        }
+        if (g_backend.hide_current_image) {
+            g_backend.hide_current_image();
+        }
+    }
+}
+#endif // IMAGE_API_STREAM_URL
+
+#if IMAGE_API_MJPEG_STREAM && IMAGE_API_STREAM_URL
+// ===== MJPEG live stream =====
+// The worker keeps one multipart/x-mixed-replace connection open and decodes
+// each part straight from the socket into the direct screen, reusing the
+// decoder buffers of one strip session. Frames that arrive faster than max_fps
+// or while a newer one is already buffered are read and discarded.
+
+static constexpr unsigned long MJPEG_IO_TIMEOUT_MS = 10000UL;
+static constexpr unsigned long MJPEG_BACKOFF_MIN_MS = 500UL;
+static constexpr unsigned long MJPEG_BACKOFF_MAX_MS = 10000UL;
+// Grace period for the enqueued show before "not visible" means dismissed.
+static constexpr unsigned long MJPEG_SHOW_GRACE_MS = 2000UL;
+
+// Written by the HTTP handlers, read by the worker (under mjpeg_mux).
+struct MjpegStreamRequest {
+    bool active;
+    char url[IMAGE_API_URL_MAX_LEN];
+    uint16_t max_fps;      // 0 = uncapped
+    uint32_t generation;   // bumped on every start/stop
+};
+static MjpegStreamRequest mjpeg_request = {false, {0}, 0, 0};
+
+// Written by the worker, read by GET /api/display/stream (under mjpeg_mux).
+struct MjpegStreamStats {
+    bool connected;
+    uint32_t frames;
+    uint32_t dropped;
+    uint32_t reconnects;
+    uint32_t last_decode_ms;
+    uint32_t fps_x10;
+    char last_error[96];
+};
+static MjpegStreamStats mjpeg_stats = {};
+static portMUX_TYPE mjpeg_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Worker-only state.
+static UrlDownload* mjpeg_dl = nullptr;
+static uint32_t mjpeg_generation = 0;        // request generation the worker has applied
+static bool mjpeg_drawing = false;           // a strip session was started for the stream
+static uint32_t mjpeg_session_seq = 0;       // image_session_seq of that session
+static unsigned long mjpeg_session_start_ms = 0;
+static unsigned long mjpeg_retry_at_ms = 0;
+static unsigned long mjpeg_backoff_ms = 0;
+static unsigned long mjpeg_last_frame_ms = 0;  // last decoded frame (rate cap)
+static unsigned long mjpeg_last_part_ms = 0;   // last part received (idle detection)
+static unsigned long mjpeg_fps_window_ms = 0;
+static uint32_t mjpeg_fps_window_frames = 0;
+
+static bool image_mjpeg_needs_work() {
+    portENTER_CRITICAL(&mjpeg_mux);
+    const bool pending = mjpeg_request.active || mjpeg_request.generation != mjpeg_generation;
+    portEXIT_CRITICAL(&mjpeg_mux);
+    return pending || mjpeg_dl != nullptr;
+}
+
+// Called from the HTTP handlers; the worker notices the new generation.
+static void image_mjpeg_request_stop() {
+    portENTER_CRITICAL(&mjpeg_mux);
+    const bool was_active = mjpeg_request.active;
+    mjpeg_request.active = false;
+    if (was_active) mjpeg_request.generation++;
+    portEXIT_CRITICAL(&mjpeg_mux);
+    if (was_active) image_api_notify_job(IMAGE_JOB_MJPEG);
+}
+
+static void mjpeg_set_error(const char* msg) {
+    portENTER_CRITICAL(&mjpeg_mux);
+    strlcpy(mjpeg_stats.last_error, msg ? msg : "", sizeof(mjpeg_stats.last_error));
+    portEXIT_CRITICAL(&mjpeg_mux);
+}
+
+static void mjpeg_disconnect() {
+    if (mjpeg_dl) {
+        if (mjpeg_dl->client) mjpeg_dl->client->stop();
+        delete mjpeg_dl;
+        mjpeg_dl = nullptr;
+    }
+    portENTER_CRITICAL(&mjpeg_mux);
+    mjpeg_stats.connected = false;
+    mjpeg_stats.fps_x10 = 0;
+    portEXIT_CRITICAL(&mjpeg_mux);
+    mjpeg_fps_window_ms = 0;
+    mjpeg_fps_window_frames = 0;
+}
+
+// Drop the connection and schedule a reconnect with exponential backoff.
+static void mjpeg_fail(const char* msg) {
+    mjpeg_disconnect();
+    mjpeg_set_error(msg);
+
+    mjpeg_backoff_ms = mjpeg_backoff_ms ? min(mjpeg_backoff_ms * 2, MJPEG_BACKOFF_MAX_MS) : MJPEG_BACKOFF_MIN_MS;
+    mjpeg_retry_at_ms = millis() + mjpeg_backoff_ms;
+    Logger.logMessagef("ImageApi", "MJPEG: %s (retry in %lu ms)", msg, mjpeg_backoff_ms);
+}
+
+// The stream gave up the screen (another image, or the screen was dismissed).
+static void mjpeg_end(const char* reason, uint32_t generation) {
+    mjpeg_disconnect();
+    mjpeg_drawing = false;
+    mjpeg_set_error(reason);
+
+    portENTER_CRITICAL(&mjpeg_mux);
+    if (mjpeg_request.generation == generation) {
+        mjpeg_request.active = false;
+        mjpeg_request.generation++;
+        mjpeg_generation = mjpeg_request.generation;
+    }
+    portEXIT_CRITICAL(&mjpeg_mux);
+    Logger.logMessagef("ImageApi", "MJPEG stream ended: %s", reason);
+}
+
+// Read one CRLF-terminated line (over-long lines are truncated).
+static bool mjpeg_read_line(UrlDownload* dl, char* out, size_t out_len) {
+    size_t n = 0;
+    while (!dl->timed_out()) {
+        const int b = dl->client->read();
+        if (b < 0) {
+            if (!dl->client->connected() && dl->client->available() <= 0) return false;
+            delay(1);
+            continue;
+        }
+        if (b == '\r') continue;
+        if (b == '\n') {
+            out[n] = '\0';
+            return true;
+        }
+        if (n + 1 < out_len) out[n++] = (char)b;
+    }
+    return false;
+}
+
+// Consume a part boundary and its headers; returns the part's Content-Length.
+static bool mjpeg_read_part_header(UrlDownload* dl, size_t* part_len, char* err, size_t err_len) {
+    char line[128];
+    bool in_headers = false;
+    size_t len = 0;
+
+    for (int lines = 0; lines < 32; lines++) {
+        if (!mjpeg_read_line(dl, line, sizeof(line))) {
+            snprintf(err, err_len, "Stream closed or stalled");
+            return false;
+        }
+        if (line[0] == '\0') {
+            if (in_headers) {
+                if (len == 0) {
+                    snprintf(err, err_len, "MJPEG part without Content-Length");
+                    return false;
+                }
+                *part_len = len;
+                return true;
+            }
+            continue;  // CRLF after the previous part
+        }
+        in_headers = true;
+        if (starts_with_ignore_case(line, "Content-Length:")) {
+            const char* v = line + strlen("Content-Length:");
+            while (*v == ' ' || *v == '\t') v++;
+            len = (size_t)strtoul(v, nullptr, 10);
+        }
+        // Boundary ("--name") and other part headers are ignored.
+    }
+
+    snprintf(err, err_len, "Malformed MJPEG part header");
+    return false;
+}
+
+// Read and discard n body bytes (dropped frame, or what TJpgDec left unread).
+static bool mjpeg_skip(UrlDownload* dl, size_t n) {
+    uint8_t scratch[256];
+    while (n > 0 && !dl->timed_out()) {
+        const int r = dl->client->read(scratch, min(n, sizeof(scratch)));
+        if (r > 0) {
+            n -= (size_t)r;
+            continue;
+        }
+        if (!dl->client->connected() && dl->client->available() <= 0) break;
+        delay(1);
+    }
+    return n == 0;
+}
+
+static bool mjpeg_connect(const char* url) {
+    // A non-zero backoff means an earlier connection failed.
+    if (mjpeg_backoff_ms > 0) {
+        portENTER_CRITICAL(&mjpeg_mux);
+        mjpeg_stats.reconnects++;
+        portEXIT_CRITICAL(&mjpeg_mux);
+    }
+
+    mjpeg_dl = new UrlDownload();
+    mjpeg_dl->accept_multipart = true;
+
+    char err[96] = {0};
+    if (!url_download_open(url, MJPEG_IO_TIMEOUT_MS, mjpeg_dl, err, sizeof(err))) {
+        mjpeg_fail(err);
+        return false;
+    }
+
+    mjpeg_last_part_ms = millis();
+    portENTER_CRITICAL(&mjpeg_mux);
+    mjpeg_stats.connected = true;
+    portEXIT_CRITICAL(&mjpeg_mux);
+    Logger.logMessagef("ImageApi", "MJPEG connected: %s", url);
+    return true;
+}
+
+// One bounded step of the stream: connect, or consume at most one part.
+// Returns quickly when no bytes are waiting so other image jobs keep flowing.
+static void image_api_mjpeg_step() {
+    char url[IMAGE_API_URL_MAX_LEN];
+    bool active = false;
+    uint16_t max_fps = 0;
+    uint32_t generation = 0;
+    portENTER_CRITICAL(&mjpeg_mux);
+    active = mjpeg_request.active;
+    max_fps = mjpeg_request.max_fps;
+    generation = mjpeg_request.generation;
+    memcpy(url, mjpeg_request.url, sizeof(url));
+    portEXIT_CRITICAL(&mjpeg_mux);
+
+    if (generation != mjpeg_generation) {
+        // Started, restarted or stopped through the API.
+        mjpeg_disconnect();
+        mjpeg_generation = generation;
+        mjpeg_backoff_ms = 0;
+        mjpeg_retry_at_ms = millis();
+        if (!active) {
+            // Take the last frame down, unless another image replaced it already.
+            if (mjpeg_drawing && mjpeg_session_seq == image_session_seq && g_backend.hide_current_image) {
+                g_backend.hide_current_image();
+            }
+            mjpeg_drawing = false;
+            Logger.logMessage("ImageApi", "MJPEG stream stopped");
+            return;
+        }
+        portENTER_CRITICAL(&mjpeg_mux);
+        mjpeg_stats = {};
+        portEXIT_CRITICAL(&mjpeg_mux);
+    }
+    if (!active) return;
+
+    // Any other image shown since our session started owns the screen now.
+    if (mjpeg_drawing && mjpeg_session_seq != image_session_seq) {
+        mjpeg_end("Replaced by another image", generation);
+        return;
+    }
+
+    if (!mjpeg_dl) {
+        if ((long)(millis() - mjpeg_retry_at_ms) < 0) return;
+        if (!mjpeg_connect(url)) return;
+    }
+
+    UrlDownload* dl = mjpeg_dl;
+    if (dl->client->available() <= 0) {
+        if (!dl->client->connected()) {
+            mjpeg_fail("Stream closed by server");
+        } else if ((unsigned long)(millis() - mjpeg_last_part_ms) > MJPEG_IO_TIMEOUT_MS) {
+            mjpeg_fail("No frame received");
+        }
+        return;
+    }
+
+    char err[96] = {0};
+    size_t part_len = 0;
+    dl->start_ms = millis();
+    dl->timeout_ms = MJPEG_IO_TIMEOUT_MS;
+    if (!mjpeg_read_part_header(dl, &part_len, err, sizeof(err))) {
+        mjpeg_fail(err);
+        return;
+    }
+    if (part_len > g_cfg.max_image_size_bytes) {
+        snprintf(err, sizeof(err), "Frame too large (%u bytes)", (unsigned)part_len);
+        mjpeg_fail(err);
+        return;
+    }
+
+    const unsigned long now = millis();
+    mjpeg_last_part_ms = now;
+
+    // Drop when over the rate cap, or when the next frame is already waiting
+    // (decoding this one would only add latency).
+    const bool rate_limited = max_fps > 0 && mjpeg_last_frame_ms != 0 &&
+                              (unsigned long)(now - mjpeg_last_frame_ms) < (1000UL / max_fps);
+    const bool behind = dl->client->available() > (int)part_len;
+    if (rate_limited || behind) {
+        if (!mjpeg_skip(dl, part_len)) {
+            mjpeg_fail("Incomplete frame");
+            return;
+        }
+        portENTER_CRITICAL(&mjpeg_mux);
+        mjpeg_stats.dropped++;
+        portEXIT_CRITICAL(&mjpeg_mux);
+        return;
+    }
+
+    // The first frame starts one strip session (no timeout); later frames reuse
+    // its buffers. Check the screen is still ours once the show had time to land.
+    if (mjpeg_drawing && g_backend.refresh_current_image &&
+        (unsigned long)(now - mjpeg_session_start_ms) > MJPEG_SHOW_GRACE_MS &&
+        !g_backend.refresh_current_image(0, now)) {
+        mjpeg_end("Image screen dismissed", generation);
+        return;
+    }
+
+    dl->content_length = part_len;
+    dl->pos = 0;
+    dl->start_ms = now;
+
+    #if HAS_DISPLAY
+    display_manager_lock();
+    #endif
+
+    bool success = false;
+    image_profile_begin("mjpeg");
+    if (!mjpeg_drawing) {
+        if (image_api_begin_session(g_cfg.lcd_width, g_cfg.lcd_height, 0, now)) {
+            mjpeg_drawing = true;
+            mjpeg_session_seq = image_session_seq;
+            mjpeg_session_start_ms = now;
+        }
+    }
+    if (mjpeg_drawing) {
+#if IMAGE_API_SCALED_DECODE
+        // Camera feeds rarely match the panel; frames share one letterbox.
+        if (g_backend.decode_fit) {
+            success = g_backend.decode_fit(nullptr, 0, url_stream_read, dl, false, true);
+        } else
+#endif
+        success = g_backend.decode_frame(url_stream_read, dl, false);
+    }
+
+    #if HAS_DISPLAY
+    display_manager_unlock();
+    #endif
+    image_profile_end(success);
+
+    const unsigned long done = millis();
+    const bool drained = (dl->pos >= part_len) || mjpeg_skip(dl, part_len - dl->pos);
+
+    if (!mjpeg_drawing) {
+        mjpeg_end("Failed to init image display", generation);
+        return;
+    }
+    if (!drained) {
+        mjpeg_fail("Incomplete frame");
+        return;
+    }
+
+    mjpeg_last_frame_ms = now;
+    if (mjpeg_fps_window_ms == 0) mjpeg_fps_window_ms = now;
+    if (success) mjpeg_fps_window_frames++;
+    const unsigned long window = (unsigned long)(done - mjpeg_fps_window_ms);
+
+    portENTER_CRITICAL(&mjpeg_mux);
+    if (success) {
+        mjpeg_stats.frames++;
+        mjpeg_stats.last_decode_ms = (uint32_t)(done - now);
+    } else {
+        // A corrupt or unsupported part: skip it, keep the connection.
+        mjpeg_stats.dropped++;
+    }
+    if (window >= 1000UL) {
+        mjpeg_stats.fps_x10 = (uint32_t)((mjpeg_fps_window_frames * 10000UL) / window);
+    }
+    portEXIT_CRITICAL(&mjpeg_mux);
+
+    if (window >= 1000UL) {
+        mjpeg_fps_window_ms = done;
+        mjpeg_fps_window_frames = 0;
+    }
+    if (success) {
+        mjpeg_backoff_ms = 0;
+    } else {
+        mjpeg_set_error("Frame decode failed (baseline JPEG at panel size?)");
+    }
+}
+#endif // IMAGE_API_MJPEG_STREAM && IMAGE_API_STREAM_URL
+
+#if IMAGE_API_STREAM_UPLOAD
+// Call with upload_stream_mux held.
+static void upload_stream_settle_locked() {
+    if (upload_stream_producer_done && upload_stream_consumer_done && upload_state == UPLOAD_STREAMING) {
+        upload_stream_request = nullptr;
+        upload_state = UPLOAD_IDLE;
+    }
+}
+
+// Request end hook (AsyncTCP task): the client is about to be freed.
+static void upload_stream_forget_client(AsyncClient* client) {
+    if (upload_stream_client == client) {
+        upload_stream_client = nullptr;
+        upload_stream_held = false;
+    }
+}
+
+// Flow control step (AsyncTCP task), after each body chunk and on each poll of
+// the connection. Instead of waiting for ring space, stop opening the TCP
+// window once less than IMAGE_API_STREAM_ACK_RESERVE_BYTES are free: the peer
+// can then only send what is already in flight, which the reserve absorbs.
+// Once the decoder has made room (or is done), every deferred byte is acked.
+static void upload_stream_flow(AsyncClient* client, bool new_data) {
+    const bool hold = upload_stream.isOpen() && upload_stream.spaceAvailable() < IMAGE_API_STREAM_ACK_RESERVE_BYTES;
+    if (hold) {
+        // Only defers the segment being delivered; a poll has nothing to defer.
+        if (new_data) client->ackLater();
+        if (!upload_stream_held) {
+            upload_stream_held = true;
+            upload_stream_held_since_ms = millis();
+        }
+        return;
+    }
+    if (upload_stream_held) {
+        client->ack(SIZE_MAX);
+        upload_stream_held = false;
+        upload_stream_held_ms += (uint32_t)(millis() - upload_stream_held_since_ms);
+    }
+}
+
+// A closed window brings no more body chunks, so the connection's poll
+// (every ~500 ms) is what reopens it after the decoder drained the ring.
+// This takes over the request's own poll callback, which only resumes large
+// responses; the upload replies are a few bytes sent in one go.
+static void upload_stream_on_poll(void* arg, AsyncClient* client) {
+    (void)arg;
+    if (client == upload_stream_client) {
+        upload_stream_flow(client, false);
+    }
+}
+
+// Try to open a streaming session for a new upload (AsyncTCP task).
+// Returns false to let the buffered path handle (and report on) the upload.
+static bool upload_stream_try_begin(AsyncWebServerRequest* request) {
+    if (!image_stream_decode_available()) return false;
+    if (request->contentLength() > g_cfg.max_image_size_bytes) return false;
+
+    // Only the ring and the decoder's own buffers need to fit.
+    const size_t heap8_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    if (heap8_free < (size_t)IMAGE_API_STREAM_RING_BYTES + g_cfg.decode_headroom_bytes) return false;
+
+    if (!upload_stream.open(IMAGE_API_STREAM_RING_BYTES, IMAGE_API_STREAM_IDLE_TIMEOUT_MS)) return false;
+
+    AsyncClient* client = request->client();
+    if (!portal_on_request_end(request, [client]() { upload_stream_forget_client(client); })) {
+        upload_stream.close();
+        return false;
+    }
+    upload_stream_client = client;
+    upload_stream_held = false;
+    upload_stream_held_ms = 0;
+    client->onPoll(upload_stream_on_poll, nullptr);
+
+    image_upload_timeout_ms = parse_timeout_ms(request);
+    image_upload_center = parse_center(request);
+    image_upload_start_ms = millis();
+    upload_stream_last_activity_ms = image_upload_start_ms;
+    upload_stream_stalled = false;
+
+    portENTER_CRITICAL(&upload_stream_mux);
+    upload_stream_request = request;
+    upload_stream_producer_done = false;
+    upload_stream_consumer_done = false;
+    upload_stream_ok = false;
+    upload_stream_error[0] = '\0';
+    upload_state = UPLOAD_STREAMING;
+    portEXIT_CRITICAL(&upload_stream_mux);
+
+    upload_stream_decode_pending = true;
+    pending_op_id++;
+    image_api_notify_job(IMAGE_JOB_STREAM);
+
+    Logger.logBegin("Image Upload (stream)");
+    Logger.logLinef("Total size: %u bytes", request->contentLength());
+    Logger.logLinef("Timeout: %lu ms", image_upload_timeout_ms);
+    Logger.logLinef("Ring: %u bytes", (unsigned)IMAGE_API_STREAM_RING_BYTES);
+    return true;
+}
+
+// Streaming front-end of handleImageUpload (AsyncTCP task).
+// Returns true if the chunk belongs to (or was rejected because of) a streaming session.
+static bool handleImageUploadStream(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len, bool final) {
+    if (index == 0 && upload_state == UPLOAD_IDLE && strip_queue_count() == 0) {
+        if (!is_jpeg_magic(data, len) || image_api_prefers_parallel(request, data, len) ||
+            !upload_stream_try_begin(request)) {
+            return false;
+        }
+    } else if (upload_state != UPLOAD_STREAMING) {
+        return false;
+    } else if (index == 0 || request != upload_stream_request || upload_stream_producer_done) {
+        // Another upload while one is streaming: reject without touching the session.
+        if (index == 0) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Upload busy\"}");
+        }
+        return true;
+    }
+
+    upload_stream_last_activity_ms = millis();
+
+    if (len && !upload_stream_stalled && upload_stream.isOpen()) {
+        const size_t sent = upload_stream.write(data, len);
+        if (sent < len && upload_stream.isOpen()) {
+            // More arrived than the window allowed for; a gap would corrupt the image, so stop feeding it.
+            Logger.logLinef("ERROR: Stream ring overrun at %u bytes", (unsigned)upload_stream.bytesIn());
+            upload_stream_stalled = true;
+            upload_stream.finish();
+        }
+    }
+    if (!final) {
+        upload_stream_flow(request->client(), true);
+    }
+
+    if (!final) {
+        return true;
+    }
+
+    upload_stream.finish();
+    Logger.logLinef("Upload complete: %u bytes streamed", (unsigned)upload_stream.bytesIn());
+
+    char err[sizeof(upload_stream_error)];
+    portENTER_CRITICAL(&upload_stream_mux);
+    upload_stream_producer_done = true;
+    const bool decoded = upload_stream_consumer_done;
+    const bool ok = upload_stream_ok;
+    strlcpy(err, upload_stream_error, sizeof(err));
+    upload_stream_settle_locked();
+    portEXIT_CRITICAL(&upload_stream_mux);
+
+    if ((decoded && !ok) || upload_stream_stalled) {
+        if (!err[0]) strlcpy(err, "Decoder could not keep up with upload", sizeof(err));
+        Logger.logEnd("ERROR: Streamed image failed");
+        char resp[160];
+        snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", err);
+        request->send(400, "application/json", resp);
+        return true;
+    }
+
+    Logger.logEnd(decoded ? "Image streamed to display" : "Image streaming to display");
+
+    char response_msg[160];
+    snprintf(response_msg, sizeof(response_msg),
+             "{\"success\":true,\"message\":\"Image streamed to display (%lus timeout)\"}",
+             (unsigned long)(image_upload_timeout_ms / 1000));
+    request->send(200, "application/json", response_msg);
+    return true;
+}
+
+// Decode the streaming upload (main loop). Blocks until the image is complete,
+// the upload stalls for IMAGE_API_STREAM_IDLE_TIMEOUT_MS, or decode fails.
+static void image_api_decode_upload_stream() {
+    Logger.logMessage("Portal", "Decoding streamed image upload");
+    device_telemetry_log_memory_snapshot("img stream pre-decode");
+
+    const unsigned long t0 = millis();
+    const char* err = "Failed to decode image";
+    bool success = false;
+    image_profile_begin("stream");
+
+    #if HAS_DISPLAY
+    // Serialize with LVGL task; the wait hook releases it while the ring is empty.
+    display_manager_lock();
+    #endif
+
+    if (!image_api_begin_session(g_cfg.lcd_width, g_cfg.lcd_height, image_upload_timeout_ms, image_upload_start_ms)) {
+        err = "Failed to init image display";
+    } else {
+        upload_stream.setWaitHook(image_stream_wait_hook, nullptr);
+        success = image_api_decode_whole(nullptr, 0, ImageStreamRing::readFn, &upload_stream, image_upload_center);
+        if (!success && upload_stream.timedOut()) {
+            err = "Upload stalled";
+        }
+    }
+
+    #if HAS_DISPLAY
+    display_manager_unlock();
+    #endif
+    image_profile_end(success);
+
+    const uint32_t bytes = upload_stream.bytesOut();
+    upload_stream.close();
+
+    // A window still held reopens on the next poll, now that the ring is closed.
+    const uint32_t held_ms = upload_stream_held_ms;
+
+    device_telemetry_log_memory_snapshot("img stream post-decode");
+    Logger.logMessagef(
+        "Portal",
+        "Streamed image %s: %u bytes in %lu ms (upload held %lu ms for the decoder)",
+        success ? "done" : "FAILED",
+        (unsigned)bytes,
+        (unsigned long)(millis() - t0),
+        (unsigned long)held_ms
+    );
+
+    portENTER_CRITICAL(&upload_stream_mux);
+    upload_stream_ok = success;
+    strlcpy(upload_stream_error, success ? "" : err, sizeof(upload_stream_error));
+    upload_stream_consumer_done = true;
+    upload_stream_settle_locked();
+    portEXIT_CRITICAL(&upload_stream_mux);
+
+    if (!success && g_backend.hide_current_image) {
+        g_backend.hide_current_image();
+    }
+}
+#endif // IMAGE_API_STREAM_UPLOAD
+
+// ===== Handlers =====
+
+// POST /api/display/image - Upload and display JPEG image (deferred decode)
+static void handleImageUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+    (void)filename;
+
+#if IMAGE_API_STREAM_UPLOAD
+    // Decode while the body arrives when possible; otherwise buffer the whole image.
+    if (handleImageUploadStream(request, index, data, len, final)) return;
+#endif
+
+    // First chunk - initialize upload
+    if (index == 0) {
+        // If upload already in progress OR pending display, reject (client can retry)
+        if (upload_state == UPLOAD_IN_PROGRESS || upload_state == UPLOAD_READY_TO_DISPLAY || strip_queue_count() > 0) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Upload busy\"}");
+            return;
+        }
+
+        Logger.logBegin("Image Upload");
+        Logger.logLinef("Total size: %u bytes", request->contentLength());
+
+        image_upload_timeout_ms = parse_timeout_ms(request);
+        image_upload_center = parse_center(request);
+        image_upload_parallel = parse_parallel(request);
+        image_upload_start_ms = millis();
+        image_upload_start_us = image_profile_now_us();
+        image_upload_profile = {};
+        Logger.logLinef("Timeout: %lu ms", image_upload_timeout_ms);
+
+        device_telemetry_log_memory_snapshot("img pre-clear");
+
+        // Free any pending image buffer to make room for new upload
+        if (pending_image_op.buffer) {
+            Logger.logMessage("Upload", "Freeing pending image buffer");
+            image_api_free((void*)pending_image_op.buffer);
+            pending_image_op.buffer = nullptr;
+            pending_image_op.size = 0;
+        }
+
+        device_telemetry_log_memory_snapshot("img post-clear");
+
+        // Check file size
+        size_t total_size = request->contentLength();
+        if (total_size > g_cfg.max_image_size_bytes) {
+            Logger.logEnd("ERROR: Image too large");
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Image too large\"}");
+            return;
+        }
+
+        // Check memory availability.
+        // - Upload uses a single contiguous buffer (a pre-reserved pool slot when the pool serves it).
+        // - The decode pipeline needs headroom (historically expressed via g_cfg.decode_headroom_bytes).
+        const bool pooled = image_pool_fits(total_size);
+
+#if SOC_SPIRAM_SUPPORTED
+        // `SOC_SPIRAM_SUPPORTED` means the SoC can use PSRAM, but some boards have no PSRAM fitted.
+        // Use a runtime check so no-PSRAM boards don't take PSRAM-specific headroom gating.
+        const bool has_psram = psramFound();
+        const size_t psram_free = has_psram ? heap_caps_get_free_size(MALLOC_CAP_SPIRAM) : 0;
+        const size_t psram_largest = has_psram ? heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) : 0;
+        const bool psram_can_hold_upload = has_psram && (psram_free >= total_size) && (psram_largest >= total_size);
+#else
+        const size_t psram_free = 0;
+        const size_t psram_largest = 0;
+        const bool psram_can_hold_upload = false;
+#endif
+
+        // PSRAM boards vs no-PSRAM boards behave very differently.
+        // - On PSRAM boards: upload buffer is expected to land in PSRAM; keep an internal headroom guard.
+        // - On no-PSRAM boards: keep the historical "total heap" guard (ESP.getFreeHeap) so we don't
+        //   falsely reject when internal-only metrics look tight but the system can still operate.
+#if SOC_SPIRAM_SUPPORTED
+        if (has_psram) {
+            const size_t internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (internal_free < g_cfg.decode_headroom_bytes) {
+            Logger.logLinef(
+                "ERROR: Insufficient internal memory for decode headroom (need %u, have %u)",
+                (unsigned)g_cfg.decode_headroom_bytes,
+                (unsigned)internal_free
+            );
+            device_telemetry_log_memory_snapshot("img insufficient");
+            char error_msg[240];
+            snprintf(
+                error_msg,
+                sizeof(error_msg),
+                "{\"success\":false,\"message\":\"Insufficient internal memory: need %uKB decode headroom, have %uKB.\"}",
+                (unsigned)(g_cfg.decode_headroom_bytes / 1024),
+                (unsigned)(internal_free / 1024)
+            );
+            Logger.logEnd();
+            request->send(507, "application/json", error_msg);
+            return;
+            }
+
+            if (!pooled && !psram_can_hold_upload) {
+            // We'll fall back to non-PSRAM allocation; be conservative.
+            const size_t heap8_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+            const size_t heap8_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+            const size_t required_heap8 = total_size + g_cfg.decode_headroom_bytes;
+            if (heap8_free < required_heap8 || heap8_largest < total_size) {
+                Logger.logLinef(
+                    "ERROR: Insufficient memory (need %u heap8, have %u; largest %u; internal_free %u; psram_free %u largest %u)",
+                    (unsigned)required_heap8,
+                    (unsigned)heap8_free,
+                    (unsigned)heap8_largest,
+                    (unsigned)internal_free,
+                    (unsigned)psram_free,
+                    (unsigned)psram_largest
+                );
+                device_telemetry_log_memory_snapshot("img insufficient");
+                char error_msg[320];
+                snprintf(
+                    error_msg,
+                    sizeof(error_msg),
+                    "{\"success\":false,\"message\":\"Insufficient memory: need %uKB total heap, have %uKB (largest block %uKB).\"}",
+                    (unsigned)(required_heap8 / 1024),
+                    (unsigned)(heap8_free / 1024),
+                    (unsigned)(heap8_largest / 1024)
+                );
+                Logger.logEnd();
+                request->send(507, "application/json", error_msg);
+                return;
+            }
+            }
+        } else {
+            // No PSRAM fitted: total heap + largest block check (prevents immediate alloc failure).
+            const size_t free_heap = ESP.getFreeHeap();
+            const size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+            const size_t headroom = image_api_no_psram_effective_headroom_bytes(g_cfg.decode_headroom_bytes, free_heap, largest);
+            const size_t body = pooled ? 0 : total_size;
+            const size_t required = body + headroom;
+            if (free_heap < required || largest < body) {
+                Logger.logLinef(
+                    "ERROR: Insufficient memory (need %u heap, have %u; largest %u)",
+                    (unsigned)required,
+                    (unsigned)free_heap,
+                    (unsigned)largest
+                );
+                device_telemetry_log_memory_snapshot("img insufficient");
+                char error_msg[256];
+                snprintf(
+                    error_msg,
+                    sizeof(error_msg),
+                    "{\"success\":false,\"message\":\"Insufficient memory: need %uKB, have %uKB (largest block %uKB).\"}",
+                    (unsigned)(required / 1024),
+                    (unsigned)(free_heap / 1024),
+                    (unsigned)(largest / 1024)
+                );
+                Logger.logEnd();
+                request->send(507, "application/json", error_msg);
+                return;
+            }
+        }
+#else
+        // No PSRAM: total heap + largest block check (prevents immediate alloc failure).
+        const size_t free_heap = ESP.getFreeHeap();
+        const size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        const size_t headroom = image_api_no_psram_effective_headroom_bytes(g_cfg.decode_headroom_bytes, free_heap, largest);
+        const size_t body = pooled ? 0 : total_size;
+        const size_t required = body + headroom;
+        if (free_heap < required || largest < body) {
+            Logger.logLinef(
+                "ERROR: Insufficient memory (need %u heap, have %u; largest %u)",
+                (unsigned)required,
+                (unsigned)free_heap,
+                (unsigned)largest
+            );
+            device_telemetry_log_memory_snapshot("img insufficient");
+            char error_msg[256];
+            snprintf(
+                error_msg,
+                sizeof(error_msg),
+                "{\"success\":false,\"message\":\"Insufficient memory: need %uKB, have %uKB (largest block %uKB).\"}",
+                (unsigned)(required / 1024),
+                (unsigned)(free_heap / 1024),
+                (unsigned)(largest / 1024)
+            );
+            Logger.logEnd();
+            request->send(507, "application/json", error_msg);
+            return;
+        }
+#endif
+
+        // Allocate buffer
+        device_telemetry_log_memory_snapshot("img pre-alloc");
+        const uint32_t alloc_t0 = image_profile_now_us();
+        const char* refusal = nullptr;
+        image_upload_buffer = (uint8_t*)image_api_lease(total_size, &refusal);
+        image_profile_span_add(&image_upload_profile, IMAGE_STAGE_ALLOC, image_profile_now_us() - alloc_t0, (uint32_t)total_size);
+        if (!image_upload_buffer) {
+            if (refusal) {
+                Logger.logEnd("ERROR: Image buffer pool full");
+                send_lease_failure(request, refusal);
+                return;
+            }
+            Logger.logEnd("ERROR: Memory allocation failed");
+            device_telemetry_log_memory_snapshot("img alloc-fail");
+            request->send(507, "application/json", "{\"success\":false,\"message\":\"Memory allocation failed\"}");
+            return;
+        }
+        device_telemetry_log_memory_snapshot("img post-alloc");
+
+        image_upload_size = 0;
+        upload_state = UPLOAD_IN_PROGRESS;
+    }
+
+    // Receive data chunks
+    if (len && image_upload_buffer && upload_state == UPLOAD_IN_PROGRESS) {
+        memcpy(image_upload_buffer + image_upload_size, data, len);
+        image_upload_size += len;
+
+        // Log progress every 10KB
+        static size_t last_logged_size = 0;
+        if (image_upload_size - last_logged_size >= 10240) {
+            Logger.logLinef("Received: %u bytes", image_upload_size);
+            last_logged_size = image_upload_size;
+        }
+    }
+
+    // Final chunk - validate and queue for display
+    if (final) {
+        if (image_upload_buffer && image_upload_size > 0 && upload_state == UPLOAD_IN_PROGRESS) {
+            Logger.logLinef("Upload complete: %u bytes", image_upload_size);
+            const uint32_t receive_us = image_profile_now_us() - image_upload_start_us - image_upload_profile.us[IMAGE_STAGE_ALLOC];
+            image_profile_span_add(&image_upload_profile, IMAGE_STAGE_RECEIVE, receive_us, (uint32_t)image_upload_size);
+
+            if (!is_jpeg_magic(image_upload_buffer, image_upload_size)) {
+                Logger.logLinef("Invalid header: %02X %02X %02X %02X",
+                                image_upload_buffer[0], image_upload_buffer[1],
+                                image_upload_buffer[2], image_upload_buffer[3]);
+                Logger.logEnd("ERROR: Not a valid JPEG file");
+                image_api_free(image_upload_buffer);
+                image_upload_buffer = nullptr;
+                image_upload_size = 0;
+                upload_state = UPLOAD_IDLE;
+                request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JPEG file\"}");
+                return;
+            }
+
+            // Best-effort header preflight so we can return a descriptive 400 before queuing
+            char preflight_err[160];
+            const uint32_t preflight_t0 = image_profile_now_us();
+            JpegHeader upload_header;
+            const bool preflight_ok = image_api_preflight_whole(
+                image_upload_buffer,
+                image_upload_size,
+                &upload_header,
+                preflight_err,
+                sizeof(preflight_err));
+            image_profile_span_add(&image_upload_profile, IMAGE_STAGE_PREFLIGHT, image_profile_now_us() - preflight_t0, (uint32_t)image_upload_size);
+            if (!preflight_ok) {
+                Logger.logLinef("ERROR: JPEG preflight failed: %s", preflight_err);
+                Logger.logEnd();
+                image_api_free(image_upload_buffer);
+                image_upload_buffer = nullptr;
+                image_upload_size = 0;
+                upload_state = UPLOAD_IDLE;
+
+                char resp[256];
+                snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", preflight_err);
+                request->send(400, "application/json", resp);
+                return;
+            }
+
+            // Queue image for display by main loop (deferred operation)
+            if (pending_image_op.buffer) {
+                Logger.logMessage("Upload", "Replacing pending image");
+                image_api_free((void*)pending_image_op.buffer);
+            }
+
+            pending_image_op.buffer = image_upload_buffer;
+            pending_image_op.size = image_upload_size;
+            pending_image_op.dismiss = false;
+            pending_image_op.timeout_ms = image_upload_timeout_ms;
+            pending_image_op.start_time = millis();
+            pending_image_op.center = image_upload_center;
+            pending_image_op.parallel = image_upload_parallel;
+            pending_image_op.profile_kind = "upload";
+            pending_image_op.profile = image_upload_profile;
+            pending_image_op.header = upload_header;
+            pending_op_id++;
+            image_api_notify_job(IMAGE_JOB_UPLOAD);
+            upload_state = UPLOAD_READY_TO_DISPLAY;
+
+            // main loop owns the buffer now
+            image_upload_buffer = nullptr;
+            image_upload_size = 0;
+
+            Logger.logEnd("Image queued for display");
+
+            char response_msg[160];
+            snprintf(response_msg, sizeof(response_msg),
+                     "{\"success\":true,\"message\":\"Image queued for display (%lus timeout)\"}",
+                     (unsigned long)(image_upload_timeout_ms / 1000));
+            request->send(200, "application/json", response_msg);
+        } else {
+            Logger.logEnd("ERROR: No data received");
+            upload_state = UPLOAD_IDLE;
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"No data received\"}");
+        }
+    }
+}
+
+// DELETE /api/display/image - Manually dismiss image
+static void handleImageDelete(AsyncWebServerRequest *request) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+    Logger.logMessage("Portal", "Image dismiss requested");
+
+    // A streaming upload owns the display until it completes; let the client retry.
+    if (upload_state == UPLOAD_STREAMING) {
+        request->send(409, "application/json", "{\"success\":false,\"message\":\"Upload busy\"}");
+        return;
+    }
+
+#if IMAGE_API_MJPEG_STREAM && IMAGE_API_STREAM_URL
+    // Dismissing the image also ends a live stream (it would redraw otherwise).
+    image_mjpeg_request_stop();
+#endif
+
+    if (pending_image_op.buffer) {
+        image_api_free((void*)pending_image_op.buffer);
+    }
+    pending_image_op.buffer = nullptr;
+    pending_image_op.size = 0;
+    pending_image_op.dismiss = true;
+    upload_state = UPLOAD_READY_TO_DISPLAY;
+    pending_op_id++;
+    image_api_notify_job(IMAGE_JOB_DISMISS);
+
+    request->send(200, "application/json", "{\"success\":true,\"message\":\"Image dismiss queued\"}");
+}
+
+// Collect a small JSON body (shared by the JSON POST endpoints) in a portal
+// body lease; a disconnect mid-body returns the lease. Returns the whole body
+// once it is there (not NUL-terminated); on nullptr an error response may
+// already have been sent.
+static const uint8_t* image_url_body_collect(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    return portal_body_collect(request, "image_api", data, len, index, total, IMAGE_URL_BODY_MAX_SIZE);
+}
+
+static bool image_url_busy() {
+    bool url_op_active = false;
+    portENTER_CRITICAL(&pending_url_op_mux);
+    url_op_active = pending_url_op.active;
+    portEXIT_CRITICAL(&pending_url_op_mux);
+
+    return upload_state == UPLOAD_IN_PROGRESS || upload_state == UPLOAD_READY_TO_DISPLAY || upload_state == UPLOAD_STREAMING || url_op_active || strip_queue_count() > 0;
+}
+
+bool image_api_queue_url(const char* url, unsigned long timeout_ms, bool center, const char** err) {
+    const char* unused = nullptr;
+    if (!err) err = &unused;
+
+    if (!url || strlen(url) == 0) {
+        *err = "Missing url";
+        return false;
+    }
+    if (strlen(url) >= IMAGE_API_URL_MAX_LEN) {
+        *err = "URL too long";
+        return false;
+    }
+    if (image_url_busy()) {
+        *err = "Busy";
+        return false;
+    }
+    if (timeout_ms == 0) timeout_ms = g_cfg.default_timeout_ms;
+    if (timeout_ms > g_cfg.max_timeout_ms) timeout_ms = g_cfg.max_timeout_ms;
+
+    // Free any pending image buffer to make room.
+    if (pending_image_op.buffer) {
+        image_api_free((void*)pending_image_op.buffer);
+        pending_image_op.buffer = nullptr;
+        pending_image_op.size = 0;
+    }
+
+    // Publish the URL op: fill fields first, then flip `active` last.
+    // This is shared between the producer task (AsyncTCP, MQTT) and the image worker.
+    portENTER_CRITICAL(&pending_url_op_mux);
+    strncpy(pending_url_op.url, url, sizeof(pending_url_op.url));
+    pending_url_op.url[sizeof(pending_url_op.url) - 1] = '\0';
+    pending_url_op.timeout_ms = timeout_ms;
+    pending_url_op.center = center;
+    pending_url_op.active = true;
+    portEXIT_CRITICAL(&pending_url_op_mux);
+
+    upload_state = UPLOAD_READY_TO_DISPLAY;
+    pending_op_id++;
+    image_api_notify_job(IMAGE_JOB_URL);
+    return true;
+}
+
+// POST /api/display/image_url - Queue HTTP(S) JPEG download for display
+// Body: {"url":"https://example.com/image.jpg"}
+static void handleImageUrl(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+    // Only accept small JSON payloads.
+    if (index == 0 && image_url_busy()) {
+        request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
+        return;
+    }
+
+    const uint8_t* body = image_url_body_collect(request, data, len, index, total);
+    if (!body) return;
+
+    StaticJsonDocument<512> doc;
+    const DeserializationError jerr = deserializeJson(doc, body, total);
+    portal_body_release(request);
+
+    if (jerr) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+        return;
+    }
+
+    const char* url = doc["url"] | "";
+    const char* err = nullptr;
+    if (!image_api_queue_url(url, parse_timeout_ms(request), parse_center(request), &err)) {
+        char body[96];
+        snprintf(body, sizeof(body), "{\"success\":false,\"message\":\"%s\"}", err ? err : "Failed");
+        request->send(strcmp(err ? err : "", "Busy") == 0 ? 409 : 400, "application/json", body);
+        return;
+    }
+
+    request->send(200, "application/json", "{\"success\":true,\"message\":\"Image URL queued\"}");
+}
+
+// POST /api/display/image/strips?strip_index=N&strip_count=T&width=W&height=H[&timeout=seconds]
+// Upload a single JPEG strip; decode is deferred to the main loop.
+static void handleStripUpload(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+    // Validate required params
+    if (index == 0) {
+        const bool has_required =
+            request->hasParam("strip_index", false) &&
+            request->hasParam("strip_count", false) &&
+            request->hasParam("width", false) &&
+            request->hasParam("height", false);
+
+        if (!has_required) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing required parameters: strip_index, strip_count, width, height\"}");
+            return;
+        }
+    }
+
+    if (!request->hasParam("strip_index", false) || !request->hasParam("strip_count", false) ||
+        !request->hasParam("width", false) || !request->hasParam("height", false)) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing required parameters: strip_index, strip_count, width, height\"}");
+        return;
+    }
+
+    const int stripIndex = request->getParam("strip_index", false)->value().toInt();
+    const int totalStrips = request->getParam("strip_count", false)->value().toInt();
+    const int imageWidth = request->getParam("width", false)->value().toInt();
+    const int imageHeight = request->getParam("height", false)->value().toInt();
+    const unsigned long timeoutMs = request->hasParam("timeout", false)
+        ? (unsigned long)request->getParam("timeout", false)->value().toInt() * 1000UL
+        : g_cfg.default_timeout_ms;
+
+    if (index == 0) {
+        // Reject if we're busy. AsyncWebServer runs on AsyncTCP task; do not block.
+        // A full strip queue is the pipeline's back-pressure: the client retries shortly.
+        if (upload_state != UPLOAD_IDLE) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
+            return;
+        }
+        if (strip_queue_count() >= IMAGE_STRIP_PIPELINE_DEPTH) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Strip queue full\"}");
+            return;
+        }
+
+        // Only log first strip to reduce verbosity
+        if (stripIndex == 0) {
+            LOGI("Strip Mode", "Uploading %dx%d image (%d strips)", imageWidth, imageHeight, totalStrips);
+            device_telemetry_log_memory_snapshot("strip pre-alloc");
+        }
+
+        if (stripIndex < 0 || stripIndex >= totalStrips) {
+            Logger.logEnd("ERROR: Invalid strip index");
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid strip index\"}");
+            return;
+        }
+
+        if (imageWidth <= 0 || imageHeight <= 0 || imageWidth > g_cfg.lcd_width || imageHeight > g_cfg.lcd_height) {
+            Logger.logLinef("ERROR: Invalid dimensions %dx%d", imageWidth, imageHeight);
+            Logger.logEnd();
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid image dimensions\"}");
+            return;
+        }
+
+        if (current_strip_buffer) {
+            image_api_free((void*)current_strip_buffer);
+            current_strip_buffer = nullptr;
+        }
+
+        const char* refusal = nullptr;
+        current_strip_buffer = (uint8_t*)image_api_lease(total, &refusal);
+        if (!current_strip_buffer) {
+            Logger.logLinef("ERROR: %s (requested %u bytes, free heap: %u)", refusal ? refusal : "Out of memory", (unsigned)total, ESP.getFreeHeap());
+            device_telemetry_log_memory_snapshot("strip alloc-fail");
+            Logger.logEnd();
+            send_lease_failure(request, refusal);
+            return;
+        }
+
+        current_strip_size = 0;
+        strip_upload_last_activity_ms = millis();
+    }
+
+    if (current_strip_buffer && current_strip_size + len <= total) {
+        memcpy((uint8_t*)current_strip_buffer + current_strip_size, data, len);
+        current_strip_size += len;
+        strip_upload_last_activity_ms = millis();
+    }
+
+    // Final chunk: decode synchronously before returning
+    if (index + len >= total) {
+        if (current_strip_size != total) {
+            image_api_free((void*)current_strip_buffer);
+            current_strip_buffer = nullptr;
+            Logger.logEnd();
+            request->send(500, "application/json", "{\"success\":false,\"message\":\"Incomplete upload\"}");
+            return;
+        }
+
+        if (!is_jpeg_magic(current_strip_buffer, current_strip_size)) {
+            image_api_free((void*)current_strip_buffer);
+            current_strip_buffer = nullptr;
+            Logger.logEnd();
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JPEG data\"}");
+            return;
+        }
+
+        // Best-effort header preflight
+        char preflight_err[160];
+        const int remaining_height = imageHeight;
+        if (!jpeg_preflight_tjpgd_fragment_supported(
+                current_strip_buffer,
+                current_strip_size,
+                imageWidth,
+                remaining_height,
+                g_cfg.lcd_height,
+                preflight_err,
+                sizeof(preflight_err))) {
+            Logger.logLinef("ERROR: JPEG fragment preflight failed: %s", preflight_err);
+            image_api_free((void*)current_strip_buffer);
+            current_strip_buffer = nullptr;
+            Logger.logEnd();
+
+            char resp[256];
+            snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", preflight_err);
+            request->send(400, "application/json", resp);
+            return;
+        }
+
+        // Queue strip for async decode (don't decode in HTTP handler)
+        PendingStripOp op = {};
+        op.buffer = current_strip_buffer;
+        op.size = current_strip_size;
+        op.strip_index = (uint8_t)stripIndex;
+        op.image_width = imageWidth;
+        op.image_height = imageHeight;
+        op.total_strips = totalStrips;
+        op.timeout_ms = timeoutMs;
+        op.start_time = millis();
+        op.kind = STRIP_OP_JPEG;
+
+        // If we're busy, reject and let client retry.
+        if (!strip_queue_push(op)) {
+            image_api_free((void*)current_strip_buffer);
+            current_strip_buffer = nullptr;
+            Logger.logEnd();
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}" );
+            return;
+        }
+        
+        current_strip_buffer = nullptr;
+        current_strip_size = 0;
+        
+        image_api_notify_job(IMAGE_JOB_STRIP);
+        
+        LOGD("Strip", "Strip %d/%d queued for decode (%u waiting)", stripIndex, totalStrips - 1, (unsigned)strip_queue_count());
+        Logger.logEnd();
+
+        char response[160];
+        snprintf(response, sizeof(response),
+                 "{\"success\":true,\"strip_index\":%d,\"strip_count\":%d,\"complete\":%s}",
+                 stripIndex, totalStrips, (stripIndex == totalStrips - 1) ? "true" : "false");
+        request->send(200, "application/json", response);
+    }
+}
+
+#if IMAGE_API_RAW_UPLOAD
+static int raw_param_int(AsyncWebServerRequest* request, const char* name, int fallback) {
+    return request->hasParam(name, false) ? request->getParam(name, false)->value().toInt() : fallback;
+}
+
+// POST /api/display/image/raw?x=&y=&w=&h=[&encoding=raw|rle|lz4][&order=be|le][&first=0|1][&timeout=]
+// Body: one RGB565 rectangle (see rgb565_codec.h). Queued like a strip; no JPEG decode.
+static void handleRawUpload(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+
+    if (!request->hasParam("w", false) || !request->hasParam("h", false)) {
+        if (index == 0) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing required parameters: w, h\"}");
+        }
+        return;
+    }
+
+    const int x = raw_param_int(request, "x", 0);
+    const int y = raw_param_int(request, "y", 0);
+    const int w = raw_param_int(request, "w", 0);
+    const int h = raw_param_int(request, "h", 0);
+    // A rectangle at the origin starts a new image unless told otherwise.
+    const bool first = raw_param_int(request, "first", (x == 0 && y == 0) ? 1 : 0) != 0;
+    const unsigned long timeoutMs = request->hasParam("timeout", false)
+        ? (unsigned long)request->getParam("timeout", false)->value().toInt() * 1000UL
+        : g_cfg.default_timeout_ms;
+
+    Rgb565Encoding encoding = RGB565_ENCODING_RAW;
+    const String enc_name = request->hasParam("encoding", false) ? request->getParam("encoding", false)->value() : String("raw");
+    const String order = request->hasParam("order", false) ? request->getParam("order", false)->value() : String("be");
+
+    if (index == 0) {
+        if (!g_backend.push_rect) {
+            request->send(501, "application/json", "{\"success\":false,\"message\":\"Raw upload not supported\"}");
+            return;
+        }
+        if (!rgb565_parse_encoding(enc_name.c_str(), &encoding)) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Unknown encoding (raw, rle, lz4)\"}");
             return;
-            }
+        }
+        if (order != "be" && order != "le") {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid order (be, le)\"}");
+            return;
+        }
+        if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > g_cfg.lcd_width || y + h > g_cfg.lcd_height) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Rectangle outside the display\"}");
+            return;
+        }
 
-            if (!psram_can_hold_upload) {
-            // We'll fall back to non-PSRAM allocation; be conservative.
-            const size_t heap8_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
-            const size_t heap8_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
-            const size_t required_heap8 = total_size + g_cfg.decode_headroom_bytes;
-            if (heap8_free < required_heap8 || heap8_largest < total_size) {
-                Logger.logLinef(
-                    "ERROR: Insufficient memory (need %u heap8, have %u; largest %u; internal_free %u; psram_free %u largest %u)",
-                    (unsigned)required_heap8,
-                    (unsigned)heap8_free,
-                    (unsigned)heap8_largest,
-                    (unsigned)internal_free,
-                    (unsigned)psram_free,
-                    (unsigned)psram_largest
-                );
-                device_telemetry_log_memory_snapshot("img insufficient");
-                char error_msg[320];
-                snprintf(
-                    error_msg,
-                    sizeof(error_msg),
-                    "{\"success\":false,\"message\":\"Insufficient memory: need %uKB total heap, have %uKB (largest block %uKB).\"}",
-                    (unsigned)(required_heap8 / 1024),
-                    (unsigned)(heap8_free / 1024),
-                    (unsigned)(heap8_largest / 1024)
-                );
-                Logger.logEnd();
-                request->send(507, "application/json", error_msg);
-                return;
-            }
-            }
-        } else {
-            // No PSRAM fitted: total heap + largest block check (prevents immediate alloc failure).
-            const size_t free_heap = ESP.getFreeHeap();
-            const size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
-            const size_t headroom = image_api_no_psram_effective_headroom_bytes(g_cfg.decode_headroom_bytes, free_heap, largest);
-            const size_t required = total_size + headroom;
-            if (free_heap < required || largest < total_size) {
-                Logger.logLinef(
-                    "ERROR: Insufficient memory (need %u heap, have %u; largest %u)",
-                    (unsigned)required,
-                    (unsigned)free_heap,
-                    (unsigned)largest
-                );
-                device_telemetry_log_memory_snapshot("img insufficient");
-                char error_msg[256];
-                snprintf(
-                    error_msg,
-                    sizeof(error_msg),
-                    "{\"success\":false,\"message\":\"Insufficient memory: need %uKB, have %uKB (largest block %uKB).\"}",
-                    (unsigned)(required / 1024),
-                    (unsigned)(free_heap / 1024),
-                    (unsigned)(largest / 1024)
-                );
-                Logger.logEnd();
-                request->send(507, "application/json", error_msg);
-                return;
-            }
+        const size_t pixel_bytes = (size_t)w * (size_t)h * 2;
+        if (pixel_bytes > g_cfg.max_image_size_bytes || total == 0 || total > g_cfg.max_image_size_bytes) {
+            request->send(413, "application/json", "{\"success\":false,\"message\":\"Rectangle too large (split it)\"}");
+            return;
         }
-#else
-        // No PSRAM: total heap + largest block check (prevents immediate alloc failure).
-        const size_t free_heap = ESP.getFreeHeap();
-        const size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
-        const size_t headroom = image_api_no_psram_effective_headroom_bytes(g_cfg.decode_headroom_bytes, free_heap, largest);
-        const size_t required = total_size + headroom;
-        if (free_heap < required || largest < total_size) {
-            Logger.logLinef(
-                "ERROR: Insufficient memory (need %u heap, have %u; largest %u)",
-                (unsigned)required,
-                (unsigned)free_heap,
-                (unsigned)largest
-            );
-            device_telemetry_log_memory_snapshot("img insufficient");
-            char error_msg[256];
-            snprintf(
-                error_msg,
-                sizeof(error_msg),
-                "{\"success\":false,\"message\":\"Insufficient memory: need %uKB, have %uKB (largest block %uKB).\"}",
-                (unsigned)(required / 1024),
-                (unsigned)(free_heap / 1024),
-                (unsigned)(largest / 1024)
-            );
-            Logger.logEnd();
-            request->send(507, "application/json", error_msg);
+        if (encoding == RGB565_ENCODING_RAW && total != pixel_bytes) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Body size must be w*h*2\"}");
             return;
         }
-#endif
 
-        // Allocate buffer
-        device_telemetry_log_memory_snapshot("img pre-alloc");
-        image_upload_buffer = (uint8_t*)image_api_alloc(total_size);
-        if (!image_upload_buffer) {
-            Logger.logEnd("ERROR: Memory allocation failed");
-            device_telemetry_log_memory_snapshot("img alloc-fail");
-            request->send(507, "application/json", "{\"success\":false,\"message\":\"Memory allocation failed\"}");
+        // Same back-pressure as strips.
+        if (upload_state != UPLOAD_IDLE) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
+            return;
+        }
+        if (strip_queue_count() >= IMAGE_STRIP_PIPELINE_DEPTH) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Strip queue full\"}");
             return;
         }
-        device_telemetry_log_memory_snapshot("img post-alloc");
 
-        image_upload_size = 0;
-        upload_state = UPLOAD_IN_PROGRESS;
+        if (current_strip_buffer) {
+            image_api_free((void*)current_strip_buffer);
+            current_strip_buffer = nullptr;
+        }
+
+        const char* refusal = nullptr;
+        current_strip_buffer = (uint8_t*)image_api_lease(total, &refusal);
+        if (!current_strip_buffer) {
+            Logger.logMessagef("Raw", "ERROR: %s (requested %u bytes, free heap: %u)", refusal ? refusal : "Out of memory", (unsigned)total, ESP.getFreeHeap());
+            send_lease_failure(request, refusal);
+            return;
+        }
+
+        current_strip_size = 0;
+        strip_upload_last_activity_ms = millis();
     }
 
-    // Receive data chunks
-    if (len && image_upload_buffer && upload_state == UPLOAD_IN_PROGRESS) {
-        memcpy(image_upload_buffer + image_upload_size, data, len);
-        image_upload_size += len;
+    if (!current_strip_buffer) return;
 
-        // Log progress every 10KB
-        static size_t last_logged_size = 0;
-        if (image_upload_size - last_logged_size >= 10240) {
-            Logger.logLinef("Received: %u bytes", image_upload_size);
-            last_logged_size = image_upload_size;
+    if (current_strip_size + len <= total) {
+        memcpy((uint8_t*)current_strip_buffer + current_strip_size, data, len);
+        current_strip_size += len;
+        strip_upload_last_activity_ms = millis();
+    }
+
+    if (index + len < total) return;
+
+    if (current_strip_size != total) {
+        image_api_free((void*)current_strip_buffer);
+        current_strip_buffer = nullptr;
+        request->send(500, "application/json", "{\"success\":false,\"message\":\"Incomplete upload\"}");
+        return;
+    }
+
+    (void)rgb565_parse_encoding(enc_name.c_str(), &encoding);
+
+    PendingStripOp op = {};
+    op.buffer = current_strip_buffer;
+    op.size = current_strip_size;
+    op.strip_index = first ? 0 : 1;
+    op.image_width = w;
+    op.image_height = h;
+    op.total_strips = 1;
+    op.timeout_ms = timeoutMs;
+    op.start_time = millis();
+    op.kind = STRIP_OP_RECT;
+    op.encoding = (uint8_t)encoding;
+    op.big_endian = (order == "be");
+    op.x = x;
+    op.y = y;
+    op.has_timeout = request->hasParam("timeout", false);
+    if (!strip_queue_push(op)) {
+        image_api_free((void*)current_strip_buffer);
+        current_strip_buffer = nullptr;
+        request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
+        return;
+    }
+
+    current_strip_buffer = nullptr;
+    current_strip_size = 0;
+
+    image_api_notify_job(IMAGE_JOB_STRIP);
+
+    request->send(200, "application/json", "{\"success\":true}");
+}
+#endif // IMAGE_API_RAW_UPLOAD
+
+#if IMAGE_API_TILE_UPLOAD
+// POST /api/display/image/tiles[?timeout=]
+// Body: tile records (see image_tiles.h) drawn over the image on screen.
+static void handleTileUpload(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+
+    if (index == 0) {
+        if (!g_backend.push_rect) {
+            request->send(501, "application/json", "{\"success\":false,\"message\":\"Tile upload not supported\"}");
+            return;
+        }
+        if (total == 0 || total > g_cfg.max_image_size_bytes) {
+            request->send(413, "application/json", "{\"success\":false,\"message\":\"Tile batch too large\"}");
+            return;
         }
+
+        // Same back-pressure as strips.
+        if (upload_state != UPLOAD_IDLE) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
+            return;
+        }
+        if (strip_queue_count() >= IMAGE_STRIP_PIPELINE_DEPTH) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Strip queue full\"}");
+            return;
+        }
+
+        if (current_strip_buffer) {
+            image_api_free((void*)current_strip_buffer);
+            current_strip_buffer = nullptr;
+        }
+
+        const char* refusal = nullptr;
+        current_strip_buffer = (uint8_t*)image_api_lease(total, &refusal);
+        if (!current_strip_buffer) {
+            Logger.logMessagef("Tiles", "ERROR: %s (requested %u bytes, free heap: %u)", refusal ? refusal : "Out of memory", (unsigned)total, ESP.getFreeHeap());
+            send_lease_failure(request, refusal);
+            return;
+        }
+
+        current_strip_size = 0;
+        strip_upload_last_activity_ms = millis();
     }
 
-    // Final chunk - validate and queue for display
-    if (final) {
-        if (image_upload_buffer && image_upload_size > 0 && upload_state == UPLOAD_IN_PROGRESS) {
-            Logger.logLinef("Upload complete: %u bytes", image_upload_size);
+    if (!current_strip_buffer) return;
 
-            if (!is_jpeg_magic(image_upload_buffer, image_upload_size)) {
-                Logger.logLinef("Invalid header: %02X %02X %02X %02X",
-                                image_upload_buffer[0], image_upload_buffer[1],
-                                image_upload_buffer[2], image_upload_buffer[3]);
-                Logger.logEnd("ERROR: Not a valid JPEG file");
-                image_api_free(image_upload_buffer);
-                image_upload_buffer = nullptr;
-                image_upload_size = 0;
-                upload_state = UPLOAD_IDLE;
-                request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JPEG file\"}");
-                return;
-            }
+    if (current_strip_size + len <= total) {
+        memcpy((uint8_t*)current_strip_buffer + current_strip_size, data, len);
+        current_strip_size += len;
+        strip_upload_last_activity_ms = millis();
+    }
 
-            // Best-effort header preflight so we can return a descriptive 400 before queuing
-            char preflight_err[160];
-            if (!jpeg_preflight_tjpgd_supported(
-                    image_upload_buffer,
-                    image_upload_size,
-                    g_cfg.lcd_width,
-                    g_cfg.lcd_height,
-                    preflight_err,
-                    sizeof(preflight_err))) {
-                Logger.logLinef("ERROR: JPEG preflight failed: %s", preflight_err);
-                Logger.logEnd();
-                image_api_free(image_upload_buffer);
-                image_upload_buffer = nullptr;
-                image_upload_size = 0;
-                upload_state = UPLOAD_IDLE;
+    if (index + len < total) return;
 
-                char resp[256];
-                snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", preflight_err);
-                request->send(400, "application/json", resp);
-                return;
-            }
+    if (current_strip_size != total) {
+        image_api_free((void*)current_strip_buffer);
+        current_strip_buffer = nullptr;
+        request->send(500, "application/json", "{\"success\":false,\"message\":\"Incomplete upload\"}");
+        return;
+    }
 
-            // Queue image for display by main loop (deferred operation)
-            if (pending_image_op.buffer) {
-                Logger.logMessage("Upload", "Replacing pending image");
-                image_api_free((void*)pending_image_op.buffer);
-            }
+    // Reject malformed batches up front; the consumer then only skips tiles that fail to draw.
+    char err[160];
+    const int tiles = image_tiles_validate(
+        current_strip_buffer,
+        current_strip_size,
+        g_cfg.lcd_width,
+        g_cfg.lcd_height,
+        g_cfg.max_image_size_bytes,
+        err,
+        sizeof(err)
+    );
+    if (tiles < 0) {
+        image_api_free((void*)current_strip_buffer);
+        current_strip_buffer = nullptr;
 
-            pending_image_op.buffer = image_upload_buffer;
-            pending_image_op.size = image_upload_size;
-            pending_image_op.dismiss = false;
-            pending_image_op.timeout_ms = image_upload_timeout_ms;
-            pending_image_op.start_time = millis();
-            pending_op_id++;
-            upload_state = UPLOAD_READY_TO_DISPLAY;
+        char resp[224];
+        snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", err);
+        request->send(400, "application/json", resp);
+        return;
+    }
 
-            // main loop owns the buffer now
-            image_upload_buffer = nullptr;
-            image_upload_size = 0;
+    PendingStripOp op = {};
+    op.buffer = current_strip_buffer;
+    op.size = current_strip_size;
+    op.strip_index = 1;  // Never starts an image
+    op.image_width = 0;
+    op.image_height = 0;
+    op.total_strips = 1;
+    op.timeout_ms = request->hasParam("timeout", false)
+        ? (unsigned long)request->getParam("timeout", false)->value().toInt() * 1000UL
+        : g_cfg.default_timeout_ms;
+    op.start_time = millis();
+    op.kind = STRIP_OP_TILES;
+    op.has_timeout = request->hasParam("timeout", false);
+    if (!strip_queue_push(op)) {
+        image_api_free((void*)current_strip_buffer);
+        current_strip_buffer = nullptr;
+        request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
+        return;
+    }
 
-            Logger.logEnd("Image queued for display");
+    current_strip_buffer = nullptr;
+    current_strip_size = 0;
 
-            char response_msg[160];
-            snprintf(response_msg, sizeof(response_msg),
-                     "{\"success\":true,\"message\":\"Image queued for display (%lus timeout)\"}",
-                     (unsigned long)(image_upload_timeout_ms / 1000));
-            request->send(200, "application/json", response_msg);
-        } else {
-            Logger.logEnd("ERROR: No data received");
-            upload_state = UPLOAD_IDLE;
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"No data received\"}");
+    image_api_notify_job(IMAGE_JOB_STRIP);
+
+    char response[64];
+    snprintf(response, sizeof(response), "{\"success\":true,\"tiles\":%d}", tiles);
+    request->send(200, "application/json", response);
+}
+#endif // IMAGE_API_TILE_UPLOAD
+
+#if IMAGE_API_WEBSOCKET
+// /api/display/ws: strips, rectangles and tile batches over one connection
+// (wire format in image_ws.h). Events run on the AsyncTCP task like the HTTP
+// handlers, so the channel is one more producer for the strip queue. One
+// client owns the channel; a new connection takes it over.
+static AsyncWebSocket image_ws("/api/display/ws");
+static uint32_t ws_client_id = 0;
+static uint8_t ws_header_buf[IMAGE_WS_HEADER_BYTES];
+static size_t ws_header_len = 0;
+static bool ws_header_done = false;
+static ImageWsHeader ws_header = {};
+static uint8_t* ws_payload = nullptr;
+static size_t ws_payload_size = 0;
+static size_t ws_payload_len = 0;
+static uint8_t ws_reject = IMAGE_WS_OK;  // non-OK: drop the rest of the message, then ack
+static uint32_t ws_messages = 0;
+static uint32_t ws_rejected = 0;
+
+static void ws_reset_message() {
+    if (ws_payload) {
+        image_api_free((void*)ws_payload);
+        ws_payload = nullptr;
+    }
+    ws_payload_size = 0;
+    ws_payload_len = 0;
+    ws_header_len = 0;
+    ws_header_done = false;
+    ws_header = {};
+    ws_reject = IMAGE_WS_OK;
+}
+
+static void ws_ack(AsyncWebSocketClient* client, uint8_t status) {
+    const uint32_t queued = strip_queue_count();
+    const uint8_t free_slots = (queued < IMAGE_STRIP_PIPELINE_DEPTH) ? (uint8_t)(IMAGE_STRIP_PIPELINE_DEPTH - queued) : 0;
+
+    uint8_t ack[IMAGE_WS_ACK_BYTES];
+    image_ws_pack_ack(ack, ws_header.seq, status, free_slots);
+    client->binary(ack, sizeof(ack));
+
+    if (status == IMAGE_WS_OK) {
+        ws_messages++;
+    } else {
+        ws_rejected++;
+        if (status != IMAGE_WS_BUSY) {
+            Logger.logMessagef("WS", "Message %u (type %u) rejected: %s",
+                               (unsigned)ws_header.seq, (unsigned)ws_header.type, image_ws_status_name(status));
         }
     }
 }
 
-// DELETE /api/display/image - Manually dismiss image
-static void handleImageDelete(AsyncWebServerRequest *request) {
-    if (g_auth_gate && !g_auth_gate(request)) return;
-    Logger.logMessage("Portal", "Image dismiss requested");
+// Header checks that need no payload; same rules as the HTTP endpoints.
+static uint8_t ws_check_header(const ImageWsHeader& h, size_t payload) {
+    if (payload == 0 || payload > g_cfg.max_image_size_bytes) return IMAGE_WS_TOO_LARGE;
 
-    if (pending_image_op.buffer) {
-        image_api_free((void*)pending_image_op.buffer);
+    switch (h.type) {
+        case IMAGE_WS_STRIP:
+            if (!g_backend.start_strip_session || !g_backend.decode_strip) return IMAGE_WS_UNSUPPORTED;
+            if (h.b == 0 || h.b > 255 || h.a >= h.b) return IMAGE_WS_BAD_REQUEST;
+            if (h.w == 0 || h.h == 0 || h.w > g_cfg.lcd_width || h.h > g_cfg.lcd_height) return IMAGE_WS_BAD_REQUEST;
+            break;
+        case IMAGE_WS_RECT: {
+            #if IMAGE_API_RAW_UPLOAD
+            if (!g_backend.push_rect) return IMAGE_WS_UNSUPPORTED;
+            if (h.encoding > RGB565_ENCODING_LZ4) return IMAGE_WS_BAD_REQUEST;
+            if (h.w == 0 || h.h == 0 || h.a + h.w > g_cfg.lcd_width || h.b + h.h > g_cfg.lcd_height) return IMAGE_WS_BAD_REQUEST;
+            const size_t pixel_bytes = (size_t)h.w * (size_t)h.h * 2;
+            if (pixel_bytes > g_cfg.max_image_size_bytes) return IMAGE_WS_TOO_LARGE;
+            if (h.encoding == RGB565_ENCODING_RAW && payload != pixel_bytes) return IMAGE_WS_BAD_REQUEST;
+            break;
+            #else
+            return IMAGE_WS_UNSUPPORTED;
+            #endif
+        }
+        case IMAGE_WS_TILES:
+            #if IMAGE_API_TILE_UPLOAD
+            if (!g_backend.push_rect) return IMAGE_WS_UNSUPPORTED;
+            break;
+            #else
+            return IMAGE_WS_UNSUPPORTED;
+            #endif
+        default:
+            return IMAGE_WS_BAD_REQUEST;
     }
-    pending_image_op.buffer = nullptr;
-    pending_image_op.size = 0;
-    pending_image_op.dismiss = true;
-    upload_state = UPLOAD_READY_TO_DISPLAY;
-    pending_op_id++;
 
-    request->send(200, "application/json", "{\"success\":true,\"message\":\"Image dismiss queued\"}");
+    if (upload_state != UPLOAD_IDLE || strip_queue_count() >= IMAGE_STRIP_PIPELINE_DEPTH) return IMAGE_WS_BUSY;
+    return IMAGE_WS_OK;
 }
 
-// POST /api/display/image_url - Queue HTTP(S) JPEG download for display
-// Body: {"url":"https://example.com/image.jpg"}
-static void handleImageUrl(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-    if (g_auth_gate && !g_auth_gate(request)) return;
-    // Only accept small JSON payloads.
-    if (index == 0) {
-        bool url_op_active = false;
-        portENTER_CRITICAL(&pending_url_op_mux);
-        url_op_active = pending_url_op.active;
-        portEXIT_CRITICAL(&pending_url_op_mux);
+// Whole payload received: validate it and hand it to the strip queue.
+static uint8_t ws_queue_message() {
+    const ImageWsHeader& h = ws_header;
 
-        if (upload_state == UPLOAD_IN_PROGRESS || upload_state == UPLOAD_READY_TO_DISPLAY || url_op_active || pending_strip_op.buffer) {
-            request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
-            return;
-        }
-        if (total == 0 || total > IMAGE_URL_BODY_MAX_SIZE) {
-            request->send(413, "application/json", "{\"success\":false,\"message\":\"Body too large\"}");
-            return;
+    if (h.type == IMAGE_WS_STRIP) {
+        if (!is_jpeg_magic(ws_payload, ws_payload_len)) return IMAGE_WS_BAD_REQUEST;
+        char preflight_err[160];
+        if (!jpeg_preflight_tjpgd_fragment_supported(
+                ws_payload, ws_payload_len, h.w, h.h, g_cfg.lcd_height, preflight_err, sizeof(preflight_err))) {
+            Logger.logMessagef("WS", "ERROR: JPEG fragment preflight failed: %s", preflight_err);
+            return IMAGE_WS_BAD_REQUEST;
         }
-        // If a previous request stalled (e.g., disconnect mid-body), reclaim after a short timeout.
-        if (image_url_body_in_use) {
-            const unsigned long elapsed = (unsigned long)(millis() - image_url_body_start_ms);
-            if (elapsed > 3000UL) {
-                image_url_body_in_use = false;
-                image_url_body_expected_len = 0;
-                image_url_body_buf[0] = '\0';
-            } else {
-                request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
-                return;
-            }
+    }
+    #if IMAGE_API_TILE_UPLOAD
+    if (h.type == IMAGE_WS_TILES) {
+        char err[160];
+        if (image_tiles_validate(ws_payload, ws_payload_len, g_cfg.lcd_width, g_cfg.lcd_height, g_cfg.max_image_size_bytes, err, sizeof(err)) < 0) {
+            Logger.logMessagef("WS", "ERROR: %s", err);
+            return IMAGE_WS_BAD_REQUEST;
         }
-
-        image_url_body_in_use = true;
-        image_url_body_expected_len = total;
-        image_url_body_start_ms = millis();
-        image_url_body_buf[0] = '\0';
     }
-
-    if (!image_url_body_in_use || total == 0 || total != image_url_body_expected_len) {
-        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid body state\"}");
-        return;
+    #endif
+
+    const bool has_timeout = h.timeout_s != 0;
+    PendingStripOp op = {};
+    op.buffer = ws_payload;
+    op.size = ws_payload_len;
+    op.timeout_ms = has_timeout ? (unsigned long)h.timeout_s * 1000UL : g_cfg.default_timeout_ms;
+    op.start_time = millis();
+    op.has_timeout = has_timeout;
+    op.total_strips = 1;
+    op.image_width = h.w;
+    op.image_height = h.h;
+    switch (h.type) {
+        case IMAGE_WS_STRIP:
+            op.kind = STRIP_OP_JPEG;
+            op.strip_index = (uint8_t)h.a;
+            op.total_strips = h.b;
+            break;
+        case IMAGE_WS_RECT:
+            op.kind = STRIP_OP_RECT;
+            op.strip_index = (h.flags & IMAGE_WS_FLAG_FIRST) ? 0 : 1;
+            op.encoding = h.encoding;
+            op.big_endian = (h.flags & IMAGE_WS_FLAG_LITTLE_ENDIAN) == 0;
+            op.x = h.a;
+            op.y = h.b;
+            break;
+        default:
+            op.kind = STRIP_OP_TILES;
+            op.strip_index = 1;  // Never starts an image
+            op.image_width = 0;
+            op.image_height = 0;
+            break;
     }
+    if (!strip_queue_push(op)) return IMAGE_WS_BUSY;
 
-    // Never accept more bytes than the buffer's data capacity (excluding the null terminator).
-    if (index + len > IMAGE_URL_BODY_MAX_SIZE) {
-        image_url_body_in_use = false;
-        image_url_body_expected_len = 0;
-        request->send(413, "application/json", "{\"success\":false,\"message\":\"Body too large\"}");
-        return;
-    }
+    // The queue owns the payload now.
+    ws_payload = nullptr;
+    ws_payload_len = 0;
 
-    memcpy(image_url_body_buf + index, data, len);
-    if (index + len >= total) {
-        image_url_body_buf[total] = '\0';
+    image_api_notify_job(IMAGE_JOB_STRIP);
+    return IMAGE_WS_OK;
+}
 
-        StaticJsonDocument<512> doc;
-        const DeserializationError jerr = deserializeJson(doc, image_url_body_buf);
-        image_url_body_in_use = false;
-        image_url_body_expected_len = 0;
+static void ws_on_data(AsyncWebSocketClient* client, const AwsFrameInfo* info, const uint8_t* data, size_t len) {
+    if (client->id() != ws_client_id) return;     // Replaced; closing
+    if (info->message_opcode != WS_BINARY) return;  // Text is not part of the protocol
 
-        if (jerr) {
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
-            return;
-        }
+    if (info->num == 0 && info->index == 0) {
+        ws_reset_message();
+        // One frame per message: the frame length sizes the payload lease.
+        if (!info->final) ws_reject = IMAGE_WS_BAD_REQUEST;
+    }
 
-        const char* url = doc["url"] | "";
-        if (!url || strlen(url) == 0) {
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing url\"}");
-            return;
-        }
-        if (strlen(url) >= IMAGE_API_URL_MAX_LEN) {
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"URL too long\"}");
-            return;
+    // The header can straddle TCP segments.
+    size_t off = 0;
+    if (!ws_header_done) {
+        const size_t want = IMAGE_WS_HEADER_BYTES - ws_header_len;
+        const size_t n = (len < want) ? len : want;
+        memcpy(ws_header_buf + ws_header_len, data, n);
+        ws_header_len += n;
+        off = n;
+
+        if (ws_header_len == IMAGE_WS_HEADER_BYTES) {
+            ws_header_done = true;
+            image_ws_parse_header(ws_header_buf, ws_header_len, &ws_header);
+
+            if (ws_reject == IMAGE_WS_OK) {
+                ws_payload_size = (size_t)info->len - IMAGE_WS_HEADER_BYTES;
+                ws_reject = ws_check_header(ws_header, ws_payload_size);
+            }
+            if (ws_reject == IMAGE_WS_OK) {
+                const char* refusal = nullptr;
+                ws_payload = (uint8_t*)image_api_lease(ws_payload_size, &refusal);
+                if (!ws_payload) {
+                    Logger.logMessagef("WS", "ERROR: %s (requested %u bytes, free heap: %u)",
+                                       refusal ? refusal : "Out of memory", (unsigned)ws_payload_size, ESP.getFreeHeap());
+                    ws_reject = IMAGE_WS_NO_MEMORY;
+                }
+            }
         }
+    }
 
-        // Free any pending image buffer to make room.
-        if (pending_image_op.buffer) {
-            image_api_free((void*)pending_image_op.buffer);
-            pending_image_op.buffer = nullptr;
-            pending_image_op.size = 0;
+    if (ws_payload && off < len) {
+        const size_t n = len - off;
+        if (ws_payload_len + n <= ws_payload_size) {
+            memcpy(ws_payload + ws_payload_len, data + off, n);
+            ws_payload_len += n;
         }
+    }
 
-        // Publish the URL op: fill fields first, then flip `active` last.
-        // This is shared between the AsyncTCP task and the main loop.
-        portENTER_CRITICAL(&pending_url_op_mux);
-        strncpy(pending_url_op.url, url, sizeof(pending_url_op.url));
-        pending_url_op.url[sizeof(pending_url_op.url) - 1] = '\0';
-        pending_url_op.timeout_ms = parse_timeout_ms(request);
-        pending_url_op.active = true;
-        portEXIT_CRITICAL(&pending_url_op_mux);
+    const bool message_end = info->final && (info->index + len >= info->len);
+    if (!message_end) return;
 
-        upload_state = UPLOAD_READY_TO_DISPLAY;
-        pending_op_id++;
+    uint8_t status = ws_reject;
+    if (!ws_header_done) {
+        status = IMAGE_WS_BAD_REQUEST;
+    } else if (status == IMAGE_WS_OK) {
+        status = (ws_payload_len == ws_payload_size) ? ws_queue_message() : IMAGE_WS_BAD_REQUEST;
+    }
+    ws_ack(client, status);
+    ws_reset_message();
+}
 
-        request->send(200, "application/json", "{\"success\":true,\"message\":\"Image URL queued\"}");
+static void image_ws_event(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    switch (type) {
+        case WS_EVT_CONNECT:
+            if (ws_client_id && ws_client_id != client->id()) {
+                AsyncWebSocketClient* previous = server->client(ws_client_id);
+                if (previous) previous->close(1000, "Replaced by a new connection");
+                ws_reset_message();
+            }
+            ws_client_id = client->id();
+            Logger.logMessagef("WS", "Client #%u connected from %s", (unsigned)client->id(), client->remoteIP().toString().c_str());
+            break;
+        case WS_EVT_DISCONNECT:
+            if (client->id() == ws_client_id) {
+                ws_reset_message();
+                ws_client_id = 0;
+                Logger.logMessagef("WS", "Client #%u disconnected", (unsigned)client->id());
+            }
+            break;
+        case WS_EVT_DATA:
+            ws_on_data(client, (const AwsFrameInfo*)arg, data, len);
+            break;
+        default:
+            break;
     }
 }
+#endif // IMAGE_API_WEBSOCKET
+
+#if IMAGE_API_MULTICAST
+// Multicast fan-out (wire format in image_mcast.h). A task of its own blocks
+// on the group's socket and puts strips together from their datagrams;
+// completed strips join the strip queue like uploaded ones. Datagrams wait in
+// lwIP's small receive mailbox meanwhile, so senders pace their output.
+static constexpr uint32_t MCAST_TASK_STACK_BYTES = 4096;
+static constexpr int MCAST_RECV_TIMEOUT_MS = 250;
+
+static portMUX_TYPE mcast_cfg_mux = portMUX_INITIALIZER_UNLOCKED;
+static char mcast_cfg_group[16] = {};
+static uint16_t mcast_cfg_port = 0;
+static volatile bool mcast_cfg_pending = false;
+static TaskHandle_t mcast_task = nullptr;
+
+// Receiver task only.
+static int mcast_sock = -1;
+static ip_mreq mcast_mreq = {};
+static uint8_t mcast_datagram[1536];
+static ImageMcastStrip mcast_strip = {};   // strip being put together (data == nullptr: none)
+static PendingStripOp mcast_ready = {};    // completed strip waiting for a queue slot
+static int32_t mcast_frame = -1;           // frame being received
+static uint8_t mcast_next_strip = 0;       // next strip of that frame to hand over
+static int16_t mcast_lost_at = -1;         // strip already counted as lost on this pass
+static bool mcast_frame_failed = false;    // preflight failed: ignore the rest of the frame
+
+static volatile bool mcast_joined = false;
+static uint32_t mcast_datagrams = 0;
+static uint32_t mcast_frames = 0;
+static uint32_t mcast_rebuilt = 0;
+static uint32_t mcast_strips_lost = 0;
+static uint32_t mcast_rejected = 0;
+
+static void mcast_drop_strip() {
+    image_api_free(mcast_strip.data);
+    image_api_free(mcast_strip.parity);
+    mcast_strip = {};
+}
 
-// POST /api/display/image/strips?strip_index=N&strip_count=T&width=W&height=H[&timeout=seconds]
-// Upload a single JPEG strip; decode is deferred to the main loop.
-static void handleStripUpload(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-    if (g_auth_gate && !g_auth_gate(request)) return;
-    // Validate required params
-    if (index == 0) {
-        const bool has_required =
-            request->hasParam("strip_index", false) &&
-            request->hasParam("strip_count", false) &&
-            request->hasParam("width", false) &&
-            request->hasParam("height", false);
+static void mcast_drop_ready() {
+    image_api_free(mcast_ready.buffer);
+    mcast_ready = {};
+}
 
-        if (!has_required) {
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing required parameters: strip_index, strip_count, width, height\"}");
-            return;
+static void mcast_close() {
+    if (mcast_sock >= 0) {
+        setsockopt(mcast_sock, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mcast_mreq, sizeof(mcast_mreq));
+        close(mcast_sock);
+        mcast_sock = -1;
+        Logger.logMessage("Mcast", "Left group");
+    }
+    mcast_joined = false;
+    mcast_drop_strip();
+    mcast_drop_ready();
+    mcast_frame = -1;
+}
+
+static bool mcast_open(const char* group, uint16_t port) {
+    in_addr addr = {};
+    if (!inet_aton(group, &addr) || !IN_MULTICAST(ntohl(addr.s_addr))) {
+        Logger.logMessagef("Mcast", "ERROR: %s is not a multicast address", group);
+        return false;
+    }
+
+    mcast_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (mcast_sock < 0) return false;
+
+    const int one = 1;
+    setsockopt(mcast_sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    timeval tv = {0, MCAST_RECV_TIMEOUT_MS * 1000};
+    setsockopt(mcast_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    mcast_mreq.imr_multiaddr = addr;
+    mcast_mreq.imr_interface.s_addr = (uint32_t)WiFi.localIP();
+    if (bind(mcast_sock, (const sockaddr*)&local, sizeof(local)) != 0 ||
+        setsockopt(mcast_sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mcast_mreq, sizeof(mcast_mreq)) != 0) {
+        Logger.logMessagef("Mcast", "ERROR: Join %s:%u failed (errno %d)", group, (unsigned)port, errno);
+        close(mcast_sock);
+        mcast_sock = -1;
+        return false;
+    }
+
+    mcast_joined = true;
+    Logger.logMessagef("Mcast", "Joined %s:%u", group, (unsigned)port);
+    return true;
+}
+
+// Push the completed strip, retrying for up to wait_ms while the queue is full.
+static bool mcast_flush_ready(uint32_t wait_ms) {
+    if (!mcast_ready.buffer) return true;
+    const uint32_t t0 = millis();
+    for (;;) {
+        if (strip_queue_push(mcast_ready)) {
+            mcast_ready = {};
+            image_api_notify_job(IMAGE_JOB_STRIP);
+            return true;
         }
+        if (millis() - t0 >= wait_ms) return false;
+        vTaskDelay(pdMS_TO_TICKS(5));
     }
+}
 
-    if (!request->hasParam("strip_index", false) || !request->hasParam("strip_count", false) ||
-        !request->hasParam("width", false) || !request->hasParam("height", false)) {
-        request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing required parameters: strip_index, strip_count, width, height\"}");
+static void mcast_on_datagram(size_t len) {
+    ImageMcastHeader h;
+    if (!image_mcast_parse_header(mcast_datagram, len, &h) ||
+        h.width > g_cfg.lcd_width || h.height > g_cfg.lcd_height || h.strip_bytes > g_cfg.max_image_size_bytes) {
+        mcast_rejected++;
         return;
     }
+    mcast_datagrams++;
+
+    if (mcast_frame < 0 || h.frame != (uint16_t)mcast_frame) {
+        // Late datagram of an older image.
+        if (mcast_frame >= 0 && (int16_t)(h.frame - (uint16_t)mcast_frame) < 0) return;
+        // New image: whatever was pending belongs to the old one.
+        mcast_drop_strip();
+        mcast_drop_ready();
+        mcast_frame = h.frame;
+        mcast_next_strip = 0;
+        mcast_lost_at = -1;
+        mcast_frame_failed = false;
+    }
 
-    const int stripIndex = request->getParam("strip_index", false)->value().toInt();
-    const int totalStrips = request->getParam("strip_count", false)->value().toInt();
-    const int imageWidth = request->getParam("width", false)->value().toInt();
-    const int imageHeight = request->getParam("height", false)->value().toInt();
-    const unsigned long timeoutMs = request->hasParam("timeout", false)
-        ? (unsigned long)request->getParam("timeout", false)->value().toInt() * 1000UL
-        : g_cfg.default_timeout_ms;
+    // Whole frame drawn, or this strip was handed over on an earlier pass.
+    if (mcast_frame_failed || h.strip_index < mcast_next_strip) return;
 
-    if (index == 0) {
-        // Reject if we're busy. AsyncWebServer runs on AsyncTCP task; do not block.
-        if (upload_state == UPLOAD_IN_PROGRESS || upload_state == UPLOAD_READY_TO_DISPLAY || pending_strip_op.buffer) {
-            request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}");
+    if (h.strip_index > mcast_next_strip) {
+        // The sender moved on before the strip was complete. The strips after
+        // it cannot be drawn before it, so wait for the sender's next pass.
+        mcast_drop_strip();
+        if (mcast_lost_at != mcast_next_strip) {
+            mcast_lost_at = mcast_next_strip;
+            mcast_strips_lost++;
+        }
+        return;
+    }
+
+    if (!mcast_strip.data || !image_mcast_strip_matches(&mcast_strip, h)) {
+        mcast_drop_strip();
+        uint8_t* data = (uint8_t*)image_api_lease(h.strip_bytes, nullptr);
+        if (!data) {
+            mcast_rejected++;
             return;
         }
+        // Without room for the parity the strip can still arrive whole.
+        const uint16_t groups = image_mcast_parity_groups(h);
+        uint8_t* parity = groups ? (uint8_t*)image_api_alloc((size_t)groups * h.frag_bytes) : nullptr;
+        image_mcast_strip_begin(&mcast_strip, h, data, parity);
+    }
 
-        // Only log first strip to reduce verbosity
-        if (stripIndex == 0) {
-            Logger.logMessagef("Strip Mode", "Uploading %dx%d image (%d strips)", imageWidth, imageHeight, totalStrips);
-            device_telemetry_log_memory_snapshot("strip pre-alloc");
+    mcast_rebuilt += image_mcast_strip_add(&mcast_strip, h, mcast_datagram + IMAGE_MCAST_HEADER_BYTES, len - IMAGE_MCAST_HEADER_BYTES);
+    if (!image_mcast_strip_complete(&mcast_strip)) return;
+
+    // The decoder is still behind on the previous strip: this one is lost on this pass.
+    if (!mcast_flush_ready(IMAGE_API_MULTICAST_QUEUE_WAIT_MS)) {
+        mcast_drop_strip();
+        if (mcast_lost_at != mcast_next_strip) {
+            mcast_lost_at = mcast_next_strip;
+            mcast_strips_lost++;
         }
+        return;
+    }
 
-        if (stripIndex < 0 || stripIndex >= totalStrips) {
-            Logger.logEnd("ERROR: Invalid strip index");
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid strip index\"}");
-            return;
+    char preflight_err[160];
+    if (!is_jpeg_magic(mcast_strip.data, mcast_strip.strip_bytes) ||
+        !jpeg_preflight_tjpgd_fragment_supported(
+            mcast_strip.data, mcast_strip.strip_bytes, h.width, h.height, g_cfg.lcd_height, preflight_err, sizeof(preflight_err))) {
+        Logger.logMessagef("Mcast", "ERROR: Frame %u strip %u rejected", (unsigned)h.frame, (unsigned)h.strip_index);
+        mcast_drop_strip();
+        mcast_frame_failed = true;
+        mcast_rejected++;
+        return;
+    }
+
+    const bool has_timeout = h.timeout_s != 0;
+    mcast_ready.buffer = mcast_strip.data;
+    mcast_ready.size = mcast_strip.strip_bytes;
+    mcast_ready.strip_index = h.strip_index;
+    mcast_ready.image_width = h.width;
+    mcast_ready.image_height = h.height;
+    mcast_ready.total_strips = h.strip_count;
+    mcast_ready.timeout_ms = has_timeout ? (unsigned long)h.timeout_s * 1000UL : g_cfg.default_timeout_ms;
+    mcast_ready.start_time = millis();
+    mcast_ready.kind = STRIP_OP_JPEG;
+    mcast_ready.has_timeout = has_timeout;
+    mcast_strip.data = nullptr;
+    mcast_drop_strip();
+
+    mcast_next_strip++;
+    mcast_lost_at = -1;
+    if (mcast_next_strip == h.strip_count) mcast_frames++;
+    (void)mcast_flush_ready(0);
+}
+
+static void mcast_task_fn(void*) {
+    char group[sizeof(mcast_cfg_group)] = {};
+    uint16_t port = 0;
+
+    for (;;) {
+        if (mcast_cfg_pending) {
+            portENTER_CRITICAL(&mcast_cfg_mux);
+            memcpy(group, mcast_cfg_group, sizeof(group));
+            port = mcast_cfg_port;
+            mcast_cfg_pending = false;
+            portEXIT_CRITICAL(&mcast_cfg_mux);
+            mcast_close();
         }
 
-        if (imageWidth <= 0 || imageHeight <= 0 || imageWidth > g_cfg.lcd_width || imageHeight > g_cfg.lcd_height) {
-            Logger.logLinef("ERROR: Invalid dimensions %dx%d", imageWidth, imageHeight);
-            Logger.logEnd();
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid image dimensions\"}");
-            return;
+        if (!group[0]) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        if (!WiFi.isConnected()) {
+            if (mcast_sock >= 0) mcast_close();
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+            continue;
+        }
+        if (mcast_sock < 0 && !mcast_open(group, port)) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5000));
+            continue;
         }
 
-        if (current_strip_buffer) {
-            image_api_free((void*)current_strip_buffer);
-            current_strip_buffer = nullptr;
+        const int n = recv(mcast_sock, mcast_datagram, sizeof(mcast_datagram), 0);
+        if (n > 0) {
+            mcast_on_datagram((size_t)n);
+        } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            mcast_close();
         }
+        (void)mcast_flush_ready(0);
+    }
+}
 
-        current_strip_buffer = (uint8_t*)image_api_alloc(total);
-        if (!current_strip_buffer) {
-            Logger.logLinef("ERROR: Out of memory (requested %u bytes, free heap: %u)", (unsigned)total, ESP.getFreeHeap());
-            device_telemetry_log_memory_snapshot("strip alloc-fail");
-            Logger.logEnd();
-            request->send(507, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
+void image_api_multicast_configure(const char* group, uint16_t port) {
+    portENTER_CRITICAL(&mcast_cfg_mux);
+    strlcpy(mcast_cfg_group, group ? group : "", sizeof(mcast_cfg_group));
+    mcast_cfg_port = port ? port : IMAGE_API_MULTICAST_DEFAULT_PORT;
+    mcast_cfg_pending = true;
+    portEXIT_CRITICAL(&mcast_cfg_mux);
+
+    if (!mcast_task && group && group[0]) {
+        xTaskCreate(mcast_task_fn, "ImageMcast", MCAST_TASK_STACK_BYTES, nullptr, IMAGE_API_WORKER_PRIORITY, &mcast_task);
+        if (!mcast_task) {
+            Logger.logMessage("Mcast", "ERROR: Receiver task creation failed");
             return;
         }
-
-        current_strip_size = 0;
-        strip_upload_last_activity_ms = millis();
     }
+    if (mcast_task) xTaskNotifyGive(mcast_task);
+}
+#endif // IMAGE_API_MULTICAST
 
-    if (current_strip_buffer && current_strip_size + len <= total) {
-        memcpy((uint8_t*)current_strip_buffer + current_strip_size, data, len);
-        current_strip_size += len;
-        strip_upload_last_activity_ms = millis();
+#if IMAGE_API_MJPEG_STREAM && IMAGE_API_STREAM_URL
+static void send_mjpeg_status(AsyncWebServerRequest *request) {
+    bool active = false;
+    uint16_t max_fps = 0;
+    MjpegStreamStats stats;
+    char url[IMAGE_API_URL_MAX_LEN];
+    portENTER_CRITICAL(&mjpeg_mux);
+    active = mjpeg_request.active;
+    max_fps = mjpeg_request.max_fps;
+    memcpy(url, mjpeg_request.url, sizeof(url));
+    stats = mjpeg_stats;
+    portEXIT_CRITICAL(&mjpeg_mux);
+
+    StaticJsonDocument<512> doc;
+    doc["success"] = true;
+    doc["active"] = active;
+    doc["url"] = url;
+    doc["max_fps"] = max_fps;
+    doc["connected"] = stats.connected;
+    doc["frames"] = stats.frames;
+    doc["dropped"] = stats.dropped;
+    doc["fps"] = (float)stats.fps_x10 / 10.0f;
+    doc["last_decode_ms"] = stats.last_decode_ms;
+    doc["reconnects"] = stats.reconnects;
+    doc["last_error"] = stats.last_error;
+
+    String out;
+    serializeJson(doc, out);
+    request->send(200, "application/json", out);
+}
+
+// GET /api/display/stream - MJPEG stream status
+static void handleMjpegStatus(AsyncWebServerRequest *request) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+    send_mjpeg_status(request);
+}
+
+// DELETE /api/display/stream - Stop the MJPEG stream (and take its frame down)
+static void handleMjpegStop(AsyncWebServerRequest *request) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+    image_mjpeg_request_stop();
+    request->send(200, "application/json", "{\"success\":true,\"message\":\"Stream stop queued\"}");
+}
+
+// POST /api/display/stream - Pull an MJPEG (multipart/x-mixed-replace) URL
+// Body: {"url":"http://camera.local/mjpeg","max_fps":10}
+static void handleMjpegStart(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+    if (index == 0 && (!g_backend.decode_frame || !g_backend.start_strip_session)) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Streaming not supported on this display\"}");
+        return;
     }
 
-    // Final chunk: decode synchronously before returning
-    if (index + len >= total) {
-        if (current_strip_size != total) {
-            image_api_free((void*)current_strip_buffer);
-            current_strip_buffer = nullptr;
-            Logger.logEnd();
-            request->send(500, "application/json", "{\"success\":false,\"message\":\"Incomplete upload\"}");
-            return;
-        }
+    const uint8_t* body = image_url_body_collect(request, data, len, index, total);
+    if (!body) return;
 
-        if (!is_jpeg_magic(current_strip_buffer, current_strip_size)) {
-            image_api_free((void*)current_strip_buffer);
-            current_strip_buffer = nullptr;
-            Logger.logEnd();
-            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JPEG data\"}");
-            return;
-        }
+    StaticJsonDocument<512> doc;
+    const DeserializationError jerr = deserializeJson(doc, body, total);
+    portal_body_release(request);
+    if (jerr) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+        return;
+    }
 
-        // Best-effort header preflight
-        char preflight_err[160];
-        const int remaining_height = imageHeight;
-        if (!jpeg_preflight_tjpgd_fragment_supported(
-                current_strip_buffer,
-                current_strip_size,
-                imageWidth,
-                remaining_height,
-                g_cfg.lcd_height,
-                preflight_err,
-                sizeof(preflight_err))) {
-            Logger.logLinef("ERROR: JPEG fragment preflight failed: %s", preflight_err);
-            image_api_free((void*)current_strip_buffer);
-            current_strip_buffer = nullptr;
-            Logger.logEnd();
+    const char* url = doc["url"] | "";
+    if (!url || strlen(url) == 0) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing url\"}");
+        return;
+    }
+    if (strlen(url) >= IMAGE_API_URL_MAX_LEN) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"URL too long\"}");
+        return;
+    }
 
-            char resp[256];
-            snprintf(resp, sizeof(resp), "{\"success\":false,\"message\":\"%s\"}", preflight_err);
-            request->send(400, "application/json", resp);
-            return;
-        }
+    int max_fps = doc["max_fps"] | (int)IMAGE_API_MJPEG_DEFAULT_MAX_FPS;
+    if (max_fps < 0) max_fps = 0;
+    if (max_fps > 60) max_fps = 60;
 
-        // Queue strip for async decode (don't decode in HTTP handler)
-        // If we're busy, reject and let client retry.
-        if (upload_state == UPLOAD_IN_PROGRESS || upload_state == UPLOAD_READY_TO_DISPLAY || pending_strip_op.buffer) {
-            image_api_free((void*)current_strip_buffer);
-            current_strip_buffer = nullptr;
-            Logger.logEnd();
-            request->send(409, "application/json", "{\"success\":false,\"message\":\"Busy\"}" );
-            return;
-        }
+    // A new URL replaces a running stream.
+    portENTER_CRITICAL(&mjpeg_mux);
+    strlcpy(mjpeg_request.url, url, sizeof(mjpeg_request.url));
+    mjpeg_request.max_fps = (uint16_t)max_fps;
+    mjpeg_request.active = true;
+    mjpeg_request.generation++;
+    portEXIT_CRITICAL(&mjpeg_mux);
 
-        // Transfer strip buffer to pending operation
-        upload_state = UPLOAD_IN_PROGRESS;
-        pending_strip_op.buffer = current_strip_buffer;
-        pending_strip_op.size = current_strip_size;
-        pending_strip_op.strip_index = (uint8_t)stripIndex;
-        pending_strip_op.image_width = imageWidth;
-        pending_strip_op.image_height = imageHeight;
-        pending_strip_op.total_strips = totalStrips;
-        pending_strip_op.timeout_ms = timeoutMs;
-        pending_strip_op.start_time = millis();
-        
-        current_strip_buffer = nullptr;
-        current_strip_size = 0;
-        
-        upload_state = UPLOAD_READY_TO_DISPLAY;
-        pending_op_id++;
-        
-        Logger.logMessagef("Strip", "Strip %d/%d queued for decode", stripIndex, totalStrips - 1);
-        Logger.logEnd();
+    image_api_notify_job(IMAGE_JOB_MJPEG);
+    request->send(200, "application/json", "{\"success\":true,\"message\":\"Stream started\"}");
+}
+#endif // IMAGE_API_MJPEG_STREAM && IMAGE_API_STREAM_URL
 
-        char response[160];
-        snprintf(response, sizeof(response),
-                 "{\"success\":true,\"strip_index\":%d,\"strip_count\":%d,\"complete\":%s}",
-                 stripIndex, totalStrips, (stripIndex == totalStrips - 1) ? "true" : "false");
-        request->send(200, "application/json", response);
+#if IMAGE_API_PROFILE
+// GET /api/display/image/stats - Per-stage timings of recent image operations (newest first)
+static void handleImageStats(AsyncWebServerRequest *request) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+
+    // AsyncTCP runs one handler at a time; keep the copy off its stack.
+    static ImageProfileRecord records[IMAGE_API_PROFILE_HISTORY];
+    const size_t n = image_profile_snapshot(records, IMAGE_API_PROFILE_HISTORY);
+    const unsigned long now = millis();
+
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->printf(
+        "{\"success\":true,\"history\":%u,\"decoder\":\"%s\",\"pack_kernel\":\"%s\",\"operations\":[",
+        (unsigned)IMAGE_API_PROFILE_HISTORY,
+        jpeg_engine_name(JPEG_DECODER),
+        rgb888_pack_kernel_name()
+    );
+    for (size_t i = 0; i < n; i++) {
+        const ImageProfileRecord& r = records[i];
+        response->printf(
+            "%s{\"seq\":%lu,\"kind\":\"%s\",\"ok\":%s,\"age_ms\":%lu,\"worker_us\":%lu,\"stages\":{",
+            i ? "," : "",
+            (unsigned long)r.seq,
+            r.kind,
+            r.ok ? "true" : "false",
+            (unsigned long)(now - r.completed_ms),
+            (unsigned long)r.worker_us
+        );
+        for (int st = 0; st < IMAGE_STAGE_COUNT; st++) {
+            response->printf(
+                "%s\"%s\":{\"us\":%lu,\"bytes\":%lu}",
+                st ? "," : "",
+                image_profile_stage_name((ImageProfileStage)st),
+                (unsigned long)r.stages.us[st],
+                (unsigned long)r.stages.bytes[st]
+            );
+        }
+        response->print("}}");
     }
+    response->print("]}");
+    request->send(response);
 }
+#endif // IMAGE_API_PROFILE
 
 // ===== Public API =====
 
@@ -1062,10 +3425,27 @@ void image_api_init(const ImageApiConfig& cfg, const ImageApiBackend& backend) {
 
     image_upload_timeout_ms = g_cfg.default_timeout_ms;
 
+#if IMAGE_API_POOL_ENABLED
+    // Reserve body buffers while the heap is still unfragmented.
+    image_pool_init(
+        g_cfg.max_image_size_bytes,
+        IMAGE_API_POOL_LARGE_SLOTS,
+        IMAGE_API_POOL_SMALL_BYTES,
+        IMAGE_API_POOL_SMALL_SLOTS
+    );
+#endif
+
+#if IMAGE_API_PARALLEL_DECODE && STATIC_ALLOC_MODE
+    // The parallel decoder's frame, while the heap is whole.
+    if (jpeg_parallel_available()) {
+        (void)parallel_fb_alloc((size_t)g_cfg.lcd_width * (size_t)g_cfg.lcd_height * sizeof(uint16_t));
+    }
+#endif
+
     // Best-effort: reset state
     upload_state = UPLOAD_IDLE;
     pending_op_id = 0;
-    pending_image_op = {nullptr, 0, false, g_cfg.default_timeout_ms, 0};
+    pending_image_op = {nullptr, 0, false, g_cfg.default_timeout_ms, 0, true, true};
 
     if (current_strip_buffer) {
         image_api_free((void*)current_strip_buffer);
@@ -1073,31 +3453,66 @@ void image_api_init(const ImageApiConfig& cfg, const ImageApiBackend& backend) {
     }
     current_strip_size = 0;
 
-    if (pending_strip_op.buffer) {
-        image_api_free((void*)pending_strip_op.buffer);
-        pending_strip_op.buffer = nullptr;
+    for (size_t i = 0; i < IMAGE_STRIP_PIPELINE_DEPTH; i++) {
+        if (strip_queue[i].buffer) {
+            image_api_free((void*)strip_queue[i].buffer);
+        }
+        strip_queue[i] = {nullptr, 0, 0, 0, 0, 0, g_cfg.default_timeout_ms, 0, STRIP_OP_JPEG, 0, false, 0, 0, false};
     }
-    pending_strip_op = {nullptr, 0, 0, 0, 0, 0, g_cfg.default_timeout_ms, 0};
+    strip_queue_head = 0;
+    strip_queue_tail = 0;
 
     if (image_upload_buffer) {
         image_api_free((void*)image_upload_buffer);
         image_upload_buffer = nullptr;
     }
     image_upload_size = 0;
+
+#if IMAGE_API_WORKER_ENABLED
+    // Downloads and decodes run here instead of stalling loop() (MQTT, WiFi watchdog, touch).
+    image_api_start_worker();
+#endif
 }
 
 void image_api_register_routes(AsyncWebServer* server, bool (*auth_gate)(AsyncWebServerRequest* request)) {
     g_auth_gate = auth_gate;
     // Register the more specific /strips endpoint before /image.
+#if IMAGE_API_PROFILE
+    server->on("/api/display/image/stats", HTTP_GET, handleImageStats);
+#endif
+    server->on(
+        "/api/display/image/strips",
+        HTTP_POST,
+        [](AsyncWebServerRequest *request) {
+            if (g_auth_gate && !g_auth_gate(request)) return;
+        },
+        NULL,
+        handleStripUpload
+    );
+
+#if IMAGE_API_TILE_UPLOAD
+    server->on(
+        "/api/display/image/tiles",
+        HTTP_POST,
+        [](AsyncWebServerRequest *request) {
+            if (g_auth_gate && !g_auth_gate(request)) return;
+        },
+        NULL,
+        handleTileUpload
+    );
+#endif
+
+#if IMAGE_API_RAW_UPLOAD
     server->on(
-        "/api/display/image/strips",
+        "/api/display/image/raw",
         HTTP_POST,
         [](AsyncWebServerRequest *request) {
             if (g_auth_gate && !g_auth_gate(request)) return;
         },
         NULL,
-        handleStripUpload
+        handleRawUpload
     );
+#endif
 
     server->on(
         "/api/display/image",
@@ -1119,11 +3534,327 @@ void image_api_register_routes(AsyncWebServer* server, bool (*auth_gate)(AsyncWe
     );
 
     server->on("/api/display/image", HTTP_DELETE, handleImageDelete);
+
+#if IMAGE_API_MJPEG_STREAM && IMAGE_API_STREAM_URL
+    server->on(
+        "/api/display/stream",
+        HTTP_POST,
+        [](AsyncWebServerRequest *request) {
+            if (g_auth_gate && !g_auth_gate(request)) return;
+        },
+        NULL,
+        handleMjpegStart
+    );
+    server->on("/api/display/stream", HTTP_GET, handleMjpegStatus);
+    server->on("/api/display/stream", HTTP_DELETE, handleMjpegStop);
+#endif
+
+#if IMAGE_API_WEBSOCKET
+    image_ws.onEvent(image_ws_event);
+    // The gate may already have queued a 401 challenge; the library answers 401 either way.
+    image_ws.handleHandshake([](AsyncWebServerRequest* request) { return !g_auth_gate || g_auth_gate(request); });
+    server->addHandler(&image_ws);
+#endif
+
+    image_playlist_register_routes(server, auth_gate);
 }
 
-void image_api_process_pending(bool ota_in_progress) {
+// Release the head strip slot back to the producer.
+static void strip_queue_pop() {
+    const uint32_t head = __atomic_load_n(&strip_queue_head, __ATOMIC_RELAXED);
+    PendingStripOp& op = strip_queue[head % IMAGE_STRIP_PIPELINE_DEPTH];
+    image_api_free((void*)op.buffer);
+    op.buffer = nullptr;
+    op.size = 0;
+    __atomic_store_n(&strip_queue_head, head + 1, __ATOMIC_RELEASE);
+}
+
+// After a failed strip the rest of the queued strips belong to a broken image.
+// Stop at the next strip 0: that is already a new image.
+static void strip_queue_drop_broken() {
+    unsigned dropped = 0;
+    while (strip_queue_count() > 0) {
+        const uint32_t next = __atomic_load_n(&strip_queue_head, __ATOMIC_RELAXED);
+        if (strip_queue[next % IMAGE_STRIP_PIPELINE_DEPTH].strip_index == 0) break;
+        strip_queue_pop();
+        dropped++;
+    }
+    if (dropped) {
+        Logger.logMessagef("Portal", "Dropped %u queued strips", dropped);
+    }
+
+    if (g_backend.hide_current_image) {
+        g_backend.hide_current_image();
+    }
+}
+
+#if IMAGE_API_RAW_UPLOAD || IMAGE_API_TILE_UPLOAD
+// Decompress (if needed) and draw one RGB565 rectangle into the current session.
+static bool image_api_push_rgb565(
+    int x,
+    int y,
+    int w,
+    int h,
+    Rgb565Encoding encoding,
+    bool big_endian,
+    const uint8_t* data,
+    size_t size
+) {
+    if (!g_backend.push_rect) return false;
+
+    const size_t pixels = (size_t)w * (size_t)h;
+    uint16_t* px = (uint16_t*)data;
+    uint16_t* decoded = nullptr;
+
+    // Raw pixels are pushed in place unless they sit at an odd address (tile payloads).
+    if (encoding != RGB565_ENCODING_RAW || ((uintptr_t)data & 1) != 0) {
+        decoded = (uint16_t*)image_api_alloc(pixels * sizeof(uint16_t));
+        if (!decoded) {
+            Logger.logMessagef("Portal", "ERROR: Out of memory for %u pixels", (unsigned)pixels);
+            return false;
+        }
+
+        char err[96];
+        const unsigned long t0 = millis();
+        if (!rgb565_decode(encoding, data, size, decoded, pixels, err, sizeof(err))) {
+            Logger.logMessagef("Portal", "ERROR: %s", err);
+            image_api_free(decoded);
+            return false;
+        }
+        if (encoding != RGB565_ENCODING_RAW) {
+            Logger.logMessagef("Portal", "Decompressed %u -> %u bytes in %lu ms",
+                               (unsigned)size, (unsigned)(pixels * 2), (unsigned long)(millis() - t0));
+        }
+        px = decoded;
+    }
+
+    #if HAS_DISPLAY
+    display_manager_lock();
+    #endif
+    const bool ok = g_backend.push_rect(x, y, w, h, px, big_endian);
+    #if HAS_DISPLAY
+    display_manager_unlock();
+    #endif
+
+    image_api_free(decoded);
+    return ok;
+}
+#endif
+
+#if IMAGE_API_RAW_UPLOAD
+// image_session_seq of the session the last first=1 rectangle started.
+static uint32_t raw_session_seq = 0;
+
+// Draw a queued raw rectangle (decompress if needed, no JPEG decode).
+static bool image_api_draw_queued_rect(const PendingStripOp& op) {
+    const Rgb565Encoding encoding = (Rgb565Encoding)op.encoding;
+
+    Logger.logMessagef(
+        "Portal",
+        "Processing %s rect %dx%d at (%d,%d) (%u bytes)",
+        rgb565_encoding_name(encoding),
+        op.image_width,
+        op.image_height,
+        op.x,
+        op.y,
+        (unsigned)op.size
+    );
+
+    if (op.strip_index == 0) {
+        if (!g_backend.start_strip_session ||
+            !image_api_begin_session(g_cfg.lcd_width, g_cfg.lcd_height, op.timeout_ms, op.start_time)) {
+            Logger.logMessage("Portal", "ERROR: Failed to init image display");
+            return false;
+        }
+        raw_session_seq = image_session_seq;
+    } else {
+        // Partial update: only onto the image the previous first=1 rectangle started.
+        if (raw_session_seq != image_session_seq) {
+            Logger.logMessage("Portal", "ERROR: No raw image session (send a rectangle with first=1)");
+            return false;
+        }
+        if (op.has_timeout && g_backend.refresh_current_image) {
+            (void)g_backend.refresh_current_image(op.timeout_ms, millis());
+        }
+    }
+
+    return image_api_push_rgb565(
+        op.x, op.y, op.image_width, op.image_height,
+        encoding, op.big_endian, op.buffer, op.size
+    );
+}
+#endif // IMAGE_API_RAW_UPLOAD
+
+#if IMAGE_API_TILE_UPLOAD
+// Draw a queued tile batch over the current image. Tiles that fail are skipped.
+static void image_api_draw_queued_tiles(const PendingStripOp& op) {
+    if (op.has_timeout && g_backend.refresh_current_image) {
+        (void)g_backend.refresh_current_image(op.timeout_ms, millis());
+    }
+
+    const unsigned long t0 = millis();
+    size_t pos = 0;
+    ImageTile tile;
+    char err[96];
+    unsigned drawn = 0;
+    unsigned failed = 0;
+
+    while (image_tiles_next(op.buffer, op.size, &pos, &tile, err, sizeof(err))) {
+        bool ok = false;
+        if (tile.encoding == IMAGE_TILE_ENCODING_JPEG) {
+            if (g_backend.decode_tile) {
+                #if HAS_DISPLAY
+                display_manager_lock();
+                #endif
+                ok = g_backend.decode_tile(tile.data, tile.size, tile.x, tile.y, false);
+                #if HAS_DISPLAY
+                display_manager_unlock();
+                #endif
+            }
+        } else {
+            ok = image_api_push_rgb565(
+                tile.x, tile.y, tile.w, tile.h,
+                (Rgb565Encoding)tile.encoding, tile.big_endian, tile.data, tile.size
+            );
+        }
+
+        if (ok) {
+            drawn++;
+        } else {
+            failed++;
+        }
+    }
+
+    Logger.logMessagef(
+        "Portal",
+        "Tiles: %u drawn, %u failed (%u bytes) in %lu ms",
+        drawn,
+        failed,
+        (unsigned)op.size,
+        (unsigned long)(millis() - t0)
+    );
+}
+#endif // IMAGE_API_TILE_UPLOAD
+
+// Decode the strip at the head of the queue. On failure the rest of the queued
+// strips belong to a broken image and are dropped. Returns false on failure.
+static bool image_api_decode_queued_strip() {
+    const uint32_t head = __atomic_load_n(&strip_queue_head, __ATOMIC_RELAXED);
+    const PendingStripOp& op = strip_queue[head % IMAGE_STRIP_PIPELINE_DEPTH];
+
+#if IMAGE_API_RAW_UPLOAD
+    if (op.kind == STRIP_OP_RECT) {
+        const bool ok = image_api_draw_queued_rect(op);
+        strip_queue_pop();
+        if (!ok) strip_queue_drop_broken();
+        return ok;
+    }
+#endif
+#if IMAGE_API_TILE_UPLOAD
+    if (op.kind == STRIP_OP_TILES) {
+        // A bad tile batch leaves the base image up; later batches may still apply.
+        image_api_draw_queued_tiles(op);
+        strip_queue_pop();
+        return true;
+    }
+#endif
+
+    const uint8_t* buf = op.buffer;
+    const size_t sz = op.size;
+    const uint8_t strip_index = op.strip_index;
+    const int total_strips = op.total_strips;
+
+    LOGD("Portal", "Processing strip %d/%d (%u bytes)", strip_index, total_strips - 1, (unsigned)sz);
+
+    bool success = false;
+    const char* failure = nullptr;
+
+    // Initialize strip session on first strip
+    if (strip_index == 0) {
+        device_telemetry_log_memory_snapshot("strip pre-decode");
+
+        if (!g_backend.start_strip_session) {
+            failure = "No strip session handler";
+        } else if (!image_api_begin_session(op.image_width, op.image_height, op.timeout_ms, op.start_time)) {
+            failure = "Failed to init strip session";
+        }
+    }
+
+    // Decode strip
+    if (!failure && g_backend.decode_strip) {
+        #if HAS_DISPLAY
+        // Serialize with LVGL task to protect buffered backends (Arduino_GFX canvas)
+        // and prevent overlapping present()/SPI polling transactions.
+        display_manager_lock();
+        #endif
+        image_profile_begin("strip");
+        TRACE_BEGIN("image.decode_strip");
+        success = g_backend.decode_strip(buf, sz, strip_index, false);
+        TRACE_END("image.decode_strip");
+        image_profile_end(success);
+        #if HAS_DISPLAY
+        display_manager_unlock();
+        #endif
+    }
+
+    if (strip_index == (uint8_t)(total_strips - 1)) {
+        device_telemetry_log_memory_snapshot("strip post-decode");
+    }
+
+    strip_queue_pop();
+
+    if (success) {
+        if (strip_index == total_strips - 1) {
+            Logger.logMessagef("Portal", "\u2713 All %d strips decoded", total_strips);
+        }
+        return true;
+    }
+
+    if (failure) {
+        Logger.logMessagef("Portal", "ERROR: %s", failure);
+    } else {
+        Logger.logMessagef("Portal", "ERROR: Failed to decode strip %d", strip_index);
+        device_telemetry_log_memory_snapshot("strip decode-fail");
+    }
+
+    strip_queue_drop_broken();
+    return false;
+}
+
+#if HAS_DISPLAY && LV_USE_IMG && LVGL_IMAGE_DOUBLE_BUFFER && LVGL_IMAGE_PROGRESSIVE
+// Progressive LVGL decode: flip the (cleared) back buffer in once the size is
+// known, then redraw each finished band while the worker keeps decoding.
+struct LvglProgressCtx {
+    LvglImageScreen* screen;
+    uint32_t claim;
+    bool shown;
+};
+
+static bool lvgl_progress_begin(void* ctx, int w, int h) {
+    LvglProgressCtx* live = (LvglProgressCtx*)ctx;
+    display_manager_lock();
+    live->shown = live->screen->presentBackBuffer(w, h, live->claim);
+    display_manager_unlock();
+    return live->shown;
+}
+
+static void lvgl_progress_rows(void* ctx, int y0, int y1) {
+    LvglProgressCtx* live = (LvglProgressCtx*)ctx;
+    display_manager_lock();
+    live->screen->invalidateRows(y0, y1);
+    display_manager_unlock();
+}
+#endif
+
+// Run whatever deferred work is pending (worker task, or main loop without one).
+static void image_api_run_pending(bool ota_in_progress) {
     static unsigned long last_processed_id = 0;
 
+#if IMAGE_API_URL_KEEPALIVE_CONNS > 0
+    // Idle keep-alive connections time out; an update wants their heap back.
+    url_pool_expire(ota_in_progress);
+#endif
+
     // Reclaim memory from interrupted uploads.
     // AsyncWebServer may stop calling the upload handlers if the client disconnects mid-transfer.
     if (upload_state == UPLOAD_IN_PROGRESS && !ota_in_progress) {
@@ -1153,6 +3884,53 @@ void image_api_process_pending(bool ota_in_progress) {
         }
     }
 
+#if IMAGE_API_STREAM_UPLOAD
+    if (upload_state == UPLOAD_STREAMING && !ota_in_progress) {
+        if (upload_stream_decode_pending) {
+            upload_stream_decode_pending = false;
+            image_api_decode_upload_stream();
+            return;
+        }
+
+        // Decode done but the client never sent the final chunk (disconnect).
+        const unsigned long idle = (unsigned long)(millis() - upload_stream_last_activity_ms);
+        if (idle > (unsigned long)IMAGE_API_STREAM_IDLE_TIMEOUT_MS) {
+            Logger.logMessage("ImageApi", "WARNING: Closing abandoned streaming upload");
+            portENTER_CRITICAL(&upload_stream_mux);
+            upload_stream_producer_done = true;
+            upload_stream_settle_locked();
+            portEXIT_CRITICAL(&upload_stream_mux);
+        }
+        return;
+    }
+#endif
+
+    // Drain the strip pipeline; strips don't go through upload_state.
+    if (!ota_in_progress && strip_queue_count() > 0) {
+        while (strip_queue_count() > 0 && image_api_decode_queued_strip()) {
+        }
+        return;
+    }
+
+    // Playlist prefetch/transition only when nothing else is pending. Mark the
+    // API busy meanwhile so uploads get a 409 instead of stalling behind a download.
+    if (!ota_in_progress && upload_state == UPLOAD_IDLE && image_playlist_needs_work()) {
+        upload_state = UPLOAD_IN_PROGRESS;
+        image_playlist_process();
+        if (upload_state == UPLOAD_IN_PROGRESS) {
+            upload_state = UPLOAD_IDLE;
+        }
+        return;
+    }
+
+#if IMAGE_API_MJPEG_STREAM && IMAGE_API_STREAM_URL
+    // Live stream frames come last; a step returns at once when no part is waiting.
+    if (!ota_in_progress && upload_state == UPLOAD_IDLE && image_mjpeg_needs_work()) {
+        image_api_mjpeg_step();
+        return;
+    }
+#endif
+
     if (upload_state != UPLOAD_READY_TO_DISPLAY || ota_in_progress) {
         return;
     }
@@ -1166,12 +3944,14 @@ void image_api_process_pending(bool ota_in_progress) {
     // Handle queued HTTP(S) download
     char url_to_download[IMAGE_API_URL_MAX_LEN];
     unsigned long url_timeout_ms = 0;
+    bool url_center = true;
     bool has_url_op = false;
     portENTER_CRITICAL(&pending_url_op_mux);
     if (pending_url_op.active) {
         strncpy(url_to_download, pending_url_op.url, sizeof(url_to_download));
         url_to_download[sizeof(url_to_download) - 1] = '\0';
         url_timeout_ms = pending_url_op.timeout_ms;
+        url_center = pending_url_op.center;
         pending_url_op.active = false;
         pending_url_op.url[0] = '\0';
         has_url_op = true;
@@ -1184,121 +3964,93 @@ void image_api_process_pending(bool ota_in_progress) {
 
         upload_state = UPLOAD_IN_PROGRESS;
 
+        const uint32_t url_t0 = image_profile_now_us();
         const unsigned long timeout_ms = url_timeout_ms;
+        int cache_slot = -1;
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+        cache_slot = url_cache_slot_for(url_to_download);
+#endif
 
-        uint8_t* downloaded = nullptr;
-        size_t downloaded_sz = 0;
-        char err[128];
-        const bool ok = download_jpeg_to_buffer(url_to_download, timeout_ms, &downloaded, &downloaded_sz, err, sizeof(err));
-
-        device_telemetry_log_memory_snapshot("urlimg post-download");
+        // Second attempt only when a 304 arrived but there was nothing left to
+        // show for it (image timed out meanwhile); that one is unconditional.
+        for (int attempt = 0; attempt < 2; attempt++) {
+            UrlDownload dl;
+            char err[128];
 
-        if (!ok) {
-            Logger.logMessagef("Portal", "ERROR: URL download failed: %s", err);
-            device_telemetry_log_memory_snapshot("urlimg download-fail");
-            upload_state = UPLOAD_IDLE;
-            if (g_backend.hide_current_image) {
-                g_backend.hide_current_image();
-            }
-            return;
-        }
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+            if (attempt == 0) url_cache_prepare(cache_slot, &dl);
+#endif
 
-        // Queue the downloaded JPEG for decode on the next main-loop tick.
-        if (pending_image_op.buffer) {
-            image_api_free((void*)pending_image_op.buffer);
-        }
-        pending_image_op.buffer = downloaded;
-        pending_image_op.size = downloaded_sz;
-        pending_image_op.dismiss = false;
-        pending_image_op.timeout_ms = timeout_ms > 0 ? timeout_ms : g_cfg.default_timeout_ms;
-        pending_image_op.start_time = millis();
-        pending_op_id++;
-        upload_state = UPLOAD_READY_TO_DISPLAY;
-        return;
-    }
+            bool ok = url_download_open(url_to_download, timeout_ms, &dl, err, sizeof(err));
 
-    // Handle dismiss operation
-    if (pending_image_op.dismiss) {
-        device_telemetry_log_memory_snapshot("img dismiss");
-        if (g_backend.hide_current_image) {
-            g_backend.hide_current_image();
-        }
-        pending_image_op.dismiss = false;
-        upload_state = UPLOAD_IDLE;
-        return;
-    }
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+            if (ok && dl.not_modified) {
+                dl.release();
+                if (url_cache_serve_not_modified(cache_slot, timeout_ms, url_center)) {
+                    return;
+                }
+                continue;
+            }
+            if (ok) {
+                url_cache_store_validators(cache_slot, dl);
+            }
+#endif
 
-    // Handle strip operation
-    if (pending_strip_op.buffer && pending_strip_op.size > 0) {
-        const uint8_t* buf = pending_strip_op.buffer;
-        const size_t sz = pending_strip_op.size;
-        const uint8_t strip_index = pending_strip_op.strip_index;
-        const int total_strips = pending_strip_op.total_strips;
+#if IMAGE_API_STREAM_URL
+            if (ok && image_stream_decode_available()) {
+                image_api_stream_url(dl, timeout_ms, url_center, cache_slot);
+                return;
+            }
+#endif
 
-        Logger.logMessagef("Portal", "Processing strip %d/%d (%u bytes)", strip_index, total_strips - 1, (unsigned)sz);
+            uint8_t* downloaded = nullptr;
+            size_t downloaded_sz = 0;
+            if (ok) {
+                ok = download_jpeg_body(&dl, &downloaded, &downloaded_sz, err, sizeof(err));
+            }
 
-        if (strip_index == 0) {
-            device_telemetry_log_memory_snapshot("strip pre-decode");
-        }
+            device_telemetry_log_memory_snapshot("urlimg post-download");
 
-        // Initialize strip session on first strip
-        if (strip_index == 0) {
-            if (!g_backend.start_strip_session) {
-                Logger.logMessage("Portal", "ERROR: No strip session handler");
-                if (g_backend.hide_current_image) {
-                    g_backend.hide_current_image();
-                }
-                image_api_free((void*)pending_strip_op.buffer);
-                pending_strip_op.buffer = nullptr;
+            if (!ok) {
+                Logger.logMessagef("Portal", "ERROR: URL download failed: %s", err);
+                device_telemetry_log_memory_snapshot("urlimg download-fail");
                 upload_state = UPLOAD_IDLE;
-                return;
-            }
-
-            if (!g_backend.start_strip_session(pending_strip_op.image_width, pending_strip_op.image_height, 
-                                                pending_strip_op.timeout_ms, pending_strip_op.start_time)) {
-                Logger.logMessage("Portal", "ERROR: Failed to init strip session");
                 if (g_backend.hide_current_image) {
                     g_backend.hide_current_image();
                 }
-                image_api_free((void*)pending_strip_op.buffer);
-                pending_strip_op.buffer = nullptr;
-                upload_state = UPLOAD_IDLE;
                 return;
             }
-        }
 
-        // Decode strip
-        bool success = false;
-        if (g_backend.decode_strip) {
-            #if HAS_DISPLAY
-            // Serialize with LVGL task to protect buffered backends (Arduino_GFX canvas)
-            // and prevent overlapping present()/SPI polling transactions.
-            display_manager_lock();
-            #endif
-            success = g_backend.decode_strip(buf, sz, strip_index, false);
-            #if HAS_DISPLAY
-            display_manager_unlock();
-            #endif
-        }
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+            // Keep a PSRAM copy of the body so a later 304 can be re-decoded.
+            uint8_t* keep = url_cache_alloc_body(dl);
+            if (keep) memcpy(keep, downloaded, downloaded_sz);
+            url_cache_keep_body(cache_slot, keep, downloaded_sz);
+#endif
 
-        if (strip_index == (uint8_t)(total_strips - 1)) {
-            device_telemetry_log_memory_snapshot("strip post-decode");
+            queue_downloaded_image(downloaded, downloaded_sz, timeout_ms, url_center, cache_slot);
+            image_profile_span_add(&pending_image_op.profile, IMAGE_STAGE_RECEIVE, image_profile_now_us() - url_t0, (uint32_t)downloaded_sz);
+            return;
         }
 
-        image_api_free((void*)pending_strip_op.buffer);
-        pending_strip_op.buffer = nullptr;
-        pending_strip_op.size = 0;
         upload_state = UPLOAD_IDLE;
+        return;
+    }
 
-        if (!success) {
-            Logger.logMessagef("Portal", "ERROR: Failed to decode strip %d", strip_index);
-            device_telemetry_log_memory_snapshot("strip decode-fail");
-            if (g_backend.hide_current_image) {
-                g_backend.hide_current_image();
-            }
-        } else if (strip_index == total_strips - 1) {
-            Logger.logMessagef("Portal", "\u2713 All %d strips decoded", total_strips);
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+    // Consume the slot tag together with the op (set by queue_downloaded_image).
+    const int url_slot = url_cache_pending_slot;
+    url_cache_pending_slot = -1;
+#endif
+
+    // Handle dismiss operation
+    if (pending_image_op.dismiss) {
+        device_telemetry_log_memory_snapshot("img dismiss");
+        if (g_backend.hide_current_image) {
+            g_backend.hide_current_image();
         }
+        pending_image_op.dismiss = false;
+        upload_state = UPLOAD_IDLE;
         return;
     }
 
@@ -1308,6 +4060,7 @@ void image_api_process_pending(bool ota_in_progress) {
         const size_t sz = pending_image_op.size;
 
         Logger.logMessagef("Portal", "Processing pending image (%u bytes)", (unsigned)sz);
+        image_profile_begin(pending_image_op.profile_kind ? pending_image_op.profile_kind : "upload", &pending_image_op.profile);
 
         device_telemetry_log_memory_snapshot("img pre-decode");
 
@@ -1317,15 +4070,55 @@ void image_api_process_pending(bool ota_in_progress) {
         const char* current_screen = display_manager_get_current_screen_id();
         Logger.logMessagef("Portal", "Current screen: %s", current_screen ? current_screen : "(none)");
         if (current_screen && strcmp(current_screen, "lvgl_image") == 0) {
+            LvglImageScreen* screen = display_manager_get_lvgl_image_screen();
             uint16_t* pixels = nullptr;
             int w = 0;
             int h = 0;
             int scale_used = -1;
             char derr[96];
-
-            // Decode without holding the LVGL mutex.
-            const bool ok = lvgl_jpeg_decode_to_rgb565(buf, sz, &pixels, &w, &h, &scale_used, derr, sizeof(derr));
+            bool ok = false;
+            bool flipped = false;  // decoded into the screen's back buffer
+            bool shown_live = false;  // ... that was shown while decoding
+
+            // Decode without holding the LVGL mutex. With double buffering the
+            // decode lands in the screen's hidden buffer; the claim tells
+            // presentBackBuffer() whether anyone else flipped it meanwhile.
+            #if LVGL_IMAGE_DOUBLE_BUFFER
+            uint32_t claim = 0;
+            size_t back_cap = 0;
+            uint16_t* back = nullptr;
+            if (screen) {
+                display_manager_lock();
+                back = screen->backBuffer(&back_cap, &claim);
+                display_manager_unlock();
+            }
+            #if LVGL_IMAGE_PROGRESSIVE
+            // Show the buffer as soon as the size is known and paint it top-down.
+            LvglProgressCtx live = {screen, claim, false};
+            const LvglJpegProgress progressive = {lvgl_progress_begin, lvgl_progress_rows, &live};
+            const LvglJpegProgress* progress = &progressive;
+            #else
+            const LvglJpegProgress* progress = nullptr;
+            #endif
+            if (back) {
+                ok = lvgl_jpeg_decode_into_rgb565(buf, sz, back, back_cap, &w, &h, &scale_used, derr, sizeof(derr), progress);
+                flipped = true;
+                #if LVGL_IMAGE_PROGRESSIVE
+                shown_live = live.shown;
+                #endif
+            }
+            #endif
+            if (!flipped) {
+                ok = lvgl_jpeg_decode_to_rgb565(buf, sz, &pixels, &w, &h, &scale_used, derr, sizeof(derr));
+            }
             if (!ok) {
+                if (shown_live) {
+                    // Don't leave a half-painted image up.
+                    display_manager_lock();
+                    screen->clearImage();
+                    display_manager_unlock();
+                }
+                image_profile_end(false);
                 Logger.logMessagef("Portal", "ERROR: LVGL JPEG decode failed: %s", derr);
                 device_telemetry_log_memory_snapshot("img lvgl-decode-fail");
 
@@ -1340,11 +4133,17 @@ void image_api_process_pending(bool ota_in_progress) {
                 return;
             }
 
-            LvglImageScreen* screen = display_manager_get_lvgl_image_screen();
             bool set_ok = false;
+            const uint32_t set_t0 = image_profile_now_us();
             display_manager_lock();
-            if (screen) set_ok = screen->setImageRgb565(pixels, w, h);
+            #if LVGL_IMAGE_DOUBLE_BUFFER
+            // A progressive decode is on screen already (painted as it decoded).
+            if (flipped) set_ok = shown_live || screen->presentBackBuffer(w, h, claim);
+            #endif
+            if (!flipped && screen) set_ok = screen->setImageRgb565(pixels, w, h);
             display_manager_unlock();
+            image_profile_add(IMAGE_STAGE_PUSH, image_profile_now_us() - set_t0, (uint32_t)w * (uint32_t)h * 2);
+            image_profile_end(set_ok);
 
             // Helpful runtime diagnostics: show whether we decoded at reduced resolution.
             // The screen will scale this to a fixed 200x200 box via lv_img zoom.
@@ -1372,7 +4171,8 @@ void image_api_process_pending(bool ota_in_progress) {
             }
 
             if (!set_ok) {
-                heap_caps_free(pixels);
+                // The back buffer belongs to the screen; only a malloc'd decode is ours to free.
+                if (pixels) heap_caps_free(pixels);
                 Logger.logMessage("Portal", "ERROR: Failed to set LVGL image");
 
                 image_api_free((void*)pending_image_op.buffer);
@@ -1397,17 +4197,25 @@ void image_api_process_pending(bool ota_in_progress) {
         #endif
 
         bool success = false;
-        if (g_backend.start_strip_session && g_backend.decode_strip) {
+        bool parallel = false;
+        const unsigned long decode_t0 = millis();
+#if IMAGE_API_PARALLEL_DECODE
+        if (pending_image_op.parallel) {
+            parallel = image_api_decode_parallel(buf, sz, pending_image_op.header, pending_image_op.timeout_ms, pending_image_op.start_time);
+            success = parallel;
+        }
+#endif
+        if (!parallel && g_backend.start_strip_session && g_backend.decode_strip) {
             #if HAS_DISPLAY
             // Serialize with LVGL task for the duration of the full decode.
             display_manager_lock();
             #endif
 
-            if (!g_backend.start_strip_session(g_cfg.lcd_width, g_cfg.lcd_height, pending_image_op.timeout_ms, pending_image_op.start_time)) {
+            if (!image_api_begin_session(g_cfg.lcd_width, g_cfg.lcd_height, pending_image_op.timeout_ms, pending_image_op.start_time)) {
                 Logger.logMessage("Portal", "ERROR: Failed to init image display");
                 success = false;
             } else {
-                success = g_backend.decode_strip(buf, sz, 0, false);
+                success = image_api_decode_whole(buf, sz, nullptr, nullptr, pending_image_op.center);
             }
 
             #if HAS_DISPLAY
@@ -1415,8 +4223,22 @@ void image_api_process_pending(bool ota_in_progress) {
             #endif
         }
 
+        const uint32_t decode_ms = (uint32_t)(millis() - decode_t0);
+        portENTER_CRITICAL(&image_job_stats_mux);
+        image_job_stats.last_decode_ms = decode_ms;
+        image_job_stats.last_decode_parallel = parallel;
+        if (parallel) image_job_stats.parallel_decodes++;
+        portEXIT_CRITICAL(&image_job_stats_mux);
+
+        image_profile_end(success);
         device_telemetry_log_memory_snapshot("img post-decode");
 
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+        if (success && url_slot >= 0) {
+            url_cache_mark_shown(url_slot);
+        }
+#endif
+
         image_api_free((void*)pending_image_op.buffer);
         pending_image_op.buffer = nullptr;
         pending_image_op.size = 0;
@@ -1436,4 +4258,155 @@ void image_api_process_pending(bool ota_in_progress) {
     upload_state = UPLOAD_IDLE;
 }
 
+#if IMAGE_API_WORKER_ENABLED
+static void image_worker_task_fn(void* arg) {
+    (void)arg;
+    for (;;) {
+        // Wake on a job, or periodically so stuck uploads are still reclaimed.
+        // A live MJPEG stream polls its socket every few ms instead.
+        ImageJob job = {IMAGE_JOB_NONE, 0};
+        TickType_t wait = pdMS_TO_TICKS(500);
+#if IMAGE_API_MJPEG_STREAM && IMAGE_API_STREAM_URL
+        if (image_mjpeg_needs_work()) wait = pdMS_TO_TICKS(5) > 0 ? pdMS_TO_TICKS(5) : 1;
+#endif
+        const bool got_job = (xQueueReceive(image_job_queue, &job, wait) == pdTRUE);
+
+        const unsigned long t0 = millis();
+        if (got_job) {
+            portENTER_CRITICAL(&image_job_stats_mux);
+            image_job_stats.active_job = job.type;
+            image_job_stats.last_wait_ms = (uint32_t)(t0 - job.enqueued_ms);
+            portEXIT_CRITICAL(&image_job_stats_mux);
+        }
+
+        image_api_run_pending(image_worker_ota_in_progress);
+
+        if (got_job) {
+            const uint32_t run_ms = (uint32_t)(millis() - t0);
+            portENTER_CRITICAL(&image_job_stats_mux);
+            image_job_stats.active_job = IMAGE_JOB_NONE;
+            image_job_stats.last_job = job.type;
+            image_job_stats.last_run_ms = run_ms;
+            if (run_ms > image_job_stats.max_run_ms) image_job_stats.max_run_ms = run_ms;
+            image_job_stats.jobs_done++;
+            portEXIT_CRITICAL(&image_job_stats_mux);
+        }
+    }
+}
+
+static void image_api_start_worker() {
+    if (image_worker_task) return;
+
+    image_job_queue = xQueueCreate(IMAGE_API_WORKER_QUEUE_DEPTH, sizeof(ImageJob));
+    if (!image_job_queue) {
+        Logger.logMessage("ImageApi", "ERROR: Image job queue allocation failed; using main loop");
+        return;
+    }
+
+    #if CONFIG_FREERTOS_UNICORE
+    xTaskCreate(image_worker_task_fn, "ImageWorker", IMAGE_API_WORKER_STACK_BYTES, nullptr,
+                IMAGE_API_WORKER_PRIORITY, &image_worker_task);
+    #else
+    xTaskCreatePinnedToCore(image_worker_task_fn, "ImageWorker", IMAGE_API_WORKER_STACK_BYTES, nullptr,
+                            IMAGE_API_WORKER_PRIORITY, &image_worker_task, IMAGE_API_WORKER_CORE);
+    #endif
+
+    if (!image_worker_task) {
+        Logger.logMessage("ImageApi", "ERROR: Image worker task creation failed; using main loop");
+        vQueueDelete(image_job_queue);
+        image_job_queue = nullptr;
+        return;
+    }
+
+    Logger.logMessagef("ImageApi", "Image worker started (prio %d, queue %d)",
+                       (int)IMAGE_API_WORKER_PRIORITY, (int)IMAGE_API_WORKER_QUEUE_DEPTH);
+}
+#endif // IMAGE_API_WORKER_ENABLED
+
+void image_api_process_pending(bool ota_in_progress) {
+#if IMAGE_API_WORKER_ENABLED
+    if (image_worker_task) {
+        // The worker does the work; the main loop only forwards OTA state.
+        image_worker_ota_in_progress = ota_in_progress;
+        return;
+    }
+#endif
+    image_api_run_pending(ota_in_progress);
+}
+
+bool image_api_download_jpeg(const char* url, unsigned long timeout_ms, uint8_t** out_buf, size_t* out_sz, char* err, size_t err_len) {
+    return download_jpeg_to_buffer(url, timeout_ms, out_buf, out_sz, err, err_len);
+}
+
+void image_api_free_buffer(void* p) {
+    image_api_free(p);
+}
+
+bool image_api_get_worker_stats(ImageApiWorkerStats* out) {
+    if (!out) return false;
+
+    portENTER_CRITICAL(&image_job_stats_mux);
+    *out = image_job_stats;
+    portEXIT_CRITICAL(&image_job_stats_mux);
+
+#if IMAGE_API_WORKER_ENABLED
+    out->worker = (image_worker_task != nullptr);
+    out->queue_depth = image_job_queue ? (uint32_t)uxQueueMessagesWaiting(image_job_queue) : 0;
+#else
+    out->worker = false;
+    out->queue_depth = 0;
+#endif
+
+    out->strip_queue_depth = strip_queue_count();
+#if IMAGE_API_URL_CACHE_ENTRIES > 0
+    out->url_not_modified = url_cache_not_modified;
+#else
+    out->url_not_modified = 0;
+#endif
+#if IMAGE_API_URL_KEEPALIVE_CONNS > 0
+    // Written by the task that owns the pool; a torn read only skews a counter.
+    out->url_conns_opened = url_pool_opened;
+    out->url_conns_reused = url_pool_reused;
+    out->url_conns_idle = url_pool_idle_count();
+#else
+    out->url_conns_opened = 0;
+    out->url_conns_reused = 0;
+    out->url_conns_idle = 0;
+#endif
+#if IMAGE_API_WEBSOCKET
+    out->ws_connected = (ws_client_id != 0);
+    out->ws_messages = ws_messages;
+    out->ws_rejected = ws_rejected;
+#else
+    out->ws_connected = false;
+    out->ws_messages = 0;
+    out->ws_rejected = 0;
+#endif
+#if IMAGE_API_MULTICAST
+    out->mcast_joined = mcast_joined;
+    out->mcast_datagrams = mcast_datagrams;
+    out->mcast_frames = mcast_frames;
+    out->mcast_rebuilt = mcast_rebuilt;
+    out->mcast_strips_lost = mcast_strips_lost;
+    out->mcast_rejected = mcast_rejected;
+#else
+    out->mcast_joined = false;
+    out->mcast_datagrams = 0;
+    out->mcast_frames = 0;
+    out->mcast_rebuilt = 0;
+    out->mcast_strips_lost = 0;
+    out->mcast_rejected = 0;
+#endif
+
+    switch (upload_state) {
+        case UPLOAD_IN_PROGRESS: out->state = "busy"; break;
+        case UPLOAD_READY_TO_DISPLAY: out->state = "queued"; break;
+        case UPLOAD_STREAMING: out->state = "streaming"; break;
+        default: out->state = "idle"; break;
+    }
+    out->active_job_name = image_job_name(out->active_job);
+    out->last_job_name = image_job_name(out->last_job);
+    return true;
+}
+
 #endif // HAS_IMAGE_API
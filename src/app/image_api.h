@@ -5,7 +5,8 @@
  * Uses backend adapter pattern for integration with any display system.
  * 
  * Supports two upload modes:
- * 1. Full image upload (deferred decode in main loop)
+ * 1. Full image upload (deferred decode in main loop, or streamed while
+ *    the body arrives when IMAGE_API_STREAM_UPLOAD is enabled)
  * 2. Stripped upload (synchronous decode, memory efficient)
  */
 
@@ -18,15 +19,30 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "image_stream.h"
+
 class AsyncWebServer;
 class AsyncWebServerRequest;
 
 // Backend adapter interface for connecting to display system
-// Implement these three hooks to integrate with your display pipeline
+// Implement these hooks to integrate with your display pipeline
 struct ImageApiBackend {
     void (*hide_current_image)();  // Hide/dismiss current image
     bool (*start_strip_session)(int width, int height, unsigned long timeout_ms, unsigned long start_time);
     bool (*decode_strip)(const uint8_t* jpeg_data, size_t jpeg_size, uint8_t strip_index, bool output_bgr565);
+    // Optional: decode a full JPEG from a streaming source (nullptr = buffer whole images)
+    bool (*decode_stream)(ImageStreamReadFn read, void* read_ctx, bool output_bgr565);
+    // Optional: restart the timeout of the image still on screen (false = nothing shown)
+    bool (*refresh_current_image)(unsigned long timeout_ms, unsigned long start_time);
+    // Optional: write ready-made RGB565 pixels into the current session (nullptr = no raw uploads)
+    bool (*push_rect)(int x, int y, int w, int h, uint16_t* pixels, bool big_endian);
+    // Optional: decode a JPEG fragment at (x, y) into the current session (nullptr = no JPEG tiles)
+    bool (*decode_tile)(const uint8_t* jpeg_data, size_t jpeg_size, int x, int y, bool output_bgr565);
+    // Optional: decode a streamed JPEG over the previous frame (nullptr = no MJPEG streams)
+    bool (*decode_frame)(ImageStreamReadFn read, void* read_ctx, bool output_bgr565);
+    // Optional: decode a whole JPEG (buffer, or read != nullptr) at the largest
+    // 1/1..1/8 scale that fits the panel (nullptr = panel-sized images only)
+    bool (*decode_fit)(const uint8_t* jpeg_data, size_t jpeg_size, ImageStreamReadFn read, void* read_ctx, bool output_bgr565, bool center);
 };
 
 // Configuration structure (can be populated from board_config.h)
@@ -48,11 +64,72 @@ void image_api_init(const ImageApiConfig& cfg, const ImageApiBackend& backend);
 //   POST   /api/display/image_url      - Queue HTTP/HTTPS JPEG download (deferred download+decode)
 //   DELETE /api/display/image          - Dismiss current image
 //   POST   /api/display/image/strips   - Upload JPEG strip (synchronous)
+//   POST   /api/display/image/raw      - Upload an RGB565 rectangle (raw/RLE/LZ4, no JPEG decode)
+//   POST   /api/display/image/tiles    - Update changed rectangles of the current image
+//   POST   /api/display/stream         - Start pulling an MJPEG (multipart/x-mixed-replace) URL
+//   GET    /api/display/stream         - Stream status (fps, dropped frames, reconnects)
+//   DELETE /api/display/stream         - Stop the stream
+//   GET    /api/display/ws             - WebSocket channel for strips, rectangles and tile batches
 // auth_gate: optional hook to enforce portal auth. Return true to allow, false to deny (should send response).
 void image_api_register_routes(AsyncWebServer* server, bool (*auth_gate)(AsyncWebServerRequest* request) = nullptr);
 
 // Process pending image operations (call from main loop)
 // ota_in_progress: true if OTA update is in progress (skips processing)
+// With IMAGE_API_WORKER_ENABLED the work runs on the image worker task and this
+// only forwards the OTA state.
 void image_api_process_pending(bool ota_in_progress);
 
+// Deferred image job telemetry (for /api/health)
+struct ImageApiWorkerStats {
+    bool worker;                  // true when a dedicated worker task runs the jobs
+    uint32_t queue_depth;         // jobs waiting in the worker queue
+    uint32_t strip_queue_depth;   // uploaded strips waiting for decode
+    uint32_t jobs_queued;         // jobs handed to the consumer since boot
+    uint32_t jobs_coalesced;      // notifications folded into an already-queued wakeup
+    uint32_t jobs_done;           // jobs finished by the worker
+    uint8_t active_job;           // internal job type (0 = none)
+    uint8_t last_job;
+    uint32_t last_wait_ms;        // enqueue -> start of the last job
+    uint32_t last_run_ms;         // duration of the last job
+    uint32_t max_run_ms;
+    uint32_t url_not_modified;    // image_url requests answered by a 304
+    uint32_t url_conns_opened;    // keep-alive pool connections opened
+    uint32_t url_conns_reused;    // image_url / playlist requests sent on a pooled connection
+    uint8_t url_conns_idle;       // pooled connections open and idle now
+    uint32_t last_decode_ms;      // last full-image decode + draw
+    bool last_decode_parallel;    // ... on both cores (split at restart markers)
+    uint32_t parallel_decodes;    // full images decoded on both cores since boot
+    bool ws_connected;            // a client holds /api/display/ws
+    uint32_t ws_messages;         // WebSocket messages queued since boot
+    uint32_t ws_rejected;         // ... answered with a non-OK ack
+    bool mcast_joined;            // IMAGE_API_MULTICAST group joined
+    uint32_t mcast_datagrams;     // valid multicast datagrams received since boot
+    uint32_t mcast_frames;        // multicast images handed to the decoder in full
+    uint32_t mcast_rebuilt;       // lost fragments rebuilt from parity
+    uint32_t mcast_strips_lost;   // strips missed on a pass (drawn again from a repeat, if any)
+    uint32_t mcast_rejected;      // malformed/oversized datagrams and strips failing preflight
+    const char* state;            // "idle", "busy", "queued", "streaming"
+    const char* active_job_name;  // nullptr when idle
+    const char* last_job_name;
+};
+
+bool image_api_get_worker_stats(ImageApiWorkerStats* out);
+
+// Queue a URL download for display, as POST /api/display/image_url does
+// (timeout_ms 0 = IMAGE_API_DEFAULT_TIMEOUT_MS). Safe from any task. On failure
+// *err (optional) is "Missing url", "URL too long" or "Busy".
+bool image_api_queue_url(const char* url, unsigned long timeout_ms, bool center, const char** err);
+
+// Download a whole JPEG over HTTP(S) into a new buffer (caller frees with
+// image_api_free_buffer). Blocking; call from the image worker / main loop only.
+bool image_api_download_jpeg(const char* url, unsigned long timeout_ms, uint8_t** out_buf, size_t* out_sz, char* err, size_t err_len);
+void image_api_free_buffer(void* p);
+
+#if IMAGE_API_MULTICAST
+// Join group:port for multicast image strips (image_mcast.h); an empty group
+// leaves it, port 0 = IMAGE_API_MULTICAST_DEFAULT_PORT. Safe from any task;
+// the receiver task is started on first use and rejoins after WiFi drops.
+void image_api_multicast_configure(const char* group, uint16_t port);
+#endif
+
 #endif // HAS_IMAGE_API
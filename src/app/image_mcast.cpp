@@ -0,0 +1,146 @@
+/*
+ * Image Multicast Wire Format Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+
+#include "image_mcast.h"
+
+#include <string.h>
+
+static uint16_t read_u16le(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool bit_get(const uint32_t* bits, uint16_t i) {
+    return (bits[i >> 5] >> (i & 31)) & 1u;
+}
+
+static void bit_set(uint32_t* bits, uint16_t i) {
+    bits[i >> 5] |= 1u << (i & 31);
+}
+
+// Payload bytes of data fragment i (the last one may be short).
+static uint32_t frag_len(uint16_t i, uint16_t frag_count, uint16_t frag_bytes, uint32_t strip_bytes) {
+    if (i + 1 < frag_count) return frag_bytes;
+    return strip_bytes - (uint32_t)(frag_count - 1) * frag_bytes;
+}
+
+uint16_t image_mcast_parity_groups(const ImageMcastHeader& h) {
+    if (h.fec_group == 0) return 0;
+    return (uint16_t)((h.frag_count + h.fec_group - 1) / h.fec_group);
+}
+
+bool image_mcast_parse_header(const uint8_t* buf, size_t len, ImageMcastHeader* out) {
+    if (!buf || !out || len <= IMAGE_MCAST_HEADER_BYTES) return false;
+    if (buf[0] != IMAGE_MCAST_VERSION) return false;
+
+    ImageMcastHeader h;
+    h.type = buf[1];
+    h.frame = read_u16le(buf + 2);
+    h.strip_index = buf[4];
+    h.strip_count = buf[5];
+    h.width = read_u16le(buf + 6);
+    h.height = read_u16le(buf + 8);
+    h.frag_index = read_u16le(buf + 10);
+    h.frag_count = read_u16le(buf + 12);
+    h.frag_bytes = read_u16le(buf + 14);
+    h.fec_group = buf[16];
+    h.strip_bytes = read_u32le(buf + 18);
+    h.timeout_s = read_u16le(buf + 22);
+
+    if (h.strip_count == 0 || h.strip_index >= h.strip_count) return false;
+    if (h.width == 0 || h.height == 0) return false;
+    if (h.frag_count == 0 || h.frag_count > IMAGE_API_MULTICAST_MAX_FRAGMENTS || h.frag_bytes == 0) return false;
+    if (h.strip_bytes <= (uint32_t)(h.frag_count - 1) * h.frag_bytes) return false;
+    if (h.strip_bytes > (uint32_t)h.frag_count * h.frag_bytes) return false;
+
+    const size_t payload = len - IMAGE_MCAST_HEADER_BYTES;
+    if (h.type == IMAGE_MCAST_DATA) {
+        if (h.frag_index >= h.frag_count) return false;
+        if (payload != frag_len(h.frag_index, h.frag_count, h.frag_bytes, h.strip_bytes)) return false;
+    } else if (h.type == IMAGE_MCAST_PARITY) {
+        if (h.fec_group == 0 || h.frag_index >= image_mcast_parity_groups(h)) return false;
+        if (payload != h.frag_bytes) return false;
+    } else {
+        return false;
+    }
+
+    *out = h;
+    return true;
+}
+
+void image_mcast_strip_begin(ImageMcastStrip* s, const ImageMcastHeader& h, uint8_t* data, uint8_t* parity) {
+    memset(s, 0, sizeof(*s));
+    s->data = data;
+    s->parity = parity;
+    s->frame = h.frame;
+    s->strip_index = h.strip_index;
+    s->frag_count = h.frag_count;
+    s->frag_bytes = h.frag_bytes;
+    s->fec_group = parity ? h.fec_group : 0;
+    s->strip_bytes = h.strip_bytes;
+    s->missing = h.frag_count;
+}
+
+bool image_mcast_strip_matches(const ImageMcastStrip* s, const ImageMcastHeader& h) {
+    return s->data && s->frame == h.frame && s->strip_index == h.strip_index && s->frag_count == h.frag_count &&
+           s->frag_bytes == h.frag_bytes && s->strip_bytes == h.strip_bytes;
+}
+
+// Rebuild the one missing data fragment of group g from its parity.
+static uint16_t rebuild_group(ImageMcastStrip* s, uint16_t g) {
+    if (!s->fec_group || !bit_get(s->have_parity, g)) return 0;
+
+    const uint16_t first = (uint16_t)(g * s->fec_group);
+    uint16_t last = (uint16_t)(first + s->fec_group);
+    if (last > s->frag_count) last = s->frag_count;
+
+    int32_t lost = -1;
+    for (uint16_t i = first; i < last; i++) {
+        if (bit_get(s->have, i)) continue;
+        if (lost >= 0) return 0;  // two or more missing: parity cannot help
+        lost = i;
+    }
+    if (lost < 0) return 0;
+
+    const uint32_t n = frag_len((uint16_t)lost, s->frag_count, s->frag_bytes, s->strip_bytes);
+    uint8_t* dst = s->data + (size_t)lost * s->frag_bytes;
+    memcpy(dst, s->parity + (size_t)g * s->frag_bytes, n);
+    for (uint16_t i = first; i < last; i++) {
+        if (i == (uint16_t)lost) continue;
+        const uint8_t* src = s->data + (size_t)i * s->frag_bytes;
+        const uint32_t m = frag_len(i, s->frag_count, s->frag_bytes, s->strip_bytes);
+        const uint32_t k = (m < n) ? m : n;
+        for (uint32_t b = 0; b < k; b++) dst[b] ^= src[b];
+    }
+    bit_set(s->have, (uint16_t)lost);
+    s->missing--;
+    return 1;
+}
+
+uint16_t image_mcast_strip_add(ImageMcastStrip* s, const ImageMcastHeader& h, const uint8_t* payload, size_t len) {
+    uint16_t group;
+    if (h.type == IMAGE_MCAST_DATA) {
+        if (bit_get(s->have, h.frag_index)) return 0;
+        memcpy(s->data + (size_t)h.frag_index * s->frag_bytes, payload, len);
+        bit_set(s->have, h.frag_index);
+        s->missing--;
+        if (!s->fec_group) return 0;
+        group = (uint16_t)(h.frag_index / s->fec_group);
+    } else {
+        if (!s->parity || h.fec_group != s->fec_group || bit_get(s->have_parity, h.frag_index)) return 0;
+        memcpy(s->parity + (size_t)h.frag_index * s->frag_bytes, payload, len);
+        bit_set(s->have_parity, h.frag_index);
+        group = h.frag_index;
+    }
+    return (s->missing > 0) ? rebuild_group(s, group) : 0;
+}
+
+#endif // HAS_IMAGE_API && IMAGE_API_MULTICAST
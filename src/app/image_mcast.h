@@ -0,0 +1,100 @@
+/*
+ * Image Multicast Wire Format
+ *
+ * UDP multicast fan-out of JPEG strips (IMAGE_API_MULTICAST): one sender
+ * updates a whole fleet with a single transmission. Each strip is the same
+ * JPEG fragment /api/display/image/strips takes, cut into datagrams. Every
+ * datagram is a 24-byte little-endian header followed by its payload:
+ *
+ *   u8  version      IMAGE_MCAST_VERSION
+ *   u8  type         1 = data fragment, 2 = parity fragment
+ *   u16 frame        image id; a new id starts a new image
+ *   u8  strip_index
+ *   u8  strip_count
+ *   u16 width        full image size
+ *   u16 height
+ *   u16 frag_index   data: fragment number in the strip; parity: group number
+ *   u16 frag_count   data fragments in the strip
+ *   u16 frag_bytes   payload of every data fragment but the last
+ *   u8  fec_group    data fragments per parity fragment (0 = no parity)
+ *   u8  reserved
+ *   u32 strip_bytes  JPEG bytes in the strip
+ *   u16 timeout      seconds; 0 = default
+ *
+ * A parity fragment is the XOR of the data fragments of its group (the
+ * last one zero-padded to frag_bytes), so one lost fragment per group is
+ * rebuilt without asking the sender. There is no return channel: the sender
+ * repeats the frame instead, and a receiver that lost a strip on the first
+ * pass resumes from that strip on the next one. Strips it already drew are
+ * skipped.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API && IMAGE_API_MULTICAST
+
+#include <stddef.h>
+#include <stdint.h>
+
+static constexpr size_t IMAGE_MCAST_HEADER_BYTES = 24;
+static constexpr uint8_t IMAGE_MCAST_VERSION = 1;
+
+enum ImageMcastType : uint8_t {
+    IMAGE_MCAST_DATA = 1,
+    IMAGE_MCAST_PARITY = 2,
+};
+
+struct ImageMcastHeader {
+    uint8_t type;
+    uint16_t frame;
+    uint8_t strip_index;
+    uint8_t strip_count;
+    uint16_t width;
+    uint16_t height;
+    uint16_t frag_index;
+    uint16_t frag_count;
+    uint16_t frag_bytes;
+    uint8_t fec_group;
+    uint32_t strip_bytes;
+    uint16_t timeout_s;
+};
+
+// Decode and sanity-check the header of a datagram of len bytes (payload
+// length included). False for anything malformed or from another version.
+bool image_mcast_parse_header(const uint8_t* buf, size_t len, ImageMcastHeader* out);
+
+// Parity fragments (groups) of a strip, and the bytes they need.
+uint16_t image_mcast_parity_groups(const ImageMcastHeader& h);
+
+// One strip being put together. The caller owns both buffers:
+// data = strip_bytes, parity = image_mcast_parity_groups() * frag_bytes
+// (nullptr without parity).
+struct ImageMcastStrip {
+    uint8_t* data;
+    uint8_t* parity;
+    uint16_t frame;
+    uint8_t strip_index;
+    uint16_t frag_count;
+    uint16_t frag_bytes;
+    uint8_t fec_group;
+    uint32_t strip_bytes;
+    uint16_t missing;             // data fragments not received or rebuilt yet
+    uint32_t have[(IMAGE_API_MULTICAST_MAX_FRAGMENTS + 31) / 32];
+    uint32_t have_parity[(IMAGE_API_MULTICAST_MAX_FRAGMENTS + 31) / 32];
+};
+
+void image_mcast_strip_begin(ImageMcastStrip* s, const ImageMcastHeader& h, uint8_t* data, uint8_t* parity);
+
+// Same strip, same layout.
+bool image_mcast_strip_matches(const ImageMcastStrip* s, const ImageMcastHeader& h);
+
+// Store a fragment; then, if its group is one fragment short and the parity
+// is in, rebuild that fragment. Returns the fragments rebuilt (0 or 1).
+// Duplicates are ignored.
+uint16_t image_mcast_strip_add(ImageMcastStrip* s, const ImageMcastHeader& h, const uint8_t* payload, size_t len);
+
+inline bool image_mcast_strip_complete(const ImageMcastStrip* s) { return s->missing == 0; }
+
+#endif // HAS_IMAGE_API && IMAGE_API_MULTICAST
@@ -0,0 +1,424 @@
+/*
+ * Image Playlist Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "image_playlist.h"
+
+#if HAS_DISPLAY && IMAGE_PLAYLIST_ENABLED
+#include <lvgl.h>
+#endif
+
+#if HAS_DISPLAY && IMAGE_PLAYLIST_ENABLED && LV_USE_IMG
+
+#include "image_api.h"
+#include "lvgl_jpeg_decoder.h"
+#include "display_manager.h"
+#include "screen_saver_manager.h"
+#include "log_manager.h"
+#include "web_portal_body.h"
+#include "web_portal_json_alloc.h"
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+
+namespace {
+
+constexpr size_t kUrlMaxLen = 256;
+constexpr uint32_t kDefaultDwellMs = 10000;
+constexpr uint32_t kMinDwellMs = 1000;
+constexpr unsigned long kRetryDelayMs = 5000;
+constexpr unsigned long kDownloadTimeoutMs = 15000;
+
+struct PlaylistEntry {
+    char url[kUrlMaxLen];
+    uint32_t dwell_ms;
+};
+
+// Published by the HTTP handlers (AsyncTCP task) under g_mux.
+PlaylistEntry g_entries[IMAGE_PLAYLIST_MAX_ENTRIES];
+uint8_t g_count = 0;
+bool g_active = false;
+uint32_t g_generation = 0;
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Owned by the consumer (image worker / main loop). Status fields are read
+// by GET without locking; they are only diagnostics.
+uint32_t g_worker_generation = 0;
+int g_current = -1;              // Entry on screen (-1 = none yet)
+unsigned long g_shown_ms = 0;
+uint32_t g_current_dwell_ms = 0;
+uint8_t g_fetch_index = 0;       // Next entry to prefetch
+unsigned long g_retry_after_ms = 0;
+
+uint16_t* g_next_pixels = nullptr;  // Decoded-ahead frame (owned until handed to the screen)
+uint32_t g_next_claim = 0;          // Non-zero: g_next_pixels is the screen's back buffer
+int g_next_w = 0;
+int g_next_h = 0;
+int g_next_index = -1;
+uint32_t g_next_dwell_ms = 0;
+
+uint32_t g_transitions = 0;
+uint32_t g_failures = 0;
+uint32_t g_last_fetch_ms = 0;
+uint32_t g_last_decode_ms = 0;
+char g_last_error[96] = {0};
+
+// Largest POST body (collected in a portal body lease, like /api/display/image_url).
+constexpr size_t kBodyMaxSize = IMAGE_PLAYLIST_MAX_ENTRIES * (kUrlMaxLen + 32) + 64;
+
+bool (*g_auth_gate)(AsyncWebServerRequest* request) = nullptr;
+
+void free_next() {
+    if (g_next_pixels && !g_next_claim) {
+        heap_caps_free(g_next_pixels);
+    }
+    g_next_pixels = nullptr;
+    g_next_claim = 0;
+    g_next_index = -1;
+    g_next_w = 0;
+    g_next_h = 0;
+}
+
+bool transition_due(unsigned long now) {
+    return g_current < 0 || (unsigned long)(now - g_shown_ms) >= g_current_dwell_ms;
+}
+
+bool retry_allowed(unsigned long now) {
+    return g_retry_after_ms == 0 || (long)(now - g_retry_after_ms) >= 0;
+}
+
+// Download + decode entry g_fetch_index into the decode-ahead slot.
+void prefetch(uint32_t generation, uint8_t count) {
+    char url[kUrlMaxLen];
+    uint32_t dwell_ms = kDefaultDwellMs;
+    const uint8_t index = (uint8_t)(g_fetch_index % count);
+
+    portENTER_CRITICAL(&g_mux);
+    const bool still_current = (g_generation == generation);
+    if (still_current) {
+        strlcpy(url, g_entries[index].url, sizeof(url));
+        dwell_ms = g_entries[index].dwell_ms;
+    }
+    portEXIT_CRITICAL(&g_mux);
+    if (!still_current) return;
+
+    const unsigned long t0 = millis();
+    uint8_t* jpeg = nullptr;
+    size_t jpeg_sz = 0;
+    char err[128];
+    if (!image_api_download_jpeg(url, kDownloadTimeoutMs, &jpeg, &jpeg_sz, err, sizeof(err))) {
+        g_failures++;
+        snprintf(g_last_error, sizeof(g_last_error), "#%u download: %s", (unsigned)index, err);
+        Logger.logMessagef("Playlist", "ERROR: %s", g_last_error);
+        // Skip the broken entry; try the following one after a short delay.
+        g_fetch_index = (uint8_t)((index + 1) % count);
+        g_retry_after_ms = millis() + kRetryDelayMs;
+        return;
+    }
+    g_last_fetch_ms = (uint32_t)(millis() - t0);
+
+    const unsigned long t1 = millis();
+    uint16_t* pixels = nullptr;
+    int w = 0;
+    int h = 0;
+    int scale_used = -1;
+    char derr[96];
+    uint32_t claim = 0;
+    bool ok = false;
+
+    #if LVGL_IMAGE_DOUBLE_BUFFER
+    // Decode straight into the screen's hidden buffer; the transition is then
+    // just a flip. Falls back to a malloc'd frame without PSRAM.
+    LvglImageScreen* screen = display_manager_get_lvgl_image_screen();
+    size_t back_cap = 0;
+    uint16_t* back = nullptr;
+    if (screen) {
+        display_manager_lock();
+        back = screen->backBuffer(&back_cap, &claim);
+        display_manager_unlock();
+    }
+    if (back) {
+        ok = lvgl_jpeg_decode_into_rgb565(jpeg, jpeg_sz, back, back_cap, &w, &h, &scale_used, derr, sizeof(derr));
+        if (ok) pixels = back;
+    }
+    #endif
+    if (!claim) {
+        ok = lvgl_jpeg_decode_to_rgb565(jpeg, jpeg_sz, &pixels, &w, &h, &scale_used, derr, sizeof(derr));
+    }
+    image_api_free_buffer(jpeg);
+
+    if (!ok) {
+        g_failures++;
+        snprintf(g_last_error, sizeof(g_last_error), "#%u decode: %s", (unsigned)index, derr);
+        Logger.logMessagef("Playlist", "ERROR: %s", g_last_error);
+        g_fetch_index = (uint8_t)((index + 1) % count);
+        g_retry_after_ms = millis() + kRetryDelayMs;
+        return;
+    }
+    g_last_decode_ms = (uint32_t)(millis() - t1);
+
+    g_next_pixels = pixels;
+    g_next_claim = claim;
+    g_next_w = w;
+    g_next_h = h;
+    g_next_index = index;
+    g_next_dwell_ms = dwell_ms;
+    g_fetch_index = (uint8_t)((index + 1) % count);
+    g_retry_after_ms = 0;
+
+    Logger.logMessagef("Playlist", "Prefetched #%u: %dx%d (fetch %lu ms, decode %lu ms)",
+                       (unsigned)index, w, h, (unsigned long)g_last_fetch_ms, (unsigned long)g_last_decode_ms);
+}
+
+void show_next(unsigned long now) {
+    LvglImageScreen* screen = display_manager_get_lvgl_image_screen();
+    if (!screen) {
+        free_next();
+        return;
+    }
+
+    if (g_current < 0) {
+        // First frame: bring the image screen up (queued to the LVGL task).
+        display_manager_show_screen("lvgl_image", nullptr);
+        screen_saver_manager_notify_activity(true);
+    }
+
+    display_manager_lock();
+    const bool set_ok = g_next_claim
+        ? screen->presentBackBuffer(g_next_w, g_next_h, g_next_claim)
+        : screen->setImageRgb565(g_next_pixels, g_next_w, g_next_h);
+    display_manager_unlock();
+
+    if (!set_ok && g_next_claim) {
+        // Another image went through the back buffer since the prefetch
+        // (e.g. an upload); fetch this entry again.
+        Logger.logMessagef("Playlist", "Back buffer reused; refetching #%d", g_next_index);
+        g_fetch_index = (uint8_t)g_next_index;
+        free_next();
+        return;
+    }
+    if (!set_ok) {
+        heap_caps_free(g_next_pixels);
+        Logger.logMessage("Playlist", "ERROR: Failed to set LVGL image");
+    }
+
+    // The screen owns the pixels now (or they were freed above).
+    g_next_pixels = nullptr;
+    g_next_claim = 0;
+    g_current = g_next_index;
+    g_current_dwell_ms = g_next_dwell_ms;
+    g_shown_ms = now;
+    g_next_index = -1;
+    g_transitions++;
+}
+
+bool snapshot(bool* active, uint8_t* count, uint32_t* generation) {
+    portENTER_CRITICAL(&g_mux);
+    *active = g_active;
+    *count = g_count;
+    *generation = g_generation;
+    portEXIT_CRITICAL(&g_mux);
+    return *active && *count > 0;
+}
+
+void send_status(AsyncWebServerRequest* request) {
+    bool active = false;
+    uint8_t count = 0;
+    uint32_t generation = 0;
+    snapshot(&active, &count, &generation);
+
+    StaticJsonDocument<384> doc;
+    doc["active"] = active;
+    doc["entries"] = count;
+    doc["current"] = g_current;
+    doc["next_ready"] = (g_next_pixels != nullptr);
+    doc["next"] = g_next_index;
+    doc["transitions"] = g_transitions;
+    doc["failures"] = g_failures;
+    doc["last_fetch_ms"] = g_last_fetch_ms;
+    doc["last_decode_ms"] = g_last_decode_ms;
+    if (g_last_error[0]) {
+        doc["last_error"] = g_last_error;
+    } else {
+        doc["last_error"] = nullptr;
+    }
+
+    char out[384];
+    serializeJson(doc, out, sizeof(out));
+    request->send(200, "application/json", out);
+}
+
+// GET /api/display/playlist
+void handlePlaylistGet(AsyncWebServerRequest* request) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+    send_status(request);
+}
+
+// DELETE /api/display/playlist
+void handlePlaylistDelete(AsyncWebServerRequest* request) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+
+    portENTER_CRITICAL(&g_mux);
+    g_active = false;
+    g_count = 0;
+    g_generation++;
+    portEXIT_CRITICAL(&g_mux);
+
+    Logger.logMessage("Playlist", "Stopped");
+    request->send(200, "application/json", "{\"success\":true,\"message\":\"Playlist stopped\"}");
+}
+
+// POST /api/display/playlist
+// Body: {"entries":[{"url":"https://...","dwell":10}, ...], "dwell":10}
+// dwell is in seconds (per entry, falling back to the top-level value).
+void handlePlaylistPost(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (g_auth_gate && !g_auth_gate(request)) return;
+
+    const uint8_t* body = portal_body_collect(request, "playlist", data, len, index, total, kBodyMaxSize);
+    if (!body) return;
+
+    BasicJsonDocument<MacrosJsonAllocator> doc(4096);
+    const DeserializationError jerr = deserializeJson(doc, body, total);
+    portal_body_release(request);
+    if (jerr) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+        return;
+    }
+
+    JsonArrayConst list = doc["entries"].as<JsonArrayConst>();
+    if (list.isNull() || list.size() == 0) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing entries\"}");
+        return;
+    }
+    if (list.size() > IMAGE_PLAYLIST_MAX_ENTRIES) {
+        request->send(400, "application/json", "{\"success\":false,\"message\":\"Too many entries\"}");
+        return;
+    }
+
+    const uint32_t default_dwell_s = doc["dwell"] | (kDefaultDwellMs / 1000);
+
+    PlaylistEntry parsed[IMAGE_PLAYLIST_MAX_ENTRIES];
+    uint8_t count = 0;
+    for (JsonVariantConst item : list) {
+        const char* url = item["url"] | "";
+        if (strncmp(url, "http://", 7) != 0 && strncmp(url, "https://", 8) != 0) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Each entry needs an http(s) url\"}");
+            return;
+        }
+        if (strlen(url) >= kUrlMaxLen) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"URL too long\"}");
+            return;
+        }
+
+        uint32_t dwell_ms = (uint32_t)(item["dwell"] | default_dwell_s) * 1000UL;
+        if (dwell_ms < kMinDwellMs) dwell_ms = kMinDwellMs;
+
+        strlcpy(parsed[count].url, url, sizeof(parsed[count].url));
+        parsed[count].dwell_ms = dwell_ms;
+        count++;
+    }
+
+    portENTER_CRITICAL(&g_mux);
+    memcpy(g_entries, parsed, sizeof(PlaylistEntry) * count);
+    g_count = count;
+    g_active = true;
+    g_generation++;
+    portEXIT_CRITICAL(&g_mux);
+
+    Logger.logMessagef("Playlist", "Started with %u entries", (unsigned)count);
+
+    char resp[96];
+    snprintf(resp, sizeof(resp), "{\"success\":true,\"entries\":%u}", (unsigned)count);
+    request->send(200, "application/json", resp);
+}
+
+} // namespace
+
+void image_playlist_register_routes(AsyncWebServer* server, bool (*auth_gate)(AsyncWebServerRequest* request)) {
+    g_auth_gate = auth_gate;
+
+    server->on(
+        "/api/display/playlist",
+        HTTP_POST,
+        [](AsyncWebServerRequest* request) {
+            if (g_auth_gate && !g_auth_gate(request)) return;
+        },
+        NULL,
+        handlePlaylistPost
+    );
+    server->on("/api/display/playlist", HTTP_GET, handlePlaylistGet);
+    server->on("/api/display/playlist", HTTP_DELETE, handlePlaylistDelete);
+}
+
+bool image_playlist_needs_work() {
+    bool active = false;
+    uint8_t count = 0;
+    uint32_t generation = 0;
+    if (!snapshot(&active, &count, &generation)) {
+        // Stopped: release the decode-ahead frame.
+        return g_next_pixels != nullptr || g_current >= 0;
+    }
+    if (generation != g_worker_generation) return true;
+
+    const unsigned long now = millis();
+    if (!g_next_pixels) return retry_allowed(now);
+    return transition_due(now);
+}
+
+void image_playlist_process() {
+    bool active = false;
+    uint8_t count = 0;
+    uint32_t generation = 0;
+    if (!snapshot(&active, &count, &generation)) {
+        free_next();
+        g_current = -1;
+        return;
+    }
+
+    if (generation != g_worker_generation) {
+        // New playlist: start over from entry 0 (the current image stays until replaced).
+        free_next();
+        g_worker_generation = generation;
+        g_current = -1;
+        g_fetch_index = 0;
+        g_retry_after_ms = 0;
+        g_last_error[0] = '\0';
+    }
+
+    if (!g_next_pixels && retry_allowed(millis())) {
+        prefetch(generation, count);
+    }
+
+    const unsigned long now = millis();
+    if (g_next_pixels && transition_due(now)) {
+        show_next(now);
+    }
+}
+
+#else // !(HAS_DISPLAY && IMAGE_PLAYLIST_ENABLED && LV_USE_IMG)
+
+void image_playlist_register_routes(AsyncWebServer* server, bool (*auth_gate)(AsyncWebServerRequest* request)) {
+    (void)server;
+    (void)auth_gate;
+}
+
+bool image_playlist_needs_work() {
+    return false;
+}
+
+void image_playlist_process() {
+}
+
+#endif
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,37 @@
+/*
+ * Image Playlist
+ *
+ * On-device rotation of JPEG URLs (camera, weather, calendar dashboards...)
+ * on the LVGL image screen. While one entry is shown, the next one is
+ * downloaded and decoded ahead into the screen's back buffer
+ * (LVGL_IMAGE_DOUBLE_BUFFER) or a malloc'd RGB565 frame, so a transition is a
+ * buffer flip or hand-off instead of a download + decode.
+ *
+ * Endpoints:
+ *   POST   /api/display/playlist  - {"entries":[{"url":"http://...","dwell":10}, ...]}
+ *   GET    /api/display/playlist  - Playlist status
+ *   DELETE /api/display/playlist  - Stop rotating (current image stays up)
+ *
+ * The prefetch/transition work runs from image_api's deferred work
+ * (image worker task, or the main loop without one).
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+
+// Register playlist routes (no-op when the playlist is compiled out).
+void image_playlist_register_routes(AsyncWebServer* server, bool (*auth_gate)(AsyncWebServerRequest* request));
+
+// True when a prefetch or a transition is due.
+bool image_playlist_needs_work();
+
+// Prefetch the next entry and/or switch to it. May block for a download.
+void image_playlist_process();
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,211 @@
+/*
+ * Image Buffer Pool Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "heap_tags.h"
+#include "image_pool.h"
+#include "log_manager.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <soc/soc_caps.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+
+static constexpr uint8_t POOL_MAX_SLOTS = 32;  // one bit per slot in `used`
+
+static portMUX_TYPE pool_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t* pool_base = nullptr;
+static size_t pool_large_bytes = 0;
+static size_t pool_small_bytes = 0;
+static uint8_t pool_large_slots = 0;
+static uint8_t pool_small_slots = 0;
+static bool pool_psram = false;
+static bool pool_released = false;
+
+// Slots [0, large) are large, [large, large + small) small.
+static uint32_t pool_used = 0;
+static uint8_t pool_peak = 0;
+static uint32_t pool_leases = 0;
+static uint32_t pool_refusals = 0;
+static uint32_t pool_oversize = 0;
+
+static uint8_t* slot_addr(uint8_t slot) {
+    if (slot < pool_large_slots) return pool_base + (size_t)slot * pool_large_bytes;
+    return pool_base + (size_t)pool_large_slots * pool_large_bytes + (size_t)(slot - pool_large_slots) * pool_small_bytes;
+}
+
+static int take_free_locked(uint8_t first, uint8_t count) {
+    for (uint8_t i = first; i < first + count; i++) {
+        if (!(pool_used & (1u << i))) {
+            pool_used |= (1u << i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool image_pool_init(size_t large_bytes, uint8_t large_slots, size_t small_bytes, uint8_t small_slots) {
+    if (pool_base) return true;
+    if (large_slots == 0 || large_bytes == 0) return false;
+    if (small_bytes == 0 || small_bytes > large_bytes) small_slots = 0;
+    if ((unsigned)large_slots + small_slots > POOL_MAX_SLOTS) {
+        Logger.logMessagef("ImagePool", "ERROR: %u slots exceed the limit of %u", (unsigned)(large_slots + small_slots), (unsigned)POOL_MAX_SLOTS);
+        return false;
+    }
+
+    // Keep slot starts 4-byte aligned (raw RGB565 payloads are pushed in place).
+    large_bytes = (large_bytes + 3) & ~(size_t)3;
+    small_bytes = (small_bytes + 3) & ~(size_t)3;
+    const size_t total = large_bytes * large_slots + small_bytes * small_slots;
+
+    uint8_t* base = nullptr;
+    bool psram = false;
+#if SOC_SPIRAM_SUPPORTED
+    if (psramFound()) {
+        base = (uint8_t*)heap_tag_malloc(HeapTag::Image, total, MALLOC_CAP_SPIRAM);
+        psram = (base != nullptr);
+    }
+#endif
+#if IMAGE_API_POOL_INTERNAL
+    if (!base) {
+        base = (uint8_t*)heap_tag_malloc(HeapTag::Image, total, MALLOC_CAP_8BIT);
+    }
+#endif
+    if (!base) {
+        Logger.logMessagef("ImagePool", "Disabled: could not reserve %u bytes (%s)", (unsigned)total,
+                           IMAGE_API_POOL_INTERNAL ? "no block large enough" : "no PSRAM");
+        return false;
+    }
+
+    portENTER_CRITICAL(&pool_mux);
+    pool_base = base;
+    pool_large_bytes = large_bytes;
+    pool_small_bytes = small_bytes;
+    pool_large_slots = large_slots;
+    pool_small_slots = small_slots;
+    pool_psram = psram;
+    pool_used = 0;
+    portEXIT_CRITICAL(&pool_mux);
+
+    Logger.logMessagef(
+        "ImagePool",
+        "Reserved %u KB in %s: %u x %u KB + %u x %u KB",
+        (unsigned)(total / 1024),
+        psram ? "PSRAM" : "internal RAM",
+        (unsigned)large_slots,
+        (unsigned)(large_bytes / 1024),
+        (unsigned)small_slots,
+        (unsigned)(small_bytes / 1024)
+    );
+    return true;
+}
+
+bool image_pool_enabled() {
+    return pool_base != nullptr;
+}
+
+bool image_pool_fits(size_t size) {
+    return pool_base && size > 0 && size <= pool_large_bytes;
+}
+
+void* image_pool_lease(size_t size) {
+    if (!pool_base || size == 0) return nullptr;
+
+    portENTER_CRITICAL(&pool_mux);
+    int slot = -1;
+    if (!pool_base) {
+        // Released by image_pool_release_idle() since the check above.
+    } else if (size > pool_large_bytes) {
+        pool_oversize++;
+    } else {
+        // Small requests prefer small slots so large ones stay free for whole images.
+        if (size <= pool_small_bytes) slot = take_free_locked(pool_large_slots, pool_small_slots);
+        if (slot < 0) slot = take_free_locked(0, pool_large_slots);
+        if (slot < 0) {
+            pool_refusals++;
+        } else {
+            pool_leases++;
+            const uint8_t used = (uint8_t)__builtin_popcount(pool_used);
+            if (used > pool_peak) pool_peak = used;
+        }
+    }
+    // A leased slot keeps the pool from being released, so pool_base stays put.
+    portEXIT_CRITICAL(&pool_mux);
+
+    return (slot >= 0) ? slot_addr((uint8_t)slot) : nullptr;
+}
+
+bool image_pool_release(void* p) {
+    if (!pool_base || !p) return false;
+
+    const uint8_t* q = (const uint8_t*)p;
+    const uint8_t* small_base = pool_base + (size_t)pool_large_slots * pool_large_bytes;
+    const uint8_t* end = small_base + (size_t)pool_small_slots * pool_small_bytes;
+    if (q < pool_base || q >= end) return false;
+
+    uint8_t slot;
+    if (q < small_base) {
+        slot = (uint8_t)((size_t)(q - pool_base) / pool_large_bytes);
+    } else {
+        slot = (uint8_t)(pool_large_slots + (size_t)(q - small_base) / pool_small_bytes);
+    }
+
+    portENTER_CRITICAL(&pool_mux);
+    pool_used &= ~(1u << slot);
+    portEXIT_CRITICAL(&pool_mux);
+    return true;
+}
+
+void image_pool_get_stats(ImagePoolStats* out) {
+    if (!out) return;
+
+    portENTER_CRITICAL(&pool_mux);
+    const uint32_t large_mask = (pool_large_slots >= 32) ? 0xFFFFFFFFu : ((1u << pool_large_slots) - 1u);
+    out->enabled = (pool_base != nullptr);
+    out->released = pool_released;
+    out->psram = pool_psram;
+    out->large_slots = pool_large_slots;
+    out->small_slots = pool_small_slots;
+    out->large_used = (uint8_t)__builtin_popcount(pool_used & large_mask);
+    out->small_used = (uint8_t)__builtin_popcount(pool_used & ~large_mask);
+    out->peak_used = pool_peak;
+    out->large_bytes = (uint32_t)pool_large_bytes;
+    out->small_bytes = (uint32_t)pool_small_bytes;
+    out->leases = pool_leases;
+    out->refusals = pool_refusals;
+    out->oversize = pool_oversize;
+    portEXIT_CRITICAL(&pool_mux);
+}
+
+bool image_pool_release_idle() {
+    portENTER_CRITICAL(&pool_mux);
+    if (!pool_base || pool_used) {
+        const bool done = !pool_base;
+        portEXIT_CRITICAL(&pool_mux);
+        return done;
+    }
+    uint8_t* base = pool_base;
+    pool_base = nullptr;
+    pool_released = true;
+    portEXIT_CRITICAL(&pool_mux);
+
+    heap_tag_free(HeapTag::Image, base);
+    Logger.logMessage("ImagePool", "Released (memory pressure)");
+    return true;
+}
+
+bool image_pool_restore() {
+    if (!pool_released) return true;
+    // Same geometry as the first init (already aligned).
+    if (!image_pool_init(pool_large_bytes, pool_large_slots, pool_small_bytes, pool_small_slots)) return false;
+    pool_released = false;
+    return true;
+}
+
+#endif // HAS_IMAGE_API
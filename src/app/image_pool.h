@@ -0,0 +1,64 @@
+/*
+ * Image Buffer Pool
+ *
+ * Fixed slots for compressed image bodies (full uploads, URL downloads,
+ * strips, raw/tile batches), carved out of one allocation at boot so repeated
+ * uploads stop fragmenting the heap. Two slot classes: large slots hold a
+ * whole JPEG (IMAGE_API_MAX_SIZE_BYTES), small ones a strip. A small request
+ * takes a large slot when the small ones are busy.
+ *
+ * Requests larger than a large slot are not pooled (the caller may use the
+ * heap); a full pool is a refusal the caller reports. Leasing and releasing
+ * are safe from any task.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct ImagePoolStats {
+    bool enabled;
+    bool released;         // given back by image_pool_release_idle()
+    bool psram;
+    uint8_t large_slots;
+    uint8_t large_used;
+    uint8_t small_slots;
+    uint8_t small_used;
+    uint8_t peak_used;
+    uint32_t large_bytes;  // per slot
+    uint32_t small_bytes;  // per slot
+    uint32_t leases;       // since boot
+    uint32_t refusals;     // pool full
+    uint32_t oversize;     // larger than a large slot (not pooled)
+};
+
+// Carve the pool (once). False leaves the pool disabled, e.g. no PSRAM fitted
+// and internal RAM not allowed by IMAGE_API_POOL_INTERNAL.
+bool image_pool_init(size_t large_bytes, uint8_t large_slots, size_t small_bytes, uint8_t small_slots);
+
+bool image_pool_enabled();
+
+// True when a request of this size is served by the pool (enabled and not oversize).
+bool image_pool_fits(size_t size);
+
+// Lease a slot of at least size bytes. nullptr when the pool is full (counted
+// as a refusal) or the request does not fit a slot (counted as oversize).
+void* image_pool_lease(size_t size);
+
+// Return a leased slot. False when p does not belong to the pool.
+bool image_pool_release(void* p);
+
+void image_pool_get_stats(ImagePoolStats* out);
+
+// Memory pressure: give the pool's block back to the heap while no slot is
+// leased, so requests take the heap path until image_pool_restore() carves it
+// again with the same geometry. False while a slot is still leased.
+bool image_pool_release_idle();
+bool image_pool_restore();
+
+#endif // HAS_IMAGE_API
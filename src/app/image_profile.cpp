@@ -0,0 +1,120 @@
+/*
+ * Image Pipeline Profiler Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "image_profile.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+
+#if IMAGE_API_PROFILE
+
+static portMUX_TYPE profile_mux = portMUX_INITIALIZER_UNLOCKED;
+static ImageProfileRecord profile_ring[IMAGE_API_PROFILE_HISTORY];
+static size_t profile_count = 0;
+static size_t profile_head = 0;  // next slot to write
+static uint32_t profile_seq = 0;
+
+static ImageProfileRecord profile_open;
+static bool profile_is_open = false;
+static int64_t profile_open_us = 0;
+
+static void profile_commit_locked(bool ok) {
+    profile_open.ok = ok;
+    profile_open.worker_us = (uint32_t)(esp_timer_get_time() - profile_open_us);
+    profile_open.completed_ms = millis();
+    profile_ring[profile_head] = profile_open;
+    profile_head = (profile_head + 1) % IMAGE_API_PROFILE_HISTORY;
+    if (profile_count < IMAGE_API_PROFILE_HISTORY) profile_count++;
+    profile_is_open = false;
+}
+
+void image_profile_begin(const char* kind, const ImageProfileSpan* carried) {
+    portENTER_CRITICAL(&profile_mux);
+    if (profile_is_open) profile_commit_locked(false);
+
+    memset(&profile_open, 0, sizeof(profile_open));
+    profile_open.seq = ++profile_seq;
+    strlcpy(profile_open.kind, kind ? kind : "?", sizeof(profile_open.kind));
+    if (carried) profile_open.stages = *carried;
+    profile_open_us = esp_timer_get_time();
+    profile_is_open = true;
+    portEXIT_CRITICAL(&profile_mux);
+}
+
+void image_profile_add(ImageProfileStage stage, uint32_t us, uint32_t bytes) {
+    if (stage >= IMAGE_STAGE_COUNT) return;
+    portENTER_CRITICAL(&profile_mux);
+    if (profile_is_open) {
+        profile_open.stages.us[stage] += us;
+        profile_open.stages.bytes[stage] += bytes;
+    }
+    portEXIT_CRITICAL(&profile_mux);
+}
+
+void image_profile_end(bool ok) {
+    portENTER_CRITICAL(&profile_mux);
+    if (profile_is_open) profile_commit_locked(ok);
+    portEXIT_CRITICAL(&profile_mux);
+}
+
+size_t image_profile_snapshot(ImageProfileRecord* out, size_t max) {
+    if (!out || max == 0) return 0;
+
+    portENTER_CRITICAL(&profile_mux);
+    const size_t n = (profile_count < max) ? profile_count : max;
+    for (size_t i = 0; i < n; i++) {
+        const size_t slot = (profile_head + IMAGE_API_PROFILE_HISTORY - 1 - i) % IMAGE_API_PROFILE_HISTORY;
+        out[i] = profile_ring[slot];
+    }
+    portEXIT_CRITICAL(&profile_mux);
+    return n;
+}
+
+#else // !IMAGE_API_PROFILE
+
+void image_profile_begin(const char* kind, const ImageProfileSpan* carried) {
+    (void)kind;
+    (void)carried;
+}
+
+void image_profile_add(ImageProfileStage stage, uint32_t us, uint32_t bytes) {
+    (void)stage;
+    (void)us;
+    (void)bytes;
+}
+
+void image_profile_end(bool ok) {
+    (void)ok;
+}
+
+size_t image_profile_snapshot(ImageProfileRecord* out, size_t max) {
+    (void)out;
+    (void)max;
+    return 0;
+}
+
+#endif // IMAGE_API_PROFILE
+
+const char* image_profile_stage_name(ImageProfileStage stage) {
+    switch (stage) {
+        case IMAGE_STAGE_RECEIVE: return "receive";
+        case IMAGE_STAGE_PREFLIGHT: return "preflight";
+        case IMAGE_STAGE_ALLOC: return "alloc";
+        case IMAGE_STAGE_HEADER: return "header";
+        case IMAGE_STAGE_DECODE: return "decode";
+        case IMAGE_STAGE_PACK: return "pack";
+        case IMAGE_STAGE_PUSH: return "push";
+        default: return "?";
+    }
+}
+
+#endif // HAS_IMAGE_API
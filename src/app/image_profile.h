@@ -0,0 +1,82 @@
+/*
+ * Image Pipeline Profiler
+ *
+ * Per-stage timings for the last IMAGE_API_PROFILE_HISTORY image operations
+ * (full uploads, streamed uploads, URL fetches, strips, MJPEG frames, LVGL
+ * decodes), served at GET /api/display/image/stats.
+ *
+ * The image worker opens a record around each operation; the decoders add
+ * their stage totals to it. Adds with no open record are dropped, so decoder
+ * code can report unconditionally. Stages measured on another task before the
+ * worker picks the job up (HTTP receive, preflight, buffer allocation) travel
+ * with the job as an ImageProfileSpan and are merged in when it opens.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_timer.h>
+
+enum ImageProfileStage : uint8_t {
+    IMAGE_STAGE_RECEIVE = 0,  // HTTP body / download, or decoder waiting on a stream
+    IMAGE_STAGE_PREFLIGHT,    // JPEG header checks
+    IMAGE_STAGE_ALLOC,        // upload / frame buffer allocation
+    IMAGE_STAGE_HEADER,       // jd_prepare: TJpgDec header parse and table setup
+    IMAGE_STAGE_DECODE,       // TJpgDec jd_decomp, less pack and push
+    IMAGE_STAGE_PACK,         // RGB888 -> RGB565
+    IMAGE_STAGE_PUSH,         // pushColors / present
+    IMAGE_STAGE_COUNT
+};
+
+// Stage totals measured outside the worker, carried with a queued job.
+struct ImageProfileSpan {
+    uint32_t us[IMAGE_STAGE_COUNT];
+    uint32_t bytes[IMAGE_STAGE_COUNT];
+};
+
+struct ImageProfileRecord {
+    uint32_t seq;          // 1-based, increments per operation
+    char kind[12];         // "upload", "stream", "url", "strip", "mjpeg"
+    bool ok;
+    uint32_t worker_us;    // open -> close on the worker
+    uint32_t completed_ms; // millis() at close
+    ImageProfileSpan stages;
+};
+
+// Open a record for one operation (closes a forgotten one as failed).
+void image_profile_begin(const char* kind, const ImageProfileSpan* carried = nullptr);
+
+// Add time / bytes to a stage of the open record (any task; no-op when none is open).
+void image_profile_add(ImageProfileStage stage, uint32_t us, uint32_t bytes = 0);
+
+// Close the open record into the history ring.
+void image_profile_end(bool ok);
+
+// Copy up to max records, newest first. Returns the count.
+size_t image_profile_snapshot(ImageProfileRecord* out, size_t max);
+
+const char* image_profile_stage_name(ImageProfileStage stage);
+
+// Profiler clock for call sites (0 with IMAGE_API_PROFILE off, so sums stay 0).
+static inline uint32_t image_profile_now_us() {
+#if IMAGE_API_PROFILE
+    return (uint32_t)esp_timer_get_time();
+#else
+    return 0;
+#endif
+}
+
+// Accumulate into a carried span.
+static inline void image_profile_span_add(ImageProfileSpan* span, ImageProfileStage stage, uint32_t us, uint32_t bytes = 0) {
+    if (!span || stage >= IMAGE_STAGE_COUNT) return;
+    span->us[stage] += us;
+    span->bytes[stage] += bytes;
+}
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,140 @@
+/*
+ * Image Stream Source Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "heap_placement.h"
+#include "heap_tags.h"
+#include "image_stream.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+bool ImageStreamRing::open(size_t capacity, uint32_t idle_ms) {
+    if (storage || capacity == 0) return false;
+
+    // Stream buffers need one spare byte to tell full from empty.
+    // Lives for one stream; touched at network speed, not pixel speed.
+    storage = (uint8_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Image, capacity + 1);
+    if (!storage) return false;
+
+    handle = xStreamBufferCreateStatic(capacity + 1, 1, storage, &handle_storage);
+    if (!handle) {
+        heap_tag_free(HeapTag::Image, storage);
+        storage = nullptr;
+        return false;
+    }
+
+    finished = false;
+    timed_out = false;
+    idle_timeout_ms = idle_ms;
+    bytes_in = 0;
+    bytes_out = 0;
+    __atomic_store_n(&writers, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&accepting, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+void ImageStreamRing::close() {
+    if (!storage) return;
+
+    __atomic_store_n(&accepting, false, __ATOMIC_RELEASE);
+
+    // A producer on another core may still be inside xStreamBufferSend();
+    // the storage must outlive that call.
+    while (__atomic_load_n(&writers, __ATOMIC_ACQUIRE) != 0) {
+        vTaskDelay(1);
+    }
+
+    vStreamBufferDelete(handle);
+    handle = nullptr;
+    heap_tag_free(HeapTag::Image, storage);
+    storage = nullptr;
+}
+
+size_t ImageStreamRing::write(const uint8_t* data, size_t len) {
+    if (!data || len == 0) return 0;
+
+    __atomic_add_fetch(&writers, 1, __ATOMIC_ACQ_REL);
+    if (!__atomic_load_n(&accepting, __ATOMIC_ACQUIRE)) {
+        __atomic_sub_fetch(&writers, 1, __ATOMIC_ACQ_REL);
+        return 0;
+    }
+
+    const size_t sent = xStreamBufferSend(handle, data, len, 0);
+
+    __atomic_add_fetch(&bytes_in, (uint32_t)sent, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&writers, 1, __ATOMIC_ACQ_REL);
+    return sent;
+}
+
+size_t ImageStreamRing::spaceAvailable() {
+    // Counted as a writer so close() cannot free the buffer underneath.
+    __atomic_add_fetch(&writers, 1, __ATOMIC_ACQ_REL);
+    const size_t space = __atomic_load_n(&accepting, __ATOMIC_ACQUIRE) ? xStreamBufferSpacesAvailable(handle) : 0;
+    __atomic_sub_fetch(&writers, 1, __ATOMIC_ACQ_REL);
+    return space;
+}
+
+void ImageStreamRing::finish() {
+    __atomic_store_n(&finished, true, __ATOMIC_RELEASE);
+}
+
+size_t ImageStreamRing::receive(uint8_t* dst, size_t n, TickType_t wait) {
+    if (dst) {
+        return xStreamBufferReceive(handle, dst, n, wait);
+    }
+
+    // Skip request: drain into a scratch buffer.
+    uint8_t scratch[64];
+    const size_t chunk = (n < sizeof(scratch)) ? n : sizeof(scratch);
+    return xStreamBufferReceive(handle, scratch, chunk, wait);
+}
+
+size_t ImageStreamRing::read(uint8_t* dst, size_t n) {
+    if (!handle || n == 0) return 0;
+
+    size_t got = 0;
+    bool waiting = false;
+    unsigned long last_byte_ms = millis();
+
+    while (got < n) {
+        // Fast path first; only run the wait hook when we actually have to wait.
+        const TickType_t wait = waiting ? pdMS_TO_TICKS(20) : 0;
+        const size_t r = receive(dst ? dst + got : nullptr, n - got, wait);
+        if (r > 0) {
+            got += r;
+            last_byte_ms = millis();
+            continue;
+        }
+
+        if (__atomic_load_n(&finished, __ATOMIC_ACQUIRE) && xStreamBufferIsEmpty(handle)) {
+            break;
+        }
+        if ((unsigned long)(millis() - last_byte_ms) > idle_timeout_ms) {
+            timed_out = true;
+            break;
+        }
+
+        if (!waiting) {
+            waiting = true;
+            if (wait_hook) wait_hook(true, wait_hook_ctx);
+        }
+    }
+
+    if (waiting && wait_hook) wait_hook(false, wait_hook_ctx);
+
+    bytes_out += (uint32_t)got;
+    return got;
+}
+
+size_t ImageStreamRing::readFn(void* ctx, uint8_t* dst, size_t n) {
+    ImageStreamRing* ring = (ImageStreamRing*)ctx;
+    return ring ? ring->read(dst, n) : 0;
+}
+
+#endif // HAS_IMAGE_API
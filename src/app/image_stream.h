@@ -0,0 +1,89 @@
+/*
+ * Image Stream Source
+ *
+ * Pull-style byte source for the JPEG strip decoder, so TJpgDec can decode
+ * while the image is still arriving instead of after it is fully buffered.
+ *
+ * ImageStreamRing bridges a push producer (AsyncTCP upload callbacks) and the
+ * pull consumer (TJpgDec input function on another task) through a small
+ * FreeRTOS stream buffer. The producer opens it on its first chunk; the
+ * consumer closes it, waiting out any in-flight write before releasing the
+ * storage. Writes after close() are dropped. Writes never block: the producer
+ * throttles its source by watching spaceAvailable().
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/stream_buffer.h>
+
+// Read up to n bytes into dst (dst == nullptr skips n bytes).
+// Returns the number of bytes produced; fewer than n means end of stream or error.
+typedef size_t (*ImageStreamReadFn)(void* ctx, uint8_t* dst, size_t n);
+
+class ImageStreamRing {
+public:
+    ImageStreamRing() = default;
+    ~ImageStreamRing() { close(); }
+
+    // Allocate the ring (called by the producer before its first write).
+    bool open(size_t capacity, uint32_t idle_timeout_ms);
+
+    // Consumer side: stop accepting writes and free the storage.
+    void close();
+
+    // Producer side. Never blocks; returns bytes accepted, a short count means
+    // the ring is closed or full.
+    size_t write(const uint8_t* data, size_t len);
+
+    // Free bytes in the ring (0 when closed).
+    size_t spaceAvailable();
+
+    // Producer side: no more data will follow.
+    void finish();
+
+    // Consumer side. Blocks until n bytes arrived, the producer finished, or no
+    // byte arrived for idle_timeout_ms.
+    size_t read(uint8_t* dst, size_t n);
+
+    // Optional hook run around blocking waits in read() (waiting=true before,
+    // false after). Lets the consumer drop locks while the network catches up.
+    void setWaitHook(void (*fn)(bool waiting, void* ctx), void* ctx) { wait_hook = fn; wait_hook_ctx = ctx; }
+
+    bool isOpen() const { return __atomic_load_n(&accepting, __ATOMIC_ACQUIRE); }
+    bool timedOut() const { return timed_out; }
+
+    uint32_t bytesIn() const { return __atomic_load_n(&bytes_in, __ATOMIC_RELAXED); }
+    uint32_t bytesOut() const { return bytes_out; }
+
+    // ImageStreamReadFn adapter (ctx = ImageStreamRing*).
+    static size_t readFn(void* ctx, uint8_t* dst, size_t n);
+
+private:
+    size_t receive(uint8_t* dst, size_t n, TickType_t wait);
+
+    StreamBufferHandle_t handle = nullptr;
+    StaticStreamBuffer_t handle_storage;
+    uint8_t* storage = nullptr;
+
+    bool accepting = false;
+    bool finished = false;
+    uint32_t writers = 0;
+    bool timed_out = false;
+    uint32_t idle_timeout_ms = 0;
+
+    uint32_t bytes_in = 0;
+    uint32_t bytes_out = 0;
+
+    void (*wait_hook)(bool waiting, void* ctx) = nullptr;
+    void* wait_hook_ctx = nullptr;
+};
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,92 @@
+/*
+ * Image Tile Batches Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "image_tiles.h"
+#include "jpeg_preflight.h"
+#include "rgb565_codec.h"
+#include <stdio.h>
+
+static uint16_t read_u16le(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool image_tiles_next(const uint8_t* buf, size_t len, size_t* pos, ImageTile* out, char* err, size_t err_sz) {
+    if (err && err_sz) err[0] = '\0';
+    if (!buf || !pos || !out || *pos >= len) return false;
+
+    if (len - *pos < IMAGE_TILE_HEADER_BYTES) {
+        snprintf(err, err_sz, "Truncated tile header at byte %u", (unsigned)*pos);
+        return false;
+    }
+
+    const uint8_t* h = buf + *pos;
+    out->x = read_u16le(h + 0);
+    out->y = read_u16le(h + 2);
+    out->w = read_u16le(h + 4);
+    out->h = read_u16le(h + 6);
+    out->encoding = h[8];
+    out->big_endian = (h[9] & IMAGE_TILE_FLAG_LITTLE_ENDIAN) == 0;
+    out->size = read_u32le(h + 10);
+
+    const size_t body = *pos + IMAGE_TILE_HEADER_BYTES;
+    if (out->size == 0 || out->size > len - body) {
+        snprintf(err, err_sz, "Tile payload out of bounds at byte %u", (unsigned)*pos);
+        return false;
+    }
+
+    out->data = buf + body;
+    *pos = body + out->size;
+    return true;
+}
+
+int image_tiles_validate(const uint8_t* buf, size_t len, int lcd_width, int lcd_height, size_t max_tile_bytes, char* err, size_t err_sz) {
+    size_t pos = 0;
+    int count = 0;
+    ImageTile tile;
+
+    while (image_tiles_next(buf, len, &pos, &tile, err, err_sz)) {
+        if (tile.w <= 0 || tile.h <= 0 || tile.x + tile.w > lcd_width || tile.y + tile.h > lcd_height) {
+            snprintf(err, err_sz, "Tile %d outside the display", count);
+            return -1;
+        }
+
+        const size_t pixel_bytes = (size_t)tile.w * (size_t)tile.h * 2;
+        if (tile.encoding == IMAGE_TILE_ENCODING_JPEG) {
+            if (tile.size < 4 || tile.data[0] != 0xFF || tile.data[1] != 0xD8) {
+                snprintf(err, err_sz, "Tile %d is not a JPEG", count);
+                return -1;
+            }
+            if (!jpeg_preflight_tjpgd_fragment_supported(tile.data, tile.size, tile.w, tile.h, lcd_height, err, err_sz)) {
+                return -1;
+            }
+        } else if (tile.encoding > RGB565_ENCODING_LZ4) {
+            snprintf(err, err_sz, "Tile %d has unknown encoding %u", count, (unsigned)tile.encoding);
+            return -1;
+        } else if (pixel_bytes > max_tile_bytes) {
+            snprintf(err, err_sz, "Tile %d too large", count);
+            return -1;
+        } else if (tile.encoding == RGB565_ENCODING_RAW && tile.size != pixel_bytes) {
+            snprintf(err, err_sz, "Tile %d size must be w*h*2", count);
+            return -1;
+        }
+        count++;
+    }
+
+    if (err && err[0]) return -1;
+    if (count == 0) {
+        snprintf(err, err_sz, "No tiles");
+        return -1;
+    }
+    return count;
+}
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,49 @@
+/*
+ * Image Tile Batches
+ *
+ * Wire format for /api/display/image/tiles: a list of changed rectangles
+ * drawn onto the image already on the direct image screen. Each record is
+ * a 14-byte little-endian header followed by its payload:
+ *
+ *   u16 x, u16 y, u16 w, u16 h   rectangle in display coordinates
+ *   u8  encoding                 0 = raw RGB565, 1 = RLE, 2 = LZ4, 3 = JPEG
+ *   u8  flags                    bit 0: RGB565 payload is little-endian
+ *   u32 size                     payload bytes
+ *
+ * RGB565 encodings are described in rgb565_codec.h. A JPEG tile is a
+ * baseline JPEG of exactly w x h pixels.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+static constexpr size_t IMAGE_TILE_HEADER_BYTES = 14;
+static constexpr uint8_t IMAGE_TILE_ENCODING_JPEG = 3;
+static constexpr uint8_t IMAGE_TILE_FLAG_LITTLE_ENDIAN = 0x01;
+
+struct ImageTile {
+    int x;
+    int y;
+    int w;
+    int h;
+    uint8_t encoding;  // Rgb565Encoding value, or IMAGE_TILE_ENCODING_JPEG
+    bool big_endian;
+    const uint8_t* data;
+    size_t size;
+};
+
+// Read the tile record at *pos and advance past it.
+// Returns false at the end of the batch (err empty) or on a malformed record (err set).
+bool image_tiles_next(const uint8_t* buf, size_t len, size_t* pos, ImageTile* out, char* err, size_t err_sz);
+
+// Walk a whole batch and check every tile header against the panel.
+// Returns the tile count, or -1 with a message in err.
+int image_tiles_validate(const uint8_t* buf, size_t len, int lcd_width, int lcd_height, size_t max_tile_bytes, char* err, size_t err_sz);
+
+#endif // HAS_IMAGE_API
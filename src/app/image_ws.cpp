@@ -0,0 +1,49 @@
+/*
+ * Image WebSocket Channel Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "image_ws.h"
+
+static uint16_t read_u16le(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool image_ws_parse_header(const uint8_t* buf, size_t len, ImageWsHeader* out) {
+    if (!buf || !out || len < IMAGE_WS_HEADER_BYTES) return false;
+
+    out->type = buf[0];
+    out->flags = buf[1];
+    out->seq = read_u16le(buf + 2);
+    out->a = read_u16le(buf + 4);
+    out->b = read_u16le(buf + 6);
+    out->w = read_u16le(buf + 8);
+    out->h = read_u16le(buf + 10);
+    out->encoding = buf[12];
+    out->timeout_s = read_u16le(buf + 14);
+    return true;
+}
+
+void image_ws_pack_ack(uint8_t* out, uint16_t seq, uint8_t status, uint8_t free_slots) {
+    out[0] = (uint8_t)(seq & 0xFF);
+    out[1] = (uint8_t)(seq >> 8);
+    out[2] = status;
+    out[3] = free_slots;
+}
+
+const char* image_ws_status_name(uint8_t status) {
+    switch (status) {
+        case IMAGE_WS_OK: return "ok";
+        case IMAGE_WS_BUSY: return "busy";
+        case IMAGE_WS_BAD_REQUEST: return "bad request";
+        case IMAGE_WS_TOO_LARGE: return "too large";
+        case IMAGE_WS_NO_MEMORY: return "no memory";
+        case IMAGE_WS_UNSUPPORTED: return "unsupported";
+        default: return "unknown";
+    }
+}
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,79 @@
+/*
+ * Image WebSocket Channel
+ *
+ * Wire format for /api/display/ws: one binary WebSocket message per JPEG
+ * strip, RGB565 rectangle or tile batch, so a live dashboard keeps a single
+ * connection instead of one HTTP POST per strip. Each message is a 16-byte
+ * little-endian header followed by its payload:
+ *
+ *   u8  type       1 = JPEG strip, 2 = RGB565 rectangle, 3 = tile batch
+ *   u8  flags      bit 0: RGB565 payload is little-endian
+ *                  bit 1: rectangle starts a new image
+ *   u16 seq        echoed in the ack
+ *   u16 a, b       strip: strip_index, strip_count; rectangle: x, y
+ *   u16 w, h       strip: full image size; rectangle: its size
+ *   u8  encoding   rectangle: 0 = raw, 1 = RLE, 2 = LZ4 (see rgb565_codec.h)
+ *   u8  reserved
+ *   u16 timeout    seconds; 0 = default (strips) or keep the current one
+ *
+ * A whole JPEG frame is a strip message with strip_count 1. A tile batch
+ * payload is the /api/display/image/tiles body (image_tiles.h).
+ *
+ * Each message is answered with a 4-byte binary ack once it is queued or
+ * rejected:
+ *
+ *   u16 seq, u8 status (ImageWsStatus), u8 free strip queue slots
+ *
+ * Clients keep at most "free slots" messages in flight and resend on BUSY.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+static constexpr size_t IMAGE_WS_HEADER_BYTES = 16;
+static constexpr size_t IMAGE_WS_ACK_BYTES = 4;
+static constexpr uint8_t IMAGE_WS_FLAG_LITTLE_ENDIAN = 0x01;
+static constexpr uint8_t IMAGE_WS_FLAG_FIRST = 0x02;
+
+enum ImageWsType : uint8_t {
+    IMAGE_WS_STRIP = 1,
+    IMAGE_WS_RECT = 2,
+    IMAGE_WS_TILES = 3,
+};
+
+enum ImageWsStatus : uint8_t {
+    IMAGE_WS_OK = 0,
+    IMAGE_WS_BUSY,         // queue full or another upload running: resend later
+    IMAGE_WS_BAD_REQUEST,  // malformed header or payload
+    IMAGE_WS_TOO_LARGE,
+    IMAGE_WS_NO_MEMORY,
+    IMAGE_WS_UNSUPPORTED,  // message type not available on this build/backend
+};
+
+struct ImageWsHeader {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t seq;
+    uint16_t a;
+    uint16_t b;
+    uint16_t w;
+    uint16_t h;
+    uint8_t encoding;
+    uint16_t timeout_s;
+};
+
+// Decode the header at the start of a message (len >= IMAGE_WS_HEADER_BYTES).
+bool image_ws_parse_header(const uint8_t* buf, size_t len, ImageWsHeader* out);
+
+// Encode an ack into out[IMAGE_WS_ACK_BYTES].
+void image_ws_pack_ack(uint8_t* out, uint16_t seq, uint8_t status, uint8_t free_slots);
+
+const char* image_ws_status_name(uint8_t status);
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,210 @@
+/*
+ * JPEG Decoder Engines Implementation
+ *
+ * TJpgDec (ROM) engine and the engine factory. JPEGDEC and the hardware
+ * codec live in jpeg_engine_jpegdec.cpp / jpeg_engine_hw.cpp.
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "jpeg_engine.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
+#include "image_profile.h"
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+// Use the ESP-ROM TJpgDec types/signatures. This matches the ROM-provided jd_prepare/jd_decomp
+// symbols used by the ESP32 Arduino core.
+//
+// Note: not all Arduino-ESP32 installs ship headers for every ESP32-family target.
+// We select based on the IDF target macro when available, and fall back to
+// __has_include for toolchains that don't define CONFIG_IDF_TARGET_*.
+#if defined(CONFIG_IDF_TARGET_ESP32)
+    #include <esp32/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32S2)
+    #if __has_include(<esp32s2/rom/tjpgd.h>)
+        #include <esp32s2/rom/tjpgd.h>
+    #else
+        #error "Missing <esp32s2/rom/tjpgd.h> in this Arduino-ESP32 install"
+    #endif
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+    #include <esp32s3/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32C2)
+    #if __has_include(<esp32c2/rom/tjpgd.h>)
+        #include <esp32c2/rom/tjpgd.h>
+    #else
+        #error "Missing <esp32c2/rom/tjpgd.h> in this Arduino-ESP32 install"
+    #endif
+#elif defined(CONFIG_IDF_TARGET_ESP32C3)
+    #include <esp32c3/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32C5)
+    #include <esp32c5/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32C6)
+    #include <esp32c6/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32H2)
+    #if __has_include(<esp32h2/rom/tjpgd.h>)
+        #include <esp32h2/rom/tjpgd.h>
+    #else
+        #error "Missing <esp32h2/rom/tjpgd.h> in this Arduino-ESP32 install"
+    #endif
+#elif defined(CONFIG_IDF_TARGET_ESP32P4)
+    #if __has_include(<esp32p4/rom/tjpgd.h>)
+        #include <esp32p4/rom/tjpgd.h>
+    #else
+        #error "Missing <esp32p4/rom/tjpgd.h> in this Arduino-ESP32 install"
+    #endif
+#else
+    // Fallback for unknown targets - try common variants
+    #if __has_include(<esp32/rom/tjpgd.h>)
+        #include <esp32/rom/tjpgd.h>
+    #elif __has_include(<esp32s3/rom/tjpgd.h>)
+        #include <esp32s3/rom/tjpgd.h>
+    #elif __has_include(<esp32c6/rom/tjpgd.h>)
+        #include <esp32c6/rom/tjpgd.h>
+    #elif __has_include(<esp32c5/rom/tjpgd.h>)
+        #include <esp32c5/rom/tjpgd.h>
+    #elif __has_include(<esp32c3/rom/tjpgd.h>)
+        #include <esp32c3/rom/tjpgd.h>
+    #elif __has_include(<esp32s2/rom/tjpgd.h>)
+        #include <esp32s2/rom/tjpgd.h>
+    #elif __has_include(<esp32c2/rom/tjpgd.h>)
+        #include <esp32c2/rom/tjpgd.h>
+    #elif __has_include(<esp32h2/rom/tjpgd.h>)
+        #include <esp32h2/rom/tjpgd.h>
+    #elif __has_include(<esp32p4/rom/tjpgd.h>)
+        #include <esp32p4/rom/tjpgd.h>
+    #else
+        #error "Unsupported ESP32 target for TJpgDec (no ROM tjpgd.h found)"
+    #endif
+#endif
+
+size_t jpeg_engine_read(JpegEngineInput* in, uint8_t* buf, size_t n) {
+    if (in->read) {
+        // buf == nullptr asks to skip bytes; the source handles that too.
+        const uint32_t t0 = image_profile_now_us();
+        const size_t got = in->read(in->read_ctx, buf, n);
+        in->read_us += image_profile_now_us() - t0;
+        in->pos += got;
+        return got;
+    }
+    if (!in->data || in->pos >= in->size) return 0;
+
+    const size_t remaining = in->size - in->pos;
+    const size_t to_read = (n < remaining) ? n : remaining;
+    if (buf && to_read > 0) {
+        memcpy(buf, in->data + in->pos, to_read);
+    }
+    in->pos += to_read;
+    return to_read;
+}
+
+// TJpgDec work area (recommended minimum).
+static constexpr size_t TJPGD_WORK_BUFFER_SIZE = 4096;
+
+class TjpgdEngine : public JpegEngine {
+public:
+    const char* name() const override { return jpeg_engine_name(JPEG_DECODER_TJPGD_ROM); }
+    uint8_t caps() const override { return JPEG_ENGINE_STREAM | JPEG_ENGINE_SCALE; }
+
+    bool prepare(JpegEngineInput* input, uint16_t* width, uint16_t* height, char* err, size_t err_sz) override {
+        in = input;
+        const JRESULT res = jd_prepare(&jd, input_func, work, (UINT)sizeof(work), this);
+        if (res != JDR_OK) {
+            snprintf(err, err_sz, "jd_prepare failed (%d)", (int)res);
+            return false;
+        }
+        *width = jd.width;
+        *height = jd.height;
+        return true;
+    }
+
+    bool decode(uint8_t scale, bool big_endian, JpegBlockFn block_fn, void* block_ctx, char* err, size_t err_sz) override {
+        (void)big_endian;  // RGB888 out; the caller packs
+        fn = block_fn;
+        ctx = block_ctx;
+        const JRESULT res = jd_decomp(&jd, output_func, scale);
+        if (res != JDR_OK) {
+            snprintf(err, err_sz, "jd_decomp failed (%d)", (int)res);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // Signatures must match ROM: UINT (*)(JDEC*, BYTE*, UINT) / UINT (*)(JDEC*, void*, JRECT*)
+    static UINT input_func(JDEC* jd, BYTE* buff, UINT nbyte) {
+        TjpgdEngine* self = (TjpgdEngine*)jd->device;
+        return (UINT)jpeg_engine_read(self->in, buff, (size_t)nbyte);
+    }
+
+    static UINT output_func(JDEC* jd, void* bitmap, JRECT* rect) {
+        TjpgdEngine* self = (TjpgdEngine*)jd->device;
+        JpegBlock block;
+        block.x = rect->left;
+        block.y = rect->top;
+        block.w = rect->right - rect->left + 1;
+        block.h = rect->bottom - rect->top + 1;
+        block.stride = block.w;
+        block.format = JpegPixels::Rgb888;
+        block.pixels = bitmap;
+        return self->fn(self->ctx, block) ? 1 : 0;
+    }
+
+    JDEC jd;
+    JpegEngineInput* in = nullptr;
+    JpegBlockFn fn = nullptr;
+    void* ctx = nullptr;
+    uint8_t work[TJPGD_WORK_BUFFER_SIZE] __attribute__((aligned(4)));
+};
+
+#if JPEG_DECODER == JPEG_DECODER_JPEGDEC
+JpegEngine* jpeg_engine_jpegdec_create();
+#endif
+#if JPEG_DECODER == JPEG_DECODER_ESP_HW
+JpegEngine* jpeg_engine_hw_create();
+#endif
+
+JpegEngine* jpeg_engine_create(uint8_t id) {
+    if (id == JPEG_DECODER_TJPGD_ROM) {
+        // Transient: a decode session's worth; PSRAM where the board allows.
+        void* mem = heap_place_malloc(HeapClass::Transient, HeapTag::Image, sizeof(TjpgdEngine));
+        return mem ? new (mem) TjpgdEngine() : nullptr;
+    }
+#if JPEG_DECODER == JPEG_DECODER_JPEGDEC
+    if (id == JPEG_DECODER_JPEGDEC) return jpeg_engine_jpegdec_create();
+#endif
+#if JPEG_DECODER == JPEG_DECODER_ESP_HW
+    if (id == JPEG_DECODER_ESP_HW) return jpeg_engine_hw_create();
+#endif
+    return nullptr;
+}
+
+void jpeg_engine_destroy(JpegEngine* engine) {
+    if (!engine) return;
+    engine->~JpegEngine();
+    heap_tag_free(HeapTag::Image, engine);
+}
+
+const char* jpeg_engine_name(uint8_t id) {
+    switch (id) {
+        case JPEG_DECODER_TJPGD_ROM: return "tjpgd_rom";
+        case JPEG_DECODER_JPEGDEC: return "jpegdec";
+        case JPEG_DECODER_ESP_HW: return "esp_hw";
+        default: return "?";
+    }
+}
+
+bool jpeg_engine_can(const JpegEngine* engine, bool stream, uint8_t scale) {
+    if (!engine) return false;
+    const uint8_t caps = engine->caps();
+    if (stream && !(caps & JPEG_ENGINE_STREAM)) return false;
+    if (scale > 0 && !(caps & JPEG_ENGINE_SCALE)) return false;
+    return true;
+}
+
+#endif // HAS_IMAGE_API
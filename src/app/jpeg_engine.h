@@ -0,0 +1,100 @@
+/*
+ * JPEG Decoder Engines
+ *
+ * One interface over the JPEG decoders a board can be built with. StripDecoder
+ * and the LVGL image decoder go through it; JPEG_DECODER in board_overrides.h
+ * picks the engine (see board_config.h):
+ *
+ *   JPEG_DECODER_TJPGD_ROM  TJpgDec in ROM. Every target, 4 KB work area,
+ *                           RGB888 blocks that the caller packs to RGB565.
+ *   JPEG_DECODER_JPEGDEC    JPEGDEC library (bitbank2). RGB565 blocks in the
+ *                           caller's byte order, S3 SIMD IDCT and colour
+ *                           conversion; about 20 KB per decoder.
+ *   JPEG_DECODER_ESP_HW     Hardware JPEG codec (ESP32-P4). Buffered input
+ *                           only, no scaling; decodes the whole frame into
+ *                           DMA memory and hands it out in bands.
+ *
+ * An engine that cannot do a job (a stream, a scaled decode, BGR565 output)
+ * leaves it to TJpgDec, which is always built in. The dual-core splitter
+ * (jpeg_parallel) stays on TJpgDec.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "image_stream.h"
+
+// Where the compressed bytes come from: a buffer, or a stream when read is set.
+struct JpegEngineInput {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    ImageStreamReadFn read = nullptr;
+    void* read_ctx = nullptr;
+    size_t pos = 0;        // bytes consumed
+    uint32_t read_us = 0;  // time spent waiting on a stream
+};
+
+// Copy (or with buf == nullptr, skip) up to n bytes from in; returns the count.
+size_t jpeg_engine_read(JpegEngineInput* in, uint8_t* buf, size_t n);
+
+enum class JpegPixels : uint8_t {
+    Rgb888,  // 3 bytes per pixel, R first
+    Rgb565,  // in the byte order decode() was asked for
+};
+
+// One decoded rectangle of the output image; stride is in pixels.
+struct JpegBlock {
+    int x;
+    int y;
+    int w;
+    int h;
+    int stride;
+    JpegPixels format;
+    const void* pixels;
+};
+
+// Called for each block in decode order; false aborts the decode.
+typedef bool (*JpegBlockFn)(void* ctx, const JpegBlock& block);
+
+// JpegEngine::caps() bits.
+enum : uint8_t {
+    JPEG_ENGINE_STREAM = 1 << 0,  // decodes from a read callback
+    JPEG_ENGINE_SCALE = 1 << 1,   // 1/2, 1/4 and 1/8 output
+    JPEG_ENGINE_RGB565 = 1 << 2,  // emits RGB565 blocks (else RGB888)
+};
+
+class JpegEngine {
+public:
+    virtual ~JpegEngine() {}
+
+    virtual const char* name() const = 0;
+    virtual uint8_t caps() const = 0;
+
+    // Parse the header. input is read from until decode() returns and must
+    // stay valid until then.
+    virtual bool prepare(JpegEngineInput* input, uint16_t* width, uint16_t* height, char* err, size_t err_sz) = 0;
+
+    // Decode the prepared image at 1/2^scale (scale 0..3). big_endian is the
+    // byte order of RGB565 blocks (MSB first when true).
+    virtual bool decode(uint8_t scale, bool big_endian, JpegBlockFn fn, void* ctx, char* err, size_t err_sz) = 0;
+};
+
+// Engine id (one of the JPEG_DECODER_* constants) -> a new engine, or
+// nullptr when it is not built in or out of memory. Engines are not
+// thread-safe; each decoding task owns its own.
+JpegEngine* jpeg_engine_create(uint8_t id);
+void jpeg_engine_destroy(JpegEngine* engine);
+
+// "tjpgd_rom", "jpegdec", "esp_hw" (for stats and the bench).
+const char* jpeg_engine_name(uint8_t id);
+
+// Whether engine can take this job: a stream, and/or output scaled down.
+bool jpeg_engine_can(const JpegEngine* engine, bool stream, uint8_t scale);
+
+#endif // HAS_IMAGE_API
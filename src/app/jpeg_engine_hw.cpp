@@ -0,0 +1,147 @@
+/*
+ * Hardware JPEG Engine (JPEG_DECODER_ESP_HW)
+ *
+ * The ESP32-P4 JPEG codec. It decodes a whole buffered frame into DMA
+ * memory in one call, so streams and scaled decodes stay on TJpgDec; the
+ * frame is handed to the caller in bands of 16 rows.
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API && JPEG_DECODER == JPEG_DECODER_ESP_HW
+
+#include <soc/soc_caps.h>
+
+#if !SOC_JPEG_CODEC_SUPPORTED || !__has_include(<driver/jpeg_decode.h>)
+#error "JPEG_DECODER_ESP_HW needs a target with the JPEG codec (ESP32-P4) and IDF 5.2+"
+#endif
+
+#include "jpeg_engine.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
+
+#include <driver/jpeg_decode.h>
+#include <esp_heap_caps.h>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+static constexpr int kBandRows = 16;
+static constexpr int kTimeoutMs = 100;
+
+class HwJpegEngine : public JpegEngine {
+public:
+    ~HwJpegEngine() override {
+        if (engine) jpeg_del_decoder_engine(engine);
+    }
+
+    bool init() {
+        jpeg_decode_engine_cfg_t cfg = {};
+        cfg.intr_priority = 0;
+        cfg.timeout_ms = kTimeoutMs;
+        return jpeg_new_decoder_engine(&cfg, &engine) == ESP_OK;
+    }
+
+    const char* name() const override { return jpeg_engine_name(JPEG_DECODER_ESP_HW); }
+    uint8_t caps() const override { return JPEG_ENGINE_RGB565; }
+
+    bool prepare(JpegEngineInput* input, uint16_t* width, uint16_t* height, char* err, size_t err_sz) override {
+        in = input;
+        if (input->read || !input->data) {
+            snprintf(err, err_sz, "Hardware JPEG needs a buffered image");
+            return false;
+        }
+        jpeg_decode_picture_info_t info = {};
+        if (jpeg_decoder_get_info(input->data, (uint32_t)input->size, &info) != ESP_OK) {
+            snprintf(err, err_sz, "Hardware JPEG: bad header");
+            return false;
+        }
+        src_w = (int)info.width;
+        src_h = (int)info.height;
+        *width = (uint16_t)src_w;
+        *height = (uint16_t)src_h;
+        return true;
+    }
+
+    bool decode(uint8_t scale, bool big_endian, JpegBlockFn fn, void* ctx, char* err, size_t err_sz) override {
+        if (scale != 0) {
+            snprintf(err, err_sz, "Hardware JPEG cannot scale");
+            return false;
+        }
+
+        // The codec writes whole MCUs: rows padded to 16 pixels.
+        const int pad_w = (src_w + 15) & ~15;
+        const int pad_h = (src_h + 15) & ~15;
+        jpeg_decode_memory_alloc_cfg_t in_cfg = {};
+        in_cfg.buffer_direction = JPEG_DEC_ALLOC_INPUT_BUFFER;
+        jpeg_decode_memory_alloc_cfg_t out_cfg = {};
+        out_cfg.buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER;
+        size_t in_cap = 0;
+        size_t out_cap = 0;
+        uint8_t* src = (uint8_t*)jpeg_alloc_decoder_mem(in->size, &in_cfg, &in_cap);
+        uint8_t* out = (uint8_t*)jpeg_alloc_decoder_mem((size_t)pad_w * (size_t)pad_h * 2, &out_cfg, &out_cap);
+        if (!src || !out) {
+            if (src) heap_caps_free(src);
+            if (out) heap_caps_free(out);
+            snprintf(err, err_sz, "Hardware JPEG: out of DMA memory");
+            return false;
+        }
+        memcpy(src, in->data, in->size);
+        in->pos = in->size;
+
+        jpeg_decode_cfg_t cfg = {};
+        cfg.output_format = JPEG_DECODE_OUT_FORMAT_RGB565;
+        cfg.rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR;  // native little-endian RGB565
+        cfg.conv_std = JPEG_YUV_RGB_CONV_STD_BT601;
+        uint32_t out_size = 0;
+        const esp_err_t res = jpeg_decoder_process(engine, &cfg, src, (uint32_t)in->size, out, (uint32_t)out_cap, &out_size);
+        heap_caps_free(src);
+        if (res != ESP_OK) {
+            heap_caps_free(out);
+            snprintf(err, err_sz, "Hardware JPEG decode failed (%s)", esp_err_to_name(res));
+            return false;
+        }
+
+        bool ok = true;
+        uint16_t* pixels = (uint16_t*)out;
+        for (int y = 0; ok && y < src_h; y += kBandRows) {
+            const int rows = (src_h - y < kBandRows) ? (src_h - y) : kBandRows;
+            uint16_t* band = pixels + (size_t)y * (size_t)pad_w;
+            if (big_endian) {
+                const size_t n = (size_t)pad_w * (size_t)rows;
+                for (size_t i = 0; i < n; i++) band[i] = (uint16_t)((band[i] >> 8) | (band[i] << 8));
+            }
+            JpegBlock block;
+            block.x = 0;
+            block.y = y;
+            block.w = src_w;
+            block.h = rows;
+            block.stride = pad_w;
+            block.format = JpegPixels::Rgb565;
+            block.pixels = band;
+            ok = fn(ctx, block);
+        }
+        heap_caps_free(out);
+        if (!ok) snprintf(err, err_sz, "Output aborted");
+        return ok;
+    }
+
+private:
+    jpeg_decoder_handle_t engine = nullptr;
+    JpegEngineInput* in = nullptr;
+    int src_w = 0;
+    int src_h = 0;
+};
+
+JpegEngine* jpeg_engine_hw_create() {
+    void* mem = heap_place_malloc(HeapClass::Transient, HeapTag::Image, sizeof(HwJpegEngine));
+    if (!mem) return nullptr;
+    HwJpegEngine* engine = new (mem) HwJpegEngine();
+    if (!engine->init()) {
+        jpeg_engine_destroy(engine);
+        return nullptr;
+    }
+    return engine;
+}
+
+#endif // HAS_IMAGE_API && JPEG_DECODER == JPEG_DECODER_ESP_HW
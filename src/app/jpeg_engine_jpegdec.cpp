@@ -0,0 +1,127 @@
+/*
+ * JPEGDEC Engine (JPEG_DECODER_JPEGDEC)
+ *
+ * bitbank2's JPEGDEC: RGB565 straight out of the colour conversion (no
+ * RGB888 pass), with the ESP32-S3 SIMD kernels when built for the S3.
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API && JPEG_DECODER == JPEG_DECODER_JPEGDEC
+
+#if !__has_include(<JPEGDEC.h>)
+#error "JPEG_DECODER_JPEGDEC needs the JPEGDEC library (see arduino-libraries.txt)"
+#endif
+
+#include "jpeg_engine.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
+
+#include <JPEGDEC.h>
+#include <new>
+#include <stdio.h>
+
+class JpegdecEngine : public JpegEngine {
+public:
+    const char* name() const override { return jpeg_engine_name(JPEG_DECODER_JPEGDEC); }
+    uint8_t caps() const override { return JPEG_ENGINE_STREAM | JPEG_ENGINE_SCALE | JPEG_ENGINE_RGB565; }
+
+    bool prepare(JpegEngineInput* input, uint16_t* width, uint16_t* height, char* err, size_t err_sz) override {
+        in = input;
+        // Streams have no known size; JPEGDEC stops at EOI or when reads come back empty.
+        const int size = input->read ? 0x7FFFFFFF : (int)input->size;
+        if (!dec.open((void*)this, size, close_cb, read_cb, seek_cb, draw_cb)) {
+            snprintf(err, err_sz, "JPEGDEC open failed (%d)", dec.getLastError());
+            return false;
+        }
+        dec.setUserPointer(this);
+        src_w = dec.getWidth();
+        src_h = dec.getHeight();
+        *width = (uint16_t)src_w;
+        *height = (uint16_t)src_h;
+        return true;
+    }
+
+    bool decode(uint8_t scale, bool big_endian, JpegBlockFn block_fn, void* block_ctx, char* err, size_t err_sz) override {
+        static const int kScaleOption[4] = {0, JPEG_SCALE_HALF, JPEG_SCALE_QUARTER, JPEG_SCALE_EIGHTH};
+        if (scale > 3) scale = 3;
+        fn = block_fn;
+        ctx = block_ctx;
+        const int div = 1 << scale;
+        out_w = (src_w + div - 1) / div;
+        out_h = (src_h + div - 1) / div;
+
+        dec.setPixelType(big_endian ? RGB565_BIG_ENDIAN : RGB565_LITTLE_ENDIAN);
+        const int ok = dec.decode(0, 0, kScaleOption[scale]);
+        const int last = dec.getLastError();
+        dec.close();
+        if (!ok) {
+            snprintf(err, err_sz, "JPEGDEC decode failed (%d)", last);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static int32_t read_cb(JPEGFILE* file, uint8_t* buf, int32_t len) {
+        JpegdecEngine* self = (JpegdecEngine*)file->fHandle;
+        const size_t got = jpeg_engine_read(self->in, buf, len > 0 ? (size_t)len : 0);
+        file->iPos = (int32_t)self->in->pos;
+        return (int32_t)got;
+    }
+
+    // JPEGDEC only seeks to where it already is or forward (EXIF thumbnails),
+    // which a stream can do by skipping.
+    static int32_t seek_cb(JPEGFILE* file, int32_t position) {
+        JpegdecEngine* self = (JpegdecEngine*)file->fHandle;
+        JpegEngineInput* in = self->in;
+        if (position < 0) return -1;
+        if ((size_t)position >= in->pos) {
+            jpeg_engine_read(in, nullptr, (size_t)position - in->pos);
+        } else if (!in->read) {
+            in->pos = (size_t)position;
+        } else {
+            return -1;
+        }
+        file->iPos = (int32_t)in->pos;
+        return file->iPos;
+    }
+
+    static void close_cb(void* handle) {
+        (void)handle;
+    }
+
+    static int draw_cb(JPEGDRAW* draw) {
+        JpegdecEngine* self = (JpegdecEngine*)draw->pUser;
+        // Blocks are whole MCUs; clip the padding past the right and bottom edges.
+        JpegBlock block;
+        block.x = draw->x;
+        block.y = draw->y;
+        block.w = draw->iWidth;
+        block.h = draw->iHeight;
+        if (block.x + block.w > self->out_w) block.w = self->out_w - block.x;
+        if (block.y + block.h > self->out_h) block.h = self->out_h - block.y;
+        if (block.w <= 0 || block.h <= 0) return 1;
+        block.stride = draw->iWidth;
+        block.format = JpegPixels::Rgb565;
+        block.pixels = draw->pPixels;
+        return self->fn(self->ctx, block) ? 1 : 0;
+    }
+
+    JPEGDEC dec;
+    JpegEngineInput* in = nullptr;
+    JpegBlockFn fn = nullptr;
+    void* ctx = nullptr;
+    int src_w = 0;
+    int src_h = 0;
+    int out_w = 0;
+    int out_h = 0;
+};
+
+JpegEngine* jpeg_engine_jpegdec_create() {
+    // ~20 KB of decoder state: PSRAM where the board allows.
+    void* mem = heap_place_malloc(HeapClass::Transient, HeapTag::Image, sizeof(JpegdecEngine));
+    return mem ? new (mem) JpegdecEngine() : nullptr;
+}
+
+#endif // HAS_IMAGE_API && JPEG_DECODER == JPEG_DECODER_JPEGDEC
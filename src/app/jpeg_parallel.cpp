@@ -0,0 +1,429 @@
+/*
+ * Parallel JPEG Decode Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "heap_tags.h"
+#include "jpeg_parallel.h"
+#include "jpeg_preflight.h"
+#include "log_manager.h"
+#include "rgb888_pack.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <soc/soc_caps.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#if IMAGE_API_PARALLEL_DECODE && !CONFIG_FREERTOS_UNICORE && SOC_SPIRAM_SUPPORTED
+
+// TJpgDec ROM header selection copied from StripDecoder for broad ESP32-family compatibility.
+#if defined(CONFIG_IDF_TARGET_ESP32)
+    #include <esp32/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32S2)
+    #if __has_include(<esp32s2/rom/tjpgd.h>)
+        #include <esp32s2/rom/tjpgd.h>
+    #else
+        #error "Missing <esp32s2/rom/tjpgd.h> in this Arduino-ESP32 install"
+    #endif
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+    #include <esp32s3/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32C2)
+    #if __has_include(<esp32c2/rom/tjpgd.h>)
+        #include <esp32c2/rom/tjpgd.h>
+    #else
+        #error "Missing <esp32c2/rom/tjpgd.h> in this Arduino-ESP32 install"
+    #endif
+#elif defined(CONFIG_IDF_TARGET_ESP32C3)
+    #include <esp32c3/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32C5)
+    #include <esp32c5/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32C6)
+    #include <esp32c6/rom/tjpgd.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32H2)
+    #if __has_include(<esp32h2/rom/tjpgd.h>)
+        #include <esp32h2/rom/tjpgd.h>
+    #else
+        #error "Missing <esp32h2/rom/tjpgd.h> in this Arduino-ESP32 install"
+    #endif
+#elif defined(CONFIG_IDF_TARGET_ESP32P4)
+    #if __has_include(<esp32p4/rom/tjpgd.h>)
+        #include <esp32p4/rom/tjpgd.h>
+    #else
+        #error "Missing <esp32p4/rom/tjpgd.h> in this Arduino-ESP32 install"
+    #endif
+#else
+    // Fall back to generic include if present.
+    #if __has_include(<rom/tjpgd.h>)
+        #include <rom/tjpgd.h>
+    #else
+        #error "Missing TJpgDec ROM header (tjpgd.h)"
+    #endif
+#endif
+
+static constexpr size_t WORK_BUFFER_SIZE = 4096;
+static constexpr uint32_t HELPER_STACK_BYTES = 4096;
+
+// Where the header ends and how the scan is cut into restart intervals.
+struct JpegLayout {
+    size_t height_pos = 0;      // offset of the SOF0 height field
+    size_t scan_pos = 0;        // first entropy-coded byte (after SOS)
+    int mcu_h = 0;
+    int rows_per_interval = 0;  // MCU rows per restart interval
+    int intervals = 0;
+};
+
+// One half of the image as a standalone JPEG: the original header (height
+// patched), a run of restart intervals (RSTn renumbered from 0) and an EOI.
+struct SliceSource {
+    const uint8_t* jpeg = nullptr;
+    size_t header_len = 0;
+    size_t height_pos = 0;
+    uint8_t height_be[2] = {0, 0};
+    size_t data_start = 0;
+    size_t data_end = 0;
+    size_t pos = 0;  // position in the logical stream
+
+    bool renumber = false;
+    bool prev_ff = false;
+    uint8_t rst_next = 0;
+
+    uint16_t* dst = nullptr;
+    int width = 0;
+    int y0 = 0;
+    int rows = 0;
+    Rgb888PackFn pack = nullptr;
+};
+
+static bool layout_from_header(const JpegHeader& hdr, int width, int height, JpegLayout* out) {
+    // Baseline only; SOS must be in the buffer.
+    if (!hdr.found || hdr.sof_marker != 0xC0 || hdr.scan_pos == 0) return false;
+    if (hdr.width != width || hdr.height != height || hdr.restart_interval == 0) return false;
+
+    const unsigned ri = hdr.restart_interval;
+    const int mcu_w = 8 * hdr.h_max;
+    const unsigned mcus_per_row = (unsigned)((hdr.width + mcu_w - 1) / mcu_w);
+    if (ri % mcus_per_row != 0) return false;
+
+    out->height_pos = hdr.sof_height_pos;
+    out->scan_pos = hdr.scan_pos;
+    out->mcu_h = 8 * hdr.v_max;
+    out->rows_per_interval = (int)(ri / mcus_per_row);
+    const int mcu_rows = (hdr.height + out->mcu_h - 1) / out->mcu_h;
+    out->intervals = (mcu_rows + out->rows_per_interval - 1) / out->rows_per_interval;
+    return out->intervals >= 2;
+}
+
+// Offset of the n-th (1-based) RST marker in the scan, or 0.
+static size_t find_restart(const uint8_t* d, size_t size, size_t from, int n) {
+    int seen = 0;
+    size_t j = from;
+    while (j + 1 < size) {
+        if (d[j] != 0xFF) {
+            j++;
+            continue;
+        }
+        const uint8_t next = d[j + 1];
+        if (next == 0x00) {
+            j += 2;  // stuffed byte
+        } else if (next == 0xFF) {
+            j++;  // fill
+        } else if (next >= 0xD0 && next <= 0xD7) {
+            if (++seen == n) return j;
+            j += 2;
+        } else {
+            return 0;  // EOI or another marker before the n-th restart
+        }
+    }
+    return 0;
+}
+
+static UINT slice_input(JDEC* jd, BYTE* buff, UINT nbyte) {
+    SliceSource* s = (SliceSource*)jd->device;
+    const size_t data_len = s->data_end - s->data_start;
+    const size_t total = s->header_len + data_len + 2;
+
+    UINT done = 0;
+    while (done < nbyte && s->pos < total) {
+        uint8_t b;
+        if (s->pos < s->header_len) {
+            if (s->pos == s->height_pos) b = s->height_be[0];
+            else if (s->pos == s->height_pos + 1) b = s->height_be[1];
+            else b = s->jpeg[s->pos];
+        } else if (s->pos < s->header_len + data_len) {
+            b = s->jpeg[s->data_start + (s->pos - s->header_len)];
+            if (s->renumber) {
+                // A restart may straddle two reads; track the 0xFF prefix.
+                if (s->prev_ff && b >= 0xD0 && b <= 0xD7) {
+                    b = (uint8_t)(0xD0 | (s->rst_next++ & 0x07));
+                }
+                s->prev_ff = (b == 0xFF);
+            }
+        } else {
+            b = (s->pos == total - 2) ? 0xFF : 0xD9;
+        }
+
+        if (buff) buff[done] = b;
+        done++;
+        s->pos++;
+    }
+    return done;
+}
+
+static UINT slice_output(JDEC* jd, void* bitmap, JRECT* rect) {
+    SliceSource* s = (SliceSource*)jd->device;
+    if (rect->right >= s->width || rect->bottom >= s->rows) return 0;
+
+    const uint8_t* src = (const uint8_t*)bitmap;
+    const size_t rect_w = (size_t)(rect->right - rect->left + 1);
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        uint16_t* row = s->dst + (size_t)(s->y0 + y) * (size_t)s->width + rect->left;
+        s->pack(src, row, rect_w);
+        src += rect_w * 3;
+    }
+    return 1;
+}
+
+static bool decode_slice(SliceSource* s, void* work) {
+    JDEC jd;
+    if (jd_prepare(&jd, slice_input, work, (UINT)WORK_BUFFER_SIZE, s) != JDR_OK) return false;
+    if ((int)jd.height != s->rows) return false;
+    return jd_decomp(&jd, slice_output, 0) == JDR_OK;
+}
+
+// Helper task on the other core: decodes one slice per notification.
+static TaskHandle_t helper_task = nullptr;
+static SemaphoreHandle_t helper_done = nullptr;
+static SliceSource* helper_slice = nullptr;
+static void* helper_work = nullptr;
+static volatile bool helper_ok = false;
+static volatile uint32_t helper_us = 0;
+
+static void helper_task_fn(void* arg) {
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const int64_t t0 = esp_timer_get_time();
+        helper_ok = decode_slice(helper_slice, helper_work);
+        helper_us = (uint32_t)(esp_timer_get_time() - t0);
+        xSemaphoreGive(helper_done);
+    }
+}
+
+static bool helper_start() {
+    if (helper_task) return true;
+
+    if (!helper_done) helper_done = xSemaphoreCreateBinary();
+    if (!helper_done) return false;
+
+    xTaskCreatePinnedToCore(helper_task_fn, "JpegHelper", HELPER_STACK_BYTES, nullptr,
+                            IMAGE_API_WORKER_PRIORITY, &helper_task, IMAGE_API_PARALLEL_CORE);
+    if (!helper_task) {
+        Logger.logMessage("JpegParallel", "ERROR: Helper task creation failed");
+        return false;
+    }
+    Logger.logMessagef("JpegParallel", "Helper started on core %d", (int)IMAGE_API_PARALLEL_CORE);
+    return true;
+}
+
+#if STATIC_ALLOC_MODE
+// Both work buffers live in .bss: a parallel decode allocates nothing.
+alignas(4) static uint8_t s_work[2][WORK_BUFFER_SIZE];
+
+static void* alloc_work(int k) {
+    return s_work[k];
+}
+
+static void free_work(void* p) {
+    (void)p;
+}
+#else
+static void* alloc_work(int) {
+    // TJpgDec tables are hot; keep them in internal RAM when possible.
+    void* p = heap_tag_malloc(HeapTag::Image, WORK_BUFFER_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    return p ? p : heap_tag_malloc(HeapTag::Image, WORK_BUFFER_SIZE, MALLOC_CAP_8BIT);
+}
+
+static void free_work(void* p) {
+    heap_tag_free(HeapTag::Image, p);
+}
+#endif
+
+bool jpeg_parallel_available() {
+    return psramFound();
+}
+
+bool jpeg_parallel_header_splittable(const uint8_t* data, size_t size, int width, int height) {
+    JpegHeader hdr;
+    jpeg_parse_header(data, size, &hdr);
+    return jpeg_parallel_header_splittable(hdr, width, height);
+}
+
+bool jpeg_parallel_header_splittable(const JpegHeader& header, int width, int height) {
+    JpegLayout layout;
+    return layout_from_header(header, width, height, &layout);
+}
+
+bool jpeg_parallel_decode_rgb565(
+    const uint8_t* jpeg,
+    size_t size,
+    const JpegHeader* header,
+    uint16_t* dst,
+    int width,
+    int height,
+    bool big_endian,
+    JpegParallelTiming* timing,
+    char* err,
+    size_t err_sz
+) {
+    const int64_t t0 = esp_timer_get_time();
+
+    JpegHeader parsed;
+    if (!header) {
+        jpeg_parse_header(jpeg, size, &parsed);
+        header = &parsed;
+    }
+    JpegLayout layout;
+    if (!dst || !jpeg || !layout_from_header(*header, width, height, &layout)) {
+        snprintf(err, err_sz, "No MCU-row restart intervals");
+        return false;
+    }
+
+    // Split at the restart marker closest to the middle.
+    const int split = layout.intervals / 2;
+    const size_t rst = find_restart(jpeg, size, layout.scan_pos, split);
+    if (rst == 0 || size < 2 || jpeg[size - 2] != 0xFF || jpeg[size - 1] != 0xD9) {
+        snprintf(err, err_sz, "Restart markers not found");
+        return false;
+    }
+
+    const int top_rows = split * layout.rows_per_interval * layout.mcu_h;
+    if (top_rows <= 0 || top_rows >= height) {
+        snprintf(err, err_sz, "Bad split (%d rows)", top_rows);
+        return false;
+    }
+
+    if (!helper_start()) {
+        snprintf(err, err_sz, "Helper task unavailable");
+        return false;
+    }
+
+    void* work[2] = {alloc_work(0), alloc_work(1)};
+    if (!work[0] || !work[1]) {
+        free_work(work[0]);
+        free_work(work[1]);
+        snprintf(err, err_sz, "Out of memory (work buffers)");
+        return false;
+    }
+
+    SliceSource slices[2];
+    for (int k = 0; k < 2; k++) {
+        SliceSource& s = slices[k];
+        s.jpeg = jpeg;
+        s.header_len = layout.scan_pos;
+        s.height_pos = layout.height_pos;
+        s.dst = dst;
+        s.width = width;
+        s.pack = rgb888_pack_kernel(false, big_endian);
+    }
+    slices[0].data_start = layout.scan_pos;
+    slices[0].data_end = rst;
+    slices[0].y0 = 0;
+    slices[0].rows = top_rows;
+
+    slices[1].data_start = rst + 2;
+    slices[1].data_end = size - 2;
+    slices[1].renumber = true;
+    slices[1].y0 = top_rows;
+    slices[1].rows = height - top_rows;
+
+    for (int k = 0; k < 2; k++) {
+        slices[k].height_be[0] = (uint8_t)(slices[k].rows >> 8);
+        slices[k].height_be[1] = (uint8_t)(slices[k].rows & 0xFF);
+    }
+
+    // Bottom half on the helper core, top half here.
+    helper_slice = &slices[1];
+    helper_work = work[1];
+    xSemaphoreTake(helper_done, 0);
+    xTaskNotifyGive(helper_task);
+
+    const int64_t t_top = esp_timer_get_time();
+    const bool top_ok = decode_slice(&slices[0], work[0]);
+    const uint32_t top_us = (uint32_t)(esp_timer_get_time() - t_top);
+
+    // The helper reads `slices` and the work buffer; always wait it out.
+    xSemaphoreTake(helper_done, portMAX_DELAY);
+
+    free_work(work[0]);
+    free_work(work[1]);
+
+    if (timing) {
+        timing->total_us = (uint32_t)(esp_timer_get_time() - t0);
+        timing->slice_us[0] = top_us;
+        timing->slice_us[1] = helper_us;
+        timing->intervals = (uint16_t)layout.intervals;
+    }
+
+    if (!top_ok || !helper_ok) {
+        snprintf(err, err_sz, "Slice decode failed (%s)", top_ok ? "bottom" : "top");
+        return false;
+    }
+    return true;
+}
+
+#else // single core, no PSRAM, or disabled
+
+bool jpeg_parallel_available() {
+    return false;
+}
+
+bool jpeg_parallel_header_splittable(const uint8_t* data, size_t size, int width, int height) {
+    (void)data;
+    (void)size;
+    (void)width;
+    (void)height;
+    return false;
+}
+
+bool jpeg_parallel_header_splittable(const JpegHeader& header, int width, int height) {
+    (void)header;
+    (void)width;
+    (void)height;
+    return false;
+}
+
+bool jpeg_parallel_decode_rgb565(
+    const uint8_t* jpeg,
+    size_t size,
+    const JpegHeader* header,
+    uint16_t* dst,
+    int width,
+    int height,
+    bool big_endian,
+    JpegParallelTiming* timing,
+    char* err,
+    size_t err_sz
+) {
+    (void)jpeg;
+    (void)size;
+    (void)header;
+    (void)dst;
+    (void)width;
+    (void)height;
+    (void)big_endian;
+    (void)timing;
+    snprintf(err, err_sz, "Parallel decode unavailable");
+    return false;
+}
+
+#endif // IMAGE_API_PARALLEL_DECODE && !CONFIG_FREERTOS_UNICORE && SOC_SPIRAM_SUPPORTED
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,59 @@
+/*
+ * Parallel JPEG Decode
+ *
+ * Splits a full-frame baseline JPEG at its restart markers and decodes the
+ * halves on both cores into an RGB565 buffer. Restart intervals reset the DC
+ * predictors, so each half becomes a standalone JPEG: the original header
+ * with the frame height patched, the interval data with its RSTn markers
+ * renumbered from 0, and an EOI.
+ *
+ * Only JPEGs whose restart interval is a whole number of MCU rows qualify
+ * (e.g. libjpeg/Pillow `restart_marker_rows`). Everything else keeps using
+ * the single-core StripDecoder path.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "jpeg_preflight.h"
+
+struct JpegParallelTiming {
+    uint32_t total_us;     // split + both slices
+    uint32_t slice_us[2];  // [0] caller's core, [1] helper core
+    uint16_t intervals;    // restart intervals in the image
+};
+
+// True on dual-core targets with PSRAM (the frame buffer lives there).
+bool jpeg_parallel_available();
+
+// Header-only check (SOI..SOS): width x height baseline JPEG with a restart
+// interval on MCU-row boundaries. Used on the first upload chunk.
+bool jpeg_parallel_header_splittable(const uint8_t* data, size_t size, int width, int height);
+
+// Same check on a header jpeg_parse_header() (or preflight) already read.
+bool jpeg_parallel_header_splittable(const JpegHeader& header, int width, int height);
+
+// Decode into dst (width * height RGB565, big_endian = MSB first). Blocking and
+// single-caller (the image worker); header is the parsed header of jpeg, or
+// nullptr to parse it here.
+// returns false with err set when the JPEG cannot be split (caller falls back).
+bool jpeg_parallel_decode_rgb565(
+    const uint8_t* jpeg,
+    size_t size,
+    const JpegHeader* header,
+    uint16_t* dst,
+    int width,
+    int height,
+    bool big_endian,
+    JpegParallelTiming* timing,
+    char* err,
+    size_t err_sz
+);
+
+#endif // HAS_IMAGE_API
@@ -9,19 +9,9 @@
 #include "jpeg_preflight.h"
 #include <stdio.h>
 
-struct JpegSofInfo {
-    bool found = false;
-    bool progressive = false;
-    uint16_t width = 0;
-    uint16_t height = 0;
-    uint8_t components = 0;
-    // Sampling factors (h,v) for component IDs 1(Y),2(Cb),3(Cr)
-    uint8_t y_h = 0, y_v = 0;
-    uint8_t cb_h = 0, cb_v = 0;
-    uint8_t cr_h = 0, cr_v = 0;
-};
-
-static bool jpeg_parse_sof_best_effort(const uint8_t* data, size_t size, JpegSofInfo& out) {
+bool jpeg_parse_header(const uint8_t* data, size_t size, JpegHeader* out) {
+    if (!out) return false;
+    *out = JpegHeader();
     if (!data || size < 4) return false;
     // Must start with SOI
     if (!(data[0] == 0xFF && data[1] == 0xD8)) return false;
@@ -44,55 +34,70 @@ static bool jpeg_parse_sof_best_effort(const uint8_t* data, size_t size, JpegSof
         if (marker == 0xD8 || marker == 0xD9) continue; // SOI/EOI
         if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue; // TEM / RSTn
 
-        // Start of Scan: header ends; no more metadata segments reliably parseable
-        if (marker == 0xDA) break;
-
         if (i + 1 >= size) break;
         const uint16_t seg_len = (uint16_t)((data[i] << 8) | data[i + 1]);
-        if (seg_len < 2) return false;
-        if (i + seg_len > size) return false;
+        // A damaged or cut-off segment after the SOF still leaves a usable
+        // SOF (first upload chunk); scan_pos stays 0.
+        if (seg_len < 2 || i + seg_len > size) return out->found;
+        const uint8_t* seg = data + i + 2;
 
-        // SOF0 (baseline DCT) or SOF2 (progressive DCT)
-        if (marker == 0xC0 || marker == 0xC2) {
-            out.found = true;
-            out.progressive = (marker == 0xC2);
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            // SOFn: 0xC0 baseline, 0xC2 progressive, the rest TJpgDec cannot decode.
             if (seg_len < 8) return false;
-            const size_t p = i + 2;
-            // p+0: precision
-            out.height = (uint16_t)((data[p + 1] << 8) | data[p + 2]);
-            out.width  = (uint16_t)((data[p + 3] << 8) | data[p + 4]);
-            out.components = data[p + 5];
-            size_t cpos = p + 6;
-            for (uint8_t c = 0; c < out.components; c++) {
-                if (cpos + 2 >= i + seg_len) break;
-                const uint8_t cid = data[cpos + 0];
-                const uint8_t hv  = data[cpos + 1];
+            out->found = true;
+            out->sof_marker = marker;
+            out->sof_height_pos = (uint32_t)(i + 3);
+            out->height = (uint16_t)((seg[1] << 8) | seg[2]);
+            out->width  = (uint16_t)((seg[3] << 8) | seg[4]);
+            out->components = seg[5];
+            out->h_max = 1;
+            out->v_max = 1;
+            for (uint8_t c = 0; c < out->components; c++) {
+                const size_t cpos = 6 + (size_t)c * 3;
+                if (cpos + 2 >= (size_t)seg_len - 2) break;
+                const uint8_t cid = seg[cpos + 0];
+                const uint8_t hv  = seg[cpos + 1];
                 const uint8_t h = hv >> 4;
                 const uint8_t v = hv & 0x0F;
-                if (cid == 1) { out.y_h = h; out.y_v = v; }
-                else if (cid == 2) { out.cb_h = h; out.cb_v = v; }
-                else if (cid == 3) { out.cr_h = h; out.cr_v = v; }
-                cpos += 3;
+                if (cid == 1) { out->y_h = h; out->y_v = v; }
+                else if (cid == 2) { out->cb_h = h; out->cb_v = v; }
+                else if (cid == 3) { out->cr_h = h; out->cr_v = v; }
+                if (h > out->h_max) out->h_max = h;
+                if (v > out->v_max) out->v_max = v;
             }
-            return true;
+            if (out->components == 1) out->h_max = out->v_max = 1;
+        } else if (marker == 0xDB) {
+            out->dqt_count++;
+        } else if (marker == 0xC4) {
+            out->dht_count++;
+        } else if (marker == 0xDD) {
+            if (seg_len == 4) out->restart_interval = (uint16_t)((seg[0] << 8) | seg[1]);
+        } else if (marker == 0xDA) {
+            // Start of Scan: the header ends with this segment.
+            out->scan_pos = (uint32_t)(i + seg_len);
+            break;
         }
 
         // Move to next segment
         i += seg_len;
     }
 
-    return out.found;
+    return out->found;
 }
 
 static bool jpeg_preflight_common(
-    const JpegSofInfo& info,
+    const JpegHeader& info,
     char* err,
     size_t err_sz
 ) {
-    if (info.progressive) {
+    if (info.sof_marker == 0xC2) {
         snprintf(err, err_sz, "Unsupported JPEG: progressive encoding (use baseline JPEG)");
         return false;
     }
+    if (info.sof_marker != 0xC0) {
+        snprintf(err, err_sz, "Unsupported JPEG: SOF%u encoding (use baseline JPEG)", (unsigned)(info.sof_marker - 0xC0));
+        return false;
+    }
 
     // Allow grayscale
     if (info.components == 1) {
@@ -128,10 +133,12 @@ bool jpeg_preflight_tjpgd_supported(
     int expected_width,
     int expected_height,
     char* err,
-    size_t err_sz
+    size_t err_sz,
+    JpegHeader* out_header
 ) {
-    JpegSofInfo info;
-    if (!jpeg_parse_sof_best_effort(data, size, info) || !info.found) {
+    JpegHeader local;
+    JpegHeader& info = out_header ? *out_header : local;
+    if (!jpeg_parse_header(data, size, &info)) {
         snprintf(err, err_sz, "Invalid JPEG header (missing SOF marker)");
         return false;
     }
@@ -145,6 +152,54 @@ bool jpeg_preflight_tjpgd_supported(
     return jpeg_preflight_common(info, err, err_sz);
 }
 
+int jpeg_tjpgd_fit_scale(int width, int height, int max_width, int max_height) {
+    if (width <= 0 || height <= 0) return -1;
+    for (int scale = 0; scale <= 3; scale++) {
+        // TJpgDec rounds partial MCUs up.
+        const int div = 1 << scale;
+        if ((width + div - 1) / div <= max_width && (height + div - 1) / div <= max_height) {
+            return scale;
+        }
+    }
+    return -1;
+}
+
+bool jpeg_preflight_tjpgd_fit_supported(
+    const uint8_t* data,
+    size_t size,
+    int max_width,
+    int max_height,
+    int* out_scale,
+    char* err,
+    size_t err_sz,
+    JpegHeader* out_header
+) {
+    JpegHeader local;
+    JpegHeader& info = out_header ? *out_header : local;
+    if (!jpeg_parse_header(data, size, &info)) {
+        snprintf(err, err_sz, "Invalid JPEG header (missing SOF marker)");
+        return false;
+    }
+
+    const int scale = jpeg_tjpgd_fit_scale((int)info.width, (int)info.height, max_width, max_height);
+    if (scale < 0) {
+        snprintf(err, err_sz, "Unsupported JPEG dimensions: %ux%u does not fit %dx%d even at 1/8 scale",
+                 (unsigned)info.width, (unsigned)info.height, max_width, max_height);
+        return false;
+    }
+    if (out_scale) *out_scale = scale;
+
+    return jpeg_preflight_common(info, err, err_sz);
+}
+
+bool jpeg_read_dimensions(const uint8_t* data, size_t size, int* out_width, int* out_height) {
+    JpegHeader info;
+    if (!jpeg_parse_header(data, size, &info)) return false;
+    if (out_width) *out_width = (int)info.width;
+    if (out_height) *out_height = (int)info.height;
+    return true;
+}
+
 bool jpeg_preflight_tjpgd_fragment_supported(
     const uint8_t* data,
     size_t size,
@@ -154,8 +209,8 @@ bool jpeg_preflight_tjpgd_fragment_supported(
     char* err,
     size_t err_sz
 ) {
-    JpegSofInfo info;
-    if (!jpeg_parse_sof_best_effort(data, size, info) || !info.found) {
+    JpegHeader info;
+    if (!jpeg_parse_header(data, size, &info)) {
         snprintf(err, err_sz, "Invalid JPEG header (missing SOF marker)");
         return false;
     }
@@ -14,18 +14,66 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// Everything the image path needs from a JPEG header, read in one pass from
+// SOI through SOS. Preflight fills it and the decoders take it from there,
+// so an upload is parsed once instead of once per check.
+struct JpegHeader {
+    bool found = false;             // an SOF marker was seen
+    uint8_t sof_marker = 0;         // 0xC0 baseline, 0xC2 progressive, ...
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint8_t components = 0;
+    // Sampling factors (h,v) for component IDs 1(Y),2(Cb),3(Cr)
+    uint8_t y_h = 0, y_v = 0;
+    uint8_t cb_h = 0, cb_v = 0;
+    uint8_t cr_h = 0, cr_v = 0;
+    uint8_t h_max = 0, v_max = 0;   // MCU is 8*h_max x 8*v_max pixels
+    uint16_t restart_interval = 0;  // DRI, in MCUs; 0 = none
+    uint32_t sof_height_pos = 0;    // offset of the SOF height field
+    uint32_t scan_pos = 0;          // offset of the entropy-coded data; 0 = SOS not in the buffer
+    uint8_t dqt_count = 0;
+    uint8_t dht_count = 0;
+};
+
+// Parse the header of a JPEG. True when an SOF was found; a buffer cut off
+// after the SOF (the first chunk of an upload) still counts, with scan_pos 0.
+bool jpeg_parse_header(const uint8_t* data, size_t size, JpegHeader* out);
+
 // Validates a full-frame JPEG against exact dimensions.
 // Returns true if the JPEG header looks compatible with TJpgDec, 
 // else writes a human-friendly error message to err buffer.
+// out_header (optional) receives the parsed header for the decoder.
 bool jpeg_preflight_tjpgd_supported(
     const uint8_t* data,
     size_t size,
     int expected_width,
     int expected_height,
     char* err,
-    size_t err_sz
+    size_t err_sz,
+    JpegHeader* out_header = nullptr
 );
 
+// Smallest TJpgDec scale (0=1/1, 1=1/2, 2=1/4, 3=1/8) at which a width x height
+// JPEG fits max_width x max_height, or -1 if it does not fit even at 1/8.
+int jpeg_tjpgd_fit_scale(int width, int height, int max_width, int max_height);
+
+// Validates a full-frame JPEG that will be decoded scaled down to fit
+// max_width x max_height (see jpeg_tjpgd_fit_scale). out_scale and
+// out_header may be nullptr.
+bool jpeg_preflight_tjpgd_fit_supported(
+    const uint8_t* data,
+    size_t size,
+    int max_width,
+    int max_height,
+    int* out_scale,
+    char* err,
+    size_t err_sz,
+    JpegHeader* out_header = nullptr
+);
+
+// Width and height from the JPEG's SOF marker; false when there is none.
+bool jpeg_read_dimensions(const uint8_t* data, size_t size, int* out_width, int* out_height);
+
 // Validates a JPEG fragment (strip) against expected width and height bounds.
 // max_height is typically the remaining image height for this fragment.
 // panel_max_height is the display panel height cap.
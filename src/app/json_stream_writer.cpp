@@ -0,0 +1,194 @@
+/*
+ * JSON Stream Writer Implementation
+ */
+
+#include "json_stream_writer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+JsonStreamObject JsonStreamWriter::root() {
+    return JsonStreamObject(this, open('{', '}'));
+}
+
+size_t JsonStreamWriter::finish() {
+    unwind(0, 0);
+    return written_;
+}
+
+void JsonStreamWriter::put(char c) {
+    written_ += out_.write((uint8_t)c);
+}
+
+void JsonStreamWriter::put(const char* s, size_t len) {
+    if (len) written_ += out_.write((const uint8_t*)s, len);
+}
+
+bool JsonStreamWriter::unwind(uint8_t level, uint16_t id) {
+    if (level > depth_ || id_at(level) != id) {
+        // The handle's container was closed by a write further up.
+        misused_ = true;
+        return false;
+    }
+    while (depth_ > level) {
+        depth_--;
+        put(close_[depth_]);
+    }
+    return true;
+}
+
+bool JsonStreamWriter::begin_element(uint8_t level, uint16_t id) {
+    if (level == 0 || !unwind(level, id)) return false;
+    if (first_[level - 1]) {
+        first_[level - 1] = false;
+    } else {
+        put(',');
+    }
+    return true;
+}
+
+bool JsonStreamWriter::begin_member(uint8_t level, uint16_t id, const char* key) {
+    if (!begin_element(level, id)) return false;
+    write_string(key);
+    put(':');
+    return true;
+}
+
+uint8_t JsonStreamWriter::open(char open_ch, char close_ch) {
+    if (depth_ >= kMaxDepth) {
+        // Keep the output well-formed: an empty container stands in.
+        misused_ = true;
+        put(open_ch);
+        put(close_ch);
+        return 0;
+    }
+    put(open_ch);
+    first_[depth_] = true;
+    close_[depth_] = close_ch;
+    ids_[depth_] = ++next_id_;
+    depth_++;
+    return depth_;
+}
+
+void JsonStreamWriter::write_null() {
+    put("null", 4);
+}
+
+void JsonStreamWriter::write_bool(bool v) {
+    if (v) {
+        put("true", 4);
+    } else {
+        put("false", 5);
+    }
+}
+
+void JsonStreamWriter::write_string(const char* s) {
+    if (!s) {
+        write_null();
+        return;
+    }
+
+    static const char kHex[] = "0123456789abcdef";
+    put('"');
+    const char* run = s;
+    for (const char* p = s; *p; p++) {
+        const uint8_t c = (uint8_t)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        // Plain bytes go out in one write; only escapes are emitted singly.
+        put(run, (size_t)(p - run));
+        run = p + 1;
+        switch (c) {
+            case '"': put("\\\"", 2); break;
+            case '\\': put("\\\\", 2); break;
+            case '\n': put("\\n", 2); break;
+            case '\r': put("\\r", 2); break;
+            case '\t': put("\\t", 2); break;
+            case '\b': put("\\b", 2); break;
+            case '\f': put("\\f", 2); break;
+            default: {
+                const char esc[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0x0F]};
+                put(esc, sizeof(esc));
+                break;
+            }
+        }
+    }
+    put(run, strlen(run));
+    put('"');
+}
+
+void JsonStreamWriter::write_uint(unsigned long long v) {
+    char buf[20];
+    size_t n = 0;
+    do {
+        buf[sizeof(buf) - 1 - n] = (char)('0' + (v % 10));
+        v /= 10;
+        n++;
+    } while (v);
+    put(buf + sizeof(buf) - n, n);
+}
+
+void JsonStreamWriter::write_int(long long v) {
+    if (v < 0) {
+        put('-');
+        write_uint(0ULL - (unsigned long long)v);
+        return;
+    }
+    write_uint((unsigned long long)v);
+}
+
+void JsonStreamWriter::write_float(double v, int digits) {
+    // JSON has no NaN/Infinity; ArduinoJson writes null as well.
+    if (isnan(v) || isinf(v)) {
+        write_null();
+        return;
+    }
+    char buf[32];
+    const int n = snprintf(buf, sizeof(buf), "%.*g", digits, v);
+    if (n <= 0) {
+        write_null();
+        return;
+    }
+    put(buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+JsonStreamObject JsonStreamObject::createNestedObject(const char* key) {
+    if (!w_->begin_member(level_, id_, key)) return JsonStreamObject(w_, 0);
+    return JsonStreamObject(w_, w_->open('{', '}'));
+}
+
+JsonStreamArray JsonStreamObject::createNestedArray(const char* key) {
+    if (!w_->begin_member(level_, id_, key)) return JsonStreamArray(w_, 0);
+    return JsonStreamArray(w_, w_->open('[', ']'));
+}
+
+JsonStreamObject JsonStreamArray::createNestedObject() {
+    if (!w_->begin_element(level_, id_)) return JsonStreamObject(w_, 0);
+    return JsonStreamObject(w_, w_->open('{', '}'));
+}
+
+JsonStreamArray JsonStreamArray::createNestedArray() {
+    if (!w_->begin_element(level_, id_)) return JsonStreamArray(w_, 0);
+    return JsonStreamArray(w_, w_->open('[', ']'));
+}
+
+size_t JsonFixedBufferPrint::write(uint8_t c) {
+    if (len_ >= cap_) {
+        overflowed_ = true;
+        return 0;
+    }
+    buf_[len_++] = (char)c;
+    return 1;
+}
+
+size_t JsonFixedBufferPrint::write(const uint8_t* data, size_t len) {
+    size_t n = len;
+    if (n > cap_ - len_) {
+        n = cap_ - len_;
+        overflowed_ = true;
+    }
+    memcpy(buf_ + len_, data, n);
+    len_ += n;
+    return n;
+}
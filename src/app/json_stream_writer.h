@@ -0,0 +1,166 @@
+/*
+ * JSON Stream Writer
+ *
+ * Allocation-free JSON output for the telemetry endpoints. Members go to a
+ * Print as they are assigned; nothing is built in memory first. The handles
+ * mirror the ArduinoJson calls the telemetry code already uses
+ * (obj["key"] = v, createNestedObject/createNestedArray, add), so one fill
+ * function template can target either a JsonDocument or a writer.
+ *
+ * Output follows call order: writing to a parent closes any nested
+ * container still open below it, and a handle whose container was closed
+ * ignores further writes. Keys are written as given, so a key assigned
+ * twice appears twice (callers assign each key once).
+ *
+ *   JsonFixedBufferPrint out(buf, sizeof(buf));
+ *   JsonStreamWriter w(out);
+ *   JsonStreamObject root = w.root();
+ *   root["uptime"] = 12;
+ *   JsonStreamArray a = root.createNestedArray("p");
+ *   a.add(1);
+ *   w.finish();   // {"uptime":12,"p":[1]}
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+class JsonStreamObject;
+class JsonStreamArray;
+
+class JsonStreamWriter {
+public:
+    static constexpr uint8_t kMaxDepth = 8;
+
+    explicit JsonStreamWriter(Print& out) : out_(out) {}
+
+    // Opens the top-level object. Call once.
+    JsonStreamObject root();
+
+    // Closes every open container. Returns the bytes written in total.
+    size_t finish();
+
+    size_t written() const { return written_; }
+
+    // Nesting deeper than kMaxDepth or a write through a closed handle.
+    bool misused() const { return misused_; }
+
+    // Used by the handles. A container is named by its nesting level
+    // (1 = the root) plus the id it got when opened. begin_* closes deeper
+    // containers and writes the separator (and key).
+    bool begin_member(uint8_t level, uint16_t id, const char* key);
+    bool begin_element(uint8_t level, uint16_t id);
+    uint8_t open(char open_ch, char close_ch);
+    uint16_t id_at(uint8_t level) const { return level ? ids_[level - 1] : 0; }
+
+    void write_null();
+    void write_bool(bool v);
+    void write_string(const char* s);
+    void write_int(long long v);
+    void write_uint(unsigned long long v);
+    void write_float(double v, int digits);
+
+    void value(std::nullptr_t) { write_null(); }
+    void value(bool v) { write_bool(v); }
+    void value(const char* s) { write_string(s); }
+    void value(const String& s) { write_string(s.c_str()); }
+    void value(float v) { write_float(v, 7); }
+    void value(double v) { write_float(v, 15); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type
+    value(T v) {
+        if (std::is_signed<T>::value) {
+            write_int((long long)v);
+        } else {
+            write_uint((unsigned long long)v);
+        }
+    }
+
+private:
+    void put(char c);
+    void put(const char* s, size_t len);
+    bool unwind(uint8_t level, uint16_t id);
+
+    Print& out_;
+    size_t written_ = 0;
+    uint8_t depth_ = 0;
+    uint16_t next_id_ = 0;
+    bool misused_ = false;
+    bool first_[kMaxDepth];
+    uint16_t ids_[kMaxDepth];
+    char close_[kMaxDepth];
+};
+
+class JsonStreamMember {
+public:
+    JsonStreamMember(JsonStreamWriter* w, uint8_t level, uint16_t id, const char* key)
+        : w_(w), level_(level), id_(id), key_(key) {}
+
+    template <typename T>
+    void operator=(T v) {
+        if (w_->begin_member(level_, id_, key_)) w_->value(v);
+    }
+
+private:
+    JsonStreamWriter* w_;
+    uint8_t level_;
+    uint16_t id_;
+    const char* key_;
+};
+
+class JsonStreamObject {
+public:
+    JsonStreamObject(JsonStreamWriter* w, uint8_t level) : w_(w), level_(level), id_(w->id_at(level)) {}
+
+    JsonStreamMember operator[](const char* key) { return JsonStreamMember(w_, level_, id_, key); }
+
+    JsonStreamObject createNestedObject(const char* key);
+    JsonStreamArray createNestedArray(const char* key);
+
+private:
+    JsonStreamWriter* w_;
+    uint8_t level_;
+    uint16_t id_;
+};
+
+class JsonStreamArray {
+public:
+    JsonStreamArray(JsonStreamWriter* w, uint8_t level) : w_(w), level_(level), id_(w->id_at(level)) {}
+
+    template <typename T>
+    void add(T v) {
+        if (w_->begin_element(level_, id_)) w_->value(v);
+    }
+
+    JsonStreamObject createNestedObject();
+    JsonStreamArray createNestedArray();
+
+private:
+    JsonStreamWriter* w_;
+    uint8_t level_;
+    uint16_t id_;
+};
+
+// Print into a caller-owned buffer; bytes past the end are dropped and
+// flagged. The buffer is not NUL-terminated.
+class JsonFixedBufferPrint : public Print {
+public:
+    JsonFixedBufferPrint(char* buf, size_t cap) : buf_(buf), cap_(cap) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t len) override;
+
+    size_t length() const { return len_; }
+    bool overflowed() const { return overflowed_; }
+
+private:
+    char* buf_;
+    size_t cap_;
+    size_t len_ = 0;
+    bool overflowed_ = false;
+};
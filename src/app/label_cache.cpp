@@ -0,0 +1,256 @@
+/*
+ * Label Cache Implementation
+ */
+
+#include "label_cache.h"
+
+#if HAS_DISPLAY && LABEL_CACHE_ENABLED
+
+#include "fnv1a.h"
+#include "heap_tags.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#include <string.h>
+
+namespace {
+
+struct Entry {
+    lv_img_dsc_t dsc;
+    uint8_t* block;          // A8 pixels, then the NUL-terminated text
+    const char* text;
+    const lv_font_t* font;
+    uint32_t hash;
+    uint32_t epoch;
+    uint32_t bytes;
+    uint32_t lastUseTick;
+    lv_coord_t width;
+    uint16_t refs;
+};
+
+static Entry g_entries[LABEL_CACHE_ENTRIES];
+static uint32_t g_epoch = 1;
+static uint32_t g_bytes = 0;
+static int8_t g_psram = -1;  // -1 = not checked yet
+
+static uint32_t g_hits = 0;
+static uint32_t g_misses = 0;
+static uint32_t g_evictions = 0;
+static uint32_t g_render_us = 0;
+
+static bool psram_present() {
+    if (g_psram < 0) {
+        g_psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0 ? 1 : 0;
+    }
+    return g_psram == 1;
+}
+
+static void free_entry(Entry& e) {
+    lv_img_cache_invalidate_src(&e.dsc);
+    heap_tag_free(HeapTag::Display, e.block);
+    g_bytes -= e.bytes;
+    memset(&e, 0, sizeof(e));
+}
+
+static Entry* find_by_dsc(const lv_img_dsc_t* dsc) {
+    for (Entry& e : g_entries) {
+        if (e.block && &e.dsc == dsc) return &e;
+    }
+    return nullptr;
+}
+
+// A free slot with room for bytes, evicting least recently used unreferenced
+// entries; nullptr when everything left is on screen.
+static Entry* make_room(uint32_t bytes) {
+    if (bytes > LABEL_CACHE_MAX_BYTES) return nullptr;
+    for (;;) {
+        Entry* empty = nullptr;
+        Entry* lru = nullptr;
+        for (Entry& e : g_entries) {
+            if (!e.block) {
+                if (!empty) empty = &e;
+                continue;
+            }
+            if (e.refs == 0 && (!lru || (int32_t)(e.lastUseTick - lru->lastUseTick) < 0)) lru = &e;
+        }
+        if (empty && g_bytes + bytes <= LABEL_CACHE_MAX_BYTES) return empty;
+        if (!lru) return nullptr;
+        free_entry(*lru);
+        g_evictions++;
+    }
+}
+
+// Mirrors lv_draw_sw_letter(): pen at the line's top-left, glyph box placed
+// from the font's base line. Returns false for glyphs this cannot reproduce.
+static bool draw_glyph(uint8_t* dst, lv_coord_t w, lv_coord_t h, lv_coord_t penX, lv_coord_t lineY, const lv_font_t* font, uint32_t letter) {
+    lv_font_glyph_dsc_t g;
+    if (!lv_font_get_glyph_dsc(font, &g, letter, '\0')) {
+        // Control characters draw nothing; a missing printable glyph may get
+        // LVGL's placeholder box, so leave that label to LVGL.
+        return letter < 0x20 || letter == 0xf8ff || letter == 0x200c;
+    }
+    if (g.box_w == 0 || g.box_h == 0) return true;
+
+    uint8_t bpp = g.bpp;
+    if (bpp == 3) bpp = 4;
+    if (bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8) return false;  // image/subpixel fonts
+
+    const uint8_t* map = lv_font_get_glyph_bitmap(g.resolved_font, letter);
+    if (!map) return false;
+
+    const int32_t gx = penX + g.ofs_x;
+    const int32_t gy = lineY + (font->line_height - font->base_line) - g.box_h - g.ofs_y;
+    const uint32_t maxVal = (1u << bpp) - 1u;
+
+    // Glyph rows are packed back to back, not byte aligned.
+    uint32_t bit = 0;
+    for (int32_t row = 0; row < g.box_h; row++) {
+        const int32_t py = gy + row;
+        for (int32_t col = 0; col < g.box_w; col++, bit += bpp) {
+            const uint32_t v = (map[bit >> 3] >> (8 - bpp - (bit & 7))) & maxVal;
+            if (v == 0) continue;
+            const int32_t px = gx + col;
+            if (px < 0 || py < 0 || px >= w || py >= h) continue;
+            const uint8_t a = (uint8_t)((v * 255u) / maxVal);
+            uint8_t& d = dst[(size_t)py * (size_t)w + (size_t)px];
+            if (a > d) d = a;
+        }
+    }
+    return true;
+}
+
+// Same line breaking and centering as lv_draw_label() for a
+// LV_TEXT_ALIGN_CENTER label (no letter/line space, no recolor).
+static bool rasterise(uint8_t* dst, lv_coord_t w, lv_coord_t h, const char* text, const lv_font_t* font) {
+    const lv_coord_t lineHeight = lv_font_get_line_height(font);
+    uint32_t lineStart = 0;
+    lv_coord_t y = 0;
+    while (text[lineStart] != '\0') {
+        const uint32_t lineLen = _lv_txt_get_next_line(&text[lineStart], font, 0, w, nullptr, LV_TEXT_FLAG_NONE);
+        if (lineLen == 0) break;
+        const lv_coord_t lineW = lv_txt_get_width(&text[lineStart], lineLen, font, 0, LV_TEXT_FLAG_NONE);
+        lv_coord_t x = (w - lineW) / 2;
+
+        uint32_t i = 0;
+        while (i < lineLen) {
+            uint32_t letter;
+            uint32_t letterNext;
+            _lv_txt_encoded_letter_next_2(&text[lineStart], &letter, &letterNext, &i);
+            if (!draw_glyph(dst, w, h, x, y, font, letter)) return false;
+            const uint16_t adv = lv_font_get_glyph_width(font, letter, letterNext);
+            if (adv > 0) x += adv;
+        }
+
+        lineStart += lineLen;
+        y += lineHeight;
+    }
+    return true;
+}
+
+} // namespace
+
+const lv_img_dsc_t* label_cache_acquire(const char* text, const lv_font_t* font, lv_coord_t width) {
+    if (!text || !*text || !font || width <= 0) return nullptr;
+    if (!psram_present()) return nullptr;
+
+    const uint32_t hash = fnv1a32_str(text);
+    for (Entry& e : g_entries) {
+        if (!e.block || e.epoch != g_epoch || e.hash != hash || e.font != font || e.width != width) continue;
+        if (strcmp(e.text, text) != 0) continue;
+        e.refs++;
+        e.lastUseTick = lv_tick_get();
+        g_hits++;
+        return &e.dsc;
+    }
+    g_misses++;
+
+    lv_point_t size;
+    lv_txt_get_size(&size, text, font, 0, 0, width, LV_TEXT_FLAG_NONE);
+    if (size.y <= 0) return nullptr;
+
+    const size_t pixels = (size_t)width * (size_t)size.y;
+    const size_t textLen = strlen(text);
+    const uint32_t bytes = (uint32_t)(pixels + textLen + 1);
+    Entry* slot = make_room(bytes);
+    if (!slot) return nullptr;
+
+    uint8_t* block = (uint8_t*)heap_tag_malloc(HeapTag::Display, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!block) return nullptr;
+    memset(block, 0, pixels);
+
+    const uint32_t t0 = (uint32_t)esp_timer_get_time();
+    const bool ok = rasterise(block, width, size.y, text, font);
+    g_render_us = (uint32_t)esp_timer_get_time() - t0;
+    if (!ok) {
+        heap_tag_free(HeapTag::Display, block);
+        return nullptr;
+    }
+
+    char* textCopy = (char*)block + pixels;
+    memcpy(textCopy, text, textLen + 1);
+
+    Entry& e = *slot;
+    memset(&e.dsc, 0, sizeof(e.dsc));
+    e.dsc.header.cf = LV_IMG_CF_ALPHA_8BIT;
+    e.dsc.header.w = (uint32_t)width;
+    e.dsc.header.h = (uint32_t)size.y;
+    e.dsc.data_size = (uint32_t)pixels;
+    e.dsc.data = block;
+    e.block = block;
+    e.text = textCopy;
+    e.font = font;
+    e.hash = hash;
+    e.epoch = g_epoch;
+    e.bytes = bytes;
+    e.lastUseTick = lv_tick_get();
+    e.width = width;
+    e.refs = 1;
+    g_bytes += bytes;
+    return &e.dsc;
+}
+
+void label_cache_release(const lv_img_dsc_t* dsc) {
+    if (!dsc) return;
+    Entry* e = find_by_dsc(dsc);
+    if (!e || e->refs == 0) return;
+    e->refs--;
+    // Stale (font reloaded): nothing can look it up again.
+    if (e->refs == 0 && e->epoch != g_epoch) free_entry(*e);
+}
+
+void label_cache_invalidate() {
+    g_epoch++;
+    for (Entry& e : g_entries) {
+        if (e.block && e.refs == 0) free_entry(e);
+    }
+}
+
+uint16_t label_cache_trim_unreferenced() {
+    uint16_t freed = 0;
+    for (Entry& e : g_entries) {
+        if (e.block && e.refs == 0) {
+            free_entry(e);
+            freed++;
+        }
+    }
+    return freed;
+}
+
+void label_cache_get_stats(LabelCacheStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    out->active = psram_present();
+    for (const Entry& e : g_entries) {
+        if (!e.block) continue;
+        out->entries++;
+        if (e.refs > 0) out->referenced++;
+    }
+    out->bytes = g_bytes;
+    out->hits = g_hits;
+    out->misses = g_misses;
+    out->evictions = g_evictions;
+    out->render_us = g_render_us;
+}
+
+#endif // HAS_DISPLAY && LABEL_CACHE_ENABLED
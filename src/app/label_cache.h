@@ -0,0 +1,56 @@
+/*
+ * Label Cache
+ *
+ * Pre-rendered macro button labels. Each distinct (text, font, width) is
+ * rasterised once, with the same line breaking and centering as an
+ * LV_LABEL_LONG_WRAP label, into an A8 (LV_IMG_CF_ALPHA_8BIT) bitmap in PSRAM.
+ * The button shows it as an image tinted with the label color, so a press
+ * cue redraw blends one alpha bitmap instead of looking up and unpacking
+ * every glyph again.
+ *
+ * Entries are reference counted: a button holds its bitmap until its config
+ * generation moves and refreshButtons() acquires the new one. Unreferenced
+ * entries stay cached (LRU) within LABEL_CACHE_MAX_BYTES. Without PSRAM the
+ * cache stays empty and labels render as text.
+ *
+ * LVGL task only.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_DISPLAY && LABEL_CACHE_ENABLED
+
+#include <lvgl.h>
+#include <stdint.h>
+
+struct LabelCacheStats {
+    bool active;             // PSRAM present
+    uint16_t entries;
+    uint16_t referenced;     // entries shown by at least one button
+    uint32_t bytes;          // bitmap + text bytes held
+    uint32_t hits;
+    uint32_t misses;         // rasterised (or failed) lookups
+    uint32_t evictions;
+    uint32_t render_us;      // duration of the last rasterisation
+};
+
+// Bitmap for text as a label of this font and content width would draw it,
+// with a reference held; nullptr when the cache is off or full (draw the
+// label as text). Width must be the label's content width.
+const lv_img_dsc_t* label_cache_acquire(const char* text, const lv_font_t* font, lv_coord_t width);
+
+// Drops a reference taken by label_cache_acquire() (nullptr is ignored).
+void label_cache_release(const lv_img_dsc_t* dsc);
+
+// Font contents changed under the same lv_font_t (label font reload): no
+// later lookup matches an existing entry; held ones are freed on release.
+void label_cache_invalidate();
+
+// Memory pressure: frees every unreferenced entry. Returns the number freed.
+uint16_t label_cache_trim_unreferenced();
+
+void label_cache_get_stats(LabelCacheStats* out);
+
+#endif // HAS_DISPLAY && LABEL_CACHE_ENABLED
@@ -0,0 +1,307 @@
+/*
+ * Label Font Implementation
+ */
+
+#include "label_font.h"
+
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+
+#include "display_manager.h"
+#include "fs_health.h"
+#include "label_cache.h"
+#include "log_manager.h"
+#include "macros_config.h"
+
+#include <Arduino.h>
+#include <FFat.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <string.h>
+
+namespace {
+
+static const char* kFontDir = "/fonts";
+static const char* kFontPath = "/fonts/label.bin";
+static const char* kFontTmpPath = "/fonts/label.tmp";
+
+// The same file through LVGL's stdio driver (LV_FS_STDIO_PATH is /ffat, see lv_conf.h).
+static const char* kLvglFontPath = "F:/fonts/label.bin";
+
+// Labels point here; the contents are swapped on reload (LVGL task only).
+static lv_font_t g_proxy;
+static bool g_proxy_ready = false;
+static lv_font_t* g_loaded = nullptr;
+
+// Serializes file replacement (AsyncTCP) against lv_font_load (LVGL task),
+// so a load never reads clusters a concurrent upload is reusing.
+static SemaphoreHandle_t g_file_mutex = nullptr;
+
+static bool ffat_attempted = false;
+static bool ffat_ready = false;
+
+static volatile bool g_stat_loaded = false;
+static volatile uint32_t g_stat_file_bytes = 0;
+static volatile uint32_t g_stat_glyphs = 0;
+static volatile uint16_t g_stat_line_height = 0;
+static volatile uint32_t g_stat_loads = 0;
+static volatile uint32_t g_stat_failures = 0;
+static volatile uint32_t g_stat_load_ms = 0;
+
+static void set_err(char* err, size_t err_len, const char* msg) {
+    if (!err || err_len == 0) return;
+    strlcpy(err, msg ? msg : "", err_len);
+}
+
+static bool ensure_ffat() {
+    if (ffat_attempted) return ffat_ready;
+    ffat_attempted = true;
+
+    const esp_partition_t* ffat_part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA,
+        ESP_PARTITION_SUBTYPE_DATA_FAT,
+        "ffat");
+    if (!ffat_part) {
+        ffat_ready = false;
+        return false;
+    }
+
+    ffat_ready = FFat.begin(false);
+    if (ffat_ready) fs_health_note_ffat_mounted();
+    return ffat_ready;
+}
+
+static void proxy_init() {
+    if (g_proxy_ready) return;
+    g_proxy = *LV_FONT_DEFAULT;
+    g_proxy_ready = true;
+}
+
+static uint32_t count_glyphs(const lv_font_t* font) {
+    const lv_font_fmt_txt_dsc_t* dsc = (const lv_font_fmt_txt_dsc_t*)font->dsc;
+    if (!dsc) return 0;
+    uint32_t glyphs = 0;
+    for (uint16_t i = 0; i < dsc->cmap_num; i++) {
+        const lv_font_fmt_txt_cmap_t& c = dsc->cmaps[i];
+        const bool sparse = c.type == LV_FONT_FMT_TXT_CMAP_SPARSE_TINY || c.type == LV_FONT_FMT_TXT_CMAP_SPARSE_FULL;
+        glyphs += sparse ? c.list_length : c.range_length;
+    }
+    return glyphs;
+}
+
+static bool lock_files(uint32_t timeout_ms) {
+    if (!g_file_mutex) return false;
+    return xSemaphoreTake(g_file_mutex, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+static void unlock_files() {
+    xSemaphoreGive(g_file_mutex);
+}
+
+// Next UTF-8 code point of s (advanced past it); 0 at the end or on a
+// malformed sequence.
+static uint32_t next_codepoint(const char** s) {
+    const uint8_t* p = (const uint8_t*)*s;
+    const uint8_t c = p[0];
+    if (c == 0) return 0;
+
+    uint32_t cp;
+    int extra;
+    if (c < 0x80) { cp = c; extra = 0; }
+    else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; extra = 1; }
+    else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; extra = 2; }
+    else if ((c & 0xF8) == 0xF0) { cp = c & 0x07; extra = 3; }
+    else return 0;
+
+    for (int i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    *s += 1 + extra;
+    return cp;
+}
+
+} // namespace
+
+void label_font_init() {
+    if (!g_file_mutex) g_file_mutex = xSemaphoreCreateMutex();
+    if (!ensure_ffat() || !FFat.exists(kFontPath)) return;
+    display_manager_reload_label_font();
+}
+
+const lv_font_t* label_font_get() {
+    proxy_init();
+    return &g_proxy;
+}
+
+void label_font_apply() {
+    proxy_init();
+
+    lv_font_t* next = nullptr;
+    uint32_t file_bytes = 0;
+    const uint32_t t0 = millis();
+    if (!lock_files(1000)) {
+        g_stat_failures = g_stat_failures + 1;
+        Logger.logMessage("LabelFont", "Font file busy; reload skipped");
+        return;
+    }
+    const bool present = ensure_ffat() && FFat.exists(kFontPath);
+    if (present) {
+        file_bytes = fs_health_ffat_file_size(kFontPath);
+        next = lv_font_load(kLvglFontPath);
+    }
+    unlock_files();
+
+    if (present && !next) {
+        g_stat_failures = g_stat_failures + 1;
+        Logger.logMessage("LabelFont", "Loading /fonts/label.bin failed; keeping the current font");
+        return;
+    }
+    if (!next && !g_loaded) return;
+
+    lv_font_t* old = g_loaded;
+    if (next) {
+        g_proxy = *next;
+        g_proxy.fallback = LV_FONT_DEFAULT;
+    } else {
+        g_proxy = *LV_FONT_DEFAULT;
+    }
+    g_loaded = next;
+    if (old) lv_font_free(old);
+
+    g_stat_loaded = next != nullptr;
+    g_stat_file_bytes = next ? file_bytes : 0;
+    g_stat_glyphs = next ? count_glyphs(next) : 0;
+    g_stat_line_height = next ? (uint16_t)next->line_height : 0;
+    g_stat_load_ms = millis() - t0;
+    if (next) g_stat_loads = g_stat_loads + 1;
+
+    // Same labels, new metrics: every button re-sets its text and re-layouts.
+    // The proxy's address is unchanged, so cached label bitmaps must go too.
+    #if LABEL_CACHE_ENABLED
+    label_cache_invalidate();
+    #endif
+    macros_config_mark_changed();
+
+    if (next) {
+        Logger.logMessagef("LabelFont", "Loaded %u glyphs, line height %u (%u bytes, %u ms)",
+            (unsigned)g_stat_glyphs, (unsigned)g_stat_line_height, (unsigned)file_bytes, (unsigned)g_stat_load_ms);
+    } else {
+        Logger.logMessage("LabelFont", "Font removed; labels use the default font");
+    }
+}
+
+bool label_font_save(const uint8_t* data, size_t len, char* err, size_t err_len) {
+    set_err(err, err_len, "");
+    // A binary font starts with its "head" table: u32 length, then the tag.
+    if (!data || len < 8 || memcmp(data + 4, "head", 4) != 0) {
+        set_err(err, err_len, "Not an LVGL binary font (lv_font_conv --format bin)");
+        return false;
+    }
+    if (len > LABEL_FONT_MAX_BYTES) {
+        set_err(err, err_len, "Font is larger than LABEL_FONT_MAX_BYTES");
+        return false;
+    }
+    if (!ensure_ffat()) {
+        set_err(err, err_len, "FFat not available");
+        return false;
+    }
+    if (!lock_files(5000)) {
+        set_err(err, err_len, "Font file busy");
+        return false;
+    }
+
+    bool ok = false;
+    if (!FFat.exists(kFontDir)) {
+        if (FFat.mkdir(kFontDir)) fs_health_note_ffat_file(0, 1);
+    }
+    if (FFat.exists(kFontTmpPath)) fs_health_ffat_remove(kFontTmpPath);
+
+    File f = FFat.open(kFontTmpPath, FILE_WRITE);
+    if (!f) {
+        set_err(err, err_len, "Failed to create the font file");
+    } else {
+        const size_t written = f.write(data, len);
+        f.close();
+        fs_health_note_ffat_file(0, (uint32_t)written);
+        if (written != len) {
+            fs_health_ffat_remove(kFontTmpPath);
+            set_err(err, err_len, "Font write failed (FFat full?)");
+        } else {
+            if (FFat.exists(kFontPath)) fs_health_ffat_remove(kFontPath);
+            ok = FFat.rename(kFontTmpPath, kFontPath);
+            if (!ok) {
+                fs_health_ffat_remove(kFontTmpPath);
+                set_err(err, err_len, "Failed to replace the font file");
+            }
+        }
+    }
+    unlock_files();
+
+    if (ok) display_manager_reload_label_font();
+    return ok;
+}
+
+bool label_font_remove(char* err, size_t err_len) {
+    set_err(err, err_len, "");
+    if (!ensure_ffat()) {
+        set_err(err, err_len, "FFat not available");
+        return false;
+    }
+    if (!lock_files(5000)) {
+        set_err(err, err_len, "Font file busy");
+        return false;
+    }
+    const bool ok = !FFat.exists(kFontPath) || fs_health_ffat_remove(kFontPath);
+    unlock_files();
+
+    if (!ok) {
+        set_err(err, err_len, "Failed to remove the font file");
+        return false;
+    }
+    display_manager_reload_label_font();
+    return true;
+}
+
+size_t label_font_collect_codepoints(const MacroConfig* cfg, uint32_t* out, size_t max, bool* truncated) {
+    if (truncated) *truncated = false;
+    if (!cfg) return 0;
+    size_t count = 0;
+    for (uint8_t s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        for (uint8_t b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+            const char* p = cfg->buttons[s][b].label;
+            uint32_t cp;
+            while ((cp = next_codepoint(&p)) != 0) {
+                if (cp < 0x20) continue;
+
+                // Sorted insert; duplicates are skipped.
+                size_t pos = 0;
+                while (pos < count && out[pos] < cp) pos++;
+                if (pos < count && out[pos] == cp) continue;
+                if (count == max) {
+                    if (truncated) *truncated = true;
+                    continue;
+                }
+                memmove(out + pos + 1, out + pos, (count - pos) * sizeof(uint32_t));
+                out[pos] = cp;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void label_font_get_stats(LabelFontStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    out->loaded = g_stat_loaded;
+    out->file_bytes = g_stat_file_bytes;
+    out->glyphs = g_stat_glyphs;
+    out->line_height = g_stat_line_height;
+    out->loads = g_stat_loads;
+    out->load_failures = g_stat_failures;
+    out->load_ms = g_stat_load_ms;
+}
+
+#endif // HAS_DISPLAY && LABEL_FONT_ENABLED
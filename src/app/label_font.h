@@ -0,0 +1,64 @@
+/*
+ * Label Font
+ *
+ * Optional macro button label font loaded at runtime from FFat
+ * (/fonts/label.bin, an LVGL binary font from lv_font_conv --format bin).
+ * The firmware keeps compiling Montserrat 14/18/24 only; a font with other
+ * sizes or scripts lives on FFat, subset to the code points the macro labels
+ * actually use (GET /api/fonts/glyphs, tools/label_font.py).
+ *
+ * lv_font_load() reads the whole file once into LVGL's allocator (the PSRAM
+ * arena where there is one), so drawing a glyph never touches the file
+ * system. Labels hold a stable proxy font: a reload swaps its contents under
+ * the LVGL mutex and frees the previous font, so no label is left pointing
+ * at freed glyphs. Code points missing from the subset fall back to
+ * LV_FONT_DEFAULT.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+
+#include <lvgl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct MacroConfig;
+
+struct LabelFontStats {
+    bool loaded;             // a font from FFat is in use
+    uint32_t file_bytes;     // size of the loaded font file
+    uint32_t glyphs;
+    uint16_t line_height;
+    uint32_t loads;          // successful loads since boot
+    uint32_t load_failures;
+    uint32_t load_ms;        // duration of the last load
+};
+
+// Boot, after FFat is mounted: queues the first load on the LVGL task.
+void label_font_init();
+
+// Font for macro button labels (LVGL task). Until a font is loaded it
+// renders as LV_FONT_DEFAULT.
+const lv_font_t* label_font_get();
+
+// (Re)loads /fonts/label.bin, or falls back to LV_FONT_DEFAULT when the file
+// is gone, and marks the macro buttons dirty so labels re-layout. LVGL task
+// with the display mutex held; other tasks use display_manager_reload_label_font().
+void label_font_apply();
+
+// Replaces /fonts/label.bin (AsyncTCP task) and queues a reload.
+bool label_font_save(const uint8_t* data, size_t len, char* err, size_t err_len);
+
+// Removes the font file and queues a reload (labels go back to the default font).
+bool label_font_remove(char* err, size_t err_len);
+
+// Distinct code points used by the macro labels, ascending; returns the count.
+// truncated is set when there were more than max.
+size_t label_font_collect_codepoints(const MacroConfig* cfg, uint32_t* out, size_t max, bool* truncated);
+
+void label_font_get_stats(LabelFontStats* out);
+
+#endif // HAS_DISPLAY && LABEL_FONT_ENABLED
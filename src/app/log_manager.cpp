@@ -2,12 +2,21 @@
  * Log Manager Implementation
  * 
  * Indentation-based logger with nested blocks and automatic timing.
- * Routes output to Serial only.
+ * Routes output to Serial only, through the drain task when
+ * LOG_ASYNC_ENABLED is set.
  */
 
 #include "log_manager.h"
+#include "board_config.h"
+#include "task_placement.h"
 #include <stdarg.h>
 
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
 #if defined(ARDUINO_ARCH_ESP32)
 #include <esp_rom_sys.h>
 #endif
@@ -39,11 +48,346 @@ static inline void log_write_line(const char* line) {
     Serial.print(line);
 }
 
+// Indentation string for a nesting level.
+const char* indent_for(uint8_t level) {
+    static const char* indents[] = {
+        "",         // Level 0: no indent
+        "  ",       // Level 1: 2 spaces
+        "    ",     // Level 2: 4 spaces
+        "      "    // Level 3+: 6 spaces
+    };
+    
+    if (level > 3) level = 3; // Cap at 3 for indentation
+    return indents[level];
+}
+
+// ---- Per-task nesting ------------------------------------------------------
+
+// Tasks that can be inside a logBegin/logEnd block at once. A task's entry is
+// released when its outermost block ends; tasks beyond this log unindented.
+constexpr size_t kNestTasks = 8;
+
+struct NestState {
+    TaskHandle_t task;
+    uint8_t level;                // current depth (0-2, 3+ = overflow)
+    unsigned long start[3];       // start time for each nesting level
+};
+
+NestState g_nest[kNestTasks] = {};
+portMUX_TYPE g_nest_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Caller holds g_nest_mux.
+NestState* nest_find(TaskHandle_t task, bool claim) {
+    NestState* free_slot = nullptr;
+    for (NestState& st : g_nest) {
+        if (st.task == task) return &st;
+        if (!st.task && !free_slot) free_slot = &st;
+    }
+    if (!claim || !free_slot) return nullptr;
+    free_slot->task = task;
+    free_slot->level = 0;
+    return free_slot;
+}
+
+// Longest line the logger formats (the 192-byte buffers below, NUL included).
+constexpr size_t kLineBytes = 192;
+
+// ---- Deferred records ------------------------------------------------------
+
+// Record layout: module pointer, format pointer, nesting level, then the
+// LogArgPacker bytes.
+constexpr size_t kDeferredHeader = sizeof(const char*) * 2 + 1;
+
+static_assert(kDeferredHeader + LOGGER_DEFERRED_ARG_BYTES <= kLineBytes, "a deferred record must fit a ring slot");
+
+// Appends one conversion to msg. spec holds "%", the flags, width and
+// precision; the length modifier comes from the stored argument type.
+size_t format_one(char* msg, size_t room, char* spec, size_t spec_len, char conv, const uint8_t*& a, const uint8_t* end) {
+    if (a >= end) return (size_t)snprintf(msg, room, "?");
+    const uint8_t tag = *a++;
+    int n = -1;
+
+    auto finish = [&](const char* length) {
+        size_t k = spec_len;
+        for (const char* l = length; *l; l++) spec[k++] = *l;
+        spec[k++] = conv;
+        spec[k] = '\0';
+    };
+
+    switch (tag) {
+        case LogArgPacker::Int32:
+        case LogArgPacker::Ptr: {
+            if (end - a < 4) return 0;
+            uint32_t v;
+            memcpy(&v, a, 4);
+            a += 4;
+            if (conv == 'p') {
+                finish("");
+                n = snprintf(msg, room, spec, (void*)(uintptr_t)v);
+            } else if (strchr("diouxXc", conv)) {
+                finish("");
+                n = snprintf(msg, room, spec, (int)v);
+            }
+            break;
+        }
+        case LogArgPacker::Int64: {
+            if (end - a < 8) return 0;
+            uint64_t v;
+            memcpy(&v, a, 8);
+            a += 8;
+            if (strchr("diouxX", conv)) {
+                finish("ll");
+                n = snprintf(msg, room, spec, (long long)v);
+            }
+            break;
+        }
+        case LogArgPacker::Double: {
+            if (end - a < 8) return 0;
+            double v;
+            memcpy(&v, a, 8);
+            a += 8;
+            if (strchr("fFeEgGaA", conv)) {
+                finish("");
+                n = snprintf(msg, room, spec, v);
+            }
+            break;
+        }
+        case LogArgPacker::Str: {
+            if (end - a < 2) return 0;
+            const uint8_t len = *a++;
+            if ((size_t)(end - a) < (size_t)len + 1) {
+                a = end;
+                return 0;
+            }
+            const char* str = (const char*)a;
+            a += len + 1;
+            if (conv == 's') {
+                finish("");
+                n = snprintf(msg, room, spec, str);
+            }
+            break;
+        }
+        default:
+            a = end;
+            break;
+    }
+
+    // Argument and conversion don't match (or the record was cut short).
+    if (n < 0) n = snprintf(msg, room, "?");
+    return (size_t)n < room ? (size_t)n : room - 1;
+}
+
+// Formats a deferred record into the line logMessagef would have written.
+void format_deferred(const uint8_t* rec, size_t rec_len, char* out, size_t out_len) {
+    const char* module;
+    const char* fmt;
+    memcpy(&module, rec, sizeof(module));
+    memcpy(&fmt, rec + sizeof(module), sizeof(fmt));
+    const uint8_t level = rec[sizeof(module) + sizeof(fmt)];
+    const uint8_t* a = rec + kDeferredHeader;
+    const uint8_t* end = rec + rec_len;
+
+    // Same message limit as logMessagef's buffer.
+    char msg[128];
+    size_t m = 0;
+    const char* p = fmt;
+    while (*p && m < sizeof(msg) - 1) {
+        if (*p != '%') {
+            msg[m++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            msg[m++] = '%';
+            p += 2;
+            continue;
+        }
+        char spec[16];
+        size_t k = 0;
+        spec[k++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && k < sizeof(spec) - 4) spec[k++] = *p++;
+        while (*p && strchr("hlLqjzt", *p)) p++;
+        if (!*p) break;
+        const char conv = *p++;
+        m += format_one(msg + m, sizeof(msg) - m, spec, k, conv, a, end);
+    }
+    msg[m] = '\0';
+
+    snprintf(out, out_len, "%s[%s] %s (0ms)\n", indent_for(level), module, msg);
+}
+
+// ---- Async ring --------------------------------------------------------------
+
+#if LOG_ASYNC_ENABLED
+
+static_assert((LOG_RING_LINES & (LOG_RING_LINES - 1)) == 0, "LOG_RING_LINES must be a power of two");
+
+constexpr uint32_t kSlots = LOG_RING_LINES;
+constexpr uint32_t kMask = kSlots - 1;
+
+// Bounded multi-producer queue: a producer claims a position by advancing
+// g_head, fills the slot, then publishes it by setting seq to position + 1.
+// The single reader (whoever holds g_out_lock) hands the slot back by
+// setting seq to position + kSlots. No producer ever waits on another.
+struct LogSlot {
+    uint32_t seq;
+    uint16_t len;
+    uint8_t deferred;     // text holds a deferred record, not a line
+    char text[kLineBytes];
+};
+
+LogSlot* g_slots = nullptr;
+uint32_t g_head = 0;
+uint32_t g_tail = 0;              // reader side, under g_out_lock
+uint32_t g_dropped = 0;
+uint32_t g_dropped_reported = 0;  // reader side, under g_out_lock
+TaskHandle_t g_drain_task = nullptr;
+
+// Serializes everything that reaches Serial once the ring is up: the drain
+// task, flush() and raw Print writes.
+SemaphoreHandle_t g_out_lock = nullptr;
+
+const LogSink* g_sink = nullptr;
+
+// Caller holds g_out_lock.
+void write_out_locked(const char* line) {
+    log_write_line(line);
+    const LogSink* sink = __atomic_load_n(&g_sink, __ATOMIC_ACQUIRE);
+    if (sink && sink->line) sink->line(line, strlen(line));
+}
+
+bool ring_push(const char* data, size_t len, bool deferred) {
+    if (!g_slots) return false;
+
+    uint32_t pos = __atomic_load_n(&g_head, __ATOMIC_RELAXED);
+    while (true) {
+        LogSlot& slot = g_slots[pos & kMask];
+        const uint32_t seq = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+        const int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&g_head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                memcpy(slot.text, data, len);
+                if (!deferred) slot.text[len] = '\0';
+                slot.len = (uint16_t)len;
+                slot.deferred = deferred ? 1 : 0;
+                __atomic_store_n(&slot.seq, pos + 1, __ATOMIC_RELEASE);
+                if (g_drain_task) xTaskNotifyGive(g_drain_task);
+                return true;
+            }
+            // pos now holds the head another producer moved to; retry there.
+        } else if (diff < 0) {
+            // Full: the reader has not handed this slot back yet.
+            __atomic_add_fetch(&g_dropped, 1, __ATOMIC_RELAXED);
+            return true;
+        } else {
+            pos = __atomic_load_n(&g_head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Caller holds g_out_lock.
+void ring_drain_locked() {
+    if (!g_slots) return;
+
+    while (true) {
+        LogSlot& slot = g_slots[g_tail & kMask];
+        if (__atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) != g_tail + 1) break;
+        if (slot.deferred) {
+            char line[kLineBytes];
+            format_deferred((const uint8_t*)slot.text, slot.len, line, sizeof(line));
+            write_out_locked(line);
+        } else {
+            write_out_locked(slot.text);
+        }
+        __atomic_store_n(&slot.seq, g_tail + kSlots, __ATOMIC_RELEASE);
+        g_tail++;
+    }
+
+    const uint32_t dropped = __atomic_load_n(&g_dropped, __ATOMIC_RELAXED);
+    if (dropped != g_dropped_reported) {
+        char line[64];
+        snprintf(line, sizeof(line), "[Log] %lu lines dropped (ring full)\n", (unsigned long)(dropped - g_dropped_reported));
+        write_out_locked(line);
+        g_dropped_reported = dropped;
+    }
+}
+
+void drain_task(void*) {
+    while (true) {
+        // A producer preempted between claiming and publishing a slot holds
+        // the reader up; the timeout picks its line up once it is done.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        if (xSemaphoreTake(g_out_lock, portMAX_DELAY) == pdTRUE) {
+            ring_drain_locked();
+            const LogSink* sink = __atomic_load_n(&g_sink, __ATOMIC_ACQUIRE);
+            if (sink && sink->idle) sink->idle(millis());
+            xSemaphoreGive(g_out_lock);
+        }
+    }
+}
+
+void flush_on_shutdown() {
+    Logger.flush();
+}
+
+bool ring_start() {
+    if (g_slots) return true;
+
+    const size_t bytes = sizeof(LogSlot) * kSlots;
+    LogSlot* slots = nullptr;
+    if (psramFound()) {
+        slots = (LogSlot*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!slots) {
+        slots = (LogSlot*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!slots) return false;
+    for (uint32_t i = 0; i < kSlots; i++) {
+        slots[i].seq = i;
+        slots[i].len = 0;
+    }
+
+    g_out_lock = xSemaphoreCreateMutex();
+    if (!g_out_lock) {
+        heap_caps_free(slots);
+        return false;
+    }
+
+    if (task_placement_create(drain_task, "LogDrain", LOG_TASK_STACK_BYTES, nullptr, LOG_TASK_PRIORITY, &g_drain_task, LOG_TASK_CORE) != pdPASS) {
+        vSemaphoreDelete(g_out_lock);
+        g_out_lock = nullptr;
+        g_drain_task = nullptr;
+        heap_caps_free(slots);
+        return false;
+    }
+
+    esp_register_shutdown_handler(flush_on_shutdown);
+    __atomic_store_n(&g_slots, slots, __ATOMIC_RELEASE);
+    return true;
+}
+
+#endif // LOG_ASYNC_ENABLED
+
+// Every formatted line goes through here.
+void log_emit(const char* line) {
+#if LOG_ASYNC_ENABLED
+    size_t len = strlen(line);
+    if (len > kLineBytes - 1) len = kLineBytes - 1;
+    if (ring_push(line, len, false)) return;
+#endif
+    // Before begin() (or without a ring): straight to serial.
+    log_write_line(line);
+}
+
+void log_emit_deferred(const uint8_t* rec, size_t len) {
+#if LOG_ASYNC_ENABLED
+    if (ring_push((const char*)rec, len, true)) return;
+#endif
+    char line[kLineBytes];
+    format_deferred(rec, len, line, sizeof(line));
+    log_write_line(line);
 }
 
-// Initialize static members
-unsigned long LogManager::startTimes[3] = {0, 0, 0};
-uint8_t LogManager::nestLevel = 0;
+}
 
 // Global LogManager instance
 LogManager Logger;
@@ -62,44 +406,85 @@ void LogManager::begin(unsigned long baud) {
 #else
     Serial.begin(baud);
 #endif
+
+#if LOG_ASYNC_ENABLED
+    if (ring_start()) {
+        logMessagef("Log", "Async output: %u line ring", (unsigned)LOG_RING_LINES);
+    } else {
+        logMessage("Log", "No memory for the log ring; writing synchronously");
+    }
+#endif
+}
+
+void LogManager::flush() {
+#if LOG_ASYNC_ENABLED
+    if (!g_out_lock) return;
+    if (xSemaphoreTake(g_out_lock, pdMS_TO_TICKS(200)) != pdTRUE) return;
+    ring_drain_locked();
+    xSemaphoreGive(g_out_lock);
+#endif
+}
+
+void LogManager::setSink(const LogSink* sink) {
+#if LOG_ASYNC_ENABLED
+    __atomic_store_n(&g_sink, sink, __ATOMIC_RELEASE);
+#else
+    (void)sink;
+#endif
+}
+
+uint32_t LogManager::dropped() const {
+#if LOG_ASYNC_ENABLED
+    return __atomic_load_n(&g_dropped, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
+uint8_t LogManager::nestLevel() {
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint8_t level = 0;
+    portENTER_CRITICAL(&g_nest_mux);
+    if (NestState* st = nest_find(self, false)) level = st->level;
+    portEXIT_CRITICAL(&g_nest_mux);
+    return level;
 }
 
 // Get indentation string based on nesting level
-const char* LogManager::indent() {
-    static const char* indents[] = {
-        "",         // Level 0: no indent
-        "  ",       // Level 1: 2 spaces
-        "    ",     // Level 2: 4 spaces
-        "      "    // Level 3+: 6 spaces
-    };
-    
-    uint8_t level = nestLevel;
-    if (level > 3) level = 3; // Cap at 3 for indentation
-    return indents[level];
+const char* LogManager::indent(uint8_t level) {
+    return indent_for(level);
 }
 
 // Begin a log block - atomic write
 void LogManager::logBegin(const char* module) {
-    char line[128];
-    snprintf(line, sizeof(line), "%s[%s] Starting...\n", indent(), module);
-    log_write_line(line);
-    
-    // Save start time if we haven't exceeded max depth
-    if (nestLevel < 3) {
-        startTimes[nestLevel] = millis();
-    }
-    
-    // Increment nesting level (but don't overflow)
-    if (nestLevel < 255) {
-        nestLevel++;
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    const unsigned long now = millis();
+    uint8_t level = 0;
+
+    portENTER_CRITICAL(&g_nest_mux);
+    if (NestState* st = nest_find(self, true)) {
+        level = st->level;
+        // Save start time if we haven't exceeded max depth
+        if (level < 3) {
+            st->start[level] = now;
+        }
+        // Increment nesting level (but don't overflow)
+        if (st->level < 255) {
+            st->level++;
+        }
     }
+    portEXIT_CRITICAL(&g_nest_mux);
+
+    char line[128];
+    snprintf(line, sizeof(line), "%s[%s] Starting...\n", indent(level), module);
+    log_emit(line);
 }
 
 // Add a line to current block - atomic write
 void LogManager::logLine(const char* message) {
     char line[160];
-    snprintf(line, sizeof(line), "%s%s\n", indent(), message);
-    log_write_line(line);
+    snprintf(line, sizeof(line), "%s%s\n", indent(nestLevel()), message);
+    log_emit(line);
 }
 
 // Add a formatted line (printf-style) - atomic write
@@ -111,39 +496,49 @@ void LogManager::logLinef(const char* format, ...) {
     va_end(args);
     
     char line[160];
-    snprintf(line, sizeof(line), "%s%s\n", indent(), msgbuf);
-    log_write_line(line);
+    snprintf(line, sizeof(line), "%s%s\n", indent(nestLevel()), msgbuf);
+    log_emit(line);
 }
 
 // End a log block - atomic write
 void LogManager::logEnd(const char* message) {
-    // Decrement nesting level first (but don't underflow)
-    if (nestLevel > 0) {
-        nestLevel--;
-    } else {
+    const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    const unsigned long now = millis();
+    uint8_t level = 0;
+    unsigned long elapsed = 0;
+
+    portENTER_CRITICAL(&g_nest_mux);
+    NestState* st = nest_find(self, false);
+    if (!st || st->level == 0) {
         // Extra end() calls are ignored gracefully
+        portEXIT_CRITICAL(&g_nest_mux);
         return;
     }
-    
+    // Decrement nesting level first
+    st->level--;
+    level = st->level;
     // Calculate elapsed time (0ms if we exceeded max depth)
-    unsigned long elapsed = 0;
-    if (nestLevel < 3) {
-        elapsed = millis() - startTimes[nestLevel];
+    if (level < 3) {
+        elapsed = now - st->start[level];
     }
+    if (level == 0) {
+        st->task = nullptr;
+    }
+    portEXIT_CRITICAL(&g_nest_mux);
     
     // Print end message with timing - atomic
     const char* msg = (message && strlen(message) > 0) ? message : "Done";
     char line[128];
-    snprintf(line, sizeof(line), "%s%s (%lums)\n", indent(), msg, elapsed);
-    log_write_line(line);
+    snprintf(line, sizeof(line), "%s%s (%lums)\n", indent(level), msg, elapsed);
+    log_emit(line);
 }
 
 // Single-line logging with timing - atomic write to prevent interleaving
 void LogManager::logMessage(const char* module, const char* msg) {
     unsigned long start = millis();
     char line[192];
-    snprintf(line, sizeof(line), "%s[%s] %s (%lums)\n", indent(), module, msg, millis() - start);
-    log_write_line(line);
+    snprintf(line, sizeof(line), "%s[%s] %s (%lums)\n", indent(nestLevel()), module, msg, millis() - start);
+    log_emit(line);
 }
 
 void LogManager::logMessagef(const char* module, const char* format, ...) {
@@ -156,8 +551,19 @@ void LogManager::logMessagef(const char* module, const char* format, ...) {
     va_end(args);
     
     char line[192];
-    snprintf(line, sizeof(line), "%s[%s] %s (%lums)\n", indent(), module, msgbuf, millis() - start);
-    log_write_line(line);
+    snprintf(line, sizeof(line), "%s[%s] %s (%lums)\n", indent(nestLevel()), module, msgbuf, millis() - start);
+    log_emit(line);
+}
+
+void LogManager::logRecord(const char* module, const char* format, const uint8_t* args, size_t args_len) {
+    uint8_t rec[kDeferredHeader + LOGGER_DEFERRED_ARG_BYTES];
+    if (args_len > LOGGER_DEFERRED_ARG_BYTES) args_len = LOGGER_DEFERRED_ARG_BYTES;
+    const uint8_t level = nestLevel();
+    memcpy(rec, &module, sizeof(module));
+    memcpy(rec + sizeof(module), &format, sizeof(format));
+    rec[sizeof(module) + sizeof(format)] = level;
+    memcpy(rec + kDeferredHeader, args, args_len);
+    log_emit_deferred(rec, kDeferredHeader + args_len);
 }
 
 // Aliases for logMessage (for backward compatibility)
@@ -176,12 +582,20 @@ void LogManager::logQuickf(const char* module, const char* format, ...) {
 
 // Write single byte (required by Print class)
 size_t LogManager::write(uint8_t c) {
-    if (!serial_ready_for_logging()) return 1;
-    return Serial.write(c);
+    return write(&c, 1);
 }
 
-// Write buffer of bytes (required by Print class)
+// Write buffer of bytes (required by Print class). Raw writes bypass the
+// ring; queued lines go out first so the order holds.
 size_t LogManager::write(const uint8_t *buffer, size_t size) {
     if (!serial_ready_for_logging()) return size;
+#if LOG_ASYNC_ENABLED
+    if (g_out_lock && xSemaphoreTake(g_out_lock, portMAX_DELAY) == pdTRUE) {
+        ring_drain_locked();
+        const size_t n = Serial.write(buffer, size);
+        xSemaphoreGive(g_out_lock);
+        return n;
+    }
+#endif
     return Serial.write(buffer, size);
 }
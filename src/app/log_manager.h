@@ -5,12 +5,116 @@
  * - Nested blocks with automatic indentation
  * - Automatic timing for each block
  * - Printf-style formatting
+ * - Asynchronous output (LOG_ASYNC_ENABLED): lines are formatted by the
+ *   caller into a lock-free ring and written to serial by a low-priority
+ *   task, so a slow or absent USB host never stalls the caller. Lines that
+ *   find the ring full are dropped and counted.
+ * - Leveled one-line macros (LOGE/LOGW/LOGI/LOGD/LOGV) checked at compile
+ *   time against LOGGER_MODULE_LEVEL; with LOG_BINARY_ENABLED they record the
+ *   format pointer and raw arguments and leave formatting to the drain task.
  */
 
 #ifndef LOG_MANAGER_H
 #define LOG_MANAGER_H
 
 #include <Arduino.h>
+#include <string.h>
+#include <type_traits>
+
+#include "board_config.h"
+
+// Levels for LOG_LEVEL and the per-module LOG_LEVEL_* flags.
+#define LOGGER_NONE 0
+#define LOGGER_ERROR 1
+#define LOGGER_WARN 2
+#define LOGGER_INFO 3
+#define LOGGER_DEBUG 4
+#define LOGGER_VERBOSE 5
+
+// A translation unit picks its module's level by defining this before its
+// first include, e.g. #define LOGGER_MODULE_LEVEL LOG_LEVEL_DISPLAY.
+#ifndef LOGGER_MODULE_LEVEL
+#define LOGGER_MODULE_LEVEL LOG_LEVEL
+#endif
+
+// Argument bytes one deferred record can carry (strings are copied in).
+static constexpr size_t LOGGER_DEFERRED_ARG_BYTES = 160;
+
+// Packs printf arguments for a deferred record: a type byte, then the raw
+// value (4 bytes for up-to-32-bit integers and pointers, 8 for 64-bit
+// integers and doubles, length + bytes + NUL for strings).
+struct LogArgPacker {
+    enum Tag : uint8_t { Int32 = 1, Int64, Double, Str, Ptr };
+
+    uint8_t* buf;
+    size_t cap;
+    size_t len = 0;
+    bool truncated = false;
+
+    LogArgPacker(uint8_t* b, size_t c) : buf(b), cap(c) {}
+
+    bool put(uint8_t tag, const void* v, size_t n) {
+        if (truncated || len + 1 + n > cap) {
+            truncated = true;
+            return false;
+        }
+        buf[len++] = tag;
+        memcpy(buf + len, v, n);
+        len += n;
+        return true;
+    }
+
+    void putString(const char* s) {
+        if (!s) s = "(null)";
+        if (truncated || len + 3 > cap) {
+            truncated = true;
+            return;
+        }
+        size_t n = strlen(s);
+        const size_t room = cap - len - 3;
+        if (n > room) n = room;
+        if (n > 255) n = 255;
+        buf[len++] = Str;
+        buf[len++] = (uint8_t)n;
+        memcpy(buf + len, s, n);
+        len += n;
+        buf[len++] = '\0';
+    }
+
+    template <typename T>
+    void add(T v) {
+        if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value) {
+            putString(v);
+        } else if constexpr (std::is_floating_point<T>::value) {
+            const double d = (double)v;
+            put(Double, &d, sizeof(d));
+        } else if constexpr (std::is_enum<T>::value) {
+            add((typename std::underlying_type<T>::type)v);
+        } else if constexpr (std::is_integral<T>::value && sizeof(T) > 4) {
+            const uint64_t u = (uint64_t)v;
+            put(Int64, &u, sizeof(u));
+        } else if constexpr (std::is_integral<T>::value) {
+            // Sign- or zero-extended the way printf's int promotion would.
+            const uint32_t u = std::is_signed<T>::value ? (uint32_t)(int32_t)v : (uint32_t)v;
+            put(Int32, &u, sizeof(u));
+        } else if constexpr (std::is_pointer<T>::value) {
+            const uint32_t u = (uint32_t)(uintptr_t)v;
+            put(Ptr, &u, sizeof(u));
+        } else {
+            static_assert(std::is_pointer<T>::value, "LOG*() arguments must be printf-compatible");
+        }
+    }
+};
+
+// Second destination for the queued lines (network streaming). Both calls
+// run with the log output lock held: line() for every line after it reached
+// serial (on the drain task, or on a task flushing the ring), idle() on the
+// drain task after each round (at least every 100 ms). They must not block
+// for long and must not log.
+struct LogSink {
+    void (*line)(const char* text, size_t len);
+    void (*idle)(uint32_t now_ms);
+};
 
 class LogManager : public Print {
 public:
@@ -36,17 +140,69 @@ public:
     // Single-line logging with timing (no nesting)
     void logQuick(const char* module, const char* message);
     void logQuickf(const char* module, const char* format, ...);
+
+    // Same line as logMessagef, but formatted later (by the drain task when
+    // the ring is up). format must be a string literal; string arguments are
+    // copied. Used by the LOG* macros with LOG_BINARY_ENABLED.
+    template <typename... Args>
+    void logDeferred(const char* module, const char* format, Args... args) {
+        uint8_t buf[LOGGER_DEFERRED_ARG_BYTES];
+        LogArgPacker packer(buf, sizeof(buf));
+        (packer.add(args), ...);
+        logRecord(module, format, buf, packer.len);
+    }
+
+    // Write out everything queued so far (blocks the caller). Also runs on
+    // restart via a shutdown handler.
+    void flush() override;
+
+    // Lines dropped because the ring was full.
+    uint32_t dropped() const;
+
+    // Install (or clear with nullptr) the second destination. Needs
+    // LOG_ASYNC_ENABLED; sink must stay valid.
+    void setSink(const LogSink* sink);
     
 private:
-    // Nested block tracking
-    static unsigned long startTimes[3];  // Start time for each nesting level
-    static uint8_t nestLevel;            // Current nesting depth (0-2, 3+ = overflow)
-    
-    // Helper methods
-    const char* indent();                // Get indentation string for current level
+    void logRecord(const char* module, const char* format, const uint8_t* args, size_t args_len);
+
+    // Nesting is tracked per task (logBegin/logEnd pairs on different tasks
+    // don't disturb each other's indentation or timing).
+    static uint8_t nestLevel();
+    static const char* indent(uint8_t level);
 };
 
 // Global instance (to replace Serial usage)
 extern LogManager Logger;
 
+// Only here so the compiler checks LOG*() formats against their arguments.
+inline void logger_format_check(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void logger_format_check(const char*, ...) {}
+
+// One-line messages at a level: LOGI("Display", "Switched to %s", id).
+// Levels above the module's compile to nothing.
+#if LOG_BINARY_ENABLED
+#define LOGGER_AT(level, module, ...) \
+    do { \
+        if (LOGGER_MODULE_LEVEL >= (level)) { \
+            if (false) logger_format_check(__VA_ARGS__); \
+            Logger.logDeferred(module, __VA_ARGS__); \
+        } \
+    } while (0)
+#else
+#define LOGGER_AT(level, module, ...) \
+    do { \
+        if (LOGGER_MODULE_LEVEL >= (level)) { \
+            if (false) logger_format_check(__VA_ARGS__); \
+            Logger.logMessagef(module, __VA_ARGS__); \
+        } \
+    } while (0)
+#endif
+
+#define LOGE(module, ...) LOGGER_AT(LOGGER_ERROR, module, __VA_ARGS__)
+#define LOGW(module, ...) LOGGER_AT(LOGGER_WARN, module, __VA_ARGS__)
+#define LOGI(module, ...) LOGGER_AT(LOGGER_INFO, module, __VA_ARGS__)
+#define LOGD(module, ...) LOGGER_AT(LOGGER_DEBUG, module, __VA_ARGS__)
+#define LOGV(module, ...) LOGGER_AT(LOGGER_VERBOSE, module, __VA_ARGS__)
+
 #endif // LOG_MANAGER_H
@@ -0,0 +1,209 @@
+#include "log_stream.h"
+
+#if LOG_STREAM_ENABLED && LOG_ASYNC_ENABLED
+
+#include "log_manager.h"
+#include "project_branding.h"
+
+#include <WiFi.h>
+#include <errno.h>
+#include <freertos/FreeRTOS.h>
+#include <lwip/sockets.h>
+
+namespace {
+
+constexpr uint16_t kDefaultPort = 514;
+
+// A host name that does not resolve is tried again after this long (ms).
+constexpr uint32_t kResolveRetryMs = 30000;
+
+static_assert(LOG_STREAM_MAX_BYTES_PER_S >= LOG_STREAM_DATAGRAM_BYTES, "the rate budget must fit one datagram");
+
+// Written by log_stream_configure() on any task, picked up under the log
+// output lock.
+portMUX_TYPE g_cfg_mux = portMUX_INITIALIZER_UNLOCKED;
+char g_cfg_host[CONFIG_LOG_STREAM_HOST_MAX_LEN] = {};
+uint16_t g_cfg_port = 0;
+char g_cfg_name[CONFIG_DEVICE_NAME_MAX_LEN] = {};
+volatile bool g_cfg_pending = false;
+
+// Everything below runs with the log output lock held.
+char g_host[CONFIG_LOG_STREAM_HOST_MAX_LEN] = {};
+uint16_t g_port = 0;
+char g_name[CONFIG_DEVICE_NAME_MAX_LEN] = {};
+
+int g_sock = -1;
+sockaddr_in g_dest = {};
+bool g_resolved = false;
+uint32_t g_resolve_at_ms = 0;
+
+char g_batch[LOG_STREAM_DATAGRAM_BYTES];
+size_t g_header_len = 0;
+size_t g_batch_len = 0;
+uint32_t g_batch_lines = 0;
+uint32_t g_batch_started_ms = 0;
+
+// Token bucket in bytes, refilled at LOG_STREAM_MAX_BYTES_PER_S up to one
+// second's worth.
+uint32_t g_tokens = LOG_STREAM_MAX_BYTES_PER_S;
+uint32_t g_refill_ms = 0;
+
+LogStreamStats g_stats = {};
+
+void close_socket() {
+    if (g_sock >= 0) {
+        close(g_sock);
+        g_sock = -1;
+    }
+    g_resolved = false;
+    g_stats.active = false;
+}
+
+void apply_pending() {
+    if (!g_cfg_pending) return;
+    portENTER_CRITICAL(&g_cfg_mux);
+    memcpy(g_host, g_cfg_host, sizeof(g_host));
+    memcpy(g_name, g_cfg_name, sizeof(g_name));
+    g_port = g_cfg_port ? g_cfg_port : kDefaultPort;
+    g_cfg_pending = false;
+    portEXIT_CRITICAL(&g_cfg_mux);
+
+    close_socket();
+    g_batch_len = 0;
+    g_batch_lines = 0;
+    g_resolve_at_ms = 0;
+}
+
+bool resolve(uint32_t now_ms) {
+    if (g_resolved) return true;
+    if (!g_host[0] || (int32_t)(now_ms - g_resolve_at_ms) < 0) return false;
+    if (!WiFi.isConnected()) return false;
+
+    // hostByName blocks on DNS. Callers that log only queue into the ring
+    // meanwhile; flush() and raw writes wait for the output lock.
+    IPAddress ip;
+    if (!ip.fromString(g_host) && !WiFi.hostByName(g_host, ip)) {
+        g_resolve_at_ms = now_ms + kResolveRetryMs;
+        return false;
+    }
+
+    if (g_sock < 0) {
+        g_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (g_sock < 0) {
+            g_resolve_at_ms = now_ms + kResolveRetryMs;
+            return false;
+        }
+    }
+    memset(&g_dest, 0, sizeof(g_dest));
+    g_dest.sin_family = AF_INET;
+    g_dest.sin_port = htons(g_port);
+    g_dest.sin_addr.s_addr = (uint32_t)ip;
+    g_resolved = true;
+    g_stats.active = true;
+    return true;
+}
+
+void refill(uint32_t now_ms) {
+    const uint32_t elapsed = now_ms - g_refill_ms;
+    const uint32_t add = (uint32_t)(((uint64_t)elapsed * LOG_STREAM_MAX_BYTES_PER_S) / 1000);
+    if (add == 0) return;
+    g_refill_ms = now_ms;
+    g_tokens = (g_tokens + add > LOG_STREAM_MAX_BYTES_PER_S) ? LOG_STREAM_MAX_BYTES_PER_S : g_tokens + add;
+}
+
+// RFC 5424 header with nil timestamp (the clock may not be set): severity
+// info, facility user; the receiver stamps arrival time.
+void start_batch(uint32_t now_ms) {
+    const int n = snprintf(g_batch, sizeof(g_batch), "<14>1 - %s %s - - - ", g_name[0] ? g_name : "-", PROJECT_NAME);
+    g_header_len = (n > 0 && (size_t)n < sizeof(g_batch)) ? (size_t)n : 0;
+    g_batch_len = g_header_len;
+    g_batch_lines = 0;
+    g_batch_started_ms = now_ms;
+}
+
+void send_batch(uint32_t now_ms) {
+    if (g_batch_lines == 0) {
+        g_batch_len = 0;
+        return;
+    }
+
+    size_t len = g_batch_len;
+    if (len > g_header_len && g_batch[len - 1] == '\n') len--;
+
+    refill(now_ms);
+    bool sent = false;
+    if (g_resolved && g_tokens >= len && WiFi.isConnected()) {
+        const int r = sendto(g_sock, g_batch, len, MSG_DONTWAIT, (const sockaddr*)&g_dest, sizeof(g_dest));
+        if (r >= 0) {
+            sent = true;
+            g_tokens -= (uint32_t)len;
+            g_stats.datagrams++;
+            g_stats.bytes += (uint32_t)len;
+        } else if (errno != EAGAIN && errno != ENOMEM) {
+            // The route or the address may have changed; look the host up again.
+            close_socket();
+            g_resolve_at_ms = now_ms + kResolveRetryMs;
+        }
+    }
+    if (!sent) g_stats.dropped_lines += g_batch_lines;
+
+    g_batch_len = 0;
+    g_batch_lines = 0;
+}
+
+void on_line(const char* text, size_t len) {
+    apply_pending();
+    if (!g_host[0]) return;
+    if (!g_resolved) {
+        g_stats.dropped_lines++;
+        return;
+    }
+
+    const uint32_t now = millis();
+    if (g_batch_len == 0) start_batch(now);
+    if (g_batch_len + len > sizeof(g_batch) && g_batch_lines > 0) {
+        send_batch(now);
+        start_batch(now);
+    }
+    const size_t room = sizeof(g_batch) - g_batch_len;
+    const size_t n = len < room ? len : room;
+    memcpy(g_batch + g_batch_len, text, n);
+    g_batch_len += n;
+    g_batch_lines++;
+}
+
+void on_idle(uint32_t now_ms) {
+    apply_pending();
+    if (!g_host[0]) return;
+    resolve(now_ms);
+    if (g_batch_lines > 0 && now_ms - g_batch_started_ms >= LOG_STREAM_BATCH_MS) {
+        send_batch(now_ms);
+    }
+}
+
+const LogSink kSink = {on_line, on_idle};
+
+} // namespace
+
+void log_stream_configure(const DeviceConfig* config) {
+    if (!config) return;
+
+    char name[CONFIG_DEVICE_NAME_MAX_LEN];
+    config_manager_sanitize_device_name(config->device_name, name, sizeof(name));
+
+    portENTER_CRITICAL(&g_cfg_mux);
+    strlcpy(g_cfg_host, config->log_stream_host, sizeof(g_cfg_host));
+    g_cfg_port = config->log_stream_port;
+    strlcpy(g_cfg_name, name, sizeof(g_cfg_name));
+    g_cfg_pending = true;
+    portEXIT_CRITICAL(&g_cfg_mux);
+
+    // The sink stays installed once set; with an empty host it returns at once.
+    if (config->log_stream_host[0]) Logger.setSink(&kSink);
+}
+
+void log_stream_get_stats(LogStreamStats* out) {
+    *out = g_stats;
+}
+
+#endif // LOG_STREAM_ENABLED && LOG_ASYNC_ENABLED
@@ -0,0 +1,45 @@
+#ifndef LOG_STREAM_H
+#define LOG_STREAM_H
+
+#include "board_config.h"
+#include "config_manager.h"
+
+// Network Log Streaming (LOG_STREAM_ENABLED)
+// Copies the lines leaving the log ring to a UDP syslog receiver
+// (DeviceConfig log_stream_host / log_stream_port, set through /api/config),
+// so a device nobody has plugged in can still be debugged.
+//
+// Lines are batched: one datagram (at most LOG_STREAM_DATAGRAM_BYTES) carries
+// every line queued within LOG_STREAM_BATCH_MS under a single RFC 5424
+// header. Sending is capped at LOG_STREAM_MAX_BYTES_PER_S; batches over the
+// budget are dropped and counted, and serial output is unaffected. All of it
+// runs on the low-priority log drain task with non-blocking sends, so
+// streaming never holds up AsyncTCP or the callers that log.
+//
+// Needs LOG_ASYNC_ENABLED.
+
+#include <Arduino.h>
+
+struct LogStreamStats {
+    bool active;           // a target is configured and resolved
+    uint32_t datagrams;
+    uint32_t bytes;
+    uint32_t dropped_lines;   // over the rate budget, no WiFi, or send failed
+};
+
+#if LOG_STREAM_ENABLED && LOG_ASYNC_ENABLED
+
+// Apply the target from config (empty host = off). Any task; takes effect on
+// the drain task's next round.
+void log_stream_configure(const DeviceConfig* config);
+
+void log_stream_get_stats(LogStreamStats* out);
+
+#else
+
+inline void log_stream_configure(const DeviceConfig*) {}
+inline void log_stream_get_stats(LogStreamStats* out) { *out = LogStreamStats{}; }
+
+#endif
+
+#endif // LOG_STREAM_H
@@ -0,0 +1,162 @@
+#include "loop_scheduler.h"
+
+#include "device_telemetry.h"
+#include "log_manager.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace {
+
+struct Entry {
+    LoopSchedulerFn fn;
+    uint32_t due_ms;
+    uint32_t interval_ms;   // last requested interval (for overrun accounting)
+    bool idle;              // waiting for an event only
+    bool run_on_event;
+    LoopSchedulerEntryStats stats;
+};
+
+Entry g_entries[LOOP_SCHEDULER_MAX_ENTRIES] = {};
+uint8_t g_count = 0;
+TaskHandle_t g_loop_task = nullptr;
+volatile bool g_event_pending = false;
+
+portMUX_TYPE g_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+LoopSchedulerStats g_stats = {};
+
+void schedule_next(Entry& e, uint32_t now, uint32_t next_ms) {
+    if (next_ms == LOOP_SCHEDULER_IDLE) {
+        e.idle = true;
+        return;
+    }
+    e.idle = false;
+    e.interval_ms = next_ms;
+    e.due_ms = now + next_ms;
+}
+
+void run_entry(Entry& e, uint32_t now, bool from_event) {
+    const bool late = !from_event && !e.idle && (int32_t)(now - e.due_ms) > (int32_t)LOOP_SCHEDULER_LATE_MS;
+
+    const int64_t t0 = esp_timer_get_time();
+    const uint32_t next = e.fn(now);
+    const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+
+    portENTER_CRITICAL(&g_stats_mux);
+    e.stats.runs++;
+    e.stats.total_us += us;
+    if (us > e.stats.max_us) e.stats.max_us = us;
+    if (late) e.stats.late++;
+    if (e.interval_ms > 0 && us / 1000 > e.interval_ms) e.stats.overruns++;
+    portEXIT_CRITICAL(&g_stats_mux);
+
+    schedule_next(e, now, next);
+}
+
+} // namespace
+
+void loop_scheduler_init() {
+    g_loop_task = xTaskGetCurrentTaskHandle();
+}
+
+bool loop_scheduler_add(const char* name, LoopSchedulerFn fn, uint32_t first_delay_ms, bool run_on_event) {
+    if (!fn) return false;
+    if (g_count >= LOOP_SCHEDULER_MAX_ENTRIES) {
+        Logger.logMessagef("Sched", "ERROR: no slot for %s (LOOP_SCHEDULER_MAX_ENTRIES)", name ? name : "?");
+        return false;
+    }
+    Entry& e = g_entries[g_count];
+    e = {};
+    e.fn = fn;
+    e.run_on_event = run_on_event;
+    e.stats.name = name;
+    schedule_next(e, millis(), first_delay_ms);
+    g_count++;
+    g_stats.entries = g_count;
+    return true;
+}
+
+void loop_scheduler_notify() {
+    g_event_pending = true;
+    if (g_loop_task) xTaskNotifyGive(g_loop_task);
+}
+
+void loop_scheduler_notify_from_isr() {
+    g_event_pending = true;
+    if (!g_loop_task) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(g_loop_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void loop_scheduler_run() {
+    const bool event = g_event_pending;
+    g_event_pending = false;
+
+    const int64_t pass_start_us = esp_timer_get_time();
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < g_count; i++) {
+        Entry& e = g_entries[i];
+        if (event && e.run_on_event) {
+            run_entry(e, now, true);
+        } else if (!e.idle && (int32_t)(now - e.due_ms) >= 0) {
+            run_entry(e, now, false);
+        }
+    }
+
+    const uint32_t pass_us = (uint32_t)(esp_timer_get_time() - pass_start_us);
+    device_telemetry_note_latency(HealthLatency::LoopPass, pass_us, pass_us > (uint32_t)LOOP_PASS_BUDGET_US);
+
+    // Sleep until the nearest deadline (capped, so a lost event costs at most
+    // LOOP_SCHEDULER_MAX_SLEEP_MS).
+    now = millis();
+    uint32_t wait_ms = LOOP_SCHEDULER_MAX_SLEEP_MS;
+    for (uint8_t i = 0; i < g_count; i++) {
+        const Entry& e = g_entries[i];
+        if (e.idle) continue;
+        const int32_t left = (int32_t)(e.due_ms - now);
+        if (left <= 0) {
+            wait_ms = 0;
+            break;
+        }
+        if ((uint32_t)left < wait_ms) wait_ms = (uint32_t)left;
+    }
+
+    uint32_t took = 0;
+    if (g_event_pending) {
+        // Posted while the entries ran; handle it on the next pass.
+    } else if (wait_ms == 0) {
+        // Something is already due: let equal-priority tasks run, then go again.
+        taskYIELD();
+    } else {
+        const uint32_t t0 = millis();
+        // Returns early on loop_scheduler_notify().
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms) ? pdMS_TO_TICKS(wait_ms) : 1);
+        took = millis() - t0;
+    }
+
+    portENTER_CRITICAL(&g_stats_mux);
+    g_stats.passes++;
+    if (event) g_stats.events++;
+    g_stats.sleep_ms += took;
+    portEXIT_CRITICAL(&g_stats_mux);
+}
+
+void loop_scheduler_get_stats(LoopSchedulerStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_stats_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_stats_mux);
+}
+
+size_t loop_scheduler_get_entry_stats(LoopSchedulerEntryStats* out, size_t max) {
+    if (!out) return 0;
+    size_t n = 0;
+    portENTER_CRITICAL(&g_stats_mux);
+    for (uint8_t i = 0; i < g_count && n < max; i++) {
+        out[n++] = g_entries[i].stats;
+    }
+    portEXIT_CRITICAL(&g_stats_mux);
+    return n;
+}
@@ -0,0 +1,57 @@
+#ifndef LOOP_SCHEDULER_H
+#define LOOP_SCHEDULER_H
+
+#include <Arduino.h>
+#include "board_config.h"
+
+// Loop Scheduler
+// Cooperative scheduler for the Arduino loop task. Subsystems register a
+// callback that returns how long (ms) until it wants to run again, so each one
+// runs at its own cadence instead of everyone's worst case. loop() then blocks
+// until the nearest deadline or until another task posts an event
+// (loop_scheduler_notify()), which also runs the entries registered with
+// run_on_event right away.
+//
+// Entries live in a fixed table (LOOP_SCHEDULER_MAX_ENTRIES) scanned once per
+// pass; with a dozen entries that is cheaper than any timer structure.
+
+// Return value for "do not run again until an event arrives".
+static constexpr uint32_t LOOP_SCHEDULER_IDLE = 0xFFFFFFFFu;
+
+// now_ms is the pass start time. Returns ms until the next run (0 = next pass).
+typedef uint32_t (*LoopSchedulerFn)(uint32_t now_ms);
+
+struct LoopSchedulerEntryStats {
+    const char* name;
+    uint32_t runs;
+    uint32_t total_us;
+    uint32_t max_us;
+    uint32_t late;       // started more than LOOP_SCHEDULER_LATE_MS after its deadline
+    uint32_t overruns;   // ran longer than the interval it asked for
+};
+
+struct LoopSchedulerStats {
+    uint32_t passes;
+    uint32_t events;       // loop_scheduler_notify() wakeups consumed
+    uint32_t sleep_ms;     // time spent blocked between passes
+    uint8_t entries;
+};
+
+// Capture the loop task (call from setup()).
+void loop_scheduler_init();
+
+// Register a callback; first run after first_delay_ms. Returns false when full.
+bool loop_scheduler_add(const char* name, LoopSchedulerFn fn, uint32_t first_delay_ms, bool run_on_event = false);
+
+// Wake the loop task (any task). Entries registered with run_on_event run next pass.
+void loop_scheduler_notify();
+void loop_scheduler_notify_from_isr();
+
+// Run due entries, then block until the next deadline or event. Call from loop().
+void loop_scheduler_run();
+
+void loop_scheduler_get_stats(LoopSchedulerStats* out);
+// Copies up to max entries; returns the number written.
+size_t loop_scheduler_get_entry_stats(LoopSchedulerEntryStats* out, size_t max);
+
+#endif // LOOP_SCHEDULER_H
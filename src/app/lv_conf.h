@@ -25,7 +25,12 @@
 #define LV_COLOR_DEPTH 16
 
 /* Swap the 2 bytes of RGB565 color. Useful if the display has a 8 bit interface (e.g. SPI)*/
+/* Controlled per board via LVGL_COLOR_16_SWAP (see DisplayDriver::pixelOrder()). */
+#if LVGL_COLOR_16_SWAP
+#define LV_COLOR_16_SWAP 1
+#else
 #define LV_COLOR_16_SWAP 0
+#endif
 
 /* Enable features to draw on transparent background */
 #define LV_COLOR_SCREEN_TRANSP 0
@@ -145,8 +150,9 @@
 // Image widget support is needed for either:
 // - Image API's optional LVGL image screen (HAS_IMAGE_API)
 // - Macro button icons (HAS_ICONS)
+// - Pre-rendered macro labels (LABEL_CACHE_ENABLED)
 // Keep it disabled by default to reduce flash size in template builds.
-#if HAS_IMAGE_API || HAS_ICONS
+#if HAS_IMAGE_API || HAS_ICONS || (HAS_DISPLAY && LABEL_CACHE_ENABLED)
   #ifndef LV_USE_IMG
     #define LV_USE_IMG        1
   #endif
@@ -196,6 +202,21 @@
 #define LV_USE_TILEVIEW                  0
 #define LV_USE_WIN                       0
 
+/*==================
+ * FILE SYSTEM
+ *==================*/
+
+/* stdio driver for lv_font_load() (label_font.h): "F:/fonts/label.bin" opens /ffat/fonts/label.bin.
+ * The cache batches the loader's many small reads. */
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+  #define LV_USE_FS_STDIO 1
+  #define LV_FS_STDIO_LETTER 'F'
+  #define LV_FS_STDIO_PATH "/ffat"
+  #define LV_FS_STDIO_CACHE_SIZE 2048
+#else
+  #define LV_USE_FS_STDIO 0
+#endif
+
 /*==================
  * THEMES
  *==================*/
@@ -256,6 +277,13 @@
   #endif
 #endif
 
+/* lv_snapshot: the screen an image covers is kept for an instant return (IMAGE_API_RETURN_SNAPSHOT). */
+#if HAS_DISPLAY && HAS_IMAGE_API && IMAGE_API_RETURN_SNAPSHOT
+  #define LV_USE_SNAPSHOT 1
+#else
+  #define LV_USE_SNAPSHOT 0
+#endif
+
 /* Enable asserts */
 #define LV_USE_ASSERT_NULL          1   /*Check if the parameter is NULL*/
 #define LV_USE_ASSERT_MALLOC        1   /*Checks is the memory is successfully allocated*/
@@ -1,42 +1,95 @@
 #include "lvgl_heap.h"
 
+#include "board_config.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
+
 #include <esp_heap_caps.h>
 #include <esp_rom_sys.h>
 #include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <multi_heap.h>
+#include <string.h>
 
 // Arduino-ESP32 helper for detecting PSRAM at runtime.
 // (psramFound() is not declared in esp_system.h)
 #include <esp32-hal-psram.h>
 #include <soc/soc_caps.h>
 
+#if LVGL_ARENA_ENABLED && defined(SOC_SPIRAM_SUPPORTED) && SOC_SPIRAM_SUPPORTED
+#define LVGL_HEAP_ARENA 1
+#else
+#define LVGL_HEAP_ARENA 0
+#endif
+
+#if LVGL_HEAP_ARENA
+namespace {
+
+portMUX_TYPE g_arena_mux = portMUX_INITIALIZER_UNLOCKED;
+multi_heap_handle_t g_arena = nullptr;
+uint8_t* g_arena_start = nullptr;
+size_t g_arena_bytes = 0;
+size_t g_arena_total = 0;       // free bytes right after registration
+bool g_arena_tried = false;
+uint32_t g_overflow_allocs = 0;
+
+// Reserved on the first LVGL allocation (lv_init), so a build without a
+// display never pays for it.
+void arena_init() {
+    if (g_arena_tried) return;
+    g_arena_tried = true;
+    if (!psramFound()) return;
+
+    void* block = heap_tag_malloc(HeapTag::Lvgl, LVGL_ARENA_BYTES, MALLOC_CAP_SPIRAM);
+    if (!block) {
+        esp_rom_printf("[LVGL] heap: arena alloc FAIL size=%u\n", (unsigned)LVGL_ARENA_BYTES);
+        return;
+    }
+    multi_heap_handle_t heap = multi_heap_register(block, LVGL_ARENA_BYTES);
+    if (!heap) {
+        heap_tag_free(HeapTag::Lvgl, block);
+        return;
+    }
+    // LVGL runs under the display lock, but frees can come from other tasks
+    // tearing down screens; the spinlock is what IDF's own heaps use.
+    multi_heap_set_lock(heap, &g_arena_mux);
+
+    g_arena_start = (uint8_t*)block;
+    g_arena_bytes = LVGL_ARENA_BYTES;
+    g_arena_total = multi_heap_free_size(heap);
+    g_arena = heap;
+    esp_rom_printf("[LVGL] heap: arena %u bytes in PSRAM\n", (unsigned)g_arena_total);
+}
+
+bool in_arena(const void* ptr) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    return g_arena && p >= g_arena_start && p < g_arena_start + g_arena_bytes;
+}
+
+} // namespace
+#endif
+
+static void* lvgl_heap_malloc_system(size_t size);
+
 extern "C" void* lvgl_heap_malloc(size_t size) {
     if (size == 0) return nullptr;
 
-    static bool logged_psram_ok = false;
-    static bool logged_psram_fail = false;
-
-#if defined(SOC_SPIRAM_SUPPORTED) && SOC_SPIRAM_SUPPORTED
-    // Prefer PSRAM to keep internal heap healthy (LVGL does lots of small allocs).
-    if (psramFound()) {
-        // Note: requesting MALLOC_CAP_8BIT along with SPIRAM can be unnecessarily
-        // restrictive on some cores; SPIRAM is already byte-addressable.
-        void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
-        if (p) {
-            if (!logged_psram_ok) {
-                esp_rom_printf("[LVGL] heap: PSRAM alloc OK (first) size=%u\n", (unsigned)size);
-                logged_psram_ok = true;
-            }
-            return p;
-        }
-        if (!logged_psram_fail) {
-            esp_rom_printf("[LVGL] heap: PSRAM alloc FAIL (first) size=%u\n", (unsigned)size);
-            logged_psram_fail = true;
-        }
+#if LVGL_HEAP_ARENA
+    arena_init();
+    if (g_arena) {
+        void* p = multi_heap_malloc(g_arena, size);
+        if (p) return p;
+        __atomic_add_fetch(&g_overflow_allocs, 1, __ATOMIC_RELAXED);
     }
 #endif
 
-    // Fallback: internal RAM.
-    return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    return lvgl_heap_malloc_system(size);
+}
+
+static void* lvgl_heap_malloc_system(size_t size) {
+    // LVGL does lots of small, long-lived allocs: keep them off internal RAM
+    // where the board's bulk placement allows.
+    return heap_place_malloc(HeapClass::Bulk, HeapTag::Lvgl, size);
 }
 
 extern "C" void* lvgl_heap_realloc(void* ptr, size_t size) {
@@ -46,19 +99,50 @@ extern "C" void* lvgl_heap_realloc(void* ptr, size_t size) {
         return nullptr;
     }
 
-#if defined(SOC_SPIRAM_SUPPORTED) && SOC_SPIRAM_SUPPORTED
-    // Prefer PSRAM to keep internal heap healthy.
-    if (psramFound()) {
-        void* p = heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM);
+#if LVGL_HEAP_ARENA
+    if (in_arena(ptr)) {
+        void* p = multi_heap_realloc(g_arena, ptr, size);
         if (p) return p;
+
+        // Arena full: move the block out to the system heap.
+        __atomic_add_fetch(&g_overflow_allocs, 1, __ATOMIC_RELAXED);
+        p = lvgl_heap_malloc_system(size);
+        if (!p) return nullptr;
+        const size_t old_size = multi_heap_get_allocated_size(g_arena, ptr);
+        memcpy(p, ptr, old_size < size ? old_size : size);
+        multi_heap_free(g_arena, ptr);
+        return p;
     }
 #endif
 
-    // Fallback: internal RAM.
-    return heap_caps_realloc(ptr, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    return heap_place_realloc(HeapClass::Bulk, HeapTag::Lvgl, ptr, size);
 }
 
 extern "C" void lvgl_heap_free(void* ptr) {
     if (!ptr) return;
-    heap_caps_free(ptr);
+#if LVGL_HEAP_ARENA
+    if (in_arena(ptr)) {
+        multi_heap_free(g_arena, ptr);
+        return;
+    }
+#endif
+    heap_tag_free(HeapTag::Lvgl, ptr);
+}
+
+void lvgl_heap_get_stats(LvglHeapStats* out) {
+    memset(out, 0, sizeof(*out));
+#if LVGL_HEAP_ARENA
+    if (!g_arena) return;
+    multi_heap_info_t info;
+    multi_heap_get_info(g_arena, &info);
+    out->arena = true;
+    out->total_bytes = (uint32_t)g_arena_total;
+    out->used_bytes = (uint32_t)(g_arena_total > info.total_free_bytes ? g_arena_total - info.total_free_bytes : 0);
+    out->peak_bytes = (uint32_t)(g_arena_total > info.minimum_free_bytes ? g_arena_total - info.minimum_free_bytes : 0);
+    out->largest_free = (uint32_t)info.largest_free_block;
+    out->frag_pct = info.total_free_bytes
+        ? (uint8_t)(100 - (uint32_t)((uint64_t)info.largest_free_block * 100 / info.total_free_bytes))
+        : 0;
+    out->overflow_allocs = __atomic_load_n(&g_overflow_allocs, __ATOMIC_RELAXED);
+#endif
 }
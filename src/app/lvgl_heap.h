@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,4 +13,21 @@ void  lvgl_heap_free(void* ptr);
 
 #ifdef __cplusplus
 }
+
+// LVGL arena (LVGL_ARENA_ENABLED): LVGL_ARENA_BYTES of PSRAM reserved on the
+// first LVGL allocation and managed by ESP-IDF's TLSF multi_heap. Objects,
+// styles and draw data then churn inside the arena instead of taking the
+// system heap lock for each block. When the arena is full, requests fall back
+// to heap_caps_malloc as before (counted in overflow_allocs).
+struct LvglHeapStats {
+    bool arena;                 // the arena was reserved
+    uint32_t total_bytes;
+    uint32_t used_bytes;
+    uint32_t peak_bytes;
+    uint32_t largest_free;
+    uint8_t frag_pct;           // 100 - largest free block as a percent of free bytes
+    uint32_t overflow_allocs;   // served from the system heap because the arena was full
+};
+
+void lvgl_heap_get_stats(LvglHeapStats* out);
 #endif
@@ -3,120 +3,51 @@
 #if HAS_DISPLAY && HAS_IMAGE_API
 
 #include "lvgl_jpeg_decoder.h"
+#include "image_profile.h"
+#include "jpeg_engine.h"
+#include "rgb888_pack.h"
 
 #if LV_USE_IMG
 
 #include <Arduino.h>
 #include <esp_heap_caps.h>
 
-// TJpgDec ROM header selection copied from StripDecoder for broad ESP32-family compatibility.
-#if defined(CONFIG_IDF_TARGET_ESP32)
-    #include <esp32/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32S2)
-    #if __has_include(<esp32s2/rom/tjpgd.h>)
-        #include <esp32s2/rom/tjpgd.h>
-    #else
-        #error "Missing <esp32s2/rom/tjpgd.h> in this Arduino-ESP32 install"
-    #endif
-#elif defined(CONFIG_IDF_TARGET_ESP32S3)
-    #include <esp32s3/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32C2)
-    #if __has_include(<esp32c2/rom/tjpgd.h>)
-        #include <esp32c2/rom/tjpgd.h>
-    #else
-        #error "Missing <esp32c2/rom/tjpgd.h> in this Arduino-ESP32 install"
-    #endif
-#elif defined(CONFIG_IDF_TARGET_ESP32C3)
-    #include <esp32c3/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32C5)
-    #include <esp32c5/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32C6)
-    #include <esp32c6/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32H2)
-    #if __has_include(<esp32h2/rom/tjpgd.h>)
-        #include <esp32h2/rom/tjpgd.h>
-    #else
-        #error "Missing <esp32h2/rom/tjpgd.h> in this Arduino-ESP32 install"
-    #endif
-#elif defined(CONFIG_IDF_TARGET_ESP32P4)
-    #if __has_include(<esp32p4/rom/tjpgd.h>)
-        #include <esp32p4/rom/tjpgd.h>
-    #else
-        #error "Missing <esp32p4/rom/tjpgd.h> in this Arduino-ESP32 install"
-    #endif
-#else
-    // Fall back to generic include if present.
-    #if __has_include(<rom/tjpgd.h>)
-        #include <rom/tjpgd.h>
-    #else
-        #error "Missing TJpgDec ROM header (tjpgd.h)"
-    #endif
-#endif
-
-struct JpegInputContext {
-    const uint8_t* data = nullptr;
-    size_t size = 0;
-    size_t pos = 0;
-};
-
 struct JpegOutputContext {
     uint16_t* dst = nullptr;
     int dst_w = 0;
     int dst_h = 0;
-};
+    uint32_t pack_us = 0;  // profiler: conversion time spent in the callback
 
-struct JpegSessionContext {
-    JpegInputContext input;
-    JpegOutputContext output;
+    // Progressive display (nullptr = report nothing).
+    const LvglJpegProgress* progress = nullptr;
+    int rows_reported = 0;
 };
 
-static UINT jpeg_input_func(JDEC* jd, BYTE* buff, UINT nbyte) {
-    JpegSessionContext* session = (JpegSessionContext*)jd->device;
-    if (!session) return 0;
-
-    JpegInputContext* ctx = &session->input;
-    if (!ctx->data || ctx->pos >= ctx->size) return 0;
-
-    const size_t remaining = ctx->size - ctx->pos;
-    const size_t requested = (size_t)nbyte;
-    const size_t to_read = (requested < remaining) ? requested : remaining;
-
-    if (buff && to_read > 0) {
-        memcpy(buff, ctx->data + ctx->pos, to_read);
-    }
-
-    ctx->pos += to_read;
-    return (UINT)to_read;
-}
-
-static inline uint16_t pack_rgb565(uint8_t r, uint8_t g, uint8_t b) {
-    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
-}
-
-static UINT jpeg_output_to_rgb565(JDEC* jd, void* bitmap, JRECT* rect) {
-    JpegSessionContext* session = (JpegSessionContext*)jd->device;
-    if (!session) return 0;
+// lv_img TRUE_COLOR data must match LVGL's colour format (byte-swapped with LV_COLOR_16_SWAP).
+static const Rgb888PackFn pack_rgb565 = rgb888_pack_kernel(false, LV_COLOR_16_SWAP != 0);
+static constexpr bool kBigEndian = LV_COLOR_16_SWAP != 0;
 
-    JpegOutputContext* out = &session->output;
-    if (!out->dst || out->dst_w <= 0 || out->dst_h <= 0) return 0;
+static bool jpeg_output_to_rgb565(void* ctx, const JpegBlock& block) {
+    JpegOutputContext* out = (JpegOutputContext*)ctx;
+    if (!out->dst || out->dst_w <= 0 || out->dst_h <= 0) return false;
 
-    const int rect_w = rect->right - rect->left + 1;
-    const int rect_h = rect->bottom - rect->top + 1;
-    if (rect_w <= 0 || rect_h <= 0) return 0;
+    const int rect_w = block.w;
+    const int rect_h = block.h;
+    if (rect_w <= 0 || rect_h <= 0) return false;
 
     // Bounds check against output buffer.
-    if (rect->left < 0 || rect->top < 0) return 0;
-    if (rect->right >= out->dst_w || rect->bottom >= out->dst_h) return 0;
+    if (block.x < 0 || block.y < 0) return false;
+    if (block.x + rect_w > out->dst_w || block.y + rect_h > out->dst_h) return false;
 
-    uint8_t* src = (uint8_t*)bitmap;
+    const uint32_t t0 = image_profile_now_us();
     for (int row = 0; row < rect_h; row++) {
-        const int y = rect->top + row;
-        uint16_t* dst_row = out->dst + (size_t)y * (size_t)out->dst_w + (size_t)rect->left;
-        for (int col = 0; col < rect_w; col++) {
-            const uint8_t r = *src++;
-            const uint8_t g = *src++;
-            const uint8_t b = *src++;
-            dst_row[col] = pack_rgb565(r, g, b);
+        const int y = block.y + row;
+        uint16_t* dst_row = out->dst + (size_t)y * (size_t)out->dst_w + (size_t)block.x;
+        if (block.format == JpegPixels::Rgb565) {
+            // Already in LVGL's byte order.
+            memcpy(dst_row, (const uint16_t*)block.pixels + (size_t)row * (size_t)block.stride, (size_t)rect_w * 2);
+        } else {
+            pack_rgb565((const uint8_t*)block.pixels + (size_t)row * (size_t)block.stride * 3, dst_row, (size_t)rect_w);
         }
 
         // Yield periodically to avoid watchdog issues on single-core boards.
@@ -124,8 +55,27 @@ static UINT jpeg_output_to_rgb565(JDEC* jd, void* bitmap, JRECT* rect) {
             taskYIELD();
         }
     }
+    out->pack_us += image_profile_now_us() - t0;
+
+    #if LVGL_IMAGE_DOUBLE_BUFFER
+    // Blocks arrive left to right: the right-most one completes a row band.
+    if (out->progress && block.x + rect_w == out->dst_w) {
+        const int rows_done = block.y + rect_h;
+        if (rows_done - out->rows_reported >= LVGL_IMAGE_PROGRESSIVE_ROWS || rows_done == out->dst_h) {
+            out->progress->rows(out->progress->ctx, out->rows_reported, rows_done);
+            out->rows_reported = rows_done;
+        }
+    }
+    #endif
+
+    return true;
+}
 
-    return 1;
+// The board's engine, or TJpgDec when it cannot be had or cannot scale.
+static JpegEngine* create_engine() {
+    JpegEngine* engine = jpeg_engine_create(JPEG_DECODER);
+    if (!engine && JPEG_DECODER != JPEG_DECODER_TJPGD_ROM) engine = jpeg_engine_create(JPEG_DECODER_TJPGD_ROM);
+    return engine;
 }
 
 static void* alloc_any_8bit(size_t bytes) {
@@ -160,83 +110,90 @@ bool lvgl_jpeg_decode_to_rgb565(
         return false;
     }
 
-    // TJpgDec work area.
-    static const size_t kWorkSize = 4096;
-    bool work_is_caps = true;
-    void* work = nullptr;
-
-#if SOC_SPIRAM_SUPPORTED
-    work = heap_caps_malloc(kWorkSize, MALLOC_CAP_SPIRAM);
-#endif
-    if (!work) {
-        work = heap_caps_malloc(kWorkSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-    }
-    if (!work) {
-        work_is_caps = false;
-        work = malloc(kWorkSize);
-    }
-    if (!work) {
-        if (err && err_len) snprintf(err, err_len, "Out of memory (work buffer)");
+    JpegEngine* engine = create_engine();
+    if (!engine) {
+        if (err && err_len) snprintf(err, err_len, "Out of memory (JPEG decoder)");
         return false;
     }
 
-    auto free_work = [&]() {
-        if (!work) return;
-        if (work_is_caps) heap_caps_free(work);
-        else free(work);
-        work = nullptr;
-    };
-
     // Best-effort: try full-res first, then 1/2, 1/4, 1/8 if the heap is fragmented.
-    // TJpgDec scale factors: 0=1/1, 1=1/2, 2=1/4, 3=1/8
+    // Scale factors: 0=1/1, 1=1/2, 2=1/4, 3=1/8
+    // The header is parsed once: a smaller scale after a failed allocation
+    // reuses it, only a failed decode (input consumed) parses it again.
+    JpegEngineInput input;
+    JpegOutputContext output;
+    uint16_t src_w = 0;
+    uint16_t src_h = 0;
+    char derr[64];
+    bool prepared = false;
     for (uint8_t scale = 0; scale <= 3; scale++) {
-        JDEC jd;
-        JpegSessionContext session;
-        session.input.data = jpeg;
-        session.input.size = jpeg_size;
-        session.input.pos = 0;
-
-        JRESULT prep = jd_prepare(&jd, jpeg_input_func, (void*)work, (UINT)kWorkSize, &session);
-        if (prep != JDR_OK) {
-            free_work();
-            if (err && err_len) snprintf(err, err_len, "JPEG prepare failed (%d)", (int)prep);
-            return false;
+        if (prepared && !jpeg_engine_can(engine, false, scale)) {
+            // An engine without scaling (hardware codec) hands the rest to TJpgDec.
+            jpeg_engine_destroy(engine);
+            engine = jpeg_engine_create(JPEG_DECODER_TJPGD_ROM);
+            if (!engine) {
+                if (err && err_len) snprintf(err, err_len, "Out of memory (JPEG decoder)");
+                return false;
+            }
+            prepared = false;
+        }
+        if (!prepared) {
+            input = JpegEngineInput();
+            input.data = jpeg;
+            input.size = jpeg_size;
+
+            const uint32_t t_prep = image_profile_now_us();
+            const bool ok = engine->prepare(&input, &src_w, &src_h, derr, sizeof(derr));
+            image_profile_add(IMAGE_STAGE_HEADER, image_profile_now_us() - t_prep, (uint32_t)input.pos);
+            if (!ok) {
+                jpeg_engine_destroy(engine);
+                if (err && err_len) snprintf(err, err_len, "JPEG prepare failed (%s)", derr);
+                return false;
+            }
+            prepared = true;
         }
 
-        const int src_w = (int)jd.width;
-        const int src_h = (int)jd.height;
-        if (src_w <= 0 || src_h <= 0) {
-            free_work();
+        if (src_w == 0 || src_h == 0) {
+            jpeg_engine_destroy(engine);
             if (err && err_len) snprintf(err, err_len, "Invalid JPEG dimensions");
             return false;
         }
 
         const int div = 1 << scale;
-        const int outw = (src_w + div - 1) / div;
-        const int outh = (src_h + div - 1) / div;
+        const int outw = ((int)src_w + div - 1) / div;
+        const int outh = ((int)src_h + div - 1) / div;
         if (outw <= 0 || outh <= 0) {
             continue;
         }
 
         const size_t pixel_bytes = (size_t)outw * (size_t)outh * 2;
+        const uint32_t t_alloc = image_profile_now_us();
         uint16_t* pixels = (uint16_t*)alloc_any_8bit(pixel_bytes);
+        image_profile_add(IMAGE_STAGE_ALLOC, image_profile_now_us() - t_alloc, pixels ? (uint32_t)pixel_bytes : 0);
         if (!pixels) {
             // Try smaller scale.
             continue;
         }
 
-        session.output.dst = pixels;
-        session.output.dst_w = outw;
-        session.output.dst_h = outh;
-
-        JRESULT dec = jd_decomp(&jd, jpeg_output_to_rgb565, scale);
-        if (dec != JDR_OK) {
+        output = JpegOutputContext();
+        output.dst = pixels;
+        output.dst_w = outw;
+        output.dst_h = outh;
+
+        const uint32_t t_start = image_profile_now_us();
+        const bool dec = engine->decode(scale, kBigEndian, jpeg_output_to_rgb565, &output, derr, sizeof(derr));
+        const uint32_t wall = image_profile_now_us() - t_start;
+        const uint32_t pack_us = output.pack_us;
+        image_profile_add(IMAGE_STAGE_DECODE, wall > pack_us ? wall - pack_us : 0, (uint32_t)input.pos);
+        image_profile_add(IMAGE_STAGE_PACK, pack_us, (uint32_t)pixel_bytes);
+        if (!dec) {
             heap_caps_free(pixels);
             // Try smaller scale.
+            prepared = false;
             continue;
         }
 
-        free_work();
+        jpeg_engine_destroy(engine);
         *out_pixels = pixels;
         *out_w = outw;
         *out_h = outh;
@@ -244,11 +201,123 @@ bool lvgl_jpeg_decode_to_rgb565(
         return true;
     }
 
-    free_work();
+    jpeg_engine_destroy(engine);
     if (err && err_len) snprintf(err, err_len, "Out of memory (no scale fits)");
     return false;
 }
 
+#if LVGL_IMAGE_DOUBLE_BUFFER
+bool lvgl_jpeg_decode_into_rgb565(
+    const uint8_t* jpeg,
+    size_t jpeg_size,
+    uint16_t* dst,
+    size_t capacity_bytes,
+    int* out_w,
+    int* out_h,
+    int* out_scale_used,
+    char* err,
+    size_t err_len,
+    const LvglJpegProgress* progress
+) {
+    if (!dst || !out_w || !out_h) return false;
+    *out_w = 0;
+    *out_h = 0;
+    if (out_scale_used) *out_scale_used = -1;
+
+    if (!jpeg || jpeg_size < 4) {
+        if (err && err_len) snprintf(err, err_len, "Invalid JPEG buffer");
+        return false;
+    }
+
+    // Kept between calls (image worker only): no allocation per image.
+    static JpegEngine* s_engine = nullptr;
+    static JpegEngine* s_tjpgd = nullptr;
+    if (!s_engine) s_engine = create_engine();
+    JpegEngine* engine = s_engine;
+    if (!engine) {
+        if (err && err_len) snprintf(err, err_len, "Out of memory (JPEG decoder)");
+        return false;
+    }
+
+    char derr[64];
+    uint16_t src_w = 0;
+    uint16_t src_h = 0;
+    JpegEngineInput input;
+    input.data = jpeg;
+    input.size = jpeg_size;
+
+    const uint32_t t_start = image_profile_now_us();
+    bool ok = engine->prepare(&input, &src_w, &src_h, derr, sizeof(derr));
+    if (!ok) {
+        image_profile_add(IMAGE_STAGE_HEADER, image_profile_now_us() - t_start, (uint32_t)input.pos);
+        if (err && err_len) snprintf(err, err_len, "JPEG prepare failed (%s)", derr);
+        return false;
+    }
+
+    // Largest output that fits the buffer (scale factors: 0=1/1 ... 3=1/8).
+    int scale = -1;
+    int outw = 0;
+    int outh = 0;
+    for (int s = 0; s <= 3; s++) {
+        const int div = 1 << s;
+        outw = ((int)src_w + div - 1) / div;
+        outh = ((int)src_h + div - 1) / div;
+        if ((size_t)outw * (size_t)outh * 2 <= capacity_bytes) {
+            scale = s;
+            break;
+        }
+    }
+    if (scale < 0) {
+        image_profile_add(IMAGE_STAGE_HEADER, image_profile_now_us() - t_start, (uint32_t)input.pos);
+        if (err && err_len) snprintf(err, err_len, "%ux%u JPEG too large for the image buffer", (unsigned)src_w, (unsigned)src_h);
+        return false;
+    }
+
+    if (!jpeg_engine_can(engine, false, (uint8_t)scale)) {
+        // An engine without scaling (hardware codec) hands this one to TJpgDec.
+        if (!s_tjpgd) s_tjpgd = jpeg_engine_create(JPEG_DECODER_TJPGD_ROM);
+        engine = s_tjpgd;
+        input.pos = 0;
+        ok = engine && engine->prepare(&input, &src_w, &src_h, derr, sizeof(derr));
+        if (!ok) {
+            image_profile_add(IMAGE_STAGE_HEADER, image_profile_now_us() - t_start, (uint32_t)input.pos);
+            if (err && err_len) snprintf(err, err_len, "JPEG prepare failed (%s)", engine ? derr : "out of memory");
+            return false;
+        }
+    }
+    const uint32_t header_us = image_profile_now_us() - t_start;
+    image_profile_add(IMAGE_STAGE_HEADER, header_us, (uint32_t)input.pos);
+
+    JpegOutputContext output;
+    output.dst = dst;
+    output.dst_w = outw;
+    output.dst_h = outh;
+
+    if (progress && progress->begin && progress->rows) {
+        // Rows not decoded yet show as black rather than an older image.
+        memset(dst, 0, (size_t)outw * (size_t)outh * 2);
+        if (progress->begin(progress->ctx, outw, outh)) {
+            output.progress = progress;
+        }
+    }
+
+    const bool dec = engine->decode((uint8_t)scale, kBigEndian, jpeg_output_to_rgb565, &output, derr, sizeof(derr));
+    const uint32_t wall = image_profile_now_us() - t_start - header_us;
+    const uint32_t pack_us = output.pack_us;
+    image_profile_add(IMAGE_STAGE_DECODE, wall > pack_us ? wall - pack_us : 0, (uint32_t)input.pos);
+    image_profile_add(IMAGE_STAGE_PACK, pack_us, (uint32_t)outw * (uint32_t)outh * 2);
+    if (!dec) {
+        if (err && err_len) snprintf(err, err_len, "JPEG decode failed (%s)", derr);
+        return false;
+    }
+
+    *out_w = outw;
+    *out_h = outh;
+    if (out_scale_used) *out_scale_used = scale;
+    return true;
+}
+#endif // LVGL_IMAGE_DOUBLE_BUFFER
+
 #endif // LV_USE_IMG
 
 #endif // HAS_DISPLAY && HAS_IMAGE_API
@@ -11,7 +11,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
-// Decode a baseline JPEG into an RGB565 pixel buffer.
+// Decode a baseline JPEG into an RGB565 pixel buffer (through the board's
+// JpegEngine, see jpeg_engine.h).
 //
 // - Allocates the output buffer with heap_caps_malloc/malloc (caller owns).
 // - Returns false with a short error string on failure.
@@ -27,6 +28,35 @@ bool lvgl_jpeg_decode_to_rgb565(
     size_t err_len
 );
 
+#if LVGL_IMAGE_DOUBLE_BUFFER
+// Optional progressive-display hooks for lvgl_jpeg_decode_into_rgb565.
+// begin() runs once the output size is known, after dst was cleared to black
+// and before any pixel is decoded; returning false turns the hooks off.
+// rows() then reports each finished band [y0, y1) of output rows.
+struct LvglJpegProgress {
+    bool (*begin)(void* ctx, int w, int h);
+    void (*rows)(void* ctx, int y0, int y1);
+    void* ctx;
+};
+
+// Decode into a caller-owned buffer (e.g. LvglImageScreen's back buffer) at the
+// largest scale (1/1 ... 1/8) whose output fits capacity_bytes. The decoder
+// engine is kept between calls, so after the first one this is
+// allocation-free but not reentrant: call from the image worker only.
+bool lvgl_jpeg_decode_into_rgb565(
+    const uint8_t* jpeg,
+    size_t jpeg_size,
+    uint16_t* dst,
+    size_t capacity_bytes,
+    int* out_w,
+    int* out_h,
+    int* out_scale_used,
+    char* err,
+    size_t err_len,
+    const LvglJpegProgress* progress = nullptr
+);
+#endif
+
 #endif // LV_USE_IMG
 
 #endif // HAS_DISPLAY && HAS_IMAGE_API
@@ -0,0 +1,192 @@
+#include "macro_executor.h"
+
+#include "ble_keyboard_manager.h"
+#include "ducky_script.h"
+#include "log_manager.h"
+#include "macros_config.h"
+#include "tap_latency.h"
+#include "trace.h"
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <string.h>
+
+namespace {
+
+struct MacroJob {
+    uint8_t screen;
+    uint8_t button;
+    BleKeyboardManager* keyboard;
+    TapTrace trace;
+    char script[MACROS_PAYLOAD_MAX_LEN];
+};
+
+// Queue, status and cancel flag are shared between the submitting (LVGL) task
+// and the executor task; all access is under g_mux.
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static MacroJob g_queue[MACRO_EXECUTOR_QUEUE_DEPTH];
+static uint8_t g_head = 0;
+static uint8_t g_count = 0;
+static MacroExecutorStatus g_status = {};
+static volatile bool g_cancel = false;
+
+static TaskHandle_t g_task = nullptr;
+static MacroJob g_current;   // owned by the executor task
+
+static void note_event_locked(MacroExecutorEvent ev, uint8_t screen, uint8_t button) {
+    g_status.seq++;
+    g_status.last_event = ev;
+    g_status.last_screen = screen;
+    g_status.last_button = button;
+    g_status.queued = g_count;
+}
+
+static bool pop_job(MacroJob* out) {
+    bool ok = false;
+    portENTER_CRITICAL(&g_mux);
+    if (g_count > 0) {
+        memcpy(out, &g_queue[g_head], sizeof(MacroJob));
+        g_head = (uint8_t)((g_head + 1) % MACRO_EXECUTOR_QUEUE_DEPTH);
+        g_count--;
+        g_cancel = false;
+        g_status.running = true;
+        g_status.running_screen = out->screen;
+        g_status.running_button = out->button;
+        note_event_locked(MacroExecutorEvent::Started, out->screen, out->button);
+        ok = true;
+    }
+    portEXIT_CRITICAL(&g_mux);
+    return ok;
+}
+
+static void executor_task_fn(void* arg) {
+    (void)arg;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (pop_job(&g_current)) {
+            const uint32_t t0 = millis();
+            BleKeyboardManager* kb = g_current.keyboard;
+            // Keeps an on-demand BLE stack up (and starts it) for the macro.
+            TRACE_BEGIN("macro.run");
+            const bool held = kb && kb->acquire(&g_cancel);
+            if (kb) kb->requestLowLatency();
+#if HAS_DISPLAY
+            tap_latency_dispatch(g_current.trace);
+#endif
+            const bool ok = ducky_execute_button(g_current.screen, g_current.button, g_current.script, kb, &g_cancel);
+#if HAS_DISPLAY
+            tap_latency_finish();
+#endif
+            if (held) kb->release();
+            TRACE_END("macro.run");
+
+            portENTER_CRITICAL(&g_mux);
+            const bool cancelled = g_cancel;
+            g_cancel = false;
+            g_status.running = false;
+            g_status.completed++;
+            note_event_locked(
+                cancelled ? MacroExecutorEvent::Cancelled : (ok ? MacroExecutorEvent::Finished : MacroExecutorEvent::Failed),
+                g_current.screen,
+                g_current.button);
+            portEXIT_CRITICAL(&g_mux);
+
+            Logger.logMessagef("Macro", "Screen %u button %u: %s in %lu ms",
+                (unsigned)g_current.screen + 1, (unsigned)g_current.button + 1,
+                cancelled ? "cancelled" : (ok ? "done" : "failed"), (unsigned long)(millis() - t0));
+        }
+    }
+}
+
+static bool ensure_task() {
+    if (g_task) return true;
+    // Above the LVGL task (priority 1) so keystroke pacing does not stretch
+    // while the UI renders; the task sleeps through every DELAY.
+    if (xTaskCreate(executor_task_fn, "MacroExec", MACRO_EXECUTOR_STACK_BYTES, nullptr, tskIDLE_PRIORITY + 2, &g_task) != pdPASS) {
+        g_task = nullptr;
+        Logger.logMessage("Macro", "Failed to create executor task");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+MacroExecutorEvent macro_executor_submit(uint8_t screen, uint8_t button, const char* script, BleKeyboardManager* keyboard,
+                                         const TapTrace* trace) {
+    if (!script || !*script) return MacroExecutorEvent::None;
+    if (!ensure_task()) return MacroExecutorEvent::Failed;
+
+    MacroExecutorEvent ev = MacroExecutorEvent::Queued;
+    portENTER_CRITICAL(&g_mux);
+    if (MACRO_EXECUTOR_TAP_TO_CANCEL && g_status.running &&
+        g_status.running_screen == screen && g_status.running_button == button) {
+        // The executor reports Cancelled once the script has stopped.
+        g_cancel = true;
+        ev = MacroExecutorEvent::Cancelled;
+    } else {
+        if (MACRO_EXECUTOR_COALESCE_REPEATS) {
+            for (uint8_t i = 0; i < g_count; i++) {
+                const MacroJob& job = g_queue[(g_head + i) % MACRO_EXECUTOR_QUEUE_DEPTH];
+                if (job.screen == screen && job.button == button) {
+                    ev = MacroExecutorEvent::Coalesced;
+                    break;
+                }
+            }
+        }
+        if (ev == MacroExecutorEvent::Queued && g_count >= MACRO_EXECUTOR_QUEUE_DEPTH) {
+            ev = MacroExecutorEvent::Dropped;
+        }
+        if (ev == MacroExecutorEvent::Queued) {
+            MacroJob& job = g_queue[(g_head + g_count) % MACRO_EXECUTOR_QUEUE_DEPTH];
+            job.screen = screen;
+            job.button = button;
+            job.keyboard = keyboard;
+            job.trace = trace ? *trace : TapTrace{0, 0};
+            strlcpy(job.script, script, sizeof(job.script));
+            g_count++;
+        }
+        note_event_locked(ev, screen, button);
+    }
+    portEXIT_CRITICAL(&g_mux);
+
+    if (ev == MacroExecutorEvent::Queued) {
+        TRACE_INSTANT("macro.queued");
+        xTaskNotifyGive(g_task);
+    } else if (ev == MacroExecutorEvent::Dropped) {
+        Logger.logMessagef("Macro", "Queue full; screen %u button %u dropped", (unsigned)screen + 1, (unsigned)button + 1);
+    }
+    return ev;
+}
+
+void macro_executor_cancel_all() {
+    portENTER_CRITICAL(&g_mux);
+    g_count = 0;
+    if (g_status.running) g_cancel = true;
+    g_status.queued = 0;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void macro_executor_get_status(MacroExecutorStatus* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_mux);
+    *out = g_status;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+uint32_t macro_executor_busy_mask(uint8_t screen) {
+    uint32_t mask = 0;
+    portENTER_CRITICAL(&g_mux);
+    if (g_status.running && g_status.running_screen == screen) {
+        mask |= 1u << g_status.running_button;
+    }
+    for (uint8_t i = 0; i < g_count; i++) {
+        const MacroJob& job = g_queue[(g_head + i) % MACRO_EXECUTOR_QUEUE_DEPTH];
+        if (job.screen == screen) mask |= 1u << job.button;
+    }
+    portEXIT_CRITICAL(&g_mux);
+    return mask;
+}
@@ -0,0 +1,63 @@
+/*
+ * Macro Executor
+ *
+ * Runs SendKeys macros on a dedicated task so DELAYs and BLE reports never
+ * block the LVGL task (button presses would otherwise hold lvglMutex for the
+ * whole macro and freeze the UI).
+ *
+ * Taps are queued in a bounded FIFO (MACRO_EXECUTOR_QUEUE_DEPTH) holding a
+ * copy of the payload. Repeated taps:
+ *   - the button whose macro is running: cancels it (MACRO_EXECUTOR_TAP_TO_CANCEL)
+ *   - a button that is already queued: dropped (MACRO_EXECUTOR_COALESCE_REPEATS)
+ *     or queued again
+ *   - queue full: dropped
+ *
+ * The UI polls the status (a sequence number bumps on every event) from
+ * its own task; nothing here calls into LVGL.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#include <stdint.h>
+
+class BleKeyboardManager;
+struct TapTrace;
+
+enum class MacroExecutorEvent : uint8_t {
+    None,
+    Queued,
+    Coalesced,   // already queued; tap dropped
+    Dropped,     // queue full
+    Started,
+    Finished,
+    Failed,      // not connected, or the script stopped early
+    Cancelled,
+};
+
+struct MacroExecutorStatus {
+    uint32_t seq;                  // bumps on every event
+    MacroExecutorEvent last_event;
+    uint8_t last_screen;
+    uint8_t last_button;
+    bool running;
+    uint8_t running_screen;
+    uint8_t running_button;
+    uint8_t queued;
+    uint32_t completed;            // Finished + Failed + Cancelled since boot
+};
+
+// Queue (or cancel, see above) the macro of a button. script is copied.
+// trace (optional) times the tap through to its first HID report (tap_latency.h).
+// Starts the executor task on first use. Returns the event it caused.
+MacroExecutorEvent macro_executor_submit(uint8_t screen, uint8_t button, const char* script, BleKeyboardManager* keyboard,
+                                         const TapTrace* trace = nullptr);
+
+// Cancel the running macro and drop everything queued.
+void macro_executor_cancel_all();
+
+void macro_executor_get_status(MacroExecutorStatus* out);
+
+// Bit per button of screen that is running or queued.
+uint32_t macro_executor_busy_mask(uint8_t screen);
@@ -17,6 +17,26 @@ const char* default_id() {
     return kTemplateRoundRing9;
 }
 
+TemplateKind resolve(const char* id) {
+    if (!id || !*id) return TemplateKind::RoundRing9;
+    if (strcmp(id, kTemplateRoundPie8) == 0) return TemplateKind::RoundPie8;
+    if (strcmp(id, kTemplateStackSides5) == 0) return TemplateKind::StackSides5;
+    if (strcmp(id, kTemplateWideSides3) == 0) return TemplateKind::WideSides3;
+    if (strcmp(id, kTemplateSplitSides4) == 0) return TemplateKind::SplitSides4;
+    // round_ring_9 default
+    return TemplateKind::RoundRing9;
+}
+
+const char* id_for(TemplateKind kind) {
+    switch (kind) {
+        case TemplateKind::RoundPie8: return kTemplateRoundPie8;
+        case TemplateKind::StackSides5: return kTemplateStackSides5;
+        case TemplateKind::WideSides3: return kTemplateWideSides3;
+        case TemplateKind::SplitSides4: return kTemplateSplitSides4;
+        default: return kTemplateRoundRing9;
+    }
+}
+
 const char* display_name(const char* id) {
     if (!id || !*id) return "(unknown)";
     if (strcmp(id, kTemplateRoundRing9) == 0) return "Round Ring (9)";
@@ -13,9 +13,26 @@ static constexpr const char* kTemplateStackSides5 = "round_stack_sides_5";
 static constexpr const char* kTemplateWideSides3 = "round_wide_sides_3";
 static constexpr const char* kTemplateSplitSides4 = "round_split_sides_4";
 
+// Template ids resolved once (per config generation) so per-frame checks are
+// integer compares. Order is internal; ids are what is stored and exchanged.
+enum class TemplateKind : uint8_t {
+    RoundRing9,
+    RoundPie8,
+    StackSides5,
+    WideSides3,
+    SplitSides4,
+    Count,   // none / not resolved yet
+};
+
 // Returns true if template id is recognized.
 bool is_valid(const char* id);
 
+// Kind for a template id; empty or unknown ids resolve to the default.
+TemplateKind resolve(const char* id);
+
+// Template id of a kind (the default for Count).
+const char* id_for(TemplateKind kind);
+
 // Returns a stable default template id.
 const char* default_id();
 
@@ -1,15 +1,20 @@
 #include "macros_config.h"
 
+#include "board_config.h"
+#include "fs_health.h"
 #include "log_manager.h"
 
 #include <Preferences.h>
 
 #if defined(ARDUINO_ARCH_ESP32)
 // Prefer filesystem storage when available (e.g. 16MB + FFat partition schemes).
-// This avoids NVS partition size limits for the ~22KB macro blob.
+// This avoids NVS partition size limits for large macro payloads.
 #include <FFat.h>
+#include <esp_heap_caps.h>
 #include <esp_log.h>
 #include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #endif
 
 #define MACROS_NAMESPACE "macros"
@@ -20,7 +25,12 @@
 #define KEY_BLOB  "b"
 
 #define MACROS_MAGIC 0x4D414352u // 'MACR'
-#define MACROS_VERSION 9
+// 11: one compact encoding per screen behind a directory (see "Indexed file").
+// 10: compact records + string pool for all screens; still loaded, then rewritten as 11.
+// 9: raw MacroConfig image; still loaded, then rewritten as 11.
+#define MACROS_VERSION 11
+#define MACROS_COMPACT_VERSION 10
+#define MACROS_LEGACY_VERSION 9
 
 static Preferences prefs;
 
@@ -29,6 +39,10 @@ static bool ffat_attempted = false;
 static bool ffat_ready = false;
 static const char* kMacrosPath = "/macros.bin";
 static const char* kMacrosTmpPath = "/macros.tmp";
+// Scratch copies written by macros_config_bench().
+static const char* kBenchPath = "/macros.bench";
+static const char* kBenchTmpPath = "/macros.benchtmp";
+#define MACROS_BENCH_NAMESPACE "macrosbench"
 
 struct MacrosFileHeader {
     uint32_t magic;
@@ -73,48 +87,550 @@ static bool ensure_ffat() {
             Logger.logLine("[Macros] FFat not available; using NVS");
         }
     }
+    if (ffat_ready) fs_health_note_ffat_mounted();
     return ffat_ready;
 #else
     return false;
 #endif
 }
 
-static bool macros_load_from_ffat(MacroConfig* cfg) {
-    if (!cfg) return false;
-    if (!ensure_ffat()) return false;
+// ===== Compact encoding (MACROS_COMPACT_VERSION 10) =====
+//
+// A raw MacroConfig is ~65KB of mostly empty fixed-size strings. The stored
+// form keeps only what is set:
+//
+//   u8  screen_count, u8 buttons_per_screen, u16 record_count
+//   u32 default_screen_bg, default_button_bg, default_icon_color, default_label_color
+//   u32 screen_bg[screen_count]
+//   u16 template_id[screen_count]          (string offsets)
+//   records[record_count], 26 bytes each, for buttons that differ from defaults:
+//     u8 screen, u8 button, u8 action, u8 icon_type,
+//     u32 button_bg, icon_color, label_color,
+//     u16 label, payload, mqtt_topic, icon_id, icon_display (string offsets)
+//   u16 pool_len, then the string pool: NUL-terminated strings, deduplicated;
+//   offset 0 is always the empty string.
+//
+// All values are little-endian. Strings longer than their MacroConfig field
+// are truncated on load; screens/buttons beyond the compiled counts are
+// dropped, so a build with different counts still loads what fits.
+
+static const size_t kMacrosRecordBytes = 26;
+// Upper bound for a stored config (every button set, pool at its u16 limit).
+static const size_t kMacrosMaxEncodedBytes =
+    4 + 16 + (size_t)MACROS_SCREEN_COUNT * 6 + (size_t)MACROS_SCREEN_COUNT * MACROS_BUTTONS_PER_SCREEN * kMacrosRecordBytes + 2 + 0xFFFFu;
+
+static_assert(
+    (size_t)MACROS_SCREEN_COUNT * MACROS_BUTTONS_PER_SCREEN * (MACROS_LABEL_MAX_LEN + MACROS_PAYLOAD_MAX_LEN + MACROS_MQTT_TOPIC_MAX_LEN + MACROS_ICON_ID_MAX_LEN + MACROS_ICON_DISPLAY_MAX_LEN)
+        + (size_t)MACROS_SCREEN_COUNT * MACROS_TEMPLATE_ID_MAX_LEN + 1 <= 0xFFFFu,
+    "macro string pool must be addressable with u16 offsets");
+static_assert(MACROS_SCREEN_COUNT <= 255 && MACROS_BUTTONS_PER_SCREEN <= 255, "macro counts must fit in u8");
+
+struct MacrosWriter {
+    uint8_t* buf;
+    size_t cap;
+    size_t len;
+    bool ok;
+
+    void put(const void* src, size_t n) {
+        if (!ok || len + n > cap) {
+            ok = false;
+            return;
+        }
+        memcpy(buf + len, src, n);
+        len += n;
+    }
+    void u8(uint8_t v) { put(&v, 1); }
+    void u16(uint16_t v) {
+        const uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+        put(b, 2);
+    }
+    void u32(uint32_t v) {
+        const uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+        put(b, 4);
+    }
+};
+
+struct MacrosReader {
+    const uint8_t* buf;
+    size_t len;
+    size_t pos;
+    bool ok;
+
+    const uint8_t* take(size_t n) {
+        if (!ok || pos + n > len) {
+            ok = false;
+            return nullptr;
+        }
+        const uint8_t* p = buf + pos;
+        pos += n;
+        return p;
+    }
+    uint8_t u8() {
+        const uint8_t* p = take(1);
+        return p ? p[0] : 0;
+    }
+    uint16_t u16() {
+        const uint8_t* p = take(2);
+        return p ? (uint16_t)(p[0] | (p[1] << 8)) : 0;
+    }
+    uint32_t u32() {
+        const uint8_t* p = take(4);
+        return p ? ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)) : 0;
+    }
+};
+
+// String pool under construction. Identical strings (repeated MQTT topics,
+// template ids) share one copy.
+struct MacrosPool {
+    char* buf;
+    size_t cap;
+    size_t len;
+
+    // str need not be NUL-terminated; n bytes are stored.
+    uint16_t add(const char* str, size_t n) {
+        if (n == 0) return 0;
+        for (size_t off = 1; off < len;) {
+            const size_t cur = strlen(buf + off);
+            if (cur == n && memcmp(buf + off, str, n) == 0) return (uint16_t)off;
+            off += cur + 1;
+        }
+        if (len + n + 1 > cap) return 0;  // Cannot happen: cap is the sum of all strings.
+        const size_t off = len;
+        memcpy(buf + off, str, n);
+        buf[off + n] = '\0';
+        len += n + 1;
+        return (uint16_t)off;
+    }
+};
+
+// Codec scratch buffers: prefer PSRAM so a save does not dent internal RAM.
+static uint8_t* macros_alloc(size_t len) {
+    uint8_t* p = nullptr;
+#if defined(ARDUINO_ARCH_ESP32) && SOC_SPIRAM_SUPPORTED
+    if (psramFound()) {
+        p = (uint8_t*)heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+#endif
+    if (!p) p = (uint8_t*)malloc(len);
+    return p;
+}
+
+static bool macros_button_is_default(const MacroButtonConfig& b) {
+    return b.action == MacroButtonAction::None &&
+        b.label[0] == '\0' &&
+        b.payload[0] == '\0' &&
+        b.mqtt_topic[0] == '\0' &&
+        b.icon.type == MacroIconType::None &&
+        b.icon.id[0] == '\0' &&
+        b.icon.display[0] == '\0' &&
+        b.button_bg == MACROS_COLOR_UNSET &&
+        b.icon_color == MACROS_COLOR_UNSET &&
+        b.label_color == MACROS_COLOR_UNSET;
+}
+
+static size_t bounded_len(const char* str, size_t field_len) {
+    return strnlen(str, field_len - 1);
+}
+
+// Encode screens [first, first + count) of cfg into a malloc'd buffer; they
+// are numbered from 0 in the output. The caller frees *out.
+static bool macros_encode_screens(const MacroConfig* cfg, int first, int count, uint8_t** out, size_t* out_len) {
+    *out = nullptr;
+    *out_len = 0;
+
+    size_t records = 0;
+    size_t pool_cap = 1;
+    for (int s = first; s < first + count; s++) {
+        pool_cap += bounded_len(cfg->template_id[s], sizeof(cfg->template_id[s])) + 1;
+        for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+            const MacroButtonConfig& btn = cfg->buttons[s][b];
+            if (macros_button_is_default(btn)) continue;
+            records++;
+            pool_cap += bounded_len(btn.label, sizeof(btn.label)) + 1;
+            pool_cap += bounded_len(btn.payload, sizeof(btn.payload)) + 1;
+            pool_cap += bounded_len(btn.mqtt_topic, sizeof(btn.mqtt_topic)) + 1;
+            pool_cap += bounded_len(btn.icon.id, sizeof(btn.icon.id)) + 1;
+            pool_cap += bounded_len(btn.icon.display, sizeof(btn.icon.display)) + 1;
+        }
+    }
+
+    const size_t table_len = 4 + 16 + (size_t)count * 6 + records * kMacrosRecordBytes + 2;
+    uint8_t* buf = macros_alloc(table_len + pool_cap);
+    if (!buf) return false;
+
+    // The pool is built in place right after the tables, then its final
+    // length is patched in front of it.
+    MacrosPool pool = {reinterpret_cast<char*>(buf + table_len), pool_cap, 1};
+    pool.buf[0] = '\0';
+
+    // Bounded by the field so one without a terminator cannot run into its neighbour.
+    auto add = [&](const char* field, size_t field_len) -> uint16_t {
+        return pool.add(field, bounded_len(field, field_len));
+    };
+
+    MacrosWriter w = {buf, table_len, 0, true};
+    w.u8((uint8_t)count);
+    w.u8((uint8_t)MACROS_BUTTONS_PER_SCREEN);
+    w.u16((uint16_t)records);
+    w.u32(cfg->default_screen_bg);
+    w.u32(cfg->default_button_bg);
+    w.u32(cfg->default_icon_color);
+    w.u32(cfg->default_label_color);
+    for (int s = first; s < first + count; s++) {
+        w.u32(cfg->screen_bg[s]);
+    }
+    for (int s = first; s < first + count; s++) {
+        w.u16(add(cfg->template_id[s], sizeof(cfg->template_id[s])));
+    }
+    for (int s = first; s < first + count; s++) {
+        for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+            const MacroButtonConfig& btn = cfg->buttons[s][b];
+            if (macros_button_is_default(btn)) continue;
+            w.u8((uint8_t)(s - first));
+            w.u8((uint8_t)b);
+            w.u8((uint8_t)btn.action);
+            w.u8((uint8_t)btn.icon.type);
+            w.u32(btn.button_bg);
+            w.u32(btn.icon_color);
+            w.u32(btn.label_color);
+            w.u16(add(btn.label, sizeof(btn.label)));
+            w.u16(add(btn.payload, sizeof(btn.payload)));
+            w.u16(add(btn.mqtt_topic, sizeof(btn.mqtt_topic)));
+            w.u16(add(btn.icon.id, sizeof(btn.icon.id)));
+            w.u16(add(btn.icon.display, sizeof(btn.icon.display)));
+        }
+    }
+    w.u16((uint16_t)pool.len);
+
+    if (!w.ok || w.len != table_len) {
+        free(buf);
+        return false;
+    }
+
+    *out = buf;
+    *out_len = table_len + pool.len;
+    return true;
+}
+
+static bool macros_pool_string(const char* pool, size_t pool_len, uint16_t off, char* dst, size_t dst_len) {
+    if (off >= pool_len) return false;
+    const size_t n = strnlen(pool + off, pool_len - off);
+    if (off + n >= pool_len) return false;  // Unterminated.
+    strlcpy(dst, pool + off, dst_len);
+    return true;
+}
+
+// Decode a compact config into cfg, its screen 0 landing on screen `first`.
+// Buttons that were not stored keep their value in cfg, so the caller resets
+// the screens first.
+static bool macros_decode_screens(const uint8_t* buf, size_t len, MacroConfig* cfg, unsigned first) {
+    MacrosReader r = {buf, len, 0, true};
+    const unsigned screens = r.u8();
+    const unsigned per_screen = r.u8();
+    const unsigned records = r.u16();
+
+    const size_t table_len = 4 + 16 + (size_t)screens * 6 + (size_t)records * kMacrosRecordBytes;
+    if (table_len + 2 > len) return false;
+    MacrosReader tail = {buf, len, table_len, true};
+    const size_t pool_len = tail.u16();
+    if (pool_len == 0 || table_len + 2 + pool_len != len) return false;
+    const char* pool = reinterpret_cast<const char*>(buf + table_len + 2);
+
+    cfg->default_screen_bg = r.u32();
+    cfg->default_button_bg = r.u32();
+    cfg->default_icon_color = r.u32();
+    cfg->default_label_color = r.u32();
+    for (unsigned s = 0; s < screens; s++) {
+        const uint32_t bg = r.u32();
+        if (first + s < MACROS_SCREEN_COUNT) cfg->screen_bg[first + s] = bg;
+    }
+    for (unsigned s = 0; s < screens; s++) {
+        const uint16_t off = r.u16();
+        const unsigned t = first + s;
+        if (t >= MACROS_SCREEN_COUNT) continue;
+        if (!macros_pool_string(pool, pool_len, off, cfg->template_id[t], sizeof(cfg->template_id[t]))) return false;
+    }
+
+    for (unsigned i = 0; i < records && r.ok; i++) {
+        const unsigned s = r.u8();
+        const uint8_t b = r.u8();
+        const uint8_t action = r.u8();
+        const uint8_t icon_type = r.u8();
+        const uint32_t button_bg = r.u32();
+        const uint32_t icon_color = r.u32();
+        const uint32_t label_color = r.u32();
+        uint16_t offs[5];
+        for (int k = 0; k < 5; k++) offs[k] = r.u16();
+        if (s >= screens || b >= per_screen) return false;
+        if (first + s >= MACROS_SCREEN_COUNT || b >= MACROS_BUTTONS_PER_SCREEN) continue;
+
+        MacroButtonConfig& btn = cfg->buttons[first + s][b];
+        btn.action = (MacroButtonAction)action;
+        btn.icon.type = (MacroIconType)icon_type;
+        btn.button_bg = button_bg;
+        btn.icon_color = icon_color;
+        btn.label_color = label_color;
+        if (!macros_pool_string(pool, pool_len, offs[0], btn.label, sizeof(btn.label)) ||
+            !macros_pool_string(pool, pool_len, offs[1], btn.payload, sizeof(btn.payload)) ||
+            !macros_pool_string(pool, pool_len, offs[2], btn.mqtt_topic, sizeof(btn.mqtt_topic)) ||
+            !macros_pool_string(pool, pool_len, offs[3], btn.icon.id, sizeof(btn.icon.id)) ||
+            !macros_pool_string(pool, pool_len, offs[4], btn.icon.display, sizeof(btn.icon.display))) {
+            return false;
+        }
+    }
+
+    return r.ok && r.pos == table_len;
+}
+
+// Decode a compact config. cfg is reset to defaults first, so buttons that
+// were not stored come back as defaults.
+static bool macros_decode(const uint8_t* buf, size_t len, MacroConfig* cfg) {
+    macros_config_set_defaults(cfg);
+    return macros_decode_screens(buf, len, cfg, 0);
+}
+
+// ===== Indexed file (MACROS_VERSION 11) =====
+//
+// The stored body is one compact encoding per screen (screen_count 1, as
+// macros_config_encode_screen() writes it) behind a directory:
+//
+//   u8  screen_count, u8 reserved[3]
+//   u32 chunk_len[screen_count]
+//   chunks, in screen order
+//
+// Every chunk repeats the 16 bytes of default colors. A boot reads the
+// directory and the default screen's chunk only (macros_config_load_lazy).
+
+static const size_t kMacrosMaxScreenBytes =
+    4 + 16 + 6 + (size_t)MACROS_BUTTONS_PER_SCREEN * kMacrosRecordBytes + 2 + 0xFFFFu;
+static const size_t kMacrosMaxStoredBytes = 4 + (size_t)MACROS_SCREEN_COUNT * (4 + kMacrosMaxScreenBytes);
+
+// Where each compiled-in screen's chunk sits, from the start of the body.
+struct MacrosIndex {
+    uint8_t count;  // screens stored, capped at MACROS_SCREEN_COUNT
+    uint32_t offset[MACROS_SCREEN_COUNT];
+    uint32_t length[MACROS_SCREEN_COUNT];
+};
+
+static bool macros_encode_indexed(const MacroConfig* cfg, uint8_t** out, size_t* out_len) {
+    *out = nullptr;
+    *out_len = 0;
+
+    uint8_t* chunk[MACROS_SCREEN_COUNT] = {};
+    size_t chunk_len[MACROS_SCREEN_COUNT] = {};
+    size_t total = 4 + (size_t)MACROS_SCREEN_COUNT * 4;
+    bool ok = true;
+    for (int s = 0; s < MACROS_SCREEN_COUNT && ok; s++) {
+        ok = macros_encode_screens(cfg, s, 1, &chunk[s], &chunk_len[s]);
+        total += chunk_len[s];
+    }
+
+    uint8_t* buf = ok ? macros_alloc(total) : nullptr;
+    if (buf) {
+        MacrosWriter w = {buf, total, 0, true};
+        w.u8((uint8_t)MACROS_SCREEN_COUNT);
+        w.u8(0);
+        w.u16(0);
+        for (int s = 0; s < MACROS_SCREEN_COUNT; s++) w.u32((uint32_t)chunk_len[s]);
+        for (int s = 0; s < MACROS_SCREEN_COUNT; s++) w.put(chunk[s], chunk_len[s]);
+        *out = buf;
+        *out_len = w.len;
+    }
+    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) free(chunk[s]);
+    return buf != nullptr;
+}
+
+// dir holds the screens u32 lengths that follow the 4-byte preamble of a
+// body of body_len bytes.
+static bool macros_index_parse(const uint8_t* dir, unsigned screens, size_t body_len, MacrosIndex* idx) {
+    if (screens == 0) return false;
+    MacrosReader r = {dir, (size_t)screens * 4, 0, true};
+    size_t off = 4 + (size_t)screens * 4;
+    idx->count = 0;
+    for (unsigned s = 0; s < screens; s++) {
+        const uint32_t len = r.u32();
+        if (len == 0 || len > kMacrosMaxScreenBytes) return false;
+        if (s < MACROS_SCREEN_COUNT) {
+            idx->offset[s] = (uint32_t)off;
+            idx->length[s] = len;
+            idx->count = (uint8_t)(s + 1);
+        }
+        off += len;
+    }
+    return off == body_len;
+}
+
+// One screen's chunk into screen `screen` of cfg (not reset first).
+static bool macros_decode_chunk(const uint8_t* buf, size_t len, MacroConfig* cfg, unsigned screen) {
+    return len > 0 && buf[0] == 1 && macros_decode_screens(buf, len, cfg, screen);
+}
+
+// Decode a whole indexed body. cfg is reset to defaults first.
+static bool macros_decode_indexed(const uint8_t* buf, size_t len, MacroConfig* cfg) {
+    macros_config_set_defaults(cfg);
+    if (len < 4 || len < 4 + (size_t)buf[0] * 4) return false;
+
+    MacrosIndex idx;
+    if (!macros_index_parse(buf + 4, buf[0], len, &idx)) return false;
+    for (unsigned s = 0; s < idx.count; s++) {
+        if (!macros_decode_chunk(buf + idx.offset[s], idx.length[s], cfg, s)) return false;
+    }
+    return true;
+}
+
+// Result of reading a stored config.
+enum class MacrosLoadResult : uint8_t {
+    Missing,   // Nothing stored (or wrong magic/version): use defaults.
+    Loaded,
+    Migrated,  // Older format: loaded; should be rewritten as MACROS_VERSION.
+    Invalid,   // Stored data is damaged.
+};
+
+#if defined(ARDUINO_ARCH_ESP32) && BOOT_MACROS_LAZY
+#define MACROS_LAZY 1
+#else
+#define MACROS_LAZY 0
+#endif
+
+#if MACROS_LAZY
+// ===== Lazy load (BOOT_MACROS_LAZY) =====
+//
+// macros_config_load_lazy() decodes the default screen and keeps /macros.bin
+// open with its directory. The other screens are read one chunk at a time by
+// the MacrosLoad task, or by whichever task needs one first
+// (macros_config_ensure_screen / _ensure_loaded); g_lazy_lock serializes the
+// reads. Chunks decode straight into the runtime config: nothing draws, runs
+// or saves a screen before ensuring it.
+static SemaphoreHandle_t g_lazy_lock = nullptr;
+static MacroConfig* g_lazy_cfg = nullptr;
+static File g_lazy_file;
+static MacrosIndex g_lazy_index;
+static volatile bool g_lazy_pending[MACROS_SCREEN_COUNT];
+static volatile uint8_t g_lazy_remaining = 0;
+static void (*g_lazy_done)(MacroConfig* cfg) = nullptr;
+static unsigned long g_lazy_t0 = 0;
+
+// Read screen s's chunk from f (positioned anywhere) into cfg.
+static bool macros_read_chunk(File& f, const MacrosIndex& idx, unsigned s, MacroConfig* cfg) {
+    if (s >= idx.count || !f.seek(sizeof(MacrosFileHeader) + idx.offset[s])) return false;
+    uint8_t* buf = macros_alloc(idx.length[s]);
+    if (!buf) return false;
+    const bool ok = f.readBytes(reinterpret_cast<char*>(buf), idx.length[s]) == idx.length[s] &&
+        macros_decode_chunk(buf, idx.length[s], cfg, s);
+    free(buf);
+    return ok;
+}
+
+// f is past the header of an indexed body of body_len bytes. Decodes screen
+// `first` and, when others are stored, keeps f for the lazy readers.
+static MacrosLoadResult macros_lazy_begin(File& f, size_t body_len, MacroConfig* cfg, uint8_t first) {
+    uint8_t pre[4];
+    if (f.readBytes(reinterpret_cast<char*>(pre), sizeof(pre)) != sizeof(pre) || 4 + (size_t)pre[0] * 4 > body_len) {
+        f.close();
+        return MacrosLoadResult::Invalid;
+    }
+    const size_t dir_len = (size_t)pre[0] * 4;
+    uint8_t* dir = macros_alloc(dir_len ? dir_len : 1);
+    if (!dir) {
+        f.close();
+        return MacrosLoadResult::Invalid;
+    }
+    const bool parsed = f.readBytes(reinterpret_cast<char*>(dir), dir_len) == dir_len &&
+        macros_index_parse(dir, pre[0], body_len, &g_lazy_index);
+    free(dir);
+
+    macros_config_set_defaults(cfg);
+    if (!parsed || (first < g_lazy_index.count && !macros_read_chunk(f, g_lazy_index, first, cfg))) {
+        f.close();
+        return MacrosLoadResult::Invalid;
+    }
+
+    uint8_t remaining = 0;
+    for (uint8_t s = 0; s < g_lazy_index.count; s++) {
+        g_lazy_pending[s] = s != first;
+        if (s != first) remaining++;
+    }
+    if (remaining == 0) {
+        f.close();
+        return MacrosLoadResult::Loaded;
+    }
+    g_lazy_file = f;
+    g_lazy_cfg = cfg;
+    g_lazy_remaining = remaining;
+    return MacrosLoadResult::Loaded;
+}
+#endif // MACROS_LAZY
+
+// lazy_screen >= 0 (BOOT_MACROS_LAZY builds): decode only that screen of an
+// indexed file and leave the rest to macros_lazy_begin's readers.
+static MacrosLoadResult macros_load_from_ffat(MacroConfig* cfg, size_t* out_stored, const char* path, int lazy_screen = -1) {
+    if (!cfg) return MacrosLoadResult::Missing;
+    if (!ensure_ffat()) return MacrosLoadResult::Missing;
 
 #if defined(ARDUINO_ARCH_ESP32)
-    File f = FFat.open(kMacrosPath, FILE_READ);
-    if (!f) return false;
+    File f = FFat.open(path, FILE_READ);
+    if (!f) return MacrosLoadResult::Missing;
 
     MacrosFileHeader hdr;
-    if (f.readBytes(reinterpret_cast<char*>(&hdr), sizeof(hdr)) != sizeof(hdr)) {
+    if (f.readBytes(reinterpret_cast<char*>(&hdr), sizeof(hdr)) != sizeof(hdr) || hdr.magic != MACROS_MAGIC) {
         f.close();
-        return false;
+        return MacrosLoadResult::Missing;
     }
 
-    const size_t expected = sizeof(MacroConfig);
-    if (hdr.magic != MACROS_MAGIC || hdr.version != MACROS_VERSION || hdr.size != expected) {
+    if (hdr.version == MACROS_LEGACY_VERSION) {
+        const size_t expected = sizeof(MacroConfig);
+        if (hdr.size != expected) {
+            f.close();
+            return MacrosLoadResult::Missing;
+        }
+        const size_t read = f.readBytes(reinterpret_cast<char*>(cfg), expected);
         f.close();
-        return false;
+        *out_stored = read;
+        return read == expected ? MacrosLoadResult::Migrated : MacrosLoadResult::Invalid;
+    }
+
+    const bool compact = hdr.version == MACROS_COMPACT_VERSION;
+    if ((hdr.version != MACROS_VERSION && !compact) || hdr.size == 0 ||
+        hdr.size > (compact ? kMacrosMaxEncodedBytes : kMacrosMaxStoredBytes) || hdr.size != f.size() - sizeof(hdr)) {
+        f.close();
+        return MacrosLoadResult::Missing;
     }
 
-    const size_t read = f.readBytes(reinterpret_cast<char*>(cfg), expected);
+#if MACROS_LAZY
+    if (!compact && lazy_screen >= 0) {
+        *out_stored = hdr.size;
+        return macros_lazy_begin(f, hdr.size, cfg, (uint8_t)lazy_screen);
+    }
+#else
+    (void)lazy_screen;
+#endif
+
+    uint8_t* buf = macros_alloc(hdr.size);
+    if (!buf) {
+        f.close();
+        return MacrosLoadResult::Invalid;
+    }
+    const size_t read = f.readBytes(reinterpret_cast<char*>(buf), hdr.size);
     f.close();
-    return read == expected;
+
+    const bool ok = read == hdr.size && (compact ? macros_decode(buf, hdr.size, cfg) : macros_decode_indexed(buf, hdr.size, cfg));
+    free(buf);
+    *out_stored = hdr.size;
+    if (!ok) return MacrosLoadResult::Invalid;
+    return compact ? MacrosLoadResult::Migrated : MacrosLoadResult::Loaded;
 #else
-    return false;
+    (void)lazy_screen;
+    return MacrosLoadResult::Missing;
 #endif
 }
 
-static bool macros_save_to_ffat(const MacroConfig* cfg) {
-    if (!cfg) return false;
+static bool macros_save_to_ffat(const uint8_t* data, size_t len, const char* path, const char* tmp_path) {
     if (!ensure_ffat()) return false;
 
 #if defined(ARDUINO_ARCH_ESP32)
     // Write to a temp file then rename for basic atomicity.
-    FFat.remove(kMacrosTmpPath);
-    File f = FFat.open(kMacrosTmpPath, FILE_WRITE);
+    if (FFat.exists(tmp_path)) fs_health_ffat_remove(tmp_path);
+    File f = FFat.open(tmp_path, FILE_WRITE);
     if (!f) return false;
 
     MacrosFileHeader hdr;
@@ -122,27 +638,23 @@ static bool macros_save_to_ffat(const MacroConfig* cfg) {
     hdr.version = MACROS_VERSION;
     hdr.reserved0 = 0;
     hdr.reserved1 = 0;
-    hdr.size = (uint32_t)sizeof(MacroConfig);
-
-    if (f.write(reinterpret_cast<const uint8_t*>(&hdr), sizeof(hdr)) != sizeof(hdr)) {
-        f.close();
-        FFat.remove(kMacrosTmpPath);
-        return false;
-    }
+    hdr.size = (uint32_t)len;
 
-    const size_t expected = sizeof(MacroConfig);
-    if (f.write(reinterpret_cast<const uint8_t*>(cfg), expected) != expected) {
+    if (f.write(reinterpret_cast<const uint8_t*>(&hdr), sizeof(hdr)) != sizeof(hdr) ||
+        f.write(data, len) != len) {
         f.close();
-        FFat.remove(kMacrosTmpPath);
+        FFat.remove(tmp_path);
         return false;
     }
 
     f.flush();
+    const uint32_t new_size = (uint32_t)f.size();
     f.close();
+    fs_health_note_ffat_file(0, new_size);
 
-    FFat.remove(kMacrosPath);
-    if (!FFat.rename(kMacrosTmpPath, kMacrosPath)) {
-        FFat.remove(kMacrosTmpPath);
+    if (FFat.exists(path)) fs_health_ffat_remove(path);
+    if (!FFat.rename(tmp_path, path)) {
+        fs_health_ffat_remove(tmp_path);
         return false;
     }
 
@@ -155,14 +667,110 @@ static bool macros_save_to_ffat(const MacroConfig* cfg) {
 static bool macros_reset_ffat() {
     if (!ensure_ffat()) return false;
 #if defined(ARDUINO_ARCH_ESP32)
-    const bool ok1 = !FFat.exists(kMacrosPath) || FFat.remove(kMacrosPath);
-    const bool ok2 = !FFat.exists(kMacrosTmpPath) || FFat.remove(kMacrosTmpPath);
+    const bool ok1 = !FFat.exists(kMacrosPath) || fs_health_ffat_remove(kMacrosPath);
+    const bool ok2 = !FFat.exists(kMacrosTmpPath) || fs_health_ffat_remove(kMacrosTmpPath);
     return ok1 && ok2;
 #else
     return false;
 #endif
 }
 
+static volatile uint32_t g_macros_generation = 1;
+static volatile uint32_t g_screen_generation[MACROS_SCREEN_COUNT];
+static volatile uint32_t g_button_generation[MACROS_SCREEN_COUNT][MACROS_BUTTONS_PER_SCREEN];
+
+// Per-screen/per-button counters start at 0 and are read as base + 1, so the
+// arrays can live in .bss and still report 1 before the first change.
+uint32_t macros_config_generation() {
+    return g_macros_generation;
+}
+
+uint32_t macros_config_screen_generation(uint8_t screen) {
+    if (screen >= MACROS_SCREEN_COUNT) return 0;
+    return g_screen_generation[screen] + 1;
+}
+
+uint32_t macros_config_button_generation(uint8_t screen, uint8_t button) {
+    if (screen >= MACROS_SCREEN_COUNT || button >= MACROS_BUTTONS_PER_SCREEN) return 0;
+    return g_button_generation[screen][button] + 1;
+}
+
+static void macros_bump_screen(uint8_t screen) {
+    g_screen_generation[screen] = g_screen_generation[screen] + 1;
+}
+
+static void macros_bump_button(uint8_t screen, uint8_t button) {
+    g_button_generation[screen][button] = g_button_generation[screen][button] + 1;
+}
+
+void macros_config_mark_changed() {
+    for (uint8_t s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        macros_bump_screen(s);
+        for (uint8_t b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+            macros_bump_button(s, b);
+        }
+    }
+    g_macros_generation = g_macros_generation + 1;
+}
+
+void macros_config_mark_screen_changed(uint8_t screen) {
+    if (screen >= MACROS_SCREEN_COUNT) return;
+    macros_bump_screen(screen);
+    g_macros_generation = g_macros_generation + 1;
+}
+
+void macros_config_mark_button_changed(uint8_t screen, uint8_t button) {
+    if (screen >= MACROS_SCREEN_COUNT || button >= MACROS_BUTTONS_PER_SCREEN) return;
+    macros_bump_button(screen, button);
+    g_macros_generation = g_macros_generation + 1;
+}
+
+void macros_config_mark_diff(const MacroConfig* prev, const MacroConfig* next) {
+    if (!prev || !next) {
+        macros_config_mark_changed();
+        return;
+    }
+
+    // The global defaults feed every screen's background and button colors.
+    const bool defaultsChanged =
+        prev->default_screen_bg != next->default_screen_bg
+        || prev->default_button_bg != next->default_button_bg
+        || prev->default_icon_color != next->default_icon_color
+        || prev->default_label_color != next->default_label_color;
+
+    for (uint8_t s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        if (defaultsChanged
+            || prev->screen_bg[s] != next->screen_bg[s]
+            || strncmp(prev->template_id[s], next->template_id[s], MACROS_TEMPLATE_ID_MAX_LEN) != 0) {
+            macros_bump_screen(s);
+        }
+        for (uint8_t b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+            // Both sides are zero-filled before being populated, so struct
+            // padding compares equal; a spurious mismatch only costs a redraw.
+            if (memcmp(&prev->buttons[s][b], &next->buttons[s][b], sizeof(MacroButtonConfig)) != 0) {
+                macros_bump_button(s, b);
+            }
+        }
+    }
+    g_macros_generation = g_macros_generation + 1;
+}
+
+// Screen s back to its defaults (cfg is zero-filled or was before).
+static void macros_screen_set_defaults(MacroConfig* cfg, int s) {
+    cfg->screen_bg[s] = MACROS_COLOR_UNSET;
+    strlcpy(cfg->template_id[s], "round_ring_9", sizeof(cfg->template_id[s]));
+
+    for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+        MacroButtonConfig& btn = cfg->buttons[s][b];
+        memset(&btn, 0, sizeof(btn));
+        btn.action = MacroButtonAction::None;
+        btn.icon.type = MacroIconType::None;
+        btn.button_bg = MACROS_COLOR_UNSET;
+        btn.icon_color = MACROS_COLOR_UNSET;
+        btn.label_color = MACROS_COLOR_UNSET;
+    }
+}
+
 void macros_config_set_defaults(MacroConfig* cfg) {
     if (!cfg) return;
     memset(cfg, 0, sizeof(MacroConfig));
@@ -174,31 +782,84 @@ void macros_config_set_defaults(MacroConfig* cfg) {
     cfg->default_label_color = 0xFFFFFF; // white
 
     for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
-        cfg->screen_bg[s] = MACROS_COLOR_UNSET;
+        macros_screen_set_defaults(cfg, s);
     }
+}
 
-    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
-        strlcpy(cfg->template_id[s], "round_ring_9", sizeof(cfg->template_id[s]));
+const char* macros_action_to_string(MacroButtonAction a) {
+    switch (a) {
+        case MacroButtonAction::None: return "none";
+        case MacroButtonAction::SendKeys: return "send_keys";
+        case MacroButtonAction::NavPrevScreen: return "nav_prev";
+        case MacroButtonAction::NavNextScreen: return "nav_next";
+        case MacroButtonAction::NavToScreen: return "nav_to";
+        case MacroButtonAction::GoBack: return "go_back";
+        case MacroButtonAction::MqttSend: return "mqtt_send";
+        case MacroButtonAction::BleHost: return "ble_host";
+        default: return "none";
     }
+}
 
-    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
-        for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
-            cfg->buttons[s][b].action = MacroButtonAction::None;
-            cfg->buttons[s][b].label[0] = '\0';
-            cfg->buttons[s][b].payload[0] = '\0';
-            cfg->buttons[s][b].mqtt_topic[0] = '\0';
-
-            cfg->buttons[s][b].icon.type = MacroIconType::None;
-            cfg->buttons[s][b].icon.id[0] = '\0';
-            cfg->buttons[s][b].icon.display[0] = '\0';
-
-            cfg->buttons[s][b].button_bg = MACROS_COLOR_UNSET;
-            cfg->buttons[s][b].icon_color = MACROS_COLOR_UNSET;
-            cfg->buttons[s][b].label_color = MACROS_COLOR_UNSET;
-        }
+const char* macros_icon_type_to_string(MacroIconType t) {
+    switch (t) {
+        case MacroIconType::None: return "none";
+        case MacroIconType::Builtin: return "builtin";
+        case MacroIconType::Emoji: return "emoji";
+        case MacroIconType::Asset: return "asset";
+        default: return "none";
     }
 }
 
+MacroIconType macros_icon_type_from_string(const char* s) {
+    if (!s || !*s) return MacroIconType::None;
+    if (strcasecmp(s, "none") == 0) return MacroIconType::None;
+    if (strcasecmp(s, "builtin") == 0) return MacroIconType::Builtin;
+    if (strcasecmp(s, "emoji") == 0) return MacroIconType::Emoji;
+    if (strcasecmp(s, "asset") == 0) return MacroIconType::Asset;
+    return MacroIconType::None;
+}
+
+MacroButtonAction macros_action_from_string(const char* s) {
+    if (!s || !*s) return MacroButtonAction::None;
+    if (strcasecmp(s, "none") == 0) return MacroButtonAction::None;
+    if (strcasecmp(s, "send_keys") == 0) return MacroButtonAction::SendKeys;
+    if (strcasecmp(s, "nav_prev") == 0) return MacroButtonAction::NavPrevScreen;
+    if (strcasecmp(s, "nav_next") == 0) return MacroButtonAction::NavNextScreen;
+    if (strcasecmp(s, "nav_to") == 0) return MacroButtonAction::NavToScreen;
+    if (strcasecmp(s, "go_back") == 0) return MacroButtonAction::GoBack;
+    if (strcasecmp(s, "mqtt_send") == 0) return MacroButtonAction::MqttSend;
+    if (strcasecmp(s, "ble_host") == 0) return MacroButtonAction::BleHost;
+    return MacroButtonAction::None;
+}
+
+const char* macros_button_normalize(MacroButtonConfig* btn) {
+    // Normalize: if action is none, clear payload/icon to keep state tidy.
+    if (btn->action == MacroButtonAction::None) {
+        btn->payload[0] = '\0';
+        btn->mqtt_topic[0] = '\0';
+        btn->icon.type = MacroIconType::None;
+        btn->icon.id[0] = '\0';
+        btn->icon.display[0] = '\0';
+    }
+
+    // Validate: mqtt_send requires a topic.
+    if (btn->action == MacroButtonAction::MqttSend && !btn->mqtt_topic[0]) {
+        return "mqtt_send requires mqtt_topic";
+    }
+
+    // For non-MQTT actions, ignore stored mqtt_topic.
+    if (btn->action != MacroButtonAction::MqttSend) {
+        btn->mqtt_topic[0] = '\0';
+    }
+
+    // For non-payload actions, ignore stored payload.
+    if (btn->action != MacroButtonAction::SendKeys && btn->action != MacroButtonAction::NavToScreen &&
+        btn->action != MacroButtonAction::MqttSend && btn->action != MacroButtonAction::BleHost) {
+        btn->payload[0] = '\0';
+    }
+    return nullptr;
+}
+
 static bool begin_readonly() {
     return prefs.begin(MACROS_NAMESPACE, true);
 }
@@ -207,114 +868,280 @@ static bool begin_readwrite() {
     return prefs.begin(MACROS_NAMESPACE, false);
 }
 
-bool macros_config_load(MacroConfig* cfg) {
-    if (!cfg) return false;
+static MacrosLoadResult macros_load_from_nvs(Preferences& prefs, const char* ns, MacroConfig* cfg, size_t* out_stored) {
+    if (!prefs.begin(ns, true)) {
+        Logger.logLine("Preferences begin failed");
+        return MacrosLoadResult::Missing;
+    }
 
-    Logger.logBegin("Macros Load");
+    const uint32_t magic = prefs.getUInt(KEY_MAGIC, 0);
+    const uint8_t version = prefs.getUChar(KEY_VER, 0);
+    const size_t got = prefs.getBytesLength(KEY_BLOB);
 
-    // Prefer FFat when available (avoids NVS size limits on large macro payloads).
-    if (macros_load_from_ffat(cfg)) {
-        Logger.logEnd("OK (FFat)");
-        return true;
+    const bool legacy = version == MACROS_LEGACY_VERSION;
+    const bool compact = version == MACROS_COMPACT_VERSION;
+    if (magic != MACROS_MAGIC || (version != MACROS_VERSION && !compact && !legacy) || got == 0) {
+        prefs.end();
+        return MacrosLoadResult::Missing;
     }
 
-    if (!begin_readonly()) {
-        Logger.logEnd("Preferences begin failed");
-        macros_config_set_defaults(cfg);
-        return false;
+    if (legacy ? got != sizeof(MacroConfig) : got > (compact ? kMacrosMaxEncodedBytes : kMacrosMaxStoredBytes)) {
+        prefs.end();
+        Logger.logLinef("Size mismatch: got=%u", (unsigned)got);
+        return MacrosLoadResult::Invalid;
     }
 
-    const uint32_t magic = prefs.getUInt(KEY_MAGIC, 0);
-    const uint8_t version = prefs.getUChar(KEY_VER, 0);
+    if (legacy) {
+        const size_t read = prefs.getBytes(KEY_BLOB, cfg, got);
+        prefs.end();
+        *out_stored = read;
+        return read == got ? MacrosLoadResult::Migrated : MacrosLoadResult::Invalid;
+    }
 
-    if (magic != MACROS_MAGIC || version != MACROS_VERSION) {
+    uint8_t* buf = macros_alloc(got);
+    if (!buf) {
         prefs.end();
-        Logger.logEnd("No macros config");
-        macros_config_set_defaults(cfg);
+        return MacrosLoadResult::Invalid;
+    }
+    const size_t read = prefs.getBytes(KEY_BLOB, buf, got);
+    prefs.end();
+
+    // A blob is read whole, so there is nothing to gain from decoding it lazily.
+    const bool ok = read == got && (compact ? macros_decode(buf, got, cfg) : macros_decode_indexed(buf, got, cfg));
+    free(buf);
+    *out_stored = got;
+    if (!ok) return MacrosLoadResult::Invalid;
+    return compact ? MacrosLoadResult::Migrated : MacrosLoadResult::Loaded;
+}
+
+static bool macros_save_to_nvs(Preferences& prefs, const char* ns, const uint8_t* data, size_t len) {
+    if (!prefs.begin(ns, false)) {
+        Logger.logLine("Preferences begin failed");
         return false;
     }
 
-    const size_t expected = sizeof(MacroConfig);
-    const size_t got = prefs.getBytesLength(KEY_BLOB);
-    if (got == 0) {
-        prefs.end();
+    const size_t written = prefs.putBytes(KEY_BLOB, data, len);
+
+    // Only mark the blob as valid if the full write succeeded.
+    if (written == len) {
+        prefs.putUInt(KEY_MAGIC, MACROS_MAGIC);
+        prefs.putUChar(KEY_VER, MACROS_VERSION);
+    }
+
+    prefs.end();
+
+    if (written != len) {
+        Logger.logLinef("Write failed: %u/%u", (unsigned)written, (unsigned)len);
+        if (written == 0) {
+            Logger.logLine("Hint: NVS partition may be too small for macros blob");
+        }
+        return false;
+    }
+    return true;
+}
+
+static bool macros_store(const MacroConfig* cfg, bool* out_ffat, size_t* out_len) {
+    uint8_t* data = nullptr;
+    size_t len = 0;
+    if (!macros_encode_indexed(cfg, &data, &len)) {
+        Logger.logLine("Encode failed (out of memory)");
+        return false;
+    }
+
+    // Prefer FFat when available.
+    *out_ffat = macros_save_to_ffat(data, len, kMacrosPath, kMacrosTmpPath);
+    const bool ok = *out_ffat || macros_save_to_nvs(prefs, MACROS_NAMESPACE, data, len);
+    free(data);
+    *out_len = len;
+    return ok;
+}
+
+static bool macros_load(MacroConfig* cfg, int lazy_screen) {
+    if (!cfg) return false;
+
+    Logger.logBegin("Macros Load");
+    const unsigned long t0 = millis();
+
+    // Prefer FFat when available (avoids NVS size limits on large macro payloads).
+    size_t stored = 0;
+    bool from_ffat = true;
+    MacrosLoadResult res = macros_load_from_ffat(cfg, &stored, kMacrosPath, lazy_screen);
+    if (res == MacrosLoadResult::Missing) {
+        from_ffat = false;
+        res = macros_load_from_nvs(prefs, MACROS_NAMESPACE, cfg, &stored);
+    }
+
+    if (res == MacrosLoadResult::Missing) {
         Logger.logEnd("No macros config");
         macros_config_set_defaults(cfg);
         return false;
     }
 
-    if (got != expected) {
-        prefs.end();
-        Logger.logLinef("Size mismatch: got=%u expected=%u", (unsigned)got, (unsigned)expected);
-
-        // Most commonly this happens after a failed/partial save (e.g. old NVS too small)
-        // or after a struct size change. Clear the namespace so we don't keep erroring.
-        if (begin_readwrite()) {
+    if (res == MacrosLoadResult::Invalid) {
+        // Most commonly this happens after a failed/partial save (e.g. old NVS too small).
+        // Clear the NVS copy so we don't keep erroring; a bad file is replaced on the next save.
+        if (!from_ffat && begin_readwrite()) {
             prefs.clear();
             prefs.end();
-            Logger.logLine("Cleared stored macros (size mismatch)");
+            Logger.logLine("Cleared stored macros");
         }
-
         Logger.logEnd("Invalid macros config");
         macros_config_set_defaults(cfg);
         return false;
     }
 
-    const size_t read = prefs.getBytes(KEY_BLOB, cfg, expected);
-    prefs.end();
-
-    if (read != expected) {
-        Logger.logLinef("Read failed: %u/%u", (unsigned)read, (unsigned)expected);
-        Logger.logEnd("Invalid macros config");
-        macros_config_set_defaults(cfg);
-        return false;
+#if MACROS_LAZY
+    if (g_lazy_remaining > 0) {
+        g_lazy_t0 = t0;
+        Logger.logLinef("Screen %d in %lu ms (%u bytes stored); %u more to follow", lazy_screen + 1,
+            (unsigned long)(millis() - t0), (unsigned)stored, (unsigned)g_lazy_remaining);
+    } else
+#endif
+    Logger.logLinef("%u bytes in %lu ms", (unsigned)stored, (unsigned long)(millis() - t0));
+
+    if (res == MacrosLoadResult::Migrated) {
+        bool to_ffat = false;
+        size_t len = 0;
+        if (macros_store(cfg, &to_ffat, &len)) {
+            Logger.logLinef("Migrated to v%u (%u bytes)", (unsigned)MACROS_VERSION, (unsigned)len);
+        } else {
+            Logger.logLine("Migration save failed; keeping old copy");
+        }
     }
 
-    Logger.logEnd("OK");
+    Logger.logEnd(from_ffat ? "OK (FFat)" : "OK");
     return true;
 }
 
-bool macros_config_save(const MacroConfig* cfg) {
+bool macros_config_load(MacroConfig* cfg) {
+    return macros_load(cfg, -1);
+}
+
+#if MACROS_LAZY
+// Last screen in: close the file and hand the config over. Any task.
+static void macros_lazy_finish() {
+    MacroConfig* cfg = nullptr;
+    xSemaphoreTake(g_lazy_lock, portMAX_DELAY);
+    if (g_lazy_remaining == 0 && g_lazy_cfg) {
+        g_lazy_file.close();
+        cfg = g_lazy_cfg;
+        g_lazy_cfg = nullptr;
+    }
+    xSemaphoreGive(g_lazy_lock);
+    if (!cfg) return;
+
+    Logger.logMessagef("Macros", "All screens loaded in %lu ms", (unsigned long)(millis() - g_lazy_t0));
+    if (g_lazy_done) g_lazy_done(cfg);
+}
+
+static void macros_lazy_task(void* arg) {
+    const unsigned first = (unsigned)(uintptr_t)arg;
+    // Following screens first: swiping forward is the common path.
+    for (unsigned i = 1; i < MACROS_SCREEN_COUNT; i++) {
+        macros_config_ensure_screen((uint8_t)((first + i) % MACROS_SCREEN_COUNT));
+    }
+    macros_lazy_finish();
+    vTaskDelete(nullptr);
+}
+#endif // MACROS_LAZY
+
+bool macros_config_load_lazy(MacroConfig* cfg, uint8_t screen, void (*on_done)(MacroConfig* cfg)) {
     if (!cfg) return false;
 
-    Logger.logBegin("Macros Save");
+#if MACROS_LAZY
+    if (!g_lazy_lock) g_lazy_lock = xSemaphoreCreateMutex();
+    if (g_lazy_lock && !g_lazy_cfg && screen < MACROS_SCREEN_COUNT) {
+        const bool loaded = macros_load(cfg, screen);
+        if (g_lazy_remaining == 0) {
+            if (on_done) on_done(cfg);
+            return loaded;
+        }
 
-    // Prefer FFat when available.
-    if (macros_save_to_ffat(cfg)) {
-        Logger.logEnd("OK (FFat)");
-        return true;
+        g_lazy_done = on_done;
+        // Idle priority: the screens trickle in while rendering and input are idle.
+        if (xTaskCreate(macros_lazy_task, "MacrosLoad", BOOT_MACROS_TASK_STACK_BYTES, (void*)(uintptr_t)screen,
+                tskIDLE_PRIORITY, nullptr) != pdPASS) {
+            Logger.logMessage("Macros", "Failed to create load task; loading now");
+            macros_config_ensure_loaded();
+        }
+        return loaded;
     }
+#else
+    (void)screen;
+#endif
 
-    if (!begin_readwrite()) {
-        Logger.logEnd("Preferences begin failed");
-        return false;
+    const bool loaded = macros_load(cfg, -1);
+    if (on_done) on_done(cfg);
+    return loaded;
+}
+
+void macros_config_ensure_screen(uint8_t screen) {
+#if MACROS_LAZY
+    if (screen >= MACROS_SCREEN_COUNT || !g_lazy_pending[screen]) return;
+
+    xSemaphoreTake(g_lazy_lock, portMAX_DELAY);
+    if (g_lazy_pending[screen] && g_lazy_cfg) {
+        if (!macros_read_chunk(g_lazy_file, g_lazy_index, screen, g_lazy_cfg)) {
+            Logger.logMessagef("Macros", "Screen %u unreadable; using defaults", (unsigned)screen + 1);
+            macros_screen_set_defaults(g_lazy_cfg, screen);
+        }
+        g_lazy_pending[screen] = false;
+        g_lazy_remaining = g_lazy_remaining - 1;
+        macros_config_mark_screen_changed(screen);
     }
+    const bool last = g_lazy_remaining == 0;
+    xSemaphoreGive(g_lazy_lock);
 
-    const size_t expected = sizeof(MacroConfig);
-    const size_t written = prefs.putBytes(KEY_BLOB, cfg, expected);
+    if (last) macros_lazy_finish();
+#else
+    (void)screen;
+#endif
+}
 
-    // Only mark the blob as valid if the full write succeeded.
-    if (written == expected) {
-        prefs.putUInt(KEY_MAGIC, MACROS_MAGIC);
-        prefs.putUChar(KEY_VER, MACROS_VERSION);
+void macros_config_ensure_loaded() {
+#if MACROS_LAZY
+    if (g_lazy_remaining == 0) return;
+    for (uint8_t s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        macros_config_ensure_screen(s);
     }
+#endif
+}
 
-    prefs.end();
+bool macros_config_save(const MacroConfig* cfg) {
+    if (!cfg) return false;
 
-    if (written != expected) {
-        Logger.logLinef("Write failed: %u/%u", (unsigned)written, (unsigned)expected);
-        if (written == 0) {
-            Logger.logLine("Hint: NVS partition may be too small for macros blob");
-        }
+    // A save replaces /macros.bin and is copied into the live config; stored
+    // screens still to be read must not land on top of it afterwards.
+    macros_config_ensure_loaded();
+
+    Logger.logBegin("Macros Save");
+    const unsigned long t0 = millis();
+
+    bool to_ffat = false;
+    size_t len = 0;
+    if (!macros_store(cfg, &to_ffat, &len)) {
         Logger.logEnd("FAILED");
         return false;
     }
 
-    Logger.logEnd("OK");
+    Logger.logLinef("%u bytes in %lu ms", (unsigned)len, (unsigned long)(millis() - t0));
+    Logger.logEnd(to_ffat ? "OK (FFat)" : "OK");
     return true;
 }
 
+bool macros_config_encode_screen(const MacroConfig* cfg, uint8_t screen, uint8_t** out, size_t* out_len) {
+    if (!cfg || !out || !out_len || screen >= MACROS_SCREEN_COUNT) return false;
+    return macros_encode_screens(cfg, screen, 1, out, out_len);
+}
+
+bool macros_config_decode_screen(const uint8_t* buf, size_t len, uint8_t screen, MacroConfig* cfg) {
+    if (!buf || !cfg || screen >= MACROS_SCREEN_COUNT || len == 0 || buf[0] != 1) return false;
+    macros_screen_set_defaults(cfg, screen);
+    return macros_decode_chunk(buf, len, cfg, screen);
+}
+
 bool macros_config_reset() {
+    macros_config_ensure_loaded();
     Logger.logBegin("Macros Reset");
 
     // Prefer removing the FFat file if present.
@@ -334,3 +1161,63 @@ bool macros_config_reset() {
     Logger.logEnd(ok ? "OK" : "FAILED");
     return ok;
 }
+
+bool macros_config_bench(const MacroConfig* cfg, MacrosBenchResult* out) {
+    if (!cfg || !out) return false;
+    memset(out, 0, sizeof(*out));
+    macros_config_ensure_loaded();
+
+    uint8_t* data = nullptr;
+    size_t len = 0;
+    uint32_t t0 = micros();
+    if (!macros_encode_indexed(cfg, &data, &len)) return false;
+    out->encode_us = micros() - t0;
+    out->encoded_bytes = (uint32_t)len;
+
+    MacroConfig* scratch = (MacroConfig*)macros_alloc(sizeof(MacroConfig));
+    if (!scratch) {
+        free(data);
+        return false;
+    }
+
+    t0 = micros();
+    const bool decoded = macros_decode_indexed(data, len, scratch);
+    out->decode_us = micros() - t0;
+
+    if (decoded && ensure_ffat()) {
+        size_t stored = 0;
+        t0 = micros();
+        const bool saved = macros_save_to_ffat(data, len, kBenchPath, kBenchTmpPath);
+        out->ffat_save_us = micros() - t0;
+        if (saved) {
+            t0 = micros();
+            out->ffat_ok = macros_load_from_ffat(scratch, &stored, kBenchPath) == MacrosLoadResult::Loaded;
+            out->ffat_load_us = micros() - t0;
+        }
+#if defined(ARDUINO_ARCH_ESP32)
+        if (FFat.exists(kBenchPath)) fs_health_ffat_remove(kBenchPath);
+#endif
+    }
+
+    if (decoded) {
+        // Own handle: the live one may be in use by a save on another task.
+        Preferences bench_prefs;
+        size_t stored = 0;
+        t0 = micros();
+        const bool saved = macros_save_to_nvs(bench_prefs, MACROS_BENCH_NAMESPACE, data, len);
+        out->nvs_save_us = micros() - t0;
+        if (saved) {
+            t0 = micros();
+            out->nvs_ok = macros_load_from_nvs(bench_prefs, MACROS_BENCH_NAMESPACE, scratch, &stored) == MacrosLoadResult::Loaded;
+            out->nvs_load_us = micros() - t0;
+        }
+        if (bench_prefs.begin(MACROS_BENCH_NAMESPACE, false)) {
+            bench_prefs.clear();
+            bench_prefs.end();
+        }
+    }
+
+    free(scratch);
+    free(data);
+    return decoded;
+}
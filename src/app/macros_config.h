@@ -22,7 +22,8 @@
 #endif
 
 // Keep sizes conservative to avoid RAM pressure.
-// Note: macros are stored in NVS as a single blob; size changes invalidate stored config.
+// Stored configs keep only set strings (see macros_config.cpp), so these can change
+// without invalidating a saved config; longer stored strings are truncated on load.
 #define MACROS_LABEL_MAX_LEN 16
 #define MACROS_PAYLOAD_MAX_LEN 256
 #define MACROS_MQTT_TOPIC_MAX_LEN 128
@@ -46,6 +47,7 @@ enum class MacroButtonAction : uint8_t {
     NavToScreen = 4,
     GoBack = 5,
     MqttSend = 6,
+    BleHost = 7,      // payload: host profile number, or "next"
 };
 
 enum class MacroIconType : uint8_t {
@@ -102,13 +104,82 @@ struct MacroConfig {
 
 void macros_config_set_defaults(MacroConfig* cfg);
 
+// String forms used by /api/macros (unknown or empty strings map to None).
+const char* macros_action_to_string(MacroButtonAction a);
+MacroButtonAction macros_action_from_string(const char* s);
+const char* macros_icon_type_to_string(MacroIconType t);
+MacroIconType macros_icon_type_from_string(const char* s);
+
+// Clear the fields the button's action does not use. Returns nullptr, or an
+// error message when the button is invalid (mqtt_send without a topic).
+const char* macros_button_normalize(MacroButtonConfig* btn);
+
 // Returns true when a valid config was loaded.
 bool macros_config_load(MacroConfig* cfg);
 
+// Boot load (BOOT_MACROS_LAZY): decode screen `screen`, the one shown first,
+// now and the others from a background task; on_done (optional) runs on
+// whichever task loads the last one. An NVS copy, an older stored format or
+// a build without the flag loads everything here, and on_done runs before
+// this returns. Returns true when a valid config was loaded.
+bool macros_config_load_lazy(MacroConfig* cfg, uint8_t screen, void (*on_done)(MacroConfig* cfg));
+
+// Read `screen` now if the boot load has not reached it yet. Any task; a
+// no-op once it is in. Call before building or running a screen.
+void macros_config_ensure_screen(uint8_t screen);
+
+// Block until every stored screen is in. Call before reading the whole
+// config or replacing it (macros_config_save does).
+void macros_config_ensure_loaded();
+
 // Returns true when write succeeded.
 bool macros_config_save(const MacroConfig* cfg);
 
-// Clears stored macros config from NVS.
+// Clears the stored macros config (FFat file or NVS).
 bool macros_config_reset();
 
+// One screen in the stored encoding (screen_count 1), as fleet sync sends it
+// (MQTT_MACROS_SYNC). The global default colors ride along. The caller frees *out.
+bool macros_config_encode_screen(const MacroConfig* cfg, uint8_t screen, uint8_t** out, size_t* out_len);
+
+// Replace screen `screen` of cfg, and the global default colors, with an
+// encoded screen. On false cfg may be partly written: decode into a copy.
+bool macros_config_decode_screen(const uint8_t* buf, size_t len, uint8_t screen, MacroConfig* cfg);
+
+// Runtime change counter for the live macro config (starts at 1).
+// Bump after replacing the runtime MacroConfig so cached/pre-built UI rebuilds.
+uint32_t macros_config_generation();
+void macros_config_mark_changed();
+
+// Finer-grained change counters (also start at 1). The screen generation covers
+// the screen's template, background and the global default colors; a button
+// generation covers that button's MacroButtonConfig. Every mark below also
+// bumps macros_config_generation(); mark_changed() bumps all of them.
+uint32_t macros_config_screen_generation(uint8_t screen);
+uint32_t macros_config_button_generation(uint8_t screen, uint8_t button);
+void macros_config_mark_screen_changed(uint8_t screen);
+void macros_config_mark_button_changed(uint8_t screen, uint8_t button);
+
+// Call before replacing the runtime config `prev` with `next`: bumps only the
+// screens/buttons that differ.
+void macros_config_mark_diff(const MacroConfig* prev, const MacroConfig* next);
+
+struct MacrosBenchResult {
+    uint32_t encoded_bytes;
+    uint32_t encode_us;
+    uint32_t decode_us;
+    bool ffat_ok;            // saved and loaded back through FFat
+    uint32_t ffat_save_us;
+    uint32_t ffat_load_us;
+    bool nvs_ok;             // ... through NVS (fails when the blob does not fit)
+    uint32_t nvs_save_us;
+    uint32_t nvs_load_us;
+};
+
+// Times the stored form of cfg: encode, decode, and a save + load through
+// each backend, using scratch copies (/macros.bench, NVS namespace
+// "macrosbench") that are removed afterwards. The stored config is not
+// touched. Blocks; not for the LVGL or AsyncTCP task.
+bool macros_config_bench(const MacroConfig* cfg, MacrosBenchResult* out);
+
 #endif // MACROS_CONFIG_H
@@ -0,0 +1,536 @@
+/*
+ * Macros JSON Stream Implementation
+ */
+
+#include "macros_json_stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// str_ holds any one string field.
+static_assert(
+    MACROS_PAYLOAD_MAX_LEN >= MACROS_LABEL_MAX_LEN &&
+    MACROS_PAYLOAD_MAX_LEN >= MACROS_MQTT_TOPIC_MAX_LEN &&
+    MACROS_PAYLOAD_MAX_LEN >= MACROS_ICON_ID_MAX_LEN &&
+    MACROS_PAYLOAD_MAX_LEN >= MACROS_ICON_DISPLAY_MAX_LEN &&
+    MACROS_PAYLOAD_MAX_LEN >= MACROS_TEMPLATE_ID_MAX_LEN,
+    "payload must be the longest macro string field");
+
+static bool is_ws(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_digit(uint8_t c) {
+    return c >= '0' && c <= '9';
+}
+
+static int hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void MacrosJsonStream::begin(MacroConfig* cfg) {
+    cfg_ = cfg;
+    macros_config_set_defaults(cfg);
+
+    state_ = State::Value;
+    offset_ = 0;
+    depth_ = 0;
+    str_len_ = 0;
+    high_surrogate_ = 0;
+    num_len_ = 0;
+    key_[0] = '\0';
+    screens_seen_ = -1;
+    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        buttons_seen_[s] = -1;
+    }
+    err_[0] = '\0';
+}
+
+bool MacrosJsonStream::feed(const uint8_t* data, size_t len) {
+    if (err_[0] || !cfg_) return false;
+
+    for (size_t i = 0; i < len;) {
+        // A number or literal ends at the first byte that is not part of it;
+        // that byte is then processed again in the next state.
+        bool consumed = true;
+        if (!step(data[i], &consumed)) return false;
+        if (consumed) {
+            i++;
+            offset_++;
+        }
+    }
+    return true;
+}
+
+bool MacrosJsonStream::step(uint8_t c, bool* consumed) {
+    switch (state_) {
+        case State::String:
+            if (c == '"') {
+                if (high_surrogate_) put_utf8(0xFFFD);
+                return end_string();
+            }
+            if (c == '\\') {
+                state_ = State::Escape;
+                return true;
+            }
+            if (c < 0x20) return fail("control character in string");
+            if (high_surrogate_) put_utf8(0xFFFD);
+            put_byte(c);
+            return true;
+
+        case State::Escape: {
+            if (c == 'u') {
+                unicode_ = 0;
+                unicode_digits_ = 0;
+                state_ = State::Unicode;
+                return true;
+            }
+            uint8_t out;
+            switch (c) {
+                case '"': out = '"'; break;
+                case '\\': out = '\\'; break;
+                case '/': out = '/'; break;
+                case 'b': out = '\b'; break;
+                case 'f': out = '\f'; break;
+                case 'n': out = '\n'; break;
+                case 'r': out = '\r'; break;
+                case 't': out = '\t'; break;
+                default: return fail("invalid escape");
+            }
+            if (high_surrogate_) put_utf8(0xFFFD);
+            put_byte(out);
+            state_ = State::String;
+            return true;
+        }
+
+        case State::Unicode: {
+            const int v = hex_value(c);
+            if (v < 0) return fail("invalid \\u escape");
+            unicode_ = (uint16_t)((unicode_ << 4) | v);
+            if (++unicode_digits_ < 4) return true;
+
+            const uint16_t u = unicode_;
+            if (u >= 0xD800 && u < 0xDC00) {
+                if (high_surrogate_) put_utf8(0xFFFD);
+                high_surrogate_ = u;
+            } else if (u >= 0xDC00 && u < 0xE000) {
+                if (high_surrogate_) {
+                    put_utf8(0x10000u + (((uint32_t)high_surrogate_ - 0xD800u) << 10) + (u - 0xDC00u));
+                    high_surrogate_ = 0;
+                } else {
+                    put_utf8(0xFFFD);
+                }
+            } else {
+                if (high_surrogate_) put_utf8(0xFFFD);
+                put_utf8(u);
+            }
+            state_ = State::String;
+            return true;
+        }
+
+        case State::Number:
+            if (is_digit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+                if (num_len_ + 1 >= kNumberMax) return fail("number too long");
+                num_[num_len_++] = (char)c;
+                return true;
+            }
+            *consumed = false;
+            return end_number();
+
+        case State::Literal:
+            if (c >= 'a' && c <= 'z') {
+                if (num_len_ + 1 >= 6) return fail("invalid literal");
+                num_[num_len_++] = (char)c;
+                return true;
+            }
+            *consumed = false;
+            return end_literal();
+
+        case State::Done:
+            if (is_ws(c)) return true;
+            return fail("trailing data after JSON");
+
+        default:
+            break;
+    }
+
+    if (is_ws(c)) return true;
+
+    switch (state_) {
+        case State::Value:
+        case State::ArrFirst:
+            if (state_ == State::ArrFirst && c == ']') return end_container();
+            if (depth_ == 0 && c != '{') return fail("expected an object");
+            if (c == '{') return start_container(false);
+            if (c == '[') return start_container(true);
+            if (c == '"') {
+                string_is_key_ = false;
+                str_len_ = 0;
+                high_surrogate_ = 0;
+                state_ = State::String;
+                return true;
+            }
+            if (c == '-' || is_digit(c)) {
+                num_len_ = 0;
+                num_[num_len_++] = (char)c;
+                state_ = State::Number;
+                return true;
+            }
+            if (c >= 'a' && c <= 'z') {
+                num_len_ = 0;
+                num_[num_len_++] = (char)c;
+                state_ = State::Literal;
+                return true;
+            }
+            return fail("expected a value");
+
+        case State::ObjFirst:
+        case State::ObjKey:
+            if (state_ == State::ObjFirst && c == '}') return end_container();
+            if (c == '"') {
+                string_is_key_ = true;
+                str_len_ = 0;
+                high_surrogate_ = 0;
+                state_ = State::String;
+                return true;
+            }
+            return fail("expected a key");
+
+        case State::Colon:
+            if (c == ':') {
+                state_ = State::Value;
+                return true;
+            }
+            return fail("expected ':'");
+
+        case State::AfterValue: {
+            const Frame& top = stack_[depth_ - 1];
+            if (c == ',') {
+                state_ = top.is_array ? State::Value : State::ObjKey;
+                return true;
+            }
+            if (c == ']' && top.is_array) return end_container();
+            if (c == '}' && !top.is_array) return end_container();
+            return fail(top.is_array ? "expected ',' or ']'" : "expected ',' or '}'");
+        }
+
+        default:
+            return fail("internal parser state");
+    }
+}
+
+bool MacrosJsonStream::start_container(bool is_array) {
+    if (depth_ == 0) {
+        stack_[0] = {Role::Root, false, 0, 0, 0};
+        depth_ = 1;
+        state_ = State::ObjFirst;
+        return true;
+    }
+    if (depth_ >= kMaxDepth) return fail("nesting too deep");
+
+    const Frame& parent = stack_[depth_ - 1];
+    Frame f = {Role::Skip, is_array, parent.screen, parent.button, 0};
+
+    if (parent.is_array) {
+        if (parent.role == Role::Screens) {
+            if (is_array) return fail("screens[] entries must be objects");
+            if (parent.count < MACROS_SCREEN_COUNT) {
+                f.role = Role::Screen;
+                f.screen = (uint8_t)parent.count;
+            }
+        } else if (parent.role == Role::Buttons) {
+            if (is_array) return fail("buttons[] entries must be objects");
+            if (parent.count < MACROS_BUTTONS_PER_SCREEN) {
+                f.role = Role::Button;
+                f.button = (uint8_t)parent.count;
+            }
+        }
+    } else if (parent.role == Role::Root) {
+        if (strcmp(key_, "defaults") == 0) {
+            if (is_array) return fail("expected an object");
+            f.role = Role::Defaults;
+        } else if (strcmp(key_, "screens") == 0) {
+            if (!is_array) return fail("expected an array");
+            f.role = Role::Screens;
+        }
+    } else if (parent.role == Role::Screen && strcmp(key_, "buttons") == 0) {
+        if (!is_array) return fail("expected an array");
+        f.role = Role::Buttons;
+    } else if (parent.role == Role::Button && strcmp(key_, "icon") == 0) {
+        if (is_array) return fail("expected an object");
+        // The icon object replaces the whole icon.
+        MacroButtonIcon& icon = cfg_->buttons[parent.screen][parent.button].icon;
+        icon.type = MacroIconType::None;
+        icon.id[0] = '\0';
+        icon.display[0] = '\0';
+        f.role = Role::Icon;
+    }
+
+    stack_[depth_++] = f;
+    state_ = is_array ? State::ArrFirst : State::ObjFirst;
+    return true;
+}
+
+bool MacrosJsonStream::end_container() {
+    const Frame f = stack_[--depth_];
+    if (f.role == Role::Screens) {
+        screens_seen_ = (int16_t)f.count;
+    } else if (f.role == Role::Buttons) {
+        buttons_seen_[f.screen] = (int16_t)f.count;
+    }
+    return value_done();
+}
+
+bool MacrosJsonStream::value_done() {
+    if (depth_ == 0) {
+        state_ = State::Done;
+        return true;
+    }
+    Frame& top = stack_[depth_ - 1];
+    if (top.count < 0xFFFF) top.count++;
+    state_ = State::AfterValue;
+    return true;
+}
+
+void MacrosJsonStream::put_byte(uint8_t c) {
+    // Longer strings are truncated like strlcpy() into the field would.
+    if (str_len_ + 1 < sizeof(str_)) str_[str_len_++] = (char)c;
+}
+
+void MacrosJsonStream::put_utf8(uint32_t cp) {
+    high_surrogate_ = 0;
+    uint8_t b[4];
+    size_t n;
+    if (cp < 0x80) {
+        b[0] = (uint8_t)cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        b[0] = (uint8_t)(0xC0 | (cp >> 6));
+        b[1] = (uint8_t)(0x80 | (cp & 0x3F));
+        n = 2;
+    } else if (cp < 0x10000) {
+        b[0] = (uint8_t)(0xE0 | (cp >> 12));
+        b[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        b[2] = (uint8_t)(0x80 | (cp & 0x3F));
+        n = 3;
+    } else {
+        b[0] = (uint8_t)(0xF0 | (cp >> 18));
+        b[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+        b[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        b[3] = (uint8_t)(0x80 | (cp & 0x3F));
+        n = 4;
+    }
+    // Never keep half a sequence.
+    if (str_len_ + n >= sizeof(str_)) return;
+    memcpy(str_ + str_len_, b, n);
+    str_len_ += n;
+}
+
+bool MacrosJsonStream::end_string() {
+    str_[str_len_] = '\0';
+    if (string_is_key_) {
+        strlcpy(key_, str_, sizeof(key_));
+        state_ = State::Colon;
+        return true;
+    }
+    return apply_scalar(Scalar::String) && value_done();
+}
+
+bool MacrosJsonStream::end_number() {
+    num_[num_len_] = '\0';
+    char* end = nullptr;
+    number_ = strtod(num_, &end);
+    if (!end || *end != '\0') return fail("invalid number");
+    return apply_scalar(Scalar::Number) && value_done();
+}
+
+bool MacrosJsonStream::end_literal() {
+    num_[num_len_] = '\0';
+    Scalar type;
+    if (strcmp(num_, "true") == 0) {
+        type = Scalar::True;
+    } else if (strcmp(num_, "false") == 0) {
+        type = Scalar::False;
+    } else if (strcmp(num_, "null") == 0) {
+        type = Scalar::Null;
+    } else {
+        return fail("invalid literal");
+    }
+    return apply_scalar(type) && value_done();
+}
+
+bool MacrosJsonStream::text(Scalar type, char* dst, size_t dst_len) {
+    if (type == Scalar::Null) {
+        dst[0] = '\0';
+        return true;
+    }
+    if (type != Scalar::String) return fail("expected a string");
+    strlcpy(dst, str_, dst_len);
+    return true;
+}
+
+bool MacrosJsonStream::color(Scalar type, uint32_t* dst, bool null_unsets) {
+    if (type == Scalar::Null) {
+        if (null_unsets) *dst = MACROS_COLOR_UNSET;
+        return true;
+    }
+    if (type != Scalar::Number) return fail("expected a number");
+    // Colors are RGB-only: 0xRRGGBB
+    const double v = number_ < 0 ? 0 : (number_ > 4294967295.0 ? 4294967295.0 : number_);
+    *dst = (uint32_t)v & 0x00FFFFFFu;
+    return true;
+}
+
+bool MacrosJsonStream::apply_scalar(Scalar type) {
+    const Frame& f = stack_[depth_ - 1];
+    if (f.is_array) {
+        if (f.role == Role::Screens) return fail("screens[] entries must be objects");
+        if (f.role == Role::Buttons) return fail("buttons[] entries must be objects");
+        return true;
+    }
+
+    const char* k = key_;
+    switch (f.role) {
+        case Role::Root:
+            if (strcmp(k, "defaults") == 0) return fail("expected an object");
+            if (strcmp(k, "screens") == 0) return fail("expected an array");
+            return true;
+
+        case Role::Defaults:
+            // null keeps the firmware default.
+            if (strcmp(k, "screen_bg") == 0) return color(type, &cfg_->default_screen_bg, false);
+            if (strcmp(k, "button_bg") == 0) return color(type, &cfg_->default_button_bg, false);
+            if (strcmp(k, "icon_color") == 0) return color(type, &cfg_->default_icon_color, false);
+            if (strcmp(k, "label_color") == 0) return color(type, &cfg_->default_label_color, false);
+            return true;
+
+        case Role::Screen:
+            if (strcmp(k, "template") == 0) return text(type, cfg_->template_id[f.screen], sizeof(cfg_->template_id[f.screen]));
+            if (strcmp(k, "screen_bg") == 0) return color(type, &cfg_->screen_bg[f.screen], true);
+            if (strcmp(k, "buttons") == 0) return fail("expected an array");
+            return true;
+
+        case Role::Button: {
+            MacroButtonConfig& btn = cfg_->buttons[f.screen][f.button];
+            if (strcmp(k, "label") == 0) return text(type, btn.label, sizeof(btn.label));
+            if (strcmp(k, "payload") == 0) return text(type, btn.payload, sizeof(btn.payload));
+            if (strcmp(k, "mqtt_topic") == 0) return text(type, btn.mqtt_topic, sizeof(btn.mqtt_topic));
+            if (strcmp(k, "action") == 0) {
+                if (type != Scalar::String && type != Scalar::Null) return fail("expected a string");
+                btn.action = macros_action_from_string(type == Scalar::String ? str_ : "");
+                return true;
+            }
+            if (strcmp(k, "icon") == 0) {
+                // Not an object: no icon.
+                btn.icon.type = MacroIconType::None;
+                btn.icon.id[0] = '\0';
+                btn.icon.display[0] = '\0';
+                return true;
+            }
+            if (strcmp(k, "button_bg") == 0) return color(type, &btn.button_bg, true);
+            if (strcmp(k, "icon_color") == 0) return color(type, &btn.icon_color, true);
+            if (strcmp(k, "label_color") == 0) return color(type, &btn.label_color, true);
+            return true;
+        }
+
+        case Role::Icon: {
+            MacroButtonIcon& icon = cfg_->buttons[f.screen][f.button].icon;
+            if (strcmp(k, "type") == 0) {
+                if (type != Scalar::String && type != Scalar::Null) return fail("expected a string");
+                icon.type = macros_icon_type_from_string(type == Scalar::String ? str_ : "");
+                return true;
+            }
+            if (strcmp(k, "id") == 0) return text(type, icon.id, sizeof(icon.id));
+            if (strcmp(k, "display") == 0) return text(type, icon.display, sizeof(icon.display));
+            return true;
+        }
+
+        default:
+            return true;
+    }
+}
+
+void MacrosJsonStream::format_path(char* out, size_t out_len) const {
+    size_t len = 0;
+    out[0] = '\0';
+    auto append = [&](const char* fmt, unsigned v, const char* s) {
+        if (len >= out_len) return;
+        const int n = s ? snprintf(out + len, out_len - len, fmt, s) : snprintf(out + len, out_len - len, fmt, v);
+        if (n > 0) len += (size_t)n;
+    };
+
+    for (uint8_t i = 1; i < depth_; i++) {
+        const Frame& parent = stack_[i - 1];
+        const Frame& f = stack_[i];
+        if (parent.is_array) {
+            append("[%u]", parent.count, nullptr);
+            continue;
+        }
+        const char* name = nullptr;
+        switch (f.role) {
+            case Role::Defaults: name = "defaults"; break;
+            case Role::Screens: name = "screens"; break;
+            case Role::Buttons: name = "buttons"; break;
+            case Role::Icon: name = "icon"; break;
+            default: name = "*"; break;
+        }
+        append(len ? ".%s" : "%s", 0, name);
+    }
+
+    if (depth_ > 0) {
+        const Frame& top = stack_[depth_ - 1];
+        if (top.is_array) {
+            append("[%u]", top.count, nullptr);
+        } else if (key_[0] && state_ != State::ObjFirst && state_ != State::ObjKey) {
+            append(len ? ".%s" : "%s", 0, key_);
+        }
+    }
+}
+
+bool MacrosJsonStream::fail(const char* what) {
+    char path[72];
+    format_path(path, sizeof(path));
+    if (path[0]) {
+        snprintf(err_, sizeof(err_), "%s at byte %u (%s)", what, (unsigned)offset_, path);
+    } else {
+        snprintf(err_, sizeof(err_), "%s at byte %u", what, (unsigned)offset_);
+    }
+    return false;
+}
+
+bool MacrosJsonStream::finish() {
+    if (err_[0] || !cfg_) return false;
+    if (state_ != State::Done) return fail("unexpected end of body");
+
+    if (screens_seen_ < 0) {
+        strlcpy(err_, "Missing screens[]", sizeof(err_));
+        return false;
+    }
+    if (screens_seen_ != MACROS_SCREEN_COUNT) {
+        strlcpy(err_, "screens[] has wrong length", sizeof(err_));
+        return false;
+    }
+
+    for (int s = 0; s < MACROS_SCREEN_COUNT; s++) {
+        if (buttons_seen_[s] < 0) {
+            snprintf(err_, sizeof(err_), "screens[%d]: each screen must have buttons[]", s);
+            return false;
+        }
+        if (buttons_seen_[s] != MACROS_BUTTONS_PER_SCREEN) {
+            snprintf(err_, sizeof(err_), "screens[%d]: buttons[] has wrong length", s);
+            return false;
+        }
+        for (int b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+            const char* e = macros_button_normalize(&cfg_->buttons[s][b]);
+            if (e) {
+                snprintf(err_, sizeof(err_), "screens[%d].buttons[%d]: %s", s, b, e);
+                return false;
+            }
+        }
+    }
+    return true;
+}
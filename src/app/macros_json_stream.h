@@ -0,0 +1,114 @@
+/*
+ * Macros JSON Stream
+ *
+ * Incremental (SAX-style) parser for the POST /api/macros body. Chunks are
+ * fed as AsyncWebServer delivers them and fields are written straight into a
+ * staging MacroConfig, so a save needs the target structure plus this
+ * parser (~400 bytes) instead of the whole body and a JSON document.
+ *
+ * Accepted shape (other keys, and unknown values, are skipped):
+ *   {"defaults":{"screen_bg":n,"button_bg":n,"icon_color":n,"label_color":n},
+ *    "screens":[{"template":"...","screen_bg":n,
+ *                "buttons":[{"label":"...","action":"...","payload":"...",
+ *                            "mqtt_topic":"...","icon":{"type","id","display"},
+ *                            "button_bg":n,"icon_color":n,"label_color":n}, ...]}, ...]}
+ *
+ * Strings longer than their MacroConfig field are truncated. Colors may be
+ * null (unset). Errors name the byte offset and the field, e.g.
+ * "expected string at byte 812 (screens[1].buttons[3].label)".
+ *
+ * Template ids are stored as sent; the caller validates them.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macros_config.h"
+
+class MacrosJsonStream {
+public:
+    // Resets cfg to defaults and starts a new document.
+    void begin(MacroConfig* cfg);
+
+    // Parse the next chunk. Returns false on the first error (see error()).
+    bool feed(const uint8_t* data, size_t len);
+
+    // Call after the last chunk: checks the document ended, has every screen
+    // and button, and normalises each button (macros_button_normalize()).
+    bool finish();
+
+    const char* error() const { return err_; }
+
+private:
+    enum class State : uint8_t {
+        Value,        // any value
+        ArrFirst,     // value or ']'
+        ObjFirst,     // key or '}'
+        ObjKey,       // key (after ',')
+        Colon,
+        AfterValue,   // ',' or the closing bracket
+        String,
+        Escape,
+        Unicode,
+        Number,
+        Literal,
+        Done,
+    };
+
+    enum class Role : uint8_t { Root, Defaults, Screens, Screen, Buttons, Button, Icon, Skip };
+
+    enum class Scalar : uint8_t { String, Number, True, False, Null };
+
+    struct Frame {
+        Role role;
+        bool is_array;
+        uint8_t screen;
+        uint8_t button;
+        uint16_t count;   // elements/members completed so far
+    };
+
+    static constexpr size_t kMaxDepth = 12;
+    static constexpr size_t kKeyMax = 24;
+    static constexpr size_t kNumberMax = 32;
+
+    bool step(uint8_t c, bool* consumed);
+    bool start_container(bool is_array);
+    bool end_container();
+    bool value_done();
+    bool apply_scalar(Scalar type);
+    bool end_string();
+    bool end_number();
+    bool end_literal();
+    bool text(Scalar type, char* dst, size_t dst_len);
+    bool color(Scalar type, uint32_t* dst, bool null_unsets);
+    void put_byte(uint8_t c);
+    void put_utf8(uint32_t cp);
+    bool fail(const char* what);
+    void format_path(char* out, size_t out_len) const;
+
+    MacroConfig* cfg_ = nullptr;
+    State state_ = State::Done;
+    size_t offset_ = 0;
+
+    Frame stack_[kMaxDepth];
+    uint8_t depth_ = 0;
+
+    bool string_is_key_ = false;
+    char str_[MACROS_PAYLOAD_MAX_LEN];
+    size_t str_len_ = 0;
+    uint16_t unicode_ = 0;
+    uint8_t unicode_digits_ = 0;
+    uint16_t high_surrogate_ = 0;
+
+    char key_[kKeyMax];
+    char num_[kNumberMax];   // number or literal text
+    size_t num_len_ = 0;
+    double number_ = 0;
+
+    int16_t screens_seen_ = -1;
+    int16_t buttons_seen_[MACROS_SCREEN_COUNT];
+
+    char err_[112];
+};
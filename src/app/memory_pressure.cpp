@@ -0,0 +1,167 @@
+#include "memory_pressure.h"
+
+const char* memory_pressure_tier_name(MemPressureTier tier) {
+    switch (tier) {
+        case MemPressureTier::Caches: return "caches";
+        case MemPressureTier::Screens: return "screens";
+        case MemPressureTier::ImagePool: return "image_pool";
+        case MemPressureTier::Admission: return "admission";
+        case MemPressureTier::Ble: return "ble";
+        case MemPressureTier::None:
+        default: return "none";
+    }
+}
+
+#if MEMORY_PRESSURE_ENABLED
+
+#include "device_telemetry.h"
+#include "log_manager.h"
+#include "loop_scheduler.h"
+#include "web_portal_admission.h"
+
+#if HAS_DISPLAY
+#include "display_manager.h"
+#endif
+
+#if HAS_IMAGE_API
+#include "image_pool.h"
+#endif
+
+#include <freertos/FreeRTOS.h>
+
+namespace {
+
+constexpr uint32_t kPollMs = 1000;
+constexpr MemPressureTier kTop = MemPressureTier::Ble;
+
+volatile MemPressureTier g_tier = MemPressureTier::None;
+portMUX_TYPE g_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+MemPressureStats g_stats = {};
+
+uint32_t g_last_step_ms = 0;
+uint32_t g_healthy_since_ms = 0;
+bool g_healthy = false;
+
+// Below any threshold: shed. Recovery needs 1.5x each of them (hysteresis),
+// so a heap hovering at the line does not flap between tiers.
+bool under_pressure(const DeviceMemorySnapshot& m) {
+    if (m.heap_internal_free_bytes < (size_t)MEMORY_PRESSURE_FREE_BYTES) return true;
+    if (m.heap_largest_free_block_bytes < (size_t)MEMORY_PRESSURE_BLOCK_BYTES) return true;
+    return m.psram_free_bytes > 0 && m.psram_largest_free_block_bytes < (size_t)MEMORY_PRESSURE_PSRAM_BLOCK_BYTES;
+}
+
+bool comfortable(const DeviceMemorySnapshot& m) {
+    if (m.heap_internal_free_bytes < (size_t)MEMORY_PRESSURE_FREE_BYTES * 3 / 2) return false;
+    if (m.heap_largest_free_block_bytes < (size_t)MEMORY_PRESSURE_BLOCK_BYTES * 3 / 2) return false;
+    return m.psram_free_bytes == 0 || m.psram_largest_free_block_bytes >= (size_t)MEMORY_PRESSURE_PSRAM_BLOCK_BYTES * 3 / 2;
+}
+
+void apply(MemPressureTier from, MemPressureTier to) {
+    const bool up = to > from;
+    // Entering a tier when going up, leaving it when coming down.
+    const MemPressureTier step = up ? to : from;
+
+    switch (step) {
+#if HAS_IMAGE_API && !STATIC_ALLOC_MODE
+        // Static allocation keeps the pool: carving it again would allocate.
+        case MemPressureTier::ImagePool:
+            if (up) {
+                image_pool_release_idle();
+            } else if (!image_pool_restore()) {
+                Logger.logMessage("MemPressure", "Image pool could not be restored; uploads stay on the heap");
+            }
+            break;
+#endif
+        case MemPressureTier::Admission:
+            portal_admission_set_shed(up);
+            break;
+        case MemPressureTier::Ble:
+            // The BLE loop reads the tier; wake it so it acts now.
+            loop_scheduler_notify();
+            break;
+        default:
+            break;
+    }
+
+#if HAS_DISPLAY
+    // Caches and screens are LVGL objects: the display task sheds them.
+    display_manager_shed_memory((uint8_t)to);
+#endif
+}
+
+void change(MemPressureTier to, uint32_t now_ms, const DeviceMemorySnapshot& m) {
+    const MemPressureTier from = g_tier;
+    g_tier = to;
+    g_last_step_ms = now_ms;
+
+    portENTER_CRITICAL(&g_stats_mux);
+    g_stats.tier = to;
+    if (to > g_stats.peak) g_stats.peak = to;
+    if (to > from) {
+        g_stats.escalations++;
+        g_stats.entered[(size_t)to]++;
+    } else {
+        g_stats.recoveries++;
+    }
+    g_stats.last_change_ms = now_ms ? now_ms : 1;
+    portEXIT_CRITICAL(&g_stats_mux);
+
+    Logger.logMessagef("MemPressure", "%s %s -> %s (hi=%u hl=%u pl=%u)",
+        to > from ? "Shed" : "Recovered",
+        memory_pressure_tier_name(from), memory_pressure_tier_name(to),
+        (unsigned)m.heap_internal_free_bytes,
+        (unsigned)m.heap_largest_free_block_bytes,
+        (unsigned)m.psram_largest_free_block_bytes);
+
+    apply(from, to);
+}
+
+} // namespace
+
+uint32_t memory_pressure_loop(uint32_t now_ms) {
+    DeviceTelemetrySnapshot snap;
+    device_telemetry_get_snapshot(&snap);
+    const DeviceMemorySnapshot& m = snap.mem;
+    const MemPressureTier tier = g_tier;
+
+    if (under_pressure(m)) {
+        g_healthy = false;
+        if (tier < kTop && (tier == MemPressureTier::None || now_ms - g_last_step_ms >= MEMORY_PRESSURE_STEP_MS)) {
+            change((MemPressureTier)((uint8_t)tier + 1), now_ms, m);
+        }
+    } else if (tier != MemPressureTier::None && comfortable(m)) {
+        if (!g_healthy) {
+            g_healthy = true;
+            g_healthy_since_ms = now_ms;
+        } else if (now_ms - g_healthy_since_ms >= MEMORY_PRESSURE_RECOVER_MS) {
+            change((MemPressureTier)((uint8_t)tier - 1), now_ms, m);
+            // The next tier down waits a full recovery period of its own.
+            g_healthy_since_ms = now_ms;
+        }
+    } else {
+        g_healthy = false;
+    }
+
+#if HAS_IMAGE_API && !STATIC_ALLOC_MODE
+    // A slot that was leased when the tier was entered has been returned since.
+    if (g_tier >= MemPressureTier::ImagePool) image_pool_release_idle();
+#endif
+
+    return kPollMs;
+}
+
+void memory_pressure_poke() {
+    loop_scheduler_notify();
+}
+
+MemPressureTier memory_pressure_tier() {
+    return g_tier;
+}
+
+void memory_pressure_get_stats(MemPressureStats* out) {
+    portENTER_CRITICAL(&g_stats_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_stats_mux);
+}
+
+#endif // MEMORY_PRESSURE_ENABLED
@@ -0,0 +1,67 @@
+#ifndef MEMORY_PRESSURE_H
+#define MEMORY_PRESSURE_H
+
+#include "board_config.h"
+
+// Memory Pressure Shedding (MEMORY_PRESSURE_ENABLED)
+// Watches the shared telemetry snapshot for low internal heap (free bytes or
+// largest block) or a PSRAM heap without a large block, and sheds load in
+// order, one tier every MEMORY_PRESSURE_STEP_MS while the pressure lasts:
+//   1 caches     drop unreferenced icon cache and 2x mask entries; icon
+//                warm-up stops
+//   2 screens    destroy hidden macro pad and LVGL image screens (rebuilt on
+//                their next show) and stop pre-warming neighbours
+//   3 image_pool release the image buffer pool while no slot is leased
+//   4 admission  answer JSON reads and uploads with 503 + Retry-After
+//   5 ble        stop an idle BLE keyboard stack that has no host connected
+// Once the heap is back above 1.5x both thresholds for
+// MEMORY_PRESSURE_RECOVER_MS, tiers are undone one at a time in reverse.
+// The low-memory tripwire triggers a check straight away.
+//
+// Every change is logged and counted; /api/health shows the current tier.
+
+#include <Arduino.h>
+
+enum class MemPressureTier : uint8_t {
+    None = 0,
+    Caches,
+    Screens,
+    ImagePool,
+    Admission,
+    Ble,
+    Count
+};
+
+struct MemPressureStats {
+    MemPressureTier tier;
+    MemPressureTier peak;            // highest tier since boot
+    uint32_t escalations;
+    uint32_t recoveries;
+    uint32_t entered[(size_t)MemPressureTier::Count];   // per tier, since boot
+    uint32_t last_change_ms;         // millis() of the last change (0 = never)
+};
+
+const char* memory_pressure_tier_name(MemPressureTier tier);
+
+#if MEMORY_PRESSURE_ENABLED
+
+// Main loop: escalate or recover. Returns ms until it wants to run again.
+uint32_t memory_pressure_loop(uint32_t now_ms);
+
+// Ask for a check on the next loop pass (any task).
+void memory_pressure_poke();
+
+// Current tier (any task).
+MemPressureTier memory_pressure_tier();
+
+void memory_pressure_get_stats(MemPressureStats* out);
+
+#else
+
+inline void memory_pressure_poke() {}
+inline MemPressureTier memory_pressure_tier() { return MemPressureTier::None; }
+inline void memory_pressure_get_stats(MemPressureStats* out) { *out = MemPressureStats{}; }
+
+#endif
+
+#endif // MEMORY_PRESSURE_H
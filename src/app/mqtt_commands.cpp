@@ -0,0 +1,149 @@
+#include "mqtt_commands.h"
+
+#include "board_config.h"
+
+#if HAS_MQTT && MQTT_COMMANDS_ENABLED
+
+#include "log_manager.h"
+#include "macros_config.h"
+#include "web_portal_state.h"
+
+#if HAS_DISPLAY
+#include "display_manager.h"
+#include "screen_saver_manager.h"
+#endif
+
+#if HAS_IMAGE_API
+#include "image_api.h"
+#endif
+
+#include <ArduinoJson.h>
+#include <stdlib.h>
+
+// Longest accepted payload: a JSON image_url request with a 256-byte URL.
+static constexpr size_t MQTT_COMMAND_PAYLOAD_MAX = 512;
+
+static MqttCommandStats g_stats = {};
+
+// Commands only arrive on the MQTT task, so the counters need no lock;
+// readers may see a slightly stale value.
+
+static bool parse_uint(const char *s, long max, long *out) {
+    char *end = nullptr;
+    const long v = strtol(s, &end, 10);
+    if (end == s || v < 0 || v > max) return false;
+    while (*end == ' ') end++;
+    if (*end != '\0') return false;
+    *out = v;
+    return true;
+}
+
+#if HAS_DISPLAY
+static bool cmd_screen(const char *arg) {
+    bool ok = false;
+    display_manager_show_screen(arg, &ok);
+    // Screen-affecting action counts as explicit activity and should wake.
+    if (ok) screen_saver_manager_notify_activity(true);
+    return ok;
+}
+
+static bool cmd_brightness(const char *arg) {
+    long v = 0;
+    if (!parse_uint(arg, 100, &v)) return false;
+    screen_saver_manager_set_brightness((uint8_t)v);
+    web_portal_note_config_changed();
+    return true;
+}
+
+static bool cmd_macro(const char *arg) {
+    long screen = 0;
+    long button = 0;
+    char buf[16];
+    strlcpy(buf, arg, sizeof(buf));
+    char *slash = strchr(buf, '/');
+    if (!slash) return false;
+    *slash = '\0';
+    if (!parse_uint(buf, MACROS_SCREEN_COUNT, &screen) || !parse_uint(slash + 1, MACROS_BUTTONS_PER_SCREEN, &button)) return false;
+    if (screen < 1 || button < 1) return false;
+    return display_manager_trigger_macro((uint8_t)(screen - 1), (uint8_t)(button - 1));
+}
+#endif
+
+#if HAS_IMAGE_API
+static bool cmd_image_url(const char *arg) {
+    const char *url = arg;
+    unsigned long timeout_ms = 0;
+    bool center = true;
+
+    StaticJsonDocument<512> doc;
+    if (arg[0] == '{') {
+        if (deserializeJson(doc, arg)) return false;
+        url = doc["url"] | "";
+        timeout_ms = (unsigned long)(doc["timeout"] | 0) * 1000UL;
+        center = doc["center"] | true;
+    }
+
+    const char *err = nullptr;
+    if (!image_api_queue_url(url, timeout_ms, center, &err)) {
+        Logger.logMessagef("MQTT", "image_url rejected: %s", err ? err : "?");
+        return false;
+    }
+    return true;
+}
+#endif
+
+void mqtt_commands_handle(const char *base_topic, const char *topic, const uint8_t *payload, size_t len) {
+    if (!base_topic || !topic) return;
+    const size_t base_len = strlen(base_topic);
+    if (strncmp(topic, base_topic, base_len) != 0 || strncmp(topic + base_len, "/cmd/", 5) != 0) return;
+    const char *cmd = topic + base_len + 5;
+
+    // Payloads are not NUL-terminated; commands are short (a URL at most).
+    char arg[MQTT_COMMAND_PAYLOAD_MAX];
+    if (len >= sizeof(arg)) {
+        g_stats.received++;
+        g_stats.rejected++;
+        Logger.logMessagef("MQTT", "Command %s: payload too long", cmd);
+        return;
+    }
+    if (len) memcpy(arg, payload, len);
+    arg[len] = '\0';
+
+    g_stats.received++;
+    bool ok = false;
+    bool known = true;
+
+#if HAS_DISPLAY
+    if (strcmp(cmd, "screen") == 0) {
+        ok = cmd_screen(arg);
+    } else if (strcmp(cmd, "sleep") == 0) {
+        screen_saver_manager_sleep_now();
+        ok = true;
+    } else if (strcmp(cmd, "wake") == 0) {
+        screen_saver_manager_wake();
+        ok = true;
+    } else if (strcmp(cmd, "brightness") == 0) {
+        ok = cmd_brightness(arg);
+    } else if (strcmp(cmd, "macro") == 0) {
+        ok = cmd_macro(arg);
+    } else
+#endif
+#if HAS_IMAGE_API
+    if (strcmp(cmd, "image_url") == 0) {
+        ok = cmd_image_url(arg);
+    } else
+#endif
+    {
+        known = false;
+    }
+
+    if (!ok) g_stats.rejected++;
+    Logger.logMessagef("MQTT", "Command %s%s", cmd, !known ? ": unknown" : (ok ? "" : ": rejected"));
+}
+
+void mqtt_commands_get_stats(MqttCommandStats *out) {
+    if (!out) return;
+    *out = g_stats;
+}
+
+#endif // HAS_MQTT && MQTT_COMMANDS_ENABLED
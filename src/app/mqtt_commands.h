@@ -0,0 +1,31 @@
+#ifndef MQTT_COMMANDS_H
+#define MQTT_COMMANDS_H
+
+#include <Arduino.h>
+#include "board_config.h"
+
+#if HAS_MQTT && MQTT_COMMANDS_ENABLED
+
+// Inbound command topics, subscribed as <base>/cmd/+ (see docs/web-portal.md):
+//   screen      payload: screen id ("macro2", "info")     -> like PUT /api/display/screen
+//   sleep       payload: ignored                          -> like POST /api/display/sleep
+//   wake        payload: ignored                          -> like POST /api/display/wake
+//   brightness  payload: 0-100                            -> like PUT /api/display/brightness
+//   image_url   payload: URL, or {"url","timeout","center"} -> like POST /api/display/image_url
+//   macro       payload: "<screen>/<button>" (1-based)    -> runs that button's action
+// Display work is handed to the LVGL task through the display command queue,
+// so a command costs one MQTT message instead of an HTTP round trip.
+
+struct MqttCommandStats {
+    uint32_t received;
+    uint32_t rejected;   // unknown command, bad payload, or the target was busy
+};
+
+// Handle one message from the command subscription. MQTT client task only.
+void mqtt_commands_handle(const char *base_topic, const char *topic, const uint8_t *payload, size_t len);
+
+void mqtt_commands_get_stats(MqttCommandStats *out);
+
+#endif // HAS_MQTT && MQTT_COMMANDS_ENABLED
+
+#endif // MQTT_COMMANDS_H
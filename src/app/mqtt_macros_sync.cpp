@@ -0,0 +1,379 @@
+#include "mqtt_macros_sync.h"
+
+#include "board_config.h"
+
+#if HAS_MQTT && MQTT_MACROS_SYNC
+
+#include "ducky_script.h"
+#include "fnv1a.h"
+#include "heap_placement.h"
+#include "log_manager.h"
+#include "macro_templates.h"
+#include "mqtt_manager.h"
+
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <stdlib.h>
+
+// The runtime macro screen UI reads from this instance (defined in app.ino).
+extern MacroConfig macro_config;
+
+#define SYNC_NAMESPACE "macrosync"
+#define KEY_STATE      "s"
+
+// Persisted: what this device has applied.
+struct SyncState {
+    uint32_t applied[MACROS_SCREEN_COUNT];   // fleet version of each screen (0 = never synced)
+    uint32_t acked;                          // fleet version fully applied and saved
+};
+
+// Everything below is shared between the MQTT task and a publish (any task),
+// under g_mux. Decoding and saving happen outside it.
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static SyncState g_state = {};
+static uint32_t g_manifest_version = 0;
+static uint32_t g_manifest[MACROS_SCREEN_COUNT] = {};
+static uint8_t g_manifest_screens = 0;                   // listed in the manifest, capped at the compiled count
+static uint32_t g_chunk_hash[MACROS_SCREEN_COUNT] = {};  // last retained chunk body per screen (0 = none seen)
+static bool g_save_macros = false;
+static bool g_save_state = false;
+static bool g_ack_due = false;
+static unsigned long g_save_at_ms = 0;
+static uint32_t g_applied = 0;
+static uint32_t g_skipped = 0;
+static uint32_t g_rejected = 0;
+
+static uint8_t pending_locked() {
+    uint8_t pending = 0;
+    for (uint8_t s = 0; s < g_manifest_screens; s++) {
+        if (g_state.applied[s] != g_manifest[s]) pending++;
+    }
+    return pending;
+}
+
+static void schedule_save_locked(bool macros) {
+    if (macros) g_save_macros = true;
+    g_save_state = true;
+    g_save_at_ms = millis() + MQTT_MACROS_SYNC_SAVE_DELAY_MS;
+}
+
+static void reject(const char *what, unsigned screen) {
+    portENTER_CRITICAL(&g_mux);
+    g_rejected++;
+    g_ack_due = true;
+    portEXIT_CRITICAL(&g_mux);
+    Logger.logMessagef("MacroSync", "Screen %u rejected: %s", screen, what);
+}
+
+void mqtt_macros_sync_begin() {
+    Preferences prefs;
+    if (!prefs.begin(SYNC_NAMESPACE, true)) return;
+    SyncState st = {};
+    if (prefs.getBytesLength(KEY_STATE) == sizeof(st) && prefs.getBytes(KEY_STATE, &st, sizeof(st)) == sizeof(st)) {
+        portENTER_CRITICAL(&g_mux);
+        g_state = st;
+        portEXIT_CRITICAL(&g_mux);
+    }
+    prefs.end();
+}
+
+static bool save_state() {
+    portENTER_CRITICAL(&g_mux);
+    const SyncState st = g_state;
+    portEXIT_CRITICAL(&g_mux);
+
+    Preferences prefs;
+    if (!prefs.begin(SYNC_NAMESPACE, false)) return false;
+    const bool ok = prefs.putBytes(KEY_STATE, &st, sizeof(st)) == sizeof(st);
+    prefs.end();
+    return ok;
+}
+
+static void handle_manifest(const uint8_t *payload, size_t len) {
+    uint32_t version = 0;
+    uint32_t screens[MACROS_SCREEN_COUNT] = {};
+    uint8_t count = 0;
+
+    // An empty retained payload clears the manifest.
+    if (len) {
+        DynamicJsonDocument doc(256 + 16 * MACROS_SCREEN_COUNT);
+        if (deserializeJson(doc, (const char *)payload, len) || !doc["screens"].is<JsonArray>()) {
+            reject("bad manifest", 0);
+            return;
+        }
+        version = doc["version"] | 0u;
+        for (JsonVariant v : doc["screens"].as<JsonArray>()) {
+            if (count >= MACROS_SCREEN_COUNT) break;
+            screens[count++] = v | 0u;
+        }
+    }
+
+    portENTER_CRITICAL(&g_mux);
+    g_manifest_version = version;
+    memcpy(g_manifest, screens, sizeof(g_manifest));
+    g_manifest_screens = count;
+    g_ack_due = true;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+static void handle_screen(const char *index, const uint8_t *payload, size_t len) {
+    char *end = nullptr;
+    const unsigned long s = strtoul(index, &end, 10);
+    // Screens this build does not have, and cleared topics, are not ours to apply.
+    if (end == index || *end != '\0' || s >= MACROS_SCREEN_COUNT || len == 0) return;
+    if (len <= 4 || len > 4 + MQTT_MACROS_SYNC_MAX_CHUNK_BYTES) {
+        reject("bad size", (unsigned)s);
+        return;
+    }
+
+    const uint32_t version = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) | ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+    const uint8_t *body = payload + 4;
+    const size_t body_len = len - 4;
+    const uint32_t hash = fnv1a32(body, body_len) | 1u;  // 0 = none seen
+
+    bool skip = false;
+    portENTER_CRITICAL(&g_mux);
+    g_chunk_hash[s] = hash;
+    skip = g_state.applied[s] == version;
+    if (skip) g_skipped++;
+    portEXIT_CRITICAL(&g_mux);
+    if (skip) return;
+
+    // Stored screens still loading at boot must not land on top of this one.
+    macros_config_ensure_loaded();
+
+    // Decoded into a copy, so a bad chunk leaves the live config alone.
+    MacroConfig *next = (MacroConfig *)heap_place_malloc(HeapClass::Transient, HeapTag::Json, sizeof(MacroConfig));
+    if (!next) {
+        reject("out of memory", (unsigned)s);
+        return;
+    }
+    memcpy(next, &macro_config, sizeof(MacroConfig));
+    if (!macros_config_decode_screen(body, body_len, (uint8_t)s, next)) {
+        heap_tag_free(HeapTag::Json, next);
+        reject("malformed", (unsigned)s);
+        return;
+    }
+
+    if (!macro_templates::is_valid(next->template_id[s])) {
+        strlcpy(next->template_id[s], macro_templates::default_id(), sizeof(next->template_id[s]));
+    }
+    for (uint8_t b = 0; b < MACROS_BUTTONS_PER_SCREEN; b++) {
+        MacroButtonConfig &btn = next->buttons[s][b];
+        char script_err[80];
+        if (macros_button_normalize(&btn) ||
+            (btn.action == MacroButtonAction::SendKeys && !ducky_compile(btn.payload, nullptr, 0, nullptr, script_err, sizeof(script_err)))) {
+            heap_tag_free(HeapTag::Json, next);
+            reject("invalid button", (unsigned)s);
+            return;
+        }
+    }
+
+    // Only this screen and the default colors change; the generation
+    // counters redraw just the buttons that differ.
+    macros_config_mark_diff(&macro_config, next);
+    macro_config.default_screen_bg = next->default_screen_bg;
+    macro_config.default_button_bg = next->default_button_bg;
+    macro_config.default_icon_color = next->default_icon_color;
+    macro_config.default_label_color = next->default_label_color;
+    macro_config.screen_bg[s] = next->screen_bg[s];
+    memcpy(macro_config.template_id[s], next->template_id[s], sizeof(macro_config.template_id[s]));
+    memcpy(macro_config.buttons[s], next->buttons[s], sizeof(macro_config.buttons[s]));
+    heap_tag_free(HeapTag::Json, next);
+    ducky_programs_rebuild(&macro_config);
+
+    portENTER_CRITICAL(&g_mux);
+    g_state.applied[s] = version;
+    g_applied++;
+    schedule_save_locked(true);
+    portEXIT_CRITICAL(&g_mux);
+    Logger.logMessagef("MacroSync", "Screen %u -> v%lu", (unsigned)s, (unsigned long)version);
+}
+
+bool mqtt_macros_sync_handle(const char *topic, const uint8_t *payload, size_t len) {
+    if (!topic) return false;
+    const size_t prefix_len = strlen(MQTT_MACROS_SYNC_TOPIC);
+    if (strncmp(topic, MQTT_MACROS_SYNC_TOPIC, prefix_len) != 0 || topic[prefix_len] != '/') return false;
+    const char *rest = topic + prefix_len + 1;
+
+    if (strcmp(rest, "manifest") == 0) {
+        handle_manifest(payload, len);
+    } else if (strncmp(rest, "screen/", 7) == 0) {
+        handle_screen(rest + 7, payload, len);
+    }
+    return true;
+}
+
+void mqtt_macros_sync_poll(const char *base_topic) {
+    portENTER_CRITICAL(&g_mux);
+    const bool save_due = (g_save_macros || g_save_state) && (long)(millis() - g_save_at_ms) >= 0;
+    const bool save_macros = save_due && g_save_macros;
+    if (save_due) {
+        g_save_macros = false;
+        g_save_state = false;
+    }
+    portEXIT_CRITICAL(&g_mux);
+
+    if (save_due) {
+        // One blob write for a whole burst of screens.
+        if (save_macros && !macros_config_save(&macro_config)) {
+            portENTER_CRITICAL(&g_mux);
+            g_save_macros = true;
+            g_save_state = true;
+            g_save_at_ms = millis() + 10 * MQTT_MACROS_SYNC_SAVE_DELAY_MS;
+            portEXIT_CRITICAL(&g_mux);
+            return;
+        }
+        (void)save_state();
+        portENTER_CRITICAL(&g_mux);
+        g_ack_due = true;
+        portEXIT_CRITICAL(&g_mux);
+    }
+
+    // Ack only what is saved: wait while a save is pending.
+    portENTER_CRITICAL(&g_mux);
+    const bool ack = g_ack_due && !g_save_macros && !g_save_state;
+    const uint8_t pending = pending_locked();
+    const uint32_t target = g_manifest_version;
+    bool acked_changed = false;
+    if (ack) {
+        g_ack_due = false;
+        if (target && pending == 0 && g_state.acked != target) {
+            g_state.acked = target;
+            acked_changed = true;
+        }
+    }
+    const uint32_t acked = g_state.acked;
+    const uint32_t rejected = g_rejected;
+    portEXIT_CRITICAL(&g_mux);
+    if (!ack) return;
+
+    if (acked_changed) {
+        (void)save_state();
+        Logger.logMessagef("MacroSync", "Fleet macros v%lu applied", (unsigned long)acked);
+    }
+
+    char topic[128];
+    char payload[128];
+    snprintf(topic, sizeof(topic), "%s/macros/sync", base_topic);
+    snprintf(payload, sizeof(payload), "{\"version\":%lu,\"target\":%lu,\"pending\":%u,\"rejected\":%lu}",
+             (unsigned long)acked, (unsigned long)target, (unsigned)pending, (unsigned long)rejected);
+    mqtt_manager.publish(topic, payload, true);
+}
+
+bool mqtt_macros_sync_publish(const MacroConfig *cfg, uint32_t *out_version, uint8_t *out_screens, char *err, size_t err_len) {
+    if (!cfg) return false;
+    if (!mqtt_manager.connected()) {
+        snprintf(err, err_len, "MQTT not connected");
+        return false;
+    }
+
+    portENTER_CRITICAL(&g_mux);
+    const uint32_t prev_version = g_manifest_version;
+    uint32_t screens[MACROS_SCREEN_COUNT];
+    memcpy(screens, g_manifest, sizeof(screens));
+    const uint8_t prev_count = g_manifest_screens;
+    uint32_t hashes[MACROS_SCREEN_COUNT];
+    memcpy(hashes, g_chunk_hash, sizeof(hashes));
+    portEXIT_CRITICAL(&g_mux);
+
+    // Each chunk is encoded with room for its version in front.
+    uint8_t *chunks[MACROS_SCREEN_COUNT] = {};
+    size_t chunk_len[MACROS_SCREEN_COUNT] = {};
+    const uint32_t version = prev_version + 1;
+    uint8_t changed = 0;
+    bool ok = true;
+    for (uint8_t s = 0; s < MACROS_SCREEN_COUNT && ok; s++) {
+        uint8_t *body = nullptr;
+        size_t body_len = 0;
+        if (!macros_config_encode_screen(cfg, s, &body, &body_len)) {
+            snprintf(err, err_len, "Out of memory");
+            ok = false;
+            break;
+        }
+        if (body_len > MQTT_MACROS_SYNC_MAX_CHUNK_BYTES) {
+            snprintf(err, err_len, "Screen %u is %u bytes (MQTT_MACROS_SYNC_MAX_CHUNK_BYTES %u)",
+                     (unsigned)s, (unsigned)body_len, (unsigned)MQTT_MACROS_SYNC_MAX_CHUNK_BYTES);
+            free(body);
+            ok = false;
+            break;
+        }
+        const uint32_t hash = fnv1a32(body, body_len) | 1u;  // 0 = none seen
+        if (s < prev_count && hashes[s] == hash) {
+            free(body);
+            continue;
+        }
+
+        uint8_t *chunk = (uint8_t *)malloc(body_len + 4);
+        if (!chunk) {
+            free(body);
+            snprintf(err, err_len, "Out of memory");
+            ok = false;
+            break;
+        }
+        chunk[0] = (uint8_t)version;
+        chunk[1] = (uint8_t)(version >> 8);
+        chunk[2] = (uint8_t)(version >> 16);
+        chunk[3] = (uint8_t)(version >> 24);
+        memcpy(chunk + 4, body, body_len);
+        free(body);
+        chunks[s] = chunk;
+        chunk_len[s] = body_len + 4;
+        hashes[s] = hash;
+        screens[s] = version;
+        changed++;
+    }
+
+    if (ok && changed) {
+        char topic[sizeof(MQTT_MACROS_SYNC_TOPIC) + 16];
+        for (uint8_t s = 0; s < MACROS_SCREEN_COUNT && ok; s++) {
+            if (!chunks[s]) continue;
+            snprintf(topic, sizeof(topic), "%s/screen/%u", MQTT_MACROS_SYNC_TOPIC, (unsigned)s);
+            ok = mqtt_manager.publish(topic, chunks[s], chunk_len[s], true);
+        }
+
+        // The manifest goes last, so a device never waits on a screen that is not out yet.
+        DynamicJsonDocument doc(256 + 16 * MACROS_SCREEN_COUNT);
+        doc["version"] = version;
+        JsonArray arr = doc.createNestedArray("screens");
+        for (uint8_t s = 0; s < MACROS_SCREEN_COUNT; s++) arr.add(screens[s]);
+        char manifest[256 + 12 * MACROS_SCREEN_COUNT];
+        serializeJson(doc, manifest, sizeof(manifest));
+        snprintf(topic, sizeof(topic), "%s/manifest", MQTT_MACROS_SYNC_TOPIC);
+        if (ok) ok = mqtt_manager.publish(topic, manifest, true);
+        if (!ok) snprintf(err, err_len, "MQTT publish queue full");
+    }
+    for (uint8_t s = 0; s < MACROS_SCREEN_COUNT; s++) free(chunks[s]);
+    if (!ok) return false;
+
+    if (changed) {
+        // This device holds the published config: it is at the new version already.
+        portENTER_CRITICAL(&g_mux);
+        g_manifest_version = version;
+        memcpy(g_manifest, screens, sizeof(g_manifest));
+        g_manifest_screens = MACROS_SCREEN_COUNT;
+        memcpy(g_chunk_hash, hashes, sizeof(g_chunk_hash));
+        memcpy(g_state.applied, screens, sizeof(g_state.applied));
+        schedule_save_locked(false);
+        portEXIT_CRITICAL(&g_mux);
+        Logger.logMessagef("MacroSync", "Published v%lu (%u screens)", (unsigned long)version, (unsigned)changed);
+    }
+
+    if (out_version) *out_version = changed ? version : prev_version;
+    if (out_screens) *out_screens = changed;
+    return true;
+}
+
+void mqtt_macros_sync_get_stats(MqttMacrosSyncStats *out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_mux);
+    out->manifest_version = g_manifest_version;
+    out->acked_version = g_state.acked;
+    out->pending = pending_locked();
+    out->applied = g_applied;
+    out->skipped = g_skipped;
+    out->rejected = g_rejected;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+#endif // HAS_MQTT && MQTT_MACROS_SYNC
@@ -0,0 +1,50 @@
+#ifndef MQTT_MACROS_SYNC_H
+#define MQTT_MACROS_SYNC_H
+
+#include <Arduino.h>
+#include "board_config.h"
+
+#if HAS_MQTT && MQTT_MACROS_SYNC
+
+#include "macros_config.h"
+
+// Fleet-wide macro config over retained topics (see docs/web-portal.md):
+//   <MQTT_MACROS_SYNC_TOPIC>/manifest    {"version":V,"screens":[v0,v1,...]}
+//   <MQTT_MACROS_SYNC_TOPIC>/screen/<n>  u32 version (little-endian), then
+//                                        screen n as macros_config_encode_screen() writes it
+// vn is the fleet version in which screen n last changed. A device decodes a
+// screen only when its version differs from the one it applied last, and the
+// generation counters then redraw only the buttons that differ. Once every
+// screen matches the manifest the config is saved and V is acked, retained,
+// on <base>/macros/sync.
+
+struct MqttMacrosSyncStats {
+    uint32_t manifest_version;   // 0 = no manifest seen
+    uint32_t acked_version;      // fleet version fully applied and saved here
+    uint8_t pending;             // screens not at their manifest version
+    uint32_t applied;            // screen chunks applied since boot
+    uint32_t skipped;            // ... already at that version
+    uint32_t rejected;           // malformed, too large, bad script, or out of memory
+};
+
+// Load the applied versions from NVS. Before the MQTT client starts.
+void mqtt_macros_sync_begin();
+
+// Handle a message under MQTT_MACROS_SYNC_TOPIC; false for other topics.
+// MQTT client task only.
+bool mqtt_macros_sync_handle(const char *topic, const uint8_t *payload, size_t len);
+
+// Save applied screens once they stop arriving, then ack. MQTT client task only.
+void mqtt_macros_sync_poll(const char *base_topic);
+
+// Publish cfg as the next fleet version: the screens that differ from the
+// retained ones, then the manifest. *out_version / *out_screens (optional)
+// get the version and the number of screens sent; nothing is sent when no
+// screen changed. Any task; the messages go through the publish queue.
+bool mqtt_macros_sync_publish(const MacroConfig *cfg, uint32_t *out_version, uint8_t *out_screens, char *err, size_t err_len);
+
+void mqtt_macros_sync_get_stats(MqttMacrosSyncStats *out);
+
+#endif // HAS_MQTT && MQTT_MACROS_SYNC
+
+#endif // MQTT_MACROS_SYNC_H
@@ -6,7 +6,32 @@
 
 #include "ha_discovery.h"
 #include "device_telemetry.h"
+#include "fnv1a.h"
 #include "log_manager.h"
+#include "mqtt_commands.h"
+#include "mqtt_macros_sync.h"
+#include "ota_quiet.h"
+#include "power_manager.h"
+#include "trace.h"
+
+#include <esp_random.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Queued publish: topic and payload copied into one allocation.
+struct MqttManager::OutMsg {
+    uint32_t topic_hash;    // FNV-1a, to find a queued value for the same topic cheaply
+    uint32_t queued_ms;
+    bool retained;
+    uint16_t topic_len;
+    uint16_t payload_len;
+    char data[1]; // topic, NUL, payload
+};
+
+// Upper bound of the random delay before discovery is published.
+static constexpr uint32_t kDiscoveryJitterMs = 5000;
+
+static portMUX_TYPE g_queue_mux = portMUX_INITIALIZER_UNLOCKED;
 
 MqttManager::MqttManager() : _client(_net) {}
 
@@ -29,14 +54,61 @@ void MqttManager::begin(const DeviceConfig *config, const char *friendly_name, c
     snprintf(_availability_topic, sizeof(_availability_topic), "%s/availability", _base_topic);
     snprintf(_health_state_topic, sizeof(_health_state_topic), "%s/health/state", _base_topic);
 
+#if MQTT_MACROS_SYNC
+    // A fleet macro screen arrives (and is published) as one message.
+    _client.setBufferSize(max(MQTT_MAX_PACKET_SIZE, MQTT_MACROS_SYNC_MAX_CHUNK_BYTES + 4 + 128));
+    mqtt_macros_sync_begin();
+#else
     _client.setBufferSize(MQTT_MAX_PACKET_SIZE);
+#endif
+    // Runs on the client task from inside _client.loop().
+    _client.setCallback([this](char *topic, uint8_t *payload, unsigned int length) {
+        onMessage(topic, payload, length);
+    });
 
     _discovery_published_this_boot = false;
+    _discovery_pending = false;
     _logged_snapshot_connect_attempt = false;
     _logged_snapshot_connected = false;
     _logged_snapshot_first_publish = false;
     _last_reconnect_attempt_ms = 0;
     _last_health_publish_ms = 0;
+    _state = ConnState::Idle;
+    _backoff_ms = 0;
+    _next_attempt_ms = 0;
+
+    if (enabled()) {
+        startTask();
+    }
+}
+
+void MqttManager::startTask() {
+#if MQTT_TASK_ENABLED
+    if (_task) return;
+
+    #if CONFIG_FREERTOS_UNICORE
+    xTaskCreate(taskFn, "MQTT", MQTT_TASK_STACK_BYTES, this, MQTT_TASK_PRIORITY, &_task);
+    #else
+    xTaskCreatePinnedToCore(taskFn, "MQTT", MQTT_TASK_STACK_BYTES, this, MQTT_TASK_PRIORITY, &_task, MQTT_TASK_CORE);
+    #endif
+
+    if (!_task) {
+        Logger.logMessage("MQTT", "ERROR: MQTT task creation failed; using main loop");
+        return;
+    }
+    Logger.logMessagef("MQTT", "MQTT task started (prio %d, queue %d)", (int)MQTT_TASK_PRIORITY, (int)MQTT_PUBLISH_QUEUE_DEPTH);
+#endif
+}
+
+void MqttManager::taskFn(void *arg) {
+    MqttManager *self = (MqttManager *)arg;
+    for (;;) {
+        self->step();
+        // Publishes wake the task early; otherwise poll often enough for
+        // keepalive and inbound traffic, and idle slower while disconnected.
+        const uint32_t wait_ms = (self->_state == ConnState::Connected) ? 50 : 250;
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+    }
 }
 
 bool MqttManager::connectEnabled() const {
@@ -63,12 +135,17 @@ bool MqttManager::publishEnabled() const {
 }
 
 bool MqttManager::connected() {
-    return _client.connected();
+    // The client itself is only touched by its owner task.
+    return _state == ConnState::Connected;
 }
 
-bool MqttManager::publish(const char *topic, const char *payload, bool retained) {
-    if (!enabled() || !_client.connected()) return false;
-    if (!topic || !payload) return false;
+bool MqttManager::inClientContext() const {
+    return _client_owner && xTaskGetCurrentTaskHandle() == _client_owner;
+}
+
+bool MqttManager::publishDirect(const char *topic, const uint8_t *payload, size_t len, bool retained) {
+    power_manager_hold(PowerActivity::Mqtt, POWER_ACTIVITY_HOLD_MS);
+    if (!_client.connected()) return false;
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
     if (!_logged_snapshot_first_publish) {
@@ -77,7 +154,171 @@ bool MqttManager::publish(const char *topic, const char *payload, bool retained)
     }
 #endif
 
-    return _client.publish(topic, payload, retained);
+    return _client.publish(topic, payload, (unsigned)len, retained);
+}
+
+bool MqttManager::enqueue(const char *topic, const uint8_t *payload, size_t len, bool retained) {
+    const size_t topic_len = strlen(topic);
+    if (topic_len > 0xFFFF || len > 0xFFFF) return false;
+
+    OutMsg *msg = (OutMsg *)malloc(sizeof(OutMsg) + topic_len + 1 + len);
+    if (!msg) {
+        portENTER_CRITICAL(&g_queue_mux);
+        _queue_stats.dropped_full++;
+        portEXIT_CRITICAL(&g_queue_mux);
+        return false;
+    }
+    msg->topic_hash = fnv1a32_str(topic);
+    msg->queued_ms = millis();
+    msg->retained = retained;
+    msg->topic_len = (uint16_t)topic_len;
+    msg->payload_len = (uint16_t)len;
+    memcpy(msg->data, topic, topic_len + 1);
+    if (len) memcpy(msg->data + topic_len + 1, payload, len);
+
+    // Retained messages are state: only the newest value per topic matters, so
+    // it replaces a queued one in place. Everything else (button events) is FIFO.
+    OutMsg *replaced = nullptr;
+    bool queued = false;
+    portENTER_CRITICAL(&g_queue_mux);
+    if (retained) {
+        for (uint8_t i = 0; i < _queue_count; i++) {
+            const uint8_t slot = (uint8_t)((_queue_head + i) % MQTT_PUBLISH_QUEUE_DEPTH);
+            OutMsg *q = _queue[slot];
+            if (q->retained && q->topic_hash == msg->topic_hash && strcmp(q->data, msg->data) == 0) {
+                replaced = q;
+                _queue[slot] = msg;
+                _queue_stats.coalesced++;
+                queued = true;
+                break;
+            }
+        }
+    }
+    if (!queued && _queue_count < MQTT_PUBLISH_QUEUE_DEPTH) {
+        _queue[(_queue_head + _queue_count) % MQTT_PUBLISH_QUEUE_DEPTH] = msg;
+        _queue_count++;
+        _queue_stats.queued++;
+        queued = true;
+    } else if (!queued) {
+        _queue_stats.dropped_full++;
+    }
+    portEXIT_CRITICAL(&g_queue_mux);
+
+    free(replaced);
+    if (!queued) {
+        Logger.logMessagef("MQTT", "Publish queue full; dropped topic=%s", topic);
+        free(msg);
+        return false;
+    }
+    if (_task) xTaskNotifyGive(_task);
+    return true;
+}
+
+void MqttManager::drainQueue() {
+    for (;;) {
+        OutMsg *msg = nullptr;
+        portENTER_CRITICAL(&g_queue_mux);
+        if (_queue_count > 0) {
+            msg = _queue[_queue_head];
+            _queue[_queue_head] = nullptr;
+            _queue_head = (uint8_t)((_queue_head + 1) % MQTT_PUBLISH_QUEUE_DEPTH);
+            _queue_count--;
+        }
+        portEXIT_CRITICAL(&g_queue_mux);
+        if (!msg) return;
+
+        const char *topic = msg->data;
+        const uint8_t *payload = (const uint8_t *)(msg->data + msg->topic_len + 1);
+        if (publishDirect(topic, payload, msg->payload_len, msg->retained)) {
+            portENTER_CRITICAL(&g_queue_mux);
+            _queue_stats.sent++;
+            portEXIT_CRITICAL(&g_queue_mux);
+            free(msg);
+            continue;
+        }
+
+        if (!_client.connected()) {
+            // Lost the broker mid-drain: put it back in front and retry after
+            // reconnecting. The slot it came from is still free unless a
+            // publish raced in, in which case the message is dropped.
+            bool requeued = false;
+            portENTER_CRITICAL(&g_queue_mux);
+            if (_queue_count < MQTT_PUBLISH_QUEUE_DEPTH) {
+                _queue_head = (uint8_t)((_queue_head + MQTT_PUBLISH_QUEUE_DEPTH - 1) % MQTT_PUBLISH_QUEUE_DEPTH);
+                _queue[_queue_head] = msg;
+                _queue_count++;
+                requeued = true;
+            } else {
+                _queue_stats.dropped_failed++;
+            }
+            portEXIT_CRITICAL(&g_queue_mux);
+            if (!requeued) free(msg);
+            return;
+        }
+
+        Logger.logMessagef("MQTT", "Publish failed: topic=%s", topic);
+        portENTER_CRITICAL(&g_queue_mux);
+        _queue_stats.dropped_failed++;
+        portEXIT_CRITICAL(&g_queue_mux);
+        free(msg);
+    }
+}
+
+void MqttManager::expireQueuedEvents() {
+#if MQTT_PUBLISH_EVENT_MAX_AGE_MS > 0
+    // A button press buffered through a long outage would fire long after the
+    // fact, so events older than MQTT_PUBLISH_EVENT_MAX_AGE_MS are dropped.
+    // Retained state never expires: its newest value is still the truth.
+    OutMsg *expired[MQTT_PUBLISH_QUEUE_DEPTH];
+    uint8_t n_expired = 0;
+    const uint32_t now = millis();
+
+    portENTER_CRITICAL(&g_queue_mux);
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < _queue_count; i++) {
+        OutMsg *q = _queue[(_queue_head + i) % MQTT_PUBLISH_QUEUE_DEPTH];
+        if (!q->retained && (uint32_t)(now - q->queued_ms) > MQTT_PUBLISH_EVENT_MAX_AGE_MS) {
+            expired[n_expired++] = q;
+            continue;
+        }
+        _queue[(_queue_head + kept) % MQTT_PUBLISH_QUEUE_DEPTH] = q;
+        kept++;
+    }
+    for (uint8_t i = kept; i < _queue_count; i++) {
+        _queue[(_queue_head + i) % MQTT_PUBLISH_QUEUE_DEPTH] = nullptr;
+    }
+    _queue_count = kept;
+    _queue_stats.dropped_expired += n_expired;
+    portEXIT_CRITICAL(&g_queue_mux);
+
+    for (uint8_t i = 0; i < n_expired; i++) {
+        free(expired[i]);
+    }
+#endif
+}
+
+void MqttManager::getQueueStats(MqttQueueStats *out) const {
+    if (!out) return;
+    portENTER_CRITICAL(&g_queue_mux);
+    *out = _queue_stats;
+    out->depth = _queue_count;
+    portEXIT_CRITICAL(&g_queue_mux);
+}
+
+bool MqttManager::publish(const char *topic, const char *payload, bool retained) {
+    if (!payload) return false;
+    return publish(topic, (const uint8_t *)payload, strlen(payload), retained);
+}
+
+bool MqttManager::publish(const char *topic, const uint8_t *payload, size_t len, bool retained) {
+    if (!enabled()) return false;
+    if (!topic || (!payload && len)) return false;
+
+    if (inClientContext() && connected()) {
+        return publishDirect(topic, payload, len, retained);
+    }
+    // Queued even while disconnected; drained once the broker is back.
+    return enqueue(topic, payload, len, retained);
 }
 
 bool MqttManager::publishJson(const char *topic, JsonDocument &doc, bool retained) {
@@ -91,15 +332,75 @@ bool MqttManager::publishJson(const char *topic, JsonDocument &doc, bool retaine
         return false;
     }
 
-    if (!enabled() || !_client.connected()) return false;
+    if (!enabled()) return false;
 
-#if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
-    if (!_logged_snapshot_first_publish) {
-        device_telemetry_log_memory_snapshot("mqtt_first_publish");
-        _logged_snapshot_first_publish = true;
+    if (inClientContext() && connected()) {
+        return publishDirect(topic, (const uint8_t*)payload, n, retained);
+    }
+    return enqueue(topic, (const uint8_t*)payload, n, retained);
+}
+
+#if MQTT_DISCOVERY_STREAMED
+namespace {
+// Batches ArduinoJson's per-character writes into socket-sized chunks.
+class ChunkedClientPrint : public Print {
+public:
+    explicit ChunkedClientPrint(PubSubClient &client) : _client(client) {}
+    ~ChunkedClientPrint() override { flush(); }
+
+    size_t write(uint8_t c) override {
+        if (_len == sizeof(_buf)) flush();
+        _buf[_len++] = c;
+        return 1;
+    }
+
+    size_t write(const uint8_t *data, size_t len) override {
+        for (size_t i = 0; i < len; i++) write(data[i]);
+        return len;
+    }
+
+    void flush() override {
+        if (_len == 0) return;
+        if (_client.write(_buf, _len) != _len) _failed = true;
+        _len = 0;
+    }
+
+    bool failed() const { return _failed; }
+
+private:
+    PubSubClient &_client;
+    uint8_t _buf[128];
+    size_t _len = 0;
+    bool _failed = false;
+};
+} // namespace
+#endif
+
+bool MqttManager::publishJsonStreamed(const char *topic, JsonDocument &doc, bool retained) {
+#if MQTT_DISCOVERY_STREAMED
+    if (!topic) return false;
+    if (!enabled()) return false;
+
+    if (inClientContext() && connected()) {
+        const size_t n = measureJson(doc);
+        if (!_client.beginPublish(topic, (unsigned)n, retained)) {
+            Logger.logMessagef("MQTT", "Publish failed: topic=%s", topic);
+            return false;
+        }
+        bool ok;
+        {
+            ChunkedClientPrint out(_client);
+            const size_t written = serializeJson(doc, out);
+            out.flush();
+            ok = written == n && !out.failed();
+        }
+        // endPublish() only reports whether the client is still connected.
+        ok = _client.endPublish() && ok;
+        if (!ok) Logger.logMessagef("MQTT", "Publish failed: topic=%s", topic);
+        return ok;
     }
 #endif
-    return _client.publish(topic, (const uint8_t*)payload, (unsigned)n, retained);
+    return publishJson(topic, doc, retained);
 }
 
 bool MqttManager::publishImmediate(const char *topic, const char *payload, bool retained) {
@@ -111,86 +412,234 @@ void MqttManager::publishAvailability(bool online) {
     _client.publish(_availability_topic, online ? "online" : "offline", true);
 }
 
-void MqttManager::publishDiscoveryOncePerBoot() {
-    if (_discovery_published_this_boot) return;
+void MqttManager::scheduleDiscovery(bool force) {
+    if (!_discovery_pending) _discovery_force = false;
+    _discovery_force = _discovery_force || force;
+    _discovery_pending = true;
+    _discovery_at_ms = millis() + (esp_random() % kDiscoveryJitterMs);
+}
 
+void MqttManager::publishDiscovery(bool force) {
     Logger.logMessage("MQTT", "Publishing HA discovery");
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
     device_telemetry_log_memory_snapshot("mqtt_discovery_pre");
 #endif
-    ha_discovery_publish_health(*this);
+    // On failure, the next connection tries again.
+    if (ha_discovery_publish_health(*this, force)) {
+        _discovery_published_this_boot = true;
+    }
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
     device_telemetry_log_memory_snapshot("mqtt_discovery_post");
 #endif
-    _discovery_published_this_boot = true;
 }
 
-void MqttManager::publishHealthNow() {
-    if (!_client.connected()) return;
-
-    StaticJsonDocument<768> doc;
-    device_telemetry_fill_mqtt(doc);
-
-    if (doc.overflowed()) {
-        Logger.logMessage("MQTT", "ERROR: health JSON overflow (StaticJsonDocument too small)");
+void MqttManager::onMessage(char *topic, uint8_t *payload, unsigned int length) {
+    power_manager_hold(PowerActivity::Mqtt, POWER_ACTIVITY_HOLD_MS);
+#if MQTT_DISCOVERY_SKIP_UNCHANGED
+    if (strcmp(topic, HA_DISCOVERY_STATUS_TOPIC) == 0) {
+        // A retained birth message is delivered right after subscribing and
+        // says nothing new; only a live one means HA (or its broker) restarted.
+        if (millis() - _connected_ms < 2000) return;
+        if (length == 6 && memcmp(payload, "online", 6) == 0) {
+            scheduleDiscovery(true);
+            Logger.logMessage("MQTT", "Home Assistant online; discovery resend scheduled");
+        }
         return;
     }
+#endif
+#if MQTT_MACROS_SYNC
+    if (mqtt_macros_sync_handle(topic, payload, length)) return;
+#endif
+#if MQTT_COMMANDS_ENABLED
+    mqtt_commands_handle(_base_topic, topic, payload, length);
+#else
+    (void)topic;
+    (void)payload;
+    (void)length;
+#endif
+}
 
-    char payload[MQTT_MAX_PACKET_SIZE];
-    size_t n = serializeJson(doc, payload, sizeof(payload));
-    if (n == 0 || n >= sizeof(payload)) {
-        Logger.logMessagef("MQTT", "ERROR: health JSON payload too large for MQTT_MAX_PACKET_SIZE (%u)", (unsigned)sizeof(payload));
-        return;
+void MqttManager::publishHealthNow() {
+    if (!_client.connected()) return;
+    if (publishHealth(true)) {
+        _health_intervals = 0;
     }
-    _client.publish(_health_state_topic, (const uint8_t*)payload, (unsigned)n, true);
 }
 
 void MqttManager::publishHealthIfDue() {
     if (!_client.connected()) return;
     if (!publishEnabled()) return;
+    // Held while a firmware update writes flash; resumes on the next interval.
+    if (ota_quiet_active()) return;
 
     unsigned long now = millis();
     unsigned long interval_ms = (unsigned long)_config->mqtt_interval_seconds * 1000UL;
 
     if (_last_health_publish_ms == 0 || (now - _last_health_publish_ms) >= interval_ms) {
-        StaticJsonDocument<768> doc;
-        device_telemetry_fill_mqtt(doc);
-
-        if (doc.overflowed()) {
-            Logger.logMessage("MQTT", "ERROR: health JSON overflow (StaticJsonDocument too small)");
-            return;
+        const bool full = (uint16_t)(_health_intervals + 1) >= MQTT_HEALTH_FULL_EVERY_N;
+        if (publishHealth(full)) {
+            _last_health_publish_ms = now;
+            _health_intervals = full ? 0 : (uint16_t)(_health_intervals + 1);
         }
+    }
+}
+
+bool MqttManager::publishHealth(bool full) {
+#if !MQTT_HEALTH_SPLIT_TOPICS
+    // Batched payload only: stream the fields straight into the packet buffer.
+    (void)full;
+    char payload[MQTT_MAX_PACKET_SIZE];
+    JsonFixedBufferPrint out(payload, sizeof(payload));
+    JsonStreamWriter writer(out);
+    JsonStreamObject root = writer.root();
+    device_telemetry_write_mqtt(root);
+    writer.finish();
+    if (out.overflowed()) {
+        Logger.logMessagef("MQTT", "ERROR: health JSON payload too large for MQTT_MAX_PACKET_SIZE (%u)", (unsigned)sizeof(payload));
+        return false;
+    }
+    return _client.publish(_health_state_topic, (const uint8_t*)payload, (unsigned)out.length(), true);
+#else
+    // Split topics walk the fields after filling, so they need the document.
+    StaticJsonDocument<1024> doc;
+    device_telemetry_fill_mqtt(doc);
+
+    if (doc.overflowed()) {
+        Logger.logMessage("MQTT", "ERROR: health JSON overflow (StaticJsonDocument too small)");
+        return false;
+    }
+
+    bool ok = true;
 
+    // The batched document only goes out with full snapshots; HA entities
+    // read the per-field topics.
+    if (full) {
         char payload[MQTT_MAX_PACKET_SIZE];
         size_t n = serializeJson(doc, payload, sizeof(payload));
         if (n == 0 || n >= sizeof(payload)) {
             Logger.logMessagef("MQTT", "ERROR: health JSON payload too large for MQTT_MAX_PACKET_SIZE (%u)", (unsigned)sizeof(payload));
-            return;
+            return false;
         }
+        ok = _client.publish(_health_state_topic, (const uint8_t*)payload, (unsigned)n, true);
+    }
 
-        bool ok = _client.publish(_health_state_topic, (const uint8_t*)payload, (unsigned)n, true);
+    ok = publishHealthFields(doc, full) && ok;
+    return ok;
+#endif
+}
 
-        if (ok) {
-            _last_health_publish_ms = now;
-        }
+#if MQTT_HEALTH_SPLIT_TOPICS
+// Noisy fields get an absolute floor on top of MQTT_HEALTH_DELTA_PCT, so e.g.
+// cpu_usage bouncing between 1% and 2% is not a "50% change".
+static double health_delta_floor(const char *key) {
+    static const struct {
+        const char *key;
+        double floor;
+    } kFloors[] = {
+        {"cpu_usage", 2},
+        {"cpu_temperature", 1},
+        {"wifi_rssi", 3},
+        {"heap_fragmentation", 2},
+        {"psram_fragmentation", 2},
+    };
+    for (const auto &f : kFloors) {
+        if (strcmp(f.key, key) == 0) return f.floor;
     }
+    return 0;
 }
 
-void MqttManager::ensureConnected() {
-    if (!enabled()) return;
-    if (WiFi.status() != WL_CONNECTED) return;
+static void format_health_value(JsonVariantConst v, char *out, size_t out_len) {
+    // Plain payloads: HA sensors read them without a value_template.
+    if (v.isNull()) {
+        strlcpy(out, "None", out_len);
+    } else if (v.is<const char *>()) {
+        strlcpy(out, v.as<const char *>(), out_len);
+    } else {
+        serializeJson(v, out, out_len);
+    }
+}
+#endif
 
-    if (_client.connected()) return;
+bool MqttManager::publishHealthFields(JsonDocument &doc, bool full) {
+#if MQTT_HEALTH_SPLIT_TOPICS
+    const bool delta = MQTT_HEALTH_DELTA_ENABLED && !full;
+    bool ok = true;
+
+    char topic[sizeof(_base_topic) + 48];
+    char value[48];
+
+    for (JsonPair kv : doc.as<JsonObject>()) {
+        const char *key = kv.key().c_str();
+        JsonVariantConst v = kv.value();
+        const uint32_t key_hash = fnv1a32_str(key) | 1u;
+
+        HealthField *slot = nullptr;
+        for (uint8_t i = 0; i < kHealthFieldSlots; i++) {
+            if (_health_fields[i].key_hash == key_hash) {
+                slot = &_health_fields[i];
+                break;
+            }
+            if (_health_fields[i].key_hash == 0) {
+                // Slots fill in order and are never freed, so the key is new.
+                slot = &_health_fields[i];
+                slot->key_hash = key_hash;
+                slot->numeric = false;
+                slot->text_hash = 0;
+                break;
+            }
+        }
 
-    unsigned long now = millis();
-    if (_last_reconnect_attempt_ms > 0 && (now - _last_reconnect_attempt_ms) < 5000) {
-        return;
+        format_health_value(v, value, sizeof(value));
+        const bool numeric = !v.isNull() && !v.is<const char *>() && v.is<double>();
+        const double number = numeric ? v.as<double>() : 0;
+        const uint32_t text_hash = numeric ? 0 : fnv1a32_str(value);
+
+        if (delta && slot) {
+            bool changed;
+            if (numeric && slot->numeric) {
+                double threshold = fabs(slot->number) * (double)MQTT_HEALTH_DELTA_PCT / 100.0;
+                const double floor = health_delta_floor(key);
+                if (threshold < floor) threshold = floor;
+                changed = fabs(number - slot->number) > threshold;
+            } else {
+                changed = numeric != slot->numeric || text_hash != slot->text_hash;
+            }
+            if (!changed) {
+                _health_fields_skipped++;
+                continue;
+            }
+        }
+
+        snprintf(topic, sizeof(topic), "%s/health/%s", _base_topic, key);
+        if (!_client.publish(topic, value, true)) {
+            // Keep the old value so the next interval retries it.
+            ok = false;
+            continue;
+        }
+        _health_fields_sent++;
+        if (slot) {
+            slot->numeric = numeric;
+            slot->number = number;
+            slot->text_hash = text_hash;
+        }
     }
-    _last_reconnect_attempt_ms = now;
+    return ok;
+#else
+    (void)doc;
+    (void)full;
+    return true;
+#endif
+}
+
+bool MqttManager::attemptConnect() {
+    _state = ConnState::Connecting;
+    _last_reconnect_attempt_ms = millis();
 
     _client.setServer(_config->mqtt_host, resolvedPort());
+    // Bound the CONNACK wait as well as the TCP connect below.
+    _client.setSocketTimeout((uint16_t)((MQTT_CONNECT_TIMEOUT_MS + 999) / 1000));
 
     // Client ID: sanitized name
     char client_id[96];
@@ -208,6 +657,13 @@ void MqttManager::ensureConnected() {
     }
 #endif
 
+    // Open the socket ourselves with a timeout; PubSubClient::connect() reuses
+    // an already-connected client and only sends CONNECT.
+    if (!_net.connect(_config->mqtt_host, resolvedPort(), MQTT_CONNECT_TIMEOUT_MS)) {
+        Logger.logMessagef("MQTT", "Connect failed (no TCP connection to %s:%d)", _config->mqtt_host, resolvedPort());
+        return false;
+    }
+
     bool connected = false;
     if (has_user) {
         const char *pass = has_pass ? _config->mqtt_password : "";
@@ -230,38 +686,123 @@ void MqttManager::ensureConnected() {
         );
     }
 
-    if (connected) {
-        Logger.logMessage("MQTT", "Connected");
+    if (!connected) {
+        Logger.logMessagef("MQTT", "Connect failed (state %d)", _client.state());
+        _net.stop();
+    }
+    return connected;
+}
+
+void MqttManager::onConnected() {
+    _state = ConnState::Connected;
+    _backoff_ms = 0;
+    _connected_ms = millis();
+    Logger.logMessage("MQTT", "Connected");
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
-        if (!_logged_snapshot_connected) {
-            device_telemetry_log_memory_snapshot("mqtt_connected");
-            _logged_snapshot_connected = true;
-        }
+    if (!_logged_snapshot_connected) {
+        device_telemetry_log_memory_snapshot("mqtt_connected");
+        _logged_snapshot_connected = true;
+    }
+#endif
+    publishAvailability(true);
+    if (!_discovery_published_this_boot) {
+        scheduleDiscovery(false);
+    }
+
+#if MQTT_DISCOVERY_SKIP_UNCHANGED
+    _client.subscribe(HA_DISCOVERY_STATUS_TOPIC);
+#endif
+
+#if MQTT_COMMANDS_ENABLED
+    char cmd_topic[sizeof(_base_topic) + 8];
+    snprintf(cmd_topic, sizeof(cmd_topic), "%s/cmd/+", _base_topic);
+    if (!_client.subscribe(cmd_topic)) {
+        Logger.logMessagef("MQTT", "Subscribe failed: %s", cmd_topic);
+    }
 #endif
-        publishAvailability(true);
-        publishDiscoveryOncePerBoot();
 
-        // Publish a single retained state after connect so HA entities have values,
-        // even when periodic publishing is disabled (interval = 0).
-        publishHealthNow();
+#if MQTT_MACROS_SYNC
+    // Retained: the current fleet config arrives right after subscribing.
+    if (!_client.subscribe(MQTT_MACROS_SYNC_TOPIC "/#")) {
+        Logger.logMessage("MQTT", "Subscribe failed: " MQTT_MACROS_SYNC_TOPIC "/#");
+    }
+#endif
+
+    // Publish a single retained state after connect so HA entities have values,
+    // even when periodic publishing is disabled (interval = 0).
+    publishHealthNow();
+
+    // If periodic publishing is enabled, start interval timing from now.
+    _last_health_publish_ms = millis();
+}
 
-        // If periodic publishing is enabled, start interval timing from now.
-        _last_health_publish_ms = millis();
+void MqttManager::scheduleReconnect() {
+    // Exponential backoff with up to 25% jitter, so a fleet that lost the same
+    // broker does not reconnect in lockstep.
+    if (_backoff_ms == 0) {
+        _backoff_ms = MQTT_RECONNECT_MIN_MS;
     } else {
-        Logger.logMessagef("MQTT", "Connect failed (state %d)", _client.state());
+        _backoff_ms = (_backoff_ms >= MQTT_RECONNECT_MAX_MS / 2) ? MQTT_RECONNECT_MAX_MS : _backoff_ms * 2;
     }
+    const uint32_t jitter = esp_random() % (_backoff_ms / 4 + 1);
+    _next_attempt_ms = millis() + _backoff_ms + jitter;
+    _state = ConnState::Backoff;
 }
 
-void MqttManager::loop() {
+void MqttManager::step() {
+    _client_owner = xTaskGetCurrentTaskHandle();
     if (!enabled()) return;
+    TRACE_SCOPE("mqtt.step");
 
-    ensureConnected();
+    if (WiFi.status() != WL_CONNECTED) {
+        if (_state == ConnState::Connected) {
+            Logger.logMessage("MQTT", "WiFi down; dropping broker connection");
+            _client.disconnect();
+        }
+        if (_state != ConnState::WaitWifi) {
+            _state = ConnState::WaitWifi;
+            _backoff_ms = 0;
+        }
+        expireQueuedEvents();
+        return;
+    }
 
-    if (_client.connected()) {
-        _client.loop();
-        publishHealthIfDue();
+    expireQueuedEvents();
+
+    if (_state != ConnState::Connected) {
+        if (_state == ConnState::Backoff && (long)(millis() - _next_attempt_ms) < 0) return;
+        if (attemptConnect()) {
+            onConnected();
+        } else {
+            scheduleReconnect();
+        }
+        return;
     }
+
+    if (!_client.loop()) {
+        Logger.logMessagef("MQTT", "Connection lost (state %d)", _client.state());
+        scheduleReconnect();
+        return;
+    }
+
+    drainQueue();
+
+#if MQTT_MACROS_SYNC
+    mqtt_macros_sync_poll(_base_topic);
+#endif
+
+    if (_discovery_pending && (long)(millis() - _discovery_at_ms) >= 0) {
+        _discovery_pending = false;
+        publishDiscovery(_discovery_force);
+    }
+
+    publishHealthIfDue();
+}
+
+void MqttManager::loop() {
+    if (_task) return;
+    step();
 }
 
 #endif // HAS_MQTT
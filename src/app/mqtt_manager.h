@@ -8,20 +8,40 @@
 
 // PubSubClient uses MQTT_MAX_PACKET_SIZE at compile time
 #ifndef MQTT_MAX_PACKET_SIZE
-#define MQTT_MAX_PACKET_SIZE 1024
+#define MQTT_MAX_PACKET_SIZE 1280
 #endif
 
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include "config_manager.h"
 
+struct MqttQueueStats {
+    uint8_t depth;            // publishes waiting now
+    uint32_t queued;          // accepted into a free slot
+    uint32_t coalesced;       // retained values that replaced a queued one for the same topic
+    uint32_t sent;
+    uint32_t dropped_full;    // queue full (or out of memory)
+    uint32_t dropped_expired; // events older than MQTT_PUBLISH_EVENT_MAX_AGE_MS
+    uint32_t dropped_failed;  // the broker rejected or the send failed
+};
+
+// The PubSubClient is owned by one task: the MQTT task (MQTT_TASK_ENABLED), or
+// the Arduino loop via loop() as a fallback. Connecting is a state machine with
+// exponential backoff, so a dead broker never stalls loop(). The publish helpers
+// can be called from any task: they copy the message into a bounded queue that
+// the owner drains while connected (called on the owner itself, they publish
+// directly). Retained messages coalesce per topic; other messages are FIFO.
 class MqttManager {
 public:
     MqttManager();
 
+    // Starts the MQTT task when MQTT is configured.
     void begin(const DeviceConfig *config, const char *friendly_name, const char *sanitized_name);
+    // Runs the client on the Arduino loop when no MQTT task is running.
     void loop();
 
     bool enabled() const;
@@ -31,10 +51,23 @@ public:
     // Status / instrumentation (safe to read from other tasks)
     unsigned long lastReconnectAttemptMs() const { return _last_reconnect_attempt_ms; }
     unsigned long lastHealthPublishMs() const { return _last_health_publish_ms; }
-
-    // Publish helpers
+    uint32_t reconnectBackoffMs() const { return _backoff_ms; }
+    void getQueueStats(MqttQueueStats *out) const;
+    // Split health topics (MQTT_HEALTH_SPLIT_TOPICS): fields sent / left out as unchanged.
+    uint32_t healthFieldsSent() const { return _health_fields_sent; }
+    uint32_t healthFieldsSkipped() const { return _health_fields_skipped; }
+    bool taskRunning() const { return _task != nullptr; }
+
+    // Publish helpers. Return false when MQTT is off or the queue is full; true
+    // means queued (or sent, on the client's own task). While disconnected the
+    // message waits in the queue for the next connection.
     bool publish(const char *topic, const char *payload, bool retained);
+    bool publish(const char *topic, const uint8_t *payload, size_t len, bool retained);
     bool publishJson(const char *topic, JsonDocument &doc, bool retained);
+    // Like publishJson, but on the client's own task the document is streamed
+    // to the socket (MQTT_DISCOVERY_STREAMED), so MQTT_MAX_PACKET_SIZE does not
+    // bound it. Elsewhere it falls back to publishJson.
+    bool publishJsonStreamed(const char *topic, JsonDocument &doc, bool retained);
 
     // Immediate publish API (topic is full topic string)
     bool publishImmediate(const char *topic, const char *payload, bool retained);
@@ -46,13 +79,51 @@ public:
 
     const char *friendlyName() const { return _friendly_name; }
     const char *sanitizedName() const { return _sanitized_name; }
+    const char *brokerHost() const { return _config ? _config->mqtt_host : ""; }
+    uint16_t brokerPort() const { return resolvedPort(); }
 
 private:
-    void ensureConnected();
+    enum class ConnState : uint8_t {
+        Idle,        // not attempted yet
+        WaitWifi,    // station not connected
+        Backoff,     // waiting for _next_attempt_ms
+        Connecting,  // TCP connect / CONNACK in progress
+        Connected,
+    };
+
+    struct OutMsg;
+
+    // Last published value of one split health field.
+    struct HealthField {
+        uint32_t key_hash;    // 0 = free slot
+        uint32_t text_hash;   // strings / null
+        double number;
+        bool numeric;
+    };
+    static constexpr uint8_t kHealthFieldSlots = 40;
+
+    static void taskFn(void *arg);
+    void startTask();
+    void step();
+
+    bool attemptConnect();
+    void onConnected();
+    void scheduleReconnect();
+
+    bool inClientContext() const;
+    bool publishDirect(const char *topic, const uint8_t *payload, size_t len, bool retained);
+    bool enqueue(const char *topic, const uint8_t *payload, size_t len, bool retained);
+    void drainQueue();
+    void expireQueuedEvents();
+
     void publishAvailability(bool online);
-    void publishDiscoveryOncePerBoot();
+    void scheduleDiscovery(bool force);
+    void publishDiscovery(bool force);
+    void onMessage(char *topic, uint8_t *payload, unsigned int length);
     void publishHealthNow();
     void publishHealthIfDue();
+    bool publishHealth(bool full);
+    bool publishHealthFields(JsonDocument &doc, bool full);
 
     bool connectEnabled() const;
     uint16_t resolvedPort() const;
@@ -69,6 +140,12 @@ private:
     char _health_state_topic[128] = {0};
 
     bool _discovery_published_this_boot = false;
+    // Discovery runs shortly after connecting (jittered, so a fleet rebooting
+    // together does not burst the broker); force = HA asked for it.
+    bool _discovery_pending = false;
+    bool _discovery_force = false;
+    unsigned long _discovery_at_ms = 0;
+    unsigned long _connected_ms = 0;
 
     // Instrumentation: avoid spamming snapshots in tight loops.
     bool _logged_snapshot_connect_attempt = false;
@@ -77,6 +154,27 @@ private:
 
     unsigned long _last_reconnect_attempt_ms = 0;
     unsigned long _last_health_publish_ms = 0;
+    // Intervals since the last full health snapshot.
+    uint16_t _health_intervals = 0;
+    uint32_t _health_fields_sent = 0;
+    uint32_t _health_fields_skipped = 0;
+#if MQTT_HEALTH_SPLIT_TOPICS
+    HealthField _health_fields[kHealthFieldSlots] = {};
+#endif
+
+    TaskHandle_t _task = nullptr;
+    // Task currently driving the client (set by step()).
+    TaskHandle_t _client_owner = nullptr;
+
+    volatile ConnState _state = ConnState::Idle;
+    uint32_t _backoff_ms = 0;
+    unsigned long _next_attempt_ms = 0;
+
+    // Ring of pending publishes (guarded by a spinlock in mqtt_manager.cpp).
+    OutMsg *_queue[MQTT_PUBLISH_QUEUE_DEPTH] = {};
+    uint8_t _queue_head = 0;
+    uint8_t _queue_count = 0;
+    MqttQueueStats _queue_stats = {};
 };
 
 // Global instance is defined in app.ino when HAS_MQTT is enabled.
@@ -0,0 +1,245 @@
+#include "ota_delta.h"
+
+#include "heap_tags.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#if OTA_DELTA_ENABLED
+#include <esp_app_desc.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+#endif
+
+static constexpr char kMagic[8] = {'E', 'S', 'P', 'D', 'L', 'T', '0', '1'};
+
+// Header field offsets.
+static constexpr size_t kHdrBaseSha = 8;
+static constexpr size_t kHdrBaseSize = 40;
+static constexpr size_t kHdrTargetSize = 44;
+static constexpr size_t kHdrTargetSha = 48;
+
+// Base bytes read from flash per step of a copy op.
+static constexpr size_t kScratchBytes = 1024;
+
+enum : uint8_t {
+    kOpEnd = 0x00,
+    kOpCopy = 0x01,
+    kOpInsert = 0x02,
+};
+
+static uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+OtaDelta::~OtaDelta() {
+    end();
+}
+
+bool OtaDelta::fail(const char* why) {
+    if (!err_) err_ = why;
+    state_ = State::End;
+    return false;
+}
+
+#if OTA_DELTA_ENABLED
+
+bool OtaDelta::begin(OtaGzipSinkFn sink, void* ctx) {
+    end();
+    sink_ = sink;
+    sink_ctx_ = ctx;
+    state_ = State::Header;
+    hdr_pos_ = 0;
+    args_pos_ = 0;
+    out_total_ = 0;
+    base_mismatch_ = false;
+    err_ = nullptr;
+
+    base_part_ = esp_ota_get_running_partition();
+    if (!base_part_) return fail("No running app partition");
+
+    // Both are small and hot: internal RAM.
+    sha_ = heap_tag_malloc(HeapTag::Ota, sizeof(mbedtls_sha256_context), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    scratch_ = (uint8_t*)heap_tag_malloc(HeapTag::Ota, kScratchBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!sha_ || !scratch_) {
+        end();
+        return fail("Out of memory for delta patch");
+    }
+    mbedtls_sha256_init((mbedtls_sha256_context*)sha_);
+    return true;
+}
+
+void OtaDelta::end() {
+    if (sha_) {
+        mbedtls_sha256_free((mbedtls_sha256_context*)sha_);
+        heap_tag_free(HeapTag::Ota, sha_);
+    }
+    if (scratch_) heap_tag_free(HeapTag::Ota, scratch_);
+    sha_ = nullptr;
+    scratch_ = nullptr;
+}
+
+bool OtaDelta::check_header() {
+    if (memcmp(hdr_, kMagic, sizeof(kMagic)) != 0) return fail("Not a delta patch");
+
+    const esp_app_desc_t* desc = esp_app_get_description();
+    if (!desc || memcmp(desc->app_elf_sha256, hdr_ + kHdrBaseSha, 32) != 0) {
+        base_mismatch_ = true;
+        return fail("Delta patch is for another firmware build");
+    }
+
+    base_size_ = read_u32(hdr_ + kHdrBaseSize);
+    target_size_ = read_u32(hdr_ + kHdrTargetSize);
+    if (base_size_ > ((const esp_partition_t*)base_part_)->size) {
+        base_mismatch_ = true;
+        return fail("Delta base larger than the running partition");
+    }
+    if (target_size_ == 0) return fail("Empty delta target");
+
+    mbedtls_sha256_starts((mbedtls_sha256_context*)sha_, 0);
+    state_ = State::Op;
+    return true;
+}
+
+bool OtaDelta::start_op() {
+    uint32_t len = 0;
+    if (op_ == kOpCopy) {
+        copy_off_ = read_u32(args_);
+        len = read_u32(args_ + 4);
+        if ((uint64_t)copy_off_ + len > base_size_) return fail("Delta copy outside the base image");
+        state_ = State::Copy;
+    } else {
+        len = read_u32(args_);
+        state_ = State::Insert;
+    }
+    if ((uint64_t)out_total_ + len > target_size_) return fail("Delta patch overruns the target size");
+    remaining_ = len;
+    if (remaining_ == 0) state_ = State::Op;
+    return true;
+}
+
+bool OtaDelta::put(const uint8_t* data, size_t len) {
+    mbedtls_sha256_update((mbedtls_sha256_context*)sha_, data, len);
+    out_total_ += len;
+    if (!sink_(sink_ctx_, data, len)) return fail("Flash write failed");
+    return true;
+}
+
+bool OtaDelta::write(const uint8_t* data, size_t len) {
+    if (err_) return false;
+    if (!sha_) return fail("Delta patch not started");
+
+    while (len > 0) {
+        switch (state_) {
+            case State::Header: {
+                size_t n = sizeof(hdr_) - hdr_pos_;
+                if (n > len) n = len;
+                memcpy(hdr_ + hdr_pos_, data, n);
+                hdr_pos_ += n;
+                data += n;
+                len -= n;
+                if (hdr_pos_ == sizeof(hdr_) && !check_header()) return false;
+                break;
+            }
+            case State::Op:
+                op_ = *data++;
+                len--;
+                args_pos_ = 0;
+                if (op_ == kOpEnd) {
+                    state_ = State::End;
+                } else if (op_ == kOpCopy) {
+                    args_len_ = 8;
+                    state_ = State::Args;
+                } else if (op_ == kOpInsert) {
+                    args_len_ = 4;
+                    state_ = State::Args;
+                } else {
+                    return fail("Bad delta op");
+                }
+                break;
+            case State::Args: {
+                size_t n = args_len_ - args_pos_;
+                if (n > len) n = len;
+                memcpy(args_ + args_pos_, data, n);
+                args_pos_ += n;
+                data += n;
+                len -= n;
+                if (args_pos_ == args_len_ && !start_op()) return false;
+                break;
+            }
+            case State::Copy: {
+                size_t n = remaining_;
+                if (n > len) n = len;
+                if (n > kScratchBytes) n = kScratchBytes;
+                if (esp_partition_read((const esp_partition_t*)base_part_, copy_off_, scratch_, n) != ESP_OK) {
+                    return fail("Base partition read failed");
+                }
+                for (size_t i = 0; i < n; i++) scratch_[i] = (uint8_t)(scratch_[i] + data[i]);
+                if (!put(scratch_, n)) return false;
+                copy_off_ += n;
+                remaining_ -= n;
+                data += n;
+                len -= n;
+                if (remaining_ == 0) state_ = State::Op;
+                break;
+            }
+            case State::Insert: {
+                size_t n = remaining_;
+                if (n > len) n = len;
+                if (!put(data, n)) return false;
+                remaining_ -= n;
+                data += n;
+                len -= n;
+                if (remaining_ == 0) state_ = State::Op;
+                break;
+            }
+            case State::End:
+                return fail("Data after delta end");
+        }
+    }
+    return true;
+}
+
+bool OtaDelta::finish() {
+    if (err_) return false;
+    if (state_ != State::End) return fail("Truncated delta patch");
+    if (out_total_ != target_size_) return fail("Delta target size mismatch");
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish((mbedtls_sha256_context*)sha_, digest);
+    if (memcmp(digest, hdr_ + kHdrTargetSha, sizeof(digest)) != 0) return fail("Delta target hash mismatch");
+    return true;
+}
+
+#else
+
+bool OtaDelta::begin(OtaGzipSinkFn, void*) {
+    return fail("Delta OTA not supported by this build");
+}
+
+void OtaDelta::end() {
+}
+
+bool OtaDelta::check_header() {
+    return false;
+}
+
+bool OtaDelta::start_op() {
+    return false;
+}
+
+bool OtaDelta::put(const uint8_t*, size_t) {
+    return false;
+}
+
+bool OtaDelta::write(const uint8_t*, size_t) {
+    return fail("Delta OTA not supported by this build");
+}
+
+bool OtaDelta::finish() {
+    return fail("Delta OTA not supported by this build");
+}
+
+#endif // OTA_DELTA_ENABLED
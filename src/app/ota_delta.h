@@ -0,0 +1,95 @@
+/*
+ * Delta OTA patch applier
+ *
+ * A delta patch (tools/make_delta_ota.py) rebuilds the next firmware image
+ * from the running one: most of the image is copied from the running app
+ * partition with a byte-wise correction added, the rest is sent literally.
+ * Releases ship it gzip'd, so the patch stream is normally fed from the
+ * OtaGzip sink; the rebuilt image goes to this class's sink (Update.write).
+ *
+ * Patch layout (little-endian):
+ *   header  "ESPDLT01"  magic
+ *           u8[32]      ELF SHA-256 of the base build (esp_app_desc_t)
+ *           u32         base image size
+ *           u32         target image size
+ *           u8[32]      SHA-256 of the target image
+ *   ops     0x01 u32 base_offset, u32 len, u8 diff[len]  target = base + diff
+ *           0x02 u32 len, u8 data[len]                   literal bytes
+ *           0x00                                          end
+ *
+ * The header is refused (base_mismatch()) unless the running firmware is
+ * the build the patch was made from, before any byte is written. The
+ * rebuilt image is hashed as it is written and compared at finish().
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_config.h"
+#include "ota_gzip.h"
+
+class OtaDelta {
+public:
+    OtaDelta() = default;
+    ~OtaDelta();
+
+    // Start a patch; output goes to sink. False when OTA_DELTA_ENABLED is
+    // off, there is no running app partition, or memory is short.
+    bool begin(OtaGzipSinkFn sink, void* ctx);
+
+    // Feed the next patch bytes. False on a bad patch, a base mismatch or a
+    // failing sink.
+    bool write(const uint8_t* data, size_t len);
+
+    // After the last write: check the end marker, size and hash.
+    bool finish();
+
+    void end();
+
+    // True when the patch was made for a different base firmware.
+    bool base_mismatch() const { return base_mismatch_; }
+    const char* error() const { return err_; }
+    size_t out_bytes() const { return out_total_; }
+
+    // Adapter for OtaGzip::begin(): ctx is the OtaDelta.
+    static bool sink(void* ctx, const uint8_t* data, size_t len) {
+        return static_cast<OtaDelta*>(ctx)->write(data, len);
+    }
+
+private:
+    enum class State : uint8_t {
+        Header,
+        Op,
+        Args,
+        Copy,
+        Insert,
+        End,
+    };
+
+    bool fail(const char* why);
+    bool check_header();
+    bool start_op();
+    bool put(const uint8_t* data, size_t len);
+
+    OtaGzipSinkFn sink_ = nullptr;
+    void* sink_ctx_ = nullptr;
+    const void* base_part_ = nullptr;  // esp_partition_t of the running app
+    void* sha_ = nullptr;               // mbedtls_sha256_context
+    uint8_t* scratch_ = nullptr;        // base bytes being patched
+    State state_ = State::Header;
+    uint8_t hdr_[80] = {};
+    size_t hdr_pos_ = 0;
+    uint8_t op_ = 0;
+    uint8_t args_[8] = {};
+    size_t args_pos_ = 0;
+    size_t args_len_ = 0;
+    uint32_t base_size_ = 0;
+    uint32_t target_size_ = 0;
+    uint32_t copy_off_ = 0;             // next base byte for the current copy
+    uint32_t remaining_ = 0;            // bytes left in the current op
+    size_t out_total_ = 0;
+    bool base_mismatch_ = false;
+    const char* err_ = nullptr;
+};
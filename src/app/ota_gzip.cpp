@@ -0,0 +1,239 @@
+#include "ota_gzip.h"
+
+#include "heap_placement.h"
+#include "heap_tags.h"
+
+#include <Arduino.h>
+#include <esp_rom_crc.h>
+#include <string.h>
+
+#if OTA_GZIP_ENABLED
+#if __has_include(<rom/miniz.h>)
+#include <rom/miniz.h>
+#else
+#include <miniz.h>
+#endif
+#endif
+
+// Output is handed on in flash-sector units.
+static constexpr size_t kSectorBytes = 4096;
+
+// gzip header flag bits (RFC 1952).
+static constexpr uint8_t kFlagHcrc = 0x02;
+static constexpr uint8_t kFlagExtra = 0x04;
+static constexpr uint8_t kFlagName = 0x08;
+static constexpr uint8_t kFlagComment = 0x10;
+
+OtaGzip::~OtaGzip() {
+    end();
+}
+
+bool OtaGzip::looks_gzip(const uint8_t* data, size_t len) {
+    return data && len >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+}
+
+#if OTA_GZIP_ENABLED
+
+static_assert(TINFL_LZ_DICT_SIZE % kSectorBytes == 0, "window must hold whole sectors");
+
+bool OtaGzip::begin(OtaGzipSinkFn sink, void* ctx) {
+    end();
+    sink_ = sink;
+    sink_ctx_ = ctx;
+    window_ofs_ = 0;
+    flushed_ = 0;
+    state_ = State::Header;
+    flags_ = 0;
+    hdr_pos_ = 0;
+    skip_ = 0;
+    trailer_pos_ = 0;
+    crc_ = 0;
+    out_total_ = 0;
+    err_ = nullptr;
+
+    // The inflate state (~11 KB of Huffman tables) is read on every symbol, so
+    // it goes to internal RAM (Latency). The 32 KB window only takes each output
+    // byte once, plus back-references and one read per flushed sector; it can
+    // live in PSRAM (Transient) without slowing the flash-bound update.
+    decomp_ = heap_place_malloc(HeapClass::Latency, HeapTag::Ota, sizeof(tinfl_decompressor));
+    window_ = (uint8_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Ota, TINFL_LZ_DICT_SIZE);
+    if (!decomp_ || !window_) {
+        end();
+        return fail("Out of memory for gzip decoder");
+    }
+    tinfl_init((tinfl_decompressor*)decomp_);
+    return true;
+}
+
+void OtaGzip::end() {
+    if (decomp_) heap_tag_free(HeapTag::Ota, decomp_);
+    if (window_) heap_tag_free(HeapTag::Ota, window_);
+    decomp_ = nullptr;
+    window_ = nullptr;
+}
+
+bool OtaGzip::fail(const char* why) {
+    if (!err_) err_ = why;
+    state_ = State::Done;
+    return false;
+}
+
+// Hand window_ bytes [flushed_, upto) to the sink in whole sectors; the
+// partial tail only once the deflate stream has ended.
+bool OtaGzip::emit(size_t upto) {
+    while (flushed_ < upto) {
+        size_t n = upto - flushed_;
+        if (n > kSectorBytes) n = kSectorBytes;
+        if (n < kSectorBytes && state_ == State::Body) break;
+        crc_ = esp_rom_crc32_le(crc_, window_ + flushed_, n);
+        if (!sink_(sink_ctx_, window_ + flushed_, n)) return fail("Flash write failed");
+        flushed_ += n;
+        out_total_ += n;
+    }
+    if (flushed_ == TINFL_LZ_DICT_SIZE) {
+        flushed_ = 0;
+        window_ofs_ = 0;
+    }
+    return true;
+}
+
+bool OtaGzip::header_byte(uint8_t b) {
+    switch (state_) {
+        case State::Header:
+            hdr_[hdr_pos_++] = b;
+            if (hdr_pos_ < sizeof(hdr_)) return true;
+            // ID1 ID2 CM(8 = deflate) FLG MTIME(4) XFL OS
+            if (hdr_[0] != 0x1f || hdr_[1] != 0x8b || hdr_[2] != 8) return fail("Not a gzip file");
+            flags_ = hdr_[3];
+            hdr_pos_ = 0;
+            state_ = (flags_ & kFlagExtra) ? State::ExtraLen : State::Name;
+            break;
+        case State::ExtraLen:
+            hdr_[hdr_pos_++] = b;
+            if (hdr_pos_ < 2) return true;
+            skip_ = (size_t)hdr_[0] | ((size_t)hdr_[1] << 8);
+            hdr_pos_ = 0;
+            state_ = skip_ ? State::Extra : State::Name;
+            break;
+        case State::Extra:
+            if (--skip_ == 0) state_ = State::Name;
+            break;
+        case State::Name:
+            if (b == 0) state_ = State::Comment;
+            break;
+        case State::Comment:
+            if (b == 0) state_ = State::HeaderCrc;
+            break;
+        case State::HeaderCrc:
+            if (++hdr_pos_ == 2) state_ = State::Body;
+            break;
+        default:
+            break;
+    }
+
+    // Step over the optional fields this file does not have.
+    if (state_ == State::Name && !(flags_ & kFlagName)) state_ = State::Comment;
+    if (state_ == State::Comment && !(flags_ & kFlagComment)) state_ = State::HeaderCrc;
+    if (state_ == State::HeaderCrc && !(flags_ & kFlagHcrc)) state_ = State::Body;
+    return true;
+}
+
+bool OtaGzip::write(const uint8_t* data, size_t len) {
+    if (err_) return false;
+    if (!decomp_) return fail("gzip decoder not started");
+
+    bool more_output = false;
+    while (len > 0 || more_output) {
+        if (state_ == State::Done) return fail("Data after gzip trailer");
+
+        if (state_ == State::Trailer) {
+            while (len > 0 && trailer_pos_ < sizeof(trailer_)) {
+                trailer_[trailer_pos_++] = *data++;
+                len--;
+            }
+            if (trailer_pos_ == sizeof(trailer_)) state_ = State::Done;
+            continue;
+        }
+
+        if (state_ != State::Body) {
+            if (!header_byte(*data++)) return false;
+            len--;
+            continue;
+        }
+
+        tinfl_decompressor* r = (tinfl_decompressor*)decomp_;
+        size_t in_size = len;
+        size_t out_size = TINFL_LZ_DICT_SIZE - window_ofs_;
+        const tinfl_status status = tinfl_decompress(
+            r, data, &in_size, window_, window_ + window_ofs_, &out_size, TINFL_FLAG_HAS_MORE_INPUT
+        );
+        data += in_size;
+        len -= in_size;
+        window_ofs_ += out_size;
+        more_output = status == TINFL_STATUS_HAS_MORE_OUTPUT;
+
+        if (status < TINFL_STATUS_DONE) return fail("Corrupt gzip data");
+
+        if (status == TINFL_STATUS_DONE) {
+            state_ = State::Trailer;
+            if (!emit(window_ofs_)) return false;
+            // Whole bytes still in the bit buffer (past the final block's
+            // padding) were read ahead and belong to the trailer.
+            uint32_t bits = r->m_num_bits;
+            uint64_t buf = (uint64_t)r->m_bit_buf;
+            buf >>= (bits & 7);
+            bits -= bits & 7;
+            while (bits >= 8 && trailer_pos_ < sizeof(trailer_)) {
+                trailer_[trailer_pos_++] = (uint8_t)(buf & 0xFF);
+                buf >>= 8;
+                bits -= 8;
+            }
+            if (trailer_pos_ == sizeof(trailer_)) state_ = State::Done;
+            continue;
+        }
+
+        if (!emit(window_ofs_)) return false;
+        if (in_size == 0 && out_size == 0 && !more_output) return fail("gzip decoder stalled");
+    }
+    return true;
+}
+
+bool OtaGzip::finish() {
+    if (err_) return false;
+    if (state_ != State::Done) {
+        return fail(state_ == State::Trailer ? "Truncated gzip trailer" : "Truncated gzip file");
+    }
+
+    const uint32_t crc = (uint32_t)trailer_[0] | ((uint32_t)trailer_[1] << 8) | ((uint32_t)trailer_[2] << 16) |
+                         ((uint32_t)trailer_[3] << 24);
+    const uint32_t isize = (uint32_t)trailer_[4] | ((uint32_t)trailer_[5] << 8) | ((uint32_t)trailer_[6] << 16) |
+                           ((uint32_t)trailer_[7] << 24);
+    if (crc != crc_) return fail("gzip CRC mismatch");
+    if (isize != (uint32_t)out_total_) return fail("gzip length mismatch");
+    return true;
+}
+
+#else
+
+bool OtaGzip::begin(OtaGzipSinkFn, void*) {
+    return fail("gzip firmware not supported by this build");
+}
+
+void OtaGzip::end() {
+}
+
+bool OtaGzip::fail(const char* why) {
+    if (!err_) err_ = why;
+    state_ = State::Done;
+    return false;
+}
+
+bool OtaGzip::write(const uint8_t*, size_t) {
+    return fail("gzip firmware not supported by this build");
+}
+
+bool OtaGzip::finish() {
+    return fail("gzip firmware not supported by this build");
+}
+
+#endif // OTA_GZIP_ENABLED
@@ -0,0 +1,81 @@
+/*
+ * Streaming gzip decoder for OTA images
+ *
+ * Firmware can be uploaded as a gzip file (gzip -9 of the app .bin, about
+ * half the size). Compressed bytes are fed in whatever chunks the transport
+ * delivers; the ROM inflater (tinfl) expands them into a 32 KiB window and
+ * every full 4 KiB flash sector of output is handed to the sink, so
+ * Update.write() sees sector-aligned writes. The gzip trailer (CRC-32 and
+ * length) is checked before finish() reports success.
+ *
+ * Memory: ~11 KB decompressor state + 32 KiB window (PSRAM when present),
+ * held from begin() to end().
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_config.h"
+
+// Receives decompressed output; false aborts the stream.
+typedef bool (*OtaGzipSinkFn)(void* ctx, const uint8_t* data, size_t len);
+
+class OtaGzip {
+public:
+    OtaGzip() = default;
+    ~OtaGzip();
+
+    // True for the gzip magic (1f 8b) at the start of data.
+    static bool looks_gzip(const uint8_t* data, size_t len);
+
+    // Allocate the decoder. False when OTA_GZIP_ENABLED is off or memory is short.
+    bool begin(OtaGzipSinkFn sink, void* ctx);
+
+    // Feed the next compressed bytes. False on corrupt input or a failing sink.
+    bool write(const uint8_t* data, size_t len);
+
+    // After the last write: flush the tail and check the trailer.
+    bool finish();
+
+    // Free the buffers (also done by the destructor).
+    void end();
+
+    const char* error() const { return err_; }
+    size_t out_bytes() const { return out_total_; }
+
+private:
+    enum class State : uint8_t {
+        Header,     // fixed 10 bytes
+        ExtraLen,
+        Extra,
+        Name,
+        Comment,
+        HeaderCrc,
+        Body,
+        Trailer,
+        Done,
+    };
+
+    bool fail(const char* why);
+    bool header_byte(uint8_t b);
+    bool emit(size_t upto);
+
+    OtaGzipSinkFn sink_ = nullptr;
+    void* sink_ctx_ = nullptr;
+    void* decomp_ = nullptr;     // tinfl_decompressor
+    uint8_t* window_ = nullptr;  // TINFL_LZ_DICT_SIZE, circular
+    size_t window_ofs_ = 0;      // next output byte in window_
+    size_t flushed_ = 0;         // window_ bytes already handed to the sink
+    State state_ = State::Header;
+    uint8_t flags_ = 0;
+    uint8_t hdr_[10] = {};
+    size_t hdr_pos_ = 0;
+    size_t skip_ = 0;            // FEXTRA bytes still to skip
+    uint8_t trailer_[8] = {};
+    size_t trailer_pos_ = 0;
+    uint32_t crc_ = 0;
+    size_t out_total_ = 0;
+    const char* err_ = nullptr;
+};
@@ -0,0 +1,158 @@
+#include "ota_quiet.h"
+
+#include "config_manager.h"
+#include "log_manager.h"
+#include "web_portal.h"
+#include "web_portal_state.h"
+
+#if HAS_DISPLAY
+#include "display_manager.h"
+#endif
+
+#include <esp_attr.h>
+
+namespace {
+
+// Progress screen redraws at most this often (percent).
+constexpr uint32_t kProgressStepPercent = 5;
+constexpr uint32_t kPollMs = 250;
+constexpr uint32_t kStatsMagic = 0x4F515331;  // "OQS1"
+
+// Last update's flash writes. Kept in RTC memory so a successful update,
+// which reboots, can still be read back afterwards.
+struct FlashStats {
+    uint32_t magic;
+    uint32_t quiet;
+    uint32_t bytes;
+    uint64_t write_us;
+    uint32_t write_max_us;
+};
+
+RTC_NOINIT_ATTR FlashStats g_flash;
+
+// g_flash belongs to the update running in this boot.
+volatile bool g_recording = false;
+volatile bool g_active = false;
+bool g_seen_ota = false;
+uint32_t g_shown_percent = 0;
+uint32_t g_started_ms = 0;
+
+void flash_stats_open() {
+    if (g_recording) return;
+    g_recording = true;
+    g_flash.magic = kStatsMagic;
+    g_flash.quiet = OTA_QUIET_ENABLED ? 1 : 0;
+    g_flash.bytes = 0;
+    g_flash.write_us = 0;
+    g_flash.write_max_us = 0;
+}
+
+void ota_progress(uint32_t* progress, uint32_t* total) {
+    FirmwareUpdateStatus fw;
+    web_portal_get_firmware_update_status(&fw);
+    if (fw.in_progress) {
+        *progress = fw.progress;
+        *total = fw.total;
+        return;
+    }
+    const WebPortalState& st = web_portal_state();
+    *progress = (uint32_t)st.ota_progress;
+    *total = (uint32_t)st.ota_total;
+}
+
+#if HAS_DISPLAY
+void show_progress(bool force) {
+    uint32_t progress = 0;
+    uint32_t total = 0;
+    ota_progress(&progress, &total);
+    const uint32_t percent = total ? (uint32_t)((uint64_t)progress * 100 / total) : 0;
+    if (!force && percent < g_shown_percent + kProgressStepPercent) return;
+    g_shown_percent = percent;
+
+    char text[48];
+    if (total) {
+        snprintf(text, sizeof(text), "Updating firmware...\n%u%%", (unsigned)(percent > 100 ? 100 : percent));
+    } else {
+        strlcpy(text, "Updating firmware...", sizeof(text));
+    }
+    display_manager_show_ota_progress(text);
+}
+#endif
+
+void enter() {
+    g_active = true;
+    g_started_ms = millis();
+    g_shown_percent = 0;
+#if HAS_DISPLAY
+    show_progress(true);
+#endif
+    Logger.logMessage("OTA", "Quiet mode on: display, MQTT health, BLE, icon warm-up and CPU monitor paused");
+}
+
+void leave() {
+    g_active = false;
+#if HAS_DISPLAY
+    display_manager_end_ota_progress();
+#endif
+    Logger.logMessagef("OTA", "Quiet mode off after %lu ms", (unsigned long)(millis() - g_started_ms));
+}
+
+} // namespace
+
+uint32_t ota_quiet_loop(uint32_t) {
+    const bool ota = web_portal_ota_in_progress();
+    if (ota && !g_seen_ota) {
+        g_seen_ota = true;
+        // A debounced config write must not land in the middle of the update.
+        config_manager_flush();
+        flash_stats_open();
+        if (OTA_QUIET_ENABLED) enter();
+    } else if (!ota && g_seen_ota) {
+        g_seen_ota = false;
+        g_recording = false;
+        if (g_active) leave();
+
+        OtaQuietStats st;
+        ota_quiet_get_stats(&st);
+        Logger.logMessagef("OTA", "Flash writes: %lu bytes in %lu ms (%lu KB/s, max %lu us)%s",
+            (unsigned long)st.last_flash_bytes, (unsigned long)st.last_flash_ms,
+            (unsigned long)st.last_flash_kbps, (unsigned long)st.last_flash_write_max_us,
+            st.last_quiet ? " in quiet mode" : "");
+    }
+#if HAS_DISPLAY
+    else if (g_active) {
+        show_progress(false);
+    }
+#endif
+    return kPollMs;
+}
+
+bool ota_quiet_active() {
+    return g_active;
+}
+
+void ota_quiet_note_flash_write(size_t bytes, uint32_t us) {
+    // The first write may land before the main loop has seen the update.
+    flash_stats_open();
+    g_flash.bytes += (uint32_t)bytes;
+    g_flash.write_us += us;
+    if (us > g_flash.write_max_us) g_flash.write_max_us = us;
+}
+
+void ota_quiet_get_stats(OtaQuietStats* out) {
+    out->active = g_active;
+    out->last_valid = g_flash.magic == kStatsMagic && g_flash.bytes > 0;
+    if (!out->last_valid) {
+        out->last_quiet = false;
+        out->last_flash_bytes = 0;
+        out->last_flash_ms = 0;
+        out->last_flash_kbps = 0;
+        out->last_flash_write_max_us = 0;
+        return;
+    }
+    out->last_quiet = g_flash.quiet != 0;
+    out->last_flash_bytes = g_flash.bytes;
+    out->last_flash_ms = (uint32_t)(g_flash.write_us / 1000);
+    out->last_flash_kbps = g_flash.write_us ? (uint32_t)((uint64_t)g_flash.bytes * 1000000ULL / g_flash.write_us / 1024) : 0;
+    out->last_flash_write_max_us = g_flash.write_max_us;
+}
@@ -0,0 +1,45 @@
+#ifndef OTA_QUIET_H
+#define OTA_QUIET_H
+
+#include "board_config.h"
+
+// OTA Quiet Mode
+// While a firmware update writes flash (browser upload or GitHub download),
+// the subsystems that compete with it for CPU, cache and RAM step aside:
+//   - display: a static progress screen (splash without its spinner), redrawn
+//     only when the percentage moves; screen requests wait until the end
+//   - MQTT: health publishes are held (connection and commands stay up)
+//   - BLE keyboard: an idle stack is stopped and not started on demand
+//   - icon warm-up and the CPU monitor: paused
+//   - image API: already held by web_portal_ota_in_progress()
+// Everything is restored when the update fails; a successful one reboots.
+//
+// Every flash write of an update is timed either way, and the result of the
+// last update survives its reboot, so the gain shows up as flash throughput
+// with and without OTA_QUIET_ENABLED.
+
+#include <Arduino.h>
+
+struct OtaQuietStats {
+    bool active;                   // quiet mode is on now
+    bool last_valid;               // the last_* fields describe an update
+    bool last_quiet;               // it ran in quiet mode
+    uint32_t last_flash_bytes;
+    uint32_t last_flash_ms;        // time spent inside flash writes
+    uint32_t last_flash_kbps;      // last_flash_bytes / last_flash_ms, in KB/s
+    uint32_t last_flash_write_max_us;
+};
+
+// Main loop: follows web_portal_ota_in_progress() and switches quiet mode.
+// Returns ms until it wants to run again.
+uint32_t ota_quiet_loop(uint32_t now_ms);
+
+// True while quiet mode is on (any task).
+bool ota_quiet_active();
+
+// Record one flash write of the running update (any task).
+void ota_quiet_note_flash_write(size_t bytes, uint32_t us);
+
+void ota_quiet_get_stats(OtaQuietStats* out);
+
+#endif // OTA_QUIET_H
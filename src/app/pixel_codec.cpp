@@ -0,0 +1,137 @@
+/*
+ * Pixel Stream Codecs Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API || (HAS_DISPLAY && HAS_ICONS)
+
+#include "pixel_codec.h"
+#include <stdio.h>
+#include <string.h>
+
+bool pixel_rle_decode(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len, size_t unit, char* err, size_t err_sz) {
+    if (unit == 0 || unit > 4) {
+        snprintf(err, err_sz, "RLE unit size invalid");
+        return false;
+    }
+
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (op < dst_len) {
+        if (ip >= src_len) {
+            snprintf(err, err_sz, "RLE data ends early (%u/%u bytes)", (unsigned)op, (unsigned)dst_len);
+            return false;
+        }
+
+        const uint8_t c = src[ip++];
+        if (c < 0x80) {
+            const size_t n = ((size_t)c + 1) * unit;
+            if (ip + n > src_len || op + n > dst_len) {
+                snprintf(err, err_sz, "RLE literal run out of bounds");
+                return false;
+            }
+            memcpy(dst + op, src + ip, n);
+            ip += n;
+            op += n;
+        } else {
+            const size_t count = (size_t)(c - 0x80) + 2;
+            if (ip + unit > src_len || op + count * unit > dst_len) {
+                snprintf(err, err_sz, "RLE repeat run out of bounds");
+                return false;
+            }
+            const uint8_t* value = src + ip;
+            ip += unit;
+            for (size_t i = 0; i < count; i++) {
+                memcpy(dst + op, value, unit);
+                op += unit;
+            }
+        }
+    }
+
+    if (ip != src_len) {
+        snprintf(err, err_sz, "RLE data has %u trailing bytes", (unsigned)(src_len - ip));
+        return false;
+    }
+    return true;
+}
+
+// LZ4 block format: [token][literal length+][literals][offset:le16][match length+] ...
+// The last sequence carries literals only.
+bool pixel_lz4_decode(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len, char* err, size_t err_sz) {
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < src_len) {
+        const uint8_t token = src[ip++];
+
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            uint8_t b = 0;
+            do {
+                if (ip >= src_len) {
+                    snprintf(err, err_sz, "LZ4 literal length truncated");
+                    return false;
+                }
+                b = src[ip++];
+                lit += b;
+            } while (b == 255);
+        }
+
+        if (lit > src_len - ip || lit > dst_len - op) {
+            snprintf(err, err_sz, "LZ4 literals out of bounds");
+            return false;
+        }
+        memcpy(dst + op, src + ip, lit);
+        ip += lit;
+        op += lit;
+
+        if (ip == src_len) break;
+
+        if (ip + 2 > src_len) {
+            snprintf(err, err_sz, "LZ4 match offset truncated");
+            return false;
+        }
+        const size_t offset = (size_t)src[ip] | ((size_t)src[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            snprintf(err, err_sz, "LZ4 match offset invalid");
+            return false;
+        }
+
+        size_t match = token & 0x0F;
+        if (match == 15) {
+            uint8_t b = 0;
+            do {
+                if (ip >= src_len) {
+                    snprintf(err, err_sz, "LZ4 match length truncated");
+                    return false;
+                }
+                b = src[ip++];
+                match += b;
+            } while (b == 255);
+        }
+        match += 4;
+
+        if (match > dst_len - op) {
+            snprintf(err, err_sz, "LZ4 match out of bounds");
+            return false;
+        }
+
+        // Matches may overlap their own output; copy byte by byte.
+        const uint8_t* from = dst + op - offset;
+        for (size_t i = 0; i < match; i++) {
+            dst[op + i] = from[i];
+        }
+        op += match;
+    }
+
+    if (op != dst_len) {
+        snprintf(err, err_sz, "LZ4 output size mismatch (%u/%u bytes)", (unsigned)op, (unsigned)dst_len);
+        return false;
+    }
+    return true;
+}
+
+#endif // HAS_IMAGE_API || (HAS_DISPLAY && HAS_ICONS)
@@ -0,0 +1,28 @@
+/*
+ * Pixel Stream Codecs
+ *
+ * Byte-level decoders shared by the RGB565 rectangle uploads (rgb565_codec.h)
+ * and compressed installed icons (icon_store.h). A pixel is a fixed-size unit
+ * of 1-4 bytes; the decoders only move bytes.
+ *
+ *   rle - PackBits over units: control byte c < 0x80 is followed by c+1
+ *         literal units; c >= 0x80 is followed by one unit repeated
+ *         (c - 0x80) + 2 times
+ *   lz4 - one LZ4 block (no frame header)
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API || (HAS_DISPLAY && HAS_ICONS)
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Decode exactly dst_len bytes. Return false (with a message in err) on
+// malformed, short or trailing input.
+bool pixel_rle_decode(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len, size_t unit, char* err, size_t err_sz);
+bool pixel_lz4_decode(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len, char* err, size_t err_sz);
+
+#endif // HAS_IMAGE_API || (HAS_DISPLAY && HAS_ICONS)
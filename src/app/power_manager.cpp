@@ -0,0 +1,232 @@
+#include "power_manager.h"
+
+#if POWER_IDLE_ENABLED
+
+#include "log_manager.h"
+
+#include <WiFi.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_wifi.h>
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+
+#if HAS_TOUCH
+#include "touch_manager.h"
+#endif
+
+namespace {
+
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+constexpr bool kLightSleepAvailable = POWER_IDLE_LIGHT_SLEEP;
+#else
+constexpr bool kLightSleepAvailable = false;
+#endif
+
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_PM_ENABLE
+esp_pm_lock_handle_t g_locks[(size_t)PowerActivity::Count] = {};
+#endif
+
+// Timed holds: one lock acquire each, released by power_manager_loop().
+bool g_timed_held[(size_t)PowerActivity::Count] = {};
+uint32_t g_timed_until_ms[(size_t)PowerActivity::Count] = {};
+
+// Full clock, sampled before DFS can lower it.
+uint32_t g_max_mhz = 0;
+bool g_idle = false;
+bool g_light_sleep = false;
+bool g_gpio_wake = false;
+uint32_t g_idle_since_ms = 0;
+uint32_t g_last_loop_ms = 0;
+PowerStats g_stats = {};
+
+#if POWER_IDLE_WIFI_MAX_MODEM
+// Power save mode in effect before idle (normally WIFI_PS_NONE), restored on wake.
+wifi_ps_type_t g_wifi_ps_before_idle = WIFI_PS_NONE;
+#endif
+
+const char* activity_name(PowerActivity a) {
+    switch (a) {
+        case PowerActivity::Http: return "pm_http";
+        case PowerActivity::Mqtt: return "pm_mqtt";
+        case PowerActivity::Ble: return "pm_ble";
+        default: return "pm";
+    }
+}
+
+void lock_acquire(PowerActivity a) {
+#if CONFIG_PM_ENABLE
+    if (g_locks[(size_t)a]) esp_pm_lock_acquire(g_locks[(size_t)a]);
+#else
+    (void)a;
+#endif
+}
+
+void lock_release(PowerActivity a) {
+#if CONFIG_PM_ENABLE
+    if (g_locks[(size_t)a]) esp_pm_lock_release(g_locks[(size_t)a]);
+#else
+    (void)a;
+#endif
+}
+
+bool configure(bool idle) {
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t cfg = {};
+    cfg.max_freq_mhz = (int)g_max_mhz;
+    cfg.min_freq_mhz = idle ? POWER_IDLE_MIN_FREQ_MHZ : (int)g_max_mhz;
+    cfg.light_sleep_enable = idle && kLightSleepAvailable;
+    const esp_err_t err = esp_pm_configure(&cfg);
+    if (err != ESP_OK) {
+        Logger.logMessagef("Power", "esp_pm_configure failed (%d)", (int)err);
+        return false;
+    }
+    g_light_sleep = cfg.light_sleep_enable;
+    return true;
+#else
+    (void)idle;
+    return false;
+#endif
+}
+
+// Light sleep only wakes on configured sources; let the touch controller's INT
+// line end it. Edge interrupts cannot wake the chip, so this is a level wake,
+// which would turn the touch sampler's falling-edge ISR into a level storm:
+// only use it when that ISR is not attached.
+void set_touch_gpio_wake(bool enable) {
+#if HAS_TOUCH && defined(TOUCH_INT) && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    if (TOUCH_INT < 0) return;
+    if (enable) {
+        TouchSamplerStats ts = {};
+        touch_manager_get_sampler_stats(&ts);
+        if (ts.active || !g_light_sleep) return;
+        if (gpio_wakeup_enable((gpio_num_t)TOUCH_INT, GPIO_INTR_LOW_LEVEL) != ESP_OK) return;
+        esp_sleep_enable_gpio_wakeup();
+        g_gpio_wake = true;
+    } else if (g_gpio_wake) {
+        gpio_wakeup_disable((gpio_num_t)TOUCH_INT);
+        g_gpio_wake = false;
+    }
+#else
+    (void)enable;
+#endif
+}
+
+} // namespace
+
+void power_manager_init() {
+#if CONFIG_PM_ENABLE
+    g_stats.supported = true;
+    g_max_mhz = getCpuFrequencyMhz();
+    for (size_t i = 0; i < (size_t)PowerActivity::Count; i++) {
+        if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, activity_name((PowerActivity)i), &g_locks[i]) != ESP_OK) {
+            g_locks[i] = nullptr;
+        }
+    }
+    configure(false);
+    Logger.logMessagef("Power", "Idle power mode ready (%d-%u MHz, light sleep %s)",
+        (int)POWER_IDLE_MIN_FREQ_MHZ, (unsigned)g_max_mhz, kLightSleepAvailable ? "on" : "unavailable");
+#else
+    Logger.logMessage("Power", "CONFIG_PM_ENABLE is off in this core; idle power mode disabled");
+#endif
+}
+
+void power_manager_loop() {
+    const uint32_t now = millis();
+
+    if (g_idle && g_last_loop_ms) {
+        const uint32_t gap = now - g_last_loop_ms;
+        if (gap > g_stats.idle_loop_gap_max_ms) g_stats.idle_loop_gap_max_ms = gap;
+    }
+    g_last_loop_ms = now;
+
+    for (size_t i = 0; i < (size_t)PowerActivity::Count; i++) {
+        bool expired = false;
+        portENTER_CRITICAL(&g_mux);
+        if (g_timed_held[i] && (int32_t)(now - g_timed_until_ms[i]) >= 0) {
+            g_timed_held[i] = false;
+            expired = true;
+        }
+        portEXIT_CRITICAL(&g_mux);
+        if (expired) lock_release((PowerActivity)i);
+    }
+}
+
+void power_manager_set_idle(bool idle) {
+    if (idle == g_idle) return;
+    const uint32_t now = millis();
+
+    if (idle) {
+        if (!configure(true)) return;
+        g_idle = true;
+        g_idle_since_ms = now;
+        g_last_loop_ms = now;
+        g_stats.idle_entries++;
+        #if POWER_IDLE_WIFI_MAX_MODEM
+        if (esp_wifi_get_ps(&g_wifi_ps_before_idle) != ESP_OK) g_wifi_ps_before_idle = WIFI_PS_NONE;
+        WiFi.setSleep(WIFI_PS_MAX_MODEM);
+        #endif
+        set_touch_gpio_wake(true);
+        Logger.logMessagef("Power", "Idle: %d-%u MHz, light sleep %s",
+            (int)POWER_IDLE_MIN_FREQ_MHZ, (unsigned)g_max_mhz, g_light_sleep ? "on" : "off");
+        return;
+    }
+
+    // The pass that handles the wake ran after this gap.
+    g_stats.last_wake_gap_ms = now - g_last_loop_ms;
+    g_stats.idle_ms += now - g_idle_since_ms;
+    g_idle = false;
+    set_touch_gpio_wake(false);
+    #if POWER_IDLE_WIFI_MAX_MODEM
+    WiFi.setSleep(g_wifi_ps_before_idle);
+    #endif
+    configure(false);
+    Logger.logMessage("Power", "Active: full clock");
+}
+
+void power_manager_hold(PowerActivity activity, uint32_t ms) {
+    const size_t i = (size_t)activity;
+    if (i >= (size_t)PowerActivity::Count) return;
+    const uint32_t until = millis() + ms;
+
+    bool acquire = false;
+    portENTER_CRITICAL(&g_mux);
+    if (!g_timed_held[i]) {
+        g_timed_held[i] = true;
+        acquire = true;
+        g_stats.holds++;
+    }
+    if (acquire || (int32_t)(until - g_timed_until_ms[i]) > 0) g_timed_until_ms[i] = until;
+    portEXIT_CRITICAL(&g_mux);
+
+    if (acquire) lock_acquire(activity);
+}
+
+void power_manager_acquire(PowerActivity activity) {
+    if ((size_t)activity >= (size_t)PowerActivity::Count) return;
+    portENTER_CRITICAL(&g_mux);
+    g_stats.holds++;
+    portEXIT_CRITICAL(&g_mux);
+    lock_acquire(activity);
+}
+
+void power_manager_release(PowerActivity activity) {
+    if ((size_t)activity >= (size_t)PowerActivity::Count) return;
+    lock_release(activity);
+}
+
+void power_manager_get_stats(PowerStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_mux);
+    out->light_sleep = g_light_sleep && g_idle;
+    out->idle = g_idle;
+    out->cpu_freq_mhz = getCpuFrequencyMhz();
+    if (g_idle) out->idle_ms += millis() - g_idle_since_ms;
+}
+
+#endif // POWER_IDLE_ENABLED
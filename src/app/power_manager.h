@@ -0,0 +1,66 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include "board_config.h"
+
+// Power Manager
+// While the screen saver is asleep (and POWER_IDLE_ENABLED), lets esp_pm scale
+// the CPU clock down to POWER_IDLE_MIN_FREQ_MHZ and, where the core was built
+// with tickless idle, enter automatic light sleep. Network and BLE work holds
+// PM locks so requests still run at full clock. Awake, the clock stays fixed.
+
+#include <Arduino.h>
+
+enum class PowerActivity : uint8_t {
+    Http = 0,
+    Mqtt = 1,
+    Ble = 2,
+    Count,
+};
+
+struct PowerStats {
+    bool supported;            // core built with CONFIG_PM_ENABLE
+    bool light_sleep;          // automatic light sleep configured while idle
+    bool idle;                 // idle power mode active now
+    uint32_t cpu_freq_mhz;     // clock at the time of the call
+    uint32_t idle_entries;
+    uint32_t idle_ms;          // total time in idle mode (including the current stretch)
+    uint32_t holds;            // activity holds taken (timed and counted)
+    // Longest stall between two loop() passes while idle: the extra latency idle
+    // mode adds to a touch wake (touch and wake requests are handled per pass).
+    uint32_t idle_loop_gap_max_ms;
+    uint32_t last_wake_gap_ms;  // loop gap right before the last wake
+};
+
+#if POWER_IDLE_ENABLED
+
+void power_manager_init();
+// Call from loop(): expires timed holds and measures idle loop gaps.
+void power_manager_loop();
+
+// Screen saver: enter (true) or leave (false) the idle power mode.
+void power_manager_set_idle(bool idle);
+
+// Keep full clock and no light sleep for ms (any task; extends a running hold).
+void power_manager_hold(PowerActivity activity, uint32_t ms);
+// Counted variant for work of unknown length (pair every acquire with a release).
+void power_manager_acquire(PowerActivity activity);
+void power_manager_release(PowerActivity activity);
+
+void power_manager_get_stats(PowerStats* out);
+
+#else
+
+inline void power_manager_init() {}
+inline void power_manager_loop() {}
+inline void power_manager_set_idle(bool) {}
+inline void power_manager_hold(PowerActivity, uint32_t) {}
+inline void power_manager_acquire(PowerActivity) {}
+inline void power_manager_release(PowerActivity) {}
+inline void power_manager_get_stats(PowerStats* out) {
+    if (out) *out = {};
+}
+
+#endif // POWER_IDLE_ENABLED
+
+#endif // POWER_MANAGER_H
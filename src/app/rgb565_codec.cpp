@@ -0,0 +1,71 @@
+/*
+ * RGB565 Rectangle Codecs Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "rgb565_codec.h"
+#include "pixel_codec.h"
+#include <stdio.h>
+#include <string.h>
+
+bool rgb565_parse_encoding(const char* name, Rgb565Encoding* out) {
+    if (!name || !out) return false;
+    if (name[0] == '\0' || strcmp(name, "raw") == 0) {
+        *out = RGB565_ENCODING_RAW;
+    } else if (strcmp(name, "rle") == 0) {
+        *out = RGB565_ENCODING_RLE;
+    } else if (strcmp(name, "lz4") == 0) {
+        *out = RGB565_ENCODING_LZ4;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* rgb565_encoding_name(Rgb565Encoding enc) {
+    switch (enc) {
+        case RGB565_ENCODING_RLE: return "rle";
+        case RGB565_ENCODING_LZ4: return "lz4";
+        default: return "raw";
+    }
+}
+
+bool rgb565_decode(
+    Rgb565Encoding enc,
+    const uint8_t* src,
+    size_t src_len,
+    uint16_t* dst,
+    size_t dst_pixels,
+    char* err,
+    size_t err_sz
+) {
+    if (!src || !dst || dst_pixels == 0) {
+        snprintf(err, err_sz, "Invalid buffers");
+        return false;
+    }
+
+    uint8_t* out = (uint8_t*)dst;
+    const size_t out_len = dst_pixels * 2;
+
+    switch (enc) {
+        case RGB565_ENCODING_RAW:
+            if (src_len != out_len) {
+                snprintf(err, err_sz, "Raw size mismatch (%u bytes, expected %u)", (unsigned)src_len, (unsigned)out_len);
+                return false;
+            }
+            memcpy(out, src, out_len);
+            return true;
+        case RGB565_ENCODING_RLE:
+            return pixel_rle_decode(src, src_len, out, out_len, 2, err, err_sz);
+        case RGB565_ENCODING_LZ4:
+            return pixel_lz4_decode(src, src_len, out, out_len, err, err_sz);
+        default:
+            snprintf(err, err_sz, "Unknown encoding");
+            return false;
+    }
+}
+
+#endif // HAS_IMAGE_API
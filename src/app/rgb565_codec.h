@@ -0,0 +1,48 @@
+/*
+ * RGB565 Rectangle Codecs
+ *
+ * Decoders for pre-rendered pixel rectangles uploaded to
+ * /api/display/image/raw. Pixels stay in the byte order they were sent in;
+ * the decoders only move bytes, so the result can go straight to pushColors().
+ *
+ * Encodings:
+ *   raw - w*h 16-bit pixels
+ *   rle - PackBits over 16-bit pixels: control byte c < 0x80 is followed by
+ *         c+1 literal pixels; c >= 0x80 is followed by one pixel repeated
+ *         (c - 0x80) + 2 times
+ *   lz4 - one LZ4 block (no frame header) of the raw pixels
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum Rgb565Encoding : uint8_t {
+    RGB565_ENCODING_RAW = 0,
+    RGB565_ENCODING_RLE,
+    RGB565_ENCODING_LZ4,
+};
+
+// Parse an encoding name ("raw", "rle", "lz4"). Returns false if unknown.
+bool rgb565_parse_encoding(const char* name, Rgb565Encoding* out);
+
+const char* rgb565_encoding_name(Rgb565Encoding enc);
+
+// Decode exactly dst_pixels pixels from src into dst.
+// Returns false (with a message in err) on malformed or short input.
+bool rgb565_decode(
+    Rgb565Encoding enc,
+    const uint8_t* src,
+    size_t src_len,
+    uint16_t* dst,
+    size_t dst_pixels,
+    char* err,
+    size_t err_sz
+);
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,65 @@
+/*
+ * RGB888 -> RGB565 Pack Kernels Implementation
+ */
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include "rgb888_pack.h"
+
+#include <string.h>
+
+template <bool BGR, bool SWAP>
+static inline uint32_t pack_one(uint32_t r, uint32_t g, uint32_t b) {
+    const uint32_t hi = BGR ? b : r;
+    const uint32_t lo = BGR ? r : b;
+    const uint32_t v = ((hi & 0xF8) << 8) | ((g & 0xFC) << 3) | (lo >> 3);
+    return SWAP ? (((v & 0xFF) << 8) | (v >> 8)) : v;
+}
+
+template <bool BGR, bool SWAP>
+static void pack_run(const uint8_t* src, uint16_t* dst, size_t n) {
+#if IMAGE_PACK_UNROLLED
+    if ((((uintptr_t)src | (uintptr_t)dst) & 3) == 0) {
+        // Little-endian words: w0 = r0 g0 b0 r1, w1 = g1 b1 r2 g2, w2 = b2 r3 g3 b3.
+        // The memcpy()s compile to single aligned l32i/s32i.
+        const uint8_t* s = (const uint8_t*)__builtin_assume_aligned(src, 4);
+        uint16_t* d = (uint16_t*)__builtin_assume_aligned(dst, 4);
+        while (n >= 4) {
+            uint32_t w[3];
+            memcpy(w, s, sizeof(w));
+
+            const uint32_t p0 = pack_one<BGR, SWAP>(w[0] & 0xFF, (w[0] >> 8) & 0xFF, (w[0] >> 16) & 0xFF);
+            const uint32_t p1 = pack_one<BGR, SWAP>(w[0] >> 24, w[1] & 0xFF, (w[1] >> 8) & 0xFF);
+            const uint32_t p2 = pack_one<BGR, SWAP>((w[1] >> 16) & 0xFF, w[1] >> 24, w[2] & 0xFF);
+            const uint32_t p3 = pack_one<BGR, SWAP>((w[2] >> 8) & 0xFF, (w[2] >> 16) & 0xFF, w[2] >> 24);
+
+            const uint32_t out[2] = {p0 | (p1 << 16), p2 | (p3 << 16)};
+            memcpy(d, out, sizeof(out));
+
+            s += 12;
+            d += 4;
+            n -= 4;
+        }
+        src = s;
+        dst = d;
+    }
+#endif
+
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = (uint16_t)pack_one<BGR, SWAP>(src[0], src[1], src[2]);
+        src += 3;
+    }
+}
+
+Rgb888PackFn rgb888_pack_kernel(bool bgr, bool byte_swap) {
+    if (bgr) return byte_swap ? pack_run<true, true> : pack_run<true, false>;
+    return byte_swap ? pack_run<false, true> : pack_run<false, false>;
+}
+
+const char* rgb888_pack_kernel_name() {
+    return IMAGE_PACK_UNROLLED ? "unrolled" : "scalar";
+}
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,32 @@
+/*
+ * RGB888 -> RGB565 Pack Kernels
+ *
+ * TJpgDec hands its output callbacks runs of RGB888 triplets. These kernels
+ * pack a run into 16-bit pixels in one of four layouts (RGB565 or BGR565,
+ * native or byte-swapped). Pick the kernel once per decode so the inner loop
+ * carries no per-pixel branches.
+ *
+ * With IMAGE_PACK_UNROLLED the kernels convert four pixels per step from
+ * three 32-bit loads and two 32-bit stores when both pointers are
+ * word-aligned, falling back to one pixel at a time otherwise.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#if HAS_IMAGE_API
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pack n pixels (3 * n source bytes) into dst.
+typedef void (*Rgb888PackFn)(const uint8_t* src, uint16_t* dst, size_t n);
+
+// bgr: BGR565 instead of RGB565. byte_swap: MSB first (big-endian wire order).
+Rgb888PackFn rgb888_pack_kernel(bool bgr, bool byte_swap);
+
+// "unrolled" or "scalar" (for /api/display/image/stats).
+const char* rgb888_pack_kernel_name();
+
+#endif // HAS_IMAGE_API
@@ -0,0 +1,693 @@
+#include "screen_capture.h"
+
+#if HAS_DISPLAY && SCREEN_CAPTURE_ENABLED
+
+#include <ESPAsyncWebServer.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+
+#include "display_driver.h"
+#include "display_manager.h"
+#include "heap_placement.h"
+#include "log_manager.h"
+#include "loop_scheduler.h"
+#include "web_portal_admission.h"
+#include "web_portal_auth.h"
+
+namespace {
+
+enum class Source : uint8_t {
+    None,     // driver cannot be read back
+    Shadow,   // Direct driver: flushes copied into g_shadow
+    Driver,   // Buffered driver: DisplayDriver::readRect()
+};
+
+constexpr uint8_t kEncRaw = 0;
+constexpr uint8_t kEncRle = 1;
+
+constexpr uint32_t kLockWaitMs = 5;     // screenshot chunk / mirror tick; else try later
+constexpr uint32_t kContinueMs = 20;    // next message of a change larger than one
+constexpr uint16_t kDriverRows = 4;     // rows read per LVGL mutex hold (Driver)
+
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+ScreenCaptureStats g_stats = {};
+
+// Set by screen_capture_init().
+DisplayDriver* g_driver = nullptr;
+Source g_source = Source::None;
+uint16_t g_w = 0;
+uint16_t g_h = 0;
+uint8_t g_rotation = 0;
+bool g_swap = false;   // source pixels are host-endian
+
+// Requests from other tasks, applied by screen_capture_lvgl_poll().
+volatile bool g_arm_request = false;
+volatile bool g_arm_failed = false;
+volatile uint32_t g_last_use_ms = 0;
+volatile bool g_shot_busy = false;
+volatile bool g_mirror_on = false;
+volatile bool g_direct_image = false;
+
+// Written with the LVGL mutex held; the volatile ones are read as hints elsewhere.
+volatile bool g_armed = false;
+volatile bool g_valid = false;   // the source holds a complete frame
+uint16_t* g_shadow = nullptr;
+bool g_need_fill = false;
+volatile uint8_t g_frozen = 0;   // screenshots reading the shadow (g_mux)
+lv_area_t g_skipped;             // flushed while frozen: redrawn afterwards
+bool g_skipped_valid = false;
+lv_area_t g_dirty;               // changed since the last mirror message
+volatile bool g_dirty_valid = false;
+uint32_t g_frame_tap_us = 0;
+
+void area_union(lv_area_t* acc, bool valid, const lv_area_t& a) {
+    if (!valid) {
+        *acc = a;
+        return;
+    }
+    if (a.x1 < acc->x1) acc->x1 = a.x1;
+    if (a.y1 < acc->y1) acc->y1 = a.y1;
+    if (a.x2 > acc->x2) acc->x2 = a.x2;
+    if (a.y2 > acc->y2) acc->y2 = a.y2;
+}
+
+bool area_clip(const lv_area_t& in, lv_area_t* out) {
+    out->x1 = in.x1 < 0 ? 0 : in.x1;
+    out->y1 = in.y1 < 0 ? 0 : in.y1;
+    out->x2 = in.x2 >= g_w ? (lv_coord_t)(g_w - 1) : in.x2;
+    out->y2 = in.y2 >= g_h ? (lv_coord_t)(g_h - 1) : in.y2;
+    return out->x1 <= out->x2 && out->y1 <= out->y2;
+}
+
+// Worst case for one encoded row of n pixels (rle: one control byte per 128 literals).
+size_t worst_row(uint16_t n) {
+    return (size_t)n * 2 + (n + 127) / 128;
+}
+
+inline void put_px(uint8_t* out, uint16_t v) {
+    if (g_swap) v = __builtin_bswap16(v);
+    memcpy(out, &v, sizeof(v));
+}
+
+// One row as big-endian RGB565; returns the bytes written.
+size_t encode_row(const uint16_t* px, uint16_t n, uint8_t enc, uint8_t* out) {
+    size_t o = 0;
+    if (enc == kEncRaw) {
+        for (uint16_t i = 0; i < n; i++, o += 2) put_px(out + o, px[i]);
+        return o;
+    }
+
+    uint16_t i = 0;
+    while (i < n) {
+        uint16_t run = 1;
+        while (i + run < n && run < 129 && px[i + run] == px[i]) run++;
+        if (run >= 2) {
+            out[o++] = (uint8_t)(0x80 + run - 2);
+            put_px(out + o, px[i]);
+            o += 2;
+            i += run;
+            continue;
+        }
+
+        // Literals up to the next pair (which starts a run) or 128.
+        const uint16_t start = i;
+        uint16_t lit = 0;
+        while (i < n && lit < 128) {
+            if (i + 1 < n && px[i + 1] == px[i]) break;
+            i++;
+            lit++;
+        }
+        out[o++] = (uint8_t)(lit - 1);
+        for (uint16_t k = 0; k < lit; k++, o += 2) put_px(out + o, px[start + k]);
+    }
+    return o;
+}
+
+void request_arm() {
+    g_last_use_ms = millis();
+    if (!g_armed) {
+        g_arm_failed = false;
+        g_arm_request = true;
+    }
+    display_manager_request_render();
+}
+
+// LVGL task.
+void arm() {
+    if (g_source == Source::Shadow && !g_shadow) {
+        g_shadow = (uint16_t*)heap_place_malloc(HeapClass::Bulk, HeapTag::Display, (size_t)g_w * g_h * sizeof(uint16_t));
+        if (!g_shadow) {
+            Logger.logMessagef("Capture", "ERROR: no memory for a %ux%u shadow framebuffer", (unsigned)g_w, (unsigned)g_h);
+            g_arm_failed = true;
+            return;
+        }
+    }
+    g_skipped_valid = false;
+    g_dirty_valid = false;
+    g_need_fill = (g_source == Source::Shadow);
+    g_valid = (g_source == Source::Driver);
+    g_armed = true;
+    Logger.logMessage("Capture", "Armed");
+}
+
+// LVGL task.
+void disarm() {
+    g_armed = false;
+    g_valid = false;
+    g_need_fill = false;
+    g_skipped_valid = false;
+    g_dirty_valid = false;
+    if (g_shadow) {
+        heap_tag_free(HeapTag::Display, g_shadow);
+        g_shadow = nullptr;
+    }
+    Logger.logMessage("Capture", "Idle");
+}
+
+// LVGL task. Areas are in flush coordinates; a rotated software render has
+// to be invalidated as a whole.
+void invalidate(const lv_area_t& a) {
+    if (g_rotation) {
+        lv_obj_invalidate(lv_scr_act());
+    } else {
+        _lv_inv_area(lv_disp_get_default(), &a);
+    }
+}
+
+void copy_to_shadow(const lv_area_t* area, const lv_color_t* pixels) {
+    lv_area_t c;
+    if (!area_clip(*area, &c)) return;
+    const size_t aw = (size_t)(area->x2 - area->x1 + 1);
+    const size_t cw = (size_t)(c.x2 - c.x1 + 1) * sizeof(uint16_t);
+    const uint16_t* src = (const uint16_t*)pixels + (size_t)(c.y1 - area->y1) * aw + (c.x1 - area->x1);
+    for (lv_coord_t y = c.y1; y <= c.y2; y++, src += aw) {
+        memcpy(g_shadow + (size_t)y * g_w + c.x1, src, cw);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Screenshot (AsyncTCP task)
+// ---------------------------------------------------------------------------
+
+struct Shot {
+    uint8_t enc;
+    bool streaming;
+    bool frozen;        // holds a g_frozen count
+    bool failed;
+    uint32_t start_ms;
+    uint16_t row;       // next row to encode
+    uint16_t* pixels;   // Driver: kDriverRows rows
+    uint16_t pix_rows;
+    uint16_t pix_next;
+    uint8_t* carry;     // encoded row not yet sent in full
+    size_t carry_len;
+    size_t carry_off;
+    uint32_t bytes;
+    uint32_t us;
+};
+
+Shot g_shot = {};
+
+void shot_free(Shot& s) {
+    if (s.pixels) heap_tag_free(HeapTag::Display, s.pixels);
+    if (s.carry) heap_tag_free(HeapTag::Display, s.carry);
+    s = Shot{};
+}
+
+size_t shot_fill(uint8_t* buf, size_t max) {
+    Shot& s = g_shot;
+    if (s.failed) return 0;
+
+    if (!s.streaming) {
+        if (g_arm_failed || millis() - s.start_ms > SCREEN_CAPTURE_WAIT_MS) {
+            s.failed = true;
+            return 0;
+        }
+        if (!g_armed || !g_valid) return RESPONSE_TRY_AGAIN;
+        if (g_source == Source::Shadow) {
+            // Frozen under the mutex, so no flush is halfway through a copy.
+            if (!display_manager_try_lock(kLockWaitMs)) return RESPONSE_TRY_AGAIN;
+            const bool ok = g_armed && g_valid;
+            if (ok) {
+                portENTER_CRITICAL(&g_mux);
+                g_frozen++;
+                portEXIT_CRITICAL(&g_mux);
+            }
+            display_manager_unlock();
+            if (!ok) return RESPONSE_TRY_AGAIN;
+            s.frozen = true;
+        }
+        s.streaming = true;
+    }
+
+    const uint32_t t0 = micros();
+    size_t n = 0;
+    bool locked = false;
+    while (n < max) {
+        if (s.carry_off < s.carry_len) {
+            size_t take = s.carry_len - s.carry_off;
+            if (take > max - n) take = max - n;
+            memcpy(buf + n, s.carry + s.carry_off, take);
+            s.carry_off += take;
+            n += take;
+            continue;
+        }
+        if (s.row >= g_h) break;
+
+        const uint16_t* src;
+        if (g_source == Source::Shadow) {
+            src = g_shadow + (size_t)s.row * g_w;
+        } else {
+            if (s.pix_next >= s.pix_rows) {
+                if (!locked) {
+                    if (!display_manager_try_lock(kLockWaitMs)) break;
+                    locked = true;
+                }
+                const uint16_t rows = (g_h - s.row) < kDriverRows ? (uint16_t)(g_h - s.row) : kDriverRows;
+                if (!g_driver->readRect(0, (int16_t)s.row, g_w, rows, s.pixels)) {
+                    s.failed = true;
+                    break;
+                }
+                s.pix_rows = rows;
+                s.pix_next = 0;
+            }
+            src = s.pixels + (size_t)s.pix_next++ * g_w;
+        }
+        s.carry_len = encode_row(src, g_w, s.enc, s.carry);
+        s.carry_off = 0;
+        s.row++;
+    }
+    if (locked) display_manager_unlock();
+    s.us += micros() - t0;
+    s.bytes += n;
+
+    // Mutex busy: nothing this time, but not done.
+    if (n == 0 && !s.failed && s.row < g_h) return RESPONSE_TRY_AGAIN;
+    return n;
+}
+
+// Request end: sent, or the client left.
+void shot_end() {
+    Shot& s = g_shot;
+    const bool done = !s.failed && s.row >= g_h && s.carry_off >= s.carry_len;
+    if (s.frozen) {
+        portENTER_CRITICAL(&g_mux);
+        g_frozen--;
+        portEXIT_CRITICAL(&g_mux);
+        display_manager_request_render();   // redraw what was skipped
+    }
+
+    portENTER_CRITICAL(&g_mux);
+    if (done) {
+        g_stats.screenshots++;
+        g_stats.screenshot_bytes_last = s.bytes;
+        g_stats.screenshot_us_last = s.us;
+    } else {
+        g_stats.screenshots_failed++;
+    }
+    portEXIT_CRITICAL(&g_mux);
+
+    shot_free(s);
+    g_last_use_ms = millis();
+    g_shot_busy = false;
+}
+
+void send_error(AsyncWebServerRequest* request, int code, const char* message) {
+    char body[128];
+    snprintf(body, sizeof(body), "{\"success\":false,\"message\":\"%s\"}", message);
+    AsyncWebServerResponse* response = request->beginResponse(code, "application/json", body);
+    if (code == 503) response->addHeader("Retry-After", "1");
+    request->send(response);
+}
+
+void handle_screenshot(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+    uint8_t enc = kEncRle;
+    if (request->hasParam("encoding")) {
+        const String& v = request->getParam("encoding")->value();
+        if (v == "raw") {
+            enc = kEncRaw;
+        } else if (v != "rle") {
+            send_error(request, 400, "encoding must be raw or rle");
+            return;
+        }
+    }
+
+    if (g_source == Source::None) {
+        send_error(request, 501, "This display cannot be captured");
+        return;
+    }
+    if (g_source == Source::Shadow && g_direct_image) {
+        send_error(request, 409, "A direct image is showing");
+        return;
+    }
+    if (g_source == Source::Shadow && !g_valid && displayManager && displayManager->isRenderSuspended()) {
+        send_error(request, 503, "Display is asleep");
+        return;
+    }
+    if (g_shot_busy) {
+        portENTER_CRITICAL(&g_mux);
+        g_stats.screenshots_busy++;
+        portEXIT_CRITICAL(&g_mux);
+        send_error(request, 503, "Screenshot in progress");
+        return;
+    }
+
+    g_shot_busy = true;
+    Shot& s = g_shot;
+    s = Shot{};
+    s.enc = enc;
+    s.start_ms = millis();
+    s.carry = (uint8_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Display, worst_row(g_w));
+    if (g_source == Source::Driver) {
+        s.pixels = (uint16_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Display, (size_t)g_w * kDriverRows * sizeof(uint16_t));
+    }
+    if (!s.carry || (g_source == Source::Driver && !s.pixels) || !portal_on_request_end(request, []() { shot_end(); })) {
+        shot_free(s);
+        portENTER_CRITICAL(&g_mux);
+        g_stats.screenshots_failed++;
+        portEXIT_CRITICAL(&g_mux);
+        g_shot_busy = false;
+        send_error(request, 503, "Out of memory");
+        return;
+    }
+
+    request_arm();
+
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        "application/octet-stream",
+        [](uint8_t* buffer, size_t maxLen, size_t) -> size_t { return shot_fill(buffer, maxLen); }
+    );
+    response->addHeader("Cache-Control", "no-store");
+    response->addHeader("X-Screen-Width", String((unsigned)g_w));
+    response->addHeader("X-Screen-Height", String((unsigned)g_h));
+    response->addHeader("X-Screen-Rotation", String((unsigned)g_rotation));
+    response->addHeader("X-Pixel-Format", "rgb565be");
+    response->addHeader("X-Encoding", enc == kEncRaw ? "raw" : "rle");
+    request->send(response);
+}
+
+// ---------------------------------------------------------------------------
+// Mirror (events on AsyncTCP, messages from the loop task)
+// ---------------------------------------------------------------------------
+
+#if SCREEN_MIRROR_FPS > 0
+AsyncWebSocket g_ws("/api/display/mirror");
+volatile bool g_mirror_resync = false;   // a client joined: send everything
+uint8_t* g_msg = nullptr;
+size_t g_msg_cap = 0;
+uint16_t* g_mirror_px = nullptr;         // Driver: one row
+uint16_t g_seq = 0;
+
+void mirror_event(AsyncWebSocket*, AsyncWebSocketClient* client, AwsEventType type, void*, uint8_t*, size_t) {
+    if (type == WS_EVT_CONNECT) {
+        char info[112];
+        snprintf(info, sizeof(info),
+                 "{\"width\":%u,\"height\":%u,\"rotation\":%u,\"format\":\"rgb565be\",\"encoding\":\"rle\"}",
+                 (unsigned)g_w, (unsigned)g_h, (unsigned)g_rotation);
+        client->text(info);
+        g_mirror_resync = true;
+        Logger.logMessagef("Capture", "Mirror client #%u from %s", (unsigned)client->id(), client->remoteIP().toString().c_str());
+        loop_scheduler_notify();
+    } else if (type == WS_EVT_DISCONNECT) {
+        loop_scheduler_notify();
+    }
+}
+
+void mirror_free() {
+    if (g_msg) heap_tag_free(HeapTag::Display, g_msg);
+    if (g_mirror_px) heap_tag_free(HeapTag::Display, g_mirror_px);
+    g_msg = nullptr;
+    g_mirror_px = nullptr;
+    g_msg_cap = 0;
+}
+
+bool mirror_alloc() {
+    if (g_msg) return true;
+    // Always room for one full row, whatever SCREEN_MIRROR_MAX_BYTES says.
+    size_t cap = SCREEN_MIRROR_MAX_BYTES;
+    if (cap < worst_row(g_w)) cap = worst_row(g_w);
+    cap += sizeof(ScreenMirrorHeader);
+    g_msg = (uint8_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Display, cap);
+    if (g_source == Source::Driver) {
+        g_mirror_px = (uint16_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Display, (size_t)g_w * sizeof(uint16_t));
+    }
+    if (!g_msg || (g_source == Source::Driver && !g_mirror_px)) {
+        mirror_free();
+        return false;
+    }
+    g_msg_cap = cap;
+    return true;
+}
+#endif // SCREEN_MIRROR_FPS > 0
+
+} // namespace
+
+void screen_capture_init(DisplayDriver* driver, const lv_disp_drv_t* drv) {
+    g_driver = driver;
+    g_w = (uint16_t)drv->hor_res;
+    g_h = (uint16_t)drv->ver_res;
+    g_rotation = 0;
+
+    if (driver->renderMode() == DisplayDriver::RenderMode::Direct) {
+        g_source = Source::Shadow;
+        g_swap = !LV_COLOR_16_SWAP;
+        // Software rotation hands the flush panel coordinates.
+        if (drv->sw_rotate && drv->rotated != LV_DISP_ROT_NONE) {
+            g_rotation = (uint8_t)drv->rotated;
+            if (drv->rotated == LV_DISP_ROT_90 || drv->rotated == LV_DISP_ROT_270) {
+                g_w = (uint16_t)drv->ver_res;
+                g_h = (uint16_t)drv->hor_res;
+            }
+        }
+    } else {
+        uint16_t probe = 0;
+        g_source = driver->readRect(0, 0, 1, 1, &probe) ? Source::Driver : Source::None;
+        g_swap = true;
+    }
+
+    static const char* const kSourceNames[] = {"none", "shadow", "driver"};
+    Logger.logMessagef("Capture", "%ux%u from %s", (unsigned)g_w, (unsigned)g_h, kSourceNames[(size_t)g_source]);
+}
+
+void screen_capture_lvgl_poll(bool direct_image_active) {
+    if (g_source == Source::None) return;
+    g_direct_image = direct_image_active;
+
+    if (g_arm_request) {
+        g_arm_request = false;
+        if (!g_armed) arm();
+    }
+    if (!g_armed) return;
+
+    if (!g_shot_busy && !g_mirror_on && g_frozen == 0 && millis() - g_last_use_ms > SCREEN_CAPTURE_LINGER_MS) {
+        disarm();
+        return;
+    }
+    if (g_source != Source::Shadow) return;
+
+    // A direct image goes to the panel around LVGL: fill again once it is gone.
+    if (direct_image_active) {
+        g_valid = false;
+        g_need_fill = true;
+        return;
+    }
+    if (g_frozen) return;
+
+    if (g_need_fill) {
+        // The tap copies every area of this refresh, so the shadow is whole after it.
+        g_need_fill = false;
+        g_skipped_valid = false;
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+        g_valid = true;
+        portENTER_CRITICAL(&g_mux);
+        g_stats.fills++;
+        portEXIT_CRITICAL(&g_mux);
+        return;
+    }
+    if (g_skipped_valid) {
+        g_skipped_valid = false;
+        invalidate(g_skipped);
+    }
+}
+
+void screen_capture_flush_tap(lv_disp_drv_t* drv, const lv_area_t* area, const lv_color_t* pixels) {
+    if (!g_armed) return;
+    const uint32_t t0 = micros();
+
+    lv_area_t c;
+    if (area_clip(*area, &c)) {
+        if (g_mirror_on) {
+            area_union(&g_dirty, g_dirty_valid, c);
+            g_dirty_valid = true;
+        }
+        if (g_shadow) {
+            if (g_frozen) {
+                area_union(&g_skipped, g_skipped_valid, c);
+                g_skipped_valid = true;
+            } else {
+                copy_to_shadow(area, pixels);
+            }
+        }
+    }
+
+    g_frame_tap_us += micros() - t0;
+    if (lv_disp_flush_is_last(drv)) {
+        portENTER_CRITICAL(&g_mux);
+        g_stats.frames++;
+        g_stats.tap_us_last = g_frame_tap_us;
+        if (g_frame_tap_us > g_stats.tap_us_max) g_stats.tap_us_max = g_frame_tap_us;
+        portEXIT_CRITICAL(&g_mux);
+        g_frame_tap_us = 0;
+    }
+}
+
+void screen_capture_register_routes(AsyncWebServer& server) {
+    server.on("/api/display/screenshot", HTTP_GET, handle_screenshot);
+
+#if SCREEN_MIRROR_FPS > 0
+    g_ws.onEvent(mirror_event);
+    // The gate may already have queued a 401 challenge; the library answers 401 either way.
+    g_ws.handleHandshake([](AsyncWebServerRequest* request) {
+        if (!portal_auth_gate(request)) return false;
+        if (g_source == Source::None || g_ws.count() >= SCREEN_MIRROR_MAX_CLIENTS) return false;
+        return true;
+    });
+    server.addHandler(&g_ws);
+#endif
+}
+
+uint32_t screen_capture_poll(uint32_t now_ms) {
+#if SCREEN_MIRROR_FPS > 0
+    g_ws.cleanupClients(SCREEN_MIRROR_MAX_CLIENTS);
+    const size_t clients = g_ws.count();
+    portENTER_CRITICAL(&g_mux);
+    g_stats.mirror_clients = (uint8_t)clients;
+    portEXIT_CRITICAL(&g_mux);
+
+    if (clients == 0) {
+        if (g_mirror_on) {
+            g_mirror_on = false;
+            g_last_use_ms = now_ms;
+            mirror_free();
+        }
+        return LOOP_SCHEDULER_IDLE;
+    }
+
+    constexpr uint32_t kPeriodMs = 1000 / SCREEN_MIRROR_FPS;
+    g_mirror_on = true;
+    g_last_use_ms = now_ms;
+    if (!g_armed) {
+        request_arm();
+        return kPeriodMs;
+    }
+    if (!g_valid || (!g_dirty_valid && !g_mirror_resync)) return kPeriodMs;
+    if (!mirror_alloc()) return kPeriodMs;
+    if (!g_ws.availableForWriteAll()) {
+        portENTER_CRITICAL(&g_mux);
+        g_stats.mirror_dropped++;
+        portEXIT_CRITICAL(&g_mux);
+        return kPeriodMs;
+    }
+    if (!display_manager_try_lock(kLockWaitMs)) return kPeriodMs;
+
+    const uint32_t t0 = micros();
+    if (__atomic_exchange_n(&g_mirror_resync, false, __ATOMIC_ACQ_REL)) {
+        g_dirty.x1 = 0;
+        g_dirty.y1 = 0;
+        g_dirty.x2 = (lv_coord_t)(g_w - 1);
+        g_dirty.y2 = (lv_coord_t)(g_h - 1);
+        g_dirty_valid = true;
+    }
+    if (!g_valid || !g_dirty_valid) {
+        display_manager_unlock();
+        return kPeriodMs;
+    }
+
+    // As many rows of the change as fit in one message; the rest stays dirty.
+    const lv_area_t a = g_dirty;
+    const uint16_t w = (uint16_t)(a.x2 - a.x1 + 1);
+    const size_t worst = worst_row(w);
+    size_t len = sizeof(ScreenMirrorHeader);
+    lv_coord_t y = a.y1;
+    while (y <= a.y2 && len + worst <= g_msg_cap) {
+        const uint16_t* src;
+        if (g_source == Source::Shadow) {
+            src = g_shadow + (size_t)y * g_w + a.x1;
+        } else {
+            if (!g_driver->readRect((int16_t)a.x1, (int16_t)y, w, 1, g_mirror_px)) break;
+            src = g_mirror_px;
+        }
+        len += encode_row(src, w, kEncRle, g_msg + len);
+        y++;
+    }
+    if (y > a.y2) {
+        g_dirty_valid = false;
+    } else {
+        g_dirty.y1 = y;
+    }
+    const bool more = g_dirty_valid;
+    display_manager_unlock();
+    const uint32_t us = micros() - t0;
+
+    if (y == a.y1) return kPeriodMs;
+
+    ScreenMirrorHeader hdr;
+    hdr.version = 1;
+    hdr.encoding = kEncRle;
+    hdr.seq = g_seq++;
+    hdr.x = (uint16_t)a.x1;
+    hdr.y = (uint16_t)a.y1;
+    hdr.w = w;
+    hdr.h = (uint16_t)(y - a.y1);
+    memcpy(g_msg, &hdr, sizeof(hdr));
+    g_ws.binaryAll(g_msg, len);
+
+    portENTER_CRITICAL(&g_mux);
+    g_stats.mirror_messages++;
+    g_stats.mirror_bytes += len;
+    if (us > g_stats.mirror_tick_us_max) g_stats.mirror_tick_us_max = us;
+    portEXIT_CRITICAL(&g_mux);
+
+    return more ? kContinueMs : kPeriodMs;
+#else
+    (void)now_ms;
+    return LOOP_SCHEDULER_IDLE;
+#endif
+}
+
+bool screen_capture_get_stats(ScreenCaptureStats* out) {
+    if (!out) return false;
+    if (g_source == Source::None) {
+        *out = ScreenCaptureStats{};
+        return false;
+    }
+    portENTER_CRITICAL(&g_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_mux);
+    out->armed = g_armed;
+    out->shadow_bytes = g_shadow ? (uint32_t)g_w * g_h * sizeof(uint16_t) : 0;
+    return true;
+}
+
+#else
+
+#include "loop_scheduler.h"
+
+void screen_capture_register_routes(AsyncWebServer&) {
+}
+
+uint32_t screen_capture_poll(uint32_t) {
+    return LOOP_SCHEDULER_IDLE;
+}
+
+bool screen_capture_get_stats(ScreenCaptureStats* out) {
+    if (out) *out = ScreenCaptureStats{};
+    return false;
+}
+
+#endif // HAS_DISPLAY && SCREEN_CAPTURE_ENABLED
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_config.h"
+
+class AsyncWebServer;
+
+// Screen capture (SCREEN_CAPTURE_ENABLED).
+//
+// GET /api/display/screenshot[?encoding=raw|rle] streams the frame LVGL last
+// rendered as a chunked body of RGB565 pixels, most significant byte first,
+// row by row. The size is in the headers (X-Screen-Width, X-Screen-Height);
+// X-Screen-Rotation is the rotation still to apply for panels LVGL rotates in
+// software (0 = as shown). rle is the PackBits format /api/display/image/raw
+// accepts; each row is encoded on its own, so the body decodes as one stream.
+// One screenshot at a time; another gets 503 + Retry-After. A body shorter
+// than the headers promise means no complete frame came up within
+// SCREEN_CAPTURE_WAIT_MS.
+//
+// Direct drivers keep nothing the CPU can read back, so the first capture
+// allocates a shadow framebuffer in PSRAM and forces one full refresh to fill
+// it; from then on each flush copies its area into the shadow before it goes
+// to the panel. A screenshot freezes the shadow while it streams: flushes
+// meanwhile only note their area, which is redrawn once it ends, so the shot
+// never tears and the UI never waits on the client. A direct image bypasses
+// LVGL, so a screenshot during one answers 409.
+//
+// Buffered drivers that implement DisplayDriver::readRect() are read in
+// place, a few rows per chunk under the LVGL mutex.
+//
+// GET /api/display/mirror is a WebSocket (SCREEN_MIRROR_FPS > 0). A client
+// first gets a text message
+//   {"width":w,"height":h,"rotation":r,"format":"rgb565be","encoding":"rle"}
+// then binary messages: a ScreenMirrorHeader and the PackBits rows of one
+// changed rectangle. A new client starts with the whole screen. At most
+// SCREEN_MIRROR_FPS rectangles per second go out, each at most
+// SCREEN_MIRROR_MAX_BYTES; a larger change continues on the next ticks and a
+// client that cannot keep up makes the tick skip (dropped) rather than queue.
+//
+// Capture stays armed SCREEN_CAPTURE_LINGER_MS after the last screenshot or
+// mirror client, then the shadow is freed and flushes cost nothing again.
+
+// Binary mirror message header, little-endian.
+struct __attribute__((packed)) ScreenMirrorHeader {
+    uint8_t version;    // 1
+    uint8_t encoding;   // 0 = raw, 1 = rle
+    uint16_t seq;       // message counter
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+static_assert(sizeof(ScreenMirrorHeader) == 12, "mirror header");
+
+#if HAS_DISPLAY
+#include <lvgl.h>
+
+class DisplayDriver;
+
+// LVGL side, called by DisplayManager with the LVGL mutex held.
+// init: once the display driver is registered.
+void screen_capture_init(DisplayDriver* driver, const lv_disp_drv_t* drv);
+// Each LVGL task cycle before lv_timer_handler(): arms, fills, invalidates.
+void screen_capture_lvgl_poll(bool direct_image_active);
+// Each flush, before the area is handed to the panel.
+void screen_capture_flush_tap(lv_disp_drv_t* drv, const lv_area_t* area, const lv_color_t* pixels);
+#endif
+
+void screen_capture_register_routes(AsyncWebServer& server);
+
+// Loop scheduler entry (register with run_on_event): sends mirror updates and
+// returns the delay until the next one, LOOP_SCHEDULER_IDLE without clients.
+uint32_t screen_capture_poll(uint32_t now_ms);
+
+struct ScreenCaptureStats {
+    bool armed;
+    uint32_t shadow_bytes;       // 0 when not allocated (or Buffered)
+    uint32_t fills;              // full refreshes forced to fill the shadow
+    uint32_t frames;             // frames whose flushes were tapped
+    uint32_t tap_us_last;        // tap time of the last frame, all its flushes
+    uint32_t tap_us_max;
+    uint32_t screenshots;        // completed
+    uint32_t screenshots_failed; // no frame in time, or out of memory
+    uint32_t screenshots_busy;   // refused: one already streaming
+    uint32_t screenshot_bytes_last;
+    uint32_t screenshot_us_last; // read + encode time, excluding the network
+    uint8_t mirror_clients;
+    uint32_t mirror_messages;
+    uint32_t mirror_bytes;
+    uint32_t mirror_dropped;     // ticks skipped: a client still had data queued
+    uint32_t mirror_tick_us_max; // read + encode of one message
+};
+
+// False when capture is compiled out or the display has no capture source.
+bool screen_capture_get_stats(ScreenCaptureStats* out);
@@ -5,6 +5,8 @@
 #include "screen_saver_manager.h"
 #include "log_manager.h"
 #include "display_manager.h"
+#include "power_manager.h"
+#include "loop_scheduler.h"
 
 #if HAS_TOUCH
 #include "touch_manager.h"
@@ -24,6 +26,8 @@ uint32_t g_fade_start_ms = 0;
 uint32_t g_fade_duration_ms = 0;
 uint8_t g_fade_from = 0;
 uint8_t g_fade_to = 0;
+// The driver's PWM peripheral runs the current fade; update_fade() only tracks it.
+bool g_fade_hw = false;
 
 uint8_t g_current_brightness = 100;
 uint8_t g_target_brightness = 100;
@@ -79,6 +83,20 @@ static void apply_brightness(uint8_t brightness) {
     }
 }
 
+static bool start_hw_fade(uint8_t from, uint8_t to, uint16_t duration_ms) {
+    #if BACKLIGHT_HW_FADE_ENABLED
+    if (!displayManager || !displayManager->getDriver()) return false;
+    DisplayDriver* driver = displayManager->getDriver();
+    if (!driver->hasBacklightControl()) return false;
+    return driver->fadeBacklight(from, to, duration_ms);
+    #else
+    (void)from;
+    (void)to;
+    (void)duration_ms;
+    return false;
+    #endif
+}
+
 static void start_fade(ScreenSaverState newState, uint8_t from, uint8_t to, uint16_t duration_ms) {
     g_state = newState;
     g_fade_start_ms = millis();
@@ -86,6 +104,7 @@ static void start_fade(ScreenSaverState newState, uint8_t from, uint8_t to, uint
     g_fade_from = from;
     g_fade_to = to;
     g_target_brightness = to;
+    g_fade_hw = false;
 
     // If duration is 0, apply immediately.
     if (duration_ms == 0) {
@@ -95,8 +114,13 @@ static void start_fade(ScreenSaverState newState, uint8_t from, uint8_t to, uint
         return;
     }
 
-    // Apply the starting brightness right away to avoid a one-loop delay.
     g_current_brightness = from;
+    if (start_hw_fade(from, to, duration_ms)) {
+        g_fade_hw = true;
+        return;
+    }
+
+    // Apply the starting brightness right away to avoid a one-loop delay.
     apply_brightness(from);
 }
 
@@ -105,18 +129,21 @@ static void request_activity(bool wake) {
     g_pending_activity = true;
     g_pending_activity_wake = wake;
     portEXIT_CRITICAL(&g_mux);
+    loop_scheduler_notify();
 }
 
 static void request_wake() {
     portENTER_CRITICAL(&g_mux);
     g_pending_wake = true;
     portEXIT_CRITICAL(&g_mux);
+    loop_scheduler_notify();
 }
 
 static void request_sleep() {
     portENTER_CRITICAL(&g_mux);
     g_pending_sleep = true;
     portEXIT_CRITICAL(&g_mux);
+    loop_scheduler_notify();
 }
 
 static void handle_pending_requests() {
@@ -193,7 +220,9 @@ static void update_fade() {
 
     if (elapsed >= g_fade_duration_ms) {
         g_current_brightness = g_fade_to;
-        apply_brightness(g_fade_to);
+        // The hardware fade has already landed on g_fade_to.
+        if (!g_fade_hw) apply_brightness(g_fade_to);
+        g_fade_hw = false;
         g_state = (g_fade_to == 0) ? ScreenSaverState::Asleep : ScreenSaverState::Awake;
         return;
     }
@@ -207,8 +236,10 @@ static void update_fade() {
 
     const uint8_t newBrightness = (uint8_t)value;
     if (newBrightness != g_current_brightness) {
+        // With a hardware fade this is only an estimate (status, and the start
+        // point if the fade is interrupted).
         g_current_brightness = newBrightness;
-        apply_brightness(newBrightness);
+        if (!g_fade_hw) apply_brightness(newBrightness);
     }
 }
 
@@ -308,6 +339,25 @@ void screen_saver_manager_loop() {
     update_fade();
     maybe_auto_sleep();
 
+    // Idle power mode follows the same Asleep edge (no-op without POWER_IDLE_ENABLED).
+    static bool prev_idle = false;
+    const bool idle = (g_state == ScreenSaverState::Asleep);
+    if (idle != prev_idle) {
+        power_manager_set_idle(idle);
+        prev_idle = idle;
+    }
+
+    #if DISPLAY_SUSPEND_RENDER_ON_SLEEP
+    // Stop rendering into the dark panel once fully asleep; resume as soon as a
+    // wake starts so the first frame is ready while the backlight fades in.
+    static bool prev_suspend = false;
+    const bool suspend = (g_state == ScreenSaverState::Asleep);
+    if (suspend != prev_suspend && displayManager) {
+        displayManager->setRenderSuspended(suspend);
+        prev_suspend = suspend;
+    }
+    #endif
+
     #if HAS_TOUCH
     // While dimming/asleep/fading in, suppress LVGL input so wake gestures don't click-through.
     // This is based on state (not config enabled), so it also protects transitions caused
@@ -334,6 +384,34 @@ void screen_saver_manager_wake() {
     request_wake();
 }
 
+void screen_saver_manager_set_brightness(uint8_t brightness) {
+    if (brightness > 100) brightness = 100;
+
+    // Update the in-RAM target brightness (does not persist to NVS).
+    // This keeps the screen saver target consistent with what the user sees.
+    if (g_config) {
+        g_config->backlight_brightness = brightness;
+    }
+
+    // Edge case: if the screen saver is dimming/asleep/fading, directly setting the
+    // backlight would show the UI again without updating the screen saver state.
+    // Route through the wake path instead; it fades in to the new target.
+    if (g_state != ScreenSaverState::Awake) {
+        request_wake();
+    } else {
+        display_manager_set_backlight_brightness(brightness);
+        request_activity(false);
+    }
+}
+
+uint32_t screen_saver_manager_poll_interval_ms() {
+    // Fades step the backlight in software; asleep we poll touch for wake.
+    if (g_state == ScreenSaverState::FadingOut || g_state == ScreenSaverState::FadingIn) return 10;
+    if (g_state == ScreenSaverState::Asleep) return 20;
+    // Awake: only the inactivity timeout is checked here (requests wake the loop).
+    return 100;
+}
+
 bool screen_saver_manager_is_asleep() {
     return g_state == ScreenSaverState::Asleep || g_state == ScreenSaverState::FadingOut;
 }
@@ -33,6 +33,9 @@ void screen_saver_manager_init(DeviceConfig* config);
 // Call frequently from loop()
 void screen_saver_manager_loop();
 
+// How soon (ms) screen_saver_manager_loop() wants to run again in the current state.
+uint32_t screen_saver_manager_poll_interval_ms();
+
 // Activity resets the inactivity timer; optionally wakes immediately (with fade)
 void screen_saver_manager_notify_activity(bool wake);
 
@@ -40,6 +43,10 @@ void screen_saver_manager_notify_activity(bool wake);
 void screen_saver_manager_sleep_now();
 void screen_saver_manager_wake();
 
+// Set the backlight target (0-100, in RAM only): applied now when awake,
+// otherwise the display wakes and fades in to it.
+void screen_saver_manager_set_brightness(uint8_t brightness);
+
 bool screen_saver_manager_is_asleep();
 ScreenSaverStatus screen_saver_manager_get_status();
 
@@ -64,9 +71,11 @@ struct ScreenSaverStatus {
 
 inline void screen_saver_manager_init(DeviceConfig*) {}
 inline void screen_saver_manager_loop() {}
+inline uint32_t screen_saver_manager_poll_interval_ms() { return 1000; }
 inline void screen_saver_manager_notify_activity(bool) {}
 inline void screen_saver_manager_sleep_now() {}
 inline void screen_saver_manager_wake() {}
+inline void screen_saver_manager_set_brightness(uint8_t) {}
 inline bool screen_saver_manager_is_asleep() { return false; }
 inline ScreenSaverStatus screen_saver_manager_get_status() { return {false, ScreenSaverState::Awake, 0, 0, 0}; }
 
@@ -19,6 +19,7 @@
 #include "screens/error_screen.cpp"
 
 // Macro pad screens (8 fixed screens)
+#include "screens/macropad_styles.cpp"
 #include "screens/macropad_screen.cpp"
 
 // MacroPad layout implementations (one-per-template)
@@ -14,6 +14,12 @@
 #include "../log_manager.h"
 #include <Arduino.h>
 
+#if DISPLAY_TE_SYNC_ENABLED && DISPLAY_TE_SYNC_STRIPS
+static void panel_sync_tearing_effect(void* ctx) {
+    ((DisplayManager*)ctx)->syncTearingEffect();
+}
+#endif
+
 DirectImageScreen::DirectImageScreen(DisplayManager* mgr) 
     : manager(mgr), screen_obj(nullptr), session_active(false), visible(false) {
     // Constructor - member variables initialized in initializer list
@@ -125,6 +131,11 @@ void DirectImageScreen::begin_strip_session(int width, int height) {
     if (manager) {
         decoder.setDisplayDriver(manager->getDriver());
     }
+
+    #if DISPLAY_TE_SYNC_ENABLED && DISPLAY_TE_SYNC_STRIPS
+    // Land each strip on a fresh vertical blank so camera refreshes don't tear.
+    decoder.setPanelSync(manager ? panel_sync_tearing_effect : nullptr, manager);
+    #endif
     
     // Use the display driver's coordinate space (what setAddrWindow expects).
     // This is the fast-path contract for direct-image uploads.
@@ -158,6 +169,64 @@ bool DirectImageScreen::decode_strip(const uint8_t* jpeg_data, size_t jpeg_size,
     return success;
 }
 
+bool DirectImageScreen::decode_stream(ImageStreamReadFn read, void* read_ctx, bool output_bgr565) {
+    if (!session_active) {
+        Logger.logMessage("DirectImageScreen", "ERROR: No active strip session");
+        return false;
+    }
+
+    // Decode while bytes arrive and write directly to LCD
+    bool success = decoder.decode_stream(read, read_ctx, output_bgr565);
+
+    if (!success) {
+        Logger.logMessage("DirectImageScreen", "ERROR: Stream decode failed");
+    }
+
+    return success;
+}
+
+bool DirectImageScreen::decode_fit(const uint8_t* jpeg_data, size_t jpeg_size, ImageStreamReadFn read, void* read_ctx, bool output_bgr565, bool center) {
+    if (!session_active) {
+        Logger.logMessage("DirectImageScreen", "ERROR: No active strip session");
+        return false;
+    }
+
+    bool success = decoder.decode_fit(jpeg_data, jpeg_size, read, read_ctx, output_bgr565, center ? STRIP_FIT_CENTER : STRIP_FIT_TOP_LEFT);
+
+    if (!success) {
+        Logger.logMessage("DirectImageScreen", "ERROR: Scaled decode failed");
+    }
+
+    return success;
+}
+
+bool DirectImageScreen::decode_frame(ImageStreamReadFn read, void* read_ctx, bool output_bgr565) {
+    if (!session_active) {
+        Logger.logMessage("DirectImageScreen", "ERROR: No active strip session");
+        return false;
+    }
+
+    return decoder.decode_frame(read, read_ctx, output_bgr565);
+}
+
+bool DirectImageScreen::decode_tile(const uint8_t* jpeg_data, size_t jpeg_size, int x, int y, bool output_bgr565) {
+    if (!session_active) {
+        Logger.logMessage("DirectImageScreen", "ERROR: No active strip session");
+        return false;
+    }
+
+    return decoder.decode_tile(jpeg_data, jpeg_size, x, y, output_bgr565);
+}
+
+bool DirectImageScreen::push_rect(int x, int y, int w, int h, uint16_t* pixels, bool big_endian) {
+    if (!session_active) {
+        Logger.logMessage("DirectImageScreen", "ERROR: No active strip session");
+        return false;
+    }
+
+    return decoder.push_pixels(x, y, w, h, pixels, big_endian);
+}
+
 void DirectImageScreen::end_strip_session() {
     if (!session_active) return;
     
@@ -41,6 +41,27 @@ public:
     // Decode and display a single strip
     // Returns: true on success, false on failure
     bool decode_strip(const uint8_t* jpeg_data, size_t jpeg_size, int strip_index, bool output_bgr565 = true);
+
+    // Decode and display a full JPEG pulled from a streaming source
+    // Returns: true on success, false on failure
+    bool decode_stream(ImageStreamReadFn read, void* read_ctx, bool output_bgr565 = true);
+
+    // Decode a whole JPEG (buffer, or read != nullptr) scaled down to fit the panel
+    // center: centre it (true) or place it at the top-left corner
+    // Returns: true on success, false on failure
+    bool decode_fit(const uint8_t* jpeg_data, size_t jpeg_size, ImageStreamReadFn read, void* read_ctx, bool output_bgr565, bool center);
+
+    // Decode one frame of a live stream over the previous one (MJPEG)
+    // Returns: true on success, false on failure
+    bool decode_frame(ImageStreamReadFn read, void* read_ctx, bool output_bgr565 = true);
+
+    // Decode a JPEG fragment at (x, y) over the current image (partial update)
+    // Returns: true on success, false on failure
+    bool decode_tile(const uint8_t* jpeg_data, size_t jpeg_size, int x, int y, bool output_bgr565 = true);
+
+    // Write ready-made RGB565 pixels (raw rectangle upload)
+    // Returns: true on success, false on failure
+    bool push_rect(int x, int y, int w, int h, uint16_t* pixels, bool big_endian);
     
     // End strip upload session
     void end_strip_session();
@@ -53,6 +74,9 @@ public:
     
     // Check if timeout expired
     bool is_timeout_expired();
+
+    // True while shown (until hidden or timed out)
+    bool is_visible() const { return visible; }
     
     // Get strip decoder for progress tracking
     StripDecoder* get_decoder() { return &decoder; }
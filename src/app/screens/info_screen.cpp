@@ -4,8 +4,8 @@
 #include "../device_telemetry.h"
 #include "../board_config.h"
 #include "../display_manager.h"
-#include <WiFi.h>
 #include <esp_chip_info.h>
+#include <string.h>
 
 InfoScreen::InfoScreen(DeviceConfig* deviceConfig, DisplayManager* manager) 
     : screen(nullptr), config(deviceConfig), displayMgr(manager),
@@ -129,30 +129,38 @@ void InfoScreen::hide() {
     // Nothing to do - LVGL handles screen switching
 }
 
+// Rewriting a label invalidates its area even when the text is the same;
+// only touch LVGL when the shown text actually changes.
+static void set_text_if_changed(lv_obj_t* label, const char* text) {
+    if (!label) return;
+    if (strcmp(lv_label_get_text(label), text) != 0) {
+        lv_label_set_text(label, text);
+    }
+}
+
 void InfoScreen::update() {
     if (!screen) return;
 
     // This method is called from the LVGL task loop, potentially every 1-10ms.
-    // Avoid constant label rewrites/invalidation: update at a modest cadence.
+    // Every field comes from the shared telemetry snapshot or config and is
+    // formatted into a stack buffer; unchanged fields leave their label alone.
     const uint32_t now = millis();
     const uint32_t kUpdateIntervalMs = 500;
     if (lastUpdateMs != 0 && (uint32_t)(now - lastUpdateMs) < kUpdateIntervalMs) {
         return;
     }
     lastUpdateMs = now;
+
+    DeviceTelemetrySnapshot snap;
+    device_telemetry_get_snapshot(&snap);
     
-    // Update device name (from config)
-    if (deviceNameLabel) {
-        if (strlen(config->device_name) > 0) {
-            lv_label_set_text(deviceNameLabel, config->device_name);
-        } else {
-            lv_label_set_text(deviceNameLabel, "ESP32 Device");
-        }
-    }
+    // Device name (from config)
+    const char* deviceName = (config->device_name[0] != '\0') ? config->device_name : "ESP32 Device";
+    set_text_if_changed(deviceNameLabel, deviceName);
     
-    // Update uptime (formatted)
+    // Uptime (formatted; changes once a minute after the first hour)
     if (uptimeLabel) {
-        unsigned long uptime_sec = millis() / 1000;
+        const unsigned long uptime_sec = now / 1000;
         char uptime_text[32];
         if (uptime_sec < 60) {
             snprintf(uptime_text, sizeof(uptime_text), "%lus", uptime_sec);
@@ -163,36 +171,38 @@ void InfoScreen::update() {
             unsigned long mins = (uptime_sec % 3600) / 60;
             snprintf(uptime_text, sizeof(uptime_text), "%luh %lum", hours, mins);
         }
-        lv_label_set_text(uptimeLabel, uptime_text);
+        set_text_if_changed(uptimeLabel, uptime_text);
     }
     
-    // Update free heap with CPU usage
+    // Free heap with CPU usage
     if (heapLabel) {
         char heap_text[64];
-        unsigned long heap_kb = ESP.getFreeHeap() / 1024;
-        int cpu_usage = device_telemetry_get_cpu_usage();
-        snprintf(heap_text, sizeof(heap_text), "%lu KB free / %d%% CPU", heap_kb, cpu_usage);
-        lv_label_set_text(heapLabel, heap_text);
+        const unsigned long heap_kb = (unsigned long)(snap.mem.heap_free_bytes / 1024);
+        snprintf(heap_text, sizeof(heap_text), "%lu KB free / %d%% CPU", heap_kb, device_telemetry_get_cpu_usage());
+        set_text_if_changed(heapLabel, heap_text);
     }
     
-    // Update IP address
+    // IP address (STA, else SoftAP)
     if (ipLabel) {
-        if (WiFi.status() == WL_CONNECTED) {
-            lv_label_set_text(ipLabel, WiFi.localIP().toString().c_str());
-        } else if (WiFi.getMode() == WIFI_AP) {
-            lv_label_set_text(ipLabel, WiFi.softAPIP().toString().c_str());
+        char ip_text[16];
+        if (snap.ip_v4 != 0) {
+            // IPAddress keeps the first octet in the low byte.
+            snprintf(ip_text, sizeof(ip_text), "%u.%u.%u.%u",
+                (unsigned)(snap.ip_v4 & 0xFF), (unsigned)((snap.ip_v4 >> 8) & 0xFF),
+                (unsigned)((snap.ip_v4 >> 16) & 0xFF), (unsigned)((snap.ip_v4 >> 24) & 0xFF));
         } else {
-            lv_label_set_text(ipLabel, "No IP");
+            strlcpy(ip_text, "No IP", sizeof(ip_text));
         }
+        set_text_if_changed(ipLabel, ip_text);
     }
     
-    // Update mDNS hostname
+    // mDNS hostname
     if (mdnsLabel) {
         char sanitized[CONFIG_DEVICE_NAME_MAX_LEN];
         config_manager_sanitize_device_name(config->device_name, sanitized, sizeof(sanitized));
         char mdns_text[CONFIG_DEVICE_NAME_MAX_LEN + 10];
         snprintf(mdns_text, sizeof(mdns_text), "%s.local", sanitized);
-        lv_label_set_text(mdnsLabel, mdns_text);
+        set_text_if_changed(mdnsLabel, mdns_text);
     }
 }
 
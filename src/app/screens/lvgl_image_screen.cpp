@@ -5,6 +5,10 @@
 #include "lvgl_image_screen.h"
 #include "log_manager.h"
 
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <soc/soc_caps.h>
+
 #if LV_USE_IMG
 
 LvglImageScreen::LvglImageScreen() {
@@ -54,6 +58,7 @@ void LvglImageScreen::create() {
 
 void LvglImageScreen::destroy() {
     freePixelBuf();
+    freeFlipBuffers();
 
     if (scr) {
         lv_obj_del(scr);
@@ -87,8 +92,20 @@ void LvglImageScreen::freePixelBuf() {
     memset(&img_dsc, 0, sizeof(img_dsc));
 }
 
+void LvglImageScreen::freeFlipBuffers() {
+    for (int i = 0; i < 2; i++) {
+        if (flip_buf[i]) heap_caps_free(flip_buf[i]);
+        flip_buf[i] = nullptr;
+        memset(&flip_dsc[i], 0, sizeof(flip_dsc[i]));
+    }
+    flip_capacity = 0;
+    showing_flip = false;
+    flip_claim++;
+}
+
 void LvglImageScreen::clearImage() {
     freePixelBuf();
+    showing_flip = false;
     if (img) {
         lv_img_set_src(img, nullptr);
         #if LV_USE_IMG_TRANSFORM
@@ -113,6 +130,7 @@ bool LvglImageScreen::setImageRgb565(uint16_t* pixels, int w, int h) {
 
     // Replace any previous image.
     freePixelBuf();
+    showing_flip = false;
 
     pixel_buf = pixels;
     pixel_buf_bytes = (size_t)w * (size_t)h * 2;
@@ -124,7 +142,109 @@ bool LvglImageScreen::setImageRgb565(uint16_t* pixels, int w, int h) {
     img_dsc.data_size = pixel_buf_bytes;
     img_dsc.data = (const uint8_t*)pixel_buf;
 
-    lv_img_set_src(img, &img_dsc);
+    applyImage(&img_dsc, w, h);
+    return true;
+}
+
+uint16_t* LvglImageScreen::backBuffer(size_t* capacity_bytes, uint32_t* claim) {
+#if LVGL_IMAGE_DOUBLE_BUFFER && SOC_SPIRAM_SUPPORTED
+    if (flip_unavailable) return nullptr;
+
+    if (!flip_buf[0]) {
+        // Panel-sized: larger JPEGs are decoded at a reduced scale into it.
+        const lv_coord_t hor = lv_disp_get_hor_res(nullptr);
+        const lv_coord_t ver = lv_disp_get_ver_res(nullptr);
+        const size_t bytes = (size_t)(hor > 0 ? hor : 0) * (size_t)(ver > 0 ? ver : 0) * 2;
+        if (bytes == 0 || !psramFound()) {
+            flip_unavailable = true;
+            return nullptr;
+        }
+        flip_buf[0] = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        flip_buf[1] = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        if (!flip_buf[0] || !flip_buf[1]) {
+            Logger.logMessagef("LvglImage", "Double buffering off: 2 x %u bytes not available in PSRAM", (unsigned)bytes);
+            freeFlipBuffers();
+            flip_unavailable = true;
+            return nullptr;
+        }
+        flip_capacity = bytes;
+        Logger.logMessagef("LvglImage", "Double buffering: 2 x %dx%d RGB565 in PSRAM", (int)hor, (int)ver);
+    }
+
+    flip_back = showing_flip ? (uint8_t)(1 - flip_front) : 0;
+    if (capacity_bytes) *capacity_bytes = flip_capacity;
+    if (claim) *claim = ++flip_claim;
+    return flip_buf[flip_back];
+#else
+    (void)capacity_bytes;
+    (void)claim;
+    return nullptr;
+#endif
+}
+
+bool LvglImageScreen::presentBackBuffer(int w, int h, uint32_t claim) {
+    if (!flip_buf[0] || claim != flip_claim) return false;
+    if (w <= 0 || h <= 0 || (size_t)w * (size_t)h * 2 > flip_capacity) return false;
+
+    if (!img) {
+        if (!scr) create();
+    }
+
+    const uint8_t back = flip_back;
+
+    // A malloc'd image from setImageRgb565 is no longer needed.
+    freePixelBuf();
+
+    lv_img_dsc_t* dsc = &flip_dsc[back];
+    dsc->header.always_zero = 0;
+    dsc->header.w = (uint32_t)w;
+    dsc->header.h = (uint32_t)h;
+    dsc->header.cf = LV_IMG_CF_TRUE_COLOR;
+    dsc->data_size = (uint32_t)((size_t)w * (size_t)h * 2);
+    dsc->data = (const uint8_t*)flip_buf[back];
+
+    // The descriptor is reused every other frame; drop any cached header for it.
+    lv_img_cache_invalidate_src(dsc);
+    applyImage(dsc, w, h);
+
+    flip_front = back;
+    showing_flip = true;
+    // Older claims refer to what is now the front buffer.
+    flip_claim++;
+    return true;
+}
+
+void LvglImageScreen::invalidateRows(int y0, int y1) {
+    if (!img || !showing_flip || y1 <= y0) return;
+
+    lv_area_t coords;
+    lv_obj_get_coords(img, &coords);
+    const int32_t w = lv_area_get_width(&coords);
+    const int32_t h = lv_area_get_height(&coords);
+
+    lv_area_t band;
+    #if LV_USE_IMG_TRANSFORM
+    // lv_img zooms around the image centre; map the band through the zoom and
+    // pad a pixel for rounding.
+    const int32_t zoom = lv_img_get_zoom(img);
+    const int32_t cx = coords.x1 + w / 2;
+    const int32_t cy = coords.y1 + h / 2;
+    band.x1 = (lv_coord_t)(cx - (w / 2) * zoom / 256 - 1);
+    band.x2 = (lv_coord_t)(cx + (w - w / 2) * zoom / 256 + 1);
+    band.y1 = (lv_coord_t)(cy + (y0 - h / 2) * zoom / 256 - 1);
+    band.y2 = (lv_coord_t)(cy + (y1 - h / 2) * zoom / 256 + 1);
+    #else
+    band.x1 = coords.x1;
+    band.x2 = coords.x2;
+    band.y1 = (lv_coord_t)(coords.y1 + y0);
+    band.y2 = (lv_coord_t)(coords.y1 + y1 - 1);
+    #endif
+
+    lv_obj_invalidate_area(img, &band);
+}
+
+void LvglImageScreen::applyImage(const lv_img_dsc_t* dsc, int w, int h) {
+    lv_img_set_src(img, dsc);
 
     // Keep it centered inside the fixed 200x200 box.
     if (box) lv_obj_center(img);
@@ -146,7 +266,6 @@ bool LvglImageScreen::setImageRgb565(uint16_t* pixels, int w, int h) {
     if (placeholder) {
         lv_obj_add_flag(placeholder, LV_OBJ_FLAG_HIDDEN);
     }
-    return true;
 }
 
 #endif // LV_USE_IMG
@@ -29,6 +29,24 @@ public:
 
     void clearImage();
 
+    // Double-buffer mode (LVGL_IMAGE_DOUBLE_BUFFER, needs PSRAM): two
+    // panel-sized RGB565 buffers reserved on first use. Decode into the back
+    // buffer without the LVGL lock, then flip it in with presentBackBuffer().
+    // Both calls belong to one writer task (the image worker).
+    //
+    // Returns the back buffer and a claim token, or nullptr when the mode is
+    // unavailable (callers fall back to setImageRgb565).
+    uint16_t* backBuffer(size_t* capacity_bytes, uint32_t* claim);
+
+    // Show the back buffer (w*h RGB565). Call with the LVGL lock held. Fails
+    // when the buffer was claimed again after `claim` (a newer image
+    // overwrote it).
+    bool presentBackBuffer(int w, int h, uint32_t claim);
+
+    // Progressive display: redraw output rows [y0, y1) of the image on screen
+    // after they were written in place. Call with the LVGL lock held.
+    void invalidateRows(int y0, int y1);
+
 private:
     lv_obj_t* scr = nullptr;
     lv_obj_t* box = nullptr;
@@ -40,7 +58,19 @@ private:
     uint16_t* pixel_buf = nullptr;
     size_t pixel_buf_bytes = 0;
 
+    // Double-buffer mode state.
+    uint16_t* flip_buf[2] = {nullptr, nullptr};
+    lv_img_dsc_t flip_dsc[2]{};
+    size_t flip_capacity = 0;
+    uint8_t flip_front = 0;       // buffer on screen while showing_flip
+    uint8_t flip_back = 0;        // buffer handed out by the last backBuffer()
+    bool showing_flip = false;
+    bool flip_unavailable = false;  // reservation failed once; stay on setImageRgb565
+    uint32_t flip_claim = 0;
+
     void freePixelBuf();
+    void freeFlipBuffers();
+    void applyImage(const lv_img_dsc_t* dsc, int w, int h);
 };
 
 #endif // LV_USE_IMG
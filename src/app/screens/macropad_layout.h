@@ -5,6 +5,7 @@
 #include <stdint.h>
 
 #include "../macros_config.h"
+#include "../macro_templates.h"
 
 class DisplayManager;
 
@@ -22,6 +23,59 @@ struct MacroPadLayoutContext {
     lv_obj_t** pieSegments; // length: 8
 };
 
+// Where one slot's button goes; w == 0 hides the slot.
+struct SlotGeometry {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+    int16_t labelW;
+    int16_t radius;
+};
+
+// A template's button geometry for one active display size. Layouts compute it
+// with constexpr builders, so the tables for the compiled DISPLAY_WIDTH x
+// DISPLAY_HEIGHT (and its rotated twin) are built by the compiler; only other
+// sizes are computed at run time.
+struct LayoutGeometry {
+    int16_t width;
+    int16_t height;
+    SlotGeometry slots[MACROS_BUTTONS_PER_SCREEN];
+};
+
+// The compiled table matching w x h, else build(w, h) into a scratch table
+// (valid until the next call; LVGL task only).
+template <typename Geometry>
+const Geometry& selectGeometry(const Geometry& native, const Geometry& rotated, int w, int h, Geometry (*build)(int, int)) {
+    if (native.width == w && native.height == h) return native;
+    if (rotated.width == w && rotated.height == h) return rotated;
+    static Geometry scratch;
+    scratch = build(w, h);
+    return scratch;
+}
+
+// Position, size and show/hide every button; center the labels.
+void applyGeometry(MacroPadLayoutContext& ctx, const LayoutGeometry& g);
+
+// constexpr stand-ins for the libm calls the builders need.
+constexpr float geomClampf(float v, float lo, float hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// lroundf(): half away from zero.
+constexpr int geomRound(float v) {
+    return v < 0.0f ? -(int)(-v + 0.5f) : (int)(v + 0.5f);
+}
+
+// cos/sin of slot i's direction (-90° + i*45°: clockwise from the top, +y down).
+constexpr float kGeomRsqrt2 = 0.70710677f;
+constexpr float geomSlotDirX(int i) {
+    return (i == 2) ? 1.0f : (i == 6) ? -1.0f : (i == 1 || i == 3) ? kGeomRsqrt2 : (i == 5 || i == 7) ? -kGeomRsqrt2 : 0.0f;
+}
+constexpr float geomSlotDirY(int i) {
+    return geomSlotDirX((i + 6) % 8);
+}
+
 class IMacroPadLayout {
 public:
     virtual ~IMacroPadLayout() = default;
@@ -46,6 +100,9 @@ public:
 // Unknown ids resolve to the default layout.
 const IMacroPadLayout& layoutForId(const char* templateId);
 
+// Same, for an id already resolved with macro_templates::resolve().
+const IMacroPadLayout& layoutForKind(macro_templates::TemplateKind kind);
+
 } // namespace macropad_layout
 
 #endif // MACROPAD_LAYOUT_H
@@ -2,8 +2,6 @@
 
 #include "../macro_templates.h"
 
-#include <string.h>
-
 namespace macropad_layout {
 
 // Forward declarations for layout singletons implemented in other translation units.
@@ -13,19 +11,47 @@ const IMacroPadLayout& layout_five_stack();
 const IMacroPadLayout& layout_wide_center();
 const IMacroPadLayout& layout_four_split();
 
-const IMacroPadLayout& layoutForId(const char* templateId) {
-    const char* id = (templateId && templateId[0] != '\0') ? templateId : macro_templates::default_id();
-    if (!macro_templates::is_valid(id)) {
-        id = macro_templates::default_id();
+const IMacroPadLayout& layoutForKind(macro_templates::TemplateKind kind) {
+    using macro_templates::TemplateKind;
+    switch (kind) {
+        case TemplateKind::StackSides5: return layout_five_stack();
+        case TemplateKind::RoundPie8: return layout_pie8();
+        case TemplateKind::WideSides3: return layout_wide_center();
+        case TemplateKind::SplitSides4: return layout_four_split();
+        default: break;
     }
 
-    if (strcmp(id, macro_templates::kTemplateStackSides5) == 0) return layout_five_stack();
-    if (strcmp(id, macro_templates::kTemplateRoundPie8) == 0) return layout_pie8();
-    if (strcmp(id, macro_templates::kTemplateWideSides3) == 0) return layout_wide_center();
-    if (strcmp(id, macro_templates::kTemplateSplitSides4) == 0) return layout_four_split();
-
     // round_ring_9 default
     return layout_round9();
 }
 
+const IMacroPadLayout& layoutForId(const char* templateId) {
+    return layoutForKind(macro_templates::resolve(templateId));
+}
+
+void applyGeometry(MacroPadLayoutContext& ctx, const LayoutGeometry& g) {
+    lv_obj_t** buttons = ctx.buttons;
+    lv_obj_t** labels = ctx.labels;
+
+    for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
+        if (!buttons[i]) continue;
+        const SlotGeometry& slot = g.slots[i];
+        if (slot.w <= 0) {
+            lv_obj_add_flag(buttons[i], LV_OBJ_FLAG_HIDDEN);
+            continue;
+        }
+
+        lv_obj_set_style_radius(buttons[i], slot.radius, 0);
+        lv_obj_set_style_border_width(buttons[i], 0, 0);
+        lv_obj_clear_flag(buttons[i], LV_OBJ_FLAG_HIDDEN);
+        lv_obj_set_size(buttons[i], slot.w, slot.h);
+        lv_obj_set_pos(buttons[i], slot.x, slot.y);
+
+        if (labels && labels[i]) {
+            lv_obj_set_width(labels[i], slot.labelW);
+            lv_obj_center(labels[i]);
+        }
+    }
+}
+
 } // namespace macropad_layout
@@ -7,97 +7,63 @@ namespace macropad_layout {
 
 namespace {
 
+constexpr LayoutGeometry buildFourSplitGeometry(int w, int h) {
+    LayoutGeometry g{};
+    g.width = (int16_t)w;
+    g.height = (int16_t)h;
+
+    const int padX = (w + h) / 2 / 24;
+    const int spacing = (padX >= 9) ? (padX / 3) : 3;
+
+    const int minTouchPx = 52;
+    const int minCenterW = minTouchPx * 2;
+
+    int sideW = (int)((float)w * 0.18f);
+    if (sideW < minTouchPx) sideW = minTouchPx;
+    const int maxSideW = (w - minCenterW - (2 * spacing)) / 2;
+    if (sideW > maxSideW) sideW = maxSideW;
+
+    const int xCenter = sideW + spacing;
+    int centerW = w - (2 * sideW) - (2 * spacing);
+    if (centerW < minCenterW) centerW = minCenterW;
+    const int xRight = w - sideW;
+    const int centerLabelW = (centerW > 12) ? (centerW - 12) : centerW;
+    const int sideLabelW = (sideW > 8) ? (sideW - 8) : sideW;
+
+    const int fullH = h;
+
+    int topH = (fullH - spacing) / 2;
+    int bottomH = fullH - topH - spacing;
+    if (topH < minTouchPx || bottomH < minTouchPx) {
+        topH = (topH < minTouchPx) ? minTouchPx : topH;
+        bottomH = fullH - topH - spacing;
+        if (bottomH < minTouchPx) {
+            bottomH = minTouchPx;
+            topH = fullH - bottomH - spacing;
+            if (topH < minTouchPx) topH = minTouchPx;
+        }
+    }
+
+    g.slots[0] = {(int16_t)xCenter, 0, (int16_t)centerW, (int16_t)topH, (int16_t)centerLabelW, 10};
+    g.slots[2] = {(int16_t)xCenter, (int16_t)(topH + spacing), (int16_t)centerW, (int16_t)bottomH, (int16_t)centerLabelW, 10};
+    g.slots[3] = {0, 0, (int16_t)sideW, (int16_t)fullH, (int16_t)sideLabelW, 10};
+    g.slots[4] = {(int16_t)xRight, 0, (int16_t)sideW, (int16_t)fullH, (int16_t)sideLabelW, 10};
+    return g;
+}
+
+// The compiled display size, in both orientations.
+constexpr LayoutGeometry kFourSplitNative = buildFourSplitGeometry(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+constexpr LayoutGeometry kFourSplitRotated = buildFourSplitGeometry(DISPLAY_HEIGHT, DISPLAY_WIDTH);
+
 class MacroPadLayoutFourSplit final : public IMacroPadLayout {
 public:
     const char* id() const override { return macro_templates::kTemplateSplitSides4; }
 
     void apply(MacroPadLayoutContext& ctx) const override {
         if (!ctx.screen || !ctx.displayMgr) return;
-        lv_obj_t** buttons = ctx.buttons;
-        lv_obj_t** labels = ctx.labels;
-
         const int w = ctx.displayMgr->getActiveWidth();
         const int h = ctx.displayMgr->getActiveHeight();
-
-        const int padX = (w + h) / 2 / 24;
-        const int spacing = (padX >= 9) ? (padX / 3) : 3;
-
-        const int minTouchPx = 52;
-        const int minCenterW = minTouchPx * 2;
-
-        int sideW = (int)((float)w * 0.18f);
-        if (sideW < minTouchPx) sideW = minTouchPx;
-        const int maxSideW = (w - minCenterW - (2 * spacing)) / 2;
-        if (sideW > maxSideW) sideW = maxSideW;
-
-        const int xLeft = 0;
-        const int xCenter = sideW + spacing;
-        int centerW = w - (2 * sideW) - (2 * spacing);
-        if (centerW < minCenterW) centerW = minCenterW;
-        const int xRight = w - sideW;
-
-        const int yTop = 0;
-        const int fullH = h;
-
-        for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
-            if (!buttons[i]) continue;
-            const bool used = (i == 0 || i == 2 || i == 3 || i == 4);
-            if (used) {
-                lv_obj_set_style_radius(buttons[i], 10, 0);
-                lv_obj_set_style_border_width(buttons[i], 0, 0);
-                lv_obj_clear_flag(buttons[i], LV_OBJ_FLAG_HIDDEN);
-            } else {
-                lv_obj_add_flag(buttons[i], LV_OBJ_FLAG_HIDDEN);
-            }
-        }
-
-        int topH = (fullH - spacing) / 2;
-        int bottomH = fullH - topH - spacing;
-        if (topH < minTouchPx || bottomH < minTouchPx) {
-            topH = (topH < minTouchPx) ? minTouchPx : topH;
-            bottomH = fullH - topH - spacing;
-            if (bottomH < minTouchPx) {
-                bottomH = minTouchPx;
-                topH = fullH - bottomH - spacing;
-                if (topH < minTouchPx) topH = minTouchPx;
-            }
-        }
-
-        if (buttons[0]) {
-            lv_obj_set_pos(buttons[0], xCenter, yTop);
-            lv_obj_set_size(buttons[0], centerW, topH);
-            if (labels && labels[0]) {
-                lv_obj_set_width(labels[0], (centerW > 12) ? (centerW - 12) : centerW);
-                lv_obj_center(labels[0]);
-            }
-        }
-
-        if (buttons[2]) {
-            lv_obj_set_pos(buttons[2], xCenter, yTop + topH + spacing);
-            lv_obj_set_size(buttons[2], centerW, bottomH);
-            if (labels && labels[2]) {
-                lv_obj_set_width(labels[2], (centerW > 12) ? (centerW - 12) : centerW);
-                lv_obj_center(labels[2]);
-            }
-        }
-
-        if (buttons[3]) {
-            lv_obj_set_pos(buttons[3], xLeft, yTop);
-            lv_obj_set_size(buttons[3], sideW, fullH);
-            if (labels && labels[3]) {
-                lv_obj_set_width(labels[3], (sideW > 8) ? (sideW - 8) : sideW);
-                lv_obj_center(labels[3]);
-            }
-        }
-
-        if (buttons[4]) {
-            lv_obj_set_pos(buttons[4], xRight, yTop);
-            lv_obj_set_size(buttons[4], sideW, fullH);
-            if (labels && labels[4]) {
-                lv_obj_set_width(labels[4], (sideW > 8) ? (sideW - 8) : sideW);
-                lv_obj_center(labels[4]);
-            }
-        }
+        applyGeometry(ctx, selectGeometry(kFourSplitNative, kFourSplitRotated, w, h, buildFourSplitGeometry));
     }
 
     bool isSlotUsed(uint8_t slot) const override {
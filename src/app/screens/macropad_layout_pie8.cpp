@@ -4,17 +4,85 @@
 #include "../macro_templates.h"
 
 #include <math.h>
+#include <stdint.h>
 
 namespace macropad_layout {
 
 namespace {
 
-static float clampf(float v, float lo, float hi) {
-    if (v < lo) return lo;
-    if (v > hi) return hi;
-    return v;
+// Button slots plus the ring segments drawn under them.
+struct PieGeometry : LayoutGeometry {
+    int16_t ringX;
+    int16_t ringY;
+    int16_t ringSize;
+    int16_t arcWidth;
+    int16_t segStart[8];
+    int16_t segEnd[8];
+};
+
+constexpr PieGeometry buildPie8Geometry(int w, int h) {
+    PieGeometry g{};
+    g.width = (int16_t)w;
+    g.height = (int16_t)h;
+
+    const int cx = w / 2;
+    const int cy = h / 2;
+    const int minDim = (w < h) ? w : h;
+
+    const int ringSize = minDim;
+    g.ringX = (int16_t)(cx - (ringSize / 2));
+    g.ringY = (int16_t)(cy - (ringSize / 2));
+    g.ringSize = (int16_t)ringSize;
+
+    const float half = (float)minDim * 0.5f;
+
+    const float baseSeparatorPx = geomClampf((float)minDim * 0.015f, 6.0f, 12.0f);
+    const float separatorPx = baseSeparatorPx + 3.0f;
+
+    const int arcWidth = (int)geomClampf((float)minDim * 0.22f, 44.0f, half * 0.60f);
+    g.arcWidth = (int16_t)arcWidth;
+    const float ringOuter = half;
+    const float ringInnerEdge = geomClampf(ringOuter - (float)arcWidth, 0.0f, ringOuter);
+    const float rStrokeMid = ringOuter - ((float)arcWidth * 0.5f);
+    const float gapDeg = (rStrokeMid > 1.0f)
+        ? (separatorPx / rStrokeMid) * (180.0f / (float)M_PI)
+        : 0.0f;
+    const float sweepDeg = 45.0f - gapDeg;
+
+    for (int i = 0; i < 8; i++) {
+        const float centerDeg = 270.0f + (float)i * 45.0f;
+        int start = geomRound(centerDeg - (sweepDeg * 0.5f)) % 360;
+        int end = geomRound(centerDeg + (sweepDeg * 0.5f)) % 360;
+        if (start < 0) start += 360;
+        if (end < 0) end += 360;
+        g.segStart[i] = (int16_t)start;
+        g.segEnd[i] = (int16_t)end;
+    }
+
+    const float rMid = rStrokeMid + (separatorPx * 0.5f);
+    const int outerBox = (int)geomClampf((float)arcWidth * 1.10f, 64.0f, 128.0f);
+    const int outerRadius = outerBox / 2;
+    const int labelWidth = (outerBox > 24) ? (outerBox - 18) : outerBox;
+
+    for (int i = 0; i < 8; i++) {
+        const int bx = geomRound((float)cx + rMid * geomSlotDirX(i));
+        const int by = geomRound((float)cy + rMid * geomSlotDirY(i));
+        g.slots[i] = {(int16_t)(bx - outerRadius), (int16_t)(by - outerRadius), (int16_t)outerBox, (int16_t)outerBox,
+                      (int16_t)labelWidth, 0};
+    }
+
+    const int centerBox = (int)geomClampf((ringInnerEdge - separatorPx) * 2.0f, 72.0f, (float)minDim);
+    const int centerRadius = centerBox / 2;
+    const int centerLabelWidth = (centerBox > 24) ? (centerBox - 18) : centerBox;
+    g.slots[8] = {(int16_t)(cx - centerRadius), (int16_t)(cy - centerRadius), (int16_t)centerBox, (int16_t)centerBox,
+                  (int16_t)centerLabelWidth, LV_RADIUS_CIRCLE};
+    return g;
 }
 
+// The compiled display size, in both orientations.
+constexpr PieGeometry kPie8Native = buildPie8Geometry(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+constexpr PieGeometry kPie8Rotated = buildPie8Geometry(DISPLAY_HEIGHT, DISPLAY_WIDTH);
+
 class MacroPadLayoutPie8 final : public IMacroPadLayout {
 public:
     const char* id() const override { return macro_templates::kTemplateRoundPie8; }
@@ -24,32 +92,13 @@ public:
     void apply(MacroPadLayoutContext& ctx) const override {
         if (!ctx.screen || !ctx.displayMgr) return;
         lv_obj_t** buttons = ctx.buttons;
-        lv_obj_t** labels = ctx.labels;
         lv_obj_t** pieSegments = ctx.pieSegments;
 
         const int w = ctx.displayMgr->getActiveWidth();
         const int h = ctx.displayMgr->getActiveHeight();
-        const int cx = w / 2;
-        const int cy = h / 2;
-        const int minDim = (w < h) ? w : h;
-
-        const int ringSize = minDim;
-        const int ringX = cx - (ringSize / 2);
-        const int ringY = cy - (ringSize / 2);
-
-        const float half = (float)minDim * 0.5f;
+        const PieGeometry& g = selectGeometry(kPie8Native, kPie8Rotated, w, h, buildPie8Geometry);
 
-        const float baseSeparatorPx = clampf((float)minDim * 0.015f, 6.0f, 12.0f);
-        const float separatorPx = baseSeparatorPx + 3.0f;
-
-        const int arcWidth = (int)clampf((float)minDim * 0.22f, 44.0f, half * 0.60f);
-        const float ringOuter = half;
-        const float ringInnerEdge = clampf(ringOuter - (float)arcWidth, 0.0f, ringOuter);
-        const float rStrokeMid = ringOuter - ((float)arcWidth * 0.5f);
-        const float gapDeg = (rStrokeMid > 1.0f)
-            ? (separatorPx / rStrokeMid) * (180.0f / (float)M_PI)
-            : 0.0f;
-        const float sweepDeg = 45.0f - gapDeg;
+        hit = buildHitGeometry(w, h);
 
         if (ctx.pieHitLayer) {
             lv_obj_set_pos(ctx.pieHitLayer, 0, 0);
@@ -62,134 +111,115 @@ public:
             lv_obj_t* seg = pieSegments ? pieSegments[i] : nullptr;
             if (!seg) continue;
 
-            lv_obj_set_pos(seg, ringX, ringY);
-            lv_obj_set_size(seg, ringSize, ringSize);
+            lv_obj_set_pos(seg, g.ringX, g.ringY);
+            lv_obj_set_size(seg, g.ringSize, g.ringSize);
 
-            lv_obj_set_style_arc_width(seg, arcWidth, LV_PART_INDICATOR);
-
-            const float centerDeg = 270.0f + (float)i * 45.0f;
-            const float startF = centerDeg - (sweepDeg * 0.5f);
-            const float endF = centerDeg + (sweepDeg * 0.5f);
-            int start = (int)lroundf(startF);
-            int end = (int)lroundf(endF);
-            start %= 360;
-            end %= 360;
-            if (start < 0) start += 360;
-            if (end < 0) end += 360;
+            lv_obj_set_style_arc_width(seg, g.arcWidth, LV_PART_INDICATOR);
 
             lv_arc_set_rotation(seg, 0);
             lv_arc_set_bg_angles(seg, 0, 0);
-            lv_arc_set_angles(seg, start, end);
+            lv_arc_set_angles(seg, g.segStart[i], g.segEnd[i]);
             lv_obj_move_background(seg);
         }
 
-        const float rMid = rStrokeMid + (separatorPx * 0.5f);
-        int outerBox = (int)clampf((float)arcWidth * 1.10f, 64.0f, 128.0f);
-        const int outerRadius = outerBox / 2;
-        const int labelWidth = (outerBox > 24) ? (outerBox - 18) : outerBox;
-
+        // Ring buttons are invisible touch/label carriers over the segments.
         for (int i = 0; i < 8; i++) {
-            if (!buttons[i]) continue;
+            if (buttons[i]) lv_obj_set_style_bg_opa(buttons[i], LV_OPA_TRANSP, 0);
+        }
+        applyGeometry(ctx, g);
+    }
 
-            lv_obj_set_style_bg_opa(buttons[i], LV_OPA_TRANSP, 0);
-            lv_obj_set_style_border_width(buttons[i], 0, 0);
-            lv_obj_set_style_radius(buttons[i], 0, 0);
+    bool isSlotUsed(uint8_t slot) const override { return slot < 9; }
 
-            lv_obj_clear_flag(buttons[i], LV_OBJ_FLAG_HIDDEN);
+    int slotFromPoint(int x, int y, const MacroPadLayoutContext& ctx) const override {
+        if (!ctx.displayMgr) return -1;
 
-            lv_obj_set_size(buttons[i], outerBox, outerBox);
+        const int w = ctx.displayMgr->getActiveWidth();
+        const int h = ctx.displayMgr->getActiveHeight();
+        if (hit.w != w || hit.h != h) hit = buildHitGeometry(w, h);
 
-            const float deg = -90.0f + (float)i * 45.0f;
-            const float rad = deg * (float)M_PI / 180.0f;
-            const int bx = (int)lroundf((float)cx + rMid * cosf(rad));
-            const int by = (int)lroundf((float)cy + rMid * sinf(rad));
-            lv_obj_set_pos(buttons[i], bx - outerRadius, by - outerRadius);
+        // Integer-only from here: this runs for every touch read during a press.
+        const int32_t dx = x - w / 2;
+        const int32_t up = (h / 2) - y;   // +y up, so slot 0 is at the top
+        const int32_t r2 = dx * dx + up * up;
 
-            if (labels && labels[i]) {
-                lv_obj_set_width(labels[i], labelWidth);
-                lv_obj_center(labels[i]);
-            }
+        // Center slot
+        if (r2 <= hit.centerR2) return 8;
+        // Ring area only
+        if (r2 < hit.ringInner2 || r2 > hit.ringOuter2) return -1;
+
+        // Octant by tan(22.5°) comparisons; slots run clockwise from the top.
+        const int32_t ax = dx < 0 ? -dx : dx;
+        const int32_t ay = up < 0 ? -up : up;
+        int slot;
+        int32_t along;   // distance along the slot's center ray (scaled)
+        int32_t across;  // distance off it, same scale
+        if (ax * 65536 <= ay * kTan22_5Q16) {
+            slot = up > 0 ? 0 : 4;
+            along = ay;
+            across = ax;
+        } else if (ay * 65536 <= ax * kTan22_5Q16) {
+            slot = dx > 0 ? 2 : 6;
+            along = ax;
+            across = ay;
+        } else {
+            slot = dx > 0 ? (up > 0 ? 1 : 3) : (up > 0 ? 7 : 5);
+            // Rotated by 45°: both components carry the same 1/sqrt(2).
+            along = ax + ay;
+            across = ax > ay ? ax - ay : ay - ax;
         }
 
-        int centerBox = (int)clampf((ringInnerEdge - separatorPx) * 2.0f, 72.0f, (float)minDim);
-        const int centerRadius = centerBox / 2;
-        const int centerLabelWidth = (centerBox > 24) ? (centerBox - 18) : centerBox;
-
-        if (buttons[8]) {
-            lv_obj_set_style_radius(buttons[8], LV_RADIUS_CIRCLE, 0);
-            lv_obj_set_style_border_width(buttons[8], 0, 0);
-            lv_obj_clear_flag(buttons[8], LV_OBJ_FLAG_HIDDEN);
-            lv_obj_set_size(buttons[8], centerBox, centerBox);
-            lv_obj_set_pos(buttons[8], cx - centerRadius, cy - centerRadius);
-            if (labels && labels[8]) {
-                lv_obj_set_width(labels[8], centerLabelWidth);
-                lv_obj_center(labels[8]);
-            }
-        }
+        // Avoid clicks on the separator gaps between wedges.
+        if ((int64_t)across * 65536 > (int64_t)along * hit.tanHalfSweepQ16) return -1;
 
-        for (int i = 9; i < MACROS_BUTTONS_PER_SCREEN; i++) {
-            if (buttons[i]) lv_obj_add_flag(buttons[i], LV_OBJ_FLAG_HIDDEN);
-        }
+        return slot;
     }
 
-    bool isSlotUsed(uint8_t slot) const override { return slot < 9; }
+private:
+    // tan(22.5°) in Q16: the boundary between an axis slot and a diagonal one.
+    static constexpr int32_t kTan22_5Q16 = 27146;
 
-    int slotFromPoint(int x, int y, const MacroPadLayoutContext& ctx) const override {
-        if (!ctx.displayMgr) return -1;
+    // apply()'s ring geometry, reduced to integer hit-test thresholds.
+    struct HitGeometry {
+        int w;
+        int h;
+        int32_t centerR2;
+        int32_t ringInner2;
+        int32_t ringOuter2;
+        int32_t tanHalfSweepQ16;   // half the wedge sweep (without its gap)
+    };
 
-        const int w = ctx.displayMgr->getActiveWidth();
-        const int h = ctx.displayMgr->getActiveHeight();
-        const int cx = w / 2;
-        const int cy = h / 2;
-        const int dx = x - cx;
-        const int dy = y - cy;
+    // Rebuilt when the layout is applied (or the active size changes); LVGL task only.
+    mutable HitGeometry hit = {-1, -1, 0, 0, 0, 0};
 
+    static HitGeometry buildHitGeometry(int w, int h) {
         const int minDim = (w < h) ? w : h;
         const float half = (float)minDim * 0.5f;
 
         // Keep hit-testing geometry consistent with apply() ring geometry.
-        const float arcWidth = clampf((float)minDim * 0.22f, 44.0f, half * 0.60f);
-        const float baseSeparatorPx = clampf((float)minDim * 0.015f, 6.0f, 12.0f);
+        const float arcWidth = geomClampf((float)minDim * 0.22f, 44.0f, half * 0.60f);
+        const float baseSeparatorPx = geomClampf((float)minDim * 0.015f, 6.0f, 12.0f);
         const float separatorPx = baseSeparatorPx + 3.0f;
 
         const float ringOuter = half;
-        const float ringInnerEdge = clampf(ringOuter - arcWidth, 0.0f, ringOuter);
-        const float centerR = clampf(ringInnerEdge - separatorPx, 0.0f, ringOuter);
-        const float ringInner = ringInnerEdge;
-
-        const float r2 = (float)dx * (float)dx + (float)dy * (float)dy;
-        const float centerR2 = centerR * centerR;
-        const float ringInner2 = ringInner * ringInner;
-        const float ringOuter2 = ringOuter * ringOuter;
-
-        // Center slot
-        if (r2 <= centerR2) return 8;
-        // Ring area only
-        if (r2 < ringInner2 || r2 > ringOuter2) return -1;
+        const float ringInnerEdge = geomClampf(ringOuter - arcWidth, 0.0f, ringOuter);
+        const float centerR = geomClampf(ringInnerEdge - separatorPx, 0.0f, ringOuter);
 
-        // Angle where 0° is at the top and increases clockwise.
-        // (x,y) screen coords => +y down.
-        float ang = atan2f((float)dx, (float)-dy) * 180.0f / (float)M_PI;
-        if (ang < 0.0f) ang += 360.0f;
-
-        const float slice = 45.0f;
-        int slot = (int)floorf((ang + (slice * 0.5f)) / slice);
-        slot %= 8;
-        if (slot < 0) slot += 8;
-
-        // Avoid clicks on the separator gaps between wedges.
         const float rStrokeMid = ringOuter - (arcWidth * 0.5f);
         const float gapDeg = (rStrokeMid > 1.0f)
             ? (separatorPx / rStrokeMid) * (180.0f / (float)M_PI)
             : 0.0f;
-        const float sweepDeg = slice - gapDeg;
-        const float slotCenter = (float)slot * slice;
-        float delta = ang - slotCenter;
-        while (delta > 180.0f) delta -= 360.0f;
-        while (delta <= -180.0f) delta += 360.0f;
-        if (fabsf(delta) > (sweepDeg * 0.5f)) return -1;
-
-        return slot;
+        const float halfSweepRad = (45.0f - gapDeg) * 0.5f * (float)M_PI / 180.0f;
+
+        // Integer squared distances compare the same as the float radii would.
+        HitGeometry g;
+        g.w = w;
+        g.h = h;
+        g.centerR2 = (int32_t)floorf(centerR * centerR);
+        g.ringInner2 = (int32_t)ceilf(ringInnerEdge * ringInnerEdge);
+        g.ringOuter2 = (int32_t)floorf(ringOuter * ringOuter);
+        g.tanHalfSweepQ16 = (int32_t)lroundf(tanf(halfSweepRad) * 65536.0f);
+        return g;
     }
 };
 
@@ -1,12 +1,15 @@
 #include "macropad_screen.h"
 
 #include "macropad_layout.h"
+#include "macropad_styles.h"
 
 #include "../display_manager.h"
 #include "../macros_config.h"
 #include "../macro_templates.h"
 #include "../ble_keyboard_manager.h"
-#include "../ducky_script.h"
+#include "../macro_executor.h"
+#include "../tap_latency.h"
+#include "../touch_gesture.h"
 #include "../log_manager.h"
 #include "../config_manager.h"
 
@@ -27,6 +30,10 @@
 #include "../screen_saver_manager.h"
 #endif
 
+#if HAS_DISPLAY && LABEL_CACHE_ENABLED
+#include "../label_cache.h"
+#endif
+
 #include <esp_system.h>
 #include <string.h>
 
@@ -35,7 +42,7 @@
 namespace {
 
 constexpr uint32_t kUiRefreshIntervalMs = 500;
-constexpr lv_state_t kPressCueState = LV_STATE_USER_1;
+constexpr lv_state_t kPressCueState = macropad_styles::kPressCueState;
 
 static void setButtonVisible(lv_obj_t* btn, bool visible) {
     if (!btn) return;
@@ -46,6 +53,17 @@ static void setButtonVisible(lv_obj_t* btn, bool visible) {
     }
 }
 
+// For navigation buttons, provide sensible default icons if none configured.
+// This avoids “blank” side buttons on templates like round_wide_sides_3.
+static const char* effectiveIconIdFor(const MacroButtonConfig* btnCfg) {
+    const char* id = btnCfg->icon.id;
+    if (!id || id[0] == '\0' || btnCfg->icon.type == MacroIconType::None) {
+        if (btnCfg->action == MacroButtonAction::NavPrevScreen) return "chevron_left";
+        if (btnCfg->action == MacroButtonAction::NavNextScreen) return "chevron_right";
+    }
+    return id;
+}
+
 static const char* actionToShortLabel(MacroButtonAction a) {
     switch (a) {
         case MacroButtonAction::None: return "—";
@@ -55,6 +73,7 @@ static const char* actionToShortLabel(MacroButtonAction a) {
         case MacroButtonAction::NavToScreen: return "Go";
         case MacroButtonAction::GoBack: return "Back";
         case MacroButtonAction::MqttSend: return "MQTT";
+        case MacroButtonAction::BleHost: return "Host";
         default: return "—";
     }
 }
@@ -64,29 +83,6 @@ static void defaultLabel(char* out, size_t outLen, uint8_t screenIndex, uint8_t
     snprintf(out, outLen, "S%u-B%u", (unsigned)(screenIndex + 1), (unsigned)(buttonIndex + 1));
 }
 
-static inline uint8_t rgb565_luma(lv_color_t c) {
-    // LV_COLOR_DEPTH is 16 (RGB565) in this project.
-    const uint16_t v = c.full;
-    const uint8_t r5 = (v >> 11) & 0x1F;
-    const uint8_t g6 = (v >> 5) & 0x3F;
-    const uint8_t b5 = (v >> 0) & 0x1F;
-
-    const uint8_t r8 = (uint8_t)((r5 * 255u) / 31u);
-    const uint8_t g8 = (uint8_t)((g6 * 255u) / 63u);
-    const uint8_t b8 = (uint8_t)((b5 * 255u) / 31u);
-
-    // ITU-R BT.601-ish luma approximation.
-    return (uint8_t)((uint16_t)(r8 * 77u + g8 * 150u + b8 * 29u) >> 8);
-}
-
-static inline lv_color_t flashColorFor(lv_color_t base) {
-    // Luminance-aware: brighten dark colors, darken bright colors.
-    const uint8_t luma = rgb565_luma(base);
-    const lv_color_t target = (luma >= 160) ? lv_color_black() : lv_color_white();
-    // lv_color_mix(c1, c2, mix): mix=0 => c2, mix=255 => c1
-    return lv_color_mix(target, base, 80);
-}
-
 #if HAS_DISPLAY && HAS_ICONS
 static int clampInt(int v, int lo, int hi) {
     if (v < lo) return lo;
@@ -94,6 +90,7 @@ static int clampInt(int v, int lo, int hi) {
     return v;
 }
 
+#if !ICON_MASK_PRESCALED
 struct Mask2xCacheEntry {
     const lv_img_dsc_t* src64;
     lv_img_dsc_t dsc128;
@@ -193,6 +190,13 @@ static const lv_img_dsc_t* getOrCreateMask2x(const lv_img_dsc_t* src64) {
 
     return &e->dsc128;
 }
+static bool mask2xShownBy(const lv_img_dsc_t* dsc2x, lv_obj_t* const* icons, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (icons[i] && lv_img_get_src(icons[i]) == dsc2x) return true;
+    }
+    return false;
+}
+#endif // !ICON_MASK_PRESCALED
 
 static bool normalizeIconId(const char* in, char* out, size_t outLen) {
     if (!out || outLen == 0) return false;
@@ -222,12 +226,26 @@ static bool normalizeIconId(const char* in, char* out, size_t outLen) {
 
     return out[0] != '\0';
 }
+
+// Probe whether a missing icon can be acquired now, without touching the
+// button, so pending icon retries cost no LVGL work until one succeeds.
+static bool iconAvailable(const char* iconId) {
+    char normalizedId[MACROS_ICON_ID_MAX_LEN];
+    const char* lookupId = iconId;
+    if (lookupId && lookupId[0] != '\0' && normalizeIconId(lookupId, normalizedId, sizeof(normalizedId))) {
+        lookupId = normalizedId;
+    }
+    IconRef ref;
+    if (!lookupId || lookupId[0] == '\0' || !icon_store_acquire(lookupId, &ref) || !ref.dsc) return false;
+    icon_store_release(ref.dsc);
+    return true;
+}
 #endif
 
 } // namespace
 
 MacroPadScreen::MacroPadScreen(DisplayManager* manager, uint8_t idx)
-    : displayMgr(manager), screenIndex(idx), screen(nullptr), pressedPieSlot(-1), pressHoldTimer(nullptr), lastUpdateMs(0) {
+    : displayMgr(manager), screenIndex(idx), screen(nullptr), pressedPieSlot(-1), pressHoldTimer(nullptr), lastUpdateMs(0), appliedScreenGen(0), iconRetryMask(0) {
     configure(manager, idx);
 }
 
@@ -235,18 +253,27 @@ void MacroPadScreen::configure(DisplayManager* manager, uint8_t idx) {
     displayMgr = manager;
     screenIndex = idx;
 
-    lastTemplateId[0] = '\0';
+    appliedTemplate = macro_templates::TemplateKind::Count;
+    resolvedTemplate = macro_templates::TemplateKind::Count;
+    resolvedGeneration = 0;
 
     for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
         buttons[i] = nullptr;
         labels[i] = nullptr;
         icons[i] = nullptr;
+        heldIcons[i] = nullptr;
+        labelImgs[i] = nullptr;
+        heldLabels[i] = nullptr;
         buttonCtx[i] = {this, (uint8_t)i};
+        fillStyle[i] = macropad_styles::kNone;
+        labelStyle[i] = macropad_styles::kNone;
+        iconStyle[i] = macropad_styles::kNone;
     }
 
     pieHitLayer = nullptr;
     for (int i = 0; i < 8; i++) {
         pieSegments[i] = nullptr;
+        segStyle[i] = macropad_styles::kNone;
     }
 
     emptyStateLabel = nullptr;
@@ -257,9 +284,13 @@ void MacroPadScreen::configure(DisplayManager* manager, uint8_t idx) {
     for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
         pressDownTick[i] = 0;
         pendingClearTick[i] = 0;
+        appliedButtonGen[i] = 0;
     }
 
+    busyMask = 0;
     lastUpdateMs = 0;
+    appliedScreenGen = 0;
+    iconRetryMask = 0;
 }
 
 MacroPadScreen::~MacroPadScreen() {
@@ -276,49 +307,30 @@ BleKeyboardManager* MacroPadScreen::getBleKeyboard() const {
     return displayMgr->getBleKeyboard();
 }
 
-const char* MacroPadScreen::resolveTemplateId(const MacroConfig* cfg) const {
-    const char* tpl = (cfg && cfg->template_id[screenIndex][0]) ? cfg->template_id[screenIndex] : macro_templates::default_id();
-    if (!macro_templates::is_valid(tpl)) {
-        tpl = macro_templates::default_id();
+macro_templates::TemplateKind MacroPadScreen::resolveTemplate(const MacroConfig* cfg) {
+    // Template edits bump the screen generation, so the string compares run
+    // once per change rather than on every frame or touch.
+    if (!cfg) return macro_templates::resolve(nullptr);
+    const uint32_t gen = macros_config_screen_generation(screenIndex);
+    if (resolvedGeneration != gen) {
+        resolvedTemplate = macro_templates::resolve(cfg->template_id[screenIndex]);
+        resolvedGeneration = gen;
     }
-    return tpl;
+    return resolvedTemplate;
 }
 
-void MacroPadScreen::ensurePressStylesInited() {
-    if (pressStyles.inited) return;
-
-    static const lv_style_prop_t btnProps[] = {
-        (lv_style_prop_t)LV_STYLE_BG_COLOR,
-        (lv_style_prop_t)LV_STYLE_BG_OPA,
-        (lv_style_prop_t)LV_STYLE_PROP_INV,
-    };
-    lv_style_transition_dsc_init(&pressStyles.btnTrans, btnProps, lv_anim_path_ease_out, 160, 0, nullptr);
-
+void MacroPadScreen::releaseSharedStyles() {
+    using macropad_styles::Kind;
+    // The objects are deleted (or about to be) and take the style links with
+    // them; only the table references are left to drop.
     for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
-        lv_style_init(&pressStyles.btnBase[i]);
-        lv_style_set_bg_opa(&pressStyles.btnBase[i], LV_OPA_COVER);
-        lv_style_set_bg_color(&pressStyles.btnBase[i], lv_color_make(30, 30, 30));
-        lv_style_set_transition(&pressStyles.btnBase[i], &pressStyles.btnTrans);
-
-        lv_style_init(&pressStyles.btnPressed[i]);
-        lv_style_set_bg_opa(&pressStyles.btnPressed[i], LV_OPA_COVER);
-        lv_style_set_bg_color(&pressStyles.btnPressed[i], flashColorFor(lv_color_make(30, 30, 30)));
+        macropad_styles::detach(nullptr, LV_PART_MAIN, &fillStyle[i], Kind::ButtonFill);
+        macropad_styles::detach(nullptr, LV_PART_MAIN, &labelStyle[i], Kind::LabelColor);
+        macropad_styles::detach(nullptr, LV_PART_MAIN, &iconStyle[i], Kind::IconTint);
     }
-
     for (int i = 0; i < 8; i++) {
-        lv_style_init(&pressStyles.segBase[i]);
-        lv_style_set_arc_opa(&pressStyles.segBase[i], LV_OPA_COVER);
-        lv_style_set_arc_color(&pressStyles.segBase[i], lv_color_make(30, 30, 30));
-        // NOTE: We intentionally do NOT animate arc color/opacity transitions.
-        // On some targets the arc (indicator) transition can produce visible color
-        // artifacts during redraw (reported as “yellow flicker” on red wedges).
-
-        lv_style_init(&pressStyles.segPressed[i]);
-        lv_style_set_arc_opa(&pressStyles.segPressed[i], LV_OPA_COVER);
-        lv_style_set_arc_color(&pressStyles.segPressed[i], flashColorFor(lv_color_make(30, 30, 30)));
+        macropad_styles::detach(nullptr, LV_PART_INDICATOR, &segStyle[i], Kind::SegmentFill);
     }
-
-    pressStyles.inited = true;
 }
 
 void MacroPadScreen::buildLayoutContext(macropad_layout::MacroPadLayoutContext& out) {
@@ -336,7 +348,8 @@ void MacroPadScreen::buildLayoutContext(macropad_layout::MacroPadLayoutContext&
 void MacroPadScreen::create() {
     if (screen) return;
 
-    ensurePressStylesInited();
+    // Screens other than the default one may still be loading (BOOT_MACROS_LAZY).
+    macros_config_ensure_screen(screenIndex);
 
     screen = lv_obj_create(NULL);
     lv_obj_set_style_bg_color(screen, lv_color_black(), 0);
@@ -353,16 +366,9 @@ void MacroPadScreen::create() {
         lv_obj_clear_flag(btn, LV_OBJ_FLAG_SCROLLABLE);
         lv_obj_set_style_radius(btn, 10, 0);
 
-        // Base + pressed styles (pressed uses a luminance-aware flash fill).
-        lv_obj_add_style(btn, &pressStyles.btnBase[i], LV_PART_MAIN);
-        lv_obj_add_style(btn, &pressStyles.btnPressed[i], LV_PART_MAIN | kPressCueState);
-
-        // No outline/border by default.
-        lv_obj_set_style_border_width(btn, 0, 0);
-        lv_obj_set_style_outline_width(btn, 0, 0);
-        lv_obj_set_style_outline_pad(btn, 0, 0);
-        lv_obj_set_style_shadow_width(btn, 0, 0);
-        lv_obj_set_style_pad_all(btn, 0, 0);
+        // No outline/border by default. The fill (base + luminance-aware
+        // pressed flash) is attached per colour in refreshButtons().
+        lv_obj_add_style(btn, macropad_styles::buttonFrame(), LV_PART_MAIN);
         lv_obj_add_flag(btn, LV_OBJ_FLAG_CLICKABLE);
 
         // Drive pressed visual feedback explicitly (kPressCueState).
@@ -379,21 +385,14 @@ void MacroPadScreen::create() {
         lv_obj_add_flag(icon, LV_OBJ_FLAG_HIDDEN);
         // Image objects should never be scrollable containers.
         lv_obj_clear_flag(icon, LV_OBJ_FLAG_SCROLLABLE);
-        // Some themes/style cascades can apply LV_STYLE_OPA to children.
-        // Force the object itself to be opaque so the image can render.
-        lv_obj_set_style_opa(icon, LV_OPA_COVER, 0);
-        // Alpha-only images (LV_IMG_CF_ALPHA_*) are tinted via style.img_recolor, but
-        // they still respect style.img_opa. Force to opaque so theme defaults can't
-        // accidentally hide icons.
-        lv_obj_set_style_img_opa(icon, LV_OPA_COVER, 0);
-        // Default to no recolor unless this is a mask icon.
-        lv_obj_set_style_img_recolor_opa(icon, LV_OPA_TRANSP, 0);
+        // Opaque and not recoloured; mask icons get a tint entry in refreshButtons().
+        lv_obj_add_style(icon, macropad_styles::iconBase(), LV_PART_MAIN);
         lv_obj_clear_flag(icon, LV_OBJ_FLAG_CLICKABLE);
         #endif
 
         lv_obj_t* lbl = lv_label_create(btn);
-        lv_obj_set_style_text_align(lbl, LV_TEXT_ALIGN_CENTER, 0);
-        lv_obj_set_style_text_color(lbl, lv_color_white(), 0);
+        // Centred, white, in the label font (LABEL_FONT_ENABLED).
+        lv_obj_add_style(lbl, macropad_styles::labelBase(), LV_PART_MAIN);
         lv_label_set_long_mode(lbl, LV_LABEL_LONG_WRAP);
         // Width is updated in layoutButtons() once button size is known.
         lv_obj_center(lbl);
@@ -427,23 +426,11 @@ void MacroPadScreen::create() {
         // Hide until pie template is active.
         lv_obj_add_flag(seg, LV_OBJ_FLAG_HIDDEN);
 
-        // Make the arc look like a ring segment (no knob/indicator).
-        lv_obj_set_style_bg_opa(seg, LV_OPA_TRANSP, LV_PART_MAIN);
-        lv_obj_set_style_border_width(seg, 0, LV_PART_MAIN);
-        lv_obj_set_style_pad_all(seg, 0, LV_PART_MAIN);
-
-        // Hide knob.
-        lv_obj_set_style_bg_opa(seg, LV_OPA_TRANSP, LV_PART_KNOB);
-        lv_obj_set_style_border_width(seg, 0, LV_PART_KNOB);
-
-        // Default segment color; per-button colors applied in refreshButtons().
-        // Base + pressed styles (pressed uses a luminance-aware flash fill).
-        lv_obj_add_style(seg, &pressStyles.segBase[i], LV_PART_INDICATOR);
-        lv_obj_add_style(seg, &pressStyles.segPressed[i], LV_PART_INDICATOR | kPressCueState);
-        lv_obj_set_style_arc_rounded(seg, false, LV_PART_INDICATOR);
-
-        // Disable the background arc.
-        lv_obj_set_style_arc_opa(seg, LV_OPA_TRANSP, LV_PART_MAIN);
+        // Make the arc look like a ring segment: no background arc, no knob,
+        // square ends. Per-button colors are attached in refreshButtons().
+        lv_obj_add_style(seg, macropad_styles::segmentMain(), LV_PART_MAIN);
+        lv_obj_add_style(seg, macropad_styles::segmentKnob(), LV_PART_KNOB);
+        lv_obj_add_style(seg, macropad_styles::segmentIndicator(), LV_PART_INDICATOR);
 
         pieSegments[i] = seg;
     }
@@ -481,6 +468,10 @@ void MacroPadScreen::destroy() {
         lv_obj_del(screen);
         screen = nullptr;
     }
+    releaseSharedStyles();
+    // The lv_img objects are gone; let the icon and label caches evict what they showed.
+    releaseIcons();
+    releaseLabelBitmaps();
 
     if (pressHoldTimer) {
         lv_timer_del(pressHoldTimer);
@@ -491,6 +482,7 @@ void MacroPadScreen::destroy() {
         buttons[i] = nullptr;
         labels[i] = nullptr;
         icons[i] = nullptr;
+        labelImgs[i] = nullptr;
     }
 
     pieHitLayer = nullptr;
@@ -505,15 +497,24 @@ void MacroPadScreen::destroy() {
     for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
         pressDownTick[i] = 0;
         pendingClearTick[i] = 0;
+        appliedButtonGen[i] = 0;
     }
 
+    busyMask = 0;
     lastUpdateMs = 0;
+    appliedScreenGen = 0;
+    iconRetryMask = 0;
+    appliedTemplate = macro_templates::TemplateKind::Count;
 }
 
 void MacroPadScreen::notePressed(uint8_t slotIndex) {
     if (slotIndex >= MACROS_BUTTONS_PER_SCREEN) return;
     pressDownTick[slotIndex] = lv_tick_get();
     pendingClearTick[slotIndex] = 0;
+
+    // Touch-down: start shortening the BLE interval before the click lands.
+    BleKeyboardManager* kb = getBleKeyboard();
+    if (kb) kb->requestLowLatency();
 }
 
 void MacroPadScreen::cancelPendingClear(uint8_t slotIndex) {
@@ -523,6 +524,7 @@ void MacroPadScreen::cancelPendingClear(uint8_t slotIndex) {
 
 void MacroPadScreen::clearPressedVisual(uint8_t slotIndex) {
     if (slotIndex >= MACROS_BUTTONS_PER_SCREEN) return;
+    if (busyMask & (1u << slotIndex)) return;   // cleared when its macro ends
 
     if (slotIndex < 8) {
         // Slots 0..7 are special in the pie template (ring segments), but they are
@@ -541,6 +543,23 @@ void MacroPadScreen::clearPressedVisual(uint8_t slotIndex) {
     }
 }
 
+void MacroPadScreen::syncBusyVisuals() {
+    const uint32_t mask = macro_executor_busy_mask(screenIndex);
+    const uint32_t changed = mask ^ busyMask;
+    if (!changed) return;
+    busyMask = mask;
+
+    for (uint8_t i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
+        if (!(changed & (1u << i))) continue;
+        if (mask & (1u << i)) {
+            lv_obj_t* target = (i < 8 && pieSegments[i]) ? pieSegments[i] : buttons[i];
+            if (target) lv_obj_add_state(target, kPressCueState);
+        } else if (pendingClearTick[i] == 0 && !(buttons[i] && lv_obj_has_state(buttons[i], LV_STATE_PRESSED))) {
+            clearPressedVisual(i);
+        }
+    }
+}
+
 void MacroPadScreen::scheduleReleaseClear(uint8_t slotIndex) {
     if (slotIndex >= MACROS_BUTTONS_PER_SCREEN) return;
 
@@ -562,6 +581,8 @@ void MacroPadScreen::pressHoldTimerCallback(lv_timer_t* t) {
     MacroPadScreen* self = (MacroPadScreen*)t->user_data;
     if (!self) return;
 
+    self->syncBusyVisuals();
+
     const uint32_t now = lv_tick_get();
     bool anyPending = false;
 
@@ -584,28 +605,165 @@ void MacroPadScreen::show() {
         create();
     }
     if (screen) {
-        // If the template was changed in the web UI while we're running,
-        // re-apply layout before showing this screen.
+        // Catch up on web UI edits made while this screen was hidden.
+        // Pre-warmed screens that are still current skip straight to the load.
+        if (!isWarm()) {
+            syncToConfig();
+        }
+        lv_scr_load(screen);
+    }
+}
+
+uint32_t MacroPadScreen::staleButtonMask() const {
+    uint32_t mask = 0;
+    for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
+        if (appliedButtonGen[i] != macros_config_button_generation(screenIndex, (uint8_t)i)) {
+            mask |= (1u << i);
+        }
+    }
+    return mask;
+}
+
+bool MacroPadScreen::isWarm() const {
+    return screen
+        && appliedScreenGen == macros_config_screen_generation(screenIndex)
+        && staleButtonMask() == 0;
+}
+
+void MacroPadScreen::prewarm() {
+    if (!screen) {
+        create();
+        return;
+    }
+    if (!isWarm()) {
+        syncToConfig();
+    }
+}
+
+void MacroPadScreen::syncToConfig() {
+    if (!screen) return;
+    const MacroConfig* cfg = getMacroConfig();
+    if (!cfg) return;
+
+    if (appliedScreenGen != macros_config_screen_generation(screenIndex)
+        || resolveTemplate(cfg) != appliedTemplate) {
         layoutButtons();
         refreshButtons(true);
-        lv_scr_load(screen);
+        return;
+    }
+    refreshButtons(false);
+}
+
+uint8_t MacroPadScreen::trimMask2xCache(const MacroPadScreen* screens, size_t count) {
+    uint8_t freed = 0;
+    #if HAS_DISPLAY && HAS_ICONS && !ICON_MASK_PRESCALED
+    for (Mask2xCacheEntry& e : s_mask2xCache) {
+        if (!e.data128) continue;
+        bool shown = false;
+        for (size_t s = 0; s < count && !shown; s++) {
+            shown = screens[s].screen && mask2xShownBy(&e.dsc128, screens[s].icons, MACROS_BUTTONS_PER_SCREEN);
+        }
+        if (shown) continue;
+        lv_img_cache_invalidate_src(&e.dsc128);
+        lv_mem_free(e.data128);
+        memset(&e, 0, sizeof(e));
+        freed++;
     }
+    #else
+    (void)screens;
+    (void)count;
+    #endif
+    return freed;
 }
 
 void MacroPadScreen::hide() {
     // Nothing to do.
 }
 
+void MacroPadScreen::holdIcon(uint8_t index, const lv_img_dsc_t* dsc) {
+    // The new reference was already taken; drop the previous one after the
+    // lv_img has been repointed so a shared entry is never briefly unreferenced.
+    const lv_img_dsc_t* prev = heldIcons[index];
+    heldIcons[index] = dsc;
+    #if HAS_DISPLAY && HAS_ICONS
+    if (prev) icon_store_release(prev);
+    #else
+    (void)prev;
+    #endif
+}
+
+void MacroPadScreen::releaseIcons() {
+    for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
+        holdIcon((uint8_t)i, nullptr);
+    }
+}
+
+void MacroPadScreen::applyLabelBitmap(uint8_t index, uint32_t color) {
+    if (index >= MACROS_BUTTONS_PER_SCREEN) return;
+    lv_obj_t* lbl = labels[index];
+    if (!lbl) return;
+    #if HAS_DISPLAY && LABEL_CACHE_ENABLED
+    // Keyed by what the label would draw: its text, font and wrap width.
+    lv_obj_update_layout(lbl);
+    const lv_img_dsc_t* dsc = label_cache_acquire(
+        lv_label_get_text(lbl),
+        lv_obj_get_style_text_font(lbl, LV_PART_MAIN),
+        lv_obj_get_content_width(lbl));
+    lv_obj_t* img = labelImgs[index];
+    if (dsc && !img) {
+        // Created on first use, so boards without PSRAM (cache off) never pay for it.
+        // It covers the label's content box.
+        lv_obj_clear_flag(lbl, LV_OBJ_FLAG_SCROLLABLE);
+        img = lv_img_create(lbl);
+        lv_obj_clear_flag(img, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_clear_flag(img, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_set_pos(img, 0, 0);
+        lv_obj_set_style_img_opa(img, LV_OPA_COVER, 0);
+        lv_obj_set_style_img_recolor_opa(img, LV_OPA_COVER, 0);
+        labelImgs[index] = img;
+    }
+    if (dsc) {
+        lv_img_set_src(img, dsc);
+        lv_obj_set_style_img_recolor(img, lv_color_hex(color), 0);
+        lv_obj_clear_flag(img, LV_OBJ_FLAG_HIDDEN);
+        // Transparent text: lv_draw_label() returns before touching a glyph.
+        lv_obj_set_style_text_opa(lbl, LV_OPA_TRANSP, 0);
+    } else if (img) {
+        lv_img_set_src(img, nullptr);
+        lv_obj_add_flag(img, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_set_style_text_opa(lbl, LV_OPA_COVER, 0);
+    }
+    holdLabelBitmap(index, dsc);
+    #else
+    (void)color;
+    #endif
+}
+
+void MacroPadScreen::holdLabelBitmap(uint8_t index, const lv_img_dsc_t* dsc) {
+    // Same order as holdIcon(): the new reference is taken before the old one drops.
+    const lv_img_dsc_t* prev = heldLabels[index];
+    heldLabels[index] = dsc;
+    #if HAS_DISPLAY && LABEL_CACHE_ENABLED
+    if (prev) label_cache_release(prev);
+    #else
+    (void)prev;
+    #endif
+}
+
+void MacroPadScreen::releaseLabelBitmaps() {
+    for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
+        holdLabelBitmap((uint8_t)i, nullptr);
+    }
+}
+
 void MacroPadScreen::layoutButtons() {
     if (!screen || !displayMgr) return;
 
     const MacroConfig* cfg = getMacroConfig();
-    const char* tpl = resolveTemplateId(cfg);
+    // Remember the applied template so update() can detect changes.
+    appliedTemplate = resolveTemplate(cfg);
 
-    // Cache the applied template so update() can detect changes.
-    strlcpy(lastTemplateId, tpl, sizeof(lastTemplateId));
-
-    const macropad_layout::IMacroPadLayout& layout = macropad_layout::layoutForId(tpl);
+    const macropad_layout::IMacroPadLayout& layout = macropad_layout::layoutForKind(appliedTemplate);
     macropad_layout::MacroPadLayoutContext ctx;
     buildLayoutContext(ctx);
     layout.apply(ctx);
@@ -659,9 +817,9 @@ void MacroPadScreen::pieEventCallback(lv_event_t* e) {
     lv_indev_get_point(indev, &p);
 
     const MacroConfig* cfg = self->getMacroConfig();
-    const char* tpl = self->resolveTemplateId(cfg);
+    const macro_templates::TemplateKind tpl = self->resolveTemplate(cfg);
 
-    const macropad_layout::IMacroPadLayout& layout = macropad_layout::layoutForId(tpl);
+    const macropad_layout::IMacroPadLayout& layout = macropad_layout::layoutForKind(tpl);
     macropad_layout::MacroPadLayoutContext ctx;
     self->buildLayoutContext(ctx);
 
@@ -724,12 +882,31 @@ void MacroPadScreen::pieEventCallback(lv_event_t* e) {
 }
 
 void MacroPadScreen::handleButtonClick(uint8_t b) {
+    #if HAS_TOUCH && MACROPAD_GESTURES
+    // The press ended in a swipe/long-press that navigated (touch_gesture.h).
+    if (touch_gesture_press_consumed()) return;
+    #endif
+
+    const TapTrace trace = tap_latency_click();
+
     #if HAS_DISPLAY
     screen_saver_manager_notify_activity(true);
     #endif
 
+    runButtonAction(b, &trace);
+}
+
+void MacroPadScreen::triggerButton(uint8_t b) {
+    if (b >= MACROS_BUTTONS_PER_SCREEN || !displayMgr) return;
+    // No touch to trace, and a remote trigger does not wake the display
+    // (the macro may run on a hidden screen).
+    runButtonAction(b, nullptr);
+}
+
+void MacroPadScreen::runButtonAction(uint8_t b, const TapTrace* trace) {
     const MacroConfig* cfg = getMacroConfig();
     if (!cfg) return;
+    macros_config_ensure_screen(screenIndex);
 
     const MacroButtonConfig* btnCfg = &cfg->buttons[screenIndex][b];
     if (!btnCfg) return;
@@ -773,8 +950,29 @@ void MacroPadScreen::handleButtonClick(uint8_t b) {
             return;
         }
 
+        // Runs on the executor task; the button keeps its press cue while the
+        // macro is queued or running (syncBusyVisuals).
         BleKeyboardManager* kb = getBleKeyboard();
-        ducky_execute(btnCfg->payload, kb);
+        (void)macro_executor_submit(screenIndex, b, btnCfg->payload, kb, trace);
+        syncBusyVisuals();
+        return;
+    }
+
+    if (btnCfg->action == MacroButtonAction::BleHost) {
+        BleHostStats hosts;
+        ble_keyboard_get_host_stats(&hosts);
+        // "next" (or empty) cycles; a number picks that profile.
+        const char* arg = btnCfg->payload;
+        uint8_t target = (uint8_t)((hosts.active + 1) % hosts.count);
+        if (arg[0] && strcasecmp(arg, "next") != 0) {
+            const int n = atoi(arg);
+            if (n < 1 || n > hosts.count) {
+                displayMgr->showError("Bluetooth", "No such host profile");
+                return;
+            }
+            target = (uint8_t)(n - 1);
+        }
+        (void)ble_keyboard_select_host(target);
         return;
     }
 
@@ -892,6 +1090,16 @@ void MacroPadScreen::updateButtonLayout(uint8_t index, bool hasIcon, bool hasLab
         lv_obj_set_size(icon, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
     } else {
         // Alpha-only masks can't be zoomed by lv_img_set_zoom.
+        #if ICON_MASK_PRESCALED
+        // Use the compiled size nearest the icon box (build-time variants).
+        if (src && lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE) {
+            const lv_img_dsc_t* dsc = (const lv_img_dsc_t*)src;
+            const lv_img_dsc_t* sized = icon_registry_pick_size(dsc, (uint16_t)iconBox);
+            if (sized && sized != dsc) {
+                lv_img_set_src(icon, sized);
+            }
+        }
+        #else
         // Instead, when we want a 2x icon, generate a cached 2x alpha mask in RAM.
         if (src && lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE) {
             const lv_img_dsc_t* dsc = (const lv_img_dsc_t*)src;
@@ -910,6 +1118,7 @@ void MacroPadScreen::updateButtonLayout(uint8_t index, bool hasIcon, bool hasLab
                 }
             }
         }
+        #endif
 
         lv_img_set_zoom(icon, 256);
         lv_obj_set_size(icon, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
@@ -937,45 +1146,81 @@ void MacroPadScreen::updateButtonLayout(uint8_t index, bool hasIcon, bool hasLab
 void MacroPadScreen::refreshButtons(bool force) {
     if (!screen) return;
 
-    const uint32_t now = millis();
-    if (!force && lastUpdateMs != 0 && (uint32_t)(now - lastUpdateMs) < kUiRefreshIntervalMs) {
-        return;
-    }
-    lastUpdateMs = now;
-
     const MacroConfig* cfg = getMacroConfig();
     if (!cfg) return;
 
-    const char* tpl = resolveTemplateId(cfg);
-    const macropad_layout::IMacroPadLayout& layout = macropad_layout::layoutForId(tpl);
-    const bool isPie = layout.isPie();
+    // Only buttons whose config generation moved are redrawn; a static screen
+    // touches no LVGL objects here. Icon retries and the empty-state text
+    // (which shows the current IP) are the only periodic work left.
+    const uint32_t allButtons = (uint32_t)((1ull << MACROS_BUTTONS_PER_SCREEN) - 1u);
+    uint32_t dirty = force ? allButtons : staleButtonMask();
 
-    if (!isPie && pressedPieSlot >= 0 && pressedPieSlot < 8) {
-        lv_obj_t* seg = pieSegments[pressedPieSlot];
-        if (seg) lv_obj_clear_state(seg, kPressCueState);
-        pressedPieSlot = -1;
+    const uint32_t now = millis();
+    const bool periodic = force || lastUpdateMs == 0 || (uint32_t)(now - lastUpdateMs) >= kUiRefreshIntervalMs;
+    if (periodic) {
+        lastUpdateMs = now;
+        #if HAS_DISPLAY && HAS_ICONS
+        for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
+            const uint32_t bit = 1u << i;
+            if ((iconRetryMask & bit) && !(dirty & bit)
+                && iconAvailable(effectiveIconIdFor(&cfg->buttons[screenIndex][i]))) {
+                dirty |= bit;
+            }
+        }
+        #endif
     }
 
-    // Enable/disable pie helpers depending on the active template.
-    if (pieHitLayer) {
-        if (isPie) {
-            lv_obj_clear_flag(pieHitLayer, LV_OBJ_FLAG_HIDDEN);
-            // Keep the hit layer above the arc visuals.
-            lv_obj_move_foreground(pieHitLayer);
-        } else {
-            lv_obj_add_flag(pieHitLayer, LV_OBJ_FLAG_HIDDEN);
+    bool anyButtonConfigured = false;
+    for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
+        if (cfg->buttons[screenIndex][i].action != MacroButtonAction::None) {
+            anyButtonConfigured = true;
+            break;
         }
     }
 
-    // Apply macro screen background (optional per-screen override, else global default).
-    const uint32_t screenBg = (cfg->screen_bg[screenIndex] != MACROS_COLOR_UNSET)
-        ? cfg->screen_bg[screenIndex]
-        : cfg->default_screen_bg;
-    lv_obj_set_style_bg_color(screen, lv_color_hex(screenBg), 0);
-    lv_obj_set_style_bg_opa(screen, LV_OPA_COVER, 0);
-    bool anyButtonConfigured = false;
+    if (dirty == 0) {
+        if (periodic) updateEmptyState(anyButtonConfigured);
+        return;
+    }
+
+    const macropad_layout::IMacroPadLayout& layout = macropad_layout::layoutForKind(resolveTemplate(cfg));
+    const bool isPie = layout.isPie();
+
+    // Screen-level state only changes with the screen generation (template,
+    // background, defaults), which always comes through a forced refresh.
+    if (force) {
+        appliedScreenGen = macros_config_screen_generation(screenIndex);
+
+        if (!isPie && pressedPieSlot >= 0 && pressedPieSlot < 8) {
+            lv_obj_t* seg = pieSegments[pressedPieSlot];
+            if (seg) lv_obj_clear_state(seg, kPressCueState);
+            pressedPieSlot = -1;
+        }
+
+        // Enable/disable pie helpers depending on the active template.
+        if (pieHitLayer) {
+            if (isPie) {
+                lv_obj_clear_flag(pieHitLayer, LV_OBJ_FLAG_HIDDEN);
+                // Keep the hit layer above the arc visuals.
+                lv_obj_move_foreground(pieHitLayer);
+            } else {
+                lv_obj_add_flag(pieHitLayer, LV_OBJ_FLAG_HIDDEN);
+            }
+        }
+
+        // Apply macro screen background (optional per-screen override, else global default).
+        const uint32_t screenBg = (cfg->screen_bg[screenIndex] != MACROS_COLOR_UNSET)
+            ? cfg->screen_bg[screenIndex]
+            : cfg->default_screen_bg;
+        lv_obj_set_style_bg_color(screen, lv_color_hex(screenBg), 0);
+        lv_obj_set_style_bg_opa(screen, LV_OPA_COVER, 0);
+    }
 
     for (int i = 0; i < MACROS_BUTTONS_PER_SCREEN; i++) {
+        if (!(dirty & (1u << i))) continue;
+        appliedButtonGen[i] = macros_config_button_generation(screenIndex, (uint8_t)i);
+        iconRetryMask &= ~(1u << i);
+
         const MacroButtonConfig* btnCfg = &cfg->buttons[screenIndex][i];
 
         if (!layout.isSlotUsed((uint8_t)i)) {
@@ -991,20 +1236,10 @@ void MacroPadScreen::refreshButtons(bool force) {
             else lv_obj_add_flag(buttons[i], LV_OBJ_FLAG_CLICKABLE);
         }
 
-        if (btnCfg->action != MacroButtonAction::None) {
-            anyButtonConfigured = true;
-        }
-
         const bool visible = btnCfg->action != MacroButtonAction::None;
         setButtonVisible(buttons[i], visible);
 
-        // For navigation buttons, provide sensible default icons if none configured.
-        // This avoids “blank” side buttons on templates like round_wide_sides_3.
-        const char* effectiveIconId = btnCfg->icon.id;
-        if (!effectiveIconId || effectiveIconId[0] == '\0' || btnCfg->icon.type == MacroIconType::None) {
-            if (btnCfg->action == MacroButtonAction::NavPrevScreen) effectiveIconId = "chevron_left";
-            else if (btnCfg->action == MacroButtonAction::NavNextScreen) effectiveIconId = "chevron_right";
-        }
+        const char* effectiveIconId = effectiveIconIdFor(btnCfg);
 
         if (!visible) continue;
 
@@ -1019,36 +1254,17 @@ void MacroPadScreen::refreshButtons(bool force) {
             ? btnCfg->icon_color
             : cfg->default_icon_color;
 
-        // Keep button base/pressed styles aligned with configured colors.
-        {
-            const bool isPieOuter = isPie && (i < 8);
-            const lv_color_t base = lv_color_hex(buttonBg);
-            const lv_color_t flash = flashColorFor(base);
-
-            if (isPieOuter) {
-                lv_style_set_bg_opa(&pressStyles.btnBase[i], LV_OPA_TRANSP);
-                lv_style_set_bg_opa(&pressStyles.btnPressed[i], LV_OPA_TRANSP);
-            } else {
-                lv_style_set_bg_opa(&pressStyles.btnBase[i], LV_OPA_COVER);
-                lv_style_set_bg_opa(&pressStyles.btnPressed[i], LV_OPA_COVER);
-            }
-            lv_style_set_bg_color(&pressStyles.btnBase[i], base);
-            lv_style_set_bg_color(&pressStyles.btnPressed[i], flash);
-        }
-        if (labels[i]) {
-            lv_obj_set_style_text_color(labels[i], lv_color_hex(labelColor), 0);
-        }
+        // Shared fill and text styles for the configured colors (pie ring
+        // buttons are transparent carriers over their segments).
+        const bool isPieOuter = isPie && (i < 8);
+        macropad_styles::attach(buttons[i], LV_PART_MAIN, &fillStyle[i], macropad_styles::Kind::ButtonFill, buttonBg, isPieOuter);
+        macropad_styles::attach(labels[i], LV_PART_MAIN, &labelStyle[i], macropad_styles::Kind::LabelColor, labelColor);
 
         // Pie ring segment background for slots 0..7.
-        if (isPie && i < 8) {
+        if (isPieOuter) {
             lv_obj_t* seg = pieSegments[i];
             if (seg) {
-                const lv_color_t base = lv_color_hex(buttonBg);
-                const lv_color_t flash = flashColorFor(base);
-                lv_style_set_arc_color(&pressStyles.segBase[i], base);
-                lv_style_set_arc_color(&pressStyles.segPressed[i], flash);
-                lv_style_set_arc_opa(&pressStyles.segBase[i], LV_OPA_COVER);
-                lv_style_set_arc_opa(&pressStyles.segPressed[i], LV_OPA_COVER);
+                macropad_styles::attach(seg, LV_PART_INDICATOR, &segStyle[i], macropad_styles::Kind::SegmentFill, buttonBg);
                 lv_obj_clear_flag(seg, LV_OBJ_FLAG_HIDDEN);
             }
         }
@@ -1095,18 +1311,15 @@ void MacroPadScreen::refreshButtons(bool force) {
                 lookupId = normalizedId;
             }
 
-            if (lookupId[0] != '\0' && icon_store_lookup(lookupId, &ref) && ref.dsc) {
+            if (lookupId[0] != '\0' && icon_store_acquire(lookupId, &ref) && ref.dsc) {
                 lv_img_set_src(icons[i], ref.dsc);
-                lv_obj_set_style_opa(icons[i], LV_OPA_COVER, 0);
+                holdIcon((uint8_t)i, ref.dsc);
                 if (ref.kind == IconKind::Mask) {
-                    // Monochrome: recolor/tint via style.
-                    lv_obj_set_style_img_recolor(icons[i], lv_color_hex(iconColor), 0);
-                    lv_obj_set_style_img_recolor_opa(icons[i], LV_OPA_COVER, 0);
-                    lv_obj_set_style_img_opa(icons[i], LV_OPA_COVER, 0);
+                    // Monochrome: recolor/tint via a shared style.
+                    macropad_styles::attach(icons[i], LV_PART_MAIN, &iconStyle[i], macropad_styles::Kind::IconTint, iconColor);
                 } else {
-                    // Color: do not recolor.
-                    lv_obj_set_style_img_recolor_opa(icons[i], LV_OPA_TRANSP, 0);
-                    lv_obj_set_style_img_opa(icons[i], LV_OPA_COVER, 0);
+                    // Color: do not recolor (iconBase).
+                    macropad_styles::detach(icons[i], LV_PART_MAIN, &iconStyle[i], macropad_styles::Kind::IconTint);
                 }
 
                 lv_obj_clear_flag(icons[i], LV_OBJ_FLAG_HIDDEN);
@@ -1114,19 +1327,27 @@ void MacroPadScreen::refreshButtons(bool force) {
                 lv_obj_move_foreground(icons[i]);
                 hasIcon = true;
             } else {
+                // Detach the old icon so its cache entry can be evicted.
+                lv_img_set_src(icons[i], nullptr);
                 lv_obj_add_flag(icons[i], LV_OBJ_FLAG_HIDDEN);
+                holdIcon((uint8_t)i, nullptr);
                 hasIcon = false;
+                // The icon may still be installing; look again later.
+                if (lookupId[0] != '\0') iconRetryMask |= (1u << i);
             }
         }
         #endif
 
         const bool hasLabel = (labelText && *labelText);
         updateButtonLayout((uint8_t)i, hasIcon, hasLabel);
+        // After layout: an icon-only button has just had its text cleared.
+        applyLabelBitmap((uint8_t)i, labelColor);
     }
 
     // Hide unused pie segments (unconfigured outer slots).
     if (isPie) {
         for (int i = 0; i < 8; i++) {
+            if (!(dirty & (1u << i))) continue;
             const MacroButtonConfig* btnCfg = &cfg->buttons[screenIndex][i];
             const bool segVisible = (btnCfg && btnCfg->action != MacroButtonAction::None);
             if (pieSegments[i]) {
@@ -1137,7 +1358,7 @@ void MacroPadScreen::refreshButtons(bool force) {
                 }
             }
         }
-    } else {
+    } else if (force) {
         for (int i = 0; i < 8; i++) {
             if (pieSegments[i]) lv_obj_add_flag(pieSegments[i], LV_OBJ_FLAG_HIDDEN);
         }
@@ -1150,8 +1371,12 @@ void MacroPadScreen::updateEmptyState(bool anyButtonConfigured) {
     // Show on any Macro Screen when it's empty.
     if (!emptyStateLabel) return;
 
+    // This runs on the periodic tick too, so only touch LVGL on a real change
+    // (setting text or the hidden flag invalidates the area even when unchanged).
     if (anyButtonConfigured) {
-        lv_obj_add_flag(emptyStateLabel, LV_OBJ_FLAG_HIDDEN);
+        if (!lv_obj_has_flag(emptyStateLabel, LV_OBJ_FLAG_HIDDEN)) {
+            lv_obj_add_flag(emptyStateLabel, LV_OBJ_FLAG_HIDDEN);
+        }
         return;
     }
 
@@ -1195,27 +1420,16 @@ void MacroPadScreen::updateEmptyState(bool anyButtonConfigured) {
             screenNumber);
     }
 
-    lv_label_set_text(emptyStateLabel, text);
-    lv_obj_clear_flag(emptyStateLabel, LV_OBJ_FLAG_HIDDEN);
+    if (strcmp(lv_label_get_text(emptyStateLabel), text) != 0) {
+        lv_label_set_text(emptyStateLabel, text);
+    }
+    if (lv_obj_has_flag(emptyStateLabel, LV_OBJ_FLAG_HIDDEN)) {
+        lv_obj_clear_flag(emptyStateLabel, LV_OBJ_FLAG_HIDDEN);
+    }
 }
 
 void MacroPadScreen::update() {
-    const MacroConfig* cfg = getMacroConfig();
-    if (cfg) {
-        const char* tpl = (cfg->template_id[screenIndex][0] != '\0') ? cfg->template_id[screenIndex] : macro_templates::default_id();
-        if (!macro_templates::is_valid(tpl)) {
-            tpl = macro_templates::default_id();
-        }
-
-        if (strcmp(tpl, lastTemplateId) != 0) {
-            // Template changed: re-layout immediately.
-            layoutButtons();
-            refreshButtons(true);
-            return;
-        }
-    }
-
-    refreshButtons(false);
+    syncToConfig();
 }
 
 void MacroPadScreen::buttonEventCallback(lv_event_t* e) {
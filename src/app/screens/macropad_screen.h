@@ -5,11 +5,14 @@
 #include <lvgl.h>
 
 #include "../macros_config.h"
+#include "../macro_templates.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 class BleKeyboardManager;
 class DisplayManager;
+struct TapTrace;
 
 namespace macropad_layout {
 struct MacroPadLayoutContext;
@@ -28,25 +31,25 @@ public:
     void hide() override;
     void update() override;
 
+    // Build (or rebuild after a config change) without loading the screen, so a
+    // later show() only has to lv_scr_load() it.
+    void prewarm();
+    bool isWarm() const;
+    bool isCreated() const { return screen != nullptr; }
+
+    // Run a button's action without a touch (remote trigger). LVGL task only.
+    void triggerButton(uint8_t buttonIndex);
+
+    // Memory pressure: free the cached 2x icon masks that no icon of these
+    // screens shows. Returns the number freed. LVGL task only.
+    static uint8_t trimMask2xCache(const MacroPadScreen* screens, size_t count);
+
 private:
     struct ButtonCtx {
         MacroPadScreen* self;
         uint8_t buttonIndex;
     };
 
-    struct PressAnimStyles {
-        bool inited;
-        lv_style_transition_dsc_t btnTrans;
-
-        lv_style_t btnBase[MACROS_BUTTONS_PER_SCREEN];
-        lv_style_t btnPressed[MACROS_BUTTONS_PER_SCREEN];
-
-        lv_style_t segBase[8];
-        lv_style_t segPressed[8];
-
-        PressAnimStyles() : inited(false) {}
-    };
-
     static constexpr uint32_t kMinPressCueMs = 100;
 
     DisplayManager* displayMgr;
@@ -56,6 +59,12 @@ private:
     lv_obj_t* buttons[MACROS_BUTTONS_PER_SCREEN];
     lv_obj_t* labels[MACROS_BUTTONS_PER_SCREEN];
     lv_obj_t* icons[MACROS_BUTTONS_PER_SCREEN];
+    // icon_store reference held for what icons[i] shows (nullptr = none).
+    const lv_img_dsc_t* heldIcons[MACROS_BUTTONS_PER_SCREEN];
+    // Pre-rendered label (LABEL_CACHE_ENABLED): an image child of labels[i]
+    // drawn instead of the label's text, and the label_cache reference it shows.
+    lv_obj_t* labelImgs[MACROS_BUTTONS_PER_SCREEN];
+    const lv_img_dsc_t* heldLabels[MACROS_BUTTONS_PER_SCREEN];
 
     // Pie template helpers (round_pie_8): we use a full-screen hit layer for
     // polar hit-testing and draw ring segments separately.
@@ -64,39 +73,72 @@ private:
     lv_obj_t* emptyStateLabel;
     ButtonCtx buttonCtx[MACROS_BUTTONS_PER_SCREEN];
 
-    PressAnimStyles pressStyles;
+    // Shared style entries (macropad_styles.h) each object shows; kNone = none.
+    uint8_t fillStyle[MACROS_BUTTONS_PER_SCREEN];
+    uint8_t labelStyle[MACROS_BUTTONS_PER_SCREEN];
+    uint8_t iconStyle[MACROS_BUTTONS_PER_SCREEN];
+    uint8_t segStyle[8];
     int8_t pressedPieSlot;
 
     lv_timer_t* pressHoldTimer;
     uint32_t pressDownTick[MACROS_BUTTONS_PER_SCREEN];
     uint32_t pendingClearTick[MACROS_BUTTONS_PER_SCREEN];
+    // Buttons whose macro is queued or running (macro_executor_busy_mask()).
+    uint32_t busyMask;
 
     uint32_t lastUpdateMs;
 
-    char lastTemplateId[MACROS_TEMPLATE_ID_MAX_LEN];
+    // Config generations the LVGL objects currently reflect (0 = never built).
+    uint32_t appliedScreenGen;
+    uint32_t appliedButtonGen[MACROS_BUTTONS_PER_SCREEN];
+    // Buttons whose icon was configured but not available yet; retried every
+    // kUiRefreshIntervalMs.
+    uint32_t iconRetryMask;
+
+    // Template the buttons are laid out for (Count = not laid out yet).
+    macro_templates::TemplateKind appliedTemplate;
+    // This screen's template id, resolved once per macros_config_screen_generation().
+    macro_templates::TemplateKind resolvedTemplate;
+    uint32_t resolvedGeneration;
 
     void layoutButtons();
     void refreshButtons(bool force);
+    // Bring the screen up to date with the config: re-layout and full refresh
+    // after a screen-level change, otherwise redraw only the changed buttons.
+    void syncToConfig();
+    uint32_t staleButtonMask() const;
 
     void updateButtonLayout(uint8_t index, bool hasIcon, bool hasLabel);
 
+    void holdIcon(uint8_t index, const lv_img_dsc_t* dsc);
+    void releaseIcons();
+
+    // Show labels[index] from the label cache (tinted with color) when it has
+    // a bitmap for the current text/font/width, else as plain text.
+    void applyLabelBitmap(uint8_t index, uint32_t color);
+    void holdLabelBitmap(uint8_t index, const lv_img_dsc_t* dsc);
+    void releaseLabelBitmaps();
+
     void updateEmptyState(bool anyButtonConfigured);
 
     const MacroConfig* getMacroConfig() const;
     BleKeyboardManager* getBleKeyboard() const;
 
-    const char* resolveTemplateId(const MacroConfig* cfg) const;
+    macro_templates::TemplateKind resolveTemplate(const MacroConfig* cfg);
     void buildLayoutContext(macropad_layout::MacroPadLayoutContext& out);
 
-    void ensurePressStylesInited();
+    // Drop this screen's references to shared style entries (objects deleted or about to be).
+    void releaseSharedStyles();
 
     void notePressed(uint8_t slotIndex);
     void scheduleReleaseClear(uint8_t slotIndex);
     void cancelPendingClear(uint8_t slotIndex);
     void clearPressedVisual(uint8_t slotIndex);
+    void syncBusyVisuals();
     static void pressHoldTimerCallback(lv_timer_t* t);
 
     void handleButtonClick(uint8_t buttonIndex);
+    void runButtonAction(uint8_t buttonIndex, const TapTrace* trace);
     static void pieEventCallback(lv_event_t* e);
 
     static void buttonEventCallback(lv_event_t* e);
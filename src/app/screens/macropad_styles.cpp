@@ -0,0 +1,327 @@
+#include "macropad_styles.h"
+
+#include "../board_config.h"
+
+#if HAS_DISPLAY && LABEL_FONT_ENABLED
+#include "../label_font.h"
+#endif
+
+#include <string.h>
+
+namespace macropad_styles {
+
+namespace {
+
+// Distinct (kind, colour) pairs alive at once. Eight screens of sixteen
+// buttons in distinct colours would need more; those fall back to local styles.
+constexpr uint8_t kEntries = 48;
+
+struct Entry {
+    uint16_t refs;
+    bool built;             // base/pressed hold properties (lv_style_reset before reuse)
+    Kind kind;
+    bool transparent;
+    uint32_t color;
+    lv_style_t base;
+    lv_style_t pressed;     // fills only
+};
+
+Entry g_entries[kEntries];
+uint32_t g_fallbacks = 0;
+
+struct Constant {
+    bool inited;
+    lv_style_t style;
+};
+
+Constant g_buttonFrame;
+Constant g_labelBase;
+Constant g_iconBase;
+Constant g_segmentMain;
+Constant g_segmentKnob;
+Constant g_segmentIndicator;
+
+lv_style_transition_dsc_t g_fillTrans;
+bool g_fillTransInited = false;
+
+inline uint8_t rgb565Luma(lv_color_t c) {
+    // LV_COLOR_DEPTH is 16 (RGB565) in this project.
+    // Use LVGL's channel accessors so this stays correct with LV_COLOR_16_SWAP.
+    const uint8_t r5 = (uint8_t)LV_COLOR_GET_R(c);
+    const uint8_t g6 = (uint8_t)LV_COLOR_GET_G(c);
+    const uint8_t b5 = (uint8_t)LV_COLOR_GET_B(c);
+
+    const uint8_t r8 = (uint8_t)((r5 * 255u) / 31u);
+    const uint8_t g8 = (uint8_t)((g6 * 255u) / 63u);
+    const uint8_t b8 = (uint8_t)((b5 * 255u) / 31u);
+
+    // ITU-R BT.601-ish luma approximation.
+    return (uint8_t)((uint16_t)(r8 * 77u + g8 * 150u + b8 * 29u) >> 8);
+}
+
+inline lv_color_t flashColorFor(lv_color_t base) {
+    // Luminance-aware: brighten dark colors, darken bright colors.
+    const uint8_t luma = rgb565Luma(base);
+    const lv_color_t target = (luma >= 160) ? lv_color_black() : lv_color_white();
+    // lv_color_mix(c1, c2, mix): mix=0 => c2, mix=255 => c1
+    return lv_color_mix(target, base, 80);
+}
+
+const lv_style_transition_dsc_t* fillTransition() {
+    if (!g_fillTransInited) {
+        static const lv_style_prop_t props[] = {
+            (lv_style_prop_t)LV_STYLE_BG_COLOR,
+            (lv_style_prop_t)LV_STYLE_BG_OPA,
+            (lv_style_prop_t)LV_STYLE_PROP_INV,
+        };
+        lv_style_transition_dsc_init(&g_fillTrans, props, lv_anim_path_ease_out, 160, 0, nullptr);
+        g_fillTransInited = true;
+    }
+    return &g_fillTrans;
+}
+
+bool isFill(Kind kind) {
+    return kind == Kind::ButtonFill || kind == Kind::SegmentFill;
+}
+
+void buildEntry(Entry& e, Kind kind, uint32_t color, bool transparent) {
+    const lv_color_t c = lv_color_hex(color);
+    e.kind = kind;
+    e.color = color;
+    e.transparent = transparent;
+    if (e.built) {
+        lv_style_reset(&e.base);
+        lv_style_reset(&e.pressed);
+    }
+    lv_style_init(&e.base);
+    lv_style_init(&e.pressed);
+    e.built = true;
+
+    switch (kind) {
+        case Kind::ButtonFill: {
+            const lv_opa_t opa = transparent ? LV_OPA_TRANSP : LV_OPA_COVER;
+            lv_style_set_bg_opa(&e.base, opa);
+            lv_style_set_bg_color(&e.base, c);
+            lv_style_set_transition(&e.base, fillTransition());
+            lv_style_set_bg_opa(&e.pressed, opa);
+            lv_style_set_bg_color(&e.pressed, flashColorFor(c));
+            break;
+        }
+        case Kind::SegmentFill:
+            // NOTE: We intentionally do NOT animate arc color/opacity transitions.
+            // On some targets the arc (indicator) transition can produce visible color
+            // artifacts during redraw (reported as “yellow flicker” on red wedges).
+            lv_style_set_arc_opa(&e.base, LV_OPA_COVER);
+            lv_style_set_arc_color(&e.base, c);
+            lv_style_set_arc_opa(&e.pressed, LV_OPA_COVER);
+            lv_style_set_arc_color(&e.pressed, flashColorFor(c));
+            break;
+        case Kind::LabelColor:
+            lv_style_set_text_color(&e.base, c);
+            break;
+        case Kind::IconTint:
+            lv_style_set_img_recolor(&e.base, c);
+            lv_style_set_img_recolor_opa(&e.base, LV_OPA_COVER);
+            break;
+    }
+}
+
+bool matches(const Entry& e, Kind kind, uint32_t color, bool transparent) {
+    return e.refs && e.kind == kind && e.color == color && e.transparent == transparent;
+}
+
+// The entry for the key with a new reference; kNone when the table is full.
+uint8_t acquire(Kind kind, uint32_t color, bool transparent) {
+    uint8_t free_idx = kNone;
+    for (uint8_t i = 0; i < kEntries; i++) {
+        if (matches(g_entries[i], kind, color, transparent)) {
+            g_entries[i].refs++;
+            return i;
+        }
+        if (!g_entries[i].refs && free_idx == kNone) free_idx = i;
+    }
+    if (free_idx == kNone) return kNone;
+    // Unreferenced, so no object shows it: safe to rebuild in place.
+    buildEntry(g_entries[free_idx], kind, color, transparent);
+    g_entries[free_idx].refs = 1;
+    return free_idx;
+}
+
+void release(uint8_t idx) {
+    if (idx < kEntries && g_entries[idx].refs) g_entries[idx].refs--;
+}
+
+void addEntry(lv_obj_t* obj, lv_part_t part, Entry& e) {
+    lv_obj_add_style(obj, &e.base, part);
+    if (isFill(e.kind)) lv_obj_add_style(obj, &e.pressed, part | kPressCueState);
+}
+
+void removeEntry(lv_obj_t* obj, lv_part_t part, Entry& e) {
+    lv_obj_remove_style(obj, &e.base, part);
+    if (isFill(e.kind)) lv_obj_remove_style(obj, &e.pressed, part | kPressCueState);
+}
+
+// Local copies of an entry's properties, for when the table is full. They
+// outrank shared styles, so attach() clears them again.
+void setLocal(lv_obj_t* obj, lv_part_t part, Kind kind, uint32_t color, bool transparent) {
+    const lv_color_t c = lv_color_hex(color);
+    switch (kind) {
+        case Kind::ButtonFill: {
+            const lv_opa_t opa = transparent ? LV_OPA_TRANSP : LV_OPA_COVER;
+            lv_obj_set_style_bg_opa(obj, opa, part);
+            lv_obj_set_style_bg_color(obj, c, part);
+            lv_obj_set_style_bg_opa(obj, opa, part | kPressCueState);
+            lv_obj_set_style_bg_color(obj, flashColorFor(c), part | kPressCueState);
+            break;
+        }
+        case Kind::SegmentFill:
+            lv_obj_set_style_arc_opa(obj, LV_OPA_COVER, part);
+            lv_obj_set_style_arc_color(obj, c, part);
+            lv_obj_set_style_arc_opa(obj, LV_OPA_COVER, part | kPressCueState);
+            lv_obj_set_style_arc_color(obj, flashColorFor(c), part | kPressCueState);
+            break;
+        case Kind::LabelColor:
+            lv_obj_set_style_text_color(obj, c, part);
+            break;
+        case Kind::IconTint:
+            lv_obj_set_style_img_recolor(obj, c, part);
+            lv_obj_set_style_img_recolor_opa(obj, LV_OPA_COVER, part);
+            break;
+    }
+}
+
+void clearLocal(lv_obj_t* obj, lv_part_t part, Kind kind) {
+    switch (kind) {
+        case Kind::ButtonFill:
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_BG_OPA, part);
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_BG_COLOR, part);
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_BG_OPA, part | kPressCueState);
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_BG_COLOR, part | kPressCueState);
+            break;
+        case Kind::SegmentFill:
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_ARC_OPA, part);
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_ARC_COLOR, part);
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_ARC_OPA, part | kPressCueState);
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_ARC_COLOR, part | kPressCueState);
+            break;
+        case Kind::LabelColor:
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_TEXT_COLOR, part);
+            break;
+        case Kind::IconTint:
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_IMG_RECOLOR, part);
+            lv_obj_remove_local_style_prop(obj, LV_STYLE_IMG_RECOLOR_OPA, part);
+            break;
+    }
+}
+
+lv_style_t* constant(Constant& c, void (*build)(lv_style_t*)) {
+    if (!c.inited) {
+        lv_style_init(&c.style);
+        build(&c.style);
+        c.inited = true;
+    }
+    return &c.style;
+}
+
+} // namespace
+
+lv_style_t* buttonFrame() {
+    return constant(g_buttonFrame, [](lv_style_t* s) {
+        lv_style_set_border_width(s, 0);
+        lv_style_set_outline_width(s, 0);
+        lv_style_set_outline_pad(s, 0);
+        lv_style_set_shadow_width(s, 0);
+        lv_style_set_pad_all(s, 0);
+    });
+}
+
+lv_style_t* labelBase() {
+    return constant(g_labelBase, [](lv_style_t* s) {
+        lv_style_set_text_align(s, LV_TEXT_ALIGN_CENTER);
+        lv_style_set_text_color(s, lv_color_white());
+        #if LABEL_FONT_ENABLED
+        // Stable proxy: renders as the default font until one is loaded from FFat.
+        lv_style_set_text_font(s, label_font_get());
+        #endif
+    });
+}
+
+lv_style_t* iconBase() {
+    return constant(g_iconBase, [](lv_style_t* s) {
+        // Some themes/style cascades can apply LV_STYLE_OPA to children.
+        // Force the object itself to be opaque so the image can render.
+        lv_style_set_opa(s, LV_OPA_COVER);
+        // Alpha-only images (LV_IMG_CF_ALPHA_*) are tinted via style.img_recolor, but
+        // they still respect style.img_opa. Force to opaque so theme defaults can't
+        // accidentally hide icons.
+        lv_style_set_img_opa(s, LV_OPA_COVER);
+        // No recolor unless an IconTint entry is attached (mask icons).
+        lv_style_set_img_recolor_opa(s, LV_OPA_TRANSP);
+    });
+}
+
+lv_style_t* segmentMain() {
+    return constant(g_segmentMain, [](lv_style_t* s) {
+        lv_style_set_bg_opa(s, LV_OPA_TRANSP);
+        lv_style_set_border_width(s, 0);
+        lv_style_set_pad_all(s, 0);
+        // Disable the background arc.
+        lv_style_set_arc_opa(s, LV_OPA_TRANSP);
+    });
+}
+
+lv_style_t* segmentKnob() {
+    return constant(g_segmentKnob, [](lv_style_t* s) {
+        lv_style_set_bg_opa(s, LV_OPA_TRANSP);
+        lv_style_set_border_width(s, 0);
+    });
+}
+
+lv_style_t* segmentIndicator() {
+    return constant(g_segmentIndicator, [](lv_style_t* s) {
+        lv_style_set_arc_rounded(s, false);
+    });
+}
+
+void attach(lv_obj_t* obj, lv_part_t part, uint8_t* slot, Kind kind, uint32_t color, bool transparent) {
+    if (!obj || !slot) return;
+    const uint8_t old = *slot;
+    if (old < kEntries && matches(g_entries[old], kind, color, transparent)) return;
+
+    const uint8_t idx = acquire(kind, color, transparent);
+    if (old < kEntries) {
+        removeEntry(obj, part, g_entries[old]);
+        release(old);
+    }
+    *slot = idx;
+    if (idx == kNone) {
+        g_fallbacks++;
+        setLocal(obj, part, kind, color, transparent);
+        return;
+    }
+    clearLocal(obj, part, kind);
+    addEntry(obj, part, g_entries[idx]);
+}
+
+void detach(lv_obj_t* obj, lv_part_t part, uint8_t* slot, Kind kind) {
+    if (!slot) return;
+    if (obj) clearLocal(obj, part, kind);
+    if (*slot >= kEntries) return;
+    if (obj) removeEntry(obj, part, g_entries[*slot]);
+    release(*slot);
+    *slot = kNone;
+}
+
+void getStats(Stats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    out->capacity = kEntries;
+    for (const Entry& e : g_entries) {
+        if (!e.refs) continue;
+        out->entries++;
+        out->refs += e.refs;
+    }
+    out->fallbacks = g_fallbacks;
+}
+
+} // namespace macropad_styles
@@ -0,0 +1,59 @@
+#ifndef MACROPAD_STYLES_H
+#define MACROPAD_STYLES_H
+
+#include <lvgl.h>
+#include <stdint.h>
+
+// Shared LVGL styles for the macro pad screens.
+//
+// Every button, label, icon and pie segment of every MacroPadScreen attaches
+// the same few lv_style_t objects instead of carrying local style arrays:
+// constant ones for what never changes (frame, alignment, font), and
+// reference-counted entries keyed by the resolved colour for what the config
+// sets. Sixteen buttons in one colour across eight screens share one entry.
+// LVGL task only.
+
+namespace macropad_styles {
+
+// State that shows the press cue (pressed, held for kMinPressCueMs, or busy).
+constexpr lv_state_t kPressCueState = LV_STATE_USER_1;
+
+// No entry attached.
+constexpr uint8_t kNone = 0xFF;
+
+enum class Kind : uint8_t {
+    ButtonFill,   // bg colour + press-cue flash, fading between them (transparent: pie ring)
+    SegmentFill,  // pie segment arc colour + press-cue flash
+    LabelColor,   // text colour
+    IconTint,     // recolour of mask icons
+};
+
+// Constant styles, built on first use.
+lv_style_t* buttonFrame();     // no border, outline, shadow or padding
+lv_style_t* labelBase();       // centred, white, label font
+lv_style_t* iconBase();        // opaque, not recoloured
+lv_style_t* segmentMain();     // no background arc
+lv_style_t* segmentKnob();     // no knob
+lv_style_t* segmentIndicator(); // square arc ends
+
+// Attach the entry for (kind, color) to obj's part, replacing the one *slot
+// refers to. A no-op when it already shows it. With the table full the
+// colour is set as local styles instead and *slot becomes kNone.
+void attach(lv_obj_t* obj, lv_part_t part, uint8_t* slot, Kind kind, uint32_t color, bool transparent = false);
+
+// Remove *slot's entry (or its local fallback) from obj and drop the
+// reference. obj may be nullptr once deleted.
+void detach(lv_obj_t* obj, lv_part_t part, uint8_t* slot, Kind kind);
+
+struct Stats {
+    uint8_t entries;      // in use
+    uint8_t capacity;
+    uint32_t refs;        // objects attached
+    uint32_t fallbacks;   // attaches that fell back to local styles (table full)
+};
+
+void getStats(Stats* out);
+
+} // namespace macropad_styles
+
+#endif // MACROPAD_STYLES_H
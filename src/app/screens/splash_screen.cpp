@@ -34,6 +34,16 @@ static void layoutSplashBlock(lv_obj_t* screen, lv_obj_t* logoImg, lv_obj_t* sta
     lv_obj_align_to(spinner, statusLabel, LV_ALIGN_OUT_BOTTOM_MID, 0, gap_status_to_spinner);
 }
 
+static lv_obj_t* createSpinner(lv_obj_t* screen) {
+    lv_obj_t* spinner = lv_spinner_create(screen, 1000, 60);
+    lv_obj_set_size(spinner, 40, 40);
+    lv_obj_set_style_arc_color(spinner, lv_color_make(0, 150, 255), LV_PART_INDICATOR);
+    lv_obj_set_style_arc_width(spinner, 4, LV_PART_INDICATOR);
+    lv_obj_set_style_arc_color(spinner, lv_color_make(40, 40, 40), LV_PART_MAIN);
+    lv_obj_set_style_arc_width(spinner, 4, LV_PART_MAIN);
+    return spinner;
+}
+
 SplashScreen::SplashScreen() : screen(nullptr), logoImg(nullptr), statusLabel(nullptr), spinner(nullptr) {}
 
 SplashScreen::~SplashScreen() {
@@ -66,12 +76,7 @@ void SplashScreen::create() {
     lv_obj_set_style_text_color(statusLabel, lv_color_make(100, 100, 100), 0);
 
     // Spinner to show activity
-    spinner = lv_spinner_create(screen, 1000, 60);
-    lv_obj_set_size(spinner, 40, 40);
-    lv_obj_set_style_arc_color(spinner, lv_color_make(0, 150, 255), LV_PART_INDICATOR);
-    lv_obj_set_style_arc_width(spinner, 4, LV_PART_INDICATOR);
-    lv_obj_set_style_arc_color(spinner, lv_color_make(40, 40, 40), LV_PART_MAIN);
-    lv_obj_set_style_arc_width(spinner, 4, LV_PART_MAIN);
+    spinner = createSpinner(screen);
 
     // Position the whole block.
     layoutSplashBlock(screen, logoImg, statusLabel, spinner);
@@ -115,3 +120,19 @@ void SplashScreen::setStatus(const char* text) {
         Logger.logLine("ERROR: statusLabel is NULL!");
     }
 }
+
+void SplashScreen::setSpinnerVisible(bool visible) {
+    if (!screen || !spinner) return;
+    if (visible == !lv_obj_has_flag(spinner, LV_OBJ_FLAG_HIDDEN)) return;
+
+    if (visible) {
+        // Its animation was deleted when hidden; a fresh spinner restarts it.
+        lv_obj_del(spinner);
+        spinner = createSpinner(screen);
+        layoutSplashBlock(screen, logoImg, statusLabel, spinner);
+    } else {
+        // A hidden spinner would still keep the LVGL timers ticking.
+        lv_anim_del(spinner, nullptr);
+        lv_obj_add_flag(spinner, LV_OBJ_FLAG_HIDDEN);
+    }
+}
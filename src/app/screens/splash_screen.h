@@ -29,6 +29,9 @@ public:
     
     // Update status text (e.g., "Initializing WiFi...")
     void setStatus(const char* text);
+
+    // Hide the spinner for a fully static screen (nothing left to animate).
+    void setSpinnerVisible(bool visible);
 };
 
 #endif // SPLASH_SCREEN_H
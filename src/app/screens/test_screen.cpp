@@ -3,11 +3,19 @@
 #include "../board_config.h"
 #include "../display_manager.h"
 
+#if BENCH_ENABLED
+#include "../bench.h"
+#endif
+
 TestScreen::TestScreen(DisplayManager* manager) 
     : screen(nullptr), displayMgr(manager),
       titleLabel(nullptr), redBar(nullptr), greenBar(nullptr), blueBar(nullptr),
       gradientBar(nullptr), yellowBar(nullptr), cyanBar(nullptr), magentaBar(nullptr),
-      infoLabel(nullptr) {}
+      infoLabel(nullptr)
+#if BENCH_ENABLED
+      , benchShownState(0xFF), benchShownPhase(nullptr)
+#endif
+{}
 
 TestScreen::~TestScreen() {
     destroy();
@@ -101,12 +109,20 @@ void TestScreen::create() {
     char info_text[32];
     snprintf(info_text, sizeof(info_text), "%dx%d RGB565", DISPLAY_WIDTH, DISPLAY_HEIGHT);
     lv_label_set_text(infoLabel, info_text);
+    #if BENCH_ENABLED
+    benchShownState = 0xFF;
+    benchShownPhase = nullptr;
+    #endif
     lv_obj_set_style_text_color(infoLabel, lv_color_make(150, 150, 150), 0);
     lv_obj_align(infoLabel, LV_ALIGN_CENTER, 0, 85);
     lv_obj_clear_flag(infoLabel, LV_OBJ_FLAG_CLICKABLE);  // Click-transparent
     
     // Add touch event handler - tap anywhere to go to InfoScreen
-    lv_obj_add_event_cb(screen, touchEventCallback, LV_EVENT_CLICKED, this);
+    // (short click, so a long press does not also navigate away)
+    lv_obj_add_event_cb(screen, touchEventCallback, LV_EVENT_SHORT_CLICKED, this);
+    #if BENCH_ENABLED
+    lv_obj_add_event_cb(screen, longPressCallback, LV_EVENT_LONG_PRESSED, this);
+    #endif
     lv_obj_add_flag(screen, LV_OBJ_FLAG_CLICKABLE);
     
     Logger.logEnd();
@@ -139,7 +155,9 @@ void TestScreen::hide() {
 }
 
 void TestScreen::update() {
-    // Static screen - no dynamic updates needed
+    #if BENCH_ENABLED
+    setInfoText();
+    #endif
 }
 
 // Touch event callback - navigate to InfoScreen
@@ -149,3 +167,50 @@ void TestScreen::touchEventCallback(lv_event_t* e) {
         instance->displayMgr->showInfo();
     }
 }
+
+#if BENCH_ENABLED
+// Long press - start the benchmark suite (results at GET /api/bench)
+void TestScreen::longPressCallback(lv_event_t* e) {
+    TestScreen* instance = (TestScreen*)lv_event_get_user_data(e);
+    char err[64];
+    if (!bench_start(nullptr, 0, err, sizeof(err))) {
+        Logger.logMessagef("TestScreen", "Bench not started: %s", err);
+    }
+    if (instance) instance->setInfoText();
+}
+
+void TestScreen::setInfoText() {
+    if (!infoLabel) return;
+    const char* phase = nullptr;
+    const BenchState state = bench_get_state(&phase);
+    if ((uint8_t)state == benchShownState && phase == benchShownPhase) return;
+    benchShownState = (uint8_t)state;
+    benchShownPhase = phase;
+
+    char text[48];
+    switch (state) {
+        case BenchState::Running:
+            snprintf(text, sizeof(text), "Bench: %s...", phase ? phase : "starting");
+            break;
+        case BenchState::Done: {
+            const BenchDisplayResult* r = bench_display_result();
+            if (r->ran && r->flush_us && r->redraw_us) {
+                // Tenths of MB/s and whole frames per second.
+                const uint64_t bytes = (uint64_t)r->width * r->height * 2u * r->frames;
+                snprintf(text, sizeof(text), "Flush %u.%u MB/s, %u fps",
+                    (unsigned)(bytes * 10 / r->flush_us / 10), (unsigned)(bytes * 10 / r->flush_us % 10),
+                    (unsigned)((uint64_t)r->frames * 1000000u / r->redraw_us));
+            } else {
+                snprintf(text, sizeof(text), "Bench done");
+            }
+            break;
+        }
+        case BenchState::Failed:
+            snprintf(text, sizeof(text), "Bench failed");
+            break;
+        default:
+            return;  // keep the resolution line
+    }
+    lv_label_set_text(infoLabel, text);
+}
+#endif
@@ -2,6 +2,7 @@
 #define TEST_SCREEN_H
 
 #include "screen.h"
+#include "../board_config.h"
 #include <lvgl.h>
 
 // Forward declaration
@@ -12,6 +13,8 @@ class DisplayManager;
 // ============================================================================
 // Display calibration and testing screen with color bars and gradients.
 // Designed for round 240x240 minimum - gradient centered for maximum width.
+// Tap: back to the info screen. Long press (BENCH_ENABLED): run the benchmark
+// suite; the bottom line shows its progress and a summary.
 
 class TestScreen : public Screen {
 private:
@@ -31,6 +34,14 @@ private:
     
     // Touch event handler (static callback)
     static void touchEventCallback(lv_event_t* e);
+
+    #if BENCH_ENABLED
+    // Benchmark state last shown in infoLabel (BenchState, 0xFF = none).
+    uint8_t benchShownState;
+    const char* benchShownPhase;
+    static void longPressCallback(lv_event_t* e);
+    void setInfoText();
+    #endif
     
 public:
     TestScreen(DisplayManager* manager);
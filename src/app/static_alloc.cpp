@@ -0,0 +1,256 @@
+#include "static_alloc.h"
+
+#include "log_manager.h"
+
+#include <Arduino.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <multi_heap.h>
+#include <sdkconfig.h>
+#include <soc/soc_caps.h>
+#include <string.h>
+
+#if defined(CONFIG_HEAP_USE_HOOKS) && CONFIG_HEAP_USE_HOOKS
+#define STATIC_ALLOC_HOOKS 1
+#else
+#define STATIC_ALLOC_HOOKS 0
+#endif
+
+namespace {
+
+constexpr size_t kTags = (size_t)HeapTag::Count;
+
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+bool g_booted = false;
+uint32_t g_boot_ms = 0;
+uint32_t g_boot_allocs[kTags] = {};
+
+#if STATIC_ALLOC_HOOKS
+volatile bool g_hook_counting = false;
+uint32_t g_hook_allocs = 0;
+#endif
+
+#if HEAP_TAGS_ENABLED
+uint32_t tag_allocs(HeapTag tag) {
+    HeapTagStats st[(size_t)HeapKind::Count];
+    heap_tag_get_stats(tag, st);
+    uint32_t n = 0;
+    for (const HeapTagStats& k : st) n += k.allocs;
+    return n;
+}
+#endif
+
+#if STATIC_ALLOC_MODE
+
+struct Arena {
+    HeapTag tag;
+    size_t budget;
+    portMUX_TYPE mux;
+    multi_heap_handle_t heap;
+    uint8_t* start;
+    size_t bytes;
+    size_t total;           // free bytes right after registration
+    bool psram;
+    uint32_t overflows;
+};
+
+Arena g_arenas[] = {
+    {HeapTag::Image, STATIC_ALLOC_IMAGE_BYTES, portMUX_INITIALIZER_UNLOCKED, nullptr, nullptr, 0, 0, false, 0},
+    {HeapTag::Json, STATIC_ALLOC_JSON_BYTES, portMUX_INITIALIZER_UNLOCKED, nullptr, nullptr, 0, 0, false, 0},
+    {HeapTag::Icons, STATIC_ALLOC_ICONS_BYTES, portMUX_INITIALIZER_UNLOCKED, nullptr, nullptr, 0, 0, false, 0},
+    {HeapTag::Http, STATIC_ALLOC_HTTP_BYTES, portMUX_INITIALIZER_UNLOCKED, nullptr, nullptr, 0, 0, false, 0},
+    {HeapTag::Other, STATIC_ALLOC_OTHER_BYTES, portMUX_INITIALIZER_UNLOCKED, nullptr, nullptr, 0, 0, false, 0},
+};
+
+Arena* arena_for(HeapTag tag) {
+    for (Arena& a : g_arenas) {
+        if (a.tag == tag) return a.heap ? &a : nullptr;
+    }
+    return nullptr;
+}
+
+Arena* arena_owning(const void* ptr) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    for (Arena& a : g_arenas) {
+        if (a.heap && p >= a.start && p < a.start + a.bytes) return &a;
+    }
+    return nullptr;
+}
+
+// Whether memory from this arena satisfies the caller's caps.
+bool caps_ok(const Arena& a, uint32_t caps) {
+    if (caps & (MALLOC_CAP_DMA | MALLOC_CAP_EXEC)) return false;
+    if (a.psram) return !(caps & MALLOC_CAP_INTERNAL);
+    return !(caps & MALLOC_CAP_SPIRAM);
+}
+
+// Only the steady state counts: boot-time blocks (the image pool) are meant to be larger.
+void note_overflow(Arena* a) {
+    if (g_booted) __atomic_add_fetch(&a->overflows, 1, __ATOMIC_RELAXED);
+}
+
+#endif // STATIC_ALLOC_MODE
+
+} // namespace
+
+void static_alloc_init() {
+#if STATIC_ALLOC_MODE
+    static bool done = false;
+    if (done) return;
+    done = true;
+
+    bool psram = false;
+#if SOC_SPIRAM_SUPPORTED
+    psram = psramFound();
+#endif
+    const uint32_t caps = psram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    size_t reserved = 0;
+    for (Arena& a : g_arenas) {
+        if (a.budget == 0) continue;
+        // The arena itself shows up under its tag like the LVGL arena.
+        void* block = heap_tag_malloc(a.tag, a.budget, caps);
+        if (!block) {
+            Logger.logMessagef("StaticAlloc", "%s arena: %u bytes not available", heap_tag_name(a.tag), (unsigned)a.budget);
+            continue;
+        }
+        multi_heap_handle_t heap = multi_heap_register(block, a.budget);
+        if (!heap) {
+            heap_tag_free(a.tag, block);
+            continue;
+        }
+        multi_heap_set_lock(heap, &a.mux);
+        a.start = (uint8_t*)block;
+        a.bytes = a.budget;
+        a.total = multi_heap_free_size(heap);
+        a.psram = psram;
+        a.heap = heap;
+        reserved += a.budget;
+    }
+    Logger.logMessagef("StaticAlloc", "Reserved %u bytes of arenas in %s", (unsigned)reserved, psram ? "PSRAM" : "internal RAM");
+#endif
+}
+
+void static_alloc_boot_complete() {
+    portENTER_CRITICAL(&g_mux);
+    const bool already = g_booted;
+    g_booted = true;
+    portEXIT_CRITICAL(&g_mux);
+    if (already) return;
+
+    g_boot_ms = millis();
+#if HEAP_TAGS_ENABLED
+    for (size_t t = 0; t < kTags; t++) g_boot_allocs[t] = tag_allocs((HeapTag)t);
+#endif
+#if STATIC_ALLOC_HOOKS
+    __atomic_store_n(&g_hook_allocs, 0, __ATOMIC_RELAXED);
+    g_hook_counting = true;
+#endif
+    Logger.logMessagef("StaticAlloc", "Boot complete at %lu ms; counting heap allocations from here", (unsigned long)g_boot_ms);
+}
+
+void static_alloc_get_stats(StaticAllocStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    out->booted = g_booted;
+    out->boot_ms = g_boot_ms;
+#if STATIC_ALLOC_HOOKS
+    out->all_counted = true;
+    out->all_allocs_after_boot = __atomic_load_n(&g_hook_allocs, __ATOMIC_RELAXED);
+#endif
+#if HEAP_TAGS_ENABLED
+    if (!g_booted) return;
+    for (size_t t = 0; t < kTags; t++) {
+        const uint32_t now = tag_allocs((HeapTag)t);
+        // A resize takes a count back (heap_tag_realloc), so it can dip below the snapshot.
+        out->tag_allocs[t] = now > g_boot_allocs[t] ? now - g_boot_allocs[t] : 0;
+        out->allocs_after_boot += out->tag_allocs[t];
+    }
+#endif
+}
+
+bool static_alloc_get_arena_stats(HeapTag tag, StaticArenaStats* out) {
+    if (!out) return false;
+    memset(out, 0, sizeof(*out));
+#if STATIC_ALLOC_MODE
+    Arena* a = arena_for(tag);
+    if (!a) return false;
+    multi_heap_info_t info;
+    multi_heap_get_info(a->heap, &info);
+    out->reserved = true;
+    out->psram = a->psram;
+    out->total_bytes = (uint32_t)a->total;
+    out->used_bytes = (uint32_t)(a->total > info.total_free_bytes ? a->total - info.total_free_bytes : 0);
+    out->peak_bytes = (uint32_t)(a->total > info.minimum_free_bytes ? a->total - info.minimum_free_bytes : 0);
+    out->overflows = __atomic_load_n(&a->overflows, __ATOMIC_RELAXED);
+    return true;
+#else
+    (void)tag;
+    return false;
+#endif
+}
+
+#if STATIC_ALLOC_MODE
+
+void* static_alloc_arena_malloc(HeapTag tag, size_t size, uint32_t caps) {
+    Arena* a = arena_for(tag);
+    if (!a || size == 0) return nullptr;
+    if (!caps_ok(*a, caps)) {
+        note_overflow(a);
+        return nullptr;
+    }
+    void* p = multi_heap_malloc(a->heap, size);
+    if (!p) note_overflow(a);
+    return p;
+}
+
+void* static_alloc_arena_aligned_alloc(HeapTag tag, size_t alignment, size_t size, uint32_t caps) {
+    Arena* a = arena_for(tag);
+    if (!a || size == 0) return nullptr;
+    if (!caps_ok(*a, caps)) {
+        note_overflow(a);
+        return nullptr;
+    }
+    void* p = multi_heap_aligned_alloc(a->heap, size, alignment);
+    if (!p) note_overflow(a);
+    return p;
+}
+
+void* static_alloc_arena_realloc(void* ptr, size_t size) {
+    Arena* a = arena_owning(ptr);
+    if (!a) return nullptr;
+    void* p = multi_heap_realloc(a->heap, ptr, size);
+    if (!p) note_overflow(a);
+    return p;
+}
+
+bool static_alloc_owns(const void* ptr) {
+    return ptr && arena_owning(ptr) != nullptr;
+}
+
+size_t static_alloc_block_size(void* ptr) {
+    Arena* a = arena_owning(ptr);
+    return a ? multi_heap_get_allocated_size(a->heap, ptr) : 0;
+}
+
+void static_alloc_arena_free(void* ptr) {
+    Arena* a = arena_owning(ptr);
+    if (a) multi_heap_free(a->heap, ptr);
+}
+
+#endif // STATIC_ALLOC_MODE
+
+#if STATIC_ALLOC_HOOKS
+// Every heap_caps allocation, including the untagged ones. Called with the
+// heap lock held and possibly from an ISR: count and return.
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+    (void)ptr;
+    (void)size;
+    (void)caps;
+    if (g_hook_counting) __atomic_add_fetch(&g_hook_allocs, 1, __ATOMIC_RELAXED);
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+    (void)ptr;
+}
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+/*
+ * Static allocation (STATIC_ALLOC_MODE) and the post-boot allocation counter.
+ *
+ * In static mode each subsystem with a STATIC_ALLOC_<TAG>_BYTES budget gets
+ * an arena reserved at the start of setup(), while the heap is still whole,
+ * and managed by ESP-IDF's TLSF multi_heap like the LVGL arena. Tagged
+ * allocations for that tag (heap_tag_malloc() and heap_place_malloc()) are
+ * served inside the arena, so after boot they churn there and never reach
+ * the system heap. A request the arena cannot hold (full, or caps it cannot
+ * meet: DMA, or internal RAM when the arena is in PSRAM) takes the heap as
+ * before and is counted as an overflow: the budget is too small.
+ *
+ * The counter works in every build: static_alloc_boot_complete() snapshots
+ * the tagged allocation counts, and /api/health reports how many tagged heap
+ * allocations happened since (heap_allocs_after_boot). With arenas sized
+ * for the board it reads 0. When the core is built with CONFIG_HEAP_USE_HOOKS
+ * every heap_caps allocation is counted as well (String, lwIP, libraries).
+ *
+ * The LVGL arena (LVGL_ARENA_ENABLED) and the image pool are reserved at
+ * boot already; OTA buffers (the ota tag) are not, so an update shows up.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_config.h"
+#include "heap_tags.h"
+
+#if STATIC_ALLOC_MODE && !HEAP_TAGS_ENABLED
+#error "STATIC_ALLOC_MODE needs HEAP_TAGS_ENABLED (arenas hook the tagged allocator)"
+#endif
+
+struct StaticArenaStats {
+    bool reserved;
+    bool psram;
+    uint32_t total_bytes;
+    uint32_t used_bytes;
+    uint32_t peak_bytes;
+    uint32_t overflows;     // after boot, served by the heap instead: arena full or caps it cannot meet
+};
+
+struct StaticAllocStats {
+    bool booted;                                  // static_alloc_boot_complete() ran
+    uint32_t boot_ms;
+    uint32_t allocs_after_boot;                   // tagged heap allocations since boot
+    uint32_t tag_allocs[(size_t)HeapTag::Count];  // the same per tag
+    bool all_counted;                             // heap hooks present
+    uint32_t all_allocs_after_boot;               // every heap_caps allocation since boot
+};
+
+// Reserve the arenas (static mode; no-op otherwise). Call once, early in setup().
+void static_alloc_init();
+
+// Boot is over: later heap allocations count against the steady state. Idempotent.
+void static_alloc_boot_complete();
+
+void static_alloc_get_stats(StaticAllocStats* out);
+
+// Arena for tag; false when it has none.
+bool static_alloc_get_arena_stats(HeapTag tag, StaticArenaStats* out);
+
+#if STATIC_ALLOC_MODE
+// Used by heap_tags.cpp. Arena malloc returns nullptr when the tag has no
+// arena or the arena cannot serve the request (the caller uses the heap).
+void* static_alloc_arena_malloc(HeapTag tag, size_t size, uint32_t caps);
+void* static_alloc_arena_aligned_alloc(HeapTag tag, size_t alignment, size_t size, uint32_t caps);
+// Resize inside the arena; nullptr when it does not fit there (ptr stays valid).
+void* static_alloc_arena_realloc(void* ptr, size_t size);
+bool static_alloc_owns(const void* ptr);
+size_t static_alloc_block_size(void* ptr);
+void static_alloc_arena_free(void* ptr);
+#endif
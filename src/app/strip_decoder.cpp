@@ -1,239 +1,188 @@
 /*
  * Strip Decoder Implementation
  * 
- * Decodes JPEG strips using TJpgDec and writes directly to LCD via DisplayDriver.
- * Performs RGB→BGR color swap during pixel write.
+ * Decodes JPEG strips through the board's JpegEngine and writes directly to
+ * the LCD via DisplayDriver. RGB888 blocks (TJpgDec) are packed to the
+ * driver's RGB565/BGR565 wire order; RGB565 engines already emit it.
  */
 
 #include "board_config.h"
 
+#define LOGGER_MODULE_LEVEL LOG_LEVEL_IMAGE
+
 #if HAS_IMAGE_API
 
 #include "strip_decoder.h"
 #include "display_driver.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
+#include "image_profile.h"
+#include "jpeg_engine.h"
+#include "jpeg_preflight.h"
 #include "log_manager.h"
+#include "rgb888_pack.h"
 
 #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
     #include <esp_heap_caps.h>
 #endif
 
-// Use the ESP-ROM TJpgDec types/signatures. This matches the ROM-provided jd_prepare/jd_decomp
-// symbols used by the ESP32 Arduino core.
-//
-// Note: not all Arduino-ESP32 installs ship headers for every ESP32-family target.
-// We select based on the IDF target macro when available, and fall back to
-// __has_include for toolchains that don't define CONFIG_IDF_TARGET_*.
-#if defined(CONFIG_IDF_TARGET_ESP32)
-    #include <esp32/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32S2)
-    #if __has_include(<esp32s2/rom/tjpgd.h>)
-        #include <esp32s2/rom/tjpgd.h>
-    #else
-        #error "Missing <esp32s2/rom/tjpgd.h> in this Arduino-ESP32 install"
-    #endif
-#elif defined(CONFIG_IDF_TARGET_ESP32S3)
-    #include <esp32s3/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32C2)
-    #if __has_include(<esp32c2/rom/tjpgd.h>)
-        #include <esp32c2/rom/tjpgd.h>
-    #else
-        #error "Missing <esp32c2/rom/tjpgd.h> in this Arduino-ESP32 install"
-    #endif
-#elif defined(CONFIG_IDF_TARGET_ESP32C3)
-    #include <esp32c3/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32C5)
-    #include <esp32c5/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32C6)
-    #include <esp32c6/rom/tjpgd.h>
-#elif defined(CONFIG_IDF_TARGET_ESP32H2)
-    #if __has_include(<esp32h2/rom/tjpgd.h>)
-        #include <esp32h2/rom/tjpgd.h>
-    #else
-        #error "Missing <esp32h2/rom/tjpgd.h> in this Arduino-ESP32 install"
-    #endif
-#elif defined(CONFIG_IDF_TARGET_ESP32P4)
-    #if __has_include(<esp32p4/rom/tjpgd.h>)
-        #include <esp32p4/rom/tjpgd.h>
-    #else
-        #error "Missing <esp32p4/rom/tjpgd.h> in this Arduino-ESP32 install"
-    #endif
-#else
-    // Fallback for unknown targets - try common variants
-    #if __has_include(<esp32/rom/tjpgd.h>)
-        #include <esp32/rom/tjpgd.h>
-    #elif __has_include(<esp32s3/rom/tjpgd.h>)
-        #include <esp32s3/rom/tjpgd.h>
-    #elif __has_include(<esp32c6/rom/tjpgd.h>)
-        #include <esp32c6/rom/tjpgd.h>
-    #elif __has_include(<esp32c5/rom/tjpgd.h>)
-        #include <esp32c5/rom/tjpgd.h>
-    #elif __has_include(<esp32c3/rom/tjpgd.h>)
-        #include <esp32c3/rom/tjpgd.h>
-    #elif __has_include(<esp32s2/rom/tjpgd.h>)
-        #include <esp32s2/rom/tjpgd.h>
-    #elif __has_include(<esp32c2/rom/tjpgd.h>)
-        #include <esp32c2/rom/tjpgd.h>
-    #elif __has_include(<esp32h2/rom/tjpgd.h>)
-        #include <esp32h2/rom/tjpgd.h>
-    #elif __has_include(<esp32p4/rom/tjpgd.h>)
-        #include <esp32p4/rom/tjpgd.h>
-    #else
-        #error "Unsupported ESP32 target for TJpgDec (no ROM tjpgd.h found)"
-    #endif
-#endif
-
-// Input buffer context for TJpgDec
-struct JpegInputContext {
-    const uint8_t* data;
-    size_t size;
-    size_t pos;
-};
-
-// Output context for TJpgDec
+// Output context for the block callback
 struct JpegOutputContext {
     StripDecoder* decoder;
     DisplayDriver* driver;
+    int x_offset;
     int strip_y_offset;
     uint16_t* line_buffer;  // Buffer for one line of pixels
     int buffer_width;
     int lcd_width;
     int lcd_height;
     bool output_bgr565;     // true=BGR565, false=RGB565
+    bool big_endian;        // pack MSB-first (driver PixelOrder::BigEndian) so pushColors needs no swap
+    Rgb888PackFn pack;      // kernel for output_bgr565 / big_endian
 
     // Optional batch buffer to reduce LCD transactions.
     // Holds a small rectangle (typically 8-16 rows) of converted RGB565 pixels.
     uint16_t* batch_buffer;
     int batch_capacity_pixels;
     int batch_max_rows;
+
+    // Profiler totals for this decode.
+    uint32_t pack_us;
+    uint32_t push_us;
+    uint32_t pixels;
 };
 
-// TJpgDec uses a single opaque device pointer for the entire decode session.
-// Both the input function and output function must be able to access their
-// respective state through the same pointer.
 struct JpegSessionContext {
-    JpegInputContext input;
+    JpegEngineInput input;
     JpegOutputContext output;
+    uint32_t header_us;  // engine prepare, less stream waits
 };
 
-// TJpgDec input function - read from memory buffer
-// Signature must match ROM: UINT (*)(JDEC*, BYTE*, UINT)
-static UINT jpeg_input_func(JDEC* jd, BYTE* buff, UINT nbyte) {
-    JpegSessionContext* session = (JpegSessionContext*)jd->device;
-    if (!session) return 0;
-
-    JpegInputContext* ctx = &session->input;
-    if (!ctx->data) return 0;
-    if (ctx->pos >= ctx->size) return 0;
-
-    const size_t remaining = ctx->size - ctx->pos;
-    const size_t requested = (size_t)nbyte;
-    const size_t to_read = (requested < remaining) ? requested : remaining;
-
-    if (buff && to_read > 0) {
-        memcpy(buff, ctx->data + ctx->pos, to_read);
+// Push a block of RGB565 pixels that is already in the driver's wire order.
+static void push_rgb565_block(JpegOutputContext* ctx, const JpegBlock& block, int lcd_x, int lcd_y) {
+    const uint16_t* src = (const uint16_t*)block.pixels;
+    const uint32_t t0 = image_profile_now_us();
+    ctx->driver->startWrite();
+    if (block.stride == block.w) {
+        ctx->driver->setAddrWindow(lcd_x, lcd_y, block.w, block.h);
+        ctx->driver->pushColors((uint16_t*)src, (uint32_t)(block.w * block.h), false);
+    } else {
+        // Clipped MCU padding on the right: one row at a time.
+        for (int row = 0; row < block.h; row++) {
+            ctx->driver->setAddrWindow(lcd_x, lcd_y + row, block.w, 1);
+            ctx->driver->pushColors((uint16_t*)(src + (size_t)row * (size_t)block.stride), (uint32_t)block.w, false);
+        }
     }
-
-    ctx->pos += to_read;
-    return (UINT)to_read;
+    ctx->driver->endWrite();
+    ctx->push_us += image_profile_now_us() - t0;
 }
 
-// TJpgDec output function - convert RGB888→(BGR565 or RGB565) and write to LCD
-static UINT jpeg_output_func(JDEC* jd, void* bitmap, JRECT* rect) {
-    JpegSessionContext* session = (JpegSessionContext*)jd->device;
+// Block callback - convert RGB888→(BGR565 or RGB565) if needed and write to LCD
+static bool jpeg_output_func(void* session_ctx, const JpegBlock& block) {
+    JpegSessionContext* session = (JpegSessionContext*)session_ctx;
     JpegOutputContext* ctx = session ? &session->output : nullptr;
-    uint8_t* src = (uint8_t*)bitmap;
+    const uint8_t* src = (const uint8_t*)block.pixels;
     
     if (!ctx || !ctx->line_buffer || !ctx->driver) {
         Logger.logMessage("StripDecoder", "ERROR: Invalid context or line_buffer or driver");
-        return 0;
+        return false;
     }
     
-    const int rect_w = rect->right - rect->left + 1;
-    const int rect_h = rect->bottom - rect->top + 1;
+    const int rect_w = block.w;
+    const int rect_h = block.h;
 
     // Bounds check
     if (rect_w <= 0 || rect_h <= 0 || rect_w > ctx->buffer_width) {
         Logger.logMessagef("StripDecoder", "ERROR: Invalid rect (w=%d h=%d, buffer_width=%d)", rect_w, rect_h, ctx->buffer_width);
-        return 0;
+        return false;
     }
 
     // Target LCD coordinates for the whole rect
-    const int lcd_x = rect->left;
-    const int lcd_y = ctx->strip_y_offset + rect->top;
+    const int lcd_x = ctx->x_offset + block.x;
+    const int lcd_y = ctx->strip_y_offset + block.y;
     if (lcd_x < 0 || lcd_y < 0 || lcd_x + rect_w > ctx->lcd_width || lcd_y + rect_h > ctx->lcd_height) {
         Logger.logMessagef("StripDecoder", "ERROR: Invalid LCD rect: x=%d y=%d w=%d h=%d (LCD: %dx%d)",
                           lcd_x, lcd_y, rect_w, rect_h, ctx->lcd_width, ctx->lcd_height);
-        return 0;
+        return false;
     }
 
     const int rect_pixels = rect_w * rect_h;
+    if (block.format == JpegPixels::Rgb565) {
+        ctx->pixels += (uint32_t)rect_pixels;
+        push_rgb565_block(ctx, block, lcd_x, lcd_y);
+        if ((lcd_y & 0x03) == 0) {
+            taskYIELD();
+        }
+        return true;
+    }
+
     const bool can_batch = ctx->batch_buffer &&
                            (ctx->batch_max_rows > 1) &&
                            (rect_h <= ctx->batch_max_rows) &&
                            (rect_pixels <= ctx->batch_capacity_pixels);
 
+    ctx->pixels += (uint32_t)rect_pixels;
+
     if (can_batch) {
-        // Convert entire rect into contiguous RGB565 pixels
+        // Convert entire rect into contiguous pixels, already in the driver's wire order
+        const uint32_t t0 = image_profile_now_us();
         uint16_t* dst = ctx->batch_buffer;
-        for (int row = 0; row < rect_h; row++) {
-            for (int col = 0; col < rect_w; col++) {
-                uint8_t r = *src++;
-                uint8_t g = *src++;
-                uint8_t b = *src++;
-
-                if (ctx->output_bgr565) {
-                    dst[row * rect_w + col] = ((b & 0xF8) << 8) | ((g & 0xFC) << 3) | (r >> 3);
-                } else {
-                    dst[row * rect_w + col] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-                }
-            }
-        }
+        ctx->pack(src, dst, (size_t)rect_pixels);
 
         // Single LCD transaction for the whole rect
+        const uint32_t t1 = image_profile_now_us();
         ctx->driver->startWrite();
         ctx->driver->setAddrWindow(lcd_x, lcd_y, rect_w, rect_h);
-        ctx->driver->pushColors(dst, rect_pixels, true);
+        ctx->driver->pushColors(dst, rect_pixels, false);
         ctx->driver->endWrite();
+        ctx->pack_us += t1 - t0;
+        ctx->push_us += image_profile_now_us() - t1;
 
         // Yield periodically to prevent watchdog timeouts.
         if ((lcd_y & 0x03) == 0) {
             taskYIELD();
         }
 
-        return 1;
+        return true;
     }
 
     // Fallback: process each line (higher overhead but lower RAM).
-    for (int y = rect->top; y <= rect->bottom; y++) {
+    for (int y = block.y; y < block.y + rect_h; y++) {
         // Convert RGB888 to BGR565 or RGB565 for this line
-        for (int x = 0; x < rect_w; x++) {
-            uint8_t r = *src++;
-            uint8_t g = *src++;
-            uint8_t b = *src++;
-
-            if (ctx->output_bgr565) {
-                ctx->line_buffer[x] = ((b & 0xF8) << 8) | ((g & 0xFC) << 3) | (r >> 3);
-            } else {
-                ctx->line_buffer[x] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-            }
-        }
+        const uint32_t t0 = image_profile_now_us();
+        ctx->pack(src, ctx->line_buffer, (size_t)rect_w);
+        src += (size_t)rect_w * 3;
 
         const int line_lcd_y = ctx->strip_y_offset + y;
+        const uint32_t t1 = image_profile_now_us();
         ctx->driver->startWrite();
         ctx->driver->setAddrWindow(lcd_x, line_lcd_y, rect_w, 1);
-        ctx->driver->pushColors(ctx->line_buffer, rect_w, true);
+        ctx->driver->pushColors(ctx->line_buffer, rect_w, false);
         ctx->driver->endWrite();
+        ctx->pack_us += t1 - t0;
+        ctx->push_us += image_profile_now_us() - t1;
 
         if ((line_lcd_y & 0x03) == 0) {
             taskYIELD();
         }
     }
     
-    return 1;  // Continue decoding
+    return true;  // Continue decoding
 }
 
-// TJpgDec work buffer size (recommended minimum)
-static const size_t TJPGD_WORK_BUFFER_SIZE = 4096;
+// Hand one decode's stage totals to the profiler (decode = the rest of the wall time).
+static void report_profile(const JpegSessionContext& session, uint32_t start_us) {
+    const uint32_t wall = image_profile_now_us() - start_us;
+    const uint32_t other = session.input.read_us + session.header_us + session.output.pack_us + session.output.push_us;
+    const uint32_t bytes = (uint32_t)session.input.pos;
+    const uint32_t pixel_bytes = session.output.pixels * 2;
+
+    if (session.input.read) image_profile_add(IMAGE_STAGE_RECEIVE, session.input.read_us, bytes);
+    image_profile_add(IMAGE_STAGE_HEADER, session.header_us, bytes);
+    image_profile_add(IMAGE_STAGE_DECODE, wall > other ? wall - other : 0, bytes);
+    image_profile_add(IMAGE_STAGE_PACK, session.output.pack_us, pixel_bytes);
+    image_profile_add(IMAGE_STAGE_PUSH, session.output.push_us, pixel_bytes);
+}
 
 StripDecoder::StripDecoder() : driver(nullptr), width(0), height(0), lcd_width(0), lcd_height(0), current_y(0) {
 }
@@ -249,7 +198,7 @@ void StripDecoder::setDisplayDriver(DisplayDriver* drv) {
 void StripDecoder::free_buffers() {
     if (batch_buffer) {
         #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-            heap_caps_free(batch_buffer);
+            heap_tag_free(HeapTag::Image, batch_buffer);
         #else
             free(batch_buffer);
         #endif
@@ -260,7 +209,7 @@ void StripDecoder::free_buffers() {
 
     if (line_buffer) {
         #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-            heap_caps_free(line_buffer);
+            heap_tag_free(HeapTag::Image, line_buffer);
         #else
             free(line_buffer);
         #endif
@@ -268,15 +217,22 @@ void StripDecoder::free_buffers() {
     }
     line_buffer_width = 0;
 
-    if (work_buffer) {
-        #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-            heap_caps_free(work_buffer);
-        #else
-            free(work_buffer);
-        #endif
-        work_buffer = nullptr;
+    if (rom_engine != engine) {
+        jpeg_engine_destroy(rom_engine);
+    }
+    rom_engine = nullptr;
+    jpeg_engine_destroy(engine);
+    engine = nullptr;
+}
+
+JpegEngine* StripDecoder::tjpgd_engine() {
+    if (!rom_engine) {
+        rom_engine = jpeg_engine_create(JPEG_DECODER_TJPGD_ROM);
+        if (!rom_engine) {
+            Logger.logMessage("StripDecoder", "ERROR: Failed to allocate TJpgDec engine");
+        }
     }
-    work_buffer_size = 0;
+    return rom_engine;
 }
 
 bool StripDecoder::ensure_buffers() {
@@ -284,20 +240,18 @@ bool StripDecoder::ensure_buffers() {
         return false;
     }
 
-    // Work buffer (fixed size)
-    if (!work_buffer) {
-        work_buffer_size = TJPGD_WORK_BUFFER_SIZE;
-        #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-            // Prefer PSRAM to avoid internal heap dips during JPEG strip decode.
-            work_buffer = heap_caps_malloc(work_buffer_size, MALLOC_CAP_SPIRAM);
-            if (!work_buffer) {
-                work_buffer = heap_caps_malloc(work_buffer_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    // Decoder engine (one per session; TJpgDec if the board's engine can't be had)
+    if (!engine) {
+        if (JPEG_DECODER == JPEG_DECODER_TJPGD_ROM) {
+            engine = tjpgd_engine();
+        } else {
+            engine = jpeg_engine_create(JPEG_DECODER);
+            if (!engine) {
+                Logger.logMessagef("StripDecoder", "%s engine unavailable, using TJpgDec", jpeg_engine_name(JPEG_DECODER));
+                engine = tjpgd_engine();
             }
-        #else
-            work_buffer = malloc(work_buffer_size);
-        #endif
-        if (!work_buffer) {
-            Logger.logMessage("StripDecoder", "ERROR: Failed to allocate TJpgDec work buffer");
+        }
+        if (!engine) {
             return false;
         }
     }
@@ -306,7 +260,7 @@ bool StripDecoder::ensure_buffers() {
     if (!line_buffer || line_buffer_width != width) {
         if (line_buffer) {
             #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-                heap_caps_free(line_buffer);
+                heap_tag_free(HeapTag::Image, line_buffer);
             #else
                 free(line_buffer);
             #endif
@@ -315,11 +269,8 @@ bool StripDecoder::ensure_buffers() {
 
         const size_t bytes = (size_t)width * sizeof(uint16_t);
         #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-            // Prefer PSRAM; this buffer can be large on wide displays.
-            line_buffer = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
-            if (!line_buffer) {
-                line_buffer = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-            }
+            // This buffer can be large on wide displays.
+            line_buffer = (uint16_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Image, bytes);
         #else
             line_buffer = (uint16_t*)malloc(bytes);
         #endif
@@ -336,7 +287,7 @@ bool StripDecoder::ensure_buffers() {
         // Batching disabled
         if (batch_buffer) {
             #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-                heap_caps_free(batch_buffer);
+                heap_tag_free(HeapTag::Image, batch_buffer);
             #else
                 free(batch_buffer);
             #endif
@@ -352,7 +303,7 @@ bool StripDecoder::ensure_buffers() {
     if (needs_new_batch) {
         if (batch_buffer) {
             #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-                heap_caps_free(batch_buffer);
+                heap_tag_free(HeapTag::Image, batch_buffer);
             #else
                 free(batch_buffer);
             #endif
@@ -360,11 +311,7 @@ bool StripDecoder::ensure_buffers() {
         }
 
         #if defined(ARDUINO_ARCH_ESP32) || defined(ESP32)
-            // Prefer PSRAM when available to avoid pressuring internal RAM.
-            batch_buffer = (uint16_t*)heap_caps_malloc(batch_bytes, MALLOC_CAP_SPIRAM);
-            if (!batch_buffer) {
-                batch_buffer = (uint16_t*)heap_caps_malloc(batch_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-            }
+            batch_buffer = (uint16_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Image, batch_bytes);
         #else
             batch_buffer = (uint16_t*)malloc(batch_bytes);
         #endif
@@ -388,8 +335,12 @@ void StripDecoder::begin(int image_width, int image_height, int lcd_w, int lcd_h
     lcd_width = lcd_w;
     lcd_height = lcd_h;
     current_y = 0;
+    fit_x = -1;
+    fit_y = -1;
+    fit_w = 0;
+    fit_h = 0;
     
-    Logger.logMessagef("StripDecoder", "Begin decode: %dx%d image on %dx%d LCD", width, height, lcd_width, lcd_height);
+    LOGI("StripDecoder", "Begin decode: %dx%d image on %dx%d LCD", width, height, lcd_width, lcd_height);
 
     // Allocate per-session buffers once and reuse across strips.
     // If allocation fails, decoding will fail early in decode_strip().
@@ -397,6 +348,31 @@ void StripDecoder::begin(int image_width, int image_height, int lcd_w, int lcd_h
 }
 
 bool StripDecoder::decode_strip(const uint8_t* jpeg_data, size_t jpeg_size, int strip_index, bool output_bgr565) {
+    (void)strip_index;
+    return decode_input(jpeg_data, jpeg_size, nullptr, nullptr, output_bgr565, 0, -1, STRIP_FIT_NONE);
+}
+
+bool StripDecoder::decode_stream(ImageStreamReadFn read, void* read_ctx, bool output_bgr565) {
+    if (!read) return false;
+    return decode_input(nullptr, 0, read, read_ctx, output_bgr565, 0, -1, STRIP_FIT_NONE);
+}
+
+bool StripDecoder::decode_frame(ImageStreamReadFn read, void* read_ctx, bool output_bgr565) {
+    if (!read) return false;
+    return decode_input(nullptr, 0, read, read_ctx, output_bgr565, 0, 0, STRIP_FIT_NONE);
+}
+
+bool StripDecoder::decode_fit(const uint8_t* jpeg_data, size_t jpeg_size, ImageStreamReadFn read, void* read_ctx, bool output_bgr565, StripFit fit) {
+    if (!read && !jpeg_data) return false;
+    return decode_input(jpeg_data, jpeg_size, read, read_ctx, output_bgr565, 0, 0, fit == STRIP_FIT_NONE ? STRIP_FIT_TOP_LEFT : fit);
+}
+
+bool StripDecoder::decode_tile(const uint8_t* jpeg_data, size_t jpeg_size, int x, int y, bool output_bgr565) {
+    if (x < 0 || y < 0) return false;
+    return decode_input(jpeg_data, jpeg_size, nullptr, nullptr, output_bgr565, x, y, STRIP_FIT_NONE);
+}
+
+bool StripDecoder::decode_input(const uint8_t* jpeg_data, size_t jpeg_size, ImageStreamReadFn read, void* read_ctx, bool output_bgr565, int x, int y, StripFit fit) {
     if (!driver) {
         Logger.logMessage("StripDecoder", "ERROR: No display driver set");
         return false;
@@ -406,65 +382,205 @@ bool StripDecoder::decode_strip(const uint8_t* jpeg_data, size_t jpeg_size, int
         Logger.logMessage("StripDecoder", "ERROR: Decoder buffers not available");
         return false;
     }
-    
-    Logger.logBegin("Strip");
-    
+
     // Buffers are allocated once per session (begin/end) to reduce heap churn.
     const int kBatchMaxRows = batch_max_rows;
     
-    JDEC jdec;
-    JRESULT res;
+    // RGB565 engines cannot emit BGR565; streams need an engine that reads them.
+    JpegEngine* eng = engine;
+    if ((output_bgr565 && (eng->caps() & JPEG_ENGINE_RGB565)) || !jpeg_engine_can(eng, read != nullptr, 0)) {
+        eng = tjpgd_engine();
+        if (!eng) return false;
+    }
+    char err[64];
+    uint16_t src_w = 0;
+    uint16_t src_h = 0;
     
     // Setup session context (shared between input and output callbacks)
     JpegSessionContext session_ctx;
     session_ctx.input.data = jpeg_data;
     session_ctx.input.size = jpeg_size;
     session_ctx.input.pos = 0;
+    session_ctx.input.read = read;
+    session_ctx.input.read_ctx = read_ctx;
+    session_ctx.input.read_us = 0;
 
     session_ctx.output.decoder = this;
     session_ctx.output.driver = driver;
-    session_ctx.output.strip_y_offset = current_y;
+    session_ctx.output.x_offset = x;
+    session_ctx.output.strip_y_offset = (y >= 0) ? y : current_y;
     session_ctx.output.line_buffer = line_buffer;
     session_ctx.output.buffer_width = width;
     session_ctx.output.lcd_width = lcd_width;
     session_ctx.output.lcd_height = lcd_height;
     session_ctx.output.output_bgr565 = output_bgr565;
+    session_ctx.output.big_endian = (driver->pixelOrder() == DisplayDriver::PixelOrder::BigEndian);
+    session_ctx.output.pack = rgb888_pack_kernel(output_bgr565, session_ctx.output.big_endian);
     session_ctx.output.batch_buffer = batch_buffer;
     session_ctx.output.batch_capacity_pixels = batch_buffer ? (width * kBatchMaxRows) : 0;
     session_ctx.output.batch_max_rows = batch_buffer ? kBatchMaxRows : 0;
+    session_ctx.output.pack_us = 0;
+    session_ctx.output.push_us = 0;
+    session_ctx.output.pixels = 0;
+    session_ctx.header_us = 0;
+    const uint32_t profile_start_us = image_profile_now_us();
     
-    // Prepare decoder
-    res = jd_prepare(&jdec, jpeg_input_func, work_buffer, (UINT)work_buffer_size, &session_ctx);
+    // Prepare decoder (parse the header)
+    bool ok = eng->prepare(&session_ctx.input, &src_w, &src_h, err, sizeof(err));
+    const uint32_t prepare_us = image_profile_now_us() - profile_start_us;
+    session_ctx.header_us = prepare_us > session_ctx.input.read_us ? prepare_us - session_ctx.input.read_us : 0;
     
-    if (res != JDR_OK) {
-        Logger.logLinef("ERROR: jd_prepare failed: %d", res);
-        Logger.logEnd();
+    if (!ok) {
+        LOGE("Strip", "ERROR: %s: %s", eng->name(), err);
         return false;
     }
+
+    // Now that the header is parsed: pick the scale and where the image lands.
+    uint8_t scale = 0;
+    if (fit != STRIP_FIT_NONE) {
+        const int s = jpeg_tjpgd_fit_scale((int)src_w, (int)src_h, lcd_width, lcd_height);
+        if (s < 0) {
+            LOGE("Strip", "ERROR: %ux%u JPEG does not fit %dx%d even at 1/8", (unsigned)src_w, (unsigned)src_h, lcd_width, lcd_height);
+            return false;
+        }
+        scale = (uint8_t)s;
+
+        // An engine without scaling (hardware codec) hands a scaled fit to
+        // TJpgDec. It only ever gets buffers, so the header can be read again.
+        if (!jpeg_engine_can(eng, read != nullptr, scale)) {
+            eng = tjpgd_engine();
+            if (!eng || read) return false;
+            const uint32_t t0 = image_profile_now_us();
+            session_ctx.input.pos = 0;
+            ok = eng->prepare(&session_ctx.input, &src_w, &src_h, err, sizeof(err));
+            session_ctx.header_us += image_profile_now_us() - t0;
+            if (!ok) {
+                LOGE("Strip", "ERROR: %s: %s", eng->name(), err);
+                return false;
+            }
+        }
+
+        const int div = 1 << scale;
+        const int out_w = ((int)src_w + div - 1) / div;
+        const int out_h = ((int)src_h + div - 1) / div;
+        const int fx = (fit == STRIP_FIT_CENTER) ? (lcd_width - out_w) / 2 : 0;
+        const int fy = (fit == STRIP_FIT_CENTER) ? (lcd_height - out_h) / 2 : 0;
+
+        if (fx != fit_x || fy != fit_y || out_w != fit_w || out_h != fit_h) {
+            const uint32_t t0 = image_profile_now_us();
+            fill_black(0, 0, lcd_width, fy);
+            fill_black(0, fy + out_h, lcd_width, lcd_height - fy - out_h);
+            fill_black(0, fy, fx, out_h);
+            fill_black(fx + out_w, fy, lcd_width - fx - out_w, out_h);
+            session_ctx.output.push_us += image_profile_now_us() - t0;
+            fit_x = fx;
+            fit_y = fy;
+            fit_w = out_w;
+            fit_h = out_h;
+            if (scale > 0 || out_w != lcd_width || out_h != lcd_height) {
+                LOGD("Strip", "Fit: %ux%u at 1/%d -> %dx%d at (%d,%d)", (unsigned)src_w, (unsigned)src_h, div, out_w, out_h, fx, fy);
+            }
+        }
+        session_ctx.output.x_offset = fx;
+        session_ctx.output.strip_y_offset = fy;
+    }
     
-    // Decompress and output to LCD
-    res = jd_decomp(&jdec, jpeg_output_func, 0);  // 0 = 1:1 scale
+    const bool buffered = (driver->renderMode() == DisplayDriver::RenderMode::Buffered);
+    if (panel_sync && !buffered) {
+        panel_sync(panel_sync_ctx);
+    }
+
+    // Decompress and output to LCD (scale: 0 = 1:1 ... 3 = 1:8)
+    ok = eng->decode(scale, session_ctx.output.big_endian, jpeg_output_func, &session_ctx, err, sizeof(err));
     
-    if (res != JDR_OK) {
-        Logger.logLinef("ERROR: jd_decomp failed: %d", res);
-        Logger.logEnd();
+    if (!ok) {
+        LOGE("Strip", "ERROR: %s: %s", eng->name(), err);
+        report_profile(session_ctx, profile_start_us);
         return false;
     }
 
     // Buffered drivers (e.g., Arduino_GFX canvas) require an explicit present()
     // to flush the accumulated pixels to the physical panel.
-    if (driver->renderMode() == DisplayDriver::RenderMode::Buffered) {
+    if (buffered) {
+        const uint32_t t0 = image_profile_now_us();
+        if (panel_sync) {
+            panel_sync(panel_sync_ctx);
+        }
         driver->present();
+        session_ctx.output.push_us += image_profile_now_us() - t0;
     }
+    report_profile(session_ctx, profile_start_us);
     
-    // Move Y position for next strip
-    current_y += jdec.height;
+    // Move Y position for next strip (tiles are placed explicitly)
+    if (y < 0) {
+        current_y += src_h;
+    }
     
     return true;
 }
 
+bool StripDecoder::push_pixels(int x, int y, int w, int h, uint16_t* pixels, bool big_endian) {
+    if (!driver || !pixels) {
+        Logger.logMessage("StripDecoder", "ERROR: No display driver set");
+        return false;
+    }
+    if (x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > lcd_width || y + h > lcd_height) {
+        Logger.logMessagef("StripDecoder", "ERROR: Invalid LCD rect: x=%d y=%d w=%d h=%d (LCD: %dx%d)",
+                          x, y, w, h, lcd_width, lcd_height);
+        return false;
+    }
+
+    const uint32_t t0 = image_profile_now_us();
+    const bool swap = big_endian != (driver->pixelOrder() == DisplayDriver::PixelOrder::BigEndian);
+    const bool buffered = (driver->renderMode() == DisplayDriver::RenderMode::Buffered);
+    if (panel_sync && !buffered) {
+        panel_sync(panel_sync_ctx);
+    }
+
+    // Same transaction size as the JPEG batch path; yield between batches.
+    const int rows_per_push = (IMAGE_STRIP_BATCH_MAX_ROWS > 1) ? (int)IMAGE_STRIP_BATCH_MAX_ROWS : 1;
+    for (int row = 0; row < h; row += rows_per_push) {
+        const int rows = (h - row < rows_per_push) ? (h - row) : rows_per_push;
+        driver->startWrite();
+        driver->setAddrWindow(x, y + row, w, rows);
+        driver->pushColors(pixels + (size_t)row * (size_t)w, (uint32_t)(w * rows), swap);
+        driver->endWrite();
+        taskYIELD();
+    }
+
+    if (buffered) {
+        if (panel_sync) {
+            panel_sync(panel_sync_ctx);
+        }
+        driver->present();
+    }
+    image_profile_add(IMAGE_STAGE_PUSH, image_profile_now_us() - t0, (uint32_t)(w * h * 2));
+    return true;
+}
+
+// Clear a panel rectangle to black (letterbox bars around a fitted image).
+void StripDecoder::fill_black(int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0) return;
+
+    // Reuse the batch buffer (or the line buffer) as a run of black pixels.
+    uint16_t* black = batch_buffer ? batch_buffer : line_buffer;
+    const int capacity = batch_buffer ? batch_capacity_pixels : line_buffer_width;
+    if (!black || capacity < w) return;
+    const int rows_per_push = capacity / w;
+    memset(black, 0, (size_t)w * (size_t)rows_per_push * sizeof(uint16_t));
+
+    for (int row = 0; row < h; row += rows_per_push) {
+        const int rows = (h - row < rows_per_push) ? (h - row) : rows_per_push;
+        driver->startWrite();
+        driver->setAddrWindow(x, y + row, w, rows);
+        driver->pushColors(black, (uint32_t)(w * rows), false);
+        driver->endWrite();
+        taskYIELD();
+    }
+}
+
 void StripDecoder::end() {
-    Logger.logMessagef("StripDecoder", "Complete at Y=%d", current_y);
+    LOGI("StripDecoder", "Complete at Y=%d", current_y);
 
     // Free session buffers so the heap can recover between image sessions.
     free_buffers();
@@ -2,12 +2,13 @@
  * Strip Decoder for Memory-Efficient Image Display
  * 
  * Decodes individual JPEG strips and writes directly to LCD hardware.
- * Uses TJpgDec/tjpgd from ESP32 ROM for baseline JPEG decode.
+ * Decodes through the board's JpegEngine (JPEG_DECODER; TJpgDec from ROM by
+ * default, see jpeg_engine.h) for baseline JPEG decode.
  * 
- * Memory usage: ~20KB constant regardless of image size
+ * Memory usage: ~20KB constant regardless of image size (TJpgDec)
  *   - Strip buffer: ~2KB (temporary per strip)
  *   - Decode buffer: ~13KB for 280px width × 16px height
- *   - TJpgDec work area: ~3KB
+ *   - TJpgDec work area: ~4KB (JPEGDEC: ~20KB decoder state instead)
  */
 
 #pragma once
@@ -18,8 +19,18 @@
 
 #include <Arduino.h>
 
-// Forward declaration
+#include "image_stream.h"
+
+// Forward declarations
 class DisplayDriver;
+class JpegEngine;
+
+// Placement of a whole image that need not match the panel (decode_fit).
+enum StripFit : uint8_t {
+    STRIP_FIT_NONE = 0,    // exact placement (strips, tiles, frames)
+    STRIP_FIT_TOP_LEFT,    // largest TJpgDec scale that fits, at the origin
+    STRIP_FIT_CENTER,      // largest TJpgDec scale that fits, centered
+};
 
 class StripDecoder {
 public:
@@ -28,6 +39,11 @@ public:
     
     // Set display driver for LCD writes
     void setDisplayDriver(DisplayDriver* drv);
+
+    // Optional hook run right before each strip reaches the panel (start of the
+    // decode for Direct drivers, before present() for Buffered ones).
+    // Used for tearing-effect sync; nullptr disables it.
+    void setPanelSync(void (*fn)(void* ctx), void* ctx) { panel_sync = fn; panel_sync_ctx = ctx; }
     
     // Initialize decoder for new image session
     // image_width: total image width in pixels
@@ -44,6 +60,27 @@ public:
     //               false to pack pixels as RGB565 (useful when LCD is in RGB mode)
     // Returns: true on success, false on failure
     bool decode_strip(const uint8_t* jpeg_data, size_t jpeg_size, int strip_index, bool output_bgr565 = true);
+
+    // Decode one JPEG pulled from a byte source as it arrives (same output
+    // path as decode_strip). read is called from within TJpgDec and may block.
+    bool decode_stream(ImageStreamReadFn read, void* read_ctx, bool output_bgr565 = true);
+
+    // Decode one streamed JPEG at the origin (video frame). Does not move the
+    // strip position, so consecutive frames overwrite each other.
+    bool decode_frame(ImageStreamReadFn read, void* read_ctx, bool output_bgr565 = true);
+
+    // Decode a whole JPEG (buffer, or read != nullptr for a stream) at the
+    // largest TJpgDec scale (1/1, 1/2, 1/4, 1/8) that fits the panel. The
+    // uncovered border is cleared to black (once per geometry per session).
+    bool decode_fit(const uint8_t* jpeg_data, size_t jpeg_size, ImageStreamReadFn read, void* read_ctx, bool output_bgr565, StripFit fit);
+
+    // Decode a JPEG fragment at an explicit (x, y) offset (partial update).
+    // Does not move the strip position.
+    bool decode_tile(const uint8_t* jpeg_data, size_t jpeg_size, int x, int y, bool output_bgr565 = true);
+
+    // Write a rectangle of ready-made RGB565 pixels (no decode).
+    // big_endian: byte order of `pixels`; swapped on the fly if the driver differs.
+    bool push_pixels(int x, int y, int w, int h, uint16_t* pixels, bool big_endian);
     
     // Complete image session and cleanup
     void end();
@@ -54,6 +91,12 @@ public:
 private:
     void free_buffers();
     bool ensure_buffers();
+    // TJpgDec, for the jobs the board's engine can't do (created on first use).
+    JpegEngine* tjpgd_engine();
+    // y < 0: place at current_y and advance it (strips); else draw at (x, y).
+    // fit != STRIP_FIT_NONE picks the scale and placement itself.
+    bool decode_input(const uint8_t* jpeg_data, size_t jpeg_size, ImageStreamReadFn read, void* read_ctx, bool output_bgr565, int x, int y, StripFit fit);
+    void fill_black(int x, int y, int w, int h);
 
     DisplayDriver* driver;  // Display driver for LCD writes
     int width;              // Image width
@@ -62,9 +105,15 @@ private:
     int lcd_height;         // LCD panel height
     int current_y;          // Current Y position in image
 
+    // Last decode_fit placement; the letterbox is only repainted when it changes.
+    int fit_x = -1, fit_y = -1, fit_w = 0, fit_h = 0;
+
+    void (*panel_sync)(void* ctx) = nullptr;
+    void* panel_sync_ctx = nullptr;
+
     // Per-session reusable buffers (allocated in begin(), freed in end()).
-    void* work_buffer = nullptr;
-    size_t work_buffer_size = 0;
+    JpegEngine* engine = nullptr;      // JPEG_DECODER
+    JpegEngine* rom_engine = nullptr;  // TJpgDec; == engine when that is TJpgDec
 
     uint16_t* line_buffer = nullptr;
     int line_buffer_width = 0;
@@ -0,0 +1,145 @@
+#include "tap_latency.h"
+
+#if HAS_DISPLAY
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+// A lift older than this is not the one that produced the click.
+static constexpr uint32_t kTouchPairWindowUs = 500000;
+
+struct LatencyRing {
+    uint32_t samples[TAP_LATENCY_HIST_SAMPLES];
+    uint16_t count;
+    uint16_t next;
+};
+
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static volatile uint32_t g_last_lift_us = 0;
+static bool g_touch_pressed = false;   // touch read callback only
+
+// The job on the executor task (one at a time).
+static bool g_active = false;
+static TapTrace g_trace = {};
+static uint32_t g_dispatch_us = 0;
+static uint32_t g_first_report_us = 0;
+static uint32_t g_last_report_us = 0;
+
+static uint32_t g_taps = 0;
+static LatencyRing g_touch_to_click = {};
+static LatencyRing g_click_to_dispatch = {};
+static LatencyRing g_dispatch_to_report = {};
+static LatencyRing g_total = {};
+static LatencyRing g_report_span = {};
+
+static inline uint32_t now_us() {
+    const uint32_t t = (uint32_t)esp_timer_get_time();
+    return t ? t : 1;
+}
+
+// Caller holds g_mux.
+static void ring_push(LatencyRing& ring, uint32_t us) {
+    ring.samples[ring.next] = us;
+    ring.next = (uint16_t)((ring.next + 1) % TAP_LATENCY_HIST_SAMPLES);
+    if (ring.count < TAP_LATENCY_HIST_SAMPLES) ring.count++;
+}
+
+static void ring_summarize(const LatencyRing& live, TapLatencyHistogram* out) {
+    LatencyRing ring;
+    portENTER_CRITICAL(&g_mux);
+    ring = live;
+    portEXIT_CRITICAL(&g_mux);
+
+    *out = {0, 0, 0, 0};
+    const uint16_t n = ring.count;
+    if (n == 0) return;
+
+    // Insertion sort: n is small and this runs on the reader's task.
+    uint32_t* v = ring.samples;
+    for (uint16_t i = 1; i < n; i++) {
+        const uint32_t key = v[i];
+        int j = (int)i - 1;
+        while (j >= 0 && v[j] > key) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = key;
+    }
+
+    // Nearest-rank percentiles.
+    auto rank = [n](uint32_t pct) -> uint16_t {
+        uint32_t idx = (pct * n + 99) / 100;
+        return (uint16_t)(idx > 0 ? idx - 1 : 0);
+    };
+    out->p50_us = v[rank(50)];
+    out->p95_us = v[rank(95)];
+    out->p99_us = v[rank(99)];
+    out->max_us = v[n - 1];
+}
+
+void tap_latency_note_touch(bool pressed, uint32_t at_us) {
+    if (g_touch_pressed && !pressed) {
+        g_last_lift_us = at_us ? at_us : now_us();
+    }
+    g_touch_pressed = pressed;
+}
+
+TapTrace tap_latency_click() {
+    TapTrace t;
+    t.click_us = now_us();
+    const uint32_t lift = g_last_lift_us;
+    t.touch_us = (lift && (t.click_us - lift) < kTouchPairWindowUs) ? lift : 0;
+    return t;
+}
+
+void tap_latency_dispatch(const TapTrace& trace) {
+    const uint32_t now = now_us();
+    portENTER_CRITICAL(&g_mux);
+    g_active = trace.click_us != 0;
+    g_trace = trace;
+    g_dispatch_us = now;
+    g_first_report_us = 0;
+    g_last_report_us = 0;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void tap_latency_note_report() {
+    if (!g_active) return;
+    const uint32_t now = now_us();
+    portENTER_CRITICAL(&g_mux);
+    if (g_active) {
+        if (!g_first_report_us) g_first_report_us = now;
+        g_last_report_us = now;
+    }
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void tap_latency_finish() {
+    portENTER_CRITICAL(&g_mux);
+    // Untraced jobs, and macros that sent nothing (not connected), add no sample.
+    if (g_active && g_first_report_us) {
+        g_taps++;
+        if (g_trace.touch_us) ring_push(g_touch_to_click, g_trace.click_us - g_trace.touch_us);
+        ring_push(g_click_to_dispatch, g_dispatch_us - g_trace.click_us);
+        ring_push(g_dispatch_to_report, g_first_report_us - g_dispatch_us);
+        ring_push(g_total, g_first_report_us - (g_trace.touch_us ? g_trace.touch_us : g_trace.click_us));
+        ring_push(g_report_span, g_last_report_us - g_first_report_us);
+    }
+    g_active = false;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void tap_latency_get_stats(TapLatencyStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_mux);
+    out->taps = g_taps;
+    portEXIT_CRITICAL(&g_mux);
+    ring_summarize(g_touch_to_click, &out->touch_to_click);
+    ring_summarize(g_click_to_dispatch, &out->click_to_dispatch);
+    ring_summarize(g_dispatch_to_report, &out->dispatch_to_report);
+    ring_summarize(g_total, &out->total);
+    ring_summarize(g_report_span, &out->report_span);
+}
+
+#endif // HAS_DISPLAY
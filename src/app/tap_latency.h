@@ -0,0 +1,68 @@
+/*
+ * Tap Latency
+ *
+ * Traces a macro tap from the touch read to the first BLE HID report:
+ *
+ *   touch    the finger lift (LVGL clicks on release): the sample's own
+ *            timestamp with interrupt sampling (TOUCH_INT_SAMPLING), else
+ *            the polled read, up to one indev read period late
+ *   click    MacroPadScreen handles LV_EVENT_CLICKED
+ *   dispatch the macro executor task starts the job
+ *   report   BleKeyboard::sendReport (first, and the last of the macro)
+ *
+ * Each finished SendKeys tap adds one sample per stage to rolling rings of
+ * TAP_LATENCY_HIST_SAMPLES; percentiles are computed on read, for
+ * /api/health and the MQTT health state.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#include <stdint.h>
+
+// Timestamps in esp_timer microseconds (low 32 bits); 0 = not seen.
+struct TapTrace {
+    uint32_t touch_us;
+    uint32_t click_us;
+};
+
+struct TapLatencyHistogram {
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+struct TapLatencyStats {
+    uint32_t taps;                         // traced taps since boot
+    TapLatencyHistogram touch_to_click;
+    TapLatencyHistogram click_to_dispatch;
+    TapLatencyHistogram dispatch_to_report;
+    TapLatencyHistogram total;             // touch (or click) to first report
+    TapLatencyHistogram report_span;       // first to last report of the macro
+};
+
+#if HAS_DISPLAY
+
+// Touch read callback: pressed/released state of this read; at_us is when
+// the sample was taken (0 = now).
+void tap_latency_note_touch(bool pressed, uint32_t at_us = 0);
+
+// LVGL click handler: start a trace, pairing it with the last finger lift.
+TapTrace tap_latency_click();
+
+// Executor task: a traced job starts / ends. Reports in between belong to it.
+void tap_latency_dispatch(const TapTrace& trace);
+void tap_latency_finish();
+
+// Every BLE keyboard / media report.
+void tap_latency_note_report();
+
+void tap_latency_get_stats(TapLatencyStats* out);
+
+#else
+
+static inline void tap_latency_note_report() {}
+
+#endif // HAS_DISPLAY
@@ -0,0 +1,82 @@
+#include "task_placement.h"
+
+#include "log_manager.h"
+
+#include <esp_idf_version.h>
+#include <freertos/timers.h>
+
+namespace {
+
+// Tasks worth watching when tuning contention (missing ones are skipped).
+const char* const kTrackedTasks[] = {
+    "loopTask",
+    "LVGL",
+    "LVGLFlush",
+    "async_tcp",
+    "nimble_host",
+    "MQTT",
+    "ImageWorker",
+    "ImageMcast",
+    "TouchSample",
+    "cpu_monitor",
+    "LogDrain",
+    "PortalW0",
+    "PortalW1",
+    "Tmr Svc",
+};
+
+int8_t task_core(TaskHandle_t h) {
+#if CONFIG_FREERTOS_UNICORE
+    (void)h;
+    return 0;
+#else
+#if ESP_IDF_VERSION_MAJOR >= 5
+    const BaseType_t core = xTaskGetCoreID(h);
+#else
+    const BaseType_t core = xTaskGetAffinity(h);
+#endif
+    return (core == tskNO_AFFINITY) ? -1 : (int8_t)core;
+#endif
+}
+
+} // namespace
+
+BaseType_t task_placement_create(TaskFunction_t fn, const char* name, uint32_t stack_bytes,
+                                 void* arg, UBaseType_t priority, TaskHandle_t* out, int core) {
+#if CONFIG_FREERTOS_UNICORE
+    (void)core;
+    return xTaskCreate(fn, name, stack_bytes, arg, priority, out);
+#else
+    const BaseType_t pin = (core < 0 || core >= portNUM_PROCESSORS) ? tskNO_AFFINITY : (BaseType_t)core;
+    return xTaskCreatePinnedToCore(fn, name, stack_bytes, arg, priority, out, pin);
+#endif
+}
+
+void task_placement_init() {
+#if TIMER_TASK_PRIORITY >= 0
+    // The timer service task (health window sampler, BLE relax timer) is created
+    // by the core with CONFIG_FREERTOS_TIMER_TASK_PRIORITY; only its priority can
+    // change afterwards.
+    TaskHandle_t timer_task = xTimerGetTimerDaemonTaskHandle();
+    if (timer_task) {
+        vTaskPrioritySet(timer_task, (UBaseType_t)TIMER_TASK_PRIORITY);
+        Logger.logMessagef("Tasks", "Timer task priority %d", (int)TIMER_TASK_PRIORITY);
+    }
+#endif
+}
+
+size_t task_placement_get(TaskPlacementInfo* out, size_t max) {
+    if (!out) return 0;
+    size_t n = 0;
+    for (const char* name : kTrackedTasks) {
+        if (n >= max) break;
+        TaskHandle_t h = xTaskGetHandle(name);
+        if (!h) continue;
+        TaskPlacementInfo& info = out[n++];
+        info.name = name;
+        info.core = task_core(h);
+        info.priority = (uint8_t)uxTaskPriorityGet(h);
+        info.stack_free = (uint32_t)uxTaskGetStackHighWaterMark(h) * (uint32_t)sizeof(StackType_t);
+    }
+    return n;
+}
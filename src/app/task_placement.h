@@ -0,0 +1,34 @@
+#ifndef TASK_PLACEMENT_H
+#define TASK_PLACEMENT_H
+
+#include "board_config.h"
+
+// Task Placement
+// Core, priority and stack of the firmware's long-running tasks come from the
+// "Task Placement" table in board_config.h (boards override it in
+// board_overrides.h). Library tasks (AsyncTCP, NimBLE) take their values as
+// compile-time defines that build.sh forwards from board_overrides.h.
+// task_placement_get() reports where the tasks actually ended up.
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// core: 0/1, or -1 for no affinity. Ignored on single-core chips.
+BaseType_t task_placement_create(TaskFunction_t fn, const char* name, uint32_t stack_bytes,
+                                 void* arg, UBaseType_t priority, TaskHandle_t* out, int core);
+
+// Apply runtime-adjustable placement (timer service task priority). Call early in setup().
+void task_placement_init();
+
+struct TaskPlacementInfo {
+    const char* name;      // FreeRTOS task name
+    int8_t core;           // -1 = not pinned
+    uint8_t priority;
+    uint32_t stack_free;   // stack high-water mark (bytes never used)
+};
+
+// Fills out for each tracked task that exists right now; returns the count.
+size_t task_placement_get(TaskPlacementInfo* out, size_t max);
+
+#endif // TASK_PLACEMENT_H
@@ -0,0 +1,458 @@
+#include "tls_client.h"
+
+#include "log_manager.h"
+
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+#include <esp_random.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <lwip/sockets.h>
+#include <mbedtls/net_sockets.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+// mbedTLS 3 marks struct members private by name only.
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member) member
+#endif
+
+namespace {
+
+struct CachedSession {
+    bool valid;
+    uint16_t port;
+    uint32_t last_use_ms;
+    char host[64];
+    mbedtls_ssl_session session;
+};
+
+#if TLS_SESSION_CACHE_ENTRIES > 0
+CachedSession g_sessions[TLS_SESSION_CACHE_ENTRIES];
+bool g_sessions_ready = false;
+#endif
+
+portMUX_TYPE g_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+TlsClientStats g_stats = {};
+uint64_t g_full_us_total = 0;
+uint64_t g_resumed_us_total = 0;
+
+// Sessions are copied in and out with mbedTLS calls that allocate (tickets,
+// peer certificates), so the cache takes a mutex rather than a spinlock.
+SemaphoreHandle_t cache_lock() {
+    static SemaphoreHandle_t m = xSemaphoreCreateMutex();
+    return m;
+}
+
+#if TLS_SESSION_CACHE_ENTRIES > 0
+void cache_init_locked() {
+    if (g_sessions_ready) return;
+    for (CachedSession& e : g_sessions) {
+        e.valid = false;
+        mbedtls_ssl_session_init(&e.session);
+    }
+    g_sessions_ready = true;
+}
+
+CachedSession* cache_find_locked(const char* host, uint16_t port) {
+    for (CachedSession& e : g_sessions) {
+        if (e.valid && e.port == port && strcmp(e.host, host) == 0) return &e;
+    }
+    return nullptr;
+}
+
+void cache_drop_locked(CachedSession* e) {
+    mbedtls_ssl_session_free(&e->session);
+    mbedtls_ssl_session_init(&e->session);
+    e->valid = false;
+}
+
+uint8_t cache_count_locked() {
+    uint8_t n = 0;
+    for (const CachedSession& e : g_sessions) n += e.valid ? 1 : 0;
+    return n;
+}
+#endif
+
+// Offer the cached session for host:port; false when there is none.
+bool cache_offer(mbedtls_ssl_context* ssl, const char* host, uint16_t port) {
+#if TLS_SESSION_CACHE_ENTRIES > 0
+    if (strlen(host) >= sizeof(g_sessions[0].host)) return false;
+    xSemaphoreTake(cache_lock(), portMAX_DELAY);
+    cache_init_locked();
+    CachedSession* e = cache_find_locked(host, port);
+    // mbedtls_ssl_set_session() copies the session into the handshake.
+    const bool offered = e && mbedtls_ssl_set_session(ssl, &e->session) == 0;
+    if (e) e->last_use_ms = millis();
+    xSemaphoreGive(cache_lock());
+    return offered;
+#else
+    (void)ssl;
+    (void)host;
+    (void)port;
+    return false;
+#endif
+}
+
+// Keep the session just negotiated (a resumed one may carry a new ticket).
+void cache_store(mbedtls_ssl_context* ssl, const char* host, uint16_t port) {
+#if TLS_SESSION_CACHE_ENTRIES > 0
+    if (strlen(host) >= sizeof(g_sessions[0].host)) return;
+    xSemaphoreTake(cache_lock(), portMAX_DELAY);
+    cache_init_locked();
+    CachedSession* slot = cache_find_locked(host, port);
+    if (!slot) {
+        // A free slot, else the least recently used host.
+        for (CachedSession& e : g_sessions) {
+            if (!e.valid) {
+                slot = &e;
+                break;
+            }
+            if (!slot || (int32_t)(e.last_use_ms - slot->last_use_ms) < 0) slot = &e;
+        }
+    }
+    cache_drop_locked(slot);
+    if (mbedtls_ssl_get_session(ssl, &slot->session) == 0) {
+        strlcpy(slot->host, host, sizeof(slot->host));
+        slot->port = port;
+        slot->last_use_ms = millis();
+        slot->valid = true;
+    } else {
+        cache_drop_locked(slot);
+    }
+    const uint8_t count = cache_count_locked();
+    xSemaphoreGive(cache_lock());
+
+    portENTER_CRITICAL(&g_stats_mux);
+    g_stats.sessions = count;
+    portEXIT_CRITICAL(&g_stats_mux);
+#else
+    (void)ssl;
+    (void)host;
+    (void)port;
+#endif
+}
+
+int tls_random(void* ctx, unsigned char* out, size_t len) {
+    (void)ctx;
+    esp_fill_random(out, len);
+    return 0;
+}
+
+int bio_send(void* ctx, const unsigned char* buf, size_t len) {
+    const int fd = *(const int*)ctx;
+    const int n = lwip_send(fd, buf, len, 0);
+    if (n >= 0) return n;
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return MBEDTLS_ERR_SSL_WANT_WRITE;
+    return MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+int bio_recv(void* ctx, unsigned char* buf, size_t len) {
+    const int fd = *(const int*)ctx;
+    const int n = lwip_recv(fd, buf, len, 0);
+    if (n >= 0) return n;  // 0: peer closed
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return MBEDTLS_ERR_SSL_WANT_READ;
+    return MBEDTLS_ERR_NET_RECV_FAILED;
+}
+
+bool want_io(int ret) {
+    return ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+size_t internal_free() {
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+} // namespace
+
+TlsClient::TlsClient() {
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+}
+
+TlsClient::~TlsClient() {
+    close_all();
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, (int32_t)handshake_timeout_ms);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout_ms) {
+    // No name to send as SNI; handshake() keys the cache by the address.
+    close_all();
+    const uint32_t deadline = millis() + (uint32_t)(timeout_ms > 0 ? timeout_ms : (int32_t)handshake_timeout_ms);
+    if (!open_socket(ip, port, deadline)) return 0;
+    if (!handshake(nullptr, port, deadline)) {
+        close_all();
+        return 0;
+    }
+    return 1;
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, (int32_t)handshake_timeout_ms);
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeout_ms) {
+    close_all();
+    if (!host || !*host) return 0;
+    const uint32_t deadline = millis() + (uint32_t)(timeout_ms > 0 ? timeout_ms : (int32_t)handshake_timeout_ms);
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip)) return 0;
+    if (!open_socket(ip, port, deadline)) return 0;
+    if (!handshake(host, port, deadline)) {
+        close_all();
+        return 0;
+    }
+    return 1;
+}
+
+bool TlsClient::wait_socket(bool for_write, uint32_t deadline_ms) {
+    const int32_t left = (int32_t)(deadline_ms - millis());
+    if (left <= 0 || sock < 0) return false;
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(sock, &set);
+    struct timeval tv = {(long)(left / 1000), (long)((left % 1000) * 1000)};
+    const int n = for_write ? select(sock + 1, nullptr, &set, nullptr, &tv)
+                            : select(sock + 1, &set, nullptr, nullptr, &tv);
+    return n > 0;
+}
+
+bool TlsClient::open_socket(const IPAddress& ip, uint16_t port, uint32_t deadline_ms) {
+    sock = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) return false;
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    const int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    if (lwip_connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0 && errno != EINPROGRESS) {
+        close_all();
+        return false;
+    }
+    if (!wait_socket(true, deadline_ms)) {
+        close_all();
+        return false;
+    }
+    int so_error = 0;
+    socklen_t len = sizeof(so_error);
+    getsockopt(sock, SOL_SOCKET, SO_ERROR, &so_error, &len);
+    if (so_error != 0) {
+        close_all();
+        return false;
+    }
+    return true;
+}
+
+bool TlsClient::handshake(const char* host, uint16_t port, uint32_t deadline_ms) {
+    char key[64];
+    if (host) {
+        strlcpy(key, host, sizeof(key));
+    } else {
+        // connect(IPAddress): key the cache by the peer address.
+        struct sockaddr_in peer = {};
+        socklen_t len = sizeof(peer);
+        getpeername(sock, (struct sockaddr*)&peer, &len);
+        inet_ntoa_r(peer.sin_addr, key, sizeof(key));
+    }
+
+    const size_t heap_before = internal_free();
+    size_t heap_low = heap_before;
+    const uint32_t t0 = micros();
+
+    if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        return false;
+    }
+    // SECURITY NOTE: no certificate validation, as with WiFiClientSecure::setInsecure().
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&conf, tls_random, nullptr);
+    #if defined(MBEDTLS_SSL_PROTO_TLS1_3) && defined(MBEDTLS_SSL_PROTO_TLS1_2)
+    mbedtls_ssl_conf_max_tls_version(&conf, MBEDTLS_SSL_VERSION_TLS1_2);
+    #endif
+    #if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    #endif
+    if (mbedtls_ssl_setup(&ssl, &conf) != 0) return false;
+    tls_up = true;
+    if (host) mbedtls_ssl_set_hostname(&ssl, host);
+    mbedtls_ssl_set_bio(&ssl, &sock, bio_send, bio_recv, nullptr);
+
+    const bool offered = cache_offer(&ssl, key, port);
+
+    // Stepped so the deadline holds on the non-blocking socket. A resumed
+    // TLS 1.2 handshake goes from ServerHello straight to the server's
+    // ChangeCipherSpec; only a full one sends a ClientKeyExchange.
+    bool key_exchange = false;
+    int ret = 0;
+    while (ssl.MBEDTLS_PRIVATE(state) != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        if (ssl.MBEDTLS_PRIVATE(state) == MBEDTLS_SSL_CLIENT_KEY_EXCHANGE) key_exchange = true;
+        ret = mbedtls_ssl_handshake_step(&ssl);
+        const size_t now_free = internal_free();
+        if (now_free < heap_low) heap_low = now_free;
+        if (ret == 0) continue;
+        if (!want_io(ret)) break;
+        if (!wait_socket(ret == MBEDTLS_ERR_SSL_WANT_WRITE, deadline_ms)) {
+            ret = MBEDTLS_ERR_SSL_TIMEOUT;
+            break;
+        }
+        ret = 0;
+    }
+    const uint32_t dt = micros() - t0;
+
+    if (ret != 0) {
+        if (offered) tls_client_forget(key, port);
+        portENTER_CRITICAL(&g_stats_mux);
+        g_stats.failed++;
+        portEXIT_CRITICAL(&g_stats_mux);
+        LOGW("Tls", "%s:%u handshake failed (-0x%04x)", key, (unsigned)port, (unsigned)-ret);
+        return false;
+    }
+
+    was_resumed = offered && !key_exchange;
+    cache_store(&ssl, key, port);
+
+    const size_t heap_after = internal_free();
+    portENTER_CRITICAL(&g_stats_mux);
+    if (was_resumed) {
+        g_stats.resumed++;
+        g_resumed_us_total += dt;
+        g_stats.resumed_us = (uint32_t)(g_resumed_us_total / g_stats.resumed);
+    } else {
+        g_stats.full++;
+        g_full_us_total += dt;
+        g_stats.full_us = (uint32_t)(g_full_us_total / g_stats.full);
+    }
+    g_stats.last_us = dt;
+    g_stats.conn_heap = heap_before > heap_after ? (uint32_t)(heap_before - heap_after) : 0;
+    g_stats.handshake_heap = (uint32_t)(heap_before - heap_low);
+    portEXIT_CRITICAL(&g_stats_mux);
+    LOGD("Tls", "%s:%u %s handshake %lu us", key, (unsigned)port, was_resumed ? "resumed" : "full", (unsigned long)dt);
+    return true;
+}
+
+void TlsClient::close_all() {
+    if (tls_up) {
+        // Best effort: the socket is non-blocking, so this never waits.
+        if (sock >= 0 && !peer_closed) mbedtls_ssl_close_notify(&ssl);
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_init(&ssl);
+        tls_up = false;
+    }
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_ssl_config_init(&conf);
+    if (sock >= 0) {
+        lwip_close(sock);
+        sock = -1;
+    }
+    peer_closed = false;
+    was_resumed = false;
+    peek_byte = -1;
+}
+
+void TlsClient::stop() {
+    close_all();
+}
+
+size_t TlsClient::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    if (!tls_up || peer_closed) return 0;
+    const uint32_t deadline = millis() + handshake_timeout_ms;
+    size_t sent = 0;
+    while (sent < size) {
+        const int ret = mbedtls_ssl_write(&ssl, buf + sent, size - sent);
+        if (ret > 0) {
+            sent += (size_t)ret;
+            continue;
+        }
+        if (!want_io(ret) || !wait_socket(ret == MBEDTLS_ERR_SSL_WANT_WRITE, deadline)) {
+            if (!want_io(ret)) peer_closed = true;
+            break;
+        }
+    }
+    return sent;
+}
+
+int TlsClient::available() {
+    if (!tls_up) return 0;
+    int n = (int)mbedtls_ssl_get_bytes_avail(&ssl);
+    if (n == 0 && !peer_closed) {
+        // Decrypt whatever records have arrived; the socket never blocks.
+        const int ret = mbedtls_ssl_read(&ssl, nullptr, 0);
+        if (ret < 0 && !want_io(ret)) peer_closed = true;
+        n = (int)mbedtls_ssl_get_bytes_avail(&ssl);
+    }
+    return n + (peek_byte >= 0 ? 1 : 0);
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+    if (!tls_up || size == 0) return -1;
+    size_t got = 0;
+    if (peek_byte >= 0) {
+        buf[got++] = (uint8_t)peek_byte;
+        peek_byte = -1;
+    }
+    if (got < size && !peer_closed) {
+        const int ret = mbedtls_ssl_read(&ssl, buf + got, size - got);
+        if (ret > 0) {
+            got += (size_t)ret;
+        } else if (ret == 0 || !want_io(ret)) {
+            peer_closed = true;
+        }
+    }
+    return got > 0 ? (int)got : -1;
+}
+
+int TlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int TlsClient::peek() {
+    if (peek_byte < 0) {
+        uint8_t b;
+        if (available() <= 0 || read(&b, 1) != 1) return -1;
+        peek_byte = b;
+    }
+    return peek_byte;
+}
+
+uint8_t TlsClient::connected() {
+    if (!tls_up) return 0;
+    if (!peer_closed) return 1;
+    return available() > 0 ? 1 : 0;
+}
+
+void tls_client_forget(const char* host, uint16_t port) {
+#if TLS_SESSION_CACHE_ENTRIES > 0
+    if (!host) return;
+    xSemaphoreTake(cache_lock(), portMAX_DELAY);
+    cache_init_locked();
+    CachedSession* e = cache_find_locked(host, port);
+    if (e) cache_drop_locked(e);
+    const uint8_t count = cache_count_locked();
+    xSemaphoreGive(cache_lock());
+
+    portENTER_CRITICAL(&g_stats_mux);
+    g_stats.sessions = count;
+    portEXIT_CRITICAL(&g_stats_mux);
+#else
+    (void)host;
+    (void)port;
+#endif
+}
+
+void tls_client_get_stats(TlsClientStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_stats_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_stats_mux);
+}
@@ -0,0 +1,88 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include "board_config.h"
+
+// Outbound HTTPS client with TLS session resumption (TLS_SESSION_CACHE_ENTRIES)
+// A drop-in for WiFiClientSecure in insecure mode (no certificate checks),
+// built on mbedTLS directly so the negotiated session can be kept. The last
+// session of each host:port (its ID, and the ticket when the server issues
+// one) is cached in RAM, and the next connect to that host offers it. A
+// server that accepts skips the certificate exchange and key agreement: one
+// round trip and no public-key math instead of the full handshake, and none
+// of the certificate-chain parsing that costs internal heap.
+//
+// Sessions are negotiated at TLS 1.2 at most. mbedTLS can resume those from
+// the handshake alone, while TLS 1.3 tickets only arrive after it.
+//
+// Used by image_url downloads and the GitHub release check and firmware
+// download. It derives from WiFiClient so HTTPClient can drive it.
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <mbedtls/ssl.h>
+
+struct TlsClientStats {
+    uint32_t full;           // full handshakes
+    uint32_t resumed;        // abbreviated handshakes from a cached session
+    uint32_t failed;         // connects that did not finish the handshake
+    uint32_t full_us;        // average full handshake
+    uint32_t resumed_us;     // average resumed handshake
+    uint32_t last_us;        // last handshake, either kind
+    uint32_t conn_heap;      // internal heap held by the last connection once up
+    uint32_t handshake_heap; // internal heap low-water drop during the last handshake
+    uint8_t sessions;        // sessions cached now
+};
+
+class TlsClient : public WiFiClient {
+public:
+    TlsClient();
+    ~TlsClient() override;
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeout_ms) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeout_ms) override;
+
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    // Socket for select() by callers that wait for data; -1 when closed.
+    int fd() const { return sock; }
+
+    // Connect + handshake timeout for connect() without one, and for writes.
+    void setHandshakeTimeout(uint32_t ms) { handshake_timeout_ms = ms; }
+
+    // Whether the current connection resumed a cached session.
+    bool resumed() const { return was_resumed; }
+
+private:
+    bool open_socket(const IPAddress& ip, uint16_t port, uint32_t deadline_ms);
+    bool handshake(const char* host, uint16_t port, uint32_t deadline_ms);
+    bool wait_socket(bool for_write, uint32_t deadline_ms);
+    void close_all();
+
+    int sock = -1;
+    bool tls_up = false;
+    bool peer_closed = false;
+    bool was_resumed = false;
+    int peek_byte = -1;
+    uint32_t handshake_timeout_ms = TLS_HANDSHAKE_TIMEOUT_MS;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+};
+
+// Drop the cached session for host:port (e.g. after the server rejected it).
+void tls_client_forget(const char* host, uint16_t port);
+
+void tls_client_get_stats(TlsClientStats* out);
+
+#endif // TLS_CLIENT_H
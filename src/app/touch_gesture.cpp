@@ -0,0 +1,122 @@
+#include "touch_gesture.h"
+
+#if HAS_TOUCH
+
+#include <freertos/FreeRTOS.h>
+
+// Travel that still counts as a tap (1/16 of the shorter display side).
+static constexpr uint32_t kSlopDivisor = 16;
+
+static constexpr uint32_t kShortSide = (DISPLAY_WIDTH < DISPLAY_HEIGHT) ? DISPLAY_WIDTH : DISPLAY_HEIGHT;
+static constexpr int32_t kSlopPx = (int32_t)(kShortSide / kSlopDivisor);
+static constexpr int32_t kSwipeMinPx = (int32_t)(kShortSide * TOUCH_SWIPE_MIN_DISTANCE_PCT / 100);
+
+// Touch reads all come from the LVGL task; stats are also read by the web task.
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static TouchGestureStats g_stats = {};
+
+static bool g_down = false;
+static bool g_fired = false;       // this press produced its gesture
+static bool g_moved = false;       // left the slop: no long-press
+static bool g_consumed = false;
+static int16_t g_x0 = 0;
+static int16_t g_y0 = 0;
+static int16_t g_x = 0;
+static int16_t g_y = 0;
+static uint32_t g_t0_us = 0;
+
+static inline int32_t iabs(int32_t v) { return v < 0 ? -v : v; }
+
+static TouchGesture fire(TouchGesture gesture) {
+    g_fired = true;
+    portENTER_CRITICAL(&g_mux);
+    if (gesture == TouchGesture::LongPress) g_stats.long_presses++;
+    else g_stats.swipes++;
+    portEXIT_CRITICAL(&g_mux);
+    return gesture;
+}
+
+static TouchGesture classify_swipe(uint32_t t_us) {
+    if ((t_us - g_t0_us) > (uint32_t)TOUCH_SWIPE_MAX_MS * 1000u) return TouchGesture::None;
+
+    const int32_t dx = (int32_t)g_x - g_x0;
+    const int32_t dy = (int32_t)g_y - g_y0;
+    const int32_t ax = iabs(dx);
+    const int32_t ay = iabs(dy);
+
+    if (ax >= kSwipeMinPx && ax >= 2 * ay) {
+        return dx < 0 ? TouchGesture::SwipeLeft : TouchGesture::SwipeRight;
+    }
+    if (ay >= kSwipeMinPx && ay >= 2 * ax) {
+        return dy < 0 ? TouchGesture::SwipeUp : TouchGesture::SwipeDown;
+    }
+    return TouchGesture::None;
+}
+
+TouchGesture touch_gesture_feed(bool pressed, uint16_t x, uint16_t y, uint32_t t_us) {
+    if (pressed && !g_down) {
+        g_down = true;
+        g_fired = false;
+        g_moved = false;
+        g_consumed = false;
+        g_x0 = g_x = (int16_t)x;
+        g_y0 = g_y = (int16_t)y;
+        g_t0_us = t_us;
+        return TouchGesture::None;
+    }
+    if (!g_down) return TouchGesture::None;
+
+    if (pressed) {
+        g_x = (int16_t)x;
+        g_y = (int16_t)y;
+        if (!g_moved && (iabs((int32_t)g_x - g_x0) > kSlopPx || iabs((int32_t)g_y - g_y0) > kSlopPx)) {
+            g_moved = true;
+        }
+        if (!g_fired && !g_moved && (t_us - g_t0_us) >= (uint32_t)TOUCH_LONG_PRESS_MS * 1000u) {
+            return fire(TouchGesture::LongPress);
+        }
+        return TouchGesture::None;
+    }
+
+    // Lift: the last pressed position is where the swipe ended.
+    g_down = false;
+    if (g_fired) return TouchGesture::None;
+    const TouchGesture swipe = classify_swipe(t_us);
+    return swipe == TouchGesture::None ? swipe : fire(swipe);
+}
+
+void touch_gesture_reset() {
+    g_down = false;
+    g_fired = false;
+}
+
+void touch_gesture_consume() {
+    g_consumed = true;
+    portENTER_CRITICAL(&g_mux);
+    g_stats.handled++;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+bool touch_gesture_press_consumed() {
+    return g_consumed;
+}
+
+const char* touch_gesture_name(TouchGesture gesture) {
+    switch (gesture) {
+        case TouchGesture::SwipeLeft: return "swipe_left";
+        case TouchGesture::SwipeRight: return "swipe_right";
+        case TouchGesture::SwipeUp: return "swipe_up";
+        case TouchGesture::SwipeDown: return "swipe_down";
+        case TouchGesture::LongPress: return "long_press";
+        default: return "none";
+    }
+}
+
+void touch_gesture_get_stats(TouchGestureStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+#endif // HAS_TOUCH
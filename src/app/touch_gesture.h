@@ -0,0 +1,60 @@
+/*
+ * Touch Gestures
+ *
+ * Recognises swipes and long-presses on the touch sample stream that
+ * TouchManager::readCallback hands to LVGL (interrupt samples or polled
+ * reads). Integer math on a few words of state; nothing is allocated.
+ *
+ *   swipe       press-to-lift travel of at least TOUCH_SWIPE_MIN_DISTANCE_PCT
+ *               of the shorter display side within TOUCH_SWIPE_MAX_MS, the
+ *               major axis at least twice the minor one
+ *   long-press  held for TOUCH_LONG_PRESS_MS without leaving the tap slop
+ *
+ * At most one gesture per press. When the consumer acts on it
+ * (touch_gesture_consume()), the press no longer counts as a tap, so the
+ * button under the finger is not clicked on release.
+ */
+
+#pragma once
+
+#include "board_config.h"
+
+#include <stdint.h>
+
+enum class TouchGesture : uint8_t {
+    None,
+    SwipeLeft,    // finger moves right to left
+    SwipeRight,
+    SwipeUp,
+    SwipeDown,
+    LongPress,
+};
+
+struct TouchGestureStats {
+    uint32_t swipes;
+    uint32_t long_presses;
+    uint32_t handled;    // gestures a consumer acted on
+};
+
+#if HAS_TOUCH
+
+// One touch read: state and position (display coordinates; ignored when
+// released) at t_us (esp_timer, low 32 bits). Returns the gesture this read
+// completes, if any.
+TouchGesture touch_gesture_feed(bool pressed, uint16_t x, uint16_t y, uint32_t t_us);
+
+// Forget the current press (input suppressed, e.g. screen saver wake).
+void touch_gesture_reset();
+
+// The consumer acted on the gesture just returned by touch_gesture_feed().
+void touch_gesture_consume();
+
+// True while (and after, until the next touch-down) a press ended in a
+// consumed gesture: click handlers should ignore it.
+bool touch_gesture_press_consumed();
+
+const char* touch_gesture_name(TouchGesture gesture);
+
+void touch_gesture_get_stats(TouchGestureStats* out);
+
+#endif // HAS_TOUCH
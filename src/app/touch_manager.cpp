@@ -10,6 +10,8 @@
 #if HAS_DISPLAY
 #include "display_manager.h"
 #include "screen_saver_manager.h"
+#include "tap_latency.h"
+#include "touch_gesture.h"
 #endif
 
 // Include selected touch driver header.
@@ -22,6 +24,13 @@
 #include "drivers/esp_panel_cst816s_touch_driver.h"
 #endif
 
+#include <esp_timer.h>
+
+#if TOUCH_SAMPLER
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
 // Global instance
 TouchManager* touchManager = nullptr;
 
@@ -30,6 +39,163 @@ static uint32_t g_lvgl_suppress_until_ms = 0;
 static bool g_lvgl_force_released = false;
 static bool g_prev_lvgl_pressed = false;
 
+#if TOUCH_SAMPLER
+// While a finger is down the controller is also read at this interval, so a
+// lift is seen even when the controller sends no INT pulse for it.
+static constexpr uint32_t kPressedPollMs = 20;
+// Above the LVGL task so a touch-down is read (and LVGL woken) mid-render.
+static constexpr UBaseType_t kSamplerPriority = tskIDLE_PRIORITY + 2;
+static constexpr uint32_t kSamplerStackBytes = 3072;
+
+#if TOUCH_DRIVER == TOUCH_DRIVER_XPT2046
+// T_IRQ (PENIRQ) is a level: low while pressed, and it toggles during every
+// conversion burst. Only the touch-down edge means anything; while pressed the
+// task polls and discards the edges its own reads caused. GPIO36 (CYD) has no
+// internal pull-up; the board pulls T_IRQ up.
+static constexpr bool kIrqMarksPressOnly = true;
+static constexpr uint8_t kSamplerPinMode = INPUT;
+#else
+static constexpr bool kIrqMarksPressOnly = false;
+static constexpr uint8_t kSamplerPinMode = INPUT_PULLUP;
+#endif
+
+struct TouchSample {
+    uint16_t x;
+    uint16_t y;
+    bool pressed;
+    uint32_t t_us;   // esp_timer, low 32 bits
+};
+
+// Ring, newest sample and stats are shared between the sampling task and the
+// LVGL task; all access is under g_sample_mux.
+static portMUX_TYPE g_sample_mux = portMUX_INITIALIZER_UNLOCKED;
+static TouchSample g_samples[TOUCH_SAMPLE_RING];
+static uint8_t g_sample_head = 0;
+static uint8_t g_sample_count = 0;
+static TouchSample g_newest = {};
+static TouchSamplerStats g_sampler_stats = {};
+static volatile uint32_t g_sample_irqs = 0;   // ISR only
+
+static TouchSample g_lvgl_sample = {};        // last sample handed to LVGL (read callback only)
+static TaskHandle_t g_sample_task = nullptr;
+static lv_indev_drv_t* g_sample_indev_drv = nullptr;
+static bool g_sampler_active = false;
+
+static void IRAM_ATTR sample_isr(void* arg) {
+    (void)arg;
+    g_sample_irqs = g_sample_irqs + 1;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(g_sample_task, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void sample_push(const TouchSample& sample) {
+    portENTER_CRITICAL(&g_sample_mux);
+    g_newest = sample;
+    g_sampler_stats.samples++;
+    const uint8_t newest = (uint8_t)((g_sample_head + g_sample_count + TOUCH_SAMPLE_RING - 1) % TOUCH_SAMPLE_RING);
+    if (g_sample_count == TOUCH_SAMPLE_RING && sample.pressed && g_samples[newest].pressed) {
+        // LVGL is behind: merge moves, but never lose a press/lift edge.
+        g_samples[newest] = sample;
+        g_sampler_stats.coalesced++;
+    } else {
+        if (g_sample_count == TOUCH_SAMPLE_RING) {
+            g_sample_head = (uint8_t)((g_sample_head + 1) % TOUCH_SAMPLE_RING);
+            g_sample_count--;
+            g_sampler_stats.dropped++;
+        }
+        g_samples[(g_sample_head + g_sample_count) % TOUCH_SAMPLE_RING] = sample;
+        g_sample_count++;
+    }
+    portEXIT_CRITICAL(&g_sample_mux);
+}
+
+// Oldest queued sample into g_lvgl_sample; returns true when more are queued.
+static bool sample_pop() {
+    bool more = false;
+    portENTER_CRITICAL(&g_sample_mux);
+    if (g_sample_count > 0) {
+        g_lvgl_sample = g_samples[g_sample_head];
+        g_sample_head = (uint8_t)((g_sample_head + 1) % TOUCH_SAMPLE_RING);
+        g_sample_count--;
+        more = g_sample_count > 0;
+    }
+    portEXIT_CRITICAL(&g_sample_mux);
+    return more;
+}
+
+// Suppressed reads discard what was queued meanwhile.
+static void sample_drain() {
+    portENTER_CRITICAL(&g_sample_mux);
+    g_sample_count = 0;
+    g_lvgl_sample = g_newest;
+    portEXIT_CRITICAL(&g_sample_mux);
+}
+
+static void sample_wake_lvgl() {
+    #if HAS_DISPLAY
+    // Run the indev read on the next cycle instead of waiting out its period.
+    // Skipped when the LVGL task holds the lock: it is awake and reads soon.
+    if (g_sample_indev_drv && display_manager_try_lock(0)) {
+        if (g_sample_indev_drv->read_timer) lv_timer_ready(g_sample_indev_drv->read_timer);
+        display_manager_unlock();
+    }
+    display_manager_request_render();
+    #endif
+}
+
+static void sample_task_fn(void* arg) {
+    TouchDriver* driver = (TouchDriver*)arg;
+    bool pressed = false;
+    TouchSample sample = {};
+    for (;;) {
+        if (pressed && kIrqMarksPressOnly) {
+            vTaskDelay(pdMS_TO_TICKS(kPressedPollMs));
+            (void)ulTaskNotifyTake(pdTRUE, 0);
+        } else {
+            (void)ulTaskNotifyTake(pdTRUE, pressed ? pdMS_TO_TICKS(kPressedPollMs) : portMAX_DELAY);
+        }
+
+        uint16_t x, y;
+        const bool now_pressed = driver->getTouch(&x, &y);
+        portENTER_CRITICAL(&g_sample_mux);
+        g_sampler_stats.reads++;
+        portEXIT_CRITICAL(&g_sample_mux);
+
+        // INT pulses without a point (gestures, controller housekeeping).
+        if (!now_pressed && !pressed) continue;
+
+        if (now_pressed) {
+            sample.x = x;
+            sample.y = y;
+        }
+        sample.pressed = now_pressed;
+        sample.t_us = (uint32_t)esp_timer_get_time();
+        sample_push(sample);
+
+        const bool pressed_edge = now_pressed && !pressed;
+        pressed = now_pressed;
+        if (pressed_edge) sample_wake_lvgl();
+    }
+}
+
+static bool sample_start(TouchDriver* driver) {
+    if (xTaskCreate(sample_task_fn, "TouchSample", kSamplerStackBytes, driver, kSamplerPriority, &g_sample_task) != pdPASS) {
+        g_sample_task = nullptr;
+        Logger.logLine("Touch sampler: task create failed; polling");
+        return false;
+    }
+    pinMode(TOUCH_SAMPLER_PIN, kSamplerPinMode);
+    attachInterruptArg(TOUCH_SAMPLER_PIN, sample_isr, nullptr, FALLING);
+    // Pick up a finger that is already down.
+    xTaskNotifyGive(g_sample_task);
+    Logger.logLinef("Touch sampler: INT on GPIO%d", TOUCH_SAMPLER_PIN);
+    return true;
+}
+#endif // TOUCH_SAMPLER
+
 TouchManager::TouchManager() 
     : driver(nullptr), indev(nullptr), lvglRegisterPending(false) {
     // Driver will be instantiated in init() after display is ready
@@ -50,11 +216,34 @@ void TouchManager::readCallback(lv_indev_drv_t* drv, lv_indev_data_t* data) {
     if (g_lvgl_force_released || ((int32_t)(g_lvgl_suppress_until_ms - now) > 0)) {
         data->state = LV_INDEV_STATE_RELEASED;
         g_prev_lvgl_pressed = false;
+        #if TOUCH_SAMPLER
+        if (g_sampler_active) sample_drain();
+        #endif
+        #if HAS_DISPLAY
+        tap_latency_note_touch(false);
+        touch_gesture_reset();
+        #endif
         return;
     }
     
     uint16_t x, y;
-    if (manager->driver->getTouch(&x, &y)) {
+    bool pressed;
+    uint32_t at_us = 0;
+    #if TOUCH_SAMPLER
+    if (g_sampler_active) {
+        // An empty ring repeats the last sample (finger still down, or up).
+        data->continue_reading = sample_pop();
+        pressed = g_lvgl_sample.pressed;
+        x = g_lvgl_sample.x;
+        y = g_lvgl_sample.y;
+        at_us = g_lvgl_sample.t_us;
+    } else
+    #endif
+    {
+        pressed = manager->driver->getTouch(&x, &y);
+    }
+
+    if (pressed) {
         data->state = LV_INDEV_STATE_PRESSED;
         data->point.x = x;
         data->point.y = y;
@@ -72,6 +261,21 @@ void TouchManager::readCallback(lv_indev_drv_t* drv, lv_indev_data_t* data) {
         data->state = LV_INDEV_STATE_RELEASED;
         g_prev_lvgl_pressed = false;
     }
+
+    #if HAS_DISPLAY
+    // Finger lift = the start of a tap's latency trace (LVGL clicks on release).
+    tap_latency_note_touch(data->state == LV_INDEV_STATE_PRESSED, at_us);
+    #endif
+
+    #if HAS_DISPLAY && MACROPAD_GESTURES
+    // Fed before LVGL processes this read: a lift that completes a consumed
+    // swipe is flagged by the time the button under it gets LV_EVENT_CLICKED.
+    const TouchGesture gesture = touch_gesture_feed(pressed, x, y, at_us ? at_us : (uint32_t)esp_timer_get_time());
+    if (gesture != TouchGesture::None && display_manager_handle_gesture(gesture)) {
+        touch_gesture_consume();
+        Logger.logMessagef("Touch", "Gesture: %s", touch_gesture_name(gesture));
+    }
+    #endif
 }
 
 void TouchManager::init() {
@@ -83,13 +287,20 @@ void TouchManager::init() {
     #elif TOUCH_DRIVER == TOUCH_DRIVER_AXS15231B
     driver = new AXS15231B_TouchDriver();
     #elif TOUCH_DRIVER == TOUCH_DRIVER_CST816S_ESP_PANEL
-    driver = new ESPPanel_CST816S_TouchDriver();
+    // The sampler owns the INT line; ESP_Panel then installs no handler of its own.
+    driver = new ESPPanel_CST816S_TouchDriver((TOUCH_SAMPLER && TOUCH_INT >= 0) ? -1 : TOUCH_INT);
     #else
     #error "No touch driver selected or unknown driver type"
     #endif
     
     // Initialize hardware
     driver->init();
+
+    #if TOUCH_SAMPLER
+    if (TOUCH_SAMPLER_PIN >= 0) {
+        g_sampler_active = sample_start(driver);
+    }
+    #endif
     
     // Set calibration if defined
     #if defined(TOUCH_CAL_X_MIN) && defined(TOUCH_CAL_X_MAX) && defined(TOUCH_CAL_Y_MIN) && defined(TOUCH_CAL_Y_MAX)
@@ -134,6 +345,9 @@ bool TouchManager::tryRegisterWithLVGL() {
     indev_drv.read_cb = TouchManager::readCallback;
     indev_drv.user_data = this;
     indev = lv_indev_drv_register(&indev_drv);
+    #if TOUCH_SAMPLER
+    if (indev) g_sample_indev_drv = &indev_drv;
+    #endif
 
     #if HAS_DISPLAY
     display_manager_unlock();
@@ -148,10 +362,31 @@ void TouchManager::loop() {
 }
 
 bool TouchManager::isTouched() {
+    #if TOUCH_SAMPLER
+    // The sampling task owns the bus; answer from its newest sample.
+    if (g_sampler_active) {
+        portENTER_CRITICAL(&g_sample_mux);
+        const bool pressed = g_newest.pressed;
+        portEXIT_CRITICAL(&g_sample_mux);
+        return pressed;
+    }
+    #endif
     return driver->isTouched();
 }
 
 bool TouchManager::getTouch(uint16_t* x, uint16_t* y) {
+    #if TOUCH_SAMPLER
+    if (g_sampler_active) {
+        portENTER_CRITICAL(&g_sample_mux);
+        const TouchSample s = g_newest;
+        portEXIT_CRITICAL(&g_sample_mux);
+        if (s.pressed && x && y) {
+            *x = s.x;
+            *y = s.y;
+        }
+        return s.pressed;
+    }
+    #endif
     return driver->getTouch(x, y);
 }
 
@@ -173,6 +408,18 @@ bool touch_manager_is_touched() {
     return touchManager->isTouched();
 }
 
+void touch_manager_get_sampler_stats(TouchSamplerStats* out) {
+    if (!out) return;
+    *out = {};
+    #if TOUCH_SAMPLER
+    portENTER_CRITICAL(&g_sample_mux);
+    *out = g_sampler_stats;
+    portEXIT_CRITICAL(&g_sample_mux);
+    out->active = g_sampler_active;
+    out->irqs = g_sample_irqs;
+    #endif
+}
+
 void touch_manager_suppress_lvgl_input(uint32_t duration_ms) {
     const uint32_t now = millis();
     const uint32_t until = now + duration_ms;
@@ -3,6 +3,12 @@
  * 
  * Manages touch controller lifecycle and LVGL integration.
  * Follows the same pattern as DisplayManager.
+ *
+ * Interrupt sampling (TOUCH_INT_SAMPLING, CST816S with TOUCH_INT or XPT2046
+ * with TOUCH_IRQ wired): the INT line wakes a sampling task that reads the
+ * controller into a timestamped ring; the LVGL read callback only drains the
+ * ring, and a touch-down wakes the LVGL task at once. Without a finger on the
+ * panel there is no bus traffic. Other drivers are read on every indev poll.
  */
 
 #ifndef TOUCH_MANAGER_H
@@ -16,6 +22,25 @@
 #include <lvgl.h>
 #include "touch_driver.h"
 
+#if TOUCH_INT_SAMPLING && TOUCH_DRIVER == TOUCH_DRIVER_CST816S_ESP_PANEL && defined(TOUCH_INT)
+#define TOUCH_SAMPLER 1
+#define TOUCH_SAMPLER_PIN TOUCH_INT
+#elif TOUCH_INT_SAMPLING && TOUCH_DRIVER == TOUCH_DRIVER_XPT2046 && defined(TOUCH_IRQ)
+#define TOUCH_SAMPLER 1
+#define TOUCH_SAMPLER_PIN TOUCH_IRQ
+#else
+#define TOUCH_SAMPLER 0
+#endif
+
+struct TouchSamplerStats {
+    bool active;          // false: polled on every LVGL read
+    uint32_t irqs;        // INT edges
+    uint32_t reads;       // controller reads by the sampling task
+    uint32_t samples;     // samples queued for LVGL
+    uint32_t coalesced;   // moves merged into the newest sample (ring full)
+    uint32_t dropped;     // oldest samples lost (ring full)
+};
+
 class TouchManager {
 private:
     TouchDriver* driver;
@@ -48,6 +73,8 @@ void touch_manager_init();
 void touch_manager_loop();
 bool touch_manager_is_touched();
 
+void touch_manager_get_sampler_stats(TouchSamplerStats* out);
+
 // Temporarily suppress LVGL touch input (forces LVGL state=RELEASED).
 // Useful to avoid "wake tap" click-through when turning the backlight back on.
 void touch_manager_suppress_lvgl_input(uint32_t duration_ms);
@@ -0,0 +1,106 @@
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+#include "log_manager.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static_assert((TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) == 0, "TRACE_RING_EVENTS must be a power of two");
+static_assert(sizeof(TraceEvent) == 16, "TraceEvent is meant to stay 16 bytes");
+
+namespace {
+
+constexpr uint32_t kMask = TRACE_RING_EVENTS - 1;
+
+struct Ring {
+    TraceEvent* events;
+    uint32_t head;  // total events claimed; the next write goes to head & kMask
+};
+
+Ring g_rings[portNUM_PROCESSORS] = {};
+volatile uint32_t g_paused = 0;
+
+} // namespace
+
+void trace_init() {
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        if (g_rings[c].events) continue;
+        const size_t bytes = sizeof(TraceEvent) * TRACE_RING_EVENTS;
+        TraceEvent* p = nullptr;
+        if (psramFound()) {
+            p = (TraceEvent*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (!p) {
+            p = (TraceEvent*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (!p) {
+            Logger.logMessagef("Trace", "No memory for the core %d ring (%u bytes); tracing off", c, (unsigned)bytes);
+            return;
+        }
+        memset(p, 0, bytes);
+        g_rings[c].head = 0;
+        g_rings[c].events = p;
+    }
+    Logger.logMessagef("Trace", "Recording: %u events per core", (unsigned)TRACE_RING_EVENTS);
+}
+
+void trace_record(TraceType type, const char* name, int32_t value) {
+    if (g_paused) return;
+    Ring& r = g_rings[xPortGetCoreID()];
+    if (!r.events) return;
+
+    // Tasks on one core can preempt each other mid-write, so each claims its
+    // slot first; a task that migrates afterwards still owns the slot.
+    const uint32_t slot = __atomic_fetch_add(&r.head, 1, __ATOMIC_RELAXED) & kMask;
+    TraceEvent& e = r.events[slot];
+    e.ts_us = (uint32_t)esp_timer_get_time();
+    e.name = name;
+    e.task = (uintptr_t)xTaskGetCurrentTaskHandle() | (uintptr_t)type;
+    e.value = value;
+}
+
+void trace_pause() {
+    __atomic_add_fetch(&g_paused, 1, __ATOMIC_SEQ_CST);
+}
+
+void trace_resume() {
+    if (g_paused) __atomic_sub_fetch(&g_paused, 1, __ATOMIC_SEQ_CST);
+}
+
+void trace_clear() {
+    trace_pause();
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        __atomic_store_n(&g_rings[c].head, 0, __ATOMIC_SEQ_CST);
+    }
+    trace_resume();
+}
+
+int trace_core_count() {
+    return portNUM_PROCESSORS;
+}
+
+uint32_t trace_event_count(int core) {
+    if (core < 0 || core >= portNUM_PROCESSORS || !g_rings[core].events) return 0;
+    const uint32_t head = __atomic_load_n(&g_rings[core].head, __ATOMIC_SEQ_CST);
+    return head < TRACE_RING_EVENTS ? head : TRACE_RING_EVENTS;
+}
+
+uint32_t trace_dropped(int core) {
+    if (core < 0 || core >= portNUM_PROCESSORS) return 0;
+    const uint32_t head = __atomic_load_n(&g_rings[core].head, __ATOMIC_SEQ_CST);
+    return head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+}
+
+bool trace_event_at(int core, uint32_t i, TraceEvent* out) {
+    const uint32_t n = trace_event_count(core);
+    if (i >= n) return false;
+    const uint32_t head = __atomic_load_n(&g_rings[core].head, __ATOMIC_SEQ_CST);
+    *out = g_rings[core].events[(head - n + i) & kMask];
+    return out->name != nullptr;
+}
+
+#endif // TRACE_ENABLED
@@ -0,0 +1,88 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "board_config.h"
+
+// Event Tracing (TRACE_ENABLED)
+// Begin/end/instant/counter events go into one ring per core (PSRAM when
+// present). Recording an event is a few stores and one atomic increment: no
+// lock, no allocation, no formatting. Each event is 16 bytes: a 32-bit
+// microsecond timestamp, the event name (a string literal, stored as a
+// pointer), the recording task and a value. When a ring is full the oldest
+// events are overwritten.
+//
+// GET /api/trace returns the rings as Chrome trace JSON (chrome://tracing or
+// ui.perfetto.dev): one process per core, one thread per task.
+// DELETE /api/trace clears them.
+//
+// With TRACE_ENABLED false every TRACE_* macro compiles to nothing.
+
+#include <Arduino.h>
+
+enum class TraceType : uint8_t {
+    Begin = 0,
+    End = 1,
+    Instant = 2,
+    Counter = 3,
+};
+
+struct TraceEvent {
+    uint32_t ts_us;     // low 32 bits of esp_timer_get_time()
+    const char* name;   // string literal
+    uintptr_t task;     // TaskHandle_t | TraceType (handles are 4-byte aligned)
+    int32_t value;      // counter value; 0 for the other types
+};
+
+#if TRACE_ENABLED
+
+// Allocate the rings. Events recorded before this are dropped.
+void trace_init();
+
+// Any task; name must outlive the trace (a literal).
+void trace_record(TraceType type, const char* name, int32_t value);
+
+// Readers (the /api/trace export). Recording is off while paused, so a dump
+// sees a stable ring; pause/resume nest.
+void trace_pause();
+void trace_resume();
+void trace_clear();
+
+int trace_core_count();
+// Events held for core (oldest first via trace_event_at(core, 0..n-1)).
+uint32_t trace_event_count(int core);
+bool trace_event_at(int core, uint32_t i, TraceEvent* out);
+uint32_t trace_dropped(int core);
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(name) { trace_record(TraceType::Begin, name_, 0); }
+    ~TraceScope() { trace_record(TraceType::End, name_, 0); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_BEGIN(name) trace_record(TraceType::Begin, (name), 0)
+#define TRACE_END(name) trace_record(TraceType::End, (name), 0)
+#define TRACE_INSTANT(name) trace_record(TraceType::Instant, (name), 0)
+#define TRACE_COUNTER(name, value) trace_record(TraceType::Counter, (name), (int32_t)(value))
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#else
+
+inline void trace_init() {}
+
+#define TRACE_BEGIN(name) do {} while (0)
+#define TRACE_END(name) do {} while (0)
+#define TRACE_INSTANT(name) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#define TRACE_SCOPE(name) do {} while (0)
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
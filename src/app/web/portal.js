@@ -18,7 +18,9 @@ const API_FIRMWARE_UPDATE_STATUS = '/api/firmware/update/status';
 const API_MACROS = '/api/macros';
 const API_ICONS = '/api/icons';
 const API_ICONS_INSTALLED = '/api/icons/installed';
-const API_ICON_INSTALL = '/api/icons/install';
+const API_ICON_INSTALL_BATCH = '/api/icons/install_batch';
+// Keep bundles under the smallest ICON_STORE_BATCH_MAX_BYTES (96 KB on non-PSRAM boards).
+const ICON_BATCH_MAX_BYTES = 90 * 1024;
 const API_ICONS_GC = '/api/icons/gc';
 
 let selectedFile = null;
@@ -76,6 +78,10 @@ let macrosSelectedScreen = 0; // 0-based
 let macrosSelectedButton = 0; // 0-based
 let macrosDirty = false;
 let macrosLoading = false;
+// Last config the device confirmed (load or save); saves diff against it to send PATCHes.
+let macrosSavedPayload = null;
+// Above this many changed screens/buttons a save POSTs the whole config instead.
+const MACROS_PATCH_MAX = 8;
 
 function macrosClampRgb24(value) {
     const v = (typeof value === 'number' && isFinite(value)) ? value : 0;
@@ -302,38 +308,115 @@ async function convertPngBlobToLvgl565aBlob(pngBlob, { width = 64, height = 64 }
         const b = rgba[i + 2];
         const a = rgba[i + 3];
 
-        const rgb565 = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+        // Fully transparent pixels all become 0 so they compress into long runs.
+        const rgb565 = a ? (((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)) : 0;
         out[o + 0] = rgb565 & 0xff;        // little-endian
         out[o + 1] = (rgb565 >> 8) & 0xff;
         out[o + 2] = a;
         o += 3;
     }
 
-    return buf;
+    // Prefer ICN2 RLE (format 1, encoding 1) when it is smaller.
+    const rle = packBits3(out.subarray(headerSize));
+    if (rle.length >= payloadSize) return buf;
+
+    const packed = new ArrayBuffer(headerSize + rle.length);
+    const pdv = new DataView(packed);
+    const pout = new Uint8Array(packed);
+    // Magic "ICN2"
+    pout[0] = 0x49; pout[1] = 0x43; pout[2] = 0x4e; pout[3] = 0x32;
+    pdv.setUint16(4, width, true);
+    pdv.setUint16(6, height, true);
+    pdv.setUint8(8, 1); // format 1 = RGB565+Alpha
+    pdv.setUint8(9, 1); // encoding 1 = RLE
+    pdv.setUint16(10, 0, true);
+    pdv.setUint32(12, rle.length, true);
+    pout.set(rle, headerSize);
+    return packed;
 }
 
-async function installTwemojiToDevice(emojiStr, { onProgress } = {}) {
+// PackBits over 3-byte pixels (see src/app/pixel_codec.h).
+function packBits3(px) {
+    const n = px.length / 3;
+    const same = (a, b) => px[a * 3] === px[b * 3] && px[a * 3 + 1] === px[b * 3 + 1] && px[a * 3 + 2] === px[b * 3 + 2];
+    const out = [];
+    let i = 0;
+    while (i < n) {
+        let run = 1;
+        while (i + run < n && run < 129 && same(i + run, i)) run++;
+        if (run >= 2) {
+            out.push(0x80 + run - 2, px[i * 3], px[i * 3 + 1], px[i * 3 + 2]);
+            i += run;
+            continue;
+        }
+        const start = i;
+        while (i < n && i - start < 128 && !(i + 1 < n && same(i + 1, i))) i++;
+        if (i === start) i++;
+        out.push(i - start - 1);
+        for (let k = start * 3; k < i * 3; k++) out.push(px[k]);
+    }
+    return Uint8Array.from(out);
+}
+
+async function prepareTwemojiIcon(emojiStr, { onProgress } = {}) {
     const iconId = suggestIconIdForEmoji(emojiStr);
 
     if (typeof onProgress === 'function') onProgress(`Downloading ${emojiStr}…`);
-    const { blob: pngBlob, url } = await fetchTwemojiPng(emojiStr);
+    const { blob: pngBlob } = await fetchTwemojiPng(emojiStr);
 
     if (typeof onProgress === 'function') onProgress(`Preparing ${emojiStr}…`);
     const lvglBlob = await convertPngBlobToLvgl565aBlob(pngBlob, { width: 64, height: 64 });
 
-    if (typeof onProgress === 'function') onProgress(`Uploading ${emojiStr}…`);
-    const res = await fetch(`${API_ICON_INSTALL}?id=${encodeURIComponent(iconId)}`, {
+    return { iconId, emojiStr, blob: new Uint8Array(lvglBlob) };
+}
+
+// One POST /api/icons/install_batch: records of u8 id_len, id, u32 blob_len (LE), blob.
+// Returns the device's per-record results (same order as icons).
+async function installIconBatch(icons) {
+    const enc = new TextEncoder();
+    const ids = icons.map(it => enc.encode(it.iconId));
+    let total = 0;
+    for (let i = 0; i < icons.length; i++) total += 1 + ids[i].length + 4 + icons[i].blob.length;
+
+    const body = new Uint8Array(total);
+    const dv = new DataView(body.buffer);
+    let o = 0;
+    for (let i = 0; i < icons.length; i++) {
+        body[o] = ids[i].length;
+        body.set(ids[i], o + 1);
+        o += 1 + ids[i].length;
+        dv.setUint32(o, icons[i].blob.length, true);
+        body.set(icons[i].blob, o + 4);
+        o += 4 + icons[i].blob.length;
+    }
+
+    const res = await fetch(API_ICON_INSTALL_BATCH, {
         method: 'POST',
         headers: { 'Content-Type': 'application/octet-stream' },
-        body: lvglBlob,
+        body,
     });
-
     const data = await res.json().catch(() => ({}));
-    if (!res.ok || data.success === false) {
+    if (!Array.isArray(data.results)) {
         throw new Error(data.message || `Install failed (${res.status})`);
     }
+    return data.results;
+}
 
-    return { iconId, sourceUrl: url };
+// Start the device's background icon GC and poll until it finishes (or give up after timeoutMs).
+async function runIconGc({ onProgress, timeoutMs = 30000 } = {}) {
+    const startRes = await fetch(API_ICONS_GC, { method: 'POST', cache: 'no-cache' });
+    const startData = await startRes.json().catch(() => ({}));
+    if (!startRes.ok || startData.success === false) return startData;
+
+    const deadline = Date.now() + timeoutMs;
+    while (Date.now() < deadline) {
+        await new Promise(r => setTimeout(r, 250));
+        const res = await fetch(API_ICONS_GC, { cache: 'no-cache' });
+        const data = await res.json().catch(() => ({}));
+        if (data.state !== 'running') return data;
+        if (onProgress) onProgress(`Cleaning up unused icons... (${Number(data.deleted || 0)} removed)`);
+    }
+    return { state: 'running', message: 'Timed out waiting for icon cleanup' };
 }
 
 async function macrosAutoInstallEmojiIcons(payload, { silent = false, onProgress } = {}) {
@@ -382,27 +465,65 @@ async function macrosAutoInstallEmojiIcons(payload, { silent = false, onProgress
     }
 
     const mapping = new Map(); // emojiStr -> iconId
-    let installIndex = 0;
     for (const emojiStr of emojiList) {
         const expectedId = suggestIconIdForEmoji(emojiStr);
-        if (installedIds.has(expectedId)) {
-            mapping.set(emojiStr, expectedId);
-            continue;
+        if (installedIds.has(expectedId)) mapping.set(emojiStr, expectedId);
+    }
+
+    // Download + convert everything first, then upload in as few bundles as fit.
+    const prepared = [];
+    for (let i = 0; i < toInstall.length; i++) {
+        const emojiStr = toInstall[i];
+        try {
+            if (typeof onProgress === 'function') onProgress(`(${i + 1}/${toInstall.length}) ${emojiStr}`);
+            prepared.push(await prepareTwemojiIcon(emojiStr, { onProgress }));
+        } catch (e) {
+            const msg = (e && e.message) ? e.message : 'Download failed';
+            return { ok: false, message: `Failed to install ${emojiStr}: ${msg}` };
         }
+    }
 
-        installIndex += 1;
-        const idx = installIndex;
-        const total = toInstall.length;
+    const batches = [];
+    let batch = [];
+    let batchBytes = 0;
+    for (const it of prepared) {
+        const size = 1 + it.iconId.length + 4 + it.blob.length;
+        if (batch.length > 0 && batchBytes + size > ICON_BATCH_MAX_BYTES) {
+            batches.push(batch);
+            batch = [];
+            batchBytes = 0;
+        }
+        batch.push(it);
+        batchBytes += size;
+    }
+    if (batch.length > 0) batches.push(batch);
+
+    const failures = [];
+    for (let b = 0; b < batches.length; b++) {
+        if (typeof onProgress === 'function') {
+            onProgress(batches.length > 1 ? `Uploading icons (${b + 1}/${batches.length})…` : 'Uploading icons…');
+        }
+        let results;
         try {
-            if (typeof onProgress === 'function' && total > 0) onProgress(`(${idx}/${total}) ${emojiStr}`);
-            const { iconId } = await installTwemojiToDevice(emojiStr, { onProgress });
-            mapping.set(emojiStr, iconId);
-            installedIds.add(iconId);
+            results = await installIconBatch(batches[b]);
         } catch (e) {
             const msg = (e && e.message) ? e.message : 'Install failed';
-            return { ok: false, message: `Failed to install ${emojiStr}: ${msg}` };
+            return { ok: false, message: `Failed to install emoji icons: ${msg}` };
+        }
+        for (const r of results) {
+            const it = batches[b][r.index];
+            if (!it) continue;
+            if (r.ok) {
+                mapping.set(it.emojiStr, it.iconId);
+                installedIds.add(it.iconId);
+            } else {
+                failures.push(`${it.emojiStr}: ${r.message || 'Install failed'}`);
+            }
         }
     }
+    if (failures.length > 0) {
+        return { ok: false, message: `Failed to install ${failures.join('; ')}` };
+    }
 
     // Replace literals in the payload with stable icon IDs.
     for (const screen of payload.screens) {
@@ -670,7 +791,7 @@ function macrosRenderIconSummary() {
 }
 
 function macrosActionUsesTextPayload(action) {
-    return action === 'send_keys' || action === 'mqtt_send';
+    return action === 'send_keys' || action === 'mqtt_send' || action === 'ble_host';
 }
 
 function macrosActionUsesScreenPayload(action) {
@@ -823,6 +944,9 @@ function macrosRenderButtonGrid() {
             subtitle.textContent = topic ? `MQTT → ${topic}` : 'MQTT → (set topic)';
         } else if (action === 'go_back') {
             subtitle.textContent = 'Back';
+        } else if (action === 'ble_host') {
+            const target = (cfg && cfg.payload) ? String(cfg.payload) : '';
+            subtitle.textContent = (target && target.toLowerCase() !== 'next') ? `Host ${target}` : 'Next Host';
         } else {
             subtitle.textContent = action;
         }
@@ -908,6 +1032,14 @@ function macrosRenderEditorFields() {
                 payloadHelpEl.innerHTML = `Optional payload text. <span style="margin-left: 8px;">Chars: <span id="macro_payload_chars">0</span>/${MACROS_PAYLOAD_MAX}</span>`;
             }
             if (duckyHelpBtn) duckyHelpBtn.style.display = 'none';
+        } else if (action === 'ble_host') {
+            payloadEl.maxLength = 8;
+            payloadEl.placeholder = 'next';
+            if (payloadLabelEl) payloadLabelEl.textContent = 'Bluetooth host profile';
+            if (payloadHelpEl) {
+                payloadHelpEl.innerHTML = 'Profile number (1, 2, ...) to switch to, or <code>next</code> (or empty) to cycle.';
+            }
+            if (duckyHelpBtn) duckyHelpBtn.style.display = 'none';
         } else {
             // Other payload actions handled elsewhere.
             if (duckyHelpBtn) duckyHelpBtn.style.display = 'none';
@@ -1493,6 +1625,7 @@ async function loadMacros() {
             macrosScreenCount = MACROS_SCREEN_COUNT_DEFAULT;
         }
         macrosPayloadCache = macrosNormalizePayload(payload);
+        macrosSavedPayload = macrosClonePayload(macrosPayloadCache);
         macrosSelectedScreen = 0;
         macrosSelectedButton = 0;
         macrosSetDirty(false);
@@ -1502,6 +1635,7 @@ async function loadMacros() {
         showMessage('Error loading macros: ' + error.message, 'error');
         // Fall back to empty editor so UI still works.
         macrosPayloadCache = macrosCreateEmptyPayload();
+        macrosSavedPayload = null;
         macrosRenderAll();
     } finally {
         macrosLoading = false;
@@ -1532,6 +1666,56 @@ function macrosValidatePayload(payload) {
     return { valid: true, message: 'OK' };
 }
 
+function macrosClonePayload(payload) {
+    return JSON.parse(JSON.stringify(payload));
+}
+
+// PATCH requests turning `saved` into `next`, or null when a full POST is needed
+// (no baseline, changed defaults, or too many edits).
+function macrosBuildPatches(saved, next) {
+    if (!saved || !Array.isArray(saved.screens) || saved.screens.length !== next.screens.length) return null;
+    if (JSON.stringify(saved.defaults) !== JSON.stringify(next.defaults)) return null;
+
+    const patches = [];
+    for (let s = 0; s < next.screens.length; s++) {
+        const a = saved.screens[s];
+        const b = next.screens[s];
+        if (!a || !Array.isArray(a.buttons) || a.buttons.length !== b.buttons.length) return null;
+
+        if (a.template !== b.template || a.screen_bg !== b.screen_bg) {
+            patches.push({
+                url: `${API_MACROS}/screens/${s}`,
+                body: { template: b.template, screen_bg: (typeof b.screen_bg === 'number') ? b.screen_bg : null },
+            });
+        }
+        for (let i = 0; i < b.buttons.length; i++) {
+            const btn = b.buttons[i];
+            if (JSON.stringify(a.buttons[i]) === JSON.stringify(btn)) continue;
+            // Send absent overrides as null so the device clears them.
+            const body = { ...btn };
+            for (const k of ['button_bg', 'icon_color', 'label_color']) {
+                if (typeof body[k] !== 'number') body[k] = null;
+            }
+            patches.push({ url: `${API_MACROS}/screens/${s}/buttons/${i}`, body });
+        }
+    }
+    return patches.length <= MACROS_PATCH_MAX ? patches : null;
+}
+
+async function macrosSendPatches(patches) {
+    for (const p of patches) {
+        const response = await fetch(p.url, {
+            method: 'PATCH',
+            headers: { 'Content-Type': 'application/json' },
+            body: JSON.stringify(p.body),
+        });
+        const data = await response.json().catch(() => ({}));
+        if (!response.ok || data.success === false) {
+            throw new Error(data.message || `Save failed (${response.status})`);
+        }
+    }
+}
+
 async function saveMacros(options = {}) {
     if (!macrosPayloadCache) return;
 
@@ -1591,18 +1775,30 @@ async function saveMacros(options = {}) {
     }
 
     try {
-        const response = await fetch(API_MACROS, {
-            method: 'POST',
-            headers: { 'Content-Type': 'application/json' },
-            body: JSON.stringify(payload),
-        });
+        const patches = macrosBuildPatches(macrosSavedPayload, payload);
+        try {
+            if (patches) {
+                await macrosSendPatches(patches);
+            } else {
+                const response = await fetch(API_MACROS, {
+                    method: 'POST',
+                    headers: { 'Content-Type': 'application/json' },
+                    body: JSON.stringify(payload),
+                });
 
-        const data = await response.json().catch(() => ({}));
-        if (!response.ok || data.success === false) {
-            throw new Error(data.message || `Save failed (${response.status})`);
+                const data = await response.json().catch(() => ({}));
+                if (!response.ok || data.success === false) {
+                    throw new Error(data.message || `Save failed (${response.status})`);
+                }
+            }
+        } catch (e) {
+            // Some PATCHes may have been applied: the next save must send everything.
+            macrosSavedPayload = null;
+            throw e;
         }
 
         macrosPayloadCache = payload;
+        macrosSavedPayload = macrosClonePayload(payload);
         macrosSetDirty(false);
         macrosRenderAll();
 
@@ -1610,9 +1806,8 @@ async function saveMacros(options = {}) {
         // No UI control is exposed; errors are intentionally non-fatal.
         if (onProgress) onProgress('Cleaning up unused icons...');
         try {
-            const gcRes = await fetch(API_ICONS_GC, { method: 'POST', cache: 'no-cache' });
-            const gcData = await gcRes.json().catch(() => ({}));
-            if (gcRes.ok && gcData && gcData.success !== false) {
+            const gcData = await runIconGc({ onProgress });
+            if (gcData && gcData.state === 'done') {
                 if (onProgress) {
                     const deleted = Number(gcData.deleted || 0);
                     const bytes = Number(gcData.bytes_freed || 0);
@@ -2211,6 +2406,10 @@ async function loadVersion() {
         const version = await response.json();
         deviceInfoCache = version;
 
+        // Switch health to pushed updates once we know the device offers them
+        // (polling stops at the first health event).
+        portalEventsStart();
+
         // Strategy B: Hide/disable MQTT settings if firmware was built without MQTT support
         const mqttSection = document.getElementById('mqtt-settings-section');
         if (mqttSection && version.has_mqtt === false) {
@@ -2220,6 +2419,33 @@ async function loadVersion() {
             });
         }
 
+        // Same for syslog streaming
+        const logStreamSection = document.getElementById('log-stream-section');
+        if (logStreamSection && version.has_log_stream === false) {
+            logStreamSection.style.display = 'none';
+            logStreamSection.querySelectorAll('input, select, textarea').forEach(el => {
+                el.disabled = true;
+            });
+        }
+
+        // And multicast image receive
+        const imageMcastSection = document.getElementById('image-mcast-section');
+        if (imageMcastSection && version.has_image_multicast !== true) {
+            imageMcastSection.style.display = 'none';
+            imageMcastSection.querySelectorAll('input, select, textarea').forEach(el => {
+                el.disabled = true;
+            });
+        }
+
+        // Same for the BLE keyboard settings
+        const bleSection = document.getElementById('ble-keyboard-section');
+        if (bleSection && version.has_ble_keyboard === false) {
+            bleSection.style.display = 'none';
+            bleSection.querySelectorAll('input, select, textarea').forEach(el => {
+                el.disabled = true;
+            });
+        }
+
         // Hide/disable display settings if firmware was built without backlight support
         const displaySection = document.getElementById('display-settings-section');
         if (displaySection) {
@@ -2410,8 +2636,11 @@ async function startGitHubFirmwareUpdate() {
         // Poll status until reboot.
         const poll = async () => {
             try {
-                const statusResp = await fetch(API_FIRMWARE_UPDATE_STATUS, { cache: 'no-cache' });
-                const status = await statusResp.json().catch(() => ({}));
+                // Progress pushed on /api/events saves a request per tick.
+                const pushed = portalEventsFresh('ota', 2000);
+                const status = (pushed && pushed.source === 'github')
+                    ? pushed
+                    : await fetch(API_FIRMWARE_UPDATE_STATUS, { cache: 'no-cache' }).then(r => r.json().catch(() => ({})));
 
                 if (status.state === 'error') {
                     throw new Error(status.error || 'Update failed');
@@ -2430,7 +2659,10 @@ async function startGitHubFirmwareUpdate() {
                 }
 
                 if (status.state === 'writing') {
-                    message.textContent = 'Installing firmware...';
+                    const rate = status.bytes_per_sec || 0;
+                    message.textContent = rate > 0
+                        ? `Installing firmware... (${Math.round(rate / 1024)} KB/s)`
+                        : 'Installing firmware...';
                 }
 
                 if (status.state === 'rebooting' || (total > 0 && progress >= total && progress > 0)) {
@@ -2542,6 +2774,12 @@ async function loadConfig() {
         setValueIfExists('mqtt_username', config.mqtt_username);
         setValueIfExists('mqtt_interval_seconds', config.mqtt_interval_seconds);
 
+        // Syslog streaming
+        setValueIfExists('log_stream_host', config.log_stream_host);
+        setValueIfExists('log_stream_port', config.log_stream_port);
+        setValueIfExists('image_mcast_group', config.image_mcast_group);
+        setValueIfExists('image_mcast_port', config.image_mcast_port);
+
         const mqttPwdField = document.getElementById('mqtt_password');
         if (mqttPwdField) {
             mqttPwdField.value = '';
@@ -2558,6 +2796,9 @@ async function loadConfig() {
             authPwdField.placeholder = saved ? '(saved - leave blank to keep)' : '';
         }
         
+        // BLE keyboard typing pace
+        setValueIfExists('ble_typing_interval_ms', config.ble_typing_interval_ms);
+
         // Display settings - backlight brightness
         const brightness = config.backlight_brightness !== undefined ? config.backlight_brightness : 100;
         setValueIfExists('backlight_brightness', brightness);
@@ -2609,7 +2850,10 @@ function extractFormFields(formData) {
     const fields = ['wifi_ssid', 'wifi_password', 'device_name', 'fixed_ip', 
                     'subnet_mask', 'gateway', 'dns1', 'dns2', 'dummy_setting',
                     'mqtt_host', 'mqtt_port', 'mqtt_username', 'mqtt_password', 'mqtt_interval_seconds',
+                    'log_stream_host', 'log_stream_port',
+                    'image_mcast_group', 'image_mcast_port',
                     'basic_auth_enabled', 'basic_auth_username', 'basic_auth_password',
+                    'ble_typing_interval_ms',
                     'backlight_brightness',
                     'screen_saver_enabled', 'screen_saver_timeout_seconds', 'screen_saver_fade_out_ms', 'screen_saver_fade_in_ms', 'screen_saver_wake_on_touch'];
     
@@ -2918,18 +3162,38 @@ function handleFileSelect(event) {
     selectedFile = event.target.files[0];
     const uploadBtn = document.getElementById('upload-btn');
     
-    if (selectedFile && selectedFile.name.endsWith('.bin')) {
+    if (selectedFile && (selectedFile.name.endsWith('.bin') || selectedFile.name.endsWith('.bin.gz'))) {
         uploadBtn.disabled = false;
         showMessage(`Selected: ${selectedFile.name} (${(selectedFile.size / 1024).toFixed(1)} KB)`, 'info');
     } else {
         uploadBtn.disabled = true;
         if (selectedFile) {
-            showMessage('Please select a .bin file', 'error');
+            showMessage('Please select a .bin or .bin.gz file', 'error');
             selectedFile = null;
         }
     }
 }
 
+/**
+ * Gzip a plain .bin in the browser when the device inflates OTA uploads
+ * (about half the bytes on the wire). Returns FormData.append() arguments.
+ * @param {File} file - Selected firmware file
+ */
+async function compressFirmwareForUpload(file) {
+    const canInflate = deviceInfoCache && deviceInfoCache.ota_gzip === true;
+    if (!canInflate || !file.name.endsWith('.bin') || typeof CompressionStream === 'undefined') {
+        return [file];
+    }
+    try {
+        const gz = await new Response(file.stream().pipeThrough(new CompressionStream('gzip'))).blob();
+        console.log(`[OTA] gzip ${file.size} -> ${gz.size} bytes`);
+        return [gz, file.name + '.gz'];
+    } catch (e) {
+        console.log('[OTA] gzip failed, sending raw image:', e);
+        return [file];
+    }
+}
+
 /**
  * Upload firmware file to device
  */
@@ -2961,7 +3225,7 @@ async function uploadFirmware() {
     const reconnectStatus = document.getElementById('reconnect-status');
     
     const formData = new FormData();
-    formData.append('firmware', selectedFile);
+    formData.append('firmware', ...(await compressFirmwareForUpload(selectedFile)));
     
     const xhr = new XMLHttpRequest();
     
@@ -3909,177 +4173,203 @@ async function updateHealth() {
         const response = await fetch(API_HEALTH);
         if (!response.ok) return;
         
-        const health = await response.json();
+        renderHealth(await response.json());
+    } catch (error) {
+        console.error('Failed to fetch health stats:', error);
+    }
+}
 
-        const sampleTs = Date.now();
+// Render one /api/health document (polled, or pushed on /api/events).
+function renderHealth(health) {
+    const sampleTs = Date.now();
 
-        const cpuUsage = (typeof health.cpu_usage === 'number' && isFinite(health.cpu_usage)) ? Math.floor(health.cpu_usage) : null;
+    const cpuUsage = (typeof health.cpu_usage === 'number' && isFinite(health.cpu_usage)) ? Math.floor(health.cpu_usage) : null;
 
-        const hasPsram = (
-            (deviceInfoCache && typeof deviceInfoCache.psram_size === 'number' && deviceInfoCache.psram_size > 0) ||
-            (typeof health.psram_free === 'number' && health.psram_free > 0)
-        );
+    const hasPsram = (
+        (deviceInfoCache && typeof deviceInfoCache.psram_size === 'number' && deviceInfoCache.psram_size > 0) ||
+        (typeof health.psram_free === 'number' && health.psram_free > 0)
+    );
 
-        // Feed client-side history buffers (no device-side time series).
-        if (cpuUsage !== null) {
-            healthPushSampleWithTs(healthHistory.cpu, healthHistory.cpuTs, cpuUsage, sampleTs);
-        }
-        healthPushSampleWithTs(healthHistory.heapInternalFree, healthHistory.heapInternalFreeTs, health.heap_internal_free, sampleTs);
+    // Feed client-side history buffers (no device-side time series).
+    if (cpuUsage !== null) {
+        healthPushSampleWithTs(healthHistory.cpu, healthHistory.cpuTs, cpuUsage, sampleTs);
+    }
+    healthPushSampleWithTs(healthHistory.heapInternalFree, healthHistory.heapInternalFreeTs, health.heap_internal_free, sampleTs);
+    {
+        const cur = health.heap_internal_free;
+        const wmin = (typeof health.heap_internal_free_min_window === 'number') ? Math.min(health.heap_internal_free_min_window, cur) : cur;
+        const wmax = (typeof health.heap_internal_free_max_window === 'number') ? Math.max(health.heap_internal_free_max_window, cur) : cur;
+        healthPushSample(healthHistory.heapInternalFreeMin, wmin);
+        healthPushSample(healthHistory.heapInternalFreeMax, wmax);
+    }
+    if (hasPsram) {
+        healthPushSampleWithTs(healthHistory.psramFree, healthHistory.psramFreeTs, health.psram_free, sampleTs);
         {
-            const cur = health.heap_internal_free;
-            const wmin = (typeof health.heap_internal_free_min_window === 'number') ? Math.min(health.heap_internal_free_min_window, cur) : cur;
-            const wmax = (typeof health.heap_internal_free_max_window === 'number') ? Math.max(health.heap_internal_free_max_window, cur) : cur;
-            healthPushSample(healthHistory.heapInternalFreeMin, wmin);
-            healthPushSample(healthHistory.heapInternalFreeMax, wmax);
-        }
-        if (hasPsram) {
-            healthPushSampleWithTs(healthHistory.psramFree, healthHistory.psramFreeTs, health.psram_free, sampleTs);
-            {
-                const cur = health.psram_free;
-                const wmin = (typeof health.psram_free_min_window === 'number') ? Math.min(health.psram_free_min_window, cur) : cur;
-                const wmax = (typeof health.psram_free_max_window === 'number') ? Math.max(health.psram_free_max_window, cur) : cur;
-                healthPushSample(healthHistory.psramFreeMin, wmin);
-                healthPushSample(healthHistory.psramFreeMax, wmax);
-            }
-        }
-        if (health.wifi_rssi !== null && health.wifi_rssi !== undefined) {
-            healthPushSampleWithTs(healthHistory.wifiRssi, healthHistory.wifiRssiTs, health.wifi_rssi, sampleTs);
+            const cur = health.psram_free;
+            const wmin = (typeof health.psram_free_min_window === 'number') ? Math.min(health.psram_free_min_window, cur) : cur;
+            const wmax = (typeof health.psram_free_max_window === 'number') ? Math.max(health.psram_free_max_window, cur) : cur;
+            healthPushSample(healthHistory.psramFreeMin, wmin);
+            healthPushSample(healthHistory.psramFreeMax, wmax);
         }
+    }
+    if (health.wifi_rssi !== null && health.wifi_rssi !== undefined) {
+        healthPushSampleWithTs(healthHistory.wifiRssi, healthHistory.wifiRssiTs, health.wifi_rssi, sampleTs);
+    }
 
-        // Derived stats used by the sparklines tooltips.
-        healthUpdateSeriesStats({ hasPsram });
-        
-        // Update compact view
-        document.getElementById('health-cpu').textContent = (cpuUsage !== null) ? `CPU ${cpuUsage}%` : 'CPU —';
-        
-        // Trigger breathing animation on status dots
-        const dot = document.getElementById('health-status-dot');
-        dot.classList.remove('breathing');
-        void dot.offsetWidth; // Force reflow
-        dot.classList.add('breathing');
-        
-        const dotExpanded = document.getElementById('health-status-dot-expanded');
-        if (dotExpanded) {
-            dotExpanded.classList.remove('breathing');
-            void dotExpanded.offsetWidth; // Force reflow
-            dotExpanded.classList.add('breathing');
-        }
-        
-        // Update expanded view - System
-        document.getElementById('health-uptime').textContent = formatUptime(health.uptime_seconds);
-        document.getElementById('health-reset').textContent = health.reset_reason || 'Unknown';
-        
-        // CPU
-        document.getElementById('health-cpu-full').textContent = (cpuUsage !== null) ? `${cpuUsage}%` : '—';
-        document.getElementById('health-temp').textContent = health.cpu_temperature !== null ? 
-            `${health.cpu_temperature}°C` : 'N/A';
-
-        // Sparklines
-        const cpuSparkValue = document.getElementById('health-sparkline-cpu-value');
-        if (cpuSparkValue) cpuSparkValue.textContent = (cpuUsage !== null) ? `${cpuUsage}%` : '—';
-
-        const heapSparkValue = document.getElementById('health-sparkline-heap-value');
-        if (heapSparkValue) heapSparkValue.textContent = healthFormatBytes(health.heap_internal_free);
-
-        const psramWrap = document.getElementById('health-sparkline-psram-wrap');
-        if (psramWrap) psramWrap.style.display = hasPsram ? '' : 'none';
-        const psramSparkValue = document.getElementById('health-sparkline-psram-value');
-        if (psramSparkValue) psramSparkValue.textContent = hasPsram ? healthFormatBytes(health.psram_free) : '—';
-
-        const rssiSparkValue = document.getElementById('health-sparkline-rssi-value');
-        if (rssiSparkValue) {
-            rssiSparkValue.textContent = (health.wifi_rssi !== null && health.wifi_rssi !== undefined) ? `${health.wifi_rssi} dBm` : 'N/A';
-        }
-        healthDrawSparklinesOnly({ hasPsram });
-        
-        // Memory
-        document.getElementById('health-heap').textContent = formatHeap(health.heap_free);
-        document.getElementById('health-heap-min').textContent = formatHeap(health.heap_min);
-        if (typeof health.heap_fragmentation_max_window === 'number') {
-            document.getElementById('health-heap-frag').textContent = `${health.heap_fragmentation}% (max ${health.heap_fragmentation_max_window}%)`;
+    // Derived stats used by the sparklines tooltips.
+    healthUpdateSeriesStats({ hasPsram });
+    
+    // Update compact view
+    document.getElementById('health-cpu').textContent = (cpuUsage !== null) ? `CPU ${cpuUsage}%` : 'CPU —';
+    
+    // Trigger breathing animation on status dots
+    const dot = document.getElementById('health-status-dot');
+    dot.classList.remove('breathing');
+    void dot.offsetWidth; // Force reflow
+    dot.classList.add('breathing');
+    
+    const dotExpanded = document.getElementById('health-status-dot-expanded');
+    if (dotExpanded) {
+        dotExpanded.classList.remove('breathing');
+        void dotExpanded.offsetWidth; // Force reflow
+        dotExpanded.classList.add('breathing');
+    }
+    
+    // Update expanded view - System
+    document.getElementById('health-uptime').textContent = formatUptime(health.uptime_seconds);
+    document.getElementById('health-reset').textContent = health.reset_reason || 'Unknown';
+    
+    // CPU
+    document.getElementById('health-cpu-full').textContent = (cpuUsage !== null) ? `${cpuUsage}%` : '—';
+    document.getElementById('health-temp').textContent = health.cpu_temperature !== null ? 
+        `${health.cpu_temperature}°C` : 'N/A';
+
+    // Sparklines
+    const cpuSparkValue = document.getElementById('health-sparkline-cpu-value');
+    if (cpuSparkValue) cpuSparkValue.textContent = (cpuUsage !== null) ? `${cpuUsage}%` : '—';
+
+    const heapSparkValue = document.getElementById('health-sparkline-heap-value');
+    if (heapSparkValue) heapSparkValue.textContent = healthFormatBytes(health.heap_internal_free);
+
+    const psramWrap = document.getElementById('health-sparkline-psram-wrap');
+    if (psramWrap) psramWrap.style.display = hasPsram ? '' : 'none';
+    const psramSparkValue = document.getElementById('health-sparkline-psram-value');
+    if (psramSparkValue) psramSparkValue.textContent = hasPsram ? healthFormatBytes(health.psram_free) : '—';
+
+    const rssiSparkValue = document.getElementById('health-sparkline-rssi-value');
+    if (rssiSparkValue) {
+        rssiSparkValue.textContent = (health.wifi_rssi !== null && health.wifi_rssi !== undefined) ? `${health.wifi_rssi} dBm` : 'N/A';
+    }
+    healthDrawSparklinesOnly({ hasPsram });
+    
+    // Memory
+    document.getElementById('health-heap').textContent = formatHeap(health.heap_free);
+    document.getElementById('health-heap-min').textContent = formatHeap(health.heap_min);
+    if (typeof health.heap_fragmentation_max_window === 'number') {
+        document.getElementById('health-heap-frag').textContent = `${health.heap_fragmentation}% (max ${health.heap_fragmentation_max_window}%)`;
+    } else {
+        document.getElementById('health-heap-frag').textContent = `${health.heap_fragmentation}%`;
+    }
+    const internalMin = document.getElementById('health-internal-min');
+    if (internalMin) internalMin.textContent = healthFormatBytes(health.heap_internal_min);
+
+    const internalLargest = document.getElementById('health-internal-largest');
+    if (internalLargest) {
+        if (typeof health.heap_internal_largest_min_window === 'number') {
+            internalLargest.textContent = `${healthFormatBytes(health.heap_internal_largest)} (min ${healthFormatBytes(health.heap_internal_largest_min_window)})`;
         } else {
-            document.getElementById('health-heap-frag').textContent = `${health.heap_fragmentation}%`;
+            internalLargest.textContent = healthFormatBytes(health.heap_internal_largest);
         }
-        const internalMin = document.getElementById('health-internal-min');
-        if (internalMin) internalMin.textContent = healthFormatBytes(health.heap_internal_min);
+    }
 
-        const internalLargest = document.getElementById('health-internal-largest');
-        if (internalLargest) {
-            if (typeof health.heap_internal_largest_min_window === 'number') {
-                internalLargest.textContent = `${healthFormatBytes(health.heap_internal_largest)} (min ${healthFormatBytes(health.heap_internal_largest_min_window)})`;
-            } else {
-                internalLargest.textContent = healthFormatBytes(health.heap_internal_largest);
-            }
-        }
+    const psramMinWrap = document.getElementById('health-psram-min-wrap');
+    if (psramMinWrap) psramMinWrap.style.display = hasPsram ? '' : 'none';
+    const psramMin = document.getElementById('health-psram-min');
+    if (psramMin) psramMin.textContent = hasPsram ? healthFormatBytes(health.psram_min) : '—';
 
-        const psramMinWrap = document.getElementById('health-psram-min-wrap');
-        if (psramMinWrap) psramMinWrap.style.display = hasPsram ? '' : 'none';
-        const psramMin = document.getElementById('health-psram-min');
-        if (psramMin) psramMin.textContent = hasPsram ? healthFormatBytes(health.psram_min) : '—';
-
-        const psramFragWrap = document.getElementById('health-psram-frag-wrap');
-        if (psramFragWrap) psramFragWrap.style.display = hasPsram ? '' : 'none';
-        const psramFrag = document.getElementById('health-psram-frag');
-        if (psramFrag) {
-            if (hasPsram && typeof health.psram_fragmentation_max_window === 'number') {
-                psramFrag.textContent = `${health.psram_fragmentation}% (max ${health.psram_fragmentation_max_window}%)`;
-            } else {
-                psramFrag.textContent = hasPsram ? `${health.psram_fragmentation}%` : '—';
-            }
+    const psramFragWrap = document.getElementById('health-psram-frag-wrap');
+    if (psramFragWrap) psramFragWrap.style.display = hasPsram ? '' : 'none';
+    const psramFrag = document.getElementById('health-psram-frag');
+    if (psramFrag) {
+        if (hasPsram && typeof health.psram_fragmentation_max_window === 'number') {
+            psramFrag.textContent = `${health.psram_fragmentation}% (max ${health.psram_fragmentation_max_window}%)`;
+        } else {
+            psramFrag.textContent = hasPsram ? `${health.psram_fragmentation}%` : '—';
         }
-        
-        // Flash
-        const flashUsed = (health.flash_used / 1024).toFixed(0);
-        const flashTotal = (health.flash_total / 1024).toFixed(0);
-        document.getElementById('health-flash').textContent = 
-            `${flashUsed} / ${flashTotal} KB`;
-        
-        // Network
-        if (health.wifi_rssi !== null) {
-            const rssi = health.wifi_rssi;
-            const strength = getSignalStrength(rssi);
-            document.getElementById('health-rssi').textContent = `${rssi} dBm (${strength})`;
-            document.getElementById('health-ip').textContent = health.ip_address || 'N/A';
+    }
+    
+    // Flash
+    const flashUsed = (health.flash_used / 1024).toFixed(0);
+    const flashTotal = (health.flash_total / 1024).toFixed(0);
+    document.getElementById('health-flash').textContent = 
+        `${flashUsed} / ${flashTotal} KB`;
+    
+    // Network
+    if (health.wifi_rssi !== null) {
+        const rssi = health.wifi_rssi;
+        const strength = getSignalStrength(rssi);
+        document.getElementById('health-rssi').textContent = `${rssi} dBm (${strength})`;
+        document.getElementById('health-ip').textContent = health.ip_address || 'N/A';
+    } else {
+        document.getElementById('health-rssi').textContent = 'Not connected';
+        document.getElementById('health-ip').textContent = 'N/A';
+    }
+
+    // FS
+    const fsEl = document.getElementById('health-fs');
+    if (fsEl) {
+        const t = health.fs_type;
+        if (!t) {
+            fsEl.textContent = 'N/A';
+        } else if (health.fs_mounted === true && typeof health.fs_used_bytes === 'number' && typeof health.fs_total_bytes === 'number') {
+            fsEl.textContent = `${t}: ${(health.fs_used_bytes / 1024).toFixed(0)} / ${(health.fs_total_bytes / 1024).toFixed(0)} KB`;
         } else {
-            document.getElementById('health-rssi').textContent = 'Not connected';
-            document.getElementById('health-ip').textContent = 'N/A';
+            fsEl.textContent = `${t}: not mounted`;
         }
+    }
 
-        // FS
-        const fsEl = document.getElementById('health-fs');
-        if (fsEl) {
-            const t = health.fs_type;
-            if (!t) {
-                fsEl.textContent = 'N/A';
-            } else if (health.fs_mounted === true && typeof health.fs_used_bytes === 'number' && typeof health.fs_total_bytes === 'number') {
-                fsEl.textContent = `${t}: ${(health.fs_used_bytes / 1024).toFixed(0)} / ${(health.fs_total_bytes / 1024).toFixed(0)} KB`;
-            } else {
-                fsEl.textContent = `${t}: not mounted`;
-            }
+    // Display
+    const fpsEl = document.getElementById('health-display-fps');
+    if (fpsEl) fpsEl.textContent = (health.display_fps !== null && health.display_fps !== undefined) ? `${health.display_fps} fps` : 'N/A';
+    const timesEl = document.getElementById('health-display-times');
+    if (timesEl) {
+        if (typeof health.display_lv_timer_us === 'number' && typeof health.display_present_us === 'number') {
+            timesEl.textContent = `${(health.display_lv_timer_us / 1000).toFixed(1)}ms / ${(health.display_present_us / 1000).toFixed(1)}ms`;
+        } else {
+            timesEl.textContent = 'N/A';
         }
-
-        // Display
-        const fpsEl = document.getElementById('health-display-fps');
-        if (fpsEl) fpsEl.textContent = (health.display_fps !== null && health.display_fps !== undefined) ? `${health.display_fps} fps` : 'N/A';
-        const timesEl = document.getElementById('health-display-times');
-        if (timesEl) {
-            if (typeof health.display_lv_timer_us === 'number' && typeof health.display_present_us === 'number') {
-                timesEl.textContent = `${(health.display_lv_timer_us / 1000).toFixed(1)}ms / ${(health.display_present_us / 1000).toFixed(1)}ms`;
-            } else {
-                timesEl.textContent = 'N/A';
-            }
+    }
+    const flushEl = document.getElementById('health-display-flush');
+    if (flushEl) flushEl.textContent = (typeof health.display_flush_us === 'number') ? `${(health.display_flush_us / 1000).toFixed(1)}ms` : 'N/A';
+    const p95El = document.getElementById('health-display-p95');
+    if (p95El) {
+        const frame = health.display_frame_us;
+        if (frame && Array.isArray(frame.render) && Array.isArray(frame.flush) && Array.isArray(frame.present)) {
+            // [p50, p95, p99, max] per phase; show render + flush + present combined.
+            const p95 = frame.render[1] + frame.flush[1] + frame.present[1];
+            const max = frame.render[3] + frame.flush[3] + frame.present[3];
+            p95El.textContent = `${(p95 / 1000).toFixed(1)}ms / ${(max / 1000).toFixed(1)}ms`;
+            p95El.title = `render p99 ${(frame.render[2] / 1000).toFixed(1)}ms, flush p99 ${(frame.flush[2] / 1000).toFixed(1)}ms, present p99 ${(frame.present[2] / 1000).toFixed(1)}ms`;
+        } else {
+            p95El.textContent = 'N/A';
         }
-
-        // MQTT
-        const mqttEl = document.getElementById('health-mqtt');
-        if (mqttEl) {
-            if (health.mqtt_enabled === false) mqttEl.textContent = 'Disabled';
-            else if (health.mqtt_connected === true) mqttEl.textContent = 'Connected';
-            else if (health.mqtt_connected === false) mqttEl.textContent = 'Disconnected';
-            else mqttEl.textContent = 'N/A';
+    }
+    const busEl = document.getElementById('health-display-bus');
+    if (busEl) {
+        if (typeof health.display_bus_mbps === 'number' && typeof health.display_px_per_s === 'number') {
+            busEl.textContent = `${health.display_bus_mbps.toFixed(1)} MB/s (${(health.display_px_per_s / 1000).toFixed(0)} kpx/s)`;
+        } else {
+            busEl.textContent = 'N/A';
         }
-    } catch (error) {
-        console.error('Failed to fetch health stats:', error);
+    }
+
+    // MQTT
+    const mqttEl = document.getElementById('health-mqtt');
+    if (mqttEl) {
+        if (health.mqtt_enabled === false) mqttEl.textContent = 'Disabled';
+        else if (health.mqtt_connected === true) mqttEl.textContent = 'Connected';
+        else if (health.mqtt_connected === false) mqttEl.textContent = 'Disconnected';
+        else mqttEl.textContent = 'N/A';
     }
 }
 
@@ -4112,10 +4402,97 @@ function initHealthWidget() {
     // Click close button to collapse
     document.getElementById('health-close').addEventListener('click', toggleHealthWidget);
     
-    // Initial health fetch
-    updateHealth();
+    // Pushed updates when the device offers them (the first health event
+    // arrives on connect). Otherwise poll at the configured interval so
+    // history is continuous.
+    if (!portalEventsStart()) {
+        updateHealth();
+        healthStartPolling();
+    }
+}
 
-    // Always poll at the configured interval so history is continuous.
-    if (healthUpdateInterval) clearInterval(healthUpdateInterval);
+function healthStartPolling() {
+    if (healthUpdateInterval) return;
     healthUpdateInterval = setInterval(updateHealth, healthPollIntervalMs);
 }
+
+function healthStopPolling() {
+    if (!healthUpdateInterval) return;
+    clearInterval(healthUpdateInterval);
+    healthUpdateInterval = null;
+}
+
+// ===== PORTAL EVENTS (/api/events) =====
+
+const API_EVENTS = '/api/events';
+let portalEventSource = null;
+// Last payload per event type: { data, at }.
+const portalEventsLatest = {};
+
+/**
+ * Latest pushed payload of one event type, if received within maxAgeMs.
+ * @param {string} type - health, screen, image or ota
+ * @param {number} maxAgeMs
+ * @returns {object|null}
+ */
+function portalEventsFresh(type, maxAgeMs) {
+    const e = portalEventsLatest[type];
+    return (e && Date.now() - e.at <= maxAgeMs) ? e.data : null;
+}
+
+/**
+ * Subscribe to /api/events. Health pushes replace polling; whenever the
+ * stream is down (refused, device busy or rebooting) polling takes over until
+ * the next pushed health event.
+ * @returns {boolean} false when the device or browser has no event stream
+ */
+function portalEventsStart() {
+    if (portalEventSource) return true;
+    if (typeof EventSource === 'undefined') return false;
+    if (!deviceInfoCache || deviceInfoCache.events !== true) return false;
+
+    const es = new EventSource(API_EVENTS);
+    portalEventSource = es;
+
+    const handlers = {
+        health: (data) => {
+            healthStopPolling();
+            renderHealth(data);
+        },
+        screen: (data) => {
+            const screenSelect = document.getElementById('screen_selection');
+            if (screenSelect && data.screen && screenSelect.querySelector(`option[value="${CSS.escape(data.screen)}"]`)) {
+                screenSelect.value = data.screen;
+            }
+            if (deviceInfoCache) deviceInfoCache.current_screen = data.screen;
+        },
+        image: () => {},
+        ota: () => {},
+    };
+
+    Object.keys(handlers).forEach(type => {
+        es.addEventListener(type, (e) => {
+            let data;
+            try {
+                data = JSON.parse(e.data);
+            } catch (err) {
+                return;
+            }
+            portalEventsLatest[type] = { data, at: Date.now() };
+            try {
+                handlers[type](data);
+            } catch (err) {
+                console.error(`Failed to handle ${type} event:`, err);
+            }
+        });
+    });
+
+    es.onerror = () => {
+        healthStartPolling();
+        if (es.readyState === EventSource.CLOSED) {
+            // Refused (client limit, auth): the browser will not retry.
+            portalEventSource = null;
+        }
+    };
+    return true;
+}
@@ -16,13 +16,18 @@
 #include "web_portal.h"
 
 #include "board_config.h"
+#include "boot_profile.h"
 #include "device_telemetry.h"
 #include "log_manager.h"
 #include "project_branding.h"
 
 #include "web_portal_auth.h"
+#include "web_portal_events.h"
+#include "web_portal_profile.h"
 #include "web_portal_routes.h"
 #include "web_portal_state.h"
+#include "web_portal_workers.h"
+#include "loop_scheduler.h"
 
 #if HAS_DISPLAY
 #include "display_manager.h"
@@ -71,9 +76,6 @@ void web_portal_init(DeviceConfig* config) {
 
     web_portal_state().config = config;
 
-    // Load macros config once at portal init so GET /api/macros is cheap.
-    web_portal_macros_preload();
-
     // Create web server instance (avoid global constructor issues)
     if (server == nullptr) {
         yield();
@@ -83,6 +85,9 @@ void web_portal_init(DeviceConfig* config) {
         delay(100);
     }
 
+    // Before the routes: handlers dispatch to the workers.
+    portal_workers_init();
+
     // Routes
     web_portal_register_page_routes(*server);
     web_portal_register_asset_routes(*server);
@@ -94,6 +99,12 @@ void web_portal_init(DeviceConfig* config) {
     web_portal_register_api_firmware_routes(*server);
     web_portal_register_api_display_routes(*server);
     web_portal_register_api_ota_routes(*server);
+    web_portal_register_api_ble_routes(*server);
+    web_portal_register_api_batch_routes(*server);
+    web_portal_register_events_routes(*server);
+    web_portal_register_profile_routes(*server);
+    web_portal_register_trace_routes(*server);
+    web_portal_register_metrics_routes(*server);
 
 #if HAS_IMAGE_API && HAS_DISPLAY
     Logger.logMessage("Portal", "Initializing image API");
@@ -101,11 +112,16 @@ void web_portal_init(DeviceConfig* config) {
     // Setup backend adapter
     ImageApiBackend backend;
     backend.hide_current_image = []() {
-        // Called from AsyncTCP task and sometimes from the main loop.
+        // Called from the AsyncTCP task and from image jobs.
         // Always defer actual display/LVGL operations to the main loop.
         pending_image_hide_request = true;
+        loop_scheduler_notify();
     };
 
+    // The session, decode and push callbacks below run where image jobs run:
+    // the image worker task (IMAGE_API_WORKER_ENABLED) or else the main loop,
+    // with the display lock held. A stream read may wait on the network; the
+    // lock is dropped meanwhile (image_stream_wait_hook).
     backend.start_strip_session = [](int width, int height, unsigned long timeout_ms, unsigned long start_time) -> bool {
         (void)start_time;
         DirectImageScreen* screen = display_manager_get_direct_image_screen();
@@ -114,7 +130,6 @@ void web_portal_init(DeviceConfig* config) {
             return false;
         }
 
-        // Now called from main loop with proper task context
         // Show the DirectImageScreen first
         display_manager_show_direct_image();
 
@@ -134,10 +149,78 @@ void web_portal_init(DeviceConfig* config) {
             return false;
         }
 
-        // Now called from main loop - safe to decode
         return screen->decode_strip(jpeg_data, jpeg_size, strip_index, output_bgr565);
     };
 
+    backend.decode_stream = [](ImageStreamReadFn read, void* read_ctx, bool output_bgr565) -> bool {
+        DirectImageScreen* screen = display_manager_get_direct_image_screen();
+        if (!screen) {
+            Logger.logMessage("ImageAPI", "ERROR: No direct image screen");
+            return false;
+        }
+
+        return screen->decode_stream(read, read_ctx, output_bgr565);
+    };
+
+    backend.decode_fit = [](const uint8_t* jpeg_data, size_t jpeg_size, ImageStreamReadFn read, void* read_ctx, bool output_bgr565, bool center) -> bool {
+        DirectImageScreen* screen = display_manager_get_direct_image_screen();
+        if (!screen) {
+            Logger.logMessage("ImageAPI", "ERROR: No direct image screen");
+            return false;
+        }
+
+        return screen->decode_fit(jpeg_data, jpeg_size, read, read_ctx, output_bgr565, center);
+    };
+
+    backend.decode_frame = [](ImageStreamReadFn read, void* read_ctx, bool output_bgr565) -> bool {
+        DirectImageScreen* screen = display_manager_get_direct_image_screen();
+        if (!screen) {
+            Logger.logMessage("ImageAPI", "ERROR: No direct image screen");
+            return false;
+        }
+
+        return screen->decode_frame(read, read_ctx, output_bgr565);
+    };
+
+    backend.push_rect = [](int x, int y, int w, int h, uint16_t* pixels, bool big_endian) -> bool {
+        DirectImageScreen* screen = display_manager_get_direct_image_screen();
+        if (!screen) {
+            Logger.logMessage("ImageAPI", "ERROR: No direct image screen");
+            return false;
+        }
+
+        return screen->push_rect(x, y, w, h, pixels, big_endian);
+    };
+
+    backend.decode_tile = [](const uint8_t* jpeg_data, size_t jpeg_size, int x, int y, bool output_bgr565) -> bool {
+        DirectImageScreen* screen = display_manager_get_direct_image_screen();
+        if (!screen) {
+            Logger.logMessage("ImageAPI", "ERROR: No direct image screen");
+            return false;
+        }
+
+        return screen->decode_tile(jpeg_data, jpeg_size, x, y, output_bgr565);
+    };
+
+    backend.refresh_current_image = [](unsigned long timeout_ms, unsigned long start_time) -> bool {
+        DirectImageScreen* screen = display_manager_get_direct_image_screen();
+        if (!screen || pending_image_hide_request) return false;
+
+        // Hold the display lock so the LVGL task's timeout check can't race the re-arm.
+        display_manager_lock();
+        const bool showing = screen->is_visible() && !screen->is_timeout_expired();
+        if (showing) {
+            screen->set_timeout(timeout_ms);
+            screen->set_start_time(start_time);
+        }
+        display_manager_unlock();
+
+        if (showing) {
+            screen_saver_manager_notify_activity(true);
+        }
+        return showing;
+    };
+
     // Setup configuration
     ImageApiConfig image_cfg;
 
@@ -176,6 +259,7 @@ void web_portal_init(DeviceConfig* config) {
     yield();
     delay(100);
     server->begin();
+    boot_profile_mark(BootMilestone::PortalReady);
     Logger.logEnd();
 }
 
@@ -0,0 +1,269 @@
+#include "web_portal_admission.h"
+
+#include <ESPAsyncWebServer.h>
+
+#include "device_telemetry.h"
+#include "log_manager.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+
+namespace {
+
+// The library keeps one onDisconnect callback per request, so every end hook
+// goes through this table and hooks for the same request are chained. Only
+// touched on the AsyncTCP task.
+struct EndHook {
+    AsyncWebServerRequest* request;
+    std::function<void()> fn;
+};
+
+constexpr size_t kEndHooks = 24;
+
+EndHook g_end_hooks[kEndHooks] = {};
+
+void run_end_hooks(AsyncWebServerRequest* request) {
+    for (EndHook& hook : g_end_hooks) {
+        if (hook.request != request) continue;
+        std::function<void()> fn = std::move(hook.fn);
+        hook.request = nullptr;
+        hook.fn = nullptr;
+        if (fn) fn();
+        return;
+    }
+}
+
+} // namespace
+
+bool portal_on_request_end(AsyncWebServerRequest* request, std::function<void()> fn) {
+    EndHook* free_hook = nullptr;
+    for (EndHook& hook : g_end_hooks) {
+        if (hook.request == request) {
+            // Registration order is run order.
+            std::function<void()> prev = std::move(hook.fn);
+            hook.fn = [prev, fn]() {
+                prev();
+                fn();
+            };
+            return true;
+        }
+        if (!hook.request && !free_hook) free_hook = &hook;
+    }
+    if (!free_hook) {
+        Logger.logMessagef("Portal", "No end hook slot for %s", request->url().c_str());
+        return false;
+    }
+    free_hook->request = request;
+    free_hook->fn = std::move(fn);
+    request->onDisconnect([request]() { run_end_hooks(request); });
+    return true;
+}
+
+#if PORTAL_ADMISSION_ENABLED
+
+namespace {
+
+enum class CostClass : uint8_t {
+    Light = 0,   // pages, assets, small commands: never shed
+    Json,        // GET /api/...: builds a JsonDocument
+    Upload,      // request bodies buffered or parsed on the heap
+};
+
+enum class SlotState : uint8_t {
+    Free = 0,
+    Admitted,
+    Rejected,    // 503 already sent; later body chunks are dropped quietly
+};
+
+struct Slot {
+    AsyncWebServerRequest* request;
+    SlotState state;
+    CostClass cls;
+};
+
+// Admitted requests are bounded by the caps; the rest absorbs rejected uploads
+// that are still streaming their bodies.
+constexpr size_t kSlots = PORTAL_ADMISSION_JSON_MAX + PORTAL_ADMISSION_UPLOAD_MAX + 12;
+
+Slot g_slots[kSlots] = {};
+uint8_t g_in_flight[3] = {};
+PortalAdmissionStats g_stats = {};
+portMUX_TYPE g_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Set by memory pressure shedding: every capped request is turned away.
+volatile bool g_shed = false;
+
+// Routes whose request body is buffered or parsed as it arrives.
+const char* const kUploadPrefixes[] = {
+    "/api/macros",
+    "/api/icons",
+    "/api/display/image",
+    "/api/display/playlist",
+    "/api/display/stream",
+    "/api/config",
+    "/api/update",
+    "/api/batch",
+};
+
+bool starts_with(const String& s, const char* prefix) {
+    return strncmp(s.c_str(), prefix, strlen(prefix)) == 0;
+}
+
+CostClass classify(AsyncWebServerRequest* request) {
+    const String& url = request->url();
+    if (!starts_with(url, "/api/")) return CostClass::Light;
+    // Long-lived WebSocket / event stream: each has its own client limit.
+    if (url == "/api/display/ws" || url == "/api/display/mirror" || url == "/api/events") return CostClass::Light;
+    // Keep monitoring working when the heap is tight (that is when it matters).
+    // Both are streamed into preallocated buffers (web_portal_json_stream).
+    if (url == "/api/health" || url == "/api/info") return CostClass::Light;
+
+    const auto method = request->method();
+    if (method == HTTP_GET) return CostClass::Json;
+    if (method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH) {
+        for (const char* prefix : kUploadPrefixes) {
+            if (starts_with(url, prefix)) return CostClass::Upload;
+        }
+    }
+    return CostClass::Light;
+}
+
+Slot* find_slot(AsyncWebServerRequest* request) {
+    for (Slot& slot : g_slots) {
+        if (slot.state != SlotState::Free && slot.request == request) return &slot;
+    }
+    return nullptr;
+}
+
+Slot* alloc_slot(AsyncWebServerRequest* request) {
+    for (Slot& slot : g_slots) {
+        if (slot.state == SlotState::Free) {
+            slot.request = request;
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void release(AsyncWebServerRequest* request) {
+    Slot* slot = find_slot(request);
+    if (!slot) return;
+
+    if (slot->state == SlotState::Admitted) {
+        portENTER_CRITICAL(&g_stats_mux);
+        g_in_flight[(uint8_t)slot->cls]--;
+        portEXIT_CRITICAL(&g_stats_mux);
+    }
+    slot->state = SlotState::Free;
+    slot->request = nullptr;
+}
+
+const char* check_limits(CostClass cls, bool* memory) {
+    *memory = false;
+    const uint8_t cap = (cls == CostClass::Upload) ? PORTAL_ADMISSION_UPLOAD_MAX : PORTAL_ADMISSION_JSON_MAX;
+    if (g_in_flight[(uint8_t)cls] >= cap) return "busy";
+    if (g_shed) {
+        *memory = true;
+        return "memory pressure";
+    }
+
+    const uint32_t scale = (cls == CostClass::Upload) ? 2 : 1;
+    // Shared snapshot (at most 200 ms old): no heap walk per request.
+    DeviceTelemetrySnapshot snap;
+    device_telemetry_get_snapshot(&snap);
+    if (snap.mem.heap_internal_free_bytes < (size_t)PORTAL_ADMISSION_MIN_FREE_BYTES * scale ||
+        snap.mem.heap_largest_free_block_bytes < (size_t)PORTAL_ADMISSION_MIN_BLOCK_BYTES * scale) {
+        *memory = true;
+        return "low memory";
+    }
+    return nullptr;
+}
+
+void send_503(AsyncWebServerRequest* request) {
+    AsyncWebServerResponse* response = request->beginResponse(
+        503,
+        "application/json",
+        "{\"success\":false,\"message\":\"Device busy, retry later\"}"
+    );
+    response->addHeader("Retry-After", String((unsigned)PORTAL_ADMISSION_RETRY_AFTER_S));
+    request->send(response);
+}
+
+} // namespace
+
+bool portal_admission_gate(AsyncWebServerRequest* request) {
+    // Later body chunks (and the final handler) of a request already decided.
+    if (Slot* slot = find_slot(request)) {
+        return slot->state == SlotState::Admitted;
+    }
+
+    const CostClass cls = classify(request);
+    if (cls == CostClass::Light) return true;
+
+    bool memory = false;
+    const char* reason = check_limits(cls, &memory);
+
+    Slot* slot = alloc_slot(request);
+    if (!slot) {
+        // More open requests than slots (only with many rejected uploads still
+        // streaming): shed this one too.
+        reason = "busy";
+        memory = false;
+    } else {
+        slot->cls = cls;
+        slot->state = reason ? SlotState::Rejected : SlotState::Admitted;
+        if (!portal_on_request_end(request, [request]() { release(request); })) {
+            // Could never be released: do not hold it.
+            slot->state = SlotState::Free;
+            slot->request = nullptr;
+            reason = "busy";
+            memory = false;
+        }
+    }
+
+    portENTER_CRITICAL(&g_stats_mux);
+    if (!reason) {
+        g_stats.admitted++;
+        g_in_flight[(uint8_t)cls]++;
+        const uint8_t total = g_in_flight[(uint8_t)CostClass::Json] + g_in_flight[(uint8_t)CostClass::Upload];
+        if (total > g_stats.in_flight_peak) g_stats.in_flight_peak = total;
+    } else if (memory) {
+        g_stats.rejected_memory++;
+    } else {
+        g_stats.rejected_busy++;
+    }
+    portEXIT_CRITICAL(&g_stats_mux);
+
+    if (!reason) return true;
+
+    Logger.logMessagef("Portal", "503 %s (%s)", request->url().c_str(), reason);
+    send_503(request);
+    return false;
+}
+
+void portal_admission_get_stats(PortalAdmissionStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_stats_mux);
+    *out = g_stats;
+    out->in_flight_json = g_in_flight[(uint8_t)CostClass::Json];
+    out->in_flight_upload = g_in_flight[(uint8_t)CostClass::Upload];
+    portEXIT_CRITICAL(&g_stats_mux);
+}
+
+void portal_admission_set_shed(bool shed) {
+    g_shed = shed;
+}
+
+#else
+
+bool portal_admission_gate(AsyncWebServerRequest*) {
+    return true;
+}
+
+void portal_admission_get_stats(PortalAdmissionStats* out) {
+    if (out) *out = {};
+}
+
+void portal_admission_set_shed(bool) {}
+
+#endif // PORTAL_ADMISSION_ENABLED
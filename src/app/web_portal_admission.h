@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+
+#include "board_config.h"
+
+struct AsyncWebServerRequest;
+
+// Admission control for portal requests (PORTAL_ADMISSION_ENABLED).
+// Every handler already passes portal_auth_gate(); once a request is
+// authenticated the gate asks here whether it may run. Routes have a cost
+// class: pages, assets and small commands always run; JSON reads and body
+// uploads are capped (PORTAL_ADMISSION_JSON_MAX / _UPLOAD_MAX) and need enough
+// free internal heap and a large enough block. Anything over the limits gets
+// 503 + Retry-After instead of allocating on an already squeezed heap.
+//
+// Handlers run on the AsyncTCP task and cannot wait, so nothing is queued:
+// the client retries. An admitted request holds its slot until the library
+// destroys it (reply sent or client gone).
+
+// True to run the request; false once a 503 has been sent. Safe to call for
+// every body chunk of the same request.
+bool portal_admission_gate(AsyncWebServerRequest* request);
+
+// Run fn when request is destroyed. Use this instead of request->onDisconnect(),
+// which holds a single callback that admission control also needs. Hooks for
+// one request run in registration order. False (fn not registered) when every
+// hook slot is taken; the caller must clean up itself.
+bool portal_on_request_end(AsyncWebServerRequest* request, std::function<void()> fn);
+
+struct PortalAdmissionStats {
+    uint32_t admitted;          // JSON reads + uploads admitted since boot
+    uint32_t rejected_busy;     // 503: class at its concurrency cap
+    uint32_t rejected_memory;   // 503: heap below the class threshold
+    uint8_t in_flight_json;
+    uint8_t in_flight_upload;
+    uint8_t in_flight_peak;     // most admitted requests running at once
+};
+
+void portal_admission_get_stats(PortalAdmissionStats* out);
+
+// Turn away every JSON read and upload (503) while set, whatever the heap
+// looks like. Used by memory pressure shedding (memory_pressure.h).
+void portal_admission_set_shed(bool shed);
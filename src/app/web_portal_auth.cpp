@@ -5,6 +5,10 @@
 #include "board_config.h"
 #include "config_manager.h"
 #include "log_manager.h"
+#include "power_manager.h"
+#include "trace.h"
+#include "web_portal_admission.h"
+#include "web_portal_profile.h"
 #include "web_portal_state.h"
 
 #include <freertos/FreeRTOS.h>
@@ -37,13 +41,19 @@ bool portal_auth_gate(AsyncWebServerRequest* request) {
         logged_async_stack = true;
     }
 
-    if (!portal_auth_required()) return true;
+    // Every API/page handler passes here: run it (and the reply) at full clock.
+    power_manager_hold(PowerActivity::Http, POWER_ACTIVITY_HOLD_MS);
+    portal_profile_begin(request);
+    TRACE_INSTANT("http.handler");
+
+    if (!portal_auth_required()) return portal_admission_gate(request);
 
     const char* user = web_portal_state().config->basic_auth_username;
     const char* pass = web_portal_state().config->basic_auth_password;
 
     if (request->authenticate(user, pass)) {
-        return true;
+        // Only authenticated requests take an admission slot.
+        return portal_admission_gate(request);
     }
 
     request->requestAuthentication(PROJECT_DISPLAY_NAME);
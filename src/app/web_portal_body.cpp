@@ -0,0 +1,295 @@
+#include "web_portal_body.h"
+
+#include <ESPAsyncWebServer.h>
+#include <esp_memory_utils.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+
+#include "heap_placement.h"
+#include "heap_tags.h"
+#include "log_manager.h"
+#include "web_portal_admission.h"
+
+namespace {
+
+constexpr size_t kClassBytes[] = {1024, 4096, 16384, 65536};
+constexpr uint8_t kClasses = sizeof(kClassBytes) / sizeof(kClassBytes[0]);
+constexpr uint8_t kExactClass = 0xFF;  // larger than every class: exact block, never cached
+
+struct Lease {
+    AsyncWebServerRequest* request;  // nullptr = free
+    const char* owner;
+    uint8_t* buf;
+    size_t size;
+    size_t block;
+    uint8_t cls;
+    bool expired;
+    bool detached;                   // handed to a portal worker: outlives the request
+    uint32_t last_ms;
+};
+
+Lease g_leases[PORTAL_BODY_ARENA_LEASES] = {};
+uint8_t* g_cache[kClasses] = {};
+PortalBodyStats g_stats = {};
+
+// Stats are read from other tasks; the table itself only changes on AsyncTCP.
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+uint8_t class_for(size_t size) {
+    for (uint8_t i = 0; i < kClasses; i++) {
+        if (size <= kClassBytes[i]) return i;
+    }
+    return kExactClass;
+}
+
+uint8_t* alloc_block(size_t bytes) {
+    return (uint8_t*)heap_place_malloc(HeapClass::Transient, HeapTag::Http, bytes);
+}
+
+// Internal RAM is too scarce to park idle blocks in; PSRAM blocks of the
+// small classes are kept.
+bool cacheable(const Lease& l) {
+    return l.cls != kExactClass && l.block <= PORTAL_BODY_ARENA_CACHE_MAX_BYTES && esp_ptr_external_ram(l.buf);
+}
+
+// Detached leases are not the request's any more.
+Lease* find(AsyncWebServerRequest* request) {
+    for (Lease& l : g_leases) {
+        if (l.request == request && !l.detached) return &l;
+    }
+    return nullptr;
+}
+
+// Call with g_mux held; returns the block to free outside it, if any.
+uint8_t* release_locked(Lease* l, bool abandoned) {
+    uint8_t* to_free = nullptr;
+    if (cacheable(*l) && !g_cache[l->cls]) {
+        g_cache[l->cls] = l->buf;
+        g_stats.cached_bytes += l->block;
+    } else {
+        to_free = l->buf;
+    }
+    g_stats.leases--;
+    g_stats.bytes -= l->block;
+    if (abandoned) g_stats.abandoned++;
+    *l = Lease{};
+    return to_free;
+}
+
+void release_lease(AsyncWebServerRequest* request, bool abandoned) {
+    uint8_t* to_free = nullptr;
+    portENTER_CRITICAL(&g_mux);
+    Lease* l = find(request);
+    if (l) to_free = release_locked(l, abandoned);
+    portEXIT_CRITICAL(&g_mux);
+    if (to_free) heap_tag_free(HeapTag::Http, to_free);
+}
+
+// Close the connections of leases that stopped receiving; their end hooks
+// return the memory once the library tears the requests down.
+void expire_idle(uint32_t now) {
+    AsyncWebServerRequest* idle[PORTAL_BODY_ARENA_LEASES];
+    size_t n = 0;
+    portENTER_CRITICAL(&g_mux);
+    for (Lease& l : g_leases) {
+        if (!l.request || l.expired || l.detached) continue;
+        if ((uint32_t)(now - l.last_ms) < PORTAL_BODY_ARENA_TIMEOUT_MS) continue;
+        l.expired = true;
+        g_stats.expired++;
+        idle[n++] = l.request;
+    }
+    portEXIT_CRITICAL(&g_mux);
+
+    for (size_t i = 0; i < n; i++) {
+        Logger.logMessagef("Portal", "Body upload idle, closing %s", idle[i]->url().c_str());
+        idle[i]->client()->close();
+    }
+}
+
+void refuse() {
+    portENTER_CRITICAL(&g_mux);
+    g_stats.refused++;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void send_error(AsyncWebServerRequest* request, int code, const char* body) {
+    AsyncWebServerResponse* response = request->beginResponse(code, "application/json", body);
+    if (code == 503) response->addHeader("Retry-After", String((unsigned)PORTAL_ADMISSION_RETRY_AFTER_S));
+    request->send(response);
+}
+
+} // namespace
+
+uint8_t* portal_body_lease(AsyncWebServerRequest* request, const char* owner, size_t size) {
+    const uint32_t now = millis();
+    expire_idle(now);
+
+    // A request holds one lease; a second call replaces it.
+    portal_body_release(request);
+
+    const uint8_t cls = class_for(size);
+    const size_t block = cls == kExactClass ? size : kClassBytes[cls];
+
+    Lease* slot = nullptr;
+    uint8_t* buf = nullptr;
+    portENTER_CRITICAL(&g_mux);
+    for (Lease& l : g_leases) {
+        if (!l.request) {
+            slot = &l;
+            break;
+        }
+    }
+    if (slot) {
+        slot->request = request;  // reserve before leaving the critical section
+        if (cls != kExactClass && g_cache[cls]) {
+            buf = g_cache[cls];
+            g_cache[cls] = nullptr;
+            g_stats.cached_bytes -= block;
+            g_stats.reused++;
+        }
+    }
+    portEXIT_CRITICAL(&g_mux);
+
+    if (!slot) {
+        refuse();
+        Logger.logMessagef("Portal", "No body lease for %s (%u held)", request->url().c_str(), (unsigned)PORTAL_BODY_ARENA_LEASES);
+        return nullptr;
+    }
+
+    if (!buf) buf = alloc_block(block);
+    if (!buf) {
+        portENTER_CRITICAL(&g_mux);
+        slot->request = nullptr;
+        portEXIT_CRITICAL(&g_mux);
+        refuse();
+        Logger.logMessagef("Portal", "Body lease OOM: %u bytes for %s", (unsigned)block, request->url().c_str());
+        return nullptr;
+    }
+
+    portENTER_CRITICAL(&g_mux);
+    slot->owner = owner;
+    slot->buf = buf;
+    slot->size = size;
+    slot->block = block;
+    slot->cls = cls;
+    slot->expired = false;
+    slot->detached = false;
+    slot->last_ms = now;
+    g_stats.granted++;
+    g_stats.leases++;
+    g_stats.bytes += block;
+    if (g_stats.leases > g_stats.leases_peak) g_stats.leases_peak = g_stats.leases;
+    if (g_stats.bytes > g_stats.bytes_peak) g_stats.bytes_peak = g_stats.bytes;
+    portEXIT_CRITICAL(&g_mux);
+
+    if (!portal_on_request_end(request, [request]() { release_lease(request, true); })) {
+        release_lease(request, false);
+        refuse();
+        return nullptr;
+    }
+    return buf;
+}
+
+uint8_t* portal_body_leased(AsyncWebServerRequest* request, size_t* size) {
+    uint8_t* buf = nullptr;
+    portENTER_CRITICAL(&g_mux);
+    Lease* l = find(request);
+    if (l && l->buf) {
+        l->last_ms = millis();
+        buf = l->buf;
+        if (size) *size = l->size;
+    }
+    portEXIT_CRITICAL(&g_mux);
+    return buf;
+}
+
+void portal_body_release(AsyncWebServerRequest* request) {
+    release_lease(request, false);
+}
+
+uint8_t* portal_body_detach(AsyncWebServerRequest* request, size_t* size) {
+    uint8_t* buf = nullptr;
+    portENTER_CRITICAL(&g_mux);
+    Lease* l = find(request);
+    if (l && l->buf) {
+        // The request pointer stays as the owner's key (portal_body_owner_active)
+        // but is never dereferenced again: the request may be gone first.
+        l->detached = true;
+        buf = l->buf;
+        if (size) *size = l->size;
+    }
+    portEXIT_CRITICAL(&g_mux);
+    return buf;
+}
+
+void portal_body_release_detached(const uint8_t* buf) {
+    if (!buf) return;
+    uint8_t* to_free = nullptr;
+    portENTER_CRITICAL(&g_mux);
+    for (Lease& l : g_leases) {
+        if (l.detached && l.buf == buf) {
+            to_free = release_locked(&l, false);
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&g_mux);
+    if (to_free) heap_tag_free(HeapTag::Http, to_free);
+}
+
+bool portal_body_owner_active(const char* owner) {
+    bool active = false;
+    portENTER_CRITICAL(&g_mux);
+    for (const Lease& l : g_leases) {
+        if (l.request && l.owner && strcmp(l.owner, owner) == 0) {
+            active = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&g_mux);
+    return active;
+}
+
+const uint8_t* portal_body_collect(
+    AsyncWebServerRequest* request,
+    const char* owner,
+    uint8_t* data,
+    size_t len,
+    size_t index,
+    size_t total,
+    size_t max_total
+) {
+    if (index == 0) {
+        if (total == 0 || total > max_total) {
+            send_error(request, 413, "{\"success\":false,\"message\":\"Body too large\"}");
+            return nullptr;
+        }
+        if (len == total) return data;
+        if (!portal_body_lease(request, owner, total)) {
+            send_error(request, 503, "{\"success\":false,\"message\":\"Device busy, retry later\"}");
+            return nullptr;
+        }
+    }
+
+    size_t size = 0;
+    uint8_t* buf = portal_body_leased(request, &size);
+    // No lease after the first chunk: that chunk was answered already.
+    if (!buf) return nullptr;
+
+    if (size != total || index + len > total) {
+        portal_body_release(request);
+        send_error(request, 400, "{\"success\":false,\"message\":\"Invalid body state\"}");
+        return nullptr;
+    }
+
+    memcpy(buf + index, data, len);
+    return index + len == total ? buf : nullptr;
+}
+
+void portal_body_get_stats(PortalBodyStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_mux);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_config.h"
+
+struct AsyncWebServerRequest;
+
+// Shared staging for request bodies.
+// Body handlers used to keep their own buffers (a static array per JSON
+// route, a malloc per upload). Here every body lives in a lease owned by its
+// request. Leases come in size classes (1, 4, 16, 64 KiB; larger bodies get
+// an exact block), PSRAM first. Blocks up to PORTAL_BODY_ARENA_CACHE_MAX_BYTES
+// that sit in PSRAM are kept for the next lease of their class instead of
+// going back to the heap.
+//
+// A lease is returned by portal_body_release(), or when the library destroys
+// the request (client gone mid-upload). A lease that sees no chunk for
+// PORTAL_BODY_ARENA_TIMEOUT_MS has its connection closed, which frees it the
+// same way. At most PORTAL_BODY_ARENA_LEASES are held at once.
+//
+// Call these from the AsyncTCP task (request handlers), except
+// portal_body_release_detached().
+
+// Collect a body that is at most max_total bytes. Returns the whole body once
+// its last chunk is in, and nullptr before that or after an error reply
+// (413 too large, 503 no lease, 400 inconsistent chunks). A body that arrives
+// in one chunk is returned in place without a lease. The result is not
+// NUL-terminated; release it with portal_body_release() when done.
+const uint8_t* portal_body_collect(
+    AsyncWebServerRequest* request,
+    const char* owner,
+    uint8_t* data,
+    size_t len,
+    size_t index,
+    size_t total,
+    size_t max_total
+);
+
+// Lease size bytes for request (its only lease). nullptr when every lease is
+// taken or memory is short; the caller answers.
+uint8_t* portal_body_lease(AsyncWebServerRequest* request, const char* owner, size_t size);
+
+// The request's lease, or nullptr. Counts as activity for the timeout.
+uint8_t* portal_body_leased(AsyncWebServerRequest* request, size_t* size = nullptr);
+
+void portal_body_release(AsyncWebServerRequest* request);
+
+// Hand the request's lease to a portal worker (web_portal_workers.h). It no
+// longer expires or goes with the request, and still counts for its owner
+// until portal_body_release_detached(), which any task may call. nullptr
+// when the request holds no lease.
+uint8_t* portal_body_detach(AsyncWebServerRequest* request, size_t* size = nullptr);
+void portal_body_release_detached(const uint8_t* buf);
+
+// True while any request holds a lease tagged owner (single-writer routes).
+bool portal_body_owner_active(const char* owner);
+
+struct PortalBodyStats {
+    uint8_t leases;             // held now
+    uint8_t leases_peak;
+    uint32_t bytes;             // block bytes held by leases now
+    uint32_t bytes_peak;
+    uint32_t cached_bytes;      // released blocks kept for reuse
+    uint32_t granted;           // leases since boot
+    uint32_t reused;            // ... served from a cached block
+    uint32_t refused;           // no lease slot or out of memory
+    uint32_t expired;           // connection closed after PORTAL_BODY_ARENA_TIMEOUT_MS idle
+    uint32_t abandoned;         // released because the request went away
+};
+
+void portal_body_get_stats(PortalBodyStats* out);
@@ -0,0 +1,225 @@
+#include "web_portal_events.h"
+
+#include <ESPAsyncWebServer.h>
+#include <string.h>
+
+#include "device_telemetry.h"
+#include "json_stream_writer.h"
+#include "log_manager.h"
+#include "loop_scheduler.h"
+#include "memory_pressure.h"
+#include "web_portal_auth.h"
+#include "web_portal_json_stream.h"
+#include "web_portal_state.h"
+
+#if HAS_DISPLAY
+#include "display_manager.h"
+#endif
+
+#if HAS_IMAGE_API
+#include "image_api.h"
+#endif
+
+#if PORTAL_EVENTS_ENABLED
+
+namespace {
+
+// Skip a round while subscribers still have this many events queued on average.
+constexpr size_t kMaxBacklog = 4;
+
+AsyncEventSource g_events("/api/events");
+uint32_t g_event_id = 0;
+
+// Set on the AsyncTCP task when someone subscribes; the next poll resends
+// every event so the new page starts from current state.
+bool g_resync = false;
+
+uint32_t g_next_health_ms = 0;
+
+#if HAS_DISPLAY
+char g_screen[32] = "";
+#endif
+
+#if HAS_IMAGE_API
+const char* g_image_state = nullptr;
+const char* g_image_job = nullptr;
+uint32_t g_image_done = 0;
+#endif
+
+bool g_ota_active = false;
+char g_ota_state[16] = "";
+uint32_t g_ota_progress = 0;
+
+#if MEMORY_PRESSURE_ENABLED
+MemPressureTier g_mem_tier = MemPressureTier::None;
+#endif
+
+// Small events render on the stack; only health needs a stream buffer.
+template <typename Fill>
+void send_small(const char* event, Fill fill) {
+    char buf[320];
+    JsonFixedBufferPrint out(buf, sizeof(buf) - 1);
+    JsonStreamWriter writer(out);
+    JsonStreamObject root = writer.root();
+    fill(root);
+    writer.finish();
+    if (out.overflowed()) return;
+    buf[out.length()] = '\0';
+    g_events.send(buf, event, ++g_event_id);
+}
+
+void send_health() {
+    size_t len = 0;
+    const char* json = portal_json_stream_render(device_telemetry_write_api, &len);
+    if (!json) return;  // Buffers busy with HTTP replies: next interval.
+    g_events.send(json, "health", ++g_event_id);
+    portal_json_stream_release(json);
+}
+
+#if HAS_DISPLAY
+void check_screen(bool force) {
+    const char* id = display_manager_get_current_screen_id();
+    if (!id) id = "";
+    if (!force && strcmp(id, g_screen) == 0) return;
+    strlcpy(g_screen, id, sizeof(g_screen));
+
+    send_small("screen", [id](JsonStreamObject& o) {
+        if (id[0]) {
+            o["screen"] = id;
+        } else {
+            o["screen"] = nullptr;
+        }
+    });
+}
+#endif
+
+#if HAS_IMAGE_API
+void check_image(bool force) {
+    ImageApiWorkerStats img;
+    if (!image_api_get_worker_stats(&img)) return;
+    // state and job names are string literals, so pointers compare.
+    if (!force && img.state == g_image_state && img.active_job_name == g_image_job && img.jobs_done == g_image_done) return;
+    g_image_state = img.state;
+    g_image_job = img.active_job_name;
+    g_image_done = img.jobs_done;
+
+    send_small("image", [&img](JsonStreamObject& o) {
+        o["state"] = img.state;
+        o["job"] = img.active_job_name;
+        o["done"] = img.jobs_done;
+        o["last_job"] = img.last_job_name;
+        o["last_run_ms"] = img.last_run_ms;
+    });
+}
+#endif
+
+void check_ota(bool force) {
+    FirmwareUpdateStatus fw;
+    web_portal_get_firmware_update_status(&fw);
+    const WebPortalState& st = web_portal_state();
+
+    // ota_in_progress also covers the GitHub update; without it running this
+    // is a browser upload to /api/update.
+    const bool upload = st.ota_in_progress && !fw.in_progress;
+    const bool active = fw.in_progress || upload;
+    const char* state = upload ? "uploading" : fw.state;
+    const uint32_t progress = upload ? (uint32_t)st.ota_progress : fw.progress;
+    const uint32_t total = upload ? (uint32_t)st.ota_total : fw.total;
+
+    // Progress while running, one event when it ends, nothing while idle.
+    if (!force) {
+        if (!active && !g_ota_active) return;
+        if (active == g_ota_active && progress == g_ota_progress && strcmp(state, g_ota_state) == 0) return;
+    }
+    g_ota_active = active;
+    g_ota_progress = progress;
+    strlcpy(g_ota_state, state, sizeof(g_ota_state));
+
+    send_small("ota", [&](JsonStreamObject& o) {
+        o["source"] = upload ? "upload" : "github";
+        o["state"] = state;
+        o["progress"] = progress;
+        o["total"] = total;
+        if (!upload) o["bytes_per_sec"] = fw.bytes_per_sec;
+        if (fw.error[0] && !upload) {
+            o["error"] = fw.error;
+        } else {
+            o["error"] = nullptr;
+        }
+    });
+}
+
+#if MEMORY_PRESSURE_ENABLED
+void check_memory(bool force) {
+    MemPressureStats mp;
+    memory_pressure_get_stats(&mp);
+    if (!force && mp.tier == g_mem_tier) return;
+    g_mem_tier = mp.tier;
+
+    send_small("memory", [&mp](JsonStreamObject& o) {
+        o["tier"] = memory_pressure_tier_name(mp.tier);
+        o["peak"] = memory_pressure_tier_name(mp.peak);
+    });
+}
+#endif
+
+} // namespace
+
+void web_portal_register_events_routes(AsyncWebServer& server) {
+    // Runs on the AsyncTCP task. A refusal is answered by the library; the
+    // portal then keeps polling.
+    g_events.authorizeConnect([](AsyncWebServerRequest* request) {
+        if (!portal_auth_gate(request)) return false;
+        if (g_events.count() >= PORTAL_EVENTS_MAX_CLIENTS) {
+            Logger.logMessagef("Portal", "/api/events refused (%u subscribers)", (unsigned)g_events.count());
+            return false;
+        }
+        return true;
+    });
+    g_events.onConnect([](AsyncEventSourceClient* client) {
+        (void)client;
+        __atomic_store_n(&g_resync, true, __ATOMIC_RELEASE);
+        loop_scheduler_notify();
+    });
+    server.addHandler(&g_events);
+}
+
+uint32_t web_portal_events_poll(uint32_t now_ms) {
+    if (g_events.count() == 0) return LOOP_SCHEDULER_IDLE;
+
+    const bool resync = __atomic_exchange_n(&g_resync, false, __ATOMIC_ACQ_REL);
+
+    if (!resync && g_events.avgPacketsWaiting() > kMaxBacklog) {
+        return PORTAL_EVENTS_CHECK_MS;
+    }
+
+    if (resync || (int32_t)(now_ms - g_next_health_ms) >= 0) {
+        send_health();
+        g_next_health_ms = now_ms + PORTAL_EVENTS_HEALTH_INTERVAL_MS;
+    }
+
+#if HAS_DISPLAY
+    check_screen(resync);
+#endif
+#if HAS_IMAGE_API
+    check_image(resync);
+#endif
+    check_ota(resync);
+#if MEMORY_PRESSURE_ENABLED
+    check_memory(resync);
+#endif
+
+    const uint32_t until_health = g_next_health_ms - now_ms;
+    return until_health < PORTAL_EVENTS_CHECK_MS ? until_health : PORTAL_EVENTS_CHECK_MS;
+}
+
+#else
+
+void web_portal_register_events_routes(AsyncWebServer&) {
+}
+
+uint32_t web_portal_events_poll(uint32_t) {
+    return LOOP_SCHEDULER_IDLE;
+}
+
+#endif // PORTAL_EVENTS_ENABLED
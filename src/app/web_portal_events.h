@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "board_config.h"
+
+class AsyncWebServer;
+
+// GET /api/events: Server-Sent Events for the portal (PORTAL_EVENTS_ENABLED).
+// Instead of polling, a subscriber receives:
+//   health  the /api/health document, every PORTAL_EVENTS_HEALTH_INTERVAL_MS
+//   screen  {"screen":"<id>"} when the active screen changes
+//   image   {"state":..,"job":..,"done":n} when the image worker changes state
+//   ota     {"source":"github"|"upload","state":..,"progress":n,"total":n,"error":..}
+//           while a firmware update runs, and once when it ends
+//   memory  {"tier":..,"peak":..} when the memory pressure tier changes
+// A new subscriber gets one of each straight away. At most
+// PORTAL_EVENTS_MAX_CLIENTS subscribers; further connections are refused.
+//
+// The health document is rendered once per interval and shared by every
+// subscriber, however many tabs are open.
+
+void web_portal_register_events_routes(AsyncWebServer& server);
+
+// Loop scheduler entry (register with run_on_event): sends due events and
+// returns the delay until the next check, LOOP_SCHEDULER_IDLE without subscribers.
+uint32_t web_portal_events_poll(uint32_t now_ms);
@@ -1,11 +1,16 @@
 #include "web_portal_http.h"
 
+#include <esp_random.h>
+
+#include "web_portal_profile.h"
+
 AsyncWebServerResponse* begin_gzipped_asset_response(
     AsyncWebServerRequest* request,
     const char* content_type,
     const uint8_t* content_gz,
     size_t content_gz_len,
-    const char* cache_control
+    const char* cache_control,
+    const char* etag
 ) {
     // Prefer the PROGMEM-aware response helper to avoid accidental heap copies.
     // All generated assets live in flash as `const uint8_t[] PROGMEM`.
@@ -21,5 +26,38 @@ AsyncWebServerResponse* begin_gzipped_asset_response(
     if (cache_control && strlen(cache_control) > 0) {
         response->addHeader("Cache-Control", cache_control);
     }
+    if (etag) {
+        response->addHeader("ETag", etag);
+    }
+    portal_profile_bytes_out(request, content_gz_len);
     return response;
 }
+
+static uint32_t boot_nonce() {
+    static uint32_t nonce = 0;
+    while (nonce == 0) nonce = esp_random();
+    return nonce;
+}
+
+void portal_format_etag(char* out, size_t out_len, const char* tag, uint32_t generation) {
+    snprintf(out, out_len, "W/\"%s-%08lx-%lu\"", tag, (unsigned long)boot_nonce(), (unsigned long)generation);
+}
+
+bool portal_send_not_modified(AsyncWebServerRequest* request, const char* etag, const char* cache_control) {
+    if (!request->hasHeader("If-None-Match")) return false;
+    const String& inm = request->header("If-None-Match");
+
+    // The header may list several tags; weak comparison ignores the W/ prefix.
+    const char* bare = (strncmp(etag, "W/", 2) == 0) ? etag + 2 : etag;
+    if (inm != "*" && inm.indexOf(bare) < 0) return false;
+
+    AsyncWebServerResponse* response = request->beginResponse(304);
+    portal_add_etag_headers(response, etag, cache_control);
+    request->send(response);
+    return true;
+}
+
+void portal_add_etag_headers(AsyncWebServerResponse* response, const char* etag, const char* cache_control) {
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", cache_control);
+}
@@ -6,6 +6,8 @@
 
 #include <ESPAsyncWebServer.h>
 
+#include "web_portal_profile.h"
+
 static inline size_t chunk_copy_out(uint8_t* dst, size_t maxLen, const char* src, size_t srcLen, size_t& srcOff) {
     if (!src || srcOff >= srcLen || maxLen == 0) return 0;
     const size_t n = (srcLen - srcOff) < maxLen ? (srcLen - srcOff) : maxLen;
@@ -14,8 +16,19 @@ static inline size_t chunk_copy_out(uint8_t* dst, size_t maxLen, const char* src
     return n;
 }
 
+// Conditional GET for config-style resources whose content only changes with
+// a generation counter. The ETag also carries a per-boot nonce, so a copy
+// cached before a reboot is never revalidated against a restarted counter.
+void portal_format_etag(char* out, size_t out_len, const char* tag, uint32_t generation);
+
+// Sends 304 (no body) and returns true when If-None-Match matches etag.
+bool portal_send_not_modified(AsyncWebServerRequest* request, const char* etag, const char* cache_control = "no-cache");
+
+// ETag + Cache-Control (default "no-cache", so browsers revalidate on every fetch).
+void portal_add_etag_headers(AsyncWebServerResponse* response, const char* etag, const char* cache_control = "no-cache");
+
 template <typename State>
-static inline void send_chunked_state(AsyncWebServerRequest* request, const char* contentType, State* st) {
+static inline void send_chunked_state(AsyncWebServerRequest* request, const char* contentType, State* st, const char* etag = nullptr) {
     AsyncWebServerResponse* response = request->beginChunkedResponse(
         contentType,
         [st](uint8_t* buffer, size_t maxLen, size_t /*index*/) mutable -> size_t {
@@ -28,6 +41,7 @@ static inline void send_chunked_state(AsyncWebServerRequest* request, const char
             return n;
         }
     );
+    if (etag) portal_add_etag_headers(response, etag);
     request->send(response);
 }
 
@@ -56,6 +70,7 @@ static inline bool send_json_doc_chunked(AsyncWebServerRequest* request, JsonDoc
 
     st->payload.reserve(measureJson(doc) + 1);
     serializeJson(doc, st->payload);
+    portal_profile_bytes_out(request, st->payload.length());
     send_chunked_state(request, "application/json", st);
     return true;
 }
@@ -65,5 +80,6 @@ AsyncWebServerResponse* begin_gzipped_asset_response(
     const char* content_type,
     const uint8_t* content_gz,
     size_t content_gz_len,
-    const char* cache_control
+    const char* cache_control,
+    const char* etag = nullptr
 );
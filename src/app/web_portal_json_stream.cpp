@@ -0,0 +1,141 @@
+#include "web_portal_json_stream.h"
+
+#include <ESPAsyncWebServer.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+
+#include "board_config.h"
+#include "heap_placement.h"
+#include "heap_tags.h"
+#include "log_manager.h"
+#include "web_portal_admission.h"
+#include "web_portal_profile.h"
+
+namespace {
+
+struct Slot {
+    char* buf;
+    bool busy;
+};
+
+Slot g_slots[PORTAL_JSON_STREAM_SLOTS] = {};
+portMUX_TYPE g_slots_mux = portMUX_INITIALIZER_UNLOCKED;
+
+char* alloc_buffer() {
+    return (char*)heap_place_malloc(HeapClass::Transient, HeapTag::Json, PORTAL_JSON_STREAM_SLOT_BYTES);
+}
+
+Slot* acquire() {
+    Slot* slot = nullptr;
+    portENTER_CRITICAL(&g_slots_mux);
+    for (Slot& s : g_slots) {
+        if (!s.busy) {
+            s.busy = true;
+            slot = &s;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&g_slots_mux);
+    if (!slot || slot->buf) return slot;
+
+    // First use of this slot: the only allocation it will ever make.
+    slot->buf = alloc_buffer();
+    if (!slot->buf) {
+        portENTER_CRITICAL(&g_slots_mux);
+        slot->busy = false;
+        portEXIT_CRITICAL(&g_slots_mux);
+        return nullptr;
+    }
+    return slot;
+}
+
+void release(Slot* slot) {
+    portENTER_CRITICAL(&g_slots_mux);
+    slot->busy = false;
+    portEXIT_CRITICAL(&g_slots_mux);
+}
+
+bool all_busy() {
+    bool busy = true;
+    portENTER_CRITICAL(&g_slots_mux);
+    for (const Slot& s : g_slots) {
+        if (!s.busy) busy = false;
+    }
+    portEXIT_CRITICAL(&g_slots_mux);
+    return busy;
+}
+
+// Renders into slot->buf; false when the output did not fit. Keeps one
+// byte spare so the text can be NUL-terminated.
+bool render(Slot* slot, void (*fill)(JsonStreamObject& root), size_t* out_len) {
+    JsonFixedBufferPrint out(slot->buf, PORTAL_JSON_STREAM_SLOT_BYTES - 1);
+    JsonStreamWriter writer(out);
+    JsonStreamObject root = writer.root();
+    fill(root);
+    writer.finish();
+    if (out.overflowed()) return false;
+    slot->buf[out.length()] = '\0';
+    *out_len = out.length();
+    return true;
+}
+
+} // namespace
+
+void portal_send_json_stream(AsyncWebServerRequest* request, void (*fill)(JsonStreamObject& root)) {
+    Slot* slot = acquire();
+    if (!slot) {
+        if (all_busy()) {
+            AsyncWebServerResponse* response = request->beginResponse(
+                503,
+                "application/json",
+                "{\"success\":false,\"message\":\"Device busy, retry later\"}"
+            );
+            response->addHeader("Retry-After", String((unsigned)PORTAL_ADMISSION_RETRY_AFTER_S));
+            request->send(response);
+        } else {
+            request->send(503, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
+        }
+        return;
+    }
+
+    size_t len = 0;
+    if (!render(slot, fill, &len)) {
+        release(slot);
+        Logger.logMessagef("Portal", "ERROR: %s JSON overflow (PORTAL_JSON_STREAM_SLOT_BYTES=%u)",
+            request->url().c_str(), (unsigned)PORTAL_JSON_STREAM_SLOT_BYTES);
+        request->send(500, "application/json", "{\"success\":false,\"message\":\"Response too large\"}");
+        return;
+    }
+
+    // The response reads straight from the slot, so hold it until the request
+    // is gone (sent or aborted).
+    if (!portal_on_request_end(request, [slot]() { release(slot); })) {
+        release(slot);
+        request->send(503, "application/json", "{\"success\":false,\"message\":\"Device busy, retry later\"}");
+        return;
+    }
+    portal_profile_bytes_out(request, len);
+    request->send(request->beginResponse_P(200, "application/json", (const uint8_t*)slot->buf, len));
+}
+
+const char* portal_json_stream_render(void (*fill)(JsonStreamObject& root), size_t* out_len) {
+    Slot* slot = acquire();
+    if (!slot) return nullptr;
+    if (!render(slot, fill, out_len)) {
+        release(slot);
+        Logger.logMessagef("Portal", "ERROR: streamed JSON overflow (PORTAL_JSON_STREAM_SLOT_BYTES=%u)",
+            (unsigned)PORTAL_JSON_STREAM_SLOT_BYTES);
+        return nullptr;
+    }
+    return slot->buf;
+}
+
+void portal_json_stream_release(const char* buf) {
+    for (Slot& s : g_slots) {
+        if (s.buf == buf) {
+            release(&s);
+            return;
+        }
+    }
+}
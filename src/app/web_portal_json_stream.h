@@ -0,0 +1,23 @@
+#pragma once
+
+#include "json_stream_writer.h"
+
+struct AsyncWebServerRequest;
+
+// Streamed JSON responses for frequently polled endpoints.
+// fill() writes the members of the top-level object through a
+// JsonStreamWriter into one of PORTAL_JSON_STREAM_SLOTS buffers, which is then
+// sent as-is (Content-Length known, no copy). Buffers are allocated on first
+// use and reused, so polling does not allocate per request. A buffer stays
+// taken until the library destroys the request.
+//
+// Sends 503 + Retry-After when every buffer is in use, 500 when the output
+// does not fit PORTAL_JSON_STREAM_SLOT_BYTES.
+void portal_send_json_stream(AsyncWebServerRequest* request, void (*fill)(JsonStreamObject& root));
+
+// The same render for a consumer other than an HTTP reply (/api/events).
+// Returns a NUL-terminated buffer to hand back with portal_json_stream_release(),
+// or nullptr when every buffer is busy, on out of memory, or when the output
+// does not fit.
+const char* portal_json_stream_render(void (*fill)(JsonStreamObject& root), size_t* out_len);
+void portal_json_stream_release(const char* buf);
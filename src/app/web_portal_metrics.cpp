@@ -0,0 +1,590 @@
+#include "web_portal_routes.h"
+
+#include <ESPAsyncWebServer.h>
+
+#include "board_config.h"
+#include "web_portal_auth.h"
+#include "web_portal_http.h"
+
+#if PROMETHEUS_METRICS_ENABLED
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <stdio.h>
+
+#include "device_telemetry.h"
+#include "heap_tags.h"
+#include "log_manager.h"
+#include "loop_scheduler.h"
+#include "web_portal_profile.h"
+
+#if HAS_DISPLAY
+#include "display_manager.h"
+#include "lvgl_heap.h"
+#endif
+
+namespace {
+
+struct MetricsChunker;
+
+// Writes sample i of a family into the chunker's line (an empty line skips
+// it); false once i is past the last sample.
+typedef bool (*MetricSampleFn)(MetricsChunker& m, const char* name, uint32_t i);
+
+struct MetricFamily {
+    const char* name;
+    const char* type;
+    const char* help;
+    MetricSampleFn sample;
+};
+
+constexpr size_t kHeapKinds = (size_t)HeapKind::Count;
+constexpr size_t kHeapTags = (size_t)HeapTag::Count;
+
+// GET /metrics body, Prometheus text exposition format 0.0.4:
+// # HELP device_heap_free_bytes Free heap.
+// # TYPE device_heap_free_bytes gauge
+// device_heap_free_bytes{heap="internal"} 81234
+// ...
+// Each line is formatted into a fixed buffer as the response asks for it, so
+// the reply costs one state object whatever the number of routes and tasks.
+// Device, CPU, heap tag, loop and display values are copied when the request
+// arrives; the route table (same task) is read as the lines go out.
+struct MetricsChunker {
+    const char* cur = nullptr;
+    size_t cur_len = 0;
+    size_t cur_off = 0;
+
+    size_t family = 0;
+    uint32_t i = 0;
+    bool header_done = false;
+
+    uint64_t uptime_us = 0;
+    DeviceTelemetrySnapshot snap = {};
+    int cpu_usage = -1;
+    int core_usage[portNUM_PROCESSORS];
+    DeviceCpuTaskUsage tasks[CPU_TASK_TOP_N];
+    size_t task_count = 0;
+
+#if HEAP_TAGS_ENABLED
+    HeapTagStats heap[kHeapTags][kHeapKinds];
+#endif
+
+    LoopSchedulerStats loop = {};
+    LoopSchedulerEntryStats loop_tasks[LOOP_SCHEDULER_MAX_ENTRIES];
+    size_t loop_task_count = 0;
+
+#if HAS_DISPLAY
+    DisplayPerfStats display = {};
+    bool have_display = false;
+    LvglHeapStats lvgl_heap = {};
+#endif
+
+    // One route table entry, cached across the lines that describe it.
+    PortalRouteStats route = {};
+    size_t route_slot = SIZE_MAX;
+    bool route_valid = false;
+
+    char labels[128];
+    char line[224];
+
+    MetricsChunker() {
+        uptime_us = (uint64_t)esp_timer_get_time();
+        device_telemetry_get_snapshot(&snap);
+        cpu_usage = device_telemetry_get_cpu_usage();
+        for (int& c : core_usage) c = -1;
+        task_count = device_telemetry_get_cpu_tasks(tasks, CPU_TASK_TOP_N, core_usage, portNUM_PROCESSORS);
+#if HEAP_TAGS_ENABLED
+        for (size_t t = 0; t < kHeapTags; t++) heap_tag_get_stats((HeapTag)t, heap[t]);
+#endif
+        loop_scheduler_get_stats(&loop);
+        loop_task_count = loop_scheduler_get_entry_stats(loop_tasks, LOOP_SCHEDULER_MAX_ENTRIES);
+#if HAS_DISPLAY
+        have_display = display_manager_get_perf_stats(&display);
+        lvgl_heap_get_stats(&lvgl_heap);
+#endif
+    }
+
+    void set_line(int n) {
+        cur = line;
+        cur_len = (n > 0 && (size_t)n < sizeof(line)) ? (size_t)n : 0;
+        cur_off = 0;
+    }
+
+    bool skip() {
+        set_line(0);
+        return true;
+    }
+
+    // Appends key="value" (value escaped per the exposition format) to labels.
+    const char* label(const char* key, const char* value, bool append = false) {
+        size_t pos = append ? strlen(labels) : 0;
+        const size_t cap = sizeof(labels);
+        const int n = snprintf(labels + pos, cap - pos, "%s%s=\"", pos ? "," : "", key);
+        if (n < 0 || (size_t)n >= cap - pos) {
+            labels[pos] = '\0';
+            return labels;
+        }
+        pos += (size_t)n;
+        for (const char* p = value ? value : ""; *p && pos + 3 < cap; p++) {
+            if (*p == '\\' || *p == '"') {
+                labels[pos++] = '\\';
+                labels[pos++] = *p;
+            } else if (*p == '\n') {
+                labels[pos++] = '\\';
+                labels[pos++] = 'n';
+            } else {
+                labels[pos++] = *p;
+            }
+        }
+        labels[pos++] = '"';
+        labels[pos] = '\0';
+        return labels;
+    }
+
+    bool put(const char* name, const char* lbl, unsigned long long value) {
+        if (lbl && *lbl) {
+            set_line(snprintf(line, sizeof(line), "%s{%s} %llu\n", name, lbl, value));
+        } else {
+            set_line(snprintf(line, sizeof(line), "%s %llu\n", name, value));
+        }
+        return true;
+    }
+
+    bool put_signed(const char* name, const char* lbl, long value) {
+        if (lbl && *lbl) {
+            set_line(snprintf(line, sizeof(line), "%s{%s} %ld\n", name, lbl, value));
+        } else {
+            set_line(snprintf(line, sizeof(line), "%s %ld\n", name, value));
+        }
+        return true;
+    }
+
+    // Microseconds written as seconds, without going through float.
+    bool put_seconds(const char* name, const char* lbl, uint64_t us) {
+        const unsigned long long s = us / 1000000ull;
+        const unsigned long frac = (unsigned long)(us % 1000000ull);
+        if (lbl && *lbl) {
+            set_line(snprintf(line, sizeof(line), "%s{%s} %llu.%06lu\n", name, lbl, s, frac));
+        } else {
+            set_line(snprintf(line, sizeof(line), "%s %llu.%06lu\n", name, s, frac));
+        }
+        return true;
+    }
+
+    const PortalRouteStats* route_at(size_t slot) {
+        if (slot != route_slot) {
+            route_slot = slot;
+            route_valid = portal_profile_route_at(slot, &route);
+        }
+        return route_valid ? &route : nullptr;
+    }
+
+    const char* route_labels(const PortalRouteStats& r) {
+        label("method", r.method);
+        return label("path", r.path, true);
+    }
+
+    bool next_piece();
+
+    size_t fill(uint8_t* buffer, size_t maxLen) {
+        size_t wrote = 0;
+        while (wrote < maxLen) {
+            if (!cur || cur_off >= cur_len) {
+                if (!next_piece()) break;
+            }
+            // Skipped samples leave an empty piece.
+            const size_t n = chunk_copy_out(buffer + wrote, maxLen - wrote, cur, cur_len, cur_off);
+            if (n == 0) continue;
+            wrote += n;
+        }
+        return wrote;
+    }
+};
+
+const char* const kMemHeaps[] = {"all", "internal", "psram"};
+
+// ---- Device ----------------------------------------------------------------
+
+bool sample_uptime(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0) return false;
+    return m.put_seconds(name, nullptr, m.uptime_us);
+}
+
+bool sample_heap_free(MetricsChunker& m, const char* name, uint32_t i) {
+    const DeviceMemorySnapshot& mem = m.snap.mem;
+    const size_t v[] = {mem.heap_free_bytes, mem.heap_internal_free_bytes, mem.psram_free_bytes};
+    if (i >= 3) return false;
+    if (i == 2 && !psramFound()) return m.skip();
+    return m.put(name, m.label("heap", kMemHeaps[i]), v[i]);
+}
+
+bool sample_heap_min_free(MetricsChunker& m, const char* name, uint32_t i) {
+    const DeviceMemorySnapshot& mem = m.snap.mem;
+    const size_t v[] = {mem.heap_min_free_bytes, mem.heap_internal_min_free_bytes, mem.psram_min_free_bytes};
+    if (i >= 3) return false;
+    if (i == 2 && !psramFound()) return m.skip();
+    return m.put(name, m.label("heap", kMemHeaps[i]), v[i]);
+}
+
+bool sample_heap_largest(MetricsChunker& m, const char* name, uint32_t i) {
+    const DeviceMemorySnapshot& mem = m.snap.mem;
+    if (i >= 2) return false;
+    if (i == 0) return m.put(name, m.label("heap", "internal"), mem.heap_largest_free_block_bytes);
+    if (!psramFound()) return m.skip();
+    return m.put(name, m.label("heap", "psram"), mem.psram_largest_free_block_bytes);
+}
+
+bool sample_heap_fragmentation(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= 2) return false;
+    if (i == 0) return m.put_signed(name, m.label("heap", "internal"), m.snap.heap_fragmentation);
+    if (!psramFound()) return m.skip();
+    return m.put_signed(name, m.label("heap", "psram"), m.snap.psram_fragmentation);
+}
+
+bool sample_cpu_temperature(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.snap.cpu_temperature_valid) return false;
+    return m.put_signed(name, nullptr, m.snap.cpu_temperature);
+}
+
+bool sample_wifi_connected(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0) return false;
+    return m.put(name, nullptr, m.snap.wifi_connected ? 1 : 0);
+}
+
+bool sample_wifi_rssi(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.snap.wifi_connected) return false;
+    return m.put_signed(name, nullptr, m.snap.wifi_rssi);
+}
+
+bool sample_log_dropped(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0) return false;
+    return m.put(name, nullptr, Logger.dropped());
+}
+
+// ---- CPU -------------------------------------------------------------------
+
+bool sample_cpu_usage(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || m.cpu_usage < 0) return false;
+    return m.put_signed(name, nullptr, m.cpu_usage);
+}
+
+bool sample_cpu_core_usage(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= (uint32_t)portNUM_PROCESSORS) return false;
+    if (m.core_usage[i] < 0) return m.skip();
+    char core[4];
+    snprintf(core, sizeof(core), "%u", (unsigned)i);
+    return m.put_signed(name, m.label("core", core), m.core_usage[i]);
+}
+
+bool sample_cpu_task_usage(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= m.task_count) return false;
+    return m.put(name, m.label("task", m.tasks[i].name), m.tasks[i].percent);
+}
+
+// ---- Heap tags -------------------------------------------------------------
+
+#if HEAP_TAGS_ENABLED
+
+// Sample i is tag i / kHeapKinds on heap i % kHeapKinds; heaps a tag never
+// touched are left out.
+const HeapTagStats* heap_tag_sample(MetricsChunker& m, uint32_t i, bool* done) {
+    *done = i >= kHeapTags * kHeapKinds;
+    if (*done) return nullptr;
+    const size_t tag = i / kHeapKinds;
+    const size_t kind = i % kHeapKinds;
+    const HeapTagStats& s = m.heap[tag][kind];
+    if (s.allocs == 0 && s.failed == 0 && s.live_blocks == 0) return nullptr;
+    m.label("tag", heap_tag_name((HeapTag)tag));
+    m.label("heap", heap_kind_name((HeapKind)kind), true);
+    return &s;
+}
+
+bool sample_heap_tag_live(MetricsChunker& m, const char* name, uint32_t i) {
+    bool done;
+    const HeapTagStats* s = heap_tag_sample(m, i, &done);
+    if (done) return false;
+    return s ? m.put(name, m.labels, s->live_bytes) : m.skip();
+}
+
+bool sample_heap_tag_peak(MetricsChunker& m, const char* name, uint32_t i) {
+    bool done;
+    const HeapTagStats* s = heap_tag_sample(m, i, &done);
+    if (done) return false;
+    return s ? m.put(name, m.labels, s->peak_bytes) : m.skip();
+}
+
+bool sample_heap_tag_allocs(MetricsChunker& m, const char* name, uint32_t i) {
+    bool done;
+    const HeapTagStats* s = heap_tag_sample(m, i, &done);
+    if (done) return false;
+    return s ? m.put(name, m.labels, s->allocs) : m.skip();
+}
+
+bool sample_heap_tag_failed(MetricsChunker& m, const char* name, uint32_t i) {
+    bool done;
+    const HeapTagStats* s = heap_tag_sample(m, i, &done);
+    if (done) return false;
+    return s ? m.put(name, m.labels, s->failed) : m.skip();
+}
+
+#endif // HEAP_TAGS_ENABLED
+
+// ---- Loop scheduler --------------------------------------------------------
+
+bool sample_loop_passes(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0) return false;
+    return m.put(name, nullptr, m.loop.passes);
+}
+
+bool sample_loop_sleep(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0) return false;
+    return m.put_seconds(name, nullptr, (uint64_t)m.loop.sleep_ms * 1000ull);
+}
+
+bool sample_loop_task_runs(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= m.loop_task_count) return false;
+    return m.put(name, m.label("task", m.loop_tasks[i].name), m.loop_tasks[i].runs);
+}
+
+bool sample_loop_task_seconds(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= m.loop_task_count) return false;
+    return m.put_seconds(name, m.label("task", m.loop_tasks[i].name), m.loop_tasks[i].total_us);
+}
+
+bool sample_loop_task_max(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= m.loop_task_count) return false;
+    return m.put_seconds(name, m.label("task", m.loop_tasks[i].name), m.loop_tasks[i].max_us);
+}
+
+bool sample_loop_task_late(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= m.loop_task_count) return false;
+    return m.put(name, m.label("task", m.loop_tasks[i].name), m.loop_tasks[i].late);
+}
+
+bool sample_loop_task_overruns(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= m.loop_task_count) return false;
+    return m.put(name, m.label("task", m.loop_tasks[i].name), m.loop_tasks[i].overruns);
+}
+
+// ---- HTTP routes -----------------------------------------------------------
+
+#if PORTAL_ROUTE_PROFILE_ENABLED
+
+bool sample_http_requests(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= portal_profile_route_slots()) return false;
+    const PortalRouteStats* r = m.route_at(i);
+    return r ? m.put(name, m.route_labels(*r), r->count) : m.skip();
+}
+
+// Per route: one cumulative _bucket line per latency bucket, then _sum and
+// _count. Untimed requests are not in the histogram.
+bool sample_http_duration(MetricsChunker& m, const char* name, uint32_t i) {
+    constexpr uint32_t kLines = PORTAL_ROUTE_PROFILE_BUCKETS + 2;
+    const size_t slot = i / kLines;
+    const uint32_t part = i % kLines;
+    if (slot >= portal_profile_route_slots()) return false;
+    const PortalRouteStats* r = m.route_at(slot);
+    if (!r) return m.skip();
+
+    const char* lbl = m.route_labels(*r);
+    if (part < PORTAL_ROUTE_PROFILE_BUCKETS) {
+        uint64_t cumulative = 0;
+        for (uint32_t b = 0; b <= part; b++) cumulative += r->buckets[b];
+        const uint32_t le_ms = portal_profile_bucket_le_ms(part);
+        int n;
+        if (le_ms) {
+            n = snprintf(m.line, sizeof(m.line), "%s_bucket{%s,le=\"%lu.%03lu\"} %llu\n",
+                name, lbl, (unsigned long)(le_ms / 1000), (unsigned long)(le_ms % 1000), (unsigned long long)cumulative);
+        } else {
+            n = snprintf(m.line, sizeof(m.line), "%s_bucket{%s,le=\"+Inf\"} %llu\n",
+                name, lbl, (unsigned long long)cumulative);
+        }
+        m.set_line(n);
+        return true;
+    }
+    if (part == PORTAL_ROUTE_PROFILE_BUCKETS) {
+        const unsigned long long s = r->total_us / 1000000ull;
+        const unsigned long frac = (unsigned long)(r->total_us % 1000000ull);
+        m.set_line(snprintf(m.line, sizeof(m.line), "%s_sum{%s} %llu.%06lu\n", name, lbl, s, frac));
+        return true;
+    }
+    m.set_line(snprintf(m.line, sizeof(m.line), "%s_count{%s} %lu\n", name, lbl, (unsigned long)r->timed));
+    return true;
+}
+
+bool sample_http_bytes_in(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= portal_profile_route_slots()) return false;
+    const PortalRouteStats* r = m.route_at(i);
+    return r ? m.put(name, m.route_labels(*r), r->bytes_in) : m.skip();
+}
+
+bool sample_http_bytes_out(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= portal_profile_route_slots()) return false;
+    const PortalRouteStats* r = m.route_at(i);
+    return r ? m.put(name, m.route_labels(*r), r->bytes_out) : m.skip();
+}
+
+bool sample_http_heap_drop(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i >= portal_profile_route_slots()) return false;
+    const PortalRouteStats* r = m.route_at(i);
+    return r ? m.put(name, m.route_labels(*r), r->heap_drop_max) : m.skip();
+}
+
+bool sample_http_untimed(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0) return false;
+    return m.put(name, nullptr, portal_profile_untimed());
+}
+
+#endif // PORTAL_ROUTE_PROFILE_ENABLED
+
+// ---- Display ---------------------------------------------------------------
+
+#if HAS_DISPLAY
+
+bool sample_display_fps(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.have_display) return false;
+    return m.put(name, nullptr, m.display.fps);
+}
+
+// Per stage: p50, p95, p99 and the max (quantile="1") over the last
+// DISPLAY_PERF_HIST_SAMPLES frames.
+bool sample_display_frame(MetricsChunker& m, const char* name, uint32_t i) {
+    static const char* const kStages[] = {"render", "flush", "present", "te_wait"};
+    static const char* const kQuantiles[] = {"0.5", "0.95", "0.99", "1"};
+    const uint32_t stages = DISPLAY_TE_SYNC_ENABLED ? 4 : 3;
+    if (!m.have_display || i >= stages * 4) return false;
+
+    const DisplayPerfHistogram* h[] = {&m.display.render, &m.display.flush, &m.display.present, &m.display.te_wait};
+    const DisplayPerfHistogram& s = *h[i / 4];
+    const uint32_t v[] = {s.p50_us, s.p95_us, s.p99_us, s.max_us};
+    m.label("stage", kStages[i / 4]);
+    m.label("quantile", kQuantiles[i % 4], true);
+    return m.put_seconds(name, m.labels, v[i % 4]);
+}
+
+bool sample_display_flush_px(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.have_display) return false;
+    return m.put(name, nullptr, m.display.flush_px_per_s);
+}
+
+bool sample_display_te_timeouts(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.have_display || !DISPLAY_TE_SYNC_ENABLED) return false;
+    return m.put(name, nullptr, m.display.te_timeouts);
+}
+
+bool sample_lvgl_arena_size(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.lvgl_heap.arena) return false;
+    return m.put(name, nullptr, m.lvgl_heap.total_bytes);
+}
+
+bool sample_lvgl_arena_used(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.lvgl_heap.arena) return false;
+    return m.put(name, nullptr, m.lvgl_heap.used_bytes);
+}
+
+bool sample_lvgl_arena_peak(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.lvgl_heap.arena) return false;
+    return m.put(name, nullptr, m.lvgl_heap.peak_bytes);
+}
+
+bool sample_lvgl_arena_fragmentation(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.lvgl_heap.arena) return false;
+    return m.put(name, nullptr, m.lvgl_heap.frag_pct);
+}
+
+bool sample_lvgl_arena_overflow(MetricsChunker& m, const char* name, uint32_t i) {
+    if (i > 0 || !m.lvgl_heap.arena) return false;
+    return m.put(name, nullptr, m.lvgl_heap.overflow_allocs);
+}
+
+#endif // HAS_DISPLAY
+
+const MetricFamily kFamilies[] = {
+    {"device_uptime_seconds", "gauge", "Time since boot.", sample_uptime},
+    {"device_heap_free_bytes", "gauge", "Free heap.", sample_heap_free},
+    {"device_heap_min_free_bytes", "gauge", "Lowest free heap since boot.", sample_heap_min_free},
+    {"device_heap_largest_free_block_bytes", "gauge", "Largest free heap block.", sample_heap_largest},
+    {"device_heap_fragmentation_percent", "gauge", "Heap fragmentation (1 - largest block / free).", sample_heap_fragmentation},
+    {"device_cpu_temperature_celsius", "gauge", "CPU temperature sensor.", sample_cpu_temperature},
+    {"device_wifi_connected", "gauge", "1 when WiFi is connected.", sample_wifi_connected},
+    {"device_wifi_rssi_dbm", "gauge", "WiFi signal strength.", sample_wifi_rssi},
+    {"device_log_dropped_total", "counter", "Log lines dropped because the log ring was full.", sample_log_dropped},
+    {"device_cpu_usage_percent", "gauge", "CPU usage over the last sample, all cores.", sample_cpu_usage},
+    {"device_cpu_core_usage_percent", "gauge", "CPU usage over the last sample, per core.", sample_cpu_core_usage},
+    {"device_cpu_task_usage_percent", "gauge", "Busiest tasks over the last sample, percent of one core.", sample_cpu_task_usage},
+#if HEAP_TAGS_ENABLED
+    {"heap_tag_live_bytes", "gauge", "Bytes held per subsystem and heap.", sample_heap_tag_live},
+    {"heap_tag_peak_bytes", "gauge", "Most bytes held at once per subsystem and heap.", sample_heap_tag_peak},
+    {"heap_tag_allocs_total", "counter", "Allocations per subsystem and heap.", sample_heap_tag_allocs},
+    {"heap_tag_failed_total", "counter", "Failed allocations per subsystem and heap.", sample_heap_tag_failed},
+#endif
+    {"loop_scheduler_passes_total", "counter", "Main loop scheduler passes.", sample_loop_passes},
+    {"loop_scheduler_sleep_seconds_total", "counter", "Main loop time spent blocked between passes.", sample_loop_sleep},
+    {"loop_task_runs_total", "counter", "Runs per main loop callback.", sample_loop_task_runs},
+    {"loop_task_run_seconds_total", "counter", "Time spent per main loop callback.", sample_loop_task_seconds},
+    {"loop_task_run_max_seconds", "gauge", "Longest run per main loop callback.", sample_loop_task_max},
+    {"loop_task_late_total", "counter", "Runs started late per main loop callback.", sample_loop_task_late},
+    {"loop_task_overruns_total", "counter", "Runs longer than the requested interval per main loop callback.", sample_loop_task_overruns},
+#if PORTAL_ROUTE_PROFILE_ENABLED
+    {"http_requests_total", "counter", "Requests per route.", sample_http_requests},
+    {"http_request_duration_seconds", "histogram", "First handler call to request teardown, per route.", sample_http_duration},
+    {"http_request_body_bytes_total", "counter", "Request body bytes per route.", sample_http_bytes_in},
+    {"http_response_body_bytes_total", "counter", "Reply body bytes per route, where known.", sample_http_bytes_out},
+    {"http_request_heap_drop_max_bytes", "gauge", "Largest internal heap drop while a request was open, per route.", sample_http_heap_drop},
+    {"http_requests_untimed_total", "counter", "Requests counted but not timed.", sample_http_untimed},
+#endif
+#if HAS_DISPLAY
+    {"display_fps", "gauge", "Rendered frames per second.", sample_display_fps},
+    {"display_frame_seconds", "gauge", "Per-frame stage time quantiles over recent frames.", sample_display_frame},
+    {"display_flush_pixels_per_second", "gauge", "Pixels pushed to the panel per second.", sample_display_flush_px},
+    {"display_te_timeouts_total", "counter", "Tearing-effect waits that timed out.", sample_display_te_timeouts},
+    {"lvgl_arena_size_bytes", "gauge", "LVGL arena size.", sample_lvgl_arena_size},
+    {"lvgl_arena_used_bytes", "gauge", "Bytes allocated in the LVGL arena.", sample_lvgl_arena_used},
+    {"lvgl_arena_peak_bytes", "gauge", "Most bytes allocated in the LVGL arena at once.", sample_lvgl_arena_peak},
+    {"lvgl_arena_fragmentation_percent", "gauge", "LVGL arena fragmentation (1 - largest block / free).", sample_lvgl_arena_fragmentation},
+    {"lvgl_arena_overflow_total", "counter", "LVGL allocations served by the system heap because the arena was full.", sample_lvgl_arena_overflow},
+#endif
+};
+
+bool MetricsChunker::next_piece() {
+    while (family < sizeof(kFamilies) / sizeof(kFamilies[0])) {
+        const MetricFamily& f = kFamilies[family];
+        if (!header_done) {
+            header_done = true;
+            set_line(snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", f.name, f.help, f.name, f.type));
+            return true;
+        }
+        if (f.sample(*this, f.name, i++)) return true;
+        family++;
+        i = 0;
+        header_done = false;
+        route_slot = SIZE_MAX;
+    }
+    return false;
+}
+
+void handleGetMetrics(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+    MetricsChunker* st = new MetricsChunker();
+    if (!st) {
+        request->send(500, "text/plain", "Out of memory\n");
+        return;
+    }
+    send_chunked_state(request, "text/plain; version=0.0.4; charset=utf-8", st);
+}
+
+} // namespace
+
+void web_portal_register_metrics_routes(AsyncWebServer& server) {
+    server.on("/metrics", HTTP_GET, handleGetMetrics);
+}
+
+#else
+
+void web_portal_register_metrics_routes(AsyncWebServer&) {
+}
+
+#endif // PROMETHEUS_METRICS_ENABLED
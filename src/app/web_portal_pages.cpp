@@ -6,8 +6,56 @@
 #include "web_assets.h"
 #include "web_portal_auth.h"
 #include "web_portal_http.h"
+#include "web_portal_profile.h"
 #include "web_portal_state.h"
 
+// Pages revalidate on every navigation (a 304 when the firmware's copy is
+// unchanged). CSS/JS are linked as /portal.css?v=<content hash>, so a request
+// carrying the current hash can be cached for good.
+static const char kPageCacheControl[] = "private, no-cache";
+static const char kImmutableCacheControl[] = "public, max-age=31536000, immutable";
+
+static void send_page(AsyncWebServerRequest* request, const uint8_t* content_gz, size_t content_gz_len, const char* etag) {
+    if (portal_send_not_modified(request, etag, kPageCacheControl)) return;
+    AsyncWebServerResponse* response = begin_gzipped_asset_response(
+        request,
+        "text/html",
+        content_gz,
+        content_gz_len,
+        kPageCacheControl,
+        etag
+    );
+    request->send(response);
+}
+
+static void send_versioned_asset(
+    AsyncWebServerRequest* request,
+    const char* content_type,
+    const uint8_t* content_gz,
+    size_t content_gz_len,
+    const char* version,
+    const char* etag
+) {
+    // Assets skip the auth gate, so profile them here.
+    portal_profile_begin(request);
+
+    // Unversioned or stale ?v= (old cached page): revalidate instead of pinning.
+    const AsyncWebParameter* v = request->getParam("v");
+    const bool pinned = v && v->value() == version;
+    const char* cache_control = pinned ? kImmutableCacheControl : "no-cache";
+
+    if (portal_send_not_modified(request, etag, cache_control)) return;
+    AsyncWebServerResponse* response = begin_gzipped_asset_response(
+        request,
+        content_type,
+        content_gz,
+        content_gz_len,
+        cache_control,
+        etag
+    );
+    request->send(response);
+}
+
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
 extern volatile bool g_portal_pending_http_root;
 extern volatile bool g_portal_pending_http_network;
@@ -22,14 +70,7 @@ static void handleRoot(AsyncWebServerRequest* request) {
     if (web_portal_state().ap_mode_active) {
         request->redirect("/network.html");
     } else {
-        AsyncWebServerResponse* response = begin_gzipped_asset_response(
-            request,
-            "text/html",
-            home_html_gz,
-            home_html_gz_len,
-            "no-store"
-        );
-        request->send(response);
+        send_page(request, home_html_gz, home_html_gz_len, home_html_etag);
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
         if (!g_portal_logged_http_root) {
@@ -45,26 +86,12 @@ static void handleHome(AsyncWebServerRequest* request) {
         request->redirect("/network.html");
         return;
     }
-    AsyncWebServerResponse* response = begin_gzipped_asset_response(
-        request,
-        "text/html",
-        home_html_gz,
-        home_html_gz_len,
-        "no-store"
-    );
-    request->send(response);
+    send_page(request, home_html_gz, home_html_gz_len, home_html_etag);
 }
 
 static void handleNetwork(AsyncWebServerRequest* request) {
     if (!portal_auth_gate(request)) return;
-    AsyncWebServerResponse* response = begin_gzipped_asset_response(
-        request,
-        "text/html",
-        network_html_gz,
-        network_html_gz_len,
-        "no-store"
-    );
-    request->send(response);
+    send_page(request, network_html_gz, network_html_gz_len, network_html_etag);
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
     if (!g_portal_logged_http_network) {
@@ -79,14 +106,7 @@ static void handleFirmware(AsyncWebServerRequest* request) {
         request->redirect("/network.html");
         return;
     }
-    AsyncWebServerResponse* response = begin_gzipped_asset_response(
-        request,
-        "text/html",
-        firmware_html_gz,
-        firmware_html_gz_len,
-        "no-store"
-    );
-    request->send(response);
+    send_page(request, firmware_html_gz, firmware_html_gz_len, firmware_html_etag);
 
 #if MEMORY_SNAPSHOT_ON_HTTP_ENABLED
     if (!g_portal_logged_http_firmware) {
@@ -103,25 +123,11 @@ void web_portal_register_page_routes(AsyncWebServer& server) {
 }
 
 static void handleCSS(AsyncWebServerRequest* request) {
-    AsyncWebServerResponse* response = begin_gzipped_asset_response(
-        request,
-        "text/css",
-        portal_css_gz,
-        portal_css_gz_len,
-        "public, max-age=600"
-    );
-    request->send(response);
+    send_versioned_asset(request, "text/css", portal_css_gz, portal_css_gz_len, portal_css_version, portal_css_etag);
 }
 
 static void handleJS(AsyncWebServerRequest* request) {
-    AsyncWebServerResponse* response = begin_gzipped_asset_response(
-        request,
-        "application/javascript",
-        portal_js_gz,
-        portal_js_gz_len,
-        "public, max-age=600"
-    );
-    request->send(response);
+    send_versioned_asset(request, "application/javascript", portal_js_gz, portal_js_gz_len, portal_js_version, portal_js_etag);
 }
 
 void web_portal_register_asset_routes(AsyncWebServer& server) {
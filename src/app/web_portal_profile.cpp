@@ -0,0 +1,298 @@
+#include "web_portal_profile.h"
+
+#include <ESPAsyncWebServer.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#include "device_telemetry.h"
+#include "json_stream_writer.h"
+#include "web_portal_admission.h"
+#include "web_portal_auth.h"
+
+#if PORTAL_ROUTE_PROFILE_ENABLED
+
+namespace {
+
+// Bucket i holds latencies below kBucketLeMs[i] ms; the last one the rest.
+constexpr uint32_t kBucketLeMs[] = {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+constexpr size_t kBuckets = sizeof(kBucketLeMs) / sizeof(kBucketLeMs[0]) + 1;
+static_assert(kBuckets == PORTAL_ROUTE_PROFILE_BUCKETS, "PortalRouteStats::buckets size");
+
+// Requests open at once (AsyncTCP holds few more sockets than this).
+constexpr size_t kTracks = 16;
+
+struct Route {
+    const char* method;     // string literal; nullptr = unused entry
+    char path[40];
+    uint32_t count;
+    uint32_t timed;
+    uint32_t buckets[kBuckets];
+    uint64_t total_us;
+    uint32_t max_us;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint32_t heap_drop_max;
+};
+
+struct Track {
+    AsyncWebServerRequest* request;
+    Route* route;
+    int64_t start_us;
+    uint32_t start_free;
+    uint32_t min_free;
+};
+
+// The last entry collects whatever does not fit ("*").
+Route g_routes[PORTAL_ROUTE_PROFILE_MAX_ROUTES + 1] = {};
+Track g_tracks[kTracks] = {};
+uint32_t g_untimed = 0;
+int64_t g_since_us = 0;
+
+const char* method_name(AsyncWebServerRequest* request) {
+    const auto method = request->method();
+    if (method == HTTP_GET) return "GET";
+    if (method == HTTP_POST) return "POST";
+    if (method == HTTP_PUT) return "PUT";
+    if (method == HTTP_PATCH) return "PATCH";
+    if (method == HTTP_DELETE) return "DELETE";
+    return "OTHER";
+}
+
+uint32_t internal_free() {
+    return (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+
+Route* find_route(const char* method, const char* path) {
+    const size_t n = PORTAL_ROUTE_PROFILE_MAX_ROUTES;
+    for (size_t i = 0; i < n; i++) {
+        Route& r = g_routes[i];
+        if (!r.method) {
+            r.method = method;
+            strlcpy(r.path, path, sizeof(r.path));
+            return &r;
+        }
+        if (r.method == method && strncmp(r.path, path, sizeof(r.path) - 1) == 0) return &r;
+    }
+    Route& other = g_routes[n];
+    if (!other.method) {
+        other.method = "*";
+        strlcpy(other.path, "*", sizeof(other.path));
+    }
+    return &other;
+}
+
+Track* find_track(AsyncWebServerRequest* request) {
+    for (Track& t : g_tracks) {
+        if (t.request == request) return &t;
+    }
+    return nullptr;
+}
+
+void sample(Track* t) {
+    const uint32_t free_now = internal_free();
+    if (free_now < t->min_free) t->min_free = free_now;
+}
+
+void finish(AsyncWebServerRequest* request) {
+    Track* t = find_track(request);
+    if (!t) return;
+    sample(t);
+
+    const int64_t elapsed = esp_timer_get_time() - t->start_us;
+    const uint32_t us = elapsed > 0 ? (uint32_t)(elapsed < UINT32_MAX ? elapsed : UINT32_MAX) : 0;
+    device_telemetry_note_latency(HealthLatency::HttpRequest, us);
+    const uint32_t ms = us / 1000;
+    size_t bucket = 0;
+    while (bucket < kBuckets - 1 && ms >= kBucketLeMs[bucket]) bucket++;
+
+    Route* r = t->route;
+    t->request = nullptr;
+    t->route = nullptr;
+    if (!r) return;  // table cleared while the request was open
+
+    r->timed++;
+    r->buckets[bucket]++;
+    r->total_us += us;
+    if (us > r->max_us) r->max_us = us;
+    const uint32_t drop = t->start_free > t->min_free ? t->start_free - t->min_free : 0;
+    if (drop > r->heap_drop_max) r->heap_drop_max = drop;
+}
+
+// Upper bucket bound (ms) below which pct percent of the timed requests fall;
+// max_us when that lands in the open-ended bucket.
+uint32_t bucket_percentile_ms(const Route& r, uint32_t pct) {
+    if (r.timed == 0) return 0;
+    const uint32_t rank = (uint32_t)(((uint64_t)r.timed * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (size_t i = 0; i < kBuckets - 1; i++) {
+        seen += r.buckets[i];
+        if (seen >= rank) return kBucketLeMs[i];
+    }
+    return (r.max_us + 999) / 1000;
+}
+
+void write_routes(JsonStreamObject& root) {
+    root["since_ms"] = (uint32_t)((esp_timer_get_time() - g_since_us) / 1000);
+    root["untimed"] = g_untimed;
+
+    JsonStreamArray bounds = root.createNestedArray("bucket_le_ms");
+    for (uint32_t b : kBucketLeMs) bounds.add(b);
+
+    JsonStreamArray routes = root.createNestedArray("routes");
+    for (const Route& r : g_routes) {
+        if (!r.method || r.count == 0) continue;
+        JsonStreamObject o = routes.createNestedObject();
+        o["method"] = r.method;
+        o["path"] = r.path;
+        o["count"] = r.count;
+        o["timed"] = r.timed;
+        o["avg_us"] = r.timed ? (uint32_t)(r.total_us / r.timed) : 0u;
+        o["max_us"] = r.max_us;
+        o["p50_ms"] = bucket_percentile_ms(r, 50);
+        o["p95_ms"] = bucket_percentile_ms(r, 95);
+        o["bytes_in"] = r.bytes_in;
+        o["bytes_out"] = r.bytes_out;
+        o["heap_drop_max"] = r.heap_drop_max;
+        JsonStreamArray buckets = o.createNestedArray("buckets");
+        for (uint32_t n : r.buckets) buckets.add(n);
+    }
+}
+
+void handleGetRoutes(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+    // Diagnostic endpoint: grows a response buffer rather than holding one
+    // of the streamed-JSON slots for a table that can outgrow it.
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    JsonStreamWriter writer(*response);
+    JsonStreamObject root = writer.root();
+    write_routes(root);
+    writer.finish();
+    request->send(response);
+}
+
+void handleDeleteRoutes(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+    // Requests still open are left out of the new table.
+    for (Track& t : g_tracks) {
+        if (t.request) t.route = nullptr;
+    }
+    memset(g_routes, 0, sizeof(g_routes));
+    g_untimed = 0;
+    g_since_us = esp_timer_get_time();
+
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
+} // namespace
+
+void web_portal_register_profile_routes(AsyncWebServer& server) {
+    server.on("/api/routes", HTTP_GET, handleGetRoutes);
+    server.on("/api/routes", HTTP_DELETE, handleDeleteRoutes);
+}
+
+void portal_profile_begin(AsyncWebServerRequest* request) {
+    if (Track* t = find_track(request)) {
+        sample(t);
+        return;
+    }
+
+    const String& url = request->url();
+    if (url == "/api/events" || url == "/api/display/ws" || url == "/api/display/mirror") return;
+
+    const int64_t now = esp_timer_get_time();
+    const uint32_t free_now = internal_free();
+    Route* route = find_route(method_name(request), url.c_str());
+    route->count++;
+    route->bytes_in += request->contentLength();
+
+    Track* slot = nullptr;
+    for (Track& t : g_tracks) {
+        if (!t.request) {
+            slot = &t;
+            break;
+        }
+    }
+    if (!slot) {
+        g_untimed++;
+        return;
+    }
+
+    slot->request = request;
+    slot->route = route;
+    slot->start_us = now;
+    slot->start_free = free_now;
+    slot->min_free = free_now;
+    if (!portal_on_request_end(request, [request]() { finish(request); })) {
+        slot->request = nullptr;
+        slot->route = nullptr;
+        g_untimed++;
+    }
+}
+
+void portal_profile_bytes_out(AsyncWebServerRequest* request, size_t n) {
+    Track* t = find_track(request);
+    if (!t) return;
+    sample(t);
+    if (t->route) t->route->bytes_out += n;
+}
+
+uint32_t portal_profile_bucket_le_ms(size_t i) {
+    return i < kBuckets - 1 ? kBucketLeMs[i] : 0;
+}
+
+size_t portal_profile_route_slots() {
+    return PORTAL_ROUTE_PROFILE_MAX_ROUTES + 1;
+}
+
+bool portal_profile_route_at(size_t i, PortalRouteStats* out) {
+    if (i >= portal_profile_route_slots() || !out) return false;
+    const Route& r = g_routes[i];
+    if (!r.method || r.count == 0) return false;
+    out->method = r.method;
+    strlcpy(out->path, r.path, sizeof(out->path));
+    out->count = r.count;
+    out->timed = r.timed;
+    memcpy(out->buckets, r.buckets, sizeof(out->buckets));
+    out->total_us = r.total_us;
+    out->max_us = r.max_us;
+    out->bytes_in = r.bytes_in;
+    out->bytes_out = r.bytes_out;
+    out->heap_drop_max = r.heap_drop_max;
+    return true;
+}
+
+uint32_t portal_profile_untimed() {
+    return g_untimed;
+}
+
+#else
+
+void web_portal_register_profile_routes(AsyncWebServer&) {
+}
+
+void portal_profile_begin(AsyncWebServerRequest*) {
+}
+
+void portal_profile_bytes_out(AsyncWebServerRequest*, size_t) {
+}
+
+uint32_t portal_profile_bucket_le_ms(size_t) {
+    return 0;
+}
+
+size_t portal_profile_route_slots() {
+    return 0;
+}
+
+bool portal_profile_route_at(size_t, PortalRouteStats*) {
+    return false;
+}
+
+uint32_t portal_profile_untimed() {
+    return 0;
+}
+
+#endif // PORTAL_ROUTE_PROFILE_ENABLED
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_config.h"
+
+class AsyncWebServer;
+struct AsyncWebServerRequest;
+
+// Per-route HTTP profiling (PORTAL_ROUTE_PROFILE_ENABLED).
+// Every handler passes portal_auth_gate(), which starts tracking the request
+// on its first call; the request's end hook closes it. For each method + path
+// this keeps:
+//   count       requests seen (including 401/503 answers)
+//   latency     first handler call to request teardown (reply sent or client
+//               gone), in log2 millisecond buckets, plus mean and max
+//   bytes_in    request bodies (Content-Length)
+//   bytes_out   reply bodies, where the portal's send helpers know the length
+//               (pages, assets, streamed and chunked JSON documents)
+//   heap        largest drop in free internal heap while the request was open,
+//               sampled at each handler call and at teardown; requests that
+//               overlap share the blame
+//
+// GET /api/routes returns the table, DELETE /api/routes clears it
+// (tools/bench_http_endpoint.py --routes, tools/portal_stress_test.py --routes).
+// The long-lived /api/events and /api/display/ws connections are not timed.
+//
+// Everything here runs on the AsyncTCP task; no locking.
+
+void web_portal_register_profile_routes(AsyncWebServer& server);
+
+// Start (first call) or sample (later body chunks) the request's profile.
+void portal_profile_begin(AsyncWebServerRequest* request);
+
+// The reply body is n bytes.
+void portal_profile_bytes_out(AsyncWebServerRequest* request, size_t n);
+
+// Read access to the table for other exporters (/metrics); AsyncTCP task only.
+static constexpr size_t PORTAL_ROUTE_PROFILE_BUCKETS = 12;
+
+struct PortalRouteStats {
+    const char* method;
+    char path[40];
+    uint32_t count;
+    uint32_t timed;
+    uint32_t buckets[PORTAL_ROUTE_PROFILE_BUCKETS];
+    uint64_t total_us;
+    uint32_t max_us;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint32_t heap_drop_max;
+};
+
+// Upper bound (ms) of latency bucket i; 0 for the last, open-ended one.
+uint32_t portal_profile_bucket_le_ms(size_t i);
+
+// Entries in the table, used or not (0 when profiling is off).
+size_t portal_profile_route_slots();
+
+// Copy entry i; false when it has seen no requests.
+bool portal_profile_route_at(size_t i, PortalRouteStats* out);
+
+// Requests counted but not timed (no free tracking slot).
+uint32_t portal_profile_untimed();
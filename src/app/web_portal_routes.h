@@ -12,5 +12,7 @@ void web_portal_register_api_icons_routes(AsyncWebServer& server);
 void web_portal_register_api_firmware_routes(AsyncWebServer& server);
 void web_portal_register_api_display_routes(AsyncWebServer& server);
 void web_portal_register_api_ota_routes(AsyncWebServer& server);
-
-void web_portal_macros_preload();
+void web_portal_register_api_ble_routes(AsyncWebServer& server);
+void web_portal_register_api_batch_routes(AsyncWebServer& server);
+void web_portal_register_trace_routes(AsyncWebServer& server);
+void web_portal_register_metrics_routes(AsyncWebServer& server);
@@ -5,3 +5,9 @@ static WebPortalState g_state;
 WebPortalState& web_portal_state() {
     return g_state;
 }
+
+void web_portal_note_config_changed() {
+    if (g_state.config) {
+        g_state.config_generation = g_state.config_generation + 1;
+    }
+}
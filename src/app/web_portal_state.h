@@ -1,12 +1,15 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 struct DeviceConfig;
 
 struct WebPortalState {
     bool ap_mode_active = false;
     DeviceConfig* config = nullptr;
+    // Bump after changing *config (GET /api/config ETag).
+    volatile uint32_t config_generation = 1;
 
     // OTA (web upload or background update) progress snapshot.
     bool ota_in_progress = false;
@@ -15,3 +18,19 @@ struct WebPortalState {
 };
 
 WebPortalState& web_portal_state();
+
+// Bumps config_generation once a portal config is attached. Call after a
+// change to the in-RAM config that bypasses POST /api/config (brightness).
+void web_portal_note_config_changed();
+
+// Background (GitHub) firmware update, as GET /api/firmware/update/status reports it.
+struct FirmwareUpdateStatus {
+    bool in_progress;
+    uint32_t progress;
+    uint32_t total;
+    uint32_t bytes_per_sec;  // download throughput, 0 when idle
+    char state[16];    // idle|downloading|writing|rebooting|error
+    char error[96];
+};
+
+void web_portal_get_firmware_update_status(FirmwareUpdateStatus* out);
@@ -0,0 +1,242 @@
+#include "web_portal_routes.h"
+
+#include <ESPAsyncWebServer.h>
+
+#include "board_config.h"
+#include "trace.h"
+#include "web_portal_admission.h"
+#include "web_portal_auth.h"
+#include "web_portal_http.h"
+
+#if TRACE_ENABLED
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace {
+
+// Live tasks named in the export; events from tasks gone since keep their id.
+constexpr UBaseType_t kMaxTasks = 24;
+
+const char* const kPhase[] = {"B", "E", "i", "C"};
+
+// GET /api/trace body:
+// {"displayTimeUnit":"ms","otherData":{...},"traceEvents":[
+//   {"name":"process_name","ph":"M","pid":0,"args":{"name":"core 0"}}, ...
+//   {"name":"thread_name","ph":"M","pid":0,"tid":1073...,"args":{"name":"LVGL"}}, ...
+//   {"name":"lvgl.frame","ph":"B","ts":123456,"pid":1,"tid":1073...}, ...
+// ]}
+// pid is the core, tid the task handle, ts microseconds since boot. Event
+// names are literals from the source, so nothing needs escaping.
+struct TraceChunker {
+    const char* cur = nullptr;
+    size_t cur_len = 0;
+    size_t cur_off = 0;
+
+    enum class Phase : uint8_t { Header, Processes, Threads, Events, Footer, Done } phase = Phase::Header;
+
+    int core = 0;
+    uint32_t i = 0;
+    uint32_t count = 0;
+    bool first = true;
+
+    int64_t now_us = 0;
+
+    struct TaskName {
+        uintptr_t handle;
+        char name[configMAX_TASK_NAME_LEN];
+    };
+    TaskName tasks[kMaxTasks];
+    UBaseType_t task_count = 0;
+    UBaseType_t task_i = 0;
+
+    char line[224];
+
+    TraceChunker() {
+        now_us = esp_timer_get_time();
+
+        // TaskStatus_t is large; borrow the heap briefly instead of the stack.
+        TaskStatus_t* st = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * kMaxTasks);
+        if (st) {
+            const UBaseType_t n = uxTaskGetSystemState(st, kMaxTasks, nullptr);
+            for (UBaseType_t k = 0; k < n; k++) {
+                tasks[k].handle = (uintptr_t)st[k].xHandle;
+                strlcpy(tasks[k].name, st[k].pcTaskName ? st[k].pcTaskName : "?", sizeof(tasks[k].name));
+            }
+            task_count = n;
+            free(st);
+        }
+    }
+
+    void set_line(int n) {
+        cur = line;
+        cur_len = (n > 0 && (size_t)n < sizeof(line)) ? (size_t)n : 0;
+        cur_off = 0;
+    }
+
+    const char* sep() {
+        const char* s = first ? "" : ",";
+        first = false;
+        return s;
+    }
+
+    // Ring timestamps are the low 32 bits of the boot clock; rebuild the rest
+    // from the time of the request (valid for events up to ~71 minutes old).
+    uint64_t unwrap(uint32_t ts) const {
+        const uint32_t age = (uint32_t)now_us - ts;
+        return (uint64_t)now_us - age;
+    }
+
+    bool next_piece() {
+        while (true) {
+            switch (phase) {
+                case Phase::Header: {
+                    uint32_t held = 0;
+                    uint32_t dropped = 0;
+                    for (int c = 0; c < trace_core_count(); c++) {
+                        held += trace_event_count(c);
+                        dropped += trace_dropped(c);
+                    }
+                    set_line(snprintf(line, sizeof(line),
+                        "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"events\":%lu,\"overwritten\":%lu,\"ring_events\":%u},\"traceEvents\":[",
+                        (unsigned long)held, (unsigned long)dropped, (unsigned)TRACE_RING_EVENTS));
+                    phase = Phase::Processes;
+                    core = 0;
+                    return true;
+                }
+
+                case Phase::Processes:
+                    if (core < trace_core_count()) {
+                        set_line(snprintf(line, sizeof(line),
+                            "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"core %d\"}}",
+                            sep(), core, core));
+                        core++;
+                        return true;
+                    }
+                    phase = Phase::Threads;
+                    core = 0;
+                    task_i = 0;
+                    continue;
+
+                case Phase::Threads:
+                    // A task may run on either core, so name it under both.
+                    while (core < trace_core_count() && task_i >= task_count) {
+                        task_i = 0;
+                        core++;
+                    }
+                    if (core < trace_core_count()) {
+                        const TaskName& t = tasks[task_i++];
+                        set_line(snprintf(line, sizeof(line),
+                            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                            sep(), core, (unsigned long)t.handle, t.name));
+                        return true;
+                    }
+                    phase = Phase::Events;
+                    core = 0;
+                    i = 0;
+                    count = trace_event_count(0);
+                    continue;
+
+                case Phase::Events: {
+                    if (i >= count) {
+                        core++;
+                        if (core >= trace_core_count()) {
+                            phase = Phase::Footer;
+                            continue;
+                        }
+                        i = 0;
+                        count = trace_event_count(core);
+                        continue;
+                    }
+                    TraceEvent e;
+                    if (!trace_event_at(core, i++, &e)) continue;
+
+                    const uint8_t type = (uint8_t)(e.task & 3u);
+                    const unsigned long tid = (unsigned long)(e.task & ~(uintptr_t)3u);
+                    const unsigned long long ts = (unsigned long long)unwrap(e.ts_us);
+                    int n;
+                    if (type == (uint8_t)TraceType::Counter) {
+                        n = snprintf(line, sizeof(line),
+                            "%s{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%llu,\"pid\":%d,\"tid\":%lu,\"args\":{\"value\":%ld}}",
+                            sep(), e.name, ts, core, tid, (long)e.value);
+                    } else if (type == (uint8_t)TraceType::Instant) {
+                        n = snprintf(line, sizeof(line),
+                            "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":%d,\"tid\":%lu}",
+                            sep(), e.name, ts, core, tid);
+                    } else {
+                        n = snprintf(line, sizeof(line),
+                            "%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%llu,\"pid\":%d,\"tid\":%lu}",
+                            sep(), e.name, kPhase[type], ts, core, tid);
+                    }
+                    set_line(n);
+                    return true;
+                }
+
+                case Phase::Footer:
+                    cur = "]}";
+                    cur_len = 2;
+                    cur_off = 0;
+                    phase = Phase::Done;
+                    return true;
+
+                case Phase::Done:
+                default:
+                    return false;
+            }
+        }
+    }
+
+    size_t fill(uint8_t* buffer, size_t maxLen) {
+        size_t wrote = 0;
+        while (wrote < maxLen) {
+            if (!cur || cur_off >= cur_len) {
+                if (!next_piece()) break;
+            }
+            // An empty piece (a line too long for the buffer) is skipped.
+            const size_t n = chunk_copy_out(buffer + wrote, maxLen - wrote, cur, cur_len, cur_off);
+            if (n == 0) continue;
+            wrote += n;
+        }
+        return wrote;
+    }
+};
+
+void handleGetTrace(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+
+    TraceChunker* st = new TraceChunker();
+    if (!st) {
+        request->send(500, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
+        return;
+    }
+
+    // Hold recording until the reply is done (or the client gone) so the
+    // rings don't move under the export, and the export doesn't trace itself.
+    trace_pause();
+    if (!portal_on_request_end(request, []() { trace_resume(); })) {
+        trace_resume();
+    }
+
+    send_chunked_state(request, "application/json", st);
+}
+
+void handleDeleteTrace(AsyncWebServerRequest* request) {
+    if (!portal_auth_gate(request)) return;
+    trace_clear();
+    request->send(200, "application/json", "{\"success\":true}");
+}
+
+} // namespace
+
+void web_portal_register_trace_routes(AsyncWebServer& server) {
+    server.on("/api/trace", HTTP_GET, handleGetTrace);
+    server.on("/api/trace", HTTP_DELETE, handleDeleteTrace);
+}
+
+#else
+
+void web_portal_register_trace_routes(AsyncWebServer&) {
+}
+
+#endif // TRACE_ENABLED
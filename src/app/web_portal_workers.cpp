@@ -0,0 +1,317 @@
+#include "web_portal_workers.h"
+
+#include <ESPAsyncWebServer.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/portmacro.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#include "log_manager.h"
+#include "task_placement.h"
+#include "web_portal_admission.h"
+#include "web_portal_body.h"
+
+#if PORTAL_WORKERS_ENABLED && (PORTAL_WORKER_COUNT < 1 || PORTAL_WORKER_COUNT > 2)
+#error "PORTAL_WORKER_COUNT must be 1 or 2"
+#endif
+
+namespace {
+
+const char* const kRouteNames[] = {"macros", "icons"};
+static_assert(sizeof(kRouteNames) / sizeof(kRouteNames[0]) == (size_t)PortalWorkRoute::Count, "route names");
+
+const int8_t kRouteWorker[] = {PORTAL_WORKER_ROUTE_MACROS, PORTAL_WORKER_ROUTE_ICONS};
+static_assert(sizeof(kRouteWorker) / sizeof(kRouteWorker[0]) == (size_t)PortalWorkRoute::Count, "route workers");
+
+PortalWorkRouteStats g_route_stats[(size_t)PortalWorkRoute::Count] = {};
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void send_reply(AsyncWebServerRequest* request, const PortalWorkReply& reply) {
+    AsyncWebServerResponse* response = request->beginResponse(reply.code, "application/json", reply.body);
+    if (reply.code == 503) response->addHeader("Retry-After", String((unsigned)PORTAL_ADMISSION_RETRY_AFTER_S));
+    request->send(response);
+}
+
+void run_inline(AsyncWebServerRequest* request, PortalWorkRoute route, PortalWorkFn fn, const uint8_t* body, size_t len, const void* arg) {
+    portENTER_CRITICAL(&g_mux);
+    g_route_stats[(size_t)route].inline_runs++;
+    portEXIT_CRITICAL(&g_mux);
+
+    PortalWorkReply reply;
+    portal_work_reply(&reply, 500, "{\"success\":false,\"message\":\"No reply\"}");
+    fn(body, len, arg, &reply);
+    portal_body_release(request);
+    send_reply(request, reply);
+}
+
+#if PORTAL_WORKERS_ENABLED
+
+constexpr size_t kJobs = PORTAL_WORKER_COUNT * (PORTAL_WORKER_QUEUE_DEPTH + 1);
+
+struct Job {
+    bool used;
+    AsyncWebServerRequest* request;   // nullptr once the client is gone
+    PortalWorkRoute route;
+    PortalWorkFn fn;
+    const uint8_t* body;              // detached lease
+    size_t len;
+    uint8_t arg[kPortalWorkArgBytes];
+    uint32_t queued_ms;
+};
+
+struct Worker {
+    QueueHandle_t queue;              // Job indexes
+    TaskHandle_t task;
+    PortalWorkerStats stats;
+};
+
+const int8_t kWorkerCore[] = {PORTAL_WORKER_0_CORE, PORTAL_WORKER_1_CORE};
+
+Job g_jobs[kJobs] = {};
+Worker g_workers[PORTAL_WORKER_COUNT] = {};
+
+// Held while a reply goes out and while a request end clears its job, so the
+// library never frees a request a worker is answering.
+SemaphoreHandle_t g_reply_lock = nullptr;
+
+int8_t route_worker(PortalWorkRoute route) {
+    const int8_t w = kRouteWorker[(size_t)route];
+    if (w < 0) return -1;
+    return w < PORTAL_WORKER_COUNT ? w : PORTAL_WORKER_COUNT - 1;
+}
+
+int alloc_job() {
+    int idx = -1;
+    portENTER_CRITICAL(&g_mux);
+    for (size_t i = 0; i < kJobs; i++) {
+        if (!g_jobs[i].used) {
+            g_jobs[i].used = true;
+            idx = (int)i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&g_mux);
+    return idx;
+}
+
+void free_job(Job& job) {
+    portENTER_CRITICAL(&g_mux);
+    job = Job{};
+    portEXIT_CRITICAL(&g_mux);
+}
+
+// Request end hook (AsyncTCP task): the reply has nowhere to go.
+void forget_request(Job* job, AsyncWebServerRequest* request) {
+    xSemaphoreTake(g_reply_lock, portMAX_DELAY);
+    if (job->used && job->request == request) job->request = nullptr;
+    xSemaphoreGive(g_reply_lock);
+}
+
+void worker_task(void* arg) {
+    Worker& w = g_workers[(uintptr_t)arg];
+    for (;;) {
+        uint8_t idx = 0;
+        if (xQueueReceive(w.queue, &idx, portMAX_DELAY) != pdTRUE) continue;
+        Job& job = g_jobs[idx];
+
+        const uint32_t start = millis();
+        PortalWorkReply reply;
+        portal_work_reply(&reply, 500, "{\"success\":false,\"message\":\"No reply\"}");
+        job.fn(job.body, job.len, job.arg, &reply);
+        portal_body_release_detached(job.body);
+        const uint32_t end = millis();
+
+        // A paused request is answered from here: AsyncTCP hands the write to
+        // the lwIP thread, and the lock keeps the request alive until it is out.
+        xSemaphoreTake(g_reply_lock, portMAX_DELAY);
+        AsyncWebServerRequest* request = job.request;
+        job.request = nullptr;
+        if (request) send_reply(request, reply);
+        xSemaphoreGive(g_reply_lock);
+
+        portENTER_CRITICAL(&g_mux);
+        PortalWorkerStats& st = w.stats;
+        st.queued--;
+        st.jobs++;
+        if (!request) st.orphaned++;
+        st.busy_ms += end - start;
+        if (end - start > st.max_run_ms) st.max_run_ms = end - start;
+        if (start - job.queued_ms > st.max_wait_ms) st.max_wait_ms = start - job.queued_ms;
+        portEXIT_CRITICAL(&g_mux);
+
+        free_job(job);
+    }
+}
+
+// Body as a detached lease; a single chunk still in place is copied first.
+const uint8_t* take_body(AsyncWebServerRequest* request, PortalWorkRoute route, const uint8_t* body, size_t len) {
+    uint8_t* leased = portal_body_leased(request);
+    if (!leased || leased != body) {
+        leased = portal_body_lease(request, kRouteNames[(size_t)route], len ? len : 1);
+        if (!leased) return nullptr;
+        if (len) memcpy(leased, body, len);
+    }
+    return portal_body_detach(request);
+}
+
+#endif // PORTAL_WORKERS_ENABLED
+
+} // namespace
+
+const char* portal_work_route_name(PortalWorkRoute route) {
+    return (size_t)route < (size_t)PortalWorkRoute::Count ? kRouteNames[(size_t)route] : "?";
+}
+
+void portal_work_reply(PortalWorkReply* reply, int code, const char* json) {
+    reply->code = code;
+    strlcpy(reply->body, json, sizeof(reply->body));
+}
+
+void portal_work_reply_error(PortalWorkReply* reply, int code, const char* message) {
+    // Parser messages can quote keys from the request: escape them.
+    char* body = reply->body;
+    const size_t cap = sizeof(reply->body);
+    size_t n = strlcpy(body, "{\"success\":false,\"message\":\"", cap);
+    for (const char* p = message; *p && n + 8 < cap; p++) {
+        const unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\') {
+            body[n++] = '\\';
+            body[n++] = (char)c;
+        } else if (c >= 0x20) {
+            body[n++] = (char)c;
+        }
+    }
+    body[n] = '\0';
+    strlcat(body, "\"}", cap);
+    reply->code = code;
+}
+
+void portal_workers_init() {
+#if PORTAL_WORKERS_ENABLED
+    if (g_reply_lock) return;
+    g_reply_lock = xSemaphoreCreateMutex();
+    for (size_t r = 0; r < (size_t)PortalWorkRoute::Count; r++) g_route_stats[r].worker = route_worker((PortalWorkRoute)r);
+
+    for (uintptr_t i = 0; i < PORTAL_WORKER_COUNT; i++) {
+        Worker& w = g_workers[i];
+        w.stats.core = kWorkerCore[i];
+        w.queue = xQueueCreate(PORTAL_WORKER_QUEUE_DEPTH, sizeof(uint8_t));
+        char name[configMAX_TASK_NAME_LEN];
+        snprintf(name, sizeof(name), "PortalW%u", (unsigned)i);
+        if (!w.queue || task_placement_create(worker_task, name, PORTAL_WORKER_STACK_BYTES, (void*)i,
+                                              PORTAL_WORKER_PRIORITY, &w.task, kWorkerCore[i]) != pdPASS) {
+            Logger.logMessagef("Portal", "ERROR: worker %u not started; its routes run inline", (unsigned)i);
+            w.task = nullptr;
+        }
+    }
+    Logger.logMessagef("Portal", "%u workers, queue %u", (unsigned)PORTAL_WORKER_COUNT, (unsigned)PORTAL_WORKER_QUEUE_DEPTH);
+#else
+    for (size_t r = 0; r < (size_t)PortalWorkRoute::Count; r++) g_route_stats[r].worker = -1;
+#endif
+}
+
+void portal_worker_run(
+    AsyncWebServerRequest* request,
+    PortalWorkRoute route,
+    PortalWorkFn fn,
+    const uint8_t* body,
+    size_t len,
+    const void* arg,
+    size_t arg_len
+) {
+    if (arg_len > kPortalWorkArgBytes) arg_len = kPortalWorkArgBytes;
+
+#if PORTAL_WORKERS_ENABLED
+    const int8_t wi = route_worker(route);
+    if (wi < 0 || !g_workers[wi].task) {
+        run_inline(request, route, fn, body, len, arg);
+        return;
+    }
+    Worker& w = g_workers[wi];
+
+    PortalWorkReply busy;
+    portal_work_reply(&busy, 503, "{\"success\":false,\"message\":\"Device busy, retry later\"}");
+
+    const int idx = alloc_job();
+    const uint8_t* job_body = idx >= 0 ? take_body(request, route, body, len) : nullptr;
+    if (!job_body) {
+        if (idx >= 0) free_job(g_jobs[idx]);
+        portal_body_release(request);
+        send_reply(request, busy);
+        return;
+    }
+
+    Job& job = g_jobs[idx];
+    job.request = request;
+    job.route = route;
+    job.fn = fn;
+    job.body = job_body;
+    job.len = len;
+    if (arg_len) memcpy(job.arg, arg, arg_len);
+    job.queued_ms = millis();
+
+    Job* jp = &job;
+    if (!portal_on_request_end(request, [jp, request]() { forget_request(jp, request); })) {
+        portal_body_release_detached(job_body);
+        free_job(job);
+        send_reply(request, busy);
+        return;
+    }
+
+    // Paused before the job can finish: the handler returns without a reply
+    // and the worker sends it.
+    request->pause();
+    portENTER_CRITICAL(&g_mux);
+    if (++w.stats.queued > w.stats.queued_peak) w.stats.queued_peak = w.stats.queued;
+    portEXIT_CRITICAL(&g_mux);
+
+    const uint8_t qi = (uint8_t)idx;
+    if (xQueueSend(w.queue, &qi, 0) != pdTRUE) {
+        xSemaphoreTake(g_reply_lock, portMAX_DELAY);
+        job.request = nullptr;
+        xSemaphoreGive(g_reply_lock);
+        portal_body_release_detached(job_body);
+        free_job(job);
+        portENTER_CRITICAL(&g_mux);
+        w.stats.queued--;
+        w.stats.rejected++;
+        portEXIT_CRITICAL(&g_mux);
+        send_reply(request, busy);
+        return;
+    }
+
+    portENTER_CRITICAL(&g_mux);
+    g_route_stats[(size_t)route].dispatched++;
+    portEXIT_CRITICAL(&g_mux);
+#else
+    (void)arg_len;
+    run_inline(request, route, fn, body, len, arg);
+#endif
+}
+
+size_t portal_workers_get_stats(PortalWorkerStats* out, size_t max) {
+    if (!out) return 0;
+    size_t n = 0;
+#if PORTAL_WORKERS_ENABLED
+    portENTER_CRITICAL(&g_mux);
+    for (size_t i = 0; i < PORTAL_WORKER_COUNT && n < max; i++) {
+        if (!g_workers[i].task) continue;
+        out[n++] = g_workers[i].stats;
+    }
+    portEXIT_CRITICAL(&g_mux);
+#else
+    (void)max;
+#endif
+    return n;
+}
+
+void portal_work_route_get_stats(PortalWorkRoute route, PortalWorkRouteStats* out) {
+    if (!out) return;
+    *out = PortalWorkRouteStats{};
+    if ((size_t)route >= (size_t)PortalWorkRoute::Count) return;
+    portENTER_CRITICAL(&g_mux);
+    *out = g_route_stats[(size_t)route];
+    portEXIT_CRITICAL(&g_mux);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board_config.h"
+
+struct AsyncWebServerRequest;
+
+// Portal workers (PORTAL_WORKERS_ENABLED).
+// AsyncTCP runs every AsyncWebServer callback on one task, so a handler that
+// writes flash holds up every other client, /api/health probes included.
+// Routes listed in PortalWorkRoute hand their last step (validate, save,
+// apply) to one of PORTAL_WORKER_COUNT tasks pinned by board config. The
+// handler still collects the body on AsyncTCP, then pauses the request; the
+// worker answers it when the job is done. All other routes answer inline, and
+// a route assigned no worker (-1) or a build without workers runs the same
+// job inline.
+//
+// The job never touches the request: it gets the body and writes its reply
+// into a PortalWorkReply. A client that leaves meanwhile only loses the reply;
+// the job runs to the end, so a save is never cut short. Jobs of one route
+// run on one worker in arrival order, which keeps the single-writer rules of
+// the inline handlers.
+
+enum class PortalWorkRoute : uint8_t {
+    Macros = 0,   // POST /api/macros, PATCH /api/macros/screens/... (PORTAL_WORKER_ROUTE_MACROS)
+    Icons,        // POST /api/icons/install (PORTAL_WORKER_ROUTE_ICONS)
+    Count,
+};
+
+const char* portal_work_route_name(PortalWorkRoute route);
+
+struct PortalWorkReply {
+    int code;
+    char body[256];   // application/json
+};
+
+// reply = code + json (truncated to fit).
+void portal_work_reply(PortalWorkReply* reply, int code, const char* json);
+
+// reply = code + {"success":false,"message":"..."}, message escaped.
+void portal_work_reply_error(PortalWorkReply* reply, int code, const char* message);
+
+// Runs on a worker (or inline). arg is the copy made by portal_worker_run().
+typedef void (*PortalWorkFn)(const uint8_t* body, size_t len, const void* arg, PortalWorkReply* reply);
+
+// Most bytes of arg copied with a job.
+constexpr size_t kPortalWorkArgBytes = 48;
+
+// Start the worker tasks. Call once before the routes are registered.
+void portal_workers_init();
+
+// Run fn for request on its route's worker, or inline, and answer the request
+// with the reply: 503 + Retry-After instead when the worker's queue is full.
+// body/len is the collected body: the request's lease (web_portal_body.h) or
+// a single chunk still in place, which is copied into a lease. The body
+// belongs to the job from here and is released after it. Call from the body
+// handler that completed it, on the AsyncTCP task.
+void portal_worker_run(
+    AsyncWebServerRequest* request,
+    PortalWorkRoute route,
+    PortalWorkFn fn,
+    const uint8_t* body,
+    size_t len,
+    const void* arg,
+    size_t arg_len
+);
+
+struct PortalWorkerStats {
+    int8_t core;            // configured; -1 = either core
+    uint8_t queued;         // waiting now
+    uint8_t queued_peak;
+    uint32_t jobs;          // run to the end
+    uint32_t rejected;      // queue full: 503
+    uint32_t orphaned;      // client gone before the reply
+    uint32_t busy_ms;       // total time spent running jobs
+    uint32_t max_run_ms;
+    uint32_t max_wait_ms;   // longest time a job waited in the queue
+};
+
+// Fills out for each worker task; returns the count (0 when workers are off).
+size_t portal_workers_get_stats(PortalWorkerStats* out, size_t max);
+
+struct PortalWorkRouteStats {
+    int8_t worker;          // -1 = inline
+    uint32_t dispatched;    // jobs queued to the worker
+    uint32_t inline_runs;   // jobs run on AsyncTCP
+};
+
+void portal_work_route_get_stats(PortalWorkRoute route, PortalWorkRouteStats* out);
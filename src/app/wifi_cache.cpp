@@ -0,0 +1,130 @@
+#include "wifi_cache.h"
+
+#include "fnv1a.h"
+#include "log_manager.h"
+
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+
+namespace {
+
+constexpr const char* kNamespace = "wifi_fast";
+constexpr uint8_t kVersion = 1;
+
+struct Stored {
+    uint8_t version;
+    uint32_t key;          // hash of SSID and password
+    WifiCacheEntry entry;
+};
+
+portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+WifiConnectStats g_stats = {};
+
+// Only touched by the task running connect_wifi() (the boot WiFi task, then
+// the loop task). Loaded from NVS once; the copy saves a flash read per reconnect and lets
+// store() skip writes that would not change anything.
+bool g_loaded = false;
+bool g_valid = false;
+Stored g_stored = {};
+
+uint32_t credentials_key(const char* ssid, const char* password) {
+    // FNV-1a over "ssid\0password".
+    if (!ssid) ssid = "";
+    const uint32_t h = fnv1a32(ssid, strlen(ssid) + 1);
+    return fnv1a32_str(password ? password : "", h);
+}
+
+void load_once() {
+    if (g_loaded) return;
+    g_loaded = true;
+
+    Preferences prefs;
+    if (!prefs.begin(kNamespace, true)) return;
+    if (prefs.getBytesLength("ap") == sizeof(g_stored)) {
+        prefs.getBytes("ap", &g_stored, sizeof(g_stored));
+        g_valid = g_stored.version == kVersion && g_stored.entry.channel != 0;
+    }
+    prefs.end();
+}
+
+} // namespace
+
+bool wifi_cache_load(const char* ssid, const char* password, WifiCacheEntry* out) {
+#if WIFI_FAST_CONNECT
+    load_once();
+    if (!g_valid || g_stored.key != credentials_key(ssid, password)) return false;
+    if (out) *out = g_stored.entry;
+    return true;
+#else
+    (void)ssid;
+    (void)password;
+    (void)out;
+    return false;
+#endif
+}
+
+void wifi_cache_store(const char* ssid, const char* password, const WifiCacheEntry& entry) {
+#if WIFI_FAST_CONNECT
+    load_once();
+    Stored next;
+    memset(&next, 0, sizeof(next));   // padding takes part in the memcmp below
+    next.version = kVersion;
+    next.key = credentials_key(ssid, password);
+    next.entry = entry;
+    if (g_valid && memcmp(&next, &g_stored, sizeof(next)) == 0) return;
+
+    Preferences prefs;
+    if (!prefs.begin(kNamespace, false)) return;
+    const bool ok = prefs.putBytes("ap", &next, sizeof(next)) == sizeof(next);
+    prefs.end();
+    if (!ok) return;
+
+    g_stored = next;
+    g_valid = true;
+    Logger.logMessagef("WiFi", "Cached AP %02X:%02X:%02X:%02X:%02X:%02X ch %u",
+        entry.bssid[0], entry.bssid[1], entry.bssid[2], entry.bssid[3], entry.bssid[4], entry.bssid[5],
+        (unsigned)entry.channel);
+#else
+    (void)ssid;
+    (void)password;
+    (void)entry;
+#endif
+}
+
+void wifi_cache_clear() {
+#if WIFI_FAST_CONNECT
+    load_once();
+    if (!g_valid) return;
+    g_valid = false;
+    Preferences prefs;
+    if (!prefs.begin(kNamespace, false)) return;
+    prefs.remove("ap");
+    prefs.end();
+#endif
+}
+
+void wifi_cache_note_connect(bool fast, bool ok, uint32_t duration_ms) {
+    portENTER_CRITICAL(&g_mux);
+    if (!ok) {
+        g_stats.failures++;
+    } else {
+        if (fast) g_stats.fast_connects++;
+        else g_stats.full_connects++;
+        g_stats.last_connect_ms = duration_ms;
+    }
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void wifi_cache_note_fast_miss() {
+    portENTER_CRITICAL(&g_mux);
+    g_stats.fast_misses++;
+    portEXIT_CRITICAL(&g_mux);
+}
+
+void wifi_cache_get_stats(WifiConnectStats* out) {
+    if (!out) return;
+    portENTER_CRITICAL(&g_mux);
+    *out = g_stats;
+    portEXIT_CRITICAL(&g_mux);
+}
@@ -0,0 +1,50 @@
+#ifndef WIFI_CACHE_H
+#define WIFI_CACHE_H
+
+#include "board_config.h"
+
+// WiFi Fast Connect (WIFI_FAST_CONNECT)
+// The AP (BSSID + channel) and address of the last successful connection are
+// kept in NVS, keyed by a hash of the SSID and password. connect_wifi() first
+// tries a directed connect to that AP, which skips the radio reset and the
+// scan; when it does not get an IP within WIFI_FAST_CONNECT_TIMEOUT_MS the
+// entry is dropped and the full scan-and-connect path runs. NVS is only
+// written when the AP or address changes.
+//
+// With WIFI_FAST_REUSE_LEASE the cached address is applied as a static config
+// on the fast path, which also skips DHCP. Only use it with a DHCP
+// reservation: nothing renews the lease.
+
+#include <Arduino.h>
+
+struct WifiCacheEntry {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;          // network byte order, as IPAddress stores it
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+struct WifiConnectStats {
+    uint32_t fast_connects;   // directed connects that got an IP
+    uint32_t fast_misses;     // directed connects that fell back to a scan
+    uint32_t full_connects;   // scan-and-connect successes
+    uint32_t failures;        // connect_wifi() calls that gave up
+    uint32_t last_connect_ms; // duration of the last successful connect_wifi()
+};
+
+// Entry for these credentials; false when there is none (or it is for others).
+bool wifi_cache_load(const char* ssid, const char* password, WifiCacheEntry* out);
+
+// Remember the AP the station is connected to now.
+void wifi_cache_store(const char* ssid, const char* password, const WifiCacheEntry& entry);
+
+void wifi_cache_clear();
+
+// fast: which path connected; ok=false records a failure.
+void wifi_cache_note_connect(bool fast, bool ok, uint32_t duration_ms);
+void wifi_cache_note_fast_miss();
+void wifi_cache_get_stats(WifiConnectStats* out);
+
+#endif // WIFI_CACHE_H
@@ -75,6 +75,16 @@
 // Color Order
 // Panel uses BGR byte order.
 #define DISPLAY_COLOR_ORDER_BGR true  // BGR color order (not RGB)
+// Render LVGL in big-endian RGB565 so TFT_eSPI pushColors() needs no swap.
+#define LVGL_COLOR_16_SWAP true
+
+// DMA Flush
+// Send LVGL bands with TFT_eSPI DMA while the next band renders.
+#define TFT_ESPI_DMA_ENABLED true
+// Second draw buffer for the DMA overlap (2 x 6.4 KB internal RAM, no PSRAM).
+#define LVGL_DOUBLE_BUFFER true
+// Draw buffers must be DMA-capable internal RAM.
+#define LVGL_BUFFER_PREFER_INTERNAL true
 
 // Backlight Control
 // Enable backlight control on this board.
@@ -145,6 +155,12 @@
 // #define HAS_LDR true
 // #define LDR_PIN 34
 
+// ============================================================================
+// Macro Screens
+// ============================================================================
+// No PSRAM: keep only the active macro screen and the last one built.
+#define MACROPAD_MAX_BUILT_SCREENS 2
+
 // ============================================================================
 // Image API Configuration
 // ============================================================================
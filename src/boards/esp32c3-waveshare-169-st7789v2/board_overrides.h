@@ -92,6 +92,12 @@
 // 20 lines × 240 pixels × 2 bytes = 9.6KB per buffer (double buffered = 19.2KB total)
 // LVGL draw buffer size in pixels.
 #define LVGL_BUFFER_SIZE (DISPLAY_WIDTH * 20)
+// Render LVGL in the panel's big-endian RGB565 order (skips the in-place swap/unswap passes).
+#define LVGL_COLOR_16_SWAP true
+// Double-buffer LVGL so the next band renders while the driver's queued SPI DMA sends this one.
+#define LVGL_DOUBLE_BUFFER true
+// Draw buffers are the SPI DMA source as-is; keep them in DMA-capable internal RAM.
+#define LVGL_BUFFER_PREFER_INTERNAL true
 
 // ============================================================================
 // Example: Additional Board-Specific Hardware
@@ -44,6 +44,9 @@
 // LVGL draw buffer size in pixels.
 #define LVGL_BUFFER_SIZE (DISPLAY_WIDTH * 80)
 
+// Keep the neighbouring macro screens pre-built so nav-next/prev only loads them.
+#define MACROPAD_PREWARM_NEIGHBORS 1
+
 // QSPI pins (from sample/esp_bsp.h)
 // QSPI host peripheral.
 #define LCD_QSPI_HOST SPI2_HOST
@@ -65,6 +68,8 @@
 // Optional tear effect pin (from sample)
 // Panel TE pin.
 #define LCD_QSPI_TE   38
+// Present the canvas on the TE edge (avoids tearing on full-screen updates).
+#define DISPLAY_TE_SYNC_ENABLED true
 
 // Backlight
 // Enable backlight control on this board.
@@ -114,4 +119,7 @@
 // Max JPEG bytes accepted for full image uploads.
 #define IMAGE_API_MAX_SIZE_BYTES (300 * 1024)
 
+// ESP32-S3 with PSRAM: JPEGDEC's SIMD decoder for full-rate decodes (TJpgDec stays as fallback).
+#define JPEG_DECODER JPEG_DECODER_JPEGDEC
+
 #endif // BOARD_OVERRIDES_JC3248W535_H
@@ -50,6 +50,9 @@
 // Max JPEG bytes accepted for full image uploads.
 #define IMAGE_API_MAX_SIZE_BYTES (300 * 1024)
 
+// ESP32-S3 with PSRAM: JPEGDEC's SIMD decoder for full-rate decodes (TJpgDec stays as fallback).
+#define JPEG_DECODER JPEG_DECODER_JPEGDEC
+
 // ---------------------------------------------------------------------------
 // Driver Selection (HAL)
 // ---------------------------------------------------------------------------
@@ -68,8 +71,11 @@
 // UI rotation (LVGL).
 #define DISPLAY_ROTATION 0
 
-// Prefer PSRAM first for LVGL draw buffer (fallback handled in DisplayManager).
-#define LVGL_BUFFER_PREFER_INTERNAL false
+// Prefer internal RAM for the LVGL draw buffers: with LVGL_COLOR_16_SWAP they are
+// handed to QSPI DMA as-is (no swap buffer), and PSRAM is not a reliable DMA source here.
+#define LVGL_BUFFER_PREFER_INTERNAL true
+// Render LVGL in the ST77916's big-endian RGB565 order (no per-flush swap pass).
+#define LVGL_COLOR_16_SWAP true
 // Prefer PSRAM first for the ESP_Panel ST77916 swap buffer (fallbacks exist).
 // NOTE: The swap buffer is used as the source for QSPI flush DMA operations.
 // PSRAM-backed buffers are not reliably DMA-accessible across cores/IDF versions
@@ -78,6 +84,10 @@
 #define ESP_PANEL_SWAPBUF_PREFER_INTERNAL true
 // LVGL draw buffer size in pixels.
 #define LVGL_BUFFER_SIZE (DISPLAY_WIDTH * 16)  // 16 rows (matches sample default)
+// Keep the neighbouring macro screens pre-built so nav-next/prev only loads them.
+#define MACROPAD_PREWARM_NEIGHBORS 1
+// Double-buffer LVGL so band N+1 renders while band N is sent over QSPI DMA.
+#define LVGL_DOUBLE_BUFFER true
 
 // ---------------------------------------------------------------------------
 // Backlight (LEDC)
@@ -103,6 +113,9 @@
 // QSPI data line 3 pin.
 #define TFT_SDA3 14
 
+// TE sync: define the panel TE GPIO (TFT_TE) and DISPLAY_TE_SYNC_ENABLED true to enable.
+// Left off until the TE line routing is confirmed on this module.
+
 // QSPI clock (matches sample)
 // QSPI clock frequency (Hz).
 #define TFT_SPI_FREQ_HZ (50 * 1000 * 1000)
@@ -4,10 +4,13 @@
 Examples:
   python3 tools/bench_http_endpoint.py --url http://192.168.1.118/api/macros -n 30 -c 1
   python3 tools/bench_http_endpoint.py --url http://192.168.1.118/api/macros -n 50 -c 10 --timeout 12
+  python3 tools/bench_http_endpoint.py --url http://192.168.1.118/api/macros -n 30 --routes
 
 Notes:
 - Reuses one HTTP connection per worker thread (keep-alive) when possible.
 - Measures end-to-end latency (request -> fully read response body).
+- --routes clears the device's per-route profile (/api/routes) before the run and
+  prints the device-side figures for the benchmarked path afterwards.
 """
 
 from __future__ import annotations
@@ -50,6 +53,41 @@ def _percentile(sorted_values: list[float], pct: float) -> float:
     return sorted_values[k - 1]
 
 
+def _routes_request(host: str, port: int, is_https: bool, timeout_s: float, method: str) -> dict | None:
+    """GET or DELETE /api/routes; None when the firmware has no route profile."""
+    conn = http.client.HTTPSConnection(host, port, timeout=timeout_s) if is_https else http.client.HTTPConnection(host, port, timeout=timeout_s)
+    try:
+        conn.request(method, "/api/routes", headers={"Host": host, "Accept": "application/json"})
+        resp = conn.getresponse()
+        data = resp.read()
+        if resp.status != 200:
+            return None
+        return json.loads(data.decode("utf-8", errors="replace"))
+    except Exception:
+        return None
+    finally:
+        conn.close()
+
+
+def _print_route_profile(profile: dict, path: str) -> dict | None:
+    route_path = path.split("?", 1)[0]
+    for r in profile.get("routes", []):
+        if r.get("method") == "GET" and r.get("path") == route_path:
+            timed = r.get("timed") or 0
+            print(
+                "Device (ms): "
+                f"avg={r.get('avg_us', 0) / 1000.0:.2f} "
+                f"p50<={r.get('p50_ms')} p95<={r.get('p95_ms')} "
+                f"max={r.get('max_us', 0) / 1000.0:.2f} "
+                f"(count={r.get('count')} timed={timed})"
+            )
+            out_avg = (r.get("bytes_out", 0) // r.get("count", 1)) if r.get("count") else 0
+            print(f"Device bytes: out={r.get('bytes_out')} (avg {out_avg}) in={r.get('bytes_in')} heap_drop_max={r.get('heap_drop_max')}")
+            return r
+    print(f"Device: no /api/routes entry for GET {route_path}")
+    return None
+
+
 def _worker(
     index: int,
     host: str,
@@ -134,6 +172,7 @@ def main(argv: list[str]) -> int:
     ap.add_argument("--warmup", type=int, default=0)
     ap.add_argument("--jitter-ms", type=int, default=0, help="Random per-request delay up to this many ms (spreads bursts).")
     ap.add_argument("--json-out", default="", help="Write raw samples + summary JSON to this file.")
+    ap.add_argument("--routes", action="store_true", help="Reset and read the device's per-route profile (/api/routes) around the run.")
     args = ap.parse_args(argv)
 
     u = urlparse(args.url)
@@ -178,6 +217,9 @@ def main(argv: list[str]) -> int:
         except Exception:
             pass
 
+    if args.routes and _routes_request(host, port, u.scheme == "https", args.timeout, "DELETE") is None:
+        print("warning: /api/routes not available (PORTAL_ROUTE_PROFILE_ENABLED off?)", file=sys.stderr)
+
     jobs: queue.Queue[int] = queue.Queue()
     for i in range(args.requests):
         jobs.put(i)
@@ -227,6 +269,12 @@ def main(argv: list[str]) -> int:
         )
     print(f"Total wall time: {(t1_all - t0_all):.2f}s")
 
+    device_route: dict | None = None
+    if args.routes:
+        profile = _routes_request(host, port, u.scheme == "https", args.timeout, "GET")
+        if profile is not None:
+            device_route = _print_route_profile(profile, path)
+
     if err_samples:
         # Show a few distinct errors
         errs: dict[str, int] = {}
@@ -251,6 +299,8 @@ def main(argv: list[str]) -> int:
             },
             "samples": [asdict(s) for s in results],
         }
+        if device_route is not None:
+            out["device_route"] = device_route
         os.makedirs(os.path.dirname(args.json_out) or ".", exist_ok=True)
         with open(args.json_out, "w", encoding="utf-8") as f:
             json.dump(out, f, indent=2)
@@ -6,6 +6,7 @@
 
 Usage:
   python3 tools/benchmark_api_macros.py --host 192.168.1.118
+  python3 tools/benchmark_api_macros.py --host 192.168.1.118 --conditional   # If-None-Match (304 path)
 """
 
 from __future__ import annotations
@@ -48,10 +49,13 @@ def percentile(values: list[float], p: float) -> float:
     return d0 + d1
 
 
-def fetch(url: str, timeout_s: float) -> Sample:
+def fetch(url: str, timeout_s: float, etag: Optional[str] = None) -> Sample:
     t0 = time.perf_counter()
     try:
-        req = urllib.request.Request(url, headers={"Accept": "application/json"})
+        headers = {"Accept": "application/json"}
+        if etag:
+            headers["If-None-Match"] = etag
+        req = urllib.request.Request(url, headers=headers)
         with urllib.request.urlopen(req, timeout=timeout_s) as resp:
             status = getattr(resp, "status", None)
             data = resp.read()
@@ -59,6 +63,8 @@ def fetch(url: str, timeout_s: float) -> Sample:
         return Sample(ok=True, ms=(t1 - t0) * 1000.0, bytes=len(data), status=status, err=None)
     except urllib.error.HTTPError as e:
         t1 = time.perf_counter()
+        if e.code == 304 and etag:
+            return Sample(ok=True, ms=(t1 - t0) * 1000.0, bytes=0, status=304, err=None)
         return Sample(ok=False, ms=(t1 - t0) * 1000.0, bytes=0, status=e.code, err=f"HTTPError: {e}")
     except Exception as e:  # noqa: BLE001
         t1 = time.perf_counter()
@@ -111,23 +117,37 @@ def main() -> int:
     ap.add_argument("--concurrency", type=int, default=1, help="Concurrent workers")
     ap.add_argument("--timeout", type=float, default=10.0, help="Per-request timeout seconds")
     ap.add_argument("--json", action="store_true", help="Output JSON only")
+    ap.add_argument("--conditional", action="store_true", help="Send If-None-Match with the ETag from a first GET")
     args = ap.parse_args()
 
     scheme = "https" if args.https else "http"
     url = f"{scheme}://{args.host}{args.path}"
 
+    etag: Optional[str] = None
+    if args.conditional:
+        try:
+            with urllib.request.urlopen(url, timeout=args.timeout) as resp:
+                etag = resp.headers.get("ETag")
+                resp.read()
+        except Exception as e:  # noqa: BLE001
+            print(f"Failed to fetch ETag: {e}")
+            return 1
+        if not etag:
+            print("Endpoint did not return an ETag")
+            return 1
+
     # Warmup
     for _ in range(max(0, args.warmup)):
-        fetch(url, args.timeout)
+        fetch(url, args.timeout, etag)
 
     # Measure
     samples: list[Sample] = []
     if args.concurrency <= 1:
         for _ in range(max(0, args.n)):
-            samples.append(fetch(url, args.timeout))
+            samples.append(fetch(url, args.timeout, etag))
     else:
         with ThreadPoolExecutor(max_workers=args.concurrency) as ex:
-            futs = [ex.submit(fetch, url, args.timeout) for _ in range(max(0, args.n))]
+            futs = [ex.submit(fetch, url, args.timeout, etag) for _ in range(max(0, args.n))]
             for f in as_completed(futs):
                 samples.append(f.result())
 
@@ -137,6 +157,7 @@ def main() -> int:
         "warmup": args.warmup,
         "concurrency": args.concurrency,
         "timeout_s": args.timeout,
+        "etag": etag,
         "result": summarize(samples),
     }
 
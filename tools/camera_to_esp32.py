@@ -39,6 +39,12 @@ Usage (automation action):
       rotate_degrees: null        # optional: null=auto, 0=no rotate, 90/180/270
       jpeg_quality: 80            # optional
       dismiss: false              # optional: if true, only dismisses current image
+      stream_url: null            # optional: MJPEG URL the ESP32 should pull instead of a snapshot
+      max_fps: 10                 # optional: frame-rate cap for stream_url
+
+  A snapshot per event costs one HTTP upload per frame. For a live feed, pass
+  stream_url (a multipart/x-mixed-replace URL serving panel-sized baseline
+  JPEGs) and the device keeps one connection open itself; dismiss stops it.
 
 Requirements:
   - Pillow (add to AppDaemon python_packages)
@@ -105,6 +111,16 @@ class CameraToESP32(hass.Hass):
             self.error("Missing required parameter: esp32_ip (or set default_esp32_ip in apps.yaml)")
             return
 
+        stream_url = data.get("stream_url")
+        if stream_url and not dismiss:
+            max_fps = int(data.get("max_fps", 10))
+            self.log(f"Starting MJPEG stream on {esp32_ip}: {stream_url} (max_fps={max_fps})")
+            if self.start_stream(esp32_ip, stream_url, max_fps):
+                self.log("[OK] Stream started")
+            else:
+                self.error("Stream start failed")
+            return
+
         if dismiss:
             self.log(f"Dismissing image on {esp32_ip}")
             ok = self.dismiss_image(esp32_ip)
@@ -322,6 +338,18 @@ class CameraToESP32(hass.Hass):
             self.error(f"Upload error: {e}")
             return False
 
+    def start_stream(self, esp32_ip: str, stream_url: str, max_fps: int = 10) -> bool:
+        """POST /api/display/stream"""
+        try:
+            url = f"http://{esp32_ip}/api/display/stream"
+            response = requests.post(url, json={"url": stream_url, "max_fps": max_fps}, timeout=10)
+            self.log(f"Stream response: HTTP {response.status_code} {response.text}")
+            return response.status_code == 200
+
+        except Exception as e:
+            self.error(f"Stream error: {e}")
+            return False
+
     def dismiss_image(self, esp32_ip: str) -> bool:
         """DELETE /api/display/image"""
         try:
@@ -11,6 +11,15 @@ Then emits:
 so firmware can resolve a compiled icon_id (e.g. "volume_up") to the compiled
 symbol (&ic_volume_up).
 
+Size variants (ic_<id>_<N>, emitted by png2lvgl_assets.py --extra-sizes inside
+#if ICON_MASK_PRESCALED) are not separate icon ids: they are listed per icon so
+the layout can pick the nearest native size (icon_registry_pick_size).
+
+Lookup is a perfect hash built here (hash-and-displace): icon_hash(id, 0)
+picks a bucket, the bucket's seed gives icon_hash(id, seed) -> the one slot
+that can hold id, and a single strcmp confirms it. icon_hash is constexpr and
+a static_assert checks it against this script's implementation.
+
 Note: full-color icons are supported via FFat-installed blobs (icon_store), not
 via compiled assets.
 
@@ -18,7 +27,8 @@ Usage:
   python3 tools/generate_icon_registry.py \
     --mono-h src/app/icon_assets_mono.h \
     --out-h  src/app/icon_registry.h \
-    --out-cpp src/app/icon_registry.cpp
+    --out-cpp src/app/icon_registry.cpp \
+    [--variant-sizes 128 --variant-guard ICON_MASK_PRESCALED]
 
 Notes:
 - This keeps the runtime lookup explicit and static (no dynamic symbol resolution).
@@ -32,7 +42,7 @@ import os
 import re
 import sys
 from dataclasses import dataclass
-from typing import List
+from typing import Dict, List, Tuple
 
 
 _DECL_RE = re.compile(r"^\s*extern\s+const\s+lv_img_dsc_t\s+(?P<sym>[A-Za-z_][A-Za-z0-9_]*)\s*;\s*$")
@@ -65,6 +75,76 @@ def _read_symbols(path: str, expected_prefix: str) -> List[IconSym]:
     return out
 
 
+def _split_variants(syms: List[IconSym], sizes: List[int]) -> Tuple[List[IconSym], Dict[str, List[Tuple[int, str]]]]:
+    """Separate <id>_<N> size variants (N in sizes, <id> also present) from icons."""
+    by_id = {s.icon_id: s for s in syms}
+    variants: Dict[str, List[Tuple[int, str]]] = {}
+    for s in syms:
+        base, sep, tail = s.icon_id.rpartition("_")
+        if sep and tail.isdigit() and int(tail) in sizes and base in by_id:
+            variants.setdefault(base, []).append((int(tail), s.symbol))
+    variant_syms = {sym for vs in variants.values() for _, sym in vs}
+    icons = [s for s in syms if s.symbol not in variant_syms]
+    for vs in variants.values():
+        vs.sort()
+    return icons, variants
+
+
+def _icon_hash(key: str, seed: int) -> int:
+    """FNV-1a with a seeded basis and a murmur3 finalizer (mirrors icon_hash in C++)."""
+    h = (2166136261 ^ seed) & 0xFFFFFFFF
+    for b in key.encode("utf-8"):
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    return h
+
+
+def _next_pow2(n: int) -> int:
+    p = 1
+    while p < n:
+        p <<= 1
+    return p
+
+
+def _build_perfect_hash(keys: List[str]) -> Tuple[List[int], List[int]]:
+    """Returns (bucket seeds, slot -> key index, 0xFFFF = empty)."""
+    n = len(keys)
+    slot_count = _next_pow2(max(1, n + n // 4))
+    bucket_count = _next_pow2(max(1, n // 2))
+
+    buckets: List[List[int]] = [[] for _ in range(bucket_count)]
+    for i, k in enumerate(keys):
+        buckets[_icon_hash(k, 0) & (bucket_count - 1)].append(i)
+
+    seeds = [0] * bucket_count
+    slots = [0xFFFF] * slot_count
+    # Largest buckets first, while most slots are still free.
+    for b in sorted(range(bucket_count), key=lambda i: -len(buckets[i])):
+        members = buckets[b]
+        if not members:
+            continue
+        for seed in range(1, 0x10000):
+            taken = [_icon_hash(keys[i], seed) & (slot_count - 1) for i in members]
+            if len(set(taken)) == len(taken) and all(slots[t] == 0xFFFF for t in taken):
+                for i, t in zip(members, taken):
+                    slots[t] = i
+                seeds[b] = seed
+                break
+        else:
+            raise SystemExit("ERROR: could not build the icon registry perfect hash")
+    return seeds, slots
+
+
+def _write_u16_table(f, name: str, values: List[int]) -> None:
+    f.write(f"static const uint16_t {name}[{len(values)}] = {{\n")
+    for i in range(0, len(values), 12):
+        f.write("  " + ", ".join(f"0x{v:04x}" for v in values[i : i + 12]) + ",\n")
+    f.write("};\n\n")
+
+
 def _write_header(out_h: str) -> None:
     guard = "ICON_REGISTRY_H"
     with open(out_h, "w", encoding="utf-8") as f:
@@ -101,6 +181,10 @@ def _write_header(out_h: str) -> None:
         f.write("\n")
         f.write("// Returns the IconKind for the given index (Mask by default if out of range).\n")
         f.write("IconKind icon_registry_kind_at(size_t index);\n\n")
+        f.write("// For a compiled icon (any of its sizes), returns the compiled size that best\n")
+        f.write("// fits box: the largest one not wider than box, else the smallest. Returns dsc\n")
+        f.write("// unchanged when it is not a compiled icon or has no size variants.\n")
+        f.write("const lv_img_dsc_t* icon_registry_pick_size(const lv_img_dsc_t* dsc, uint16_t box);\n\n")
         f.write("#ifdef __cplusplus\n")
         f.write("}\n")
         f.write("#endif\n\n")
@@ -108,7 +192,13 @@ def _write_header(out_h: str) -> None:
         f.write(f"#endif // {guard}\n")
 
 
-def _write_cpp(out_cpp: str, out_h_basename: str, mono: List[IconSym]) -> None:
+def _write_cpp(
+    out_cpp: str,
+    out_h_basename: str,
+    mono: List[IconSym],
+    variants: Dict[str, List[Tuple[int, str]]],
+    variant_guard: str,
+) -> None:
     with open(out_cpp, "w", encoding="utf-8") as f:
         f.write("/*\n")
         f.write(" * Auto-generated icon registry\n")
@@ -132,19 +222,42 @@ def _write_cpp(out_cpp: str, out_h_basename: str, mono: List[IconSym]) -> None:
             f.write(f'  {{"{s.icon_id}", &{s.symbol}, IconKind::Mask}},\n')
         f.write("};\n\n")
 
+        keys = [s.icon_id for s in mono]
+        seeds, slots = _build_perfect_hash(keys)
+        f.write("// Perfect hash over kIcons ids (see tools/generate_icon_registry.py).\n")
+        f.write("static constexpr uint32_t icon_hash(const char* s, uint32_t seed) {\n")
+        f.write("  uint32_t h = 2166136261u ^ seed;\n")
+        f.write("  while (*s) {\n")
+        f.write("    h ^= (uint8_t)*s++;\n")
+        f.write("    h *= 16777619u;\n")
+        f.write("  }\n")
+        f.write("  h ^= h >> 16;\n")
+        f.write("  h *= 0x85ebca6bu;\n")
+        f.write("  h ^= h >> 13;\n")
+        f.write("  return h;\n")
+        f.write("}\n\n")
+        if keys:
+            f.write(
+                f'static_assert(icon_hash("{keys[0]}", 0) == 0x{_icon_hash(keys[0], 0):08x}u, '
+                '"icon_hash must match tools/generate_icon_registry.py");\n\n'
+            )
+        f.write(f"static constexpr uint32_t kHashBuckets = {len(seeds)};\n")
+        f.write(f"static constexpr uint32_t kHashSlots = {len(slots)};\n\n")
+        _write_u16_table(f, "kHashSeeds", seeds)
+        _write_u16_table(f, "kHashSlotIcon", slots)
+
         f.write("bool icon_registry_lookup(const char* icon_id, IconRef* out) {\n")
         f.write("  if (!out) return false;\n")
         f.write("  out->dsc = nullptr;\n")
         f.write("  out->kind = IconKind::Mask;\n")
         f.write("  if (!icon_id || !*icon_id) return false;\n\n")
-        f.write("  for (size_t i = 0; i < (sizeof(kIcons) / sizeof(kIcons[0])); i++) {\n")
-        f.write("    if (strcmp(icon_id, kIcons[i].id) == 0) {\n")
-        f.write("      out->dsc = kIcons[i].dsc;\n")
-        f.write("      out->kind = kIcons[i].kind;\n")
-        f.write("      return true;\n")
-        f.write("    }\n")
-        f.write("  }\n")
-        f.write("  return false;\n")
+        f.write("  const uint16_t seed = kHashSeeds[icon_hash(icon_id, 0) & (kHashBuckets - 1)];\n")
+        f.write("  const uint16_t i = kHashSlotIcon[icon_hash(icon_id, seed) & (kHashSlots - 1)];\n")
+        f.write("  if (i >= (sizeof(kIcons) / sizeof(kIcons[0]))) return false;\n")
+        f.write("  if (strcmp(icon_id, kIcons[i].id) != 0) return false;\n\n")
+        f.write("  out->dsc = kIcons[i].dsc;\n")
+        f.write("  out->kind = kIcons[i].kind;\n")
+        f.write("  return true;\n")
         f.write("}\n\n")
 
         f.write("size_t icon_registry_count() {\n")
@@ -163,6 +276,48 @@ def _write_cpp(out_cpp: str, out_h_basename: str, mono: List[IconSym]) -> None:
         f.write("  return kIcons[index].kind;\n")
         f.write("}\n\n")
 
+        guard = variant_guard or "1"
+        set_len = 1 + max((len(vs) for vs in variants.values()), default=0)
+        f.write(f"#if {guard}\n")
+        f.write("// Compiled sizes of icons that have size variants (unused entries are nullptr).\n")
+        f.write("struct IconSizeSet {\n")
+        f.write(f"  const lv_img_dsc_t* sizes[{set_len}];\n")
+        f.write("};\n\n")
+        f.write("static const IconSizeSet kSizeSets[] = {\n")
+        for s in mono:
+            vs = variants.get(s.icon_id)
+            if not vs:
+                continue
+            refs = ", ".join([f"&{s.symbol}"] + [f"&{sym}" for _, sym in vs])
+            f.write(f"  {{{{{refs}}}}},\n")
+        if not variants:
+            f.write("  {{nullptr}},\n")
+        f.write("};\n")
+        f.write(f"#endif // {guard}\n\n")
+
+        f.write("const lv_img_dsc_t* icon_registry_pick_size(const lv_img_dsc_t* dsc, uint16_t box) {\n")
+        f.write("  if (!dsc) return nullptr;\n")
+        f.write(f"#if {guard}\n")
+        f.write("  for (const IconSizeSet& set : kSizeSets) {\n")
+        f.write("    bool member = false;\n")
+        f.write("    for (const lv_img_dsc_t* s : set.sizes) {\n")
+        f.write("      if (s == dsc) member = true;\n")
+        f.write("    }\n")
+        f.write("    if (!member) continue;\n\n")
+        f.write("    const lv_img_dsc_t* fit = nullptr;\n")
+        f.write("    const lv_img_dsc_t* smallest = nullptr;\n")
+        f.write("    for (const lv_img_dsc_t* s : set.sizes) {\n")
+        f.write("      if (!s) continue;\n")
+        f.write("      if (s->header.w <= box && (!fit || s->header.w > fit->header.w)) fit = s;\n")
+        f.write("      if (!smallest || s->header.w < smallest->header.w) smallest = s;\n")
+        f.write("    }\n")
+        f.write("    return fit ? fit : smallest;\n")
+        f.write("  }\n")
+        f.write(f"#endif // {guard}\n")
+        f.write("  (void)box;\n")
+        f.write("  return dsc;\n")
+        f.write("}\n\n")
+
         f.write("#endif // HAS_DISPLAY && HAS_ICONS\n")
 
 
@@ -172,19 +327,25 @@ def main() -> int:
     ap.add_argument("--out-h", required=True, help="Output registry header path")
     ap.add_argument("--out-cpp", required=True, help="Output registry cpp path")
     ap.add_argument("--symbol-prefix", default="ic_", help="Icon symbol prefix (default: ic_)")
+    ap.add_argument(
+        "--variant-sizes",
+        default="",
+        help="Sizes emitted by png2lvgl_assets.py --extra-sizes (e.g. 128); <id>_<N> symbols become size variants",
+    )
+    ap.add_argument("--variant-guard", default="", help="Macro the size variants are compiled under")
 
     args = ap.parse_args()
 
-    mono = _read_symbols(args.mono_h, expected_prefix=args.symbol_prefix)
-    color: List[IconSym] = []
+    sizes = [int(x) for x in args.variant_sizes.replace(",", " ").split()]
+    mono, variants = _split_variants(_read_symbols(args.mono_h, expected_prefix=args.symbol_prefix), sizes)
 
     os.makedirs(os.path.dirname(args.out_h) or ".", exist_ok=True)
     os.makedirs(os.path.dirname(args.out_cpp) or ".", exist_ok=True)
 
     _write_header(args.out_h)
-    _write_cpp(args.out_cpp, os.path.basename(args.out_h), mono)
+    _write_cpp(args.out_cpp, os.path.basename(args.out_h), mono, variants, args.variant_guard)
 
-    print(f"✓ Icon registry: mono={len(mono)}")
+    print(f"✓ Icon registry: mono={len(mono)} sized={len(variants)}")
     print(f"✓ Wrote {args.out_h}")
     print(f"✓ Wrote {args.out_cpp}")
 
@@ -28,6 +28,12 @@ PARTITION_NAME_NO_EXT_S3="app3M_fat9M_16MB_big_nvs"
 BOARD_ID_S3="esp32s3"
 UPLOAD_MAX_SIZE_S3="3145728"  # 0x300000
 
+# Same as above with 1MB of FFat given to a read-only icon pack partition.
+PARTITION_FILE_SRC_S3_ICONS="$REPO_ROOT/partitions/app3M_fat8M_icons_16MB_big_nvs.csv"
+PARTITION_SCHEME_ID_S3_ICONS="app3M_fat8M_icons_16MB_big_nvs"
+PARTITION_FILE_BASENAME_S3_ICONS="app3M_fat8M_icons_16MB_big_nvs.csv"
+PARTITION_NAME_NO_EXT_S3_ICONS="app3M_fat8M_icons_16MB_big_nvs"
+
 ESP32_HW_BASE="$HOME/.arduino15/packages/esp32/hardware/esp32"
 
 if [[ ! -f "$PARTITION_FILE_SRC_C3" ]]; then
@@ -42,6 +48,12 @@ if [[ ! -f "$PARTITION_FILE_SRC_S3" ]]; then
   exit 1
 fi
 
+if [[ ! -f "$PARTITION_FILE_SRC_S3_ICONS" ]]; then
+  echo "Error: partition file not found: $PARTITION_FILE_SRC_S3_ICONS" >&2
+  echo "Did you delete or rename the file under partitions/?" >&2
+  exit 1
+fi
+
 if [[ ! -d "$ESP32_HW_BASE" ]]; then
   echo "Error: ESP32 Arduino core not found at $ESP32_HW_BASE" >&2
   echo "Run ./setup.sh first to install esp32:esp32." >&2
@@ -84,6 +96,9 @@ echo "✓ Installed $PARTITION_FILE_BASENAME_C3"
 cp "$PARTITION_FILE_SRC_S3" "$PARTITION_DIR/$PARTITION_FILE_BASENAME_S3"
 echo "✓ Installed $PARTITION_FILE_BASENAME_S3"
 
+cp "$PARTITION_FILE_SRC_S3_ICONS" "$PARTITION_DIR/$PARTITION_FILE_BASENAME_S3_ICONS"
+echo "✓ Installed $PARTITION_FILE_BASENAME_S3_ICONS"
+
 # 2) Register PartitionScheme in boards.txt (idempotent)
 # We key off the specific menu entry to avoid false positives.
 printf "\nRegistering PartitionScheme menu entries...\n"
@@ -116,4 +131,18 @@ else
   echo "✓ Registered PartitionScheme '$PARTITION_SCHEME_ID_S3' for board '$BOARD_ID_S3'"
 fi
 
+if grep -q "^${BOARD_ID_S3}\.menu\.PartitionScheme\.${PARTITION_SCHEME_ID_S3_ICONS}=" "$BOARDS_TXT"; then
+  echo "✓ PartitionScheme '$PARTITION_SCHEME_ID_S3_ICONS' already registered in boards.txt"
+else
+  {
+    echo ""
+    echo "# Custom 16MB partition scheme w/ larger NVS and an icon pack (installed by $REPO_ROOT/tools/install-custom-partitions.sh)"
+    echo "${BOARD_ID_S3}.menu.PartitionScheme.${PARTITION_SCHEME_ID_S3_ICONS}=3MB APP×2 + FFat + 1MB Icon Pack (Big NVS)"
+    echo "${BOARD_ID_S3}.menu.PartitionScheme.${PARTITION_SCHEME_ID_S3_ICONS}.build.partitions=${PARTITION_NAME_NO_EXT_S3_ICONS}"
+    echo "${BOARD_ID_S3}.menu.PartitionScheme.${PARTITION_SCHEME_ID_S3_ICONS}.upload.maximum_size=${UPLOAD_MAX_SIZE_S3}"
+  } >> "$BOARDS_TXT"
+
+  echo "✓ Registered PartitionScheme '$PARTITION_SCHEME_ID_S3_ICONS' for board '$BOARD_ID_S3'"
+fi
+
 echo "Done."
\ No newline at end of file
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""
+Build and upload the macro label font (LABEL_FONT_ENABLED).
+
+Fetches the code points the device's macro labels use, subsets a TTF/WOFF
+font to them with lv_font_conv (binary LVGL font), and uploads it as
+/fonts/label.bin. Code points missing from the font are drawn with the
+firmware's default font, so re-run after adding labels with new characters.
+
+Usage:
+    # Subset NotoSansJP to the labels, 20 px, and upload
+    ./label_font.py 192.168.1.100 --font NotoSansJP-Regular.ttf --size 20
+
+    # Also keep printable ASCII (default labels, action hints)
+    ./label_font.py esp32-1234.local --font Inter.ttf --size 22 --ascii
+
+    # Only build the file
+    ./label_font.py 192.168.1.100 --font Inter.ttf --size 22 --out label.bin --no-upload
+
+    # Back to the built-in font
+    ./label_font.py 192.168.1.100 --delete
+
+Dependencies:
+    pip install requests
+    npm install -g lv_font_conv   (or have npx available)
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from typing import List, Optional, Tuple
+
+import requests
+
+
+def parse_auth(value: Optional[str]) -> Optional[Tuple[str, str]]:
+    if not value:
+        return None
+    user, _, password = value.partition(":")
+    return (user, password)
+
+
+def base_url(host: str) -> str:
+    return host if host.startswith("http") else f"http://{host}"
+
+
+def fetch_codepoints(url: str, auth, timeout: float) -> List[int]:
+    r = requests.get(f"{url}/api/fonts/glyphs", auth=auth, timeout=timeout)
+    r.raise_for_status()
+    data = r.json()
+    if data.get("truncated"):
+        print("warning: the device reported more code points than it lists; some labels may fall back",
+              file=sys.stderr)
+    return [int(cp) for cp in data.get("codepoints", [])]
+
+
+def to_ranges(codepoints: List[int]) -> str:
+    """Collapse sorted code points into lv_font_conv's --range syntax."""
+    parts = []
+    start = prev = None
+    for cp in sorted(set(codepoints)):
+        if start is None:
+            start = prev = cp
+        elif cp == prev + 1:
+            prev = cp
+        else:
+            parts.append((start, prev))
+            start = prev = cp
+    if start is not None:
+        parts.append((start, prev))
+    return ",".join(f"0x{a:X}" if a == b else f"0x{a:X}-0x{b:X}" for a, b in parts)
+
+
+def lv_font_conv_cmd(explicit: Optional[str]) -> List[str]:
+    if explicit:
+        return explicit.split()
+    if shutil.which("lv_font_conv"):
+        return ["lv_font_conv"]
+    if shutil.which("npx"):
+        return ["npx", "--yes", "lv_font_conv"]
+    raise SystemExit("lv_font_conv not found (npm install -g lv_font_conv, or pass --lv-font-conv)")
+
+
+def build_font(args, codepoints: List[int], out_path: str) -> None:
+    cmd = lv_font_conv_cmd(args.lv_font_conv) + [
+        "--font", args.font,
+        "--range", to_ranges(codepoints),
+        "--size", str(args.size),
+        "--bpp", str(args.bpp),
+        "--format", "bin",
+        "--no-compress",
+        "-o", out_path,
+    ]
+    subprocess.run(cmd, check=True)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Subset and upload the macro label font")
+    parser.add_argument("host", help="Device IP or hostname")
+    parser.add_argument("--font", help="TTF/WOFF source font")
+    parser.add_argument("--size", type=int, default=20, help="Font size in px (default 20)")
+    parser.add_argument("--bpp", type=int, default=4, choices=[1, 2, 4, 8], help="Bits per pixel (default 4)")
+    parser.add_argument("--ascii", action="store_true", help="Also include printable ASCII (0x20-0x7E)")
+    parser.add_argument("--out", help="Keep the built font at this path")
+    parser.add_argument("--no-upload", action="store_true", help="Build only")
+    parser.add_argument("--delete", action="store_true", help="Remove the label font from the device")
+    parser.add_argument("--lv-font-conv", default=None, help="lv_font_conv command (default: lv_font_conv or npx)")
+    parser.add_argument("--auth", default=None, help="Basic auth in the form user:pass (optional)")
+    parser.add_argument("--timeout", type=float, default=30.0, help="HTTP timeout in seconds")
+    args = parser.parse_args()
+
+    url = base_url(args.host)
+    auth = parse_auth(args.auth)
+
+    if args.delete:
+        r = requests.delete(f"{url}/api/fonts/label", auth=auth, timeout=args.timeout)
+        print(r.text)
+        return 0 if r.ok else 1
+
+    if not args.font:
+        parser.error("--font is required unless --delete is given")
+
+    codepoints = fetch_codepoints(url, auth, args.timeout)
+    if args.ascii:
+        codepoints += list(range(0x20, 0x7F))
+    if not codepoints:
+        print("The macro labels use no characters; nothing to build", file=sys.stderr)
+        return 1
+    print(f"{len(set(codepoints))} code points: {to_ranges(codepoints)}")
+
+    with tempfile.TemporaryDirectory() as tmp:
+        out_path = args.out or os.path.join(tmp, "label.bin")
+        build_font(args, codepoints, out_path)
+        with open(out_path, "rb") as f:
+            data = f.read()
+        print(f"Built {out_path} ({len(data)} bytes)")
+
+        if args.no_upload:
+            return 0
+        r = requests.post(
+            f"{url}/api/fonts/label",
+            data=data,
+            headers={"Content-Type": "application/octet-stream"},
+            auth=auth,
+            timeout=args.timeout,
+        )
+        print(r.text)
+        return 0 if r.ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""Build a delta OTA patch between two app images (stdlib only).
+
+Examples:
+  python3 tools/make_delta_ota.py old/app.ino.bin build/cyd/app.ino.bin -o update.delta.gz
+  python3 tools/make_delta_ota.py prev.bin new.bin -o out.delta.gz --json
+
+The patch rebuilds the new image from the one the device is running (see
+src/app/ota_delta.h for the layout): stretches that line up with the old image
+are sent as a byte-wise difference, which is mostly zeros and gzips to almost
+nothing, and the rest as literal bytes. The device refuses a patch whose base
+is not the firmware it runs, identified by the ELF SHA-256 in the old image's
+app descriptor.
+
+Notes:
+- The patch is applied back to the old image before it is written; a patch
+  that does not rebuild the new image byte for byte is never produced.
+- Matching is bsdiff-like but simpler: the old image is indexed every 4 bytes,
+  and matches are extended forwards while mismatches stay rare.
+"""
+
+from __future__ import annotations
+
+import argparse
+import gzip
+import hashlib
+import json
+import struct
+import sys
+
+MAGIC = b"ESPDLT01"
+OP_END = 0x00
+OP_COPY = 0x01
+OP_INSERT = 0x02
+
+# esp_app_desc_t follows the image header (24 bytes) and first segment header (8).
+APP_DESC_OFFSET = 32
+APP_DESC_MAGIC = 0xABCD5432
+APP_DESC_ELF_SHA_OFFSET = 144
+
+KEY = 16          # bytes that must match exactly to seed a copy
+STRIDE = 4        # old-image positions indexed
+MIN_COPY = 32     # shorter matches are sent as literals
+GIVE_UP = 64      # stop extending once the score drops this far below its best
+
+
+def elf_sha256(image: bytes) -> bytes:
+    desc = APP_DESC_OFFSET
+    if len(image) < desc + APP_DESC_ELF_SHA_OFFSET + 32:
+        raise ValueError("image too small for an ESP app descriptor")
+    (magic,) = struct.unpack_from("<I", image, desc)
+    if magic != APP_DESC_MAGIC:
+        raise ValueError("no ESP app descriptor (is this an app .bin?)")
+    start = desc + APP_DESC_ELF_SHA_OFFSET
+    return image[start : start + 32]
+
+
+def build_index(old: bytes) -> dict[bytes, int]:
+    index: dict[bytes, int] = {}
+    for pos in range(0, len(old) - KEY + 1, STRIDE):
+        index.setdefault(old[pos : pos + KEY], pos)
+    return index
+
+
+def extend_forward(new: bytes, ni: int, old: bytes, oi: int) -> int:
+    limit = min(len(new) - ni, len(old) - oi)
+    score = best = best_len = k = 0
+    while k < limit:
+        if k + 64 <= limit and new[ni + k : ni + k + 64] == old[oi + k : oi + k + 64]:
+            k += 64
+            score += 64
+        else:
+            score += 1 if new[ni + k] == old[oi + k] else -1
+            k += 1
+        if score > best:
+            best = score
+            best_len = k
+        elif score < best - GIVE_UP:
+            break
+    return best_len
+
+
+def diff_ops(old: bytes, new: bytes) -> list[tuple[int, int, int, int]]:
+    """(op, new_start, length, old_offset) covering new from start to end."""
+    index = build_index(old)
+    ops: list[tuple[int, int, int, int]] = []
+    literal_start = 0
+    last_delta = None  # old - new offset of the previous copy
+    i = 0
+    n = len(new)
+    while i + KEY <= n:
+        candidates = []
+        if last_delta is not None and 0 <= i + last_delta < len(old):
+            candidates.append(i + last_delta)
+        hit = index.get(new[i : i + KEY])
+        if hit is not None:
+            candidates.append(hit)
+
+        best_off = best_len = 0
+        for off in candidates:
+            length = extend_forward(new, i, old, off)
+            if length > best_len:
+                best_off, best_len = off, length
+        if best_len < MIN_COPY:
+            i += 1
+            continue
+
+        # Pull the copy back over identical bytes still pending as literal.
+        start, off = i, best_off
+        while start > literal_start and off > 0 and new[start - 1] == old[off - 1]:
+            start -= 1
+            off -= 1
+        if start > literal_start:
+            ops.append((OP_INSERT, literal_start, start - literal_start, 0))
+        length = best_len + (i - start)
+        ops.append((OP_COPY, start, length, off))
+        last_delta = off - start
+        i = start + length
+        literal_start = i
+
+    if literal_start < n:
+        ops.append((OP_INSERT, literal_start, n - literal_start, 0))
+    return ops
+
+
+def make_patch(old: bytes, new: bytes) -> bytes:
+    out = bytearray()
+    out += MAGIC
+    out += elf_sha256(old)
+    out += struct.pack("<II", len(old), len(new))
+    out += hashlib.sha256(new).digest()
+    for op, start, length, off in diff_ops(old, new):
+        if op == OP_COPY:
+            out += struct.pack("<BII", OP_COPY, off, length)
+            out += bytes((a - b) & 0xFF for a, b in zip(new[start : start + length], old[off : off + length]))
+        else:
+            out += struct.pack("<BI", OP_INSERT, length)
+            out += new[start : start + length]
+    out.append(OP_END)
+    return bytes(out)
+
+
+def apply_patch(old: bytes, patch: bytes) -> bytes:
+    """Reference applier, same checks as src/app/ota_delta.cpp."""
+    if patch[:8] != MAGIC:
+        raise ValueError("not a delta patch")
+    if patch[8:40] != elf_sha256(old):
+        raise ValueError("patch is for another base build")
+    base_size, target_size = struct.unpack_from("<II", patch, 40)
+    target_sha = patch[48:80]
+    if base_size > len(old):
+        raise ValueError("base larger than the old image")
+    out = bytearray()
+    pos = 80
+    while True:
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            off, length = struct.unpack_from("<II", patch, pos)
+            pos += 8
+            if off + length > base_size:
+                raise ValueError("copy outside the base image")
+            out += bytes((a + b) & 0xFF for a, b in zip(old[off : off + length], patch[pos : pos + length]))
+        elif op == OP_INSERT:
+            (length,) = struct.unpack_from("<I", patch, pos)
+            pos += 4
+            out += patch[pos : pos + length]
+        else:
+            raise ValueError(f"bad op {op:#x}")
+        pos += length
+        if len(out) > target_size:
+            raise ValueError("patch overruns the target size")
+    if pos != len(patch):
+        raise ValueError("data after end marker")
+    if len(out) != target_size or hashlib.sha256(out).digest() != target_sha:
+        raise ValueError("rebuilt image does not match")
+    return bytes(out)
+
+
+def main(argv: list[str]) -> int:
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("old", help="app image the device runs now (.bin)")
+    ap.add_argument("new", help="app image to update to (.bin)")
+    ap.add_argument("-o", "--out", required=True, help="patch file to write (.delta.gz)")
+    ap.add_argument("--json", action="store_true", help="print sizes as JSON")
+    args = ap.parse_args(argv)
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    try:
+        patch = make_patch(old, new)
+        if apply_patch(old, patch) != new:
+            raise ValueError("round trip failed")
+    except ValueError as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+    packed = gzip.compress(patch, compresslevel=9, mtime=0)
+    with open(args.out, "wb") as f:
+        f.write(packed)
+
+    full = len(gzip.compress(new, compresslevel=9, mtime=0))
+    stats = {
+        "new_bytes": len(new),
+        "new_gzip_bytes": full,
+        "patch_bytes": len(patch),
+        "patch_gzip_bytes": len(packed),
+        "saving_vs_gzip": round(1 - len(packed) / full, 3) if full else 0.0,
+    }
+    if args.json:
+        print(json.dumps(stats))
+    else:
+        print(
+            f"{args.out}: {len(packed)} bytes "
+            f"(full image {len(new)}, gzip {full}; {stats['saving_vs_gzip'] * 100:.0f}% smaller than gzip)"
+        )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -174,6 +174,13 @@ declare -A JS_GZIP_CONTENTS
 declare -A ORIGINAL_SIZES
 declare -A PROCESSED_SIZES
 declare -A GZIPPED_SIZES
+declare -A ASSET_HASHES
+
+# Short content hash of the processed asset: used as its ETag and, for CSS/JS,
+# as the ?v= version the HTML pages reference (so the URL changes with the content).
+content_hash() {
+    echo -n "$1" | sha256sum | cut -c1-12
+}
 
 # Helper function to gzip content and generate C byte array
 gzip_to_c_array() {
@@ -183,7 +190,7 @@ gzip_to_c_array() {
     
     # Write content to temp file and gzip it
     echo -n "$content" > "$temp_file"
-    gzip -9 -c "$temp_file" > "$temp_gz"
+    gzip -9 -n -c "$temp_file" > "$temp_gz"
     
     # Convert to C byte array format
     xxd -i < "$temp_gz" | grep -v "unsigned" | sed 's/^  //'
@@ -192,59 +199,6 @@ gzip_to_c_array() {
     rm -f "$temp_file" "$temp_gz"
 }
 
-# Process HTML files (template substitution + minification)
-for html_file in "${HTML_FILES[@]}"; do
-    filename=$(basename "$html_file" .html)
-    echo "Processing HTML: $filename.html..."
-    content=$(cat "$html_file")
-    original_size=$(echo -n "$content" | wc -c)
-    
-    # Template substitution and minification
-    minified=$(python3 -c "
-import re
-import sys
-
-# Read template fragments from environment or files
-header_template = '''$HEADER_TEMPLATE'''
-nav_template = '''$NAV_TEMPLATE'''
-footer_template = '''$FOOTER_TEMPLATE'''
-
-with open('$html_file', 'r') as f:
-    html = f.read()
-    
-    # Replace template placeholders with actual content
-    html = html.replace('{{HEADER}}', header_template)
-    html = html.replace('{{NAV}}', nav_template)
-    html = html.replace('{{FOOTER}}', footer_template)
-    
-    # Project name substitution
-    html = html.replace('{{PROJECT_NAME}}', '$PROJECT_NAME')
-    html = html.replace('{{PROJECT_DISPLAY_NAME}}', '$PROJECT_DISPLAY_NAME')
-    
-    # Remove HTML comments
-    html = re.sub(r'<!--.*?-->', '', html, flags=re.DOTALL)
-    # Collapse multiple spaces/newlines to single space
-    html = re.sub(r'\s+', ' ', html)
-    # Remove spaces around tags
-    html = re.sub(r'>\s+<', '><', html)
-    # Trim
-    html = html.strip()
-    print(html, end='')
-")
-    
-    HTML_CONTENTS["$filename"]="$minified"
-    minified_size=$(echo -n "$minified" | wc -c)
-    
-    # Gzip compress
-    gzipped=$(gzip_to_c_array "$minified")
-    HTML_GZIP_CONTENTS["$filename"]="$gzipped"
-    gzipped_size=$(echo -n "$minified" | gzip -9 -c | wc -c)
-    
-    ORIGINAL_SIZES["html_$filename"]=$original_size
-    PROCESSED_SIZES["html_$filename"]=$minified_size
-    GZIPPED_SIZES["html_$filename"]=$gzipped_size
-done
-
 # Process CSS files (minify)
 for css_file in "${CSS_FILES[@]}"; do
     filename=$(basename "$css_file" .css)
@@ -261,12 +215,13 @@ with open('$css_file', 'r') as f:
 ")
     
     CSS_CONTENTS["$filename"]="$minified"
+    ASSET_HASHES["css_$filename"]=$(content_hash "$minified")
     minified_size=$(echo -n "$minified" | wc -c)
     
     # Gzip compress
     gzipped=$(gzip_to_c_array "$minified")
     CSS_GZIP_CONTENTS["$filename"]="$gzipped"
-    gzipped_size=$(echo -n "$minified" | gzip -9 -c | wc -c)
+    gzipped_size=$(echo -n "$minified" | gzip -9 -n -c | wc -c)
     
     ORIGINAL_SIZES["css_$filename"]=$original_size
     PROCESSED_SIZES["css_$filename"]=$minified_size
@@ -289,18 +244,88 @@ with open('$js_file', 'r') as f:
 ")
     
     JS_CONTENTS["$filename"]="$minified"
+    ASSET_HASHES["js_$filename"]=$(content_hash "$minified")
     minified_size=$(echo -n "$minified" | wc -c)
     
     # Gzip compress
     gzipped=$(gzip_to_c_array "$minified")
     JS_GZIP_CONTENTS["$filename"]="$gzipped"
-    gzipped_size=$(echo -n "$minified" | gzip -9 -c | wc -c)
+    gzipped_size=$(echo -n "$minified" | gzip -9 -n -c | wc -c)
     
     ORIGINAL_SIZES["js_$filename"]=$original_size
     PROCESSED_SIZES["js_$filename"]=$minified_size
     GZIPPED_SIZES["js_$filename"]=$gzipped_size
 done
 
+# name=hash pairs substituted into the HTML below
+ASSET_VERSION_REFS=""
+for filename in "${!CSS_CONTENTS[@]}"; do
+    ASSET_VERSION_REFS+=" /${filename}.css=${ASSET_HASHES[css_$filename]}"
+done
+for filename in "${!JS_CONTENTS[@]}"; do
+    ASSET_VERSION_REFS+=" /${filename}.js=${ASSET_HASHES[js_$filename]}"
+done
+
+# Process HTML files (template substitution + minification)
+# Runs after CSS/JS so pages can reference their content-hashed URLs.
+for html_file in "${HTML_FILES[@]}"; do
+    filename=$(basename "$html_file" .html)
+    echo "Processing HTML: $filename.html..."
+    content=$(cat "$html_file")
+    original_size=$(echo -n "$content" | wc -c)
+    
+    # Template substitution and minification
+    minified=$(python3 -c "
+import re
+import sys
+
+# Read template fragments from environment or files
+header_template = '''$HEADER_TEMPLATE'''
+nav_template = '''$NAV_TEMPLATE'''
+footer_template = '''$FOOTER_TEMPLATE'''
+
+with open('$html_file', 'r') as f:
+    html = f.read()
+    
+    # Replace template placeholders with actual content
+    html = html.replace('{{HEADER}}', header_template)
+    html = html.replace('{{NAV}}', nav_template)
+    html = html.replace('{{FOOTER}}', footer_template)
+    
+    # Versioned CSS/JS URLs (\"/portal.css\" -> \"/portal.css?v=<hash>\")
+    for ref in '''$ASSET_VERSION_REFS'''.split():
+        path, version = ref.split('=', 1)
+        html = html.replace('\"' + path + '\"', '\"' + path + '?v=' + version + '\"')
+
+    # Project name substitution
+    html = html.replace('{{PROJECT_NAME}}', '$PROJECT_NAME')
+    html = html.replace('{{PROJECT_DISPLAY_NAME}}', '$PROJECT_DISPLAY_NAME')
+    
+    # Remove HTML comments
+    html = re.sub(r'<!--.*?-->', '', html, flags=re.DOTALL)
+    # Collapse multiple spaces/newlines to single space
+    html = re.sub(r'\s+', ' ', html)
+    # Remove spaces around tags
+    html = re.sub(r'>\s+<', '><', html)
+    # Trim
+    html = html.strip()
+    print(html, end='')
+")
+    
+    HTML_CONTENTS["$filename"]="$minified"
+    ASSET_HASHES["html_$filename"]=$(content_hash "$minified")
+    minified_size=$(echo -n "$minified" | wc -c)
+    
+    # Gzip compress
+    gzipped=$(gzip_to_c_array "$minified")
+    HTML_GZIP_CONTENTS["$filename"]="$gzipped"
+    gzipped_size=$(echo -n "$minified" | gzip -9 -n -c | wc -c)
+    
+    ORIGINAL_SIZES["html_$filename"]=$original_size
+    PROCESSED_SIZES["html_$filename"]=$minified_size
+    GZIPPED_SIZES["html_$filename"]=$gzipped_size
+done
+
 echo
 
 # Generate the header file
@@ -397,6 +422,10 @@ cat > "$OUTPUT_FILE" << 'HEADER_START'
  * 
  * All assets are stored in gzipped format with Content-Encoding: gzip headers.
  * This reduces flash storage and bandwidth by 60-80%.
+ *
+ * Each asset also gets a content hash (<name>_<ext>_etag). HTML pages reference
+ * CSS/JS as /<name>.<ext>?v=<hash> (<name>_<ext>_version), so those URLs can be
+ * cached as immutable.
  * 
  * To modify web assets:
  *   1. Edit source files in src/app/web/
@@ -467,6 +496,26 @@ for filename in "${!JS_CONTENTS[@]}"; do
     echo "const size_t ${filename}_js_gz_len = sizeof(${filename}_js_gz);" >> "$OUTPUT_FILE"
 done
 
+# Content hashes: strong ETags for every asset, plus the ?v= version of CSS/JS
+cat >> "$OUTPUT_FILE" << 'HASH_CONSTANTS'
+
+// Content hashes (first 12 hex digits of SHA-256 over the minified asset)
+HASH_CONSTANTS
+
+for filename in "${!HTML_CONTENTS[@]}"; do
+    echo "const char ${filename}_html_etag[] = \"\\\"${ASSET_HASHES[html_$filename]}\\\"\";" >> "$OUTPUT_FILE"
+done
+
+for filename in "${!CSS_CONTENTS[@]}"; do
+    echo "const char ${filename}_css_version[] = \"${ASSET_HASHES[css_$filename]}\";" >> "$OUTPUT_FILE"
+    echo "const char ${filename}_css_etag[] = \"\\\"${ASSET_HASHES[css_$filename]}\\\"\";" >> "$OUTPUT_FILE"
+done
+
+for filename in "${!JS_CONTENTS[@]}"; do
+    echo "const char ${filename}_js_version[] = \"${ASSET_HASHES[js_$filename]}\";" >> "$OUTPUT_FILE"
+    echo "const char ${filename}_js_etag[] = \"\\\"${ASSET_HASHES[js_$filename]}\\\"\";" >> "$OUTPUT_FILE"
+done
+
 # Close header file
 cat >> "$OUTPUT_FILE" << 'HEADER_END'
 
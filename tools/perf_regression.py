@@ -0,0 +1,673 @@
+#!/usr/bin/env python3
+"""Release-over-release performance regression harness (stdlib only).
+
+Drives a device through one fixed scenario, collects host-side latency and the
+device's own counters, and compares the result with a stored baseline for the
+same board. Exit code 1 means a metric regressed past its threshold.
+
+Scenario (phases run in this order, fixed round counts, fixed seed):
+  portal   pages, assets and JSON reads (/api/info, /api/config, /api/macros)
+  macros   GET /api/macros and POST the same document back (a full save)
+  image    POST /api/display/image of one JPEG, then DELETE /api/display/image
+  screens  PUT /api/display/screen across every screen in /api/info
+  bench    (--bench) POST /api/bench and wait for the on-device results
+
+Device counters, read after the scenario:
+  /api/routes  per-route latency and heap drop (cleared before the run)
+  /api/health  *_window percentiles and heap minimums (window started before the run),
+               heap_tags peaks, heap_place failures, lvgl_arena peak
+  /api/bench   display, JPEG, FFat, macros storage and DuckyScript figures
+
+Baselines live in <baseline-dir>/<board>/<version>.json. Without --baseline,
+a run compares against the stored baseline for its own version, or else the
+newest older version of the same board (the previous release).
+
+Examples:
+  python3 tools/perf_regression.py run --host 192.168.1.118
+  python3 tools/perf_regression.py run --host 192.168.1.118 --bench --image photo.jpg
+  python3 tools/perf_regression.py run --host 192.168.1.118 --save-baseline
+  python3 tools/perf_regression.py compare artifacts/perf/run.json perf-baselines/cyd-v2/1.4.0.json
+"""
+
+from __future__ import annotations
+
+import argparse
+import base64
+import fnmatch
+import json
+import os
+import random
+import re
+import sys
+import time
+from datetime import datetime, timezone
+from typing import Any, Dict, List, Optional, Tuple
+
+from urllib.error import HTTPError, URLError
+from urllib.request import Request, urlopen
+
+
+DEFAULT_TIMEOUT_S = 10.0
+DEFAULT_RETRIES = 2
+DEFAULT_RETRY_SLEEP_S = 0.25
+SCENARIO_VERSION = 1
+SEED = 1234
+
+PORTAL_PATHS = ("/home.html", "/network.html", "/firmware.html", "/portal.css", "/portal.js")
+# Not /api/health: reading it restarts the *_window fields collected afterwards.
+PORTAL_API_PATHS = ("/api/info", "/api/config", "/api/macros")
+
+# kind -> (better, pct, abs). A metric regresses when it moves the wrong way by
+# more than pct percent of the baseline plus abs.
+DEFAULT_KINDS: Dict[str, Tuple[str, float, float]] = {
+    "ms": ("lower", 25.0, 2.0),
+    "us": ("lower", 25.0, 2000.0),
+    "bytes": ("lower", 10.0, 4096.0),   # peaks and usage
+    "free": ("higher", 10.0, 4096.0),   # free heap minimums, largest blocks
+    "pct": ("lower", 0.0, 5.0),         # fragmentation, in points
+    "rate": ("higher", 15.0, 0.0),      # fps, MB/s, ops/s
+    "count": ("lower", 50.0, 5.0),      # over-budget passes
+    "errors": ("lower", 0.0, 0.0),      # failed requests, failed allocations
+}
+
+
+def _repo_root() -> str:
+    # tools/perf_regression.py -> repo root
+    return os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+
+
+def _now_iso() -> str:
+    return datetime.now(timezone.utc).isoformat(timespec="seconds")
+
+
+def _normalize_base_url(host: str) -> str:
+    host = host.strip()
+    if host.startswith("http://") or host.startswith("https://"):
+        return host.rstrip("/")
+    return f"http://{host.rstrip('/')}"
+
+
+def _basic_auth_header(auth: Optional[str]) -> Dict[str, str]:
+    if not auth:
+        return {}
+    if ":" not in auth:
+        raise ValueError("--auth must be in the form user:pass")
+    tok = base64.b64encode(auth.encode("utf-8")).decode("ascii")
+    return {"Authorization": f"Basic {tok}"}
+
+
+def _percentile(sorted_values: List[float], pct: float) -> float:
+    # Nearest-rank method, as tools/bench_http_endpoint.py.
+    if not sorted_values:
+        return float("nan")
+    k = int((pct / 100.0) * len(sorted_values))
+    k = max(1, min(len(sorted_values), k))
+    return sorted_values[k - 1]
+
+
+class Device:
+    def __init__(self, base_url: str, headers: Dict[str, str], timeout_s: float) -> None:
+        self.base_url = base_url
+        self.headers = headers
+        self.timeout_s = timeout_s
+
+    def http(
+        self,
+        method: str,
+        path: str,
+        body: Optional[bytes] = None,
+        content_type: Optional[str] = None,
+        retries: int = DEFAULT_RETRIES,
+    ) -> Tuple[int, bytes, float]:
+        """Returns (status, body, ms). Status 0 means no response."""
+        headers = {"User-Agent": "perf-regression/1.0", "Accept": "*/*"}
+        headers.update(self.headers)
+        if content_type:
+            headers["Content-Type"] = content_type
+        req = Request(url=f"{self.base_url}{path}", data=body, headers=headers, method=method)
+
+        t0 = time.perf_counter()
+        for attempt in range(1, max(1, retries) + 1):
+            t0 = time.perf_counter()
+            try:
+                with urlopen(req, timeout=self.timeout_s) as resp:
+                    data = resp.read()
+                    return resp.getcode(), data, (time.perf_counter() - t0) * 1000.0
+            except HTTPError as e:
+                try:
+                    data = e.read()
+                except Exception:
+                    data = b""
+                return e.code, data, (time.perf_counter() - t0) * 1000.0
+            except (URLError, TimeoutError, ConnectionError):
+                if attempt < retries:
+                    time.sleep(DEFAULT_RETRY_SLEEP_S * attempt)
+        return 0, b"", (time.perf_counter() - t0) * 1000.0
+
+    def get_json(self, path: str) -> Optional[Dict[str, Any]]:
+        status, data, _ = self.http("GET", path)
+        if status != 200:
+            return None
+        try:
+            return json.loads(data.decode("utf-8", errors="replace"))
+        except json.JSONDecodeError:
+            return None
+
+
+class Phase:
+    def __init__(self, name: str) -> None:
+        self.name = name
+        self.samples: List[float] = []
+        self.errors: Dict[str, int] = {}
+        self.skipped: Optional[str] = None
+
+    def record(self, label: str, status: int, ms: float, ok_statuses: Tuple[int, ...] = (200,)) -> bool:
+        if status in ok_statuses:
+            self.samples.append(ms)
+            return True
+        key = f"{label}: HTTP {status}" if status else f"{label}: no response"
+        self.errors[key] = self.errors.get(key, 0) + 1
+        return False
+
+    def summary(self) -> Dict[str, Any]:
+        if self.skipped:
+            return {"skipped": self.skipped}
+        lat = sorted(self.samples)
+        out: Dict[str, Any] = {"requests": len(lat) + sum(self.errors.values()), "errors": sum(self.errors.values())}
+        if lat:
+            out.update({
+                "p50_ms": round(_percentile(lat, 50), 2),
+                "p95_ms": round(_percentile(lat, 95), 2),
+                "max_ms": round(lat[-1], 2),
+            })
+        if self.errors:
+            out["error_kinds"] = self.errors
+        return out
+
+
+def phase_portal(dev: Device, rounds: int) -> Phase:
+    p = Phase("portal")
+    for _ in range(rounds):
+        for path in PORTAL_PATHS:
+            status, _, ms = dev.http("GET", path)
+            # In AP mode, home/firmware may redirect.
+            p.record(path, status, ms, (200, 302))
+        for path in PORTAL_API_PATHS:
+            status, _, ms = dev.http("GET", path)
+            p.record(path, status, ms)
+    return p
+
+
+def phase_macros(dev: Device, rounds: int) -> Phase:
+    p = Phase("macros")
+    status, doc, _ = dev.http("GET", "/api/macros")
+    if status != 200:
+        p.skipped = f"GET /api/macros: HTTP {status}"
+        return p
+    for _ in range(rounds):
+        status, _, ms = dev.http("GET", "/api/macros")
+        p.record("GET /api/macros", status, ms)
+        # The same document back: a full parse, compile and store every round
+        # without changing what the device shows.
+        status, _, ms = dev.http("POST", "/api/macros", body=doc, content_type="application/json")
+        p.record("POST /api/macros", status, ms)
+    return p
+
+
+def _multipart_jpeg(jpeg: bytes) -> Tuple[bytes, str]:
+    boundary = f"----perfregression{random.Random(SEED).getrandbits(48):012x}"
+    head = (
+        f"--{boundary}\r\n"
+        'Content-Disposition: form-data; name="file"; filename="image.jpg"\r\n'
+        "Content-Type: image/jpeg\r\n\r\n"
+    ).encode("ascii")
+    tail = f"\r\n--{boundary}--\r\n".encode("ascii")
+    return head + jpeg + tail, f"multipart/form-data; boundary={boundary}"
+
+
+def _generated_jpeg(width: int, height: int) -> Optional[bytes]:
+    """Panel-sized gradient bars; None without Pillow."""
+    try:
+        import io
+        from PIL import Image, ImageDraw
+    except ImportError:
+        return None
+    rng = random.Random(SEED)
+    img = Image.new("RGB", (width, height))
+    draw = ImageDraw.Draw(img)
+    bars = 7
+    for i in range(bars):
+        color = (rng.randrange(256), rng.randrange(256), rng.randrange(256))
+        y0 = i * height // bars
+        y1 = (i + 1) * height // bars
+        for x in range(width):
+            f = x / max(1, width - 1)
+            draw.line([(x, y0), (x, y1)], fill=tuple(int(c * f) for c in color))
+    buf = io.BytesIO()
+    img.save(buf, format="JPEG", quality=85)
+    return buf.getvalue()
+
+
+def phase_image(dev: Device, rounds: int, jpeg: Optional[bytes]) -> Phase:
+    p = Phase("image")
+    if not jpeg:
+        p.skipped = "no JPEG (pass --image, or install Pillow to generate one)"
+        return p
+    body, ctype = _multipart_jpeg(jpeg)
+    for _ in range(rounds):
+        status, data, ms = dev.http("POST", "/api/display/image?timeout=0", body=body, content_type=ctype, retries=1)
+        if status == 404:
+            p.skipped = "image API not in this build"
+            return p
+        p.record("POST /api/display/image", status, ms)
+        # Let the decode finish before the next upload, as a user would.
+        time.sleep(1.0)
+        status, _, ms = dev.http("DELETE", "/api/display/image")
+        p.record("DELETE /api/display/image", status, ms)
+    return p
+
+
+def phase_screens(dev: Device, rounds: int, info: Dict[str, Any]) -> Phase:
+    p = Phase("screens")
+    screens = [s.get("id") for s in info.get("available_screens") or [] if isinstance(s, dict) and s.get("id")]
+    if not screens:
+        p.skipped = "no available_screens in /api/info"
+        return p
+    start = info.get("current_screen")
+    for _ in range(rounds):
+        for sid in screens:
+            body = json.dumps({"screen": sid}, separators=(",", ":")).encode("utf-8")
+            status, _, ms = dev.http("PUT", "/api/display/screen", body=body, content_type="application/json")
+            p.record("PUT /api/display/screen", status, ms)
+            time.sleep(0.1)
+    if isinstance(start, str) and start:
+        body = json.dumps({"screen": start}, separators=(",", ":")).encode("utf-8")
+        dev.http("PUT", "/api/display/screen", body=body, content_type="application/json")
+    return p
+
+
+def run_bench(dev: Device, jpeg: Optional[bytes], timeout_s: float) -> Dict[str, Any]:
+    status, data, _ = dev.http("POST", "/api/bench", body=jpeg or None, content_type="image/jpeg" if jpeg else None, retries=1)
+    if status == 404:
+        return {"skipped": "BENCH_ENABLED off in this build"}
+    if status != 202:
+        return {"skipped": f"POST /api/bench: HTTP {status} {data[:120]!r}"}
+    deadline = time.monotonic() + timeout_s
+    while time.monotonic() < deadline:
+        time.sleep(1.0)
+        res = dev.get_json("/api/bench")
+        if res and res.get("state") in ("done", "failed"):
+            return res
+    return {"skipped": f"no result within {timeout_s:.0f}s"}
+
+
+# ---------------------------------------------------------------------------
+# Metrics: a flat {name: {"value": v, "kind": k}} map, which is what compare reads.
+
+
+def _put(metrics: Dict[str, Dict[str, Any]], name: str, value: Any, kind: str) -> None:
+    if isinstance(value, bool) or not isinstance(value, (int, float)):
+        return
+    metrics[name] = {"value": value, "kind": kind}
+
+
+def collect_metrics(result: Dict[str, Any]) -> Dict[str, Dict[str, Any]]:
+    m: Dict[str, Dict[str, Any]] = {}
+
+    for name, ph in (result.get("host") or {}).items():
+        if ph.get("skipped"):
+            continue
+        _put(m, f"host.{name}.p50_ms", ph.get("p50_ms"), "ms")
+        _put(m, f"host.{name}.p95_ms", ph.get("p95_ms"), "ms")
+        _put(m, f"host.{name}.errors", ph.get("errors"), "errors")
+
+    routes = (result.get("device") or {}).get("routes") or {}
+    for r in routes.get("routes") or []:
+        key = f"route.{r.get('method')} {r.get('path')}"
+        _put(m, f"{key}.avg_us", r.get("avg_us"), "us")
+        _put(m, f"{key}.p95_ms", r.get("p95_ms"), "ms")
+        _put(m, f"{key}.heap_drop_max", r.get("heap_drop_max"), "bytes")
+
+    health = (result.get("device") or {}).get("health") or {}
+    for field in ("loop_pass_us_window", "lvgl_cycle_us_window", "http_service_us_window"):
+        q = health.get(field)
+        if isinstance(q, list) and len(q) == 4:
+            _put(m, f"health.{field}.p95", q[1], "us")
+            _put(m, f"health.{field}.max", q[3], "us")
+    _put(m, "health.loop_over_budget_window", health.get("loop_over_budget_window"), "count")
+    _put(m, "health.lvgl_over_budget_window", health.get("lvgl_over_budget_window"), "count")
+    _put(m, "health.heap_internal_free_min_window", health.get("heap_internal_free_min_window"), "free")
+    _put(m, "health.heap_internal_largest_min_window", health.get("heap_internal_largest_min_window"), "free")
+    _put(m, "health.heap_fragmentation_max_window", health.get("heap_fragmentation_max_window"), "pct")
+    _put(m, "health.psram_free_min_window", health.get("psram_free_min_window"), "free")
+    _put(m, "health.heap_min", health.get("heap_min"), "free")
+    for tag, heaps in (health.get("heap_tags") or {}).items():
+        for heap, row in (heaps or {}).items():
+            if isinstance(row, list) and len(row) == 5:
+                _put(m, f"heap_tags.{tag}.{heap}.peak", row[1], "bytes")
+                _put(m, f"heap_tags.{tag}.{heap}.failed", row[4], "errors")
+    for cls, row in (health.get("heap_place") or {}).items():
+        if isinstance(row, list) and len(row) == 4:
+            _put(m, f"heap_place.{cls}.failed", row[3], "errors")
+    arena = health.get("lvgl_arena")
+    if isinstance(arena, list) and len(arena) == 6:
+        _put(m, "lvgl_arena.peak", arena[2], "bytes")
+        _put(m, "lvgl_arena.overflow_allocs", arena[5], "errors")
+
+    bench = (result.get("device") or {}).get("bench") or {}
+    disp = bench.get("display") or {}
+    if disp.get("ran"):
+        _put(m, "bench.display.fill.mb_per_s", (disp.get("fill") or {}).get("mb_per_s"), "rate")
+        _put(m, "bench.display.flush.fps", (disp.get("flush") or {}).get("fps"), "rate")
+        _put(m, "bench.display.redraw.fps", (disp.get("redraw") or {}).get("fps"), "rate")
+        for t in disp.get("templates") or []:
+            _put(m, f"bench.display.template.{t.get('id')}.fps", t.get("fps"), "rate")
+    jpeg = bench.get("jpeg") or {}
+    _put(m, "bench.jpeg.strip.mp_per_s", (jpeg.get("strip") or {}).get("mp_per_s"), "rate")
+    _put(m, "bench.jpeg.full_frame.mp_per_s", (jpeg.get("full_frame") or {}).get("mp_per_s"), "rate")
+    ffat = bench.get("ffat") or {}
+    for k in ("write_mb_per_s", "seq_read_mb_per_s", "random_read_mb_per_s"):
+        _put(m, f"bench.ffat.{k}", ffat.get(k), "rate")
+    macros = bench.get("macros") or {}
+    _put(m, "bench.macros.encode_us", macros.get("encode_us"), "us")
+    _put(m, "bench.macros.decode_us", macros.get("decode_us"), "us")
+    for store in ("ffat", "nvs"):
+        s = macros.get(store) or {}
+        if s.get("ok"):
+            _put(m, f"bench.macros.{store}.save_us", s.get("save_us"), "us")
+            _put(m, f"bench.macros.{store}.load_us", s.get("load_us"), "us")
+    ducky = bench.get("ducky") or {}
+    _put(m, "bench.ducky.compile_kb_per_s", ducky.get("compile_kb_per_s"), "rate")
+    return m
+
+
+# ---------------------------------------------------------------------------
+# Baselines and comparison
+
+
+def _version_key(v: str) -> Tuple:
+    return tuple(int(x) if x.isdigit() else x for x in re.split(r"[.\-+]", v))
+
+
+def _safe_name(s: str) -> str:
+    return re.sub(r"[^A-Za-z0-9._-]", "_", s) or "unknown"
+
+
+def baseline_path(baseline_dir: str, board: str, version: str) -> str:
+    return os.path.join(baseline_dir, _safe_name(board), f"{_safe_name(version)}.json")
+
+
+def find_baseline(baseline_dir: str, board: str, version: str) -> Optional[str]:
+    """Same version if stored, else the newest older version for the board."""
+    exact = baseline_path(baseline_dir, board, version)
+    if os.path.isfile(exact):
+        return exact
+    board_dir = os.path.join(baseline_dir, _safe_name(board))
+    if not os.path.isdir(board_dir):
+        return None
+    mine = _version_key(version)
+    older = []
+    for name in os.listdir(board_dir):
+        if not name.endswith(".json"):
+            continue
+        v = name[: -len(".json")]
+        try:
+            if _version_key(v) < mine:
+                older.append((_version_key(v), name))
+        except TypeError:
+            continue
+    if not older:
+        return None
+    older.sort()
+    return os.path.join(board_dir, older[-1][1])
+
+
+def load_thresholds(path: Optional[str]) -> Tuple[Dict[str, Tuple[str, float, float]], List[Tuple[str, Dict[str, float]]]]:
+    """{"kinds": {"ms": {"pct": 30}}, "metrics": {"host.image.*": {"pct": 50, "abs": 20}}}"""
+    kinds = dict(DEFAULT_KINDS)
+    patterns: List[Tuple[str, Dict[str, float]]] = []
+    if not path:
+        return kinds, patterns
+    with open(path, "r", encoding="utf-8") as f:
+        cfg = json.load(f)
+    for kind, over in (cfg.get("kinds") or {}).items():
+        better, pct, abs_ = kinds.get(kind, ("lower", 0.0, 0.0))
+        kinds[kind] = (over.get("better", better), float(over.get("pct", pct)), float(over.get("abs", abs_)))
+    for pattern, over in (cfg.get("metrics") or {}).items():
+        patterns.append((pattern, over))
+    return kinds, patterns
+
+
+def compare(
+    current: Dict[str, Dict[str, Any]],
+    baseline: Dict[str, Dict[str, Any]],
+    kinds: Dict[str, Tuple[str, float, float]],
+    patterns: List[Tuple[str, Dict[str, float]]],
+) -> Dict[str, Any]:
+    rows = []
+    for name in sorted(set(current) | set(baseline)):
+        cur = current.get(name)
+        base = baseline.get(name)
+        if cur is None or base is None:
+            rows.append({"metric": name, "status": "missing" if cur is None else "new",
+                         "baseline": base and base["value"], "current": cur and cur["value"]})
+            continue
+        kind = cur.get("kind") or base.get("kind") or "ms"
+        better, pct, abs_ = kinds.get(kind, ("lower", 0.0, 0.0))
+        for pattern, over in patterns:
+            if fnmatch.fnmatchcase(name, pattern):
+                pct = float(over.get("pct", pct))
+                abs_ = float(over.get("abs", abs_))
+                if over.get("ignore"):
+                    better = "ignore"
+                break
+        b = float(base["value"])
+        c = float(cur["value"])
+        margin = abs(b) * pct / 100.0 + abs_
+        status = "ok"
+        if better == "lower":
+            limit = b + margin
+            if c > limit:
+                status = "regressed"
+            elif c < b - margin:
+                status = "improved"
+        elif better == "higher":
+            limit = b - margin
+            if c < limit:
+                status = "regressed"
+            elif c > b + margin:
+                status = "improved"
+        else:
+            limit = None
+            status = "ignored"
+        change = ((c - b) / b * 100.0) if b else None
+        rows.append({"metric": name, "status": status, "baseline": b, "current": c, "limit": limit,
+                     "change_pct": None if change is None else round(change, 1), "kind": kind})
+    regressed = [r for r in rows if r["status"] == "regressed"]
+    return {"passed": not regressed, "regressed": len(regressed), "rows": rows}
+
+
+def print_comparison(cmp: Dict[str, Any], baseline_label: str, verbose: bool) -> None:
+    print(f"\nBaseline: {baseline_label}")
+    counts: Dict[str, int] = {}
+    for r in cmp["rows"]:
+        counts[r["status"]] = counts.get(r["status"], 0) + 1
+        if r["status"] in ("regressed", "improved") or verbose:
+            change = "" if r.get("change_pct") is None else f" ({r['change_pct']:+.1f}%)"
+            limit = "" if r.get("limit") is None else f" limit={r['limit']:.2f}"
+            print(f"  {r['status']:<9} {r['metric']}: {r['baseline']} -> {r['current']}{change}{limit}")
+    print("Metrics: " + " ".join(f"{k}={v}" for k, v in sorted(counts.items())))
+    print("RESULT: " + ("PASS" if cmp["passed"] else f"FAIL ({cmp['regressed']} regressed)"))
+
+
+def _write_json(path: str, obj: Any) -> None:
+    os.makedirs(os.path.dirname(path) or ".", exist_ok=True)
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump(obj, f, indent=2, sort_keys=False)
+        f.write("\n")
+
+
+def _load_result(path: str) -> Dict[str, Any]:
+    with open(path, "r", encoding="utf-8") as f:
+        res = json.load(f)
+    if "metrics" not in res:
+        res["metrics"] = collect_metrics(res)
+    return res
+
+
+# ---------------------------------------------------------------------------
+
+
+def cmd_run(args: argparse.Namespace) -> int:
+    dev = Device(_normalize_base_url(args.host), _basic_auth_header(args.auth), args.timeout)
+
+    info = dev.get_json("/api/info")
+    if info is None:
+        print(f"ERROR: GET /api/info failed on {dev.base_url}", file=sys.stderr)
+        return 2
+    board = args.board or info.get("board_name") or "unknown"
+    version = args.version or info.get("version") or "unknown"
+    print(f"Device: {dev.base_url} board={board} version={version} chip={info.get('chip_model')}")
+
+    jpeg: Optional[bytes] = None
+    if args.image:
+        with open(args.image, "rb") as f:
+            jpeg = f.read()
+    elif not args.no_image:
+        w = int(info.get("display_coord_width") or 0)
+        h = int(info.get("display_coord_height") or 0)
+        if w and h:
+            jpeg = _generated_jpeg(w, h)
+
+    # Start clean windows: route profile cleared, /api/health window restarted.
+    routes_ok = dev.http("DELETE", "/api/routes")[0] == 200
+    if not routes_ok:
+        print("WARNING: /api/routes not available (PORTAL_ROUTE_PROFILE_ENABLED off?)", file=sys.stderr)
+    dev.get_json("/api/health")
+
+    phases: Dict[str, Dict[str, Any]] = {}
+    t0 = time.perf_counter()
+    for name, fn in (
+        ("portal", lambda: phase_portal(dev, args.rounds)),
+        ("macros", lambda: phase_macros(dev, args.rounds)),
+        ("image", lambda: phase_image(dev, max(1, args.rounds // 2), jpeg)),
+        ("screens", lambda: phase_screens(dev, max(1, args.rounds // 4), info)),
+    ):
+        ph = fn()
+        phases[name] = ph.summary()
+        s = phases[name]
+        if s.get("skipped"):
+            print(f"  {name:<8} skipped: {s['skipped']}")
+        else:
+            print(f"  {name:<8} requests={s['requests']} errors={s['errors']} p50={s.get('p50_ms')}ms p95={s.get('p95_ms')}ms")
+    wall_s = time.perf_counter() - t0
+
+    device: Dict[str, Any] = {"health": dev.get_json("/api/health")}
+    if routes_ok:
+        device["routes"] = dev.get_json("/api/routes")
+    if args.bench:
+        print("  bench    running on the device...")
+        device["bench"] = run_bench(dev, jpeg, args.bench_timeout)
+        if device["bench"].get("skipped"):
+            print(f"  bench    skipped: {device['bench']['skipped']}")
+
+    result: Dict[str, Any] = {
+        "meta": {
+            "timestamp": _now_iso(),
+            "host": dev.base_url,
+            "board": board,
+            "version": version,
+            "chip_model": info.get("chip_model"),
+            "scenario": SCENARIO_VERSION,
+            "rounds": args.rounds,
+            "image_bytes": len(jpeg) if jpeg else 0,
+            "wall_s": round(wall_s, 2),
+        },
+        "host": phases,
+        "device": device,
+    }
+    result["metrics"] = collect_metrics(result)
+
+    out = args.out or os.path.join(
+        _repo_root(), "artifacts", "perf", f"{_safe_name(board)}-{_safe_name(version)}-{datetime.now().strftime('%Y%m%d-%H%M%S')}.json"
+    )
+    _write_json(out, result)
+    print(f"Wrote: {out} ({len(result['metrics'])} metrics)")
+
+    if args.save_baseline:
+        path = baseline_path(args.baseline_dir, board, version)
+        _write_json(path, result)
+        print(f"Saved baseline: {path}")
+        return 0
+
+    base_file = args.baseline or find_baseline(args.baseline_dir, board, version)
+    if not base_file:
+        print(f"\nNo baseline for board {board} in {args.baseline_dir}; run with --save-baseline to store one.")
+        return 0
+    base = _load_result(base_file)
+    if (base.get("meta") or {}).get("scenario") != SCENARIO_VERSION:
+        print(f"WARNING: baseline was recorded with scenario {base.get('meta', {}).get('scenario')}, this is {SCENARIO_VERSION}", file=sys.stderr)
+    if (base.get("meta") or {}).get("rounds") != args.rounds:
+        print(f"WARNING: baseline used --rounds {base.get('meta', {}).get('rounds')}, this run {args.rounds}", file=sys.stderr)
+    kinds, patterns = load_thresholds(args.thresholds)
+    cmp = compare(result["metrics"], base["metrics"], kinds, patterns)
+    meta = base.get("meta") or {}
+    print_comparison(cmp, f"{base_file} (v{meta.get('version')}, {meta.get('timestamp')})", args.verbose)
+    if args.report:
+        _write_json(args.report, cmp)
+    return 0 if cmp["passed"] else 1
+
+
+def cmd_compare(args: argparse.Namespace) -> int:
+    cur = _load_result(args.current)
+    base = _load_result(args.baseline)
+    kinds, patterns = load_thresholds(args.thresholds)
+    cmp = compare(cur["metrics"], base["metrics"], kinds, patterns)
+    print_comparison(cmp, args.baseline, args.verbose)
+    if args.report:
+        _write_json(args.report, cmp)
+    return 0 if cmp["passed"] else 1
+
+
+def main(argv: List[str]) -> int:
+    ap = argparse.ArgumentParser(description="Release-over-release performance regression harness.")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    def add_compare_opts(p: argparse.ArgumentParser) -> None:
+        p.add_argument("--thresholds", help="JSON with per-kind or per-metric (glob) overrides of pct/abs, or ignore.")
+        p.add_argument("--report", help="Write the comparison rows to this JSON file.")
+        p.add_argument("-v", "--verbose", action="store_true", help="Print every metric, not only regressions and improvements.")
+
+    run = sub.add_parser("run", help="Run the scenario against a device and compare with its baseline.")
+    run.add_argument("--host", required=True)
+    run.add_argument("--auth", help="Portal Basic Auth as user:pass.")
+    run.add_argument("--timeout", type=float, default=DEFAULT_TIMEOUT_S)
+    run.add_argument("--rounds", type=int, default=8, help="Rounds per phase (image uses half, screens a quarter).")
+    run.add_argument("--image", help="JPEG for the image phase and the bench decode tests (default: generated, needs Pillow).")
+    run.add_argument("--no-image", action="store_true", help="Skip the image phase.")
+    run.add_argument("--bench", action="store_true", help="Also run the on-device benchmark (/api/bench).")
+    run.add_argument("--bench-timeout", type=float, default=120.0)
+    run.add_argument("--board", help="Override the board name from /api/info.")
+    run.add_argument("--version", help="Override the firmware version from /api/info.")
+    run.add_argument("--out", help="Result JSON (default: artifacts/perf/<board>-<version>-<time>.json).")
+    run.add_argument("--baseline", help="Compare with this file instead of looking one up.")
+    run.add_argument("--baseline-dir", default=os.path.join(_repo_root(), "perf-baselines"))
+    run.add_argument("--save-baseline", action="store_true", help="Store the result as the baseline for this board and version.")
+    add_compare_opts(run)
+    run.set_defaults(fn=cmd_run)
+
+    cmp = sub.add_parser("compare", help="Compare two stored results.")
+    cmp.add_argument("current")
+    cmp.add_argument("baseline")
+    add_compare_opts(cmp)
+    cmp.set_defaults(fn=cmd_compare)
+
+    args = ap.parse_args(argv)
+    if getattr(args, "rounds", 1) < 1:
+        print("rounds must be >= 1", file=sys.stderr)
+        return 2
+    return args.fn(args)
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv[1:]))
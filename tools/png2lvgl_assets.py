@@ -6,6 +6,17 @@ Requirements:
 
 Example:
     python3 tools/png2lvgl_assets.py assets/png src/app/png_assets.cpp src/app/png_assets.h --prefix img_
+
+Pre-scaled mask variants (ic_<name>_128, compiled only when ICON_MASK_PRESCALED):
+    python3 tools/png2lvgl_assets.py assets/icons_mono out.cpp out.h --prefix ic_ \
+        --format alpha_8bit --size 64 --resize --extra-sizes 128 --variant-guard ICON_MASK_PRESCALED
+
+Device icon blobs (for /api/icons/install and /api/icons/install_batch):
+    python3 tools/png2lvgl_assets.py assets/emoji --icn-dir build/icons --icn-batch build/icons.batch
+
+Icon pack for the read-only "icons" partition (POST to /api/icons/pack; add
+--icon-pack-swap for boards built with LVGL_COLOR_16_SWAP):
+    python3 tools/png2lvgl_assets.py assets/emoji --icon-pack build/icons.pack
 """
 
 from __future__ import annotations
@@ -13,6 +24,7 @@ from __future__ import annotations
 import argparse
 import os
 import re
+import struct
 import sys
 from dataclasses import dataclass
 from enum import Enum
@@ -64,6 +76,36 @@ class LvglImage:
     lv_cf: str
     map_name: str
     source_file: str
+    guard: str = ""  # emitted inside #if <guard> when set
+
+
+def _convert_image(img: "Image.Image", fmt: LvglColorFormat) -> "Tuple[bytes, str]":
+    if fmt == LvglColorFormat.TRUE_COLOR_ALPHA:
+        return _rgba_to_true_color_alpha_bytes(img), "LV_IMG_CF_TRUE_COLOR_ALPHA"
+    if fmt == LvglColorFormat.ALPHA_8BIT:
+        return _rgba_to_alpha8_bytes(img), "LV_IMG_CF_ALPHA_8BIT"
+    if fmt == LvglColorFormat.ALPHA_4BIT:
+        return _rgba_to_alpha4_bytes(img), "LV_IMG_CF_ALPHA_4BIT"
+    raise SystemExit(f"ERROR: Unsupported format: {fmt}")
+
+
+def _parse_sizes(text: str) -> List[int]:
+    sizes: List[int] = []
+    for part in (text or "").replace(",", " ").split():
+        n = int(part)
+        if n < 8 or n > 256:
+            raise SystemExit(f"ERROR: --extra-sizes entries must be 8..256, got {n}")
+        if n not in sizes:
+            sizes.append(n)
+    return sizes
+
+
+def _guard_groups(images: List[LvglImage]) -> "List[Tuple[str, List[LvglImage]]]":
+    # Unguarded images first, then one #if block per guard.
+    groups: "List[Tuple[str, List[LvglImage]]]" = [("", [i for i in images if not i.guard])]
+    for guard in sorted({i.guard for i in images if i.guard}):
+        groups.append((guard, [i for i in images if i.guard == guard]))
+    return groups
 
 
 def _load_png_rgba(png_path: str) -> "Image.Image":
@@ -92,6 +134,7 @@ def _enforce_or_resize_square(img: "Image.Image", png_path: str, size: int, resi
 
 def _rgba_to_true_color_alpha_bytes(img: "Image.Image") -> bytes:
     # LVGL TRUE_COLOR_ALPHA: RGB565 (LE, 2 bytes) + alpha (1 byte) per pixel.
+    # Boards with LV_COLOR_16_SWAP need _swap16_rgb565a8() on top.
     pixels = list(img.getdata())
     out = bytearray()
     out_extend = out.extend
@@ -106,6 +149,13 @@ def _rgba_to_true_color_alpha_bytes(img: "Image.Image") -> bytes:
     return bytes(out)
 
 
+def _swap16_rgb565a8(data: bytes) -> bytes:
+    # Same pixels with each RGB565 big-endian, as LVGL stores them under LV_COLOR_16_SWAP.
+    out = bytearray(data)
+    out[0::3], out[1::3] = out[1::3], out[0::3]
+    return bytes(out)
+
+
 def _rgba_to_alpha8_bytes(img: "Image.Image") -> bytes:
     pixels = list(img.getdata())
     out = bytearray(len(pixels))
@@ -136,6 +186,177 @@ def _rgba_to_alpha4_bytes(img: "Image.Image") -> bytes:
     return bytes(out)
 
 
+# ---- Device icon blobs (ICN1/ICN2, see src/app/icon_store.h) ----
+
+ICN_FORMAT_RGB565A8 = 1
+ICN_FORMAT_PALETTE8 = 2
+ICN_ENCODINGS = {"raw": 0, "rle": 1, "lz4": 2}
+
+
+def _packbits_encode(data: bytes, unit: int) -> bytes:
+    """PackBits over fixed-size units (see src/app/pixel_codec.h)."""
+    px = [data[i:i + unit] for i in range(0, len(data), unit)]
+    out = bytearray()
+    i = 0
+    n = len(px)
+    while i < n:
+        run = 1
+        while i + run < n and run < 129 and px[i + run] == px[i]:
+            run += 1
+        if run >= 2:
+            out.append(0x80 + run - 2)
+            out += px[i]
+            i += run
+            continue
+        start = i
+        while i < n and i - start < 128 and not (i + 1 < n and px[i + 1] == px[i]):
+            i += 1
+        if i == start:
+            i += 1
+        out.append(i - start - 1)
+        for p in px[start:i]:
+            out += p
+    return bytes(out)
+
+
+def _lz4_encode(data: bytes) -> "bytes | None":
+    try:
+        import lz4.block
+    except ImportError:
+        return None
+    return lz4.block.compress(data, store_size=False)
+
+
+def _palette_split(rgb565a8: bytes) -> "Tuple[bytes, bytes] | None":
+    """Palette + index bytes when the icon has at most 256 distinct pixels."""
+    entries = {}
+    indices = bytearray()
+    for i in range(0, len(rgb565a8), 3):
+        px = rgb565a8[i:i + 3]
+        if px[2] == 0:
+            px = b"\x00\x00\x00"  # All transparent pixels share one entry.
+        k = entries.get(px)
+        if k is None:
+            if len(entries) == 256:
+                return None
+            k = len(entries)
+            entries[px] = k
+        indices.append(k)
+    palette = b"".join(sorted(entries, key=entries.get))
+    return palette, bytes(indices)
+
+
+def _icn_blob(width: int, height: int, fmt: int, encoding: int, palette_count: int, data: bytes) -> bytes:
+    if fmt == ICN_FORMAT_RGB565A8 and encoding == 0:
+        # Plain ICN1 stays readable by older firmware.
+        return b"ICN1" + struct.pack("<HHB3xI", width, height, fmt, len(data)) + data
+    return b"ICN2" + struct.pack("<HHBBHI", width, height, fmt, encoding, palette_count, len(data)) + data
+
+
+def _icn_variants(img: "Image.Image") -> "List[Tuple[str, bytes]]":
+    """Every encodable (name, blob) for an icon, ICN1 first."""
+    width, height = img.size
+    pixels = _rgba_to_true_color_alpha_bytes(img)
+
+    variants = [("rgb565a8/raw", _icn_blob(width, height, ICN_FORMAT_RGB565A8, 0, 0, pixels))]
+    variants.append(("rgb565a8/rle", _icn_blob(width, height, ICN_FORMAT_RGB565A8, 1, 0, _packbits_encode(pixels, 3))))
+    lz = _lz4_encode(pixels)
+    if lz is not None:
+        variants.append(("rgb565a8/lz4", _icn_blob(width, height, ICN_FORMAT_RGB565A8, 2, 0, lz)))
+
+    split = _palette_split(pixels)
+    if split is not None:
+        palette, indices = split
+        count = len(palette) // 3
+        variants.append(("palette/raw", _icn_blob(width, height, ICN_FORMAT_PALETTE8, 0, count, palette + indices)))
+        variants.append(("palette/rle", _icn_blob(width, height, ICN_FORMAT_PALETTE8, 1, count, palette + _packbits_encode(indices, 1))))
+        lz = _lz4_encode(indices)
+        if lz is not None:
+            variants.append(("palette/lz4", _icn_blob(width, height, ICN_FORMAT_PALETTE8, 2, count, palette + lz)))
+    return variants
+
+
+def _pick_icn_variant(variants: "List[Tuple[str, bytes]]", fmt: str, encoding: str) -> "Tuple[str, bytes]":
+    candidates = [
+        v for v in variants
+        if (fmt == "auto" or v[0].startswith(fmt + "/"))
+        and (encoding == "auto" or v[0].endswith("/" + encoding))
+    ]
+    if not candidates:
+        raise SystemExit(
+            f"ERROR: No icon encoding matches --icn-format {fmt} --icn-encoding {encoding}.\n"
+            "  palette needs at most 256 distinct pixels; lz4 needs the 'lz4' package (pip install lz4)."
+        )
+    return min(candidates, key=lambda v: len(v[1]))
+
+
+def _write_icn_blobs(
+    images: "List[Tuple[str, Image.Image]]", out_dir: str, batch_path: str, fmt: str, encoding: str
+) -> None:
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+    batch = bytearray()
+    total_icn1 = 0
+    total_out = 0
+
+    print(f"✓ Icon blobs: {len(images)} file(s) (sizes in bytes; * = written)")
+    for icon_id, img in images:
+        variants = _icn_variants(img)
+        name, blob = _pick_icn_variant(variants, fmt, encoding)
+        total_icn1 += len(variants[0][1])
+        total_out += len(blob)
+
+        sizes = "  ".join(f"{'*' if n == name else ''}{n}={len(b)}" for n, b in variants)
+        print(f"  - {icon_id}: {sizes}")
+
+        if out_dir:
+            with open(os.path.join(out_dir, f"{icon_id}.bin"), "wb") as f:
+                f.write(blob)
+        id_bytes = icon_id.encode("ascii")
+        batch += bytes([len(id_bytes)]) + id_bytes + struct.pack("<I", len(blob)) + blob
+
+    pct = (100.0 * total_out / total_icn1) if total_icn1 else 100.0
+    print(f"✓ Icon blobs total: {total_out} bytes ({pct:.0f}% of {total_icn1} as ICN1)")
+    if out_dir:
+        print(f"✓ Wrote {out_dir}/*.bin")
+    if batch_path:
+        os.makedirs(os.path.dirname(batch_path) or ".", exist_ok=True)
+        with open(batch_path, "wb") as f:
+            f.write(batch)
+        print(f"✓ Wrote {batch_path} ({len(batch)} bytes, POST to /api/icons/install_batch)")
+
+
+def _write_icon_pack(images: "List[Tuple[str, Image.Image]]", path: str, swap16: bool) -> None:
+    """Raw RGB565+A8 payloads and a sorted index; layout in src/app/icon_pack.h."""
+    header_bytes = 16
+    entries = []
+    payload = bytearray()
+    for icon_id, img in sorted(images, key=lambda item: item[0].encode("ascii")):
+        width, height = img.size
+        pixels = _rgba_to_true_color_alpha_bytes(img)
+        if swap16:
+            pixels = _swap16_rgb565a8(pixels)
+        payload += b"\0" * (-(header_bytes + len(payload)) % 4)
+        entries.append((icon_id, header_bytes + len(payload), len(pixels), width, height))
+        payload += pixels
+
+    index_offset = header_bytes + len(payload)
+    index_offset += -index_offset % 4
+    index = bytearray()
+    for icon_id, offset, data_len, width, height in entries:
+        index += struct.pack("<32sIIHHBBH", icon_id.encode("ascii"), offset, data_len, width, height, 1, 0, 0)
+
+    pack = bytearray(b"ICP1" + struct.pack("<III", len(entries), index_offset, 1 if swap16 else 0))
+    pack += payload
+    pack += b"\0" * (index_offset - len(pack))
+    pack += index
+
+    os.makedirs(os.path.dirname(path) or ".", exist_ok=True)
+    with open(path, "wb") as f:
+        f.write(pack)
+    print(f"✓ Wrote {path} ({len(entries)} icons, {len(pack)} bytes, POST to /api/icons/pack)")
+
+
 def _list_top_level_pngs(input_dir: str) -> List[str]:
     try:
         entries = os.listdir(input_dir)
@@ -184,8 +405,15 @@ def _write_header(path_h: str, images: List[LvglImage]) -> None:
         f.write("extern \"C\" {\n")
         f.write("#endif\n\n")
         f.write("// PNG asset declarations\n")
-        for img in images:
-            f.write(f"extern const lv_img_dsc_t {img.symbol};\n")
+        for guard, group in _guard_groups(images):
+            if not group:
+                continue
+            if guard:
+                f.write(f"\n#if {guard}\n")
+            for img in group:
+                f.write(f"extern const lv_img_dsc_t {img.symbol};\n")
+            if guard:
+                f.write(f"#endif // {guard}\n")
         f.write("\n#ifdef __cplusplus\n")
         f.write("}\n")
         f.write("#endif\n")
@@ -193,6 +421,19 @@ def _write_header(path_h: str, images: List[LvglImage]) -> None:
         f.write(f"#endif // {guard}\n")
 
 
+def _write_map(f, map_name: str, data: bytes) -> None:
+    f.write(f"const LV_ATTRIBUTE_MEM_ALIGN LV_ATTRIBUTE_IMG_ uint8_t {map_name}[] = {{\n")
+    # Write 12 bytes per line (4 pixels * 3 bytes)
+    for i in range(0, len(data), 12):
+        chunk = data[i : i + 12]
+        hexes = ", ".join(f"0x{b:02x}" for b in chunk)
+        if i + 12 < len(data):
+            f.write(f"  {hexes},\n")
+        else:
+            f.write(f"  {hexes}\n")
+    f.write("};\n")
+
+
 def _write_c(path_c: str, header_basename: str, images: List[LvglImage]) -> None:
     with open(path_c, "w", encoding="utf-8") as f:
         f.write("/*\n")
@@ -212,35 +453,38 @@ def _write_c(path_c: str, header_basename: str, images: List[LvglImage]) -> None
         f.write("#define LV_ATTRIBUTE_IMG_\n")
         f.write("#endif\n\n")
 
-        for img in images:
-            f.write(f"// {img.width}x{img.height} RGBA PNG: {os.path.basename(img.source_file)}\n")
-            f.write(
-                f"const LV_ATTRIBUTE_MEM_ALIGN LV_ATTRIBUTE_IMG_ uint8_t {img.map_name}[] = {{\n"
-            )
-
-            data = img.data
-            # Write 12 bytes per line (4 pixels * 3 bytes)
-            for i in range(0, len(data), 12):
-                chunk = data[i : i + 12]
-                hexes = ", ".join(f"0x{b:02x}" for b in chunk)
-                if i + 12 < len(data):
-                    f.write(f"  {hexes},\n")
+        for guard, group in _guard_groups(images):
+            if not group:
+                continue
+            if guard:
+                f.write(f"#if {guard}\n\n")
+            for img in group:
+                f.write(f"// {img.width}x{img.height} RGBA PNG: {os.path.basename(img.source_file)}\n")
+                data = img.data
+                if img.lv_cf == "LV_IMG_CF_TRUE_COLOR_ALPHA":
+                    # LVGL reads TRUE_COLOR pixels in its own lv_color_t byte order.
+                    f.write("#if LV_COLOR_16_SWAP\n")
+                    _write_map(f, img.map_name, _swap16_rgb565a8(data))
+                    f.write("#else\n")
+                    _write_map(f, img.map_name, data)
+                    f.write("#endif\n\n")
                 else:
-                    f.write(f"  {hexes}\n")
-
-            f.write("};\n\n")
-
-            f.write(f"const lv_img_dsc_t {img.symbol} = {{\n")
-            f.write("  {\n")
-            f.write(f"    {img.lv_cf},\n")
-            f.write("    0,\n")
-            f.write("    0,\n")
-            f.write(f"    {img.width},\n")
-            f.write(f"    {img.height},\n")
-            f.write("  },\n")
-            f.write(f"  {len(data)},\n")
-            f.write(f"  {img.map_name},\n")
-            f.write("};\n\n")
+                    _write_map(f, img.map_name, data)
+                    f.write("\n")
+
+                f.write(f"const lv_img_dsc_t {img.symbol} = {{\n")
+                f.write("  {\n")
+                f.write(f"    {img.lv_cf},\n")
+                f.write("    0,\n")
+                f.write("    0,\n")
+                f.write(f"    {img.width},\n")
+                f.write(f"    {img.height},\n")
+                f.write("  },\n")
+                f.write(f"  {len(data)},\n")
+                f.write(f"  {img.map_name},\n")
+                f.write("};\n\n")
+            if guard:
+                f.write(f"#endif // {guard}\n\n")
 
         f.write("#endif // HAS_DISPLAY\n")
 
@@ -248,8 +492,8 @@ def _write_c(path_c: str, header_basename: str, images: List[LvglImage]) -> None
 def main() -> int:
     ap = argparse.ArgumentParser(description="Convert PNGs to LVGL C arrays")
     ap.add_argument("input_dir", help="Directory containing PNG files (top-level only)")
-    ap.add_argument("output_c", help="Output .c file path")
-    ap.add_argument("output_h", help="Output .h file path")
+    ap.add_argument("output_c", nargs="?", help="Output .c file path")
+    ap.add_argument("output_h", nargs="?", help="Output .h file path")
     ap.add_argument("--prefix", default="img_", help="Symbol name prefix (default: img_)")
     ap.add_argument(
         "--format",
@@ -268,9 +512,46 @@ def main() -> int:
         action="store_true",
         help="If --size is set and PNGs are not the right size, auto-resize to the requested size.",
     )
+    ap.add_argument(
+        "--extra-sizes",
+        default="",
+        help="Also emit <symbol>_<N> variants at these square sizes (e.g. 128), resampled from the source PNG.",
+    )
+    ap.add_argument(
+        "--variant-guard",
+        default="",
+        help="Wrap the --extra-sizes variants in #if <MACRO> (e.g. ICON_MASK_PRESCALED).",
+    )
+    ap.add_argument("--icn-dir", default="", help="Also write device icon blobs (<id>.bin) to this directory.")
+    ap.add_argument("--icn-batch", default="", help="Also write one /api/icons/install_batch body to this file.")
+    ap.add_argument(
+        "--icn-format",
+        default="auto",
+        choices=["auto", "rgb565a8", "palette"],
+        help="Icon blob pixel format (default: auto = smallest)",
+    )
+    ap.add_argument(
+        "--icn-encoding",
+        default="auto",
+        choices=["auto"] + list(ICN_ENCODINGS),
+        help="Icon blob encoding (default: auto = smallest; lz4 needs 'pip install lz4')",
+    )
+    ap.add_argument("--icon-pack", default="", help="Also write an icon pack (raw RGB565+A8) for the icons partition.")
+    ap.add_argument(
+        "--icon-pack-swap",
+        action="store_true",
+        help="Store the pack's RGB565 byte-swapped (boards built with LVGL_COLOR_16_SWAP).",
+    )
 
     args = ap.parse_args()
 
+    want_c = bool(args.output_c or args.output_h)
+    want_icn = bool(args.icn_dir or args.icn_batch or args.icon_pack)
+    if want_c and not (args.output_c and args.output_h):
+        ap.error("output_c and output_h go together")
+    if not want_c and not want_icn:
+        ap.error("give output_c/output_h and/or --icn-dir/--icn-batch/--icon-pack")
+
     input_dir = args.input_dir
     output_c = args.output_c
     output_h = args.output_h
@@ -278,6 +559,11 @@ def main() -> int:
     fmt = LvglColorFormat(args.format)
     size = int(args.size or 0)
     resize = bool(args.resize)
+    extra_sizes = [n for n in _parse_sizes(args.extra_sizes) if n != size]
+    if extra_sizes and size <= 0:
+        ap.error("--extra-sizes needs --size")
+    if args.variant_guard and not _VALID_C_IDENT.match(args.variant_guard):
+        ap.error("--variant-guard must be a C identifier")
 
     if not os.path.isdir(input_dir):
         raise SystemExit(f"ERROR: Input directory not found: {input_dir}")
@@ -285,6 +571,7 @@ def main() -> int:
     png_files = _list_top_level_pngs(input_dir)
 
     images: List[LvglImage] = []
+    icn_images = []
     seen_symbols = set()
 
     for png_path in png_files:
@@ -303,24 +590,20 @@ def main() -> int:
             )
         seen_symbols.add(symbol)
 
-        img = _load_png_rgba(png_path)
+        src_img = _load_png_rgba(png_path)
+        img = src_img
         if size > 0:
             img = _enforce_or_resize_square(img, png_path, size=size, resize=resize)
 
         width, height = img.size
-
-        if fmt == LvglColorFormat.TRUE_COLOR_ALPHA:
-            data = _rgba_to_true_color_alpha_bytes(img)
-            lv_cf = "LV_IMG_CF_TRUE_COLOR_ALPHA"
-        elif fmt == LvglColorFormat.ALPHA_8BIT:
-            data = _rgba_to_alpha8_bytes(img)
-            lv_cf = "LV_IMG_CF_ALPHA_8BIT"
-        elif fmt == LvglColorFormat.ALPHA_4BIT:
-            data = _rgba_to_alpha4_bytes(img)
-            lv_cf = "LV_IMG_CF_ALPHA_4BIT"
-        else:
-            raise SystemExit(f"ERROR: Unsupported format: {fmt}")
-
+        if want_icn:
+            if width > 256 or height > 256:
+                raise SystemExit(f"ERROR: Device icons are limited to 256x256: {png_path}")
+            if len(base) >= 32 or not re.match(r"^[a-z0-9_]+$", base):
+                raise SystemExit(f"ERROR: Device icon ids must be [a-z0-9_]+ and shorter than 32: {png_path}")
+            icn_images.append((base, img))
+
+        data, lv_cf = _convert_image(img, fmt)
         images.append(
             LvglImage(
                 symbol=symbol,
@@ -333,6 +616,42 @@ def main() -> int:
             )
         )
 
+        # Resample each variant from the source so large sizes stay sharp
+        # when the PNG is exported above the base size.
+        for n in extra_sizes:
+            variant = src_img if src_img.size == (n, n) else src_img.resize((n, n), resample=Image.Resampling.LANCZOS)
+            vdata, vcf = _convert_image(variant, fmt)
+            vsymbol = f"{symbol}_{n}"
+            images.append(
+                LvglImage(
+                    symbol=vsymbol,
+                    width=n,
+                    height=n,
+                    data=vdata,
+                    lv_cf=vcf,
+                    map_name=f"{vsymbol}_map",
+                    source_file=png_path,
+                    guard=args.variant_guard,
+                )
+            )
+
+    all_symbols = [i.symbol for i in images]
+    for sym in all_symbols:
+        if all_symbols.count(sym) > 1:
+            raise SystemExit(
+                "ERROR: A size variant collides with another PNG's symbol.\n"
+                f"  Symbol: {sym}\n"
+                "\n"
+                "Fix: rename the PNG whose name ends in _<size>."
+            )
+
+    if args.icn_dir or args.icn_batch:
+        _write_icn_blobs(icn_images, args.icn_dir, args.icn_batch, args.icn_format, args.icn_encoding)
+    if args.icon_pack:
+        _write_icon_pack(icn_images, args.icon_pack, args.icon_pack_swap)
+    if not want_c:
+        return 0
+
     os.makedirs(os.path.dirname(output_h) or ".", exist_ok=True)
     os.makedirs(os.path.dirname(output_c) or ".", exist_ok=True)
 
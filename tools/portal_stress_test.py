@@ -17,6 +17,8 @@ Scenarios:
 Notes:
 - Requires --no-reboot and always uses ?no_reboot=1 when saving config.
 - Uses /api/health as the single source of metrics.
+- --routes also clears the per-route profile (/api/routes) at the start and prints
+  each route's device-side latency, bytes and heap drop at the end.
 """
 
 from __future__ import annotations
@@ -435,6 +437,48 @@ def summarize(samples: list[HealthSample]) -> None:
         print(f"  {field:18s} {_minmax(vals)}")
 
 
+def reset_routes(base_url: str, timeout_s: float, retries: int, retry_sleep_s: float) -> bool:
+    status, _ = _http(
+        base_url,
+        method="DELETE",
+        path="/api/routes",
+        timeout_s=timeout_s,
+        retries=retries,
+        retry_sleep_s=retry_sleep_s,
+    )
+    return status == 200
+
+
+def get_routes(base_url: str, timeout_s: float, retries: int, retry_sleep_s: float) -> Optional[Dict[str, Any]]:
+    status, data = _http(
+        base_url,
+        method="GET",
+        path="/api/routes",
+        timeout_s=timeout_s,
+        accept="application/json",
+        retries=retries,
+        retry_sleep_s=retry_sleep_s,
+    )
+    if status != 200:
+        return None
+    try:
+        return json.loads(data.decode("utf-8", errors="replace"))
+    except Exception:
+        return None
+
+
+def summarize_routes(profile: Dict[str, Any]) -> None:
+    routes = sorted(profile.get("routes", []), key=lambda r: r.get("max_us", 0), reverse=True)
+    print(f"\nRoutes (device-side, {profile.get('since_ms', 0) / 1000.0:.1f}s, untimed={profile.get('untimed', 0)}):")
+    print(f"  {'method':6s} {'path':32s} {'count':>6s} {'avg_ms':>8s} {'p95_ms':>7s} {'max_ms':>8s} {'out_B':>9s} {'in_B':>9s} {'heap_drop':>9s}")
+    for r in routes:
+        print(
+            f"  {r.get('method', ''):6s} {r.get('path', ''):32s} {r.get('count', 0):6d} "
+            f"{r.get('avg_us', 0) / 1000.0:8.2f} {r.get('p95_ms', 0):7d} {r.get('max_us', 0) / 1000.0:8.2f} "
+            f"{r.get('bytes_out', 0):9d} {r.get('bytes_in', 0):9d} {r.get('heap_drop_max', 0):9d}"
+        )
+
+
 def write_csv(path: str, samples: list[HealthSample]) -> None:
     with open(path, "w", newline="") as f:
         w = csv.writer(f)
@@ -533,6 +577,16 @@ def main(argv: list[str]) -> int:
         default=None,
         help="Optional CSV output path (writes all samples).",
     )
+    p.add_argument(
+        "--routes",
+        action="store_true",
+        help="Reset /api/routes before the run and print per-route device timings after it.",
+    )
+    p.add_argument(
+        "--routes-out",
+        default=None,
+        help="With --routes: also write the final /api/routes JSON to this path.",
+    )
 
     args = p.parse_args(argv)
 
@@ -556,6 +610,14 @@ def main(argv: list[str]) -> int:
 
     samples: list[HealthSample] = []
 
+    if args.routes:
+        try:
+            routes_ok = reset_routes(base_url, timeout_s=args.timeout, retries=args.retries, retry_sleep_s=args.retry_sleep)
+        except RuntimeError:
+            routes_ok = False
+        if not routes_ok:
+            print("WARNING: /api/routes not available (PORTAL_ROUTE_PROFILE_ENABLED off?)", file=sys.stderr)
+
     try:
         # Baseline samples
         health0 = get_health(base_url, timeout_s=args.timeout, retries=args.retries, retry_sleep_s=args.retry_sleep)
@@ -682,6 +744,18 @@ def main(argv: list[str]) -> int:
             print(f"cycle {i:3d}/{args.cycles}: heap_largest={hl} heap_fragmentation={frag}")
     finally:
         summarize(samples)
+        if args.routes:
+            try:
+                profile = get_routes(base_url, timeout_s=args.timeout, retries=args.retries, retry_sleep_s=args.retry_sleep)
+            except RuntimeError as e:
+                print(f"WARNING: GET /api/routes failed: {e}", file=sys.stderr)
+                profile = None
+            if profile is not None:
+                summarize_routes(profile)
+                if args.routes_out:
+                    with open(args.routes_out, "w", encoding="utf-8") as f:
+                        json.dump(profile, f, indent=2)
+                    print(f"Wrote routes: {args.routes_out}")
 
     if args.out:
         write_csv(args.out, samples)
@@ -12,6 +12,12 @@ Usage:
     
     # Upload in strip mode (memory efficient)
     ./upload_image.py 192.168.1.100 --image photo.jpg --mode strip
+
+    # Same strips over one WebSocket connection (needs websocket-client)
+    ./upload_image.py 192.168.1.100 --image photo.jpg --mode ws
+
+    # Same strips to every device in multicast group 239.1.2.3 (IMAGE_API_MULTICAST)
+    ./upload_image.py 239.1.2.3 --image photo.jpg --mode mcast --repeat 3
     
     # Generate and upload test image
     ./upload_image.py 192.168.1.100 --generate 320x240
@@ -19,8 +25,15 @@ Usage:
     # Use mDNS hostname
     ./upload_image.py esp32-device.local --image photo.jpg --timeout 30
 
+    # Show where the device spent the time (receive, decode, push, ...)
+    ./upload_image.py 192.168.1.100 --image photo.jpg --stats
+
+    # Compare dual-core and single-core decode times (10 uploads each)
+    ./upload_image.py 192.168.1.100 --generate --restart-rows 1 --bench 10
+
 Dependencies:
     pip install requests pillow
+    pip install websocket-client   # --mode ws only
 """
 
 import argparse
@@ -28,6 +41,9 @@ import sys
 import os
 import io
 import random
+import socket
+import struct
+import time
 import requests
 from PIL import Image, ImageDraw, ImageFont
 from pathlib import Path
@@ -217,11 +233,24 @@ def generate_worst_case_image(width: int, height: int, quality: int = 85, seed:
     return jpeg_bytes
 
 
-def upload_full_image(host: str, jpeg_data: bytes, timeout: int, verbose: bool = False) -> bool:
-    """Upload full JPEG image (deferred decode mode)."""
+def upload_full_image(host: str, jpeg_data: bytes, timeout: int, verbose: bool = False, center: bool = True,
+                      parallel: bool = True) -> bool:
+    """Upload full JPEG image (deferred decode mode).
+
+    Images larger than the panel are scaled down on the device (1/2, 1/4, 1/8);
+    smaller ones are centered unless center=False. parallel=False keeps the
+    device on its single-core decoder.
+    """
     url = f"http://{host}/api/display/image"
+    params = []
     if timeout > 0:
-        url += f"?timeout={timeout}"
+        params.append(f"timeout={timeout}")
+    if not center:
+        params.append("center=0")
+    if not parallel:
+        params.append("parallel=0")
+    if params:
+        url += "?" + "&".join(params)
     
     print_info(f"Uploading {len(jpeg_data)} bytes to {url}")
     
@@ -290,6 +319,9 @@ def upload_strip_mode(host: str, jpeg_data: bytes, strip_height: int, timeout: i
     print_info(f"Image: {width}x{height}, {num_strips} strips")
     
     url = f"http://{host}/api/display/image/strips"
+
+    # Keep-alive session: one TCP connection for all strips.
+    session = requests.Session()
     
     for strip_index, strip_data in strips:
         params = {
@@ -308,7 +340,14 @@ def upload_strip_mode(host: str, jpeg_data: bytes, strip_height: int, timeout: i
         try:
             # Send as raw POST body data
             headers = {'Content-Type': 'image/jpeg'}
-            response = requests.post(url, params=params, data=strip_data, headers=headers, timeout=30)
+            # The device queues a few strips for decode; 409 means its queue is
+            # full (back-pressure), so retry shortly instead of failing.
+            deadline = time.monotonic() + 10.0
+            while True:
+                response = session.post(url, params=params, data=strip_data, headers=headers, timeout=30)
+                if response.status_code != 409 or time.monotonic() >= deadline:
+                    break
+                time.sleep(0.01)
             
             if verbose:
                 print(f"\n  Response: {response.status_code} {response.text}")
@@ -333,6 +372,334 @@ def upload_strip_mode(host: str, jpeg_data: bytes, strip_height: int, timeout: i
     return True
 
 
+WS_HEADER = struct.Struct('<BBHHHHHBBH')
+WS_ACK = struct.Struct('<HBB')
+WS_STATUS = {0: 'ok', 1: 'busy', 2: 'bad request', 3: 'too large', 4: 'no memory', 5: 'unsupported'}
+
+
+def upload_ws_mode(host: str, jpeg_data: bytes, strip_height: int, timeout: int, quality: int = 85, verbose: bool = False) -> bool:
+    """Upload image strips over the /api/display/ws WebSocket (one connection, acked messages)."""
+    try:
+        import websocket
+    except ImportError:
+        print_error("--mode ws needs the websocket-client package (pip install websocket-client)")
+        return False
+
+    print_info(f"Splitting image into {strip_height}px strips (quality {quality}%)...")
+    strips, width, height = split_jpeg_into_strips(jpeg_data, strip_height, quality)
+    num_strips = len(strips)
+    print_info(f"Image: {width}x{height}, {num_strips} strips over ws://{host}/api/display/ws")
+
+    try:
+        ws = websocket.create_connection(f"ws://{host}/api/display/ws", timeout=10)
+    except Exception as e:
+        print_error(f"WebSocket connect failed: {e}")
+        return False
+
+    def send(index: int, seq: int):
+        header = WS_HEADER.pack(1, 0, seq, index, num_strips, width, height, 0, 0,
+                                timeout if index == 0 and timeout > 0 else 0)
+        ws.send_binary(header + strips[index][1])
+
+    # Keep no more strips in flight than the device has queue slots: strips must
+    # arrive in order, so a BUSY strip overtaken by a later one restarts the image.
+    t0 = time.time()
+    next_index = 0
+    seq = 0
+    window = 1
+    inflight = {}
+    deadline = time.monotonic() + 30.0
+    try:
+        while next_index < num_strips or inflight:
+            while next_index < num_strips and len(inflight) < window:
+                seq = (seq + 1) & 0xFFFF
+                send(next_index, seq)
+                inflight[seq] = next_index
+                next_index += 1
+
+            ack_seq, status, free_slots = WS_ACK.unpack(ws.recv()[:WS_ACK.size])
+            index = inflight.pop(ack_seq, None)
+            if verbose:
+                print(f"  ack seq={ack_seq} strip={index} status={WS_STATUS.get(status, status)} free={free_slots}")
+            if index is None:
+                continue
+
+            if status == 0:
+                window = max(1, len(inflight) + free_slots)
+                continue
+            if status != 1 or time.monotonic() >= deadline:
+                print_error(f"Strip {index} rejected: {WS_STATUS.get(status, status)}")
+                return False
+
+            # BUSY: let the rest drain, then resend from here (or from 0 if a
+            # later strip already got in).
+            while inflight:
+                later_seq, later_status, _ = WS_ACK.unpack(ws.recv()[:WS_ACK.size])
+                later = inflight.pop(later_seq, None)
+                if later is not None and later_status == 0 and later > index:
+                    index = 0
+            next_index = index
+            window = 1
+            time.sleep(0.01)
+    except Exception as e:
+        print_error(f"WebSocket error: {e}")
+        return False
+    finally:
+        ws.close()
+
+    print_success(f"All {num_strips} strips acked in {(time.time() - t0) * 1000.0:.0f} ms")
+    return True
+
+
+MCAST_HEADER = struct.Struct('<BBHBBHHHHHBBIH')
+MCAST_DATA = 1
+MCAST_PARITY = 2
+
+
+def upload_mcast_mode(group: str, jpeg_data: bytes, strip_height: int, timeout: int, quality: int = 85,
+                      port: int = 5010, frag_bytes: int = 1200, fec: int = 4, repeat: int = 3,
+                      gap_ms: float = 2.0, ttl: int = 1, frame: Optional[int] = None, verbose: bool = False) -> bool:
+    """Send image strips to a multicast group (see src/app/image_mcast.h).
+
+    There are no acks: each group of `fec` fragments gets an XOR parity fragment
+    (one loss per group is rebuilt on the device), and the whole image is sent
+    `repeat` times so a device that lost a strip picks up from there on the next
+    pass. Datagrams are paced `gap_ms` apart: the device buffers only a few.
+    """
+    print_info(f"Splitting image into {strip_height}px strips (quality {quality}%)...")
+    strips, width, height = split_jpeg_into_strips(jpeg_data, strip_height, quality)
+    num_strips = len(strips)
+    if num_strips > 255:
+        print_error(f"{num_strips} strips; multicast takes at most 255 (raise --strip-height)")
+        return False
+
+    frame = random.randrange(0x10000) if frame is None else frame & 0xFFFF
+    timeout_s = min(max(timeout, 0), 0xFFFF)
+    datagrams = []
+    for index, strip in strips:
+        frag_count = (len(strip) + frag_bytes - 1) // frag_bytes
+        if frag_count > 256:
+            print_error(f"Strip {index} needs {frag_count} fragments (device limit 256 by default); "
+                        f"lower --strip-height or raise --frag-bytes")
+            return False
+        frags = [strip[i * frag_bytes:(i + 1) * frag_bytes] for i in range(frag_count)]
+
+        def header(kind: int, frag_index: int) -> bytes:
+            return MCAST_HEADER.pack(1, kind, frame, index, num_strips, width, height,
+                                     frag_index, frag_count, frag_bytes, fec, 0, len(strip), timeout_s)
+
+        for g in range(0, frag_count, fec or frag_count):
+            group_frags = frags[g:g + (fec or frag_count)]
+            for i, payload in enumerate(group_frags):
+                datagrams.append(header(MCAST_DATA, g + i) + payload)
+            if fec:
+                parity = bytearray(frag_bytes)
+                for payload in group_frags:
+                    for b, v in enumerate(payload):
+                        parity[b] ^= v
+                datagrams.append(header(MCAST_PARITY, g // fec) + bytes(parity))
+
+    print_info(f"Image: {width}x{height}, {num_strips} strips, {len(datagrams)} datagrams per pass "
+               f"to {group}:{port} (frame {frame}, {repeat} pass(es))")
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, ttl)
+    t0 = time.time()
+    try:
+        for n in range(repeat):
+            for d in datagrams:
+                sock.sendto(d, (group, port))
+                time.sleep(gap_ms / 1000.0)
+            if verbose:
+                print(f"  pass {n + 1}/{repeat} sent")
+    except OSError as e:
+        print_error(f"Send failed: {e}")
+        return False
+    finally:
+        sock.close()
+
+    print_success(f"Sent {repeat} pass(es) in {(time.time() - t0) * 1000.0:.0f} ms "
+                  f"(nothing is acked: check image_mcast_* in /api/health)")
+    return True
+
+
+def rgb565_bytes(img: Image.Image, big_endian: bool = True) -> bytes:
+    """Pack an image as RGB565 pixels (MSB-first by default, the SPI panel wire order)."""
+    rgb = img.convert('RGB')
+    out = bytearray()
+    for r, g, b in rgb.getdata():
+        v = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+        out += v.to_bytes(2, 'big' if big_endian else 'little')
+    return bytes(out)
+
+
+def rle565_encode(data: bytes) -> bytes:
+    """PackBits over 16-bit pixels (see src/app/rgb565_codec.h)."""
+    px = [data[i:i + 2] for i in range(0, len(data), 2)]
+    out = bytearray()
+    i = 0
+    n = len(px)
+    while i < n:
+        run = 1
+        while i + run < n and run < 129 and px[i + run] == px[i]:
+            run += 1
+        if run >= 2:
+            out.append(0x80 + run - 2)
+            out += px[i]
+            i += run
+            continue
+        start = i
+        while i < n and i - start < 128 and not (i + 1 < n and px[i + 1] == px[i]):
+            i += 1
+        if i == start:
+            i += 1
+        out.append(i - start - 1)
+        for p in px[start:i]:
+            out += p
+    return bytes(out)
+
+
+def encode_rect(pixels: bytes, encoding: str) -> bytes:
+    if encoding == 'rle':
+        return rle565_encode(pixels)
+    if encoding == 'lz4':
+        try:
+            import lz4.block
+        except ImportError:
+            raise RuntimeError("lz4 encoding needs the 'lz4' package (pip install lz4)")
+        return lz4.block.compress(pixels, store_size=False)
+    return pixels
+
+
+def upload_raw_mode(host: str, jpeg_data: bytes, band_height: int, encoding: str, timeout: int, verbose: bool = False) -> bool:
+    """Upload pre-rendered RGB565 bands (no JPEG decode on the device)."""
+    img = Image.open(io.BytesIO(jpeg_data))
+    width, height = img.size
+    num_bands = (height + band_height - 1) // band_height
+
+    print_info(f"Image: {width}x{height}, {num_bands} {encoding} bands of {band_height}px")
+
+    url = f"http://{host}/api/display/image/raw"
+    session = requests.Session()
+    total_bytes = 0
+
+    for i in range(num_bands):
+        y = i * band_height
+        h = min(band_height, height - y)
+        body = encode_rect(rgb565_bytes(img.crop((0, y, width, y + h))), encoding)
+        total_bytes += len(body)
+
+        params = {'x': 0, 'y': y, 'w': width, 'h': h, 'encoding': encoding, 'order': 'be', 'first': 1 if i == 0 else 0}
+        if i == 0 and timeout > 0:
+            params['timeout'] = timeout
+
+        print(f"  Uploading band {i + 1}/{num_bands} ({len(body)} bytes)...", end='', flush=True)
+        try:
+            headers = {'Content-Type': 'application/octet-stream'}
+            # Same back-pressure as strips: 409 while the device's queue is full.
+            deadline = time.monotonic() + 10.0
+            while True:
+                response = session.post(url, params=params, data=body, headers=headers, timeout=30)
+                if response.status_code != 409 or time.monotonic() >= deadline:
+                    break
+                time.sleep(0.01)
+
+            if verbose:
+                print(f"\n  Response: {response.status_code} {response.text}")
+
+            if response.status_code != 200:
+                print(f" {Colors.FAIL}✗{Colors.ENDC}")
+                try:
+                    print_error(f"Band upload failed: {response.json().get('message', response.text)}")
+                except Exception:
+                    print_error(f"Band upload failed: {response.status_code} {response.text}")
+                return False
+            print(f" {Colors.OKGREEN}✓{Colors.ENDC}")
+        except requests.exceptions.RequestException as e:
+            print(f" {Colors.FAIL}✗{Colors.ENDC}")
+            print_error(f"Network error: {e}")
+            return False
+
+    print_success(f"All {num_bands} bands uploaded ({total_bytes} bytes, raw {width * height * 2})")
+    return True
+
+
+def changed_tiles(prev: Image.Image, cur: Image.Image, tile: int) -> list:
+    """Grid cells that differ between two frames, merged into horizontal runs per row."""
+    width, height = cur.size
+    prev = prev.convert('RGB').resize((width, height))
+    cur = cur.convert('RGB')
+    rects = []
+    for y in range(0, height, tile):
+        h = min(tile, height - y)
+        run_x = None
+        for x in range(0, width + tile, tile):
+            changed = False
+            if x < width:
+                box = (x, y, min(x + tile, width), y + h)
+                changed = prev.crop(box).tobytes() != cur.crop(box).tobytes()
+            if changed and run_x is None:
+                run_x = x
+            elif not changed and run_x is not None:
+                rects.append((run_x, y, min(x, width) - run_x, h))
+                run_x = None
+    return rects
+
+
+def build_tile_batch(img: Image.Image, rects: list, encoding: str, quality: int = 85) -> bytes:
+    """Tile records for /api/display/image/tiles (see src/app/image_tiles.h)."""
+    codes = {'raw': 0, 'rle': 1, 'lz4': 2, 'jpeg': 3}
+    out = bytearray()
+    for x, y, w, h in rects:
+        crop = img.crop((x, y, x + w, y + h))
+        if encoding == 'jpeg':
+            buf = io.BytesIO()
+            crop.convert('RGB').save(buf, format='JPEG', quality=quality)
+            body = buf.getvalue()
+        else:
+            body = encode_rect(rgb565_bytes(crop), encoding)
+        out += struct.pack('<HHHHBBI', x, y, w, h, codes[encoding], 0, len(body))
+        out += body
+    return bytes(out)
+
+
+def upload_tiles_mode(host: str, jpeg_data: bytes, previous: bytes, tile: int, encoding: str, quality: int, verbose: bool = False) -> bool:
+    """Send only the tiles that changed since `previous` (already on screen)."""
+    cur = Image.open(io.BytesIO(jpeg_data))
+    prev = Image.open(io.BytesIO(previous))
+    rects = changed_tiles(prev, cur, tile)
+    if not rects:
+        print_success("No changes")
+        return True
+
+    body = build_tile_batch(cur, rects, encoding, quality)
+    print_info(f"{len(rects)} changed rects ({encoding}), {len(body)} bytes")
+
+    url = f"http://{host}/api/display/image/tiles"
+    try:
+        deadline = time.monotonic() + 10.0
+        while True:
+            response = requests.post(url, data=body, headers={'Content-Type': 'application/octet-stream'}, timeout=30)
+            if response.status_code != 409 or time.monotonic() >= deadline:
+                break
+            time.sleep(0.01)
+
+        if verbose:
+            print(f"Response: {response.status_code} {response.text}")
+
+        if response.status_code == 200:
+            print_success(f"{response.json().get('tiles', len(rects))} tiles applied")
+            return True
+        try:
+            print_error(f"Tile upload failed: {response.json().get('message', response.text)}")
+        except Exception:
+            print_error(f"Tile upload failed: {response.status_code} {response.text}")
+        return False
+    except requests.exceptions.RequestException as e:
+        print_error(f"Network error: {e}")
+        return False
+
+
 def dismiss_image(host: str, verbose: bool = False) -> bool:
     """Dismiss currently displayed image."""
     url = f"http://{host}/api/display/image"
@@ -379,6 +746,103 @@ def parse_resolution(res_str: str) -> Tuple[int, int]:
     return width, height
 
 
+def add_restart_markers(jpeg_data: bytes, rows: int, quality: int = 85) -> bytes:
+    """Re-encode with a restart marker every `rows` MCU rows (enables the dual-core decode)."""
+    img = Image.open(io.BytesIO(jpeg_data)).convert('RGB')
+    output = io.BytesIO()
+    try:
+        img.save(output, format='JPEG', quality=quality, restart_marker_rows=rows)
+    except TypeError:
+        raise ValueError("this Pillow version does not support restart_marker_rows (upgrade Pillow)")
+    return output.getvalue()
+
+
+def fetch_health(host: str) -> dict:
+    response = requests.get(f"http://{host}/api/health", timeout=10)
+    response.raise_for_status()
+    return response.json()
+
+
+def wait_for_image_job(host: str, jobs_before: int, deadline_s: float = 15.0) -> Optional[dict]:
+    """Poll /api/health until the image worker finished another job."""
+    end = time.time() + deadline_s
+    while time.time() < end:
+        health = fetch_health(host)
+        if health.get('image_jobs_done', 0) > jobs_before and health.get('image_state') == 'idle':
+            return health
+        time.sleep(0.1)
+    return None
+
+
+def fetch_image_stats(host: str) -> Tuple[list, str]:
+    """Recent image operations from /api/display/image/stats (newest first) and the pack kernel name."""
+    response = requests.get(f"http://{host}/api/display/image/stats", timeout=10)
+    response.raise_for_status()
+    body = response.json()
+    return body.get('operations', []), body.get('pack_kernel', 'unknown')
+
+
+def print_image_stats(host: str, wall_ms: float, count: int = 1):
+    """Print the device-side stage breakdown of the last operation(s) next to the host wall clock."""
+    try:
+        operations, pack_kernel = fetch_image_stats(host)
+        operations = operations[:count]
+    except (requests.exceptions.RequestException, ValueError) as e:
+        print_error(f"Could not fetch image stats: {e}")
+        return
+
+    print_header("Pipeline Stats")
+    print_info(f"Host wall clock: {wall_ms:.1f} ms (pack kernel: {pack_kernel})")
+    for op in reversed(operations):
+        status = 'ok' if op.get('ok') else 'FAILED'
+        stages = op.get('stages', {})
+        stage_ms = sum(st.get('us', 0) for st in stages.values()) / 1000.0
+        print_info(f"#{op.get('seq')} {op.get('kind')} ({status}): worker {op.get('worker_us', 0) / 1000.0:.1f} ms, "
+                   f"stages {stage_ms:.1f} ms")
+        for name, st in stages.items():
+            if st.get('us', 0) or st.get('bytes', 0):
+                print(f"    {name:10s} {st.get('us', 0) / 1000.0:8.2f} ms  {st.get('bytes', 0):>9d} B")
+        # Pack bytes are RGB565 output: 2 bytes per pixel.
+        pixels = stages.get('pack', {}).get('bytes', 0) / 2
+        decode_us = sum(stages.get(name, {}).get('us', 0) for name in ('header', 'decode', 'pack'))
+        pack_us = stages.get('pack', {}).get('us', 0)
+        if pixels and decode_us:
+            rate = f"    decode+pack {pixels / decode_us:.2f} MP/s"
+            if pack_us:
+                rate += f", pack alone {pixels / pack_us:.2f} MP/s"
+            print(rate)
+
+
+def bench_full_image(host: str, jpeg_data: bytes, runs: int, timeout: int, verbose: bool = False) -> bool:
+    """Upload the same image `runs` times per decoder and compare device-side decode times."""
+    results = {}
+    for parallel in (True, False):
+        label = 'dual-core' if parallel else 'single-core'
+        decode_ms = []
+        wall_ms = []
+        used_parallel = 0
+        for _ in range(runs):
+            jobs_before = fetch_health(host).get('image_jobs_done', 0)
+            t0 = time.time()
+            if not upload_full_image(host, jpeg_data, timeout, verbose, parallel=parallel):
+                return False
+            health = wait_for_image_job(host, jobs_before)
+            if health is None:
+                print_error("Timed out waiting for the device to decode")
+                return False
+            wall_ms.append((time.time() - t0) * 1000.0)
+            decode_ms.append(health.get('image_last_decode_ms', 0))
+            used_parallel += 1 if health.get('image_last_decode_parallel') else 0
+        results[label] = (sum(decode_ms) / runs, sum(wall_ms) / runs, used_parallel)
+
+    print_header("Decode Benchmark")
+    for label, (decode_avg, wall_avg, used) in results.items():
+        print_info(f"{label:12s} decode {decode_avg:7.1f} ms   wall {wall_avg:7.1f} ms   (parallel {used}/{runs})")
+    if results['dual-core'][2] == 0:
+        print_error("The device never used the dual-core path (no restart markers? try --restart-rows 1)")
+    return True
+
+
 def fetch_info_api(host: str, verbose: bool = False) -> dict:
     """Fetch /api/info JSON from the device."""
     url = f"http://{host}/api/info"
@@ -410,6 +874,8 @@ def main():
 Examples:
   %(prog)s 192.168.1.100 --image photo.jpg
   %(prog)s 192.168.1.100 --image photo.jpg --mode strip --strip-height 16
+  %(prog)s 192.168.1.100 --image dashboard.jpg --mode raw --encoding rle
+  %(prog)s 192.168.1.100 --image new.jpg --mode tiles --previous old.jpg
   %(prog)s 192.168.1.100 --generate 320x240 --timeout 30
     %(prog)s 192.168.1.100 --generate --timeout 30   # auto-detect from /api/info
   %(prog)s esp32-cyd.local --generate 240x240
@@ -432,8 +898,29 @@ Examples:
     source_group.add_argument('--dismiss', action='store_true', help='Dismiss currently displayed image')
     
     # Upload options
-    parser.add_argument('--mode', choices=['full', 'strip'], default='full',
-                       help='Upload mode: full (default, deferred decode) or strip (memory efficient)')
+    parser.add_argument('--mode', choices=['full', 'strip', 'raw', 'tiles', 'ws', 'mcast'], default='full',
+                       help='Upload mode: full (default, deferred decode), strip (memory efficient), '
+                            'raw (RGB565 bands, no decode on the device), tiles (only what changed since --previous), '
+                            'ws (strips over one WebSocket connection) or mcast (strips to a multicast group; '
+                            'host is the group address)')
+    parser.add_argument('--port', type=int, default=5010, metavar='N',
+                       help='For --mode mcast: UDP port (default: 5010)')
+    parser.add_argument('--repeat', type=int, default=3, metavar='N',
+                       help='For --mode mcast: times the image is sent (default: 3)')
+    parser.add_argument('--fec', type=int, default=4, metavar='N',
+                       help='For --mode mcast: one parity datagram per N data datagrams (default: 4, 0 = none)')
+    parser.add_argument('--frag-bytes', type=int, default=1200, metavar='N',
+                       help='For --mode mcast: JPEG bytes per datagram (default: 1200)')
+    parser.add_argument('--gap-ms', type=float, default=2.0, metavar='MS',
+                       help='For --mode mcast: pause between datagrams (default: 2)')
+    parser.add_argument('--ttl', type=int, default=1, metavar='N',
+                       help='For --mode mcast: multicast TTL (default: 1, local subnet)')
+    parser.add_argument('--encoding', choices=['raw', 'rle', 'lz4', 'jpeg'], default='rle',
+                       help='Pixel encoding for raw/tiles mode (default: rle; lz4 needs the lz4 package; jpeg is tiles only)')
+    parser.add_argument('--previous', metavar='PATH',
+                       help='For --mode tiles: the image currently on screen')
+    parser.add_argument('--tile-size', type=int, default=32, metavar='N',
+                       help='For --mode tiles: change-detection grid in pixels (default: 32)')
     parser.add_argument('--strip-height', type=int, default=16, metavar='N',
                        help='Strip height in pixels for strip mode (default: 16, min: 1, max: 240)')
     parser.add_argument('--quality', type=int, default=85, metavar='N',
@@ -450,6 +937,14 @@ Examples:
         action='store_true',
         help='For --generate: create a high-entropy noise image (less compressible; worst-case for upload size)',
     )
+    parser.add_argument('--top-left', action='store_true',
+                       help='Full mode: place images that do not fill the panel at the top-left instead of centering')
+    parser.add_argument('--restart-rows', type=int, default=0, metavar='N',
+                       help='Re-encode with a restart marker every N MCU rows (lets the device decode on both cores)')
+    parser.add_argument('--bench', type=int, default=0, metavar='N',
+                       help='Full mode: upload N times each with and without the dual-core decode and compare')
+    parser.add_argument('--stats', action='store_true',
+                       help='After the upload, print per-stage device timings from /api/display/image/stats')
     parser.add_argument('--save', metavar='PATH', 
                        help='Save the final processed image to file before uploading (e.g., --save output.jpg)')
     parser.add_argument('--timeout', type=int, default=10, metavar='SECONDS',
@@ -471,6 +966,14 @@ Examples:
     if args.quality < 1 or args.quality > 100:
         print_error("Quality must be between 1 and 100")
         sys.exit(1)
+
+    if args.mode == 'mcast':
+        if args.stats or args.bench or args.dismiss or args.generate == 'auto':
+            print_error("--mode mcast sends to a group: pass --generate WxH, without --stats/--bench/--dismiss")
+            sys.exit(1)
+        if not 1 <= args.frag_bytes <= 1400 or not 0 <= args.fec <= 255 or args.repeat < 1:
+            print_error("--frag-bytes must be 1-1400, --fec 0-255 and --repeat at least 1")
+            sys.exit(1)
     
     # Handle dismiss command
     if args.dismiss:
@@ -521,6 +1024,15 @@ Examples:
             print_error(f"Failed to determine resolution: {e}")
             sys.exit(1)
     
+    if args.restart_rows > 0:
+        try:
+            jpeg_data = add_restart_markers(jpeg_data, args.restart_rows, args.quality)
+        except ValueError as e:
+            print_error(f"Cannot add restart markers: {e}")
+            sys.exit(1)
+        jpeg_image = None
+        print_info(f"Re-encoded with restart markers every {args.restart_rows} MCU row(s): {len(jpeg_data)} bytes")
+
     # Save image to file if requested (before upload)
     if args.save:
         save_path = Path(args.save)
@@ -530,11 +1042,51 @@ Examples:
         print_success(f"Saved processed image to: {save_path}")
     
     # Upload image
-    if args.mode == 'full':
-        success = upload_full_image(args.host, jpeg_data, args.timeout, args.verbose)
+    jobs_before = None
+    if args.stats:
+        try:
+            jobs_before = fetch_health(args.host).get('image_jobs_done', 0)
+        except requests.exceptions.RequestException as e:
+            print_error(f"Could not read /api/health: {e}")
+    upload_t0 = time.time()
+
+    if args.bench > 0:
+        if args.mode != 'full':
+            print_error("--bench only works with --mode full")
+            sys.exit(1)
+        success = bench_full_image(args.host, jpeg_data, args.bench, args.timeout, args.verbose)
+        sys.exit(0 if success else 1)
+    elif args.mode == 'full':
+        success = upload_full_image(args.host, jpeg_data, args.timeout, args.verbose, center=not args.top_left)
+    elif args.mode == 'tiles':
+        if not args.previous:
+            print_error("--mode tiles needs --previous")
+            sys.exit(1)
+        previous = Path(args.previous).read_bytes()
+        success = upload_tiles_mode(args.host, jpeg_data, previous, args.tile_size, args.encoding, args.quality, args.verbose)
+    elif args.mode == 'raw':
+        if args.encoding == 'jpeg':
+            print_error("--mode raw does not take --encoding jpeg (use --mode strip)")
+            sys.exit(1)
+        success = upload_raw_mode(args.host, jpeg_data, args.strip_height, args.encoding, args.timeout, args.verbose)
+    elif args.mode == 'ws':
+        success = upload_ws_mode(args.host, jpeg_data, args.strip_height, args.timeout, args.quality, args.verbose)
+    elif args.mode == 'mcast':
+        success = upload_mcast_mode(args.host, jpeg_data, args.strip_height, args.timeout, args.quality,
+                                    port=args.port, frag_bytes=args.frag_bytes, fec=args.fec, repeat=args.repeat,
+                                    gap_ms=args.gap_ms, ttl=args.ttl, verbose=args.verbose)
     else:  # strip mode
         success = upload_strip_mode(args.host, jpeg_data, args.strip_height, args.timeout, args.quality, args.verbose)
     
+    if success and jobs_before is not None:
+        # Wall clock until the device reports the job done (strip mode: one op per strip).
+        wait_for_image_job(args.host, jobs_before)
+        wall_ms = (time.time() - upload_t0) * 1000.0
+        strips = 1
+        if args.mode in ('strip', 'ws'):
+            strips = (Image.open(io.BytesIO(jpeg_data)).height + args.strip_height - 1) // args.strip_height
+        print_image_stats(args.host, wall_ms, count=strips)
+
     if success:
         print_header("Complete")
         print_success(f"Image displayed on {args.host}")